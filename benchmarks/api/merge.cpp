@@ -20,6 +20,8 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/common/stats_timer.hpp>
 #include <thrill/common/string.hpp>
+#include <thrill/core/losertree.hpp>
+#include <thrill/core/multiway_merge.hpp>
 
 #include <algorithm>
 #include <random>
@@ -31,6 +33,9 @@
 
 unsigned int size = 1000 * 1000 * 10;
 
+//! number of runs merged by the local loser tree benchmark, 0 = skip it.
+unsigned int local_runs = 0;
+
 //! Network benchmarking.
 void merge_test(thrill::api::Context& ctx) {
 
@@ -67,6 +72,71 @@ void merge_test(thrill::api::Context& ctx) {
          << " workers=" << ctx.num_workers();
 }
 
+//! Reader over a sorted std::vector for core::MultiwayMergeTree
+class VectorReader
+{
+public:
+    explicit VectorReader(const std::vector<size_t>& vec)
+        : it_(vec.begin()), end_(vec.end()) { }
+
+    bool HasNext() const { return it_ != end_; }
+
+    template <typename T>
+    T Next() { return *it_++; }
+
+private:
+    std::vector<size_t>::const_iterator it_, end_;
+};
+
+//! Merge k sorted vectors locally with the given loser tree.
+template <typename LoserTree>
+void local_merge_test(const std::vector<std::vector<size_t> >& runs,
+                      const char* tree) {
+
+    using ReaderIterator = std::vector<VectorReader>::iterator;
+
+    std::vector<VectorReader> seq(runs.begin(), runs.end());
+
+    thrill::common::StatsTimerStart timer;
+
+    thrill::core::MultiwayMergeTree<
+        size_t, ReaderIterator, std::less<size_t>, false, LoserTree>
+    puller(seq.begin(), seq.end(), std::less<size_t>());
+
+    size_t checksum = 0;
+    while (puller.HasNext()) checksum += puller.Next();
+
+    timer.Stop();
+
+    LOG1 << "RESULT"
+         << " operation=local_merge"
+         << " tree=" << tree
+         << " k=" << runs.size()
+         << " size=" << size
+         << " time=" << timer.Microseconds()
+         << " checksum=" << checksum;
+}
+
+//! Compare the generic and the arithmetic loser trees on local runs.
+void local_merge_benchmark() {
+
+    std::mt19937 gen(std::random_device { } ());
+
+    std::vector<std::vector<size_t> > runs(local_runs);
+    for (size_t i = 0; i < size; ++i)
+        runs[i % local_runs].push_back(gen());
+    for (std::vector<size_t>& r : runs)
+        std::sort(r.begin(), r.end());
+
+    using namespace thrill::core; // NOLINT
+    local_merge_test<LoserTreeCopy<false, size_t, std::less<size_t> > >(
+        runs, "copy");
+    local_merge_test<LoserTreePointer<false, size_t, std::less<size_t> > >(
+        runs, "pointer");
+    local_merge_test<LoserTreeArithmetic<false, size_t, std::less<size_t> > >(
+        runs, "arithmetic");
+}
+
 int main(int argc, char** argv) {
 
     thrill::common::CmdlineParser clp;
@@ -74,12 +144,21 @@ int main(int argc, char** argv) {
     clp.AddUInt('n', "size", size,
                 "Count of elements to merge");
 
+    clp.AddUInt('k', "local_runs", local_runs,
+                "Merge this number of local runs with different loser trees "
+                "instead of running the DIA Merge benchmark");
+
     if (!clp.Process(argc, argv)) {
         return -1;
     }
 
     clp.PrintResult();
 
+    if (local_runs != 0) {
+        local_merge_benchmark();
+        return 0;
+    }
+
     return thrill::api::Run(merge_test);
 }
 
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * benchmarks/api/select.cpp
+ *
+ * Compare DIA::Select() of the median with Sort() and picking the middle item.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/cache.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/select.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
+#include <thrill/api/zip_with_index.hpp>
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/stats_timer.hpp>
+
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+int main(int argc, char* argv[]) {
+
+    common::CmdlineParser clp;
+
+    int iterations;
+    clp.AddParamInt("i", iterations, "Iterations");
+
+    uint64_t size;
+    clp.AddParamBytes("size", size,
+                      "Amount of size_t items to select from (example: 1 GiB).");
+
+    if (!clp.Process(argc, argv)) {
+        return -1;
+    }
+
+    clp.PrintResult();
+
+    api::Run(
+        [&iterations, &size](api::Context& ctx) {
+            const size_t num_items = size / sizeof(size_t);
+
+            for (int i = 0; i < iterations; i++) {
+                std::default_random_engine generator(std::random_device { } ());
+                std::uniform_int_distribution<size_t> distribution(
+                    0, std::numeric_limits<size_t>::max());
+
+                auto input = api::Generate(
+                    ctx,
+                    [&distribution, &generator](size_t) -> size_t {
+                        return distribution(generator);
+                    },
+                    num_items).Cache().Execute();
+
+                common::StatsTimerStart select_timer;
+                size_t median = input.Select(num_items / 2);
+                select_timer.Stop();
+
+                common::StatsTimerStart sort_timer;
+                std::vector<size_t> sorted_median =
+                    input.Sort().ZipWithIndex(
+                        [](const size_t& v, const size_t& index) {
+                            return std::make_pair(v, index);
+                        })
+                    .Filter([num_items](const std::pair<size_t, size_t>& p) {
+                                return p.second == num_items / 2;
+                            })
+                    .Map([](const std::pair<size_t, size_t>& p) {
+                             return p.first;
+                         })
+                    .AllGather();
+                sort_timer.Stop();
+
+                die_unless(sorted_median.size() == 1 &&
+                           sorted_median[0] == median);
+
+                if (!ctx.my_rank()) {
+                    LOG1 << "ITERATION " << i << " RESULT"
+                         << " select_time=" << select_timer.Milliseconds()
+                         << " sort_time=" << sort_timer.Milliseconds();
+                }
+            }
+        });
+}
+
+/******************************************************************************/
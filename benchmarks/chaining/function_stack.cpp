@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * benchmarks/chaining/function_stack.cpp
+ *
+ * Runs a chain of string transforming lambdas through a FunctionStack, once
+ * with adaptors which forward the items as rvalues, and once with adaptors
+ * taking const references, which copy the items at each hop. The DIA variant
+ * runs the same transforms as a chain of DIA::Map().
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/function_stack.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/stats_timer.hpp>
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace thrill; // NOLINT
+
+//! number of items pushed through the chain
+size_t num_items = 1024 * 1024;
+//! length of the strings
+size_t string_length = 64;
+//! repetitions of each run
+unsigned int repetitions = 1;
+
+//! map function of each hop, which takes its argument by value
+static std::string Transform(std::string s) {
+    s[0] = static_cast<char>(s[0] + 1);
+    return s;
+}
+
+//! adaptor like DIA::Map(), which forwards rvalues
+static auto forward_fn =
+    [](auto&& input, auto emit_func) {
+        emit_func(Transform(std::forward<decltype(input)>(input)));
+    };
+
+//! adaptor taking a const reference, hence the map function gets a copy
+static auto copy_fn =
+    [](const std::string& input, auto emit_func) {
+        emit_func(Transform(input));
+    };
+
+template <typename Adaptor>
+void RunStack(const char* variant, const Adaptor& adaptor) {
+    size_t total = 0;
+    auto save_fn = [&total](const std::string& s) { total += s[0]; };
+
+    auto chain =
+        api::MakeFunctionStack<size_t>(
+            [](const size_t& index, auto emit_func) {
+                emit_func(std::string(
+                              string_length,
+                              static_cast<char>('a' + index % 8)));
+            })
+        .push(adaptor).push(adaptor).push(adaptor).push(adaptor)
+        .push(adaptor).push(adaptor).push(adaptor).push(adaptor)
+        .push(save_fn).fold();
+
+    for (unsigned int r = 0; r < repetitions; ++r) {
+        total = 0;
+        common::StatsTimerStart timer;
+        for (size_t i = 0; i < num_items; ++i)
+            chain(i);
+        timer.Stop();
+
+        std::cout << "RESULT"
+                  << " benchmark=function_stack"
+                  << " variant=" << variant
+                  << " items=" << num_items
+                  << " string_length=" << string_length
+                  << " hops=8"
+                  << " repetition=" << r
+                  << " time=" << timer.Milliseconds()
+                  << " checksum=" << total
+                  << std::endl;
+    }
+}
+
+void RunDIA(api::Context& ctx) {
+    auto map_fn = [](std::string s) { return Transform(std::move(s)); };
+
+    for (unsigned int r = 0; r < repetitions; ++r) {
+        common::StatsTimerStart timer;
+        size_t size =
+            Generate(
+                ctx,
+                [](const size_t& index) {
+                    return std::string(
+                        string_length, static_cast<char>('a' + index % 8));
+                },
+                num_items)
+            .Map(map_fn).Map(map_fn).Map(map_fn).Map(map_fn)
+            .Map(map_fn).Map(map_fn).Map(map_fn).Map(map_fn)
+            .Size();
+        timer.Stop();
+
+        if (ctx.my_rank() == 0) {
+            std::cout << "RESULT"
+                      << " benchmark=function_stack"
+                      << " variant=dia"
+                      << " items=" << size
+                      << " string_length=" << string_length
+                      << " hops=8"
+                      << " repetition=" << r
+                      << " time=" << timer.Milliseconds()
+                      << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    common::CmdlineParser clp;
+
+    clp.SetDescription(
+        "Pushes strings through a chain of eight transforms, with forwarding "
+        "and with copying adaptors, and as DIA::Map() chain.");
+
+    clp.AddBytes('n', "items", "N", num_items,
+                 "Number of items, default = 1 Mi.");
+
+    clp.AddSizeT('l', "string_length", "L", string_length,
+                 "Length of the strings, default = 64.");
+
+    clp.AddUInt('r', "repetitions", "R", repetitions,
+                "Repetitions of each run, default = 1.");
+
+    if (!clp.Process(argc, argv)) {
+        return -1;
+    }
+
+    if (string_length == 0) string_length = 1;
+
+    clp.PrintResult();
+
+    RunStack("forward", forward_fn);
+    RunStack("copy", copy_fn);
+
+    return api::Run(
+        [](api::Context& ctx) {
+            RunDIA(ctx);
+        });
+}
+
+/******************************************************************************/
@@ -0,0 +1,361 @@
+/*******************************************************************************
+ * benchmarks/data/block_pool_benchmark.cpp
+ *
+ * Stress the BlockPool's external memory path: run sort, reduce, and cache
+ * access patterns on a data volume that overcommits the RAM limit by a given
+ * factor, and report eviction throughput, pin latency percentiles, and how
+ * close the spill I/O gets to the raw disk bandwidth.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/die.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_pool.hpp>
+#include <thrill/io/block_alloc_strategy.hpp>
+#include <thrill/io/block_manager.hpp>
+#include <thrill/io/iostats.hpp>
+#include <thrill/io/request_operations.hpp>
+#include <thrill/mem/aligned_allocator.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+using Timer = common::StatsTimerStart;
+
+uint64_t ram_limit = 64 * 1024 * 1024;
+uint64_t block_size = 2 * 1024 * 1024;
+size_t num_partitions = 16;
+size_t io_depth = 16;
+uint64_t seed = 42;
+
+//! raw disk bandwidth in MiB/s, measured once before the workloads.
+double raw_write_mibs = 0, raw_read_mibs = 0;
+
+static inline double MiBs(uint64_t bytes, double seconds) {
+    return seconds == 0 ? 0 : static_cast<double>(bytes) / 1024.0 / 1024.0
+           / seconds;
+}
+
+/******************************************************************************/
+
+//! write and read back volume bytes directly via the BlockManager, bypassing
+//! the BlockPool, with io_depth requests in flight.
+void MeasureRawBandwidth(uint64_t volume) {
+    io::BlockManager* bm = io::BlockManager::GetInstance();
+
+    std::vector<io::BID<0> > bids(std::max<uint64_t>(volume / block_size, 1));
+    for (io::BID<0>& b : bids) b.size = block_size;
+    bm->new_blocks(io::Striping(), bids.begin(), bids.end());
+
+    std::vector<char*> buffers(io_depth);
+    for (char*& b : buffers) {
+        b = static_cast<char*>(mem::aligned_alloc(block_size));
+        std::fill(b, b + block_size, 0x5A);
+    }
+
+    std::vector<io::RequestPtr> reqs(io_depth);
+
+    Timer write_timer;
+    for (size_t i = 0; i < bids.size(); i += io_depth) {
+        size_t n = std::min(io_depth, bids.size() - i);
+        for (size_t j = 0; j < n; ++j)
+            reqs[j] = bids[i + j].storage->awrite(
+                buffers[j], bids[i + j].offset, block_size);
+        io::wait_all(reqs.begin(), reqs.begin() + n);
+    }
+    write_timer.Stop();
+
+    Timer read_timer;
+    for (size_t i = 0; i < bids.size(); i += io_depth) {
+        size_t n = std::min(io_depth, bids.size() - i);
+        for (size_t j = 0; j < n; ++j)
+            reqs[j] = bids[i + j].storage->aread(
+                buffers[j], bids[i + j].offset, block_size);
+        io::wait_all(reqs.begin(), reqs.begin() + n);
+    }
+    read_timer.Stop();
+
+    for (char* b : buffers) mem::aligned_dealloc(b, block_size);
+    bm->delete_blocks(bids.begin(), bids.end());
+
+    uint64_t bytes = bids.size() * block_size;
+    raw_write_mibs = MiBs(bytes, write_timer.SecondsDouble());
+    raw_read_mibs = MiBs(bytes, read_timer.SecondsDouble());
+
+    std::cout << "RESULT"
+              << " benchmark=block_pool"
+              << " workload=raw"
+              << " block_size=" << block_size
+              << " io_depth=" << io_depth
+              << " bytes=" << bytes
+              << " write_mibs=" << raw_write_mibs
+              << " read_mibs=" << raw_read_mibs
+              << std::endl;
+}
+
+/******************************************************************************/
+
+//! Runs one workload against a fresh BlockPool, collecting pin latencies and
+//! I/O statistics.
+class Workload
+{
+public:
+    Workload(const std::string& name, size_t overcommit)
+        : name_(name), overcommit_(overcommit),
+          block_pool_(ram_limit * 9 / 10, ram_limit, nullptr, nullptr, 1),
+          num_blocks_(overcommit * ram_limit / block_size),
+          rng_(seed) {
+        // measure the disks, not the compressor
+        block_pool_.set_block_compression(false);
+    }
+
+    void Run() {
+        io::StatsData begin_stats(*io::Stats::GetInstance());
+
+        write_timer_.Start();
+        if (name_ == "sort") WriteRuns();
+        else if (name_ == "reduce") WritePartitions();
+        else if (name_ == "cache") WriteCache();
+        else die("Unknown workload " << name_);
+        write_timer_.Stop();
+
+        io::StatsData write_stats =
+            io::StatsData(*io::Stats::GetInstance()) - begin_stats;
+
+        read_timer_.Start();
+        if (name_ == "sort") ReadRuns();
+        else if (name_ == "reduce") ReadPartitions();
+        else if (name_ == "cache") ReadCache();
+        read_timer_.Stop();
+
+        io::StatsData read_stats =
+            io::StatsData(*io::Stats::GetInstance()) - begin_stats
+            - write_stats;
+
+        // data volumes above the RAM limit must be evicted
+        if (num_blocks_ * block_size > ram_limit)
+            die_unless(write_stats.write_volume() > 0);
+
+        Report(write_stats, read_stats);
+    }
+
+private:
+    std::string name_;
+    size_t overcommit_;
+    data::BlockPool block_pool_;
+    size_t num_blocks_;
+
+    std::default_random_engine rng_;
+
+    //! a block and the index which filled it
+    struct Entry {
+        size_t      index;
+        data::Block block;
+    };
+
+    //! sorted runs, scattered partitions, or the cached set.
+    std::vector<std::deque<Entry> > lists_;
+
+    //! microseconds from Pin() until the block is available
+    std::vector<double> pin_latency_;
+
+    common::StatsTimerStopped write_timer_, read_timer_;
+
+    //! allocate a new block, fill it, and release the pin so that the
+    //! BlockPool may evict it.
+    Entry NewBlock(size_t i) {
+        data::PinnedByteBlockPtr bb =
+            block_pool_.AllocateByteBlock(block_size, 0);
+        std::fill(bb->data(), bb->data() + block_size,
+                  static_cast<data::Byte>(i));
+        return Entry {
+                   i, data::PinnedBlock(std::move(bb), 0, block_size, 0, 0,
+                                        false).ToBlock()
+        };
+    }
+
+    //! pin a block, record the latency until it is in RAM, and check that it
+    //! was read back intact.
+    void PinBlock(const Entry& entry) {
+        Timer timer;
+        data::PinnedBlock pb = entry.block.PinWait(0);
+        timer.Stop();
+        pin_latency_.push_back(static_cast<double>(timer.Microseconds()));
+        die_unless(pb.size() == block_size);
+        die_unless(std::all_of(
+                       pb.data_begin(), pb.data_end(),
+                       [&entry](const data::Byte& b) {
+                           return b == static_cast<data::Byte>(entry.index);
+                       }));
+    }
+
+    //! run formation of an external sort: runs of half the RAM limit.
+    void WriteRuns() {
+        size_t run_blocks = std::max<size_t>(ram_limit / block_size / 2, 1);
+        for (size_t i = 0; i < num_blocks_; ++i) {
+            if (i % run_blocks == 0) lists_.emplace_back();
+            lists_.back().emplace_back(NewBlock(i));
+        }
+    }
+
+    //! multiway merge: consume the heads of all runs round-robin.
+    void ReadRuns() {
+        bool more = true;
+        while (more) {
+            more = false;
+            for (std::deque<Entry>& run : lists_) {
+                if (run.empty()) continue;
+                PinBlock(run.front());
+                run.pop_front();
+                more = true;
+            }
+        }
+    }
+
+    //! pre phase of a reduce or shuffle: scatter blocks to random partitions.
+    void WritePartitions() {
+        lists_.resize(num_partitions);
+        std::uniform_int_distribution<size_t> dist(0, num_partitions - 1);
+        for (size_t i = 0; i < num_blocks_; ++i)
+            lists_[dist(rng_)].emplace_back(NewBlock(i));
+    }
+
+    //! post phase: process one partition after the other.
+    void ReadPartitions() {
+        for (std::deque<Entry>& part : lists_) {
+            while (!part.empty()) {
+                PinBlock(part.front());
+                part.pop_front();
+            }
+        }
+    }
+
+    //! a cached DIA which is larger than RAM.
+    void WriteCache() {
+        lists_.resize(1);
+        for (size_t i = 0; i < num_blocks_; ++i)
+            lists_[0].emplace_back(NewBlock(i));
+    }
+
+    //! skewed random access: 80% of the pins hit the hottest 20% of blocks.
+    void ReadCache() {
+        std::deque<Entry>& set = lists_[0];
+        size_t hot = std::max<size_t>(set.size() / 5, 1);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        std::uniform_int_distribution<size_t> hot_dist(0, hot - 1);
+        std::uniform_int_distribution<size_t> all_dist(0, set.size() - 1);
+        for (size_t i = 0; i < num_blocks_; ++i)
+            PinBlock(set[coin(rng_) < 0.8 ? hot_dist(rng_) : all_dist(rng_)]);
+        set.clear();
+    }
+
+    double Percentile(double p) const {
+        if (pin_latency_.empty()) return 0;
+        size_t k = std::min(
+            static_cast<size_t>(p * static_cast<double>(pin_latency_.size())),
+            pin_latency_.size() - 1);
+        return pin_latency_[k];
+    }
+
+    void Report(const io::StatsData& write_stats,
+                const io::StatsData& read_stats) {
+        std::sort(pin_latency_.begin(), pin_latency_.end());
+
+        double evict_mibs =
+            MiBs(write_stats.write_volume(), write_timer_.SecondsDouble());
+        double read_mibs =
+            MiBs(read_stats.read_volume(), read_timer_.SecondsDouble());
+
+        std::cout << "RESULT"
+                  << " benchmark=block_pool"
+                  << " workload=" << name_
+                  << " overcommit=" << overcommit_
+                  << " ram_limit=" << ram_limit
+                  << " block_size=" << block_size
+                  << " blocks=" << num_blocks_
+                  << " write_time=" << write_timer_.SecondsDouble()
+                  << " read_time=" << read_timer_.SecondsDouble()
+                  << " evicted_bytes=" << write_stats.write_volume()
+                  << " evict_mibs=" << evict_mibs
+                  << " evict_raw_ratio="
+                  << (raw_write_mibs == 0 ? 0 : evict_mibs / raw_write_mibs)
+                  << " read_bytes=" << read_stats.read_volume()
+                  << " read_mibs=" << read_mibs
+                  << " read_raw_ratio="
+                  << (raw_read_mibs == 0 ? 0 : read_mibs / raw_read_mibs)
+                  << " pins=" << pin_latency_.size()
+                  << " pin_p50_us=" << Percentile(0.50)
+                  << " pin_p90_us=" << Percentile(0.90)
+                  << " pin_p99_us=" << Percentile(0.99)
+                  << " pin_max_us=" << Percentile(1.0)
+                  << std::endl;
+    }
+};
+
+/******************************************************************************/
+
+int main(int argc, char* argv[]) {
+
+    common::CmdlineParser clp;
+
+    clp.SetDescription(
+        "Stress the BlockPool with sort, reduce, and cache access patterns "
+        "on data volumes overcommitting the RAM limit.");
+
+    std::vector<std::string> workloads;
+    clp.AddStringlist('w', "workload", "W", workloads,
+                      "workloads: sort, reduce, cache, default = all");
+
+    std::string overcommit = "2,5,10,20";
+    clp.AddString('o', "overcommit", "LIST", overcommit,
+                  "comma-separated data volume / RAM factors, "
+                  "default = 2,5,10,20");
+
+    clp.AddBytes('r', "ram", "R", ram_limit,
+                 "RAM limit of the BlockPool, default = 64 MiB");
+
+    clp.AddBytes('b', "block_size", "B", block_size,
+                 "size of blocks, default = 2 MiB");
+
+    clp.AddSizeT('p', "partitions", "P", num_partitions,
+                 "number of partitions of reduce, default = 16");
+
+    clp.AddSizeT('d', "depth", "D", io_depth,
+                 "requests in flight for raw disk bandwidth, default = 16");
+
+    clp.AddBytes('s', "seed", "S", seed, "random seed, default = 42");
+
+    if (!clp.Process(argc, argv)) {
+        return -1;
+    }
+
+    if (workloads.empty())
+        workloads = { "sort", "reduce", "cache" };
+
+    clp.PrintResult();
+
+    MeasureRawBandwidth(2 * ram_limit);
+
+    for (const std::string& oc : common::Split(overcommit, ',')) {
+        for (const std::string& w : workloads) {
+            Workload(w, std::stoul(oc)).Run();
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
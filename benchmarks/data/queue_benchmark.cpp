@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * benchmarks/data/queue_benchmark.cpp
+ *
+ * Compare the mutex-based ConcurrentBoundedQueue with the lock-free MpscQueue:
+ * several producer threads push items, which one consumer pops, as the
+ * dispatcher threads push received Blocks into BlockQueue and MixBlockQueue.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/concurrent_bounded_queue.hpp>
+#include <thrill/common/mpsc_queue.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/data/block.hpp>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+uint64_t num_items = 4 * 1024 * 1024;
+unsigned int num_producers = 4;
+unsigned int repeats = 3;
+
+//! time producers pushing num_items in total, and one consumer popping them.
+template <typename Queue, typename Item>
+void RunQueue(const std::string& name, const std::string& type) {
+    for (size_t r = 0; r < repeats; ++r) {
+        Queue queue;
+        uint64_t per_producer = num_items / num_producers;
+
+        common::StatsTimerStart timer;
+
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < num_producers; ++p) {
+            producers.emplace_back(
+                [&queue, per_producer]() {
+                    for (uint64_t i = 0; i < per_producer; ++i)
+                        queue.emplace();
+                });
+        }
+
+        Item item;
+        for (uint64_t i = 0; i < per_producer * num_producers; ++i)
+            queue.pop(item);
+
+        for (std::thread& t : producers) t.join();
+        timer.Stop();
+
+        std::cout << "RESULT"
+                  << " benchmark=queue"
+                  << " queue=" << name
+                  << " item=" << type
+                  << " producers=" << num_producers
+                  << " items=" << per_producer * num_producers
+                  << " time=" << timer.Microseconds()
+                  << " ns_per_item="
+                  << static_cast<double>(timer.Microseconds()) * 1e3
+            / static_cast<double>(per_producer * num_producers)
+                  << std::endl;
+    }
+}
+
+template <typename Item>
+void RunAll(const std::string& type) {
+    RunQueue<common::OurConcurrentBoundedQueue<Item>, Item>("mutex", type);
+    RunQueue<common::MpscQueue<Item>, Item>("mpsc", type);
+}
+
+int main(int argc, char* argv[]) {
+
+    common::CmdlineParser clp;
+
+    std::string type = "block";
+
+    clp.AddString('t', "type", "T", type,
+                  "item type: integer or block, default = block");
+
+    clp.AddBytes('n', "items", "N", num_items,
+                 "number of items, default = 4 Mi");
+
+    clp.AddUInt('p', "producers", "P", num_producers,
+                "number of producer threads, default = 4");
+
+    clp.AddUInt('r', "repeats", "R", repeats,
+                "repetitions of each benchmark, default = 3");
+
+    if (!clp.Process(argc, argv)) {
+        return -1;
+    }
+
+    if (type == "integer")
+        RunAll<size_t>(type);
+    else
+        RunAll<data::Block>(type);
+
+    return 0;
+}
+
+/******************************************************************************/
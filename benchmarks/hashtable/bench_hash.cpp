@@ -0,0 +1,172 @@
+/*******************************************************************************
+ * benchmarks/hashtable/bench_hash.cpp
+ *
+ * Compare std::hash with common::Hash on integers and strings of different
+ * lengths, alone and as hash function of a reduce table.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/hash.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/core/reduce_by_hash_post_stage.hpp>
+
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+uint64_t num_items = 4 * 1024 * 1024;
+unsigned int repeats = 3;
+uint64_t num_keys = 1024 * 1024;
+uint64_t limit_memory = 256 * 1024 * 1024;
+
+//! generate random integer keys from num_keys distinct ones
+static std::vector<uint64_t> MakeKeys(uint64_t*) {
+    std::default_random_engine rng(std::random_device { } ());
+    std::uniform_int_distribution<uint64_t> dist(1, num_keys);
+    std::vector<uint64_t> keys(num_items);
+    for (uint64_t& k : keys) k = dist(rng);
+    return keys;
+}
+
+size_t string_length = 16;
+
+//! generate random string keys of string_length from num_keys distinct ones
+static std::vector<std::string> MakeKeys(std::string*) {
+    std::default_random_engine rng(std::random_device { } ());
+    std::uniform_int_distribution<uint64_t> dist(1, num_keys);
+    std::vector<std::string> keys(num_items);
+    for (std::string& k : keys) {
+        k = std::to_string(dist(rng));
+        k.resize(string_length, '.');
+    }
+    return keys;
+}
+
+//! time only the hash function
+template <typename Key, typename HashFunction>
+void RunHash(const std::string& name, const std::vector<Key>& keys) {
+    HashFunction hash;
+    for (size_t r = 0; r < repeats; ++r) {
+        common::StatsTimerStart timer;
+        size_t sum = 0;
+        for (const Key& k : keys) sum += hash(k);
+        timer.Stop();
+
+        std::cout << "RESULT"
+                  << " benchmark=hash"
+                  << " hash=" << name
+                  << " items=" << keys.size()
+                  << " string_length=" << string_length
+                  << " time=" << timer.Microseconds()
+                  << " ns_per_item="
+                  << static_cast<double>(timer.Microseconds()) * 1e3
+            / static_cast<double>(keys.size())
+                  << " checksum=" << (sum & 0xFF)
+                  << std::endl;
+    }
+}
+
+//! time a reduce table counting the occurrences of each key
+template <typename Key, typename HashFunction>
+void RunReduce(api::Context& ctx, const std::string& name,
+               const std::vector<Key>& keys) {
+    using Item = std::pair<Key, size_t>;
+
+    auto key_ex = [](const Item& in) { return in.first; };
+
+    auto red_fn = [](const Item& in1, const Item& in2) {
+                      return Item(in1.first, in1.second + in2.second);
+                  };
+
+    size_t num_results = 0;
+    auto emit_fn = [&num_results](const Item&) { ++num_results; };
+
+    for (size_t r = 0; r < repeats; ++r) {
+        core::ReduceByHashPostStage<
+            Item, Key, Item,
+            decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+            /* SendPair */ false, core::DefaultReduceConfig,
+            core::ReduceByHash<Key, HashFunction> >
+        stage(ctx, 0, key_ex, red_fn, emit_fn);
+
+        stage.Initialize(limit_memory);
+        num_results = 0;
+
+        common::StatsTimerStart timer;
+        for (const Key& k : keys)
+            stage.Insert(Item(k, 1));
+        stage.PushData(/* consume */ true);
+        timer.Stop();
+
+        std::cout << "RESULT"
+                  << " benchmark=reduce"
+                  << " hash=" << name
+                  << " items=" << keys.size()
+                  << " string_length=" << string_length
+                  << " keys=" << num_results
+                  << " time=" << timer.Microseconds()
+                  << std::endl;
+    }
+}
+
+template <typename Key>
+void RunAll(api::Context& ctx) {
+    std::vector<Key> keys = MakeKeys(static_cast<Key*>(nullptr));
+
+    RunHash<Key, std::hash<Key> >("std", keys);
+    RunHash<Key, common::Hash<Key> >("common", keys);
+
+    RunReduce<Key, std::hash<Key> >(ctx, "std", keys);
+    RunReduce<Key, common::Hash<Key> >(ctx, "common", keys);
+}
+
+int main(int argc, char* argv[]) {
+
+    common::CmdlineParser clp;
+
+    std::string type = "string";
+
+    clp.AddString('t', "type", "T", type,
+                  "key type: integer or string, default = string");
+
+    clp.AddBytes('n', "items", "N", num_items,
+                 "number of items, default = 4 Mi");
+
+    clp.AddBytes('k', "keys", "K", num_keys,
+                 "number of distinct keys, default = 1 Mi");
+
+    clp.AddSizeT('l', "length", "L", string_length,
+                 "length of string keys, default = 16");
+
+    clp.AddUInt('r', "repeats", "R", repeats,
+                "repetitions of each benchmark, default = 3");
+
+    clp.AddBytes('m', "memory", "M", limit_memory,
+                 "memory limit of the reduce table, default = 256 MiB");
+
+    if (!clp.Process(argc, argv)) {
+        return -1;
+    }
+
+    api::RunLocalSameThread(
+        [&](api::Context& ctx) {
+            if (type == "integer")
+                RunAll<uint64_t>(ctx);
+            else
+                RunAll<std::string>(ctx);
+        });
+
+    return 0;
+}
+
+/******************************************************************************/
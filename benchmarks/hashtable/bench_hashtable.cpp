@@ -35,6 +35,7 @@ using namespace thrill; // NOLINT
 std::string title;
 uint64_t size = 64 * 1024 * 1024;
 unsigned int workers = 100;
+uint64_t limit_memory = 256 * 1024 * 1024;
 
 uint64_t item_range = std::numeric_limits<Key>::max();
 
@@ -58,6 +59,7 @@ void RunBenchmark(api::Context& ctx, core::DefaultReduceConfig& base_config) {
     core::DefaultReduceConfigSelect<table_impl> config;
     config.limit_partition_fill_rate_ = base_config.limit_partition_fill_rate_;
     config.bucket_rate_ = base_config.bucket_rate_;
+    config.max_probe_length_ = base_config.max_probe_length_;
 
     core::ReduceByHashPostStage<
         Key, Key, Key,
@@ -67,13 +69,22 @@ void RunBenchmark(api::Context& ctx, core::DefaultReduceConfig& base_config) {
     stage(ctx, 0, key_ex, red_fn, emit_fn,
           config);
 
+    stage.Initialize(limit_memory);
+
+    // generate items beforehand to time only the hash table operations
+    std::vector<Key> items(num_items);
+    for (Key& k : items) k = dist(rng);
+
     common::StatsTimerStart timer;
 
-    for (uint64_t i = 0; i < num_items; i++)
-        stage.Insert(dist(rng));
+    for (const Key& k : items)
+        stage.Insert(k);
+
+    common::StatsTimerStart flush_timer;
 
     stage.PushData(/* consume */ true);
 
+    flush_timer.Stop();
     timer.Stop();
 
     std::cout
@@ -83,7 +94,12 @@ void RunBenchmark(api::Context& ctx, core::DefaultReduceConfig& base_config) {
         << " workers=" << workers
         << " max_partition_fill_rate=" << config.limit_partition_fill_rate()
         << " bucket_rate=" << config.bucket_rate()
+        << " max_probe_length=" << config.max_probe_length()
+        << " limit_memory=" << limit_memory
+        << " item_size=" << sizeof(KeyPair)
         << " time=" << timer.Milliseconds()
+        << " insert_time=" << timer.Milliseconds() - flush_timer.Milliseconds()
+        << " flush_time=" << flush_timer.Milliseconds()
         << std::endl;
 }
 
@@ -102,7 +118,7 @@ int main(int argc, char* argv[]) {
                   "Load in byte to be inserted");
 
     clp.AddString('h', "hash-table", "H", hashtable,
-                  "Set hashtable: probing or bucket");
+                  "Set hashtable: probing, bucket, old_probing or robin_hood");
 
     clp.AddUInt('w', "workers", "W", workers,
                 "Open hashtable with W workers, default = 1.");
@@ -115,6 +131,13 @@ int main(int argc, char* argv[]) {
                   config.bucket_rate_,
                   "set bucket_rate, default = 0.5.");
 
+    clp.AddSizeT('p', "max_probe", "P",
+                 config.max_probe_length_,
+                 "set max_probe_length of robin_hood, default = 64.");
+
+    clp.AddBytes('m', "memory", "M", limit_memory,
+                 "Set memory limit of the hash table, default = 256 MiB");
+
     clp.AddBytes('r', "range", "N",
                  item_range,
                  "set upper bound on item values, default = UINT_MAX.");
@@ -127,6 +150,12 @@ int main(int argc, char* argv[]) {
         [&](api::Context& ctx) {
             if (hashtable == "bucket")
                 return RunBenchmark<core::ReduceTableImpl::BUCKET>(ctx, config);
+            else if (hashtable == "old_probing")
+                return RunBenchmark<core::ReduceTableImpl::OLD_PROBING>(
+                    ctx, config);
+            else if (hashtable == "robin_hood")
+                return RunBenchmark<core::ReduceTableImpl::ROBIN_HOOD>(
+                    ctx, config);
             else
                 return RunBenchmark<core::ReduceTableImpl::PROBING>(ctx, config);
         });
@@ -0,0 +1,295 @@
+/*******************************************************************************
+ * benchmarks/hashtable/bench_reduce_tables.cpp
+ *
+ * Runs all ReduceTableImpl variants through the same key workloads, fill rates
+ * and memory limits, and prints comparable throughput and spill numbers.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/die.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/common/zipf_distribution.hpp>
+#include <thrill/core/reduce_by_hash_post_stage.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+//! number of inserted items
+uint64_t num_items = 4 * 1024 * 1024;
+//! number of distinct keys drawn by uniform, zipf and string workloads
+uint64_t key_range = 1024 * 1024;
+//! Zipf exponent
+double zipf_s = 1.0;
+//! length of string keys
+size_t string_length = 16;
+//! repetitions of each run
+unsigned int repetitions = 1;
+
+/******************************************************************************/
+// Workloads
+
+//! Generate the keys of a workload.
+template <typename Key>
+std::vector<Key> GenerateKeys(const std::string& workload);
+
+template <>
+std::vector<uint64_t> GenerateKeys<uint64_t>(const std::string& workload) {
+    std::vector<uint64_t> keys(num_items);
+    std::mt19937_64 rng(123456);
+
+    if (workload == "uniform") {
+        std::uniform_int_distribution<uint64_t> dist(1, key_range);
+        for (uint64_t& k : keys) k = dist(rng);
+    }
+    else if (workload == "zipf") {
+        common::ZipfDistribution zipf(key_range, zipf_s);
+        // scatter the ranks such that frequent keys do not hash to neighbours
+        std::vector<uint64_t> perm(key_range);
+        for (size_t i = 0; i < perm.size(); ++i) perm[i] = i + 1;
+        std::shuffle(perm.begin(), perm.end(), rng);
+        for (uint64_t& k : keys) k = perm[zipf(rng) - 1];
+    }
+    else if (workload == "sequential") {
+        for (size_t i = 0; i < keys.size(); ++i) keys[i] = i + 1;
+    }
+    else {
+        die("Unknown workload " << workload);
+    }
+    return keys;
+}
+
+template <>
+std::vector<std::string> GenerateKeys<std::string>(
+    const std::string& /* workload */) {
+    // uniformly drawn keys, zero-padded to the same length.
+    std::vector<uint64_t> ids = GenerateKeys<uint64_t>("uniform");
+    std::vector<std::string> keys(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        std::string id = std::to_string(ids[i]);
+        keys[i] = std::string(
+            string_length > id.size() ? string_length - id.size() : 0, '0')
+                  + id;
+    }
+    return keys;
+}
+
+/******************************************************************************/
+// Benchmark
+
+template <core::ReduceTableImpl table_impl, typename Key>
+void RunTable(api::Context& ctx, const char* table_name,
+              const std::string& workload, const std::vector<Key>& keys,
+              size_t distinct_keys, double fill_rate, uint64_t limit_memory) {
+
+    auto key_ex = [](const Key& in) { return in; };
+    auto red_fn = [](const Key& in1, const Key& /* in2 */) { return in1; };
+
+    size_t output_items = 0;
+    auto emit_fn = [&output_items](const std::pair<Key, Key>&) {
+                       ++output_items;
+                   };
+
+    using Config = core::DefaultReduceConfigSelect<table_impl>;
+    Config config;
+    config.limit_partition_fill_rate_ = fill_rate;
+
+    for (unsigned int r = 0; r < repetitions; ++r) {
+        output_items = 0;
+
+        core::ReduceByHashPostStage<
+            Key, Key, Key,
+            decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+            /* SendPair */ true, Config>
+        stage(ctx, 0, key_ex, red_fn, emit_fn, config);
+
+        stage.Initialize(limit_memory);
+
+        common::StatsTimerStart timer;
+
+        for (const Key& k : keys)
+            stage.Insert(k);
+
+        common::StatsTimerStart flush_timer;
+
+        // count the items spilled by the inserts
+        size_t spilled_items = 0, spilled_bytes = 0;
+        for (const data::File& file : stage.table().partition_files()) {
+            spilled_items += file.num_items();
+            spilled_bytes += file.size_bytes();
+        }
+
+        stage.PushData(/* consume */ true);
+
+        flush_timer.Stop();
+        timer.Stop();
+
+        // each distinct key is reduced to exactly one output item
+        die_unequal(output_items, distinct_keys);
+
+        std::cout
+            << "RESULT"
+            << " benchmark=reduce_tables"
+            << " table=" << table_name
+            << " workload=" << workload
+            << " items=" << keys.size()
+            << " key_range=" << key_range
+            << " fill_rate=" << fill_rate
+            << " limit_memory=" << limit_memory
+            << " repetition=" << r
+            << " time=" << timer.Milliseconds()
+            << " insert_time="
+            << timer.Milliseconds() - flush_timer.Milliseconds()
+            << " flush_time=" << flush_timer.Milliseconds()
+            << " items_per_sec="
+            << static_cast<double>(keys.size()) / timer.SecondsDouble()
+            << " output_items=" << output_items
+            << " spilled_items=" << spilled_items
+            << " spilled_bytes=" << spilled_bytes
+            << std::endl;
+    }
+}
+
+template <typename Key>
+void RunWorkload(api::Context& ctx, const std::string& workload,
+                 const std::vector<std::string>& tables,
+                 const std::vector<double>& fill_rates,
+                 const std::vector<uint64_t>& memory_limits) {
+
+    std::vector<Key> keys = GenerateKeys<Key>(workload);
+
+    std::vector<Key> sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    size_t distinct_keys =
+        std::unique(sorted_keys.begin(), sorted_keys.end())
+        - sorted_keys.begin();
+    std::vector<Key>().swap(sorted_keys);
+
+    for (const std::string& table : tables) {
+        for (double fill_rate : fill_rates) {
+            for (uint64_t limit_memory : memory_limits) {
+                if (table == "probing")
+                    RunTable<core::ReduceTableImpl::PROBING>(
+                        ctx, "probing", workload, keys, distinct_keys,
+                        fill_rate, limit_memory);
+                else if (table == "old_probing")
+                    RunTable<core::ReduceTableImpl::OLD_PROBING>(
+                        ctx, "old_probing", workload, keys, distinct_keys,
+                        fill_rate, limit_memory);
+                else if (table == "bucket")
+                    RunTable<core::ReduceTableImpl::BUCKET>(
+                        ctx, "bucket", workload, keys, distinct_keys,
+                        fill_rate, limit_memory);
+                else if (table == "robin_hood")
+                    RunTable<core::ReduceTableImpl::ROBIN_HOOD>(
+                        ctx, "robin_hood", workload, keys, distinct_keys,
+                        fill_rate, limit_memory);
+                else if (table == "sort")
+                    RunTable<core::ReduceTableImpl::SORT>(
+                        ctx, "sort", workload, keys, distinct_keys,
+                        fill_rate, limit_memory);
+                else
+                    die("Unknown table " << table);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    common::CmdlineParser clp;
+
+    clp.SetDescription(
+        "Runs all reduce table implementations through uniform, zipf, "
+        "sequential and string key workloads at several fill rates and "
+        "memory limits.");
+
+    std::vector<std::string> tables, workloads, fill_rate_list, memory_list;
+
+    clp.AddBytes('n', "items", "N", num_items,
+                 "Number of inserted items, default = 4 Mi.");
+
+    clp.AddBytes('k', "key_range", "K", key_range,
+                 "Number of distinct keys of random workloads, "
+                 "default = 1 Mi.");
+
+    clp.AddDouble('z', "zipf_s", "S", zipf_s,
+                  "Exponent of the zipf workload, default = 1.0.");
+
+    clp.AddSizeT('l', "string_length", "L", string_length,
+                 "Length of string keys, default = 16.");
+
+    clp.AddUInt('r', "repetitions", "R", repetitions,
+                "Repetitions of each run, default = 1.");
+
+    clp.AddStringlist('t', "table", "T", tables,
+                      "Table to run: probing, old_probing, bucket, robin_hood "
+                      "or sort, default = all.");
+
+    clp.AddStringlist('w', "workload", "W", workloads,
+                      "Workload to run: uniform, zipf, sequential or string, "
+                      "default = all.");
+
+    clp.AddStringlist('f', "fill_rate", "F", fill_rate_list,
+                      "limit_partition_fill_rate to run, "
+                      "default = 0.5 and 0.9.");
+
+    clp.AddStringlist('m', "memory", "M", memory_list,
+                      "Memory limit of the tables to run, "
+                      "default = 16 MiB and 256 MiB.");
+
+    if (!clp.Process(argc, argv)) {
+        return -1;
+    }
+
+    if (tables.empty())
+        tables = { "probing", "old_probing", "bucket", "robin_hood", "sort" };
+    if (workloads.empty())
+        workloads = { "uniform", "zipf", "sequential", "string" };
+    if (fill_rate_list.empty())
+        fill_rate_list = { "0.5", "0.9" };
+    if (memory_list.empty())
+        memory_list = { "16Mi", "256Mi" };
+
+    std::vector<double> fill_rates;
+    for (const std::string& f : fill_rate_list)
+        fill_rates.push_back(std::stod(f));
+
+    std::vector<uint64_t> memory_limits;
+    for (const std::string& m : memory_list) {
+        uint64_t bytes;
+        if (!common::ParseSiIecUnits(m.c_str(), bytes))
+            die("Invalid memory limit " << m);
+        memory_limits.push_back(bytes);
+    }
+
+    clp.PrintResult();
+
+    api::RunLocalSameThread(
+        [&](api::Context& ctx) {
+            for (const std::string& workload : workloads) {
+                if (workload == "string")
+                    RunWorkload<std::string>(
+                        ctx, workload, tables, fill_rates, memory_limits);
+                else
+                    RunWorkload<uint64_t>(
+                        ctx, workload, tables, fill_rates, memory_limits);
+            }
+        });
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -24,6 +24,30 @@
 
 using namespace thrill; // NOLINT
 
+template <core::ReduceTableImpl table_impl>
+void RunReduce(api::Context& ctx, const std::string& input,
+               const core::DefaultReduceConfig& base_config) {
+
+    core::DefaultReduceConfigSelect<table_impl> config;
+    config.limit_partition_fill_rate_ = base_config.limit_partition_fill_rate_;
+    config.max_probe_length_ = base_config.max_probe_length_;
+
+    auto in = api::ReadBinary<size_t>(ctx, input).Keep();
+    in.Size();
+
+    common::StatsTimerStart timer;
+    in.ReduceByKey([](const size_t& in) {
+                       return in;
+                   }, [](const size_t& in1, const size_t& in2) {
+                       (void)in2;
+                       return in1;
+                   }, config).Size();
+    timer.Stop();
+
+    LOG1 << "RESULT" << " benchmark=reduce time=" << timer.Milliseconds()
+         << " fill_rate=" << config.limit_partition_fill_rate();
+}
+
 int main(int argc, char* argv[]) {
 
     common::CmdlineParser clp;
@@ -35,27 +59,35 @@ int main(int argc, char* argv[]) {
     clp.AddParamString("input", input,
                        "input file pattern");
 
+    std::string hashtable = "probing";
+    clp.AddString('h', "hash-table", "H", hashtable,
+                  "Set hashtable: probing, bucket or robin_hood");
+
+    core::DefaultReduceConfig config;
+    clp.AddDouble('f', "fill_rate", "F",
+                  config.limit_partition_fill_rate_,
+                  "set limit_partition_fill_rate, default = 0.5.");
+
+    clp.AddSizeT('p', "max_probe", "P",
+                 config.max_probe_length_,
+                 "set max_probe_length of robin_hood, default = 64.");
+
     if (!clp.Process(argc, argv)) {
         return -1;
     }
 
     clp.PrintResult();
 
-    api::Run([&input, &iterations](api::Context& ctx) {
-
-                 auto in = api::ReadBinary<size_t>(ctx, input).Keep();
-                 in.Size();
-
-                 common::StatsTimerStart timer;
-                 in.ReduceByKey([](const size_t& in) {
-                                    return in;
-                                }, [](const size_t& in1, const size_t& in2) {
-                                    (void)in2;
-                                    return in1;
-                                }).Size();
-                 timer.Stop();
-
-                 LOG1 << "RESULT" << " benchmark=reduce time=" << timer.Milliseconds();
+    api::Run([&](api::Context& ctx) {
+                 if (hashtable == "bucket")
+                     RunReduce<core::ReduceTableImpl::BUCKET>(
+                         ctx, input, config);
+                 else if (hashtable == "robin_hood")
+                     RunReduce<core::ReduceTableImpl::ROBIN_HOOD>(
+                         ctx, input, config);
+                 else
+                     RunReduce<core::ReduceTableImpl::PROBING>(
+                         ctx, input, config);
              });
 }
 
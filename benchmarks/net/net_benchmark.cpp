@@ -6,6 +6,9 @@
  * - 1-factor full bandwidth test
  * - fcc Broadcast
  * - fcc PrefixSum
+ * - fcc local collective latency
+ * - select() vs. epoll() TCP dispatcher
+ * - latency percentiles of all collectives and stream throughput
  *
  * Part of Project Thrill - http://project-thrill.org
  *
@@ -19,10 +22,21 @@
 #include <thrill/common/aggregate.hpp>
 #include <thrill/common/cmdline_parser.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
 #include <thrill/common/matrix.hpp>
 #include <thrill/common/stats_timer.hpp>
 #include <thrill/common/string.hpp>
-
+#include <thrill/net/collective.hpp>
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
+#include <thrill/net/tcp/select_dispatcher.hpp>
+#include <thrill/net/tcp/socket.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -610,6 +624,660 @@ private:
     //! inner repetitions
     unsigned int inner_repeats_ = 200;
 };
+/******************************************************************************/
+//! measure the latency of tiny collectives among the local workers
+
+class LocalCollectives
+{
+public:
+    int Run(int argc, char* argv[]) {
+
+        common::CmdlineParser clp;
+
+        clp.AddUInt('r', "inner_repeats", inner_repeats_,
+                    "Repeat inner experiment a number of times.");
+
+        clp.AddUInt('R', "outer_repeats", outer_repeats_,
+                    "Repeat whole experiment a number of times.");
+
+        if (!clp.Process(argc, argv)) return -1;
+
+        return api::Run(
+            [=](api::Context& ctx) {
+                // make a copy of this for local workers
+                LocalCollectives local = *this;
+                return local.Test(ctx);
+            });
+    }
+
+    //! run op inner_repeats_ times and report the maximum time
+    template <typename Op>
+    void Measure(api::Context& ctx, const char* operation,
+                 const char* datatype, const Op& op) {
+        common::StatsTimerStopped t;
+
+        t.Start();
+        for (size_t inner = 0; inner < inner_repeats_; ++inner) {
+            op(inner);
+        }
+        t.Stop();
+
+        size_t time = t.Microseconds();
+        // calculate maximum time.
+        time = ctx.net.AllReduce(time, common::maximum<size_t>());
+
+        if (ctx.my_rank() == 0) {
+            LOG1 << "RESULT"
+                 << " datatype=" << datatype
+                 << " operation=" << operation
+                 << " workers=" << ctx.num_workers()
+                 << " local_workers=" << ctx.workers_per_host()
+                 << " inner_repeats=" << inner_repeats_
+                 << " time[us]=" << time
+                 << " time_per_op[us]="
+                 << static_cast<double>(time) / inner_repeats_;
+        }
+    }
+
+    void Test(api::Context& ctx) {
+
+        size_t n = ctx.num_workers();
+
+        // a value filling most of a cache line
+        using Line = std::array<size_t, 6>;
+
+        for (size_t outer = 0; outer < outer_repeats_; ++outer) {
+
+            Measure(ctx, "local_barrier", "none",
+                    [&](size_t) { ctx.net.LocalBarrier(); });
+
+            Measure(ctx, "barrier", "none",
+                    [&](size_t) { ctx.net.Barrier(); });
+
+            Measure(ctx, "allreduce", "size_t",
+                    [&](size_t inner) {
+                        size_t value = ctx.net.AllReduce(inner + ctx.my_rank());
+                        die_unequal(value, n * inner + n * (n - 1) / 2);
+                    });
+
+            Measure(ctx, "prefixsum", "size_t",
+                    [&](size_t inner) {
+                        size_t value = ctx.net.PrefixSum(inner + ctx.my_rank());
+                        die_unequal(value,
+                                    inner * (ctx.my_rank() + 1)
+                                    + ctx.my_rank() * (ctx.my_rank() + 1) / 2);
+                    });
+
+            Measure(ctx, "allreduce", "array<size_t,6>",
+                    [&](size_t inner) {
+                        Line value = ctx.net.AllReduce(
+                            Line { { inner, 1, 2, 3, 4, ctx.my_rank() } },
+                            [](const Line& a, const Line& b) {
+                                Line r;
+                                for (size_t i = 0; i < r.size(); ++i)
+                                    r[i] = a[i] + b[i];
+                                return r;
+                            });
+                        die_unequal(value[0], n * inner);
+                    });
+
+            // std::vector is reduced via pointers and the ThreadBarrier
+            Measure(ctx, "allreduce", "vector<size_t>",
+                    [&](size_t inner) {
+                        std::vector<size_t> value = ctx.net.AllReduce(
+                            std::vector<size_t>(1, inner),
+                            [](const std::vector<size_t>& a,
+                               const std::vector<size_t>& b) {
+                                return std::vector<size_t>(1, a[0] + b[0]);
+                            });
+                        die_unequal(value[0], n * inner);
+                    });
+        }
+    }
+
+private:
+    //! whole experiment
+    unsigned int outer_repeats_ = 1;
+
+    //! inner repetitions
+    unsigned int inner_repeats_ = 10000;
+};
+
+/******************************************************************************/
+//! compare the TCP dispatchers on many loopback socket pairs
+
+class DispatcherCompare
+{
+public:
+    int Run(int argc, char* argv[]) {
+
+        common::CmdlineParser clp;
+
+        clp.AddUInt('R', "outer_repeats", outer_repeats_,
+                    "Repeat whole experiment a number of times.");
+
+        clp.AddUInt('c', "connections", connections_,
+                    "Number of socket pairs, default: 256");
+
+        clp.AddUInt('a', "active", active_,
+                    "Number of connections sending in each round, the others "
+                    "wait idle for reads. default: all");
+
+        clp.AddUInt('m', "messages", messages_,
+                    "Number of rounds of messages, default: 200");
+
+        clp.AddBytes('s', "size", size_,
+                     "Size of each message, default: 64");
+
+        if (!clp.Process(argc, argv)) return -1;
+
+        for (size_t outer = 0; outer < outer_repeats_; ++outer) {
+            Test<net::tcp::SelectDispatcher>("select");
+#if THRILL_HAVE_NET_EPOLL
+            Test<net::tcp::EpollDispatcher>("epoll");
+#endif
+        }
+        return 0;
+    }
+
+    template <typename Dispatcher>
+    void Test(const char* name) {
+
+        mem::Manager mem_manager(nullptr, "DispatcherCompare");
+        Dispatcher dispatcher(mem_manager);
+
+        // socket pair i consists of conn[2 * i] and conn[2 * i + 1]
+        std::vector<net::tcp::Connection> conn;
+        conn.reserve(2 * connections_);
+        for (size_t i = 0; i < connections_; ++i) {
+            std::pair<net::tcp::Socket, net::tcp::Socket> sp =
+                net::tcp::Socket::CreatePair();
+            conn.emplace_back(std::move(sp.first));
+            conn.emplace_back(std::move(sp.second));
+        }
+
+        size_t active = std::min<size_t>(active_, connections_);
+        std::string message(size_, 'x');
+        size_t received = 0;
+
+        // keep one read pending on each socket pair
+        net::AsyncReadCallback on_read = net::AsyncReadCallback::make(
+            [&](net::Connection& c, net::Buffer&&) {
+                ++received;
+                dispatcher.AsyncRead(c, size_, on_read);
+            });
+
+        for (size_t i = 0; i < connections_; ++i)
+            dispatcher.AsyncRead(conn[2 * i + 1], size_, on_read);
+
+        common::StatsTimerStart timer;
+
+        for (size_t m = 0; m < messages_; ++m) {
+            // send one message over the active socket pairs, while reads on
+            // all connections are pending at the dispatcher.
+            for (size_t i = 0; i < active; ++i) {
+                size_t p = (m * active + i) % connections_;
+                dispatcher.AsyncWriteCopy(conn[2 * p], message);
+            }
+
+            while (received < (m + 1) * active)
+                dispatcher.Dispatch();
+        }
+        timer.Stop();
+
+        for (size_t i = 0; i < connections_; ++i)
+            dispatcher.Cancel(conn[2 * i + 1]);
+
+        LOG1 << "RESULT"
+             << " benchmark=" << benchmark
+             << " dispatcher=" << name
+             << " connections=" << connections_
+             << " active=" << active
+             << " messages=" << messages_
+             << " size=" << size_
+             << " time[us]=" << timer.Microseconds()
+             << " time_per_round[us]="
+             << static_cast<double>(timer.Microseconds()) / messages_;
+    }
+
+private:
+    //! whole experiment
+    unsigned int outer_repeats_ = 1;
+
+    //! number of socket pairs
+    unsigned int connections_ = 256;
+
+    //! number of connections sending in each round
+    unsigned int active_ = std::numeric_limits<unsigned int>::max();
+
+    //! number of rounds of messages
+    unsigned int messages_ = 200;
+
+    //! size of each message
+    uint64_t size_ = 64;
+};
+
+/******************************************************************************/
+//! latency percentiles of all collectives and stream throughput over a range
+//! of message sizes
+
+class Matrix
+{
+public:
+    //! payload of the collectives, reduced elementwise by maximum
+    using Payload = std::vector<size_t>;
+
+    //! measured latency percentiles: p50, p90, p99 and maximum
+    using Latencies = std::array<double, 4>;
+
+    int Run(int argc, char* argv[]) {
+
+        common::CmdlineParser clp;
+
+        std::vector<std::string> size_list;
+
+        clp.AddUInt('r', "repeats", repeats_,
+                    "Repetitions of each collective, default: 100");
+
+        clp.AddUInt('R', "stream_repeats", stream_repeats_,
+                    "Repetitions of each stream exchange, default: 5");
+
+        clp.AddBytes('S', "stream_bytes", stream_bytes_,
+                     "Bytes sent by each worker in a stream exchange, "
+                     "default: 4 MiB");
+
+        clp.AddStringlist('s', "size", size_list,
+                          "Message sizes, default: 8, 1Ki, 64Ki and 1Mi");
+
+        clp.AddStringlist('o', "operation", operations_,
+                          "Operations to run, default: all. "
+                          "fcc_{barrier,broadcast,reduce,allreduce,prefixsum,"
+                          "exprefixsum}, group_{broadcast,reduce,allreduce,"
+                          "prefixsum,exprefixsum}, broadcast_{trivial,"
+                          "binomial,pipelined}, allreduce_{hypercube,"
+                          "elementwise}, prefixsum_hypercube, allgather_ring, "
+                          "stream_{cat,mix}");
+
+        if (!clp.Process(argc, argv)) return -1;
+
+        if (size_list.empty())
+            size_list = { "8", "1Ki", "64Ki", "1Mi" };
+
+        for (const std::string& s : size_list) {
+            uint64_t size;
+            if (!common::ParseSiIecUnits(s.c_str(), size) || size == 0)
+                die("Invalid message size " << s);
+            sizes_.push_back(size);
+        }
+
+        // the backend is selected by the environment as for all programs
+        const char* env_net = getenv("THRILL_NET");
+        backend_ = env_net && *env_net ? env_net : "auto";
+
+        return api::Run(
+            [=](api::Context& ctx) {
+                // make a copy of this for local workers
+                Matrix local = *this;
+                return local.Test(ctx);
+            });
+    }
+
+    void Test(api::Context& ctx) {
+
+        if (Enabled("fcc_barrier")) {
+            MeasureFcc(ctx, "fcc_barrier", 0,
+                       [&](size_t) { ctx.net.Barrier(); });
+        }
+
+        for (size_t size : sizes_) {
+            TestFcc(ctx, size);
+
+            // the host Group is only used by the first worker of each host
+            if (ctx.local_worker_id() == 0)
+                TestGroup(ctx, ctx.net.group(), size);
+            ctx.net.Barrier();
+
+            TestStreams(ctx, size);
+        }
+    }
+
+    void TestFcc(api::Context& ctx, size_t size) {
+        size_t n = ctx.num_workers();
+        Payload payload = MakePayload(ctx.my_rank(), size);
+
+        if (Enabled("fcc_broadcast")) {
+            MeasureFcc(ctx, "fcc_broadcast", size,
+                       [&](size_t r) {
+                           Payload p = ctx.net.Broadcast(payload, r % n);
+                           die_unequal(p.front(), r % n);
+                       });
+        }
+        if (Enabled("fcc_reduce")) {
+            MeasureFcc(ctx, "fcc_reduce", size,
+                       [&](size_t r) {
+                           Payload p = ctx.net.Reduce(payload, r % n, MaxOp);
+                           if (ctx.my_rank() == r % n)
+                               die_unequal(p.front(), n - 1);
+                       });
+        }
+        if (Enabled("fcc_allreduce")) {
+            MeasureFcc(ctx, "fcc_allreduce", size,
+                       [&](size_t) {
+                           Payload p = ctx.net.AllReduce(payload, MaxOp);
+                           die_unequal(p.front(), n - 1);
+                       });
+        }
+        if (Enabled("fcc_prefixsum")) {
+            MeasureFcc(ctx, "fcc_prefixsum", size,
+                       [&](size_t) {
+                           Payload p = ctx.net.PrefixSum(
+                               payload, Payload(), MaxOp);
+                           die_unequal(p.front(), ctx.my_rank());
+                       });
+        }
+        if (Enabled("fcc_exprefixsum")) {
+            MeasureFcc(ctx, "fcc_exprefixsum", size,
+                       [&](size_t) {
+                           Payload p = ctx.net.ExPrefixSum(
+                               payload, Payload(), MaxOp);
+                           if (ctx.my_rank() != 0)
+                               die_unequal(p.front(), ctx.my_rank() - 1);
+                       });
+        }
+    }
+
+    void TestGroup(api::Context& ctx, net::Group& group, size_t size) {
+        size_t n = group.num_hosts();
+        size_t rank = group.my_host_rank();
+        Payload payload = MakePayload(rank, size);
+
+        if (Enabled("group_broadcast")) {
+            MeasureGroup(ctx, group, "group_broadcast", size,
+                         [&](size_t r) {
+                             Payload p = payload;
+                             group.Broadcast(p, r % n);
+                             die_unequal(p.front(), r % n);
+                         });
+        }
+        if (Enabled("group_reduce")) {
+            MeasureGroup(ctx, group, "group_reduce", size,
+                         [&](size_t r) {
+                             Payload p = payload;
+                             group.Reduce(p, r % n, MaxOp);
+                             if (rank == r % n) die_unequal(p.front(), n - 1);
+                         });
+        }
+        if (Enabled("group_allreduce")) {
+            MeasureGroup(ctx, group, "group_allreduce", size,
+                         [&](size_t) {
+                             Payload p = payload;
+                             group.AllReduce(p, MaxOp);
+                             die_unequal(p.front(), n - 1);
+                         });
+        }
+        if (Enabled("group_prefixsum")) {
+            MeasureGroup(ctx, group, "group_prefixsum", size,
+                         [&](size_t) {
+                             Payload p = payload;
+                             group.PrefixSum(p, MaxOp);
+                             die_unequal(p.front(), rank);
+                         });
+        }
+        if (Enabled("group_exprefixsum")) {
+            MeasureGroup(ctx, group, "group_exprefixsum", size,
+                         [&](size_t) {
+                             Payload p = payload;
+                             group.ExPrefixSum(p, MaxOp);
+                             if (rank != 0) die_unequal(p.front(), rank - 1);
+                         });
+        }
+        if (Enabled("broadcast_trivial")) {
+            MeasureGroup(ctx, group, "broadcast_trivial", size,
+                         [&](size_t r) {
+                             Payload p = payload;
+                             net::collective::BroadcastTrivial(group, p, r % n);
+                             die_unequal(p.front(), r % n);
+                         });
+        }
+        if (Enabled("broadcast_binomial")) {
+            MeasureGroup(ctx, group, "broadcast_binomial", size,
+                         [&](size_t r) {
+                             Payload p = payload;
+                             net::collective::BroadcastBinomialTree(
+                                 group, p, r % n);
+                             die_unequal(p.front(), r % n);
+                         });
+        }
+        if (Enabled("broadcast_pipelined")) {
+            MeasureGroup(ctx, group, "broadcast_pipelined", size,
+                         [&](size_t r) {
+                             Payload p = payload;
+                             net::collective::BroadcastPipelined(
+                                 group, p, r % n);
+                             die_unequal(p.front(), r % n);
+                         });
+        }
+        // the hypercube algorithms require a power of two hosts, and log their
+        // values, hence they reduce strings of one character per byte.
+        std::string str(size, static_cast<char>('0' + rank));
+        auto max_str = [](const std::string& a, const std::string& b) {
+                           return std::max(a, b);
+                       };
+        if (Enabled("allreduce_hypercube") && common::IsPowerOfTwo(n)) {
+            MeasureGroup(ctx, group, "allreduce_hypercube", size,
+                         [&](size_t) {
+                             std::string s = str;
+                             net::collective::AllReduceHypercube(
+                                 group, s, max_str);
+                             die_unequal(s.front(),
+                                         static_cast<char>('0' + n - 1));
+                         });
+        }
+        if (Enabled("prefixsum_hypercube") && common::IsPowerOfTwo(n)) {
+            MeasureGroup(ctx, group, "prefixsum_hypercube", size,
+                         [&](size_t) {
+                             std::string s = str;
+                             net::collective::PrefixSumHypercube(
+                                 group, s, max_str);
+                             die_unequal(s.front(),
+                                         static_cast<char>('0' + rank));
+                         });
+        }
+        if (Enabled("allreduce_elementwise")) {
+            MeasureGroup(ctx, group, "allreduce_elementwise", size,
+                         [&](size_t) {
+                             Payload p = payload;
+                             net::collective::AllReduceElementwise(
+                                 group, p, common::maximum<size_t>());
+                             die_unequal(p.front(), n - 1);
+                         });
+        }
+        if (Enabled("allgather_ring")) {
+            // each host owns one block of the gathered vector
+            MeasureGroup(ctx, group, "allgather_ring", size,
+                         [&](size_t) {
+                             Payload p = payload;
+                             net::collective::AllGatherRing(group, p);
+                             die_unequal(p.back(), n - 1);
+                         });
+        }
+    }
+
+    void TestStreams(api::Context& ctx, size_t size) {
+        size_t n = ctx.num_workers();
+        // items sent to each worker
+        size_t items = std::max<size_t>(1, stream_bytes_ / n / size);
+        std::string item(size, 'x');
+
+        auto exchange =
+            [&](auto stream, auto reader) {
+                auto writers = stream->GetWriters();
+                for (auto& w : writers) {
+                    for (size_t i = 0; i < items; ++i) w.Put(item);
+                    w.Close();
+                }
+                auto r = reader(stream);
+                size_t count = 0;
+                while (r.HasNext()) {
+                    die_unequal(r.template Next<std::string>().size(), size);
+                    ++count;
+                }
+                die_unequal(count, n * items);
+                stream->Close();
+            };
+
+        if (Enabled("stream_cat")) {
+            MeasureStream(ctx, "stream_cat", size, n * items * size,
+                          [&](size_t) {
+                              exchange(ctx.GetNewCatStream(size_t(0)),
+                                       [](data::CatStreamPtr& s) {
+                                           return s->GetCatReader(true);
+                                       });
+                          });
+        }
+        if (Enabled("stream_mix")) {
+            MeasureStream(ctx, "stream_mix", size, n * items * size,
+                          [&](size_t) {
+                              exchange(ctx.GetNewMixStream(size_t(0)),
+                                       [](data::MixStreamPtr& s) {
+                                           return s->GetMixReader(true);
+                                       });
+                          });
+        }
+    }
+
+    //! run op repeats times, timing each call, and return the percentiles
+    template <typename Op>
+    static Latencies Measure(size_t repeats, const Op& op) {
+        std::vector<double> times(repeats);
+        for (size_t r = 0; r < repeats; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            op(r);
+            times[r] = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        std::sort(times.begin(), times.end());
+        auto percentile = [&](size_t p) {
+                              return times[std::min(
+                                               repeats - 1, p * repeats / 100)];
+                          };
+        return Latencies {
+                   { percentile(50), percentile(90), percentile(99),
+                     times.back() }
+        };
+    }
+
+    //! measure a collective on all workers and report the slowest worker
+    template <typename Op>
+    void MeasureFcc(api::Context& ctx, const char* operation, size_t size,
+                    const Op& op) {
+        ctx.net.Barrier();
+        Latencies lat = ctx.net.AllReduce(Measure(repeats_, op), MaxLatencies);
+        if (ctx.my_rank() == 0)
+            Print(ctx, "fcc", operation, size, repeats_, lat, 0);
+    }
+
+    //! measure a collective on the host Group and report the slowest host
+    template <typename Op>
+    void MeasureGroup(api::Context& ctx, net::Group& group,
+                      const char* operation, size_t size, const Op& op) {
+        size_t sync = 0;
+        group.AllReduce(sync);
+        Latencies lat = Measure(repeats_, op);
+        group.AllReduce(lat, MaxLatencies);
+        if (group.my_host_rank() == 0)
+            Print(ctx, "group", operation, size, repeats_, lat, 0);
+    }
+
+    //! measure a stream exchange in which each worker receives bytes
+    template <typename Op>
+    void MeasureStream(api::Context& ctx, const char* operation, size_t size,
+                       size_t bytes, const Op& op) {
+        ctx.net.Barrier();
+        Latencies lat = ctx.net.AllReduce(
+            Measure(stream_repeats_, op), MaxLatencies);
+        if (ctx.my_rank() == 0) {
+            Print(ctx, "stream", operation, size, stream_repeats_, lat,
+                  bytes * ctx.num_workers());
+        }
+    }
+
+    void Print(api::Context& ctx, const char* layer, const char* operation,
+               size_t size, size_t repeats, const Latencies& lat,
+               size_t bytes) {
+        std::ostringstream os;
+        if (bytes != 0) {
+            os << " bytes=" << bytes
+               << " bandwidth[MiB/s]="
+               << static_cast<double>(bytes) / 1024.0 / 1024.0
+                / lat[0] * 1e6;
+        }
+        LOG1 << "RESULT"
+             << " benchmark=" << benchmark
+             << " backend=" << backend_
+             << " layer=" << layer
+             << " operation=" << operation
+             << " hosts=" << ctx.num_hosts()
+             << " workers=" << ctx.num_workers()
+             << " size=" << size
+             << " repeats=" << repeats
+             << " p50[us]=" << lat[0]
+             << " p90[us]=" << lat[1]
+             << " p99[us]=" << lat[2]
+             << " max[us]=" << lat[3]
+             << os.str();
+    }
+
+private:
+    //! whether the operation was selected
+    bool Enabled(const std::string& operation) const {
+        return operations_.empty() ||
+               std::find(operations_.begin(), operations_.end(), operation)
+               != operations_.end();
+    }
+
+    //! a payload of size bytes filled with the rank
+    static Payload MakePayload(size_t rank, size_t size) {
+        return Payload(std::max<size_t>(1, size / sizeof(size_t)), rank);
+    }
+
+    //! elementwise maximum of payloads, an empty payload is neutral
+    static Payload MaxOp(const Payload& a, const Payload& b) {
+        if (a.empty()) return b;
+        if (b.empty()) return a;
+        Payload r(a.size());
+        for (size_t i = 0; i < r.size(); ++i)
+            r[i] = std::max(a[i], b[i]);
+        return r;
+    }
+
+    //! elementwise maximum of latencies
+    static Latencies MaxLatencies(const Latencies& a, const Latencies& b) {
+        Latencies r;
+        for (size_t i = 0; i < r.size(); ++i)
+            r[i] = std::max(a[i], b[i]);
+        return r;
+    }
+
+    //! repetitions of each collective
+    unsigned int repeats_ = 100;
+
+    //! repetitions of each stream exchange
+    unsigned int stream_repeats_ = 5;
+
+    //! bytes sent by each worker in a stream exchange
+    uint64_t stream_bytes_ = 4 * 1024 * 1024;
+
+    //! message sizes
+    std::vector<uint64_t> sizes_;
+
+    //! selected operations, empty for all
+    std::vector<std::string> operations_;
+
+    //! name of the network backend
+    std::string backend_;
+};
+
 /******************************************************************************/
 
 void Usage(const char* argv0) {
@@ -621,6 +1289,11 @@ void Usage(const char* argv0) {
         << "    broadcast  - FCC Broadcast operation" << std::endl
         << "    prefixsum  - FCC PrefixSum operation" << std::endl
         << "    allreduce  - FCC PrefixSum operation" << std::endl
+        << "    local      - FCC local collective latency" << std::endl
+        << "    dispatcher - select() vs. epoll() TCP dispatcher" << std::endl
+        << "    matrix     - latency percentiles of all collectives and"
+        << std::endl
+        << "                 stream throughput over message sizes" << std::endl
         << std::endl;
 }
 
@@ -648,6 +1321,15 @@ int main(int argc, char** argv) {
     else if (benchmark == "allreduce") {
         return AllReduce().Run(argc - 1, argv + 1);
     }
+    else if (benchmark == "local") {
+        return LocalCollectives().Run(argc - 1, argv + 1);
+    }
+    else if (benchmark == "dispatcher") {
+        return DispatcherCompare().Run(argc - 1, argv + 1);
+    }
+    else if (benchmark == "matrix") {
+        return Matrix().Run(argc - 1, argv + 1);
+    }
     else {
         Usage(argv[0]);
         return -1;
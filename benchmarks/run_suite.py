@@ -0,0 +1,251 @@
+#!/usr/bin/env python
+##########################################################################
+# benchmarks/run_suite.py
+#
+# Run a fixed suite of example programs across worker counts and input sizes,
+# collect weak and strong scaling results as JSON and RESULT lines, and
+# compare the throughput with a stored baseline.
+#
+# Example:
+#   benchmarks/run_suite.py --build build --workers 1,2,4 \
+#       --output results.json --baseline baseline.json
+#
+# Part of Project Thrill - http://project-thrill.org
+#
+#
+# All rights reserved. Published under the BSD-2 license in the LICENSE file.
+##########################################################################
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+# Each benchmark has a program relative to the build directory, a function
+# producing its arguments for an input size, and the input size per worker of
+# the smallest scale. The size unit is given for the throughput.
+SUITE = {
+    "terasort": {
+        "program": "examples/terasort/terasort",
+        "args": lambda size, tmp: ["-g", str(size)],
+        "base_size": 64 * 1024 * 1024,
+        "unit": "bytes",
+    },
+    "word_count": {
+        "program": "examples/word_count/word_count_run",
+        "args": lambda size, tmp: [make_text(tmp, size)],
+        "base_size": 32 * 1024 * 1024,
+        "unit": "bytes",
+    },
+    "page_rank": {
+        "program": "examples/page_rank/page_rank_run",
+        "args": lambda size, tmp: ["-g", "-n", "10", str(size)],
+        "base_size": 1000000,
+        "unit": "pages",
+    },
+    "k-means": {
+        "program": "examples/k-means/k-means_run",
+        "args": lambda size, tmp: ["-g", "-n", "10", "2", "10", str(size)],
+        "base_size": 4000000,
+        "unit": "points",
+    },
+    "suffix_sorting": {
+        "program": "examples/suffix_sorting/prefix_doubling",
+        "args": lambda size, tmp: ["random", "-s", str(size)],
+        "base_size": 4 * 1024 * 1024,
+        "unit": "bytes",
+    },
+}
+
+# set by main() to the build directory
+build_dir = None
+
+
+def make_text(tmp, size):
+    "generate a random text file of size bytes for word_count, once per size"
+    path = os.path.join(tmp, "text-%d.txt" % size)
+    if not os.path.exists(path):
+        program = os.path.join(
+            build_dir, "examples/word_count/random_text_writer")
+        with open(path, "w") as f:
+            subprocess.check_call([program, str(size)], stdout=f)
+    return path
+
+
+def parse_results(output):
+    "collect the key=value pairs of all RESULT lines of a program's output"
+    results = []
+    for line in output.splitlines():
+        if "RESULT" not in line:
+            continue
+        pairs = re.findall(r"(\w+)=(\S+)", line)
+        results.append(dict(pairs))
+    return results
+
+
+def run_once(name, workers, size, tmp):
+    "run one benchmark with the given number of local workers, returns seconds"
+    bench = SUITE[name]
+    cmd = ([os.path.join(build_dir, bench["program"])] +
+           bench["args"](size, tmp))
+
+    env = dict(os.environ)
+    env["THRILL_LOCAL"] = str(workers)
+    env["THRILL_WORKERS_PER_HOST"] = "1"
+
+    start = time.time()
+    proc = subprocess.Popen(cmd, env=env, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    output, _ = proc.communicate()
+    took = time.time() - start
+
+    if proc.returncode != 0:
+        sys.stderr.write(output)
+        raise RuntimeError("%s failed with exit code %d"
+                           % (" ".join(cmd), proc.returncode))
+
+    return took, parse_results(output)
+
+
+def median(values):
+    values = sorted(values)
+    mid = len(values) // 2
+    if len(values) % 2:
+        return values[mid]
+    return (values[mid - 1] + values[mid]) / 2.0
+
+
+def run_suite(args, tmp):
+    "run all configurations, returns the list of result records"
+    records = []
+    max_workers = max(args.workers)
+
+    for name in args.benchmarks:
+        for scale in args.scales:
+            base = int(SUITE[name]["base_size"] * scale)
+            for mode in args.modes:
+                for workers in args.workers:
+                    # weak scaling grows the input with the workers, strong
+                    # scaling fixes it at the size of the largest run.
+                    size = base * (workers if mode == "weak" else max_workers)
+
+                    times = []
+                    results = []
+                    for _ in range(args.repeat):
+                        took, res = run_once(name, workers, size, tmp)
+                        times.append(took)
+                        results.extend(res)
+
+                    rec = {
+                        "benchmark": name, "mode": mode,
+                        "workers": workers, "size": size,
+                        "unit": SUITE[name]["unit"],
+                        "times": times, "time": median(times),
+                        "throughput": size / median(times),
+                        "results": results,
+                    }
+                    records.append(rec)
+
+                    print("RESULT benchmark=%s mode=%s workers=%d size=%d"
+                          " time=%.6f throughput=%.3f"
+                          % (name, mode, workers, size,
+                             rec["time"], rec["throughput"]))
+                    sys.stdout.flush()
+
+    return records
+
+
+def record_key(rec):
+    return (rec["benchmark"], rec["mode"], rec["workers"], rec["size"])
+
+
+def compare(records, baseline, threshold):
+    "print throughput changes against baseline, returns number of regressions"
+    base = dict((record_key(r), r) for r in baseline)
+    regressions = 0
+
+    for rec in records:
+        old = base.get(record_key(rec))
+        if old is None:
+            continue
+        ratio = rec["throughput"] / old["throughput"]
+        status = "ok"
+        if ratio < 1.0 - threshold:
+            status = "REGRESSION"
+            regressions += 1
+        print("%-10s %-14s %-6s workers=%-4d size=%-12d %+.1f%%"
+              % (status, rec["benchmark"], rec["mode"], rec["workers"],
+                 rec["size"], (ratio - 1.0) * 100.0))
+
+    return regressions
+
+
+def parse_list(conv):
+    return lambda s: [conv(x) for x in s.split(",") if x]
+
+
+def main():
+    global build_dir
+
+    p = argparse.ArgumentParser(
+        description="Run the Thrill scaling benchmark suite.")
+    p.add_argument("--build", default="build",
+                   help="build directory, default: build")
+    p.add_argument("--benchmarks", type=parse_list(str),
+                   default=sorted(SUITE.keys()),
+                   help="comma separated subset of: "
+                   + ", ".join(sorted(SUITE.keys())))
+    p.add_argument("--workers", type=parse_list(int), default=[1, 2, 4, 8],
+                   help="comma separated worker counts, default: 1,2,4,8")
+    p.add_argument("--scales", type=parse_list(float), default=[1.0],
+                   help="comma separated factors of the base input sizes")
+    p.add_argument("--modes", type=parse_list(str), default=["weak", "strong"],
+                   help="scaling modes: weak,strong")
+    p.add_argument("--repeat", type=int, default=3,
+                   help="runs per configuration, the median is used")
+    p.add_argument("--output", help="write results as JSON to this file")
+    p.add_argument("--baseline", help="compare with results in this JSON file")
+    p.add_argument("--threshold", type=float, default=0.1,
+                   help="relative throughput loss flagged as regression")
+    args = p.parse_args()
+
+    for name in args.benchmarks:
+        if name not in SUITE:
+            p.error("unknown benchmark " + name)
+    for mode in args.modes:
+        if mode not in ("weak", "strong"):
+            p.error("unknown scaling mode " + mode)
+
+    build_dir = os.path.abspath(args.build)
+
+    tmp = tempfile.mkdtemp(prefix="thrill-suite-")
+    try:
+        records = run_suite(args, tmp)
+    finally:
+        for f in os.listdir(tmp):
+            os.unlink(os.path.join(tmp, f))
+        os.rmdir(tmp)
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(records, f, indent=2, sort_keys=True)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if compare(records, baseline, args.threshold):
+            return 1
+
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
+
+##########################################################################
@@ -16,6 +16,7 @@
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/collapse.hpp>
+#include <thrill/api/iterate.hpp>
 #include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/sample.hpp>
 #include <thrill/api/sum.hpp>
@@ -24,6 +25,7 @@
 #include <thrill/data/serialization_cereal.hpp>
 
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -304,55 +306,62 @@ auto KMeans(const DIA<Point, InStack>&input_points,
     using ClosestCentroid = ClosestCentroid<Point>;
     using CentroidAccumulated = CentroidAccumulated<Point>;
 
-    DIA<Point> centroids = points.Sample(num_clusters);
-
-    for (size_t iter = 0; iter < iterations; ++iter) {
-
-        // handling this local variable is difficult: it is calculated as an
-        // Action here, but must exist later when the Map() is
-        // processed. Hhence, we move it into the closure.
-        std::vector<Point> local_centroids = centroids.AllGather();
-
-        // calculate the closest centroid for each point
-        auto closest = points.Map(
-            [local_centroids = std::move(local_centroids)](const Point& p) {
-                assert(local_centroids.size());
-                double min_dist = p.DistanceSquare(local_centroids[0]);
-                size_t closest_id = 0;
-
-                for (size_t i = 1; i < local_centroids.size(); ++i) {
-                    double dist = p.DistanceSquare(local_centroids[i]);
-                    if (dist < min_dist) {
-                        min_dist = dist;
-                        closest_id = i;
+    // each iteration materializes the new centroids and releases the previous
+    // ones.
+    std::vector<Point> centroids = Iterate(
+        points.Sample(num_clusters), iterations,
+        [&points](const DIA<Point>& centroids, size_t) {
+
+            // handling this local variable is difficult: it is calculated as
+            // an Action here, but must exist later when the Map() is
+            // processed. Hence, we capture the pointer to the host's shared
+            // copy in the closure.
+            std::shared_ptr<const std::vector<Point> > local_centroids =
+                centroids.AllGatherShared();
+
+            // calculate the closest centroid for each point
+            auto closest = points.Map(
+                [local_centroids](const Point& p) {
+                    const std::vector<Point>& c = *local_centroids;
+                    assert(c.size());
+                    double min_dist = p.DistanceSquare(c[0]);
+                    size_t closest_id = 0;
+
+                    for (size_t i = 1; i < c.size(); ++i) {
+                        double dist = p.DistanceSquare(c[i]);
+                        if (dist < min_dist) {
+                            min_dist = dist;
+                            closest_id = i;
+                        }
                     }
-                }
-                return ClosestCentroid {
-                    closest_id, CentroidAccumulated { p, 1 }
-                };
-            });
-
-        // Calculate new centroids as the mean of all points associated with it.
-        centroids =
-            closest
-            .ReduceByKey(
-                [](const ClosestCentroid& cc) { return cc.cluster_id; },
-                [](const ClosestCentroid& a, const ClosestCentroid& b) {
                     return ClosestCentroid {
-                        a.cluster_id,
-                        CentroidAccumulated { a.center.p + b.center.p,
-                                              a.center.count + b.center.count }
+                        closest_id, CentroidAccumulated { p, 1 }
                     };
-                })
-            .Map([](const ClosestCentroid& cc) {
-                     return cc.center.p / static_cast<double>(cc.center.count);
-                 })
-            .Collapse();
-    }
+                });
+
+            // Calculate new centroids as the mean of all points associated
+            // with it.
+            return
+                closest
+                .ReduceByKey(
+                    [](const ClosestCentroid& cc) { return cc.cluster_id; },
+                    [](const ClosestCentroid& a, const ClosestCentroid& b) {
+                        return ClosestCentroid {
+                            a.cluster_id,
+                            CentroidAccumulated {
+                                a.center.p + b.center.p,
+                                a.center.count + b.center.count
+                            }
+                        };
+                    })
+                .Map([](const ClosestCentroid& cc) {
+                         return cc.center.p
+                         / static_cast<double>(cc.center.count);
+                     });
+        }).AllGather();
 
     return KMeansModel<Point>(
-        dimensions, num_clusters, iterations,
-        centroids.AllGather());
+        dimensions, num_clusters, iterations, centroids);
 }
 
 } // namespace k_means
@@ -14,6 +14,8 @@
 
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/iterate.hpp>
+#include <thrill/api/pregel.hpp>
 #include <thrill/api/print.hpp>
 #include <thrill/api/reduce_to_index.hpp>
 #include <thrill/api/size.hpp>
@@ -68,66 +70,101 @@ auto PageRank(const DIA<OutgoingLinks, InStack>&links,
 
     // initialize all ranks to 1.0 / n: (url, rank)
 
-    DIA<Rank> ranks =
-        Generate(
-            ctx,
-            [num_pages_d](size_t) { return Rank(1.0) / num_pages_d; },
-            num_pages)
-        .Collapse();
-
-    // do iterations
-    for (size_t iter = 0; iter < iterations; ++iter) {
-
-        // for all outgoing link, get their rank contribution from all
-        // links by doing:
-        //
-        // 1) group all outgoing links with rank of its parent page: (Zip)
-        // ([linked_url, linked_url, ...], rank_parent)
-        //
-        // 2) compute rank contribution for each linked_url: (FlatMap)
-        // (linked_url, rank / outgoing.size)
-
-        auto outs_rank = links.Zip(
-            ranks,
-            [](const OutgoingLinks& ol, const Rank& r) {
-                return OutgoingLinksRank(ol, r);
-            });
-
-        if (debug) {
-            outs_rank
-            .Map([](const OutgoingLinksRank& ol) {
-                     return common::Join(',', ol.first)
-                     + " <- " + std::to_string(ol.second);
-                 })
-            .Print("outs_rank");
-        }
-
-        auto contribs = outs_rank.template FlatMap<PageRankPair>(
-            [](const OutgoingLinksRank& p, auto emit) {
-                if (p.first.size() > 0) {
-                    Rank rank_contrib = p.second / static_cast<double>(p.first.size());
-                    for (const PageId& tgt : p.first)
-                        emit(PageRankPair { tgt, rank_contrib });
-                }
-            });
-
-        // reduce all rank contributions by adding all rank contributions and
-        // compute the new rank: (url, rank)
-
-        ranks =
-            contribs
-            .ReduceToIndex(
-                [](const PageRankPair& p) { return p.page; },
-                [](const PageRankPair& p1, const PageRankPair& p2) {
-                    return PageRankPair { p1.page, p1.rank + p2.rank };
-                }, num_pages)
-            .Map([num_pages_d](const PageRankPair& p) {
-                     return dampening * p.rank + (1 - dampening) / num_pages_d;
-                 })
-            .Collapse();
+    auto initial_ranks = Generate(
+        ctx,
+        [num_pages_d](size_t) { return Rank(1.0) / num_pages_d; },
+        num_pages);
+
+    // do iterations, each one materializes the new ranks and releases the
+    // previous ones.
+    return Iterate(
+        initial_ranks, iterations,
+        [&links, num_pages, num_pages_d](const DIA<Rank>& ranks, size_t) {
+
+            // for all outgoing link, get their rank contribution from all
+            // links by doing:
+            //
+            // 1) group all outgoing links with rank of its parent page: (Zip)
+            // ([linked_url, linked_url, ...], rank_parent)
+            //
+            // 2) compute rank contribution for each linked_url: (FlatMap)
+            // (linked_url, rank / outgoing.size)
+
+            auto outs_rank = links.Zip(
+                ranks,
+                [](const OutgoingLinks& ol, const Rank& r) {
+                    return OutgoingLinksRank(ol, r);
+                });
+
+            if (debug) {
+                outs_rank
+                .Map([](const OutgoingLinksRank& ol) {
+                         return common::Join(',', ol.first)
+                         + " <- " + std::to_string(ol.second);
+                     })
+                .Print("outs_rank");
+            }
+
+            auto contribs = outs_rank.template FlatMap<PageRankPair>(
+                [](const OutgoingLinksRank& p, auto emit) {
+                    if (p.first.size() > 0) {
+                        Rank rank_contrib =
+                            p.second / static_cast<double>(p.first.size());
+                        for (const PageId& tgt : p.first)
+                            emit(PageRankPair { tgt, rank_contrib });
+                    }
+                });
+
+            // reduce all rank contributions by adding all rank contributions
+            // and compute the new rank: (url, rank)
+
+            return
+                contribs
+                .ReduceToIndex(
+                    [](const PageRankPair& p) { return p.page; },
+                    [](const PageRankPair& p1, const PageRankPair& p2) {
+                        return PageRankPair { p1.page, p1.rank + p2.rank };
+                    }, num_pages)
+                .Map([num_pages_d](const PageRankPair& p) {
+                         return dampening * p.rank
+                         + (1 - dampening) / num_pages_d;
+                     });
+        });
+}
+
+//! PageRank on a Pregel graph, which keeps the links on their worker, such
+//! that only the rank contributions are exchanged in each iteration.
+template <typename InStack>
+auto PageRankPregel(const DIA<OutgoingLinks, InStack>&links,
+                    size_t num_pages, size_t iterations) {
+
+    double num_pages_d = static_cast<double>(num_pages);
+
+    // initialize all ranks to 1.0 / n
+    Pregel<Rank, Rank> graph(
+        links, [num_pages_d](size_t) { return Rank(1.0) / num_pages_d; },
+        Rank(0.0));
+    die_unless(graph.num_vertices() == num_pages);
+
+    // superstep 0 only sends the initial contributions, each further one
+    // computes the new rank from the sum of contributions, and all but the
+    // last send the new contributions.
+    for (size_t iter = 0; iter <= iterations; ++iter) {
+        graph.Superstep(
+            [iter, iterations, num_pages_d](
+                size_t, Rank& rank, const Rank& contrib,
+                const Pregel<Rank, Rank>::Edges& edges, auto send) {
+                if (iter != 0)
+                    rank = dampening * contrib + (1 - dampening) / num_pages_d;
+                if (iter == iterations || edges.empty()) return;
+                Rank rank_contrib = rank / static_cast<double>(edges.size());
+                for (const PageId& tgt : edges)
+                    send(tgt, rank_contrib);
+            },
+            [](const Rank& a, const Rank& b) { return a + b; });
     }
 
-    return ranks;
+    return graph.States();
 }
 
 } // namespace page_rank
@@ -28,6 +28,7 @@
 #include <thrill/api/window.hpp>
 #include <thrill/api/write_binary.hpp>
 #include <thrill/api/zip.hpp>
+#include <thrill/api/zip_with_index.hpp>
 #include <thrill/common/cmdline_parser.hpp>
 
 #include <algorithm>
@@ -334,10 +335,9 @@ DIA<size_t> DC3(Context& ctx, const InputDIA& input_dia, size_t input_size) {
 
         ranks_rec =
             suffix_array_rec
-            .Zip(Generate(ctx, size_subp),
-                 [](size_t sa, size_t i) {
-                     return IndexRank { sa, i };
-                 })
+            .ZipWithIndex([](size_t sa, size_t i) {
+                              return IndexRank { sa, i };
+                          })
             .Sort([](const IndexRank& a, const IndexRank& b) {
                       // TODO(tb): change sort order for better locality later.
                       return a.index < b.index;
@@ -352,10 +352,9 @@ DIA<size_t> DC3(Context& ctx, const InputDIA& input_dia, size_t input_size) {
 
         ranks_rec =
             triple_index_sorted
-            .Zip(Generate(ctx, size_subp),
-                 [](size_t sa, size_t i) {
-                     return IndexRank { sa, i };
-                 })
+            .ZipWithIndex([](size_t sa, size_t i) {
+                              return IndexRank { sa, i };
+                          })
             .Sort([](const IndexRank& a, const IndexRank& b) {
                       // TODO(tb): change sort order for better locality later.
                       if (a.index % 3 == b.index % 3)
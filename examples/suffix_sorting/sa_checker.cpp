@@ -10,12 +10,12 @@
 
 #include <examples/suffix_sorting/sa_checker.hpp>
 
-#include <thrill/api/generate.hpp>
 #include <thrill/api/max.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/sort.hpp>
 #include <thrill/api/window.hpp>
 #include <thrill/api/zip.hpp>
+#include <thrill/api/zip_with_index.hpp>
 
 #include <ostream>
 #include <utility>
@@ -53,8 +53,6 @@ struct Index3 {
 template <typename InputDIA, typename SuffixArrayDIA>
 bool CheckSA(const InputDIA& input, const SuffixArrayDIA& suffix_array) {
 
-    Context& ctx = input.ctx();
-
     using Char = typename InputDIA::ValueType;
     using Index3 = suffix_sorting::Index3<Char>;
 
@@ -63,10 +61,9 @@ bool CheckSA(const InputDIA& input, const SuffixArrayDIA& suffix_array) {
     auto isa_pair =
         suffix_array
         // build tuples with index: (SA[i]) -> (i, SA[i]),
-        .Zip(Generate(ctx, input_size),
-             [](size_t sa, size_t i) {
-                 return IndexRank { sa, i };
-             })
+        .ZipWithIndex([](size_t sa, size_t i) {
+                          return IndexRank { sa, i };
+                      })
         // take (i, SA[i]) and sort to (ISA[i], i)
         .Sort([](const IndexRank& a, const IndexRank& b) {
                   return a.index < b.index;
@@ -76,10 +73,9 @@ bool CheckSA(const InputDIA& input, const SuffixArrayDIA& suffix_array) {
     // permutation of [0,n)
     size_t perm_check =
         isa_pair.Keep()
-        .Zip(Generate(ctx, input_size),
-             [](const IndexRank& ir, size_t index) -> size_t {
-                 return ir.index == index ? 0 : 1;
-             })
+        .ZipWithIndex([](const IndexRank& ir, size_t index) -> size_t {
+                          return ir.index == index ? 0 : 1;
+                      })
         // sum over all boolean values.
         .Max();
 
@@ -17,6 +17,7 @@
 #include <thrill/common/string.hpp>
 
 #include <algorithm>
+#include <array>
 #include <random>
 #include <string>
 #include <utility>
@@ -38,6 +39,15 @@ struct Record {
 
 static_assert(sizeof(Record) == 100, "struct Record packing incorrect.");
 
+//! key extractor for radix sorting of Records
+struct RecordKey {
+    std::array<uint8_t, 10> operator () (const Record& r) const {
+        std::array<uint8_t, 10> k;
+        std::copy(r.key, r.key + 10, k.begin());
+        return k;
+    }
+};
+
 struct RecordSigned {
     char key[10];
     char value[90];
@@ -122,6 +132,11 @@ int main(int argc, char* argv[]) {
                 "compare with signed chars to compare with broken Java "
                 "implementations, default: false");
 
+    bool use_radix_sort = false;
+    clp.AddFlag('r', "radix", use_radix_sort,
+                "sort unsigned records using radix sort on the keys, "
+                "default: false");
+
     bool generate = false;
     clp.AddFlag('g', "generate", generate,
                 "generate binary record on-the-fly for testing."
@@ -183,6 +198,15 @@ int main(int argc, char* argv[]) {
                     else
                         r.Execute();
                 }
+                else if (use_radix_sort) {
+                    auto r = ReadBinary<Record>(ctx, input)
+                             .Sort(RadixSortTag, RecordKey());
+
+                    if (output.size())
+                        r.WriteBinary(output);
+                    else
+                        r.Execute();
+                }
                 else {
                     auto r = ReadBinary<Record>(ctx, input).Sort();
 
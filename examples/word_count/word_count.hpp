@@ -38,9 +38,8 @@ auto WordCount(const DIA<std::string, InputStack>&input) {
     auto word_pairs = input.template FlatMap<WordCountPair>(
         [](const std::string& line, auto emit) -> void {
                 /* map lambda: emit each word */
-            common::SplitView(
+            common::SplitWords(
                 line, ' ', [&](const common::StringView& sv) {
-                    if (sv.size() == 0) return;
                     emit(WordCountPair(sv.ToString(), 1));
                 });
         });
@@ -69,9 +68,8 @@ auto FastWordCount(const DIA<std::string, InputStack>&input) {
     auto word_pairs = input.template FlatMap<FastWordCountPair>(
         [](const std::string& line, auto emit) -> void {
                 /* map lambda: emit each word */
-            common::SplitView(
+            common::SplitWords(
                 line, ' ', [&](const common::StringView& sv) {
-                    if (sv.size() == 0) return;
                     emit(FastWordCountPair(sv.ToFastString(), 1));
                 });
         });
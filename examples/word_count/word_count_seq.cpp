@@ -41,9 +41,8 @@ int main(int argc, char* argv[]) {
         std::string line;
         while (std::getline(in, line, '\n'))
         {
-            common::SplitView(
+            common::SplitWords(
                 line, ' ', [&](const common::StringView& sv) {
-                    if (sv.size() == 0) return;
                     ++count_map[sv.ToString()];
                 });
         }
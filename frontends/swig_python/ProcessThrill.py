@@ -0,0 +1,77 @@
+#!/usr/bin/env python
+##########################################################################
+# frontends/swig_python/ProcessThrill.py
+#
+# Run a Thrill job with one process per worker, such that Python callbacks of
+# different workers do not share one GIL.
+#
+# Part of Project Thrill - http://project-thrill.org
+#
+# All rights reserved. Published under the BSD-2 license in the LICENSE file.
+##########################################################################
+
+import multiprocessing
+import socket
+import traceback
+
+import thrill
+
+
+def free_endpoints(num_workers):
+    # bind to ephemeral ports to find free ones, then release them for Thrill.
+    socks = []
+    for _ in range(0, num_workers):
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.bind(("127.0.0.1", 0))
+        socks.append(s)
+    endpoints = ["127.0.0.1:%d" % s.getsockname()[1] for s in socks]
+    for s in socks:
+        s.close()
+    return endpoints
+
+
+def _run_worker(job, rank, endpoints, queue):
+    try:
+        ctx = thrill.PyContext.ConstructTcp(rank, endpoints, len(endpoints))
+        result = job(ctx)
+        # destroy the context, which closes the connections, before reporting.
+        del ctx
+        queue.put((rank, True, result))
+    except Exception:
+        queue.put((rank, False, traceback.format_exc()))
+
+
+def RunProcesses(job, num_workers):
+    """Run job(ctx) on num_workers forked worker processes, which are connected
+    via TCP on localhost, and return the list of their results by rank. The
+    job receives a PyContext with the same API as in threads, and its results
+    must be picklable."""
+    endpoints = free_endpoints(num_workers)
+
+    mp = multiprocessing.get_context("fork")
+    queue = mp.Queue()
+    procs = [mp.Process(target=_run_worker,
+                        args=(job, rank, endpoints, queue))
+             for rank in range(0, num_workers)]
+    for p in procs:
+        p.start()
+
+    # collect results before joining, such that large results do not block
+    # the workers on a full pipe.
+    results = [None] * num_workers
+    errors = []
+    for _ in range(0, num_workers):
+        rank, ok, value = queue.get()
+        if ok:
+            results[rank] = value
+        else:
+            errors.append("worker %d:\n%s" % (rank, value))
+
+    for p in procs:
+        p.join()
+
+    if errors:
+        raise Exception("\n".join(errors))
+    return results
+
+##########################################################################
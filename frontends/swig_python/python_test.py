@@ -9,11 +9,19 @@
 # All rights reserved. Published under the BSD-2 license in the LICENSE file.
 ##########################################################################
 
+import array
+import os
 import unittest
 import threading
 import sys
 
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
 import thrill
+from ProcessThrill import RunProcesses
 
 
 class TryThread(threading.Thread):
@@ -112,6 +120,163 @@ class TestOperations(unittest.TestCase):
 
         run_tests(test)
 
+    def test_distribute_native_types(self):
+
+        def test(ctx):
+            items = [None, True, False, 0, -1, 2**62, -2**63, 2**70, 1.5,
+                     "hello", u"\u00e4\u00f6", b"bytes", (1, "a", 2.5),
+                     [(-5, None), [b"", ""]], {"dict": 1}]
+
+            # each worker pushes the items through the serialization
+            dia1 = ctx.Distribute(items)
+            self.assertEqual(dia1.AllGather(), items)
+
+        run_tests(test)
+
+    def test_distribute_encoding_edge_cases(self):
+
+        def test(ctx):
+            # limits of the native int encoding, empty containers, deep
+            # nesting, and objects which fall back to marshal: big ints, a
+            # lone surrogate which is no UTF-8, sets, complex numbers, and
+            # containers holding them.
+            items = [2**63 - 1, -2**63 + 1, 2**63, -2**63 - 1, 2**64, -1, 1,
+                     float("inf"), float("-inf"), -0.0, "", b"", (), [],
+                     ((((("deep",),),),),), [[[[[]]]]], u"\ud800",
+                     frozenset([1, 2]), {3}, 1 + 2j, (1, 2**80, [u"\ud800"])]
+
+            dia1 = ctx.Distribute(items)
+            result = dia1.AllGather()
+            self.assertEqual(result, items)
+            for a, b in zip(result, items):
+                self.assertEqual(type(a), type(b))
+            # the sign of zero survives
+            self.assertEqual(str(result[9]), "-0.0")
+
+            # items go through the network as keys and values of a reduce
+            dia2 = ctx.Generate(
+                lambda x: (x % 3, [None, -x, float(x), "s%d" % x, b"b"]), 300)
+            dia3 = dia2.ReduceBy(
+                lambda x: x[0],
+                lambda x, y: (x[0], [None, x[1][1] + y[1][1],
+                                     x[1][2] + y[1][2],
+                                     min(x[1][3], y[1][3]), b"b"]))
+            res = sorted(dia3.AllGather())
+            self.assertEqual(len(res), 3)
+            for k in range(0, 3):
+                vals = range(k, 300, 3)
+                self.assertEqual(res[k][0], k)
+                self.assertEqual(res[k][1],
+                                 [None, -sum(vals), float(sum(vals)),
+                                  min("s%d" % v for v in vals), b"b"])
+
+        run_tests(test)
+
+    def test_double_batches(self):
+
+        def test(ctx):
+            test_size = 1024
+
+            dia1 = ctx.DistributeArray([float(x) for x in range(0, test_size)])
+            self.assertEqual(dia1.Size(), test_size)
+
+            # each batch is a memoryview of doubles
+            dia2 = dia1.MapBatches(lambda b: [2 * x for x in b], 100)
+
+            check = [float(2 * x) for x in range(0, test_size)]
+            self.assertEqual(list(dia2.AllGather()), check)
+
+            self.assertEqual(dia2.Sum(), sum(check))
+            self.assertEqual(dia2.Min(), 0.0)
+            self.assertEqual(dia2.Max(), float(2 * (test_size - 1)))
+
+            # conversion from a PyDIA
+            dia3 = ctx.Generate(lambda x: int(x), test_size).ToDouble()
+            self.assertEqual(dia3.Sum(), sum(range(0, test_size)))
+
+        run_tests(test)
+
+    def test_double_batch_views(self):
+
+        def test(ctx):
+            test_size = 1000
+            batch_size = 64
+
+            dia1 = ctx.DistributeArray([float(x) for x in range(0, test_size)])
+
+            # batches are read-only views of consecutive doubles, which are
+            # answered with float64 buffers of any length
+            def keep_even(batch):
+                self.assertEqual(batch.format, 'd')
+                self.assertTrue(batch.readonly)
+                self.assertTrue(0 < len(batch) <= batch_size)
+                for i in range(1, len(batch)):
+                    self.assertEqual(batch[i - 1] + 1, batch[i])
+                return array.array('d', [x for x in batch if x % 2 == 0])
+
+            dia2 = dia1.MapBatches(keep_even, batch_size).Cache()
+            check = [float(x) for x in range(0, test_size, 2)]
+            self.assertEqual(dia2.Size(), len(check))
+            self.assertEqual(list(dia2.AllGather()), check)
+
+            # a view kept beyond the call is released
+            kept = []
+            dia3 = dia1.MapBatches(lambda b: kept.append(b) or b, batch_size)
+            self.assertEqual(dia3.Sum(), sum(range(0, test_size)))
+            for b in kept:
+                self.assertRaises(ValueError, len, b)
+
+            # an empty result drops the batch
+            dia4 = dia1.MapBatches(lambda b: [], batch_size)
+            self.assertEqual(dia4.Size(), 0)
+
+            if numpy is not None:
+                dia5 = dia1.MapBatches(
+                    lambda b: numpy.frombuffer(b, dtype=numpy.float64) * 3,
+                    batch_size)
+                self.assertEqual(dia5.Sum(), 3 * sum(range(0, test_size)))
+
+        run_tests(test)
+
+    def test_process_per_worker(self):
+
+        def job(ctx):
+            test_size = 1024
+
+            dia1 = ctx.Generate(lambda x: int(x), test_size)
+            dia2 = dia1.Map(lambda x: x * x)
+            return [dia2.Size(), dia2.AllGather()]
+
+        check = [x * x for x in range(0, 1024)]
+        for num_workers in [1, 3]:
+            results = RunProcesses(job, num_workers)
+            self.assertEqual(results, [[1024, check]] * num_workers)
+
+    def test_process_per_worker_pids_and_errors(self):
+
+        def job(ctx):
+            # each worker is a separate process, and large results pass
+            dia1 = ctx.Generate(lambda x: int(x), 100000)
+            return [ctx.my_rank(), os.getpid(), dia1.Size(), "x" * 1000000]
+
+        results = RunProcesses(job, 3)
+        self.assertEqual([r[0] for r in results], [0, 1, 2])
+        self.assertEqual(len(set(r[1] for r in results)), 3)
+        self.assertNotIn(os.getpid(), [r[1] for r in results])
+        self.assertEqual([r[2] for r in results], [100000] * 3)
+        self.assertEqual([len(r[3]) for r in results], [1000000] * 3)
+
+        def failing_job(ctx):
+            if ctx.my_rank() == 1:
+                raise ValueError("failing worker")
+            return ctx.my_rank()
+
+        # the exception names the rank and carries the worker's traceback
+        with self.assertRaises(Exception) as cm:
+            RunProcesses(failing_job, 2)
+        self.assertIn("worker 1", str(cm.exception))
+        self.assertIn("failing worker", str(cm.exception))
+
     def my_generator(self, index):
         #print("generator at index", index)
         return (index, "hello at %d" % (index))
@@ -19,15 +19,23 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/distribute.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/max.hpp>
+#include <thrill/api/min.hpp>
 #include <thrill/api/reduce.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/sum.hpp>
+#include <thrill/api/window.hpp>
+#include <thrill/common/die.hpp>
 #include <thrill/common/string.hpp>
+#include <thrill/net/tcp/construct.hpp>
 
 #include <Python.h>
 #include <bytesobject.h>
 #include <marshal.h>
 
 #include <functional>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -120,16 +128,130 @@ typedef swig::SwigVar_PyObject PyObjectVarRef;
 
 namespace data {
 
+//! type tags of the native encoding of PyObjects
+enum class PyObjectTag : uint8_t {
+    None, False, True, Int, Float, Str, Bytes, Tuple, List, Marshal
+};
+
 /*!
- * Thrill serialization interface for PyObjects: call the PyMarshal C API.
+ * Encodes PyObjects compactly: None, bools, ints fitting into 64 bits, floats,
+ * str, bytes, and tuples and lists thereof are written natively into the
+ * Archive with a one byte tag, all other objects are marshalled. Requires the
+ * GIL.
  */
 template <typename Archive>
-struct Serialization<Archive, PyObjectRef>
+class PyObjectEncoder
 {
-    static void Serialize(const PyObjectRef& obj, Archive& ar) {
-        SWIG_PYTHON_THREAD_BEGIN_BLOCK;
-        PyObject* mar =
-            PyMarshal_WriteObjectToString(obj.get(), Py_MARSHAL_VERSION);
+public:
+    static void Write(PyObject* obj, Archive& ar) {
+        if (obj == Py_None) {
+            PutTag(ar, PyObjectTag::None);
+        }
+        else if (PyBool_Check(obj)) {
+            PutTag(ar, obj == Py_True ? PyObjectTag::True : PyObjectTag::False);
+        }
+        else if (PyLong_CheckExact(obj)) {
+            int overflow;
+            long long v = PyLong_AsLongLongAndOverflow(obj, &overflow);
+            if (overflow) return WriteMarshal(obj, ar);
+            // zigzag encoding keeps small negative numbers short
+            PutTag(ar, PyObjectTag::Int);
+            ar.PutVarint((static_cast<uint64_t>(v) << 1) ^
+                         static_cast<uint64_t>(v >> 63));
+        }
+        else if (PyFloat_CheckExact(obj)) {
+            PutTag(ar, PyObjectTag::Float);
+            ar.template PutRaw<double>(PyFloat_AS_DOUBLE(obj));
+        }
+        else if (PyUnicode_CheckExact(obj)) {
+            Py_ssize_t len;
+            const char* data = PyUnicode_AsUTF8AndSize(obj, &len);
+            if (!data) {
+                // e.g. lone surrogates cannot be encoded as UTF-8
+                PyErr_Clear();
+                return WriteMarshal(obj, ar);
+            }
+            PutTag(ar, PyObjectTag::Str);
+            ar.PutString(data, len);
+        }
+        else if (PyBytes_CheckExact(obj)) {
+            PutTag(ar, PyObjectTag::Bytes);
+            ar.PutString(PyBytes_AS_STRING(obj), PyBytes_GET_SIZE(obj));
+        }
+        else if (PyTuple_CheckExact(obj)) {
+            PutTag(ar, PyObjectTag::Tuple);
+            Py_ssize_t size = PyTuple_GET_SIZE(obj);
+            ar.PutVarint(size);
+            for (Py_ssize_t i = 0; i < size; ++i)
+                Write(PyTuple_GET_ITEM(obj, i), ar);
+        }
+        else if (PyList_CheckExact(obj)) {
+            PutTag(ar, PyObjectTag::List);
+            Py_ssize_t size = PyList_GET_SIZE(obj);
+            ar.PutVarint(size);
+            for (Py_ssize_t i = 0; i < size; ++i)
+                Write(PyList_GET_ITEM(obj, i), ar);
+        }
+        else {
+            WriteMarshal(obj, ar);
+        }
+    }
+
+    //! returns a new reference
+    static PyObject * Read(Archive& ar) {
+        switch (static_cast<PyObjectTag>(ar.template GetRaw<uint8_t>())) {
+        case PyObjectTag::None:
+            Py_RETURN_NONE;
+        case PyObjectTag::False:
+            Py_RETURN_FALSE;
+        case PyObjectTag::True:
+            Py_RETURN_TRUE;
+        case PyObjectTag::Int: {
+            uint64_t z = ar.GetVarint();
+            return PyLong_FromLongLong(
+                static_cast<long long>((z >> 1) ^ (~(z & 1) + 1)));
+        }
+        case PyObjectTag::Float:
+            return PyFloat_FromDouble(ar.template GetRaw<double>());
+        case PyObjectTag::Str: {
+            std::string data = ar.Read(ar.GetVarint());
+            return PyUnicode_FromStringAndSize(data.data(), data.size());
+        }
+        case PyObjectTag::Bytes: {
+            std::string data = ar.Read(ar.GetVarint());
+            return PyBytes_FromStringAndSize(data.data(), data.size());
+        }
+        case PyObjectTag::Tuple: {
+            Py_ssize_t size = ar.GetVarint();
+            PyObject* tuple = PyTuple_New(size);
+            for (Py_ssize_t i = 0; i < size; ++i)
+                PyTuple_SET_ITEM(tuple, i, Read(ar));
+            return tuple;
+        }
+        case PyObjectTag::List: {
+            Py_ssize_t size = ar.GetVarint();
+            PyObject* list = PyList_New(size);
+            for (Py_ssize_t i = 0; i < size; ++i)
+                PyList_SET_ITEM(list, i, Read(ar));
+            return list;
+        }
+        case PyObjectTag::Marshal: {
+            std::string data = ar.Read(ar.GetVarint());
+            return PyMarshal_ReadObjectFromString(
+                const_cast<char*>(data.data()), data.size());
+        }
+        }
+        die("PyObjectEncoder: invalid type tag");
+    }
+
+private:
+    static void PutTag(Archive& ar, PyObjectTag tag) {
+        ar.template PutRaw<uint8_t>(static_cast<uint8_t>(tag));
+    }
+
+    static void WriteMarshal(PyObject* obj, Archive& ar) {
+        PyObject* mar = PyMarshal_WriteObjectToString(obj, Py_MARSHAL_VERSION);
+        if (!mar) throw std::runtime_error("PyObject cannot be marshalled");
 
         char* data;
         Py_ssize_t len;
@@ -138,16 +260,28 @@ struct Serialization<Archive, PyObjectRef>
         if (debug)
             sLOG0 << "Serialized:" << common::Hexdump(data, len);
 
+        PutTag(ar, PyObjectTag::Marshal);
         ar.PutVarint(len).Append(data, len);
         Py_DECREF(mar);
+    }
+};
+
+/*!
+ * Thrill serialization interface for PyObjects: use the native encoding of
+ * PyObjectEncoder, which falls back to the PyMarshal C API.
+ */
+template <typename Archive>
+struct Serialization<Archive, PyObjectRef>
+{
+    static void Serialize(const PyObjectRef& obj, Archive& ar) {
+        SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+        PyObjectEncoder<Archive>::Write(obj.get(), ar);
         SWIG_PYTHON_THREAD_END_BLOCK;
     }
     static PyObjectRef Deserialize(Archive& ar) {
         SWIG_PYTHON_THREAD_BEGIN_BLOCK;
-        std::string data = ar.Read(ar.GetVarint());
-        PyObjectRef obj(
-            PyMarshal_ReadObjectFromString(
-                const_cast<char*>(data.data()), data.size()));
+        // Read() returns a new reference
+        PyObjectRef obj(PyObjectEncoder<Archive>::Read(ar), false);
         SWIG_PYTHON_THREAD_END_BLOCK;
         return obj;
     }
@@ -180,6 +314,13 @@ public:
     virtual bool operator () (PyObject* obj) = 0;
 };
 
+class BatchMapFunction
+{
+public:
+    virtual ~BatchMapFunction() { }
+    virtual PyObjectVarRef operator () (PyObject* batch) = 0;
+};
+
 class KeyExtractorFunction
 {
 public:
@@ -225,6 +366,163 @@ namespace thrill {
 //! counted PyObjects.
 typedef api::DIA<PyObjectRef> PyObjDIA;
 
+//! typed DIAs of doubles, whose items are passed to python in batches.
+typedef api::DIA<double> PyDoubleDIAType;
+
+#ifndef SWIG
+
+/*!
+ * Wrap an array of doubles in a read-only memoryview with format 'd', without
+ * copying. The view must be released before the array is freed. Requires the
+ * GIL.
+ */
+static inline PyObject * MakeDoubleView(const double* data, size_t size) {
+    PyObject* bytes = PyMemoryView_FromMemory(
+        reinterpret_cast<char*>(const_cast<double*>(data)),
+        size * sizeof(double), PyBUF_READ);
+    if (!bytes) throw std::runtime_error("PyMemoryView_FromMemory() failed");
+    PyObject* view = PyObject_CallMethod(bytes, "cast", "s", "d");
+    Py_DECREF(bytes);
+    if (!view) throw std::runtime_error("memoryview.cast('d') failed");
+    return view;
+}
+
+/*!
+ * Call emit(double) for each item of obj, which is either an object supporting
+ * the buffer protocol with format 'd', such as a NumPy float64 array, or any
+ * sequence of numbers. Requires the GIL.
+ */
+template <typename Emitter>
+static inline void ForEachDouble(PyObject* obj, const Emitter& emit) {
+    if (PyObject_CheckBuffer(obj)) {
+        Py_buffer buf;
+        if (PyObject_GetBuffer(obj, &buf, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0)
+            throw std::runtime_error("batch is not a contiguous buffer");
+        if (buf.itemsize != sizeof(double) || !buf.format ||
+            std::string(buf.format) != "d") {
+            PyBuffer_Release(&buf);
+            throw std::runtime_error("batch buffer is not of type float64");
+        }
+        const double* data = reinterpret_cast<const double*>(buf.buf);
+        for (Py_ssize_t i = 0; i < buf.len / buf.itemsize; ++i)
+            emit(data[i]);
+        PyBuffer_Release(&buf);
+        return;
+    }
+
+    PyObject* seq = PySequence_Fast(obj, "batch must be a buffer or sequence");
+    if (!seq) throw std::runtime_error("batch is not a sequence");
+    Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+    PyObject** items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < size; ++i)
+        emit(PyFloat_AsDouble(items[i]));
+    Py_DECREF(seq);
+}
+
+#endif
+
+/*!
+ * A DIA of doubles. Python callbacks are called once per batch with a
+ * memoryview of format 'd' over the items in the C++ Block, which can be
+ * wrapped with numpy.frombuffer() for vectorized processing. Sum, Min, and Max
+ * run without any Python callback.
+ */
+class PyDoubleDIA
+{
+public:
+    //! underlying C++ DIA class, which can be freely copied by the object.
+    PyDoubleDIAType dia_;
+
+    explicit PyDoubleDIA(const PyDoubleDIAType& dia)
+        : dia_(dia) { }
+
+    //! copy-constructor: default
+    PyDoubleDIA(const PyDoubleDIA& dia) = default;
+
+    /*!
+     * Call map_function on batches of batch_size consecutive items, the last
+     * one may be shorter. The function receives a memoryview, which is only
+     * valid during the call, and returns a buffer or sequence of doubles of any
+     * length.
+     */
+    PyDoubleDIA MapBatches(BatchMapFunction& map_function,
+                           size_t batch_size) const {
+        assert(dia_.IsValid());
+
+        // the object BatchMapFunction is actually an instance of the Director
+        SwigDirector_BatchMapFunction& director =
+            *dynamic_cast<SwigDirector_BatchMapFunction*>(&map_function);
+
+        return PyDoubleDIA(
+            dia_.FlatWindow<double>(
+                api::DisjointTag, batch_size,
+                [&map_function,
+                 // this holds a reference count to the callback object for the
+                 // lifetime of the capture object.
+                 ref = PyObjectRef(director.swig_get_self())
+                ](size_t /* rank */, const std::vector<double>& batch,
+                  auto emit) {
+                    SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+                    PyObject* view = MakeDoubleView(batch.data(), batch.size());
+                    // the callback takes ownership of one reference.
+                    Py_INCREF(view);
+                    PyObjectRef result(map_function(view), true);
+                    ForEachDouble(result.get(), emit);
+                    // invalidate the view, ignore it if python keeps exports.
+                    PyObject* r = PyObject_CallMethod(view, "release", nullptr);
+                    if (!r) PyErr_Clear();
+                    Py_XDECREF(r);
+                    Py_DECREF(view);
+                    SWIG_PYTHON_THREAD_END_BLOCK;
+                })
+            .Collapse());
+    }
+
+    PyDoubleDIA Cache() const {
+        assert(dia_.IsValid());
+        return PyDoubleDIA(dia_.Cache());
+    }
+
+    size_t Size() const {
+        assert(dia_.IsValid());
+        return dia_.Size();
+    }
+
+    double Sum() const {
+        assert(dia_.IsValid());
+        return dia_.Sum();
+    }
+
+    double Min() const {
+        assert(dia_.IsValid());
+        return dia_.Min(common::minimum<double>(),
+                        std::numeric_limits<double>::infinity());
+    }
+
+    double Max() const {
+        assert(dia_.IsValid());
+        return dia_.Max(common::maximum<double>(),
+                        -std::numeric_limits<double>::infinity());
+    }
+
+    //! Returns a memoryview of format 'd' over a copy of all items.
+    PyObject * AllGather() const {
+        assert(dia_.IsValid());
+        std::vector<double> vec = dia_.AllGather();
+
+        SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+        PyObject* array = PyByteArray_FromStringAndSize(
+            reinterpret_cast<const char*>(vec.data()),
+            vec.size() * sizeof(double));
+        PyObject* bytes = PyMemoryView_FromObject(array);
+        Py_DECREF(array);
+        PyObject* view = PyObject_CallMethod(bytes, "cast", "s", "d");
+        Py_DECREF(bytes);
+        SWIG_PYTHON_THREAD_END_BLOCK;
+        return view;
+    }
+};
+
 /*!
  * This is a wrapper around the C++ DIA class, which returns plain PyDIAs
  * again. The C++ function stack is always collapsed.
@@ -335,6 +633,20 @@ public:
         return PyDIA(dia_.Cache());
     }
 
+    //! Convert all items with float() into a PyDoubleDIA.
+    PyDoubleDIA ToDouble() const {
+        assert(dia_.IsValid());
+        return PyDoubleDIA(
+            dia_.Map(
+                [](const PyObjectRef& obj) {
+                    SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+                    double d = PyFloat_AsDouble(obj.get());
+                    SWIG_PYTHON_THREAD_END_BLOCK;
+                    return d;
+                })
+            .Cache());
+    }
+
     size_t Size() const {
         assert(dia_.IsValid());
         return dia_.Size();
@@ -393,6 +705,34 @@ public:
         return contexts;
     }
 
+    /*!
+     * Construct the Context of a worker process, which is host my_rank of a
+     * TCP network of the given endpoints and runs a single worker. Since
+     * each worker then has its own interpreter and GIL, Python callbacks of
+     * different workers run in parallel. The detected RAM is divided among
+     * processes_per_host processes.
+     */
+    static std::shared_ptr<PyContext>
+    ConstructTcp(size_t my_rank, const std::vector<std::string>& endpoints,
+                 size_t processes_per_host) {
+        MemoryConfig mem_config;
+        die_unless(mem_config.setup_detect() >= 0);
+        mem_config = mem_config.divide(processes_per_host);
+
+        std::vector<std::unique_ptr<net::Group> > groups =
+            net::tcp::Construct(my_rank, endpoints, net::Manager::kGroupCount);
+
+        std::vector<net::GroupPtr> host_groups;
+        for (std::unique_ptr<net::Group>& g : groups)
+            host_groups.emplace_back(std::move(g));
+
+        return std::make_shared<PyContext>(
+            std::make_unique<HostContext>(
+                0, mem_config, std::move(host_groups),
+                /* workers_per_host */ 1),
+            /* local_worker_id */ 0);
+    }
+
     PyDIA Generate(GeneratorFunction& generator_function, size_t size) {
 
         // the object GeneratorFunction is actually an instance of the Director
@@ -421,6 +761,20 @@ public:
         return PyDIA(dia);
     }
 
+    //! Distribute a buffer of format 'd', such as a NumPy float64 array, or a
+    //! sequence of numbers as PyDoubleDIA.
+    PyDoubleDIA DistributeArray(PyObject* array) {
+        std::vector<double> vec;
+
+        SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+        ForEachDouble(array, [&vec](double d) { vec.push_back(d); });
+        SWIG_PYTHON_THREAD_END_BLOCK;
+
+        PyDoubleDIAType dia = api::Distribute(*this, std::move(vec));
+
+        return PyDoubleDIA(dia);
+    }
+
 protected:
     std::unique_ptr<HostContext> host_context_;
 };
@@ -24,6 +24,7 @@ using namespace thrill;
 
 %feature("director") MapFunction;
 %feature("director") FilterFunction;
+%feature("director") BatchMapFunction;
 
 %feature("director") KeyExtractorFunction;
 %feature("director") ReduceFunction;
@@ -72,6 +73,9 @@ callback_wrapper('thrill::PyDIA::Map(MapFunction&) const',
 
 callback_wrapper('thrill::PyDIA::Filter(FilterFunction&) const',
                  'FilterFunction');
+
+callback_wrapper('thrill::PyDoubleDIA::MapBatches(BatchMapFunction&, size_t) const',
+                 'BatchMapFunction', '');
 ]]]*/
 %feature("pythonprepend") thrill::PyContext::Generate(GeneratorFunction&, size_t) %{
   wa = []
@@ -116,6 +120,21 @@ callback_wrapper('thrill::PyDIA::Filter(FilterFunction&) const',
     wa.append(args[0])
   args = tuple(wa)
 %}
+%feature("pythonprepend") thrill::PyDoubleDIA::MapBatches(BatchMapFunction&, size_t) const %{
+  wa = []
+  if not isinstance(args[0], BatchMapFunction) and callable(args[0]):
+    class CallableWrapper(BatchMapFunction):
+      def __init__(self, f):
+        super(CallableWrapper, self).__init__()
+        self.f_ = f
+      def __call__(self, *args):
+        return self.f_(*args)
+    wa.append(CallableWrapper(args[0]))
+  else:
+    wa.append(args[0])
+  wa.append(args[1])
+  args = tuple(wa)
+%}
 // [[[end]]]
 
 
@@ -107,14 +107,19 @@ fi
 
 rank=0
 
-# check THRILL_HOSTLIST for hosts without port numbers: add 10000+rank
+# check THRILL_HOSTLIST for hosts without port numbers: add 10000+rank, and
+# keep rack labels after a slash.
 hostlist=()
 for hostport in $THRILL_HOSTLIST; do
+  rack=""
+  case "$hostport" in
+      */*) rack="/${hostport#*/}"; hostport="${hostport%%/*}" ;;
+  esac
   port=$(echo $hostport | awk 'BEGIN { FS=":" } { printf "%s", $2 }')
   if [ -z "$port" ]; then
       hostport="$hostport:$((10000+rank))"
   fi
-  hostlist+=($hostport)
+  hostlist+=($hostport$rack)
   rank=$((rank+1))
 done
 
@@ -124,6 +129,7 @@ export THRILL_HOSTLIST="${hostlist[@]}"
 SSH_PIDS=()
 
 for hostport in $THRILL_SSHLIST; do
+  hostport="${hostport%%/*}"
   host=$(echo $hostport | awk 'BEGIN { FS=":" } { printf "%s", $1 }')
   if [ $verbose -ne 0 ]; then
     echo "Connecting to $user@$host to invoke $cmd"
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+##########################################################################
+# scripts/json2stages.py
+#
+# Python script to parse the JSON output logs of Thrill hosts and print a
+# per-stage cost profile: elapsed and CPU time, bytes shuffled and disk I/O
+# volume, and the imbalance between workers. Additionally, the critical path
+# through the DIA graph is calculated, which shows the stages and straggler
+# workers bounding the wall time of the job.
+#
+# Part of Project Thrill - http://project-thrill.org
+#
+# All rights reserved. Published under the BSD-2 license in the LICENSE file.
+##########################################################################
+
+import sys
+import json
+
+if len(sys.argv) < 2:
+    print("Usage: " + sys.argv[0] + " <thrill-host-log.json> ...")
+    sys.exit(0)
+
+# DIA nodes: id -> { label, parents }
+nodes = {}
+
+# stage phases: (id, phase) -> { worker_rank -> event }
+phases = {}
+
+# stream traffic: dia_id -> { worker_rank -> tx_bytes }
+streams = {}
+
+for input_file in sys.argv[1:]:
+    with open(input_file, 'r') as json_file:
+        for line in json_file:
+            try:
+                data = json.loads(line)
+            except ValueError:
+                continue
+
+            if not "class" in data: continue
+
+            if data["class"] in ("DIABase", "DIA") and data["event"] == "create":
+                nodes[data["id"]] = { "label": data["label"],
+                                      "parents": data["parents"] }
+
+            if data["class"] == "StageBuilder" and \
+               data["event"] in ("execute-done", "pushdata-done"):
+                phase = data["event"].split("-")[0]
+                key = (data["id"], phase)
+                phases.setdefault(key, {})[data["worker_rank"]] = data
+                if not data["id"] in nodes:
+                    nodes[data["id"]] = { "label": data["label"],
+                                          "parents": [] }
+
+            if data["class"] == "Stream" and data["event"] == "close":
+                w = streams.setdefault(data["dia_id"], {})
+                w[data["worker_rank"]] = \
+                    w.get(data["worker_rank"], 0) + data["tx_bytes"]
+
+def fmt_bytes(b):
+    for unit in ["B", "KiB", "MiB", "GiB"]:
+        if abs(b) < 1024.0 or unit == "GiB":
+            return "%.1f %s" % (b, unit)
+        b /= 1024.0
+
+def summarize(key):
+    events = phases[key]
+    elapsed = { w: e["elapsed"] for w, e in events.items() }
+    straggler = max(elapsed, key=elapsed.get)
+    max_t = elapsed[straggler]
+    mean_t = sum(elapsed.values()) / len(elapsed)
+    # disk I/O is counted per host, hence, take maximum over its workers
+    host_io = {}
+    for e in events.values():
+        io = e.get("io_read_bytes", 0) + e.get("io_write_bytes", 0)
+        host_io[e["host_rank"]] = max(host_io.get(e["host_rank"], 0), io)
+    return {
+        "max": max_t,
+        "imbalance": max_t / mean_t if mean_t > 0 else 1.0,
+        "straggler": straggler,
+        "cpu": sum(e.get("cpu_time", 0) for e in events.values()),
+        "io": sum(host_io.values()),
+        "push": sum(e.get("push_bytes", 0) for e in events.values()),
+    }
+
+def node_name(id):
+    return nodes[id]["label"] + "." + str(id)
+
+# print per-stage table in order of maximum elapsed time
+
+summary = { key: summarize(key) for key in phases }
+
+print("%-24s %-9s %10s %9s %9s %10s %12s %12s" %
+      ("stage", "phase", "max [ms]", "imbal.", "straggler",
+       "cpu [ms]", "shuffled", "disk I/O"))
+
+for key in sorted(summary, key=lambda k: -summary[k]["max"]):
+    s = summary[key]
+    shuffled = sum(streams.get(key[0], {}).values()) \
+        if key[1] == "execute" else 0
+    print("%-24s %-9s %10.1f %9.2f %9d %10.1f %12s %12s" %
+          (node_name(key[0]), key[1], s["max"] / 1e3, s["imbalance"],
+           s["straggler"], s["cpu"] / 1e3, fmt_bytes(shuffled),
+           fmt_bytes(s["io"])))
+
+# calculate critical path: the longest path through the DIA graph, weighted by
+# the elapsed time of the slowest worker in each stage phase.
+
+def weight(id):
+    return sum(summary[(id, p)]["max"]
+               for p in ("execute", "pushdata") if (id, p) in summary)
+
+longest = {}
+def longest_path(id):
+    if id in longest: return longest[id]
+    best = (0, [])
+    for p in nodes[id]["parents"]:
+        if p in nodes:
+            cand = longest_path(p)
+            if cand[0] > best[0]: best = cand
+    longest[id] = (best[0] + weight(id), best[1] + [id])
+    return longest[id]
+
+if nodes:
+    total, path = max((longest_path(id) for id in nodes), key=lambda x: x[0])
+
+    print()
+    print("critical path: %.1f ms" % (total / 1e3))
+    for id in path:
+        for p in ("execute", "pushdata"):
+            if not (id, p) in summary: continue
+            s = summary[(id, p)]
+            print("  %-24s %-9s %10.1f ms  straggler worker %d (imbalance %.2f)" %
+                  (node_name(id), p, s["max"] / 1e3, s["straggler"],
+                   s["imbalance"]))
+
+##########################################################################
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+##########################################################################
+# scripts/json2trace.py
+#
+# Convert Thrill's JSON logs into the Chrome Trace Event format, which can be
+# opened in chrome://tracing or https://ui.perfetto.dev as a timeline.
+#
+# Each host is a process with one track per worker, showing the Execute and
+# PushData phases of the stages, one I/O track with block eviction writes and
+# reads, and counters of the profile events (including the dispatcher
+# utilization). Streams are shown as asynchronous spans from open to close.
+#
+# Usage: json2trace.py [-o trace.json] log-host0.json log-host1.json ...
+#
+# Part of Project Thrill - http://project-thrill.org
+#
+#
+# All rights reserved. Published under the BSD-2 license in the LICENSE file.
+##########################################################################
+
+import argparse
+import json
+import numbers
+import sys
+
+# thread ids of the per host tracks, workers use their rank
+TID_IO = 1000000
+TID_DISPATCHER = 1000001
+
+
+def read_events(paths):
+    for path in paths:
+        with open(path, 'r') as f:
+            for line in f:
+                try:
+                    r = json.loads(line)
+                except ValueError:
+                    sys.stderr.write("JSON line invalid: " + line)
+                    continue
+                if isinstance(r, dict) and 'class' in r and 'ts' in r:
+                    yield r
+
+
+def counters(r):
+    "numeric top-level values of a profile event"
+    return dict((k, v) for k, v in r.items()
+                if isinstance(v, numbers.Number) and not isinstance(v, bool)
+                and k not in ('ts', 'host_rank', 'worker_rank'))
+
+
+def convert(records):
+    records = sorted(records, key=lambda r: r['ts'])
+    if not records:
+        return []
+    t0 = records[0]['ts']
+
+    trace = []
+    threads = {}
+
+    def emit(ph, pid, tid, ts, name, **kw):
+        ev = {'ph': ph, 'pid': pid, 'tid': tid, 'ts': ts - t0, 'name': name}
+        ev.update(kw)
+        trace.append(ev)
+
+    for r in records:
+        cls = r['class']
+        event = r.get('event')
+        pid = r.get('host_rank', 0)
+        ts = r['ts']
+
+        if cls == 'StageBuilder' and 'worker_rank' in r:
+            tid = r['worker_rank']
+            threads[(pid, tid)] = "worker %d" % tid
+            name = "%s.%s" % (r.get('label', 'Stage'), r.get('dia_id', '?'))
+            phase = event.split('-')[0] if event else ''
+            if event in ('execute-start', 'pushdata-start'):
+                emit('B', pid, tid, ts, name, cat=phase,
+                     args={'targets': r.get('targets')})
+            elif event in ('execute-done', 'pushdata-done'):
+                args = {}
+                if 'push_bytes' in r:
+                    args['push_bytes'] = r['push_bytes']
+                emit('E', pid, tid, ts, name, cat=phase, args=args)
+
+        elif cls == 'StreamSink' and event in ('open', 'close'):
+            tid = r.get('src_worker', 0)
+            key = "%s:%s->%s" % (r.get('stream'), tid, r.get('tgt_worker'))
+            args = dict((k, r[k]) for k in ('bytes', 'blocks') if k in r)
+            emit('b' if event == 'open' else 'e', pid, tid, ts,
+                 "stream %s" % r.get('stream'), cat='stream', id=key,
+                 args=args)
+
+        elif cls == 'Stream' and event == 'close':
+            tid = r.get('worker_rank', 0)
+            emit('i', pid, tid, ts, "stream %s closed" % r.get('id'),
+                 cat='stream', s='t',
+                 args=dict((k, r[k]) for k in
+                           ('rx_bytes', 'tx_bytes', 'dia_id') if k in r))
+
+        elif cls == 'BlockPool' and event in ('evict', 'read'):
+            threads[(pid, TID_IO)] = "I/O"
+            duration = r.get('duration', 0)
+            emit('X', pid, TID_IO, ts - duration,
+                 'write' if event == 'evict' else 'read', cat='io',
+                 dur=duration,
+                 args=dict((k, r[k]) for k in
+                           ('bytes', 'em_bytes', 'read_ahead') if k in r))
+
+        elif event == 'profile':
+            tid = TID_DISPATCHER if cls == 'Multiplexer' else 0
+            if cls == 'Multiplexer':
+                threads[(pid, TID_DISPATCHER)] = "dispatcher"
+            values = counters(r)
+            if values:
+                emit('C', pid, tid, ts, cls, args=values)
+
+    # name processes and threads
+    for pid in sorted(set(p for p, _ in threads)):
+        trace.append({'ph': 'M', 'pid': pid, 'name': 'process_name',
+                      'args': {'name': "host %d" % pid}})
+    for (pid, tid), name in sorted(threads.items()):
+        trace.append({'ph': 'M', 'pid': pid, 'tid': tid,
+                      'name': 'thread_name', 'args': {'name': name}})
+
+    return trace
+
+
+def main():
+    p = argparse.ArgumentParser(
+        description="Convert Thrill JSON logs to Chrome Trace Event format.")
+    p.add_argument('-o', '--output', help="output file, default: stdout")
+    p.add_argument('inputs', nargs='+', help="JSON log files of all hosts")
+    args = p.parse_args()
+
+    trace = {'traceEvents': convert(read_events(args.inputs)),
+             'displayTimeUnit': 'ms'}
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+if __name__ == '__main__':
+    main()
+
+##########################################################################
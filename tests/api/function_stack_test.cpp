@@ -118,4 +118,57 @@ TEST(API, SimpleDeductionTest) {
     ASSERT_EQ(output[1], "123");
 }
 
+//! item which counts its copies
+struct CopyCounted {
+    std::string value;
+
+    static size_t copies;
+
+    explicit CopyCounted(const std::string& v) : value(v) { }
+
+    CopyCounted(const CopyCounted& o) : value(o.value) { ++copies; }
+    CopyCounted(CopyCounted&&) = default;
+};
+
+size_t CopyCounted::copies = 0;
+
+TEST(API, ForwardRvaluesTest) {
+    using api::MakeFunctionStack;
+
+    // like DIA::Map(), with a map function taking its argument by value
+    auto append_fn = [](CopyCounted c) {
+                         c.value += "x";
+                         return c;
+                     };
+    auto conv_append_fn =
+        [=](auto&& input, auto emit_func) {
+            emit_func(append_fn(std::forward<decltype(input)>(input)));
+        };
+
+    auto fmap_fn =
+        [](const std::string& input, auto emit_func) {
+            emit_func(CopyCounted(input));
+            emit_func(CopyCounted(input + input));
+        };
+
+    std::vector<CopyCounted> output;
+    auto save_fn = [&output](CopyCounted c) {
+                       output.emplace_back(std::move(c));
+                   };
+
+    auto composed_function =
+        MakeFunctionStack<std::string>(fmap_fn)
+        .push(conv_append_fn).push(conv_append_fn).push(conv_append_fn)
+        .push(save_fn).fold();
+
+    CopyCounted::copies = 0;
+    output.reserve(2);
+    composed_function(std::string("ab"));
+
+    ASSERT_EQ(2u, output.size());
+    ASSERT_EQ("abxxx", output[0].value);
+    ASSERT_EQ("ababxxx", output[1].value);
+    ASSERT_EQ(0u, CopyCounted::copies);
+}
+
 /******************************************************************************/
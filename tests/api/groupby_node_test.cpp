@@ -13,14 +13,17 @@
 #include <thrill/api/group_by_key.hpp>
 #include <thrill/api/group_to_index.hpp>
 #include <thrill/api/sum.hpp>
+#include <thrill/common/die.hpp>
 #include <thrill/common/logger.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace thrill; // NOLINT
@@ -123,6 +126,98 @@ TEST(GroupByNode, Median) {
     api::RunLocalTests(start_func);
 }
 
+TEST(GroupByNode, StreamingSumKeepRepeated) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 10000;
+            static constexpr size_t m = 37;
+
+            auto sizets = Generate(ctx, n);
+
+            auto sum_fn =
+                [](auto& r, size_t key) {
+                    size_t res = 0;
+                    while (r.HasNext()) {
+                        size_t n = r.Next();
+                        // all items of a group arrive consecutively
+                        die_unless(n % m == key);
+                        res += n;
+                    }
+                    return res;
+                };
+
+            // group by to compute sum and gather results
+            auto reduced = sizets.GroupByKey<size_t>(
+                StreamingGroupTag, [](size_t in) { return in % m; }, sum_fn)
+                           .Keep();
+
+            // compute vector with expected results
+            std::vector<size_t> res_vec(m, 0);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[t % m] += t;
+            }
+            std::sort(res_vec.begin(), res_vec.end());
+
+            // push results twice, the second time from the stored results
+            for (size_t round = 0; round < 2; ++round) {
+                std::vector<size_t> out_vec = reduced.AllGather();
+                std::sort(out_vec.begin(), out_vec.end());
+                ASSERT_EQ(res_vec, out_vec);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(GroupByNode, CombinerTopThreePerKey) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+            static constexpr size_t m = 31;
+
+            auto integers = Generate(ctx, n);
+
+            // partial groups are the up to three largest elements of a key.
+            using Top = std::vector<size_t>;
+
+            auto init_fn = [](const size_t& in) { return Top { in }; };
+
+            auto merge_fn =
+                [](const Top& a, const Top& b) {
+                    Top res(a.size() + b.size());
+                    std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                               res.begin(), std::greater<size_t>());
+                    if (res.size() > 3) res.resize(3);
+                    return res;
+                };
+
+            auto reduced = integers.GroupByKey(
+                CombinerTag, [](const size_t& in) { return in % m; },
+                init_fn, merge_fn,
+                [](const size_t& key, const Top& top) {
+                    return std::make_pair(key, top);
+                });
+
+            std::vector<std::pair<size_t, Top> > out_vec = reduced.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(m, out_vec.size());
+            for (size_t k = 0; k < m; ++k) {
+                ASSERT_EQ(k, out_vec[k].first);
+                ASSERT_EQ(3u, out_vec[k].second.size());
+                // the largest t < n with t % m == k, and the next two
+                size_t largest = (n - 1) / m * m + k;
+                if (largest >= n) largest -= m;
+                for (size_t i = 0; i < 3; ++i)
+                    ASSERT_EQ(largest - i * m, out_vec[k].second[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(GroupByNode, GroupToIndexCorrectResults) {
 
     auto start_func =
@@ -165,4 +260,51 @@ TEST(GroupByNode, GroupToIndexCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+TEST(GroupByNode, GroupToIndexStringsWithEmptyIndexes) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 3000;
+            static constexpr size_t m = 500;
+
+            // only every third index below 450 receives items
+            auto strings = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return std::to_string((index % 150) * 3) + "-"
+                           + std::to_string(index);
+                },
+                n);
+
+            auto key = [](const std::string& in) -> size_t {
+                           return std::stoul(in);
+                       };
+
+            auto count_function =
+                [](auto& r, size_t /* key */) {
+                    size_t count = 0;
+                    while (r.HasNext()) {
+                        r.Next();
+                        ++count;
+                    }
+                    return std::to_string(count);
+                };
+
+            auto grouped = strings.GroupToIndex<std::string>(
+                key, count_function, m, std::string("none"));
+
+            std::vector<std::string> out_vec = grouped.AllGather();
+
+            ASSERT_EQ(m, out_vec.size());
+            for (size_t i = 0; i < m; ++i) {
+                size_t count = 0;
+                for (size_t t = 0; t < n; ++t)
+                    count += ((t % 150) * 3 == i);
+                ASSERT_EQ(count ? std::to_string(count) : "none", out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
@@ -0,0 +1,318 @@
+/*******************************************************************************
+ * tests/api/join_node_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/inner_join.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
+#include <thrill/api/sort_merge_join.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+TEST(InnerJoin, JoinDuplicateKeys) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            // keys 0..99, each key ten times
+            auto left = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return IntPair(index % 100, index);
+                },
+                1000);
+
+            // only even keys 0..198, each key twice
+            auto right = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return std::to_string(2 * (index % 100));
+                },
+                200);
+
+            auto joined = left.InnerJoin(
+                right,
+                [](const IntPair& p) { return p.first; },
+                [](const std::string& s) { return std::stoul(s); },
+                [](const IntPair& p, const std::string& s) {
+                    return IntPair(std::stoul(s), p.second);
+                });
+
+            std::vector<IntPair> out_vec = joined.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            std::vector<IntPair> check;
+            for (size_t i = 0; i < 1000; ++i) {
+                if ((i % 100) % 2 != 0) continue;
+                check.emplace_back(i % 100, i);
+                check.emplace_back(i % 100, i);
+            }
+            std::sort(check.begin(), check.end());
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(InnerJoin, JoinSmallDimensionTable) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            // large fact table with keys 0..9
+            auto facts = Generate(ctx, 100000);
+
+            // small lookup table of keys 0..4, which is broadcast
+            auto lookup = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return IntPair(index, 100 * index);
+                },
+                5);
+
+            auto joined = facts.InnerJoin(
+                lookup,
+                [](const size_t& i) { return i % 10; },
+                [](const IntPair& p) { return p.first; },
+                [](const size_t& i, const IntPair& p) {
+                    return i + p.second;
+                });
+
+            std::vector<size_t> out_vec = joined.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            std::vector<size_t> check;
+            for (size_t i = 0; i < 100000; ++i) {
+                if (i % 10 < 5) check.push_back(i + 100 * (i % 10));
+            }
+            std::sort(check.begin(), check.end());
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(InnerJoin, JoinSemiJoinFilter) {
+
+    static constexpr size_t test_size = 200000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using Row = std::pair<size_t, std::string>;
+
+            // many items, of which only every 200th has a partner
+            auto facts = Generate(ctx, test_size);
+
+            // few but large items, such that they are not broadcast
+            auto dimension = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return Row(200 * index, std::string(4000, 'x'));
+                },
+                test_size / 200);
+
+            api::DefaultInnerJoinConfig config;
+            config.semi_join_filter_ = true;
+
+            auto joined = facts.InnerJoin(
+                dimension,
+                [](const size_t& i) { return i; },
+                [](const Row& r) { return r.first; },
+                [](const size_t& i, const Row& r) {
+                    return i + r.second.size();
+                },
+                common::Hash<size_t>(), config);
+
+            std::vector<size_t> out_vec = joined.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            std::vector<size_t> check;
+            for (size_t i = 0; i < test_size; i += 200)
+                check.push_back(i + 4000);
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(InnerJoin, JoinGracePartitions) {
+
+    static constexpr size_t test_size = 1000000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto left = Generate(ctx, test_size);
+            auto right = Generate(
+                ctx,
+                [](const size_t& index) { return 3 * index; },
+                test_size);
+
+            auto key_fn = [](const size_t& i) { return i; };
+
+            auto joined = left.InnerJoin(
+                right, key_fn, key_fn,
+                [](const size_t& a, const size_t& b) { return a + b; });
+
+            // keys 0, 3, 6, ... below test_size match
+            ASSERT_EQ((test_size + 2) / 3, joined.Size());
+        };
+
+    // set small amount of RAM, such that the build side is partitioned
+    api::MemoryConfig mem_config;
+    mem_config.setup(64 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(InnerJoin, JoinRecursiveGracePartitions) {
+
+    static constexpr size_t test_size = 1000000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto left = Generate(ctx, test_size);
+            auto right = Generate(
+                ctx,
+                [](const size_t& index) { return 3 * index; },
+                test_size);
+
+            auto key_fn = [](const size_t& i) { return i; };
+
+            // all hash values are multiples of 2 * lcm(1..28), hence all items
+            // land on worker 0 and in the first grace partition, which must
+            // be split again using different hash bits.
+            auto hash_fn = [](const size_t& i) {
+                               return (i + 1) * 2 * 80313433200llu;
+                           };
+
+            auto joined = left.InnerJoin(
+                right, key_fn, key_fn,
+                [](const size_t& a, const size_t& b) { return a + b; },
+                hash_fn);
+
+            // keys 0, 3, 6, ... below test_size match
+            ASSERT_EQ((test_size + 2) / 3, joined.Size());
+        };
+
+    // set small amount of RAM, such that the build side is partitioned
+    api::MemoryConfig mem_config;
+    mem_config.setup(64 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(SortMergeJoin, JoinSortedDuplicateKeys) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            // keys 0..99, each key ten times
+            auto left = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return IntPair(index % 100, index);
+                },
+                1000).Sort(
+                [](const IntPair& a, const IntPair& b) {
+                    return a.first < b.first;
+                });
+
+            // only even keys 0..198, each key twice
+            auto right = Generate(
+                ctx,
+                [](const size_t& index) { return 2 * (index % 100); },
+                200).Sort();
+
+            auto joined = left.SortMergeJoin(
+                right,
+                [](const IntPair& p) { return p.first; },
+                [](const size_t& k) { return k; },
+                [](const IntPair& p, const size_t& k) {
+                    return IntPair(k, p.second);
+                });
+
+            std::vector<IntPair> out_vec = joined.AllGather();
+
+            // the output is ordered by key
+            for (size_t i = 1; i < out_vec.size(); ++i)
+                ASSERT_LE(out_vec[i - 1].first, out_vec[i].first);
+
+            std::sort(out_vec.begin(), out_vec.end());
+
+            std::vector<IntPair> check;
+            for (size_t i = 0; i < 1000; ++i) {
+                if ((i % 100) % 2 != 0) continue;
+                check.emplace_back(i % 100, i);
+                check.emplace_back(i % 100, i);
+            }
+            std::sort(check.begin(), check.end());
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(SortMergeJoin, JoinHeavyKeys) {
+
+    static constexpr size_t test_size = 20000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // two keys with test_size / 2 items each, which exceed the group
+            // buffer and cannot be split evenly over the workers.
+            auto left = Generate(
+                ctx,
+                [](const size_t& index) { return index / (test_size / 2); },
+                test_size);
+
+            auto right = Generate(
+                ctx,
+                [](const size_t& index) { return index / 5; },
+                10);
+
+            auto key_fn = [](const size_t& i) { return i; };
+
+            auto joined = left.SortMergeJoin(
+                right, key_fn, key_fn,
+                [](const size_t& a, const size_t& b) { return a + b; });
+
+            std::vector<size_t> out_vec = joined.AllGather();
+
+            ASSERT_EQ(5 * test_size, out_vec.size());
+            ASSERT_TRUE(std::is_sorted(out_vec.begin(), out_vec.end()));
+            ASSERT_EQ(2 * 5 * test_size / 2,
+                      std::accumulate(out_vec.begin(), out_vec.end(),
+                                      size_t(0)));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
@@ -18,6 +18,9 @@
 #include <thrill/data/block_queue.hpp>
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <random>
 #include <string>
@@ -184,4 +187,62 @@ TEST(MergeNode, TwoIntegerArraysOfDifferentSize) {
     api::RunLocalTests(start_func);
 }
 
+
+TEST(MergeNode, ManyDuplicatesFewIterations) {
+
+    static constexpr size_t test_size = 100000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // runs of 100 and 70 equal numbers, such that the splitters fall
+            // into runs of duplicates
+            auto merge_input1 = Generate(
+                ctx,
+                [](size_t index) { return index / 100; },
+                test_size);
+            auto merge_input2 = Generate(
+                ctx,
+                [](size_t index) { return index / 70; },
+                test_size);
+
+            std::vector<size_t> expected;
+            expected.reserve(test_size * 2);
+            for (size_t i = 0; i < test_size; i++) {
+                expected.push_back(i / 100);
+                expected.push_back(i / 70);
+            }
+            std::sort(expected.begin(), expected.end());
+
+            DoMergeAndCheckResult(expected, merge_input1, merge_input2);
+        };
+
+    const std::string prefix = "merge_node_test_log";
+    setenv("THRILL_LOG", prefix.c_str(), /* overwrite */ 1);
+
+    api::MemoryConfig mem_config;
+    mem_config.setup(1024 * 1024 * 1024llu);
+    api::RunLocalMock(mem_config, 1, 4, start_func);
+    setenv("THRILL_LOG", "", /* overwrite */ 1);
+
+    // each round shrinks the search ranges by a factor of up to nine, a
+    // search with one pivot per round would need about 18 rounds.
+    const std::string path = prefix + "-host-0.json";
+    std::ifstream in(path);
+    std::string line;
+    size_t stats = 0;
+    while (std::getline(in, line)) {
+        if (line.find("\"class\":\"MergeNode\"") == std::string::npos)
+            continue;
+        size_t pos = line.find("\"iterations\":");
+        ASSERT_NE(std::string::npos, pos);
+        size_t iterations = std::stoul(line.substr(pos + 13));
+        ASSERT_LE(1u, iterations);
+        ASSERT_GE(8u, iterations);
+        ++stats;
+    }
+    ASSERT_EQ(4u, stats);
+    std::remove(path.c_str());
+}
+
 /******************************************************************************/
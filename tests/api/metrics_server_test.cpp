@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * tests/api/metrics_server_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/metrics_server.hpp>
+#include <thrill/common/die.hpp>
+#include <thrill/common/json_logger.hpp>
+#include <thrill/net/tcp/socket.hpp>
+#include <thrill/net/tcp/socket_address.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace thrill;
+
+TEST(MetricsServer, UpdateAndFormat) {
+    api::MetricsServer server(3, 0);
+
+    server.Update(
+        "{\"ts\":1,\"host_rank\":3,\"class\":\"LinuxProcStats\","
+        "\"event\":\"profile\",\"cpu_user\":12.5,\"net_tx_speed\":1000,"
+        "\"cores\":[1,2,{\"x\":\"]\"}],\"pr_rss\":4096}\n");
+    server.Update(
+        "{\"ts\":2,\"host_rank\":3,\"worker_rank\":7,\"dia_id\":5,"
+        "\"label\":\"Sort\",\"class\":\"StageBuilder\","
+        "\"event\":\"execute-start\",\"targets\":[6]}\n");
+    server.Update(
+        "{\"ts\":3,\"host_rank\":3,\"class\":\"BlockPool\","
+        "\"event\":\"evict\",\"bytes\":2048,\"duration\":10}\n");
+    server.Update(
+        "{\"ts\":4,\"host_rank\":3,\"class\":\"BlockPool\","
+        "\"event\":\"evict\",\"bytes\":1024,\"duration\":10}\n");
+    server.Update("not json");
+
+    std::string text = server.Format();
+    ASSERT_NE(std::string::npos, text.find(
+                  "thrill_linux_proc_stats_cpu_user{host=\"3\"} 12.5\n"));
+    ASSERT_NE(std::string::npos, text.find(
+                  "thrill_linux_proc_stats_net_tx_speed{host=\"3\"} 1000\n"));
+    ASSERT_NE(std::string::npos, text.find(
+                  "thrill_linux_proc_stats_pr_rss{host=\"3\"} 4096\n"));
+    ASSERT_EQ(std::string::npos, text.find("cores"));
+    ASSERT_NE(std::string::npos, text.find(
+                  "thrill_worker_stage{host=\"3\",worker=\"7\","
+                  "phase=\"execute\",label=\"Sort\"} 5\n"));
+    ASSERT_NE(std::string::npos, text.find(
+                  "thrill_block_pool_evict_bytes_total{host=\"3\"} 3072\n"));
+
+    server.Update(
+        "{\"ts\":5,\"host_rank\":3,\"worker_rank\":7,\"dia_id\":5,"
+        "\"label\":\"Sort\",\"class\":\"StageBuilder\","
+        "\"event\":\"execute-done\",\"targets\":[6]}\n");
+    ASSERT_NE(std::string::npos, server.Format().find("phase=\"idle\""));
+}
+
+TEST(MetricsServer, HttpRequest) {
+    api::MetricsServer server(0, 0);
+
+    // feed the server through a tap of a logger without output file
+    {
+        common::JsonLogger logger(
+            std::string(),
+            [&server](const std::string& line) { server.Update(line); });
+        logger << "class" << "BlockPool" << "event" << "profile"
+               << "total_bytes" << 123;
+    }
+
+    auto get = [&](const std::string& request) {
+        net::tcp::Socket socket = net::tcp::Socket::Create();
+        net::tcp::SocketAddress sa(
+            "127.0.0.1", std::to_string(server.port()).c_str());
+        die_unless(socket.connect(sa) == 0);
+        socket.send(request.data(), request.size());
+
+        std::string response;
+        char buffer[1024];
+        ssize_t rb;
+        while ((rb = socket.recv_one(buffer, sizeof(buffer))) > 0)
+            response.append(buffer, static_cast<size_t>(rb));
+        return response;
+    };
+
+    std::string response = get("GET /metrics HTTP/1.1\r\nHost: a\r\n\r\n");
+    ASSERT_EQ(0u, response.find("HTTP/1.0 200 OK\r\n"));
+    ASSERT_NE(std::string::npos, response.find(
+                  "\r\n\r\n# TYPE thrill_block_pool_total_bytes gauge\n"
+                  "thrill_block_pool_total_bytes{host=\"0\"} 123\n"));
+
+    response = get("GET /other HTTP/1.0\r\n\r\n");
+    ASSERT_EQ(0u, response.find("HTTP/1.0 404 Not Found\r\n"));
+}
+
+/******************************************************************************/
@@ -10,8 +10,11 @@
  ******************************************************************************/
 
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/approx_count_distinct.hpp>
+#include <thrill/api/approx_quantiles.hpp>
 #include <thrill/api/bernoulli_sample.hpp>
 #include <thrill/api/cache.hpp>
+#include <thrill/api/checkpoint.hpp>
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/concat.hpp>
 #include <thrill/api/concat_to_dia.hpp>
@@ -20,23 +23,34 @@
 #include <thrill/api/gather.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/generate_from_file.hpp>
+#include <thrill/api/iterate.hpp>
 #include <thrill/api/prefixsum.hpp>
 #include <thrill/api/print.hpp>
 #include <thrill/api/read_lines.hpp>
+#include <thrill/api/rebalance.hpp>
 #include <thrill/api/sample.hpp>
+#include <thrill/api/select.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
+#include <thrill/api/sparse_matrix.hpp>
 #include <thrill/api/sum.hpp>
+#include <thrill/api/union.hpp>
 #include <thrill/api/window.hpp>
 #include <thrill/api/write_binary.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_many.hpp>
+#include <thrill/api/zip.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <utility>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace thrill; // NOLINT
@@ -105,6 +119,92 @@ TEST(Operations, EqualToDIAAndAllGatherElements) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, EqualToDIAOfPODsInManyBlocks) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            static constexpr size_t test_size = 1000000;
+
+            std::vector<size_t> in_vector(test_size);
+            for (size_t i = 0; i < test_size; ++i)
+                in_vector[i] = test_size - 1 - i;
+
+            // the local ranges are copied into Blocks and the vector is freed
+            auto integers = EqualToDIA(ctx, std::move(in_vector));
+            ASSERT_TRUE(in_vector.empty());
+
+            // Sort receives the File as whole, Map is pushed the items.
+            std::vector<size_t> sorted = integers.Sort().AllGather();
+            ASSERT_EQ(test_size, sorted.size());
+            for (size_t i = 0; i < test_size; ++i) {
+                ASSERT_EQ(i, sorted[i]);
+            }
+
+            ASSERT_EQ(test_size * (test_size - 1) / 2,
+                      integers.Map([](const size_t& i) { return i; }).Sum());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, AllGatherSharedElements) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(ctx, 1000);
+
+            std::shared_ptr<const std::vector<size_t> > shared =
+                integers.AllGatherShared();
+
+            ASSERT_EQ(1000u, shared->size());
+            for (size_t i = 0; i < shared->size(); ++i) {
+                ASSERT_EQ(i, (*shared)[i]);
+            }
+
+            // all workers of the host share the gathered vector
+            ASSERT_EQ(shared.get(), ctx.net.LocalBroadcast(shared).get());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, GatherAndAllGatherLargeElements) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // large enough for the binomial tree and the ring.
+            static constexpr size_t test_size = 1000000;
+
+            auto integers = Generate(ctx, test_size).Cache();
+
+            std::vector<size_t> all_vec = integers.AllGather();
+
+            ASSERT_EQ(test_size, all_vec.size());
+            for (size_t i = 0; i < all_vec.size(); ++i) {
+                ASSERT_EQ(i, all_vec[i]);
+            }
+
+            // gather on the last worker, which is not the tree's rank 0.
+            size_t target = ctx.num_workers() - 1;
+            std::vector<size_t> out_vec = integers.Gather(target);
+
+            if (ctx.my_rank() == target) {
+                ASSERT_EQ(test_size, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); ++i) {
+                    ASSERT_EQ(i, out_vec[i]);
+                }
+            }
+            else {
+                ASSERT_EQ(0u, out_vec.size());
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, ConcatToDIAAndAllGatherElements) {
 
     auto start_func =
@@ -165,6 +265,66 @@ TEST(Operations, DistributeAndAllGatherElements) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, DistributeStringsFromLastWorker) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            static constexpr size_t test_size = 1000;
+            size_t source = ctx.num_workers() - 1;
+
+            std::vector<std::string> in_vector;
+
+            if (ctx.my_rank() == source) {
+                for (size_t i = 0; i < test_size; ++i)
+                    in_vector.push_back("item " + std::to_string(i));
+            }
+
+            auto strings = Distribute(ctx, std::move(in_vector), source);
+
+            // keeps the order of the items, also when pushed again.
+            for (size_t r = 0; r < 2; ++r) {
+                std::vector<std::string> out_vec = strings.AllGather();
+
+                ASSERT_EQ(test_size, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); ++i) {
+                    ASSERT_EQ("item " + std::to_string(i), out_vec[i]);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, DistributePODsAsFileSlices) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            static constexpr size_t test_size = 1000000;
+            size_t source = ctx.num_workers() - 1;
+
+            std::vector<size_t> in_vector;
+
+            if (ctx.my_rank() == source) {
+                for (size_t i = 0; i < test_size; ++i)
+                    in_vector.push_back(i);
+            }
+
+            auto integers = Distribute(ctx, std::move(in_vector), source);
+
+            ASSERT_EQ(test_size, integers.Size());
+
+            std::vector<size_t> out_vec = integers.AllGather();
+            ASSERT_EQ(test_size, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, EqualToDIAAndGatherElements) {
 
     auto start_func =
@@ -227,6 +387,104 @@ TEST(Operations, GenerateIntegers) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, GenerateStoresRecomputedItems) {
+
+    static constexpr size_t test_size = 100000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            common::Range local = ctx.CalculateLocalRange(test_size);
+            size_t calls = 0;
+
+            // a slow generator, which is worth storing after the first push
+            auto integers = Generate(
+                ctx,
+                [&](const size_t& index) {
+                    if (index == local.begin)
+                        std::this_thread::sleep_for(
+                            std::chrono::milliseconds(100));
+                    ++calls;
+                    return index;
+                },
+                test_size);
+
+            for (size_t i = 0; i < 4; ++i) {
+                ASSERT_EQ(test_size * (test_size - 1) / 2, integers.Sum());
+            }
+
+            // the first and second push call the generator, the second
+            // stores the items for the following ones.
+            ASSERT_EQ(2 * local.size(), calls);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, SizeOfPushedNodeSkipsPushData) {
+
+    static constexpr size_t test_size = 1000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            size_t calls = 0;
+
+            auto integers = Generate(
+                ctx,
+                [&](const size_t& index) {
+                    ++calls;
+                    return index;
+                },
+                test_size);
+
+            ASSERT_EQ(test_size, integers.Size());
+            size_t first_calls = calls;
+
+            // the number of pushed items is known after the first push
+            ASSERT_EQ(test_size, integers.Size());
+            ASSERT_EQ(first_calls, calls);
+
+            // with a function stack, the items must be pushed again.
+            ASSERT_EQ(test_size / 2,
+                      integers.Filter([](const size_t& i) { return i % 2; })
+                      .Size());
+            ASSERT_EQ(2 * first_calls, calls);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, GenerateRandomIntegers) {
+
+    static constexpr size_t test_size = 1000;
+
+    auto generator = [](const size_t& index, common::PhiloxEngine& rng) {
+                         std::uniform_int_distribution<size_t> dist(0, 1000);
+                         return std::make_pair(index, dist(rng));
+                     };
+
+    auto start_func =
+        [&generator](Context& ctx) {
+
+            auto integers = GenerateRandom(ctx, generator, test_size, 42);
+
+            std::vector<std::pair<size_t, size_t> > out_vec =
+                integers.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            // the items depend only on the seed and their index, regardless
+            // of the number of workers.
+            for (size_t i = 0; i < test_size; ++i) {
+                common::PhiloxEngine rng(42, i);
+                ASSERT_EQ(generator(i, rng), out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, GenerateAndConcatTwo) {
 
     static constexpr size_t test_size = 1024;
@@ -279,6 +537,38 @@ TEST(Operations, GenerateAndConcatThree) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, GenerateAndUnionThree) {
+
+    static constexpr size_t test_size = 1024;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto dia1 = Generate(ctx, test_size).Cache();
+            auto dia2 = Generate(ctx, 2 * test_size).Map(
+                [](size_t i) { return test_size + i; });
+            auto dia3 = Generate(ctx, 3 * test_size).Map(
+                [](size_t i) { return 3 * test_size + i; }).Cache();
+
+            auto udia = Union(dia1, dia2, dia3);
+
+            ASSERT_EQ(6 * test_size, udia.Keep().Size());
+
+            // Union keeps the items on the workers, hence sort for checking
+            std::vector<size_t> out_vec = udia.Sort().AllGather();
+
+            ASSERT_EQ(6 * test_size, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+
+            // member variant
+            ASSERT_EQ(2 * test_size, dia1.Union(dia1).Size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, MapResultsCorrectChangingType) {
 
     auto start_func =
@@ -437,6 +727,70 @@ TEST(Operations, PrefixSumFacultyCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, SegmentedPrefixSumCorrectResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // segments of 7 items with equal key, which span workers.
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& input) {
+                    return std::make_pair(input / 7, input + 1);
+                },
+                100);
+
+            using Pair = std::pair<size_t, size_t>;
+
+            auto prefixsums = pairs.SegmentedPrefixSum(
+                [](const Pair& p) { return p.first; },
+                [](const Pair& a, const Pair& b) {
+                    return Pair(b.first, a.second + b.second);
+                });
+
+            std::vector<Pair> out_vec = prefixsums.AllGather();
+
+            ASSERT_EQ(100u, out_vec.size());
+
+            size_t ctr = 0;
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                if (i % 7 == 0) ctr = 0;
+                ctr += i + 1;
+                ASSERT_EQ(i / 7, out_vec[i].first);
+                ASSERT_EQ(ctr, out_vec[i].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, PrefixSumBatchesCorrectResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // cached DIA of doubles takes the batched path of PrefixSum.
+            auto doubles = Generate(
+                ctx,
+                [](const size_t& input) {
+                    return static_cast<double>(input % 5);
+                },
+                10000).Cache();
+
+            std::vector<double> out_vec = doubles.PrefixSum().AllGather();
+
+            ASSERT_EQ(10000u, out_vec.size());
+
+            double ctr = 0;
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ctr += static_cast<double>(i % 5);
+                ASSERT_EQ(ctr, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, GenerateAndSumHaveEqualAmount1) {
 
     std::default_random_engine generator(std::random_device { } ());
@@ -598,6 +952,74 @@ TEST(Operations, DisjointWindowCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, ContiguousWindowCorrectResults) {
+
+    static constexpr size_t test_size = 1440;
+    static constexpr size_t window_size = 10;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& input) { return input * input; },
+                test_size);
+
+            auto window = integers.Window(
+                ContiguousWindowTag, window_size,
+                [](size_t rank, const size_t* window) {
+                    for (size_t i = 0; i < window_size; ++i)
+                        die_unequal((rank + i) * (rank + i), window[i]);
+                    return rank;
+                });
+
+            std::vector<size_t> out_vec = window.AllGather();
+
+            ASSERT_EQ(test_size - window_size + 1, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, WindowSumMinMax) {
+
+    static constexpr size_t test_size = 1000;
+    static constexpr size_t window_size = 17;
+
+    auto value = [](size_t i) -> int { return (i * 7919) % 1000 - 500; };
+
+    auto start_func =
+        [&value](Context& ctx) {
+
+            auto integers = Generate(ctx, value, test_size).Cache();
+
+            std::vector<int> sums = integers.WindowSum(window_size).AllGather();
+            std::vector<int> mins = integers.WindowMin(window_size).AllGather();
+            std::vector<int> maxs = integers.WindowMax(window_size).AllGather();
+
+            ASSERT_EQ(test_size - window_size + 1, sums.size());
+            ASSERT_EQ(test_size - window_size + 1, mins.size());
+            ASSERT_EQ(test_size - window_size + 1, maxs.size());
+
+            for (size_t i = 0; i + window_size <= test_size; ++i) {
+                int sum = 0, min = value(i), max = value(i);
+                for (size_t j = i; j < i + window_size; ++j) {
+                    sum += value(j);
+                    min = std::min(min, value(j));
+                    max = std::max(max, value(j));
+                }
+                ASSERT_EQ(sum, sums[i]);
+                ASSERT_EQ(min, mins[i]);
+                ASSERT_EQ(max, maxs[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, FilterResultsCorrectly) {
 
     auto start_func =
@@ -630,6 +1052,278 @@ TEST(Operations, FilterResultsCorrectly) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, MapFilterBatchesCorrectResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // Generate and the Cache push items in batches, which are not
+            // multiples of the size.
+            auto integers = Generate(ctx, 10000).Cache();
+
+            auto odd_triples =
+                integers
+                .Map([](const size_t& i) { return 3 * i; })
+                .Filter([](const size_t& i) { return i % 2 == 1; });
+
+            std::vector<size_t> out_vec = odd_triples.AllGather();
+
+            ASSERT_EQ(5000u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(3 * (2 * i + 1), out_vec[i]);
+            }
+
+            ASSERT_EQ(10000u, integers.Size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, ApproxCountDistinctAndQuantiles) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // 100000 items with 20000 distinct values
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) { return index % 20000; },
+                100000);
+
+            size_t count = integers.ApproxCountDistinct();
+            ASSERT_NEAR(20000.0, static_cast<double>(count), 1000.0);
+
+            std::vector<size_t> quantiles =
+                Generate(ctx, 100000).ApproxQuantiles({ 0.0, 0.5, 0.9, 1.0 });
+
+            ASSERT_EQ(4u, quantiles.size());
+            ASSERT_NEAR(0.0, static_cast<double>(quantiles[0]), 2000.0);
+            ASSERT_NEAR(50000.0, static_cast<double>(quantiles[1]), 2000.0);
+            ASSERT_NEAR(90000.0, static_cast<double>(quantiles[2]), 2000.0);
+            ASSERT_NEAR(99999.0, static_cast<double>(quantiles[3]), 2000.0);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, SelectRanksExactly) {
+
+    static constexpr size_t test_size = 20000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // random permutation of 0..test_size-1 with each value twice
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return (index * 7919) % test_size / 2;
+                },
+                test_size).Cache();
+
+            ASSERT_EQ(0u, integers.Select(0));
+            ASSERT_EQ(test_size / 4, integers.Select(test_size / 2));
+            ASSERT_EQ(test_size / 2 - 1, integers.Select(test_size - 1));
+
+            // multi-rank variant returns the ranks in the given order
+            std::vector<size_t> ranks = { 19999, 5, 10000, 6, 18000, 5 };
+            std::vector<size_t> values = integers.Select(ranks);
+            ASSERT_EQ(ranks.size(), values.size());
+            for (size_t i = 0; i < ranks.size(); ++i)
+                ASSERT_EQ(ranks[i] / 2, values[i]);
+
+            // the maximum by reversed order
+            ASSERT_EQ(test_size / 2 - 1,
+                      integers.Select(0, std::greater<size_t>()));
+
+            // few distinct values
+            auto zeros = Generate(
+                ctx, [](const size_t& index) { return index % 2; }, test_size);
+            ASSERT_EQ(1u, zeros.Select(test_size / 2));
+            ASSERT_EQ(0u, zeros.Select(test_size / 2 - 1));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, SparseMatrixMultiply) {
+
+    static constexpr size_t rows = 300, cols = 200;
+
+    using Entry = SparseMatrixEntry<size_t>;
+
+    // a few nonzeros per row, with some duplicate entries and empty rows
+    std::vector<Entry> entries;
+    std::vector<size_t> x(cols), correct(rows, 0);
+    for (size_t c = 0; c < cols; ++c) x[c] = c % 7 + 1;
+    for (size_t r = 0; r < rows; r += 1 + r % 3) {
+        for (size_t k = 0; k < 5; ++k) {
+            size_t c = (r * 31 + k * 17) % cols;
+            entries.emplace_back(Entry { r, c, k + 1 });
+            correct[r] += (k + 1) * x[c];
+        }
+    }
+
+    auto start_func =
+        [&](Context& ctx) {
+            for (SparseMatrixPartition partition :
+                 { SparseMatrixPartition::Rows,
+                   SparseMatrixPartition::Columns })
+            {
+                SparseMatrix<size_t> matrix(
+                    EqualToDIA(ctx, entries), rows, cols, partition);
+
+                // multiply twice with the same matrix
+                for (size_t i = 0; i < 2; ++i) {
+                    std::vector<size_t> result =
+                        matrix.Multiply(EqualToDIA(ctx, x)).AllGather();
+                    ASSERT_EQ(correct, result);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, RebalanceAfterFilter) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // only the first worker's range survives the filter
+            auto integers = Generate(ctx, 10000)
+                            .Filter([](const size_t& i) { return i < 1000; });
+
+            auto balanced = integers.Rebalance();
+
+            // each worker holds its equal share after Rebalance()
+            size_t local_size = 0;
+            balanced.Map([&local_size](const size_t& i) {
+                             ++local_size;
+                             return i;
+                         })
+            .Size();
+            common::Range range = ctx.CalculateLocalRange(1000);
+            ASSERT_EQ(range.size(), local_size);
+
+            // and the order is kept
+            std::vector<size_t> out_vec = balanced.AllGather();
+            ASSERT_EQ(1000u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, CacheModesCorrectResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // enough items for multiple Blocks, which compress well.
+            auto integers = Generate(ctx, 1000000);
+
+            for (api::CacheMode mode : { api::CacheMode::CompressedMemory,
+                                         api::CacheMode::Pinned }) {
+                auto cached = integers.Map(
+                    [](const size_t& i) { return i % 1000; }).Cache(mode);
+
+                // read the cache twice
+                for (size_t r = 0; r < 2; ++r) {
+                    std::vector<size_t> out_vec = cached.AllGather();
+
+                    ASSERT_EQ(1000000u, out_vec.size());
+                    for (size_t i = 0; i < out_vec.size(); i++) {
+                        ASSERT_EQ(i % 1000, out_vec[i]);
+                    }
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, FreeUnreferencedNodesAfterPushData) {
+
+    static constexpr size_t test_size = 1000000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // the first Cache node is only referenced by the second one
+            auto cached = Generate(
+                ctx,
+                [](const size_t& index) { return index; },
+                test_size)
+                          .Cache()
+                          .Map([](const size_t& i) { return i + 1; })
+                          .Cache();
+
+            size_t bytes = 0;
+            size_t size = cached.Map(
+                [&](const size_t& i) {
+                    if (bytes == 0)
+                        bytes = ctx.block_pool().total_bytes();
+                    return i;
+                }).Size();
+
+            ASSERT_EQ(test_size, size);
+
+            // the items of the first Cache were freed after it pushed them
+            // into the second one, only the second copy is left.
+            size_t cached_bytes = ctx.block_pool().total_bytes();
+            ASSERT_LT(bytes, cached_bytes * 3 / 2);
+        };
+
+    api::RunLocalSameThread(start_func);
+}
+
+TEST(Operations, CheckpointRestoresItems) {
+    core::TemporaryDirectory tmpdir;
+
+    auto start_func =
+        [&tmpdir](Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            std::string path = tmpdir.get() + "/ckpt";
+
+            for (size_t run = 0; run < 2; ++run) {
+                size_t computed = 0;
+
+                auto strings =
+                    Generate(ctx, 100000)
+                    .Map([&computed](const size_t& i) {
+                             ++computed;
+                             return std::to_string(i % 1000);
+                         })
+                    .Checkpoint(path);
+
+                // read the checkpoint twice
+                for (size_t r = 0; r < 2; ++r) {
+                    std::vector<std::string> out_vec = strings.AllGather();
+
+                    ASSERT_EQ(100000u, out_vec.size());
+                    for (size_t i = 0; i < out_vec.size(); i++) {
+                        ASSERT_EQ(std::to_string(i % 1000), out_vec[i]);
+                    }
+                }
+
+                // the second run is restored from the checkpoint
+                size_t total = ctx.net.AllReduce(computed);
+                ASSERT_EQ(run == 0 ? 100000u : 0u, total);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, DIACasting) {
 
     auto start_func =
@@ -700,6 +1394,20 @@ TEST(Operations, Sample) {
                 std::vector<size_t> int_vec = int_sampled.AllGather();
                 ASSERT_EQ(100u, int_vec.size());
             }
+
+            // test with a cached input, which is sampled by skipping over the
+            // File's items
+            {
+                auto int_sampled = Generate(ctx, n).Cache().Sample(100);
+
+                std::vector<size_t> int_vec = int_sampled.AllGather();
+                ASSERT_EQ(100u, int_vec.size());
+
+                std::sort(int_vec.begin(), int_vec.end());
+                ASSERT_TRUE(std::unique(int_vec.begin(), int_vec.end())
+                            == int_vec.end());
+                ASSERT_LT(int_vec.back(), n);
+            }
         };
 
     api::RunLocalTests(start_func);
@@ -747,6 +1455,81 @@ TEST(Operations, ForLoop) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, IterateLoop) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // loop-invariant input
+            auto offsets = Generate(ctx, 16).Cache();
+
+            auto squares = Iterate(
+                Generate(ctx, 16), 4,
+                [&offsets](const DIA<size_t>& state, size_t iter) {
+                    return state.Zip(
+                        offsets,
+                        [iter](const size_t& s, const size_t& o) {
+                            return 2 * s + o * iter;
+                        });
+                });
+
+            std::vector<size_t> out_vec = squares.AllGather();
+
+            ASSERT_EQ(16u, out_vec.size());
+            for (size_t i = 0; i != 16; ++i) {
+                // i -> 2i -> 5i -> 12i -> 27i
+                ASSERT_EQ(27 * i, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, DeltaIterateConnectedComponents) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using Pair = std::pair<size_t, size_t>;
+
+            // vertices 0..499 on paths of 5 vertices, labelled by themselves
+            auto labels = Generate(
+                ctx, [](const size_t& v) { return Pair(v, v); }, 500);
+
+            std::vector<size_t> workset_sizes;
+            auto components = DeltaIterate(
+                labels, 100,
+                [&workset_sizes](const DIA<Pair>& workset, size_t) {
+                    workset_sizes.push_back(workset.Size());
+                    // send the changed label to the neighbors on the path
+                    return workset.FlatMap<Pair>(
+                        [](const Pair& p, auto emit) {
+                            if (p.first % 5 != 0)
+                                emit(Pair(p.first - 1, p.second));
+                            if (p.first % 5 != 4)
+                                emit(Pair(p.first + 1, p.second));
+                        });
+                },
+                [](const size_t& a, const size_t& b) {
+                    return std::min(a, b);
+                });
+
+            std::vector<Pair> out_vec = components.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(500u, out_vec.size());
+            for (size_t v = 0; v < 500; ++v) {
+                ASSERT_EQ(Pair(v, v - v % 5), out_vec[v]);
+            }
+
+            // only the labels changed in the previous iteration are processed
+            ASSERT_EQ(std::vector<size_t>({ 500, 400, 300, 200, 100 }),
+                      workset_sizes);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, WhileLoop) {
 
     auto start_func =
@@ -11,17 +11,22 @@
 
 #include <gtest/gtest.h>
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/cache.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/generate_from_file.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/read_columnar.hpp>
 #include <thrill/api/read_lines.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/write_binary.hpp>
+#include <thrill/api/write_columnar.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_many.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/system_exception.hpp>
+#include <thrill/core/binary_index.hpp>
 #include <thrill/core/file_io.hpp>
+#include <thrill/core/remote_file_system.hpp>
 
 #include <sys/stat.h>
 
@@ -57,6 +62,28 @@ TEST(IO, ReadSingleFile) {
     api::RunLocalTests(start_func);
 }
 
+TEST(IO, ReadSingleFileView) {
+    auto start_func =
+        [](Context& ctx) {
+            auto integers = ReadLinesView(ctx, "inputs/test1")
+                            .FlatMap<int>(
+                [](const common::StringView& line, auto emit) {
+                    emit(std::stoi(line.ToString()));
+                });
+
+            std::vector<int> out_vec = integers.AllGather();
+
+            int i = 1;
+            for (int element : out_vec) {
+                ASSERT_EQ(element, i++);
+            }
+
+            ASSERT_EQ(16u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(IO, ReadFolder) {
     auto start_func =
         [](Context& ctx) {
@@ -93,6 +120,33 @@ TEST(IO, ReadPartOfFolderCompressed) {
     api::RunLocalTests(start_func);
 }
 
+TEST(IO, ReadSplittableBgzf) {
+#if defined(_MSC_VER)
+    return;
+#endif
+    auto start_func =
+        [](Context& ctx) {
+            // a single BGZF file with integers from 1 to 1000 in small
+            // members, lines span members. It is split among all workers if
+            // zlib is available.
+            auto integers = ReadLines(ctx, "inputs/read_bgzf.gz")
+                            .Map([](const std::string& line) {
+                                     return std::stoi(line);
+                                 });
+
+            std::vector<int> out_vec = integers.AllGather();
+
+            int i = 1;
+            for (int element : out_vec) {
+                ASSERT_EQ(element, i++);
+            }
+
+            ASSERT_EQ(1000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(IO, GenerateFromFileRandomIntegers) {
     api::RunLocalSameThread(
         [](api::Context& ctx) {
@@ -264,6 +318,18 @@ TEST(IO, GenerateStringWriteBinary) {
             }
             ctx.net.Barrier();
 
+            // no item index is appended unless requested
+            if (ctx.my_rank() == 0) {
+                for (const std::string& path : core::GlobFilePattern(
+                         tmpdir.get() + "/IO.StringBinary*")) {
+                    struct stat st;
+                    ASSERT_EQ(0, stat(path.c_str(), &st));
+                    core::BinaryIndex index;
+                    ASSERT_FALSE(
+                        core::BinaryIndex::Read(path, st.st_size, &index));
+                }
+            }
+
             // read the Items from disk (collectively) and compare
             {
                 auto dia = api::ReadBinary<Item>(
@@ -283,6 +349,65 @@ TEST(IO, GenerateStringWriteBinary) {
         });
 }
 
+TEST(IO, WriteReadBinaryIndexBalanced) {
+    core::TemporaryDirectory tmpdir;
+
+    using Item = std::pair<size_t, std::string>;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            // write only a quarter of the items, such that the files are very
+            // different in size, and the first worker writes all for p <= 4.
+            size_t generate_size = 32000;
+            size_t write_size = generate_size / 4;
+            {
+                auto dia = Generate(
+                    ctx,
+                    [](const size_t index) {
+                        return Item(index, test_string(index));
+                    },
+                    generate_size)
+                           .Filter([write_size](const Item& i) {
+                                       return i.first < write_size;
+                                   });
+
+                dia.WriteBinary(tmpdir.get() + "/IO.IndexBinary",
+                                128 * 1024 * 1024, /* write_index */ true);
+            }
+            ctx.net.Barrier();
+
+            // each worker reads an equal part of the items and tags them
+            {
+                auto dia = api::ReadBinary<Item>(
+                    ctx, tmpdir.get() + "/IO.IndexBinary*")
+                           .Map([&ctx](const Item& i) {
+                                    return std::make_pair(i, ctx.my_rank());
+                                });
+
+                std::vector<std::pair<Item, size_t> > vec = dia.AllGather();
+
+                ASSERT_EQ(write_size, vec.size());
+
+                std::vector<size_t> count(ctx.num_workers());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(Item(i, test_string(i)), vec[i].first);
+                    count[vec[i].second]++;
+                }
+                for (size_t c : count) {
+                    ASSERT_GE(write_size / ctx.num_workers() + 1, c);
+                    ASSERT_LE(write_size / ctx.num_workers(), c);
+                }
+            }
+        });
+}
+
 TEST(IO, WriteAndReadBinaryEqualDIAs) {
     core::TemporaryDirectory tmpdir;
 
@@ -337,4 +462,271 @@ TEST(IO, WriteAndReadBinaryEqualDIAs) {
     api::RunLocalTests(start_func);
 }
 
+TEST(IO, WriteLinesParallelLarge) {
+    core::TemporaryDirectory tmpdir;
+
+    // lines of 40 bytes, such that every worker flushes its write buffer
+    // several times
+    static constexpr size_t test_size = 600000;
+    auto make_line = [](size_t i) {
+                         std::string s = std::to_string(i);
+                         return s + std::string(39 - s.size(), 'a' + i % 26);
+                     };
+
+    auto check_file =
+        [&make_line](const std::string& path, size_t size) {
+            std::ifstream file(path, std::ios::binary);
+            file.seekg(0, std::ios::end);
+            ASSERT_EQ(40 * size, static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            std::string line;
+            for (size_t i = 0; i < size; ++i) {
+                ASSERT_TRUE(std::getline(file, line).good());
+                ASSERT_EQ(make_line(i), line);
+            }
+        };
+
+    auto start_func =
+        [&](Context& ctx) {
+            std::string path = tmpdir.get() + "/IO.WriteLinesLarge";
+            auto lines = Generate(ctx, make_line, test_size).Cache();
+
+            // all workers write into the shared file at their offsets
+            lines.WriteLines(path);
+            ctx.net.Barrier();
+            if (ctx.my_rank() == 0)
+                check_file(path, test_size);
+            ctx.net.Barrier();
+
+            // only the first workers hold lines, the others write nothing.
+            // the existing longer file is truncated.
+            lines.Filter([](const std::string& s) {
+                             return std::stoul(s) < test_size / 4;
+                         }).WriteLines(path);
+            ctx.net.Barrier();
+            if (ctx.my_rank() == 0)
+                check_file(path, test_size / 4);
+
+            // compressed files cannot be written at offsets
+            ASSERT_THROW(lines.WriteLines(path + ".gz"), std::runtime_error);
+        };
+
+    api::MemoryConfig mem_config;
+    mem_config.setup(1024 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 2, start_func);
+}
+
+TEST(IO, WriteReadColumnar) {
+    core::TemporaryDirectory tmpdir;
+
+    using Row = std::tuple<size_t, uint32_t, double>;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            // generate rows with a sorted, a narrow, and a constant column
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx,
+                    [](const size_t index) {
+                        return Row(index, index % 7 + 1000, 1.5);
+                    },
+                    generate_size);
+
+                dia.WriteColumnar(tmpdir.get() + "/IO.Columnar", 1000);
+            }
+            ctx.net.Barrier();
+
+            std::string glob = tmpdir.get() + "/IO.Columnar*";
+
+            // read all columns and compare
+            {
+                std::vector<Row> vec = ReadColumnar<Row>(ctx, glob).AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                std::sort(vec.begin(), vec.end());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(Row(i, i % 7 + 1000, 1.5), vec[i]);
+                }
+            }
+
+            // read only the second column
+            {
+                api::ColumnarOptions<Row> options;
+                options.columns = { 1 };
+
+                std::vector<Row> vec =
+                    ReadColumnar<Row>(ctx, glob, options).AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                for (const Row& r : vec) {
+                    ASSERT_EQ(0u, std::get<0>(r));
+                    ASSERT_LE(1000u, std::get<1>(r));
+                    ASSERT_EQ(0.0, std::get<2>(r));
+                }
+            }
+
+            // skip chunks whose first column cannot be in [5000, 6000)
+            {
+                api::ColumnarOptions<Row> options;
+                options.chunk_filter =
+                    [](const Row& min, const Row& max) {
+                        return std::get<0>(max) >= 5000 &&
+                               std::get<0>(min) < 6000;
+                    };
+
+                std::vector<Row> vec =
+                    ReadColumnar<Row>(ctx, glob, options).AllGather();
+
+                // chunks do not span workers' files, hence at most two
+                // partial chunks are read besides the matching ones
+                ASSERT_LE(1000u, vec.size());
+                ASSERT_GE(3000u, vec.size());
+
+                size_t matches = std::count_if(
+                    vec.begin(), vec.end(), [](const Row& r) {
+                        return std::get<0>(r) >= 5000 && std::get<0>(r) < 6000;
+                    });
+                ASSERT_EQ(1000u, matches);
+            }
+        });
+}
+
+//! remote file system for testing, which maps testfs://path to the local path
+//! and uses shell commands to access it.
+class TestRemoteFileSystem final : public core::RemoteFileSystem
+{
+public:
+    std::vector<Entry> List(const std::string& prefix) final {
+        core::SysFileList files = core::GlobFileSizePrefixSum(
+            core::GlobFilePattern(Local(prefix) + "*"));
+        std::vector<Entry> list;
+        for (size_t i = 0; i < files.count(); ++i)
+            list.emplace_back("testfs://" + files.list[i].path,
+                              files.list[i].size);
+        return list;
+    }
+
+    std::string ReadCommand(const std::string& path, uint64_t offset) final {
+        return "tail -c +" + std::to_string(offset + 1) + " "
+               + core::ShellQuote(Local(path));
+    }
+
+    std::string WriteCommand(const std::string& path) final {
+        return "cat > " + core::ShellQuote(Local(path));
+    }
+
+private:
+    static std::string Local(const std::string& path) {
+        return path.substr(std::string("testfs://").size());
+    }
+};
+
+TEST(IO, RemoteFileSystemWriteReadBinary) {
+#if defined(_MSC_VER)
+    return;
+#endif
+    core::TemporaryDirectory tmpdir;
+    core::RegisterRemoteFileSystem(
+        "testfs", std::make_shared<TestRemoteFileSystem>());
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            std::string remote = "testfs://" + tmpdir.get();
+
+            // generate a dia of integers and write them via pipes
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx,
+                    [](const size_t index) { return index + 42; },
+                    generate_size);
+
+                dia.WriteBinary(remote + "/IO.RemoteBinary", 16 * 1024);
+            }
+            ctx.net.Barrier();
+
+            // read the integers via ranged reads and compare
+            {
+                auto dia = api::ReadBinary<size_t>(
+                    ctx, remote + "/IO.RemoteBinary*");
+
+                std::vector<size_t> vec = dia.AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(42 + i, vec[i]);
+                }
+            }
+
+            // read lines split among workers at offsets
+            {
+                auto integers = ReadLines(ctx, "testfs://inputs/test1")
+                                .Map([](const std::string& line) {
+                                         return std::stoi(line);
+                                     });
+
+                std::vector<int> out_vec = integers.AllGather();
+
+                int i = 1;
+                for (int element : out_vec) {
+                    ASSERT_EQ(element, i++);
+                }
+
+                ASSERT_EQ(16u, out_vec.size());
+            }
+        });
+}
+
+TEST(IO, SysFileDirectIO) {
+    core::TemporaryDirectory tmpdir;
+    std::string path = tmpdir.get() + "/direct";
+
+    static constexpr size_t align = core::SysFile::direct_alignment;
+
+    // two buffers of 4 * align bytes, aligned for O_DIRECT
+    std::vector<char> memory(9 * align);
+    char* out_data = memory.data() +
+                     (align - reinterpret_cast<uintptr_t>(memory.data()) % align);
+    char* in_data = out_data + 4 * align;
+    for (size_t i = 0; i < 4 * align; ++i)
+        out_data[i] = static_cast<char>(i * 7);
+
+    {
+        core::SysFile file = core::SysFile::OpenForWrite(path, true);
+        ASSERT_TRUE(core::SysFile::IsDirectAligned(out_data, 3 * align));
+        ASSERT_EQ(3 * align, file.write(out_data, 3 * align));
+
+        // unaligned tail: switch to buffered I/O
+        ASSERT_FALSE(core::SysFile::IsDirectAligned(out_data, 100));
+        ASSERT_TRUE(file.set_direct(false));
+        ASSERT_EQ(100, file.write(out_data + 3 * align, 100));
+    }
+    {
+        core::SysFile file = core::SysFile::OpenForRead(path, true);
+        ASSERT_EQ(2 * align, file.read(in_data, 2 * align));
+        // short read at the end of the file, then leave O_DIRECT mode
+        ASSERT_EQ(align + 100, file.read(in_data + 2 * align, 2 * align));
+        ASSERT_TRUE(file.set_direct(false));
+        ASSERT_EQ(0, file.read(in_data, align));
+    }
+
+    ASSERT_TRUE(std::equal(out_data, out_data + 3 * align + 100, in_data));
+}
+
 /******************************************************************************/
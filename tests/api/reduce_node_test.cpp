@@ -11,9 +11,13 @@
 
 #include <gtest/gtest.h>
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/distinct.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/group_by_key.hpp>
 #include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/reduce_to_index.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/streaming_reduce.hpp>
 
 #include <algorithm>
 #include <string>
@@ -102,6 +106,309 @@ TEST(ReduceNode, ReduceModuloPairsCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+//! ReduceConfig which combines items on each host before the shuffle
+class HostCombineReduceConfig : public api::DefaultReduceConfig
+{
+public:
+    static constexpr bool use_host_combine_ = true;
+};
+
+TEST(ReduceNode, ReduceModuloPairsHostCombine) {
+
+    static constexpr size_t test_size = 1000000u;
+    static constexpr size_t mod_size = 1000u;
+    static constexpr size_t div_size = test_size / mod_size;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return IntPair(index % mod_size, index / mod_size);
+                },
+                test_size);
+
+            auto add_function = [](const size_t& in1, const size_t& in2) {
+                                    return in1 + in2;
+                                };
+
+            auto reduced = integers.ReducePair(
+                add_function, HostCombineReduceConfig());
+
+            std::vector<IntPair> out_vec = reduced.AllGather();
+
+            std::sort(out_vec.begin(), out_vec.end(),
+                      [](const IntPair& p1, const IntPair& p2) {
+                          return p1.first < p2.first;
+                      });
+
+            ASSERT_EQ(mod_size, out_vec.size());
+            for (const auto& element : out_vec) {
+                ASSERT_EQ(element.second, (div_size * (div_size - 1)) / 2u);
+            }
+
+            // ReduceByKey with key extraction in the combine stage
+            auto values = Generate(ctx, test_size);
+
+            auto reduced_values = values.ReduceByKey(
+                [](const size_t& in) { return in % mod_size; },
+                [](const size_t& in1, const size_t& in2) {
+                    return in1 < in2 ? in1 : in2;
+                },
+                HostCombineReduceConfig());
+
+            std::vector<size_t> min_vec = reduced_values.AllGather();
+            std::sort(min_vec.begin(), min_vec.end());
+
+            ASSERT_EQ(mod_size, min_vec.size());
+            for (size_t i = 0; i < min_vec.size(); ++i) {
+                ASSERT_EQ(i, min_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! ReduceConfig which sizes the post stage by sketches of the keys
+class KeySketchReduceConfig : public api::DefaultReduceConfig
+{
+public:
+    KeySketchReduceConfig() { key_sketch_precision_ = 10; }
+
+    static constexpr bool use_post_thread_ = false;
+};
+
+TEST(ReduceNode, ReduceManyKeysKeySketches) {
+
+    static constexpr size_t test_size = 20000u;
+    static constexpr size_t mod_size = 10000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(ctx, test_size);
+
+            auto reduced = integers.ReduceByKey(
+                [](const size_t& in) { return in % mod_size; },
+                [](const size_t& in1, const size_t& in2) {
+                    return in1 < in2 ? in1 : in2;
+                },
+                KeySketchReduceConfig());
+
+            std::vector<size_t> out_vec = reduced.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(mod_size, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    // without the post thread, use one worker per host, such that the
+    // sketches are merged from the senders on both hosts.
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(ReduceNode, ReduceSkewedKeysHotKeys) {
+
+    static constexpr size_t test_size = 1000000u;
+    static constexpr size_t mod_size = 1000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // nine of ten items have key zero
+            auto key = [](const size_t& index) {
+                           return index % 10 == 0 ? index % mod_size : 0;
+                       };
+
+            auto integers = Generate(ctx, test_size);
+
+            api::DefaultReduceConfig config;
+            config.hot_key_sample_size_ = 1000;
+
+            auto reduced = integers.Map(
+                [key](const size_t& index) {
+                    return std::make_pair(key(index), size_t(1));
+                })
+                           .ReducePair(
+                [](const size_t& a, const size_t& b) { return a + b; },
+                config);
+
+            using IntPair = std::pair<size_t, size_t>;
+            std::vector<IntPair> out_vec = reduced.AllGather();
+
+            std::sort(out_vec.begin(), out_vec.end());
+
+            // calculate expected counts sequentially
+            std::vector<size_t> count(mod_size, 0);
+            for (size_t i = 0; i < test_size; ++i) ++count[key(i)];
+
+            std::vector<IntPair> check;
+            for (size_t i = 0; i < mod_size; ++i) {
+                if (count[i] != 0) check.emplace_back(i, count[i]);
+            }
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(ReduceNode, ReduceRangePartitionSortedResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using Pair = std::pair<size_t, size_t>;
+
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return Pair((index * 7919) % 1009, 1);
+                },
+                20000);
+
+            auto add_function = [](const Pair& a, const Pair& b) {
+                                    return Pair(a.first, a.second + b.second);
+                                };
+
+            std::vector<Pair> out_vec =
+                pairs.ReduceByKey(
+                    RangePartitionTag,
+                    [](const Pair& p) { return p.first; }, add_function)
+                .AllGather();
+
+            // the output is sorted by key without a Sort()
+            ASSERT_EQ(1009u, out_vec.size());
+            size_t sum = 0;
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i, out_vec[i].first);
+                sum += out_vec[i].second;
+            }
+            ASSERT_EQ(20000u, sum);
+
+            // descending order of the keys
+            std::vector<Pair> out_desc =
+                pairs.ReduceByKey(
+                    RangePartitionTag,
+                    [](const Pair& p) { return p.first; }, add_function,
+                    std::greater<size_t>())
+                .AllGather();
+
+            ASSERT_EQ(1009u, out_desc.size());
+            for (size_t i = 0; i < out_desc.size(); ++i)
+                ASSERT_EQ(1008u - i, out_desc[i].first);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(ReduceNode, DistinctCorrectResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return index % 97;
+                },
+                10000);
+
+            std::vector<size_t> out_vec = integers.Distinct().AllGather();
+
+            std::sort(out_vec.begin(), out_vec.end());
+            ASSERT_EQ(97u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i)
+                ASSERT_EQ(i, out_vec[i]);
+
+            // distinct by key keeps one of the pairs of each key
+            using Pair = std::pair<size_t, size_t>;
+
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return Pair(index % 13, index);
+                },
+                10000);
+
+            std::vector<Pair> out_pairs =
+                pairs.Distinct([](const Pair& p) { return p.first; })
+                .AllGather();
+
+            std::sort(out_pairs.begin(), out_pairs.end());
+            ASSERT_EQ(13u, out_pairs.size());
+            for (size_t i = 0; i < out_pairs.size(); ++i) {
+                ASSERT_EQ(i, out_pairs[i].first);
+                ASSERT_EQ(i, out_pairs[i].second % 13);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(ReduceNode, ReducePartitionedReduceAndGroupBy) {
+
+    static constexpr size_t test_size = 10000u;
+    static constexpr size_t mod_size = 100u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) {
+                    return IntPair(index % mod_size, 1);
+                },
+                test_size);
+
+            auto key_fn = [](const IntPair& p) { return p.first; };
+
+            auto add_fn = [](const IntPair& a, const IntPair& b) {
+                              return IntPair(a.first, a.second + b.second);
+                          };
+
+            auto reduced = integers.ReduceByKey(key_fn, add_fn);
+            ASSERT_TRUE(reduced.node()->is_partitioned_by(
+                            api::KeyPartitioning<decltype(key_fn)>::tag()));
+
+            // second ReduceByKey with the same key is performed locally
+            auto doubled = reduced.ReduceByKey(key_fn, add_fn);
+
+            std::vector<IntPair> out_vec = doubled.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(mod_size, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(IntPair(i, test_size / mod_size), out_vec[i]);
+            }
+
+            // GroupByKey with the same key also skips the shuffle
+            auto groups = doubled.GroupByKey<size_t>(
+                key_fn,
+                [](auto& r, size_t /* key */) {
+                    size_t count = 0;
+                    while (r.HasNext()) r.Next(), ++count;
+                    return count;
+                });
+
+            std::vector<size_t> counts = groups.AllGather();
+            ASSERT_EQ(mod_size, counts.size());
+            for (const size_t& c : counts) ASSERT_EQ(1u, c);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(ReduceNode, ReduceToIndexCorrectResults) {
 
     auto start_func =
@@ -169,4 +476,113 @@ TEST(ReduceNode, ReduceToIndexCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+TEST(ReduceNode, ReduceToIndexDenseArray) {
+
+    auto start_func =
+        [](Context& ctx) {
+            using Pair = std::pair<size_t, size_t>;
+
+            // only every third index receives items, the others are holes
+            auto generator = [](const size_t& index) {
+                                 return Pair((index % 300) / 3 * 3, index);
+                             };
+
+            auto key = [](const Pair& p) { return p.first; };
+
+            auto add_function = [](const Pair& a, const Pair& b) {
+                                    return Pair(a.first, a.second + b.second);
+                                };
+
+            size_t result_size = 310;
+            Pair neutral(42, 0);
+
+            api::DefaultReduceToIndexConfig config;
+            config.dense_array_max_bytes_ = 1024 * 1024;
+
+            std::vector<Pair> dense =
+                Generate(ctx, generator, 10000)
+                .ReduceToIndex(key, add_function, result_size, neutral, config)
+                .AllGather();
+            std::vector<Pair> table =
+                Generate(ctx, generator, 10000)
+                .ReduceToIndex(key, add_function, result_size, neutral)
+                .AllGather();
+
+            ASSERT_EQ(result_size, dense.size());
+            ASSERT_EQ(table, dense);
+
+            for (size_t i = 0; i < result_size; ++i) {
+                if (i % 3 != 0 || i >= 300) {
+                    ASSERT_EQ(neutral, dense[i]);
+                    continue;
+                }
+                size_t sum = 0;
+                for (size_t j = i; j < 10000; j += 300)
+                    sum += j + (j + 1 < 10000 ? j + 1 : 0)
+                           + (j + 2 < 10000 ? j + 2 : 0);
+                ASSERT_EQ(Pair(i, sum), dense[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+
+//! Test StreamingReduce over micro-batches, with keys expiring from the window
+TEST(ReduceNode, StreamingReduceWindow) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using Pair = std::pair<size_t, size_t>;
+
+            auto add_function = [](const size_t& a, const size_t& b) {
+                                    return a + b;
+                                };
+
+            // batch b contains key k for k in [b, b + 100), each 10 times.
+            auto make_batch = [&ctx](size_t b) {
+                                  return Generate(
+                                      ctx,
+                                      [b](const size_t& index) {
+                                          return Pair(b + index % 100, 1);
+                                      },
+                                      1000);
+                              };
+
+            StreamingReduce<size_t, size_t> all(ctx);
+            StreamingReduce<size_t, size_t> windowed(ctx, 2);
+
+            for (size_t b = 0; b < 5; ++b) {
+                all.Update(make_batch(b), add_function);
+                windowed.Update(make_batch(b), add_function);
+            }
+            ASSERT_EQ(5u, all.num_batches());
+
+            // key k occurs in the batches max(0, k - 99) .. min(4, k)
+            std::vector<Pair> out = all.State().AllGather();
+            std::sort(out.begin(), out.end());
+            ASSERT_EQ(104u, out.size());
+            for (size_t k = 0; k < out.size(); ++k) {
+                size_t batches = std::min<size_t>(4, k) + 1
+                                 - (k < 99 ? 0 : k - 99);
+                ASSERT_EQ(Pair(k, 10 * batches), out[k]);
+            }
+
+            // only keys updated by the batches 3 and 4 remain
+            out = windowed.State().AllGather();
+            std::sort(out.begin(), out.end());
+            ASSERT_EQ(101u, windowed.State().Size());
+            ASSERT_EQ(101u, out.size());
+            for (size_t i = 0; i < out.size(); ++i) {
+                size_t k = i + 3;
+                size_t batches = std::min<size_t>(4, k) + 1
+                                 - (k < 99 ? 0 : k - 99);
+                ASSERT_EQ(Pair(k, 10 * batches), out[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
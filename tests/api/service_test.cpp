@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * tests/api/service_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/api/cache.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sum.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+TEST(Service, RunJobsFromInput) {
+    const std::string path = "service_test_input.txt";
+    {
+        std::ofstream input(path);
+        input << "sum 100\n"
+              << "\n"
+              << "unknown 1\n"
+              << "count 5 7 9\n"
+              << "sum 10\n"
+              << "quit\n"
+              << "sum 1000\n";
+    }
+
+    // results reported by worker 0 of each job
+    std::mutex mutex;
+    std::vector<std::string> results;
+
+    std::map<std::string, api::ServiceJob> jobs;
+    jobs["sum"] =
+        [&](Context& ctx, const std::vector<std::string>& args) {
+            ASSERT_EQ(1u, args.size());
+            // consume is reset from previous jobs
+            ASSERT_FALSE(ctx.consume());
+            ctx.enable_consume();
+
+            size_t n = std::stoul(args[0]);
+            size_t sum = Generate(ctx, n).Sum();
+            if (ctx.my_rank() != 0) return;
+            std::unique_lock<std::mutex> lock(mutex);
+            results.emplace_back("sum " + std::to_string(sum));
+        };
+    jobs["count"] =
+        [&](Context& ctx, const std::vector<std::string>& args) {
+            ASSERT_FALSE(ctx.consume());
+            auto dia = Generate(ctx, args.size()).Cache();
+            size_t size = dia.Size();
+            if (ctx.my_rank() != 0) return;
+            std::unique_lock<std::mutex> lock(mutex);
+            results.emplace_back("count " + std::to_string(size));
+        };
+
+    setenv("THRILL_NET", "mock", /* overwrite */ 1);
+    setenv("THRILL_LOCAL", "2", /* overwrite */ 1);
+    setenv("THRILL_WORKERS_PER_HOST", "2", /* overwrite */ 1);
+    setenv("THRILL_RAM", "1GiB", /* overwrite */ 1);
+    setenv("THRILL_SERVICE_INPUT", path.c_str(), /* overwrite */ 1);
+
+    ASSERT_EQ(0, api::RunService(jobs));
+
+    // the unknown job is skipped, and no job after "quit" runs
+    ASSERT_EQ(std::vector<std::string>({ "sum 4950", "count 3", "sum 45" }),
+              results);
+
+    std::remove(path.c_str());
+}
+
+/******************************************************************************/
@@ -10,12 +10,19 @@
 
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/partial_sort.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/size.hpp>
 #include <thrill/api/sort.hpp>
+#include <thrill/api/top_k.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <functional>
+#include <random>
 #include <string>
 #include <utility>
 #include <vector>
@@ -156,6 +163,705 @@ TEST(Sort, SortRandomIntIntStructs) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Sort, SortRandomIntegersParallelSortAlgorithm) {
+
+    static constexpr size_t test_size = 200000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(1, 10000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> int {
+                    return distribution(generator);
+                },
+                test_size);
+
+            auto sorted = integers.Sort(
+                std::less<int>(), api::ParallelSortAlgorithm(4));
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(test_size, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomIntegersRadixSort) {
+
+    static constexpr size_t test_size = 100000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<uint32_t> distribution;
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> uint32_t {
+                    return distribution(generator);
+                },
+                test_size);
+
+            auto sorted = integers.Sort(
+                RadixSortTag, [](const uint32_t& i) { return i; });
+
+            std::vector<uint32_t> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(test_size, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomByteArraysRadixSort) {
+
+    using Key = std::array<uint8_t, 5>;
+    using Pair = std::pair<Key, size_t>;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<unsigned> distribution(0, 3);
+
+            auto pairs = Generate(
+                ctx,
+                [&distribution, &generator](const size_t& index) -> Pair {
+                    Key k;
+                    for (size_t i = 0; i < k.size(); ++i)
+                        k[i] = static_cast<uint8_t>(distribution(generator));
+                    return Pair(k, index);
+                },
+                10000);
+
+            auto sorted = pairs.Sort(
+                RadixSortTag, [](const Pair& p) { return p.first; });
+
+            std::vector<Pair> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1].first < out_vec[i].first);
+            }
+
+            ASSERT_EQ(10000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomStringsCachedKey) {
+
+    static constexpr size_t test_size = 10000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<unsigned> distribution(0, 51);
+
+            auto strings = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) {
+                    std::string s(8, 'a');
+                    for (char& c : s) {
+                        unsigned r = distribution(generator);
+                        c = static_cast<char>(
+                            r < 26 ? 'a' + r : 'A' + (r - 26));
+                    }
+                    return s;
+                },
+                test_size);
+
+            // sort case-insensitively by the lower-cased strings
+            auto lower = [](const std::string& s) {
+                             std::string k = s;
+                             for (char& c : k)
+                                 c = static_cast<char>(std::tolower(c));
+                             return k;
+                         };
+
+            auto sorted = strings.Sort(CachedKeyTag, lower);
+
+            std::vector<std::string> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i + 1 < out_vec.size(); i++) {
+                ASSERT_FALSE(lower(out_vec[i + 1]) < lower(out_vec[i]));
+            }
+
+            ASSERT_EQ(test_size, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomIntegersRegularSampling) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(1, 10000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> int {
+                    return distribution(generator);
+                },
+                10000);
+
+            api::DefaultSortConfig config;
+            config.sampling_ = api::SortSampling::REGULAR;
+            config.oversampling_factor_ = 2.0;
+
+            auto sorted = integers.Sort(
+                std::less<int>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(10000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortStableFewDistinctKeys) {
+
+    using Pair = std::pair<size_t, size_t>;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) -> Pair {
+                    return Pair((index * 7919) % 5, index);
+                },
+                100000);
+
+            auto sorted = pairs.SortStable(
+                [](const Pair& a, const Pair& b) {
+                    return a.first < b.first;
+                });
+
+            std::vector<Pair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(100000u, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_LE(out_vec[i].first, out_vec[i + 1].first);
+                if (out_vec[i].first == out_vec[i + 1].first) {
+                    ASSERT_LT(out_vec[i].second, out_vec[i + 1].second);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortStableManyRuns) {
+
+    using Pair = std::pair<size_t, size_t>;
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) -> Pair {
+                    return Pair((index * 7919) % 100, index);
+                },
+                test_size);
+
+            auto sorted = pairs.SortStable(
+                [](const Pair& a, const Pair& b) {
+                    return a.first < b.first;
+                });
+
+            std::vector<Pair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_LE(out_vec[i].first, out_vec[i + 1].first);
+                if (out_vec[i].first == out_vec[i + 1].first) {
+                    ASSERT_LT(out_vec[i].second, out_vec[i + 1].second);
+                }
+            }
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(Sort, SortInBlocksManyRuns) {
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return (index * 7919) % test_size;
+                },
+                test_size);
+
+            // POD items are sorted in-place inside the received ByteBlocks
+            auto sorted = integers.Sort();
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+struct StableKeyIndex {
+    size_t key, index;
+};
+
+TEST(Sort, SortStableInBlocksManyRuns) {
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto items = Generate(
+                ctx,
+                [](const size_t& index) -> StableKeyIndex {
+                    return StableKeyIndex { (index * 7919) % 100, index };
+                },
+                test_size);
+
+            // POD items are stably sorted inside ByteBlocks in half-size runs
+            auto sorted = items.SortStable(
+                [](const StableKeyIndex& a, const StableKeyIndex& b) {
+                    return a.key < b.key;
+                });
+
+            std::vector<StableKeyIndex> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_LE(out_vec[i].key, out_vec[i + 1].key);
+                if (out_vec[i].key == out_vec[i + 1].key) {
+                    ASSERT_LT(out_vec[i].index, out_vec[i + 1].index);
+                }
+            }
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(Sort, SortDeltaCodedManyRuns) {
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return (index * 7919) % test_size;
+                },
+                test_size);
+
+            api::DefaultSortConfig config;
+            config.delta_coding_ = true;
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(Sort, SortParallelMergeManyRuns) {
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return (index * 7919) % test_size;
+                },
+                test_size);
+
+            api::DefaultSortConfig config;
+            config.merge_threads_ = 4;
+            config.block_sort_ = false;
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(Sort, SortVectorRunsWithOverlap) {
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return (index * 7919) % test_size;
+                },
+                test_size);
+
+            // runs are sorted in a background thread while the next is received
+            api::DefaultSortConfig config;
+            config.block_sort_ = false;
+            config.overlap_run_formation_ = true;
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(Sort, SortStringsManyRuns) {
+
+    static constexpr size_t test_size = 1000000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // URLs with long common prefixes
+            auto strings = Generate(
+                ctx,
+                [](const size_t& index) -> std::string {
+                    return "http://www.example.com/page/" +
+                           std::to_string((index * 7919) % test_size);
+                },
+                test_size);
+
+            // multikey quicksort of the runs, front coded run Files, and the
+            // LCP-aware merge of std::less<std::string>
+            api::DefaultSortConfig config;
+            config.delta_coding_ = true;
+
+            auto sorted = strings.Sort(
+                std::less<std::string>(), api::StringSortAlgorithm(), config);
+
+            std::vector<std::string> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+            ASSERT_TRUE(std::is_sorted(out_vec.begin(), out_vec.end()));
+            ASSERT_TRUE(std::adjacent_find(out_vec.begin(), out_vec.end())
+                        == out_vec.end());
+        };
+
+    // set small amount of RAM to force multiple sorted runs
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 1, start_func);
+}
+
+TEST(Sort, SortMultiLevelExchange) {
+
+    static constexpr size_t test_size = 50000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // few distinct keys, such that equal items cross group boundaries
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return (index * 7919) % 5;
+                },
+                test_size);
+
+            api::DefaultSortConfig config;
+            config.multi_level_workers_ = 2;
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+            ASSERT_EQ(test_size / 5,
+                      static_cast<size_t>(
+                          std::count(out_vec.begin(), out_vec.end(), 4u)));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortClassifyPartialBatches) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // sizes around multiples of the classification batch, with and
+            // without the two-level exchange
+            for (size_t test_size : { 1, 15, 16, 17, 33, 250, 1007 }) {
+                for (size_t multi_level : { 0, 2 }) {
+                    auto keys = Generate(
+                        ctx,
+                        [test_size](const size_t& index) -> size_t {
+                            return (index * 7919) % test_size;
+                        },
+                        test_size);
+
+                    api::DefaultSortConfig config;
+                    if (multi_level) config.multi_level_workers_ = multi_level;
+
+                    std::vector<size_t> out_vec =
+                        keys.Sort(std::greater<size_t>(),
+                                  api::DefaultSortAlgorithm(), config)
+                        .AllGather();
+
+                    // 7919 is prime, hence the keys are a permutation
+                    ASSERT_EQ(test_size, out_vec.size());
+                    for (size_t i = 0; i < out_vec.size(); i++) {
+                        ASSERT_EQ(test_size - 1 - i, out_vec[i]);
+                    }
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortPresortedIntegers) {
+
+    static constexpr size_t test_size = 50000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // globally sorted, hence the items are not exchanged.
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return index;
+                },
+                test_size);
+
+            api::DefaultSortConfig config;
+            config.detect_presorted_ = true;
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortStableNearlySorted) {
+
+    using Pair = std::pair<size_t, size_t>;
+
+    static constexpr size_t test_size = 50000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // rotated chunks of 10000 items, which are few ascending runs with
+            // runs of equal keys.
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) -> Pair {
+                    size_t key = (index / 10000) * 10000 +
+                                 (index % 10000 + 5000) % 10000;
+                    return Pair(key / 4, index);
+                },
+                test_size);
+
+            api::DefaultSortConfig config;
+            config.detect_presorted_ = true;
+
+            auto sorted = pairs.SortStable(
+                [](const Pair& a, const Pair& b) {
+                    return a.first < b.first;
+                },
+                api::DefaultStableSortAlgorithm(), config);
+
+            std::vector<Pair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i / 4, out_vec[i].first);
+                if (i % 4 != 0) {
+                    ASSERT_LT(out_vec[i - 1].second, out_vec[i].second);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, TopKRandomIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(123456);
+            std::uniform_int_distribution<int> distribution(1, 10000);
+
+            // generate the same integers on all workers to check the result
+            std::vector<int> input(10000);
+            for (int& i : input) i = distribution(generator);
+
+            auto integers = Generate(
+                ctx,
+                [&input](const size_t& index) -> int {
+                    return input[index];
+                },
+                input.size());
+
+            std::vector<int> check = input;
+            std::sort(check.begin(), check.end(), std::greater<int>());
+
+            std::vector<int> top = integers.TopK(100, std::greater<int>());
+
+            ASSERT_EQ(100u, top.size());
+            ASSERT_TRUE(std::equal(top.begin(), top.end(), check.begin()));
+
+            // request more items than the DIA contains
+            std::vector<int> all = integers.TopK(20000);
+
+            std::sort(check.begin(), check.end());
+            ASSERT_EQ(check, all);
+
+            ASSERT_EQ(0u, integers.TopK(0).size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, PartialSortRandomIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(123456);
+            std::uniform_int_distribution<int> distribution(1, 10000);
+
+            std::vector<int> input(10000);
+            for (int& i : input) i = distribution(generator);
+
+            auto integers = Generate(
+                ctx,
+                [&input](const size_t& index) -> int {
+                    return input[index];
+                },
+                input.size());
+
+            std::vector<int> check = input;
+            std::sort(check.begin(), check.end());
+            check.resize(333);
+
+            auto sorted = integers.PartialSort(333);
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Sort, SortZeros) {
 
     auto start_func =
@@ -185,6 +891,46 @@ TEST(Sort, SortZeros) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Sort, SortFewDistinctKeysBalanced) {
+
+    static constexpr size_t test_size = 100000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx,
+                [](const size_t& index) -> size_t {
+                    return index % 3;
+                },
+                test_size);
+
+            auto sorted = integers.Sort();
+
+            // count items on this worker to check that equal keys are spread
+            // across all workers.
+            size_t local_size = 0;
+            size_t total_size = sorted.Keep().Map(
+                [&local_size](const size_t& i) {
+                    ++local_size;
+                    return i;
+                }).Size();
+
+            ASSERT_EQ(test_size, total_size);
+            ASSERT_LE(local_size, 2 * test_size / ctx.num_workers() + 1);
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Sort, SortWithEmptyWorkers) {
 
     auto start_func =
@@ -8,12 +8,19 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <thrill/api/action_node.hpp>
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <random>
 #include <string>
 #include <vector>
@@ -223,4 +230,171 @@ TEST(Stage, AdditionalChildReferences) {
     api::RunLocalTests(start_func);
 }
 
+//! Action which requests all available RAM for its PreOp, optionally with a
+//! demand estimate, and records the amount it receives.
+template <typename ParentDIA>
+class MemLimitRecorderNode final : public api::ActionNode
+{
+public:
+    MemLimitRecorderNode(const ParentDIA& parent, size_t& mem_limit,
+                         size_t demand = 0)
+        : ActionNode(parent.ctx(), "MemLimitRecorder",
+                     { parent.id() }, { parent.node() }),
+          recorded_(mem_limit), demand_(demand) {
+        auto pre_op_fn = [](const size_t&) { };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    api::DIAMemUse PreOpMemUse() final {
+        return api::DIAMemUse::Max(demand_);
+    }
+
+    void StartPreOp(size_t /* parent_index */) final {
+        recorded_ = mem_limit_.limit();
+    }
+
+    void Execute() final { }
+
+private:
+    size_t& recorded_;
+    size_t demand_;
+};
+
+TEST(Stage, MemoryHints) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(ctx, 1000);
+
+            // four nodes share the RAM of the parent's PushData stage
+            using Node = MemLimitRecorderNode<decltype(integers)>;
+            size_t frac = 0, bytes = 0, eq1 = 0, eq2 = 0;
+            auto frac_node = common::MakeCounting<Node>(integers, frac);
+            auto bytes_node = common::MakeCounting<Node>(integers, bytes);
+            auto eq1_node = common::MakeCounting<Node>(integers, eq1);
+            auto eq2_node = common::MakeCounting<Node>(integers, eq2);
+
+            frac_node->set_mem_fraction(0.5);
+            bytes_node->set_mem_bytes(1024 * 1024);
+            frac_node->RunScope();
+
+            const size_t available = frac + bytes + eq1 + eq2;
+            ASSERT_LE(available, ctx.mem_limit());
+            ASSERT_EQ(available / 2, frac);
+            ASSERT_EQ(1024u * 1024u, bytes);
+            // the unhinted nodes split the rest equally.
+            ASSERT_LE(eq1, eq2);
+            ASSERT_LE(eq2, eq1 + 1);
+
+            // a hint on a DIA limits the RAM of its Execute
+            auto sorted =
+                Generate(ctx, 1000).Sort().MemoryHint(4 * 1024 * 1024);
+            ASSERT_EQ(1000u, sorted.Size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Stage, MemoryDemands) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(ctx, 1000);
+
+            // a node with a small demand gets it, the others split the rest.
+            using Node = MemLimitRecorderNode<decltype(integers)>;
+            const size_t small_demand = 1024 * 1024;
+            size_t small = 0, eq1 = 0, eq2 = 0;
+            auto small_node =
+                common::MakeCounting<Node>(integers, small, small_demand);
+            auto eq1_node = common::MakeCounting<Node>(integers, eq1);
+            auto eq2_node = common::MakeCounting<Node>(integers, eq2);
+            small_node->RunScope();
+
+            ASSERT_EQ(small_demand, small);
+            ASSERT_LE(small + eq1 + eq2, ctx.mem_limit());
+            ASSERT_LE(eq1, eq2);
+            ASSERT_LE(eq2, eq1 + 1);
+            ASSERT_LT(small, eq1);
+
+            // if all demands are met, the last node with the largest demand
+            // gets the leftover memory.
+            const size_t large_demand = 2 * 1024 * 1024;
+            size_t b1 = 0, b2 = 0;
+            auto b1_node =
+                common::MakeCounting<Node>(integers, b1, small_demand);
+            auto b2_node =
+                common::MakeCounting<Node>(integers, b2, large_demand);
+            b1_node->RunScope();
+
+            ASSERT_EQ(small_demand, b1);
+            ASSERT_LE(large_demand, b2);
+            ASSERT_EQ(small + eq1 + eq2, b1 + b2);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! Run the job on one host with two workers, and return the StageBuilder
+//! events of the host's JSON log.
+static std::vector<std::string> RunWithStageLog(
+    const std::function<void(Context&)>& job) {
+    static const std::string prefix = "stage_builder_test_log";
+
+    setenv("THRILL_LOG", prefix.c_str(), /* overwrite */ 1);
+    api::MemoryConfig mem_config;
+    mem_config.setup(4 * 1024 * 1024 * 1024llu);
+    api::RunLocalMock(mem_config, 1, 2, job);
+    setenv("THRILL_LOG", "", /* overwrite */ 1);
+
+    const std::string path = prefix + "-host-0.json";
+    std::vector<std::string> events;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.find("\"class\":\"StageBuilder\"") != std::string::npos)
+                events.push_back(line);
+        }
+    }
+    std::remove(path.c_str());
+    return events;
+}
+
+TEST(Stage, LogStageProfile) {
+
+    auto start_func =
+        [](Context& ctx) {
+            auto sorted = Generate(ctx, 1000).Sort();
+            ASSERT_EQ(1000u, sorted.Size());
+        };
+
+    std::vector<std::string> events = RunWithStageLog(start_func);
+
+    // the done events carry the resources used by the phase
+    size_t execute_done = 0, pushdata_done = 0;
+    for (const std::string& e : events) {
+        bool execute =
+            e.find("\"event\":\"execute-done\"") != std::string::npos;
+        bool pushdata =
+            e.find("\"event\":\"pushdata-done\"") != std::string::npos;
+        if (!execute && !pushdata) continue;
+
+        ASSERT_NE(std::string::npos, e.find("\"cpu_time\":")) << e;
+        ASSERT_NE(std::string::npos, e.find("\"io_read_bytes\":")) << e;
+        ASSERT_NE(std::string::npos, e.find("\"io_write_bytes\":")) << e;
+        if (pushdata)
+            ASSERT_NE(std::string::npos, e.find("\"push_bytes\":")) << e;
+
+        execute_done += execute, pushdata_done += pushdata;
+    }
+    // all three nodes are executed, Generate and Sort push data, on two
+    // workers
+    ASSERT_EQ(6u, execute_done);
+    ASSERT_EQ(4u, pushdata_done);
+}
+
 /******************************************************************************/
@@ -10,16 +10,19 @@
 
 #include <gtest/gtest.h>
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/cache.hpp>
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/zip.hpp>
+#include <thrill/api/zip_with_index.hpp>
 #include <thrill/common/string.hpp>
 
 #include <algorithm>
 #include <random>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 using namespace thrill; // NOLINT
@@ -332,4 +335,65 @@ TEST(ZipNode, ThreeIntegerArraysPadded) {
     api::RunLocalTests(start_func);
 }
 
+TEST(ZipNode, TwoAlignedFilteredArraysNoRebalance) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // the same filter on both inputs keeps their local sizes equal,
+            // but disbalanced among the workers.
+            auto input = Generate(ctx, test_size).Cache();
+
+            auto small = [](size_t i) { return i < test_size / 3; };
+
+            auto input1 = input.Filter(small);
+            auto input2 =
+                input.Map([](size_t i) { return 2 * i; })
+                .Filter([](size_t i) { return i < 2 * test_size / 3; });
+
+            // aligned inputs are detected by the prefix sum
+            std::vector<size_t> res = input1.Zip(
+                input2, [](size_t a, size_t b) { return a + b; }).AllGather();
+
+            // and guaranteed to be aligned here
+            std::vector<size_t> res_local = input1.Zip(
+                NoRebalanceTag, input2,
+                [](size_t a, size_t b) { return a + b; }).AllGather();
+
+            ASSERT_EQ(test_size / 3, res.size());
+            ASSERT_EQ(res, res_local);
+            for (size_t i = 0; i != res.size(); ++i) {
+                ASSERT_EQ(3 * i, res[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(ZipNode, ZipWithIndexDisbalanced) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // disbalanced input of the squares of 0..332
+            auto input = Generate(ctx, test_size)
+                         .Filter([](size_t i) { return i < test_size / 3; })
+                         .Map([](size_t i) { return i * i; });
+
+            std::vector<std::pair<size_t, size_t> > res =
+                input.ZipWithIndex(
+                    [](size_t v, size_t index) {
+                        return std::make_pair(index, v);
+                    }).AllGather();
+
+            ASSERT_EQ(test_size / 3, res.size());
+            for (size_t i = 0; i != res.size(); ++i) {
+                ASSERT_EQ(i, res[i].first);
+                ASSERT_EQ(i * i, res[i].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
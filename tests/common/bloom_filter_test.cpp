@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * tests/common/bloom_filter_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/bloom_filter.hpp>
+
+#include <cstdint>
+
+using namespace thrill::common;
+
+TEST(BloomFilter, NoFalseNegativesFewFalsePositives) {
+    static constexpr uint64_t n = 100000;
+    BloomFilter filter = BloomFilter::ForItems(n, 8);
+    ASSERT_EQ(6u, filter.num_hashes());
+
+    // std::hash of integers is the identity, the filter must cope with it.
+    for (uint64_t i = 0; i < n; ++i)
+        filter.Insert(2 * i);
+
+    for (uint64_t i = 0; i < n; ++i)
+        ASSERT_TRUE(filter.Contains(2 * i));
+
+    size_t false_positives = 0;
+    for (uint64_t i = 0; i < n; ++i)
+        false_positives += filter.Contains(2 * i + 1);
+
+    // 8 bits per item are rounded up to 10.5, hence even fewer than 2%
+    ASSERT_LT(false_positives, n / 50);
+}
+
+TEST(BloomFilter, MergeEqualsUnion) {
+    BloomFilter a(1 << 16, 4), b(1 << 16, 4), all(1 << 16, 4);
+    for (uint64_t i = 0; i < 5000; ++i) {
+        (i % 3 == 0 ? a : b).Insert(i * 0x9E3779B97F4A7C15ull);
+        all.Insert(i * 0x9E3779B97F4A7C15ull);
+    }
+    a.Merge(b);
+    ASSERT_EQ(all.words(), a.words());
+}
+
+/******************************************************************************/
@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * tests/common/cgroup_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/cgroup.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __linux__
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace thrill;
+
+#if __linux__
+
+//! a fake tree of cgroup files, which is removed at the end
+class CgroupTree
+{
+public:
+    explicit CgroupTree(const std::string& root) : root_(root) {
+        MakeDir(root_);
+    }
+
+    ~CgroupTree() {
+        for (auto it = files_.rbegin(); it != files_.rend(); ++it)
+            ::remove(it->c_str());
+        for (auto it = dirs_.rbegin(); it != dirs_.rend(); ++it)
+            ::rmdir(it->c_str());
+    }
+
+    //! create a directory below the root
+    void Dir(const std::string& path) { MakeDir(root_ + "/" + path); }
+
+    //! write a file below the root
+    void File(const std::string& path, const std::string& content) {
+        std::ofstream(root_ + "/" + path) << content << '\n';
+        files_.push_back(root_ + "/" + path);
+    }
+
+    const std::string& root() const { return root_; }
+
+private:
+    std::string root_;
+    std::vector<std::string> dirs_, files_;
+
+    void MakeDir(const std::string& path) {
+        ::mkdir(path.c_str(), 0755);
+        dirs_.push_back(path);
+    }
+};
+
+TEST(Cgroup, LimitsV2) {
+    CgroupTree t("cgroup_test_v2");
+    t.File("proc_cgroup", "0::/user.slice/job");
+    t.Dir("user.slice");
+    t.Dir("user.slice/job");
+
+    // the job's limits are below its parent's
+    t.File("user.slice/memory.max", "max");
+    t.File("user.slice/job/memory.max", "1073741824");
+    t.File("user.slice/cpu.max", "150000 100000");
+    t.File("user.slice/job/cpu.max", "max 100000");
+
+    std::string proc = t.root() + "/proc_cgroup";
+    ASSERT_EQ(1073741824u, common::CgroupMemoryLimit(proc, t.root()));
+    // 1.5 CPUs are rounded up
+    ASSERT_EQ(2u, common::CgroupCpuLimit(proc, t.root()));
+}
+
+TEST(Cgroup, LimitsV1) {
+    CgroupTree t("cgroup_test_v1");
+    t.File("proc_cgroup", "4:memory:/job\n3:cpu,cpuacct:/job");
+    t.Dir("memory");
+    t.Dir("memory/job");
+    t.Dir("cpu,cpuacct");
+    t.Dir("cpu,cpuacct/job");
+
+    // the root's values mean no limit
+    t.File("memory/memory.limit_in_bytes", "9223372036854771712");
+    t.File("memory/job/memory.limit_in_bytes", "536870912");
+    t.File("cpu,cpuacct/cpu.cfs_quota_us", "-1");
+    t.File("cpu,cpuacct/cpu.cfs_period_us", "100000");
+    t.File("cpu,cpuacct/job/cpu.cfs_quota_us", "300000");
+    t.File("cpu,cpuacct/job/cpu.cfs_period_us", "100000");
+
+    std::string proc = t.root() + "/proc_cgroup";
+    ASSERT_EQ(536870912u, common::CgroupMemoryLimit(proc, t.root()));
+    ASSERT_EQ(3u, common::CgroupCpuLimit(proc, t.root()));
+}
+
+TEST(Cgroup, NoLimits) {
+    CgroupTree t("cgroup_test_none");
+    t.File("proc_cgroup", "0::/");
+    t.File("memory.max", "max");
+    t.File("cpu.max", "max 100000");
+
+    std::string proc = t.root() + "/proc_cgroup";
+    ASSERT_EQ(0u, common::CgroupMemoryLimit(proc, t.root()));
+    ASSERT_EQ(0u, common::CgroupCpuLimit(proc, t.root()));
+
+    // missing files are no limits either
+    ASSERT_EQ(0u, common::CgroupMemoryLimit(proc + "_missing", t.root()));
+}
+
+TEST(Cgroup, AvailableCpuCount) {
+    size_t cpus = common::AvailableCpuCount();
+    ASSERT_LE(1u, cpus);
+    if (std::thread::hardware_concurrency() != 0) {
+        ASSERT_GE(std::thread::hardware_concurrency(), cpus);
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        ASSERT_GE(static_cast<size_t>(CPU_COUNT(&set)), cpus);
+    }
+
+    size_t quota = common::CgroupCpuLimit();
+    if (quota != 0) {
+        ASSERT_GE(quota, cpus);
+    }
+}
+
+#endif
+
+/******************************************************************************/
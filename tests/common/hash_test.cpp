@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * tests/common/hash_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/hash.hpp>
+
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+
+using namespace thrill::common;
+
+TEST(Hash, StringLengths) {
+    // all lengths around the 4, 16, and 48 byte code paths
+    std::set<size_t> hashes;
+    for (size_t n = 0; n < 200; ++n)
+        hashes.insert(Hash<std::string>()(std::string(n, 'a')));
+    ASSERT_EQ(200u, hashes.size());
+
+    // each byte of a long string changes the hash
+    std::string str(150, 'x');
+    hashes.clear();
+    for (size_t i = 0; i < str.size(); ++i) {
+        std::string s = str;
+        s[i] = 'y';
+        hashes.insert(Hash<std::string>()(s));
+    }
+    ASSERT_EQ(str.size(), hashes.size());
+}
+
+TEST(Hash, StringTypes) {
+    std::string str = "The quick brown fox jumps over the lazy dog";
+    size_t h = Hash<std::string>()(str);
+    ASSERT_EQ(h, Hash<StringView>()(StringView(str.data(), str.size())));
+    ASSERT_EQ(h, Hash<FastString>()(FastString::Ref(str.data(), str.size())));
+}
+
+TEST(Hash, Integers) {
+    // consecutive integers spread over the low bits used for partitioning
+    std::set<size_t> low_bits;
+    for (size_t i = 0; i < 4096; ++i)
+        low_bits.insert(Hash<size_t>()(i * 1024) % 1024);
+    ASSERT_GT(low_bits.size(), 512u);
+
+    ASSERT_EQ(Hash<int>()(42), Hash<int>()(42));
+    ASSERT_NE(Hash<int>()(42), Hash<int>()(43));
+}
+
+TEST(Hash, PairsAndTuples) {
+    using Pair = std::pair<int, std::string>;
+    ASSERT_EQ(Hash<Pair>()(Pair(1, "a")), Hash<Pair>()(Pair(1, "a")));
+    ASSERT_NE(Hash<Pair>()(Pair(1, "a")), Hash<Pair>()(Pair(2, "a")));
+
+    using IntPair = std::pair<int, int>;
+    ASSERT_NE(Hash<IntPair>()(IntPair(1, 2)), Hash<IntPair>()(IntPair(2, 1)));
+
+    using Tuple = std::tuple<int, std::string, double>;
+    ASSERT_EQ(Hash<Tuple>()(Tuple(1, "a", 2.0)),
+              Hash<Tuple>()(Tuple(1, "a", 2.0)));
+    ASSERT_NE(Hash<Tuple>()(Tuple(1, "a", 2.0)),
+              Hash<Tuple>()(Tuple(1, "b", 2.0)));
+}
+
+/******************************************************************************/
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * tests/common/hyperloglog_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/hash.hpp>
+#include <thrill/common/hyperloglog.hpp>
+
+#include <cstdint>
+
+using namespace thrill::common;
+
+TEST(HyperLogLog, EstimateSmallAndLarge) {
+    for (uint64_t n : { 100u, 10000u, 1000000u }) {
+        HyperLogLog hll;
+        // insert every item twice, duplicates must not count
+        for (size_t r = 0; r < 2; ++r) {
+            for (uint64_t i = 0; i < n; ++i)
+                hll.Insert(HashInteger(i));
+        }
+        double error = std::abs(hll.Estimate() - n) / n;
+        ASSERT_LT(error, 0.05) << "n = " << n;
+    }
+}
+
+TEST(HyperLogLog, MergeEqualsUnion) {
+    HyperLogLog a, b, all;
+    for (uint64_t i = 0; i < 50000; ++i) {
+        (i % 3 == 0 ? a : b).Insert(HashInteger(i));
+        all.Insert(HashInteger(i));
+    }
+    a.Merge(b);
+    ASSERT_EQ(all.registers(), a.registers());
+    ASSERT_DOUBLE_EQ(all.Estimate(), a.Estimate());
+}
+
+/******************************************************************************/
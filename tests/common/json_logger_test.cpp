@@ -9,10 +9,13 @@
  ******************************************************************************/
 
 #include <thrill/common/json_logger.hpp>
+#include <thrill/core/file_io.hpp>
 
 #include <gtest/gtest.h>
 
+#include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace thrill;
@@ -53,4 +56,40 @@ TEST(JsonLogger, Sublogger) {
     sub_sub_logger << "test" << "output";
 }
 
+TEST(JsonLogger, ManyThreads) {
+
+    static constexpr size_t num_threads = 8;
+    static constexpr size_t num_lines = 1000;
+
+    core::TemporaryDirectory tmpdir;
+    std::string path = tmpdir.get() + "/log.json";
+
+    {
+        common::JsonLogger base_logger(path);
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back(
+                [&base_logger, t]() {
+                    common::JsonLogger logger(&base_logger, "thread", t);
+                    for (size_t i = 0; i < num_lines; ++i)
+                        logger << "line" << i << "text" << "abc";
+                });
+        }
+        for (std::thread& t : threads) t.join();
+        // destructor writes all lines
+    }
+
+    std::ifstream in(path);
+    std::string line;
+    size_t count = 0;
+    while (std::getline(in, line)) {
+        ASSERT_EQ('{', line.front());
+        ASSERT_EQ('}', line.back());
+        ASSERT_NE(std::string::npos, line.find("\"text\":\"abc\""));
+        ++count;
+    }
+    ASSERT_EQ(num_threads * num_lines, count);
+}
+
 /******************************************************************************/
@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * tests/common/latency_histogram_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/latency_histogram.hpp>
+
+#include <vector>
+
+using namespace thrill::common;
+
+TEST(LatencyHistogram, Buckets) {
+    using std::chrono::microseconds;
+    LatencyHistogram h;
+
+    h.Add(microseconds(0));
+    h.Add(microseconds(1));
+    h.Add(microseconds(2));
+    h.Add(microseconds(3));
+    h.Add(microseconds(1000));
+
+    std::vector<size_t> counts = h.Take();
+    ASSERT_EQ(10u, counts.size());
+    ASSERT_EQ(2u, counts[0]);
+    ASSERT_EQ(2u, counts[1]);
+    ASSERT_EQ(1u, counts[9]);
+
+    // Take() resets the counts
+    ASSERT_TRUE(h.Take().empty());
+
+    // very large latencies go into the last bucket
+    h.Add(std::chrono::hours(24 * 365));
+    counts = h.Take();
+    ASSERT_EQ(static_cast<size_t>(LatencyHistogram::kBuckets), counts.size());
+    ASSERT_EQ(1u, counts.back());
+}
+
+TEST(LatencyHistogram, Merge) {
+    std::vector<size_t> sum { 1, 2 };
+    LatencyHistogram::Merge(&sum, { 0, 1, 3 });
+    ASSERT_EQ(std::vector<size_t>({ 1, 3, 3 }), sum);
+    LatencyHistogram::Merge(&sum, { 4 });
+    ASSERT_EQ(std::vector<size_t>({ 5, 3, 3 }), sum);
+}
+
+/******************************************************************************/
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * tests/common/mpsc_queue_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/mpsc_queue.hpp>
+#include <thrill/common/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+using namespace thrill::common;
+
+TEST(MpscQueue, ParallelPushPopAscIntegerAndCalculateTotalSum) {
+    ThreadPool pool(8);
+
+    MpscQueue<size_t> queue;
+    std::atomic<size_t> count(0);
+    std::atomic<size_t> total_sum(0);
+
+    static constexpr size_t num_threads = 4;
+    static constexpr size_t num_pushes = 10000;
+
+    // have threads push items
+
+    for (size_t i = 0; i != num_threads; ++i) {
+        pool.Enqueue([&queue]() {
+                         for (size_t i = 0; i != num_pushes; ++i) {
+                             queue.push(i);
+                         }
+                     });
+    }
+
+    // have one thread try to pop() items, waiting for new ones as needed.
+
+    pool.Enqueue([&]() {
+                     while (count != num_threads * num_pushes) {
+                         size_t item;
+                         queue.pop(item);
+                         total_sum += item;
+                         ++count;
+                     }
+                 });
+
+    pool.LoopUntilEmpty();
+
+    ASSERT_TRUE(queue.empty());
+    ASSERT_EQ(count, num_threads * num_pushes);
+    // check total sum, no item gets lost?
+    ASSERT_EQ(total_sum, num_threads * num_pushes * (num_pushes - 1) / 2);
+}
+
+TEST(MpscQueue, OrderTryPopAndTimeout) {
+    MpscQueue<std::unique_ptr<std::string> > queue;
+
+    std::unique_ptr<std::string> item;
+    ASSERT_FALSE(queue.try_pop(item));
+    ASSERT_FALSE(queue.pop_for(item, std::chrono::milliseconds(1)));
+
+    for (size_t i = 0; i < 100; ++i)
+        queue.emplace(new std::string(std::to_string(i)));
+    ASSERT_EQ(100u, queue.size());
+
+    // a moved queue keeps the items of a single producer in order
+    MpscQueue<std::unique_ptr<std::string> > other(std::move(queue));
+    ASSERT_TRUE(queue.empty());
+
+    for (size_t i = 0; i < 50; ++i) {
+        ASSERT_TRUE(other.try_pop(item));
+        ASSERT_EQ(std::to_string(i), *item);
+    }
+    for (size_t i = 50; i < 100; ++i) {
+        ASSERT_TRUE(other.pop_for(item, std::chrono::milliseconds(1)));
+        ASSERT_EQ(std::to_string(i), *item);
+    }
+    ASSERT_TRUE(other.empty());
+
+    // remaining items are destroyed with the queue
+    other.emplace(new std::string("x"));
+}
+
+/******************************************************************************/
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * tests/common/numa_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/numa.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#if __linux__
+#include <sched.h>
+#endif
+
+using namespace thrill;
+
+// must run first, since the reserved service cores are read once.
+TEST(Numa, ServiceCores) {
+    setenv("THRILL_SERVICE_CORES", "1", /* overwrite */ 1);
+    ASSERT_EQ(1u, common::NumServiceCores());
+
+    const std::vector<size_t>& cpus = common::ServiceCpus();
+    // a single CPU machine cannot reserve any
+    ASSERT_GE(1u, cpus.size());
+    if (cpus.empty()) return;
+
+#if __linux__
+    std::thread([&cpus]() {
+                    common::PinServiceThread();
+                    cpu_set_t set;
+                    ASSERT_EQ(0, sched_getaffinity(0, sizeof(set), &set));
+                    ASSERT_EQ(1, CPU_COUNT(&set));
+                    ASSERT_TRUE(CPU_ISSET(cpus[0], &set));
+                }).join();
+
+    std::thread([&cpus]() {
+                    common::NumaPinWorker(0, 1);
+                    cpu_set_t set;
+                    ASSERT_EQ(0, sched_getaffinity(0, sizeof(set), &set));
+                    ASSERT_FALSE(CPU_ISSET(cpus[0], &set));
+                }).join();
+#endif
+}
+
+TEST(Numa, NodeOfWorker) {
+    size_t num_nodes = common::NumaNumNodes();
+    ASSERT_LE(1u, num_nodes);
+
+    // workers are distributed in consecutive ranges and all nodes are used
+    static constexpr size_t num_workers = 64;
+    size_t prev = common::NumaNodeOfWorker(0, num_workers);
+    size_t changes = 0;
+    for (size_t w = 1; w < num_workers; ++w) {
+        size_t node = common::NumaNodeOfWorker(w, num_workers);
+        if (node != prev) ++changes;
+        ASSERT_LE(prev, node);
+        prev = node;
+    }
+    ASSERT_EQ(num_nodes - 1, changes);
+}
+
+TEST(Numa, PinAndPreferMemory) {
+    size_t node = common::NumaNodeOfWorker(0, 1);
+    ASSERT_FALSE(common::NumaNodeCpus(node).empty() &&
+                 !common::NumaPinThisThread(node));
+
+    std::vector<char> memory(1024 * 1024);
+    common::NumaPreferMemory(memory.data(), memory.size(), node);
+}
+
+/******************************************************************************/
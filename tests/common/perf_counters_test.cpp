@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * tests/common/perf_counters_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/perf_counters.hpp>
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace thrill::common;
+
+//! some work for the counters
+static size_t Spin(size_t n) {
+    volatile size_t x = 0;
+    for (size_t i = 0; i < n; ++i) x = x + i * i;
+    return x;
+}
+
+TEST(PerfCounters, Names) {
+    ASSERT_EQ(std::string("cycles"), PerfCounters::Name(PerfCounters::Cycles));
+    ASSERT_EQ(std::string("instructions"),
+              PerfCounters::Name(PerfCounters::Instructions));
+    ASSERT_EQ(std::string("llc_misses"),
+              PerfCounters::Name(PerfCounters::CacheMisses));
+    ASSERT_EQ(std::string("branch_misses"),
+              PerfCounters::Name(PerfCounters::BranchMisses));
+    ASSERT_EQ(std::string("unknown"),
+              PerfCounters::Name(PerfCounters::kEvents));
+}
+
+TEST(PerfCounters, CountThreads) {
+    // the setting is read once, hence this is the only test enabling it.
+    setenv("THRILL_PERF_COUNTERS", "1", /* overwrite */ 1);
+    ASSERT_TRUE(PerfCounters::Enabled());
+
+    PerfCounters::Values begin, end;
+    if (!PerfCounters::Read(&begin)) {
+        // the kernel denies access, e.g. in containers: fall back to nothing
+        return;
+    }
+    Spin(1000000);
+    ASSERT_TRUE(PerfCounters::Read(&end));
+    ASSERT_LT(begin[PerfCounters::Instructions] + 1000000,
+              end[PerfCounters::Instructions]);
+    ASSERT_LT(begin[PerfCounters::Cycles], end[PerfCounters::Cycles]);
+
+    // another thread has its own counters, which start near zero
+    std::thread thread(
+        [&begin]() {
+            PerfCounters::Values values;
+            ASSERT_TRUE(PerfCounters::Read(&values));
+            ASSERT_GT(begin[PerfCounters::Instructions],
+                      values[PerfCounters::Instructions]);
+        });
+    thread.join();
+}
+
+/******************************************************************************/
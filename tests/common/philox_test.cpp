@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * tests/common/philox_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/philox.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace thrill;
+
+TEST(Philox, KnownAnswers) {
+    // known answer vectors of the Random123 reference implementation
+    using Counter = common::Philox4x32::Counter;
+
+    common::Philox4x32 zero(0);
+    ASSERT_EQ((Counter { { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } }),
+              zero(Counter { { 0, 0, 0, 0 } }));
+
+    common::Philox4x32 ones(0xffffffffffffffffull);
+    ASSERT_EQ((Counter { { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } }),
+              ones(Counter { { 0xffffffff, 0xffffffff,
+                               0xffffffff, 0xffffffff } }));
+
+    common::Philox4x32 pi(0x299f31d0a4093822ull);
+    ASSERT_EQ((Counter { { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } }),
+              pi(Counter { { 0x243f6a88, 0x85a308d3,
+                             0x13198a2e, 0x03707344 } }));
+}
+
+TEST(Philox, EngineStreams) {
+    common::PhiloxEngine a(42, 7), b(42, 7), c(42, 8), d(43, 7);
+
+    std::vector<uint64_t> va, vc, vd;
+    for (size_t i = 0; i < 100; ++i) {
+        va.push_back(a());
+        ASSERT_EQ(va.back(), b());
+        vc.push_back(c());
+        vd.push_back(d());
+    }
+    ASSERT_NE(va, vc);
+    ASSERT_NE(va, vd);
+
+    // discard skips the same words as drawing them
+    common::PhiloxEngine e(42, 7);
+    e.discard(1);
+    ASSERT_EQ(va[1], e());
+    e.discard(50);
+    ASSERT_EQ(va[52], e());
+    e.seed(42, 7);
+    ASSERT_EQ(va[0], e());
+
+    // direct access to positions of the stream
+    common::Philox4x32 philox(42);
+    ASSERT_EQ(va[0], philox.Random(0, 7));
+}
+
+TEST(Philox, UniformDistribution) {
+    common::PhiloxEngine engine(1);
+    std::uniform_real_distribution<double> dist;
+
+    static constexpr size_t num = 100000;
+    double sum = 0;
+    for (size_t i = 0; i < num; ++i) {
+        double x = dist(engine);
+        ASSERT_LE(0.0, x);
+        ASSERT_GT(1.0, x);
+        sum += x;
+    }
+    ASSERT_NEAR(0.5, sum / num, 0.01);
+}
+
+/******************************************************************************/
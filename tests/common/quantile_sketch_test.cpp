@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * tests/common/quantile_sketch_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/quantile_sketch.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace thrill::common;
+
+TEST(QuantileSketch, SmallInputIsExact) {
+    QuantileSketch<int> sketch;
+    for (int i = 50; i > 0; --i) sketch.Insert(i);
+
+    ASSERT_EQ(50u, sketch.num_items());
+    ASSERT_EQ(1, sketch.Quantile(0.0));
+    ASSERT_EQ(25, sketch.Quantile(0.5));
+    ASSERT_EQ(50, sketch.Quantile(1.0));
+}
+
+TEST(QuantileSketch, MergedRankError) {
+    const size_t n = 1000000;
+    std::vector<size_t> values(n);
+    for (size_t i = 0; i < n; ++i) values[i] = i;
+    std::shuffle(values.begin(), values.end(), std::mt19937(42));
+
+    // four sketches of a quarter each, merged like an AllReduce
+    std::vector<QuantileSketch<size_t> > parts(4);
+    for (size_t i = 0; i < n; ++i) parts[i % 4].Insert(values[i]);
+
+    QuantileSketch<size_t> sketch;
+    for (const QuantileSketch<size_t>& p : parts) sketch.Merge(p.levels());
+
+    size_t stored = 0;
+    for (const std::vector<size_t>& level : sketch.levels())
+        stored += level.size();
+    ASSERT_LT(stored, 1000u);
+
+    std::vector<double> qs = { 0.01, 0.25, 0.5, 0.75, 0.99 };
+    std::vector<size_t> result = sketch.Quantiles(qs);
+    for (size_t i = 0; i < qs.size(); ++i) {
+        double rank = static_cast<double>(result[i]) / n;
+        ASSERT_NEAR(qs[i], rank, 0.02);
+    }
+}
+
+/******************************************************************************/
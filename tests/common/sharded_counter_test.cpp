@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * tests/common/sharded_counter_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/sharded_counter.hpp>
+#include <thrill/mem/manager.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace thrill;
+
+TEST(ShardedCounters, ConcurrentAddsAreSummed) {
+    common::ShardedCounters<size_t, 2> counters;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 8; ++t) {
+        threads.emplace_back(
+            [&counters, t]() {
+                for (size_t i = 0; i < 10000; ++i) {
+                    counters.add(0, 1);
+                    counters.add(1, t);
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    ASSERT_EQ(80000u, counters.get(0));
+    ASSERT_EQ(10000u * 28u, counters.get(1));
+}
+
+TEST(ShardedCounters, SubtractFromOtherThread) {
+    common::ShardedCounters<size_t> counters;
+
+    counters.add(0, 100);
+    std::thread([&counters]() { counters.subtract(0, 60); }).join();
+    ASSERT_EQ(40u, counters.get(0));
+}
+
+TEST(ShardedCounters, ManagerReportsToSuperior) {
+    mem::Manager super(nullptr, "Super");
+    mem::Manager local(&super, "Local");
+
+    local.add(1000);
+    std::thread([&local]() { local.add(500).subtract(1000); }).join();
+
+    ASSERT_EQ(500u, local.total());
+    ASSERT_EQ(500u, super.total());
+    ASSERT_EQ(1500u, local.peak());
+
+    local.subtract(500);
+    ASSERT_EQ(0u, super.total());
+}
+
+/******************************************************************************/
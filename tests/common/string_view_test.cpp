@@ -14,7 +14,9 @@
 #include <gtest/gtest.h>
 #include <thrill/common/logger.hpp>
 
+#include <random>
 #include <string>
+#include <vector>
 
 using thrill::common::StringView;
 
@@ -49,4 +51,41 @@ TEST(StringViewTest, AssignAndCompare) {
     ASSERT_FALSE(fast_str != equal_str);
 }
 
+TEST(StringViewTest, SplitWords) {
+
+    std::vector<std::string> words;
+    auto collect = [&](const StringView& sv) {
+                       words.push_back(sv.ToString());
+                   };
+
+    thrill::common::SplitWords("", ' ', collect);
+    ASSERT_EQ(0u, words.size());
+
+    thrill::common::SplitWords(
+        "  a bb  ccc dddd eeeee ffffff ggggggg hhhhhhhh iiiiiiiii  ", ' ',
+        collect);
+    ASSERT_EQ(std::vector<std::string>(
+                  { "a", "bb", "ccc", "dddd", "eeeee", "ffffff", "ggggggg",
+                    "hhhhhhhh", "iiiiiiiii" }), words);
+
+    // compare against SplitView() on random strings of all lengths, which
+    // cross the 16 byte blocks at all offsets.
+    std::mt19937 rng(42);
+    for (size_t size = 0; size < 100; ++size) {
+        std::string str(size, 'x');
+        for (char& c : str)
+            c = static_cast<char>(rng() % 3 == 0 ? ' ' : 'a' + rng() % 26);
+
+        std::vector<std::string> expected;
+        thrill::common::SplitView(
+            str, ' ', [&](const StringView& sv) {
+                if (sv.size() != 0) expected.push_back(sv.ToString());
+            });
+
+        words.clear();
+        thrill::common::SplitWords(str, ' ', collect);
+        ASSERT_EQ(expected, words);
+    }
+}
+
 /******************************************************************************/
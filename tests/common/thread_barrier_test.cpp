@@ -20,11 +20,12 @@
 
 using namespace thrill::common;
 
+template <typename Barrier = ThreadBarrier>
 static void TestWaitFor(int count, int slowThread = -1) {
 
     int maxWaitTime = 100000;
 
-    ThreadBarrier barrier(count);
+    Barrier barrier(count);
     // Need to use atomic here, since setting a bool might not be atomic.
     std::vector<std::atomic<bool> > flags(count);
     std::vector<std::thread> threads(count);
@@ -74,4 +75,37 @@ TEST(ThreadBarrier, TestWaitFor) {
     TestWaitFor(32);
 }
 
+TEST(ThreadBarrier, SpinBlockingWaitFor) {
+    // sleeping threads go to sleep and must be woken up
+    TestWaitFor<ThreadBarrierSpinBlocking>(8, 3);
+    TestWaitFor<ThreadBarrierSpinBlocking>(32);
+}
+
+TEST(ThreadBarrier, SpinBlockingCycles) {
+    // many short cycles, with the lambda run once per cycle
+    size_t count = 6, cycles = 10000;
+    ThreadBarrierSpinBlocking barrier(count);
+    std::atomic<size_t> arrived { 0 };
+    size_t lambda_calls = 0;
+    std::vector<std::thread> threads(count);
+
+    for (size_t i = 0; i < count; i++) {
+        threads[i] = std::thread(
+            [&, i] {
+                for (size_t c = 0; c < cycles; ++c) {
+                    ++arrived;
+                    if (c % 1000 == i)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    barrier.Await([&]() { ++lambda_calls; });
+                    ASSERT_GE(arrived.load(), (c + 1) * count);
+                }
+            });
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        threads[i].join();
+    }
+    ASSERT_EQ(cycles, lambda_calls);
+}
+
 /******************************************************************************/
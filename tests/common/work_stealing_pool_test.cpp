@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * tests/common/work_stealing_pool_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/work_stealing_pool.hpp>
+#include <thrill/core/parallel_sort.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace thrill;
+using namespace thrill::common;
+
+TEST(WorkStealingPool, ParallelForNested) {
+    WorkStealingPool pool(4);
+
+    std::vector<size_t> result(64 * 64, 0);
+
+    // nested ParallelFor calls from the pool's threads run while waiting.
+    pool.ParallelFor(
+        0, 64, 1, [&](size_t i) {
+            pool.ParallelFor(
+                0, 64, 4, [&](size_t j) { result[i * 64 + j] += i * 64 + j; });
+        });
+
+    for (size_t i = 0; i < result.size(); ++i)
+        ASSERT_EQ(i, result[i]);
+}
+
+TEST(WorkStealingPool, ParallelInvokeFibonacci) {
+    WorkStealingPool pool(3);
+
+    std::function<size_t(size_t)> fib =
+        [&](size_t n) -> size_t {
+            if (n < 2) return n;
+            size_t a, b;
+            pool.ParallelInvoke([&]() { a = fib(n - 1); },
+                                [&]() { b = fib(n - 2); });
+            return a + b;
+        };
+
+    ASSERT_EQ(6765u, fib(20));
+}
+
+TEST(WorkStealingPool, EnqueueFromOutside) {
+    std::atomic<size_t> pending { 1000 };
+    std::atomic<size_t> sum { 0 };
+    {
+        WorkStealingPool pool(2);
+        for (size_t i = 0; i < 1000; ++i) {
+            pool.Enqueue([i, &pending, &sum]() {
+                             sum += i;
+                             --pending;
+                         });
+        }
+        pool.Wait(pending);
+        ASSERT_EQ(1000u, pool.done());
+    }
+    ASSERT_EQ(999u * 1000u / 2, sum);
+}
+
+TEST(WorkStealingPool, ParallelSort) {
+    std::vector<size_t> v(300000);
+    std::mt19937 rng(42);
+    for (size_t& x : v) x = rng();
+
+    std::vector<size_t> check = v;
+    std::sort(check.begin(), check.end());
+
+    core::parallel_sort(v.begin(), v.end(), std::less<size_t>(), 5);
+    ASSERT_EQ(check, v);
+}
+
+TEST(WorkStealingPool, ParallelSortSmallMergeBuffer) {
+    std::vector<size_t> v(300000);
+    std::mt19937 rng(42);
+    for (size_t& x : v) x = rng() % 1000;
+
+    std::vector<size_t> check = v;
+    std::sort(check.begin(), check.end());
+
+    // merges larger than 16 items are split by rotations
+    core::parallel_sort(v.begin(), v.end(), std::less<size_t>(), 5,
+                        5 * 16 * sizeof(size_t));
+    ASSERT_EQ(check, v);
+}
+
+/******************************************************************************/
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * tests/core/background_writer_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thrill/core/background_writer.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+TEST(BackgroundWriter, RunsJobsInOrder) {
+    for (size_t max_queue : { 0, 1, 4 }) {
+        std::vector<size_t> done;
+        core::BackgroundWriter writer(max_queue);
+        for (size_t i = 0; i < 1000; ++i) {
+            std::vector<size_t> data(16, i);
+            writer.Enqueue([&done, data = std::move(data)]() {
+                               done.push_back(data.front());
+                           });
+        }
+        writer.Finish();
+
+        ASSERT_EQ(1000u, done.size());
+        for (size_t i = 0; i < done.size(); ++i)
+            ASSERT_EQ(i, done[i]);
+    }
+}
+
+TEST(BackgroundWriter, RethrowsErrors) {
+    for (size_t max_queue : { 0, 2 }) {
+        size_t num_done = 0;
+        core::BackgroundWriter writer(max_queue);
+        ASSERT_THROW(
+            {
+                for (size_t i = 0; i < 100; ++i) {
+                    writer.Enqueue([&num_done, i]() {
+                                       if (i == 10)
+                                           throw std::runtime_error("failed");
+                                       ++num_done;
+                                   });
+                }
+                writer.Finish();
+            }, std::runtime_error);
+        // later calls rethrow the error, and later jobs are skipped.
+        ASSERT_THROW(writer.Finish(), std::runtime_error);
+        ASSERT_EQ(10u, num_done);
+    }
+}
+
+/******************************************************************************/
@@ -12,7 +12,7 @@
 
 #include <thrill/common/function_traits.hpp>
 #include <thrill/core/multiway_merge.hpp>
-#include <thrill/core/multiway_merge_attic.hpp>
+#include <thrill/core/string_sort.hpp>
 #include <thrill/data/file.hpp>
 
 #include <thrill/common/logger.hpp>
@@ -20,8 +20,10 @@
 #include <algorithm>
 #include <cstdlib>
 #include <functional>
+#include <limits>
 #include <random>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -31,48 +33,156 @@ struct MultiwayMerge : public ::testing::Test {
     data::BlockPool block_pool_;
 };
 
-TEST_F(MultiwayMerge, Basic) {
-    // static constexpr bool debug = false;
+TEST_F(MultiwayMerge, ArithmeticLoserTree) {
     std::mt19937 gen(0);
-    size_t a = 2;
-    size_t b = 5;
-    size_t total = 2 * 5;
 
-    using iterator = std::vector<size_t>::iterator;
-    std::vector<std::vector<size_t> > in;
-    std::vector<size_t> ref;
-    std::vector<size_t> output;
-    std::vector<std::pair<iterator, iterator> > seq;
+    using Tree = core::LoserTreeTraits<
+              false, size_t, std::less<size_t> >::Type;
+    static_assert(
+        std::is_same<
+            Tree, core::LoserTreeArithmetic<false, size_t, std::less<size_t> >
+            >::value, "arithmetic loser tree is not selected");
 
-    in.reserve(a);
-    ref.reserve(total);
-    seq.reserve(a);
-    output.resize(total);
+    for (size_t a : { 1, 3, 16, 17 }) {
+        std::vector<data::File> in;
+        std::vector<size_t> ref;
 
-    for (size_t i = 0; i < a; ++i) {
-        std::vector<size_t> tmp;
-        tmp.reserve(b);
-        for (size_t j = 0; j < b; ++j) {
-            auto elem = gen() % 10;
-            tmp.push_back(elem);
-            ref.push_back(elem);
+        for (size_t i = 0; i < a; ++i) {
+            // some empty runs, and the maximum value which is the sentinel
+            std::vector<size_t> tmp(i % 5 == 2 ? 0 : 100 + gen() % 100);
+            for (size_t& t : tmp) {
+                t = gen() % 50;
+                if (t == 0) t = std::numeric_limits<size_t>::max();
+            }
+            std::sort(tmp.begin(), tmp.end());
+            ref.insert(ref.end(), tmp.begin(), tmp.end());
+
+            data::File f(block_pool_, 0, /* dia_id */ 0);
+            {
+                auto w = f.GetWriter();
+                for (const size_t& t : tmp) w.Put(t);
+            }
+            in.emplace_back(std::move(f));
         }
-        std::sort(tmp.begin(), tmp.end());
-        in.push_back(tmp);
+
+        std::vector<data::File::ConsumeReader> seq;
+        for (size_t t = 0; t < in.size(); ++t)
+            seq.emplace_back(in[t].GetConsumeReader());
+
+        auto puller = core::make_multiway_merge_tree<size_t>(
+            seq.begin(), seq.end(), std::less<size_t>());
+
+        std::sort(ref.begin(), ref.end());
+
+        for (size_t i = 0; i < ref.size(); ++i) {
+            ASSERT_TRUE(puller.HasNext());
+            ASSERT_EQ(ref[i], puller.Next());
+        }
+        ASSERT_FALSE(puller.HasNext());
     }
+}
+
+template <typename Comparator>
+void TestInfinityKeys(data::BlockPool& block_pool, double inf) {
+    // runs containing the infinity, which must not lose against the sentinel
+    // of exhausted runs.
+    std::vector<std::vector<double> > runs = {
+        { 1.0, inf, inf }, { 2.0 }, { }, { -inf, 0.5, inf }
+    };
+
+    std::vector<data::File> in;
+    std::vector<double> ref;
+    for (std::vector<double>& run : runs) {
+        std::sort(run.begin(), run.end(), Comparator());
+        ref.insert(ref.end(), run.begin(), run.end());
 
-    for (auto& vec : in) {
-        seq.push_back(std::make_pair(vec.begin(), vec.end()));
+        data::File f(block_pool, 0, /* dia_id */ 0);
+        {
+            auto w = f.GetWriter();
+            for (const double& t : run) w.Put(t);
+        }
+        in.emplace_back(std::move(f));
     }
 
-    std::sort(ref.begin(), ref.end());
-    core::sequential_multiway_merge<true, false>(seq.begin(),
-                                                 seq.end(),
-                                                 output.begin(),
-                                                 total,
-                                                 std::less<size_t>());
-    for (size_t i = 0; i < total; ++i) {
-        ASSERT_EQ(ref[i], output[i]);
+    std::vector<data::File::ConsumeReader> seq;
+    for (size_t t = 0; t < in.size(); ++t)
+        seq.emplace_back(in[t].GetConsumeReader());
+
+    auto puller = core::make_multiway_merge_tree<double>(
+        seq.begin(), seq.end(), Comparator());
+
+    std::sort(ref.begin(), ref.end(), Comparator());
+
+    for (size_t i = 0; i < ref.size(); ++i) {
+        ASSERT_TRUE(puller.HasNext());
+        ASSERT_EQ(ref[i], puller.Next());
+    }
+    ASSERT_FALSE(puller.HasNext());
+}
+
+TEST_F(MultiwayMerge, ArithmeticLoserTreeInfinity) {
+    static_assert(
+        std::is_same<
+            core::LoserTreeTraits<false, double, std::less<double> >::Type,
+            core::LoserTreeArithmetic<false, double, std::less<double> >
+            >::value, "arithmetic loser tree is not selected");
+
+    const double inf = std::numeric_limits<double>::infinity();
+    TestInfinityKeys<std::less<double> >(block_pool_, inf);
+    TestInfinityKeys<std::greater<double> >(block_pool_, inf);
+}
+
+TEST_F(MultiwayMerge, LcpStringMergeFrontCoded) {
+    std::mt19937 gen(0);
+
+    // strings with long common prefixes, duplicates and prefixes of others
+    auto random_string = [&gen]() {
+                             std::string s = "http://www.example.com/";
+                             s.resize(gen() % s.size() + (gen() % 4 ? 40 : 0),
+                                      'x');
+                             size_t n = gen() % 6;
+                             for (size_t j = 0; j < n; ++j)
+                                 s += static_cast<char>('a' + gen() % 3);
+                             if (!s.empty() && gen() % 7 == 0)
+                                 s.back() = '\xf0';
+                             return s;
+                         };
+
+    for (size_t a : { 1, 3, 16, 17 }) {
+        std::vector<data::File> in;
+        std::vector<std::string> ref;
+
+        for (size_t i = 0; i < a; ++i) {
+            std::vector<std::string> tmp(i % 5 == 2 ? 0 : 100 + gen() % 1000);
+            for (std::string& t : tmp) t = random_string();
+            core::multikey_quicksort(tmp.begin(), tmp.end());
+            ASSERT_TRUE(std::is_sorted(tmp.begin(), tmp.end()));
+            ref.insert(ref.end(), tmp.begin(), tmp.end());
+
+            data::File f(block_pool_, 0, /* dia_id */ 0);
+            f.set_delta_coding(true);
+            {
+                auto w = f.GetWriter(/* block_size */ 256);
+                for (const std::string& t : tmp) w.Put(t);
+            }
+            in.emplace_back(std::move(f));
+        }
+
+        std::vector<data::File::ConsumeReader> seq;
+        for (size_t t = 0; t < in.size(); ++t)
+            seq.emplace_back(in[t].GetConsumeReader());
+
+        core::LcpStringMultiwayMergeTree<
+            std::vector<data::File::ConsumeReader>::iterator>
+        puller(seq.begin(), seq.end());
+
+        std::sort(ref.begin(), ref.end());
+
+        for (size_t i = 0; i < ref.size(); ++i) {
+            ASSERT_TRUE(puller.HasNext());
+            ASSERT_EQ(ref[i], puller.Next());
+        }
+        ASSERT_FALSE(puller.HasNext());
     }
 }
 
@@ -133,4 +243,47 @@ TEST_F(MultiwayMerge, GetMultiwayMergePuller) {
     ASSERT_FALSE(puller.HasNext());
 }
 
+TEST_F(MultiwayMerge, ParallelMergeFilesStable) {
+    std::mt19937 gen(0);
+    size_t a = 7;
+    size_t b = 20000;
+
+    // items (key, origin), merge by key with many equal keys
+    using Item = std::pair<size_t, size_t>;
+    auto cmp = [](const Item& x, const Item& y) { return x.first < y.first; };
+
+    std::vector<data::File> in;
+    std::vector<Item> ref;
+
+    for (size_t i = 0; i < a; ++i) {
+        std::vector<Item> tmp;
+        for (size_t j = 0; j < b * (i + 1) / a; ++j)
+            tmp.emplace_back(gen() % 100, i * b + j);
+        std::stable_sort(tmp.begin(), tmp.end(), cmp);
+        ref.insert(ref.end(), tmp.begin(), tmp.end());
+
+        data::File f(block_pool_, 0, /* dia_id */ 0);
+        {
+            auto w = f.GetWriter();
+            for (const Item& t : tmp) w.Put(t);
+        }
+        in.emplace_back(std::move(f));
+    }
+
+    std::stable_sort(ref.begin(), ref.end(), cmp);
+
+    data::File out(block_pool_, 0, /* dia_id */ 0);
+    core::parallel_multiway_merge_files<Item, /* Stable */ true>(
+        in.begin(), in.end(), out, cmp, /* num_threads */ 4, /* prefetch */ 1);
+
+    ASSERT_EQ(ref.size(), out.num_items());
+
+    auto reader = out.GetKeepReader();
+    for (size_t i = 0; i < ref.size(); ++i) {
+        ASSERT_TRUE(reader.HasNext());
+        ASSERT_EQ(ref[i], reader.Next<Item>());
+    }
+    ASSERT_FALSE(reader.HasNext());
+}
+
 /******************************************************************************/
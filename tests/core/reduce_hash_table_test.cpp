@@ -9,9 +9,12 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/common/fast_string.hpp>
 #include <thrill/core/reduce_bucket_hash_table.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_robin_hood_hash_table.hpp>
+#include <thrill/core/reduce_sort_table.hpp>
 
 #include <thrill/core/reduce_pre_stage.hpp>
 
@@ -19,6 +22,8 @@
 
 #include <algorithm>
 #include <functional>
+#include <map>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -138,4 +143,310 @@ TEST(ReduceHashTable, ProbingAddIntegers) {
         });
 }
 
+TEST(ReduceHashTable, RobinHoodAddIntegers) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructModulo<core::ReduceRobinHoodHashTable>(ctx);
+        });
+}
+
+TEST(ReduceHashTable, SortAddIntegers) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructModulo<core::ReduceSortTable>(ctx);
+        });
+}
+
+//! value whose reduction concatenates vectors, and which counts its copies
+struct CopyCountedItems
+{
+    std::vector<size_t> items;
+
+    static size_t copies;
+
+    CopyCountedItems() = default;
+    explicit CopyCountedItems(size_t v) : items(1, v) { }
+
+    CopyCountedItems(const CopyCountedItems& o) : items(o.items) { ++copies; }
+    CopyCountedItems(CopyCountedItems&&) noexcept = default;
+
+    CopyCountedItems& operator = (const CopyCountedItems& o) {
+        items = o.items, ++copies;
+        return *this;
+    }
+    CopyCountedItems& operator = (CopyCountedItems&&) noexcept = default;
+
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.PutVarint(items.size());
+        for (const size_t& i : items) ar.template PutRaw<size_t>(i);
+    }
+
+    template <typename Archive>
+    static CopyCountedItems ThrillDeserialize(Archive& ar) {
+        CopyCountedItems c;
+        c.items.resize(ar.GetVarint());
+        for (size_t& i : c.items) i = ar.template GetRaw<size_t>();
+        return c;
+    }
+};
+
+size_t CopyCountedItems::copies = 0;
+
+template <
+    template <
+        typename ValueType, typename Key, typename Value,
+        typename KeyExtractor, typename ReduceFunction, typename Emitter,
+        const bool VolatileKey,
+        typename ReduceConfig = core::DefaultReduceConfig,
+        typename IndexFunction = core::ReduceByHash<Key>,
+        typename EqualToFunction = std::equal_to<Key> >
+    class HashTable>
+void TestMoveConcatVectors(Context& ctx) {
+    static constexpr size_t test_size = 20000;
+    static constexpr size_t mod_size = 100;
+
+    using Pair = std::pair<size_t, CopyCountedItems>;
+
+    auto key_ex = [](const Pair& in) { return in.first; };
+
+    // takes the slot's value by value, into which it is moved, and appends
+    auto red_fn = [](CopyCountedItems a, const CopyCountedItems& b) {
+                      a.items.insert(a.items.end(),
+                                     b.items.begin(), b.items.end());
+                      return a;
+                  };
+
+    using Collector = TableCollector<Pair>;
+    Collector collector(7);
+
+    using Table = HashTable<
+              Pair, size_t, CopyCountedItems,
+              decltype(key_ex), decltype(red_fn), Collector,
+              /* VolatileKey */ true, MyReduceConfig>;
+
+    Table table(ctx, 0, key_ex, red_fn, collector,
+                /* num_partitions */ 7,
+                typename Table::ReduceConfig(),
+                /* immediate_flush */ true);
+    table.Initialize(/* limit_memory_bytes */ 16 * 1024 * 1024);
+
+    CopyCountedItems::copies = 0;
+
+    for (size_t i = 0; i < test_size; ++i)
+        table.Insert(Pair(i % mod_size, CopyCountedItems(i)));
+
+    // rvalue pairs are moved into the slots and through the reduce function
+    ASSERT_EQ(0u, CopyCountedItems::copies);
+
+    table.FlushAll();
+
+    size_t keys = 0, items = 0;
+    for (const auto& partition : collector) {
+        for (const Pair& p : partition) {
+            ++keys, items += p.second.items.size();
+            for (const size_t& v : p.second.items)
+                ASSERT_EQ(p.first, v % mod_size);
+        }
+    }
+    ASSERT_EQ(mod_size, keys);
+    ASSERT_EQ(test_size, items);
+}
+
+TEST(ReduceHashTable, MoveConcatVectors) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestMoveConcatVectors<core::ReduceBucketHashTable>(ctx);
+            TestMoveConcatVectors<core::ReduceOldProbingHashTable>(ctx);
+            TestMoveConcatVectors<core::ReduceProbingHashTable>(ctx);
+            TestMoveConcatVectors<core::ReduceRobinHoodHashTable>(ctx);
+            TestMoveConcatVectors<core::ReduceSortTable>(ctx);
+        });
+}
+
+//! value which counts its live instances
+struct LiveCounted
+{
+    size_t value = 0;
+
+    static size_t live;
+
+    LiveCounted() { ++live; }
+    explicit LiveCounted(size_t v) : value(v) { ++live; }
+    LiveCounted(const LiveCounted& o) : value(o.value) { ++live; }
+    LiveCounted& operator = (const LiveCounted&) = default;
+    ~LiveCounted() { --live; }
+
+    static constexpr bool thrill_is_fixed_size = true;
+    static constexpr size_t thrill_fixed_size = sizeof(size_t);
+
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.template PutRaw<size_t>(value);
+    }
+
+    template <typename Archive>
+    static LiveCounted ThrillDeserialize(Archive& ar) {
+        return LiveCounted(ar.template GetRaw<size_t>());
+    }
+};
+
+size_t LiveCounted::live = 0;
+
+TEST(ReduceHashTable, BucketDisposeNonEmpty) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t test_size = 20000;
+
+            using Pair = std::pair<size_t, LiveCounted>;
+
+            auto key_ex = [](const Pair& in) { return in.first; };
+
+            auto red_fn = [](const LiveCounted& a, const LiveCounted& b) {
+                              return LiveCounted(a.value + b.value);
+                          };
+
+            using Collector = TableCollector<Pair>;
+            Collector collector(4);
+
+            using Table = core::ReduceBucketHashTable<
+                      Pair, size_t, LiveCounted,
+                      decltype(key_ex), decltype(red_fn), Collector,
+                      /* VolatileKey */ true, core::DefaultReduceConfig,
+                      core::ReduceByHash<size_t> >;
+
+            LiveCounted::live = 0;
+            {
+                Table table(ctx, 0, key_ex, red_fn, collector,
+                            /* num_partitions */ 4);
+                table.Initialize(/* limit_memory_bytes */ 16 * 1024 * 1024);
+
+                for (size_t i = 0; i < test_size; ++i)
+                    table.Insert(Pair(i, LiveCounted(i)));
+
+                ASSERT_EQ(test_size, LiveCounted::live);
+
+                // dispose the block chains without flushing them
+                table.Dispose();
+                ASSERT_EQ(0u, LiveCounted::live);
+            }
+            ASSERT_EQ(0u, LiveCounted::live);
+            for (const auto& partition : collector)
+                ASSERT_EQ(0u, partition.size());
+        });
+}
+
+TEST(ReduceHashTable, RobinHoodHighFillRate) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t test_size = 200000;
+            static constexpr size_t mod_size = 20000;
+
+            auto key_ex = [](const MyStruct& in) {
+                              return in.key % mod_size;
+                          };
+
+            auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                              return MyStruct(in1.key, in1.value + in2.value);
+                          };
+
+            using Collector = TableCollector<std::pair<size_t, MyStruct> >;
+            Collector collector(4);
+
+            using Table = core::ReduceRobinHoodHashTable<
+                      MyStruct, size_t, MyStruct,
+                      decltype(key_ex), decltype(red_fn), Collector,
+                      /* VolatileKey */ false, core::DefaultReduceConfig,
+                      core::ReduceByHash<size_t> >;
+
+            // fill partitions almost completely, with short probe sequences,
+            // such that partitions are spilled due to both limits.
+            core::DefaultReduceConfig config;
+            config.limit_partition_fill_rate_ = 0.95;
+            config.max_probe_length_ = 8;
+
+            Table table(ctx, 0, key_ex, red_fn, collector,
+                        /* num_partitions */ 4, config,
+                        /* immediate_flush */ true);
+            table.Initialize(/* limit_memory_bytes */ 64 * 1024);
+            ASSERT_EQ(8u, table.max_probe_length());
+
+            for (size_t i = 0; i < test_size; ++i) {
+                table.Insert(MyStruct(i, 1));
+            }
+
+            table.FlushAll();
+
+            // items of a key may be emitted several times, sum them up.
+            std::map<size_t, size_t> result;
+            for (const auto& partition : collector) {
+                for (const auto& v : partition) {
+                    ASSERT_EQ(v.first, v.second.key % mod_size);
+                    result[v.first] += v.second.value;
+                }
+            }
+
+            ASSERT_EQ(mod_size, result.size());
+            for (const auto& r : result) {
+                ASSERT_EQ(test_size / mod_size, r.second);
+            }
+        });
+}
+
+TEST(ReduceHashTable, ProbingFastStringKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t test_size = 20000;
+            static constexpr size_t mod_size = 1000;
+
+            using Pair = std::pair<common::FastString, size_t>;
+
+            auto key_ex = [](const Pair& in) { return in.first; };
+            auto red_fn = [](const size_t& a, const size_t& b) {
+                              return a + b;
+                          };
+
+            using Collector = TableCollector<Pair>;
+            Collector collector(7);
+
+            using Table = core::ReduceProbingHashTable<
+                      Pair, common::FastString, size_t,
+                      decltype(key_ex), decltype(red_fn), Collector,
+                      /* VolatileKey */ true, core::DefaultReduceConfig,
+                      core::ReduceByHash<common::FastString>,
+                      std::equal_to<common::FastString> >;
+
+            Table table(ctx, 0, key_ex, red_fn, collector,
+                        /* num_partitions */ 7,
+                        typename Table::ReduceConfig(),
+                        /* immediate_flush */ true);
+            table.Initialize(/* limit_memory_bytes */ 64 * 1024);
+
+            // insert references to a buffer which is overwritten, hence the
+            // table must keep its own copy of the bytes.
+            std::string buffer;
+            for (size_t i = 0; i < test_size; ++i) {
+                buffer = "key" + std::to_string(i % mod_size);
+                table.Insert(Pair(common::FastString::Ref(
+                                      buffer.data(), buffer.size()), 1));
+                buffer.assign(buffer.size(), '#');
+            }
+            table.FlushAll();
+
+            std::map<std::string, size_t> counts;
+            for (const auto& partition : collector) {
+                for (const Pair& p : partition)
+                    counts[p.first.ToString()] += p.second;
+            }
+
+            ASSERT_EQ(mod_size, counts.size());
+            for (size_t i = 0; i < mod_size; ++i)
+                ASSERT_EQ(test_size / mod_size,
+                          counts["key" + std::to_string(i)]);
+        });
+}
+
 /******************************************************************************/
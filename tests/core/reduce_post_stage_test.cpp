@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -103,6 +104,20 @@ TEST(ReduceHashStage, OldProbingAddMyStructByHash) {
         });
 }
 
+TEST(ReduceHashStage, RobinHoodAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::ROBIN_HOOD>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, SortAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::SORT>(ctx);
+        });
+}
+
 TEST(ReduceHashStage, ProbingAddMyStructByHash) {
     api::RunLocalSameThread(
         [](Context& ctx) {
@@ -112,6 +127,182 @@ TEST(ReduceHashStage, ProbingAddMyStructByHash) {
 
 /******************************************************************************/
 
+//! reduce config which stores the key hashes in the tables
+template <core::ReduceTableImpl table_impl>
+class StoreHashReduceConfig : public core::DefaultReduceConfigSelect<table_impl>
+{
+public:
+    static constexpr bool store_hash_ = true;
+};
+
+static std::string MakeKey(size_t i, std::string*) {
+    return "key " + std::to_string(i);
+}
+
+static size_t MakeKey(size_t i, size_t*) {
+    // spread keys such that they are not the sentinel
+    return i * 7 + 1;
+}
+
+//! if expected_keys is non-zero, the stage is initialized with it, and the
+//! items are split into parts instead of filling the table first.
+template <typename ReduceConfig, typename Key>
+static void TestSpillByHash(Context& ctx, size_t expected_keys = 0) {
+    static constexpr size_t num_keys = 10000;
+    static constexpr size_t repeats = 4;
+
+    using Item = std::pair<Key, size_t>;
+
+    auto key_ex = [](const Item& in) { return in.first; };
+
+    auto red_fn = [](const Item& in1, const Item& in2) {
+                      return Item(in1.first, in1.second + in2.second);
+                  };
+
+    // collect all items
+    std::vector<Item> result;
+
+    auto emit_fn = [&result](const Item& in) {
+                       result.emplace_back(in);
+                   };
+
+    using Stage = core::ReduceByHashPostStage<
+              Item, Key, Item,
+              decltype(key_ex), decltype(red_fn), decltype(emit_fn), false,
+              ReduceConfig>;
+
+    Stage stage(ctx, 0, key_ex, red_fn, emit_fn);
+    // small enough to spill items and re-reduce them in subtables
+    if (expected_keys == 0) {
+        stage.Initialize(/* limit_memory_bytes */ 16 * 1024);
+    }
+    else {
+        stage.Initialize(/* limit_memory_bytes */ 16 * 1024, expected_keys);
+        ASSERT_LT(1u, stage.fan_out());
+    }
+
+    for (size_t r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < num_keys; ++i)
+            stage.Insert(Item(MakeKey(i, static_cast<Key*>(nullptr)), i));
+    }
+
+    stage.PushData(/* consume */ true);
+
+    // check result
+    std::sort(result.begin(), result.end(),
+              [](const Item& a, const Item& b) { return a.second < b.second; });
+
+    ASSERT_EQ(num_keys, result.size());
+
+    for (size_t i = 0; i < result.size(); ++i) {
+        ASSERT_EQ(MakeKey(i, static_cast<Key*>(nullptr)), result[i].first);
+        ASSERT_EQ(i * repeats, result[i].second);
+    }
+}
+
+TEST(ReduceHashStage, BucketSpillStringsByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<core::ReduceTableImpl::BUCKET>,
+                std::string>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, BucketSpillStringsByStoredHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                StoreHashReduceConfig<core::ReduceTableImpl::BUCKET>,
+                std::string>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, ProbingSpillStringsByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<core::ReduceTableImpl::PROBING>,
+                std::string>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, ProbingSpillStringsByStoredHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                StoreHashReduceConfig<core::ReduceTableImpl::PROBING>,
+                std::string>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, ProbingSpillIntegersByStoredHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                StoreHashReduceConfig<core::ReduceTableImpl::PROBING>,
+                size_t>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, OldProbingSpillIntegersByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<
+                    core::ReduceTableImpl::OLD_PROBING>,
+                size_t>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, RobinHoodSpillIntegersByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<
+                    core::ReduceTableImpl::ROBIN_HOOD>,
+                size_t>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, SortSpillIntegersByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<core::ReduceTableImpl::SORT>,
+                size_t>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, SortSpillStringsByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<core::ReduceTableImpl::SORT>,
+                std::string>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, ProbingSplitStringsByExpectedKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                core::DefaultReduceConfigSelect<core::ReduceTableImpl::PROBING>,
+                std::string>(ctx, /* expected_keys */ 10000);
+        });
+}
+
+TEST(ReduceHashStage, BucketSplitIntegersByStoredHashExpectedKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpillByHash<
+                StoreHashReduceConfig<core::ReduceTableImpl::BUCKET>,
+                size_t>(ctx, /* expected_keys */ 10000);
+        });
+}
+
+/******************************************************************************/
+
 TEST(ReduceHashStage, PostReduceByIndex) {
     static constexpr bool debug = false;
 
@@ -215,6 +406,20 @@ TEST(ReduceHashStage, OldProbingAddMyStructByIndex) {
         });
 }
 
+TEST(ReduceHashStage, RobinHoodAddMyStructByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndex<core::ReduceTableImpl::ROBIN_HOOD>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, SortAddMyStructByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndex<core::ReduceTableImpl::SORT>(ctx);
+        });
+}
+
 TEST(ReduceHashStage, ProbingAddMyStructByIndex) {
     api::RunLocalSameThread(
         [](Context& ctx) {
@@ -298,6 +503,20 @@ TEST(ReduceHashStage, OldProbingAddMyStructByIndexWithHoles) {
         });
 }
 
+TEST(ReduceHashStage, RobinHoodAddMyStructByIndexWithHoles) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndexWithHoles<core::ReduceTableImpl::ROBIN_HOOD>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, SortAddMyStructByIndexWithHoles) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndexWithHoles<core::ReduceTableImpl::SORT>(ctx);
+        });
+}
+
 TEST(ReduceHashStage, ProbingAddMyStructByIndexWithHoles) {
     api::RunLocalSameThread(
         [](Context& ctx) {
@@ -306,3 +525,128 @@ TEST(ReduceHashStage, ProbingAddMyStructByIndexWithHoles) {
 }
 
 /******************************************************************************/
+
+//! all items are inserted on worker 0 of a host with four workers, whose small
+//! table spills, hence the idle workers steal its spilled partitions.
+static constexpr size_t steal_mod_size = 20011;
+
+struct StealKeyExtractor {
+    size_t operator () (const MyStruct& in) const {
+        return in.key % steal_mod_size;
+    }
+};
+
+struct StealReduceFunction {
+    MyStruct operator () (const MyStruct& in1, const MyStruct& in2) const {
+        return MyStruct { in1.key, in1.value + in2.value };
+    }
+};
+
+using StealEmitter = std::function<void(const MyStruct&)>;
+
+//! stealing of partitions is off by default
+static core::DefaultReduceConfig StealConfig() {
+    core::DefaultReduceConfig config;
+    config.steal_partitions_ = true;
+    return config;
+}
+
+template <typename Stage>
+static void TestStealSpilledPartitions(
+    Context& ctx, Stage& stage, std::vector<MyStruct>& result, bool sorted) {
+
+    bool owner = ctx.local_worker_id() == 0;
+
+    stage.Initialize(/* limit_memory_bytes */ 64 * 1024);
+
+    if (owner) {
+        for (size_t i = 0; i < steal_mod_size * 4; ++i)
+            stage.Insert(MyStruct { i, i / steal_mod_size });
+    }
+
+    stage.PushData(/* consume */ true);
+
+    size_t num_stolen = ctx.net.AllReduce(stage.num_stolen());
+    ASSERT_LT(0u, num_stolen);
+
+    // the output of stolen partitions is handed back to worker 0.
+    if (!owner) {
+        ASSERT_EQ(0u, result.size());
+        return;
+    }
+
+    if (!sorted)
+        std::sort(result.begin(), result.end());
+
+    ASSERT_EQ(steal_mod_size, result.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+        ASSERT_EQ(i, result[i].key);
+        ASSERT_EQ(6u, result[i].value);
+    }
+}
+
+TEST(ReduceHashStage, StealSpilledPartitionsByHash) {
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+    api::RunLocalMock(
+        mem_config, 1, 4,
+        [](Context& ctx) {
+            std::vector<MyStruct> result;
+            core::ReduceByHashPostStage<
+                MyStruct, size_t, MyStruct,
+                StealKeyExtractor, StealReduceFunction, StealEmitter>
+            stage(ctx, 0, StealKeyExtractor(), StealReduceFunction(),
+                  [&result](const MyStruct& in) { result.push_back(in); },
+                  StealConfig());
+            TestStealSpilledPartitions(ctx, stage, result, false);
+        });
+}
+
+TEST(ReduceHashStage, NoStealingByDefault) {
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+    api::RunLocalMock(
+        mem_config, 1, 4,
+        [](Context& ctx) {
+            std::vector<MyStruct> result;
+            core::ReduceByHashPostStage<
+                MyStruct, size_t, MyStruct,
+                StealKeyExtractor, StealReduceFunction, StealEmitter>
+            stage(ctx, 0, StealKeyExtractor(), StealReduceFunction(),
+                  [&result](const MyStruct& in) { result.push_back(in); });
+
+            stage.Initialize(/* limit_memory_bytes */ 64 * 1024);
+            if (ctx.local_worker_id() == 0) {
+                for (size_t i = 0; i < steal_mod_size * 4; ++i)
+                    stage.Insert(MyStruct { i, i / steal_mod_size });
+            }
+            stage.PushData(/* consume */ true);
+
+            ASSERT_EQ(0u, stage.num_stolen());
+            ASSERT_EQ(ctx.local_worker_id() == 0 ? steal_mod_size : 0u,
+                      result.size());
+        });
+}
+
+TEST(ReduceHashStage, StealSpilledPartitionsByIndex) {
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+    api::RunLocalMock(
+        mem_config, 1, 4,
+        [](Context& ctx) {
+            // only worker 0 owns keys, the range of the others is empty.
+            size_t begin = ctx.local_worker_id() == 0 ? 0 : steal_mod_size;
+
+            std::vector<MyStruct> result;
+            core::ReduceByIndexPostStage<
+                MyStruct, size_t, MyStruct,
+                StealKeyExtractor, StealReduceFunction, StealEmitter>
+            stage(ctx, 0, StealKeyExtractor(), StealReduceFunction(),
+                  [&result](const MyStruct& in) { result.push_back(in); },
+                  StealConfig(),
+                  core::ReduceByIndex<size_t>(begin, steal_mod_size));
+            TestStealSpilledPartitions(ctx, stage, result, true);
+        });
+}
+
+/******************************************************************************/
@@ -121,6 +121,20 @@ TEST(ReducePreStage, OldProbingAddMyStructByHash) {
         });
 }
 
+TEST(ReducePreStage, RobinHoodAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::ROBIN_HOOD>(ctx);
+        });
+}
+
+TEST(ReducePreStage, SortAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::SORT>(ctx);
+        });
+}
+
 TEST(ReducePreStage, ProbingAddMyStructByHash) {
     api::RunLocalSameThread(
         [](Context& ctx) {
@@ -211,6 +225,20 @@ TEST(ReducePreStage, OldProbingAddMyStructByIndex) {
         });
 }
 
+TEST(ReducePreStage, RobinHoodAddMyStructByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndex<core::ReduceTableImpl::ROBIN_HOOD>(ctx);
+        });
+}
+
+TEST(ReducePreStage, SortAddMyStructByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndex<core::ReduceTableImpl::SORT>(ctx);
+        });
+}
+
 TEST(ReducePreStage, ProbingAddMyStructByIndex) {
     api::RunLocalSameThread(
         [](Context& ctx) {
@@ -218,4 +246,167 @@ TEST(ReducePreStage, ProbingAddMyStructByIndex) {
         });
 }
 
+TEST(ReducePreStage, PartitionsPerOutputByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t mod_size = 1000;
+            static constexpr size_t test_size = mod_size * 20;
+
+            auto key_ex = [](const MyStruct& in) {
+                              return in.key % mod_size;
+                          };
+
+            auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                              return MyStruct {
+                                         in1.key, in1.value + in2.value
+                              };
+                          };
+
+            const size_t num_outputs = 3;
+
+            std::vector<data::File> files;
+            for (size_t i = 0; i < num_outputs; ++i)
+                files.emplace_back(ctx.GetFile(nullptr));
+
+            std::vector<data::DynBlockWriter> emitters;
+            for (size_t i = 0; i < num_outputs; ++i)
+                emitters.emplace_back(files[i].GetDynWriter());
+
+            using Stage = core::ReducePreStage<
+                      MyStruct, size_t, MyStruct,
+                      decltype(key_ex), decltype(red_fn),
+                      /* VolatileKey */ false,
+                      MyReduceConfig<core::ReduceTableImpl::PROBING>,
+                      core::ReduceByIndex<size_t> >;
+
+            // small table such that partitions are spilled often
+            typename Stage::ReduceConfig config;
+            config.min_pre_partitions_ = 64;
+
+            Stage stage(ctx, 0, num_outputs, key_ex, red_fn, emitters, config,
+                        core::ReduceByIndex<size_t>(0, mod_size));
+            ASSERT_EQ(22u, stage.partitions_per_output());
+
+            stage.Initialize(/* limit_memory_bytes */ 16 * 1024);
+
+            for (size_t i = 0; i < test_size; ++i) {
+                stage.Insert(MyStruct { i, 1 });
+            }
+
+            stage.FlushAll();
+
+            // the key ranges of the outputs are consecutive and cover all keys
+            std::vector<size_t> count(mod_size, 0);
+            size_t range_begin = 0;
+
+            for (size_t i = 0; i < num_outputs; ++i) {
+                common::Range range = stage.key_range(i);
+                ASSERT_EQ(range_begin, range.begin);
+                range_begin = range.end;
+
+                data::File::Reader r = files[i].GetReader(/* consume */ true);
+                while (r.HasNext()) {
+                    size_t key = key_ex(r.Next<MyStruct>());
+                    ASSERT_TRUE(key >= range.begin && key < range.end);
+                    ++count[key];
+                }
+            }
+            ASSERT_EQ(mod_size, range_begin);
+
+            stage.CloseAll();
+
+            for (size_t i = 0; i < mod_size; ++i) {
+                ASSERT_EQ(test_size / mod_size, count[i]);
+            }
+        });
+}
+
+/******************************************************************************/
+
+template <core::ReduceTableImpl table_impl>
+static void TestBypassUniqueKeys(Context& ctx) {
+    static constexpr size_t mod_size = 601;
+    static constexpr size_t test_size = mod_size * 100;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key < test_size / 2 ? in.key : in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                                 in1.key, in1.value + in2.value
+                      };
+                  };
+
+    // collect all items
+    const size_t num_partitions = 13;
+
+    std::vector<data::File> files;
+    for (size_t i = 0; i < num_partitions; ++i)
+        files.emplace_back(ctx.GetFile(nullptr));
+
+    std::vector<data::DynBlockWriter> emitters;
+    for (size_t i = 0; i < num_partitions; ++i)
+        emitters.emplace_back(files[i].GetDynWriter());
+
+    // process items with stage
+    using Stage = core::ReducePreStage<
+              MyStruct, size_t, MyStruct,
+              decltype(key_ex), decltype(red_fn),
+              /* VolatileKey */ false,
+              MyReduceConfig<table_impl> >;
+
+    typename Stage::ReduceConfig config;
+    config.bypass_window_size_ = 1000;
+    config.bypass_windows_ = 4;
+
+    Stage stage(ctx, 0, num_partitions, key_ex, red_fn, emitters, config);
+
+    stage.Initialize(/* limit_memory_bytes */ 1024 * 1024);
+
+    // first half has unique keys, second half only mod_size distinct keys
+    for (size_t i = 0; i < test_size; ++i) {
+        stage.Insert(MyStruct { i, 1 });
+    }
+
+    // unique keys must be bypassed, later windows probe the table again.
+    ASSERT_GT(stage.num_bypassed(), 0u);
+    ASSERT_LT(stage.num_bypassed(), test_size / 2 + 5000);
+
+    stage.FlushAll();
+    stage.CloseAll();
+
+    // collect items, reduce them as the post stage would, and check result
+    std::vector<size_t> count(test_size / 2, 0);
+
+    for (size_t i = 0; i < num_partitions; ++i) {
+        data::File::Reader r = files[i].GetReader(/* consume */ true);
+        while (r.HasNext()) {
+            MyStruct m = r.Next<MyStruct>();
+            count[key_ex(m)] += m.value;
+        }
+    }
+
+    for (size_t i = 0; i < count.size(); ++i) {
+        if (i < mod_size)
+            ASSERT_EQ(1 + (test_size / 2) / mod_size, count[i]);
+        else
+            ASSERT_EQ(1u, count[i]);
+    }
+}
+
+TEST(ReducePreStage, BucketBypassUniqueKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestBypassUniqueKeys<core::ReduceTableImpl::BUCKET>(ctx);
+        });
+}
+
+TEST(ReducePreStage, ProbingBypassUniqueKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestBypassUniqueKeys<core::ReduceTableImpl::PROBING>(ctx);
+        });
+}
+
 /******************************************************************************/
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * tests/core/reduce_sharded_pre_stage_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/core/reduce_sharded_pre_stage.hpp>
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace thrill;
+
+struct MyStruct
+{
+    size_t key, value;
+};
+
+template <core::ReduceTableImpl table_impl>
+struct MyReduceConfig : public core::DefaultReduceConfig
+{
+    //! only for growing ProbingHashTable: items initially in a partition.
+    static constexpr size_t                initial_items_per_partition_ = 160000;
+
+    //! select the hash table in the reduce stage by enum
+    static constexpr core::ReduceTableImpl table_impl_ = table_impl;
+};
+
+template <core::ReduceTableImpl table_impl>
+static void TestShardedInsert(Context& ctx, size_t limit_memory_bytes,
+                              bool expect_unique) {
+    static constexpr size_t mod_size = 601;
+    static constexpr size_t test_size = mod_size * 100;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                                 in1.key, in1.value + in2.value
+                      };
+                  };
+
+    const size_t num_outputs = 5;
+
+    std::vector<data::File> files;
+    for (size_t i = 0; i < num_outputs; ++i)
+        files.emplace_back(ctx.GetFile(nullptr));
+
+    std::vector<data::DynBlockWriter> emitters;
+    for (size_t i = 0; i < num_outputs; ++i)
+        emitters.emplace_back(files[i].GetDynWriter());
+
+    using Stage = core::ReduceShardedPreStage<
+              MyStruct, size_t, MyStruct,
+              decltype(key_ex), decltype(red_fn),
+              /* VolatileKey */ false,
+              MyReduceConfig<table_impl> >;
+
+    Stage stage(ctx, 0, /* num_shards */ 4, num_outputs,
+                key_ex, red_fn, emitters);
+    ASSERT_EQ(4u, stage.num_shards());
+
+    stage.Initialize(limit_memory_bytes);
+
+    std::vector<MyStruct> items(test_size);
+    for (size_t i = 0; i < test_size; ++i)
+        items[i] = MyStruct { i, 1 };
+
+    common::WorkStealingPool pool(3);
+    stage.InsertParallel(pool, items.begin(), items.end());
+
+    stage.FlushAll();
+    stage.CloseAll();
+
+    // collect items and reduce them as the post stage would
+    std::vector<size_t> count(mod_size, 0), seen(mod_size, 0);
+
+    for (size_t i = 0; i < num_outputs; ++i) {
+        data::File::Reader r = files[i].GetReader(/* consume */ true);
+        while (r.HasNext()) {
+            MyStruct m = r.Next<MyStruct>();
+            count[key_ex(m)] += m.value;
+            ++seen[key_ex(m)];
+        }
+    }
+
+    for (size_t i = 0; i < mod_size; ++i) {
+        ASSERT_EQ(test_size / mod_size, count[i]);
+        if (expect_unique)
+            ASSERT_EQ(1u, seen[i]);
+    }
+}
+
+TEST(ReduceShardedPreStage, ProbingMergeShards) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestShardedInsert<core::ReduceTableImpl::PROBING>(
+                ctx, /* limit_memory_bytes */ 4 * 1024 * 1024,
+                /* expect_unique */ true);
+        });
+}
+
+TEST(ReduceShardedPreStage, BucketMergeShards) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestShardedInsert<core::ReduceTableImpl::BUCKET>(
+                ctx, /* limit_memory_bytes */ 4 * 1024 * 1024,
+                /* expect_unique */ true);
+        });
+}
+
+TEST(ReduceShardedPreStage, ProbingConcurrentSpills) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestShardedInsert<core::ReduceTableImpl::PROBING>(
+                ctx, /* limit_memory_bytes */ 16 * 1024,
+                /* expect_unique */ false);
+        });
+}
+
+/******************************************************************************/
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * tests/data/block_compression_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/data/block_compression.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace thrill;
+
+using data::Byte;
+
+static void TestRoundTrip(const std::vector<Byte>& input) {
+    std::vector<Byte> compressed(input.size() + input.size() / 255 + 16);
+    size_t csize = data::BlockCompress(
+        input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0u, csize);
+
+    std::vector<Byte> output(input.size());
+    ASSERT_TRUE(data::BlockDecompress(
+                    compressed.data(), csize, output.data(), output.size()));
+    ASSERT_EQ(input, output);
+}
+
+TEST(BlockCompression, RoundTripShortInputs) {
+    for (size_t size = 0; size < 64; ++size) {
+        std::vector<Byte> input(size);
+        for (size_t i = 0; i < size; ++i)
+            input[i] = static_cast<Byte>(i % 3);
+        TestRoundTrip(input);
+    }
+}
+
+TEST(BlockCompression, RoundTripRepetitive) {
+    std::vector<Byte> input(1024 * 1024);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<Byte>((i / 7) % 13);
+
+    std::vector<Byte> compressed(input.size());
+    size_t csize = data::BlockCompress(
+        input.data(), input.size(), compressed.data(), input.size() - 1);
+    ASSERT_NE(0u, csize);
+    ASSERT_LT(csize, input.size() / 10);
+
+    TestRoundTrip(input);
+}
+
+TEST(BlockCompression, RoundTripMixed) {
+    std::default_random_engine rng(123456);
+    std::vector<Byte> input;
+    while (input.size() < 256 * 1024) {
+        // append either random literals or a copy of previous data
+        size_t len = rng() % 300 + 1;
+        if (input.size() < 1000 || rng() % 2 == 0) {
+            for (size_t i = 0; i < len; ++i)
+                input.push_back(static_cast<Byte>(rng()));
+        }
+        else {
+            size_t offset = rng() % std::min<size_t>(input.size(), 70000) + 1;
+            for (size_t i = 0; i < len; ++i)
+                input.push_back(input[input.size() - offset]);
+        }
+    }
+    TestRoundTrip(input);
+}
+
+TEST(BlockCompression, RejectIncompressible) {
+    std::default_random_engine rng(123456);
+    std::vector<Byte> input(64 * 1024);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<Byte>(rng());
+
+    std::vector<Byte> compressed(input.size());
+    ASSERT_EQ(0u, data::BlockCompress(
+                  input.data(), input.size(), compressed.data(), input.size() - 1));
+
+    TestRoundTrip(input);
+}
+
+TEST(BlockCompression, DetectCorruptData) {
+    std::vector<Byte> input(4096, 42);
+    std::vector<Byte> compressed(input.size());
+    size_t csize = data::BlockCompress(
+        input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0u, csize);
+
+    // wrong output size and truncated input are detected
+    std::vector<Byte> output(input.size() + 1);
+    ASSERT_FALSE(data::BlockDecompress(
+                     compressed.data(), csize, output.data(), output.size()));
+    ASSERT_FALSE(data::BlockDecompress(
+                     compressed.data(), csize - 1, output.data(), input.size()));
+}
+
+/******************************************************************************/
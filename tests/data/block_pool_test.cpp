@@ -9,10 +9,18 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <thrill/common/json_logger.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
+#include <thrill/data/file.hpp>
+#include <thrill/io/file_mapping.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace thrill;
 
@@ -82,6 +90,128 @@ TEST_F(BlockPoolTest, PinnedBlock) {
     ASSERT_EQ(0u, bbp->pin_count(0));
 }
 
+TEST(BlockPool, ConcurrentPinsOfWorkers) {
+    static constexpr size_t num_workers = 4;
+    data::BlockPool block_pool(num_workers);
+
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+
+    // each worker repeatedly pins the Block and copies its pins, which races
+    // the last unpin of one worker against the pins of the others.
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < num_workers; ++w) {
+        threads.emplace_back(
+            [&unpinned_block, w]() {
+                for (size_t i = 0; i < 2000; ++i) {
+                    data::PinnedBlock pinned = unpinned_block.PinWait(w);
+                    data::PinnedBlock copy = pinned;
+                    ASSERT_LE(2u, copy.byte_block()->pin_count(w));
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    ASSERT_EQ(1u, block_pool.total_blocks());
+    ASSERT_EQ(0u, block_pool.pinned_blocks());
+    ASSERT_EQ(1u, block_pool.unpinned_blocks());
+}
+
+//! allocate unpinned Blocks with the given eviction hints, evict them one by
+//! one, and return the order in which they were evicted.
+static std::vector<size_t> EvictionOrder(
+    data::EvictionPolicy policy, const std::vector<data::EvictionHint>& hints) {
+    data::BlockPool block_pool;
+    block_pool.set_eviction_policy(policy);
+
+    std::vector<data::Block> blocks;
+    for (const data::EvictionHint& hint : hints) {
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(4096, 0);
+        block->set_eviction_hint(hint);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    std::vector<size_t> order;
+    while (block_pool.unpinned_blocks() != 0) {
+        io::RequestPtr req = block_pool.EvictBlockLRU();
+        if (req) req->wait();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!blocks[i].byte_block()->in_memory() &&
+                std::find(order.begin(), order.end(), i) == order.end())
+                order.push_back(i);
+        }
+    }
+    return order;
+}
+
+TEST(BlockPool, EvictionPolicyHint) {
+    using data::EvictionHint;
+    std::vector<size_t> order = EvictionOrder(
+        data::EvictionPolicy::Hint,
+        { EvictionHint::ReadAgainSoon, EvictionHint::None,
+          EvictionHint::Sequential, EvictionHint::DeadAfterRead,
+          EvictionHint::Sequential, EvictionHint::None });
+
+    // dead blocks first, then sequential ones newest first, then by LRU
+    ASSERT_EQ(std::vector<size_t>({ 3, 4, 2, 1, 5, 0 }), order);
+}
+
+TEST(BlockPool, EvictionPolicyLRU) {
+    using data::EvictionHint;
+    std::vector<size_t> order = EvictionOrder(
+        data::EvictionPolicy::LRU,
+        { EvictionHint::ReadAgainSoon, EvictionHint::None,
+          EvictionHint::DeadAfterRead });
+
+    // hints are ignored
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2 }), order);
+}
+
+TEST(BlockPool, EvictionHintPinned) {
+    using data::EvictionHint;
+
+    // pinned blocks are evicted last under all policies
+    ASSERT_EQ(std::vector<size_t>({ 1, 2, 0 }),
+              EvictionOrder(data::EvictionPolicy::LRU,
+                            { EvictionHint::Pinned, EvictionHint::None,
+                              EvictionHint::ReadAgainSoon }));
+    ASSERT_EQ(std::vector<size_t>({ 2, 0, 1 }),
+              EvictionOrder(data::EvictionPolicy::Hint,
+                            { EvictionHint::ReadAgainSoon, EvictionHint::Pinned,
+                              EvictionHint::DeadAfterRead }));
+    ASSERT_EQ(std::vector<size_t>({ 1, 0 }),
+              EvictionOrder(data::EvictionPolicy::TwoQueue,
+                            { EvictionHint::Pinned, EvictionHint::None }));
+}
+
+TEST_F(BlockPoolTest, EvictionPolicyTwoQueue) {
+    block_pool_.set_eviction_policy(data::EvictionPolicy::TwoQueue);
+
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < 8; ++i) {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+    // touch the first block again, which moves it to the frequent queue.
+    blocks[0].PinWait(0);
+
+    // the seven blocks used once are evicted before the reused one.
+    for (size_t i = 0; i < 7; ++i) {
+        io::RequestPtr req = block_pool_.EvictBlockLRU();
+        if (req) req->wait();
+        ASSERT_TRUE(blocks[0].byte_block()->in_memory());
+    }
+    io::RequestPtr req = block_pool_.EvictBlockLRU();
+    if (req) req->wait();
+    ASSERT_FALSE(blocks[0].byte_block()->in_memory());
+}
+
 TEST_F(BlockPoolTest, EvictBlock) {
     data::Block unpinned_block;
     {
@@ -109,4 +239,333 @@ TEST_F(BlockPoolTest, EvictBlock) {
     ASSERT_EQ(0u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
 }
 
+TEST_F(BlockPoolTest, EvictCompressedBlock) {
+    static constexpr size_t size = 64 * 1024;
+    block_pool_.set_block_compression(true);
+
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(size, 0);
+        for (size_t i = 0; i < size; ++i)
+            block->data()[i] = static_cast<data::Byte>(i / 100);
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+    // evict block, which is written compressed
+    block_pool_.EvictBlock(unpinned_block.byte_block().get());
+    ASSERT_EQ(0u, block_pool_.unpinned_blocks());
+    ASSERT_EQ(1u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
+    // swap block back in by pinning it and check contents.
+    data::PinnedBlock pinned = unpinned_block.PinWait(0);
+    ASSERT_EQ(1u, block_pool_.pinned_blocks());
+    ASSERT_EQ(0u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
+    for (size_t i = 0; i < size; ++i)
+        ASSERT_EQ(static_cast<data::Byte>(i / 100), pinned.data_begin()[i]);
+}
+
+TEST(BlockPool, ConcurrentCompressedEvictAndPin) {
+    static constexpr size_t num_workers = 2;
+    static constexpr size_t num_blocks = 16;
+    static constexpr size_t size = 64 * 1024;
+    data::BlockPool block_pool(num_workers);
+    block_pool.set_block_compression(true);
+
+    std::vector<data::Block> blocks;
+    for (size_t b = 0; b < num_blocks; ++b) {
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(size, 0);
+        for (size_t i = 0; i < size; ++i)
+            block->data()[i] = static_cast<data::Byte>(b + i / 100);
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    // blocks are compressed without holding the BlockPool's mutex, while the
+    // workers pin them, which cancels their writes or reads them back.
+    std::vector<std::thread> threads;
+    threads.emplace_back(
+        [&block_pool]() {
+            for (size_t i = 0; i < 500; ++i) block_pool.EvictBlockLRU();
+        });
+    for (size_t w = 0; w < num_workers; ++w) {
+        threads.emplace_back(
+            [&blocks, w]() {
+                for (size_t i = 0; i < 500; ++i) {
+                    size_t b = (i * 7 + w) % num_blocks;
+                    data::PinnedBlock pinned = blocks[b].PinWait(w);
+                    ASSERT_EQ(static_cast<data::Byte>(b + (size - 1) / 100),
+                              pinned.data_begin()[size - 1]);
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    for (size_t b = 0; b < num_blocks; ++b) {
+        data::PinnedBlock pinned = blocks[b].PinWait(0);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(static_cast<data::Byte>(b + i / 100),
+                      pinned.data_begin()[i]);
+        }
+    }
+    ASSERT_EQ(num_blocks, block_pool.total_blocks());
+    ASSERT_EQ(0u, block_pool.pinned_blocks());
+}
+
+TEST_F(BlockPoolTest, AttributeMemoryToDIA) {
+    const size_t dia_id = 42;
+    data::File file(block_pool_, 0, dia_id);
+    {
+        data::File::Writer fw = file.GetWriter(4096);
+        for (size_t i = 0; i < 2048; ++i)
+            fw.Put<size_t>(i);
+    }
+    const size_t bytes = file.num_blocks() * 4096;
+    ASSERT_LT(1u, file.num_blocks());
+    ASSERT_EQ(dia_id, file.block(0).byte_block()->dia_id());
+
+    data::BlockPool::DIAMemory mem = block_pool_.dia_memory(dia_id);
+    ASSERT_EQ(bytes, mem.ram_bytes);
+    ASSERT_EQ(bytes, mem.peak_ram_bytes);
+
+    // reserved memory is attributed, too.
+    block_pool_.RequestInternalMemory(1000, dia_id);
+    block_pool_.ReleaseInternalMemory(1000, dia_id);
+    mem = block_pool_.dia_memory(dia_id);
+    ASSERT_EQ(bytes, mem.ram_bytes);
+    ASSERT_EQ(bytes + 1000, mem.peak_ram_bytes);
+
+    // evict a block and wait for the write.
+    data::Block block = file.block(0);
+    block_pool_.EvictBlock(block.byte_block().get());
+    while (block_pool_.writing_blocks() != 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    mem = block_pool_.dia_memory(dia_id);
+    ASSERT_EQ(bytes - 4096, mem.ram_bytes);
+    ASSERT_EQ(4096u, mem.evicted_bytes);
+    ASSERT_EQ(0u, mem.read_bytes);
+
+    // read it back by pinning it.
+    {
+        data::PinnedBlock pinned = block.PinWait(0);
+        mem = block_pool_.dia_memory(dia_id);
+        ASSERT_EQ(bytes, mem.ram_bytes);
+        ASSERT_EQ(4096u, mem.read_bytes);
+    }
+
+    block = data::Block();
+    file.Clear();
+    mem = block_pool_.TakeDIAMemory(dia_id);
+    ASSERT_EQ(0u, mem.ram_bytes);
+    ASSERT_EQ(bytes + 1000, mem.peak_ram_bytes);
+    ASSERT_EQ(0u, block_pool_.dia_memory(dia_id).peak_ram_bytes);
+}
+
+TEST_F(BlockPoolTest, PrefetchFile) {
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    {
+        data::File::Writer fw = file.GetWriter(4096);
+        for (size_t i = 0; i < 2048; ++i)
+            fw.Put<size_t>(i);
+    }
+    const size_t num_blocks = file.num_blocks();
+
+    // evict all blocks and wait for the writes.
+    for (size_t i = 0; i < num_blocks; ++i)
+        block_pool_.EvictBlock(file.block(i).byte_block().get());
+    while (block_pool_.writing_blocks() != 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_EQ(num_blocks, block_pool_.swapped_blocks());
+
+    // prefetch the first two blocks, and then all others.
+    ASSERT_EQ(2u, file.Prefetch(2));
+    ASSERT_EQ(num_blocks - 2, file.Prefetch());
+    // the pins are released after the reads complete.
+    while (block_pool_.reading_blocks() != 0 ||
+           block_pool_.pinned_blocks() != 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // all blocks are back in RAM, but unpinned.
+    ASSERT_EQ(0u, block_pool_.swapped_blocks());
+    ASSERT_EQ(num_blocks, block_pool_.unpinned_blocks());
+    ASSERT_EQ(0u, file.Prefetch());
+
+    // check the data
+    data::File::Reader fr = file.GetReader(/* consume */ false);
+    for (size_t i = 0; i < 2048; ++i)
+        ASSERT_EQ(i, fr.Next<size_t>());
+}
+
+TEST_F(BlockPoolTest, ReadAheadScheduler) {
+    static constexpr size_t size = 4096;
+    static constexpr size_t num_blocks = 16;
+    block_pool_.set_read_ahead_depth(1);
+
+    std::vector<data::Block> blocks;
+    for (size_t b = 0; b < num_blocks; ++b) {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(size, 0);
+        for (size_t i = 0; i < size; ++i)
+            block->data()[i] = static_cast<data::Byte>(b + i);
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+    for (data::Block& b : blocks)
+        block_pool_.EvictBlock(b.byte_block().get());
+    // wait for all writes to finish
+    while (io::RequestPtr req = block_pool_.GetAnyWriting())
+        req->wait();
+    ASSERT_EQ(num_blocks, block_pool_.swapped_blocks());
+
+    // request all Blocks with deadlines in reverse order, then wait for them
+    // in order, which issues most of the queued reads early.
+    auto now = std::chrono::steady_clock::now();
+    std::vector<data::PinRequestPtr> requests;
+    for (size_t b = 0; b < num_blocks; ++b) {
+        requests.emplace_back(
+            blocks[b].PinReadAhead(
+                0, now + std::chrono::seconds(num_blocks - b)));
+    }
+    for (size_t b = 0; b < num_blocks; ++b) {
+        data::PinnedBlock pinned = requests[b]->Wait();
+        for (size_t i = 0; i < size; ++i)
+            ASSERT_EQ(static_cast<data::Byte>(b + i), pinned.data_begin()[i]);
+    }
+    ASSERT_EQ(0u, block_pool_.reading_blocks());
+}
+
+TEST(BlockPool, MemoryPressure) {
+    // soft limit of two blocks, all blocks stay pinned
+    data::BlockPool block_pool(2 * 4096, 16 * 4096, nullptr, nullptr, 1);
+
+    data::MemoryPressure pressure(block_pool);
+
+    std::vector<data::PinnedByteBlockPtr> blocks;
+    blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+    blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+    ASSERT_FALSE(pressure.requested());
+
+    // no unpinned blocks can be evicted, hence the handlers are asked
+    blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+    ASSERT_TRUE(pressure.requested());
+    ASSERT_EQ(4096u, pressure.Take());
+    ASSERT_FALSE(pressure.requested());
+
+    blocks.clear();
+    blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+    ASSERT_FALSE(pressure.requested());
+}
+
+TEST(BlockPool, MemoryRelief) {
+    // soft limit of two blocks, all blocks stay pinned
+    data::BlockPool block_pool(2 * 4096, 16 * 4096, nullptr, nullptr, 1);
+
+    size_t reliefs = 0;
+    size_t id = block_pool.AddReliefHandler([&reliefs]() { ++reliefs; });
+
+    std::vector<data::PinnedByteBlockPtr> blocks;
+    for (size_t i = 0; i < 4; ++i)
+        blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+
+    // still above the soft limit
+    blocks.pop_back();
+    ASSERT_EQ(0u, reliefs);
+
+    // back at the soft limit, and then below it without crossing again
+    blocks.pop_back();
+    ASSERT_EQ(1u, reliefs);
+    blocks.pop_back();
+    ASSERT_EQ(1u, reliefs);
+
+    block_pool.RemoveReliefHandler(id);
+    blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+    blocks.emplace_back(block_pool.AllocateByteBlock(4096, 0));
+    blocks.clear();
+    ASSERT_EQ(1u, reliefs);
+}
+
+TEST(BlockPool, LogEvictAndRead) {
+    std::vector<std::string> lines;
+    {
+        // the tap collects the lines, which are all written when the logger
+        // is destroyed.
+        common::JsonLogger logger(
+            std::string(),
+            [&lines](const std::string& line) { lines.push_back(line); });
+        data::BlockPool block_pool(0, 0, &logger, nullptr, 1);
+
+        data::PinnedByteBlockPtr bytes = block_pool.AllocateByteBlock(4096, 0);
+        std::fill(bytes->data(), bytes->data() + 4096, 42);
+        data::Block block =
+            data::PinnedBlock(std::move(bytes), 0, 4096, 0, 0, false).ToBlock();
+
+        io::RequestPtr req = block_pool.EvictBlockLRU();
+        ASSERT_TRUE(req.valid());
+        req->wait();
+        ASSERT_FALSE(block.byte_block()->in_memory());
+
+        data::PinnedBlock pinned = block.PinWait(0);
+        ASSERT_EQ(42, pinned.data_begin()[4095]);
+    }
+
+    size_t evicts = 0, reads = 0;
+    for (const std::string& line : lines) {
+        bool evict = line.find("\"event\":\"evict\"") != std::string::npos;
+        bool read = line.find("\"event\":\"read\"") != std::string::npos;
+        if (!evict && !read) continue;
+
+        ASSERT_NE(std::string::npos, line.find("\"bytes\":4096")) << line;
+        ASSERT_NE(std::string::npos, line.find("\"duration\":")) << line;
+        if (read) {
+            ASSERT_NE(std::string::npos,
+                      line.find("\"read_ahead\":false")) << line;
+        }
+        evicts += evict, reads += read;
+    }
+    ASSERT_EQ(1u, evicts);
+    ASSERT_EQ(1u, reads);
+}
+
+TEST_F(BlockPoolTest, MapMemoryBlock) {
+    if (!io::FileMapping::supported()) return;
+
+    std::string path = "block_pool_test_map.bin";
+    std::vector<char> content(3 * 4096);
+    for (size_t i = 0; i < content.size(); ++i)
+        content[i] = static_cast<char>(i * 7);
+
+    FILE* f = fopen(path.c_str(), "wb");
+    ASSERT_TRUE(f != nullptr);
+    ASSERT_EQ(content.size(), fwrite(content.data(), 1, content.size(), f));
+    fclose(f);
+
+    {
+        // map the file from an unaligned offset
+        io::FileMappingPtr mapping =
+            common::MakeCounting<io::FileMapping>(path, 100, 8000);
+        ASSERT_EQ(8000u, mapping->size());
+
+        data::Block block(
+            block_pool_.MapMemoryBlock(mapping, 1000, 4000),
+            0, 4000, 0, 0, false);
+        ASSERT_TRUE(block.byte_block()->is_mapped());
+        ASSERT_EQ(1u, block_pool_.total_blocks());
+        ASSERT_EQ(4000u, block_pool_.total_bytes());
+
+        data::PinnedBlock pinned = block.PinWait(0);
+        for (size_t i = 0; i < 4000; ++i) {
+            ASSERT_EQ(static_cast<data::Byte>(content[1100 + i]),
+                      pinned.data_begin()[i]);
+        }
+        ASSERT_EQ(1u, block_pool_.pinned_blocks());
+
+        // mapped Blocks are never queued for eviction
+        pinned.Reset();
+        ASSERT_EQ(0u, block_pool_.unpinned_blocks());
+        ASSERT_EQ(4000u, block_pool_.total_bytes());
+    }
+    ASSERT_EQ(0u, block_pool_.total_blocks());
+    ASSERT_EQ(0u, block_pool_.total_bytes());
+
+    remove(path.c_str());
+}
+
 /******************************************************************************/
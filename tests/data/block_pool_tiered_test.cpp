@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * tests/data/block_pool_tiered_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_pool.hpp>
+#include <thrill/io/block_manager.hpp>
+#include <thrill/io/config_file.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace thrill;
+
+static constexpr size_t block_size = 1024 * 1024;
+
+//! the io::Config must be set up before the BlockManager is created, hence this
+//! test runs in its own binary.
+static bool SetupTieredDisks() {
+    static bool done = false;
+    if (done) return true;
+    done = true;
+
+    io::Config* config = io::Config::GetInstance();
+
+    // add the flash disk first to check that it is ordered after the regular
+    io::DiskConfig flash("/tmp/thrill-tiered-flash.tmp", 4 * block_size,
+                         "memory autogrow=no");
+    flash.flash = true;
+    config->add_disk(flash);
+
+    config->add_disk(
+        io::DiskConfig("/tmp/thrill-tiered-disk.tmp", 4 * block_size,
+                       "memory"));
+    return true;
+}
+
+struct BlockPoolTiered : public ::testing::Test {
+    BlockPoolTiered() {
+        block_pool_.set_block_compression(false);
+    }
+
+    //! must be initialized before the BlockPool
+    bool disks_ = SetupTieredDisks();
+
+    data::BlockPool block_pool_ { 0, 0, nullptr, nullptr, 1 };
+
+    //! allocate and fill a block and release its pin
+    data::Block NewBlock(size_t i) {
+        data::PinnedByteBlockPtr bb =
+            block_pool_.AllocateByteBlock(block_size, 0);
+        std::fill(bb->data(), bb->data() + block_size,
+                  static_cast<data::Byte>(i));
+        return data::PinnedBlock(std::move(bb), 0, block_size, 0, 0, false)
+               .ToBlock();
+    }
+
+    void WaitWriting() {
+        while (io::RequestPtr req = block_pool_.GetAnyWriting())
+            req->wait();
+    }
+
+    void CheckBlock(const data::Block& block, size_t i) {
+        data::PinnedBlock pb = block.PinWait(0);
+        ASSERT_EQ(block_size, pb.size());
+        for (const data::Byte* p = pb.data_begin(); p != pb.data_end(); ++p)
+            ASSERT_EQ(static_cast<data::Byte>(i), *p);
+    }
+};
+
+TEST_F(BlockPoolTiered, TierRanges) {
+    io::BlockManager* bm = io::BlockManager::GetInstance();
+
+    ASSERT_TRUE(bm->tiered());
+    ASSERT_EQ(std::make_pair(size_t(1), size_t(2)), bm->tier_range(0));
+    ASSERT_EQ(std::make_pair(size_t(0), size_t(1)), bm->tier_range(1));
+    ASSERT_EQ(1u, bm->disk_tier(0));
+    ASSERT_EQ(0u, bm->disk_tier(1));
+
+    ASSERT_TRUE(bm->has_space(1, 2, 4 * block_size));
+    ASSERT_FALSE(bm->has_space(1, 2, 5 * block_size));
+    // the regular disk grows
+    ASSERT_TRUE(bm->has_space(0, 1, 5 * block_size));
+}
+
+TEST_F(BlockPoolTiered, SpillOverflowsToSlowTier) {
+    static constexpr size_t num_blocks = 8;
+
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        blocks.emplace_back(NewBlock(i));
+        block_pool_.EvictBlock(blocks.back().byte_block().get());
+        WaitWriting();
+    }
+
+    // the flash disk holds four blocks, the rest went to the regular disk
+    ASSERT_EQ(4u, block_pool_.swapped_blocks(0));
+    ASSERT_EQ(4u * block_size, block_pool_.swapped_bytes(0));
+    ASSERT_EQ(num_blocks - 4, block_pool_.swapped_blocks(1));
+    ASSERT_EQ(num_blocks, block_pool_.swapped_blocks());
+
+    for (size_t i = 0; i < num_blocks; ++i)
+        CheckBlock(blocks[i], i);
+}
+
+TEST_F(BlockPoolTiered, DemoteColdBlocks) {
+    static constexpr size_t num_blocks = 4;
+
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        blocks.emplace_back(NewBlock(i));
+        block_pool_.EvictBlock(blocks.back().byte_block().get());
+    }
+    WaitWriting();
+    ASSERT_EQ(num_blocks, block_pool_.swapped_blocks(0));
+
+    // demote all blocks immediately, completion is asynchronous
+    block_pool_.set_demotion_age(std::chrono::steady_clock::duration(0));
+    for (size_t r = 0; r < 1000 && block_pool_.demoted_blocks() < num_blocks;
+         ++r) {
+        block_pool_.RunTask(std::chrono::steady_clock::now());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(num_blocks, block_pool_.demoted_blocks());
+    ASSERT_EQ(0u, block_pool_.swapped_blocks(0));
+    ASSERT_EQ(num_blocks, block_pool_.swapped_blocks(1));
+
+    // the fast tier is free again
+    io::BlockManager* bm = io::BlockManager::GetInstance();
+    ASSERT_TRUE(bm->has_space(1, 2, 4 * block_size));
+
+    for (size_t i = 0; i < num_blocks; ++i)
+        CheckBlock(blocks[i], i);
+}
+
+/******************************************************************************/
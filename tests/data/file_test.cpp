@@ -12,6 +12,7 @@
 #include <thrill/common/string.hpp>
 #include <thrill/data/block_queue.hpp>
 #include <thrill/data/file.hpp>
+#include <thrill/data/file_index.hpp>
 
 #include <algorithm>
 #include <functional>
@@ -247,6 +248,90 @@ TEST_F(File, SerializeSomeItemsConsumeReader) {
     ASSERT_EQ(0u, file.num_items());
 }
 
+TEST_F(File, DeltaCodedIntegers) {
+    static constexpr size_t size = 5000;
+
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    file.set_delta_coding(true);
+
+    // put increasing large integers, followed by decreasing negative integers
+    {
+        // construct File with very small blocks for testing
+        data::File::Writer fw = file.GetWriter(1024);
+        for (size_t i = 0; i < size; ++i)
+            fw.Put<uint64_t>((uint64_t(1) << 60) + 3 * i);
+        for (size_t i = 0; i < size; ++i)
+            fw.Put<int>(-static_cast<int>(i));
+    }
+    ASSERT_EQ(2 * size, file.num_items());
+    if (!common::g_self_verify) {
+        // most deltas are encoded in a single byte
+        ASSERT_GT(size * (sizeof(uint64_t) + sizeof(int)) / 4,
+                  file.size_bytes());
+    }
+
+    // read items back twice, once keeping and once consuming the File.
+    for (bool consume : { false, true }) {
+        data::File::Reader fr = file.GetReader(consume);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_TRUE(fr.HasNext());
+            ASSERT_EQ((uint64_t(1) << 60) + 3 * i, fr.Next<uint64_t>());
+        }
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_TRUE(fr.HasNext());
+            ASSERT_EQ(-static_cast<int>(i), fr.Next<int>());
+        }
+        ASSERT_TRUE(!fr.HasNext());
+    }
+    ASSERT_TRUE(file.empty());
+}
+
+TEST_F(File, PutManyNextMany) {
+    struct MyStruct {
+        size_t a;
+        int    b;
+    };
+    static constexpr size_t size = 5000;
+
+    std::vector<MyStruct> items(size);
+    for (size_t i = 0; i < size; ++i)
+        items[i] = MyStruct { i, -static_cast<int>(i) };
+
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    {
+        // construct File with very small blocks for testing
+        data::File::Writer fw = file.GetWriter(100);
+        fw.PutMany(items.data(), size / 2);
+        fw.Put<MyStruct>(items[size / 2]);
+        fw.PutMany(items.data() + size / 2 + 1, size - size / 2 - 1);
+    }
+    ASSERT_EQ(size, file.num_items());
+
+    // read items in batches, the last one is incomplete.
+    {
+        data::File::KeepReader fr = file.GetKeepReader();
+        std::vector<MyStruct> out(size / 3 + 1);
+        size_t pos = 0;
+        while (size_t n = fr.NextMany(out.data(), out.size())) {
+            for (size_t i = 0; i < n; ++i, ++pos) {
+                ASSERT_EQ(pos, out[i].a);
+                ASSERT_EQ(-static_cast<int>(pos), out[i].b);
+            }
+        }
+        ASSERT_EQ(size, pos);
+    }
+
+    // items can also be read one at a time
+    {
+        data::File::KeepReader fr = file.GetKeepReader();
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_TRUE(fr.HasNext());
+            ASSERT_EQ(i, fr.Next<MyStruct>().a);
+        }
+        ASSERT_TRUE(!fr.HasNext());
+    }
+}
+
 TEST_F(File, RandomGetIndexOf) {
     static constexpr size_t size = 500;
 
@@ -273,6 +358,94 @@ TEST_F(File, RandomGetIndexOf) {
     }
 }
 
+TEST_F(File, GetItemsAtFixedAndVariableSize) {
+    static constexpr size_t size = 500;
+
+    std::minstd_rand0 rng(0);
+
+    // fixed-size items spanning the small Blocks
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    data::File::Writer fw = file.GetWriter(53);
+    for (size_t i = 0; i < size; i++) {
+        fw.Put(i);
+    }
+    fw.Close();
+
+    // variable-size items
+    data::File sfile(block_pool_, 0, /* dia_id */ 0);
+    data::File::Writer sfw = sfile.GetWriter(53);
+    for (size_t i = 0; i < size; i++) {
+        sfw.Put(std::to_string(i));
+    }
+    sfw.Close();
+
+    for (size_t i = 0; i < size; i++) {
+        ASSERT_EQ(i, file.GetItemAt<size_t>(i));
+        ASSERT_EQ(std::to_string(i), sfile.GetItemAt<std::string>(i));
+    }
+
+    // sorted indices with repetitions
+    std::vector<size_t> indices(200);
+    for (size_t& i : indices) i = rng() % size;
+    indices.push_back(0);
+    indices.push_back(size - 1);
+    indices.push_back(size - 1);
+    std::sort(indices.begin(), indices.end());
+
+    std::vector<size_t> items = file.GetItemsAt<size_t>(indices);
+    std::vector<std::string> sitems = sfile.GetItemsAt<std::string>(indices);
+
+    ASSERT_EQ(indices.size(), items.size());
+    ASSERT_EQ(indices.size(), sitems.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        ASSERT_EQ(indices[i], items[i]);
+        ASSERT_EQ(std::to_string(indices[i]), sitems[i]);
+    }
+}
+
+TEST_F(File, SliceSharesBlocks) {
+    static constexpr size_t size = 500;
+
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    data::File::Writer fw = file.GetWriter(53);
+    for (size_t i = 0; i < size; i++) {
+        fw.Put(std::to_string(i));
+    }
+    fw.Close();
+
+    auto check_slice =
+        [](const data::File& slice, size_t begin, size_t end) {
+            ASSERT_EQ(end - begin, slice.num_items());
+            data::File::KeepReader fr = slice.GetKeepReader();
+            for (size_t i = begin; i < end; ++i) {
+                ASSERT_TRUE(fr.HasNext());
+                ASSERT_EQ(std::to_string(i), fr.Next<std::string>());
+            }
+            ASSERT_FALSE(fr.HasNext());
+        };
+
+    for (size_t begin = 0; begin < size; begin += 37) {
+        for (size_t end = begin; end <= size; end += 41) {
+            data::File slice = file.Slice<std::string>(begin, end);
+            check_slice(slice, begin, end);
+            if (begin == end) continue;
+
+            // slices of slices and random access into slices
+            size_t mid = (end - begin) / 2;
+            check_slice(slice.Slice<std::string>(mid, end - begin),
+                        begin + mid, end);
+            ASSERT_EQ(std::to_string(begin + mid),
+                      slice.GetItemAt<std::string>(mid));
+        }
+    }
+
+    // the ByteBlocks are shared
+    data::File slice = file.Slice<std::string>(100, 200);
+    ASSERT_EQ(file.block(0).byte_block(),
+              file.Slice<std::string>(0, 1).block(0).byte_block());
+    ASSERT_GE(file.size_bytes(), slice.size_bytes());
+}
+
 TEST_F(File, TieGetIndexOf) {
     const size_t size = 500;
 
@@ -330,6 +503,41 @@ TEST_F(File, TieGetIndexOfWithDuplicates) {
     }
 }
 
+TEST_F(File, FileIndexGetIndexOf) {
+    const size_t size = 2000;
+
+    // Create test file with variable-size items spanning many Blocks.
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+
+    data::File::Writer fw = file.GetWriter(64);
+    for (size_t i = 0; i < size; i++) {
+        fw.Put(std::to_string(1000 + i / 7));
+    }
+    fw.Close();
+
+    data::FileIndex<std::string> index(file);
+    ASSERT_LT(1u, index.size());
+
+    std::minstd_rand0 rng(0);
+
+    for (size_t i = 0; i < size / 7 + 2; i++) {
+        std::string val = std::to_string(999 + i);
+        for (size_t tie : { size_t(0), i * 7, i * 7 + 3, size * 2 }) {
+            ASSERT_EQ(file.GetIndexOf(val, tie, std::less<std::string>()),
+                      index.GetIndexOf(file, val, tie,
+                                       std::less<std::string>()));
+
+            // restricted search range
+            size_t a = rng() % (size + 1), b = rng() % (size + 1);
+            if (a > b) std::swap(a, b);
+            ASSERT_EQ(file.GetIndexOf(val, tie, a, b,
+                                      std::less<std::string>()),
+                      index.GetIndexOf(file, val, tie, a, b,
+                                       std::less<std::string>()));
+        }
+    }
+}
+
 TEST_F(File, SeekReadSlicesOfFiles) {
     static constexpr bool debug = false;
 
@@ -486,6 +694,70 @@ TEST_F(File, BoundedFilePutIntegerUntilFull) {
               file.num_items());
 }
 
+TEST_F(File, StripedBlocksGetConsecutiveStripes) {
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+
+    {
+        data::File::Writer fw = file.GetWriter(16);
+        for (size_t i = 0; i != 8; ++i)
+            fw.PutRaw<uint64_t>(i);
+    }
+    ASSERT_EQ(data::ByteBlock::no_stripe,
+              file.block(0).byte_block()->em_stripe());
+
+    // existing and appended Blocks are striped consecutively
+    file.set_striped(true);
+    {
+        data::File::Writer fw = file.GetWriter(16);
+        for (size_t i = 0; i != 8; ++i)
+            fw.PutRaw<uint64_t>(i);
+    }
+
+    size_t first = file.block(0).byte_block()->em_stripe();
+    for (size_t i = 0; i != file.num_blocks(); ++i)
+        ASSERT_EQ(first + i, file.block(i).byte_block()->em_stripe());
+
+    file.set_striped(false);
+    ASSERT_EQ(data::ByteBlock::no_stripe,
+              file.block(0).byte_block()->em_stripe());
+}
+
+TEST_F(File, AdaptivePrefetchWithinQuota) {
+    const size_t bs = data::default_block_size;
+    block_pool_.set_prefetch_quota(2 * bs);
+
+    data::AdaptivePrefetch prefetch(&block_pool_, 2);
+    ASSERT_EQ(2u, prefetch.depth());
+
+    // stalls deepen the prefetch until the quota is exhausted
+    for (size_t i = 0; i != 4; ++i)
+        prefetch.Observe(/* ready */ false);
+    ASSERT_EQ(4u, prefetch.depth());
+    ASSERT_FALSE(block_pool_.RequestPrefetchQuota(bs));
+
+    // ready Blocks shrink it again, down to one
+    for (size_t i = 0; i != 100; ++i)
+        prefetch.Observe(/* ready */ true);
+    ASSERT_EQ(1u, prefetch.depth());
+    ASSERT_TRUE(block_pool_.RequestPrefetchQuota(2 * bs));
+    block_pool_.ReleasePrefetchQuota(2 * bs);
+
+    // the reservation is returned on destruction
+    {
+        data::AdaptivePrefetch other(&block_pool_, 1);
+        other.Observe(/* ready */ false);
+        ASSERT_EQ(2u, other.depth());
+        ASSERT_FALSE(block_pool_.RequestPrefetchQuota(2 * bs));
+    }
+    ASSERT_TRUE(block_pool_.RequestPrefetchQuota(2 * bs));
+    block_pool_.ReleasePrefetchQuota(2 * bs);
+
+    // no adaptation without prefetching
+    data::AdaptivePrefetch none(&block_pool_, 0);
+    none.Observe(/* ready */ false);
+    ASSERT_EQ(0u, none.depth());
+}
+
 // forced instantiation
 template class data::BlockReader<data::KeepFileBlockSource>;
 template class data::BlockReader<data::ConsumeFileBlockSource>;
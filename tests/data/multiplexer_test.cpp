@@ -10,16 +10,28 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <thrill/core/multiway_merge.hpp>
 #include <thrill/data/cat_stream.hpp>
 #include <thrill/data/mix_stream.hpp>
 #include <thrill/data/multiplexer.hpp>
 #include <thrill/data/multiplexer_header.hpp>
+#include <thrill/io/syscall_file.hpp>
 #include <thrill/net/dispatcher_thread.hpp>
 #include <thrill/net/group.hpp>
 #include <thrill/net/mock/group.hpp>
 
+#if THRILL_HAVE_NET_TCP
+#include <thrill/net/tcp/group.hpp>
+#endif
+
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 using namespace thrill;
@@ -36,6 +48,7 @@ struct MultiplexerHeaderTest : public ::testing::Test {
         candidate.size = 4;
         candidate.num_items = 5;
         candidate.sender_worker = 6;
+        candidate.compressed_size = 3;
     }
 
     data::StreamMultiplexerHeader candidate;
@@ -54,6 +67,7 @@ TEST_F(MultiplexerHeaderTest, ParsesAndSerializesHeader) {
     ASSERT_EQ(candidate.size, result.size);
     ASSERT_EQ(candidate.num_items, result.num_items);
     ASSERT_EQ(candidate.sender_worker, result.sender_worker);
+    ASSERT_EQ(candidate.compressed_size, result.compressed_size);
 }
 
 TEST_F(MultiplexerHeaderTest, HeaderIsEnd) {
@@ -111,6 +125,63 @@ TEST(StreamSet, TestLoopbacks) {
     consumer(stream2, 2);
 }
 
+TEST(StreamSet, MoveToLocalWorker) {
+    size_t workers_per_host = 3;
+    size_t hosts = 1;
+    auto groups = net::mock::Group::ConstructLoopbackMesh(hosts);
+    net::Group* group = groups[0].get();
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool(workers_per_host);
+    data::Multiplexer multiplexer(mem_manager, block_pool, workers_per_host, *group);
+
+    std::vector<data::CatStreamPtr> streams;
+    for (size_t w = 0; w < workers_per_host; ++w)
+        streams.emplace_back(
+            multiplexer.GetOrCreateCatStream(0, w, /* dia_id */ 0));
+
+    // move strings to all local workers except the first one
+    for (size_t w = 0; w < workers_per_host; ++w) {
+        auto writers = streams[w]->GetWriters(test_block_size);
+        for (size_t j = 0; j < workers_per_host; j++) {
+            if (j != 0) {
+                streams[w]->MoveToLocalWorker(
+                    j, std::vector<std::string>(
+                        j, std::to_string(w) + "->" + std::to_string(j)));
+            }
+            writers[j].Close();
+        }
+    }
+
+    for (size_t w = 0; w < workers_per_host; ++w) {
+        auto reader = streams[w]->GetCatReader(/* consume */ true);
+        ASSERT_FALSE(reader.HasNext());
+        for (size_t j = 0; j < workers_per_host; j++) {
+            std::vector<std::string> items =
+                streams[w]->TakeLocalItems<std::string>(j);
+            ASSERT_EQ(w, items.size());
+            for (const std::string& s : items)
+                ASSERT_EQ(std::to_string(j) + "->" + std::to_string(w), s);
+            // items are taken only once
+            ASSERT_TRUE(streams[w]->TakeLocalItems<std::string>(j).empty());
+        }
+    }
+}
+
+TEST(StreamSet, AdaptiveBlockSize) {
+    using data::Stream;
+    // no limit: full blocks
+    ASSERT_EQ(data::default_block_size, Stream::AdaptiveBlockSize(0, 4, 64));
+    // quarter of 64 MiB per each of four local workers, for four writers
+    ASSERT_EQ(1024u * 1024u, Stream::AdaptiveBlockSize(64 * 1024 * 1024, 4, 4));
+    // rounded down to a power of two
+    ASSERT_EQ(512u * 1024u, Stream::AdaptiveBlockSize(48 * 1024 * 1024, 4, 4));
+    // clamped to the smallest and largest sizes
+    ASSERT_EQ(data::min_stream_block_size,
+              Stream::AdaptiveBlockSize(64 * 1024 * 1024, 4, 1024));
+    ASSERT_EQ(data::default_block_size,
+              Stream::AdaptiveBlockSize(size_t(1) << 40, 1, 2));
+}
+
 /******************************************************************************/
 // Multiplexer tests
 
@@ -161,7 +232,9 @@ struct Multiplexer : public ::testing::Test {
 
 // open a Stream via data::Multiplexer, and send a short message to all workers,
 // receive and check the message.
-void TalkAllToAllViaCatStream(net::Group* net) {
+void TalkAllToAllViaCatStreamBlocks(
+    net::Group* net, size_t block_size, bool block_compression,
+    bool schedule_exchange = false) {
     common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
 
     unsigned char send_buffer[123];
@@ -177,15 +250,18 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     std::string swap_file_suffix =
         std::to_string(net->my_host_rank()) + "-" + std::to_string(my_local_worker_id);
     data::BlockPool block_pool;
+    block_pool.set_block_compression(block_compression);
     data::Multiplexer multiplexer(mem_manager, block_pool, num_workers_per_host, *net);
     {
         data::StreamId id = multiplexer.AllocateCatStreamId(my_local_worker_id);
 
         // open Writers and send a message to all workers
 
-        auto writers = multiplexer.GetOrCreateCatStream(
-            id, my_local_worker_id, /* dia_id */ 0)
-                       ->GetWriters(test_block_size);
+        data::CatStreamPtr stream = multiplexer.GetOrCreateCatStream(
+            id, my_local_worker_id, /* dia_id */ 0);
+        if (schedule_exchange) stream->ScheduleExchange();
+
+        auto writers = stream->GetWriters(block_size);
 
         for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
             writers[tgt].Put("hello I am " + std::to_string(net->my_host_rank())
@@ -229,6 +305,10 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     }
 }
 
+void TalkAllToAllViaCatStream(net::Group* net) {
+    return TalkAllToAllViaCatStreamBlocks(net, test_block_size, false);
+}
+
 TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     // test for all network mesh sizes 1, 2, 5, 9:
     net::RunLoopbackGroupTest(1, TalkAllToAllViaCatStream);
@@ -237,6 +317,258 @@ TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     net::RunLoopbackGroupTest(9, TalkAllToAllViaCatStream);
 }
 
+void TalkAllToAllViaCompressedCatStream(net::Group* net) {
+    return TalkAllToAllViaCatStreamBlocks(net, 16 * 1024, true);
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaCompressedCatStream) {
+    net::RunLoopbackGroupTest(2, TalkAllToAllViaCompressedCatStream);
+    net::RunLoopbackGroupTest(5, TalkAllToAllViaCompressedCatStream);
+}
+
+void TalkAllToAllViaScheduledCatStream(net::Group* net) {
+    return TalkAllToAllViaCatStreamBlocks(net, test_block_size, false, true);
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaScheduledCatStream) {
+    net::RunLoopbackGroupTest(1, TalkAllToAllViaScheduledCatStream);
+    net::RunLoopbackGroupTest(2, TalkAllToAllViaScheduledCatStream);
+    net::RunLoopbackGroupTest(5, TalkAllToAllViaScheduledCatStream);
+    net::RunLoopbackGroupTest(6, TalkAllToAllViaScheduledCatStream);
+}
+
+TEST_F(Multiplexer, ClampDispatcherThreads) {
+    static constexpr size_t num_hosts = 3;
+
+    // more threads than connections are clamped
+    net::RunLoopbackGroupTest(
+        num_hosts,
+        [](net::Group* net) {
+            mem::Manager mem_manager(nullptr, "Benchmark");
+            data::BlockPool block_pool;
+            data::Multiplexer multiplexer(
+                mem_manager, block_pool, 1, { net }, 100);
+            ASSERT_EQ(num_hosts - 1, multiplexer.num_dispatchers());
+        });
+}
+
+#if THRILL_HAVE_NET_TCP
+TEST_F(Multiplexer, TalkAllToAllViaCatStreamOnParallelConnections) {
+    static constexpr size_t num_hosts = 3;
+    static constexpr size_t num_connections = 3;
+    static constexpr size_t num_streams = 4;
+    static constexpr size_t iterations = 1000;
+
+    // construct a loopback mesh for each parallel connection
+    std::vector<std::vector<std::unique_ptr<net::tcp::Group> > > meshes;
+    for (size_t c = 0; c < num_connections; ++c)
+        meshes.emplace_back(net::tcp::Group::ConstructLoopbackMesh(num_hosts));
+
+    auto host_thread =
+        [&meshes](size_t host) {
+            std::vector<net::Group*> groups;
+            for (size_t c = 0; c < num_connections; ++c)
+                groups.push_back(meshes[c][host].get());
+
+            mem::Manager mem_manager(nullptr, "Benchmark");
+            data::BlockPool block_pool;
+            data::Multiplexer multiplexer(mem_manager, block_pool, 1, groups);
+            ASSERT_EQ(num_connections, multiplexer.num_connections());
+
+            // each stream uses another parallel connection
+            for (size_t s = 0; s < num_streams; ++s) {
+                data::CatStreamPtr stream = multiplexer.GetNewCatStream(0, 0);
+
+                auto writers = stream->GetWriters(test_block_size);
+                for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+                    for (size_t i = 0; i < iterations; ++i)
+                        writers[tgt].Put(host * iterations + i);
+                    writers[tgt].Close();
+                }
+
+                // items from each source must arrive in order
+                auto readers = stream->GetReaders();
+                for (size_t src = 0; src != readers.size(); ++src) {
+                    for (size_t i = 0; i < iterations; ++i) {
+                        ASSERT_TRUE(readers[src].HasNext());
+                        ASSERT_EQ(src * iterations + i,
+                                  readers[src].Next<size_t>());
+                    }
+                    ASSERT_FALSE(readers[src].HasNext());
+                }
+                stream->Close();
+            }
+        };
+
+    std::vector<std::thread> threads;
+    for (size_t h = 0; h < num_hosts; ++h)
+        threads.emplace_back(host_thread, h);
+    for (std::thread& t : threads)
+        t.join();
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaShardedDispatchers) {
+    static constexpr size_t num_hosts = 4;
+    static constexpr size_t num_connections = 2;
+    static constexpr size_t workers_per_host = 2;
+    static constexpr size_t iterations = 2000;
+
+    std::vector<std::vector<std::unique_ptr<net::tcp::Group> > > meshes;
+    for (size_t c = 0; c < num_connections; ++c)
+        meshes.emplace_back(net::tcp::Group::ConstructLoopbackMesh(num_hosts));
+
+    auto host_thread =
+        [&meshes](size_t host) {
+            std::vector<net::Group*> groups;
+            for (size_t c = 0; c < num_connections; ++c)
+                groups.push_back(meshes[c][host].get());
+
+            mem::Manager mem_manager(nullptr, "Benchmark");
+            data::BlockPool block_pool(workers_per_host);
+
+            data::Multiplexer multiplexer(
+                mem_manager, block_pool, workers_per_host, groups, 4);
+            ASSERT_EQ(4u, multiplexer.num_dispatchers());
+
+            // connections to different hosts are handled by different threads
+            ASSERT_NE(&multiplexer.dispatcher(groups[0]->connection(
+                                                  (host + 1) % num_hosts)),
+                      &multiplexer.dispatcher(groups[0]->connection(
+                                                  (host + 2) % num_hosts)));
+
+            auto worker =
+                [&](size_t local_worker) {
+                    size_t my_worker = host * workers_per_host + local_worker;
+
+                    data::CatStreamPtr cat = multiplexer.GetNewCatStream(
+                        local_worker, /* dia_id */ 0);
+                    auto writers = cat->GetWriters(test_block_size);
+                    for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+                        for (size_t i = 0; i < iterations; ++i)
+                            writers[tgt].Put(my_worker * iterations + i);
+                        writers[tgt].Close();
+                    }
+
+                    // items from each source must arrive in order
+                    auto readers = cat->GetReaders();
+                    for (size_t src = 0; src != readers.size(); ++src) {
+                        for (size_t i = 0; i < iterations; ++i) {
+                            ASSERT_TRUE(readers[src].HasNext());
+                            ASSERT_EQ(src * iterations + i,
+                                      readers[src].Next<size_t>());
+                        }
+                        ASSERT_FALSE(readers[src].HasNext());
+                    }
+                    cat->Close();
+
+                    data::MixStreamPtr mix = multiplexer.GetNewMixStream(
+                        local_worker, /* dia_id */ 0);
+                    auto mix_writers = mix->GetWriters(test_block_size);
+                    for (size_t tgt = 0; tgt != mix_writers.size(); ++tgt) {
+                        for (size_t i = 0; i < iterations; ++i)
+                            mix_writers[tgt].Put(my_worker * iterations + i);
+                        mix_writers[tgt].Close();
+                    }
+
+                    std::vector<size_t> next(multiplexer.num_workers());
+                    auto reader = mix->GetMixReader(/* consume */ true);
+                    while (reader.HasNext()) {
+                        size_t x = reader.Next<size_t>();
+                        size_t src = x / iterations;
+                        ASSERT_EQ(next[src]++, x % iterations);
+                    }
+                    for (size_t src = 0; src != next.size(); ++src)
+                        ASSERT_EQ(iterations, next[src]);
+                    mix->Close();
+                };
+
+            std::vector<std::thread> threads;
+            for (size_t w = 0; w < workers_per_host; ++w)
+                threads.emplace_back(worker, w);
+            for (std::thread& t : threads)
+                t.join();
+        };
+
+    std::vector<std::thread> threads;
+    for (size_t h = 0; h < num_hosts; ++h)
+        threads.emplace_back(host_thread, h);
+    for (std::thread& t : threads)
+        t.join();
+}
+
+TEST_F(Multiplexer, SendExternalFileBlocks) {
+    static constexpr size_t num_hosts = 2;
+    static constexpr size_t num_items = 64 * 1024;
+    static constexpr size_t block_items = 2000;
+    const std::string path = "multiplexer_test_sendfile.tmp";
+
+    // write consecutive integers into an external file
+    {
+        std::vector<size_t> items(num_items);
+        std::iota(items.begin(), items.end(), size_t(0));
+        std::ofstream of(path, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(items.data()),
+                 items.size() * sizeof(size_t));
+    }
+
+    auto groups = net::tcp::Group::ConstructLoopbackMesh(num_hosts);
+
+    auto host_thread =
+        [&groups, &path](size_t host) {
+            mem::Manager mem_manager(nullptr, "Benchmark");
+            data::BlockPool block_pool;
+            block_pool.set_block_compression(false);
+            data::Multiplexer multiplexer(
+                mem_manager, block_pool, 1, { groups[host].get() });
+
+            // map the file as unpinned Blocks, as ReadBinary does.
+            io::FileBasePtr file(
+                new io::SyscallFile(
+                    path, io::FileBase::RDONLY | io::FileBase::NO_LOCK));
+
+            std::vector<data::Block> blocks;
+            for (size_t i = 0; i < num_items; i += block_items) {
+                size_t n = std::min(block_items, num_items - i);
+                blocks.emplace_back(
+                    block_pool.MapExternalBlock(
+                        file, i * sizeof(size_t), n * sizeof(size_t)),
+                    0, n * sizeof(size_t), 0, n, false);
+            }
+
+            data::CatStreamPtr stream = multiplexer.GetNewCatStream(0, 0);
+            auto writers = stream->GetWriters(test_block_size);
+
+            // send the Blocks to the other host only, the loopback does not
+            // pass through the network.
+            writers[1 - host].AppendBlocks(blocks);
+            for (auto& w : writers) w.Close();
+
+            auto readers = stream->GetReaders();
+            for (size_t i = 0; i < num_items; ++i) {
+                ASSERT_TRUE(readers[1 - host].HasNext());
+                ASSERT_EQ(i, readers[1 - host].Next<size_t>());
+            }
+            ASSERT_FALSE(readers[1 - host].HasNext());
+            ASSERT_FALSE(readers[host].HasNext());
+            stream->Close();
+
+#if defined(__linux__)
+            // the Blocks were sent from the file without loading them.
+            for (const data::Block& b : blocks)
+                ASSERT_FALSE(b.byte_block()->in_memory());
+#endif
+        };
+
+    std::vector<std::thread> threads;
+    for (size_t h = 0; h < num_hosts; ++h)
+        threads.emplace_back(host_thread, h);
+    for (std::thread& t : threads)
+        t.join();
+
+    std::remove(path.c_str());
+}
+#endif
+
 TEST_F(Multiplexer, ReadCompleteCatStream) {
     auto w0 =
         [](data::Multiplexer& multiplexer) {
@@ -454,7 +786,7 @@ TEST_F(Multiplexer, ReadCompleteMixStreamManyTimes) {
 
 // open a Stream via data::Multiplexer, and send a short message to all workers,
 // receive and check the message.
-void TalkAllToAllViaMixStream(net::Group* net) {
+void TalkAllToAllViaMixStreamSchedule(net::Group* net, bool schedule_exchange) {
     common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
 
     char send_buffer[123];
@@ -475,8 +807,11 @@ void TalkAllToAllViaMixStream(net::Group* net) {
 
         // open Writers and send a message to all workers
 
-        auto writers = multiplexer.GetOrCreateMixStream(
-            id, my_local_worker_id, /* dia_id */ 0)->GetWriters(test_block_size);
+        data::MixStreamPtr stream = multiplexer.GetOrCreateMixStream(
+            id, my_local_worker_id, /* dia_id */ 0);
+        if (schedule_exchange) stream->ScheduleExchange();
+
+        auto writers = stream->GetWriters(test_block_size);
 
         for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
             std::string txt =
@@ -529,6 +864,10 @@ void TalkAllToAllViaMixStream(net::Group* net) {
     }
 }
 
+void TalkAllToAllViaMixStream(net::Group* net) {
+    return TalkAllToAllViaMixStreamSchedule(net, false);
+}
+
 TEST_F(Multiplexer, TalkAllToAllViaMixStreamForManyNetSizes) {
     // test for all network mesh sizes 1, 2, 5, 9:
     net::RunLoopbackGroupTest(1, TalkAllToAllViaMixStream);
@@ -538,6 +877,358 @@ TEST_F(Multiplexer, TalkAllToAllViaMixStreamForManyNetSizes) {
     // the test does not work for two digit #workers (due to sorting digits)
 }
 
+void TalkAllToAllViaScheduledMixStream(net::Group* net) {
+    return TalkAllToAllViaMixStreamSchedule(net, true);
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaScheduledMixStream) {
+    net::RunLoopbackGroupTest(2, TalkAllToAllViaScheduledMixStream);
+    net::RunLoopbackGroupTest(5, TalkAllToAllViaScheduledMixStream);
+}
+
+// open a MixStream, send a sorted sequence to all workers, and merge the
+// sequences on the receiver with a SplitReader.
+void MergeSortedRunsViaMixStream(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    static constexpr size_t iterations = 2000;
+    size_t my_local_worker_id = 0;
+    size_t num_workers_per_host = 1;
+    size_t num_hosts = net->num_hosts();
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool;
+    data::Multiplexer multiplexer(mem_manager, block_pool, num_workers_per_host, *net);
+    {
+        data::StreamId id = multiplexer.AllocateMixStreamId(my_local_worker_id);
+
+        data::MixStreamPtr stream = multiplexer.GetOrCreateMixStream(
+            id, my_local_worker_id, /* dia_id */ 0);
+
+        // send interleaved ascending sequences
+        auto writers = stream->GetWriters(test_block_size);
+        for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+            for (size_t i = 0; i < iterations; ++i)
+                writers[tgt].Put(i * num_hosts + net->my_host_rank());
+            writers[tgt].Close();
+        }
+
+        auto split_reader = stream->GetSplitReader(/* consume */ true);
+        ASSERT_EQ(num_hosts, split_reader.num_sources());
+
+        auto readers = split_reader.GetSourceReaders();
+        auto puller = core::make_multiway_merge_tree<size_t>(
+            readers.begin(), readers.end(), std::less<size_t>());
+
+        size_t i = 0;
+        while (puller.HasNext()) {
+            ASSERT_EQ(i, puller.Next());
+            ++i;
+        }
+        ASSERT_EQ(iterations * num_hosts, i);
+
+        stream->Close();
+    }
+}
+
+TEST_F(Multiplexer, MergeSortedRunsViaMixStream) {
+    net::RunLoopbackGroupTest(1, MergeSortedRunsViaMixStream);
+    net::RunLoopbackGroupTest(2, MergeSortedRunsViaMixStream);
+    net::RunLoopbackGroupTest(5, MergeSortedRunsViaMixStream);
+}
+
+// open and close many streams, whose StreamSets must be released.
+void ReleaseClosedStreams(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    static constexpr size_t iterations = 200;
+    size_t my_local_worker_id = 0;
+    size_t num_workers_per_host = 1;
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool;
+    data::Multiplexer multiplexer(mem_manager, block_pool, num_workers_per_host, *net);
+
+    for (size_t r = 0; r < iterations; ++r) {
+        data::CatStreamPtr cat = multiplexer.GetNewCatStream(
+            my_local_worker_id, /* dia_id */ 0);
+        data::MixStreamPtr mix = multiplexer.GetNewMixStream(
+            my_local_worker_id, /* dia_id */ 0);
+
+        auto cat_writers = cat->GetWriters(test_block_size);
+        auto mix_writers = mix->GetWriters(test_block_size);
+        for (size_t tgt = 0; tgt != cat_writers.size(); ++tgt) {
+            cat_writers[tgt].Put(r);
+            cat_writers[tgt].Close();
+            mix_writers[tgt].Put(r);
+            mix_writers[tgt].Close();
+        }
+
+        auto cat_reader = cat->GetCatReader(/* consume */ true);
+        size_t count = 0;
+        while (cat_reader.HasNext()) {
+            ASSERT_EQ(r, cat_reader.Next<size_t>());
+            ++count;
+        }
+        auto mix_reader = mix->GetMixReader(/* consume */ true);
+        while (mix_reader.HasNext()) {
+            ASSERT_EQ(r, mix_reader.Next<size_t>());
+            ++count;
+        }
+        ASSERT_EQ(2 * net->num_hosts(), count);
+
+        cat->Close();
+        mix->Close();
+    }
+
+    // only streams which are not closed yet are kept
+    ASSERT_EQ(0u, multiplexer.num_stream_sets());
+}
+
+TEST_F(Multiplexer, ReleaseClosedStreams) {
+    net::RunLoopbackGroupTest(1, ReleaseClosedStreams);
+    net::RunLoopbackGroupTest(2, ReleaseClosedStreams);
+    net::RunLoopbackGroupTest(5, ReleaseClosedStreams);
+}
+
+// send several default-sized Blocks to all workers, which are received into
+// the pre-allocated ByteBlocks of the receive pools.
+void SendDefaultSizedBlocks(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    static constexpr size_t items = 4 * data::default_block_size / 8;
+    size_t my_local_worker_id = 0;
+    size_t num_workers_per_host = 1;
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool;
+    data::Multiplexer multiplexer(mem_manager, block_pool, num_workers_per_host, *net);
+
+    for (size_t round = 0; round < 2; ++round) {
+        data::CatStreamPtr stream = multiplexer.GetNewCatStream(
+            my_local_worker_id, /* dia_id */ 0);
+
+        auto writers = stream->GetWriters();
+        for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+            for (size_t i = 0; i < items; ++i)
+                writers[tgt].PutRaw<uint64_t>(round + i * tgt);
+            writers[tgt].Close();
+        }
+
+        auto readers = stream->GetReaders();
+        for (size_t src = 0; src != readers.size(); ++src) {
+            for (size_t i = 0; i < items; ++i) {
+                ASSERT_EQ(round + i * net->my_host_rank(),
+                          readers[src].GetRaw<uint64_t>());
+            }
+            ASSERT_FALSE(readers[src].HasNext());
+        }
+        stream->Close();
+    }
+}
+
+TEST_F(Multiplexer, SendDefaultSizedBlocks) {
+    net::RunLoopbackGroupTest(2, SendDefaultSizedBlocks);
+    net::RunLoopbackGroupTest(3, SendDefaultSizedBlocks);
+}
+
+// send many small Blocks, mixed with large ones, and empty streams between
+// several workers per host, such that the sinks to each remote host share one
+// batch. Items are (source worker, sequence number) and must arrive in order.
+void SendSmallBlocksBatched(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    static constexpr size_t workers_per_host = 3;
+    static constexpr size_t rounds = 200;
+    // small blocks limit the allocated memory, large blocks of 64 KiB are
+    // not batched.
+    static constexpr size_t block_size = 64 * 1024;
+    static constexpr size_t large_items = 5000;
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool(workers_per_host);
+    data::Multiplexer multiplexer(
+        mem_manager, block_pool, workers_per_host, *net);
+
+    using Item = std::pair<size_t, size_t>;
+
+    // write rounds of one small Block each, every tenth round is followed by
+    // a large Block. Every third target receives no items at all.
+    auto write = [](auto& writers, size_t my_worker) {
+                     for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+                         size_t seq = 0;
+                         for (size_t r = 0; r < rounds && tgt % 3 != 2; ++r) {
+                             for (size_t i = 0; i < r % 7 + 1; ++i)
+                                 writers[tgt].Put(Item(my_worker, seq++));
+                             writers[tgt].Flush();
+                             if (r % 10 != 9) continue;
+                             for (size_t i = 0; i < large_items; ++i)
+                                 writers[tgt].Put(Item(my_worker, seq++));
+                             writers[tgt].Flush();
+                         }
+                         writers[tgt].Close();
+                     }
+                 };
+
+    // the number of items each worker sends to a target which is not empty
+    size_t num_items = rounds / 10 * large_items;
+    for (size_t r = 0; r < rounds; ++r) num_items += r % 7 + 1;
+
+    auto worker =
+        [&](size_t local_worker) {
+            size_t my_worker =
+                net->my_host_rank() * workers_per_host + local_worker;
+            bool empty = my_worker % 3 == 2;
+
+            // CatStream: each reader delivers the items of one source in order
+            {
+                data::CatStreamPtr stream = multiplexer.GetNewCatStream(
+                    local_worker, /* dia_id */ 0);
+                auto writers = stream->GetWriters(block_size);
+                write(writers, my_worker);
+
+                auto readers = stream->GetReaders();
+                for (size_t src = 0; src != readers.size(); ++src) {
+                    for (size_t i = 0; i < (empty ? 0 : num_items); ++i) {
+                        ASSERT_EQ(Item(src, i), readers[src].Next<Item>());
+                    }
+                    ASSERT_FALSE(readers[src].HasNext());
+                }
+                stream->Close();
+            }
+
+            // MixStream: the items of each source arrive in order
+            {
+                data::MixStreamPtr stream = multiplexer.GetNewMixStream(
+                    local_worker, /* dia_id */ 0);
+                auto writers = stream->GetWriters(block_size);
+                write(writers, my_worker);
+
+                std::vector<size_t> next(multiplexer.num_workers());
+                auto reader = stream->GetMixReader(/* consume */ true);
+                while (reader.HasNext()) {
+                    Item item = reader.Next<Item>();
+                    ASSERT_EQ(next[item.first]++, item.second);
+                }
+                for (size_t src = 0; src != next.size(); ++src)
+                    ASSERT_EQ(empty ? 0 : num_items, next[src]);
+                stream->Close();
+            }
+        };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers_per_host; ++w)
+        threads.emplace_back([&worker, w]() { worker(w); });
+    for (std::thread& t : threads) t.join();
+}
+
+TEST_F(Multiplexer, SendSmallBlocksBatched) {
+    net::RunLoopbackGroupTest(2, SendSmallBlocksBatched);
+    net::RunLoopbackGroupTest(3, SendSmallBlocksBatched);
+    // message based networks receive the StreamBatch header and the batch as
+    // separate messages
+    net::ExecuteGroupThreads(
+        net::mock::Group::ConstructLoopbackMesh(3),
+        std::function<void(net::Group*)>(SendSmallBlocksBatched));
+}
+
+// send many more Blocks than StreamSink::initial_credits from one host, such
+// that the sinks run out of credits and hold back Blocks until the receivers
+// grant more, also while they close.
+void SendBlocksBeyondCredits(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    static constexpr size_t num_blocks = 8 * data::StreamSink::initial_credits;
+    static constexpr size_t items = num_blocks * test_block_size / 8;
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool;
+    data::Multiplexer multiplexer(mem_manager, block_pool, 1, *net);
+
+    data::CatStreamPtr stream = multiplexer.GetNewCatStream(
+        /* local_worker_id */ 0, /* dia_id */ 0);
+
+    auto writers = stream->GetWriters(test_block_size);
+    for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+        for (size_t i = 0; i < items && net->my_host_rank() == 0; ++i)
+            writers[tgt].PutRaw<uint64_t>(i);
+        writers[tgt].Close();
+    }
+
+    auto readers = stream->GetReaders();
+    for (size_t src = 0; src != readers.size(); ++src) {
+        for (size_t i = 0; i < (src == 0 ? items : 0); ++i)
+            ASSERT_EQ(i, readers[src].GetRaw<uint64_t>());
+        ASSERT_FALSE(readers[src].HasNext());
+    }
+    stream->Close();
+}
+
+TEST_F(Multiplexer, SendBlocksBeyondCredits) {
+    net::RunLoopbackGroupTest(2, SendBlocksBeyondCredits);
+    net::RunLoopbackGroupTest(3, SendBlocksBeyondCredits);
+}
+
+// host 1 holds pinned memory above its soft limit while host 0 sends to it,
+// hence host 1 delays the credits and host 0's Close() waits with Blocks held
+// back. Releasing the memory brings host 1 below the limit, which grants the
+// delayed credits.
+void DelayCreditsAboveSoftLimit(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    // ByteBlocks must be aligned if the BlockPool has limits
+    static constexpr size_t block_size = 4096;
+    static constexpr size_t num_blocks = 4 * data::StreamSink::initial_credits;
+    static constexpr size_t items = num_blocks * block_size / 8;
+    static constexpr size_t soft_limit = num_blocks * block_size;
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool(
+        soft_limit, 1024 * soft_limit, nullptr, &mem_manager, 1);
+    data::Multiplexer multiplexer(mem_manager, block_pool, 1, *net);
+
+    std::vector<data::PinnedByteBlockPtr> held;
+    if (net->my_host_rank() == 1) {
+        for (size_t i = 0; i < 2 * num_blocks; ++i) {
+            held.emplace_back(block_pool.AllocateByteBlock(block_size, 0));
+        }
+        ASSERT_FALSE(block_pool.below_soft_limit());
+    }
+
+    data::CatStreamPtr stream = multiplexer.GetNewCatStream(
+        /* local_worker_id */ 0, /* dia_id */ 0);
+
+    std::thread release;
+    if (net->my_host_rank() == 1) {
+        release = std::thread([&held]() {
+                                  std::this_thread::sleep_for(
+                                      std::chrono::milliseconds(50));
+                                  held.clear();
+                              });
+    }
+
+    auto writers = stream->GetWriters(block_size);
+    for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+        for (size_t i = 0; i < items && net->my_host_rank() == 0; ++i)
+            writers[tgt].PutRaw<uint64_t>(i);
+        writers[tgt].Close();
+    }
+
+    if (release.joinable()) release.join();
+
+    auto readers = stream->GetReaders();
+    for (size_t src = 0; src != readers.size(); ++src) {
+        for (size_t i = 0; i < (src == 0 ? items : 0); ++i)
+            ASSERT_EQ(i, readers[src].GetRaw<uint64_t>());
+        ASSERT_FALSE(readers[src].HasNext());
+    }
+    stream->Close();
+}
+
+TEST_F(Multiplexer, DelayCreditsAboveSoftLimit) {
+    net::RunLoopbackGroupTest(2, DelayCreditsAboveSoftLimit);
+}
+
 /******************************************************************************/
 // Scatter Tests
 
@@ -13,6 +13,7 @@
 #include <thrill/data/file.hpp>
 #include <thrill/data/serialization.hpp>
 
+#include <array>
 #include <string>
 #include <tuple>
 #include <typeinfo>
@@ -238,4 +239,64 @@ TEST_F(Serialization, MethodStruct) {
         "Serialization::is_fixed_size is wrong");
 }
 
+struct MyMacroStruct
+{
+    int                     i1 = 0;
+    std::vector<std::string> v2;
+    std::pair<double, char> p3;
+
+    THRILL_SERIALIZE(MyMacroStruct, i1, v2, p3);
+};
+
+struct MyFixedMacroStruct
+{
+    // the default member initializer makes it non-POD
+    uint32_t                i1 = 42;
+    std::array<uint16_t, 3> a2;
+
+    THRILL_SERIALIZE(MyFixedMacroStruct, i1, a2);
+};
+
+TEST_F(Serialization, MacroStruct) {
+    MyMacroStruct foo;
+    foo.i1 = 6 * 9;
+    foo.v2 = { "abc", "", "defg" };
+    foo.p3 = std::make_pair(4.5, 'x');
+
+    MyFixedMacroStruct bar;
+    bar.a2 = { { 1, 2, 3 } };
+
+    data::File f(block_pool_, 0, /* dia_id */ 0);
+    {
+        auto w = f.GetWriter();
+        w.Put(foo);
+        w.Put(bar);
+        w.Put(foo);
+    }
+    auto r = f.GetKeepReader();
+    for (size_t i = 0; i < 2; ++i) {
+        auto fooserial = r.Next<MyMacroStruct>();
+        ASSERT_EQ(foo.i1, fooserial.i1);
+        ASSERT_EQ(foo.v2, fooserial.v2);
+        ASSERT_EQ(foo.p3, fooserial.p3);
+        if (i == 1) break;
+        auto barserial = r.Next<MyFixedMacroStruct>();
+        ASSERT_EQ(42u, barserial.i1);
+        ASSERT_EQ(bar.a2, barserial.a2);
+    }
+    ASSERT_FALSE(r.HasNext());
+
+    static_assert(
+        !data::Serialization<data::DynBlockWriter, MyMacroStruct>::is_fixed_size,
+        "Serialization::is_fixed_size is wrong");
+    static_assert(
+        data::Serialization<data::DynBlockWriter, MyFixedMacroStruct>
+        ::is_fixed_size,
+        "Serialization::is_fixed_size is wrong");
+    static_assert(
+        data::Serialization<data::DynBlockWriter, MyFixedMacroStruct>
+        ::fixed_size == 10,
+        "Serialization::fixed_size is wrong");
+}
+
 /******************************************************************************/
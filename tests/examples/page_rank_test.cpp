@@ -93,6 +93,17 @@ TEST(PageRank, RandomZipfGraph) {
             for (size_t i = 0; i < result.size(); ++i) {
                 ASSERT_TRUE(std::abs(correct_page_rank[i] - result[i]) < 0.000001);
             }
+
+            // the same on a Pregel graph
+            std::vector<double> pregel_result =
+                PageRankPregel(EqualToDIA(ctx, outlinks), num_pages, iterations)
+                .AllGather();
+
+            ASSERT_EQ(correct_page_rank.size(), pregel_result.size());
+            for (size_t i = 0; i < pregel_result.size(); ++i) {
+                ASSERT_TRUE(
+                    std::abs(correct_page_rank[i] - pregel_result[i]) < 0.000001);
+            }
         };
 
     api::RunLocalTests(start_func);
@@ -16,6 +16,8 @@
 #include <thrill/common/die.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/io/block_manager.hpp>
+#include <thrill/io/create_file.hpp>
+#include <thrill/io/disk_allocator.hpp>
 
 #include <gtest/gtest.h>
 
@@ -32,6 +34,13 @@ TEST(IO_ConfigFile, Test1) {
     die_unequal(cfg.size, 100 * 1024 * 1024 * uint64_t(1024));
     die_unequal(cfg.fileio_string(), "syscall direct=on unlink_on_open");
 
+    // preallocated file kept across runs
+
+    cfg.parse_line("disk=/var/tmp/thrill.tmp, 100 GiB , syscall keep preallocate");
+
+    die_unless(cfg.keep && cfg.preallocate);
+    die_unequal(cfg.fileio_string(), "syscall keep preallocate");
+
     // test disk_config parser:
 
     cfg.parse_line("disk=/var/tmp/thrill.tmp, 100 , wincall queue=5 delete_on_exit direct=on");
@@ -42,8 +51,19 @@ TEST(IO_ConfigFile, Test1) {
     die_unequal(cfg.queue, 5);
     die_unequal(cfg.direct, io::DiskConfig::DIRECT_ON);
 
+    // bandwidth weight for the LeastLoaded allocation strategy
+
+    cfg.parse_line("disk=/var/tmp/thrill.tmp, 100 GiB , syscall bandwidth=2500");
+
+    die_unequal(cfg.bandwidth, 2500.0);
+    die_unequal(cfg.fileio_string(), "syscall bandwidth=2500");
+
     // bad configurations
 
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/thrill.tmp, 100 GiB, syscall bandwidth=fast"),
+        std::runtime_error);
+
     die_unless_throws(
         cfg.parse_line("disk=/var/tmp/thrill.tmp, 100 GiB, wincall_fileperblock unlink direct=on"),
         std::runtime_error);
@@ -51,10 +71,41 @@ TEST(IO_ConfigFile, Test1) {
     die_unless_throws(
         cfg.parse_line("disk=/var/tmp/thrill.tmp,0x,syscall"),
         std::runtime_error);
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/thrill.tmp, 100 GiB, syscall keep unlink"),
+        std::runtime_error);
 }
 
 #if !THRILL_WINDOWS
 
+TEST(IO_ConfigFile, KeepFile) {
+    std::string path = "/tmp/thrill-keep-" + std::to_string(getpid()) + ".tmp";
+    const int mode = io::FileBase::CREAT | io::FileBase::RDWR;
+
+    // an existing larger file is truncated to the configured size
+    {
+        io::DiskConfig cfg(path, 4 * 1024 * 1024, "syscall preallocate");
+        io::FileBasePtr file = io::CreateFile(cfg, mode, 0);
+        file->set_size(8 * 1024 * 1024);
+        { io::DiskAllocator alloc(file.get(), cfg); }
+        die_unequal(file->size(), 4 * 1024 * 1024u);
+    }
+
+    // but all of it is used and kept with "keep"
+    {
+        io::DiskConfig cfg(path, 2 * 1024 * 1024, "syscall keep preallocate");
+        io::FileBasePtr file = io::CreateFile(cfg, mode, 0);
+        {
+            io::DiskAllocator alloc(file.get(), cfg);
+            die_unequal(alloc.total_bytes(), 4 * 1024 * 1024);
+            die_unequal(alloc.free_bytes(), 4 * 1024 * 1024);
+        }
+        die_unequal(file->size(), 4 * 1024 * 1024u);
+        file->close_remove();
+    }
+}
+
 TEST(IO_ConfigFile, Test2) {
     // test user-supplied configuration
 
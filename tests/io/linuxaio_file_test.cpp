@@ -0,0 +1,189 @@
+/*******************************************************************************
+ * tests/io/linuxaio_file_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/io/exceptions.hpp>
+#include <thrill/io/linuxaio_file.hpp>
+#include <thrill/io/request_operations.hpp>
+#include <thrill/mem/aligned_allocator.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if THRILL_HAVE_LINUXAIO_FILE
+
+using namespace thrill;
+
+static constexpr size_t block_size = 4096;
+
+struct LinuxaioFile : public ::testing::Test {
+    //! allocate num aligned blocks, block i filled with (i + seed)
+    std::vector<char*> MakeBuffers(size_t num, size_t seed) {
+        std::vector<char*> buffers(num);
+        for (size_t i = 0; i < num; ++i) {
+            buffers[i] = static_cast<char*>(mem::aligned_alloc(block_size));
+            std::fill(buffers[i], buffers[i] + block_size,
+                      static_cast<char>(i + seed));
+        }
+        return buffers;
+    }
+
+    void FreeBuffers(std::vector<char*>& buffers) {
+        for (char* b : buffers) mem::aligned_dealloc(b, block_size);
+        buffers.clear();
+    }
+
+    void CheckBuffer(const char* buffer, size_t value) {
+        for (size_t j = 0; j < block_size; ++j)
+            ASSERT_EQ(static_cast<char>(value), buffer[j]);
+    }
+
+    io::FileBasePtr OpenFile(const std::string& path) {
+        paths_.push_back(path);
+        return io::FileBasePtr(
+            new io::LinuxaioFile(
+                path, io::FileBase::CREAT | io::FileBase::RDWR));
+    }
+
+    ~LinuxaioFile() {
+        for (const std::string& p : paths_) std::remove(p.c_str());
+    }
+
+    std::vector<std::string> paths_;
+};
+
+TEST_F(LinuxaioFile, AdjacentRequests) {
+    static constexpr size_t num_blocks = 256;
+
+    io::FileBasePtr file = OpenFile("linuxaio_file_test_1.dat");
+    file->set_size(num_blocks * block_size);
+
+    // post adjacent writes at once, which the queue merges into vectored
+    // requests.
+    std::vector<char*> buffers = MakeBuffers(num_blocks, 0);
+    std::vector<io::RequestPtr> reqs(num_blocks);
+    for (size_t i = 0; i < num_blocks; ++i)
+        reqs[i] = file->awrite(buffers[i], i * block_size, block_size);
+    io::wait_all(reqs.begin(), reqs.end());
+    FreeBuffers(buffers);
+
+    // read back adjacent blocks in reverse order of posting
+    buffers = MakeBuffers(num_blocks, 1);
+    for (size_t i = num_blocks; i != 0; --i)
+        reqs[i - 1] = file->aread(
+            buffers[i - 1], (i - 1) * block_size, block_size);
+    io::wait_all(reqs.begin(), reqs.end());
+
+    for (size_t i = 0; i < num_blocks; ++i)
+        CheckBuffer(buffers[i], i);
+    FreeBuffers(buffers);
+}
+
+TEST_F(LinuxaioFile, InterleavedRequests) {
+    static constexpr size_t num_blocks = 128;
+
+    // two files, with every second block written, such that only requests to
+    // the same file with adjacent offsets and the same type are merged.
+    io::FileBasePtr file1 = OpenFile("linuxaio_file_test_2.dat");
+    io::FileBasePtr file2 = OpenFile("linuxaio_file_test_3.dat");
+    file1->set_size(2 * num_blocks * block_size);
+    file2->set_size(2 * num_blocks * block_size);
+
+    std::vector<char*> buffers1 = MakeBuffers(num_blocks, 0);
+    std::vector<char*> buffers2 = MakeBuffers(num_blocks, 100);
+    std::vector<io::RequestPtr> reqs;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        reqs.push_back(
+            file1->awrite(buffers1[i], 2 * i * block_size, block_size));
+        reqs.push_back(
+            file2->awrite(buffers2[i], (2 * i + 1) * block_size, block_size));
+    }
+    io::wait_all(reqs.begin(), reqs.end());
+    reqs.clear();
+
+    // read each written block twice, into adjacent buffers of file1 and the
+    // same region of file2, mixed with writes to the gaps of file1.
+    std::vector<char*> read1 = MakeBuffers(num_blocks, 200);
+    std::vector<char*> read2 = MakeBuffers(num_blocks, 200);
+    std::vector<char*> gaps = MakeBuffers(num_blocks, 50);
+    for (size_t i = 0; i < num_blocks; ++i) {
+        reqs.push_back(file1->aread(read1[i], 2 * i * block_size, block_size));
+        reqs.push_back(
+            file1->awrite(gaps[i], (2 * i + 1) * block_size, block_size));
+        reqs.push_back(
+            file2->aread(read2[i], (2 * i + 1) * block_size, block_size));
+    }
+    io::wait_all(reqs.begin(), reqs.end());
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+        CheckBuffer(read1[i], i);
+        CheckBuffer(read2[i], i + 100);
+    }
+
+    // check the gaps of file1 with one large read
+    char* all = static_cast<char*>(
+        mem::aligned_alloc(2 * num_blocks * block_size));
+    file1->aread(all, 0, 2 * num_blocks * block_size)->wait();
+    for (size_t i = 0; i < num_blocks; ++i) {
+        CheckBuffer(all + 2 * i * block_size, i);
+        CheckBuffer(all + (2 * i + 1) * block_size, i + 50);
+    }
+    mem::aligned_dealloc(all, 2 * num_blocks * block_size);
+
+    FreeBuffers(buffers1);
+    FreeBuffers(buffers2);
+    FreeBuffers(read1);
+    FreeBuffers(read2);
+    FreeBuffers(gaps);
+}
+
+TEST_F(LinuxaioFile, ShortReadSetsError) {
+    static constexpr size_t num_blocks = 8;
+
+    io::FileBasePtr file = OpenFile("linuxaio_file_test_4.dat");
+    file->set_size(num_blocks * block_size);
+
+    // the adjacent reads past the end of the file may be merged with the
+    // valid ones: all requests of a short transfer must fail.
+    std::vector<char*> buffers = MakeBuffers(2 * num_blocks, 0);
+    std::vector<io::RequestPtr> reqs(2 * num_blocks);
+    for (size_t i = 0; i < 2 * num_blocks; ++i)
+        reqs[i] = file->aread(buffers[i], i * block_size, block_size);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < 2 * num_blocks; ++i) {
+        try {
+            reqs[i]->wait();
+        }
+        catch (const io::IoError&) {
+            ++failed;
+        }
+    }
+    // at least the reads past the end failed
+    ASSERT_LE(num_blocks, failed);
+    FreeBuffers(buffers);
+}
+
+TEST_F(LinuxaioFile, DeviceQueueLength) {
+    ASSERT_EQ(0, io::LinuxaioFile::DeviceQueueLength(-1));
+
+    io::FileBasePtr file = OpenFile("linuxaio_file_test_5.dat");
+    int length = io::LinuxaioFile::DeviceQueueLength(file->native_fd());
+    // zero if unknown, e.g. on tmpfs.
+    ASSERT_TRUE(length == 0 || (length >= 64 && length <= 1024));
+
+    // the file's queue length is derived from it unless given explicitly.
+    io::LinuxaioFile* lfile = dynamic_cast<io::LinuxaioFile*>(file.get());
+    ASSERT_EQ(length, lfile->desired_queue_length());
+}
+
+#endif // THRILL_HAVE_LINUXAIO_FILE
+
+/******************************************************************************/
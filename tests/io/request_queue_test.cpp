@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * tests/io/request_queue_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/io/memory_file.hpp>
+#include <thrill/io/request_operations.hpp>
+#include <thrill/io/request_queue_impl_qw_qr.hpp>
+#include <thrill/io/serving_request.hpp>
+#include <thrill/mem/aligned_allocator.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace thrill;
+
+TEST(RequestQueue, PriorityAndCoalescing) {
+    static constexpr size_t size = 4096;
+
+    io::FileBasePtr file(new io::MemoryFile());
+    file->set_size(32 * size);
+
+    char* buffer = static_cast<char*>(mem::aligned_alloc(size));
+
+    io::RequestQueueImplQwQr queue;
+
+    // the completion handler of the first request blocks the queue's thread
+    // until all other requests are queued.
+    std::mutex blocker, order_mutex;
+    std::atomic<bool> started { false };
+    std::vector<size_t> order;
+    std::unique_lock<std::mutex> block_lock(blocker);
+
+    auto make = [&](size_t block, io::Request::ReadOrWriteType type,
+                    io::Request::Priority priority, bool first) {
+                    io::RequestPtr req(
+                        mem::GPool().make<io::ServingRequest>(
+                            io::CompletionHandler(
+                                [&, block, first](io::Request*, bool) {
+                                    if (first) {
+                                        started = true;
+                                        std::unique_lock<std::mutex> l(blocker);
+                                    }
+                                    std::unique_lock<std::mutex> l(order_mutex);
+                                    order.push_back(block);
+                                }),
+                            file, buffer, block * size, size, type));
+                    req->set_priority(priority);
+                    queue.AddRequest(req);
+                    return req;
+                };
+
+    std::vector<io::RequestPtr> reqs;
+    reqs.push_back(
+        make(0, io::Request::WRITE, io::Request::BACKGROUND_WRITE, true));
+    while (!started) std::this_thread::yield();
+
+    reqs.push_back(
+        make(5, io::Request::WRITE, io::Request::BACKGROUND_WRITE, false));
+    reqs.push_back(
+        make(10, io::Request::READ, io::Request::DEMAND_READ, false));
+    reqs.push_back(
+        make(1, io::Request::WRITE, io::Request::BACKGROUND_WRITE, false));
+    block_lock.unlock();
+
+    io::wait_all(reqs.begin(), reqs.end());
+
+    // the write continuing block 0 is coalesced, then the demand read
+    // overtakes the earlier background write.
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 10, 5 }), order);
+
+    mem::aligned_dealloc(buffer, size);
+}
+
+/******************************************************************************/
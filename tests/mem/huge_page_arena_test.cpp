@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * tests/mem/huge_page_arena_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/huge_page_arena.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace thrill;
+
+TEST(HugePageArena, AllocateDeallocate) {
+    static constexpr size_t region_size = 16 * 1024 * 1024;
+    mem::HugePageArena arena(
+        mem::HugePageArena::Mode::Transparent, region_size);
+
+    // irregular sizes are not served by the arena
+    ASSERT_EQ(nullptr, arena.allocate(5000));
+    ASSERT_EQ(nullptr, arena.allocate(1024));
+    ASSERT_EQ(nullptr, arena.allocate(2 * region_size));
+
+    std::default_random_engine rng(42);
+    std::vector<std::pair<char*, size_t> > blocks;
+
+    for (size_t i = 0; i < 200; ++i) {
+        size_t size = mem::HugePageArena::min_block_size << (rng() % 8);
+        char* ptr = static_cast<char*>(arena.allocate(size));
+        ASSERT_NE(nullptr, ptr);
+        ASSERT_TRUE(arena.owns(ptr));
+        // blocks are aligned to their size
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % size);
+        memset(ptr, static_cast<int>(i), size);
+        blocks.emplace_back(ptr, size);
+    }
+
+    // check that blocks do not overlap
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        char* ptr = blocks[i].first;
+        for (size_t j = 0; j < blocks[i].second; j += 1024)
+            ASSERT_EQ(static_cast<char>(i), ptr[j]);
+    }
+
+    std::shuffle(blocks.begin(), blocks.end(), rng);
+    for (const auto& b : blocks)
+        arena.deallocate(b.first, b.second);
+    ASSERT_EQ(0u, arena.allocated());
+
+    // all buddies were merged: a whole region can be allocated again, but
+    // without mapping another region.
+    size_t reserved = arena.reserved();
+    void* whole = arena.allocate(region_size);
+    ASSERT_NE(nullptr, whole);
+    ASSERT_EQ(reserved, arena.reserved());
+    arena.deallocate(whole, region_size);
+
+    int x;
+    ASSERT_FALSE(arena.owns(&x));
+}
+
+/******************************************************************************/
@@ -11,6 +11,9 @@
 #include <gtest/gtest.h>
 #include <thrill/mem/malloc_tracker.hpp>
 
+#include <thread>
+#include <vector>
+
 using namespace thrill;
 
 TEST(MallocTracker, Test1) {
@@ -35,4 +38,42 @@ TEST(MallocTracker, Test1) {
     ASSERT_LE(curr, curr2);
 }
 
+TEST(MallocTracker, Sampling) {
+
+    size_t old_interval = mem::malloc_tracker_sampling();
+    mem::malloc_tracker_set_sampling(4096);
+
+    size_t sampled = mem::malloc_tracker_sampled_bytes();
+    size_t curr = mem::malloc_tracker_current();
+
+    std::vector<char*> ptrs;
+    for (size_t i = 0; i < 1024; ++i) {
+        ptrs.push_back(reinterpret_cast<char*>(malloc(1024)));
+        ptrs.back()[0] = 0;
+    }
+
+    // allocations of other threads are flushed on their exit
+    std::thread thread([]() {
+                           for (size_t i = 0; i < 100; ++i) {
+                               volatile char* a =
+                                   reinterpret_cast<char*>(malloc(1024));
+                               a[0] = 0;
+                               free(const_cast<char*>(a));
+                           }
+                       });
+    thread.join();
+
+    mem::malloc_tracker_flush();
+
+    size_t curr2 = mem::malloc_tracker_current();
+    ASSERT_GE(curr2, curr + 1024 * 1024 - 256 * 1024);
+
+    // about 1 MiB / 4096 bytes allocation sites were sampled
+    ASSERT_GE(mem::malloc_tracker_sampled_bytes(), sampled + 1024 * 1024);
+
+    for (char* p : ptrs) free(p);
+
+    mem::malloc_tracker_set_sampling(old_interval);
+}
+
 /******************************************************************************/
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * tests/mem/pool_benchmark.cpp
+ *
+ * Microbenchmark of small allocations from multiple threads using mem::Pool
+ * with and without thread-local magazines, compared to malloc().
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/cmdline_parser.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/mem/pool.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+//! run num_threads threads, each allocating and freeing objects of random
+//! small sizes with a window of live allocations, and print the time taken.
+template <typename Allocate, typename Deallocate>
+void Benchmark(const std::string& name, size_t num_threads, size_t rounds,
+               const Allocate& allocate, const Deallocate& deallocate) {
+    static constexpr size_t window = 256;
+
+    common::StatsTimerStart timer;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&, t]() {
+                std::minstd_rand rng(static_cast<unsigned>(t));
+                std::vector<std::pair<void*, size_t> > live(window);
+                for (size_t r = 0; r < rounds; ++r) {
+                    std::pair<void*, size_t>& slot = live[r % window];
+                    if (slot.first) deallocate(slot.first, slot.second);
+                    slot.second = 8 + 8 * (rng() % 16);
+                    slot.first = allocate(slot.second);
+                }
+                for (std::pair<void*, size_t>& slot : live) {
+                    if (slot.first) deallocate(slot.first, slot.second);
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+    timer.Stop();
+
+    std::cout << "RESULT"
+              << " benchmark=" << name
+              << " threads=" << num_threads
+              << " rounds=" << rounds
+              << " time=" << timer.SecondsDouble()
+              << " ns_per_op="
+              << timer.SecondsDouble() * 1e9 / static_cast<double>(rounds)
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    common::CmdlineParser clp;
+
+    size_t num_threads = std::thread::hardware_concurrency();
+    clp.AddSizeT('t', "threads", num_threads, "number of threads");
+
+    size_t rounds = 4000000;
+    clp.AddSizeT('r', "rounds", rounds, "allocations per thread");
+
+    if (!clp.Process(argc, argv)) return -1;
+
+    for (size_t t = 1; t <= num_threads; t *= 2) {
+        mem::Pool locked_pool(16384, /* thread_cache */ false);
+        Benchmark("pool_locked", t, rounds,
+                  [&](size_t n) { return locked_pool.allocate(n); },
+                  [&](void* p, size_t n) { locked_pool.deallocate(p, n); });
+
+        Benchmark("pool_thread_cache", t, rounds,
+                  [&](size_t n) { return mem::GPool().allocate(n); },
+                  [&](void* p, size_t n) { mem::GPool().deallocate(p, n); });
+
+        Benchmark("malloc", t, rounds,
+                  [&](size_t n) { return malloc(n); },
+                  [&](void* p, size_t) { free(p); });
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -18,6 +18,7 @@
 #include <functional>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -146,6 +147,49 @@ TEST(MemPool, UnorderedMap) {
     }
 }
 
+TEST(MemPool, ThreadCache) {
+    mem::Pool pool(4096, /* thread_cache */ true);
+
+    // objects are allocated by one thread and freed by its neighbour, which
+    // moves slots between the thread-local magazines and the arenas.
+    static constexpr size_t num_threads = 4;
+    static constexpr size_t num_items = 10000;
+    std::vector<std::vector<size_t*> > items(num_threads);
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back(
+                [&pool, &items, t]() {
+                    for (size_t i = 0; i < num_items; ++i) {
+                        size_t* p = pool.make<size_t>(t * num_items + i);
+                        items[t].push_back(p);
+                        if (i % 3 == 0) {
+                            // use other size classes
+                            pool.destroy(pool.make<std::pair<size_t, size_t> >());
+                        }
+                    }
+                });
+        }
+        for (std::thread& t : threads) t.join();
+    }
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back(
+                [&pool, &items, t]() {
+                    size_t u = (t + 1) % num_threads;
+                    for (size_t i = 0; i < num_items; ++i) {
+                        ASSERT_EQ(u * num_items + i, *items[u][i]);
+                        pool.destroy(items[u][i]);
+                    }
+                });
+        }
+        for (std::thread& t : threads) t.join();
+    }
+    // the magazines were returned to the pool by the exiting threads, which
+    // is checked by the destructor.
+}
+
 namespace thrill {
 namespace mem {
 
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * tests/mem/stage_arena_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/stage_arena.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+using namespace thrill;
+
+TEST(StageArena, AllocateAndRelease) {
+    mem::Manager manager(nullptr, "StageArenaTest");
+    {
+        mem::StageArena arena(manager, 4096);
+
+        // allocations are aligned and do not overlap
+        char* a = static_cast<char*>(arena.allocate(10, 1));
+        uint64_t* b = static_cast<uint64_t*>(arena.allocate(8, 8));
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(b) % 8);
+        ASSERT_GE(reinterpret_cast<char*>(b), a + 10);
+        ASSERT_EQ(18u, arena.allocated());
+        ASSERT_EQ(4096u, arena.reserved());
+        ASSERT_EQ(4096u, manager.total());
+
+        // the most recent allocation is reclaimed
+        arena.deallocate(b, 8);
+        ASSERT_EQ(10u, arena.allocated());
+        ASSERT_EQ(b, arena.allocate(8, 8));
+
+        // a large allocation gets its own chunk
+        arena.allocate(100000);
+        ASSERT_GT(arena.reserved(), 100000u);
+        ASSERT_EQ(arena.reserved(), manager.total());
+
+        // release keeps only the first chunk
+        arena.Release();
+        ASSERT_EQ(0u, arena.allocated());
+        ASSERT_EQ(4096u, arena.reserved());
+        ASSERT_EQ(4096u, manager.total());
+    }
+    ASSERT_EQ(0u, manager.total());
+}
+
+TEST(StageArena, Vector) {
+    mem::Manager manager(nullptr, "StageArenaTest");
+    mem::StageArena arena(manager);
+
+    {
+        mem::arena_vector<std::string> vec {
+            mem::StageArenaAllocator<std::string>(arena)
+        };
+        for (size_t i = 0; i < 1000; ++i)
+            vec.emplace_back(std::to_string(i));
+
+        ASSERT_EQ(1000u, vec.size());
+        for (size_t i = 0; i < 1000; ++i)
+            ASSERT_EQ(std::to_string(i), vec[i]);
+    }
+    arena.Release();
+    ASSERT_EQ(0u, arena.allocated());
+}
+
+/******************************************************************************/
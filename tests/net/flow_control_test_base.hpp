@@ -18,7 +18,11 @@
 #include <thrill/net/flow_control_manager.hpp>
 #include <thrill/net/group.hpp>
 
+#include <algorithm>
+#include <array>
 #include <functional>
+#include <future>
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
@@ -143,6 +147,32 @@ static void TestMultiThreadBroadcast(net::Group* net) {
         });
 }
 
+/*!
+ * Broadcasts a vector from each worker, which all workers on a host share.
+ */
+static void TestMultiThreadBroadcastShared(net::Group* net) {
+    const size_t count = 4;
+    ExecuteMultiThreads(
+        net, count, [=](net::FlowControlChannel& channel) {
+
+            for (size_t origin = 0; origin < channel.num_workers(); ++origin) {
+
+                std::vector<size_t> value(100, origin);
+                if (origin != channel.my_rank()) value.clear();
+
+                std::shared_ptr<const std::vector<size_t> > res =
+                    channel.BroadcastShared(value, origin);
+
+                ASSERT_EQ(std::vector<size_t>(100, origin), *res);
+
+                // all workers on the host received the same copy
+                std::shared_ptr<const std::vector<size_t> > first =
+                    channel.LocalBroadcast(res, 0);
+                ASSERT_EQ(first.get(), res.get());
+            }
+        });
+}
+
 /*!
  * Calculates a sum over all worker and thread ids.
  */
@@ -208,6 +238,43 @@ static void TestMultiThreadAllReduce(net::Group* net) {
         });
 }
 
+/*!
+ * Reduces vectors and arrays elementwise, small vectors and large ones which
+ * are reduced by ring algorithms between hosts.
+ */
+static void TestMultiThreadAllReduceElementwise(net::Group* net) {
+
+    const size_t count = 4;
+
+    ExecuteMultiThreads(
+        net, count, [=](net::FlowControlChannel& channel) {
+            size_t my_rank = channel.my_rank();
+            size_t num_workers = channel.num_workers();
+
+            for (size_t size : { 0, 3, 50000 }) {
+                std::vector<size_t> values(size);
+                for (size_t i = 0; i < size; ++i)
+                    values[i] = i * my_rank;
+
+                std::vector<size_t> res =
+                    channel.AllReduceElementwise(values);
+
+                ASSERT_EQ(size, res.size());
+                for (size_t i = 0; i < size; ++i) {
+                    ASSERT_EQ(i * num_workers * (num_workers - 1) / 2, res[i]);
+                }
+            }
+
+            std::array<double, 5> arr;
+            arr.fill(static_cast<double>(my_rank));
+            std::array<double, 5> res = channel.AllReduceElementwise(
+                arr, [](double a, double b) { return std::max(a, b); });
+            for (const double& d : res) {
+                ASSERT_EQ(static_cast<double>(num_workers - 1), d);
+            }
+        });
+}
+
 /*!
  * Calculates a sum over all worker and thread ids.
  */
@@ -340,6 +407,42 @@ static void TestPredecessorOneItem(net::Group* net) {
         });
 }
 
+/*!
+ * Starts asynchronous collectives, interleaves them with synchronous ones, and
+ * checks their results afterwards.
+ */
+static void TestMultiThreadAsyncCollectives(net::Group* net) {
+
+    const size_t count = 4;
+
+    ExecuteMultiThreads(
+        net, count, [=](net::FlowControlChannel& channel) {
+            size_t my_rank = channel.my_rank();
+            size_t num_workers = channel.num_workers();
+
+            for (size_t r = 0; r < 10; ++r) {
+                std::future<size_t> sum = channel.AllReduceAsync(my_rank + r);
+                std::future<size_t> ex = channel.ExPrefixSumAsync(my_rank);
+                std::future<std::string> str =
+                    channel.AllReduceAsync(std::to_string(my_rank % 10));
+
+                // synchronous collectives wait for the asynchronous ones
+                ASSERT_EQ(r, channel.Broadcast(r));
+                std::future<size_t> in = channel.PrefixSumAsync(size_t(1));
+
+                ASSERT_EQ(num_workers * (num_workers - 1) / 2 + num_workers * r,
+                          sum.get());
+                ASSERT_EQ(my_rank * (my_rank - 1) / 2, ex.get());
+                ASSERT_EQ(my_rank + 1, in.get());
+
+                std::string expected;
+                for (size_t i = 0; i < num_workers; ++i)
+                    expected += std::to_string(i % 10);
+                ASSERT_EQ(expected, str.get());
+            }
+        });
+}
+
 /*!
  * Does a lot of operations to provoke race conditions.
  */
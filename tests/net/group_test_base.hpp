@@ -13,11 +13,16 @@
 #define THRILL_TESTS_NET_GROUP_TEST_BASE_HEADER
 
 #include <thrill/common/math.hpp>
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_pool.hpp>
 #include <thrill/net/collective.hpp>
 #include <thrill/net/group.hpp>
 
+#include <algorithm>
+#include <condition_variable>
 #include <functional>
 #include <future>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -202,6 +207,106 @@ static void TestAllReduceHypercubeString(net::Group* net) {
     ASSERT_EQ(result.substr(0, net->num_hosts()), local_value);
 }
 
+//! exchange values larger than socket buffers in hypercube collectives
+static void TestHypercubeLargeValues(net::Group* net) {
+    const size_t size = 4 * 1024 * 1024;
+    std::string value(size, static_cast<char>('a' + net->my_host_rank()));
+    auto max_op = [](const std::string& a, const std::string& b) {
+                      return std::max(a, b);
+                  };
+
+    std::string prefix = value;
+    net::collective::PrefixSumHypercube(*net, prefix, max_op);
+    ASSERT_EQ(value, prefix);
+
+    // only for powers of two
+    if (net->num_hosts() != common::RoundUpToPowerOfTwo(net->num_hosts()))
+        return;
+
+    net::collective::AllReduceHypercube(*net, value, max_op);
+    ASSERT_EQ(size, value.size());
+    ASSERT_EQ(static_cast<char>('a' + net->num_hosts() - 1), value.back());
+}
+
+//! broadcast small and large vectors, which use different algorithms
+static void TestBroadcastLargeVector(net::Group* net) {
+    for (size_t size : { size_t(0), size_t(10), size_t(40000) }) {
+        for (size_t origin = 0; origin < net->num_hosts(); ++origin) {
+            std::vector<size_t> values;
+            if (net->my_host_rank() == origin) {
+                for (size_t i = 0; i < size; ++i)
+                    values.push_back(i * origin);
+            }
+            net::collective::Broadcast(*net, values, origin);
+            ASSERT_EQ(size, values.size());
+            for (size_t i = 0; i < size; ++i)
+                ASSERT_EQ(i * origin, values[i]);
+        }
+    }
+}
+
+//! let group of p hosts gather the blocks of a vector using a ring
+static void TestAllGatherRing(net::Group* net) {
+    const size_t num_hosts = net->num_hosts();
+    for (size_t size : { size_t(3), num_hosts, size_t(10007) }) {
+        std::vector<size_t> values(size);
+        size_t begin = net->my_host_rank() * size / num_hosts;
+        size_t end = (net->my_host_rank() + 1) * size / num_hosts;
+        for (size_t i = begin; i < end; ++i)
+            values[i] = i + 1;
+        net::collective::AllGatherRing(*net, values);
+        for (size_t i = 0; i < size; ++i)
+            ASSERT_EQ(i + 1, values[i]);
+    }
+}
+
+//! let group of p hosts perform elementwise AllReduces on small and large
+//! vectors
+static void TestAllReduceElementwise(net::Group* net) {
+    const size_t num_hosts = net->num_hosts();
+    for (size_t size : { size_t(1), size_t(10), size_t(100003) }) {
+        std::vector<size_t> values(size);
+        for (size_t i = 0; i < size; ++i)
+            values[i] = i + net->my_host_rank();
+        net::collective::AllReduceElementwise(*net, values);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(num_hosts * i + num_hosts * (num_hosts - 1) / 2,
+                      values[i]);
+        }
+    }
+}
+
+//! set racks of two hosts, then perform topology-aware AllReduce and
+//! Broadcast collectives
+static void TestTopologyCollectives(net::Group* net) {
+    const size_t num_hosts = net->num_hosts();
+    std::vector<size_t> rack_of_host(num_hosts);
+    for (size_t h = 0; h < num_hosts; ++h)
+        rack_of_host[h] = h / 2;
+    ASSERT_TRUE(net->SetRacks(rack_of_host));
+    ASSERT_EQ((num_hosts + 1) / 2, net->num_racks());
+    ASSERT_EQ(net->my_host_rank() / 2, net->rack_of(net->my_host_rank()));
+
+    // the reduction must keep the order of hosts
+    const std::string result = "abcdefghijklmnopqrstuvwxyz";
+    std::string local_value = result.substr(net->my_host_rank(), 1);
+    net::collective::AllReduce(*net, local_value);
+    ASSERT_EQ(result.substr(0, num_hosts), local_value);
+
+    for (size_t origin = 0; origin < num_hosts; ++origin) {
+        size_t value = net->my_host_rank() == origin ? 42 + origin : 0;
+        net::collective::Broadcast(*net, value, origin);
+        ASSERT_EQ(42 + origin, value);
+    }
+
+    // racks must be contiguous
+    if (num_hosts >= 4) {
+        rack_of_host[num_hosts - 1] = 0;
+        ASSERT_FALSE(net->SetRacks(rack_of_host));
+        ASSERT_EQ(1u, net->num_racks());
+    }
+}
+
 /******************************************************************************/
 // Dispatcher Tests
 
@@ -238,6 +343,235 @@ static void TestDispatcherSyncSendAsyncRead(net::Group* net) {
     }
 }
 
+//! exchanges large messages asynchronously between all workers, which the
+//! dispatcher writes and reads in many partial calls.
+static void TestDispatcherLargeAsyncMessages(net::Group* net) {
+    static constexpr size_t size = 4 * 1024 * 1024;
+
+    mem::Manager mem_manager(nullptr, "Dispatcher");
+    std::unique_ptr<net::Dispatcher>
+    dispatcher = net->ConstructDispatcher(mem_manager);
+
+    // the message to host i contains bytes (i + k) % 251
+    for (size_t i = 0; i < net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        net::Buffer buffer(size);
+        for (size_t k = 0; k < size; ++k)
+            buffer[k] = static_cast<net::Buffer::value_type>((i + k) % 251);
+        dispatcher->AsyncWrite(net->connection(i), std::move(buffer));
+    }
+
+    size_t received = 0;
+    net::AsyncReadCallback callback =
+        [net, &received](net::Connection& /* s */, const net::Buffer& buffer) {
+            ASSERT_EQ(size, buffer.size());
+            size_t k = 0;
+            while (k < size && buffer[k] == (net->my_host_rank() + k) % 251)
+                ++k;
+            ASSERT_EQ(size, k);
+            received++;
+        };
+
+    for (size_t i = 0; i != net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        dispatcher->AsyncRead(net->connection(i), size, callback);
+    }
+
+    while (received < net->num_hosts() - 1 || dispatcher->HasAsyncWrites()) {
+        dispatcher->Dispatch();
+    }
+}
+
+//! sends header Buffers followed by the data of PinnedBlocks, as the
+//! multiplexer does, which some dispatchers gather into one send call.
+static void TestDispatcherAsyncWriteHeaderAndBlock(net::Group* net) {
+    static constexpr size_t num_messages = 40;
+    static constexpr size_t header_size = 16;
+
+    mem::Manager mem_manager(nullptr, "Dispatcher");
+    data::BlockPool block_pool;
+    std::unique_ptr<net::Dispatcher>
+    dispatcher = net->ConstructDispatcher(mem_manager);
+
+    // block sizes from tiny to large, which are sent in many partial calls
+    auto block_size = [](size_t m) { return size_t(1) << (m % 21); };
+
+    // header and block of message m to host i contain bytes (i + m + k) % 251
+    auto make_byte =
+        [](size_t i, size_t m, size_t k) {
+            return static_cast<net::Buffer::value_type>((i + m + k) % 251);
+        };
+
+    for (size_t i = 0; i < net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        for (size_t m = 0; m < num_messages; ++m) {
+            net::Buffer header(header_size);
+            for (size_t k = 0; k < header_size; ++k)
+                header[k] = make_byte(i, m, k);
+
+            data::PinnedByteBlockPtr bytes =
+                block_pool.AllocateByteBlock(block_size(m), 0);
+            for (size_t k = 0; k < block_size(m); ++k)
+                bytes->data()[k] = make_byte(i, m, header_size + k);
+
+            dispatcher->AsyncWrite(
+                net->connection(i), std::move(header),
+                data::PinnedBlock(std::move(bytes), 0, block_size(m),
+                                  0, 0, false));
+        }
+    }
+
+    std::vector<size_t> received(net->num_hosts());
+    size_t num_received = 0;
+
+    auto check =
+        [net, &make_byte](size_t m, size_t offset, const net::Buffer& buffer) {
+            size_t k = 0;
+            while (k < buffer.size() &&
+                   buffer[k] == make_byte(net->my_host_rank(), m, offset + k))
+                ++k;
+            ASSERT_EQ(buffer.size(), k);
+        };
+
+    // read header and block as separate messages
+    for (size_t i = 0; i != net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        for (size_t m = 0; m < num_messages; ++m) {
+            dispatcher->AsyncRead(
+                net->connection(i), header_size,
+                [&check, m](net::Connection&, const net::Buffer& buffer) {
+                    check(m, 0, buffer);
+                });
+            dispatcher->AsyncRead(
+                net->connection(i), block_size(m),
+                [&check, &received, &num_received, i, m](
+                    net::Connection&, const net::Buffer& buffer) {
+                    ASSERT_EQ(m, received[i]);
+                    check(m, header_size, buffer);
+                    ++received[i], ++num_received;
+                });
+        }
+    }
+
+    while (num_received < (net->num_hosts() - 1) * num_messages ||
+           dispatcher->HasAsyncWrites()) {
+        dispatcher->Dispatch();
+    }
+}
+
+//! exchanges many small messages of recurring sizes, as the multiplexer's
+//! headers, interleaved with larger ones. The MPI dispatcher receives the
+//! small ones with persistent requests.
+static void TestDispatcherRecurringSmallMessages(net::Group* net) {
+    static constexpr size_t num_messages = 300;
+    static constexpr size_t sizes[3] = { 8, 24, 1000 };
+
+    mem::Manager mem_manager(nullptr, "Dispatcher");
+    std::unique_ptr<net::Dispatcher>
+    dispatcher = net->ConstructDispatcher(mem_manager);
+
+    // message m to host i contains bytes (i + m + k) % 251
+    auto make_byte =
+        [](size_t i, size_t m, size_t k) {
+            return static_cast<net::Buffer::value_type>((i + m + k) % 251);
+        };
+
+    for (size_t i = 0; i < net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        for (size_t m = 0; m < num_messages; ++m) {
+            net::Buffer buffer(sizes[m % 3]);
+            for (size_t k = 0; k < buffer.size(); ++k)
+                buffer[k] = make_byte(i, m, k);
+            dispatcher->AsyncWrite(net->connection(i), std::move(buffer));
+        }
+    }
+
+    // messages from each peer must arrive in order
+    std::vector<size_t> received(net->num_hosts());
+    size_t num_received = 0;
+
+    for (size_t i = 0; i != net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        for (size_t m = 0; m < num_messages; ++m) {
+            dispatcher->AsyncRead(
+                net->connection(i), sizes[m % 3],
+                [net, &received, &num_received, &make_byte, i, m](
+                    net::Connection&, const net::Buffer& buffer) {
+                    ASSERT_EQ(m, received[i]);
+                    ASSERT_EQ(sizes[m % 3], buffer.size());
+                    size_t k = 0;
+                    while (k < buffer.size() &&
+                           buffer[k] == make_byte(net->my_host_rank(), m, k))
+                        ++k;
+                    ASSERT_EQ(buffer.size(), k);
+                    ++received[i], ++num_received;
+                });
+        }
+    }
+
+    while (num_received < (net->num_hosts() - 1) * num_messages ||
+           dispatcher->HasAsyncWrites()) {
+        dispatcher->Dispatch();
+    }
+}
+
+//! urgent asynchronous writes pass the queued writes, except the first one.
+//! Only the tcp dispatchers reorder writes.
+void TestDispatcherAsyncWriteUrgent(net::Group* net) {
+    mem::Manager mem_manager(nullptr, "Dispatcher");
+    std::unique_ptr<net::Dispatcher>
+    dispatcher = net->ConstructDispatcher(mem_manager);
+
+    // queue two normal and two urgent messages to all other hosts
+    for (size_t i = 0; i < net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        for (size_t m = 0; m < 4; ++m) {
+            net::Buffer buffer(&m, sizeof(m));
+            if (m < 2)
+                dispatcher->AsyncWrite(net->connection(i), std::move(buffer));
+            else
+                dispatcher->AsyncWriteUrgent(
+                    net->connection(i), std::move(buffer));
+        }
+    }
+
+    std::vector<std::vector<size_t> > received(net->num_hosts());
+    size_t num_received = 0;
+
+    for (size_t i = 0; i != net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        for (size_t m = 0; m < 4; ++m) {
+            dispatcher->AsyncRead(
+                net->connection(i), sizeof(size_t),
+                [&received, &num_received, i](
+                    net::Connection&, const net::Buffer& buffer) {
+                    received[i].push_back(
+                        *reinterpret_cast<const size_t*>(buffer.data()));
+                    ++num_received;
+                });
+        }
+    }
+
+    while (num_received < 4 * (net->num_hosts() - 1) ||
+           dispatcher->HasAsyncWrites()) {
+        dispatcher->Dispatch();
+    }
+
+    for (size_t i = 0; i != net->num_hosts(); ++i)
+    {
+        if (i == net->my_host_rank()) continue;
+        ASSERT_EQ(std::vector<size_t>({ 0, 2, 3, 1 }), received[i]);
+    }
+}
+
 /******************************************************************************/
 // DispatcherThread tests
 
@@ -250,6 +584,46 @@ static void TestDispatcherLaunchAndTerminate(net::Group* net) {
     std::this_thread::sleep_for(std::chrono::microseconds(1));
 }
 
+//! enqueue async messages on a DispatcherThread after it became idle, which
+//! must wake it up.
+static void TestDispatcherThreadIdleWakeup(net::Group* net) {
+    static constexpr size_t rounds = 3;
+
+    mem::Manager mem_manager_(nullptr, "DispatcherTest");
+    net::DispatcherThread disp(mem_manager_, *net, "dispatcher");
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t received = 0;
+
+    for (size_t r = 0; r < rounds; ++r) {
+        // let the dispatcher become idle
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        for (size_t i = 0; i < net->num_hosts(); ++i) {
+            if (i == net->my_host_rank()) continue;
+            disp.AsyncWrite(net->connection(i), net::Buffer(&r, sizeof(r)));
+        }
+
+        for (size_t i = 0; i < net->num_hosts(); ++i) {
+            if (i == net->my_host_rank()) continue;
+            disp.AsyncRead(
+                net->connection(i), sizeof(size_t),
+                [&, r](net::Connection&, net::Buffer&& b) {
+                    ASSERT_EQ(r, *reinterpret_cast<const size_t*>(b.data()));
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ++received;
+                    cv.notify_one();
+                });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() {
+                    return received == (r + 1) * (net->num_hosts() - 1);
+                });
+    }
+}
+
 //! use DispatcherThread to send and receive messages asynchronously.
 //! this test produces a data race condition, which is probably a problem of
 //! std::future
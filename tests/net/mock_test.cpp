@@ -91,12 +91,39 @@ TEST(MockGroup, AllReduceString) {
 TEST(MockGroup, AllReduceHypercubeString) {
     MockTest(TestAllReduceHypercubeString);
 }
+TEST(MockGroup, HypercubeLargeValues) {
+    MockTest(TestHypercubeLargeValues);
+}
+TEST(MockGroup, BroadcastLargeVector) {
+    MockTest(TestBroadcastLargeVector);
+}
+TEST(MockGroup, AllGatherRing) {
+    MockTest(TestAllGatherRing);
+}
+TEST(MockGroup, AllReduceElementwise) {
+    MockTest(TestAllReduceElementwise);
+}
+TEST(MockGroup, TopologyCollectives) {
+    MockTest(TestTopologyCollectives);
+}
 TEST(MockGroup, DispatcherSyncSendAsyncRead) {
     MockTest(TestDispatcherSyncSendAsyncRead);
 }
+TEST(MockGroup, DispatcherLargeAsyncMessages) {
+    MockTest(TestDispatcherLargeAsyncMessages);
+}
+TEST(MockGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    MockTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
+TEST(MockGroup, DispatcherRecurringSmallMessages) {
+    MockTest(TestDispatcherRecurringSmallMessages);
+}
 TEST(MockGroup, DispatcherLaunchAndTerminate) {
     MockTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(MockGroup, DispatcherThreadIdleWakeup) {
+    MockTest(TestDispatcherThreadIdleWakeup);
+}
 TEST(MockGroup, SingleThreadPrefixSum) {
     MockTestLess(TestSingleThreadPrefixSum);
 }
@@ -109,6 +136,9 @@ TEST(MockGroup, SingleThreadBroadcast) {
 TEST(MockGroup, MultiThreadBroadcast) {
     MockTestLess(TestMultiThreadBroadcast);
 }
+TEST(MockGroup, MultiThreadBroadcastShared) {
+    MockTestLess(TestMultiThreadBroadcastShared);
+}
 TEST(MockGroup, MultiThreadReduce) {
     MockTestLess(TestMultiThreadReduce);
 }
@@ -118,6 +148,9 @@ TEST(MockGroup, SingleThreadAllReduce) {
 TEST(MockGroup, MultiThreadAllReduce) {
     MockTestLess(TestMultiThreadAllReduce);
 }
+TEST(MockGroup, MultiThreadAllReduceElementwise) {
+    MockTestLess(TestMultiThreadAllReduceElementwise);
+}
 TEST(MockGroup, MultiThreadPrefixSum) {
     MockTestLess(TestMultiThreadPrefixSum);
 }
@@ -130,6 +163,9 @@ TEST(MockGroup, PredecessorFewItems) {
 TEST(MockGroup, PredecessorOneItem) {
     MockTestLess(TestPredecessorOneItem);
 }
+TEST(MockGroup, MultiThreadAsyncCollectives) {
+    MockTestLess(TestMultiThreadAsyncCollectives);
+}
 TEST(MockGroup, HardcoreRaceConditionTest) {
     MockTestLess(TestHardcoreRaceConditionTest);
 }
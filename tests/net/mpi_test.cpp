@@ -93,12 +93,39 @@ TEST(MpiGroup, AllReduceString) {
 TEST(MpiGroup, AllReduceHypercubeString) {
     MpiTest(TestAllReduceHypercubeString);
 }
+TEST(MpiGroup, HypercubeLargeValues) {
+    MpiTest(TestHypercubeLargeValues);
+}
+TEST(MpiGroup, BroadcastLargeVector) {
+    MpiTest(TestBroadcastLargeVector);
+}
+TEST(MpiGroup, AllGatherRing) {
+    MpiTest(TestAllGatherRing);
+}
+TEST(MpiGroup, AllReduceElementwise) {
+    MpiTest(TestAllReduceElementwise);
+}
+TEST(MpiGroup, TopologyCollectives) {
+    MpiTest(TestTopologyCollectives);
+}
 TEST(MpiGroup, DispatcherSyncSendAsyncRead) {
     MpiTest(TestDispatcherSyncSendAsyncRead);
 }
+TEST(MpiGroup, DispatcherLargeAsyncMessages) {
+    MpiTest(TestDispatcherLargeAsyncMessages);
+}
+TEST(MpiGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    MpiTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
+TEST(MpiGroup, DispatcherRecurringSmallMessages) {
+    MpiTest(TestDispatcherRecurringSmallMessages);
+}
 TEST(MpiGroup, DispatcherLaunchAndTerminate) {
     MpiTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(MpiGroup, DispatcherThreadIdleWakeup) {
+    MpiTest(TestDispatcherThreadIdleWakeup);
+}
 TEST(MpiGroup, SingleThreadPrefixSum) {
     MpiTest(TestSingleThreadPrefixSum);
 }
@@ -111,6 +138,9 @@ TEST(MpiGroup, SingleThreadBroadcast) {
 TEST(MpiGroup, MultiThreadBroadcast) {
     MpiTest(TestMultiThreadBroadcast);
 }
+TEST(MpiGroup, MultiThreadBroadcastShared) {
+    MpiTest(TestMultiThreadBroadcastShared);
+}
 TEST(MpiGroup, MultiThreadReduce) {
     MpiTest(TestMultiThreadReduce);
 }
@@ -120,6 +150,9 @@ TEST(MpiGroup, SingleThreadAllReduce) {
 TEST(MpiGroup, MultiThreadAllReduce) {
     MpiTest(TestMultiThreadAllReduce);
 }
+TEST(MpiGroup, MultiThreadAllReduceElementwise) {
+    MpiTest(TestMultiThreadAllReduceElementwise);
+}
 TEST(MpiGroup, MultiThreadPrefixSum) {
     MpiTest(TestMultiThreadPrefixSum);
 }
@@ -132,6 +165,9 @@ TEST(MpiGroup, PredecessorFewItems) {
 TEST(MpiGroup, PredecessorOneItem) {
     MpiTest(TestPredecessorOneItem);
 }
+TEST(MpiGroup, MultiThreadAsyncCollectives) {
+    MpiTest(TestMultiThreadAsyncCollectives);
+}
 TEST(MpiGroup, HardcoreRaceConditionTest) {
     MpiTest(TestHardcoreRaceConditionTest);
 }
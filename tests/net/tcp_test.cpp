@@ -11,9 +11,15 @@
 #include <gtest/gtest.h>
 #include <thrill/mem/manager.hpp>
 #include <thrill/net/dispatcher_thread.hpp>
+#include <thrill/net/tcp/construct.hpp>
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
 #include <thrill/net/tcp/group.hpp>
 #include <thrill/net/tcp/select_dispatcher.hpp>
 
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstdlib>
 #include <random>
 #include <string>
 #include <thread>
@@ -83,12 +89,39 @@ TEST(RealTcpGroup, AllReduceString) {
 TEST(RealTcpGroup, AllReduceHypercubeString) {
     RealGroupTest(TestAllReduceHypercubeString);
 }
+TEST(RealTcpGroup, HypercubeLargeValues) {
+    RealGroupTest(TestHypercubeLargeValues);
+}
+TEST(RealTcpGroup, BroadcastLargeVector) {
+    RealGroupTest(TestBroadcastLargeVector);
+}
+TEST(RealTcpGroup, AllGatherRing) {
+    RealGroupTest(TestAllGatherRing);
+}
+TEST(RealTcpGroup, AllReduceElementwise) {
+    RealGroupTest(TestAllReduceElementwise);
+}
+TEST(RealTcpGroup, TopologyCollectives) {
+    RealGroupTest(TestTopologyCollectives);
+}
 TEST(RealTcpGroup, DispatcherSyncSendAsyncRead) {
     RealGroupTest(TestDispatcherSyncSendAsyncRead);
 }
+TEST(RealTcpGroup, DispatcherLargeAsyncMessages) {
+    RealGroupTest(TestDispatcherLargeAsyncMessages);
+}
+TEST(RealTcpGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    RealGroupTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
+TEST(RealTcpGroup, DispatcherRecurringSmallMessages) {
+    RealGroupTest(TestDispatcherRecurringSmallMessages);
+}
 TEST(RealTcpGroup, DispatcherLaunchAndTerminate) {
     RealGroupTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(RealTcpGroup, DispatcherThreadIdleWakeup) {
+    RealGroupTest(TestDispatcherThreadIdleWakeup);
+}
 TEST(LocalTcpGroup, NoOperation) {
     LocalGroupTest(TestNoOperation);
 }
@@ -125,12 +158,42 @@ TEST(LocalTcpGroup, AllReduceString) {
 TEST(LocalTcpGroup, AllReduceHypercubeString) {
     LocalGroupTest(TestAllReduceHypercubeString);
 }
+TEST(LocalTcpGroup, HypercubeLargeValues) {
+    LocalGroupTest(TestHypercubeLargeValues);
+}
+TEST(LocalTcpGroup, BroadcastLargeVector) {
+    LocalGroupTest(TestBroadcastLargeVector);
+}
+TEST(LocalTcpGroup, AllGatherRing) {
+    LocalGroupTest(TestAllGatherRing);
+}
+TEST(LocalTcpGroup, AllReduceElementwise) {
+    LocalGroupTest(TestAllReduceElementwise);
+}
+TEST(LocalTcpGroup, TopologyCollectives) {
+    LocalGroupTest(TestTopologyCollectives);
+}
 TEST(LocalTcpGroup, DispatcherSyncSendAsyncRead) {
     LocalGroupTest(TestDispatcherSyncSendAsyncRead);
 }
+TEST(LocalTcpGroup, DispatcherLargeAsyncMessages) {
+    LocalGroupTest(TestDispatcherLargeAsyncMessages);
+}
+TEST(LocalTcpGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    LocalGroupTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
+TEST(LocalTcpGroup, DispatcherRecurringSmallMessages) {
+    LocalGroupTest(TestDispatcherRecurringSmallMessages);
+}
+TEST(LocalTcpGroup, DispatcherAsyncWriteUrgent) {
+    LocalGroupTest(TestDispatcherAsyncWriteUrgent);
+}
 TEST(LocalTcpGroup, DispatcherLaunchAndTerminate) {
     LocalGroupTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(LocalTcpGroup, DispatcherThreadIdleWakeup) {
+    LocalGroupTest(TestDispatcherThreadIdleWakeup);
+}
 TEST(LocalTcpGroup, SingleThreadPrefixSum) {
     LocalGroupTest(TestSingleThreadPrefixSum);
 }
@@ -143,6 +206,9 @@ TEST(LocalTcpGroup, SingleThreadBroadcast) {
 TEST(LocalTcpGroup, MultiThreadBroadcast) {
     LocalGroupTest(TestMultiThreadBroadcast);
 }
+TEST(LocalTcpGroup, MultiThreadBroadcastShared) {
+    LocalGroupTest(TestMultiThreadBroadcastShared);
+}
 TEST(LocalTcpGroup, MultiThreadReduce) {
     LocalGroupTest(TestMultiThreadReduce);
 }
@@ -152,6 +218,9 @@ TEST(LocalTcpGroup, SingleThreadAllReduce) {
 TEST(LocalTcpGroup, MultiThreadAllReduce) {
     LocalGroupTest(TestMultiThreadAllReduce);
 }
+TEST(LocalTcpGroup, MultiThreadAllReduceElementwise) {
+    LocalGroupTest(TestMultiThreadAllReduceElementwise);
+}
 TEST(LocalTcpGroup, MultiThreadPrefixSum) {
     LocalGroupTest(TestMultiThreadPrefixSum);
 }
@@ -164,9 +233,152 @@ TEST(LocalTcpGroup, PredecessorFewItems) {
 TEST(LocalTcpGroup, PredecessorOneItem) {
     LocalGroupTest(TestPredecessorOneItem);
 }
+TEST(LocalTcpGroup, MultiThreadAsyncCollectives) {
+    LocalGroupTest(TestMultiThreadAsyncCollectives);
+}
 TEST(LocalTcpGroup, HardcoreRaceConditionTest) {
     LocalGroupTest(TestHardcoreRaceConditionTest);
 }
 // [[[end]]]
 
+TEST(RealTcpGroup, ConstructStaggeredStartup) {
+    static constexpr size_t num_hosts = 6, group_count = 2;
+
+    std::default_random_engine generator(std::random_device { } ());
+    std::uniform_int_distribution<int> distribution(10000, 30000);
+    const size_t port_base = distribution(generator);
+
+    std::vector<std::string> endpoints;
+    for (size_t i = 0; i < num_hosts; ++i)
+        endpoints.push_back("127.0.0.1:" + std::to_string(port_base + i));
+
+    // hosts start one after another, such that early hosts have to retry
+    // connecting to later ones.
+    std::vector<std::vector<std::unique_ptr<net::tcp::Group> > > groups(
+        group_count);
+    for (size_t j = 0; j < group_count; ++j) groups[j].resize(num_hosts);
+    std::vector<std::thread> threads(num_hosts);
+    for (size_t i = 0; i < num_hosts; ++i) {
+        threads[i] = std::thread(
+            [i, &endpoints, &groups]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(40 * i));
+                std::unique_ptr<net::tcp::Group> g[group_count];
+                net::tcp::Construct(i, endpoints, g, group_count);
+                for (size_t j = 0; j < group_count; ++j)
+                    groups[j][i] = std::move(g[j]);
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    for (size_t j = 0; j < group_count; ++j) {
+        net::ExecuteGroupThreads(
+            groups[j], std::function<void(net::Group*)>(TestSendRecvCyclic));
+    }
+}
+
+/******************************************************************************/
+// Connections between co-located hosts selected by THRILL_NET_LOCAL_SOCKETS
+
+//! construct a real TCP mesh on localhost and check that the peers are
+//! connected by sockets of the given address family.
+static void LocalSocketsGroupTest(const char* local_sockets, int family) {
+    setenv("THRILL_NET_LOCAL_SOCKETS", local_sockets, /* overwrite */ 1);
+    std::vector<std::unique_ptr<net::tcp::Group> > groups =
+        net::tcp::Group::ConstructLocalRealTCPMesh(4);
+    unsetenv("THRILL_NET_LOCAL_SOCKETS");
+
+    for (std::unique_ptr<net::tcp::Group>& g : groups) {
+        for (size_t id = 0; id < g->num_hosts(); ++id) {
+            if (id == g->my_host_rank()) continue;
+
+            struct sockaddr_storage sa;
+            socklen_t salen = sizeof(sa);
+            ASSERT_EQ(0, getsockname(g->tcp_connection(id).GetSocket().fd(),
+                                     reinterpret_cast<struct sockaddr*>(&sa),
+                                     &salen));
+            ASSERT_EQ(family, sa.ss_family);
+        }
+    }
+
+    net::ExecuteGroupThreads(
+        groups, std::function<void(net::Group*)>(
+            [](net::Group* net) {
+                TestSendRecvCyclic(net);
+                TestDispatcherLargeAsyncMessages(net);
+            }));
+}
+
+TEST(RealTcpGroup, ConstructWithLocalSockets) {
+#if defined(__linux__)
+    LocalSocketsGroupTest("1", AF_UNIX);
+#else
+    LocalSocketsGroupTest("1", AF_INET);
+#endif
+}
+
+TEST(RealTcpGroup, ConstructWithoutLocalSockets) {
+    LocalSocketsGroupTest("0", AF_INET);
+}
+
+/******************************************************************************/
+// Dispatcher backends selected by THRILL_NET_DISPATCHER
+
+//! run the thread_function on a local TCP group, whose dispatchers are of the
+//! given kind.
+static void DispatcherGroupTest(
+    const char* dispatcher,
+    const std::function<void(net::Group*)>& thread_function) {
+    setenv("THRILL_NET_DISPATCHER", dispatcher, /* overwrite */ 1);
+    LocalGroupTest(thread_function);
+    unsetenv("THRILL_NET_DISPATCHER");
+}
+
+TEST(TcpDispatcher, ConstructByEnvironment) {
+    mem::Manager mem_manager(nullptr, "Dispatcher");
+    std::vector<std::unique_ptr<net::tcp::Group> > groups =
+        net::tcp::Group::ConstructLoopbackMesh(2);
+
+    setenv("THRILL_NET_DISPATCHER", "select", /* overwrite */ 1);
+    ASSERT_TRUE(dynamic_cast<net::tcp::SelectDispatcher*>(
+                    groups[0]->ConstructDispatcher(mem_manager).get()));
+
+#if THRILL_HAVE_NET_EPOLL
+    setenv("THRILL_NET_DISPATCHER", "epoll", /* overwrite */ 1);
+    ASSERT_TRUE(dynamic_cast<net::tcp::EpollDispatcher*>(
+                    groups[0]->ConstructDispatcher(mem_manager).get()));
+
+    // epoll is the default
+    unsetenv("THRILL_NET_DISPATCHER");
+    ASSERT_TRUE(dynamic_cast<net::tcp::EpollDispatcher*>(
+                    groups[0]->ConstructDispatcher(mem_manager).get()));
+#endif
+
+    setenv("THRILL_NET_DISPATCHER", "poll", /* overwrite */ 1);
+    ASSERT_THROW(groups[0]->ConstructDispatcher(mem_manager),
+                 net::Exception);
+    unsetenv("THRILL_NET_DISPATCHER");
+}
+
+TEST(TcpDispatcher, SelectSyncSendAsyncRead) {
+    DispatcherGroupTest("select", TestDispatcherSyncSendAsyncRead);
+}
+TEST(TcpDispatcher, SelectLargeAsyncMessages) {
+    DispatcherGroupTest("select", TestDispatcherLargeAsyncMessages);
+}
+TEST(TcpDispatcher, SelectAsyncWriteUrgent) {
+    DispatcherGroupTest("select", TestDispatcherAsyncWriteUrgent);
+}
+
+#if THRILL_HAVE_NET_EPOLL
+TEST(TcpDispatcher, EpollSyncSendAsyncRead) {
+    DispatcherGroupTest("epoll", TestDispatcherSyncSendAsyncRead);
+}
+TEST(TcpDispatcher, EpollLargeAsyncMessages) {
+    DispatcherGroupTest("epoll", TestDispatcherLargeAsyncMessages);
+}
+TEST(TcpDispatcher, EpollAsyncWriteUrgent) {
+    DispatcherGroupTest("epoll", TestDispatcherAsyncWriteUrgent);
+}
+#endif
+
 /******************************************************************************/
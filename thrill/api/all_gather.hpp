@@ -15,13 +15,22 @@
 
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/data/file.hpp>
 
+#include <memory>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
 /*!
+ * A ActionNode which collects all items on all workers. The items are stored
+ * in a local File first. Small DIAs are sent directly to all workers, larger
+ * ones around a ring: each worker sends its Blocks to the next one and forwards
+ * the Blocks it receives from the previous one, such that each worker only
+ * sends and receives the total data once.
+ *
  * \ingroup api_layer
  */
 template <typename ParentDIA>
@@ -34,12 +43,30 @@ public:
     //! input and output type is the parent's output value type.
     using ValueType = typename ParentDIA::ValueType;
 
+    //! minimum total size in bytes for the ring
+    static constexpr size_t ring_min_bytes = 4 * 1024 * 1024;
+
     AllGatherNode(const ParentDIA& parent,
                   std::vector<ValueType>* out_vector)
         : ActionNode(parent.ctx(), "AllGather",
                      { parent.id() }, { parent.node() }),
           out_vector_(out_vector)
     {
+        Hook(parent);
+    }
+
+    //! Constructor for AllGatherShared(): sends the items only to the first
+    //! worker of each host, which shares its vector with the other workers.
+    AllGatherNode(const ParentDIA& parent,
+                  std::shared_ptr<const std::vector<ValueType> >* out_shared)
+        : ActionNode(parent.ctx(), "AllGatherShared",
+                     { parent.id() }, { parent.node() }),
+          out_shared_(out_shared), stride_(context_.workers_per_host())
+    {
+        Hook(parent);
+    }
+
+    void Hook(const ParentDIA& parent) {
         auto pre_op_function = [this](const ValueType& input) {
                                    PreOp(input);
                                };
@@ -50,50 +77,144 @@ public:
         parent.node()->AddChild(this, lop_chain);
     }
 
-    void StartPreOp(size_t /* id */) final {
-        emitters_ = stream_->GetWriters();
-    }
-
     void PreOp(const ValueType& element) {
-        for (size_t i = 0; i < emitters_.size(); i++) {
-            emitters_[i].Put(element);
-        }
+        writer_.Put(element);
     }
 
     bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
         if (!ParentDIA::stack_empty) return false;
-        for (size_t i = 0; i < emitters_.size(); i++) {
-            emitters_[i].AppendBlocks(file.blocks());
-        }
+        assert(file_.num_items() == 0);
+        file_ = file.Copy();
         return true;
     }
 
     void StopPreOp(size_t /* id */) final {
-        // data has been pushed during pre-op -> close emitters
-        for (size_t i = 0; i < emitters_.size(); i++) {
-            emitters_[i].Close();
-        }
+        writer_.Close();
     }
 
     //! Closes the output file
     void Execute() final {
+        size_t p = context_.num_workers();
+        size_t total_bytes = context_.net.AllReduce(file_.size_bytes());
 
-        bool consume = false;
-        auto reader = stream_->GetCatReader(consume);
+        std::vector<data::CatStream::Writer> writers = stream_->GetWriters();
+
+        if (stride_ != 1 || p <= 2 || total_bytes < ring_min_bytes)
+            return ExecuteDirect(writers);
+
+        // item counts and byte sizes of all workers, to locate their items
+        // in the ring.
+        size_t rank = context_.my_rank();
+        std::vector<size_t> counts(2 * p);
+        counts[rank] = file_.num_items();
+        counts[p + rank] = file_.size_bytes();
+        counts = context_.net.AllReduce(
+            counts, common::ComponentSum<std::vector<size_t> >());
+
+        size_t right = (rank + 1) % p, left = (rank + p - 1) % p;
+        for (size_t i = 0; i < p; ++i) {
+            if (i != right) writers[i].Close();
+        }
+        writers[right].AppendBlocks(file_.blocks());
+
+        // the Blocks from the left arrive in the order of the workers left,
+        // left - 1, ..., right. Forward all but those of the right neighbor,
+        // which start after forward_bytes bytes. The writer to the right must
+        // be closed right after forwarding, and not when the left neighbor
+        // closes, since that would wait around the whole ring.
+        size_t forward_bytes = total_bytes - counts[p + rank] - counts[p + right];
+
+        data::File received = context_.GetFile(this);
+        std::vector<data::CatStream::Reader> readers = stream_->GetReaders();
+
+        size_t bytes = 0;
+        if (forward_bytes == 0) writers[right].Close();
+
+        data::PinnedBlock pb;
+        while ((pb = readers[left].source().NextBlock()).IsValid()) {
+            data::Block b = std::move(pb).MoveToBlock();
+            if (bytes < forward_bytes) {
+                writers[right].AppendBlock(b);
+                bytes += b.size();
+                if (bytes >= forward_bytes) writers[right].Close();
+            }
+            received.AppendBlock(std::move(b));
+        }
+        assert(bytes == forward_bytes);
+
+        // index of the first item of each worker in received
+        std::vector<size_t> first(p);
+        for (size_t j = 1, index = 0; j < p; ++j) {
+            size_t w = (rank + p - j) % p;
+            first[w] = index;
+            index += counts[w];
+        }
 
-        while (reader.HasNext()) {
-            out_vector_->push_back(reader.template Next<ValueType>());
+        for (size_t w = 0; w < p; ++w) {
+            if (w == rank) {
+                auto reader = file_.GetKeepReader();
+                while (reader.HasNext())
+                    out_vector_->push_back(reader.template Next<ValueType>());
+            }
+            else if (counts[w] != 0) {
+                auto reader = received.GetReaderAt<ValueType>(first[w]);
+                for (size_t i = 0; i < counts[w]; ++i)
+                    out_vector_->push_back(reader.template Next<ValueType>());
+            }
         }
+        file_.Clear();
     }
 
 private:
     //! Vector pointer to write elements to.
-    std::vector<ValueType>* out_vector_;
+    std::vector<ValueType>* out_vector_ = nullptr;
+    //! Shared vector pointer to write elements to, for AllGatherShared().
+    std::shared_ptr<const std::vector<ValueType> >* out_shared_ = nullptr;
+    //! send elements to every stride_-th worker.
+    size_t stride_ = 1;
+
+    //! local items
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
 
     data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
-    std::vector<data::CatStream::Writer> emitters_;
 
     static constexpr bool debug = false;
+
+    //! send the local Blocks directly to every stride_-th worker.
+    void ExecuteDirect(std::vector<data::CatStream::Writer>& writers) {
+        for (size_t i = 0; i < writers.size(); i += stride_) {
+            writers[i].AppendBlocks(file_.blocks());
+        }
+        for (size_t i = 0; i < writers.size(); i++) {
+            writers[i].Close();
+        }
+        file_.Clear();
+
+        bool consume = false;
+        auto reader = stream_->GetCatReader(consume);
+
+        if (out_shared_ == nullptr) {
+            while (reader.HasNext()) {
+                out_vector_->push_back(reader.template Next<ValueType>());
+            }
+            return;
+        }
+
+        // only the first worker of each host receives items.
+        std::shared_ptr<std::vector<ValueType> > vec;
+        if (context_.local_worker_id() == 0) {
+            vec = std::make_shared<std::vector<ValueType> >();
+            while (reader.HasNext()) {
+                vec->push_back(reader.template Next<ValueType>());
+            }
+        }
+        assert(!reader.HasNext());
+
+        *out_shared_ = context_.net.LocalBroadcast(
+            std::shared_ptr<const std::vector<ValueType> >(std::move(vec)));
+    }
 };
 
 template <typename ValueType, typename Stack>
@@ -122,6 +243,22 @@ void DIA<ValueType, Stack>::AllGather(std::vector<ValueType>* out_vector) const
     node->RunScope();
 }
 
+template <typename ValueType, typename Stack>
+std::shared_ptr<const std::vector<ValueType> >
+DIA<ValueType, Stack>::AllGatherShared() const {
+    assert(IsValid());
+
+    using AllGatherNode = api::AllGatherNode<DIA>;
+
+    std::shared_ptr<const std::vector<ValueType> > output;
+
+    auto node = common::MakeCounting<AllGatherNode>(*this, &output);
+
+    node->RunScope();
+
+    return output;
+}
+
 } // namespace api
 } // namespace thrill
 
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * thrill/api/approx_count_distinct.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_APPROX_COUNT_DISTINCT_HEADER
+#define THRILL_API_APPROX_COUNT_DISTINCT_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/hyperloglog.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ParentDIA, typename HashFunction>
+class ApproxCountDistinctNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+public:
+    ApproxCountDistinctNode(const ParentDIA& parent,
+                            const char* label,
+                            unsigned precision,
+                            const HashFunction& hash_function)
+        : ActionNode(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          hll_(precision), hash_function_(hash_function)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             hll_.Insert(hash_function_(input));
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! Merges the registers of all workers and estimates the count.
+    void Execute() final {
+        std::vector<uint8_t> registers = context_.net.AllReduce(
+            hll_.registers(),
+            [](const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+                std::vector<uint8_t> out = a;
+                common::HyperLogLog::MergeRegisters(&out, b);
+                return out;
+            });
+
+        result_ = static_cast<size_t>(
+            std::llround(common::HyperLogLog::Estimate(registers)));
+
+        LOG << "ApproxCountDistinct estimated " << result_ << " items";
+    }
+
+    //! Returns the estimated number of distinct items.
+    size_t result() const { return result_; }
+
+private:
+    //! local sketch
+    common::HyperLogLog hll_;
+    //! hash function of the items
+    HashFunction hash_function_;
+    //! global estimate
+    size_t result_ = 0;
+};
+
+template <typename ValueType, typename Stack>
+template <typename HashFunction>
+size_t DIA<ValueType, Stack>::ApproxCountDistinct(
+    unsigned precision, const HashFunction &hash_function) const {
+    assert(IsValid());
+
+    using ApproxCountDistinctNode =
+              api::ApproxCountDistinctNode<DIA, HashFunction>;
+
+    auto node = common::MakeCounting<ApproxCountDistinctNode>(
+        *this, "ApproxCountDistinct", precision, hash_function);
+
+    node->RunScope();
+
+    return node->result();
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_APPROX_COUNT_DISTINCT_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * thrill/api/approx_quantiles.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_APPROX_QUANTILES_HEADER
+#define THRILL_API_APPROX_QUANTILES_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/quantile_sketch.hpp>
+
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ParentDIA, typename CompareFunction>
+class ApproxQuantilesNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input and result type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+    using Sketch = common::QuantileSketch<ValueType, CompareFunction>;
+
+public:
+    ApproxQuantilesNode(const ParentDIA& parent,
+                        const char* label,
+                        const std::vector<double>& qs,
+                        size_t k,
+                        const CompareFunction& compare_function)
+        : ActionNode(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          qs_(qs), k_(k), compare_function_(compare_function),
+          sketch_(k, compare_function)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             sketch_.Insert(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! Merges the sketches of all workers and calculates the quantiles.
+    void Execute() final {
+        size_t k = k_;
+        CompareFunction compare_function = compare_function_;
+
+        typename Sketch::Levels levels = context_.net.AllReduce(
+            sketch_.levels(),
+            [k, compare_function](const typename Sketch::Levels& a,
+                                  const typename Sketch::Levels& b) {
+                Sketch sketch(k, compare_function);
+                sketch.Merge(a);
+                sketch.Merge(b);
+                return sketch.levels();
+            });
+
+        Sketch global(k_, compare_function_);
+        global.Merge(levels);
+        if (!global.empty())
+            result_ = global.Quantiles(qs_);
+    }
+
+    //! Returns the global quantiles.
+    std::vector<ValueType>& result() {
+        return result_;
+    }
+
+private:
+    //! requested quantiles
+    std::vector<double> qs_;
+    //! accuracy parameter of the sketch
+    size_t k_;
+    //! compare function
+    CompareFunction compare_function_;
+    //! local sketch
+    Sketch sketch_;
+    //! global result
+    std::vector<ValueType> result_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+std::vector<ValueType> DIA<ValueType, Stack>::ApproxQuantiles(
+    const std::vector<double>& qs, size_t k,
+    const CompareFunction &compare_function) const {
+    assert(IsValid());
+
+    using ApproxQuantilesNode = api::ApproxQuantilesNode<DIA, CompareFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0>
+            >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    auto node = common::MakeCounting<ApproxQuantilesNode>(
+        *this, "ApproxQuantiles", qs, k, compare_function);
+
+    node->RunScope();
+
+    return std::move(node->result());
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_APPROX_QUANTILES_HEADER
+
+/******************************************************************************/
@@ -14,6 +14,7 @@
 
 #include <thrill/api/dia.hpp>
 #include <thrill/common/functional.hpp>
+#include <thrill/common/philox.hpp>
 
 #include <random>
 
@@ -80,7 +81,7 @@ private:
     // the naive method
     const bool use_skip_;
     // Random generator
-    std::default_random_engine engine_ { std::random_device { } () };
+    common::PhiloxEngine engine_ { std::random_device { } () };
     std::bernoulli_distribution simple_dist_;
     std::geometric_distribution<SkipDistValueType> skip_dist_;
     SkipDistValueType skip_remaining_ = -1;
@@ -15,6 +15,7 @@
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dia_node.hpp>
+#include <thrill/data/compressed_file.hpp>
 #include <thrill/data/file.hpp>
 
 #include <string>
@@ -37,7 +38,8 @@ public:
 };
 
 /*!
- * A DOpNode which caches all items in an external file.
+ * A DOpNode which caches all items in an external file, or compressed in RAM
+ * with CacheMode::CompressedMemory.
  *
  * \ingroup api_layer
  */
@@ -51,11 +53,14 @@ public:
     /*!
      * Constructor for a LOpNode. Sets the Context, parents and stack.
      */
-    explicit CacheNode(const ParentDIA& parent)
-        : Super(parent) {
+    CacheNode(const ParentDIA& parent, CacheMode mode)
+        : Super(parent), mode_(mode) {
         // CacheNodes are kept by default.
         Super::consume_counter_ = Super::never_consume_;
 
+        if (mode_ == CacheMode::Pinned)
+            file_.set_eviction_hint(data::EvictionHint::Pinned);
+
         auto save_fn = [this](const ValueType& input) {
                            writer_.Put(input);
                        };
@@ -67,40 +72,77 @@ public:
         if (!ParentDIA::stack_empty) return false;
         assert(file_.num_items() == 0);
         file_ = file.Copy();
+        if (mode_ == CacheMode::Pinned)
+            file_.set_eviction_hint(data::EvictionHint::Pinned);
         return true;
     }
 
     void StopPreOp(size_t /* id */) final {
         // Push local elements to children
         writer_.Close();
+
+        if (mode_ == CacheMode::CompressedMemory) {
+            compressed_.Append(file_);
+            file_.Clear();
+        }
     }
 
     void Execute() final { }
 
     void PushData(bool consume) final {
-        this->PushFile(file_, consume);
+        if (mode_ != CacheMode::CompressedMemory)
+            return this->PushFile(file_, consume);
+
+        // decompress Blocks while reading and push items in batches
+        data::CompressedFile::Reader reader = compressed_.GetReader();
+        std::vector<ValueType> batch;
+        batch.reserve(Super::push_batch_size);
+        while (reader.HasNext()) {
+            batch.clear();
+            while (batch.size() < Super::push_batch_size && reader.HasNext())
+                batch.emplace_back(reader.template Next<ValueType>());
+            this->PushItems(batch.data(), batch.size());
+        }
+        if (consume) compressed_.Clear();
+    }
+
+    void PrefetchData() final {
+        if (mode_ != CacheMode::CompressedMemory)
+            file_.Prefetch();
+    }
+
+    size_t PushDataBytes() final {
+        return mode_ == CacheMode::CompressedMemory
+               ? compressed_.size_bytes() : file_.size_bytes();
     }
 
 private:
+    //! storage of the items
+    CacheMode mode_;
+
     //! Local data file
     data::File file_ { context_.GetFile(this) };
     //! Data writer to local file (only active in PreOp).
     data::File::Writer writer_ { file_.GetWriter() };
+    //! compressed Blocks of file_ for CacheMode::CompressedMemory
+    data::CompressedFile compressed_ {
+        context_.block_pool(), context_.local_worker_id()
+    };
 };
 
 template <typename ValueType, typename Stack>
-DIA<ValueType> DIA<ValueType, Stack>::Cache() const {
+DIA<ValueType> DIA<ValueType, Stack>::Cache(CacheMode mode) const {
     assert(IsValid());
 
 #if !defined(_MSC_VER)
     // skip if this is already a CacheNode. MSVC messes this up.
-    if (stack_empty &&
+    if (mode == CacheMode::Default && stack_empty &&
         dynamic_cast<CacheNodeBase<ValueType>*>(node_.get()) != nullptr) {
         return *this;
     }
 #endif
     return DIA<ValueType>(
-        common::MakeCounting<api::CacheNode<ValueType, DIA> >(*this));
+        common::MakeCounting<api::CacheNode<ValueType, DIA> >(*this, mode));
 }
 
 } // namespace api
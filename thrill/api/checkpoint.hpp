@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * thrill/api/checkpoint.hpp
+ *
+ * DIA::Checkpoint() writes the items of a DIA to persistent storage and
+ * restores them in a restarted job instead of recomputing them.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_CHECKPOINT_HEADER
+#define THRILL_API_CHECKPOINT_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dia_node.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
+#include <thrill/core/background_writer.hpp>
+#include <thrill/core/checkpoint_index.hpp>
+#include <thrill/core/file_io.hpp>
+#include <thrill/data/file.hpp>
+#include <thrill/io/syscall_file.hpp>
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DOpNode which stores all items in a File like a CacheNode, and writes its
+ * Blocks into a checkpoint file per worker. If a restarted job finds complete
+ * checkpoints of all workers, the node instead has no parent and maps the
+ * Blocks of its checkpoint file, hence the parent DIA is never computed.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType>
+class CheckpointNode final : public DIANode<ValueType>
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = DIANode<ValueType>;
+    using Super::context_;
+
+    //! Constructor which stores the parent's items and writes the checkpoint.
+    template <typename ParentDIA>
+    CheckpointNode(const ParentDIA& parent, const std::string& path)
+        : Super(parent.ctx(), "Checkpoint",
+                { parent.id() }, { parent.node() }),
+          path_(path), parent_stack_empty_(ParentDIA::stack_empty) {
+        // CheckpointNodes are kept like CacheNodes.
+        Super::consume_counter_ = Super::never_consume_;
+
+        auto save_fn = [this](const ValueType& input) {
+                           writer_.Put(input);
+                       };
+        auto lop_chain = parent.stack().push(save_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! Constructor which restores the items from the checkpoint.
+    CheckpointNode(Context& ctx, const std::string& path,
+                   core::CheckpointIndex&& index)
+        : Super(ctx, "Checkpoint", { }, { }),
+          path_(path), index_(std::move(index)), restore_(true) {
+        Super::consume_counter_ = Super::never_consume_;
+    }
+
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!parent_stack_empty_) return false;
+        assert(!restore_);
+        assert(file_.num_items() == 0);
+        file_ = file.Copy();
+        return true;
+    }
+
+    void StopPreOp(size_t /* id */) final {
+        writer_.Close();
+        WriteCheckpoint();
+    }
+
+    void Execute() final {
+        if (!restore_) return;
+
+        // map the Blocks of the checkpoint file, they are read on demand.
+        io::FileBasePtr file(
+            new io::SyscallFile(
+                path_, io::FileBase::RDONLY | io::FileBase::NO_LOCK));
+
+        uint64_t offset = 0;
+        for (const core::CheckpointIndex::Block& b : index_.blocks) {
+            data::ByteBlockPtr bbp =
+                context_.block_pool().MapExternalBlock(file, offset, b.size);
+            file_.AppendBlock(
+                data::Block(std::move(bbp), 0, b.size, b.first_item,
+                            b.num_items, b.typecode_verify != 0));
+            offset += b.size;
+        }
+
+        LOG << "CheckpointNode: restored " << file_.num_items()
+            << " items from " << path_;
+    }
+
+    void PushData(bool consume) final {
+        this->PushFile(file_, consume);
+    }
+
+    size_t PushDataBytes() final {
+        return file_.size_bytes();
+    }
+
+private:
+    //! path of this worker's checkpoint file
+    std::string path_;
+    //! index of the checkpoint, if restored
+    core::CheckpointIndex index_;
+    //! whether the items are restored from the checkpoint
+    bool restore_ = false;
+    //! whether the parent's function stack is empty, which is required for
+    //! OnPreOpFile()
+    bool parent_stack_empty_ = false;
+
+    //! Local data file
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+
+    //! write all Blocks of file_ into a temporary file, which is renamed to
+    //! path_ when complete.
+    void WriteCheckpoint() {
+        std::string tmp_path = path_ + ".tmp";
+
+        core::CheckpointIndex index;
+        index.worker = context_.my_rank();
+        index.num_workers = context_.num_workers();
+
+        {
+            core::SysFile file = core::SysFile::OpenForWrite(tmp_path);
+            core::BackgroundWriter bg_writer(core::DefaultWriteBehind());
+
+            for (size_t i = 0; i < file_.num_blocks(); ++i) {
+                data::PinnedBlock b =
+                    file_.block(i).PinWait(context_.local_worker_id());
+                index.blocks.emplace_back(
+                    core::CheckpointIndex::Block {
+                        b.size(), b.first_item_relative(), b.num_items(),
+                        b.typecode_verify()
+                    });
+                bg_writer.Enqueue(
+                    [&file, tmp_path, b]() {
+                        WriteAll(file, tmp_path, b.data_begin(), b.size());
+                    });
+            }
+
+            bg_writer.Enqueue(
+                [&file, tmp_path, idx = index.Serialize()]() {
+                    WriteAll(file, tmp_path, idx.data(), idx.size());
+                });
+            bg_writer.Finish();
+        }
+
+        if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+            throw common::ErrnoException(
+                      "Cannot rename checkpoint file " + tmp_path);
+        }
+
+        LOG << "CheckpointNode: wrote " << file_.num_items()
+            << " items to " << path_;
+    }
+
+    //! write all bytes to the file, throw on errors.
+    static void WriteAll(core::SysFile& file, const std::string& path,
+                         const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size != 0) {
+            ssize_t wb = file.write(p, size);
+            if (wb <= 0) {
+                throw common::ErrnoException(
+                          "Error writing checkpoint file " + path);
+            }
+            p += wb, size -= wb;
+        }
+    }
+};
+
+template <typename ValueType, typename Stack>
+DIA<ValueType> DIA<ValueType, Stack>::Checkpoint(const std::string& path) const {
+    assert(IsValid());
+
+    Context& ctx = context();
+    std::string worker_path =
+        core::CheckpointIndex::WorkerPath(path, ctx.my_rank());
+
+    core::CheckpointIndex index;
+    bool found =
+        core::CheckpointIndex::Read(worker_path, &index) &&
+        index.worker == ctx.my_rank() &&
+        index.num_workers == ctx.num_workers();
+
+    // restore only if the checkpoints of all workers are complete
+    if (ctx.net.AllReduce(size_t(found), common::minimum<size_t>()) != 0) {
+        return DIA<ValueType>(
+            common::MakeCounting<api::CheckpointNode<ValueType> >(
+                ctx, worker_path, std::move(index)));
+    }
+
+    return DIA<ValueType>(
+        common::MakeCounting<api::CheckpointNode<ValueType> >(
+            *this, worker_path));
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_CHECKPOINT_HEADER
+
+/******************************************************************************/
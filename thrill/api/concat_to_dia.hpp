@@ -15,7 +15,10 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/data/serialization.hpp>
 
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -31,27 +34,59 @@ public:
     using Super = SourceNode<ValueType>;
     using Super::context_;
 
+    //! whether the items of PODs is copied into the Blocks of a File,
+    //! which is pushed to children as a whole, instead of keeping the vector.
+    using RawItems = std::integral_constant<
+              bool, data::is_raw_serializable<ValueType>::value &&
+              !std::is_same<ValueType, bool>::value>;
+
     ConcatToDIANode(Context& ctx,
                     const std::vector<ValueType>& in_vector)
         : SourceNode<ValueType>(ctx, "ConcatToDIA"),
-          in_vector_(in_vector)
-    { }
+          file_(ctx.GetFile(this)) {
+        Store(in_vector, RawItems());
+    }
 
     ConcatToDIANode(Context& ctx,
                     std::vector<ValueType>&& in_vector)
         : SourceNode<ValueType>(ctx, "ConcatToDIA"),
-          in_vector_(std::move(in_vector))
-    { }
+          file_(ctx.GetFile(this)) {
+        Store(std::move(in_vector), RawItems());
+    }
 
     void PushData(bool /* consume */) final {
+        if (RawItems::value) {
+            this->PushFile(file_, /* consume */ false);
+            return;
+        }
+
         for (size_t i = 0; i < in_vector_.size(); ++i) {
             this->PushItem(in_vector_[i]);
         }
     }
 
+    size_t PushDataBytes() final { return file_.size_bytes(); }
+
 private:
     //! Vector pointer to read elements from.
     std::vector<ValueType> in_vector_;
+
+    //! File holding the items of PODs
+    data::File file_;
+
+    void Store(const std::vector<ValueType>& v, std::true_type /* raw */) {
+        file_.AppendRawItems(v.data(), v.size());
+    }
+
+    void Store(std::vector<ValueType>&& v, std::true_type /* raw */) {
+        Store(v, std::true_type());
+        std::vector<ValueType>().swap(v);
+    }
+
+    template <typename Vector>
+    void Store(Vector&& v, std::false_type /* raw */) {
+        in_vector_ = std::forward<Vector>(v);
+    }
 };
 
 /*!
@@ -59,6 +94,10 @@ private:
  * CONCATENATES them into a DIA. Use Distribute to actually distribute data from
  * a single worker, ConcatToDIA is a wrapper if the data is already distributed.
  *
+ * Items of PODs are copied into the Blocks of a File, which is pushed to
+ * children as a whole, such that e.g. Sort takes it over without
+ * deserialization.
+ *
  * \param ctx Reference to the Context object
  *
  * \param in_vector Vector to concatenate into a DIA, the contents is COPIED
@@ -80,6 +119,10 @@ auto ConcatToDIA(Context & ctx,
  * CONCATENATES them into a DIA. Use Distribute to actually distribute data from
  * a single worker, ConcatToDIA is a wrapper if the data is already distributed.
  *
+ * Items of PODs are copied into the Blocks of a File, which is pushed to
+ * children as a whole, such that e.g. Sort takes it over without
+ * deserialization.
+ *
  * \param ctx Reference to the Context object
  *
  * \param in_vector Vector to concatenate into a DIA, the contents is MOVED into
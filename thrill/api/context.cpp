@@ -12,10 +12,12 @@
 #include <thrill/api/context.hpp>
 
 #include <thrill/api/dia_base.hpp>
+#include <thrill/common/cgroup.hpp>
 #include <thrill/common/cmdline_parser.hpp>
 #include <thrill/common/linux_proc_stats.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/common/profile_thread.hpp>
 #include <thrill/common/string.hpp>
@@ -61,6 +63,9 @@
 
 #include <algorithm>
 #include <csignal>
+#include <fstream>
+#include <iostream>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <thread>
@@ -129,7 +134,9 @@ RunLoopbackThreads(
         mem::by_string log_prefix = "host " + mem::to_string(host);
         for (size_t worker = 0; worker < workers_per_host; ++worker) {
             threads[host * workers_per_host + worker] = common::CreateThread(
-                [&host_contexts, &job_startpoint, host, worker, log_prefix] {
+                [&host_contexts, &job_startpoint, host, worker, log_prefix,
+                 workers_per_host] {
+                    common::NumaPinWorker(worker, workers_per_host);
                     Context ctx(*host_contexts[host], worker);
                     common::NameThisThread(
                         log_prefix + " worker " + mem::to_string(worker));
@@ -260,7 +267,7 @@ int RunBackendLoopback(
 
     // determine number of loopback hosts
 
-    size_t num_hosts = std::thread::hardware_concurrency();
+    size_t num_hosts = common::AvailableCpuCount();
 
     const char* env_local = getenv("THRILL_LOCAL");
     if (env_local && *env_local) {
@@ -295,7 +302,7 @@ int RunBackendLoopback(
         if (!env_local && !env_workers_per_host) {
             // distribute two threads per worker.
             workers_per_host = 2;
-            num_hosts /= 2;
+            num_hosts = std::max<size_t>(num_hosts / 2, 1);
         }
     }
 
@@ -351,6 +358,9 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
     }
 
     std::vector<std::string> hostlist;
+    // optional rack labels of the hosts, indexes into rack_labels
+    std::vector<std::string> rack_labels;
+    std::vector<size_t> rack_of_host;
 
     if (env_hostlist && *env_hostlist) {
         // first try to split by spaces, then by commas
@@ -360,10 +370,22 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
             list = common::Split(env_hostlist, ',');
         }
 
-        for (const std::string& host : list) {
+        for (std::string host : list) {
             // skip empty splits
             if (host.size() == 0) continue;
 
+            // split off rack label: host:port/rack
+            std::string rack;
+            std::string::size_type slash = host.find('/');
+            if (slash != std::string::npos) {
+                rack = host.substr(slash + 1);
+                host.resize(slash);
+            }
+            std::vector<std::string>::iterator it =
+                std::find(rack_labels.begin(), rack_labels.end(), rack);
+            rack_of_host.push_back(it - rack_labels.begin());
+            if (it == rack_labels.end()) rack_labels.push_back(rack);
+
             if (host.find(':') == std::string::npos) {
                 std::cerr << "Thrill: invalid address \"" << host << "\""
                           << "in THRILL_HOSTLIST. It must contain a port number."
@@ -401,7 +423,23 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
         }
     }
     else {
-        workers_per_host = std::thread::hardware_concurrency();
+        workers_per_host = common::AvailableCpuCount();
+    }
+
+    // number of parallel data connections between each pair of hosts
+    size_t num_connections = 1;
+
+    const char* env_connections = getenv("THRILL_NET_CONNECTIONS");
+
+    if (env_connections && *env_connections) {
+        num_connections = std::strtoul(env_connections, &endptr, 10);
+        if (!endptr || *endptr != 0 || num_connections == 0) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_NET_CONNECTIONS=" << env_connections
+                      << " is not a valid number of connections."
+                      << std::endl;
+            return -1;
+        }
     }
 
     // detect memory config
@@ -419,16 +457,25 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
         std::cerr << ' ' << ep;
     std::cerr << std::endl;
 
-    static constexpr size_t kGroupCount = net::Manager::kGroupCount;
+    // construct TCP network groups, additional connections are extra data
+    // groups.
+    size_t group_count = net::Manager::kGroupCount + num_connections - 1;
 
-    // construct three TCP network groups
-    std::array<std::unique_ptr<net::tcp::Group>, kGroupCount> groups;
-    net::tcp::Construct(
-        my_host_rank, hostlist, groups.data(), net::Manager::kGroupCount);
+    std::vector<std::unique_ptr<net::tcp::Group> > groups(group_count);
+    net::tcp::Construct(my_host_rank, hostlist, groups.data(), group_count);
 
-    std::array<net::GroupPtr, kGroupCount> host_groups = {
-        { std::move(groups[0]), std::move(groups[1]) }
-    };
+    if (rack_labels.size() > 1) {
+        for (size_t g = 0; g < group_count; ++g) {
+            if (groups[g]->SetRacks(rack_of_host)) continue;
+            std::cerr << "Thrill: racks in THRILL_HOSTLIST are not contiguous"
+                      << " ranges of hosts, ignoring them." << std::endl;
+            break;
+        }
+    }
+
+    std::vector<net::GroupPtr> host_groups;
+    for (size_t g = 0; g < group_count; ++g)
+        host_groups.emplace_back(std::move(groups[g]));
 
     // construct HostContext
     HostContext host_context(
@@ -438,7 +485,8 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
     for (size_t worker = 0; worker < workers_per_host; worker++) {
         threads[worker] = common::CreateThread(
-            [&host_context, &job_startpoint, worker] {
+            [&host_context, &job_startpoint, worker, workers_per_host] {
+                common::NumaPinWorker(worker, workers_per_host);
                 Context ctx(host_context, worker);
                 common::NameThisThread("worker " + mem::to_string(worker));
 
@@ -480,7 +528,7 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
         }
     }
     else {
-        workers_per_host = std::thread::hardware_concurrency();
+        workers_per_host = common::AvailableCpuCount();
     }
 
     // detect memory config
@@ -518,7 +566,8 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
 
     for (size_t worker = 0; worker < workers_per_host; worker++) {
         threads[worker] = common::CreateThread(
-            [&host_context, &job_startpoint, worker] {
+            [&host_context, &job_startpoint, worker, workers_per_host] {
+                common::NumaPinWorker(worker, workers_per_host);
                 Context ctx(host_context, worker);
                 common::NameThisThread("host " + mem::to_string(ctx.host_rank())
                                        + " worker " + mem::to_string(worker));
@@ -687,6 +736,78 @@ int Run(const std::function<void(Context&)>& job_startpoint) {
     return -1;
 }
 
+//! the loop which all workers run in RunService()
+static void RunServiceLoop(
+    Context& ctx, const std::map<std::string, ServiceJob>& jobs) {
+
+    // worker 0 reads requests from THRILL_SERVICE_INPUT or stdin
+    std::ifstream file;
+    std::istream* input = &std::cin;
+    if (ctx.my_rank() == 0) {
+        const char* env_input = getenv("THRILL_SERVICE_INPUT");
+        if (env_input && *env_input) {
+            file.open(env_input);
+            if (!file.good())
+                die("Thrill: could not open THRILL_SERVICE_INPUT="
+                    << env_input);
+            input = &file;
+        }
+    }
+
+    size_t job_count = 0;
+
+    for ( ; ; ) {
+        std::string line;
+        if (ctx.my_rank() == 0 && !std::getline(*input, line))
+            line = "quit";
+        line = ctx.net.Broadcast(line);
+
+        std::vector<std::string> args;
+        for (std::string& arg : common::Split(line, ' ')) {
+            if (!arg.empty()) args.emplace_back(std::move(arg));
+        }
+        if (args.empty()) continue;
+        if (args[0] == "quit") break;
+
+        std::string name = args[0];
+        args.erase(args.begin());
+
+        auto it = jobs.find(name);
+        if (it == jobs.end()) {
+            if (ctx.my_rank() == 0)
+                std::cerr << "Thrill: unknown service job \"" << name << "\""
+                          << std::endl;
+            continue;
+        }
+
+        ctx.logger_ << "class" << "Context"
+                    << "event" << "service-job-start"
+                    << "name" << name;
+
+        common::StatsTimerStart timer;
+        it->second(ctx, args);
+
+        // all workers finish the job before the next one starts
+        ctx.net.Barrier();
+        ctx.enable_consume(false);
+        timer.Stop();
+
+        ctx.logger_ << "class" << "Context"
+                    << "event" << "service-job-done"
+                    << "name" << name
+                    << "elapsed" << timer;
+
+        if (ctx.my_rank() == 0) {
+            std::cerr << "Thrill: service job " << ++job_count << " " << name
+                      << " ran " << timer.SecondsDouble() << "s" << std::endl;
+        }
+    }
+}
+
+int RunService(const std::map<std::string, ServiceJob>& jobs) {
+    return Run([&jobs](Context& ctx) { RunServiceLoop(ctx, jobs); });
+}
+
 /******************************************************************************/
 // MemoryConfig
 
@@ -747,6 +868,13 @@ int MemoryConfig::setup_detect() {
             sLOG1 << "getrlimit(): " << strerror(errno);
         }
 #endif
+
+        // limit to the memory of the cgroup, as set by containers or batch
+        // schedulers, to avoid being killed for using more than allowed.
+        uint64_t cgroup_ram = common::CgroupMemoryLimit();
+        if (cgroup_ram != 0 && cgroup_ram * 3 / 4 < ram_) {
+            ram_ = static_cast<size_t>(cgroup_ram * 3 / 4);
+        }
     }
 
     apply();
@@ -792,14 +920,39 @@ void MemoryConfig::print(size_t workers_per_host) const {
 /******************************************************************************/
 // HostContext methods
 
+#if THRILL_HAVE_NET_TCP
+//! pass the host's log lines to the MetricsServer, if one is running.
+static common::JsonLogger::LineTap MetricsTap(MetricsServer* server) {
+    if (!server) return common::JsonLogger::LineTap();
+    return [server](const std::string& line) { server->Update(line); };
+}
+#endif
+
 HostContext::HostContext(
     size_t local_host_id,
     const MemoryConfig& mem_config,
     std::array<net::GroupPtr, net::Manager::kGroupCount>&& groups,
+    size_t workers_per_host)
+    : HostContext(local_host_id, mem_config,
+                  std::vector<net::GroupPtr>(
+                      std::make_move_iterator(groups.begin()),
+                      std::make_move_iterator(groups.end())),
+                  workers_per_host) { }
 
+HostContext::HostContext(
+    size_t local_host_id,
+    const MemoryConfig& mem_config,
+    std::vector<net::GroupPtr>&& groups,
     size_t workers_per_host)
 
-    : base_logger_(MakeHostLogPath(groups[0]->my_host_rank())),
+    :
+#if THRILL_HAVE_NET_TCP
+      metrics_server_(MetricsServer::Create(groups[0]->my_host_rank())),
+      base_logger_(MakeHostLogPath(groups[0]->my_host_rank()),
+                   MetricsTap(metrics_server_.get())),
+#else
+      base_logger_(MakeHostLogPath(groups[0]->my_host_rank())),
+#endif
       logger_(&base_logger_, "host_rank", groups[0]->my_host_rank()),
       profiler_(std::make_unique<common::ProfileThread>()),
       mem_config_(mem_config),
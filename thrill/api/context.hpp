@@ -14,6 +14,7 @@
 #ifndef THRILL_API_CONTEXT_HEADER
 #define THRILL_API_CONTEXT_HEADER
 
+#include <thrill/api/metrics_server.hpp>
 #include <thrill/common/config.hpp>
 #include <thrill/common/defines.hpp>
 #include <thrill/common/json_logger.hpp>
@@ -23,12 +24,14 @@
 #include <thrill/data/file.hpp>
 #include <thrill/data/mix_stream.hpp>
 #include <thrill/data/multiplexer.hpp>
+#include <thrill/mem/stage_arena.hpp>
 #include <thrill/net/flow_control_channel.hpp>
 #include <thrill/net/flow_control_manager.hpp>
 #include <thrill/net/manager.hpp>
 
 #include <cassert>
 #include <functional>
+#include <map>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -87,6 +90,12 @@ public:
                 std::array<net::GroupPtr, net::Manager::kGroupCount>&& groups,
                 size_t workers_per_host);
 
+    //! constructor from existing net Groups, possibly with additional data
+    //! Groups for parallel connections.
+    HostContext(size_t local_host_id, const MemoryConfig& mem_config,
+                std::vector<net::GroupPtr>&& groups,
+                size_t workers_per_host);
+
     //! Construct a number of mock hosts running in this process.
     static std::vector<std::unique_ptr<HostContext> >
     ConstructLoopback(size_t num_hosts, size_t workers_per_host);
@@ -129,6 +138,12 @@ public:
     //! \name Logging System
     //! \{
 
+#if THRILL_HAVE_NET_TCP
+    //! optional HTTP server of profile values, receives all lines of
+    //! base_logger_ and hence must outlive it.
+    std::unique_ptr<MetricsServer> metrics_server_;
+#endif
+
     //! base logger exclusive for this host context
     common::JsonLogger base_logger_;
 
@@ -186,8 +201,15 @@ private:
     //! data multiplexer transmits large amounts of data asynchronously.
     data::Multiplexer data_multiplexer_ {
         mem_manager_, block_pool_, workers_per_host_,
-        net_manager_.GetDataGroup()
+        net_manager_.GetDataGroups()
     };
+
+#if !THRILL_HAVE_THREAD_SANITIZER
+    //! register data_multiplexer_'s profiling method
+    common::ProfileTaskRegistration data_multiplexer_profiler_ {
+        std::chrono::milliseconds(500), *profiler_, &data_multiplexer_
+    };
+#endif
 };
 
 /*!
@@ -350,6 +372,11 @@ public:
     //! returns the host-global memory manager
     mem::Manager& mem_manager() { return mem_manager_; }
 
+    //! arena for temporary data of the current stage, which is released by
+    //! the StageBuilder after each Execute() and PushData(), see
+    //! mem::StageArena.
+    mem::StageArena& stage_arena() { return stage_arena_; }
+
     //! given a global range [0,global_size) and p PEs to split the range, calculate
     //! the [local_begin,local_end) index range assigned to the PE i. Takes the
     //! information from the Context.
@@ -390,6 +417,9 @@ private:
     //! host-global memory manager
     mem::Manager& mem_manager_;
 
+    //! arena for temporary data of the current stage
+    mem::StageArena stage_arena_ { mem_manager_ };
+
     //! net::Manager instance that is shared among workers
     net::Manager& net_manager_;
 
@@ -483,7 +513,9 @@ void RunLocalSameThread(const std::function<void(Context&)>& job_startpoint);
  * THRILL_RANK contains the rank of this worker
  *
  * THRILL_HOSTLIST contains a space- or comma-separated list of host:ports to
- * connect to.
+ * connect to. Each entry may carry a rack label as host:port/rack, then
+ * collectives reduce and broadcast within racks first. The hosts of a rack must
+ * be consecutive in the list.
  *
  * THRILL_WORKERS_PER_HOST is the number of workers (threads) per host.
  *
@@ -499,6 +531,28 @@ void RunLocalSameThread(const std::function<void(Context&)>& job_startpoint);
  */
 int Run(const std::function<void(Context&)>& job_startpoint);
 
+//! A job run by RunService() on request, with the arguments of the request.
+using ServiceJob =
+    std::function<void(Context&, const std::vector<std::string>& args)>;
+
+/*!
+ * Runs Thrill as a long-running service for many short jobs. Processes,
+ * network groups, BlockPool, and io::BlockManager are set up once as in
+ * Run(). Then worker 0 reads requests as lines "name arg1 arg2 ...", from the
+ * file or FIFO named by THRILL_SERVICE_INPUT or else from stdin. Each request
+ * is broadcast to all workers, which run the ServiceJob registered under the
+ * name and meet in a barrier before the next request, such that jobs never
+ * overlap. Unknown names are reported and skipped.
+ *
+ * Between jobs, the consume flag of the Context is reset, and all DIA data of
+ * the job is freed when its DIAs go out of scope in the ServiceJob. The service
+ * ends at the end of the input or at a line "quit". An exception terminates the
+ * service, since workers cannot continue once their DIAs disagree.
+ *
+ * \returns 0 if execution was fine on all threads.
+ */
+int RunService(const std::map<std::string, ServiceJob>& jobs);
+
 //! \}
 
 } // namespace api
@@ -512,6 +566,9 @@ using api::Context;
 //! imported from api namespace
 using api::Run;
 
+//! imported from api namespace
+using api::RunService;
+
 } // namespace thrill
 
 #endif // !THRILL_API_CONTEXT_HEADER
@@ -22,9 +22,11 @@
 #include <thrill/api/function_stack.hpp>
 #include <thrill/common/function_traits.hpp>
 #include <thrill/common/functional.hpp>
+#include <thrill/common/hash.hpp>
 
 #include <cassert>
 #include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -52,6 +54,75 @@ struct DisjointTag {
 //! global const DisjointTag instance
 const struct DisjointTag DisjointTag;
 
+//! tag structure for Zip() of DIAs with equal local sizes
+struct NoRebalanceTag {
+    NoRebalanceTag() { }
+};
+
+//! global const NoRebalanceTag instance
+const struct NoRebalanceTag NoRebalanceTag;
+
+//! tag structure for Sort() with unsigned integer or byte array keys
+struct RadixSortTag {
+    RadixSortTag() { }
+};
+
+//! global const RadixSortTag instance
+const struct RadixSortTag RadixSortTag;
+
+//! tag structure for Sort() by keys which are extracted once per item
+struct CachedKeyTag {
+    CachedKeyTag() { }
+};
+
+//! global const CachedKeyTag instance
+const struct CachedKeyTag CachedKeyTag;
+
+//! tag structure for GroupByKey() merging sorted streams on arrival
+struct StreamingGroupTag {
+    StreamingGroupTag() { }
+};
+
+//! global const StreamingGroupTag instance
+const struct StreamingGroupTag StreamingGroupTag;
+
+//! tag structure for GroupByKey() folding partial groups before the shuffle
+struct CombinerTag {
+    CombinerTag() { }
+};
+
+//! global const CombinerTag instance
+const struct CombinerTag CombinerTag;
+
+//! tag structure for ReduceByKey() partitioning the keys by ranges
+struct RangePartitionTag {
+    RangePartitionTag() { }
+};
+
+//! global const RangePartitionTag instance
+const struct RangePartitionTag RangePartitionTag;
+
+//! tag structure for Window() and FlatWindow() with contiguous windows
+struct ContiguousWindowTag {
+    ContiguousWindowTag() { }
+};
+
+//! global const ContiguousWindowTag instance
+const struct ContiguousWindowTag ContiguousWindowTag;
+
+//! storage of the items of a Cache()
+enum class CacheMode {
+    //! a plain File, whose Blocks are evicted to disk under memory pressure.
+    Default,
+    //! Blocks compressed in RAM, which are decompressed when read.
+    CompressedMemory,
+    //! a File whose Blocks are evicted only if no other Blocks are left.
+    Pinned
+};
+
+//! default local run sorting algorithm of Sort(), defined in sort.hpp
+class DefaultSortAlgorithm;
+
 /*!
  * DIA is the interface between the user and the Thrill framework. A DIA can be
  * imagined as an immutable array, even though the data does not need to be
@@ -223,6 +294,32 @@ public:
         return *this;
     }
 
+    /*!
+     * Hint that the referenced DIANode should receive the given fraction of
+     * the RAM of its Stages, instead of sharing it equally with the other
+     * nodes requesting all available RAM, e.g. to give a large Sort more RAM
+     * than a small ReduceByKey next to it. The hint has no effect on nodes
+     * with a constant memory usage. This does not create a new DIA, but
+     * returns the existing one.
+     */
+    DIA& MemoryFraction(double fraction) {
+        assert(IsValid());
+        node_->set_mem_fraction(fraction);
+        return *this;
+    }
+
+    /*!
+     * Hint that the referenced DIANode should receive the given bytes of RAM
+     * in its Stages, at most all available RAM, instead of sharing it equally
+     * with the other nodes requesting all available RAM. This does not create
+     * a new DIA, but returns the existing one.
+     */
+    DIA& MemoryHint(size_t bytes) {
+        assert(IsValid());
+        node_->set_mem_bytes(bytes);
+        return *this;
+    }
+
     /*!
      * Execute DIA's scope and parents such that this (Action)Node is
      * Executed. This does not create a new DIA, but returns the existing one.
@@ -258,8 +355,8 @@ public:
         using MapResult
                   = typename FunctionTraits<MapFunction>::result_type;
         auto conv_map_function =
-            [map_function](const MapArgument& input, auto emit_func) {
-                emit_func(map_function(input));
+            [map_function](auto&& input, auto emit_func) {
+                emit_func(map_function(std::forward<decltype(input)>(input)));
             };
 
         static_assert(
@@ -301,8 +398,9 @@ public:
         using FilterArgument
                   = typename FunctionTraits<FilterFunction>::template arg_plain<0>;
         auto conv_filter_function =
-            [filter_function](const FilterArgument& input, auto emit_func) {
-                if (filter_function(input)) emit_func(input);
+            [filter_function](auto&& input, auto emit_func) {
+                if (filter_function(input))
+                    emit_func(std::forward<decltype(input)>(input));
             };
 
         static_assert(
@@ -401,6 +499,17 @@ public:
      */
     void AllGather(std::vector<ValueType>* out_vector) const;
 
+    /*!
+     * AllGatherShared is an Action, which returns the whole DIA in one
+     * std::vector per host, which all workers on the host share read-only. The
+     * items are transmitted only once to each host, hence it is suited for side
+     * inputs of Map() or FlatMap() lambdas, which capture the pointer instead of
+     * a copy of the items.
+     *
+     * \ingroup dia_actions
+     */
+    std::shared_ptr<const std::vector<ValueType> > AllGatherShared() const;
+
     /*!
      * Print is an Action, which collects all data of the DIA at the worker 0
      * and prints using ostream serialization. It is implemented using Gather().
@@ -494,9 +603,100 @@ public:
     auto Max(const MaxFunction& max_function = MaxFunction(),
              const ValueType& initial_value = ValueType()) const;
 
+    /*!
+     * TopK is an Action, which returns the k smallest elements according to
+     * compare_function in sorted order on all workers. Each worker keeps only
+     * a bounded heap of k items, hence the running time is O(n log k) and the
+     * items of the DIA are not exchanged. Use std::greater to select the k
+     * largest elements.
+     *
+     * \param k Number of elements to return.
+     *
+     * \param compare_function Function comparing two elements.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    std::vector<ValueType> TopK(
+        size_t k,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
+    /*!
+     * ApproxCountDistinct is an Action, which estimates the number of distinct
+     * elements globally with a HyperLogLog sketch of 2^precision registers on
+     * each worker, which are merged with an AllReduce. The standard error is
+     * about 1.04 / sqrt(2^precision), i.e. 0.8% for the default precision.
+     *
+     * \param precision Number of index bits of the sketch, from 4 to 18.
+     *
+     * \param hash_function Hash function of the elements.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename HashFunction = common::Hash<ValueType> >
+    size_t ApproxCountDistinct(
+        unsigned precision = 14,
+        const HashFunction& hash_function = HashFunction()) const;
+
+    /*!
+     * ApproxQuantiles is an Action, which returns approximate quantiles of the
+     * elements according to compare_function on all workers. Each worker keeps
+     * a KLL sketch of O(k) elements, which are merged with an AllReduce. The
+     * rank error is about 1.7 / k of the number of elements. Returns an empty
+     * vector if the DIA is empty.
+     *
+     * \param qs Quantiles to return, each in [0,1].
+     *
+     * \param k Accuracy parameter of the sketch.
+     *
+     * \param compare_function Function comparing two elements.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    std::vector<ValueType> ApproxQuantiles(
+        const std::vector<double>& qs, size_t k = 200,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
+    /*!
+     * Select is an Action, which returns the element of the given rank, i.e.
+     * the element at position rank if the DIA were sorted by
+     * compare_function, on all workers. It runs rounds of a sample gathered
+     * at worker 0 and a Filter() caching only the items between two pivots
+     * around the rank, hence it never sorts the DIA. The DIA itself is read
+     * four times and should be cached.
+     *
+     * \param rank Rank of the element, less than Size().
+     *
+     * \param compare_function Function comparing two elements.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    ValueType Select(
+        size_t rank,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
+    /*!
+     * Select is an Action, which returns the elements of the given ranks, e.g.
+     * exact medians and percentiles, in the order of ranks on all workers. The
+     * ranks share the rounds of sampling and filtering, see Select(rank).
+     *
+     * \param ranks Ranks of the elements, each less than Size().
+     *
+     * \param compare_function Function comparing two elements.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    std::vector<ValueType> Select(
+        const std::vector<size_t>& ranks,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
     /*!
      * WriteLines is an Action, which writes std::strings to an output file.
-     * Strings are written using fstream with a newline after each entry.
+     * Strings are written with a newline after each entry. All workers write
+     * their parts in parallel at offsets calculated with a prefix sum.
      *
      * \param filepath Destination of the output file.
      *
@@ -535,10 +735,36 @@ public:
      *
      * \param max_file_size size limit of individual file.
      *
+     * \param write_index append an index of item boundaries to uncompressed
+     * files of variable-size items, which lets ReadBinary split them among all
+     * workers. Other readers must then ignore the trailing index.
+     *
      * \ingroup dia_actions
      */
     void WriteBinary(const std::string& filepath,
-                     size_t max_file_size = 128* 1024* 1024) const;
+                     size_t max_file_size = 128* 1024* 1024,
+                     bool write_index = false) const;
+
+    /*!
+     * WriteColumnar is an Action, which writes a DIA of std::tuples of
+     * trivially copyable values to one columnar file per worker. Each file
+     * consists of chunks of rows, each stored column by column with
+     * lightweight encodings, and a footer with the minimum and maximum value
+     * of each column in each chunk. ReadColumnar can read only some columns
+     * and skip chunks by their statistics.
+     *
+     * \param filepath Destination of the output file. This filepath must
+     * contain two special substrings: "$$$$$" is replaced by the worker id and
+     * "#####" by zero, as each worker writes a single file. The last
+     * occurrences of "$" and "#" are replaced, otherwise "$$$$" and/or
+     * "##########" are automatically appended.
+     *
+     * \param chunk_rows number of rows in each chunk.
+     *
+     * \ingroup dia_actions
+     */
+    void WriteColumnar(const std::string& filepath,
+                       size_t chunk_rows = 64* 1024) const;
 
     //! \}
 
@@ -614,6 +840,39 @@ public:
                      const ReduceFunction &reduce_function,
                      const ReduceConfig& reduce_config = ReduceConfig()) const;
 
+    /*!
+     * ReduceByKey is a DOp, which groups elements of the DIA with the
+     * key_extractor and reduces each key-bucket to a single element using the
+     * associative reduce_function, like ReduceByKey() above. Instead of hashing
+     * the keys, the reduced keys are range-partitioned by splitters sampled
+     * from them, like in Sort(), and each worker delivers its reduced elements
+     * in key order. The resulting DIA is hence sorted by key, which saves the
+     * second shuffle of a following Sort().
+     *
+     * \param key_extractor Key extractor function, which maps each element to a
+     * key of possibly different type.
+     *
+     * \param reduce_function Reduce function, which defines how the key buckets
+     * are reduced to a single element. This function is applied associative but
+     * not necessarily commutative.
+     *
+     * \param key_compare_function Strict weak order of the keys.
+     *
+     * \param reduce_config Reduce configuration.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor, typename ReduceFunction,
+              typename KeyCompareFunction = std::less<
+                  typename common::FunctionTraits<KeyExtractor>::result_type>,
+              typename ReduceConfig = class DefaultReduceConfig>
+    auto ReduceByKey(struct RangePartitionTag,
+                     const KeyExtractor &key_extractor,
+                     const ReduceFunction &reduce_function,
+                     const KeyCompareFunction& key_compare_function
+                         = KeyCompareFunction(),
+                     const ReduceConfig& reduce_config = ReduceConfig()) const;
+
     /*!
      * ReducePair is a DOp, which groups key-value-pairs in the input DIA by
      * their key and reduces each key-bucket to a single element using the
@@ -641,6 +900,34 @@ public:
     auto ReducePair(const ReduceFunction &reduce_function,
                     const ReduceConfig& reduce_config = ReduceConfig()) const;
 
+    /*!
+     * Distinct is a DOp, which removes all but one element of each key from
+     * the DIA. It groups the elements with the key_extractor like ReduceByKey,
+     * but keeps an arbitrary element of each key instead of reducing them.
+     * Hence duplicates are dropped in the pre stage before the shuffle, and
+     * only the elements themselves are sent.
+     *
+     * \param key_extractor Key extractor function, which maps each element to a
+     * key of possibly different type.
+     *
+     * \param reduce_config Reduce configuration.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename ReduceConfig = class DefaultReduceConfig>
+    auto Distinct(const KeyExtractor &key_extractor,
+                  const ReduceConfig& reduce_config = ReduceConfig()) const;
+
+    /*!
+     * Distinct is a DOp, which removes duplicate elements from the DIA. The
+     * elements themselves are the keys, hence they must be hashable and
+     * comparable with ==.
+     *
+     * \ingroup dia_dops
+     */
+    auto Distinct() const;
+
     /*!
      * ReduceToIndex is a DOp, which groups elements of the DIA with the
      * key_extractor returning an unsigned integers and reduces each key-bucket
@@ -765,10 +1052,74 @@ public:
      */
     template <typename ValueOut, typename KeyExtractor,
               typename GroupByFunction, typename HashFunction =
-                  std::hash<typename FunctionTraits<KeyExtractor>::result_type> >
+                  common::Hash<
+                      typename FunctionTraits<KeyExtractor>::result_type> >
     auto GroupByKey(const KeyExtractor &key_extractor,
                     const GroupByFunction &groupby_function) const;
 
+    /*!
+     * GroupByKey is a DOp, which groups elements of the DIA by its key. This
+     * variant sorts the items on each worker before sending them, and merges
+     * the sorted streams from all workers on arrival. Hence the
+     * groupby_function is called as soon as all elements of a key arrived,
+     * and received elements are not stored.
+     *
+     * \tparam KeyExtractor Type of the key_extractor function.
+     *
+     * \param key_extractor Key extractor function, which maps each element to a
+     * key of possibly different type.
+     *
+     * \tparam GroupByFunction Type of the groupby_function. This is a function
+     * taking an iterator for all elements of the same key as input.
+     *
+     * \param groupby_function Reduce function, which defines how the key
+     * buckets are grouped and processed.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ValueOut, typename KeyExtractor,
+              typename GroupByFunction, typename HashFunction =
+                  common::Hash<
+                      typename FunctionTraits<KeyExtractor>::result_type> >
+    auto GroupByKey(struct StreamingGroupTag,
+                    const KeyExtractor &key_extractor,
+                    const GroupByFunction &groupby_function) const;
+
+    /*!
+     * GroupByKey is a DOp, which groups elements of the DIA by its key. This
+     * variant takes a combiner for group functions which are associative
+     * folds, e.g. collecting the top-k elements of each key. Each element is
+     * turned into a partial group by the init_function, and partial groups of
+     * the same key are merged by the merge_function in the tables of the
+     * reduce stages, like in ReduceByKey. Hence each worker sends at most one
+     * partial group per key. The group_function receives the key and its
+     * fully merged partial group, and returns the output element.
+     *
+     * \param key_extractor Key extractor function, which maps each element to a
+     * key of possibly different type.
+     *
+     * \param init_function Function which maps an element to a partial group.
+     *
+     * \param merge_function Associative function which merges two partial
+     * groups of the same key.
+     *
+     * \param group_function Function which maps a key and its merged partial
+     * group to the output element.
+     *
+     * \param reduce_config Reduce configuration.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor, typename InitFunction,
+              typename MergeFunction, typename GroupFunction,
+              typename ReduceConfig = class DefaultReduceConfig>
+    auto GroupByKey(struct CombinerTag,
+                    const KeyExtractor &key_extractor,
+                    const InitFunction &init_function,
+                    const MergeFunction &merge_function,
+                    const GroupFunction &group_function,
+                    const ReduceConfig& reduce_config = ReduceConfig()) const;
+
     /*!
      * GroupBy is a DOp, which groups elements of the DIA by its key.
      * After having grouped all elements of one key, all elements of one key
@@ -834,6 +1185,125 @@ public:
     template <typename ZipFunction, typename SecondDIA>
     auto Zip(const SecondDIA &second_dia, const ZipFunction &zip_function) const;
 
+    /*!
+     * Zip is a DOp, which Zips two DIAs like Zip() above, but requires that
+     * both DIAs have the same number of items on each worker, e.g. because they
+     * are derived from the same parent by Map()s. The i-th local items are then
+     * zipped without any communication.
+     *
+     * \param zip_function Zip function, which zips two elements together
+     *
+     * \param second_dia DIA, which is zipped together with the original
+     * DIA.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ZipFunction, typename SecondDIA>
+    auto Zip(struct NoRebalanceTag, const SecondDIA &second_dia,
+             const ZipFunction &zip_function) const;
+
+    /*!
+     * ZipWithIndex is a DOp, which zips each item of the DIA with its global
+     * index, i.e. its rank in the DIA's order. It is cheaper than a Zip() with
+     * Generate(), since the items stay on their worker and only the local item
+     * counts are prefix summed.
+     *
+     * \param zip_function Zip function, which is called with an item and its
+     * size_t index.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ZipFunction>
+    auto ZipWithIndex(const ZipFunction &zip_function) const;
+
+    /*!
+     * InnerJoin is a DOp, which joins two DIAs by key: for each pair of items
+     * a from this DIA and b from second_dia with key_extractor1(a) ==
+     * key_extractor2(b), the output DIA contains join_function(a, b). Both DIAs
+     * are hash partitioned by key, and the smaller side on each worker is
+     * loaded into a hash table.
+     *
+     * \tparam KeyExtractor1 Type of the key_extractor1 function. This is a
+     * function from this DIA's type to the key type.
+     *
+     * \tparam KeyExtractor2 Type of the key_extractor2 function. This is a
+     * function from second_dia's type to the key type.
+     *
+     * \tparam JoinFunction Type of the join_function. This is a function with
+     * an item of each DIA as input, and one output element, which is the type
+     * of the output DIA.
+     *
+     * \param second_dia DIA, which is joined with the original DIA.
+     *
+     * \param key_extractor1 Key extractor function of this DIA.
+     *
+     * \param key_extractor2 Key extractor function of second_dia.
+     *
+     * \param join_function Join function applied to each matching pair.
+     *
+     * \param hash_function Hash function for keys, used for partitioning and
+     * the hash tables.
+     *
+     * \param join_config Join configuration, e.g. whether to filter the larger
+     * input by a Bloom filter of the smaller input's keys before shuffling.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor1, typename KeyExtractor2,
+              typename JoinFunction, typename SecondDIA,
+              typename HashFunction =
+                  common::Hash<
+                      typename FunctionTraits<KeyExtractor1>::result_type>,
+              typename JoinConfig = class DefaultInnerJoinConfig>
+    auto InnerJoin(const SecondDIA &second_dia,
+                   const KeyExtractor1 &key_extractor1,
+                   const KeyExtractor2 &key_extractor2,
+                   const JoinFunction &join_function,
+                   const HashFunction &hash_function = HashFunction(),
+                   const JoinConfig &join_config = JoinConfig()) const;
+
+    /*!
+     * SortMergeJoin is a DOp, which joins two DIAs by key like InnerJoin, but
+     * requires the items of both DIAs to be sorted by key on each worker,
+     * e.g. the outputs of Sort() or Merge(). Both DIAs are split into ranges
+     * of keys by the same splitters, which moves only the boundary data if
+     * they are globally sorted, and joined in one streaming pass. The output
+     * DIA is ordered by key.
+     *
+     * \tparam KeyExtractor1 Type of the key_extractor1 function. This is a
+     * function from this DIA's type to the key type.
+     *
+     * \tparam KeyExtractor2 Type of the key_extractor2 function. This is a
+     * function from second_dia's type to the key type.
+     *
+     * \tparam JoinFunction Type of the join_function. This is a function with
+     * an item of each DIA as input, and one output element, which is the type
+     * of the output DIA.
+     *
+     * \param second_dia DIA, which is joined with the original DIA.
+     *
+     * \param key_extractor1 Key extractor function of this DIA.
+     *
+     * \param key_extractor2 Key extractor function of second_dia.
+     *
+     * \param join_function Join function applied to each matching pair.
+     *
+     * \param key_comparator Comparator of keys, by which both DIAs are sorted.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor1, typename KeyExtractor2,
+              typename JoinFunction, typename SecondDIA,
+              typename KeyComparator =
+                  std::less<
+                      typename FunctionTraits<KeyExtractor1>::result_type> >
+    auto SortMergeJoin(
+        const SecondDIA &second_dia,
+        const KeyExtractor1 &key_extractor1,
+        const KeyExtractor2 &key_extractor2,
+        const JoinFunction &join_function,
+        const KeyComparator &key_comparator = KeyComparator()) const;
+
     /*!
      * Sort is a DOp, which sorts a given DIA according to the given compare_function.
      *
@@ -843,10 +1313,101 @@ public:
      * \param compare_function Function, which compares two elements. Returns true, if
      * first element is smaller than second. False otherwise.
      *
+     * \param sort_algorithm Algorithm used to sort the local runs, e.g.
+     * DefaultSortAlgorithm or ParallelSortAlgorithm. The functor is called as
+     * sort_algorithm(begin, end, compare_function).
+     *
+     * \param sort_config Sort configuration, e.g. the sampling method for
+     * splitter selection and the oversampling factor.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType>,
+              typename SortAlgorithm = DefaultSortAlgorithm,
+              typename SortConfig = class DefaultSortConfig>
+    auto Sort(const CompareFunction& compare_function = CompareFunction(),
+              const SortAlgorithm& sort_algorithm = SortAlgorithm(),
+              const SortConfig& sort_config = SortConfig()) const;
+
+    /*!
+     * SortStable is a DOp, which sorts a given DIA according to the given
+     * compare_function while keeping the input order of equal elements, also
+     * across workers.
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (ValueType,ValueType)->bool
+     *
+     * \param compare_function Function, which compares two elements. Returns true, if
+     * first element is smaller than second. False otherwise.
+     *
+     * \param sort_algorithm Algorithm used to sort the local runs, which must
+     * be stable, e.g. DefaultStableSortAlgorithm.
+     *
+     * \param sort_config Sort configuration.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType>,
+              typename SortAlgorithm = class DefaultStableSortAlgorithm,
+              typename SortConfig = class DefaultSortConfig>
+    auto SortStable(
+        const CompareFunction& compare_function = CompareFunction(),
+        const SortAlgorithm& sort_algorithm = SortAlgorithm(),
+        const SortConfig& sort_config = SortConfig()) const;
+
+    /*!
+     * Sort is a DOp, which sorts a given DIA by the unsigned integer or
+     * fixed-width byte array (std::array<uint8_t, N>) key returned by the
+     * key_extractor. Local runs are sorted using in-place MSD radix sort
+     * instead of comparison sorting.
+     *
+     * \param key_extractor Function, which maps an element to its radix key.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor>
+    auto Sort(struct RadixSortTag, const KeyExtractor& key_extractor) const;
+
+    /*!
+     * Sort is a DOp, which sorts a given DIA by the keys returned by the
+     * key_extractor. The key of each element is extracted only once and
+     * carried next to the element through the local runs, the splitter
+     * classification and the merge, which all compare only the cached keys.
+     * This pays off if keys are expensive to build from the elements, e.g.
+     * normalized strings, at the cost of transmitting the keys.
+     *
+     * \param key_extractor Function, which maps an element to its key.
+     *
+     * \param key_compare_function Function, which compares two keys.
+     *
+     * \param sort_config Sort configuration.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename KeyCompareFunction = std::less<>,
+              typename SortConfig = class DefaultSortConfig>
+    auto Sort(struct CachedKeyTag, const KeyExtractor& key_extractor,
+              const KeyCompareFunction& key_compare_function
+                  = KeyCompareFunction(),
+              const SortConfig& sort_config = SortConfig()) const;
+
+    /*!
+     * PartialSort is a DOp, which selects the k smallest elements of the DIA
+     * according to compare_function and returns them as a sorted DIA, whose
+     * items are evenly distributed over all workers. Like TopK, only a bounded
+     * heap of k items is kept per worker.
+     *
+     * \param k Number of elements to keep.
+     *
+     * \param compare_function Function comparing two elements.
+     *
      * \ingroup dia_dops
      */
     template <typename CompareFunction = std::less<ValueType> >
-    auto Sort(const CompareFunction& compare_function = CompareFunction()) const;
+    auto PartialSort(
+        size_t k,
+        const CompareFunction& compare_function = CompareFunction()) const;
 
     /*!
      * Merge is a DOp, which merges two sorted DIAs to a single sorted DIA.
@@ -880,6 +1441,27 @@ public:
     auto PrefixSum(const SumFunction& sum_function = SumFunction(),
                    const ValueType& initial_element = ValueType()) const;
 
+    /*!
+     * SegmentedPrefixSum is a DOp, which computes the prefix sum of all
+     * elements, restarting it with initial_element whenever the key of
+     * consecutive elements changes. Segments of equal keys may span multiple
+     * workers, which replaces a GroupByKey for running sums over sorted keys.
+     *
+     * \param key_extractor Function extracting the key of an element.
+     *
+     * \param sum_function Sum function (any associative function).
+     *
+     * \param initial_element Initial element of the sum function.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename SumFunction = std::plus<ValueType> >
+    auto SegmentedPrefixSum(
+        const KeyExtractor& key_extractor,
+        const SumFunction& sum_function = SumFunction(),
+        const ValueType& initial_element = ValueType()) const;
+
     /*!
      * Window is a DOp, which applies a window function to every k
      * consecutive items in a DIA. The window function is also given the index
@@ -940,6 +1522,91 @@ public:
     auto FlatWindow(struct DisjointTag, size_t window_size,
                     const WindowFunction &window_function) const;
 
+    /*!
+     * Window is a DOp, which applies a window function to every k
+     * consecutive items in a DIA. For trivially copyable items, the window is
+     * passed as a pointer to k contiguous items instead of a RingBuffer, which
+     * vectorizes and avoids index wrap-around. Signature: Result(size_t index,
+     * const ValueType* window).
+     *
+     * \param window_size the size of the delivered window.
+     *
+     * \param window_function Window function applied to each k item.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename WindowFunction>
+    auto Window(struct ContiguousWindowTag, size_t window_size,
+                const WindowFunction &window_function) const;
+
+    /*!
+     * FlatWindow is a DOp, which applies a window function to every k
+     * consecutive items in a DIA, which are passed as a pointer to k
+     * contiguous trivially copyable items. The window function can output
+     * zero or more items via an Emitter. Signature: void(size_t index, const
+     * ValueType* window, Emitter emit).
+     *
+     * \param window_size the size of the delivered window.
+     *
+     * \param window_function Window function applied to each k item.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ValueOut, typename WindowFunction>
+    auto FlatWindow(struct ContiguousWindowTag, size_t window_size,
+                    const WindowFunction &window_function) const;
+
+    /*!
+     * WindowSum is a DOp, which calculates the sum of every k consecutive
+     * items in a DIA. The sum is updated incrementally by adding the item
+     * entering and subtracting the item leaving the window, hence it costs
+     * O(n) in total instead of O(n k). For floating point items, rounding
+     * errors may accumulate.
+     *
+     * \param window_size the size of the window.
+     *
+     * \param sum_function Sum function, must be associative.
+     *
+     * \param subtract_function Inverse of the sum function.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename SumFunction = std::plus<ValueType>,
+              typename SubtractFunction = std::minus<ValueType> >
+    auto WindowSum(
+        size_t window_size, const SumFunction& sum_function = SumFunction(),
+        const SubtractFunction& subtract_function = SubtractFunction()) const;
+
+    /*!
+     * WindowMin is a DOp, which calculates the minimum of every k consecutive
+     * items in a DIA with a monotonic queue, which costs O(n) in total.
+     *
+     * \param window_size the size of the window.
+     *
+     * \param compare_function Less comparison of two items.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    auto WindowMin(
+        size_t window_size,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
+    /*!
+     * WindowMax is a DOp, which calculates the maximum of every k consecutive
+     * items in a DIA with a monotonic queue, which costs O(n) in total.
+     *
+     * \param window_size the size of the window.
+     *
+     * \param compare_function Less comparison of two items.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    auto WindowMax(
+        size_t window_size,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
     /*!
      * Concat is a DOp, which concatenates any number of DIAs to a single DIA.
      * All input DIAs must contain the same type, which is also the output DIA's
@@ -953,6 +1620,29 @@ public:
     template <typename SecondDIA>
     auto Concat(const SecondDIA &second_dia) const;
 
+    /*!
+     * Union is a DOp, which combines the items of any number of DIAs into a
+     * single DIA. All input DIAs must contain the same type, which is also the
+     * output DIA's type.
+     *
+     * In contrast to Concat, no items are exchanged: each worker keeps its
+     * local items, hence the output order is unspecified and not balanced.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename SecondDIA>
+    auto Union(const SecondDIA &second_dia) const;
+
+    /*!
+     * Rebalance is a DOp, which moves items between workers such that each
+     * worker holds an equal share of the DIA, while keeping the global order of
+     * the items. Only items outside a worker's new range are sent, use it after
+     * a selective Filter() or a skewed ReduceByKey().
+     *
+     * \ingroup dia_dops
+     */
+    auto Rebalance() const;
+
     /*!
      * Create a CollapseNode which is mainly used to collapse the LOp chain into
      * a DIA<T> with an empty stack. This is most often necessary for iterative
@@ -968,9 +1658,27 @@ public:
      * format. This is needed if a DIA is reused many times, in order to avoid
      * recalculating a PostOp multiple times.
      *
+     * \param mode Storage of the items: CacheMode::Pinned keeps the items in
+     * RAM while other Blocks can be evicted, CacheMode::CompressedMemory
+     * reduces their memory usage.
+     *
      * \ingroup dia_dops
      */
-    DIA<ValueType> Cache() const;
+    DIA<ValueType> Cache(CacheMode mode = CacheMode::Default) const;
+
+    /*!
+     * Create a CheckpointNode which caches all items of a DIA like Cache(), and
+     * also writes each worker's Blocks unchanged into the file path followed
+     * by "-worker-" and the worker rank. If all workers find their complete
+     * checkpoint files when the DIA is created, e.g. after restarting a failed
+     * job, the items are restored from them and this DIA's computation is
+     * skipped. Checkpoints are only valid for the same number of workers.
+     *
+     * \param path Base path of the checkpoint files.
+     *
+     * \ingroup dia_dops
+     */
+    DIA<ValueType> Checkpoint(const std::string& path) const;
 
     //! \}
 
@@ -1000,9 +1708,30 @@ private:
 //! imported from api namespace
 using api::DIA;
 
+//! imported from api namespace
+using api::ContiguousWindowTag;
+
+//! imported from api namespace
+using api::CachedKeyTag;
+
+//! imported from api namespace
+using api::CombinerTag;
+
 //! imported from api namespace
 using api::DisjointTag;
 
+//! imported from api namespace
+using api::NoRebalanceTag;
+
+//! imported from api namespace
+using api::RadixSortTag;
+
+//! imported from api namespace
+using api::RangePartitionTag;
+
+//! imported from api namespace
+using api::StreamingGroupTag;
+
 //! imported from api namespace
 using api::VolatileKeyTag;
 
@@ -12,11 +12,14 @@
 #include <thrill/api/dia_base.hpp>
 #include <thrill/common/json_logger.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/perf_counters.hpp>
 #include <thrill/common/stats_timer.hpp>
+#include <thrill/io/iostats.hpp>
 #include <thrill/mem/allocator.hpp>
 
 #include <algorithm>
 #include <chrono>
+#include <ctime>
 #include <deque>
 #include <functional>
 #include <iomanip>
@@ -31,6 +34,56 @@ namespace api {
 /******************************************************************************/
 // DIABase StageBuilder
 
+//! Measures resources used by a worker while executing a phase of a Stage,
+//! which are added to the StageBuilder's JSON events for profiling.
+class StageProfile
+{
+public:
+    StageProfile()
+        : cpu_time_(ThreadCpuTime()),
+          io_read_(io::Stats::GetInstance()->read_volume()),
+          io_write_(io::Stats::GetInstance()->write_volume()),
+          perf_valid_(common::PerfCounters::Read(&perf_)) { }
+
+    //! append CPU time of this thread in microseconds and the host's disk I/O
+    //! volume since construction to the JsonLine, and the hardware counters
+    //! of this thread if enabled.
+    void Write(common::JsonLine& line) const {
+        io::Stats* stats = io::Stats::GetInstance();
+        line << "cpu_time" << ThreadCpuTime() - cpu_time_
+             << "io_read_bytes" << stats->read_volume() - io_read_
+             << "io_write_bytes" << stats->write_volume() - io_write_;
+
+        common::PerfCounters::Values perf;
+        if (perf_valid_ && common::PerfCounters::Read(&perf)) {
+            common::JsonLine sub = line.sub("perf");
+            for (size_t i = 0; i < common::PerfCounters::kEvents; ++i)
+                sub << common::PerfCounters::Name(i) << perf[i] - perf_[i];
+        }
+    }
+
+    //! CPU time used by the calling thread in microseconds
+    static uint64_t ThreadCpuTime() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        struct timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000u + ts.tv_nsec / 1000;
+#else
+        return 0;
+#endif
+    }
+
+private:
+    //! CPU time of thread at start
+    uint64_t cpu_time_;
+    //! disk I/O volume of host at start
+    int64_t io_read_, io_write_;
+    //! hardware counters of thread at start
+    common::PerfCounters::Values perf_;
+    //! whether perf_ was read
+    bool perf_valid_;
+};
+
 class Stage
 {
 public:
@@ -128,12 +181,20 @@ public:
                 << "targets" << target_ids;
 
         DIAMemUse mem_use = node_->ExecuteMemUse();
-        if (mem_use.is_max())
-            mem_use = context_.mem_limit();
+        if (mem_use.is_max()) {
+            if (node_->has_mem_hint())
+                mem_use = node_->HintedMemLimit(context_.mem_limit());
+            else
+                mem_use = mem_use.demand()
+                          ? std::min(mem_use.demand(), context_.mem_limit())
+                          : context_.mem_limit();
+        }
         node_->set_mem_limit(mem_use);
 
-        data::BlockPoolMemoryHolder mem_holder(context_.block_pool(), mem_use);
+        data::BlockPoolMemoryHolder mem_holder(
+            context_.block_pool(), mem_use, node_->id());
 
+        StageProfile profile;
         common::StatsTimerStart timer;
         try {
             node_->Execute();
@@ -145,12 +206,18 @@ public:
         }
         node_->set_state(DIAState::EXECUTED);
         timer.Stop();
+        node_->RecordExecute(timer.Microseconds() / 1e3);
+
+        size_t arena_bytes = context_.stage_arena().allocated();
+        context_.stage_arena().Release();
 
         sLOG << "FINISH (EXECUTE) stage" << *node_ << "targets" << TargetsString()
              << "took" << timer << "ms";
 
-        logger_ << "class" << "StageBuilder" << "event" << "execute-done"
-                << "targets" << target_ids << "elapsed" << timer;
+        profile.Write(
+            logger_ << "class" << "StageBuilder" << "event" << "execute-done"
+                    << "targets" << target_ids << "elapsed" << timer
+                    << "arena_bytes" << arena_bytes);
     }
 
     void PushData() {
@@ -178,14 +245,15 @@ public:
         std::vector<DIABase*> targets = TargetPtrs();
 
         const size_t mem_limit = context_.mem_limit();
-        std::vector<DIABase*> max_mem_nodes;
+        // nodes requesting maximum RAM, paired with their estimated demand
+        std::vector<std::pair<DIABase*, size_t> > max_mem_nodes;
         size_t const_mem = 0;
 
         {
             // process node which will PushData() to targets
             DIAMemUse m = node_->PushDataMemUse();
             if (m.is_max()) {
-                max_mem_nodes.emplace_back(node_.get());
+                max_mem_nodes.emplace_back(node_.get(), m.demand());
             }
             else {
                 const_mem += m.limit();
@@ -197,7 +265,7 @@ public:
             for (DIABase* target : TargetPtrs()) {
                 DIAMemUse m = target->PreOpMemUse();
                 if (m.is_max()) {
-                    max_mem_nodes.emplace_back(target);
+                    max_mem_nodes.emplace_back(target, m.demand());
                 }
                 else {
                     const_mem += m.limit();
@@ -213,31 +281,73 @@ public:
             abort();
         }
 
-        // distribute remaining memory to nodes requesting maximum RAM amount
-
+        // distribute remaining memory to nodes requesting maximum RAM amount:
+        // nodes with a user memory hint get their hinted amount first. Of the
+        // others, nodes with a demand below the equal share get their demand,
+        // and the surplus is split among the rest. Nodes which report no
+        // demand are unbounded, and the last node gets all leftover memory.
         if (max_mem_nodes.size()) {
-            size_t remaining_mem = mem_limit - const_mem;
-            remaining_mem /= max_mem_nodes.size();
+            const size_t available_mem = mem_limit - const_mem;
+            size_t remaining_mem = available_mem;
 
-            if (context_.my_rank() == 0) {
-                LOG << "StageBuilder: distribute remaining worker memory "
-                    << remaining_mem << " to "
-                    << max_mem_nodes.size() << " DIANodes";
-            }
+            for (const std::pair<DIABase*, size_t>& n : max_mem_nodes) {
+                if (!n.first->has_mem_hint()) continue;
+                size_t limit = std::min(
+                    n.first->HintedMemLimit(available_mem), remaining_mem);
 
-            for (DIABase* target : max_mem_nodes) {
-                target->set_mem_limit(remaining_mem);
+                if (context_.my_rank() == 0) {
+                    LOG << "StageBuilder: distribute worker memory "
+                        << limit << " to " << *n.first << " by hint";
+                }
+
+                n.first->set_mem_limit(limit);
+                remaining_mem -= limit;
+                const_mem += limit;
             }
+            max_mem_nodes.erase(
+                std::remove_if(
+                    max_mem_nodes.begin(), max_mem_nodes.end(),
+                    [](const std::pair<DIABase*, size_t>& n) {
+                        return n.first->has_mem_hint();
+                    }),
+                max_mem_nodes.end());
+
+            // process nodes in order of increasing demand, unknown last.
+            std::stable_sort(
+                max_mem_nodes.begin(), max_mem_nodes.end(),
+                [](const std::pair<DIABase*, size_t>& a,
+                   const std::pair<DIABase*, size_t>& b) {
+                    return (a.second ? a.second : size_t(-1))
+                    < (b.second ? b.second : size_t(-1));
+                });
+
+            for (size_t i = 0; i < max_mem_nodes.size(); ++i) {
+                size_t share = remaining_mem / (max_mem_nodes.size() - i);
+                size_t demand = max_mem_nodes[i].second;
+                bool last = (i + 1 == max_mem_nodes.size());
+                size_t limit =
+                    (demand && demand < share && !last) ? demand : share;
+
+                if (context_.my_rank() == 0) {
+                    LOG << "StageBuilder: distribute worker memory "
+                        << limit << " to " << *max_mem_nodes[i].first
+                        << " with demand " << demand;
+                }
 
-            // update const_mem: later allocate the mem limit of this worker
-            const_mem = mem_limit;
+                max_mem_nodes[i].first->set_mem_limit(limit);
+                remaining_mem -= limit;
+                const_mem += limit;
+            }
         }
 
         // execute push data: hold memory for DIANodes, and remove filled
         // children afterwards
 
-        data::BlockPoolMemoryHolder mem_holder(context_.block_pool(), const_mem);
+        data::BlockPoolMemoryHolder mem_holder(
+            context_.block_pool(), const_mem, node_->id());
 
+        size_t push_bytes = node_->PushDataBytes();
+        StageProfile profile;
         common::StatsTimerStart timer;
         try {
             node_->RunPushData();
@@ -250,12 +360,19 @@ public:
         }
         node_->RemoveAllChildren();
         timer.Stop();
+        node_->RecordPushData(timer.Microseconds() / 1e3, push_bytes);
+
+        size_t arena_bytes = context_.stage_arena().allocated();
+        context_.stage_arena().Release();
 
         sLOG << "FINISH (PUSHDATA) stage" << *node_ << "targets" << TargetsString()
              << "took" << timer << "ms";
 
-        logger_ << "class" << "StageBuilder" << "event" << "pushdata-done"
-                << "targets" << target_ids << "elapsed" << timer;
+        profile.Write(
+            logger_ << "class" << "StageBuilder" << "event" << "pushdata-done"
+                    << "targets" << target_ids << "elapsed" << timer
+                    << "push_bytes" << push_bytes
+                    << "arena_bytes" << arena_bytes);
     }
 
     //! order for std::set in FindStages() - this must be deterministic such
@@ -380,6 +497,11 @@ void DIABase::RunScope() {
     };
     TopoSortStages(stages, toporder);
 
+    // release the set's references, such that toporder holds the last
+    // reference to nodes which are not referenced by DIAs or children. These
+    // are destroyed and free their data right after their PushData().
+    stages.clear();
+
     LOG << "Topological order";
     for (auto top = toporder.rbegin(); top != toporder.rend(); ++top) {
         LOG << "  " << *top->node_;
@@ -399,6 +521,14 @@ void DIABase::RunScope() {
         if (debug)
             mem::malloc_tracker_print_status();
 
+        // let the node of the next Stage read its swapped data speculatively
+        // while this Stage runs.
+        for (size_t i = toporder.size() - 1; i-- > 0; ) {
+            if (!toporder[i].node_->CanExecute()) continue;
+            toporder[i].node_->PrefetchData();
+            break;
+        }
+
         if (s.node_->state() == DIAState::NEW) {
             s.Execute();
             if (s.node_.get() != this)
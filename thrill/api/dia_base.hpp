@@ -18,7 +18,11 @@
 
 #include <thrill/api/context.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 namespace thrill {
@@ -59,9 +63,21 @@ public:
     //! StageBuilder by detecting the DIANodes in a Stage)
     static DIAMemUse Max() { return DIAMemUse(max_limit_); }
 
+    //! Maximum available RAM requested, but the node cannot make use of more
+    //! than the given demand estimate. The StageBuilder gives the RAM above
+    //! the demand to other nodes in the Stage.
+    static DIAMemUse Max(size_t demand) {
+        DIAMemUse m(max_limit_);
+        m.demand_ = demand;
+        return m;
+    }
+
     //! return amount of RAM reserved
     size_t limit() const { return limit_; }
 
+    //! return estimated RAM demand of a maximum request, or zero if unknown.
+    size_t demand() const { return demand_; }
+
     //! test if sentinel for maximum RAM request
     bool is_max() const { return limit_ == max_limit_; }
 
@@ -72,10 +88,47 @@ private:
     //! amount of RAM requested or reserved.
     size_t limit_;
 
+    //! estimated RAM demand of a maximum request, zero if unknown.
+    size_t demand_ = 0;
+
     //! sentinel for maximum available RAM.
     static constexpr size_t max_limit_ = static_cast<size_t>(-1);
 };
 
+/*!
+ * Partitioning property of the items pushed by a DIANode: all items with equal
+ * key, as extracted by the KeyExtractor, are located on the same worker. The
+ * property is identified by the type of the KeyExtractor, hence it is only
+ * defined for stateless key extractors (e.g. lambdas without captures), since
+ * two objects of the same capturing type may extract different keys.
+ */
+template <typename KeyExtractor>
+class KeyPartitioning
+{
+public:
+    //! return the tag identifying the partitioning, or nullptr if undefined.
+    static const std::type_info * tag() {
+        return std::is_empty<KeyExtractor>::value
+               ? &typeid(KeyPartitioning) : nullptr;
+    }
+};
+
+/*!
+ * Running costs of a DIANode, which the StageBuilder measures while executing
+ * its Stages.
+ */
+struct DIACost {
+    //! duration of the last Execute() in milliseconds
+    double execute_ms = 0;
+    //! duration of the last PushData() in milliseconds, which includes the
+    //! PreOps of the children.
+    double push_data_ms = 0;
+    //! bytes pushed by the last PushData(), as estimated by PushDataBytes()
+    size_t push_bytes = 0;
+    //! number of PushData() calls
+    size_t num_pushes = 0;
+};
+
 /*!
  * The DIABase is the untyped super class of DIANode. DIABases are used to build
  * the execution graph, which is used to execute the computation.
@@ -133,9 +186,17 @@ public:
         // Remove child pointer from parent If a parent loses all its childs its
         // reference count should be zero and he should be removed
 
+        // report memory attributed to this node: the peak RAM of its Blocks
+        // and reservations, and the bytes it evicted and read back.
+        data::BlockPool::DIAMemory mem =
+            context_.block_pool().TakeDIAMemory(id_);
+
         logger_ << "class" << "DIABase"
                 << "event" << "destroy"
-                << "parents" << parent_ids();
+                << "parents" << parent_ids()
+                << "peak_ram_bytes" << mem.peak_ram_bytes
+                << "evicted_bytes" << mem.evicted_bytes
+                << "read_bytes" << mem.read_bytes;
 
         // de-register at parents (if still hooked there)
         for (const DIABasePtr& p : parents_)
@@ -178,6 +239,22 @@ public:
     //! Virtual method for pushing data. Triggers actual pushing in sub-classes.
     virtual void PushData(bool consume) = 0;
 
+    //! Estimated number of bytes pushed by PushData() on this worker, e.g. the
+    //! size of stored data::Files, or zero if unknown. Recorded by the
+    //! StageBuilder in the stage's profile.
+    virtual size_t PushDataBytes() { return 0; }
+
+    //! Called by the StageBuilder before the Stage preceding this node's next
+    //! Execute() or PushData() runs. Nodes holding Files should start reading
+    //! their swapped out Blocks in the background, without blocking, such
+    //! that the Stage starts with data in RAM.
+    virtual void PrefetchData() { }
+
+    //! Returns true if PushData() recomputes the items on each call, e.g. by
+    //! reading files, instead of pushing stored data. The pushed items of such
+    //! nodes are stored in a File if this is cheaper than recomputing them.
+    virtual bool Recomputes() { return false; }
+
     //! Virtual clear method. Triggers actual disposing in sub-classes.
     virtual void Dispose() { }
 
@@ -261,6 +338,61 @@ public:
 
     void set_mem_limit(const DIAMemUse& mem_limit) { mem_limit_ = mem_limit; }
 
+    //! Hint to give this node the fraction of the Stage's RAM instead of an
+    //! equal share, if it requests DIAMemUse::Max(). Zero removes the hint.
+    void set_mem_fraction(double fraction) {
+        assert(fraction >= 0.0 && fraction <= 1.0);
+        mem_fraction_ = fraction;
+        mem_bytes_ = 0;
+    }
+
+    //! Hint to give this node the given bytes of RAM instead of an equal
+    //! share, if it requests DIAMemUse::Max(). Zero removes the hint.
+    void set_mem_bytes(size_t bytes) {
+        mem_bytes_ = bytes;
+        mem_fraction_ = 0.0;
+    }
+
+    //! Returns whether a memory hint was set.
+    bool has_mem_hint() const {
+        return mem_fraction_ != 0.0 || mem_bytes_ != 0;
+    }
+
+    //! Returns the RAM given to this node by its memory hint, out of the
+    //! available bytes.
+    size_t HintedMemLimit(size_t available) const {
+        assert(has_mem_hint());
+        if (mem_bytes_ != 0) return std::min(mem_bytes_, available);
+        return static_cast<size_t>(mem_fraction_ * available);
+    }
+
+    //! Returns the running costs measured by the StageBuilder.
+    const DIACost& cost() const { return cost_; }
+
+    //! Record the duration of Execute(), called by the StageBuilder.
+    void RecordExecute(double ms) { cost_.execute_ms = ms; }
+
+    //! Record the duration and size of PushData(), called by the StageBuilder.
+    void RecordPushData(double ms, size_t bytes) {
+        cost_.push_data_ms = ms;
+        cost_.push_bytes = bytes;
+        ++cost_.num_pushes;
+    }
+
+    //! Returns the KeyPartitioning tag of the items pushed by this node, or
+    //! nullptr if they are not known to be partitioned.
+    const std::type_info * partitioning() const { return partitioning_; }
+
+    //! Test if the items pushed by this node are partitioned by the given
+    //! KeyPartitioning tag, in which case a following DOp on the same key can
+    //! skip its shuffle.
+    bool is_partitioned_by(const std::type_info* tag) const {
+        return tag != nullptr && partitioning_ != nullptr &&
+               *partitioning_ == *tag;
+    }
+
+    void set_partitioning(const std::type_info* tag) { partitioning_ = tag; }
+
 protected:
     //! \name Fixed DIA Information
     //! \{
@@ -289,10 +421,22 @@ protected:
     //! is allowed to use.
     DIAMemUse mem_limit_ = 0;
 
+    //! user hint for the fraction of the Stage's RAM, or zero.
+    double mem_fraction_ = 0.0;
+
+    //! user hint for the bytes of RAM, or zero.
+    size_t mem_bytes_ = 0;
+
     //! Consumption counter: when it reaches zero, PushData() is called with
     //! consume = true
     size_t consume_counter_ = 1;
 
+    //! running costs measured by the StageBuilder
+    DIACost cost_;
+
+    //! KeyPartitioning tag of the pushed items, nullptr if unknown.
+    const std::type_info* partitioning_ = nullptr;
+
     //! Never full consume
     static constexpr size_t never_consume_ = static_cast<size_t>(-1);
 
@@ -16,7 +16,11 @@
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
+#include <functional>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -25,6 +29,16 @@ namespace api {
 //! \ingroup api_layer
 //! \{
 
+//! test whether items of type T can be serialized into a data::File, which is
+//! not the case for views such as common::StringView.
+template <typename T, typename = void>
+struct IsFileSerializable : public std::false_type { };
+
+template <typename T>
+struct IsFileSerializable<
+    T, decltype(void(sizeof(data::Serialization<data::File::Writer, T>)))>
+    : public std::true_type { };
+
 /*!
  * A DIANode is a typed node representing and operation in Thrill. It is the
  * super class for all operation nodes and stores the state of the
@@ -39,11 +53,20 @@ class DIANode : public DIABase
 public:
     using Callback = std::function<void(const ValueType&)>;
 
+    //! callback to invoke for a batch of items
+    using BatchCallback = std::function<void(const ValueType*, size_t)>;
+
+    //! number of items in the batches pushed by PushFile() and some sources
+    static constexpr size_t push_batch_size = 256;
+
     struct Child {
         //! reference to child node
         DIABase  * node;
-        //! callback to invoke (currently for each item)
+        //! callback to invoke for each item
         Callback callback;
+        //! callback to invoke for a batch of items, which runs the function
+        //! chain of the child in a loop, such that it is inlined.
+        BatchCallback batch_callback;
         //! index this node has among the parents of the child (passed to
         //! callbacks), e.g. for ZipNode which has multiple parents and their order
         //! is important.
@@ -72,10 +95,25 @@ public:
      * Enables children to push their "folded" function chains to their parent.
      * This way the parent can push all its result elements to each of the
      * children. This procedure enables the minimization of IO-accesses.
+     *
+     * The callback is used for single items and batches of items. Both share
+     * one copy of it, since the function chain may be stateful.
      */
-    void AddChild(DIABase* node, const Callback& callback,
+    template <typename Function>
+    void AddChild(DIABase* node, const Function& callback,
                   size_t parent_index = 0) {
-        children_.emplace_back(Child { node, callback, parent_index });
+        auto fn = std::make_shared<Function>(callback);
+        children_.emplace_back(
+            Child {
+                node,
+                [fn](const ValueType& item) { (*fn)(item); },
+                [fn](const ValueType* items, size_t size) {
+                    Function& f = *fn;
+                    for (const ValueType* end = items + size;
+                         items != end; ++items) f(*items);
+                },
+                parent_index
+            });
     }
 
     //! Remove a child from the vector of children. This method is called by the
@@ -128,23 +166,66 @@ public:
             --consume_counter_;
 
         bool consume = context().consume() && consume_counter_ == 0;
-        PushData(consume);
+        pushing_items_ = 0;
+        if (recompute_ && !recompute_->writing) {
+            // push the stored items instead of recomputing them
+            PushRecomputeFile(IsFileSerializable<ValueType>());
+        }
+        else {
+            StartRecomputeFile();
+            PushData(consume);
+            FinishRecomputeFile();
+        }
         if (consume) Dispose();
+        pushed_items_ = pushing_items_;
 
         for (const Child& child : children_)
             child.node->StopPreOp(child.parent_index);
     }
 
+    //! Returns the number of local items pushed by the last PushData(), which
+    //! a further PushData() delivers again, or -1 if not pushed yet.
+    size_t pushed_items() const { return pushed_items_; }
+
+    //! Count an access to the items, which did not need a PushData() since
+    //! pushed_items() sufficed, towards consumption.
+    void ConsumeWithoutPush() {
+        if (consume_counter_ > 0 && consume_counter_ != never_consume_)
+            --consume_counter_;
+        if (context().consume() && consume_counter_ == 0) Dispose();
+    }
+
     //! Method for derived classes to Push a single item to all children.
     void PushItem(const ValueType& item) const {
         for (const Child& child : children_) {
             child.callback(item);
         }
+        if (recompute_ && recompute_->writing)
+            StoreRecomputeItems(
+                &item, 1, IsFileSerializable<ValueType>());
+        ++pushing_items_;
+    }
+
+    //! Method for derived classes to Push a batch of items to all children,
+    //! which runs the function chain of each child once per batch.
+    void PushItems(const ValueType* items, size_t size) const {
+        for (const Child& child : children_) {
+            child.batch_callback(items, size);
+        }
+        if (recompute_ && recompute_->writing)
+            StoreRecomputeItems(
+                items, size, IsFileSerializable<ValueType>());
+        pushing_items_ += size;
     }
 
     //! Method for derived classes to Push a whole File of ValueType items to
     //! all children.
     void PushFile(data::File& file, bool consume) const {
+        // the items are already stored in a File, do not store them again.
+        if (recompute_ && recompute_->writing)
+            recompute_->abandoned = true;
+        pushing_items_ += file.num_items();
+
         // iterate over children, push directly into those with data:File*
         std::vector<Child> nonfile_children;
         for (const Child& child : children_) {
@@ -156,12 +237,17 @@ public:
 
         if (nonfile_children.size() == 0) return;
 
-        // push into remaining which have a function stack or no direct File*
+        // push into remaining which have a function stack or no direct File*,
+        // in batches of items.
         data::File::Reader reader = file.GetReader(consume);
+        std::vector<ValueType> batch;
+        batch.reserve(push_batch_size);
         while (reader.HasNext()) {
-            ValueType item = reader.Next<ValueType>();
+            batch.clear();
+            while (batch.size() < push_batch_size && reader.HasNext())
+                batch.emplace_back(reader.Next<ValueType>());
             for (const Child& child : nonfile_children) {
-                child.callback(item);
+                child.batch_callback(batch.data(), batch.size());
             }
         }
     }
@@ -169,6 +255,96 @@ public:
 protected:
     //! Callback functions from the child nodes.
     std::vector<Child> children_;
+
+private:
+    //! number of items pushed by the current PushData()
+    mutable size_t pushing_items_ = 0;
+
+    //! number of items pushed by the last PushData(), -1 if not pushed yet.
+    size_t pushed_items_ = size_t(-1);
+
+    //! log decisions about storing recomputed items
+    static constexpr bool debug_recompute = false;
+
+    //! estimated bandwidth of writing a File, which may be spilled to disk, and
+    //! reading it back, in bytes per millisecond.
+    static constexpr double recompute_bytes_per_ms = 100 * 1024;
+
+    //! File storing the items of a node which Recomputes() them
+    struct RecomputeFile {
+        explicit RecomputeFile(data::File&& f, size_t max)
+            : file(std::move(f)), writer(file.GetWriter()), max_bytes(max) { }
+
+        //! the stored items
+        data::File file;
+        //! writer into file, while the items are being stored
+        data::File::Writer writer;
+        //! size beyond which recomputing is cheaper than writing the File
+        size_t max_bytes;
+        //! true while storing pushed items
+        bool writing = true;
+        //! set if the File grew beyond max_bytes
+        bool abandoned = false;
+    };
+
+    //! items stored instead of recomputing them, or nullptr
+    std::unique_ptr<RecomputeFile> recompute_;
+
+    //! On the second PushData() of a node which Recomputes() its items, start
+    //! storing them in a File, if the first PushData() took longer than
+    //! writing and reading at least one Block would. The first push is only
+    //! measured, since most nodes are pushed once.
+    void StartRecomputeFile() {
+        if (!IsFileSerializable<ValueType>::value ||
+            !Recomputes() || cost_.num_pushes != 1) return;
+
+        size_t max_bytes = static_cast<size_t>(
+            cost_.push_data_ms * recompute_bytes_per_ms / 2);
+        if (max_bytes < data::default_block_size) return;
+
+        recompute_ = std::make_unique<RecomputeFile>(
+            context_.GetFile(this), max_bytes);
+    }
+
+    //! Store pushed items in the File, unless it grew too large, in which case
+    //! recomputing the items is cheaper.
+    void StoreRecomputeItems(const ValueType* items, size_t size,
+                             std::true_type /* serializable */) const {
+        if (recompute_->abandoned) return;
+        for (const ValueType* end = items + size; items != end; ++items)
+            recompute_->writer.Put(*items);
+        if (recompute_->file.size_bytes() > recompute_->max_bytes)
+            recompute_->abandoned = true;
+    }
+
+    void StoreRecomputeItems(const ValueType*, size_t,
+                             std::false_type /* serializable */) const { }
+
+    //! Push the stored items to all children.
+    void PushRecomputeFile(std::true_type /* serializable */) {
+        PushFile(recompute_->file, /* consume */ false);
+    }
+
+    void PushRecomputeFile(std::false_type /* serializable */) { }
+
+    //! Close the File after PushData(), and keep it if it is complete.
+    void FinishRecomputeFile() {
+        if (!recompute_ || !recompute_->writing) return;
+        recompute_->writer.Close();
+        recompute_->writing = false;
+
+        if (recompute_->abandoned) {
+            sLOGC(debug_recompute)
+                << "DIANode" << *this << "recomputes items after"
+                << cost_.push_data_ms << "ms";
+            recompute_.reset();
+            return;
+        }
+        sLOGC(debug_recompute)
+            << "DIANode" << *this << "stores" << recompute_->file.size_bytes()
+            << "bytes instead of recomputing them in"
+            << cost_.push_data_ms << "ms";
+    }
 };
 
 //! \}
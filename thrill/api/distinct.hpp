@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * thrill/api/distinct.hpp
+ *
+ * DIANode for a distinct operation, which is a ReduceByKey keeping one element
+ * of each key.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_DISTINCT_HEADER
+#define THRILL_API_DISTINCT_HEADER
+
+#include <thrill/api/reduce_by_key.hpp>
+
+#include <type_traits>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename ReduceConfig>
+auto DIA<ValueType, Stack>::Distinct(
+    const KeyExtractor &key_extractor,
+    const ReduceConfig &reduce_config) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>
+                                ::template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    // keep the first element of each key: the tables drop all others when
+    // they are inserted, hence they are never sent.
+    auto keep_first = [](const ValueType& a, const ValueType&) {
+                          return a;
+                      };
+
+    using ReduceNode = api::ReduceNode<
+              ValueType, DIA, KeyExtractor, decltype(keep_first),
+              ReduceConfig, /* VolatileKey */ false, false>;
+    auto node = common::MakeCounting<ReduceNode>(
+        *this, "Distinct", key_extractor, keep_first, reduce_config);
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+auto DIA<ValueType, Stack>::Distinct() const {
+    return Distinct([](const ValueType& v) { return v; });
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_DISTINCT_HEADER
+
+/******************************************************************************/
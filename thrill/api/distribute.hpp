@@ -15,7 +15,11 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/data/serialization.hpp>
 
+#include <iterator>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -34,6 +38,12 @@ public:
     using Super = SourceNode<ValueType>;
     using Super::context_;
 
+    //! whether the vector holds PODs, which are copied into Blocks and
+    //! scattered as File slices.
+    using RawItems = std::integral_constant<
+              bool, data::is_raw_serializable<ValueType>::value &&
+              !std::is_same<ValueType, bool>::value>;
+
     DistributeNode(Context& ctx,
                    const std::vector<ValueType>& in_vector,
                    size_t source_id)
@@ -50,37 +60,44 @@ public:
           source_id_(source_id)
     { }
 
-    //! Executes the scatter operation: source sends out its data.
+    //! Executes the scatter operation: source sends out its data, and all
+    //! workers receive their range into a File.
     void Execute() final {
+        if (context_.my_rank() == source_id_) {
+            Send(RawItems());
+            std::vector<ValueType>().swap(in_vector_);
+        }
+        else {
+            for (data::CatStream::Writer& w : stream_->GetWriters())
+                w.Close();
+        }
 
-        std::vector<data::CatStream::Writer> emitters = stream_->GetWriters();
-
-        if (context_.my_rank() == source_id_)
-        {
-            size_t in_size = in_vector_.size();
-
-            for (size_t w = 0; w < emitters.size(); ++w) {
-
-                common::Range local =
-                    common::CalculateLocalRange(in_size, emitters.size(), w);
+        // all items arrive from the source, either as Blocks or moved.
+        std::vector<data::CatStream::Reader> readers = stream_->GetReaders();
+        data::PinnedBlock pb;
+        while ((pb = readers[source_id_].source().NextBlock()).IsValid())
+            file_.AppendBlock(std::move(pb).MoveToBlock());
 
-                for (size_t i = local.begin; i < local.end; ++i) {
-                    emitters[w].Put(in_vector_[i]);
-                }
-            }
+        size_t workers_per_host = context_.workers_per_host();
+        if (source_id_ / workers_per_host == context_.host_rank()) {
+            local_items_ = stream_->TakeLocalItems<ValueType>(
+                source_id_ % workers_per_host);
         }
+
+        stream_->Close();
     }
 
     void PushData(bool consume) final {
-        data::CatStream::CatReader readers = stream_->GetCatReader(consume);
-
-        while (readers.HasNext()) {
-            this->PushItem(readers.Next<ValueType>());
+        if (!local_items_.empty()) {
+            this->PushItems(local_items_.data(), local_items_.size());
+            if (consume) std::vector<ValueType>().swap(local_items_);
+            return;
         }
-
-        stream_->Close();
+        this->PushFile(file_, consume);
     }
 
+    size_t PushDataBytes() final { return file_.size_bytes(); }
+
 private:
     //! Vector pointer to read elements from.
     std::vector<ValueType> in_vector_;
@@ -88,6 +105,63 @@ private:
     size_t source_id_;
 
     data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+
+    //! received Blocks of the local range
+    data::File file_ { context_.GetFile(this) };
+
+    //! local range moved from the source on the same host
+    std::vector<ValueType> local_items_;
+
+    //! PODs are copied into a File once, whose slices are scattered as Blocks
+    //! without serialization. Workers on the source's host receive references
+    //! to the same Blocks.
+    void Send(std::true_type /* raw */) {
+        const size_t num_workers = context_.num_workers();
+        std::vector<size_t> offsets(num_workers + 1);
+        for (size_t w = 0; w < num_workers; ++w) {
+            offsets[w] = common::CalculateLocalRange(
+                in_vector_.size(), num_workers, w).begin;
+        }
+        offsets[num_workers] = in_vector_.size();
+
+        data::File file = context_.GetFile(this);
+        file.AppendRawItems(in_vector_.data(), in_vector_.size());
+        std::vector<ValueType>().swap(in_vector_);
+
+        stream_->template Scatter<ValueType>(file, offsets, /* consume */ true);
+    }
+
+    //! Other items are serialized for remote workers, the ranges of workers
+    //! on the source's host are moved to them without serialization.
+    void Send(std::false_type /* raw */) {
+        std::vector<data::CatStream::Writer> emitters = stream_->GetWriters();
+
+        size_t in_size = in_vector_.size();
+        size_t workers_per_host = context_.workers_per_host();
+
+        for (size_t w = 0; w < emitters.size(); ++w) {
+
+            common::Range local =
+                common::CalculateLocalRange(in_size, emitters.size(), w);
+
+            if (w / workers_per_host == context_.host_rank()) {
+                stream_->MoveToLocalWorker(
+                    w % workers_per_host,
+                    std::vector<ValueType>(
+                        std::make_move_iterator(
+                            in_vector_.begin() + local.begin),
+                        std::make_move_iterator(
+                            in_vector_.begin() + local.end)));
+                emitters[w].Close();
+                continue;
+            }
+
+            for (size_t i = local.begin; i < local.end; ++i) {
+                emitters[w].Put(in_vector_[i]);
+            }
+            emitters[w].Close();
+        }
+    }
 };
 
 /*!
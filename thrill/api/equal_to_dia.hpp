@@ -15,7 +15,10 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/data/serialization.hpp>
 
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -31,19 +34,32 @@ public:
     using Super = SourceNode<ValueType>;
     using Super::context_;
 
+    //! whether the local range of PODs is copied into the Blocks of a File,
+    //! which is pushed to children as a whole, instead of keeping the vector.
+    using RawItems = std::integral_constant<
+              bool, data::is_raw_serializable<ValueType>::value &&
+              !std::is_same<ValueType, bool>::value>;
+
     EqualToDIANode(Context& ctx,
                    const std::vector<ValueType>& in_vector)
         : SourceNode<ValueType>(ctx, "EqualToDIA"),
-          in_vector_(in_vector)
-    { }
+          file_(ctx.GetFile(this)) {
+        Store(in_vector, RawItems());
+    }
 
     EqualToDIANode(Context& ctx,
                    std::vector<ValueType>&& in_vector)
         : SourceNode<ValueType>(ctx, "EqualToDIA"),
-          in_vector_(std::move(in_vector))
-    { }
+          file_(ctx.GetFile(this)) {
+        Store(std::move(in_vector), RawItems());
+    }
 
     void PushData(bool /* consume */) final {
+        if (RawItems::value) {
+            this->PushFile(file_, /* consume */ false);
+            return;
+        }
+
         common::Range local = context_.CalculateLocalRange(in_vector_.size());
 
         for (size_t i = local.begin; i < local.end; ++i) {
@@ -51,9 +67,29 @@ public:
         }
     }
 
+    size_t PushDataBytes() final { return file_.size_bytes(); }
+
 private:
     //! Vector pointer to read elements from.
     std::vector<ValueType> in_vector_;
+
+    //! File holding the local range of PODs
+    data::File file_;
+
+    void Store(const std::vector<ValueType>& v, std::true_type /* raw */) {
+        common::Range local = context_.CalculateLocalRange(v.size());
+        file_.AppendRawItems(v.data() + local.begin, local.size());
+    }
+
+    void Store(std::vector<ValueType>&& v, std::true_type /* raw */) {
+        Store(v, std::true_type());
+        std::vector<ValueType>().swap(v);
+    }
+
+    template <typename Vector>
+    void Store(Vector&& v, std::false_type /* raw */) {
+        in_vector_ = std::forward<Vector>(v);
+    }
 };
 
 /*!
@@ -62,6 +98,10 @@ private:
  * data from a single worker, EqualToDIA is a wrapper if the data is already
  * distributed.
  *
+ * Items of PODs are copied into the Blocks of a File, which is pushed to
+ * children as a whole, such that e.g. Sort takes it over without
+ * deserialization.
+ *
  * \param ctx Reference to the Context object
  *
  * \param in_vector Vector to convert to a DIA, the contents is COPIED into the
@@ -84,6 +124,10 @@ auto EqualToDIA(Context & ctx,
  * data from a single worker, EqualToDIA is a wrapper if the data is already
  * distributed.
  *
+ * Items of PODs are copied into the Blocks of a File, which is pushed to
+ * children as a whole, such that e.g. Sort takes it over without
+ * deserialization.
+ *
  * \param ctx Reference to the Context object
  *
  * \param in_vector Vector to convert to a DIA, the contents is MOVED into the
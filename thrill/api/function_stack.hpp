@@ -33,6 +33,9 @@ namespace api {
  * receives an input element, no emitter and should have no return type.  It
  * should therefore store the input parameter externally.
  *
+ * Inputs are perfectly forwarded, hence an item created by a previous lambda
+ * reaches the next one as an rvalue and may be moved instead of copied.
+ *
  * \param lambda Lambda function that represents the chain end.
  */
 template <typename Lambda>
@@ -40,8 +43,8 @@ auto RunEmitter(const Lambda &lambda)
 {
     // lambda is captured by non-const copy so that we can use functors with
     // non-const operator(), i.e. stateful functors (e.g. for sampling)
-    return [=, lambda = lambda](const auto & input) mutable->void {
-               lambda(input);
+    return [=, lambda = lambda](auto && input) mutable->void {
+               lambda(std::forward<decltype(input)>(input));
     };
 }
 
@@ -60,8 +63,9 @@ auto RunEmitter(const Lambda &lambda, const MoreLambdas &... rest)
 {
     // lambda is captured by non-const copy so that we can use functors with
     // non-const operator(), i.e. stateful functors (e.g. for sampling)
-    return [=, lambda = lambda](const auto & input) mutable->void {
-               lambda(input, RunEmitter(rest ...));
+    return [=, lambda = lambda](auto && input) mutable->void {
+               lambda(std::forward<decltype(input)>(input),
+                      RunEmitter(rest ...));
     };
 }
 
@@ -73,6 +77,10 @@ auto RunEmitter(const Lambda &lambda, const MoreLambdas &... rest)
  * function is used for chaining lambdas together.  The single exception to this
  * is the last lambda function, which receives no emitter.
  *
+ * Emitters take forwarding references, hence lambdas which take their input
+ * by value or as rvalue reference receive the items emitted by the previous
+ * lambda by move.
+ *
  * \tparam Lambdas Types of the different lambda functions.
  */
 template <typename Input_, typename ... Lambdas>
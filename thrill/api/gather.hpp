@@ -14,7 +14,10 @@
 
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/data/file.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -22,6 +25,12 @@ namespace thrill {
 namespace api {
 
 /*!
+ * A ActionNode which collects all items on one worker. The items are stored
+ * in a local File first. Small DIAs are sent directly to the target, larger
+ * ones along a binomial tree rooted at the target, such that each worker
+ * receives from at most log(p) others. Inner tree nodes forward the Blocks
+ * from their children as they arrive, without deserializing them.
+ *
  * \ingroup api_layer
  */
 template <typename ParentDIA>
@@ -34,6 +43,9 @@ public:
     //! input and output type is the parent's output value type.
     using ValueType = typename ParentDIA::ValueType;
 
+    //! minimum total size in bytes for the binomial tree
+    static constexpr size_t tree_min_bytes = 4 * 1024 * 1024;
+
     GatherNode(const ParentDIA& parent, const char* label,
                size_t target_id,
                std::vector<ValueType>* out_vector)
@@ -45,7 +57,7 @@ public:
         assert(target_id_ < context_.num_workers());
 
         auto pre_op_fn = [this](const ValueType& input) {
-                             emitters_[target_id_].Put(input);
+                             writer_.Put(input);
                          };
 
         // close the function stack with our pre op and register it at parent
@@ -54,26 +66,89 @@ public:
         parent.node()->AddChild(this, lop_chain);
     }
 
-    void StartPreOp(size_t /* id */) final {
-        emitters_ = stream_->GetWriters();
-
-        // close all but the target
-        for (size_t i = 0; i < emitters_.size(); i++) {
-            if (i == target_id_) continue;
-            emitters_[i].Close();
-        }
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!ParentDIA::stack_empty) return false;
+        assert(file_.num_items() == 0);
+        file_ = file.Copy();
+        return true;
     }
 
     void StopPreOp(size_t /* id */) final {
-        emitters_[target_id_].Close();
+        writer_.Close();
     }
 
     void Execute() final {
-        auto reader = stream_->GetCatReader(true /* consume */);
+        size_t p = context_.num_workers();
+        size_t total_bytes = context_.net.AllReduce(file_.size_bytes());
+
+        std::vector<data::CatStream::Writer> writers = stream_->GetWriters();
+
+        if (p <= 2 || total_bytes < tree_min_bytes) {
+            // send all Blocks directly to the target
+            for (size_t i = 0; i < p; ++i) {
+                if (i == target_id_) writers[i].AppendBlocks(file_.blocks());
+                writers[i].Close();
+            }
+            file_.Clear();
+
+            auto reader = stream_->GetCatReader(true /* consume */);
+            while (reader.HasNext()) {
+                out_vector_->push_back(reader.template Next<ValueType>());
+            }
+            return;
+        }
 
-        while (reader.HasNext()) {
-            out_vector_->push_back(reader.template Next<ValueType>());
+        // number of items on workers before this one, used by the target to
+        // reorder the items it receives in tree order.
+        size_t rank_offset = context_.net.ExPrefixSum(file_.num_items());
+
+        // binomial tree over the ranks relative to the target: the subtree of
+        // q contains [q, q + lowbit(q)), and is sent to q - lowbit(q).
+        size_t q = (context_.my_rank() + p - target_id_) % p;
+        size_t lowbit = q == 0 ? common::RoundUpToPowerOfTwo(p) : (q & (~q + 1));
+
+        std::vector<size_t> children;
+        for (size_t k = 1; k < lowbit && q + k < p; k <<= 1)
+            children.push_back((q + k + target_id_) % p);
+
+        std::vector<data::CatStream::Reader> readers = stream_->GetReaders();
+
+        if (q != 0) {
+            size_t parent = (q - lowbit + target_id_) % p;
+            for (size_t i = 0; i < p; ++i) {
+                if (i != parent) writers[i].Close();
+            }
+
+            // send own Blocks, then forward the subtrees in order.
+            writers[parent].AppendBlocks(file_.blocks());
+            file_.Clear();
+
+            for (size_t c : children) {
+                data::PinnedBlock b;
+                while ((b = readers[c].source().NextBlock()).IsValid())
+                    writers[parent].AppendBlock(std::move(b).MoveToBlock());
+            }
+            writers[parent].Close();
+            return;
         }
+
+        for (size_t i = 0; i < p; ++i) writers[i].Close();
+
+        size_t begin = out_vector_->size();
+        {
+            auto reader = file_.GetConsumeReader();
+            while (reader.HasNext())
+                out_vector_->push_back(reader.template Next<ValueType>());
+        }
+        for (size_t c : children) {
+            while (readers[c].HasNext())
+                out_vector_->push_back(readers[c].template Next<ValueType>());
+        }
+
+        // the items arrived in the order of the workers target, ..., p - 1, 0,
+        // ..., target - 1.
+        std::rotate(out_vector_->begin() + begin,
+                    out_vector_->end() - rank_offset, out_vector_->end());
     }
 
 private:
@@ -83,8 +158,12 @@ private:
     //! Vector pointer to write elements to.
     std::vector<ValueType>* out_vector_;
 
+    //! local items
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+
     data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
-    std::vector<data::CatStream::Writer> emitters_;
 };
 
 template <typename ValueType, typename Stack>
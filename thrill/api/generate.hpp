@@ -17,9 +17,11 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/philox.hpp>
 
 #include <random>
 #include <type_traits>
+#include <vector>
 
 namespace thrill {
 namespace api {
@@ -52,11 +54,20 @@ public:
           size_(size)
     { }
 
+    //! calls the generator function again on each PushData()
+    bool Recomputes() final { return true; }
+
     void PushData(bool /* consume */) final {
         common::Range local = context_.CalculateLocalRange(size_);
 
-        for (size_t i = local.begin; i < local.end; i++) {
-            this->PushItem(generator_function_(i));
+        // generate and push items in batches
+        std::vector<ValueType> batch;
+        batch.reserve(Super::push_batch_size);
+        for (size_t i = local.begin; i < local.end; ) {
+            batch.clear();
+            for ( ; i < local.end && batch.size() < Super::push_batch_size; ++i)
+                batch.emplace_back(generator_function_(i));
+            this->PushItems(batch.data(), batch.size());
         }
     }
 
@@ -120,10 +131,54 @@ auto Generate(Context & ctx, size_t size) {
     return Generate(ctx, [](const size_t& index) { return index; }, size);
 }
 
+/*!
+ * GenerateRandom is a Source-DOp, which creates a DIA of given size using a
+ * generator function, which is called for each index in the range of
+ * `[0,size)` with a random generator for the index. The generator is a
+ * counter-based common::PhiloxEngine, whose stream is determined by the seed
+ * and the index only, hence the DIA's items do not depend on the number of
+ * workers or on the order in which the items are generated.
+ *
+ * \param ctx Reference to the Context object
+ *
+ * \param generator_function Generator function, which maps a `size_t` index
+ * and a `common::PhiloxEngine&` to an element.
+ *
+ * \param size Size of the output DIA
+ *
+ * \param seed Seed of the random streams
+ *
+ * \ingroup dia_sources
+ */
+template <typename GeneratorFunction>
+auto GenerateRandom(Context & ctx,
+                    const GeneratorFunction &generator_function,
+                    size_t size, uint64_t seed) {
+
+    static_assert(
+        std::is_convertible<
+            common::PhiloxEngine&,
+            typename common::FunctionTraits<GeneratorFunction>::template arg<1>
+            >::value,
+        "GeneratorFunction needs a common::PhiloxEngine& as second input");
+
+    using GeneratorResult =
+              typename common::FunctionTraits<GeneratorFunction>::result_type;
+
+    return Generate(
+        ctx,
+        [generator_function, seed](const size_t& index) -> GeneratorResult {
+            common::PhiloxEngine rng(seed, index);
+            return generator_function(index, rng);
+        },
+        size);
+}
+
 } // namespace api
 
 //! imported from api namespace
 using api::Generate;
+using api::GenerateRandom;
 
 } // namespace thrill
 
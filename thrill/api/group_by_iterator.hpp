@@ -34,7 +34,8 @@ namespace api {
 
 // forward declarations for friend classes
 template <typename ValueType, typename ParentDIA,
-          typename KeyExtractor, typename GroupFunction, typename HashFunction>
+          typename KeyExtractor, typename GroupFunction, typename HashFunction,
+          bool Streaming>
 class GroupByNode;
 
 template <typename ValueType, typename ParentDIA,
@@ -50,7 +51,8 @@ class GroupByIterator
               typename T2,
               typename T3,
               typename T4,
-              typename T5>
+              typename T5,
+              bool T6>
     friend class GroupByNode;
 
     template <typename T1,
@@ -127,14 +129,18 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename ValueType, typename KeyExtractor, typename Comparator>
+template <typename ValueType, typename KeyExtractor, typename Comparator,
+          typename Puller_ = core::MultiwayMergeTree<
+              ValueType, std::vector<data::File::ConsumeReader>::iterator,
+              Comparator> >
 class GroupByMultiwayMergeIterator
 {
     template <typename T1,
               typename T2,
               typename T3,
               typename T4,
-              typename T5>
+              typename T5,
+              bool T6>
     friend class GroupByNode;
 
     template <typename T1,
@@ -147,8 +153,7 @@ public:
     static constexpr bool debug = false;
     using ValueIn = ValueType;
     using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
-    using Puller = core::MultiwayMergeTree<
-              ValueIn, std::vector<data::File::ConsumeReader>::iterator, Comparator>;
+    using Puller = Puller_;
 
     GroupByMultiwayMergeIterator(Puller& reader, const KeyExtractor& key_extractor)
         : reader_(reader),
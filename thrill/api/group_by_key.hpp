@@ -17,13 +17,16 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dop_node.hpp>
 #include <thrill/api/group_by_iterator.hpp>
+#include <thrill/api/reduce_by_key.hpp>
 #include <thrill/common/functional.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/mem/malloc_tracker.hpp>
 
 #include <algorithm>
 #include <functional>
 #include <type_traits>
 #include <typeinfo>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,10 +34,21 @@ namespace thrill {
 namespace api {
 
 /*!
+ * A DIANode which performs a GroupBy operation. Items are hash partitioned by
+ * key, and each worker groups its received items by sorting them, or by
+ * hashing if they fit into RAM.
+ *
+ * In Streaming mode, each worker instead sorts its items before sending them,
+ * hence every worker receives one sorted stream from each worker. These
+ * streams are merged on arrival via a loser tree, and the GroupFunction is
+ * called as soon as all items of a key arrived, without storing the received
+ * items. The results are stored only if they are pushed again.
+ *
  * \ingroup api_layer
  */
 template <typename ValueType, typename ParentDIA,
-          typename KeyExtractor, typename GroupFunction, typename HashFunction>
+          typename KeyExtractor, typename GroupFunction, typename HashFunction,
+          bool Streaming>
 class GroupByNode final : public DOpNode<ValueType>
 {
     static constexpr bool debug = false;
@@ -72,7 +86,10 @@ public:
         : Super(parent.ctx(), "GroupByKey", { parent.id() }, { parent.node() }),
           key_extractor_(key_extractor),
           groupby_function_(groupby_function),
-          hash_function_(hash_function)
+          hash_function_(hash_function),
+          local_(ParentDIA::stack_empty &&
+                 parent.node()->is_partitioned_by(
+                     KeyPartitioning<KeyExtractor>::tag()))
     {
         // Hook PreOp
         auto pre_op_fn = [=](const ValueIn& input) {
@@ -90,22 +107,34 @@ public:
 
     //! Send all elements to their designated PEs
     void PreOp(const ValueIn& v) {
-        const Key k = key_extractor_(v);
-        const size_t recipient = hash_function_(k) % emitter_.size();
-        emitter_[recipient].Put(v);
+        if (Streaming) {
+            // collect sorted runs, which are sent in StopPreOp()
+            incoming_.emplace_back(v);
+            if (mem::memory_exceeded ||
+                (pressure_.requested() && IsMinRun(incoming_))) {
+                pressure_.Take();
+                FlushVectorToFile(incoming_);
+                incoming_.clear();
+            }
+            return;
+        }
+        emitter_[Recipient(v)].Put(v);
     }
 
     void StopPreOp(size_t /* id */) final {
+        if (Streaming) SendSortedRuns();
         // data has been pushed during pre-op -> close emitters
         for (size_t i = 0; i < emitter_.size(); i++)
             emitter_[i].Close();
     }
 
     void Execute() override {
-        MainOp();
+        if (!Streaming) MainOp();
     }
 
     void PushData(bool consume) final {
+        if (Streaming) return PushStreaming(consume);
+
         LOG << "sort data";
         common::StatsTimerStart timer;
         const size_t num_runs = files_.size();
@@ -159,12 +188,98 @@ private:
     GroupFunction groupby_function_;
     HashFunction hash_function_;
 
+    //! whether the parent is partitioned by the key, hence no shuffle is
+    //! needed.
+    bool local_;
+
+    //! Streaming mode: items collected in the PreOp
+    std::vector<ValueIn> incoming_;
+
+    //! Streaming mode: whether the streams were merged in PushData()
+    bool streamed_ = false;
+
+    //! Streaming mode: results of the GroupFunction, if pushed again
+    data::File results_ { context_.GetFile(this) };
+
     data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
     std::vector<data::Stream::Writer> emitter_;
     std::vector<data::File> files_;
     data::File sorted_elems_ { context_.GetFile(this) };
     size_t totalsize_ = 0;
 
+    //! memory pressure flag set by the BlockPool, spills incoming items early
+    data::MemoryPressure pressure_ { context_.block_pool() };
+
+    //! whether a vector is large enough to be spilled on memory pressure
+    static bool IsMinRun(const std::vector<ValueIn>& v) {
+        return v.size() * sizeof(ValueIn) >= data::default_block_size;
+    }
+
+    //! worker receiving an item
+    size_t Recipient(const ValueIn& v) const {
+        // parent is partitioned by key: keep items on this worker
+        if (local_) return context_.my_rank();
+        return hash_function_(key_extractor_(v)) % emitter_.size();
+    }
+
+    //! Streaming mode: merge the local sorted runs and send them, such that
+    //! each worker receives a sorted stream.
+    void SendSortedRuns() {
+        FlushVectorToFile(incoming_);
+        std::vector<ValueIn>().swap(incoming_);
+
+        {
+            std::vector<data::File::ConsumeReader> seq;
+            seq.reserve(files_.size());
+            for (size_t t = 0; t < files_.size(); ++t)
+                seq.emplace_back(files_[t].GetConsumeReader());
+
+            auto puller = core::make_multiway_merge_tree<ValueIn>(
+                seq.begin(), seq.end(), ValueComparator(*this));
+
+            while (puller.HasNext()) {
+                ValueIn v = puller.Next();
+                emitter_[Recipient(v)].Put(v);
+            }
+        }
+        files_.clear();
+    }
+
+    //! Streaming mode: merge the sorted streams from all workers on arrival
+    //! and call the GroupFunction for each complete key.
+    void PushStreaming(bool consume) {
+        if (streamed_) {
+            // replay results of the first PushData()
+            auto reader = results_.GetReader(consume);
+            while (reader.HasNext())
+                this->PushItem(reader.template Next<ValueOut>());
+            return;
+        }
+        streamed_ = true;
+
+        std::vector<data::CatStream::BlockQueueReader> readers =
+            stream_->GetReaders();
+
+        auto puller = core::make_multiway_merge_tree<ValueIn>(
+            readers.begin(), readers.end(), ValueComparator(*this));
+
+        data::File::Writer results = results_.GetWriter();
+        if (puller.HasNext()) {
+            auto user_iterator = GroupByMultiwayMergeIterator<
+                ValueIn, KeyExtractor, ValueComparator, decltype(puller)>(
+                puller, key_extractor_);
+
+            while (user_iterator.HasNextForReal()) {
+                const ValueOut res = groupby_function_(
+                    user_iterator, user_iterator.GetNextKey());
+                if (!consume) results.Put(res);
+                this->PushItem(res);
+            }
+        }
+        results.Close();
+        stream_->Close();
+    }
+
     void RunUserFunc(data::File& f, bool consume) {
         auto r = f.GetReader(consume);
         if (r.HasNext()) {
@@ -200,6 +315,48 @@ private:
         files_.emplace_back(std::move(f));
     }
 
+    //! Estimated bytes allocated by GroupVectorToFile() for n items: a hash
+    //! node and bucket per key and a chain index per item, all in the worst
+    //! case of distinct keys.
+    static size_t GroupVectorOverhead(size_t n) {
+        return n * (sizeof(Key) + 4 * sizeof(size_t) + 2 * sizeof(void*));
+    }
+
+    //! Store elements in a file, such that equal keys are consecutive. This is
+    //! done by chaining the items of each key via indexes in a hash table of
+    //! keys, which avoids sorting. The caller must check that the
+    //! GroupVectorOverhead() fits into the memory limit.
+    void GroupVectorToFile(std::vector<ValueIn>& v) {
+        totalsize_ += v.size();
+
+        // (first, last) item index of the chain of each key
+        std::unordered_map<Key, std::pair<size_t, size_t>, HashFunction>
+        chains(v.size(), hash_function_);
+        // next item index in the chain of the same key
+        mem::arena_vector<size_t> next(
+            v.size(), v.size(),
+            mem::StageArenaAllocator<size_t>(context_.stage_arena()));
+
+        for (size_t i = 0; i < v.size(); ++i) {
+            auto it = chains.emplace(
+                key_extractor_(v[i]), std::make_pair(i, i));
+            if (!it.second) {
+                next[it.first->second.second] = i;
+                it.first->second.second = i;
+            }
+        }
+
+        data::File f = context_.GetFile(this);
+        data::File::Writer w = f.GetWriter();
+        for (const auto& chain : chains) {
+            for (size_t i = chain.second.first; i < v.size(); i = next[i])
+                w.Put(v[i]);
+        }
+        w.Close();
+
+        files_.emplace_back(std::move(f));
+    }
+
     //! Receive elements from other workers.
     void MainOp() {
         LOG << "running group by main op";
@@ -210,15 +367,23 @@ private:
         // get incoming elements
         auto reader = stream_->GetCatReader(/* consume */ true);
         while (reader.HasNext()) {
-            // if vector is full save to disk
-            if (mem::memory_exceeded) {
+            // if vector is full or the BlockPool asks to spill, save to disk
+            if (mem::memory_exceeded ||
+                (pressure_.requested() && IsMinRun(incoming))) {
+                pressure_.Take();
                 FlushVectorToFile(incoming);
                 incoming.clear();
             }
             // store incoming element
             incoming.emplace_back(reader.template Next<ValueIn>());
         }
-        FlushVectorToFile(incoming);
+        // if all items and the hash table fit into RAM, group them by hashing
+        // instead of sorting, since no runs need to be merged.
+        if (files_.empty() &&
+            mem::memory_available(GroupVectorOverhead(incoming.size())))
+            GroupVectorToFile(incoming);
+        else
+            FlushVectorToFile(incoming);
         std::vector<ValueIn>().swap(incoming);
         LOG << "finished receiving elems";
         stream_->Close();
@@ -251,7 +416,8 @@ auto DIA<ValueType, Stack>::GroupByKey(
         "KeyExtractor has the wrong input type");
 
     using GroupByNode = api::GroupByNode<
-              DOpResult, DIA, KeyExtractor, GroupFunction, HashFunction>;
+              DOpResult, DIA, KeyExtractor, GroupFunction, HashFunction,
+              /* Streaming */ false>;
 
     auto node = common::MakeCounting<GroupByNode>(
         *this, key_extractor, groupby_function);
@@ -259,6 +425,81 @@ auto DIA<ValueType, Stack>::GroupByKey(
     return DIA<DOpResult>(node);
 }
 
+template <typename ValueType, typename Stack>
+template <typename ValueOut, typename KeyExtractor,
+          typename GroupFunction, typename HashFunction>
+auto DIA<ValueType, Stack>::GroupByKey(
+    struct StreamingGroupTag,
+    const KeyExtractor &key_extractor,
+    const GroupFunction &groupby_function) const {
+
+    using DOpResult = ValueOut;
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>
+                                ::template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    using GroupByNode = api::GroupByNode<
+              DOpResult, DIA, KeyExtractor, GroupFunction, HashFunction,
+              /* Streaming */ true>;
+
+    auto node = common::MakeCounting<GroupByNode>(
+        *this, key_extractor, groupby_function);
+
+    return DIA<DOpResult>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename InitFunction,
+          typename MergeFunction, typename GroupFunction,
+          typename ReduceConfig>
+auto DIA<ValueType, Stack>::GroupByKey(
+    struct CombinerTag,
+    const KeyExtractor &key_extractor,
+    const InitFunction &init_function,
+    const MergeFunction &merge_function,
+    const GroupFunction &group_function,
+    const ReduceConfig &reduce_config) const {
+    assert(IsValid());
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+    using Partial = typename common::FunctionTraits<InitFunction>::result_type;
+    using KeyPartial = std::pair<Key, Partial>;
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>
+                                ::template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<InitFunction>::template arg<0>
+            >::value,
+        "InitFunction has the wrong input type");
+
+    static_assert(
+        std::is_same<
+            typename common::FunctionTraits<MergeFunction>::result_type,
+            Partial>::value,
+        "MergeFunction has the wrong output type");
+
+    // the partial groups are folded by the tables of the ReduceNode, and the
+    // group_function is chained to its output.
+    return Map([key_extractor, init_function](const ValueType& v) {
+                   return KeyPartial(key_extractor(v), init_function(v));
+               })
+           .ReducePair(merge_function, reduce_config)
+           .Map([group_function](const KeyPartial& p) {
+                    return group_function(p.first, p.second);
+                });
+}
+
 } // namespace api
 } // namespace thrill
 
@@ -111,7 +111,7 @@ public:
     }
 
     void PushData(bool consume) final {
-        sLOG1 << "GroupToIndexNode::PushData()";
+        sLOG << "GroupToIndexNode::PushData()";
 
         const size_t num_runs = files_.size();
         if (num_runs == 0) {
@@ -178,11 +178,11 @@ private:
 
     void RunUserFunc(data::File& f, bool consume) {
         auto r = f.GetReader(consume);
+        size_t curr_index = key_range_.begin;
         if (r.HasNext()) {
             // create iterator to pass to user_function
             auto user_iterator = GroupByIterator<
                 ValueIn, KeyExtractor, ValueComparator>(r, key_extractor_);
-            size_t curr_index = key_range_.begin;
             while (user_iterator.HasNextForReal()) {
                 if (user_iterator.GetNextKey() != curr_index) {
                     // push neutral element as result to callback functions
@@ -197,11 +197,11 @@ private:
                 }
                 ++curr_index;
             }
-            while (curr_index < key_range_.end) {
-                // push neutral element as result to callback functions
-                this->PushItem(neutral_element_);
-                ++curr_index;
-            }
+        }
+        while (curr_index < key_range_.end) {
+            // push neutral element as result to callback functions
+            this->PushItem(neutral_element_);
+            ++curr_index;
         }
     }
 
@@ -209,6 +209,41 @@ private:
     void FlushVectorToFile(std::vector<ValueIn>& v) {
         // sort run and sort to file
         std::sort(v.begin(), v.end(), ValueComparator(*this));
+        WriteVectorToFile(v);
+    }
+
+    //! Sort all elements of the local key range in O(n + range) by counting
+    //! their indexes, and store them in a file.
+    void CountingSortToFile(std::vector<ValueIn>& v) {
+        // count items per index, bucket[i + 1] is the count of index i.
+        std::vector<size_t> bucket(key_range_.size() + 1, 0);
+        for (const ValueIn& e : v) {
+            const size_t k = key_extractor_(e);
+            assert(key_range_.begin <= k && k < key_range_.end);
+            ++bucket[k - key_range_.begin + 1];
+        }
+        // exclusive prefix sum: bucket[i] is the first slot of index i
+        for (size_t i = 1; i < bucket.size(); ++i)
+            bucket[i] += bucket[i - 1];
+
+        // permutation sorting v stably by index
+        std::vector<size_t> order(v.size());
+        for (size_t j = 0; j < v.size(); ++j)
+            order[bucket[key_extractor_(v[j]) - key_range_.begin]++] = j;
+        std::vector<size_t>().swap(bucket);
+
+        std::vector<ValueIn> sorted;
+        sorted.reserve(v.size());
+        for (const size_t& j : order)
+            sorted.emplace_back(std::move(v[j]));
+        std::vector<size_t>().swap(order);
+
+        v.swap(sorted);
+        WriteVectorToFile(v);
+    }
+
+    //! Store sorted elements in a file
+    void WriteVectorToFile(std::vector<ValueIn>& v) {
         totalsize_ += v.size();
 
         data::File f = context_.GetFile(this);
@@ -238,7 +273,15 @@ private:
             // store incoming element
             incoming.emplace_back(reader.template Next<ValueIn>());
         }
-        FlushVectorToFile(incoming);
+        if (files_.empty()) {
+            // all elements are in memory: bucket them by their dense index
+            // instead of comparison sorting. Spilled runs are sorted and
+            // merged.
+            CountingSortToFile(incoming);
+        }
+        else {
+            FlushVectorToFile(incoming);
+        }
         std::vector<ValueIn>().swap(incoming);
 
         stream_->Close();
@@ -0,0 +1,594 @@
+/*******************************************************************************
+ * thrill/api/inner_join.hpp
+ *
+ * DIANode for a hash join operation. Performs the actual join operation.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_INNER_JOIN_HEADER
+#define THRILL_API_INNER_JOIN_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/bloom_filter.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/hash.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Configuration class to define operational parameters of the InnerJoinNode.
+ */
+class DefaultInnerJoinConfig
+{
+public:
+    //! before shuffling, build a Bloom filter of the keys of the input with
+    //! fewer items, unite it over all workers, and drop the items of the other
+    //! input whose keys are not contained. This pays off if most keys of the
+    //! larger input have no partner. The filter is only used if its AllReduce
+    //! costs less traffic than shuffling the larger input.
+    bool semi_join_filter_ = false;
+
+    //! number of filter bits per item of the smaller input, the false positive
+    //! rate is about 2% for 8 bits.
+    size_t filter_bits_per_item_ = 8;
+
+    //! maximum recursion depth of the grace hash join: partitions whose build
+    //! side still exceeds the memory limit are split again, using different
+    //! hash bits, at most this many times. This bounds the work spent on
+    //! partitions dominated by a single key, which no split can shrink.
+    size_t max_partition_levels_ = 8;
+};
+
+/*!
+ * A DIANode which performs an inner hash join of two DIAs. Items of both inputs
+ * are first stored in local data::Files. In Execute, the total sizes of both
+ * inputs are known, and the items are exchanged in one of two ways:
+ *
+ * - If sending the smaller input to all workers costs less traffic than
+ *   shuffling both inputs, and it fits into RAM, the smaller input is broadcast
+ *   to all workers and the larger input remains local (broadcast join).
+ *
+ * - Otherwise both inputs are hash partitioned by their key over one CatStream
+ *   each, and stored in Files on the receiving worker. Optionally, items of
+ *   the input with more items whose keys are not in a Bloom filter of the
+ *   other input's keys are dropped before sending (semi-join filter).
+ *
+ * During PushData, the smaller of the two local Files is loaded into a hash
+ * table (the build side), and the other File is streamed against it (the probe
+ * side), calling the JoinFunction for each matching pair.
+ *
+ * If the estimated hash table of the build side does not fit into the memory
+ * limit, both Files are split by the key hash into partitions, which are
+ * joined pairwise (grace hash join). Partitions which are still too large are
+ * split again recursively. The partitions are Files and may be evicted to disk
+ * by the BlockPool.
+ *
+ * \tparam ValueType Output type of the join, the result of the JoinFunction.
+ *
+ * \tparam FirstDIA Type of the first input DIA.
+ *
+ * \tparam SecondDIA Type of the second input DIA.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename HashFunction,
+          typename JoinConfig = DefaultInnerJoinConfig>
+class InnerJoinNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using InputTypeFirst = typename FirstDIA::ValueType;
+    using InputTypeSecond = typename SecondDIA::ValueType;
+
+    using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
+
+public:
+    /*!
+     * Constructor for an InnerJoinNode. Sets the parents, the key extractors
+     * and the join function.
+     */
+    InnerJoinNode(const FirstDIA& parent1, const SecondDIA& parent2,
+                  const KeyExtractor1& key_extractor1,
+                  const KeyExtractor2& key_extractor2,
+                  const JoinFunction& join_function,
+                  const HashFunction& hash_function,
+                  const JoinConfig& join_config = JoinConfig())
+        : Super(parent1.ctx(), "InnerJoin",
+                { parent1.id(), parent2.id() },
+                { parent1.node(), parent2.node() }),
+          key_extractor1_(key_extractor1),
+          key_extractor2_(key_extractor2),
+          join_function_(join_function),
+          hash_function_(hash_function),
+          config_(join_config)
+    {
+        files1_.emplace_back(context_.GetFile(this));
+        files2_.emplace_back(context_.GetFile(this));
+
+        auto pre_op1_fn = [this](const InputTypeFirst& input) {
+                              writer1_.Put(input);
+                          };
+        auto pre_op2_fn = [this](const InputTypeSecond& input) {
+                              writer2_.Put(input);
+                          };
+
+        // close the function stacks with our pre ops and register it at
+        // parent nodes for output
+        auto lop_chain1 = parent1.stack().push(pre_op1_fn).fold();
+        auto lop_chain2 = parent2.stack().push(pre_op2_fn).fold();
+        parent1.node()->AddChild(this, lop_chain1, 0);
+        parent2.node()->AddChild(this, lop_chain2, 1);
+    }
+
+    void StartPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            writer1_ = files1_[0].GetWriter();
+        else
+            writer2_ = files2_[0].GetWriter();
+    }
+
+    //! Receive a whole data::File of ValueType, but only if our stack is empty.
+    bool OnPreOpFile(const data::File& file, size_t parent_index) final {
+        if (parent_index == 0) {
+            if (!FirstDIA::stack_empty) return false;
+            files1_[0] = file.Copy();
+        }
+        else {
+            if (!SecondDIA::stack_empty) return false;
+            files2_[0] = file.Copy();
+        }
+        return true;
+    }
+
+    void StopPreOp(size_t parent_index) final {
+        LOG << *this << " StopPreOp() parent_index=" << parent_index;
+        if (parent_index == 0)
+            writer1_.Close();
+        else
+            writer2_.Close();
+    }
+
+    void Execute() final {
+        using ArraySizeT = std::array<size_t, 4>;
+
+        // calculate total size and number of items of both inputs
+        ArraySizeT total = context_.net.AllReduce(
+            ArraySizeT {
+                { files1_[0].size_bytes(), files2_[0].size_bytes(),
+                  files1_[0].num_items(), files2_[0].num_items() }
+            },
+            common::ComponentSum<ArraySizeT>());
+
+        // broadcast the smaller input if sending it to all other workers
+        // costs less than shuffling both, and each worker can hold it in RAM.
+        const size_t num_workers = context_.num_workers();
+        const size_t small = total[0] <= total[1] ? 0 : 1;
+        const bool broadcast =
+            num_workers > 1 &&
+            total[small] * (num_workers - 1) < total[1 - small] &&
+            4 * total[small] < context_.mem_limit();
+
+        if (context_.my_rank() == 0) {
+            sLOG << "InnerJoin: input sizes" << total[0] << total[1]
+                 << (broadcast ? "broadcast input" : "shuffle")
+                 << (broadcast ? small : 0);
+        }
+
+        // filter the input with more items by the keys of the other one.
+        const size_t filtered = total[2] <= total[3] ? 1 : 0;
+        std::unique_ptr<common::BloomFilter> filter;
+        if (!broadcast && config_.semi_join_filter_) {
+            if (filtered == 1) {
+                filter = BuildFilter<InputTypeFirst>(
+                    files1_[0], key_extractor1_, total[2], total[1]);
+            }
+            else {
+                filter = BuildFilter<InputTypeSecond>(
+                    files2_[0], key_extractor2_, total[3], total[0]);
+            }
+        }
+
+        Exchange<InputTypeFirst>(
+            files1_, key_extractor1_,
+            !broadcast ? Shuffle : small == 0 ? Broadcast : Keep,
+            filtered == 0 ? filter.get() : nullptr);
+        Exchange<InputTypeSecond>(
+            files2_, key_extractor2_,
+            !broadcast ? Shuffle : small == 1 ? Broadcast : Keep,
+            filtered == 1 ? filter.get() : nullptr);
+    }
+
+    DIAMemUse PushDataMemUse() final {
+        // the hash table is built on the smaller side
+        return DIAMemUse::Max(
+            std::min(TableBytes<InputTypeFirst>(files1_),
+                     TableBytes<InputTypeSecond>(files2_)));
+    }
+
+    void PushData(bool consume) final {
+        if (!partitioned_) {
+            Partition();
+            partitioned_ = true;
+        }
+
+        for (size_t p = 0; p < files1_.size(); ++p) {
+            if (files1_[p].size_bytes() <= files2_[p].size_bytes()) {
+                BuildAndProbe<InputTypeFirst, InputTypeSecond>(
+                    files1_[p], files2_[p], key_extractor1_, key_extractor2_,
+                    consume,
+                    [this](const InputTypeFirst& a, const InputTypeSecond& b) {
+                        this->PushItem(join_function_(a, b));
+                    });
+            }
+            else {
+                BuildAndProbe<InputTypeSecond, InputTypeFirst>(
+                    files2_[p], files1_[p], key_extractor2_, key_extractor1_,
+                    consume,
+                    [this](const InputTypeSecond& b, const InputTypeFirst& a) {
+                        this->PushItem(join_function_(a, b));
+                    });
+            }
+        }
+    }
+
+    void Dispose() final {
+        files1_.clear();
+        files2_.clear();
+    }
+
+private:
+    KeyExtractor1 key_extractor1_;
+    KeyExtractor2 key_extractor2_;
+    JoinFunction join_function_;
+    HashFunction hash_function_;
+    JoinConfig config_;
+
+    //! writers of the local PreOp Files
+    data::File::Writer writer1_;
+    data::File::Writer writer2_;
+
+    //! items of both inputs: first the local items from the PreOp, then the
+    //! received items, which may be split into grace hash partitions.
+    std::vector<data::File> files1_;
+    std::vector<data::File> files2_;
+
+    //! whether the Files were split into partitions fitting into RAM
+    bool partitioned_ = false;
+
+    //! worker receiving items with the given key
+    size_t Recipient(const Key& k) const {
+        return hash_function_(k) % context_.num_workers();
+    }
+
+    //! grace hash partition of a key on the given recursion level, using the
+    //! hash bits not used by Recipient() on the first level, and a rehash of
+    //! the key's hash on deeper levels.
+    size_t LocalPartition(const Key& k, size_t num_partitions,
+                          size_t level) const {
+        size_t h = hash_function_(k) / context_.num_workers();
+        if (level != 0)
+            h = static_cast<size_t>(
+                common::HashCombine(h, common::HashInteger(level)));
+        return h % num_partitions;
+    }
+
+    //! estimate of the RAM needed for a hash table containing the File's items
+    template <typename Type>
+    static size_t TableBytes(const data::File& file) {
+        return 2 * file.size_bytes() +
+               file.num_items() * (sizeof(std::pair<Key, Type>) +
+                                   4 * sizeof(void*));
+    }
+
+    //! estimate of the RAM needed for a hash table containing the Files' items
+    template <typename Type>
+    static size_t TableBytes(const std::vector<data::File>& files) {
+        size_t bytes = 0;
+        for (const data::File& file : files)
+            bytes += TableBytes<Type>(file);
+        return bytes;
+    }
+
+    //! method of exchanging the local items of one input in Execute().
+    enum ExchangeMode { Shuffle, Broadcast, Keep };
+
+    /*!
+     * Build a Bloom filter of the keys of all items of the build input, which
+     * has total_items items globally, or return nullptr if uniting the filter
+     * over all workers would cost more traffic than shuffling the other input
+     * of probe_bytes bytes. The decision is the same on all workers.
+     */
+    template <typename Type, typename KeyExtractor>
+    std::unique_ptr<common::BloomFilter> BuildFilter(
+        const data::File& file, const KeyExtractor& key_extractor,
+        size_t total_items, size_t probe_bytes) {
+
+        std::unique_ptr<common::BloomFilter> filter =
+            std::make_unique<common::BloomFilter>(
+                common::BloomFilter::ForItems(
+                    total_items, config_.filter_bits_per_item_));
+
+        // each worker sends and receives the filter about once per round of
+        // the AllReduce, and saves at most its share of the shuffle.
+        const size_t num_workers = context_.num_workers();
+        const size_t rounds =
+            std::max<size_t>(1, 2 * common::IntegerLog2Ceil(num_workers));
+        if (filter->size_bytes() * rounds >= probe_bytes / num_workers ||
+            4 * filter->size_bytes() >= context_.mem_limit())
+            return nullptr;
+
+        auto reader = file.GetKeepReader();
+        while (reader.HasNext()) {
+            filter->Insert(
+                hash_function_(key_extractor(reader.template Next<Type>())));
+        }
+
+        filter->words() = context_.net.AllReduce(
+            filter->words(),
+            [](std::vector<uint64_t> a, const std::vector<uint64_t>& b) {
+                common::BloomFilter::MergeWords(&a, b);
+                return a;
+            });
+
+        return filter;
+    }
+
+    //! send the local items to the workers according to mode, and replace
+    //! them with the received items. When shuffling, items whose keys are not
+    //! in the filter are dropped.
+    template <typename Type, typename KeyExtractor>
+    void Exchange(std::vector<data::File>& files,
+                  const KeyExtractor& key_extractor, ExchangeMode mode,
+                  const common::BloomFilter* filter = nullptr) {
+        if (mode == Keep) return;
+
+        data::CatStreamPtr stream = context_.GetNewCatStream(this);
+        std::vector<data::Stream::Writer> writers = stream->GetWriters();
+
+        if (mode == Broadcast) {
+            // send all Blocks of the File to all workers
+            for (data::Stream::Writer& w : writers) {
+                w.AppendBlocks(files[0].blocks());
+                w.Close();
+            }
+        }
+        else {
+            size_t dropped = 0;
+            auto reader = files[0].GetConsumeReader();
+            while (reader.HasNext()) {
+                Type item = reader.template Next<Type>();
+                const Key key = key_extractor(item);
+                if (filter && !filter->Contains(hash_function_(key))) {
+                    ++dropped;
+                    continue;
+                }
+                writers[Recipient(key)].Put(item);
+            }
+            for (data::Stream::Writer& w : writers) w.Close();
+
+            if (filter) {
+                sLOG << "InnerJoin: semi-join filter dropped" << dropped
+                     << "items";
+            }
+        }
+
+        files.clear();
+        files.emplace_back(context_.GetFile(this));
+        data::File::Writer writer = files[0].GetWriter();
+
+        auto reader = stream->GetCatReader(/* consume */ true);
+        while (reader.HasNext()) {
+            writer.Put(reader.template Next<Type>());
+        }
+        writer.Close();
+        stream->Close();
+    }
+
+    //! split both Files into partitions, such that the smaller side of each
+    //! partition fits into RAM.
+    void Partition() {
+        if (files1_.size() != 1) return;
+
+        std::vector<data::File> parts1, parts2;
+        SplitPartition(files1_[0], files2_[0], 0, parts1, parts2);
+        files1_ = std::move(parts1);
+        files2_ = std::move(parts2);
+    }
+
+    //! split the pair of Files by key hash if the smaller side exceeds the
+    //! memory limit, recursing into partitions which are still too large, and
+    //! append the resulting pairs to parts1 and parts2. The fan-out is limited
+    //! by the number of Blocks the partition Writers may pin.
+    void SplitPartition(data::File& file1, data::File& file2, size_t level,
+                        std::vector<data::File>& parts1,
+                        std::vector<data::File>& parts2) {
+        size_t build_bytes = std::min(
+            TableBytes<InputTypeFirst>(file1),
+            TableBytes<InputTypeSecond>(file2));
+
+        size_t mem_limit = std::max<size_t>(DIABase::mem_limit_, 1);
+        size_t num_partitions = (build_bytes + mem_limit - 1) / mem_limit;
+        // one Block per partition Writer, and the Reader's Blocks
+        const size_t reader_blocks = 1 + data::File::default_prefetch;
+        num_partitions = std::min(
+            num_partitions,
+            std::max<size_t>(
+                reader_blocks + 2,
+                DIABase::mem_limit_ / data::default_block_size)
+            - reader_blocks);
+        if (num_partitions <= 1 || level >= config_.max_partition_levels_) {
+            parts1.emplace_back(std::move(file1));
+            parts2.emplace_back(std::move(file2));
+            return;
+        }
+
+        sLOG << "InnerJoin: build side of" << build_bytes
+             << "bytes exceeds the memory limit of" << DIABase::mem_limit_
+             << "bytes, splitting into" << num_partitions
+             << "partitions on level" << level;
+
+        std::vector<data::File> sub1 = SplitFile<InputTypeFirst>(
+            file1, key_extractor1_, num_partitions, level);
+        std::vector<data::File> sub2 = SplitFile<InputTypeSecond>(
+            file2, key_extractor2_, num_partitions, level);
+
+        for (size_t p = 0; p < num_partitions; ++p)
+            SplitPartition(sub1[p], sub2[p], level + 1, parts1, parts2);
+    }
+
+    //! split a File into num_partitions Files by key hash on the given
+    //! recursion level, consuming it.
+    template <typename Type, typename KeyExtractor>
+    std::vector<data::File> SplitFile(
+        data::File& file, const KeyExtractor& key_extractor,
+        size_t num_partitions, size_t level) {
+
+        std::vector<data::File> parts;
+        std::vector<data::File::Writer> writers;
+        for (size_t p = 0; p < num_partitions; ++p)
+            parts.emplace_back(context_.GetFile(this));
+        for (size_t p = 0; p < num_partitions; ++p)
+            writers.emplace_back(parts[p].GetWriter());
+
+        auto reader = file.GetConsumeReader();
+        while (reader.HasNext()) {
+            Type item = reader.template Next<Type>();
+            writers[LocalPartition(key_extractor(item), num_partitions, level)]
+                .Put(item);
+        }
+        for (data::File::Writer& w : writers) w.Close();
+
+        return parts;
+    }
+
+    //! load the build File into a hash table, and emit all matching pairs of
+    //! items in the probe File.
+    template <typename BuildType, typename ProbeType,
+              typename BuildKeyExtractor, typename ProbeKeyExtractor,
+              typename EmitFunction>
+    void BuildAndProbe(data::File& build, data::File& probe,
+                       const BuildKeyExtractor& build_key_extractor,
+                       const ProbeKeyExtractor& probe_key_extractor,
+                       bool consume, const EmitFunction& emit) {
+        if (build.num_items() == 0 || probe.num_items() == 0) {
+            if (consume) {
+                build.Clear();
+                probe.Clear();
+            }
+            return;
+        }
+
+        std::unordered_multimap<Key, BuildType, HashFunction> table(
+            build.num_items(), hash_function_);
+        {
+            auto reader = build.GetReader(consume);
+            while (reader.HasNext()) {
+                BuildType item = reader.template Next<BuildType>();
+                Key key = build_key_extractor(item);
+                table.emplace(std::move(key), std::move(item));
+            }
+        }
+
+        auto reader = probe.GetReader(consume);
+        while (reader.HasNext()) {
+            ProbeType item = reader.template Next<ProbeType>();
+            auto range = table.equal_range(probe_key_extractor(item));
+            for (auto it = range.first; it != range.second; ++it)
+                emit(it->second, item);
+        }
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename SecondDIA, typename HashFunction,
+          typename JoinConfig>
+auto DIA<ValueType, Stack>::InnerJoin(
+    const SecondDIA &second_dia,
+    const KeyExtractor1 &key_extractor1,
+    const KeyExtractor2 &key_extractor2,
+    const JoinFunction &join_function,
+    const HashFunction &hash_function,
+    const JoinConfig &join_config) const {
+    assert(IsValid());
+    assert(second_dia.IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<KeyExtractor1>::template arg<0>
+            >::value,
+        "KeyExtractor1 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<KeyExtractor2>::template arg<0>
+            >::value,
+        "KeyExtractor2 has the wrong input type");
+
+    static_assert(
+        std::is_same<
+            typename common::FunctionTraits<KeyExtractor1>::result_type,
+            typename common::FunctionTraits<KeyExtractor2>::result_type
+            >::value,
+        "Keys have the wrong type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<JoinFunction>::template arg<0>
+            >::value,
+        "JoinFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<JoinFunction>::template arg<1>
+            >::value,
+        "JoinFunction has the wrong input type");
+
+    using JoinResult
+              = typename common::FunctionTraits<JoinFunction>::result_type;
+
+    using InnerJoinNode = api::InnerJoinNode<
+              JoinResult, DIA, SecondDIA,
+              KeyExtractor1, KeyExtractor2, JoinFunction, HashFunction,
+              JoinConfig>;
+
+    auto node = common::MakeCounting<InnerJoinNode>(
+        *this, second_dia, key_extractor1, key_extractor2, join_function,
+        hash_function, join_config);
+
+    return DIA<JoinResult>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_INNER_JOIN_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * thrill/api/iterate.hpp
+ *
+ * Iterate runs a loop body on a state DIA and materializes the new state after
+ * each iteration. DeltaIterate keeps a solution set of (key, value) pairs and
+ * only processes the changed pairs in each iteration.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_ITERATE_HEADER
+#define THRILL_API_ITERATE_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/cache.hpp>
+#include <thrill/api/collapse.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Iterate applies `body_function` iterations times to a state DIA, and returns
+ * the final state. The DIA returned by the body is cached and executed at the
+ * end of each iteration. This cuts the DIA graph, hence each iteration only
+ * runs the stages of its own body instead of growing one graph over all
+ * iterations, and the previous state's data is released as soon as the next
+ * state is complete.
+ *
+ * Loop-invariant inputs, which the body references, should be Cache()d before
+ * the loop, such that they are not recomputed or consumed by the first
+ * iteration.
+ *
+ * \param state Initial state DIA.
+ *
+ * \param iterations Number of iterations.
+ *
+ * \param body_function Function `(const DIA<ValueType>& state, size_t
+ * iteration)`, which returns a DIA of the next state with the same ValueType.
+ *
+ * \ingroup dia_dops
+ */
+template <typename ValueType, typename Stack, typename BodyFunction>
+DIA<ValueType> Iterate(const DIA<ValueType, Stack>& state, size_t iterations,
+                       const BodyFunction& body_function) {
+    assert(state.IsValid());
+
+    DIA<ValueType> current = state.Collapse();
+
+    for (size_t iter = 0; iter < iterations; ++iter) {
+        DIA<ValueType> next = body_function(current, iter).Cache();
+        next.Execute();
+        // drops the last reference to the previous state
+        current = std::move(next);
+    }
+
+    return current;
+}
+
+/*!
+ * Action which merges the reduced candidate (key, value) pairs of a
+ * DeltaIterate iteration into the local solution set, and collects the pairs
+ * whose value changed, without any communication.
+ *
+ * \ingroup api_layer
+ */
+template <typename ParentDIA, typename Table, typename ReduceFunction>
+class DeltaIterateMergeNode final : public ActionNode
+{
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+public:
+    DeltaIterateMergeNode(const ParentDIA& parent, Table& solution,
+                          const ReduceFunction& reduce_function,
+                          std::vector<ValueType>& changed)
+        : ActionNode(parent.ctx(), "DeltaIterateMerge",
+                     { parent.id() }, { parent.node() }),
+          solution_(solution), reduce_function_(reduce_function),
+          changed_(changed)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             auto it = solution_.find(input.first);
+                             if (it == solution_.end()) {
+                                 solution_.emplace(input.first, input.second);
+                                 changed_.emplace_back(input);
+                                 return;
+                             }
+                             auto value = reduce_function_(
+                                 it->second, input.second);
+                             if (value == it->second) return;
+                             it->second = std::move(value);
+                             changed_.emplace_back(it->first, it->second);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void Execute() final { }
+
+private:
+    //! solution set of the DeltaIterate
+    Table& solution_;
+    //! reduce function of the candidates
+    ReduceFunction reduce_function_;
+    //! output list of changed pairs
+    std::vector<ValueType>& changed_;
+};
+
+/*!
+ * DeltaIterate runs an incremental fixpoint iteration on a solution set of
+ * (key, value) pairs, as in the delta iterations of Stratosphere. Each
+ * iteration calls `step_function` only on the workset DIA of pairs which
+ * changed in the previous iteration. It returns candidate pairs, which are
+ * combined with `reduce_function` and merged into the solution set. The pairs
+ * whose value changes form the next workset, and the iteration stops when the
+ * workset is empty or after max_iterations.
+ *
+ * The solution set is a hash table on each worker. The candidates are reduced
+ * with ReducePair(), whose hash partitioning depends only on the key and the
+ * number of workers, hence each key always arrives at the worker holding its
+ * solution entry, and only the candidates are shuffled. Algorithms in which
+ * most values converge early, like connected components, then process only
+ * few items in the later iterations.
+ *
+ * \param initial DIA of the initial solution pairs, which is also the first
+ * workset.
+ *
+ * \param max_iterations Maximum number of iterations.
+ *
+ * \param step_function Function `(const DIA<std::pair<Key, Value> >& workset,
+ * size_t iteration)`, which returns a DIA of candidate pairs of the same type.
+ *
+ * \param reduce_function Function `Value (const Value&, const Value&)`, which
+ * must be associative and commutative, and merges a candidate into the
+ * solution value. A pair changes if the merged value differs from the old one.
+ *
+ * \ingroup dia_dops
+ */
+template <typename Key, typename Value, typename Stack,
+          typename StepFunction, typename ReduceFunction>
+DIA<std::pair<Key, Value> > DeltaIterate(
+    const DIA<std::pair<Key, Value>, Stack>& initial, size_t max_iterations,
+    const StepFunction& step_function, const ReduceFunction& reduce_function) {
+    assert(initial.IsValid());
+
+    static constexpr bool debug = false;
+
+    using Pair = std::pair<Key, Value>;
+    using Table = std::unordered_map<Key, Value>;
+
+    Context& ctx = initial.ctx();
+    Table solution;
+
+    // reduce candidates and merge them into the solution set, returns the
+    // global number of changed pairs.
+    std::vector<Pair> changed;
+    auto merge =
+        [&](const auto& candidates) {
+            auto reduced = candidates.ReducePair(reduce_function);
+            using MergeNode = api::DeltaIterateMergeNode<
+                      decltype(reduced), Table, ReduceFunction>;
+            auto node = common::MakeCounting<MergeNode>(
+                reduced, solution, reduce_function, changed);
+            node->RunScope();
+            return ctx.net.AllReduce(changed.size());
+        };
+
+    size_t num_changed = merge(initial);
+
+    for (size_t iter = 0; iter < max_iterations && num_changed != 0; ++iter) {
+        DIA<Pair> workset = ConcatToDIA(ctx, std::move(changed));
+        changed = std::vector<Pair>();
+
+        num_changed = merge(step_function(workset, iter));
+
+        LOG << "DeltaIterate: iteration " << iter << " changed " << num_changed
+            << " local solution " << solution.size();
+    }
+
+    std::vector<Pair> items(solution.begin(), solution.end());
+    return ConcatToDIA(ctx, std::move(items));
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::Iterate;
+using api::DeltaIterate;
+
+} // namespace thrill
+
+#endif // !THRILL_API_ITERATE_HEADER
+
+/******************************************************************************/
@@ -25,11 +25,11 @@
 #include <thrill/core/multiway_merge.hpp>
 #include <thrill/data/dyn_block_reader.hpp>
 #include <thrill/data/file.hpp>
+#include <thrill/data/file_index.hpp>
 
 #include <algorithm>
 #include <array>
 #include <functional>
-#include <random>
 #include <string>
 #include <vector>
 
@@ -42,8 +42,10 @@ namespace api {
  * finishes.
  *
  * The algorithm performs a distributed multi-sequence selection by picking
- * random pivots (from the largest remaining interval) for each DIA. The pivots
- * are selected via a global AllReduce. There is one pivot per DIA.
+ * kNumPivots pivots at equidistant positions of the largest remaining interval
+ * for each splitter. The pivots of all splitters are selected via one global
+ * AllReduce per round, and their ranks via another one, such that each round
+ * shrinks the largest interval by a factor of kNumPivots + 1.
  *
  * Then the pivots are searched for in the interval [left,left + width) in each
  * local File's partition, where these are initialized with left = 0 and width =
@@ -83,6 +85,9 @@ class MergeNode : public DOpNode<ValueType>
 
     static constexpr size_t kNumInputs = 1 + sizeof ... (ParentDIAs);
 
+    //! Number of pivots per splitter selected and ranked in each search round.
+    static constexpr size_t kNumPivots = 8;
+
     static_assert(kNumInputs >= 2, "Merge requires at least two inputs.");
 
 public:
@@ -183,6 +188,7 @@ public:
 
         stats_.result_size_ = result_count;
         stats_.Print(context_);
+        stats_.Log(Super::logger_);
     }
 
     void Dispose() final { }
@@ -191,12 +197,12 @@ private:
     //! Merge comparator
     Comparator comparator_;
 
-    //! Random generator for pivot selection.
-    std::default_random_engine rng_ { std::random_device { } () };
-
     //! Files for intermediate storage
     data::FilePtr files_[kNumInputs];
 
+    //! Sparse indexes of the Blocks of files_ for pivot rank queries
+    data::FileIndex<ValueType> indexes_[kNumInputs];
+
     //! Writers to intermediate files
     data::File::Writer writers_[kNumInputs];
 
@@ -340,14 +346,33 @@ private:
                 }
             }
         }
+
+        //! Output the local timers and counters as a JSON event. The timers
+        //! are only measured if stats_enabled is set.
+        void Log(common::JsonLogger& logger) {
+            logger << "class" << "MergeNode"
+                   << "event" << "stats"
+                   << "merge_time" << merge_timer_.Microseconds()
+                   << "balancing_time" << balancing_timer_.Microseconds()
+                   << "pivot_selection_time"
+                   << pivot_selection_timer_.Microseconds()
+                   << "search_step_time" << search_step_timer_.Microseconds()
+                   << "file_op_time" << file_op_timer_.Microseconds()
+                   << "comm_time" << comm_timer_.Microseconds()
+                   << "scatter_time" << scatter_timer_.Microseconds()
+                   << "result_size" << result_size_
+                   << "iterations" << iterations_
+                   << "pivots_per_splitter" << size_t(kNumPivots);
+        }
     };
 
     //! Instance of merge statistics
     Stats stats_;
 
     /*!
-     * Selects random global pivots for all splitter searches based on all
-     * worker's search ranges.
+     * Selects kNumPivots global pivots for each splitter search based on all
+     * worker's search ranges. The pivots of splitter s are stored at
+     * out_pivots[s * kNumPivots + j].
      *
      * \param left The left bounds of all search ranges for all files.  The
      * first index identifies the splitter, the second index identifies the
@@ -363,8 +388,8 @@ private:
         const std::vector<ArrayNumInputsSizeT>& width,
         std::vector<Pivot>& out_pivots) {
 
-        // Select a random pivot for the largest range we have for each
-        // splitter.
+        // Select kNumPivots equidistant pivots from the largest range we have
+        // for each splitter.
         for (size_t s = 0; s < width.size(); s++) {
             size_t mp = 0;
 
@@ -375,25 +400,29 @@ private:
                 }
             }
 
-            // We can leave pivot_elem uninitialized.  If it is not initialized
-            // below, then an other worker's pivot will be taken for this range,
-            // since our range is zero.
-            ValueType pivot_elem = ValueType();
-            size_t pivot_idx = left[s][mp];
+            for (size_t j = 0; j < kNumPivots; j++) {
+                // We can leave pivot_elem uninitialized.  If it is not
+                // initialized below, then an other worker's pivot will be taken
+                // for this range, since our range is zero.
+                ValueType pivot_elem = ValueType();
+                size_t pivot_idx = left[s][mp];
+
+                if (width[s][mp] > 0) {
+                    pivot_idx = left[s][mp]
+                                + (j + 1) * width[s][mp] / (kNumPivots + 1);
+                    assert(pivot_idx < files_[mp]->num_items());
+                    stats_.file_op_timer_.Start();
+                    pivot_elem =
+                        files_[mp]->template GetItemAt<ValueType>(pivot_idx);
+                    stats_.file_op_timer_.Stop();
+                }
 
-            if (width[s][mp] > 0) {
-                pivot_idx = left[s][mp] + (rng_() % width[s][mp]);
-                assert(pivot_idx < files_[mp]->num_items());
-                stats_.file_op_timer_.Start();
-                pivot_elem = files_[mp]->template GetItemAt<ValueType>(pivot_idx);
-                stats_.file_op_timer_.Stop();
+                out_pivots[s * kNumPivots + j] = Pivot {
+                    pivot_elem,
+                    pivot_idx,
+                    width[s][mp]
+                };
             }
-
-            out_pivots[s] = Pivot {
-                pivot_elem,
-                pivot_idx,
-                width[s][mp]
-            };
         }
 
         LOG << "local pivots: " << VToStr(out_pivots);
@@ -407,8 +436,9 @@ private:
     }
 
     /*!
-     * Calculates the global ranks of the given pivots.
-     * Additionally returns the local ranks so we can use them in the next step.
+     * Calculates the global ranks of the given pivots of all splitters with one
+     * AllReduce.  Additionally returns the local ranks so we can use them in
+     * the next step.
      */
     void GetGlobalRanks(
         const std::vector<Pivot>& pivots,
@@ -419,22 +449,23 @@ private:
 
         // Simply get the rank of each pivot in each file. Sum the ranks up
         // locally.
-        for (size_t s = 0; s < pivots.size(); s++) {
+        for (size_t k = 0; k < pivots.size(); k++) {
+            size_t s = k / kNumPivots;
             size_t rank = 0;
             for (size_t i = 0; i < kNumInputs; i++) {
                 stats_.file_op_timer_.Start();
 
-                size_t idx = files_[i]->GetIndexOf(
-                    pivots[s].value, pivots[s].tie_idx,
+                size_t idx = indexes_[i].GetIndexOf(
+                    *files_[i], pivots[k].value, pivots[k].tie_idx,
                     left[s][i], left[s][i] + width[s][i],
                     comparator_);
 
                 stats_.file_op_timer_.Stop();
 
                 rank += idx;
-                out_local_ranks[s][i] = idx;
+                out_local_ranks[k][i] = idx;
             }
-            global_ranks[s] = rank;
+            global_ranks[k] = rank;
         }
 
         stats_.comm_timer_.Start();
@@ -445,7 +476,11 @@ private:
     }
 
     /*!
-     * Shrinks the search ranges according to the global ranks of the pivots.
+     * Shrinks the search ranges according to the global ranks of the pivots:
+     * the new range of each splitter is bounded by its largest pivot below and
+     * smallest pivot not below the target rank. The global and local ranks of
+     * the pivot closest to the target are stored into best_global_ranks and
+     * best_local_ranks.
      *
      * \param global_ranks The global ranks of all pivots.
      *
@@ -467,26 +502,44 @@ private:
         const std::vector<ArrayNumInputsSizeT>& local_ranks,
         const std::vector<size_t>& target_ranks,
         std::vector<ArrayNumInputsSizeT>& left,
-        std::vector<ArrayNumInputsSizeT>& width) {
+        std::vector<ArrayNumInputsSizeT>& width,
+        std::vector<size_t>& best_global_ranks,
+        std::vector<ArrayNumInputsSizeT>& best_local_ranks) {
 
         for (size_t s = 0; s < width.size(); s++) {
+
+            // remember the pivot closest to the target rank
+            size_t best = s * kNumPivots;
+            for (size_t k = best + 1; k < (s + 1) * kNumPivots; k++) {
+                if (common::abs_diff(global_ranks[k], target_ranks[s]) <
+                    common::abs_diff(global_ranks[best], target_ranks[s]))
+                    best = k;
+            }
+            best_global_ranks[s] = global_ranks[best];
+            best_local_ranks[s] = local_ranks[best];
+
             for (size_t p = 0; p < width[s].size(); p++) {
 
                 if (width[s][p] == 0)
                     continue;
 
-                size_t local_rank = local_ranks[s][p];
+                size_t lo = left[s][p], hi = left[s][p] + width[s][p];
                 size_t old_width = width[s][p];
-                assert(left[s][p] <= local_rank);
 
-                if (global_ranks[s] < target_ranks[s]) {
-                    width[s][p] -= local_rank - left[s][p];
-                    left[s][p] = local_rank;
-                }
-                else if (global_ranks[s] >= target_ranks[s]) {
-                    width[s][p] = local_rank - left[s][p];
+                for (size_t k = s * kNumPivots; k < (s + 1) * kNumPivots; k++) {
+                    size_t local_rank = local_ranks[k][p];
+                    assert(left[s][p] <= local_rank);
+
+                    if (global_ranks[k] < target_ranks[s])
+                        lo = std::max(lo, local_rank);
+                    else
+                        hi = std::min(hi, local_rank);
                 }
 
+                assert(lo <= hi);
+                left[s][p] = lo;
+                width[s][p] = hi - lo;
+
                 if (debug) {
                     die_unless(width[s][p] <= old_width);
                 }
@@ -558,14 +611,18 @@ private:
         }
 
         // buffer for the global ranks of selected pivots
-        std::vector<size_t> global_ranks(p - 1);
+        std::vector<size_t> global_ranks((p - 1) * kNumPivots);
+
+        // the global and local ranks of the best pivot of each splitter
+        std::vector<size_t> best_global_ranks(p - 1);
+        std::vector<ArrayNumInputsSizeT> best_local_ranks(p - 1);
 
         // Search range bounds.
         std::vector<ArrayNumInputsSizeT> left(p - 1), width(p - 1);
 
         // Auxillary arrays.
-        std::vector<Pivot> pivots(p - 1);
-        std::vector<ArrayNumInputsSizeT> local_ranks(p - 1);
+        std::vector<Pivot> pivots((p - 1) * kNumPivots);
+        std::vector<ArrayNumInputsSizeT> local_ranks((p - 1) * kNumPivots);
 
         // Initialize all lefts with 0 and all widths with size of their
         // respective file.
@@ -575,6 +632,13 @@ private:
             }
         }
 
+        // index the first item of each Block for the pivot rank queries.
+        stats_.file_op_timer_.Start();
+        for (size_t i = 0; i < kNumInputs; i++) {
+            indexes_[i].Build(*files_[i]);
+        }
+        stats_.file_op_timer_.Stop();
+
         bool finished = false;
         stats_.balancing_timer_.Start();
 
@@ -611,7 +675,8 @@ private:
             LOG << "global_ranks: " << common::VecToStr(global_ranks);
             LOG << "local_ranks: " << VecVecToStr(local_ranks);
 
-            SearchStep(global_ranks, local_ranks, target_ranks, left, width);
+            SearchStep(global_ranks, local_ranks, target_ranks, left, width,
+                       best_global_ranks, best_local_ranks);
 
             if (debug) {
                 for (size_t q = 0; q < kNumInputs; q++) {
@@ -627,7 +692,7 @@ private:
             // We check for accuracy of kNumInputs + 1
             finished = true;
             for (size_t i = 0; i < p - 1; i++) {
-                size_t a = global_ranks[i], b = target_ranks[i];
+                size_t a = best_global_ranks[i], b = target_ranks[i];
                 if (common::abs_diff(a, b) > kNumInputs + 1) {
                     finished = false;
                     break;
@@ -641,6 +706,10 @@ private:
 
         LOG << "Finished after " << stats_.iterations_ << " iterations";
 
+        // release the indexes, the files are consumed by scattering.
+        for (size_t i = 0; i < kNumInputs; i++)
+            indexes_[i] = data::FileIndex<ValueType>();
+
         LOG << "Creating channels";
 
         // Initialize channels for distributing data.
@@ -660,7 +729,7 @@ private:
             std::vector<size_t> offsets(p + 1, 0);
 
             for (size_t r = 0; r < p - 1; r++)
-                offsets[r + 1] = local_ranks[r][j];
+                offsets[r + 1] = best_local_ranks[r][j];
 
             offsets[p] = files_[j]->num_items();
 
@@ -0,0 +1,338 @@
+/*******************************************************************************
+ * thrill/api/metrics_server.cpp
+ *
+ * Small HTTP server exposing the latest profile values of a host in the
+ * Prometheus text format.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/metrics_server.hpp>
+
+#if THRILL_HAVE_NET_TCP
+
+#include <thrill/common/die.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
+#include <thrill/net/tcp/socket_address.hpp>
+
+#include <poll.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+namespace {
+
+/*!
+ * Scanner for the top-level key:value pairs of the JSON object on one log line.
+ * Arrays and objects as values are skipped, since the metrics are flat.
+ */
+class FlatJsonScanner
+{
+public:
+    explicit FlatJsonScanner(const std::string& str)
+        : p_(str.data()), end_(str.data() + str.size()) { }
+
+    //! Read the next pair, returns false at the end of the object or if the
+    //! line is malformed. is_num tells whether the value is a number in num,
+    //! else strings and literals are returned in str.
+    bool Next(std::string& key, std::string& str, double& num, bool& is_num) {
+        SkipSpace();
+        if (p_ == end_ || (*p_ != '{' && *p_ != ',')) return false;
+        ++p_;
+        SkipSpace();
+        if (!ParseString(key)) return false;
+        SkipSpace();
+        if (p_ == end_ || *p_++ != ':') return false;
+        SkipSpace();
+        if (p_ == end_) return false;
+
+        is_num = false;
+        if (*p_ == '"') return ParseString(str);
+        if (*p_ == '[' || *p_ == '{') return SkipNested();
+
+        // number or literal
+        const char* begin = p_;
+        while (p_ != end_ && *p_ != ',' && *p_ != '}' && !isspace(*p_)) ++p_;
+        str.assign(begin, p_);
+
+        char* endptr;
+        num = std::strtod(str.c_str(), &endptr);
+        is_num = !str.empty() && *endptr == 0;
+        return true;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+
+    void SkipSpace() {
+        while (p_ != end_ && isspace(*p_)) ++p_;
+    }
+
+    //! read a string, escape sequences other than \" and \\ are kept as is.
+    bool ParseString(std::string& out) {
+        if (p_ == end_ || *p_ != '"') return false;
+        ++p_;
+        out.clear();
+        while (p_ != end_ && *p_ != '"') {
+            if (*p_ == '\\' && p_ + 1 != end_) {
+                ++p_;
+                if (*p_ != '"' && *p_ != '\\') out += '\\';
+            }
+            out += *p_++;
+        }
+        if (p_ == end_) return false;
+        ++p_;
+        return true;
+    }
+
+    //! skip an array or object, including strings containing brackets.
+    bool SkipNested() {
+        size_t depth = 0;
+        while (p_ != end_) {
+            char c = *p_++;
+            if (c == '"') {
+                while (p_ != end_ && *p_ != '"') {
+                    if (*p_ == '\\' && p_ + 1 != end_) ++p_;
+                    ++p_;
+                }
+                if (p_ == end_) return false;
+                ++p_;
+            }
+            else if (c == '[' || c == '{') {
+                ++depth;
+            }
+            else if (c == ']' || c == '}') {
+                if (--depth == 0) return true;
+            }
+        }
+        return false;
+    }
+};
+
+//! convert a class name like LinuxProcStats to linux_proc_stats, and any
+//! character not allowed in metric names to '_'.
+std::string MetricPart(const std::string& str) {
+    std::string out;
+    for (size_t i = 0; i < str.size(); ++i) {
+        char c = str[i];
+        if (isupper(c)) {
+            if (i != 0 && (islower(str[i - 1]) || isdigit(str[i - 1]) ||
+                           (isupper(str[i - 1]) && i + 1 < str.size() &&
+                            islower(str[i + 1]))))
+                out += '_';
+            out += static_cast<char>(tolower(c));
+        }
+        else {
+            out += isalnum(c) ? c : '_';
+        }
+    }
+    return out;
+}
+
+//! escape a label value
+std::string EscapeLabel(const std::string& str) {
+    std::string out;
+    for (char c : str) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+/******************************************************************************/
+
+std::unique_ptr<MetricsServer> MetricsServer::Create(size_t host_rank) {
+    const char* env_port = getenv("THRILL_METRICS_PORT");
+    if (!env_port || !*env_port) return nullptr;
+
+    char* endptr;
+    unsigned long port = std::strtoul(env_port, &endptr, 10);
+    if (!endptr || *endptr != 0 || port + host_rank > 65535) {
+        die("environment variable THRILL_METRICS_PORT=" << env_port
+            << " is not a valid port.");
+    }
+
+    return std::make_unique<MetricsServer>(
+        host_rank, static_cast<uint16_t>(port + host_rank));
+}
+
+MetricsServer::MetricsServer(size_t host_rank, uint16_t port)
+    : host_rank_(host_rank), listen_(net::tcp::Socket::Create()) {
+
+    net::tcp::SocketAddress sa(
+        "0.0.0.0", std::to_string(port).c_str());
+
+    listen_.SetReuseAddr();
+    if (!listen_.bind(sa) || !listen_.listen()) {
+        throw common::ErrnoException(
+            "MetricsServer: could not listen on port " + std::to_string(port));
+    }
+    port_ = listen_.GetLocalAddress().GetPort();
+
+    thread_ = std::thread([this]() { ServeLoop(); });
+}
+
+MetricsServer::~MetricsServer() {
+    terminate_ = true;
+    thread_.join();
+}
+
+void MetricsServer::Update(const std::string& line) {
+    FlatJsonScanner scan(line);
+
+    std::string key, str, cls, event, label;
+    double num;
+    bool is_num;
+    size_t worker = size_t(-1);
+    double dia_id = 0, bytes = 0;
+    std::vector<std::pair<std::string, double> > numbers;
+
+    while (scan.Next(key, str, num, is_num)) {
+        if (!is_num) {
+            if (key == "class") cls = str;
+            else if (key == "event") event = str;
+            else if (key == "label") label = str;
+            continue;
+        }
+        if (key == "ts" || key == "host_rank") continue;
+        if (key == "worker_rank") worker = static_cast<size_t>(num);
+        else if (key == "dia_id") dia_id = num;
+        else if (key == "bytes") bytes = num;
+        numbers.emplace_back(key, num);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (event == "profile") {
+        std::string prefix = "thrill_" + MetricPart(cls) + "_";
+        for (const auto& n : numbers)
+            values_[prefix + MetricPart(n.first)] = n.second;
+    }
+    else if (cls == "StageBuilder" && worker != size_t(-1)) {
+        // events are phase-start and phase-done
+        std::string::size_type dash = event.find('-');
+        if (dash == std::string::npos) return;
+
+        Stage& stage = stages_[worker];
+        stage.phase = event.compare(dash + 1, std::string::npos, "start") == 0
+                      ? event.substr(0, dash) : "idle";
+        stage.label = label;
+        stage.dia_id = dia_id;
+    }
+    else if (cls == "BlockPool" && (event == "evict" || event == "read")) {
+        counters_["thrill_block_pool_" + event + "_bytes_total"] += bytes;
+        counters_["thrill_block_pool_" + event + "_blocks_total"] += 1;
+    }
+}
+
+std::string MetricsServer::Format() {
+    std::ostringstream oss;
+    oss << std::setprecision(15);
+
+    std::string host = "{host=\"" + std::to_string(host_rank_) + "\"}";
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (const auto& v : values_) {
+        oss << "# TYPE " << v.first << " gauge\n"
+            << v.first << host << ' ' << v.second << '\n';
+    }
+    for (const auto& c : counters_) {
+        oss << "# TYPE " << c.first << " counter\n"
+            << c.first << host << ' ' << c.second << '\n';
+    }
+    if (!stages_.empty()) {
+        oss << "# HELP thrill_worker_stage"
+            << " id of the DIA node whose stage each worker is running\n"
+            << "# TYPE thrill_worker_stage gauge\n";
+        for (const auto& s : stages_) {
+            oss << "thrill_worker_stage{host=\"" << host_rank_ << "\""
+                << ",worker=\"" << s.first << "\""
+                << ",phase=\"" << EscapeLabel(s.second.phase) << "\""
+                << ",label=\"" << EscapeLabel(s.second.label) << "\"} "
+                << s.second.dia_id << '\n';
+        }
+    }
+
+    return oss.str();
+}
+
+void MetricsServer::ServeLoop() {
+    common::NameThisThread("metrics-server");
+
+    while (!terminate_) {
+        // wake up regularly to check terminate_
+        struct pollfd pfd;
+        pfd.fd = listen_.fd();
+        pfd.events = POLLIN;
+        if (::poll(&pfd, 1, 100) <= 0) continue;
+
+        net::tcp::Socket client = listen_.accept();
+        if (client.IsValid())
+            Serve(client);
+    }
+}
+
+void MetricsServer::Serve(net::tcp::Socket& client) {
+    // read the request header up to the empty line, but do not wait long on
+    // slow clients.
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 16384)
+    {
+        struct pollfd pfd;
+        pfd.fd = client.fd();
+        pfd.events = POLLIN;
+        if (::poll(&pfd, 1, 1000) <= 0) return;
+
+        ssize_t rb = client.recv_one(buffer, sizeof(buffer));
+        if (rb <= 0) return;
+        request.append(buffer, static_cast<size_t>(rb));
+    }
+
+    std::string status = "200 OK", body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 ||
+        request.compare(0, 6, "GET / ") == 0) {
+        body = Format();
+    }
+    else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string header =
+        "HTTP/1.0 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+
+    client.send(header.data(), header.size());
+    client.send(body.data(), body.size());
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // THRILL_HAVE_NET_TCP
+
+/******************************************************************************/
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * thrill/api/metrics_server.hpp
+ *
+ * Small HTTP server exposing the latest profile values of a host in the
+ * Prometheus text format.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_METRICS_SERVER_HEADER
+#define THRILL_API_METRICS_SERVER_HEADER
+
+#include <thrill/common/config.hpp>
+
+#if THRILL_HAVE_NET_TCP
+
+#include <thrill/net/tcp/socket.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * MetricsServer receives the JSON log lines of a host, keeps the newest
+ * numeric values of all profile events, and answers HTTP requests to /metrics
+ * with them in the Prometheus (OpenMetrics) text format. A profile value key
+ * of class Cls becomes the gauge thrill_cls_key{host="rank"}. Additionally,
+ * the current stage of each worker and the bytes evicted and read by the
+ * BlockPool are exported.
+ *
+ * The server is started by HostContext if THRILL_METRICS_PORT is set, each
+ * host listens on that port plus its rank.
+ */
+class MetricsServer
+{
+public:
+    //! Start a MetricsServer if THRILL_METRICS_PORT is set, else nullptr.
+    static std::unique_ptr<MetricsServer> Create(size_t host_rank);
+
+    //! Listen on the given port, zero selects any free port.
+    MetricsServer(size_t host_rank, uint16_t port);
+
+    //! non-copyable: delete copy-constructor
+    MetricsServer(const MetricsServer&) = delete;
+    //! non-copyable: delete assignment operator
+    MetricsServer& operator = (const MetricsServer&) = delete;
+
+    //! stop the server thread
+    ~MetricsServer();
+
+    //! port the server is listening on
+    uint16_t port() const { return port_; }
+
+    //! Update the values from one JSON log line.
+    void Update(const std::string& line);
+
+    //! Format all current values in the Prometheus text format.
+    std::string Format();
+
+private:
+    //! current stage of a worker
+    struct Stage {
+        std::string phase;
+        std::string label;
+        double      dia_id;
+    };
+
+    //! rank of this host, the label of all values
+    size_t host_rank_;
+
+    //! listening socket
+    net::tcp::Socket listen_;
+
+    //! port of listen_
+    uint16_t port_;
+
+    //! lock for values_, counters_ and stages_
+    std::mutex mutex_;
+
+    //! newest values of profile events by metric name
+    std::map<std::string, double> values_;
+
+    //! accumulated counters by metric name
+    std::map<std::string, double> counters_;
+
+    //! current stage of each worker by worker rank
+    std::map<size_t, Stage> stages_;
+
+    //! flag to stop thread_
+    std::atomic<bool> terminate_ { false };
+
+    //! thread accepting and answering connections
+    std::thread thread_;
+
+    //! main loop of thread_
+    void ServeLoop();
+
+    //! read a request from a client and send the answer
+    void Serve(net::tcp::Socket& client);
+};
+
+} // namespace api
+} // namespace thrill
+
+#endif // THRILL_HAVE_NET_TCP
+
+#endif // !THRILL_API_METRICS_SERVER_HEADER
+
+/******************************************************************************/
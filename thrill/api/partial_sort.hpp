@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * thrill/api/partial_sort.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_PARTIAL_SORT_HEADER
+#define THRILL_API_PARTIAL_SORT_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/api/top_k.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which selects the k smallest items of its parent and outputs them
+ * in sorted order. Each worker keeps a bounded heap of k items, which are then
+ * merged by an AllReduce. Afterwards, each worker outputs an equal slice of
+ * the global result.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ParentDIA, typename CompareFunction>
+class PartialSortNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+public:
+    PartialSortNode(const ParentDIA& parent, size_t k,
+                    const CompareFunction& compare_function)
+        : Super(parent.ctx(), "PartialSort",
+                { parent.id() }, { parent.node() }),
+          collector_(k, compare_function)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             collector_.Insert(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    void Execute() final {
+        std::vector<ValueType> result = collector_.AllReduce(context_.net);
+
+        // keep only the local slice of the global result
+        common::Range range = common::CalculateLocalRange(
+            result.size(), context_.num_workers(), context_.my_rank());
+
+        items_.assign(result.begin() + range.begin,
+                      result.begin() + range.end);
+
+        sLOG << "PartialSortNode::Execute"
+             << "result_size" << result.size() << "local_range" << range;
+    }
+
+    void PushData(bool consume) final {
+        for (const ValueType& v : items_) {
+            this->PushItem(v);
+        }
+        if (consume)
+            std::vector<ValueType>().swap(items_);
+    }
+
+    void Dispose() final {
+        std::vector<ValueType>().swap(items_);
+    }
+
+private:
+    //! bounded heap of local items
+    TopKCollector<ValueType, CompareFunction> collector_;
+
+    //! local slice of the global result
+    std::vector<ValueType> items_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+auto DIA<ValueType, Stack>::PartialSort(
+    size_t k, const CompareFunction &compare_function) const {
+    assert(IsValid());
+
+    using PartialSortNode
+              = api::PartialSortNode<ValueType, DIA, CompareFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0>
+            >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    auto node = common::MakeCounting<PartialSortNode>(
+        *this, k, compare_function);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_PARTIAL_SORT_HEADER
+
+/******************************************************************************/
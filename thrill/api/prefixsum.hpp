@@ -18,6 +18,10 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/data/file.hpp>
 
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
 namespace thrill {
 namespace api {
 
@@ -32,6 +36,10 @@ class PrefixSumNode final : public DOpNode<ValueType>
     using Super = DOpNode<ValueType>;
     using Super::context_;
 
+    //! arithmetic items are read from the File in batches via NextMany() and
+    //! summed in a tight loop, instead of deserializing each one.
+    static constexpr bool use_batch_ = std::is_arithmetic<ValueType>::value;
+
 public:
     PrefixSumNode(const ParentDIA& parent,
                   const SumFunction& sum_function,
@@ -63,6 +71,17 @@ public:
         file_ = file.Copy();
         // read File for prefix sum.
         auto reader = file_.GetKeepReader();
+        if (use_batch_) {
+            std::vector<ValueType> batch(Super::push_batch_size);
+            size_t n;
+            while ((n = reader.NextMany(batch.data(), batch.size())) != 0) {
+                ValueType sum = local_sum_;
+                for (size_t i = 0; i < n; ++i)
+                    sum = sum_function_(sum, batch[i]);
+                local_sum_ = sum;
+            }
+            return true;
+        }
         while (reader.HasNext()) {
             local_sum_ = sum_function_(
                 local_sum_, reader.template Next<ValueType>());
@@ -93,6 +112,20 @@ public:
 
         ValueType sum = local_sum_;
 
+        if (use_batch_) {
+            // compute the prefix sums of each batch in place and push it
+            std::vector<ValueType> batch(Super::push_batch_size);
+            size_t n;
+            while ((n = reader.NextMany(batch.data(), batch.size())) != 0) {
+                for (size_t i = 0; i < n; ++i) {
+                    sum = sum_function_(sum, batch[i]);
+                    batch[i] = sum;
+                }
+                this->PushItems(batch.data(), n);
+            }
+            return;
+        }
+
         for (size_t i = 0; i < file_.num_items(); ++i) {
             sum = sum_function_(sum, reader.Next<ValueType>());
             this->PushItem(sum);
@@ -151,6 +184,187 @@ auto DIA<ValueType, Stack>::PrefixSum(
     return DIA<ValueType>(node);
 }
 
+/*!
+ * A DOpNode which computes a prefix sum of items, which is restarted whenever
+ * the key of the items changes. The segments may span many workers, their
+ * carries are combined with one exclusive prefix sum over SegmentCarry tuples.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ParentDIA,
+          typename KeyExtractor, typename SumFunction>
+class SegmentedPrefixSumNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+
+    //! (valid, single_key, last_key, carry): carry is the sum of the items of
+    //! the last segment with key last_key, and single_key is true if all items
+    //! have this key, such that the segment continues before them.
+    using SegmentCarry = std::tuple<bool, bool, Key, ValueType>;
+
+public:
+    SegmentedPrefixSumNode(const ParentDIA& parent,
+                           const KeyExtractor& key_extractor,
+                           const SumFunction& sum_function,
+                           const ValueType& initial_element)
+        : Super(parent.ctx(), "SegmentedPrefixSum",
+                { parent.id() }, { parent.node() }),
+          key_extractor_(key_extractor),
+          sum_function_(sum_function),
+          initial_element_(initial_element)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! PreOp: compute carry of the last local segment and store items.
+    void PreOp(const ValueType& input) {
+        Key key = key_extractor_(input);
+        if (!std::get<0>(local_carry_)) {
+            local_carry_ = SegmentCarry(true, true, key, input);
+        }
+        else if (std::get<2>(local_carry_) == key) {
+            std::get<3>(local_carry_) =
+                sum_function_(std::get<3>(local_carry_), input);
+        }
+        else {
+            local_carry_ = SegmentCarry(true, false, key, input);
+        }
+        writer_.Put(input);
+    }
+
+    void StopPreOp(size_t /* id */) final {
+        writer_.Close();
+    }
+
+    //! Executes the segmented prefixsum operation.
+    void Execute() final {
+        LOG << "MainOp processing";
+
+        SegmentCarry prefix = context_.net.ExPrefixSum(
+            local_carry_, SegmentCarry(false, false, Key(), ValueType()),
+            [this](const SegmentCarry& a, const SegmentCarry& b) {
+                return CombineCarry(a, b);
+            });
+
+        if (context_.my_rank() == 0) {
+            prefix = SegmentCarry(false, false, Key(), ValueType());
+        }
+
+        prefix_ = prefix;
+    }
+
+    void PushData(bool consume) final {
+        data::File::Reader reader = file_.GetReader(consume);
+
+        // continue the segment of the preceding workers, if any.
+        bool in_segment = std::get<0>(prefix_);
+        Key key = std::get<2>(prefix_);
+        ValueType sum = in_segment
+                        ? sum_function_(initial_element_, std::get<3>(prefix_))
+                        : initial_element_;
+
+        for (size_t i = 0; i < file_.num_items(); ++i) {
+            ValueType item = reader.Next<ValueType>();
+            Key item_key = key_extractor_(item);
+            if (!in_segment || !(item_key == key)) {
+                in_segment = true;
+                key = item_key;
+                sum = initial_element_;
+            }
+            sum = sum_function_(sum, item);
+            this->PushItem(sum);
+        }
+    }
+
+    void Dispose() final {
+        file_.Clear();
+    }
+
+private:
+    //! The key extractor which determines the segments.
+    KeyExtractor key_extractor_;
+    //! The sum function which is applied to two elements.
+    SumFunction sum_function_;
+    //! Initial element.
+    ValueType initial_element_;
+
+    //! Carry of the last local segment.
+    SegmentCarry local_carry_ { false, false, Key(), ValueType() };
+    //! Carry of the segment reaching this worker from preceding workers.
+    SegmentCarry prefix_ { false, false, Key(), ValueType() };
+
+    //! Local data file
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+
+    //! associative combination of the carries of two consecutive ranges.
+    SegmentCarry CombineCarry(
+        const SegmentCarry& a, const SegmentCarry& b) const {
+        if (!std::get<0>(b)) return a;
+        if (!std::get<0>(a)) return b;
+        if (std::get<1>(b) && std::get<2>(a) == std::get<2>(b)) {
+            return SegmentCarry(
+                true, std::get<1>(a), std::get<2>(b),
+                sum_function_(std::get<3>(a), std::get<3>(b)));
+        }
+        return b;
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename SumFunction>
+auto DIA<ValueType, Stack>::SegmentedPrefixSum(
+    const KeyExtractor &key_extractor, const SumFunction &sum_function,
+    const ValueType &initial_element) const {
+    assert(IsValid());
+
+    using SegmentedPrefixSumNode = api::SegmentedPrefixSumNode<
+              ValueType, DIA, KeyExtractor, SumFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0>
+            >::value,
+        "KeyExtractor has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<SumFunction>::template arg<0>
+            >::value,
+        "SumFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<SumFunction>::template arg<1> >::value,
+        "SumFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<SumFunction>::result_type,
+            ValueType>::value,
+        "SumFunction has the wrong input type");
+
+    auto node = common::MakeCounting<SegmentedPrefixSumNode>(
+        *this, key_extractor, sum_function, initial_element);
+
+    return DIA<ValueType>(node);
+}
+
 } // namespace api
 } // namespace thrill
 
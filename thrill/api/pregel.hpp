@@ -0,0 +1,339 @@
+/*******************************************************************************
+ * thrill/api/pregel.hpp
+ *
+ * Vertex-centric graph processing in supersteps on a cached, range-partitioned
+ * adjacency structure.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_PREGEL_HEADER
+#define THRILL_API_PREGEL_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/rebalance.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/data/cat_stream.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Action which appends the local items of a DIA of adjacency lists to the
+ * compressed sparse row arrays of a Pregel graph.
+ *
+ * \ingroup api_layer
+ */
+template <typename ParentDIA>
+class PregelLoadNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+    using Super = ActionNode;
+    using Super::context_;
+
+public:
+    PregelLoadNode(const ParentDIA& parent,
+                   std::vector<size_t>& offsets, std::vector<size_t>& targets)
+        : ActionNode(parent.ctx(), "PregelLoad",
+                     { parent.id() }, { parent.node() }),
+          offsets_(offsets), targets_(targets)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const std::vector<size_t>& input) {
+                             targets_.insert(
+                                 targets_.end(), input.begin(), input.end());
+                             offsets_.push_back(targets_.size());
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void Execute() final {
+        LOG << "PregelLoad: " << offsets_.size() - 1 << " vertices with "
+            << targets_.size() << " edges";
+    }
+
+private:
+    //! CSR offsets of the graph, starting with a zero
+    std::vector<size_t>& offsets_;
+    //! CSR targets of the graph
+    std::vector<size_t>& targets_;
+};
+
+/*!
+ * Pregel runs vertex-centric graph algorithms in supersteps. The adjacency
+ * lists are loaded once, range-partitioned over the workers like the output of
+ * Rebalance(), and kept as compressed sparse row arrays on their worker
+ * together with the state of each vertex. In each superstep, the compute
+ * function runs on every local vertex with the combined message sent to it in
+ * the previous superstep, and sends new messages along its edges. Only the
+ * messages cross the network, instead of the adjacency lists being joined with
+ * the state in every iteration.
+ *
+ * Messages to the same target are combined on the sending worker: in an array
+ * over all vertices if it fits into dense_array_max_bytes, like the dense path
+ * of ReduceToIndex, otherwise they are sent as (target, message) pairs and only
+ * combined on the receiving worker.
+ *
+ * \tparam VertexState Type of the state of each vertex.
+ *
+ * \tparam Message Type of the messages between vertices.
+ *
+ * \ingroup dia_dops
+ */
+template <typename VertexState, typename Message>
+class Pregel
+{
+    static constexpr bool debug = false;
+
+public:
+    //! The outgoing edges of a vertex, iterable targets in the CSR array
+    class Edges
+    {
+    public:
+        Edges(const size_t* begin, const size_t* end)
+            : begin_(begin), end_(end) { }
+
+        const size_t * begin() const { return begin_; }
+        const size_t * end() const { return end_; }
+        size_t size() const { return static_cast<size_t>(end_ - begin_); }
+        bool empty() const { return begin_ == end_; }
+
+    private:
+        const size_t* begin_;
+        const size_t* end_;
+    };
+
+    /*!
+     * Load the graph from a DIA of adjacency lists, in which the item at
+     * index i holds the targets of vertex i, and initialize the state of each
+     * vertex. The DIA is rebalanced and consumed by loading.
+     *
+     * \param adjacency DIA of the outgoing targets of each vertex.
+     *
+     * \param init_function Function `VertexState (size_t vertex)`.
+     *
+     * \param neutral_message Message received by vertices without messages.
+     *
+     * \param dense_array_max_bytes Maximum bytes of the array over all
+     * vertices used to combine outgoing messages, zero disables it.
+     */
+    template <typename InStack, typename InitFunction>
+    Pregel(const DIA<std::vector<size_t>, InStack>& adjacency,
+           const InitFunction& init_function,
+           const Message& neutral_message = Message(),
+           size_t dense_array_max_bytes = 64 * 1024 * 1024)
+        : ctx_(adjacency.context()),
+          neutral_message_(neutral_message),
+          offsets_(1, 0) {
+        assert(adjacency.IsValid());
+
+        auto balanced = adjacency.Rebalance();
+        {
+            using PregelLoadNode = api::PregelLoadNode<decltype(balanced)>;
+            auto node = common::MakeCounting<PregelLoadNode>(
+                balanced, offsets_, targets_);
+            node->RunScope();
+        }
+
+        num_vertices_ = ctx_.net.AllReduce(offsets_.size() - 1);
+        dense_ = dense_array_max_bytes != 0 &&
+                 num_vertices_ <= dense_array_max_bytes / sizeof(Message);
+
+        const size_t num_workers = ctx_.num_workers();
+        range_begin_.resize(num_workers);
+        for (size_t p = 0; p < num_workers; ++p) {
+            range_begin_[p] = common::CalculateLocalRange(
+                num_vertices_, num_workers, p).begin;
+        }
+        range_ = common::CalculateLocalRange(
+            num_vertices_, num_workers, ctx_.my_rank());
+        assert(range_.size() == offsets_.size() - 1);
+
+        states_.reserve(range_.size());
+        for (size_t v = range_.begin; v < range_.end; ++v)
+            states_.emplace_back(init_function(v));
+
+        messages_.resize(range_.size(), neutral_message_);
+        present_.resize(range_.size(), false);
+
+        LOG << "Pregel: vertices " << range_ << " of " << num_vertices_
+            << " dense " << dense_;
+    }
+
+    //! non-copyable: delete copy-constructor
+    Pregel(const Pregel&) = delete;
+    //! non-copyable: delete assignment operator
+    Pregel& operator = (const Pregel&) = delete;
+
+    /*!
+     * Run one superstep: call compute_function on each local vertex, and
+     * deliver the messages it sends, combined by combine_function, to the
+     * compute calls of the next superstep. Returns the global number of
+     * messages sent, such that the loop can stop when it is zero.
+     *
+     * \param compute_function Function `(size_t vertex, VertexState& state,
+     * const Message& message, const Edges& edges, auto send)`, which calls
+     * `send(size_t target, const Message&)` for any number of targets.
+     *
+     * \param combine_function Function `Message (const Message&, const
+     * Message&)`, which must be associative and commutative.
+     */
+    template <typename ComputeFunction, typename CombineFunction>
+    size_t Superstep(const ComputeFunction& compute_function,
+                     const CombineFunction& combine_function) {
+
+        data::CatStreamPtr stream = ctx_.GetNewCatStream(ctx_.next_dia_id());
+        std::vector<data::Stream::Writer> writers = stream->GetWriters();
+
+        std::vector<Message> out_messages;
+        std::vector<bool> out_present;
+        if (dense_) {
+            out_messages.resize(num_vertices_, neutral_message_);
+            out_present.resize(num_vertices_, false);
+        }
+
+        size_t num_sent = 0;
+
+        auto send = [&](size_t target, const Message& message) {
+                        assert(target < num_vertices_);
+                        ++num_sent;
+                        if (!dense_) {
+                            writers[Owner(target)].Put(
+                                std::make_pair(target, message));
+                        }
+                        else if (out_present[target]) {
+                            out_messages[target] = combine_function(
+                                out_messages[target], message);
+                        }
+                        else {
+                            out_messages[target] = message;
+                            out_present[target] = true;
+                        }
+                    };
+
+        for (size_t i = 0; i < states_.size(); ++i) {
+            Edges edges(targets_.data() + offsets_[i],
+                        targets_.data() + offsets_[i + 1]);
+            compute_function(range_.begin + i, states_[i],
+                             present_[i] ? messages_[i] : neutral_message_,
+                             edges, send);
+        }
+
+        if (dense_) {
+            for (size_t p = 0; p < writers.size(); ++p) {
+                size_t end = p + 1 < writers.size()
+                             ? range_begin_[p + 1] : num_vertices_;
+                for (size_t v = range_begin_[p]; v < end; ++v) {
+                    if (!out_present[v]) continue;
+                    writers[p].Put(std::make_pair(v, out_messages[v]));
+                }
+            }
+        }
+        for (data::Stream::Writer& w : writers) w.Close();
+        std::vector<Message>().swap(out_messages);
+        std::vector<bool>().swap(out_present);
+
+        // combine the incoming messages of the next superstep
+        std::fill(messages_.begin(), messages_.end(), neutral_message_);
+        std::fill(present_.begin(), present_.end(), false);
+
+        auto reader = stream->GetCatReader(/* consume */ true);
+        while (reader.HasNext()) {
+            auto p = reader.template Next<std::pair<size_t, Message> >();
+            assert(p.first >= range_.begin && p.first < range_.end);
+            size_t i = p.first - range_.begin;
+            if (present_[i]) {
+                messages_[i] = combine_function(messages_[i], p.second);
+            }
+            else {
+                messages_[i] = std::move(p.second);
+                present_[i] = true;
+            }
+        }
+        stream->Close();
+
+        ++superstep_;
+        return ctx_.net.AllReduce(num_sent);
+    }
+
+    //! Returns a DIA of the vertex states, the state of vertex i at index i.
+    DIA<VertexState> States() const {
+        return ConcatToDIA(ctx_, states_);
+    }
+
+    //! Returns the global number of vertices.
+    size_t num_vertices() const { return num_vertices_; }
+
+    //! Returns the number of supersteps run.
+    size_t superstep() const { return superstep_; }
+
+    //! Returns the range of vertices on this worker.
+    const common::Range& local_range() const { return range_; }
+
+private:
+    //! Context of the graph's workers
+    Context& ctx_;
+
+    //! Message received by vertices without messages
+    Message neutral_message_;
+
+    //! whether to combine outgoing messages in an array over all vertices
+    bool dense_ = false;
+
+    //! global number of vertices
+    size_t num_vertices_ = 0;
+
+    //! number of supersteps run
+    size_t superstep_ = 0;
+
+    //! first vertex of each worker
+    std::vector<size_t> range_begin_;
+
+    //! range of vertices on this worker
+    common::Range range_;
+
+    //! CSR offsets of the local vertices' edges into targets_
+    std::vector<size_t> offsets_;
+    //! CSR targets of the local vertices' edges
+    std::vector<size_t> targets_;
+
+    //! state of the local vertices
+    std::vector<VertexState> states_;
+
+    //! combined incoming messages of the local vertices, and whether any
+    //! message arrived.
+    std::vector<Message> messages_;
+    std::vector<bool> present_;
+
+    //! worker owning a vertex
+    size_t Owner(size_t vertex) const {
+        return static_cast<size_t>(
+            std::upper_bound(range_begin_.begin(), range_begin_.end(), vertex)
+            - range_begin_.begin()) - 1;
+    }
+};
+
+} // namespace api
+
+//! imported from api namespace
+using api::Pregel;
+
+} // namespace thrill
+
+#endif // !THRILL_API_PREGEL_HEADER
+
+/******************************************************************************/
@@ -18,15 +18,25 @@
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/item_serialization_tools.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/porting.hpp>
+#include <thrill/core/binary_index.hpp>
 #include <thrill/core/file_io.hpp>
+#include <thrill/core/remote_file_system.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_reader.hpp>
+#include <thrill/io/file_mapping.hpp>
 #include <thrill/io/syscall_file.hpp>
 #include <thrill/net/buffer_builder.hpp>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -65,6 +75,10 @@ public:
         size_t      size() const { return end - begin; }
         //! whether file is compressed
         bool        is_compressed;
+        //! number of items to skip at begin, which precede the local range.
+        size_t      skip_items = 0;
+        //! maximum number of items to read after skipping
+        size_t      num_items = std::numeric_limits<size_t>::max();
     };
 
     using SysFileInfo = core::SysFileInfo;
@@ -81,6 +95,27 @@ public:
                       + common::Join(" ", globlist));
         }
 
+        // read the item indexes which WriteBinary() appends to files of
+        // variable-size items on request, and exclude them from the file
+        // sizes.
+        std::vector<core::BinaryIndex> indexes(files.count());
+        bool all_indexed = !is_fixed_size_ && !files.contains_compressed;
+
+        if (!is_fixed_size_) {
+            uint64_t total_size = 0;
+            for (size_t i = 0; i < files.count(); ++i) {
+                SysFileInfo& f = files.list[i];
+                if (core::BinaryIndex::Read(f.path, f.size, &indexes[i]))
+                    f.size = indexes[i].data_size;
+                else
+                    all_indexed = false;
+                f.size_ex_psum = total_size;
+                total_size += f.size;
+            }
+            files.list.back().size_ex_psum = total_size;
+            files.total_size = total_size;
+        }
+
         if (is_fixed_size_ && !files.contains_compressed)
         {
             // use fixed_size information to split binary files.
@@ -126,12 +161,28 @@ public:
                      << "begin" << fi.begin << "end" << fi.end;
 
                 if (fi.begin == fi.end) continue;
-#if 0
-                my_files_.push_back(fi);
-#else
-                io::FileBasePtr file(
-                    new io::SyscallFile(
-                        fi.path, io::FileBase::RDONLY | io::FileBase::NO_LOCK));
+
+                if (files.contains_remote) {
+                    // remote files are requested from the offset onward.
+                    my_files_.push_back(fi);
+                    continue;
+                }
+
+                // either map the file range into memory or read blocks on
+                // demand from the file via the BlockPool.
+                io::FileMappingPtr mapping;
+                io::FileBasePtr file;
+                if (core::DefaultReadBinaryMmap()) {
+                    mapping = common::MakeCounting<io::FileMapping>(
+                        fi.path, fi.begin, fi.size());
+                    mapping->AdviseSequential();
+                }
+                else {
+                    file = io::FileBasePtr(
+                        new io::SyscallFile(
+                            fi.path,
+                            io::FileBase::RDONLY | io::FileBase::NO_LOCK));
+                }
 
                 size_t item_off = 0;
 
@@ -142,7 +193,10 @@ public:
                         std::min(off + data::default_block_size, fi.end) - off;
 
                     data::ByteBlockPtr bbp =
-                        context_.block_pool().MapExternalBlock(
+                        mapping
+                        ? context_.block_pool().MapMemoryBlock(
+                            mapping, off - fi.begin, bsize)
+                        : context_.block_pool().MapExternalBlock(
                             file, off, bsize);
 
                     size_t item_num =
@@ -159,9 +213,50 @@ public:
                 }
 
                 use_ext_file_ = true;
-#endif
             }
         }
+        else if (all_indexed)
+        {
+            // split files at the item boundaries of the indexes, such that
+            // all workers get equal numbers of items.
+            uint64_t total_items = 0;
+            for (const core::BinaryIndex& index : indexes)
+                total_items += index.total_items;
+
+            common::Range my_range = context_.CalculateLocalRange(total_items);
+
+            uint64_t items_ex_psum = 0;
+            for (size_t i = 0; i < files.count(); ++i) {
+                const core::BinaryIndex& index = indexes[i];
+
+                uint64_t begin = std::max<uint64_t>(my_range.begin, items_ex_psum);
+                uint64_t end = std::min<uint64_t>(
+                    my_range.end, items_ex_psum + index.total_items);
+                items_ex_psum += index.total_items;
+                if (begin >= end) continue;
+
+                begin -= items_ex_psum - index.total_items;
+                end -= items_ex_psum - index.total_items;
+
+                const core::BinaryIndex::Checkpoint& cp =
+                    index.CheckpointBefore(begin);
+
+                FileInfo fi { files.list[i].path, cp.first,
+                              index.OffsetAfter(end), false };
+                fi.skip_items = begin - cp.second;
+                fi.num_items = end - begin;
+
+                sLOG << "FileInfo"
+                     << "path" << fi.path
+                     << "begin" << fi.begin << "end" << fi.end
+                     << "skip_items" << fi.skip_items
+                     << "num_items" << fi.num_items;
+
+                my_files_.push_back(fi);
+            }
+
+            LOG << my_files_.size() << " files, my items " << my_range;
+        }
         else
         {
             // split filelist by whole files.
@@ -177,10 +272,14 @@ public:
 
             while (i < files.count() &&
                    files.list[i].size_inc_psum() <= my_range.end) {
+                bool is_compressed = files.list[i].IsCompressed();
+                // compressed files are read until the decompressor ends.
                 my_files_.push_back(
                     FileInfo { files.list[i].path, 0,
-                               std::numeric_limits<size_t>::max(),
-                               files.list[i].IsCompressed() });
+                               is_compressed
+                               ? std::numeric_limits<size_t>::max()
+                               : files.list[i].size,
+                               is_compressed });
                 i++;
             }
 
@@ -191,6 +290,10 @@ public:
     ReadBinaryNode(Context& ctx, const std::string& glob)
         : ReadBinaryNode(ctx, std::vector<std::string>{ glob }) { }
 
+    //! reads the files again on each PushData(), unless they are mapped into
+    //! a File.
+    bool Recomputes() final { return !use_ext_file_; }
+
     void PushData(bool consume) final {
         if (use_ext_file_) {
             this->PushFile(ext_file_, consume);
@@ -199,17 +302,38 @@ public:
 
         LOG << "ReadBinaryNode::PushData() start id " << this->id();
 
+        // files read via SysFile are opened up to open_files ahead, such
+        // that their reader threads already read while the current file is
+        // processed.
+        const size_t read_ahead = core::DefaultReadBinaryReadAhead();
+        const size_t open_files =
+            read_ahead == 0 ? 1 : core::DefaultReadBinaryOpenFiles();
+        std::vector<std::unique_ptr<SysFileReader> > readers(my_files_.size());
+
         // Hook Read
-        for (const FileInfo& file : my_files_) {
+        for (size_t i = 0; i < my_files_.size(); ++i) {
+            const FileInfo& file = my_files_[i];
             LOG << "ReadBinaryNode::PushData() opening " << file.path;
 
-            data::BlockReader<SysFileBlockSource> br(
-                SysFileBlockSource(file, context_,
-                                   stats_total_bytes, stats_total_reads));
+            if (UseMmap(file)) {
+                data::BlockReader<MappedBlockSource> br(
+                    MappedBlockSource(file, context_,
+                                      stats_total_bytes, stats_total_reads));
+                PushReader(br, file);
+                continue;
+            }
 
-            while (br.HasNext()) {
-                this->PushItem(br.template NextNoSelfVerify<ValueType>());
+            for (size_t j = i; j < std::min(i + open_files, my_files_.size());
+                 ++j) {
+                if (readers[j] || UseMmap(my_files_[j])) continue;
+                readers[j] = std::make_unique<SysFileReader>(
+                    my_files_[j], context_, read_ahead);
             }
+
+            data::BlockReader<SysFileBlockSource> br(
+                SysFileBlockSource(std::move(readers[i]),
+                                   stats_total_bytes, stats_total_reads));
+            PushReader(br, file);
         }
 
         Super::logger_
@@ -222,35 +346,151 @@ public:
 private:
     std::vector<FileInfo> my_files_;
 
+    //! whether the file is read via a memory mapping
+    static bool UseMmap(const FileInfo& file) {
+        return !file.is_compressed && !core::IsRemotePath(file.path) &&
+               core::DefaultReadBinaryMmap();
+    }
+
+    //! skip and push the items of file from a BlockReader
+    template <typename Reader>
+    void PushReader(Reader& br, const FileInfo& file) {
+        for (size_t i = 0; i < file.skip_items && br.HasNext(); ++i)
+            br.template NextNoSelfVerify<ValueType>();
+
+        std::vector<ValueType> batch;
+        batch.reserve(Super::push_batch_size);
+        for (size_t i = 0; i < file.num_items && br.HasNext(); ) {
+            batch.clear();
+            for ( ; i < file.num_items && br.HasNext() &&
+                  batch.size() < Super::push_batch_size; ++i)
+                batch.emplace_back(br.template NextNoSelfVerify<ValueType>());
+            this->PushItems(batch.data(), batch.size());
+        }
+    }
+
     bool use_ext_file_ = false;
     data::File ext_file_ { context_.GetFile(this) };
 
     size_t stats_total_bytes = 0;
     size_t stats_total_reads = 0;
 
-    class SysFileBlockSource
+    /*!
+     * Reads the Blocks of one file via core::SysFile. With read_ahead > 0, a
+     * reader thread reads up to read_ahead Blocks ahead of the consumer, such
+     * that reading and processing overlap, otherwise Next() reads
+     * synchronously. The reader thread starts at construction, hence files
+     * which are opened ahead are already being read.
+     */
+    class SysFileReader
     {
     public:
         const size_t block_size = data::default_block_size;
 
-        SysFileBlockSource(const FileInfo& fileinfo,
-                           Context& ctx,
-                           size_t& stats_total_bytes,
-                           size_t& stats_total_reads)
+        SysFileReader(const FileInfo& fileinfo, Context& ctx,
+                      size_t read_ahead)
             : context_(ctx),
-              sysfile_(core::SysFile::OpenForRead(fileinfo.path)),
+              sysfile_(core::SysFile::OpenForRead(
+                           fileinfo.path, core::DefaultDirectIO(),
+                           fileinfo.is_compressed ? 0 : fileinfo.begin)),
               remain_size_(fileinfo.size()),
               is_compressed_(fileinfo.is_compressed),
-              stats_total_bytes_(stats_total_bytes),
-              stats_total_reads_(stats_total_reads) {
-            if (fileinfo.begin != 0 && !is_compressed_) {
-                // seek to beginning
-                size_t p = sysfile_.lseek(static_cast<off_t>(fileinfo.begin));
-                die_unequal(fileinfo.begin, p);
+              read_ahead_(read_ahead) {
+            if (fileinfo.begin % core::SysFile::direct_alignment != 0)
+                sysfile_.set_direct(false);
+            if (read_ahead_ != 0)
+                thread_ = common::CreateThread([this]() { Work(); });
+        }
+
+        //! non-copyable: delete copy-constructor
+        SysFileReader(const SysFileReader&) = delete;
+        //! non-copyable: delete assignment operator
+        SysFileReader& operator = (const SysFileReader&) = delete;
+
+        ~SysFileReader() {
+            if (!thread_.joinable()) return;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                stop_ = true;
             }
+            cv_.notify_all();
+            thread_.join();
         }
 
-        data::PinnedBlock NextBlock() {
+        //! Returns the next Block of the file, or an invalid Block at the end.
+        data::PinnedBlock Next() {
+            if (read_ahead_ == 0) return ReadBlock();
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return !queue_.empty() || finished_; });
+            if (queue_.empty()) {
+                if (error_) std::rethrow_exception(error_);
+                return data::PinnedBlock();
+            }
+            data::PinnedBlock block = std::move(queue_.front());
+            queue_.pop_front();
+            cv_.notify_all();
+            return block;
+        }
+
+    private:
+        Context& context_;
+        core::SysFile sysfile_;
+        size_t remain_size_;
+        bool is_compressed_;
+        bool done_ = false;
+
+        //! number of Blocks read ahead by the thread, zero if synchronous.
+        size_t read_ahead_;
+        //! reader thread, if reading ahead
+        std::thread thread_;
+        //! mutex protecting the queue and flags
+        std::mutex mutex_;
+        //! signaled on changes of the queue and flags
+        std::condition_variable cv_;
+        //! Blocks read ahead
+        std::deque<data::PinnedBlock> queue_;
+        //! flag that the reader thread finished
+        bool finished_ = false;
+        //! flag that the consumer is gone
+        bool stop_ = false;
+        //! exception thrown while reading, rethrown by Next()
+        std::exception_ptr error_;
+
+        //! reader thread: read Blocks while fewer than read_ahead_ are ready.
+        void Work() {
+            try {
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cv_.wait(lock, [this]() {
+                                     return stop_ || queue_.size() < read_ahead_;
+                                 });
+                        if (stop_) return;
+                    }
+
+                    data::PinnedBlock block = ReadBlock();
+
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (!block.IsValid()) {
+                        finished_ = true;
+                        cv_.notify_all();
+                        return;
+                    }
+                    queue_.emplace_back(std::move(block));
+                    cv_.notify_all();
+                }
+            }
+            catch (...) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                error_ = std::current_exception();
+                finished_ = true;
+                cv_.notify_all();
+            }
+        }
+
+        //! read the next Block synchronously
+        data::PinnedBlock ReadBlock() {
             if (done_) return data::PinnedBlock();
 
             data::PinnedByteBlockPtr bytes
@@ -260,14 +500,21 @@ private:
             size_t rb = is_compressed_
                         ? block_size : std::min(block_size, remain_size_);
 
+            if (sysfile_.direct() &&
+                !core::SysFile::IsDirectAligned(bytes->data(), rb))
+                sysfile_.set_direct(false);
+
             ssize_t size = sysfile_.read(bytes->data(), rb);
-            stats_total_bytes_ += size;
-            stats_total_reads_++;
+
+            // a short read leaves the file offset unaligned at the end.
+            if (sysfile_.direct() && size >= 0 && static_cast<size_t>(size) < rb)
+                sysfile_.set_direct(false);
 
             if (size > 0) {
+                // pipes from remote files may return short reads.
                 if (!is_compressed_) {
-                    assert(remain_size_ >= rb);
-                    remain_size_ -= rb;
+                    assert(remain_size_ >= static_cast<size_t>(size));
+                    remain_size_ -= size;
                 }
                 return data::PinnedBlock(std::move(bytes), 0, size, 0, 0,
                                          /* typecode_verify */ false);
@@ -282,15 +529,81 @@ private:
                 return data::PinnedBlock();
             }
         }
+    };
+
+    //! BlockSource which delivers the Blocks of a SysFileReader.
+    class SysFileBlockSource
+    {
+    public:
+        SysFileBlockSource(std::unique_ptr<SysFileReader>&& reader,
+                           size_t& stats_total_bytes,
+                           size_t& stats_total_reads)
+            : reader_(std::move(reader)),
+              stats_total_bytes_(stats_total_bytes),
+              stats_total_reads_(stats_total_reads) { }
+
+        data::PinnedBlock NextBlock() {
+            if (!reader_) return data::PinnedBlock();
+
+            data::PinnedBlock block = reader_->Next();
+            stats_total_reads_++;
+
+            if (!block.IsValid()) {
+                // close the file and join the reader thread
+                reader_.reset();
+                return block;
+            }
+            stats_total_bytes_ += block.size();
+            return block;
+        }
+
+    private:
+        std::unique_ptr<SysFileReader> reader_;
+        size_t& stats_total_bytes_;
+        size_t& stats_total_reads_;
+    };
+
+    //! BlockSource which delivers zero-copy Blocks pointing into a memory
+    //! mapping of the whole file.
+    class MappedBlockSource
+    {
+    public:
+        const size_t block_size = data::default_block_size;
+
+        MappedBlockSource(const FileInfo& fileinfo,
+                          Context& ctx,
+                          size_t& stats_total_bytes,
+                          size_t& stats_total_reads)
+            : context_(ctx),
+              mapping_(common::MakeCounting<io::FileMapping>(
+                           fileinfo.path, fileinfo.begin, fileinfo.size())),
+              stats_total_bytes_(stats_total_bytes),
+              stats_total_reads_(stats_total_reads) {
+            mapping_->AdviseSequential();
+        }
+
+        data::PinnedBlock NextBlock() {
+            if (offset_ >= mapping_->size()) return data::PinnedBlock();
+
+            size_t size = std::min(block_size, mapping_->size() - offset_);
+
+            data::Block block(
+                context_.block_pool().MapMemoryBlock(mapping_, offset_, size),
+                0, size, 0, 0, /* typecode_verify */ false);
+
+            offset_ += size;
+            stats_total_bytes_ += size;
+            stats_total_reads_++;
+
+            return block.PinWait(context_.local_worker_id());
+        }
 
     private:
         Context& context_;
-        core::SysFile sysfile_;
-        size_t remain_size_;
-        bool is_compressed_;
+        io::FileMappingPtr mapping_;
+        size_t offset_ = 0;
         size_t& stats_total_bytes_;
         size_t& stats_total_reads_;
-        bool done_ = false;
     };
 };
 
@@ -0,0 +1,350 @@
+/*******************************************************************************
+ * thrill/api/read_columnar.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_READ_COLUMNAR_HEADER
+#define THRILL_API_READ_COLUMNAR_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/source_node.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/meta.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/core/columnar_format.hpp>
+#include <thrill/core/file_io.hpp>
+#include <thrill/core/remote_file_system.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Options of ReadColumnar() for projection and predicate pushdown.
+ */
+template <typename ValueType>
+struct ColumnarOptions {
+    //! indexes of the columns to read, or all if empty. The other columns are
+    //! not read from the files, they are value-initialized in the items.
+    std::vector<size_t> columns;
+
+    //! Predicate on the minimum and maximum values of each column in a chunk
+    //! of rows. Chunks for which it returns false are skipped without reading
+    //! them, hence it must return true if any item in the range may match.
+    //! Items of the remaining chunks are not filtered.
+    std::function<bool(const ValueType& min, const ValueType& max)>
+    chunk_filter;
+};
+
+/*!
+ * A DIANode which reads columnar files written by WriteColumnar(). Chunks are
+ * distributed to the workers by their number of rows.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType>
+class ReadColumnarNode final : public SourceNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    static_assert(common::is_std_tuple<ValueType>::value,
+                  "ReadColumnar needs an std::tuple as value type");
+
+    //! number of columns
+    static constexpr size_t num_columns = std::tuple_size<ValueType>::value;
+
+    using Columns = typename core::columnar::ColumnVectors<ValueType>::type;
+
+public:
+    using Super = SourceNode<ValueType>;
+    using Super::context_;
+
+    ReadColumnarNode(Context& ctx, const std::vector<std::string>& globlist,
+                     const ColumnarOptions<ValueType>& options)
+        : Super(ctx, "ReadColumnar"),
+          selected_(num_columns, options.columns.empty()) {
+
+        for (size_t c : options.columns) {
+            if (c >= num_columns) {
+                throw std::runtime_error(
+                          "ReadColumnar() column " + std::to_string(c)
+                          + " out of range");
+            }
+            selected_[c] = true;
+        }
+
+        core::SysFileList files = core::GlobFileSizePrefixSum(
+            core::GlobFilePatterns(globlist));
+
+        if (files.count() == 0) {
+            throw std::runtime_error(
+                      "No files found in globs: "
+                      + common::Join(" ", globlist));
+        }
+
+        // read all footers and select the chunks to read, which are
+        // identical on all workers.
+        std::vector<ChunkRef> chunks;
+        uint64_t total_rows = 0;
+
+        for (size_t f = 0; f < files.count(); ++f) {
+            const std::string& path = files.list[f].path;
+            if (core::IsRemotePath(path) || files.list[f].IsCompressed()) {
+                throw std::runtime_error(
+                          "ReadColumnar() can only read uncompressed local "
+                          "files: " + path);
+            }
+
+            core::columnar::Footer footer = ReadFooter(path, files.list[f].size);
+
+            for (core::columnar::ChunkMeta& meta : footer.chunks) {
+                if (options.chunk_filter &&
+                    !options.chunk_filter(StatTuple(meta, true),
+                                          StatTuple(meta, false))) {
+                    stats_skipped_chunks_++;
+                    continue;
+                }
+                chunks.emplace_back(ChunkRef { path, total_rows, std::move(meta) });
+                total_rows += chunks.back().meta.rows;
+            }
+        }
+
+        // take chunks whose first row is in the local range
+        common::Range my_range = context_.CalculateLocalRange(total_rows);
+
+        for (ChunkRef& c : chunks) {
+            if (c.first_row >= my_range.begin && c.first_row < my_range.end)
+                my_chunks_.emplace_back(std::move(c));
+        }
+
+        LOG << "ReadColumnar() " << my_chunks_.size() << " of "
+            << chunks.size() << " chunks, skipped " << stats_skipped_chunks_;
+    }
+
+    //! decodes the chunks again on each PushData()
+    bool Recomputes() final { return true; }
+
+    void PushData(bool /* consume */) final {
+        LOG << "ReadColumnarNode::PushData() start " << *this;
+
+        core::SysFile file;
+        std::string path;
+        uint64_t offset = 0;
+        std::string buffer;
+        Columns columns;
+
+        for (const ChunkRef& c : my_chunks_) {
+            if (c.path != path) {
+                file = core::SysFile::OpenForRead(c.path);
+                path = c.path, offset = 0;
+            }
+
+            common::VariadicCallEnumerate<num_columns>(
+                [&](auto index) {
+                    static constexpr size_t I = decltype(index)::index;
+                    auto& column = std::get<I>(columns);
+                    using Type = typename std::decay_t<decltype(column)>::value_type;
+
+                    const core::columnar::ColumnMeta& m = c.meta.columns[I];
+                    if (!selected_[I]) {
+                        column.assign(c.meta.rows, Type());
+                        return;
+                    }
+                    if (m.size != 0) {
+                        Seek(file, path, &offset, m.offset);
+                        buffer.resize(m.size);
+                        ReadFully(file, path, &buffer[0], m.size);
+                        offset += m.size;
+                        stats_total_bytes_ += m.size;
+                    }
+                    core::columnar::DecodeColumn(
+                        m, buffer.data(), c.meta.rows, &column, path);
+                });
+
+            for (size_t r = 0; r < c.meta.rows; ++r) {
+                this->PushItem(MakeRow(columns, r,
+                                       common::make_index_sequence<num_columns>()));
+            }
+            stats_total_rows_ += c.meta.rows;
+        }
+
+        Super::logger_
+            << "class" << "ReadColumnarNode"
+            << "event" << "done"
+            << "total_rows" << stats_total_rows_
+            << "total_bytes" << stats_total_bytes_
+            << "skipped_chunks" << stats_skipped_chunks_;
+    }
+
+private:
+    //! a chunk to read
+    struct ChunkRef {
+        std::string                path;
+        uint64_t                   first_row;
+        core::columnar::ChunkMeta meta;
+    };
+
+    //! which columns to read
+    std::vector<bool> selected_;
+
+    //! chunks read by this worker
+    std::vector<ChunkRef> my_chunks_;
+
+    size_t stats_total_rows_ = 0;
+    size_t stats_total_bytes_ = 0;
+    size_t stats_skipped_chunks_ = 0;
+
+    //! read exactly size bytes from file or throw
+    static void ReadFully(core::SysFile& file, const std::string& path,
+                          char* data, size_t size) {
+        while (size != 0) {
+            ssize_t rb = file.read(data, size);
+            if (rb <= 0) core::columnar::Footer::Invalid(path);
+            data += rb, size -= rb;
+        }
+    }
+
+    //! seek forward from offset to target
+    static void Seek(core::SysFile& file, const std::string& path,
+                     uint64_t* offset, uint64_t target) {
+        if (target == *offset) return;
+        if (target < *offset) {
+            file = core::SysFile::OpenForRead(path, false, target);
+        }
+        else if (file.lseek(static_cast<off_t>(target - *offset)) < 0) {
+            throw common::ErrnoException("Cannot seek in file " + path);
+        }
+        *offset = target;
+    }
+
+    //! read and verify the footer of a file
+    static core::columnar::Footer ReadFooter(
+        const std::string& path, uint64_t size) {
+        using core::columnar::Footer;
+        if (size < core::columnar::trailer_size) Footer::Invalid(path);
+
+        char trailer[core::columnar::trailer_size];
+        {
+            core::SysFile file = core::SysFile::OpenForRead(
+                path, false, size - sizeof(trailer));
+            ReadFully(file, path, trailer, sizeof(trailer));
+        }
+        if (std::memcmp(trailer + sizeof(uint64_t), core::columnar::magic,
+                        sizeof(core::columnar::magic)) != 0)
+            Footer::Invalid(path);
+
+        uint64_t footer_size;
+        std::memcpy(&footer_size, trailer, sizeof(footer_size));
+        if (footer_size > size - sizeof(trailer)) Footer::Invalid(path);
+
+        std::string data(footer_size, 0);
+        {
+            core::SysFile file = core::SysFile::OpenForRead(
+                path, false, size - sizeof(trailer) - footer_size);
+            ReadFully(file, path, &data[0], footer_size);
+        }
+        Footer footer = Footer::Deserialize(data, path);
+
+        bool valid = footer.value_sizes.size() == num_columns;
+        common::VariadicCallEnumerate<num_columns>(
+            [&](auto index) {
+                static constexpr size_t I = decltype(index)::index;
+                valid = valid && footer.value_sizes[I] == sizeof(
+                    typename std::tuple_element<I, ValueType>::type);
+            });
+        if (!valid) {
+            throw std::runtime_error(
+                      "ReadColumnar() columns of file " + path
+                      + " do not match the value type");
+        }
+        return footer;
+    }
+
+    //! assemble the minimum or maximum values of a chunk into a tuple
+    static ValueType StatTuple(const core::columnar::ChunkMeta& meta, bool min) {
+        ValueType t;
+        common::VariadicCallEnumerate<num_columns>(
+            [&](auto index) {
+                static constexpr size_t I = decltype(index)::index;
+                using Type = typename std::tuple_element<I, ValueType>::type;
+                std::get<I>(t) = core::columnar::StatValue<Type>(
+                    min ? meta.columns[I].min : meta.columns[I].max);
+            });
+        return t;
+    }
+
+    //! assemble row r from the columns
+    template <size_t ... Is>
+    static ValueType MakeRow(const Columns& columns, size_t r,
+                             common::index_sequence<Is ...>) {
+        return ValueType(std::get<Is>(columns)[r] ...);
+    }
+};
+
+/*!
+ * ReadColumnar is a DOp, which reads columnar files written by WriteColumnar
+ * from the file system and creates a DIA. Only the columns given in the
+ * options are read, and chunks rejected by the options' chunk_filter are
+ * skipped.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Paths or globs of the files in the file system
+ * \param options columns to read and chunk predicate
+ *
+ * \ingroup dia_sources
+ */
+template <typename ValueType>
+DIA<ValueType> ReadColumnar(
+    Context& ctx, const std::vector<std::string>& filepath,
+    const ColumnarOptions<ValueType>& options = ColumnarOptions<ValueType>()) {
+
+    auto node = common::MakeCounting<ReadColumnarNode<ValueType> >(
+        ctx, filepath, options);
+
+    return DIA<ValueType>(node);
+}
+
+/*!
+ * ReadColumnar is a DOp, which reads columnar files written by WriteColumnar
+ * from the file system and creates a DIA. Only the columns given in the
+ * options are read, and chunks rejected by the options' chunk_filter are
+ * skipped.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path or glob of the files in the file system
+ * \param options columns to read and chunk predicate
+ *
+ * \ingroup dia_sources
+ */
+template <typename ValueType>
+DIA<ValueType> ReadColumnar(
+    Context& ctx, const std::string& filepath,
+    const ColumnarOptions<ValueType>& options = ColumnarOptions<ValueType>()) {
+    return ReadColumnar<ValueType>(
+        ctx, std::vector<std::string>{ filepath }, options);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::ColumnarOptions;
+using api::ReadColumnar;
+
+} // namespace thrill
+
+#endif // !THRILL_API_READ_COLUMNAR_HEADER
+
+/******************************************************************************/
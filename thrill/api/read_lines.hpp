@@ -19,11 +19,15 @@
 #include <thrill/common/defines.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/string.hpp>
+#include <thrill/common/string_view.hpp>
 #include <thrill/common/system_exception.hpp>
+#include <thrill/core/bgzf_file.hpp>
 #include <thrill/core/file_io.hpp>
 #include <thrill/net/buffer_builder.hpp>
 
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -32,16 +36,23 @@ namespace api {
 
 /*!
  * A DIANode which performs a line-based Read operation. Reads a file from the
- * file system and delivers it as a DIA.
+ * file system and delivers it as a DIA. ValueType is either std::string, or
+ * common::StringView for lines referencing the read buffers, which are only
+ * valid while the item is pushed.
  *
  * \ingroup api_layer
  */
-class ReadLinesNode final : public SourceNode<std::string>
+template <typename ValueType>
+class ReadLinesNode final : public SourceNode<ValueType>
 {
     static constexpr bool debug = false;
 
+    static_assert(std::is_same<ValueType, std::string>::value ||
+                  std::is_same<ValueType, common::StringView>::value,
+                  "ReadLinesNode delivers std::string or common::StringView");
+
 public:
-    using Super = SourceNode<std::string>;
+    using Super = SourceNode<ValueType>;
     using Super::context_;
 
     using FileSizePair = std::pair<std::string, size_t>;
@@ -71,14 +82,25 @@ public:
         return data::default_block_size;
     }
 
+    //! reads the files again on each PushData()
+    bool Recomputes() final { return true; }
+
     void PushData(bool /* consume */) final {
-        if (filelist_.contains_compressed) {
+        if (filelist_.all_bgzf) {
+            InputLineIteratorBgzf it = InputLineIteratorBgzf(filelist_, *this);
+
+            // Hook Read
+            while (it.HasNext()) {
+                PushLine(it.Next(), IsView());
+            }
+        }
+        else if (filelist_.contains_compressed) {
             InputLineIteratorCompressed it = InputLineIteratorCompressed(
                 filelist_, *this);
 
             // Hook Read
             while (it.HasNext()) {
-                this->PushItem(it.Next());
+                PushLine(it.Next(), IsView());
             }
         }
         else {
@@ -87,7 +109,7 @@ public:
 
             // Hook Read
             while (it.HasNext()) {
-                this->PushItem(it.Next());
+                PushLine(it.Next(), IsView());
             }
         }
     }
@@ -95,6 +117,21 @@ public:
 private:
     core::SysFileList filelist_;
 
+    //! whether lines are delivered as common::StringView
+    using IsView = std::is_same<ValueType, common::StringView>;
+
+    //! String, which std::string lines are copied into for pushing
+    std::string line_;
+
+    void PushLine(const common::StringView& line, std::true_type /* view */) {
+        this->PushItem(line);
+    }
+
+    void PushLine(const common::StringView& line, std::false_type /* view */) {
+        line_.assign(line.data(), line.size());
+        this->PushItem(line_);
+    }
+
     class InputLineIterator
     {
     public:
@@ -115,7 +152,7 @@ private:
     protected:
         //! Block read size
         const size_t read_size = data::default_block_size;
-        //! String, which Next() references to
+        //! String, which collects lines spanning multiple blocks
         std::string data_;
         //! Input files with size prefixsum.
         const core::SysFileList& files_;
@@ -136,6 +173,40 @@ private:
         size_t total_reads_ = 0;
         size_t total_elements_ = 0;
 
+        //! Returns the first newline in [begin, end) or end. memchr() is
+        //! implemented with SSE2/AVX2 instructions by the C library, which is
+        //! considerably faster than comparing byte by byte.
+        static unsigned char * FindNewline(
+            unsigned char* begin, unsigned char* end) {
+            void* nl = std::memchr(begin, '\n', end - begin);
+            return nl ? static_cast<unsigned char*>(nl) : end;
+        }
+
+        //! Returns the line ending at newline nl, which either lies in the
+        //! current buffer or, if parts of it were collected in data_ from
+        //! previous blocks, in data_. Advances current_ beyond the newline.
+        common::StringView TakeLine(unsigned char* nl) {
+            common::StringView line;
+            if (data_.empty()) {
+                line = common::StringView(
+                    reinterpret_cast<const char*>(current_), nl - current_);
+            }
+            else {
+                data_.append(reinterpret_cast<const char*>(current_),
+                             nl - current_);
+                line = common::StringView(data_);
+            }
+            current_ = nl + 1;
+            return line;
+        }
+
+        //! Appends the rest of the current buffer to data_.
+        void CollectRest() {
+            data_.append(reinterpret_cast<const char*>(current_),
+                         buffer_.end() - current_);
+            current_ = buffer_.end();
+        }
+
         bool ReadBlock(core::SysFile& file, net::BufferBuilder& buffer) {
             read_timer.Start();
             ssize_t bytes = file.read(buffer.data(), read_size);
@@ -172,26 +243,27 @@ private:
             : InputLineIterator(files, node) {
 
             // Go to start of 'local part'.
-            my_range_ = node_.context_.CalculateLocalRange(files.total_size);
+            this->my_range_ = this->node_.context_.CalculateLocalRange(files.total_size);
 
-            while (files_.list[current_file_].size_inc_psum() <= my_range_.begin) {
-                current_file_++;
+            while (this->files_.list[this->current_file_].size_inc_psum() <= this->my_range_.begin) {
+                this->current_file_++;
             }
-            if (my_range_.begin < my_range_.end) {
-                LOG << "Opening file " << current_file_;
-                file_ = core::SysFile::OpenForRead(files_.list[current_file_].path);
+            if (this->my_range_.begin < this->my_range_.end) {
+                // find offset in current file:
+                // offset = start - sum of previous file sizes
+                offset_ = this->my_range_.begin - this->files_.list[this->current_file_].size_ex_psum;
+
+                LOG << "Opening file " << this->current_file_ << " at " << offset_;
+                file_ = core::SysFile::OpenForRead(
+                    this->files_.list[this->current_file_].path, false, offset_);
             }
             else {
-                LOG << "my_range : " << my_range_;
+                LOG << "my_range : " << this->my_range_;
                 return;
             }
 
-            // find offset in current file:
-            // offset = start - sum of previous file sizes
-            offset_ = file_.lseek(
-                static_cast<off_t>(my_range_.begin - files_.list[current_file_].size_ex_psum));
-            buffer_.Reserve(read_size);
-            ReadBlock(file_, buffer_);
+            this->buffer_.Reserve(this->read_size);
+            this->ReadBlock(file_, this->buffer_);
 
             if (offset_ != 0) {
                 bool found_n = false;
@@ -199,61 +271,57 @@ private:
                 // find next newline, discard all previous data as previous
                 // worker already covers it
                 while (!found_n) {
-                    while (current_ < buffer_.end()) {
-                        if (THRILL_UNLIKELY(*current_++ == '\n')) {
-                            found_n = true;
-                            break;
-                        }
+                    unsigned char* nl = this->FindNewline(this->current_, this->buffer_.end());
+                    if (nl != this->buffer_.end()) {
+                        this->current_ = nl + 1;
+                        found_n = true;
                     }
                     // no newline found: read new data into buffer_builder
                     if (!found_n) {
-                        offset_ += buffer_.size();
-                        if (!ReadBlock(file_, buffer_)) {
+                        offset_ += this->buffer_.size();
+                        if (!this->ReadBlock(file_, this->buffer_)) {
                             // EOF = newline per definition
                             found_n = true;
                         }
                     }
                 }
             }
-            data_.reserve(4 * 1024);
+            this->data_.reserve(4 * 1024);
         }
 
-        //! returns the next element if one exists
+        //! returns the next element if one exists, which is valid until the
+        //! next call.
         //!
         //! does no checks whether a next element exists!
-        const std::string& Next() {
-            total_elements_++;
-            data_.clear();
+        common::StringView Next() {
+            this->total_elements_++;
+            this->data_.clear();
             while (true) {
-                while (current_ < buffer_.end()) {
-                    if (THRILL_UNLIKELY(*current_ == '\n')) {
-                        current_++;
-                        return data_;
-                    }
-                    else {
-                        data_.push_back(*current_++);
-                    }
-                }
-                offset_ += buffer_.size();
-                if (!ReadBlock(file_, buffer_)) {
+                unsigned char* nl = this->FindNewline(this->current_, this->buffer_.end());
+                if (nl != this->buffer_.end())
+                    return this->TakeLine(nl);
+
+                this->CollectRest();
+                offset_ += this->buffer_.size();
+                if (!this->ReadBlock(file_, this->buffer_)) {
                     LOG << "opening next file";
 
                     file_.close();
-                    current_file_++;
+                    this->current_file_++;
                     offset_ = 0;
 
-                    if (current_file_ < files_.count()) {
-                        file_ = core::SysFile::OpenForRead(files_.list[current_file_].path);
-                        offset_ += buffer_.size();
-                        ReadBlock(file_, buffer_);
+                    if (this->current_file_ < this->files_.count()) {
+                        file_ = core::SysFile::OpenForRead(this->files_.list[this->current_file_].path);
+                        offset_ += this->buffer_.size();
+                        this->ReadBlock(file_, this->buffer_);
                     }
                     else {
-                        current_ = buffer_.begin() +
-                                   files_.list[current_file_ - 1].size;
+                        this->current_ = this->buffer_.begin() +
+                                   this->files_.list[this->current_file_ - 1].size;
                     }
 
-                    if (data_.length()) {
-                        return data_;
+                    if (this->data_.length()) {
+                        return common::StringView(this->data_);
                     }
                 }
             }
@@ -261,12 +329,12 @@ private:
 
         //! returns true, if an element is available in local part
         bool HasNext() {
-            size_t position_in_buf = current_ - buffer_.begin();
-            assert(current_ >= buffer_.begin());
-            size_t global_index = offset_ + position_in_buf + files_.list[current_file_].size_ex_psum;
-            return global_index < my_range_.end ||
-                   (global_index == my_range_.end &&
-                    files_.list[current_file_].size > offset_ + position_in_buf);
+            size_t position_in_buf = this->current_ - this->buffer_.begin();
+            assert(this->current_ >= this->buffer_.begin());
+            size_t global_index = offset_ + position_in_buf + this->files_.list[this->current_file_].size_ex_psum;
+            return global_index < this->my_range_.end ||
+                   (global_index == this->my_range_.end &&
+                    this->files_.list[this->current_file_].size > offset_ + position_in_buf);
         }
 
     private:
@@ -286,74 +354,71 @@ private:
             : InputLineIterator(files, node) {
 
             // Go to start of 'local part'.
-            my_range_ = node_.context_.CalculateLocalRange(files.total_size);
+            this->my_range_ = this->node_.context_.CalculateLocalRange(files.total_size);
 
-            while (files_.list[current_file_].size_inc_psum() <= my_range_.begin) {
-                current_file_++;
+            while (this->files_.list[this->current_file_].size_inc_psum() <= this->my_range_.begin) {
+                this->current_file_++;
             }
 
-            for (size_t file_nr = current_file_; file_nr < files_.count(); file_nr++) {
-                if (files.list[file_nr].size_inc_psum() == my_range_.end) {
+            for (size_t file_nr = this->current_file_; file_nr < this->files_.count(); file_nr++) {
+                if (files.list[file_nr].size_inc_psum() == this->my_range_.end) {
                     break;
                 }
-                if (files.list[file_nr].size_inc_psum() > my_range_.end) {
-                    my_range_.end = files_.list[file_nr].size_ex_psum;
+                if (files.list[file_nr].size_inc_psum() > this->my_range_.end) {
+                    this->my_range_.end = this->files_.list[file_nr].size_ex_psum;
                     break;
                 }
             }
 
-            if (my_range_.begin < my_range_.end) {
-                LOG << "Opening file " << current_file_;
-                LOG << "my_range : " << my_range_;
-                file_ = core::SysFile::OpenForRead(files_.list[current_file_].path);
+            if (this->my_range_.begin < this->my_range_.end) {
+                LOG << "Opening file " << this->current_file_;
+                LOG << "my_range : " << this->my_range_;
+                file_ = core::SysFile::OpenForRead(this->files_.list[this->current_file_].path);
             }
             else {
                 // No local files, set buffer size to 2, so HasNext() does not try to read
-                LOG << "my_range : " << my_range_;
-                buffer_.Reserve(2);
-                buffer_.set_size(2);
-                current_ = buffer_.begin();
+                LOG << "my_range : " << this->my_range_;
+                this->buffer_.Reserve(2);
+                this->buffer_.set_size(2);
+                this->current_ = this->buffer_.begin();
                 return;
             }
-            buffer_.Reserve(read_size);
-            ReadBlock(file_, buffer_);
-            data_.reserve(4 * 1024);
+            this->buffer_.Reserve(this->read_size);
+            this->ReadBlock(file_, this->buffer_);
+            this->data_.reserve(4 * 1024);
         }
 
-        //! returns the next element if one exists
+        //! returns the next element if one exists, which is valid until the
+        //! next call.
         //!
         //! does no checks whether a next element exists!
-        const std::string& Next() {
-            total_elements_++;
-            data_.clear();
+        common::StringView Next() {
+            this->total_elements_++;
+            this->data_.clear();
             while (true) {
-                while (current_ < buffer_.end()) {
-                    if (THRILL_UNLIKELY(*current_ == '\n')) {
-                        current_++;
-                        return data_;
-                    }
-                    else {
-                        data_.push_back(*current_++);
-                    }
-                }
+                unsigned char* nl = this->FindNewline(this->current_, this->buffer_.end());
+                if (nl != this->buffer_.end())
+                    return this->TakeLine(nl);
+
+                this->CollectRest();
 
-                if (!ReadBlock(file_, buffer_)) {
+                if (!this->ReadBlock(file_, this->buffer_)) {
                     LOG << "Opening new file!";
                     file_.close();
-                    current_file_++;
+                    this->current_file_++;
 
-                    if (current_file_ < files_.count()) {
-                        file_ = core::SysFile::OpenForRead(files_.list[current_file_].path);
-                        ReadBlock(file_, buffer_);
+                    if (this->current_file_ < this->files_.count()) {
+                        file_ = core::SysFile::OpenForRead(this->files_.list[this->current_file_].path);
+                        this->ReadBlock(file_, this->buffer_);
                     }
                     else {
                         LOG << "reached last file";
-                        current_ = buffer_.begin();
+                        this->current_ = this->buffer_.begin();
                     }
 
-                    if (data_.length()) {
-                        LOG << "end - returning string of length" << data_.length();
-                        return data_;
+                    if (this->data_.length()) {
+                        LOG << "end - returning string of length" << this->data_.length();
+                        return common::StringView(this->data_);
                     }
                 }
             }
@@ -361,31 +426,31 @@ private:
 
         //! returns true, if an element is available in local part
         bool HasNext() {
-            if (files_.list[current_file_].size_ex_psum >= my_range_.end) {
+            if (this->files_.list[this->current_file_].size_ex_psum >= this->my_range_.end) {
                 return false;
             }
 
             // if block is fully read, read next block. needs to be done here
             // as HasNext() has to know if file is finished
             //         v-- no new line at end ||   v-- newline at end of file
-            if (current_ >= buffer_.end() || (current_ + 1 >= buffer_.end() && *current_ == '\n')) {
+            if (this->current_ >= this->buffer_.end() || (this->current_ + 1 >= this->buffer_.end() && *this->current_ == '\n')) {
                 LOG << "New buffer in HasNext()";
-                ReadBlock(file_, buffer_);
-                if (buffer_.size() > 1 || (buffer_.size() == 1 && buffer_[0] != '\n')) {
+                this->ReadBlock(file_, this->buffer_);
+                if (this->buffer_.size() > 1 || (this->buffer_.size() == 1 && this->buffer_[0] != '\n')) {
                     return true;
                 }
                 else {
                     LOG << "Opening new file in HasNext()";
                     // already at last file
-                    if (current_file_ >= files_.count() - 1) {
+                    if (this->current_file_ >= this->files_.count() - 1) {
                         return false;
                     }
                     file_.close();
                     // if (this worker reads at least one more file)
-                    if (my_range_.end > files_.list[current_file_].size_inc_psum()) {
-                        current_file_++;
-                        file_ = core::SysFile::OpenForRead(files_.list[current_file_].path);
-                        ReadBlock(file_, buffer_);
+                    if (this->my_range_.end > this->files_.list[this->current_file_].size_inc_psum()) {
+                        this->current_file_++;
+                        file_ = core::SysFile::OpenForRead(this->files_.list[this->current_file_].path);
+                        this->ReadBlock(file_, this->buffer_);
                         return true;
                     }
                     else {
@@ -402,6 +467,126 @@ private:
         //! File handle to files_[current_file_]
         core::SysFile file_;
     };
+
+    //! InputLineIterator gives you access to lines of BGZF files, which are
+    //! split among the workers at member boundaries: each worker delivers the
+    //! lines starting in members which begin in its local range.
+    class InputLineIteratorBgzf : public InputLineIterator
+    {
+    public:
+        //! Creates an instance of iterator that reads file line based
+        InputLineIteratorBgzf(const core::SysFileList& files,
+                              ReadLinesNode& node)
+            : InputLineIterator(files, node) {
+
+            // Go to start of 'local part'.
+            this->my_range_ =
+                this->node_.context_.CalculateLocalRange(files.total_size);
+
+            this->buffer_.Reserve(core::BgzfFile::max_member_size);
+            this->current_ = this->buffer_.end();
+
+            while (this->files_.list[this->current_file_].size_inc_psum()
+                   <= this->my_range_.begin) {
+                this->current_file_++;
+            }
+            if (this->my_range_.begin >= this->my_range_.end) {
+                LOG << "my_range : " << this->my_range_;
+                done_ = true;
+                return;
+            }
+
+            LOG << "Opening file " << this->current_file_;
+            file_ = core::BgzfFile(
+                this->files_.list[this->current_file_].path,
+                this->my_range_.begin
+                - this->files_.list[this->current_file_].size_ex_psum);
+
+            if (file_.offset() != 0) {
+                // skip the rest of a line starting in a previous member, which
+                // the previous worker delivers.
+                while (ReadMember()) {
+                    unsigned char* nl =
+                        this->FindNewline(this->current_, this->buffer_.end());
+                    if (nl != this->buffer_.end()) {
+                        this->current_ = nl + 1;
+                        break;
+                    }
+                    this->current_ = this->buffer_.end();
+                }
+            }
+            this->data_.reserve(4 * 1024);
+        }
+
+        //! returns the next element if one exists, which is valid until the
+        //! next call.
+        //!
+        //! does no checks whether a next element exists!
+        common::StringView Next() {
+            this->total_elements_++;
+            this->data_.clear();
+            while (true) {
+                unsigned char* nl =
+                    this->FindNewline(this->current_, this->buffer_.end());
+                if (nl != this->buffer_.end())
+                    return this->TakeLine(nl);
+
+                this->CollectRest();
+                // the line continues in the next member or ends with the file
+                if (!ReadMember())
+                    return common::StringView(this->data_);
+            }
+        }
+
+        //! returns true, if an element is available in local part
+        bool HasNext() {
+            if (done_) return false;
+
+            // load the member in which the next line starts
+            while (this->current_ == this->buffer_.end()) {
+                if (ReadMember()) continue;
+
+                // end of file: open the next file if it starts in local part
+                if (this->current_file_ + 1 >= this->files_.count() ||
+                    this->files_.list[this->current_file_ + 1].size_ex_psum
+                    >= this->my_range_.end) {
+                    done_ = true;
+                    return false;
+                }
+                this->current_file_++;
+                LOG << "Opening file " << this->current_file_;
+                file_ = core::BgzfFile(
+                    this->files_.list[this->current_file_].path, 0);
+            }
+            return member_pos_ < this->my_range_.end;
+        }
+
+    private:
+        //! Reader of files_[current_file_]
+        core::BgzfFile file_;
+        //! global position of the member in buffer_
+        uint64_t member_pos_ = 0;
+        //! whether all lines of the local part were delivered
+        bool done_ = false;
+
+        //! Decompress the next member of the current file into buffer_,
+        //! returns false at the end of the file.
+        bool ReadMember() {
+            member_pos_ = this->files_.list[this->current_file_].size_ex_psum
+                          + file_.offset();
+            size_t size;
+            this->read_timer.Start();
+            bool ok = file_.ReadMember(this->buffer_.data(), &size);
+            this->read_timer.Stop();
+            if (!ok) return false;
+
+            this->buffer_.set_size(size);
+            this->current_ = this->buffer_.begin();
+            this->total_bytes_ += size;
+            this->total_reads_++;
+            return true;
+        }
+    };
 };
 
 /*!
@@ -414,7 +599,8 @@ private:
  * \ingroup dia_sources
  */
 DIA<std::string> ReadLines(Context& ctx, const std::string& filepath) {
-    return DIA<std::string>(common::MakeCounting<ReadLinesNode>(ctx, filepath));
+    return DIA<std::string>(
+        common::MakeCounting<ReadLinesNode<std::string> >(ctx, filepath));
 }
 
 /*!
@@ -429,7 +615,45 @@ DIA<std::string> ReadLines(Context& ctx, const std::string& filepath) {
 DIA<std::string> ReadLines(
     Context& ctx, const std::vector<std::string>& filepaths) {
     return DIA<std::string>(
-        common::MakeCounting<ReadLinesNode>(ctx, filepaths));
+        common::MakeCounting<ReadLinesNode<std::string> >(ctx, filepaths));
+}
+
+/*!
+ * ReadLinesView is a DOp, which reads a file from the file system and creates
+ * an ordered DIA of lines as common::StringView. The views reference the read
+ * buffers and are only valid while the line is pushed, hence they must be
+ * consumed by the following LOps, e.g. a FlatMap tokenizer, without copying
+ * the line.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the file in the file system
+ *
+ * \ingroup dia_sources
+ */
+DIA<common::StringView> ReadLinesView(
+    Context& ctx, const std::string& filepath) {
+    return DIA<common::StringView>(
+        common::MakeCounting<ReadLinesNode<common::StringView> >(
+            ctx, filepath));
+}
+
+/*!
+ * ReadLinesView is a DOp, which reads a file from the file system and creates
+ * an ordered DIA of lines as common::StringView. The views reference the read
+ * buffers and are only valid while the line is pushed, hence they must be
+ * consumed by the following LOps, e.g. a FlatMap tokenizer, without copying
+ * the line.
+ *
+ * \param ctx Reference to the context object
+ * \param filepaths Path of the file in the file system
+ *
+ * \ingroup dia_sources
+ */
+DIA<common::StringView> ReadLinesView(
+    Context& ctx, const std::vector<std::string>& filepaths) {
+    return DIA<common::StringView>(
+        common::MakeCounting<ReadLinesNode<common::StringView> >(
+            ctx, filepaths));
 }
 
 } // namespace api
@@ -437,6 +661,9 @@ DIA<std::string> ReadLines(
 //! imported from api namespace
 using api::ReadLines;
 
+//! imported from api namespace
+using api::ReadLinesView;
+
 } // namespace thrill
 
 #endif // !THRILL_API_READ_LINES_HEADER
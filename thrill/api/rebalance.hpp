@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * thrill/api/rebalance.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_REBALANCE_HEADER
+#define THRILL_API_REBALANCE_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DOpNode which moves items between workers such that each holds an equal
+ * share, while keeping the global order of the items.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType>
+class RebalanceNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+public:
+    template <typename ParentDIA>
+    explicit RebalanceNode(const ParentDIA& parent)
+        : Super(parent.ctx(), "Rebalance", { parent.id() }, { parent.node() }),
+          parent_stack_empty_(ParentDIA::stack_empty)
+    {
+        auto save_fn = [this](const ValueType& input) {
+                           writer_.Put(input);
+                       };
+        auto lop_chain = parent.stack().push(save_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! Receive a whole data::File of ValueType, but only if our stack is empty.
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!parent_stack_empty_) return false;
+        assert(file_.num_items() == 0);
+        file_ = file.Copy();
+        return true;
+    }
+
+    void StopPreOp(size_t /* id */) final {
+        writer_.Close();
+    }
+
+    void Execute() final {
+        size_t local_size = file_.num_items();
+        size_t local_rank = context_.net.ExPrefixSum(local_size);
+        size_t total_size = context_.net.AllReduce(local_size);
+
+        // worker p receives the global range [begin_p, begin_{p+1}). Only items
+        // outside the own range leave this worker.
+        const size_t num_workers = context_.num_workers();
+        std::vector<size_t> offsets(num_workers + 1, 0);
+        for (size_t p = 0; p < num_workers; ++p) {
+            size_t begin = common::CalculateLocalRange(
+                total_size, num_workers, p).begin;
+            if (begin < local_rank) continue;
+            offsets[p] = std::min(begin - local_rank, local_size);
+        }
+        offsets[num_workers] = local_size;
+
+        LOG << "local_rank " << local_rank << " total_size " << total_size
+            << " offsets " << common::VecToStr(offsets);
+
+        stream_->template Scatter<ValueType>(file_, offsets, /* consume */ true);
+    }
+
+    void PushData(bool consume) final {
+        data::CatStream::CatReader reader = stream_->GetCatReader(consume);
+        while (reader.HasNext()) {
+            this->PushItem(reader.Next<ValueType>());
+        }
+    }
+
+    void Dispose() final { }
+
+private:
+    //! whether the parent stack is empty
+    const bool parent_stack_empty_;
+
+    //! Local data file
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+
+    //! CatStream for the exchange, which keeps the order of the workers
+    data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+};
+
+template <typename ValueType, typename Stack>
+auto DIA<ValueType, Stack>::Rebalance() const {
+    assert(IsValid());
+
+    using RebalanceNode = api::RebalanceNode<ValueType>;
+
+    auto node = common::MakeCounting<RebalanceNode>(*this);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_REBALANCE_HEADER
+
+/******************************************************************************/
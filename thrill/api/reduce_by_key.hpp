@@ -19,13 +19,21 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dop_node.hpp>
 #include <thrill/common/functional.hpp>
+#include <thrill/common/hyperloglog.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/meta.hpp>
 #include <thrill/common/porting.hpp>
+#include <thrill/core/multiway_merge.hpp>
 #include <thrill/core/reduce_by_hash_post_stage.hpp>
 #include <thrill/core/reduce_pre_stage.hpp>
+#include <thrill/data/cat_stream.hpp>
+#include <thrill/data/file.hpp>
+#include <thrill/data/mix_stream.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <iterator>
 #include <thread>
 #include <type_traits>
 #include <typeinfo>
@@ -54,6 +62,19 @@ class DefaultReduceConfig : public core::DefaultReduceConfig
  * \tparam VolatileKey Whether to reuse the key once extracted in during pre reduce
  * (false) or let the post reduce extract the key again (true).
  *
+ * If ReduceConfig::use_host_combine_ is set and there are multiple workers per
+ * host, the pre stage partitions items only among the workers of the local
+ * host. Each local worker then combines the items it received in a second pre
+ * stage, which sends them to their final worker. Since both stages partition by
+ * the same hash, combiner i only sends to workers with local id i, and each key
+ * crosses the network at most once per host.
+ *
+ * If the parent DIA is already partitioned by the same stateless KeyExtractor,
+ * e.g. because it is the output of a previous ReduceByKey with the same key,
+ * all items with equal key are already on the same worker. The ReduceNode then
+ * skips the pre stage and the shuffle, and inserts items directly into the
+ * post stage.
+ *
  * \ingroup api_layer
  */
 template <typename ValueType, typename ParentDIA,
@@ -76,6 +97,7 @@ class ReduceNode final : public DOpNode<ValueType>
 
     static constexpr bool use_mix_stream_ = ReduceConfig::use_mix_stream_;
     static constexpr bool use_post_thread_ = ReduceConfig::use_post_thread_;
+    static constexpr bool use_host_combine_ = ReduceConfig::use_host_combine_;
 
 private:
     //! Emitter for PostStage to push elements to next DIA object.
@@ -101,13 +123,29 @@ public:
                const ReduceFunction& reduce_function,
                const ReduceConfig& config)
         : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          local_(ParentDIA::stack_empty &&
+                 parent.node()->is_partitioned_by(Partitioning::tag())),
           mix_stream_(use_mix_stream_ ?
                       parent.ctx().GetNewMixStream(this) : nullptr),
           cat_stream_(use_mix_stream_ ?
                       nullptr : parent.ctx().GetNewCatStream(this)),
           emitters_(use_mix_stream_ ?
                     mix_stream_->GetWriters() : cat_stream_->GetWriters()),
+          host_combine_(use_host_combine_ && !local_ &&
+                        parent.ctx().workers_per_host() > 1),
+          combine_stream_(host_combine_ ?
+                          parent.ctx().GetNewCatStream(this) : nullptr),
+          combine_remote_writers_(
+              host_combine_ ? combine_stream_->GetWriters()
+              : std::vector<data::Stream::Writer>()),
+          combine_writers_(TakeLocalWriters(combine_remote_writers_)),
           pre_stage_(
+              context_, Super::id(),
+              host_combine_ ? parent.ctx().workers_per_host()
+              : parent.ctx().num_workers(),
+              key_extractor, reduce_function,
+              host_combine_ ? combine_writers_ : emitters_, config),
+          combine_stage_(
               context_, Super::id(), parent.ctx().num_workers(),
               key_extractor, reduce_function, emitters_, config),
           post_stage_(
@@ -117,13 +155,35 @@ public:
         // Hook PreOp: Locally hash elements of the current DIA onto buckets and
         // reduce each bucket to a single value, afterwards send data to another
         // worker given by the shuffle algorithm.
-        auto pre_op_fn = [this](const ValueType& input) {
-                             return pre_stage_.Insert(input);
+        auto pre_op_fn = [this](auto&& input) {
+                             PreOp(std::forward<decltype(input)>(input));
                          };
         // close the function stack with our pre op and register it at
         // parent node for output
         auto lop_chain = parent.stack().push(pre_op_fn).fold();
         parent.node()->AddChild(this, lop_chain);
+
+        if (config.schedule_exchange()) {
+            use_mix_stream_ ? mix_stream_->ScheduleExchange()
+            : cat_stream_->ScheduleExchange();
+        }
+
+        // the post stage is initialized after the items are received only
+        // without the post thread, hence the key sketches can size it.
+        if (config.key_sketch_precision() != 0 && !use_post_thread_ &&
+            !local_) {
+            sketch_stream_ = parent.ctx().GetNewCatStream(this);
+            if (host_combine_)
+                combine_stage_.EnableKeySketches(config.key_sketch_precision());
+            else
+                pre_stage_.EnableKeySketches(config.key_sketch_precision());
+        }
+
+        // the output contains each key once, located on the worker the hash
+        // partitioning delivered it to. With a volatile key, the output
+        // cannot be keyed again by the KeyExtractor.
+        if (!VolatileKey || SendPair)
+            Super::set_partitioning(Partitioning::tag());
     }
 
     DIAMemUse PreOpMemUse() final {
@@ -134,12 +194,16 @@ public:
 
     void StartPreOp(size_t /* id */) final {
         LOG << *this << " running StartPreOp";
-        if (!use_post_thread_) {
+        if (local_) {
+            // parent is partitioned by key: reduce locally in post stage
+            post_stage_.Initialize(DIABase::mem_limit_);
+        }
+        else if (!use_post_thread_) {
             // use pre_stage without extra thread
-            pre_stage_.Initialize(DIABase::mem_limit_);
+            pre_stage_.Initialize(PreStageMemLimit());
         }
         else {
-            pre_stage_.Initialize(DIABase::mem_limit_ / 2);
+            pre_stage_.Initialize(PreStageMemLimit());
             post_stage_.Initialize(DIABase::mem_limit_ / 2);
 
             // start additional thread to receive from the channel
@@ -149,9 +213,20 @@ public:
 
     void StopPreOp(size_t /* id */) final {
         LOG << *this << " running StopPreOp";
+        if (local_) {
+            // close the unused shuffle stream, and wait for the other workers
+            // to close it by reading the empty stream.
+            for (data::Stream::Writer& w : emitters_) w.Close();
+            ProcessChannel();
+            use_mix_stream_ ? mix_stream_->Close() : cat_stream_->Close();
+            reduced_ = true;
+            return;
+        }
         // Flush hash table before the postOp
         pre_stage_.FlushAll();
         pre_stage_.CloseAll();
+        if (host_combine_) CombineHost();
+        if (sketch_stream_) SendKeySketches();
         // waiting for the additional thread to finish the reduce
         if (use_post_thread_) thread_.join();
         use_mix_stream_ ? mix_stream_->Close() : cat_stream_->Close();
@@ -167,7 +242,11 @@ public:
 
         if (!use_post_thread_ && !reduced_) {
             // not final reduced, and no additional thread, perform post reduce
-            post_stage_.Initialize(DIABase::mem_limit_);
+            if (sketch_stream_)
+                post_stage_.Initialize(
+                    DIABase::mem_limit_, ReceiveKeySketches());
+            else
+                post_stage_.Initialize(DIABase::mem_limit_);
             ProcessChannel();
 
             reduced_ = true;
@@ -202,6 +281,114 @@ public:
     }
 
 private:
+    //! insert an item of the parent's chain into the pre or post stage.
+    void PreOp(const ValueType& input) {
+        if (local_)
+            return post_stage_.Insert(input);
+        return pre_stage_.Insert(input);
+    }
+
+    //! insert an rvalue of the parent's chain, which is moved into the table.
+    void PreOp(ValueType&& input) {
+        if (local_)
+            return post_stage_.Insert(std::move(input));
+        return pre_stage_.Insert(std::move(input));
+    }
+
+    //! memory limit of the pre stage, which is reused by the combine stage.
+    size_t PreStageMemLimit() const {
+        size_t mem_limit = DIABase::mem_limit_;
+        return use_post_thread_ ? mem_limit / 2 : mem_limit;
+    }
+
+    //! move the writers to the local workers out of writers, which leaves the
+    //! writers to remote workers.
+    std::vector<data::Stream::Writer> TakeLocalWriters(
+        std::vector<data::Stream::Writer>& writers) {
+        std::vector<data::Stream::Writer> local;
+        if (writers.empty()) return local;
+
+        size_t begin = context_.host_rank() * context_.workers_per_host();
+        size_t end = begin + context_.workers_per_host();
+
+        std::move(writers.begin() + begin, writers.begin() + end,
+                  std::back_inserter(local));
+        writers.erase(writers.begin() + begin, writers.begin() + end);
+        return local;
+    }
+
+    //! read the pre-reduced items from all workers on this host and reduce
+    //! them again before sending them to their final workers.
+    void CombineHost() {
+        for (data::Stream::Writer& w : combine_remote_writers_)
+            w.Close();
+
+        combine_stage_.Initialize(PreStageMemLimit());
+
+        auto reader = combine_stream_->GetCatReader(/* consume */ true);
+        sLOG << "combining data from" << combine_stream_->id()
+             << "on host" << context_.host_rank();
+        while (reader.HasNext()) {
+            combine_stage_.Insert(reader.template Next<PreStageOutput>());
+        }
+
+        combine_stage_.FlushAll();
+        combine_stage_.CloseAll();
+        combine_stream_->Close();
+    }
+
+    //! send the sketch of the keys sent to each worker to it, and release the
+    //! sketches.
+    void SendKeySketches() {
+        std::vector<common::HyperLogLog>& sketches =
+            host_combine_ ? combine_stage_.key_sketches()
+            : pre_stage_.key_sketches();
+
+        std::vector<data::CatStream::Writer> writers =
+            sketch_stream_->GetWriters();
+        assert(writers.size() == sketches.size());
+        for (size_t i = 0; i < writers.size(); ++i) {
+            writers[i].Put(sketches[i].registers());
+            writers[i].Close();
+        }
+        std::vector<common::HyperLogLog>().swap(sketches);
+    }
+
+    //! merge the key sketches of all senders, and return the estimated number
+    //! of distinct keys this worker receives.
+    size_t ReceiveKeySketches() {
+        std::vector<uint8_t> registers;
+
+        auto reader = sketch_stream_->GetCatReader(/* consume */ true);
+        while (reader.HasNext()) {
+            auto sketch = reader.template Next<std::vector<uint8_t> >();
+            if (registers.empty())
+                registers = std::move(sketch);
+            else
+                common::HyperLogLog::MergeRegisters(&registers, sketch);
+        }
+        sketch_stream_->Close();
+
+        size_t expected_keys = 0;
+        if (!registers.empty()) {
+            expected_keys = static_cast<size_t>(
+                std::llround(common::HyperLogLog::Estimate(registers)));
+        }
+
+        Super::logger_
+            << "class" << "ReduceNode"
+            << "event" << "key_sketch"
+            << "expected_keys" << expected_keys;
+
+        return expected_keys;
+    }
+
+    using Partitioning = KeyPartitioning<KeyExtractor>;
+
+    //! whether the parent is partitioned by the key, hence items are reduced
+    //! locally without shuffle.
+    bool local_;
+
     // pointers for both Mix and CatStream. only one is used, the other costs
     // only a null pointer.
     data::MixStreamPtr mix_stream_;
@@ -209,6 +396,18 @@ private:
 
     std::vector<data::Stream::Writer> emitters_;
 
+    //! whether items are combined on the host before the shuffle
+    bool host_combine_;
+
+    //! stream to the workers on the same host for combining
+    data::CatStreamPtr combine_stream_;
+
+    //! writers of combine_stream_ to other hosts, which remain empty
+    std::vector<data::Stream::Writer> combine_remote_writers_;
+
+    //! writers of combine_stream_ to the workers on this host
+    std::vector<data::Stream::Writer> combine_writers_;
+
     //! handle to additional thread for post stage
     std::thread thread_;
 
@@ -216,13 +415,317 @@ private:
         ValueType, Key, Value, KeyExtractor, ReduceFunction, VolatileKey,
         ReduceConfig> pre_stage_;
 
+    //! second pre stage combining the items of all workers on a host
+    core::ReducePreStage<
+        ValueType, Key, Value, KeyExtractor, ReduceFunction, VolatileKey,
+        ReduceConfig> combine_stage_;
+
     core::ReduceByHashPostStage<
         ValueType, Key, Value, KeyExtractor, ReduceFunction, Emitter, SendPair,
         ReduceConfig> post_stage_;
 
+    //! stream of the key sketches sent along with the items, if enabled
+    data::CatStreamPtr sketch_stream_;
+
     bool reduced_ = false;
 };
 
+/*!
+ * A DIANode which performs a ReduceByKey operation with range-partitioned
+ * keys. The PreOp reduces the items locally in a ReducePreStage, whose only
+ * output is a local File. Splitters are then selected from regular samples of
+ * the pre-reduced keys like in the SortNode, and each item is sent to the
+ * worker whose key range contains its key. Equal keys hence meet on the same
+ * worker, where they are reduced in a post stage. The reduced items are sorted
+ * by key in runs, which are merged in PushData().
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ParentDIA,
+          typename KeyExtractor, typename ReduceFunction,
+          typename KeyCompareFunction, typename ReduceConfig>
+class RangeReduceNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+    using Value = typename common::FunctionTraits<ReduceFunction>::result_type;
+
+    //! Emitter for PostStage to collect the reduced items in sorted runs.
+    class Emitter
+    {
+    public:
+        explicit Emitter(RangeReduceNode* node) : node_(node) { }
+        void operator () (const ValueType& item) const
+        { return node_->EmitReduced(item); }
+
+    private:
+        RangeReduceNode* node_;
+    };
+
+    //! Compares items by their keys
+    class ValueComparator
+    {
+    public:
+        explicit ValueComparator(const RangeReduceNode& node) : node_(node) { }
+
+        bool operator () (const ValueType& a, const ValueType& b) const {
+            return node_.key_compare_function_(
+                node_.key_extractor_(a), node_.key_extractor_(b));
+        }
+
+    private:
+        const RangeReduceNode& node_;
+    };
+
+public:
+    RangeReduceNode(const ParentDIA& parent,
+                    const char* label,
+                    const KeyExtractor& key_extractor,
+                    const ReduceFunction& reduce_function,
+                    const KeyCompareFunction& key_compare_function,
+                    const ReduceConfig& config)
+        : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          key_extractor_(key_extractor),
+          key_compare_function_(key_compare_function),
+          pre_file_(context_.GetFile(this)),
+          pre_writers_(1),
+          pre_stage_(
+              context_, Super::id(), /* num_partitions */ 1,
+              key_extractor, reduce_function, pre_writers_, config),
+          post_stage_(
+              context_, Super::id(), key_extractor, reduce_function,
+              Emitter(this), config)
+    {
+        pre_writers_[0] = pre_file_.GetDynWriter();
+
+        auto pre_op_fn = [this](auto&& input) {
+                             PreOp(std::forward<decltype(input)>(input));
+                         };
+        // close the function stack with our pre op and register it at
+        // parent node for output
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    void StartPreOp(size_t /* id */) final {
+        pre_stage_.Initialize(DIABase::mem_limit_);
+    }
+
+    void StopPreOp(size_t /* id */) final {
+        LOG << *this << " running StopPreOp";
+        pre_stage_.FlushAll();
+        pre_stage_.CloseAll();
+    }
+
+    DIAMemUse ExecuteMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    void Execute() final {
+        MainOp();
+    }
+
+    DIAMemUse PushDataMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    void PushData(bool consume) final {
+        if (runs_.empty()) {
+            for (const ValueType& v : run_)
+                this->PushItem(v);
+            if (consume) std::vector<ValueType>().swap(run_);
+            return;
+        }
+
+        std::vector<data::File::Reader> readers;
+        readers.reserve(runs_.size());
+        for (data::File& f : runs_)
+            readers.emplace_back(f.GetReader(consume));
+
+        auto puller = core::make_multiway_merge_tree<ValueType>(
+            readers.begin(), readers.end(), ValueComparator(*this));
+
+        while (puller.HasNext())
+            this->PushItem(puller.Next());
+    }
+
+    void Dispose() final {
+        std::vector<ValueType>().swap(run_);
+        runs_.clear();
+        post_stage_.Dispose();
+    }
+
+private:
+    //! insert an item of the parent's chain into the pre stage.
+    void PreOp(const ValueType& input) {
+        pre_stage_.Insert(input);
+    }
+
+    //! insert an rvalue of the parent's chain, which is moved into the table.
+    void PreOp(ValueType&& input) {
+        pre_stage_.Insert(std::move(input));
+    }
+
+    //! key extractor function
+    KeyExtractor key_extractor_;
+
+    //! order of the keys
+    KeyCompareFunction key_compare_function_;
+
+    //! the locally pre-reduced items
+    data::File pre_file_;
+
+    //! single writer of the pre stage into pre_file_
+    std::vector<data::DynBlockWriter> pre_writers_;
+
+    core::ReducePreStage<
+        ValueType, Key, Value, KeyExtractor, ReduceFunction,
+        /* VolatileKey */ false, ReduceConfig> pre_stage_;
+
+    core::ReduceByHashPostStage<
+        ValueType, Key, Value, KeyExtractor, ReduceFunction, Emitter,
+        /* SendPair */ false, ReduceConfig> post_stage_;
+
+    //! current run of reduced items
+    std::vector<ValueType> run_;
+
+    //! maximum number of items in run_ before it is sorted into runs_
+    size_t run_limit_ = 0;
+
+    //! sorted runs of reduced items if they exceeded run_limit_
+    std::vector<data::File> runs_;
+
+    //! epsilon
+    static constexpr double desired_imbalance_ = 0.25;
+
+    //! calculate desired number of samples of the local_items
+    size_t wanted_sample_size(size_t local_items) const {
+        if (local_items == 0) return 0;
+        size_t s = static_cast<size_t>(
+            std::log2(local_items * context_.num_workers())
+            * (1.0 / (desired_imbalance_ * desired_imbalance_)));
+        return std::min(local_items, std::max(s, size_t(1)));
+    }
+
+    //! collect reduced items, and sort and write them as a run if run_ is full
+    void EmitReduced(const ValueType& item) {
+        run_.push_back(item);
+        if (run_.size() >= run_limit_) SortAndWriteRun();
+    }
+
+    void SortAndWriteRun() {
+        std::sort(run_.begin(), run_.end(), ValueComparator(*this));
+
+        runs_.emplace_back(context_.GetFile(this));
+        data::File::Writer w = runs_.back().GetWriter();
+        for (const ValueType& v : run_) w.Put(v);
+        w.Close();
+        run_.clear();
+    }
+
+    //! select the splitters from samples of all workers on worker 0 and
+    //! deliver them to all workers.
+    std::vector<Key> FindSplitters() {
+        const size_t num_workers = context_.num_workers();
+        const size_t local_items = pre_file_.num_items();
+
+        // draw keys at regular positions
+        size_t pick_items = wanted_sample_size(local_items);
+        std::vector<size_t> indices(pick_items);
+        for (size_t i = 0; i < pick_items; ++i)
+            indices[i] = ((2 * i + 1) * local_items) / (2 * pick_items);
+
+        data::CatStreamPtr sample_stream = context_.GetNewCatStream(this);
+        {
+            std::vector<data::CatStream::Writer> writers =
+                sample_stream->GetWriters();
+            for (const ValueType& v : pre_file_.GetItemsAt<ValueType>(indices))
+                writers[0].Put(key_extractor_(v));
+        }
+
+        data::CatStreamPtr splitter_stream = context_.GetNewCatStream(this);
+        {
+            std::vector<data::CatStream::Writer> writers =
+                splitter_stream->GetWriters();
+
+            if (context_.my_rank() == 0) {
+                std::vector<Key> samples;
+                auto reader = sample_stream->GetCatReader(/* consume */ true);
+                while (reader.HasNext())
+                    samples.push_back(reader.template Next<Key>());
+
+                std::sort(samples.begin(), samples.end(),
+                          key_compare_function_);
+
+                if (!samples.empty()) {
+                    for (size_t i = 1; i < num_workers; ++i) {
+                        const Key& s = samples[i * samples.size() / num_workers];
+                        for (data::CatStream::Writer& w : writers) w.Put(s);
+                    }
+                }
+            }
+        }
+        sample_stream->Close();
+
+        std::vector<Key> splitters;
+        auto reader = splitter_stream->GetCatReader(/* consume */ true);
+        while (reader.HasNext())
+            splitters.push_back(reader.template Next<Key>());
+        splitter_stream->Close();
+
+        assert(splitters.empty() || splitters.size() == num_workers - 1);
+        return splitters;
+    }
+
+    void MainOp() {
+        std::vector<Key> splitters = FindSplitters();
+
+        // send each item to the worker whose key range contains its key
+        data::MixStreamPtr stream = context_.GetNewMixStream(this);
+        {
+            std::vector<data::MixStream::Writer> writers = stream->GetWriters();
+            auto reader = pre_file_.GetConsumeReader();
+            while (reader.HasNext()) {
+                ValueType v = reader.template Next<ValueType>();
+                size_t b = std::upper_bound(
+                    splitters.begin(), splitters.end(),
+                    key_extractor_(v), key_compare_function_)
+                           - splitters.begin();
+                writers[b].Put(v);
+            }
+        }
+
+        // reduce the received items, and collect them in sorted runs
+        post_stage_.Initialize(DIABase::mem_limit_ / 2);
+        run_limit_ = std::max<size_t>(
+            DIABase::mem_limit_ / 2 / sizeof(ValueType), 1);
+
+        auto reader = stream->GetMixReader(/* consume */ true);
+        while (reader.HasNext())
+            post_stage_.Insert(reader.template Next<ValueType>());
+        stream->Close();
+
+        post_stage_.PushData(/* consume */ true);
+        post_stage_.Dispose();
+
+        if (runs_.empty())
+            std::sort(run_.begin(), run_.end(), ValueComparator(*this));
+        else if (!run_.empty())
+            SortAndWriteRun();
+
+        LOG << "RangeReduce: splitters " << splitters.size()
+            << " sorted runs " << runs_.size();
+    }
+};
+
 template <typename ValueType, typename Stack>
 template <typename KeyExtractor, typename ReduceFunction, typename ReduceConfig>
 auto DIA<ValueType, Stack>::ReduceByKey(
@@ -319,6 +822,57 @@ auto DIA<ValueType, Stack>::ReduceByKey(
     return DIA<DOpResult>(node);
 }
 
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename ReduceFunction,
+          typename KeyCompareFunction, typename ReduceConfig>
+auto DIA<ValueType, Stack>::ReduceByKey(
+    struct RangePartitionTag,
+    const KeyExtractor &key_extractor,
+    const ReduceFunction &reduce_function,
+    const KeyCompareFunction &key_compare_function,
+    const ReduceConfig &reduce_config) const {
+    assert(IsValid());
+
+    using DOpResult
+              = typename common::FunctionTraits<ReduceFunction>::result_type;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<ReduceFunction>::template arg<0>
+            >::value,
+        "ReduceFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<ReduceFunction>::template arg<1>
+            >::value,
+        "ReduceFunction has the wrong input type");
+
+    static_assert(
+        std::is_same<
+            DOpResult,
+            ValueType>::value,
+        "ReduceFunction has the wrong output type");
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>
+                                ::template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    using RangeReduceNode = api::RangeReduceNode<
+              DOpResult, DIA, KeyExtractor, ReduceFunction,
+              KeyCompareFunction, ReduceConfig>;
+    auto node = common::MakeCounting<RangeReduceNode>(
+        *this, "ReduceByKey", key_extractor, reduce_function,
+        key_compare_function, reduce_config);
+
+    return DIA<DOpResult>(node);
+}
+
 template <typename ValueType, typename Stack>
 template <typename ReduceFunction, typename ReduceConfig>
 auto DIA<ValueType, Stack>::ReducePair(
@@ -20,11 +20,13 @@
 #include <thrill/api/dop_node.hpp>
 #include <thrill/common/functional.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
 #include <thrill/common/meta.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/core/reduce_by_index_post_stage.hpp>
 #include <thrill/core/reduce_pre_stage.hpp>
 
+#include <cassert>
 #include <functional>
 #include <thread>
 #include <type_traits>
@@ -35,7 +37,19 @@ namespace thrill {
 namespace api {
 
 class DefaultReduceToIndexConfig : public core::DefaultReduceConfig
-{ };
+{
+public:
+    //! if the result array of size * sizeof(ValueType) bytes is at most this
+    //! large, each worker pre-reduces into a plain array over the whole index
+    //! range instead of the pre stage table, and sends contiguous segments of
+    //! it without keys to the workers. Since each worker holds the whole
+    //! array, this should stay well below the memory of the stage. Zero
+    //! disables the dense array.
+    size_t dense_array_max_bytes_ = 0;
+
+    //! Returns dense_array_max_bytes_
+    size_t dense_array_max_bytes() const { return dense_array_max_bytes_; }
+};
 
 /*!
  * A DIANode which performs a ReduceToIndex operation. ReduceToIndex groups the
@@ -46,6 +60,11 @@ class DefaultReduceToIndexConfig : public core::DefaultReduceConfig
  * the result type of the reduce_function. The key type is an unsigned integer
  * and the output DIA will have element with key K at index K.
  *
+ * If the result array fits into config.dense_array_max_bytes(), the pre and
+ * post stage tables are replaced by plain arrays: each worker reduces into an
+ * array over all indexes, and sends the segment of each worker as a sequence
+ * of (bool present, [Value]) in index order over a CatStream.
+ *
  * \tparam ParentType Input type of the Reduce operation
  * \tparam ValueType Output type of the Reduce operation
  * \tparam ParentStack Function stack, which contains the chained lambdas between the last and this DIANode.
@@ -104,13 +123,18 @@ public:
                       const Value& neutral_element,
                       const ReduceConfig& config)
         : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
-          mix_stream_(use_mix_stream_ ?
+          dense_(config.dense_array_max_bytes() != 0 &&
+                 result_size <= config.dense_array_max_bytes() / sizeof(Value)),
+          mix_stream_(use_mix_stream_ && !dense_ ?
                       parent.ctx().GetNewMixStream(this) : nullptr),
-          cat_stream_(use_mix_stream_ ?
+          cat_stream_(use_mix_stream_ && !dense_ ?
                       nullptr : parent.ctx().GetNewCatStream(this)),
-          emitters_(use_mix_stream_ ?
+          emitters_(mix_stream_ ?
                     mix_stream_->GetWriters() : cat_stream_->GetWriters()),
           result_size_(result_size),
+          key_extractor_(key_extractor),
+          reduce_function_(reduce_function),
+          neutral_element_(neutral_element),
           pre_stage_(
               context_, Super::id(), context_.num_workers(),
               key_extractor, reduce_function, emitters_,
@@ -124,6 +148,7 @@ public:
         // reduce each bucket to a single value, afterwards send data to another
         // worker given by the shuffle algorithm.
         auto pre_op_fn = [this](const ValueType& input) {
+                             if (dense_) return InsertDense(input);
                              return pre_stage_.Insert(input);
                          };
 
@@ -131,6 +156,11 @@ public:
         // node for output
         auto lop_chain = parent.stack().push(pre_op_fn).fold();
         parent.node()->AddChild(this, lop_chain);
+
+        if (config.schedule_exchange()) {
+            mix_stream_ ? mix_stream_->ScheduleExchange()
+            : cat_stream_->ScheduleExchange();
+        }
     }
 
     DIAMemUse PreOpMemUse() final {
@@ -140,7 +170,12 @@ public:
     }
 
     void StartPreOp(size_t /* id */) final {
-        if (!use_post_thread_) {
+        if (dense_) {
+            LOG << *this << " using dense array of " << result_size_ << " items";
+            dense_values_.resize(result_size_, neutral_element_);
+            dense_present_.resize(result_size_, false);
+        }
+        else if (!use_post_thread_) {
             // use pre_stage without extra thread
             pre_stage_.Initialize(DIABase::mem_limit_);
 
@@ -167,12 +202,17 @@ public:
 
     void StopPreOp(size_t /* id */) final {
         LOG << *this << " running StopPreOp";
-        // Flush hash table before the postOp
-        pre_stage_.FlushAll();
-        pre_stage_.CloseAll();
-        // waiting for the additional thread to finish the reduce
-        if (use_post_thread_) thread_.join();
-        use_mix_stream_ ? mix_stream_->Close() : cat_stream_->Close();
+        if (dense_) {
+            SendDense();
+        }
+        else {
+            // Flush hash table before the postOp
+            pre_stage_.FlushAll();
+            pre_stage_.CloseAll();
+            // waiting for the additional thread to finish the reduce
+            if (use_post_thread_) thread_.join();
+        }
+        mix_stream_ ? mix_stream_->Close() : cat_stream_->Close();
     }
 
     void Execute() final { }
@@ -183,6 +223,18 @@ public:
 
     void PushData(bool consume) final {
 
+        if (dense_) {
+            if (!reduced_) {
+                ReceiveDense();
+                reduced_ = true;
+            }
+            for (size_t i = 0; i < dense_values_.size(); ++i)
+                this->PushItem(dense_present_[i]
+                               ? dense_values_[i] : neutral_element_);
+            if (consume) DisposeDense();
+            return;
+        }
+
         if (!use_post_thread_ && !reduced_) {
             // not final reduced, and no additional thread, perform post reduce
             post_stage_.Initialize(DIABase::mem_limit_);
@@ -216,10 +268,81 @@ public:
     }
 
     void Dispose() final {
-        post_stage_.Dispose();
+        if (dense_)
+            DisposeDense();
+        else
+            post_stage_.Dispose();
     }
 
 private:
+    //! reduce an item into the dense array
+    void InsertDense(const ValueType& input) {
+        Key key = key_extractor_(input);
+        assert(key < result_size_ && "Item out of range.");
+        if (dense_present_[key]) {
+            dense_values_[key] = reduce_function_(dense_values_[key], input);
+        }
+        else {
+            dense_values_[key] = input;
+            dense_present_[key] = true;
+        }
+    }
+
+    //! index range of the result on the given worker in dense mode
+    common::Range DenseRange(size_t worker) const {
+        return common::CalculateLocalRange(
+            result_size_, context_.num_workers(), worker);
+    }
+
+    //! send the segment of each worker from the dense array, then free it
+    void SendDense() {
+        for (size_t w = 0; w < emitters_.size(); ++w) {
+            common::Range range = DenseRange(w);
+            data::Stream::Writer& writer = emitters_[w];
+            for (size_t i = range.begin; i < range.end; ++i) {
+                writer.Put(static_cast<bool>(dense_present_[i]));
+                if (dense_present_[i]) writer.Put(dense_values_[i]);
+            }
+            writer.Close();
+        }
+        DisposeDense();
+    }
+
+    //! reduce the segments received from all workers into the local range
+    void ReceiveDense() {
+        common::Range range = DenseRange(context_.my_rank());
+        dense_values_.resize(range.size(), neutral_element_);
+        dense_present_.resize(range.size(), false);
+
+        // the CatReader delivers the segments of the workers one after the
+        // other, each containing exactly one flag per local index.
+        auto reader = cat_stream_->GetCatReader(/* consume */ true);
+        for (size_t w = 0; w < context_.num_workers(); ++w) {
+            for (size_t i = 0; i < range.size(); ++i) {
+                if (!reader.template Next<bool>()) continue;
+                Value v = reader.template Next<Value>();
+                if (dense_present_[i]) {
+                    dense_values_[i] = reduce_function_(dense_values_[i], v);
+                }
+                else {
+                    dense_values_[i] = std::move(v);
+                    dense_present_[i] = true;
+                }
+            }
+        }
+        assert(!reader.HasNext());
+    }
+
+    //! free the dense array
+    void DisposeDense() {
+        std::vector<Value>().swap(dense_values_);
+        std::vector<bool>().swap(dense_present_);
+    }
+
+
+    //! whether to reduce in dense arrays instead of the pre and post stage
+    bool dense_;
+
     // pointers for both Mix and CatStream. only one is used, the other costs
     // only a null pointer.
     data::MixStreamPtr mix_stream_;
@@ -229,6 +352,15 @@ private:
 
     size_t result_size_;
 
+    KeyExtractor key_extractor_;
+    ReduceFunction reduce_function_;
+    Value neutral_element_;
+
+    //! dense array: the whole range during the pre op, the local range after
+    //! receiving, and the flags of the indexes which received an item.
+    std::vector<Value> dense_values_;
+    std::vector<bool> dense_present_;
+
     //! handle to additional thread for post stage
     std::thread thread_;
 
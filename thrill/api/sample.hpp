@@ -15,14 +15,25 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dop_node.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/philox.hpp>
+#include <thrill/data/file.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
 /*!
+ * A DOpNode which selects a uniform sample of a fixed size. Each worker keeps
+ * a local reservoir using Li's Algorithm L, which draws the number of items to
+ * skip until the next replacement from a geometric distribution. If the parent
+ * delivers a complete File, only the items that enter the reservoir are
+ * deserialized, via File::GetItemsAt().
+ *
  * \ingroup api_layer
  */
 template <typename ValueType, typename ParentDIA>
@@ -56,10 +67,65 @@ public:
     void PreOp(const ValueType& input) {
         if (samples_.size() < sample_size_) {
             samples_.emplace_back(input);
+            if (samples_.size() == sample_size_) StartSkipping();
         }
-        else {
+        else if (sample_size_ > 0 && items_seen_ == next_replace_) {
             samples_[rng_() % samples_.size()] = input;
+            NextSkip();
+        }
+        ++items_seen_;
+    }
+
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!ParentDIA::stack_empty || file.delta_coding()) return false;
+
+        // determine which item of file ends in which slot of the reservoir,
+        // later replacements override earlier ones. Slots holding items from
+        // before this file keep index end.
+        const size_t begin = items_seen_, end = begin + file.num_items();
+
+        const size_t old_size = samples_.size();
+        const size_t fill = std::min(sample_size_ - old_size, file.num_items());
+        samples_.resize(old_size + fill);
+
+        std::vector<size_t> slot_index(samples_.size(), end);
+        for (size_t i = 0; i < fill; ++i)
+            slot_index[old_size + i] = begin + i;
+
+        if (fill > 0 && samples_.size() == sample_size_) {
+            items_seen_ = begin + fill - 1;
+            StartSkipping();
+        }
+        if (sample_size_ > 0 && samples_.size() == sample_size_) {
+            // jump over the items which do not enter the reservoir
+            while (next_replace_ < end) {
+                slot_index[rng_() % samples_.size()] = next_replace_;
+                NextSkip();
+            }
+        }
+        items_seen_ = end;
+
+        // fetch the selected items in file order
+        std::vector<std::pair<size_t, size_t> > slots;
+        for (size_t i = 0; i < slot_index.size(); ++i) {
+            if (slot_index[i] < begin || slot_index[i] >= end) continue;
+            slots.emplace_back(slot_index[i] - begin, i);
         }
+        std::sort(slots.begin(), slots.end());
+
+        std::vector<size_t> indices(slots.size());
+        for (size_t i = 0; i < slots.size(); ++i)
+            indices[i] = slots[i].first;
+
+        std::vector<ValueType> items =
+            file.template GetItemsAt<ValueType>(indices);
+        for (size_t i = 0; i < slots.size(); ++i)
+            samples_[slots[i].second] = std::move(items[i]);
+
+        sLOG << "SampleNode::OnPreOpFile"
+             << "items" << file.num_items()
+             << "deserialized" << items.size();
+        return true;
     }
 
     void Execute() final {
@@ -75,7 +141,7 @@ public:
         // synchronize global random generator
         size_t seed = context_.my_rank() == 0 ? rng_() : 0;
         seed = context_.net.Broadcast(seed);
-        rng_.seed(static_cast<unsigned>(seed));
+        rng_.seed(seed);
 
         // globally select random samples among samples_
         typename std::vector<ValueType>::iterator it = samples_.begin();
@@ -124,7 +190,38 @@ private:
     std::vector<ValueType> samples_;
 
     //! Random generator for eviction
-    std::default_random_engine rng_ { std::random_device { } () };
+    common::PhiloxEngine rng_ { std::random_device { } () };
+
+    //! uniform distribution over [0,1) for skip distances
+    std::uniform_real_distribution<double> uniform_ { 0.0, 1.0 };
+
+    //! number of items processed by this worker
+    size_t items_seen_ = 0;
+
+    //! index of the next item to enter the full reservoir
+    size_t next_replace_ = 0;
+
+    //! Algorithm L's running weight W of the reservoir
+    double weight_ = 1.0;
+
+    //! draw a random number in (0,1]
+    double Uniform() { return 1.0 - uniform_(rng_); }
+
+    //! initialize Algorithm L after the first sample_size_ items filled the
+    //! reservoir, with the item at index items_seen_ being the last of them.
+    void StartSkipping() {
+        weight_ = std::exp(std::log(Uniform()) / sample_size_);
+        next_replace_ = items_seen_;
+        NextSkip();
+    }
+
+    //! draw the index of the next item to replace one in the reservoir
+    void NextSkip() {
+        double skip = std::floor(std::log(Uniform()) / std::log1p(-weight_));
+        next_replace_ += 1 + static_cast<size_t>(
+            std::min(skip, static_cast<double>(1ull << 62)));
+        weight_ *= std::exp(std::log(Uniform()) / sample_size_);
+    }
 };
 
 template <typename ValueType, typename Stack>
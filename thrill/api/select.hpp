@@ -0,0 +1,338 @@
+/*******************************************************************************
+ * thrill/api/select.hpp
+ *
+ * Exact distributed selection of the items with given ranks by rounds of
+ * sampling and filtering, promoted from examples/select.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * Copyright (C) 2016 Lorenz Hübschle-Schneider <lorenz@4z2.de>
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_SELECT_HEADER
+#define THRILL_API_SELECT_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/bernoulli_sample.hpp>
+#include <thrill/api/cache.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/gather.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/common/die.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Return the cell of an item relative to sorted distinct pivots: cell 2i + 1
+ * holds items equivalent to pivots[i], and cell 2i the items between
+ * pivots[i - 1] and pivots[i].
+ */
+template <typename ValueType, typename CompareFunction>
+static inline size_t SelectCell(
+    const std::vector<ValueType>& pivots, const ValueType& item,
+    const CompareFunction& compare_function) {
+    size_t i = static_cast<size_t>(
+        std::lower_bound(pivots.begin(), pivots.end(), item, compare_function)
+        - pivots.begin());
+    if (i < pivots.size() && !compare_function(item, pivots[i]))
+        return 2 * i + 1;
+    return 2 * i;
+}
+
+/*!
+ * Action counting the items of a DIA in each cell of a set of sorted distinct
+ * pivots, see SelectCell().
+ *
+ * \ingroup api_layer
+ */
+template <typename ParentDIA, typename CompareFunction>
+class SelectCountNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+public:
+    SelectCountNode(const ParentDIA& parent,
+                    const std::vector<ValueType>& pivots,
+                    const CompareFunction& compare_function)
+        : ActionNode(parent.ctx(), "SelectCount",
+                     { parent.id() }, { parent.node() }),
+          pivots_(pivots), compare_function_(compare_function),
+          counts_(2 * pivots.size() + 1, 0)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             ++counts_[SelectCell(
+                                           pivots_, input, compare_function_)];
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void Execute() final {
+        counts_ = context_.net.AllReduce(
+            counts_, common::ComponentSum<std::vector<size_t> >());
+    }
+
+    //! global number of items of each cell
+    const std::vector<size_t>& result() const { return counts_; }
+
+private:
+    //! sorted distinct pivots
+    std::vector<ValueType> pivots_;
+    //! comparator of the items
+    CompareFunction compare_function_;
+    //! local, then global, number of items of each cell
+    std::vector<size_t> counts_;
+};
+
+//! size up to which the items are gathered and selected on worker 0.
+static constexpr size_t select_base_case_size = 1024;
+
+//! maximum expected number of samples gathered at worker 0 in each round.
+static constexpr size_t select_max_sample_size = 1 << 18;
+
+/*!
+ * Select the items with the sorted distinct ranks of the DIA data, which has
+ * size items. A Bernoulli sample of about size^(2/3) items is gathered, and
+ * for each rank two pivots are taken around its expected position in the
+ * sample, such that the item of the rank lies between them with high
+ * probability. One pass counts the items relative to all pivots, which
+ * resolves ranks that hit a pivot, and a Filter() keeps only the union of the
+ * ranges between the pivot pairs, which contains O(size^(2/3)) items per rank,
+ * for the next round. Ranks which missed their range are selected again
+ * separately.
+ */
+template <typename ValueType, typename InStack, typename CompareFunction>
+std::vector<ValueType> SelectRanks(
+    const DIA<ValueType, InStack>& data, size_t size,
+    const std::vector<size_t>& ranks,
+    const CompareFunction& compare_function) {
+
+    static constexpr bool debug = false;
+
+    Context& ctx = data.context();
+    std::vector<ValueType> result(ranks.size());
+
+    if (size <= select_base_case_size) {
+        // base case, gather all data at worker with rank 0
+        std::vector<ValueType> elements = data.Gather();
+
+        if (ctx.my_rank() == 0) {
+            std::sort(elements.begin(), elements.end(), compare_function);
+            for (size_t i = 0; i < ranks.size(); ++i) {
+                assert(ranks[i] < elements.size());
+                result[i] = elements[ranks[i]];
+            }
+        }
+        return ctx.net.Broadcast(result);
+    }
+
+    // materialized at worker 0
+    const double size_d = static_cast<double>(size);
+    const double p = std::min(
+        1.0, std::min(std::max(std::cbrt(size_d * size_d),
+                               static_cast<double>(select_base_case_size)),
+                      static_cast<double>(select_max_sample_size)) / size_d);
+    std::vector<ValueType> sample = data.BernoulliSample(p).Gather();
+
+    // two pivots per rank, the lower pivots first
+    std::vector<ValueType> pivots;
+    if (ctx.my_rank() == 0 && !sample.empty()) {
+        std::sort(sample.begin(), sample.end(), compare_function);
+
+        const double s = static_cast<double>(sample.size());
+        const double offset = 3.0 * std::sqrt(s);
+        pivots.resize(2 * ranks.size());
+
+        for (size_t i = 0; i < ranks.size(); ++i) {
+            const double pos = static_cast<double>(ranks[i]) * s / size_d;
+            size_t lower = static_cast<size_t>(std::max(0.0, pos - offset));
+            size_t upper = static_cast<size_t>(
+                std::min(s - 1.0, std::floor(pos + offset)));
+            pivots[i] = sample[lower];
+            pivots[ranks.size() + i] = sample[upper];
+        }
+    }
+    std::vector<ValueType>().swap(sample);
+
+    pivots = ctx.net.Broadcast(pivots);
+
+    if (pivots.empty()) {
+        // the sample missed all items, gather them instead.
+        LOGC(debug && ctx.my_rank() == 0) << "empty sample, gathering";
+        std::vector<ValueType> elements = data.Gather();
+        if (ctx.my_rank() == 0) {
+            std::sort(elements.begin(), elements.end(), compare_function);
+            for (size_t i = 0; i < ranks.size(); ++i)
+                result[i] = elements[ranks[i]];
+        }
+        return ctx.net.Broadcast(result);
+    }
+
+    // sorted distinct pivots and their counts
+    std::vector<ValueType> sorted = pivots;
+    std::sort(sorted.begin(), sorted.end(), compare_function);
+    sorted.erase(
+        std::unique(sorted.begin(), sorted.end(),
+                    [&compare_function](const ValueType& a, const ValueType& b) {
+                        return !compare_function(a, b);
+                    }),
+        sorted.end());
+
+    std::vector<size_t> counts;
+    {
+        using SelectCountNode =
+                  api::SelectCountNode<DIA<ValueType, InStack>, CompareFunction>;
+        auto node = common::MakeCounting<SelectCountNode>(
+            data, sorted, compare_function);
+        node->RunScope();
+        counts = node->result();
+    }
+
+    // prefix[c] = number of items in cells before c
+    std::vector<size_t> prefix(counts.size() + 1, 0);
+    for (size_t c = 0; c < counts.size(); ++c)
+        prefix[c + 1] = prefix[c] + counts[c];
+
+    // resolve ranks hitting a pivot, and mark the cells of the other ranges.
+    std::vector<bool> covered(counts.size(), false);
+    std::vector<size_t> pending, missed;
+
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        const ValueType& left = pivots[i];
+        const ValueType& right = pivots[ranks.size() + i];
+        size_t lc = SelectCell(sorted, left, compare_function);
+        size_t rc = SelectCell(sorted, right, compare_function);
+
+        size_t left_size = prefix[lc];
+        size_t middle_end = prefix[rc + 1];
+
+        if (ranks[i] < left_size || ranks[i] >= middle_end) {
+            missed.push_back(i);
+        }
+        else if (ranks[i] < prefix[lc + 1] || lc == rc) {
+            // equivalent to the left pivot
+            result[i] = left;
+        }
+        else if (ranks[i] >= prefix[rc]) {
+            // equivalent to the right pivot
+            result[i] = right;
+        }
+        else {
+            pending.push_back(i);
+            for (size_t c = lc; c <= rc; ++c) covered[c] = true;
+        }
+    }
+
+    LOGC(debug && ctx.my_rank() == 0)
+        << "Select: size " << size << " pending " << pending.size()
+        << " missed " << missed.size();
+
+    if (!pending.empty()) {
+        // removed[c] = number of uncovered items in cells before c
+        std::vector<size_t> removed(counts.size() + 1, 0);
+        for (size_t c = 0; c < counts.size(); ++c)
+            removed[c + 1] = removed[c] + (covered[c] ? 0 : counts[c]);
+
+        std::vector<size_t> sub_ranks;
+        for (const size_t& i : pending) {
+            size_t lc = SelectCell(sorted, pivots[i], compare_function);
+            sub_ranks.push_back(ranks[i] - removed[lc]);
+        }
+
+        size_t sub_size = size - removed.back();
+
+        auto subset = data.Filter(
+            [sorted, covered, compare_function](const ValueType& item) {
+                return covered[SelectCell(sorted, item, compare_function)];
+            }).Cache();
+
+        // sub ranks are sorted and distinct, as the ranks are
+        std::vector<ValueType> sub_result =
+            SelectRanks(subset, sub_size, sub_ranks, compare_function);
+
+        for (size_t j = 0; j < pending.size(); ++j)
+            result[pending[j]] = std::move(sub_result[j]);
+    }
+
+    if (!missed.empty()) {
+        std::vector<size_t> missed_ranks;
+        for (const size_t& i : missed)
+            missed_ranks.push_back(ranks[i]);
+
+        std::vector<ValueType> missed_result =
+            SelectRanks(data, size, missed_ranks, compare_function);
+
+        for (size_t j = 0; j < missed.size(); ++j)
+            result[missed[j]] = std::move(missed_result[j]);
+    }
+
+    return result;
+}
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+ValueType DIA<ValueType, Stack>::Select(
+    size_t rank, const CompareFunction& compare_function) const {
+    return Select(std::vector<size_t>(1, rank), compare_function)[0];
+}
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+std::vector<ValueType> DIA<ValueType, Stack>::Select(
+    const std::vector<size_t>& ranks,
+    const CompareFunction& compare_function) const {
+    assert(IsValid());
+
+    const size_t size = Size();
+
+    // select sorted distinct ranks, and return them in the given order.
+    std::vector<size_t> sorted_ranks = ranks;
+    std::sort(sorted_ranks.begin(), sorted_ranks.end());
+    sorted_ranks.erase(std::unique(sorted_ranks.begin(), sorted_ranks.end()),
+                       sorted_ranks.end());
+
+    if (!sorted_ranks.empty() && sorted_ranks.back() >= size) {
+        die("DIA::Select() rank " << sorted_ranks.back()
+            << " exceeds the size " << size);
+    }
+
+    std::vector<ValueType> sorted_result =
+        SelectRanks(*this, size, sorted_ranks, compare_function);
+
+    std::vector<ValueType> result;
+    result.reserve(ranks.size());
+    for (const size_t& r : ranks) {
+        result.emplace_back(
+            sorted_result[std::lower_bound(sorted_ranks.begin(),
+                                           sorted_ranks.end(), r)
+                          - sorted_ranks.begin()]);
+    }
+    return result;
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_SELECT_HEADER
+
+/******************************************************************************/
@@ -84,6 +84,17 @@ template <typename ValueType, typename Stack>
 size_t DIA<ValueType, Stack>::Size() const {
     assert(IsValid());
 
+    // if the node's items were pushed before, their local number is known and
+    // a further PushData() is not needed.
+    if (stack_empty && node_->state() == DIAState::EXECUTED &&
+        node_->pushed_items() != size_t(-1) &&
+        !(context().consume() && node_->consume_counter() == 0))
+    {
+        size_t local_size = node_->pushed_items();
+        node_->ConsumeWithoutPush();
+        return context().net.AllReduce(local_size);
+    }
+
     using SizeNode = api::SizeNode<DIA>;
 
     auto node = common::MakeCounting<SizeNode>(*this);
@@ -17,24 +17,273 @@
 #include <thrill/api/context.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dop_node.hpp>
+#include <thrill/common/cgroup.hpp>
+#include <thrill/common/functional.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/meta.hpp>
+#include <thrill/common/philox.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/parallel_sort.hpp>
+#include <thrill/core/radix_sort.hpp>
+#include <thrill/core/segmented_iterator.hpp>
+#include <thrill/core/string_sort.hpp>
 #include <thrill/data/file.hpp>
 #include <thrill/net/group.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <deque>
 #include <functional>
+#include <future>
 #include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
+/*!
+ * Default local run sorting algorithm of DIA::Sort(): plain std::sort, which is
+ * run by the worker thread itself.
+ */
+class DefaultSortAlgorithm
+{
+public:
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end, CompareFunction cmp) const {
+        return std::sort(begin, end, cmp);
+    }
+};
+
+/*!
+ * Default local run sorting algorithm of DIA::SortStable(): std::stable_sort.
+ */
+class DefaultStableSortAlgorithm
+{
+public:
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end, CompareFunction cmp) const {
+        return std::stable_sort(begin, end, cmp);
+    }
+};
+
+/*!
+ * Parallel local run sorting algorithm for DIA::Sort(): parallel mergesort
+ * using a team of num_threads threads, which is created by the worker during
+ * run formation. Use this if there are more cores per host than workers.
+ */
+class ParallelSortAlgorithm
+{
+public:
+    //! construct with num_threads threads per worker, 0 = the worker's share
+    //! of the host's cores. The temporary merge buffers of all threads are
+    //! limited to merge_buffer_bytes.
+    explicit ParallelSortAlgorithm(
+        size_t num_threads = 0,
+        size_t merge_buffer_bytes = core::default_merge_buffer_bytes)
+        : requested_threads_(num_threads),
+          num_threads_(num_threads != 0 ? num_threads :
+                       common::AvailableCpuCount()),
+          merge_buffer_bytes_(merge_buffer_bytes) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end, CompareFunction cmp) const {
+        return core::parallel_sort(
+            begin, end, cmp, num_threads_, merge_buffer_bytes_);
+    }
+
+    //! divide the host's cores among its workers, unless the number of
+    //! threads was given explicitly. Called by the SortNode.
+    void SetWorkersPerHost(size_t workers_per_host) {
+        if (requested_threads_ != 0) return;
+        num_threads_ = std::max<size_t>(
+            1, common::AvailableCpuCount() / workers_per_host);
+    }
+
+    //! number of threads used to sort one run
+    size_t num_threads() const { return num_threads_; }
+
+private:
+    //! number of threads given by the user, 0 = share of the host's cores
+    size_t requested_threads_;
+
+    //! number of threads used to sort one run
+    size_t num_threads_;
+
+    //! total size of the temporary merge buffers
+    size_t merge_buffer_bytes_;
+};
+
+//! adapt a local run sorting algorithm to the worker's Context, which is a
+//! no-op for most algorithms.
+template <typename SortAlgorithm>
+void SetupSortAlgorithm(SortAlgorithm& /* sort_algorithm */,
+                        Context& /* ctx */) { }
+
+//! a ParallelSortAlgorithm uses the worker's share of the host's cores.
+static inline
+void SetupSortAlgorithm(ParallelSortAlgorithm& sort_algorithm, Context& ctx) {
+    sort_algorithm.SetWorkersPerHost(ctx.workers_per_host());
+}
+
+/*!
+ * Local run sorting algorithm for DIA::Sort(RadixSortTag, ...): in-place MSD
+ * radix sort on the unsigned integer or byte array key returned by the key
+ * extractor. The compare function is ignored; it must be consistent with the
+ * key order, which is guaranteed by RadixKeyCompare.
+ */
+template <typename KeyExtractor>
+class RadixSortAlgorithm
+{
+public:
+    explicit RadixSortAlgorithm(const KeyExtractor& key_extractor)
+        : key_extractor_(key_extractor) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end, CompareFunction) const {
+        return core::radix_sort_msd(begin, end, key_extractor_);
+    }
+
+private:
+    //! key extractor returning the radix key
+    KeyExtractor key_extractor_;
+};
+
+/*!
+ * Local run sorting algorithm for strings: multikey quicksort, which compares
+ * characters of common prefixes once per level instead of comparing full
+ * strings. The compare function is ignored; it must be the lexicographic order
+ * of unsigned characters, std::less<std::string>, which also selects the
+ * LCP-aware merge of the runs.
+ */
+class StringSortAlgorithm
+{
+public:
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end, CompareFunction) const {
+        return core::multikey_quicksort(begin, end);
+    }
+};
+
+/*!
+ * Compare function ordering items by the key returned by a key extractor. Used
+ * by DIA::Sort(RadixSortTag, ...) for splitter classification and merging.
+ */
+template <typename KeyExtractor>
+class RadixKeyCompare
+{
+public:
+    explicit RadixKeyCompare(const KeyExtractor& key_extractor)
+        : key_extractor_(key_extractor) { }
+
+    template <typename ValueType>
+    bool operator () (const ValueType& a, const ValueType& b) const {
+        return key_extractor_(a) < key_extractor_(b);
+    }
+
+private:
+    //! key extractor returning the radix key
+    KeyExtractor key_extractor_;
+};
+
+/*!
+ * Compare function ordering pairs of a cached key and an item by the key. Used
+ * by DIA::Sort(CachedKeyTag, ...).
+ */
+template <typename Key, typename ValueType, typename KeyCompareFunction>
+class CachedKeyCompare
+{
+public:
+    explicit CachedKeyCompare(const KeyCompareFunction& key_compare_function)
+        : key_compare_function_(key_compare_function) { }
+
+    bool operator () (const std::pair<Key, ValueType>& a,
+                      const std::pair<Key, ValueType>& b) const {
+        return key_compare_function_(a.first, b.first);
+    }
+
+private:
+    //! compare function of the keys
+    KeyCompareFunction key_compare_function_;
+};
+
+//! sampling methods for splitter selection in SortNode
+enum class SortSampling {
+    //! randomized reservoir sampling during the PreOp
+    RESERVOIR,
+    //! systematic sampling of items at evenly spaced positions of the unsorted
+    //! local data. The samples are deterministic, but as the data is not
+    //! sorted, the bucket sizes are bounded only in expectation, as for
+    //! random sampling; this is not the regular sampling of PSRS.
+    REGULAR
+};
+
+/*!
+ * Configuration class to define operational parameters of the SortNode.
+ */
+class DefaultSortConfig
+{
+public:
+    //! sampling method used to select the splitters
+    SortSampling sampling_ = SortSampling::RESERVOIR;
+
+    //! factor by which the number of samples drawn by each worker is increased
+    //! over the default, which is based on the desired imbalance.
+    double oversampling_factor_ = 1.0;
+
+    //! delta encode and Varint pack sorted runs of integral items, or front
+    //! code sorted runs of std::string by their LCP with the previous string,
+    //! which shrinks Files spilled to disk.
+    bool delta_coding_ = false;
+
+    //! sort runs of POD items in-place inside the received ByteBlocks instead
+    //! of copying them into a vector, which doubles the run length of
+    //! unstable sorts. Stable sorts need a temporary buffer of the run's size,
+    //! hence their runs keep half the memory limit.
+    bool block_sort_ = true;
+
+    //! number of threads used to merge sorted runs in PushData(), which split
+    //! the runs into disjoint parts and merge them in parallel. This requires
+    //! seeking in the runs, hence, it is not used with delta_coding_.
+    size_t merge_threads_ = 1;
+
+    //! send the items to other hosts in pairwise phases after they are
+    //! partitioned, instead of to all hosts at once. This avoids incast in
+    //! large clusters, but holds back all items until they are partitioned.
+    bool schedule_exchange_ = false;
+
+    //! sort and write full runs of the vector receive path in a background
+    //! thread, while the next run is received into a second buffer. Each
+    //! buffer then takes a quarter of the memory limit instead of half, as
+    //! sorting may need a buffer of the same size.
+    bool overlap_run_formation_ = false;
+
+    //! with at least this many workers, exchange the items in two levels over
+    //! groups of about sqrt(p) workers: first to the same position in the
+    //! target's group, which then forwards them inside the group. Each worker
+    //! thus writes to only 2 sqrt(p) others, which keeps the Blocks large.
+    //! Stable sorting always uses a single level.
+    size_t multi_level_workers_ = 1024;
+
+    //! count the ascending runs of the input during the PreOp. If the runs of
+    //! all workers together are in order and balanced, the sample exchange and
+    //! the shuffle are skipped, and each worker only merges its local runs.
+    //! This costs a compare per item, an extra AllReduce and a copy of the
+    //! last item, hence, it is only worthwhile if the input is often sorted.
+    bool detect_presorted_ = false;
+
+    //! maximum number of ascending runs per worker which are merged locally as
+    //! presorted input. Counting stops once a worker has more runs.
+    size_t presorted_max_runs_ = 16;
+};
+
 /*!
  * A DIANode which performs a Sort operation. Sort sorts a DIA according to a
  * given compare function
@@ -46,9 +295,18 @@ namespace api {
  *
  * \tparam CompareFunction Type of the compare function
  *
+ * \tparam SortAlgorithm Type of the local run sorting algorithm
+ *
+ * \tparam SortConfig Type of the configuration class
+ *
+ * \tparam Stable whether to sort stably, this keeps the input order of equal
+ * items across all workers.
+ *
  * \ingroup api_layer
  */
-template <typename ValueType, typename ParentDIA, typename CompareFunction>
+template <typename ValueType, typename ParentDIA, typename CompareFunction,
+          typename SortAlgorithm, typename SortConfig = DefaultSortConfig,
+          bool Stable = false>
 class SortNode final : public DOpNode<ValueType>
 {
     static constexpr bool debug = false;
@@ -56,15 +314,32 @@ class SortNode final : public DOpNode<ValueType>
     using Super = DOpNode<ValueType>;
     using Super::context_;
 
+    //! stable sorting requires the items to be received in order of the
+    //! senders, hence use a CatStream instead of a MixStream.
+    using DataStream = typename common::If<
+              Stable, data::CatStream, data::MixStream>::type;
+    using DataStreamPtr = common::CountingPtr<DataStream>;
+
+    using MergeTree = core::SortMultiwayMergeTree<
+              ValueType,
+              typename std::vector<data::File::ConsumeReader>::iterator,
+              CompareFunction, Stable>;
+
 public:
     /*!
      * Constructor for a sort node.
      */
     SortNode(const ParentDIA& parent,
-             CompareFunction compare_function)
+             const CompareFunction& compare_function,
+             const SortAlgorithm& sort_algorithm,
+             const SortConfig& sort_config = SortConfig())
         : Super(parent.ctx(), "Sort", { parent.id() }, { parent.node() }),
-          compare_function_(compare_function)
+          compare_function_(compare_function),
+          sort_algorithm_(sort_algorithm),
+          config_(sort_config)
     {
+        SetupSortAlgorithm(sort_algorithm_, context_);
+
         // Hook PreOp(s)
         auto pre_op_fn = [this](const ValueType& input) {
                              PreOp(input);
@@ -81,6 +356,9 @@ public:
     void PreOp(const ValueType& input) {
         unsorted_writer_.Put(input);
         local_items_++;
+        if (config_.detect_presorted_) CountRun(input);
+        // regular sampling picks samples after the local size is known.
+        if (config_.sampling_ == SortSampling::REGULAR) return;
         // In this stage we do not know how many elements are there in total.
         // Therefore we draw samples based on current number of elements and
         // randomly replace older samples when we have too many.
@@ -106,15 +384,29 @@ public:
         unsorted_file_ = file.Copy();
         local_items_ = unsorted_file_.num_items();
 
+        if (config_.detect_presorted_) {
+            auto reader = unsorted_file_.GetKeepReader();
+            while (reader.HasNext() &&
+                   local_runs_ <= config_.presorted_max_runs_)
+                CountRun(reader.template Next<ValueType>());
+        }
+
+        // regular sampling picks samples after the local size is known.
+        if (config_.sampling_ == SortSampling::REGULAR) return true;
+
         size_t pick_items = std::min(local_items_, wanted_sample_size());
 
         sLOG << "Pick" << pick_items << "samples by random access"
              << " from File containing " << local_items_ << " items.";
+        std::vector<size_t> indices(pick_items);
         for (size_t i = 0; i < pick_items; ++i) {
-            size_t index = rng_() % local_items_;
-            sLOG << "got index[" << i << "] = " << index;
-            samples_.emplace_back(unsorted_file_.GetItemAt<ValueType>(index));
+            indices[i] = rng_() % local_items_;
+            sLOG << "got index[" << i << "] = " << indices[i];
         }
+        // read the samples in ascending order, pinning each Block once.
+        std::sort(indices.begin(), indices.end());
+        for (ValueType& v : unsorted_file_.GetItemsAt<ValueType>(indices))
+            samples_.emplace_back(std::move(v));
 
         return true;
     }
@@ -141,15 +433,32 @@ public:
             return 0;
         }
         else {
-            // need to perform multiway merging
-            return DIAMemUse::Max();
+            // need to perform multiway merging, which cannot use more than one
+            // read Block plus 16 prefetched Blocks per File.
+            return DIAMemUse::Max(
+                files_.size() * 17 * data::default_block_size);
         }
     }
 
+    void PrefetchData() final {
+        // the merge starts with the first Blocks of all sorted runs.
+        for (data::File& file : files_)
+            file.Prefetch(2);
+    }
+
+    size_t PushDataBytes() final {
+        size_t bytes = 0;
+        for (const data::File& file : files_)
+            bytes += file.size_bytes();
+        return bytes;
+    }
+
     //! calculate maximum merging degree from available memory and the number of
     //! files. additionally calculate the prefetch size of each File.
     std::pair<size_t, size_t> MaxMergeDegreePrefetch() {
-        size_t avail_blocks = DIABase::mem_limit_ / data::default_block_size;
+        // parallel merging threads each read one Block of every File
+        size_t avail_blocks = std::max<size_t>(
+            2, DIABase::mem_limit_ / data::default_block_size / MergeThreads());
         if (files_.size() >= avail_blocks) {
             // more files than blocks available -> partial merge of avail_blocks
             // Files with prefetch = 0, which is one read Block per File.
@@ -168,43 +477,72 @@ public:
         if (files_.size() == 0) {
             // nothing to push
         }
-        else if (files_.size() == 1) {
+        else if (files_.size() == 1 && !files_[0].delta_coding()) {
             this->PushFile(files_[0], consume);
         }
+        else if (files_.size() == 1) {
+            // delta encoded Files cannot be handed to children directly
+            data::File::Reader reader = files_[0].GetReader(consume);
+            while (reader.HasNext()) {
+                this->PushItem(reader.template Next<ValueType>());
+            }
+        }
         else {
             size_t merge_degree, prefetch;
 
+            // number of Files remaining from the current round of partial
+            // merges, which must be merged in order to keep the run order.
+            size_t round_left = 0;
+
             // merge batches of files if necessary
             while (files_.size() > MaxMergeDegreePrefetch().first)
             {
                 std::tie(merge_degree, prefetch) = MaxMergeDegreePrefetch();
 
+                if (round_left == 0) round_left = files_.size();
+                merge_degree = std::min(merge_degree, round_left);
+                round_left -= merge_degree;
+
+                if (merge_degree == 1) {
+                    // move single remaining File of round to the back
+                    files_.emplace_back(std::move(files_.front()));
+                    files_.pop_front();
+                    continue;
+                }
+
                 sLOG1 << "Partial multi-way-merge of"
                       << merge_degree << "files with prefetch" << prefetch;
 
-                // create merger for first merge_degree_ Files
-                std::vector<data::File::ConsumeReader> seq;
-                seq.reserve(merge_degree);
-
-                for (size_t t = 0; t < merge_degree; ++t)
-                    seq.emplace_back(files_[t].GetConsumeReader(0));
+                // create new File for merged items
+                data::File merged = context_.GetFile(this);
+                merged.set_delta_coding(UseDeltaCoding());
+                merged.set_striped(true);
+
+                if (MergeThreads() > 1) {
+                    core::parallel_multiway_merge_files<ValueType, Stable>(
+                        files_.begin(), files_.begin() + merge_degree, merged,
+                        compare_function_, MergeThreads(), prefetch);
+                }
+                else {
+                    // create merger for first merge_degree_ Files
+                    std::vector<data::File::ConsumeReader> seq;
+                    seq.reserve(merge_degree);
 
-                StartPrefetch(seq, prefetch);
+                    for (size_t t = 0; t < merge_degree; ++t)
+                        seq.emplace_back(files_[t].GetConsumeReader(0));
 
-                auto puller = core::make_multiway_merge_tree<ValueType>(
-                    seq.begin(), seq.end(), compare_function_);
+                    StartPrefetch(seq, prefetch);
 
-                // create new File for merged items
-                files_.emplace_back(context_.GetFile(this));
-                auto writer = files_.back().GetWriter();
+                    MergeTree puller(seq.begin(), seq.end(), compare_function_);
 
-                while (puller.HasNext()) {
-                    writer.Put(puller.Next());
+                    auto writer = merged.GetWriter();
+                    while (puller.HasNext()) {
+                        writer.Put(puller.Next());
+                    }
+                    writer.Close();
                 }
-                writer.Close();
 
-                // this clear is important to release references to the files.
-                seq.clear();
+                files_.emplace_back(std::move(merged));
 
                 // remove merged files
                 files_.erase(files_.begin(), files_.begin() + merge_degree);
@@ -215,6 +553,18 @@ public:
             sLOG1 << "Start multi-way-merge of" << files_.size() << "files"
                   << "with prefetch" << prefetch;
 
+            if (MergeThreads() > 1) {
+                // merge in parallel into a File, then push it as a whole
+                data::File merged = context_.GetFile(this);
+                core::parallel_multiway_merge_files<ValueType, Stable>(
+                    files_.begin(), files_.end(), merged,
+                    compare_function_, MergeThreads(), prefetch);
+                files_.clear();
+
+                this->PushFile(merged, /* consume */ true);
+                return;
+            }
+
             // construct output merger of remaining Files
             std::vector<data::File::ConsumeReader> seq;
             seq.reserve(files_.size());
@@ -224,8 +574,7 @@ public:
 
             StartPrefetch(seq, prefetch);
 
-            auto puller = core::make_multiway_merge_tree<ValueType>(
-                seq.begin(), seq.end(), compare_function_);
+            MergeTree puller(seq.begin(), seq.end(), compare_function_);
 
             while (puller.HasNext()) {
                 this->PushItem(puller.Next());
@@ -237,6 +586,12 @@ private:
     //! The comparison function which is applied to two elements.
     CompareFunction compare_function_;
 
+    //! Sort algorithm used to sort the local runs.
+    SortAlgorithm sort_algorithm_;
+
+    //! Configuration of the sorting node
+    SortConfig config_;
+
     //! \name PreOp Phase
     //! \{
 
@@ -252,7 +607,7 @@ private:
     //! Number of items to process before the next sample was drawn
     size_t sample_interval_ = 1;
     //! Random generator
-    std::default_random_engine rng_ { std::random_device { } () };
+    common::PhiloxEngine rng_ { std::random_device { } () };
 
     //! epsilon
     static constexpr double desired_imbalance_ = 0.3;
@@ -261,26 +616,83 @@ private:
     size_t wanted_sample_size() const {
         size_t s = static_cast<size_t>(
             std::log2(local_items_ * context_.num_workers())
-            * (1.0 / (desired_imbalance_ * desired_imbalance_)));
+            * (1.0 / (desired_imbalance_ * desired_imbalance_))
+            * config_.oversampling_factor_);
         return std::max(s, size_t(1));
     }
 
+    //! draw samples at evenly spaced positions of the complete, unsorted local
+    //! data: exactly one sample from the middle of each equally sized interval.
+    //! This avoids the random number generator and the reservoir, but gives
+    //! no deterministic bound on the bucket sizes.
+    void PickRegularSamples() {
+        size_t pick_items = std::min(local_items_, wanted_sample_size());
+
+        sLOG << "Pick" << pick_items << "regular samples by random access"
+             << " from File containing " << local_items_ << " items.";
+
+        std::vector<size_t> indices(pick_items);
+        for (size_t i = 0; i < pick_items; ++i) {
+            // pick the item in the middle of the i-th interval
+            indices[i] = ((2 * i + 1) * local_items_) / (2 * pick_items);
+        }
+
+        samples_.reserve(pick_items);
+        for (ValueType& v : unsorted_file_.GetItemsAt<ValueType>(indices))
+            samples_.emplace_back(std::move(v));
+    }
+
+    //! Number of ascending runs in the local items, counted up to one more
+    //! than presorted_max_runs_.
+    size_t local_runs_ = 0;
+    //! Smallest and largest local item, and the previous item of the PreOp
+    ValueType local_min_ = ValueType(), local_max_ = ValueType(),
+              last_item_ = ValueType();
+
+    //! count the ascending runs and the range of the local items.
+    void CountRun(const ValueType& input) {
+        if (local_runs_ > config_.presorted_max_runs_) return;
+        if (local_runs_ == 0) {
+            local_min_ = local_max_ = input;
+            local_runs_ = 1;
+        }
+        else if (compare_function_(input, last_item_)) {
+            // a new run starts, which may contain a new minimum.
+            if (++local_runs_ > config_.presorted_max_runs_) return;
+            if (compare_function_(input, local_min_)) local_min_ = input;
+        }
+        else if (compare_function_(local_max_, input)) {
+            local_max_ = input;
+        }
+        last_item_ = input;
+    }
+
     //! \}
 
     //! Local data files
     std::deque<data::File> files_;
     //! Total number of local elements after communication
     size_t local_out_size_ = 0;
+    //! Number of local elements sent to each worker
+    std::vector<size_t> sent_items_;
+
+    //! memory pressure flag set by the BlockPool, writes runs early
+    data::MemoryPressure pressure_ { context_.block_pool() };
+
+    //! allocator for temporary vectors of samples and splitters in MainOp()
+    mem::StageArenaAllocator<ValueType> arena_allocator() {
+        return mem::StageArenaAllocator<ValueType>(context_.stage_arena());
+    }
 
     void FindAndSendSplitters(
-        std::vector<ValueType>& splitters, size_t sample_size,
+        mem::arena_vector<ValueType>& splitters, size_t sample_size,
         data::MixStreamPtr& sample_stream,
         std::vector<data::MixStream::Writer>& sample_writers) {
 
         // Get samples from other workers
         size_t num_total_workers = context_.num_workers();
 
-        std::vector<ValueType> samples;
+        mem::arena_vector<ValueType> samples { arena_allocator() };
         samples.reserve(sample_size * num_total_workers);
 
         auto reader = sample_stream->GetMixReader(/* consume */ true);
@@ -291,7 +703,7 @@ private:
         if (samples.size() == 0) return;
 
         // Find splitters
-        std::sort(samples.begin(), samples.end(), compare_function_);
+        sort_algorithm_(samples.begin(), samples.end(), compare_function_);
 
         size_t splitting_size = samples.size() / num_total_workers;
 
@@ -308,6 +720,9 @@ private:
         }
     }
 
+    //! Builds the splitter tree in implicit (Eytzinger) layout: the root is
+    //! at index 1 and the children of node j at 2j and 2j + 1, hence the
+    //! descent needs no pointers and the top levels share cache lines.
     class TreeBuilder
     {
     public:
@@ -351,12 +766,53 @@ private:
         return !(compare_function_(ele1, ele2) || compare_function_(ele2, ele1));
     }
 
-    //! round n down by k where k is a power of two.
-    template <typename Integral>
-    static inline size_t RoundDown(Integral n, Integral k) {
-        return (n & ~(k - 1));
+    /*!
+     * Calculate the equality bucket structure of the sorted splitters: for
+     * each splitter i, equal_begin[i] is the index of the first splitter in
+     * the run of splitters equal to splitter i.
+     */
+    std::vector<size_t> CalcEqualBegin(
+        const ValueType* const sorted_splitters, size_t num_splitters) {
+
+        std::vector<size_t> equal_begin(num_splitters);
+        for (size_t i = 0; i < num_splitters; ++i) {
+            equal_begin[i] =
+                (i != 0 && Equal(sorted_splitters[i - 1], sorted_splitters[i]))
+                ? equal_begin[i - 1] : i;
+        }
+        return equal_begin;
+    }
+
+    /*!
+     * Determine the target worker of an item, given the bucket b found by
+     * descending the splitter tree. Items equal to a run of splitters
+     * s_lo..s_hi may be sent to any of the workers lo..hi+1 without breaking
+     * the global order, hence they are distributed round-robin over these
+     * equality buckets instead of all landing on worker hi+1.
+     */
+    size_t EqualBucket(
+        const ValueType& el, size_t b,
+        const ValueType* const sorted_splitters,
+        const std::vector<size_t>& equal_begin,
+        std::vector<size_t>& equal_counter,
+        size_t global_index, size_t total_items) {
+
+        if (b == 0 || !Equal(el, sorted_splitters[b - 1]))
+            return b;
+
+        // item equals the run of splitters [lo, b-1], spread it over the
+        // workers lo..b.
+        size_t lo = equal_begin[b - 1];
+
+        if (Stable) {
+            // assign monotonically by global input position to keep order
+            return lo + global_index * (b - lo + 1) / total_items;
+        }
+
+        return lo + (equal_counter[b - 1]++ % (b - lo + 1));
     }
 
+    template <typename TargetWorker>
     void TransmitItems(
         // Tree of splitters, sizeof |splitter|
         const ValueType* const tree,
@@ -368,110 +824,173 @@ private:
         const ValueType* const sorted_splitters,
         size_t prefix_items,
         size_t total_items,
-        data::MixStreamPtr& data_stream) {
+        DataStreamPtr& data_stream,
+        // maps the bucket of an item to the worker it is sent to
+        const TargetWorker& target_worker) {
 
         data::File::ConsumeReader unsorted_reader =
             unsorted_file_.GetConsumeReader();
 
-        std::vector<data::MixStream::Writer> data_writers =
+        std::vector<data::Stream::Writer> data_writers =
             data_stream->GetWriters();
 
-        // enlarge emitters array to next power of two to have direct access,
-        // because we fill the splitter set up with sentinels == last splitter,
-        // hence all items land in the last bucket.
+        // the splitter set is filled up with sentinels == last splitter, hence
+        // all items larger or equal to the last real splitter land in bucket
+        // k-1, which is clamped to the last actual worker.
         assert(data_writers.size() == actual_k);
         assert(actual_k <= k);
 
-        while (data_writers.size() < k)
-            data_writers.emplace_back(nullptr);
+        const size_t num_splitters = actual_k - 1;
 
-        std::swap(data_writers[actual_k - 1], data_writers[k - 1]);
+        // equality bucket structure of the real splitters. The counters start
+        // at different offsets on each worker, such that equal items of all
+        // workers are spread evenly.
+        std::vector<size_t> equal_begin;
+        if (local_items_ != 0)
+            equal_begin = CalcEqualBegin(sorted_splitters, num_splitters);
+        std::vector<size_t> equal_counter(num_splitters, context_.my_rank());
 
-        // classify all items (take two at once) and immediately transmit them.
+        // count items sent into each bucket for statistics
+        std::vector<size_t> bucket_size(actual_k, 0);
 
-        const size_t stepsize = 2;
+        // classify the items in batches, and write each batch to the target
+        // BlockWriters in a second pass using the oracle of buckets.
+        std::vector<ValueType> batch;
+        batch.reserve(classify_batch_size);
+        size_t oracle[classify_batch_size];
 
-        size_t i = 0;
-        for ( ; i < RoundDown(local_items_, stepsize); i += stepsize)
-        {
-            // take two items
-            size_t j0 = 1;
-            ValueType el0 = unsorted_reader.Next<ValueType>();
+        for (size_t i = 0; i < local_items_; ) {
+            size_t n = std::min(local_items_ - i, size_t(classify_batch_size));
 
-            size_t j1 = 1;
-            ValueType el1 = unsorted_reader.Next<ValueType>();
+            batch.clear();
+            for (size_t t = 0; t < n; ++t)
+                batch.emplace_back(unsorted_reader.Next<ValueType>());
 
-            // run items down the tree
-            for (size_t l = 0; l < log_k; l++)
-            {
-                j0 = 2 * j0 + (compare_function_(el0, tree[j0]) ? 0 : 1);
-                j1 = 2 * j1 + (compare_function_(el1, tree[j1]) ? 0 : 1);
+            ClassifyBatch(batch.data(), n, tree, k, log_k, num_splitters,
+                          oracle);
+
+            for (size_t t = 0; t < n; ++t) {
+                size_t b = EqualBucket(batch[t], oracle[t], sorted_splitters,
+                                       equal_begin, equal_counter,
+                                       prefix_items + i + t, total_items);
+                b = target_worker(b);
+
+                assert(data_writers[b].IsValid());
+                data_writers[b].Put(batch[t]);
+                ++bucket_size[b];
             }
+            i += n;
+        }
 
-            size_t b0 = j0 - k;
-            size_t b1 = j1 - k;
+        // close writers and flush data
+        for (size_t j = 0; j < data_writers.size(); j++)
+            data_writers[j].Close();
 
-            if (b0 && Equal(el0, sorted_splitters[b0 - 1])) {
-                while (b0 && Equal(el0, sorted_splitters[b0 - 1]) &&
-                       (prefix_items + i) * actual_k < b0 * total_items) {
-                    b0--;
-                }
+        // save number of items sent to workers
+        sent_items_.swap(bucket_size);
+    }
 
-                if (b0 + 1 >= actual_k) {
-                    b0 = k - 1;
-                }
+    //! number of items classified together by ClassifyBatch()
+    static constexpr size_t classify_batch_size = 16;
+
+    /*!
+     * Run n items down the splitter tree together and store their buckets,
+     * clamped to the number of real splitters, in oracle. The descent is
+     * branch-free, and the tree is traversed level by level for all items,
+     * such that the comparisons of different items are independent and
+     * overlap in the CPU pipeline instead of waiting on each other's loads.
+     */
+    void ClassifyBatch(const ValueType* items, size_t n,
+                       const ValueType* const tree,
+                       size_t k, size_t log_k, size_t num_splitters,
+                       size_t* oracle) {
+        for (size_t t = 0; t < n; ++t)
+            oracle[t] = 1;
+        for (size_t l = 0; l < log_k; l++) {
+            for (size_t t = 0; t < n; ++t) {
+                oracle[t] = 2 * oracle[t] + static_cast<size_t>(
+                    !compare_function_(items[t], tree[oracle[t]]));
             }
+        }
+        for (size_t t = 0; t < n; ++t)
+            oracle[t] = std::min(oracle[t] - k, num_splitters);
+    }
 
-            if (b1 && Equal(el1, sorted_splitters[b1 - 1])) {
-                while (b1 && Equal(el1, sorted_splitters[b1 - 1]) &&
-                       (prefix_items + i + 1) * actual_k < b1 * total_items) {
-                    b1--;
-                }
+    //! number of workers in a group of the two-level exchange, or zero if the
+    //! items are sent directly.
+    size_t ExchangeGroupSize() const {
+        size_t p = context_.num_workers();
+        if (Stable || p < 2 || p < config_.multi_level_workers_) return 0;
+        size_t r = static_cast<size_t>(std::sqrt(static_cast<double>(p)));
+        while (r * r < p) ++r;
+        return r;
+    }
 
-                if (b1 + 1 >= actual_k) {
-                    b1 = k - 1;
-                }
-            }
+    /*!
+     * Second level of the two-level exchange: classify all items received by
+     * the group_stream again and forward them to the worker inside this
+     * worker's group of size r which owns their bucket. Equal items may pick
+     * a different equality bucket than in the first level, which is then
+     * clamped into the group, hence the global order is kept.
+     */
+    void ForwardItems(
+        const ValueType* const tree, size_t k, size_t log_k, size_t actual_k,
+        const ValueType* const sorted_splitters, size_t r,
+        DataStreamPtr& group_stream, DataStreamPtr& data_stream) {
 
-            assert(data_writers[b0].IsValid());
-            assert(data_writers[b1].IsValid());
+        auto reader = group_stream->GetReader(/* consume */ true);
 
-            data_writers[b0].Put(el0);
-            data_writers[b1].Put(el1);
-        }
+        std::vector<data::Stream::Writer> data_writers =
+            data_stream->GetWriters();
 
-        // last iteration of loop if we have an odd number of items.
-        for ( ; i < local_items_; i++)
-        {
-            size_t j0 = 1;
-            ValueType el0 = unsorted_reader.Next<ValueType>();
+        const size_t num_splitters = actual_k - 1;
+        const size_t group_begin = context_.my_rank() / r * r;
+        const size_t group_last = std::min(group_begin + r, actual_k) - 1;
 
-            // run item down the tree
-            for (size_t l = 0; l < log_k; l++)
-            {
-                j0 = 2 * j0 + (compare_function_(el0, tree[j0]) ? 0 : 1);
-            }
+        // there are no splitters if no worker has items
+        std::vector<size_t> equal_begin;
+        if (reader.HasNext())
+            equal_begin = CalcEqualBegin(sorted_splitters, num_splitters);
+        std::vector<size_t> equal_counter(num_splitters, context_.my_rank());
 
-            size_t b0 = j0 - k;
+        std::vector<ValueType> batch;
+        batch.reserve(classify_batch_size);
+        size_t oracle[classify_batch_size];
 
-            while (b0 && Equal(el0, sorted_splitters[b0 - 1])
-                   && (prefix_items + i) * actual_k < b0 * total_items) {
-                b0--;
-            }
+        while (reader.HasNext()) {
+            batch.clear();
+            while (batch.size() < classify_batch_size && reader.HasNext())
+                batch.emplace_back(reader.template Next<ValueType>());
 
-            if (b0 + 1 >= actual_k) {
-                b0 = k - 1;
-            }
+            ClassifyBatch(batch.data(), batch.size(), tree, k, log_k,
+                          num_splitters, oracle);
 
-            assert(data_writers[b0].IsValid());
-            data_writers[b0].Put(el0);
+            for (size_t t = 0; t < batch.size(); ++t) {
+                size_t b = EqualBucket(batch[t], oracle[t], sorted_splitters,
+                                       equal_begin, equal_counter, 0, 0);
+                b = std::min(std::max(b, group_begin), group_last);
+
+                data_writers[b].Put(batch[t]);
+            }
         }
 
-        // close writers and flush data
         for (size_t j = 0; j < data_writers.size(); j++)
             data_writers[j].Close();
     }
 
+    //! whether to delta encode the sorted run Files
+    bool UseDeltaCoding() const {
+        return (std::is_integral<ValueType>::value ||
+                std::is_same<ValueType, std::string>::value) &&
+               config_.delta_coding_;
+    }
+
+    //! number of threads for merging runs, parallel merging seeks in the runs,
+    //! which works only without delta encoding.
+    size_t MergeThreads() const {
+        return UseDeltaCoding() ? 1 : std::max<size_t>(1, config_.merge_threads_);
+    }
+
     void SortAndWriteToFile(
         std::vector<ValueType>& vec, std::deque<data::File>& files) {
 
@@ -485,7 +1004,7 @@ private:
         context_.block_pool().AdviseFree(vec.size() * sizeof(ValueType));
 
         common::StatsTimerStart sort_time;
-        std::sort(vec.begin(), vec.end(), compare_function_);
+        sort_algorithm_(vec.begin(), vec.end(), compare_function_);
         sort_time.Stop();
 
         LOG << "SortAndWriteToFile() sort took " << time;
@@ -493,10 +1012,12 @@ private:
         common::StatsTimerStart write_time;
 
         files.emplace_back(context_.GetFile(this));
+        files.back().set_delta_coding(UseDeltaCoding());
+        // runs are read again by the merge, in parallel with the other runs
+        files.back().set_eviction_hint(data::EvictionHint::ReadAgainSoon);
+        files.back().set_striped(true);
         auto writer = files.back().GetWriter();
-        for (const ValueType& elem : vec) {
-            writer.Put(elem);
-        }
+        writer.PutMany(vec);
         writer.Close();
 
         write_time.Stop();
@@ -516,14 +1037,100 @@ private:
             << "write_time" << write_time;
     }
 
+    /*!
+     * Check collectively whether the runs of all workers are in order, such
+     * that the items need not be exchanged, and keep the local runs as Files
+     * then. The ranges are combined in rank order as (state, max runs, max
+     * items, total items, min, max), with state 0 for no items, 1 for ordered,
+     * and 2 for unordered. Falls back to the shuffle if one worker would hold
+     * more items than the desired imbalance allows.
+     */
+    bool UsePresorted() {
+        using Range = std::tuple<
+            size_t, size_t, size_t, size_t, ValueType, ValueType>;
+
+        size_t state = local_items_ == 0 ? 0 :
+                       local_runs_ > config_.presorted_max_runs_ ? 2 : 1;
+
+        Range range = context_.net.AllReduce(
+            Range(state, local_runs_, local_items_, local_items_,
+                  local_min_, local_max_),
+            [this](const Range& a, const Range& b) {
+                size_t sa = std::get<0>(a), sb = std::get<0>(b);
+                return Range(
+                    sa == 0 ? sb : sb == 0 ? sa :
+                    (sa == 2 || sb == 2 ||
+                     compare_function_(std::get<4>(b), std::get<5>(a))) ? 2 : 1,
+                    std::max(std::get<1>(a), std::get<1>(b)),
+                    std::max(std::get<2>(a), std::get<2>(b)),
+                    std::get<3>(a) + std::get<3>(b),
+                    sa == 0 ? std::get<4>(b) : std::get<4>(a),
+                    sb == 0 ? std::get<5>(a) : std::get<5>(b));
+            });
+
+        if (std::get<0>(range) == 2) return false;
+
+        size_t total_items = std::get<3>(range);
+        if (static_cast<double>(std::get<2>(range) * context_.num_workers()) >
+            (1.0 + desired_imbalance_) * static_cast<double>(total_items) + 1.0)
+            return false;
+
+        std::vector<ValueType>().swap(samples_);
+        local_out_size_ = local_items_;
+
+        if (local_runs_ == 1) {
+            files_.emplace_back(std::move(unsorted_file_));
+        }
+        else if (local_runs_ > 1) {
+            // split the items into one File per run, which PushData() merges.
+            auto reader = unsorted_file_.GetConsumeReader();
+            data::File::Writer writer;
+            ValueType last = ValueType();
+            while (reader.HasNext()) {
+                ValueType item = reader.template Next<ValueType>();
+                if (files_.empty() || compare_function_(item, last)) {
+                    if (!files_.empty()) writer.Close();
+                    files_.emplace_back(context_.GetFile(this));
+                    files_.back().set_delta_coding(UseDeltaCoding());
+                    files_.back().set_striped(true);
+                    writer = files_.back().GetWriter();
+                }
+                writer.Put(item);
+                last = std::move(item);
+            }
+            writer.Close();
+        }
+
+        Super::logger_
+            << "class" << "SortNode"
+            << "event" << "presorted"
+            << "local_runs" << local_runs_
+            << "max_runs" << std::get<1>(range)
+            << "total_items" << total_items;
+
+        return true;
+    }
+
     void MainOp() {
-        size_t prefix_items = context_.net.ExPrefixSum(local_items_);
-        size_t total_items = context_.net.AllReduce(local_items_);
+        if (config_.detect_presorted_ && UsePresorted()) return;
+
+        // the global position of items is only needed for stable sorting. Both
+        // counts are calculated in the background during the sample exchange.
+        std::future<size_t> prefix_items_future;
+        if (Stable)
+            prefix_items_future = context_.net.ExPrefixSumAsync(local_items_);
+        std::future<size_t> total_items_future =
+            context_.net.AllReduceAsync(local_items_);
 
         size_t num_total_workers = context_.num_workers();
 
+        if (config_.sampling_ == SortSampling::REGULAR)
+            PickRegularSamples();
+
+        size_t sample_size = samples_.size();
+
         LOG << "Local sample size on worker " << context_.my_rank() <<
-            ": " << samples_.size();
+            ": " << sample_size;
         LOG << "Number of local items: " << local_items_;
 
         // stream to send samples to process 0 and receive them back
@@ -544,11 +1151,11 @@ private:
         size_t workers_algo = size_t(1) << ceil_log;
         size_t splitter_count_algo = workers_algo - 1;
 
-        std::vector<ValueType> splitters;
+        mem::arena_vector<ValueType> splitters { arena_allocator() };
         splitters.reserve(workers_algo);
 
         if (context_.my_rank() == 0) {
-            FindAndSendSplitters(splitters, samples_.size(),
+            FindAndSendSplitters(splitters, sample_size,
                                  sample_stream, sample_writers);
         }
         else {
@@ -567,7 +1174,8 @@ private:
 
         // code from SS2NPartition, slightly altered
 
-        std::vector<ValueType> splitter_tree(workers_algo + 1);
+        mem::arena_vector<ValueType> splitter_tree(
+            workers_algo + 1, ValueType(), arena_allocator());
 
         // add sentinel splitters if fewer nodes than splitters.
         for (size_t i = num_total_workers; i < workers_algo; i++) {
@@ -578,7 +1186,13 @@ private:
                     splitters.data(),
                     splitter_count_algo);
 
-        data::MixStreamPtr data_stream = context_.GetNewMixStream(this);
+        size_t prefix_items = Stable ? prefix_items_future.get() : 0;
+        size_t total_items = total_items_future.get();
+
+        DataStreamPtr data_stream =
+            context_.template GetNewStream<DataStream>(this->id());
+        if (config_.schedule_exchange_)
+            data_stream->ScheduleExchange();
 
         // launch receiver thread.
         std::thread thread = common::CreateThread(
@@ -586,17 +1200,58 @@ private:
                 return ReceiveItems(data_stream);
             });
 
-        TransmitItems(
-            splitter_tree.data(), // Tree. sizeof |splitter|
-            workers_algo,         // Number of buckets
-            ceil_log,
-            num_total_workers,
-            splitters.data(),
-            prefix_items,
-            total_items,
-            data_stream);
+        const size_t r = ExchangeGroupSize();
+
+        if (r == 0) {
+            TransmitItems(
+                splitter_tree.data(), // Tree. sizeof |splitter|
+                workers_algo,         // Number of buckets
+                ceil_log,
+                num_total_workers,
+                splitters.data(),
+                prefix_items,
+                total_items,
+                data_stream,
+                [](size_t b) { return b; });
+        }
+        else {
+            sLOG << "SortNode: two-level exchange with groups of" << r
+                 << "workers";
+
+            // first level: send items to the worker in the target's group
+            // with the same position as this worker in its group.
+            DataStreamPtr group_stream =
+                context_.template GetNewStream<DataStream>(this->id());
+            if (config_.schedule_exchange_)
+                group_stream->ScheduleExchange();
+
+            // second level: forward received items inside the group.
+            std::thread forward_thread = common::CreateThread(
+                [&]() {
+                    return ForwardItems(
+                        splitter_tree.data(), workers_algo, ceil_log,
+                        num_total_workers, splitters.data(), r,
+                        group_stream, data_stream);
+                });
+
+            const size_t my_pos = context_.my_rank() % r;
+
+            TransmitItems(
+                splitter_tree.data(), workers_algo, ceil_log,
+                num_total_workers, splitters.data(),
+                prefix_items, total_items, group_stream,
+                [r, my_pos, num_total_workers](size_t b) {
+                    size_t group_begin = b / r * r;
+                    size_t group_size =
+                        std::min(r, num_total_workers - group_begin);
+                    return group_begin + my_pos % group_size;
+                });
+
+            forward_thread.join();
+            group_stream->Close();
+        }
 
-        std::vector<ValueType>().swap(splitter_tree);
+        mem::arena_vector<ValueType>(arena_allocator()).swap(splitter_tree);
 
         thread.join();
 
@@ -613,46 +1268,185 @@ private:
             balance = 1 / balance;
         }
 
+        // maximum bucket size determines the imbalance of all workers
+        size_t max_out_size = context_.net.AllReduce(
+            local_out_size_, common::maximum<size_t>());
+
+        double imbalance = 0;
+        if (total_items > 0) {
+            imbalance = static_cast<double>(max_out_size)
+                        * static_cast<double>(num_total_workers)
+                        / static_cast<double>(total_items);
+        }
+
         Super::logger_
             << "class" << "SortNode"
             << "event" << "done"
             << "workers" << num_total_workers
             << "local_out_size" << local_out_size_
+            << "max_out_size" << max_out_size
             << "balance" << balance
-            << "sample_size" << samples_.size();
+            << "imbalance" << imbalance
+            << "sent_items" << sent_items_
+            << "sampling" << (config_.sampling_ == SortSampling::REGULAR
+                              ? "regular" : "reservoir")
+            << "sample_size" << sample_size;
     }
 
-    void ReceiveItems(data::MixStreamPtr& data_stream) {
+    //! whether to sort runs in-place inside ByteBlocks
+    bool UseBlockSort() const {
+        return std::is_pod<ValueType>::value &&
+               !std::is_pointer<ValueType>::value &&
+               config_.block_sort_ && !UseDeltaCoding();
+    }
+
+    //! Sort a run of items stored as arrays in ByteBlocks in-place and hand
+    //! the ByteBlocks to a new File.
+    void SortAndWriteBlocks(std::vector<data::PinnedByteBlockPtr>& blocks,
+                            size_t size, size_t block_items) {
+
+        LOG << "SortAndWriteBlocks() " << size
+            << " items into file #" << files_.size();
+
+        local_out_size_ += size;
+
+        std::vector<ValueType*> segments;
+        segments.reserve(blocks.size());
+        for (data::PinnedByteBlockPtr& b : blocks)
+            segments.push_back(reinterpret_cast<ValueType*>(b->data()));
+
+        using Iterator = core::SegmentedIterator<ValueType>;
+
+        common::StatsTimerStart sort_time;
+        sort_algorithm_(Iterator(segments.data(), block_items, 0),
+                        Iterator(segments.data(), block_items, size),
+                        compare_function_);
+        sort_time.Stop();
+
+        LOG << "SortAndWriteBlocks() sort took " << sort_time;
+
+        files_.emplace_back(context_.GetFile(this));
+        files_.back().set_eviction_hint(data::EvictionHint::ReadAgainSoon);
+        files_.back().set_striped(true);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            size_t n = std::min(block_items, size - i * block_items);
+            files_.back().AppendPinnedBlock(
+                data::PinnedBlock(std::move(blocks[i]), 0, n * sizeof(ValueType),
+                                  0, n, /* typecode_verify */ false));
+        }
+        blocks.clear();
+    }
 
-        auto reader = data_stream->GetMixReader(/* consume */ true);
+    //! receive items directly into ByteBlocks and sort them there.
+    void ReceiveItemsInBlocks(DataStreamPtr& data_stream) {
+
+        auto reader = data_stream->GetReader(/* consume */ true);
+
+        // the ByteBlocks of the runs are allocated from the BlockPool, hence
+        // hand this stage's memory reservation over to them while receiving.
+        data::BlockPool& block_pool = context_.block_pool();
+        block_pool.ReleaseInternalMemory(DIABase::mem_limit_, this->id());
+
+        // no copy is needed for sorting or writing, hence a run may fill the
+        // whole memory limit. A stable sort however allocates a buffer as
+        // large as the run, hence its runs take only half.
+        const size_t block_items = data::default_block_size / sizeof(ValueType);
+        const size_t capacity = std::max(
+            block_items,
+            DIABase::mem_limit_ / sizeof(ValueType) / (Stable ? 2 : 1));
+
+        std::vector<data::PinnedByteBlockPtr> blocks;
+        size_t size = 0;
+
+        while (reader.HasNext()) {
+            if (size % block_items == 0) {
+                if (size >= capacity ||
+                    (size != 0 &&
+                     (mem::memory_exceeded || pressure_.requested()))) {
+                    pressure_.Take();
+                    SortAndWriteBlocks(blocks, size, block_items);
+                    size = 0;
+                }
+                blocks.emplace_back(
+                    block_pool.AllocateByteBlock(
+                        data::default_block_size, context_.local_worker_id()));
+            }
+
+            ValueType* array = reinterpret_cast<ValueType*>(blocks.back()->data());
+            size += reader.NextMany(array + size % block_items,
+                                    block_items - size % block_items);
+        }
+
+        if (size)
+            SortAndWriteBlocks(blocks, size, block_items);
+
+        block_pool.RequestInternalMemory(DIABase::mem_limit_, this->id());
+    }
+
+    void ReceiveItems(DataStreamPtr& data_stream) {
+
+        if (UseBlockSort())
+            return ReceiveItemsInBlocks(data_stream);
+
+        auto reader = data_stream->GetReader(/* consume */ true);
 
         LOG << "Writing files";
 
-        // M/2 such that the other half is used to prepare the next bulk
-        size_t capacity = DIABase::mem_limit_ / sizeof(ValueType) / 2;
+        // M/2 such that the other half is used to prepare the next bulk, or
+        // M/4 per buffer if two runs are held while overlapping.
+        size_t capacity = DIABase::mem_limit_ / sizeof(ValueType) /
+                          (config_.overlap_run_formation_ ? 4 : 2);
         std::vector<ValueType> temp_data;
         temp_data.reserve(capacity);
 
+        // run which is sorted and written by the sorter thread
+        std::vector<ValueType> sort_data;
+        std::thread sorter;
+
+        auto write_run = [&]() {
+            if (!config_.overlap_run_formation_)
+                return SortAndWriteToFile(temp_data, files_);
+
+            // wait for the previous run, then swap buffers and continue
+            // receiving while the full one is sorted.
+            if (sorter.joinable()) sorter.join();
+            sort_data.swap(temp_data);
+            temp_data.reserve(capacity);
+            sorter = common::CreateThread(
+                [this, &sort_data]() {
+                    SortAndWriteToFile(sort_data, files_);
+                });
+        };
+
         while (reader.HasNext()) {
-            if (!mem::memory_exceeded && temp_data.size() < capacity) {
+            if (temp_data.empty() ||
+                (!mem::memory_exceeded && temp_data.size() < capacity &&
+                 (!pressure_.requested() || temp_data.size() < capacity / 16))) {
                 temp_data.push_back(reader.template Next<ValueType>());
             }
             else {
-                SortAndWriteToFile(temp_data, files_);
+                pressure_.Take();
+                write_run();
             }
         }
 
         if (temp_data.size())
-            SortAndWriteToFile(temp_data, files_);
+            write_run();
+        if (sorter.joinable())
+            sorter.join();
     }
 };
 
 template <typename ValueType, typename Stack>
-template <typename CompareFunction>
-auto DIA<ValueType, Stack>::Sort(const CompareFunction &compare_function) const {
+template <typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig>
+auto DIA<ValueType, Stack>::Sort(const CompareFunction &compare_function,
+                                 const SortAlgorithm &sort_algorithm,
+                                 const SortConfig &sort_config) const {
     assert(IsValid());
 
-    using SortNode = api::SortNode<ValueType, DIA, CompareFunction>;
+    using SortNode = api::SortNode<
+              ValueType, DIA, CompareFunction, SortAlgorithm, SortConfig>;
 
     static_assert(
         std::is_convertible<
@@ -675,11 +1469,117 @@ auto DIA<ValueType, Stack>::Sort(const CompareFunction &compare_function) const
             bool>::value,
         "CompareFunction has the wrong output type (should be bool)");
 
-    auto node = common::MakeCounting<SortNode>(*this, compare_function);
+    auto node = common::MakeCounting<SortNode>(
+        *this, compare_function, sort_algorithm, sort_config);
 
     return DIA<ValueType>(node);
 }
 
+template <typename ValueType, typename Stack>
+template <typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig>
+auto DIA<ValueType, Stack>::SortStable(
+    const CompareFunction &compare_function,
+    const SortAlgorithm &sort_algorithm,
+    const SortConfig &sort_config) const {
+    assert(IsValid());
+
+    using SortNode = api::SortNode<
+              ValueType, DIA, CompareFunction, SortAlgorithm, SortConfig,
+              /* Stable */ true>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0>
+            >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<CompareFunction>::result_type,
+            bool>::value,
+        "CompareFunction has the wrong output type (should be bool)");
+
+    auto node = common::MakeCounting<SortNode>(
+        *this, compare_function, sort_algorithm, sort_config);
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor>
+auto DIA<ValueType, Stack>::Sort(struct RadixSortTag,
+                                 const KeyExtractor &key_extractor) const {
+    assert(IsValid());
+
+    using Key = typename std::decay<
+              typename FunctionTraits<KeyExtractor>::result_type>::type;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0>
+            >::value,
+        "KeyExtractor has the wrong input type");
+
+    static_assert(
+        core::RadixKeyTraits<Key>::enabled,
+        "KeyExtractor must return an unsigned integer or std::array<uint8_t>");
+
+    using CompareFunction = RadixKeyCompare<KeyExtractor>;
+    using SortAlgorithm = RadixSortAlgorithm<KeyExtractor>;
+
+    using SortNode = api::SortNode<
+              ValueType, DIA, CompareFunction, SortAlgorithm>;
+
+    auto node = common::MakeCounting<SortNode>(
+        *this, CompareFunction(key_extractor), SortAlgorithm(key_extractor));
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename KeyCompareFunction,
+          typename SortConfig>
+auto DIA<ValueType, Stack>::Sort(struct CachedKeyTag,
+                                 const KeyExtractor &key_extractor,
+                                 const KeyCompareFunction &key_compare_function,
+                                 const SortConfig &sort_config) const {
+    assert(IsValid());
+
+    using Key = typename std::decay<
+              typename FunctionTraits<KeyExtractor>::result_type>::type;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0>
+            >::value,
+        "KeyExtractor has the wrong input type");
+
+    using KeyValuePair = std::pair<Key, ValueType>;
+    using CompareFunction =
+              CachedKeyCompare<Key, ValueType, KeyCompareFunction>;
+
+    // decorate the items with their keys in the PreOp, sort the pairs, and
+    // strip the keys again in the following LOp.
+    return Map([key_extractor](const ValueType& v) {
+                   return KeyValuePair(key_extractor(v), v);
+               })
+           .Sort(CompareFunction(key_compare_function),
+                 DefaultSortAlgorithm(), sort_config)
+           .Map([](const KeyValuePair& p) { return p.second; });
+}
+
 } // namespace api
 } // namespace thrill
 
@@ -0,0 +1,590 @@
+/*******************************************************************************
+ * thrill/api/sort_merge_join.hpp
+ *
+ * DIANode for a sort-merge join of two DIAs which are sorted by their keys.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_SORT_MERGE_JOIN_HEADER
+#define THRILL_API_SORT_MERGE_JOIN_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/core/multiway_merge.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which performs an inner join of two DIAs whose items are sorted by
+ * key on each worker, e.g. the output of Sort(), Merge(), or a sorted
+ * ReduceByKey. Unlike InnerJoin, the order is not thrown away by hashing:
+ *
+ * - In Execute, p - 1 splitter keys are selected, which split the items of
+ *   both inputs into p ranges of about equal size. The search is the
+ *   multi-sequence selection of MergeNode: each round picks kNumPivots pivot
+ *   keys in the largest remaining search range of each splitter, ranks them in
+ *   both local Files, and shrinks the ranges by their global ranks. All items
+ *   of one key stay in one range, hence the ranges may be unbalanced by
+ *   heavy keys.
+ *
+ * - Both Files are scattered by the splitters. If the inputs are already
+ *   globally sorted, most items stay on their worker and only the data at the
+ *   range boundaries is sent.
+ *
+ * - In PushData, the sorted runs received from each worker are merged and the
+ *   two inputs are joined in one streaming pass. Only the items of the first
+ *   input with the current key are held, and large groups are stored in a
+ *   data::File, which the BlockPool may evict.
+ *
+ * The output is ordered by key, worker r holds the r-th key range.
+ *
+ * \tparam ValueType Output type of the join, the result of the JoinFunction.
+ *
+ * \tparam FirstDIA Type of the first input DIA.
+ *
+ * \tparam SecondDIA Type of the second input DIA.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename KeyComparator>
+class SortMergeJoinNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+    static constexpr bool self_verify = debug && common::g_debug_mode;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using InputTypeFirst = typename FirstDIA::ValueType;
+    using InputTypeSecond = typename SecondDIA::ValueType;
+
+    using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
+
+    //! Number of pivots per splitter selected and ranked in each search round.
+    static constexpr size_t kNumPivots = 8;
+
+    //! Number of items of a group of equal keys of the first input kept in
+    //! RAM, the rest is stored in a File.
+    static constexpr size_t kMaxGroupItems = 4096;
+
+    //! search range bounds or ranks of a splitter in both inputs
+    using ArraySizeT = std::array<size_t, 2>;
+
+    //! a pivot key, and the length of the search range it was picked from
+    using Pivot = std::pair<Key, size_t>;
+
+public:
+    SortMergeJoinNode(const FirstDIA& parent1, const SecondDIA& parent2,
+                      const KeyExtractor1& key_extractor1,
+                      const KeyExtractor2& key_extractor2,
+                      const JoinFunction& join_function,
+                      const KeyComparator& key_comparator)
+        : Super(parent1.ctx(), "SortMergeJoin",
+                { parent1.id(), parent2.id() },
+                { parent1.node(), parent2.node() }),
+          key_extractor1_(key_extractor1),
+          key_extractor2_(key_extractor2),
+          join_function_(join_function),
+          key_comparator_(key_comparator),
+          file1_(context_.GetFile(this)),
+          file2_(context_.GetFile(this))
+    {
+        auto pre_op1_fn = [this](const InputTypeFirst& input) {
+                              writer1_.Put(input);
+                          };
+        auto pre_op2_fn = [this](const InputTypeSecond& input) {
+                              writer2_.Put(input);
+                          };
+
+        // close the function stacks with our pre ops and register it at
+        // parent nodes for output
+        auto lop_chain1 = parent1.stack().push(pre_op1_fn).fold();
+        auto lop_chain2 = parent2.stack().push(pre_op2_fn).fold();
+        parent1.node()->AddChild(this, lop_chain1, 0);
+        parent2.node()->AddChild(this, lop_chain2, 1);
+    }
+
+    void StartPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            writer1_ = file1_.GetWriter();
+        else
+            writer2_ = file2_.GetWriter();
+    }
+
+    //! Receive a whole data::File of ValueType, but only if our stack is empty.
+    bool OnPreOpFile(const data::File& file, size_t parent_index) final {
+        if (parent_index == 0) {
+            if (!FirstDIA::stack_empty) return false;
+            file1_ = file.Copy();
+        }
+        else {
+            if (!SecondDIA::stack_empty) return false;
+            file2_ = file.Copy();
+        }
+        return true;
+    }
+
+    void StopPreOp(size_t parent_index) final {
+        LOG << *this << " StopPreOp() parent_index=" << parent_index;
+        if (parent_index == 0)
+            writer1_.Close();
+        else
+            writer2_.Close();
+    }
+
+    void Execute() final {
+        if (self_verify) {
+            VerifySorted<InputTypeFirst>(file1_, key_extractor1_);
+            VerifySorted<InputTypeSecond>(file2_, key_extractor2_);
+        }
+
+        std::vector<ArraySizeT> splits = SelectSplitters();
+
+        recv1_ = Exchange<InputTypeFirst>(file1_, splits, 0);
+        recv2_ = Exchange<InputTypeSecond>(file2_, splits, 1);
+    }
+
+    void PushData(bool consume) final {
+        auto less1 = [this](const InputTypeFirst& a, const InputTypeFirst& b) {
+                         return key_comparator_(
+                             key_extractor1_(a), key_extractor1_(b));
+                     };
+        auto less2 = [this](const InputTypeSecond& a,
+                            const InputTypeSecond& b) {
+                         return key_comparator_(
+                             key_extractor2_(a), key_extractor2_(b));
+                     };
+
+        // merge the sorted runs received from all workers.
+        std::vector<data::File::Reader> readers1, readers2;
+        for (data::File& f : recv1_)
+            readers1.emplace_back(f.GetReader(consume));
+        for (data::File& f : recv2_)
+            readers2.emplace_back(f.GetReader(consume));
+
+        auto puller1 = core::make_multiway_merge_tree<InputTypeFirst>(
+            readers1.begin(), readers1.end(), less1);
+        auto puller2 = core::make_multiway_merge_tree<InputTypeSecond>(
+            readers2.begin(), readers2.end(), less2);
+
+        if (puller1.HasNext() && puller2.HasNext())
+            MergeJoin(puller1, puller2);
+
+        if (consume) {
+            recv1_.clear();
+            recv2_.clear();
+        }
+    }
+
+    void Dispose() final {
+        file1_.Clear();
+        file2_.Clear();
+        recv1_.clear();
+        recv2_.clear();
+    }
+
+private:
+    KeyExtractor1 key_extractor1_;
+    KeyExtractor2 key_extractor2_;
+    JoinFunction join_function_;
+    KeyComparator key_comparator_;
+
+    //! local PreOp Files of both inputs
+    data::File file1_, file2_;
+
+    //! writers of the local PreOp Files
+    data::File::Writer writer1_, writer2_;
+
+    //! sorted runs of both inputs received from each worker
+    std::vector<data::File> recv1_, recv2_;
+
+    //! check that the items of file are sorted by key.
+    template <typename Type, typename KeyExtractor>
+    void VerifySorted(const data::File& file,
+                      const KeyExtractor& key_extractor) const {
+        auto reader = file.GetKeepReader();
+        if (!reader.HasNext()) return;
+
+        Key prev = key_extractor(reader.template Next<Type>());
+        while (reader.HasNext()) {
+            Key next = key_extractor(reader.template Next<Type>());
+            if (key_comparator_(next, prev))
+                die("SortMergeJoin input was not sorted!");
+            prev = std::move(next);
+        }
+    }
+
+    //! join the merged items of both inputs, which must both be non-empty.
+    //! The current items are constructed from the first items of the inputs,
+    //! hence the input types need not be default constructible.
+    template <typename Puller1, typename Puller2>
+    void MergeJoin(Puller1& puller1, Puller2& puller2) {
+        InputTypeFirst a = puller1.Next();
+        InputTypeSecond b = puller2.Next();
+        bool has1 = true, has2 = true;
+
+        // items of the first input with the current key.
+        std::vector<InputTypeFirst> group;
+        data::File group_file = context_.GetFile(this);
+
+        while (has1 && has2) {
+            const Key key = key_extractor1_(a);
+            const Key key2 = key_extractor2_(b);
+
+            if (key_comparator_(key, key2)) {
+                if ((has1 = puller1.HasNext())) a = puller1.Next();
+                continue;
+            }
+            if (key_comparator_(key2, key)) {
+                if ((has2 = puller2.HasNext())) b = puller2.Next();
+                continue;
+            }
+
+            // collect the items of the first input with this key.
+            group.clear();
+            {
+                data::File::Writer writer;
+                do {
+                    if (group.size() < kMaxGroupItems) {
+                        group.emplace_back(std::move(a));
+                    }
+                    else {
+                        if (!writer.IsValid()) writer = group_file.GetWriter();
+                        writer.Put(a);
+                    }
+                    if ((has1 = puller1.HasNext())) a = puller1.Next();
+                } while (has1 && !key_comparator_(key, key_extractor1_(a)));
+            }
+
+            // and join them with each item of the second input with this key.
+            do {
+                for (const InputTypeFirst& g : group)
+                    this->PushItem(join_function_(g, b));
+                if (group_file.num_items() != 0) {
+                    auto reader = group_file.GetKeepReader();
+                    while (reader.HasNext()) {
+                        InputTypeFirst g =
+                            reader.template Next<InputTypeFirst>();
+                        this->PushItem(join_function_(g, b));
+                    }
+                }
+                if ((has2 = puller2.HasNext())) b = puller2.Next();
+            } while (has2 && !key_comparator_(key, key_extractor2_(b)));
+
+            group_file.Clear();
+        }
+    }
+
+    //! index of the first item in [left, right) of file whose key is not less
+    //! than key, or if upper is set, greater than key.
+    template <typename Type, typename KeyExtractor>
+    size_t Bound(const data::File& file, const KeyExtractor& key_extractor,
+                 const Key& key, bool upper, size_t left, size_t right) const {
+        while (left < right) {
+            size_t mid = (left + right) / 2;
+            Key cur = key_extractor(file.template GetItemAt<Type>(mid));
+            bool before = upper ? !key_comparator_(key, cur)
+                          : key_comparator_(cur, key);
+            if (before)
+                left = mid + 1;
+            else
+                right = mid;
+        }
+        return left;
+    }
+
+    //! rank of key in both local Files within the search range [left,
+    //! left+width).
+    ArraySizeT LocalRanks(const Key& key, bool upper,
+                          const ArraySizeT& left,
+                          const ArraySizeT& width) const {
+        return ArraySizeT {
+                   { Bound<InputTypeFirst>(
+                         file1_, key_extractor1_, key, upper,
+                         left[0], left[0] + width[0]),
+                     Bound<InputTypeSecond>(
+                         file2_, key_extractor2_, key, upper,
+                         left[1], left[1] + width[1]) }
+        };
+    }
+
+    //! pick kNumPivots equidistant pivot keys from the search range [left,
+    //! left+width) of file.
+    template <typename Type, typename KeyExtractor>
+    void PickPivots(const data::File& file, const KeyExtractor& key_extractor,
+                    size_t left, size_t width, Pivot* out) const {
+        for (size_t j = 0; j < kNumPivots; ++j) {
+            size_t idx = left + (j + 1) * width / (kNumPivots + 1);
+            out[j] = Pivot(
+                key_extractor(file.template GetItemAt<Type>(idx)), width);
+        }
+    }
+
+    /*!
+     * Selects the p - 1 splitter keys, and returns the local split positions
+     * of each in both Files. Splitter s is searched for in the ranges
+     * [left[s][i], left[s][i] + width[s][i]) of both Files i, which are
+     * always bounded by the same keys on all workers, such that the ranks
+     * found within them are the global ranks.
+     */
+    std::vector<ArraySizeT> SelectSplitters() {
+        const size_t p = context_.num_workers();
+
+        std::vector<ArraySizeT> left(p - 1), width(p - 1);
+        if (p == 1) return left;
+
+        size_t global_size = context_.net.AllReduce(
+            file1_.num_items() + file2_.num_items());
+
+        std::vector<size_t> target_ranks(p - 1);
+        for (size_t r = 0; r < p - 1; ++r) {
+            target_ranks[r] = (global_size / p) * (r + 1);
+            if (r < global_size % p)
+                target_ranks[r] += 1;
+        }
+
+        for (size_t r = 0; r < p - 1; ++r) {
+            width[r] = ArraySizeT {
+                { file1_.num_items(), file2_.num_items() }
+            };
+        }
+
+        std::vector<Pivot> pivots((p - 1) * kNumPivots);
+        // lower and upper local ranks of each pivot in both Files
+        std::vector<ArraySizeT> lower((p - 1) * kNumPivots);
+        std::vector<ArraySizeT> upper((p - 1) * kNumPivots);
+        // global lower and upper ranks, interleaved
+        std::vector<size_t> global_ranks(2 * (p - 1) * kNumPivots);
+
+        size_t iterations = 0;
+        while (true) {
+            // pick pivots from the largest local range of each splitter, and
+            // select the ones from the largest range among all workers.
+            for (size_t s = 0; s < p - 1; ++s) {
+                Pivot* out = pivots.data() + s * kNumPivots;
+                if (width[s][0] >= width[s][1] && width[s][0] != 0) {
+                    PickPivots<InputTypeFirst>(
+                        file1_, key_extractor1_, left[s][0], width[s][0], out);
+                }
+                else if (width[s][1] != 0) {
+                    PickPivots<InputTypeSecond>(
+                        file2_, key_extractor2_, left[s][1], width[s][1], out);
+                }
+                else {
+                    std::fill(out, out + kNumPivots, Pivot(Key(), 0));
+                }
+            }
+
+            pivots = context_.net.AllReduce(
+                pivots,
+                [](const std::vector<Pivot>& a, const std::vector<Pivot>& b) {
+                    std::vector<Pivot> res(a);
+                    for (size_t k = 0; k < res.size(); ++k) {
+                        if (b[k].second > res[k].second) res[k] = b[k];
+                    }
+                    return res;
+                });
+
+            // finished if the ranges of all splitters are empty.
+            bool finished = true;
+            for (size_t s = 0; s < p - 1; ++s) {
+                if (pivots[s * kNumPivots].second != 0) finished = false;
+            }
+            if (finished) break;
+
+            // rank the pivots of splitters with a non-empty range.
+            for (size_t k = 0; k < pivots.size(); ++k) {
+                size_t s = k / kNumPivots;
+                if (pivots[k].second == 0) continue;
+                lower[k] = LocalRanks(pivots[k].first, false,
+                                      left[s], width[s]);
+                upper[k] = LocalRanks(pivots[k].first, true,
+                                      left[s], width[s]);
+                global_ranks[2 * k] = lower[k][0] + lower[k][1];
+                global_ranks[2 * k + 1] = upper[k][0] + upper[k][1];
+            }
+
+            global_ranks = context_.net.AllReduce(
+                global_ranks, common::ComponentSum<std::vector<size_t> >());
+
+            for (size_t s = 0; s < p - 1; ++s) {
+                if (pivots[s * kNumPivots].second == 0) continue;
+                ShrinkRange(s, target_ranks[s], global_ranks, lower, upper,
+                            left[s], width[s]);
+            }
+
+            ++iterations;
+        }
+
+        if (context_.my_rank() == 0) {
+            sLOG << "SortMergeJoin: selected splitters after" << iterations
+                 << "iterations";
+        }
+
+        return left;
+    }
+
+    /*!
+     * Shrinks the search range of splitter s by the global ranks of its
+     * pivots: the split is after all items with a key k if the global upper
+     * rank of k is at most the target, and before them if the lower rank is
+     * larger. If the target falls within the items of a key, the closer
+     * boundary is the split, and the range becomes empty.
+     */
+    void ShrinkRange(size_t s, size_t target,
+                     const std::vector<size_t>& global_ranks,
+                     const std::vector<ArraySizeT>& lower,
+                     const std::vector<ArraySizeT>& upper,
+                     ArraySizeT& left, ArraySizeT& width) const {
+        ArraySizeT lo = left, hi {
+            { left[0] + width[0], left[1] + width[1] }
+        };
+
+        for (size_t k = s * kNumPivots; k < (s + 1) * kNumPivots; ++k) {
+            size_t lower_rank = global_ranks[2 * k];
+            size_t upper_rank = global_ranks[2 * k + 1];
+
+            if (upper_rank <= target) {
+                for (size_t i = 0; i < 2; ++i)
+                    lo[i] = std::max(lo[i], upper[k][i]);
+            }
+            else if (lower_rank > target) {
+                for (size_t i = 0; i < 2; ++i)
+                    hi[i] = std::min(hi[i], lower[k][i]);
+            }
+            else {
+                // target is within the items of this key.
+                const ArraySizeT& split =
+                    target - lower_rank <= upper_rank - target
+                    ? lower[k] : upper[k];
+                lo = hi = split;
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < 2; ++i) {
+            assert(lo[i] <= hi[i]);
+            left[i] = lo[i];
+            width[i] = hi[i] - lo[i];
+        }
+    }
+
+    //! scatter the local File by the split positions of input index, and
+    //! receive the sorted runs sent by each worker into separate Files.
+    template <typename Type>
+    std::vector<data::File> Exchange(
+        data::File& file, const std::vector<ArraySizeT>& splits,
+        size_t index) {
+        const size_t p = context_.num_workers();
+
+        std::vector<size_t> offsets(p + 1, 0);
+        for (size_t r = 0; r < p - 1; ++r) {
+            offsets[r + 1] = splits[r][index];
+            assert(offsets[r] <= offsets[r + 1]);
+        }
+        offsets[p] = file.num_items();
+
+        LOG << "SortMergeJoin: scatter input " << index
+            << " offsets " << common::VecToStr(offsets);
+
+        data::CatStreamPtr stream = context_.GetNewCatStream(this);
+        stream->template Scatter<Type>(file, offsets, /* consume */ true);
+
+        std::vector<data::File> runs;
+        std::vector<data::CatStream::Reader> readers = stream->GetReaders();
+        for (size_t w = 0; w < p; ++w) {
+            runs.emplace_back(context_.GetFile(this));
+            data::PinnedBlock pb;
+            while ((pb = readers[w].source().NextBlock()).IsValid())
+                runs.back().AppendBlock(std::move(pb).MoveToBlock());
+        }
+        stream->Close();
+
+        return runs;
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename SecondDIA, typename KeyComparator>
+auto DIA<ValueType, Stack>::SortMergeJoin(
+    const SecondDIA &second_dia,
+    const KeyExtractor1 &key_extractor1,
+    const KeyExtractor2 &key_extractor2,
+    const JoinFunction &join_function,
+    const KeyComparator &key_comparator) const {
+    assert(IsValid());
+    assert(second_dia.IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<KeyExtractor1>::template arg<0>
+            >::value,
+        "KeyExtractor1 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<KeyExtractor2>::template arg<0>
+            >::value,
+        "KeyExtractor2 has the wrong input type");
+
+    static_assert(
+        std::is_same<
+            typename common::FunctionTraits<KeyExtractor1>::result_type,
+            typename common::FunctionTraits<KeyExtractor2>::result_type
+            >::value,
+        "Keys have the wrong type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<JoinFunction>::template arg<0>
+            >::value,
+        "JoinFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<JoinFunction>::template arg<1>
+            >::value,
+        "JoinFunction has the wrong input type");
+
+    using JoinResult
+              = typename common::FunctionTraits<JoinFunction>::result_type;
+
+    using SortMergeJoinNode = api::SortMergeJoinNode<
+              JoinResult, DIA, SecondDIA,
+              KeyExtractor1, KeyExtractor2, JoinFunction, KeyComparator>;
+
+    auto node = common::MakeCounting<SortMergeJoinNode>(
+        *this, second_dia, key_extractor1, key_extractor2, join_function,
+        key_comparator);
+
+    return DIA<JoinResult>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_SORT_MERGE_JOIN_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,320 @@
+/*******************************************************************************
+ * thrill/api/sparse_matrix.hpp
+ *
+ * Distributed sparse matrix kept as local compressed rows or columns, and its
+ * multiplication with a dense vector DIA.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_SPARSE_MATRIX_HEADER
+#define THRILL_API_SPARSE_MATRIX_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/collapse.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/group_to_index.hpp>
+#include <thrill/api/rebalance.hpp>
+#include <thrill/api/reduce_to_index.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/data/cat_stream.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Action which appends the local items of a DIA to a vector, without any
+ * communication.
+ *
+ * \ingroup api_layer
+ */
+template <typename ParentDIA>
+class CollectLocalNode final : public ActionNode
+{
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+public:
+    CollectLocalNode(const ParentDIA& parent, std::vector<ValueType>& out)
+        : ActionNode(parent.ctx(), "CollectLocal",
+                     { parent.id() }, { parent.node() }),
+          out_(out)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             out_.push_back(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void Execute() final { }
+
+private:
+    //! vector of the local items
+    std::vector<ValueType>& out_;
+};
+
+//! A nonzero entry of a SparseMatrix.
+template <typename Value>
+struct SparseMatrixEntry {
+    size_t row, col;
+    Value  value;
+};
+
+//! How a SparseMatrix is distributed over the workers.
+enum class SparseMatrixPartition {
+    //! each worker holds a range of rows, and gathers the whole vector.
+    Rows,
+    //! each worker holds a range of columns and the matching vector segment,
+    //! and the partial products are summed by ReduceToIndex.
+    Columns
+};
+
+/*!
+ * SparseMatrix holds a sparse rows x cols matrix in one-dimensional
+ * partitions: each worker keeps a range of the rows or the columns, split like
+ * by Rebalance(), as compressed sparse arrays. The matrix is built once from a
+ * DIA of entries and can then be multiplied with any number of dense vectors,
+ * which are DIAs holding the item of index i at position i.
+ *
+ * With SparseMatrixPartition::Rows, each worker sends its segment of the
+ * vector to all workers over a CatStream, and computes its rows of the result
+ * without further communication. With SparseMatrixPartition::Columns, the
+ * vector is rebalanced to the column ranges, each worker computes partial
+ * products of all rows, and these are summed by ReduceToIndex, which uses its
+ * dense array path if rows fit into dense_array_max_bytes. The row partition
+ * suits vectors which fit into each worker's RAM, the column partition moves
+ * only the partial results.
+ *
+ * \tparam Value Type of the matrix and vector items, with operators + and *.
+ *
+ * \ingroup dia_dops
+ */
+template <typename Value>
+class SparseMatrix
+{
+    static constexpr bool debug = false;
+
+public:
+    using Entry = SparseMatrixEntry<Value>;
+
+    //! Entries of one row or column: pairs (index, value) sorted by index.
+    using Line = std::vector<std::pair<size_t, Value> >;
+
+    /*!
+     * Build the matrix from a DIA of its nonzero entries, which is consumed.
+     * Entries with the same row and column are kept as separate summands.
+     *
+     * \param entries DIA of the nonzero entries.
+     *
+     * \param rows Number of rows.
+     *
+     * \param cols Number of columns.
+     *
+     * \param partition Whether to distribute rows or columns.
+     *
+     * \param dense_array_max_bytes Limit of the dense array path of the
+     * ReduceToIndex for SparseMatrixPartition::Columns, zero disables it.
+     */
+    template <typename InStack>
+    SparseMatrix(const DIA<Entry, InStack>& entries, size_t rows, size_t cols,
+                 SparseMatrixPartition partition = SparseMatrixPartition::Rows,
+                 size_t dense_array_max_bytes = 64 * 1024 * 1024)
+        : ctx_(entries.context()),
+          rows_(rows), cols_(cols), partition_(partition),
+          dense_array_max_bytes_(dense_array_max_bytes),
+          offsets_(1, 0) {
+        assert(entries.IsValid());
+
+        const bool by_rows = (partition_ == SparseMatrixPartition::Rows);
+        const size_t num_lines = by_rows ? rows_ : cols_;
+
+        auto lines = entries.template GroupToIndex<Line>(
+            [by_rows](const Entry& e) { return by_rows ? e.row : e.col; },
+            [by_rows](auto& r, const size_t&) {
+                Line line;
+                while (r.HasNext()) {
+                    const Entry& e = r.Next();
+                    line.emplace_back(by_rows ? e.col : e.row, e.value);
+                }
+                std::sort(line.begin(), line.end(),
+                          [](const std::pair<size_t, Value>& a,
+                             const std::pair<size_t, Value>& b) {
+                              return a.first < b.first;
+                          });
+                return line;
+            },
+            num_lines).Rebalance();
+
+        std::vector<Line> local;
+        CollectLocal(lines, local);
+
+        range_ = common::CalculateLocalRange(
+            num_lines, ctx_.num_workers(), ctx_.my_rank());
+        assert(range_.size() == local.size());
+
+        for (const Line& line : local) {
+            for (const std::pair<size_t, Value>& p : line) {
+                indexes_.push_back(p.first);
+                values_.push_back(p.second);
+            }
+            offsets_.push_back(indexes_.size());
+        }
+
+        LOG << "SparseMatrix: " << rows_ << " x " << cols_ << " local "
+            << (by_rows ? "rows " : "columns ") << range_
+            << " with " << values_.size() << " entries";
+    }
+
+    //! non-copyable: delete copy-constructor
+    SparseMatrix(const SparseMatrix&) = delete;
+    //! non-copyable: delete assignment operator
+    SparseMatrix& operator = (const SparseMatrix&) = delete;
+
+    /*!
+     * Multiply the matrix with the dense vector x of cols items, and return
+     * the product vector of rows items. x is consumed.
+     */
+    template <typename InStack>
+    DIA<Value> Multiply(const DIA<Value, InStack>& x) const {
+        assert(x.IsValid());
+        if (partition_ == SparseMatrixPartition::Rows)
+            return MultiplyRows(x);
+        else
+            return MultiplyColumns(x);
+    }
+
+    //! Returns the number of rows.
+    size_t rows() const { return rows_; }
+
+    //! Returns the number of columns.
+    size_t cols() const { return cols_; }
+
+    //! Returns the local range of rows or columns.
+    const common::Range& local_range() const { return range_; }
+
+private:
+    //! Context of the matrix's workers
+    Context& ctx_;
+
+    //! dimensions of the matrix
+    size_t rows_, cols_;
+
+    //! whether rows or columns are distributed
+    SparseMatrixPartition partition_;
+
+    //! limit of the dense ReduceToIndex for the column partition
+    size_t dense_array_max_bytes_;
+
+    //! local range of rows or columns
+    common::Range range_;
+
+    //! compressed offsets of the local lines into indexes_ and values_
+    std::vector<size_t> offsets_;
+    //! column or row index of each local entry
+    std::vector<size_t> indexes_;
+    //! value of each local entry
+    std::vector<Value> values_;
+
+    //! append the local items of dia to out
+    template <typename DIAType>
+    static void CollectLocal(const DIAType& dia,
+                             std::vector<typename DIAType::ValueType>& out) {
+        using CollectLocalNode = api::CollectLocalNode<DIAType>;
+        auto node = common::MakeCounting<CollectLocalNode>(dia, out);
+        node->RunScope();
+    }
+
+    template <typename InStack>
+    DIA<Value> MultiplyRows(const DIA<Value, InStack>& x) const {
+        std::vector<Value> segment;
+        CollectLocal(x, segment);
+
+        // send the local segment to all workers, the CatReader concatenates
+        // the segments in worker order.
+        data::CatStreamPtr stream = ctx_.GetNewCatStream(ctx_.next_dia_id());
+        std::vector<data::Stream::Writer> writers = stream->GetWriters();
+        for (data::Stream::Writer& w : writers) {
+            for (const Value& v : segment) w.Put(v);
+            w.Close();
+        }
+        std::vector<Value>().swap(segment);
+
+        std::vector<Value> full;
+        full.reserve(cols_);
+        auto reader = stream->GetCatReader(/* consume */ true);
+        while (reader.HasNext())
+            full.emplace_back(reader.template Next<Value>());
+        stream->Close();
+
+        die_unequal(cols_, full.size());
+
+        std::vector<Value> result(range_.size(), Value());
+        for (size_t i = 0; i < range_.size(); ++i) {
+            Value sum = Value();
+            for (size_t j = offsets_[i]; j < offsets_[i + 1]; ++j)
+                sum = sum + values_[j] * full[indexes_[j]];
+            result[i] = sum;
+        }
+
+        return ConcatToDIA(ctx_, std::move(result));
+    }
+
+    template <typename InStack>
+    DIA<Value> MultiplyColumns(const DIA<Value, InStack>& x) const {
+        // the rebalanced vector matches the local column range.
+        std::vector<Value> segment;
+        CollectLocal(x.Rebalance(), segment);
+        die_unequal(range_.size(), segment.size());
+
+        using RowValue = std::pair<size_t, Value>;
+
+        std::vector<RowValue> partial;
+        partial.reserve(values_.size());
+        for (size_t i = 0; i < range_.size(); ++i) {
+            for (size_t j = offsets_[i]; j < offsets_[i + 1]; ++j)
+                partial.emplace_back(indexes_[j], values_[j] * segment[i]);
+        }
+
+        DefaultReduceToIndexConfig config;
+        config.dense_array_max_bytes_ = dense_array_max_bytes_;
+
+        return ConcatToDIA(ctx_, std::move(partial))
+               .ReduceToIndex(
+                   [](const RowValue& p) { return p.first; },
+                   [](const RowValue& a, const RowValue& b) {
+                       return RowValue(a.first, a.second + b.second);
+                   },
+                   rows_, RowValue(0, Value()), config)
+               .Map([](const RowValue& p) { return p.second; })
+               .Collapse();
+    }
+};
+
+} // namespace api
+
+//! imported from api namespace
+using api::SparseMatrix;
+using api::SparseMatrixEntry;
+using api::SparseMatrixPartition;
+
+} // namespace thrill
+
+#endif // !THRILL_API_SPARSE_MATRIX_HEADER
+
+/******************************************************************************/
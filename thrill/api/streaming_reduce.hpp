@@ -0,0 +1,215 @@
+/*******************************************************************************
+ * thrill/api/streaming_reduce.hpp
+ *
+ * Reduction by key which is kept between micro-batches of a stream of DIAs,
+ * with expiry of keys after a window of batches.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_STREAMING_REDUCE_HEADER
+#define THRILL_API_STREAMING_REDUCE_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Action which merges the pre-reduced (key, value) pairs of a micro-batch into
+ * the table of a StreamingReduce, without any communication.
+ *
+ * \ingroup api_layer
+ */
+template <typename ParentDIA, typename Table, typename ReduceFunction>
+class StreamingReduceMergeNode final : public ActionNode
+{
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+public:
+    StreamingReduceMergeNode(const ParentDIA& parent, Table& table,
+                             const ReduceFunction& reduce_function,
+                             size_t batch)
+        : ActionNode(parent.ctx(), "StreamingReduceMerge",
+                     { parent.id() }, { parent.node() }),
+          table_(table), reduce_function_(reduce_function), batch_(batch)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             auto it = table_.find(input.first);
+                             if (it == table_.end()) {
+                                 table_.emplace(
+                                     input.first,
+                                     typename Table::mapped_type {
+                                         input.second, batch_
+                                     });
+                                 return;
+                             }
+                             it->second.value = reduce_function_(
+                                 it->second.value, input.second);
+                             it->second.last_batch = batch_;
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void Execute() final { }
+
+private:
+    //! table of the StreamingReduce
+    Table& table_;
+    //! reduce function of the micro-batch
+    ReduceFunction reduce_function_;
+    //! index of the micro-batch
+    size_t batch_;
+};
+
+/*!
+ * StreamingReduce keeps the reduction by key of a stream of micro-batches,
+ * which are DIAs of (key, value) pairs processed one after another in the same
+ * Context, e.g. lines read from new files every few seconds. Each batch is
+ * pre-reduced by ReducePair(), which delivers all values of a key to the same
+ * worker in every batch, since its hash partitioning depends only on the key
+ * and the number of workers. The reduced values are merged into a hash table
+ * on that worker, which persists between batches, hence each batch only
+ * processes and shuffles its own items.
+ *
+ * Keys which were not updated in the last window batches expire from the
+ * table. A window of zero keeps all keys.
+ *
+ * \tparam Key Type of the keys.
+ *
+ * \tparam Value Type of the reduced values.
+ *
+ * \ingroup dia_dops
+ */
+template <typename Key, typename Value>
+class StreamingReduce
+{
+    static constexpr bool debug = false;
+
+public:
+    using ValueType = std::pair<Key, Value>;
+
+    //! reduced value of a key and the batch which last updated it
+    struct Entry {
+        Value  value;
+        size_t last_batch;
+    };
+
+    using Table = std::unordered_map<Key, Entry>;
+
+    /*!
+     * Create an empty StreamingReduce.
+     *
+     * \param ctx Context of the workers.
+     *
+     * \param window Number of batches after which keys without updates
+     * expire, zero disables expiry.
+     */
+    explicit StreamingReduce(Context& ctx, size_t window = 0)
+        : ctx_(ctx), window_(window) { }
+
+    //! non-copyable: delete copy-constructor
+    StreamingReduce(const StreamingReduce&) = delete;
+    //! non-copyable: delete assignment operator
+    StreamingReduce& operator = (const StreamingReduce&) = delete;
+
+    /*!
+     * Process the next micro-batch: reduce its pairs with reduce_function and
+     * merge them into the kept values, then expire old keys. The batch DIA is
+     * consumed.
+     *
+     * \param batch DIA of the batch's (key, value) pairs.
+     *
+     * \param reduce_function Function `Value (const Value&, const Value&)`,
+     * which must be associative and commutative, and the same in all batches.
+     */
+    template <typename InStack, typename ReduceFunction>
+    void Update(const DIA<ValueType, InStack>& batch,
+                const ReduceFunction& reduce_function) {
+        assert(batch.IsValid());
+
+        auto reduced = batch.ReducePair(reduce_function);
+
+        using MergeNode = api::StreamingReduceMergeNode<
+                  decltype(reduced), Table, ReduceFunction>;
+        auto node = common::MakeCounting<MergeNode>(
+            reduced, table_, reduce_function, batch_);
+        node->RunScope();
+
+        size_t expired = 0;
+        if (window_ != 0) {
+            for (auto it = table_.begin(); it != table_.end(); ) {
+                if (batch_ - it->second.last_batch >= window_) {
+                    it = table_.erase(it);
+                    ++expired;
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        LOG << "StreamingReduce: batch " << batch_ << " local keys "
+            << table_.size() << " expired " << expired;
+
+        ++batch_;
+    }
+
+    //! Returns a DIA of the current (key, value) pairs, in no particular order.
+    DIA<ValueType> State() const {
+        std::vector<ValueType> items;
+        items.reserve(table_.size());
+        for (const auto& e : table_)
+            items.emplace_back(e.first, e.second.value);
+        return ConcatToDIA(ctx_, std::move(items));
+    }
+
+    //! Returns the number of processed batches.
+    size_t num_batches() const { return batch_; }
+
+    //! Returns the number of keys kept on this worker.
+    size_t local_size() const { return table_.size(); }
+
+private:
+    //! Context of the workers
+    Context& ctx_;
+
+    //! number of batches after which keys expire, zero for never.
+    size_t window_;
+
+    //! index of the next batch
+    size_t batch_ = 0;
+
+    //! reduced values of the local keys
+    Table table_;
+};
+
+} // namespace api
+
+//! imported from api namespace
+using api::StreamingReduce;
+
+} // namespace thrill
+
+#endif // !THRILL_API_STREAMING_REDUCE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * thrill/api/top_k.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_TOP_K_HEADER
+#define THRILL_API_TOP_K_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/binary_heap.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Collects the k smallest items according to a compare function in a bounded
+ * common::BinaryHeap, whose top is the largest item kept. Inserting an item
+ * costs O(log k), and the collected items of all workers are merged with a
+ * single AllReduce on the sorted item vectors.
+ */
+template <typename ValueType, typename CompareFunction>
+class TopKCollector
+{
+public:
+    TopKCollector(size_t k, const CompareFunction& compare_function)
+        : k_(k), compare_function_(compare_function),
+          heap_(compare_function) { }
+
+    //! add an item, which is only kept if it is among the k smallest.
+    void Insert(const ValueType& item) {
+        if (heap_.size() < k_) {
+            heap_.emplace(item);
+        }
+        else if (k_ != 0 && compare_function_(item, heap_.top())) {
+            heap_.pop();
+            heap_.emplace(item);
+        }
+    }
+
+    //! merge the collected items of all workers and return the global k
+    //! smallest items in sorted order on all workers.
+    std::vector<ValueType> AllReduce(net::FlowControlChannel& net) {
+        std::vector<ValueType> local;
+        local.swap(heap_.container());
+        std::sort(local.begin(), local.end(), compare_function_);
+
+        size_t k = k_;
+        CompareFunction compare_function = compare_function_;
+
+        return net.AllReduce(
+            local,
+            [k, compare_function](const std::vector<ValueType>& a,
+                                  const std::vector<ValueType>& b) {
+                std::vector<ValueType> out;
+                out.reserve(std::min(k, a.size() + b.size()));
+                typename std::vector<ValueType>::const_iterator
+                    ia = a.begin(), ib = b.begin();
+                while (out.size() < k && (ia != a.end() || ib != b.end())) {
+                    if (ib == b.end() ||
+                        (ia != a.end() && !compare_function(*ib, *ia)))
+                        out.push_back(*ia++);
+                    else
+                        out.push_back(*ib++);
+                }
+                return out;
+            });
+    }
+
+private:
+    //! number of items to keep
+    size_t k_;
+    //! compare function
+    CompareFunction compare_function_;
+    //! bounded heap of the k smallest items seen
+    common::BinaryHeap<ValueType, CompareFunction> heap_;
+};
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ParentDIA, typename CompareFunction>
+class TopKNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+    using Super = ActionNode;
+    using Super::context_;
+
+    //! input and result type is the parent's output value type.
+    using ValueType = typename ParentDIA::ValueType;
+
+public:
+    TopKNode(const ParentDIA& parent,
+             const char* label,
+             size_t k,
+             const CompareFunction& compare_function)
+        : ActionNode(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          collector_(k, compare_function)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             collector_.Insert(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    //! Executes the top-k merge.
+    void Execute() final {
+        result_ = collector_.AllReduce(context_.net);
+    }
+
+    //! Returns the global top-k items.
+    std::vector<ValueType>& result() {
+        return result_;
+    }
+
+private:
+    //! bounded heap of local items
+    TopKCollector<ValueType, CompareFunction> collector_;
+    //! global result
+    std::vector<ValueType> result_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+std::vector<ValueType> DIA<ValueType, Stack>::TopK(
+    size_t k, const CompareFunction &compare_function) const {
+    assert(IsValid());
+
+    using TopKNode = api::TopKNode<DIA, CompareFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0>
+            >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value ||
+        std::is_same<CompareFunction, std::less<ValueType> >::value,
+        "CompareFunction has the wrong input type");
+
+    auto node = common::MakeCounting<TopKNode>(
+        *this, "TopK", k, compare_function);
+
+    node->RunScope();
+
+    return std::move(node->result());
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_TOP_K_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,190 @@
+/*******************************************************************************
+ * thrill/api/union.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_UNION_HEADER
+#define THRILL_API_UNION_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/file.hpp>
+
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DOpNode which contains the items of all parents in an unspecified order.
+ * In contrast to ConcatNode, no items are exchanged between workers: each
+ * worker chains the Blocks of its local parent Files into one File. If a
+ * parent delivers a File, its Blocks are only referenced, not copied.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ParentDIA0, typename ... ParentDIAs>
+class UnionNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    static constexpr size_t kNumInputs = 1 + sizeof ... (ParentDIAs);
+
+public:
+    UnionNode(const ParentDIA0& parent0,
+              const ParentDIAs& ... parents)
+        : Super(parent0.ctx(), "Union",
+                { parent0.id(), parents.id() ... },
+                { parent0.node(), parents.node() ... })
+    {
+        files_.reserve(kNumInputs);
+        writers_.reserve(kNumInputs);
+
+        // allocate files.
+        for (size_t i = 0; i < kNumInputs; ++i)
+            files_.emplace_back(context_.GetFile(this));
+
+        for (size_t i = 0; i < kNumInputs; ++i)
+            writers_.emplace_back(files_[i].GetWriter());
+
+        common::VariadicCallForeachIndex(
+            RegisterParent(this), parent0, parents ...);
+    }
+
+    //! Register Parent PreOp Hooks, instantiated and called for each Union
+    //! parent
+    class RegisterParent
+    {
+    public:
+        explicit RegisterParent(UnionNode* union_node)
+            : union_node_(union_node) { }
+
+        template <typename Index, typename Parent>
+        void operator () (const Index&, Parent& parent) {
+
+            // construct lambda with only the writer in the closure
+            data::File::Writer* writer = &union_node_->writers_[Index::index];
+            auto pre_op_fn = [writer](const ValueType& input) -> void {
+                                 writer->Put(input);
+                             };
+
+            // close the function stacks with our pre ops and register it at
+            // parent nodes for output
+            auto lop_chain = parent.stack().push(pre_op_fn).fold();
+
+            parent.node()->AddChild(union_node_, lop_chain, Index::index);
+        }
+
+    private:
+        UnionNode* union_node_;
+    };
+
+    //! Receive a whole data::File of ValueType, but only if our stack is empty.
+    bool OnPreOpFile(const data::File& file, size_t parent_index) final {
+        assert(parent_index < kNumInputs);
+
+        //! indication whether the parent stack is empty
+        static constexpr bool parent_stack_empty[kNumInputs] = {
+            // parenthesis are due to a MSVC2015 parser bug
+            ParentDIA0::stack_empty, (ParentDIAs::stack_empty)...
+        };
+        if (!parent_stack_empty[parent_index]) return false;
+
+        // accept file
+        assert(files_[parent_index].num_items() == 0);
+        files_[parent_index] = file.Copy();
+        return true;
+    }
+
+    void StopPreOp(size_t id) final {
+        writers_[id].Close();
+    }
+
+    //! Chains the Blocks of all parent Files, which each end on an item
+    //! boundary.
+    void Execute() final {
+        for (size_t i = 0; i < kNumInputs; ++i) {
+            for (const data::Block& b : files_[i].blocks())
+                file_.AppendBlock(b);
+            files_[i].Clear();
+        }
+        LOG << "UnionNode::Execute() local items " << file_.num_items();
+    }
+
+    void PushData(bool consume) final {
+        this->PushFile(file_, consume);
+    }
+
+    void Dispose() final {
+        file_.Clear();
+    }
+
+    size_t PushDataBytes() final { return file_.size_bytes(); }
+
+private:
+    //! Files for intermediate storage
+    std::vector<data::File> files_;
+    //! Writers to intermediate files
+    std::vector<data::File::Writer> writers_;
+
+    //! chained Blocks of all parents
+    data::File file_ { context_.GetFile(this) };
+};
+
+/*!
+ * Union is a DOp, which combines the items of any number of DIAs into a single
+ * DIA, in an unspecified order. All input DIAs must contain the same type,
+ * which is also the output DIA's type.
+ *
+ * In contrast to Concat, Union does not exchange any items between the workers
+ * and is hence cheap. Use it if the next operation does not depend on the
+ * order, e.g. ReduceByKey.
+ *
+ * \param first_dia first DIA
+ * \param dias DIAs, whose items are added to the first DIA.
+ *
+ * \ingroup dia_dops
+ */
+template <typename FirstDIA, typename ... DIAs>
+auto Union(const FirstDIA &first_dia, const DIAs &... dias) {
+
+    using VarForeachExpander = int[];
+
+    first_dia.AssertValid();
+    (void)VarForeachExpander {
+        (dias.AssertValid(), 0) ...
+    };
+
+    using ValueType = typename FirstDIA::ValueType;
+
+    using UnionNode = api::UnionNode<ValueType, FirstDIA, DIAs ...>;
+
+    return DIA<ValueType>(common::MakeCounting<UnionNode>(first_dia, dias ...));
+}
+
+template <typename ValueType, typename Stack>
+template <typename SecondDIA>
+auto DIA<ValueType, Stack>::Union(
+    const SecondDIA &second_dia) const {
+    return api::Union(*this, second_dia);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::Union;
+
+} // namespace thrill
+
+#endif // !THRILL_API_UNION_HEADER
+
+/******************************************************************************/
@@ -19,6 +19,8 @@
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
+#include <functional>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -123,8 +125,14 @@ protected:
 
 /*!
  * \ingroup api_layer
+ *
+ * If Contiguous is true, the window is passed as a pointer to window_size
+ * contiguous items in a linear buffer of twice the window size. When the buffer
+ * is full, the last window_size - 1 items are moved to its front, hence each
+ * item is moved at most twice.
  */
-template <typename ValueType, typename ParentDIA, typename WindowFunction>
+template <typename ValueType, typename ParentDIA, typename WindowFunction,
+          bool Contiguous = false>
 class OverlapWindowNode final
     : public BaseWindowNode<ValueType, ParentDIA, WindowFunction>
 {
@@ -171,6 +179,18 @@ public:
     }
 
     void PushData(bool consume) final {
+        PushData(consume, std::integral_constant<bool, Contiguous>());
+    }
+
+private:
+    using Super::file_;
+    using Super::first_rank_;
+    using Super::window_;
+    using Super::window_size_;
+    using Super::window_function_;
+
+    //! PushData() passing the window as RingBuffer
+    void PushData(bool consume, std::false_type) {
         data::File::Reader reader = file_.GetReader(consume);
 
         // copy window ring buffer containing first items
@@ -202,12 +222,40 @@ public:
         }
     }
 
-private:
-    using Super::file_;
-    using Super::first_rank_;
-    using Super::window_;
-    using Super::window_size_;
-    using Super::window_function_;
+    //! PushData() passing the window as pointer to contiguous items
+    void PushData(bool consume, std::true_type) {
+        data::File::Reader reader = file_.GetReader(consume);
+
+        // linear buffer starting with the first items
+        std::vector<Input> buffer(2 * window_size_);
+        size_t fill = 0;
+        for (size_t i = 0; i < window_.size(); ++i)
+            buffer[fill++] = window_[i];
+
+        // this may wrap around, but that is okay. -tb
+        size_t rank = first_rank_ - (window_size_ - 1);
+
+        for (size_t i = 0; i < file_.num_items(); ++i, ++rank) {
+            // move the last k - 1 items to the front if the buffer is full.
+            if (fill == buffer.size()) {
+                std::copy(buffer.end() - (window_size_ - 1), buffer.end(),
+                          buffer.begin());
+                fill = window_size_ - 1;
+            }
+
+            // append an item.
+            buffer[fill++] = reader.Next<Input>();
+
+            // only issue full window frames
+            if (fill < window_size_) continue;
+
+            // call window user-defined function
+            window_function_(rank, buffer.data() + fill - window_size_,
+                             [this](const ValueType& output) {
+                                 this->PushItem(output);
+                             });
+        }
+    }
 };
 
 template <typename ValueType, typename Stack>
@@ -267,6 +315,194 @@ auto DIA<ValueType, Stack>::Window(
     return DIA<Result>(node);
 }
 
+template <typename ValueType, typename Stack>
+template <typename ValueOut, typename WindowFunction>
+auto DIA<ValueType, Stack>::FlatWindow(
+    struct ContiguousWindowTag, size_t window_size,
+    const WindowFunction &window_function) const {
+    assert(IsValid());
+
+    static_assert(std::is_trivially_copyable<ValueType>::value,
+                  "ContiguousWindowTag requires trivially copyable items");
+
+    using WindowNode =
+              api::OverlapWindowNode<ValueOut, DIA, WindowFunction, true>;
+
+    auto node = common::MakeCounting<WindowNode>(
+        *this, "FlatWindow", window_size, window_function);
+
+    return DIA<ValueOut>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename WindowFunction>
+auto DIA<ValueType, Stack>::Window(
+    struct ContiguousWindowTag, size_t window_size,
+    const WindowFunction &window_function) const {
+    assert(IsValid());
+
+    using Result
+              = typename FunctionTraits<WindowFunction>::result_type;
+
+    static_assert(
+        std::is_convertible<
+            size_t,
+            typename FunctionTraits<WindowFunction>::template arg<0>
+            >::value,
+        "WindowFunction's first argument must be size_t (index)");
+
+    static_assert(
+        std::is_convertible<
+            const ValueType*,
+            typename FunctionTraits<WindowFunction>::template arg<1>
+            >::value,
+        "WindowFunction's second argument must be const T*");
+
+    static_assert(std::is_trivially_copyable<ValueType>::value,
+                  "ContiguousWindowTag requires trivially copyable items");
+
+    // transform Map-like function into FlatMap-like function
+    auto flatwindow_function =
+        [window_function](size_t index, const ValueType* window, auto emit) {
+            emit(window_function(index, window));
+        };
+
+    using WindowNode =
+              api::OverlapWindowNode<
+                  Result, DIA, decltype(flatwindow_function), true>;
+
+    auto node = common::MakeCounting<WindowNode>(
+        *this, "Window", window_size, flatwindow_function);
+
+    return DIA<Result>(node);
+}
+
+/******************************************************************************/
+
+/*!
+ * FlatWindow function of WindowSum(): the running sum adds the item entering
+ * and subtracts the item leaving each window. It is recalculated if the index
+ * is not consecutive, e.g. when PushData() runs again.
+ */
+template <typename ValueType, typename SumFunction, typename SubtractFunction>
+class WindowSumFunction
+{
+public:
+    WindowSumFunction(const SumFunction& sum_function,
+                      const SubtractFunction& subtract_function)
+        : sum_function_(sum_function), subtract_function_(subtract_function)
+    { }
+
+    template <typename Emitter>
+    void operator () (size_t index, const common::RingBuffer<ValueType>& window,
+                      Emitter emit) {
+        if (index != next_index_ || index == 0) {
+            sum_ = window[0];
+            for (size_t i = 1; i < window.size(); ++i)
+                sum_ = sum_function_(sum_, window[i]);
+        }
+        else {
+            sum_ = sum_function_(subtract_function_(sum_, last_front_),
+                                 window.back());
+        }
+        last_front_ = window.front();
+        next_index_ = index + 1;
+        emit(sum_);
+    }
+
+private:
+    SumFunction sum_function_;
+    SubtractFunction subtract_function_;
+    //! sum of the last window
+    ValueType sum_;
+    //! first item of the last window
+    ValueType last_front_;
+    //! index of the next consecutive window
+    size_t next_index_ = 0;
+};
+
+/*!
+ * FlatWindow function of WindowMin() and WindowMax(): a monotonic queue of the
+ * indexes of the items which can still become the minimum of a window, whose
+ * items increase from front to back. Each item is pushed and popped once.
+ */
+template <typename ValueType, typename CompareFunction>
+class WindowMinFunction
+{
+public:
+    explicit WindowMinFunction(const CompareFunction& compare_function)
+        : compare_function_(compare_function) { }
+
+    template <typename Emitter>
+    void operator () (size_t index, const common::RingBuffer<ValueType>& window,
+                      Emitter emit) {
+        if (index != next_index_ || index == 0) {
+            queue_.deallocate();
+            queue_.allocate(window.size());
+            for (size_t i = 0; i < window.size(); ++i)
+                Push(index, index + i, window);
+        }
+        else {
+            if (queue_.front() < index) queue_.pop_front();
+            Push(index, index + window.size() - 1, window);
+        }
+        next_index_ = index + 1;
+        emit(window[queue_.front() - index]);
+    }
+
+private:
+    CompareFunction compare_function_;
+    //! indexes of the candidate items
+    common::RingBuffer<size_t> queue_;
+    //! index of the next consecutive window
+    size_t next_index_ = 0;
+
+    //! push item i of the window starting at index
+    void Push(size_t index, size_t i,
+              const common::RingBuffer<ValueType>& window) {
+        while (queue_.size() &&
+               !compare_function_(window[queue_.back() - index],
+                                  window[i - index]))
+            queue_.pop_back();
+        queue_.push_back(i);
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename SumFunction, typename SubtractFunction>
+auto DIA<ValueType, Stack>::WindowSum(
+    size_t window_size, const SumFunction& sum_function,
+    const SubtractFunction& subtract_function) const {
+    return FlatWindow<ValueType>(
+        window_size,
+        WindowSumFunction<ValueType, SumFunction, SubtractFunction>(
+            sum_function, subtract_function));
+}
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+auto DIA<ValueType, Stack>::WindowMin(
+    size_t window_size, const CompareFunction& compare_function) const {
+    return FlatWindow<ValueType>(
+        window_size,
+        WindowMinFunction<ValueType, CompareFunction>(compare_function));
+}
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+auto DIA<ValueType, Stack>::WindowMax(
+    size_t window_size, const CompareFunction& compare_function) const {
+    // the maximum is the minimum with swapped comparison
+    auto greater_function =
+        [compare_function](const ValueType& a, const ValueType& b) {
+            return compare_function(b, a);
+        };
+    return FlatWindow<ValueType>(
+        window_size,
+        WindowMinFunction<ValueType, decltype(greater_function)>(
+            greater_function));
+}
+
 /******************************************************************************/
 
 /*!
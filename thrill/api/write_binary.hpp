@@ -17,6 +17,8 @@
 #include <thrill/api/context.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/common/string.hpp>
+#include <thrill/core/background_writer.hpp>
+#include <thrill/core/binary_index.hpp>
 #include <thrill/core/file_io.hpp>
 #include <thrill/data/block_sink.hpp>
 #include <thrill/data/block_writer.hpp>
@@ -46,11 +48,15 @@ public:
 
     WriteBinaryNode(const ParentDIA& parent,
                     const std::string& path_out,
-                    size_t max_file_size)
+                    size_t max_file_size, bool write_index)
         : ActionNode(parent.ctx(), "WriteBinary",
                      { parent.id() }, { parent.node() }),
           out_pathbase_(path_out),
-          max_file_size_(max_file_size)
+          max_file_size_(max_file_size),
+          // fixed-size items are split by file size and need no index.
+          write_index_(
+              write_index &&
+              !data::Serialization<data::DynBlockWriter, Input>::is_fixed_size)
     {
         sLOG << "Creating write node.";
 
@@ -110,25 +116,44 @@ public:
     void Execute() final { }
 
 private:
-    //! Implements BlockSink class writing to files with size limit.
+    //! Implements BlockSink class writing to files with size limit. Appends a
+    //! BinaryIndex of the item boundaries to uncompressed files if requested.
+    //! The Blocks are written by a BackgroundWriter, which keeps them pinned
+    //! until they are written.
     class SysFileSink final : public data::BoundedBlockSink
     {
     public:
         SysFileSink(data::BlockPool& block_pool,
                     size_t local_worker_id,
                     const std::string& path, size_t max_file_size,
+                    bool write_index,
                     size_t& stats_total_elements,
                     size_t& stats_total_writes)
             : BlockSink(block_pool, local_worker_id),
               BoundedBlockSink(block_pool, local_worker_id, max_file_size),
-              file_(core::SysFile::OpenForWrite(path)),
+              file_(core::SysFile::OpenForWrite(path, core::DefaultDirectIO())),
+              write_index_(write_index && !core::IsCompressed(path)),
               stats_total_elements_(stats_total_elements),
               stats_total_writes_(stats_total_writes) { }
 
         void AppendPinnedBlock(const data::PinnedBlock& b) final {
             sLOG << "SysFileSink::AppendBlock()" << b;
             stats_total_writes_++;
-            file_.write(b.data_begin(), b.size());
+            if (b.num_items() != 0) {
+                index_.checkpoints.emplace_back(
+                    offset_ + b.first_item_relative(), index_.total_items);
+                index_.total_items += b.num_items();
+            }
+            offset_ += b.size();
+            writer_.Enqueue(
+                [this, b]() {
+                    // blocks are aligned ByteBlocks, except for the tail of a
+                    // file.
+                    if (file_.direct() &&
+                        !core::SysFile::IsDirectAligned(b.data_begin(), b.size()))
+                        file_.set_direct(false);
+                    file_.write(b.data_begin(), b.size());
+                });
         }
 
         void AppendPinnedBlock(data::PinnedBlock&& b) final {
@@ -144,11 +169,25 @@ private:
         }
 
         void Close() final {
+            writer_.Finish();
+            if (write_index_) {
+                std::string index = index_.Serialize();
+                file_.set_direct(false);
+                file_.write(index.data(), index.size());
+                write_index_ = false;
+            }
             file_.close();
         }
 
     private:
         core::SysFile file_;
+        //! writes the Blocks to file_ behind the producer, destroyed first.
+        core::BackgroundWriter writer_ { core::DefaultWriteBehind() };
+        //! whether to write the index on Close()
+        bool write_index_;
+        //! index of item boundaries and current file offset
+        core::BinaryIndex index_;
+        uint64_t offset_ = 0;
         size_t& stats_total_elements_;
         size_t& stats_total_writes_;
     };
@@ -164,6 +203,9 @@ private:
     //! Maximum file size
     size_t max_file_size_;
 
+    //! whether to append a BinaryIndex to files
+    bool write_index_;
+
     //! Block size used by BlockWriter
     size_t block_size_ = data::default_block_size;
 
@@ -189,7 +231,7 @@ private:
 
         sink_ = std::make_unique<SysFileSink>(
             context_.block_pool(), context_.local_worker_id(),
-            out_path, max_file_size_,
+            out_path, max_file_size_, write_index_,
             stats_total_elements_, stats_total_writes_);
 
         writer_ = std::make_unique<Writer>(sink_.get(), block_size_);
@@ -198,12 +240,13 @@ private:
 
 template <typename ValueType, typename Stack>
 void DIA<ValueType, Stack>::WriteBinary(
-    const std::string& filepath, size_t max_file_size) const {
+    const std::string& filepath, size_t max_file_size,
+    bool write_index) const {
 
     using WriteBinaryNode = api::WriteBinaryNode<DIA>;
 
     auto node = common::MakeCounting<WriteBinaryNode>(
-        *this, filepath, max_file_size);
+        *this, filepath, max_file_size, write_index);
 
     node->RunScope();
 }
@@ -0,0 +1,199 @@
+/*******************************************************************************
+ * thrill/api/write_columnar.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_WRITE_COLUMNAR_HEADER
+#define THRILL_API_WRITE_COLUMNAR_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/meta.hpp>
+#include <thrill/core/columnar_format.hpp>
+#include <thrill/core/file_io.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ParentDIA>
+class WriteColumnarNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+    //! input type is the parent's output value type.
+    using Input = typename ParentDIA::ValueType;
+
+    //! number of columns
+    static constexpr size_t num_columns = std::tuple_size<Input>::value;
+
+public:
+    using Super = ActionNode;
+    using Super::context_;
+
+    WriteColumnarNode(const ParentDIA& parent,
+                      const std::string& path_out,
+                      size_t chunk_rows)
+        : ActionNode(parent.ctx(), "WriteColumnar",
+                     { parent.id() }, { parent.node() }),
+          out_path_(core::FillFilePattern(
+                        path_out, parent.ctx().my_rank(), 0)),
+          chunk_rows_(chunk_rows)
+    {
+        sLOG << "Creating write node.";
+
+        common::VariadicCallEnumerate<num_columns>(
+            [this](auto index) {
+                std::get<decltype(index)::index>(columns_).reserve(chunk_rows_);
+                footer_.value_sizes.push_back(sizeof(
+                    typename std::tuple_element<
+                        decltype(index)::index, Input>::type));
+            });
+
+        auto pre_op_fn = [=](const Input& input) {
+                             return PreOp(input);
+                         };
+        // close the function stack with our pre op and register it at parent
+        // node for output
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        return chunk_rows_ * sizeof(Input);
+    }
+
+    //! writer preop: split item into columns, write chunks as needed.
+    void PreOp(const Input& input) {
+        common::VariadicCallEnumerate<num_columns>(
+            [this, &input](auto index) {
+                std::get<decltype(index)::index>(columns_).push_back(
+                    std::get<decltype(index)::index>(input));
+            });
+
+        if (++rows_ >= chunk_rows_) WriteChunk();
+    }
+
+    //! Writes the last chunk and the footer, and closes the output file
+    void StopPreOp(size_t /* id */) final {
+        if (rows_ != 0) WriteChunk();
+
+        if (file_opened_) {
+            std::string footer;
+            footer_.Serialize(&footer);
+            Write(footer);
+            file_.close();
+        }
+
+        Super::logger_
+            << "class" << "WriteColumnarNode"
+            << "total_rows" << stats_total_rows_
+            << "total_chunks" << footer_.chunks.size()
+            << "total_bytes" << offset_;
+    }
+
+    void Execute() final { }
+
+private:
+    //! Path of the output file.
+    std::string out_path_;
+
+    //! Number of rows per chunk.
+    size_t chunk_rows_;
+
+    //! Buffers of the current chunk's columns.
+    typename core::columnar::ColumnVectors<Input>::type columns_;
+
+    //! Number of rows in the current chunk.
+    size_t rows_ = 0;
+
+    //! Output file, opened when the first chunk is written.
+    core::SysFile file_;
+    bool file_opened_ = false;
+
+    //! Current file offset.
+    uint64_t offset_ = 0;
+
+    //! Footer collected while writing chunks.
+    core::columnar::Footer footer_;
+
+    size_t stats_total_rows_ = 0;
+
+    //! Encode current chunk column by column and write it.
+    void WriteChunk() {
+        if (!file_opened_) {
+            sLOG << "WriteChunk() out_path" << out_path_;
+            file_ = core::SysFile::OpenForWrite(out_path_);
+            file_opened_ = true;
+        }
+
+        core::columnar::ChunkMeta chunk;
+        chunk.rows = rows_;
+
+        std::string data;
+        common::VariadicCallEnumerate<num_columns>(
+            [this, &chunk, &data](auto index) {
+                auto& column = std::get<decltype(index)::index>(columns_);
+                size_t begin = data.size();
+                chunk.columns.emplace_back(
+                    core::columnar::EncodeColumn(column, &data));
+                chunk.columns.back().offset = offset_ + begin;
+                column.clear();
+            });
+
+        Write(data);
+        footer_.chunks.emplace_back(std::move(chunk));
+
+        stats_total_rows_ += rows_;
+        rows_ = 0;
+    }
+
+    //! Write all of data to the file
+    void Write(const std::string& data) {
+        size_t wb = 0;
+        while (wb < data.size()) {
+            ssize_t w = file_.write(data.data() + wb, data.size() - wb);
+            if (w <= 0) {
+                throw common::ErrnoException(
+                          "Error writing columnar file " + out_path_);
+            }
+            wb += w;
+        }
+        offset_ += data.size();
+    }
+};
+
+template <typename ValueType, typename Stack>
+void DIA<ValueType, Stack>::WriteColumnar(
+    const std::string& filepath, size_t chunk_rows) const {
+    assert(IsValid());
+
+    static_assert(common::is_std_tuple<ValueType>::value,
+                  "WriteColumnar needs an std::tuple as input parameter");
+
+    using WriteColumnarNode = api::WriteColumnarNode<DIA>;
+
+    auto node = common::MakeCounting<WriteColumnarNode>(
+        *this, filepath, chunk_rows);
+
+    node->RunScope();
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_WRITE_COLUMNAR_HEADER
+
+/******************************************************************************/
@@ -16,10 +16,14 @@
 
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/core/background_writer.hpp>
+#include <thrill/core/file_io.hpp>
+#include <thrill/core/remote_file_system.hpp>
 #include <thrill/data/file.hpp>
 
-#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace thrill {
 namespace api {
@@ -43,11 +47,17 @@ public:
                    const std::string& path_out)
         : ActionNode(parent.ctx(), "WriteLines",
                      { parent.id() }, { parent.node() }),
-          path_out_(path_out),
-          file_(path_out_, std::ios::binary)
+          path_out_(path_out)
     {
         sLOG << "Creating write node.";
 
+        if (core::IsRemotePath(path_out_) || core::IsCompressed(path_out_)) {
+            throw std::runtime_error(
+                      "WriteLines() cannot write at offsets in remote or "
+                      "compressed file " + path_out_
+                      + ", use WriteLinesMany() instead.");
+        }
+
         auto pre_op_fn = [this](const Input& input) {
                              PreOp(input);
                          };
@@ -67,35 +77,76 @@ public:
         writer_.Close();
     }
 
-    //! Closes the output file
+    //! Writes all workers' lines in parallel into the output file
     void Execute() final {
         Super::logger_
             << "class" << "WriteLinesNode"
             << "total_bytes" << local_size_
             << "total_lines" << local_lines_;
 
-        // (Portable) allocation of output file, setting individual file pointers.
-        size_t prefix_elem = context_.net.ExPrefixSum(local_size_);
-        if (context_.my_rank() == context_.num_workers() - 1) {
-            file_.seekp(prefix_elem + local_size_ - 1);
-            file_.put('\0');
+        // each worker writes its lines at its byte offset in the file
+        size_t offset = context_.net.ExPrefixSum(local_size_);
+        size_t total_size = context_.net.AllReduce(local_size_);
+
+        // the first worker creates and sizes the output file
+        if (context_.my_rank() == 0) {
+            core::SysFile file = core::SysFile::OpenForWrite(path_out_);
+            file.truncate(total_size);
         }
-        file_.seekp(prefix_elem);
         context_.net.Barrier();
 
+        core::SysFile file = core::SysFile::OpenForWrite(path_out_);
+
+        // full buffers are written in a helper thread while the next ones
+        // are filled.
+        core::BackgroundWriter bg_writer(core::DefaultWriteBehind());
+
+        std::vector<char> buffer;
+        buffer.reserve(write_buffer_size);
+
         data::File::ConsumeReader reader = temp_file_.GetConsumeReader();
 
         for (size_t i = 0; i < temp_file_.num_items(); ++i) {
-            file_ << reader.Next<Input>() << "\n";
+            Input line = reader.Next<Input>();
+            buffer.insert(buffer.end(), line.begin(), line.end());
+            buffer.push_back('\n');
+
+            if (buffer.size() >= write_buffer_size)
+                offset += Flush(bg_writer, file, buffer, offset);
         }
+        Flush(bg_writer, file, buffer, offset);
+        bg_writer.Finish();
     }
 
 private:
+    //! size of the buffer written with each pwrite()
+    static constexpr size_t write_buffer_size = 4 * 1024 * 1024;
+
     //! Path of the output file.
     std::string path_out_;
 
-    //! File to write to
-    std::ofstream file_;
+    //! Queue writing the buffer at offset, replace it by an empty one, and
+    //! return the number of bytes.
+    size_t Flush(core::BackgroundWriter& bg_writer, core::SysFile& file,
+                 std::vector<char>& buffer, size_t offset) {
+        size_t size = buffer.size();
+        bg_writer.Enqueue(
+            [this, &file, b = std::move(buffer), offset]() {
+                size_t wb = 0;
+                while (wb < b.size()) {
+                    ssize_t w = file.pwrite(
+                        b.data() + wb, b.size() - wb, offset + wb);
+                    if (w <= 0) {
+                        throw common::ErrnoException(
+                                  "Error writing file " + path_out_);
+                    }
+                    wb += w;
+                }
+            });
+        buffer = std::vector<char>();
+        buffer.reserve(write_buffer_size);
+        return size;
+    }
 
     //! Local file size
     size_t local_size_ = 0;
@@ -66,9 +66,14 @@ namespace api {
  *
  * \tparam ZipFunction Type of the ZipFunction.
  *
+ * \tparam Pad Whether shorter DIAs are padded instead of cut.
+ *
+ * \tparam NoRebalance Whether the inputs are guaranteed to have equal local
+ * sizes, which skips all communication.
+ *
  * \ingroup api_layer
  */
-template <typename ValueType, typename ZipFunction, bool Pad,
+template <typename ValueType, typename ZipFunction, bool Pad, bool NoRebalance,
           typename ParentDIA0, typename ... ParentDIAs>
 class ZipNode final : public DOpNode<ValueType>
 {
@@ -141,19 +146,22 @@ public:
     void PushData(bool consume) final {
         size_t result_count = 0;
 
-        if (result_size_ != 0) {
+        if (result_size_ != 0 && aligned_) {
+            // zip the local Files directly
+            std::vector<data::File::Reader> readers;
+            readers.reserve(kNumInputs);
+            for (size_t i = 0; i < kNumInputs; ++i)
+                readers.emplace_back(files_[i].GetReader(consume));
+
+            result_count = PushReaders(readers);
+        }
+        else if (result_size_ != 0) {
             // get inbound readers from all Streams
             std::array<data::CatStream::CatReader, kNumInputs> readers;
             for (size_t i = 0; i < kNumInputs; ++i)
                 readers[i] = streams_[i]->GetCatReader(consume);
 
-            ReaderNext reader_next(*this, readers);
-
-            while (reader_next.HasNext()) {
-                auto v = common::VariadicMapEnumerate<kNumInputs>(reader_next);
-                this->PushItem(common::ApplyTuple(zip_function_, v));
-                ++result_count;
-            }
+            result_count = PushReaders(readers);
         }
 
         sLOG << "Zip: result_count" << result_count;
@@ -190,6 +198,10 @@ private:
     //! shortest size of Zipped inputs
     size_t result_size_;
 
+    //! whether all inputs have equal local ranges on all workers, then the
+    //! local Files are zipped without any exchange.
+    bool aligned_ = false;
+
     //! \}
 
     //! Register Parent PreOp Hooks, instantiated and called for each Zip parent
@@ -289,20 +301,43 @@ private:
 
         //! number of elements of this worker
         ArraySizeT dia_local_size;
+        bool local_equal = true;
         for (size_t i = 0; i < kNumInputs; ++i) {
             dia_local_size[i] = files_[i].num_items();
+            local_equal = local_equal && dia_local_size[i] == dia_local_size[0];
             sLOG << "input" << i << "dia_local_size" << dia_local_size[i];
         }
 
+        if (NoRebalance) {
+            // the inputs are guaranteed to be aligned, zip locally.
+            if (!local_equal) {
+                die("Zip(NoRebalanceTag): input DIAs have unequal local size: "
+                    << common::VecToStr(dia_local_size));
+            }
+            result_size_ = dia_local_size[0];
+            aligned_ = true;
+            return;
+        }
+
         //! inclusive prefixsum of number of elements: we have items from
         //! [dia_size_prefixsum - local_size, dia_size_prefixsum).
         dia_size_prefixsum_ = context_.net.PrefixSum(
             dia_local_size, ArraySizeT(), common::ComponentSum<ArraySizeT>());
 
-        //! total number of items in DIAs, over all worker. take last worker's
-        //! prefixsum
-        ArraySizeT dia_total_size = context_.net.Broadcast(
-            dia_size_prefixsum_, context_.net.num_workers() - 1);
+        //! total number of items in DIAs over all workers, and the number of
+        //! workers whose local sizes differ.
+        using ArraySizeT1 = std::array<size_t, kNumInputs + 1>;
+        ArraySizeT1 local_sum;
+        std::copy(dia_local_size.begin(), dia_local_size.end(),
+                  local_sum.begin());
+        local_sum[kNumInputs] = local_equal ? 0 : 1;
+
+        ArraySizeT1 global_sum = context_.net.AllReduce(
+            local_sum, common::ComponentSum<ArraySizeT1>());
+
+        ArraySizeT dia_total_size;
+        std::copy(global_sum.begin(), global_sum.begin() + kNumInputs,
+                  dia_total_size.begin());
 
         size_t max_dia_total_size =
             *std::max_element(dia_total_size.begin(), dia_total_size.end());
@@ -321,6 +356,14 @@ private:
 
         if (result_size_ == 0) return;
 
+        // if all workers have equal local sizes of all inputs, then their
+        // ranges match already and no items need to be exchanged.
+        if (global_sum[kNumInputs] == 0) {
+            sLOG << "Zip: inputs are aligned, skipping scatter";
+            aligned_ = true;
+            return;
+        }
+
         // perform scatters to exchange data, with different types.
         common::VariadicCallEnumerate<kNumInputs>(
             [=](auto index) {
@@ -329,12 +372,26 @@ private:
             });
     }
 
-    //! Access CatReaders for different different parents.
+    //! Zip the items of the readers and push them to the children.
+    template <typename Readers>
+    size_t PushReaders(Readers& readers) {
+        size_t result_count = 0;
+        ReaderNext<Readers> reader_next(*this, readers);
+
+        while (reader_next.HasNext()) {
+            auto v = common::VariadicMapEnumerate<kNumInputs>(reader_next);
+            this->PushItem(common::ApplyTuple(zip_function_, v));
+            ++result_count;
+        }
+        return result_count;
+    }
+
+    //! Access Readers for different different parents.
+    template <typename Readers>
     class ReaderNext
     {
     public:
-        ReaderNext(ZipNode& zip_node,
-                   std::array<data::CatStream::CatReader, kNumInputs>& readers)
+        ReaderNext(ZipNode& zip_node, Readers& readers)
             : zip_node_(zip_node), readers_(readers) { }
 
         //! helper for PushData() which checks all inputs
@@ -370,7 +427,7 @@ private:
         ZipNode& zip_node_;
 
         //! reference to the reader array in PushData().
-        std::array<data::CatStream::CatReader, kNumInputs>& readers_;
+        Readers& readers_;
     };
 };
 
@@ -419,7 +476,8 @@ auto Zip(const ZipFunction &zip_function,
               typename common::FunctionTraits<ZipFunction>::args_plain;
 
     using ZipNode
-              = api::ZipNode<ZipResult, ZipFunction, false, FirstDIA, DIAs ...>;
+              = api::ZipNode<ZipResult, ZipFunction, false, false,
+                           FirstDIA, DIAs ...>;
 
     auto node = common::MakeCounting<ZipNode>(
         zip_function, ZipArgs(), first_dia, dias ...);
@@ -437,6 +495,65 @@ auto DIA<ValueType, Stack>::Zip(
     return api::Zip(zip_function, *this, second_dia);
 }
 
+/*!
+ * Zip is a DOp, which Zips any number of DIAs like Zip() above, but requires
+ * that all DIAs have the same number of items on each worker, e.g. because they
+ * are derived from the same parent by Map()s. The local items are then zipped
+ * without any communication, unequal local sizes are a fatal error.
+ *
+ * \param zip_function Zip function, which zips two elements together
+ *
+ * \param first_dia the initial DIA.
+ *
+ * \param dias DIAs, which is zipped together with the original DIA.
+ *
+ * \ingroup dia_dops
+ */
+template <typename ZipFunction, typename FirstDIA, typename ... DIAs>
+auto Zip(struct NoRebalanceTag, const ZipFunction &zip_function,
+         const FirstDIA &first_dia, const DIAs &... dias) {
+
+    using VarForeachExpander = int[];
+
+    first_dia.AssertValid();
+    (void)VarForeachExpander {
+        (dias.AssertValid(), 0) ...
+    };
+
+    static_assert(
+        std::is_convertible<
+            typename FirstDIA::ValueType,
+            typename common::FunctionTraits<ZipFunction>::template arg<0>
+            >::value,
+        "ZipFunction has the wrong input type in DIA 0");
+
+    using ZipResult
+              = typename common::FunctionTraits<ZipFunction>::result_type;
+
+    using ZipArgs =
+              typename common::FunctionTraits<ZipFunction>::args_plain;
+
+    using ZipNode
+              = api::ZipNode<ZipResult, ZipFunction, false, true,
+                           FirstDIA, DIAs ...>;
+
+    auto node = common::MakeCounting<ZipNode>(
+        zip_function, ZipArgs(), first_dia, dias ...);
+
+    return DIA<ZipResult>(node);
+}
+
+/*!
+ * \ingroup dia_dops
+ */
+template <typename ValueType, typename Stack>
+template <typename ZipFunction, typename SecondDIA>
+auto DIA<ValueType, Stack>::Zip(
+    struct NoRebalanceTag, const SecondDIA &second_dia,
+    const ZipFunction &zip_function) const {
+    return api::Zip(NoRebalanceTag, zip_function, *this, second_dia);
+}
+
 /*!
  * ZipPad is a DOp, which Zips any number of DIAs in style of functional
  * programming. The zip_function is used to zip the i-th elements of all input
@@ -482,7 +599,8 @@ auto ZipPad(const ZipFunction &zip_function,
               typename common::FunctionTraits<ZipFunction>::args_plain;
 
     using ZipNode
-              = api::ZipNode<ZipResult, ZipFunction, true, FirstDIA, DIAs ...>;
+              = api::ZipNode<ZipResult, ZipFunction, true, false,
+                           FirstDIA, DIAs ...>;
 
     auto node = common::MakeCounting<ZipNode>(
         zip_function, ZipArgs(), first_dia, dias ...);
@@ -537,7 +655,8 @@ auto ZipPadding(
               typename common::FunctionTraits<ZipFunction>::result_type;
 
     using ZipNode
-              = api::ZipNode<ZipResult, ZipFunction, true, FirstDIA, DIAs ...>;
+              = api::ZipNode<ZipResult, ZipFunction, true, false,
+                           FirstDIA, DIAs ...>;
 
     auto node = common::MakeCounting<ZipNode>(
         zip_function, padding, first_dia, dias ...);
@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * thrill/api/zip_with_index.hpp
+ *
+ * DIANode for a ZipWithIndex operation, which zips each item with its global
+ * index.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_ZIP_WITH_INDEX_HEADER
+#define THRILL_API_ZIP_WITH_INDEX_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/file.hpp>
+
+#include <type_traits>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which zips each item with its global index. Unlike a Zip() with a
+ * Generate(), the items are not exchanged between workers: only the number of
+ * local items is prefix summed once.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ParentDIA, typename ZipFunction>
+class ZipWithIndexNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using InputType = typename ParentDIA::ValueType;
+
+public:
+    ZipWithIndexNode(const ParentDIA& parent, const ZipFunction& zip_function)
+        : Super(parent.ctx(), "ZipWithIndex",
+                { parent.id() }, { parent.node() }),
+          zip_function_(zip_function)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const InputType& input) {
+                             writer_.Put(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!ParentDIA::stack_empty) return false;
+        // copy complete Block references to writer_
+        file_ = file.Copy();
+        return true;
+    }
+
+    void StopPreOp(size_t /* id */) final {
+        writer_.Close();
+    }
+
+    //! Calculates the global index of the first local item.
+    void Execute() final {
+        first_index_ = context_.net.ExPrefixSum(file_.num_items());
+        LOG << "ZipWithIndex first_index_ " << first_index_;
+    }
+
+    void PushData(bool consume) final {
+        data::File::Reader reader = file_.GetReader(consume);
+
+        size_t index = first_index_;
+        for (size_t i = 0; i < file_.num_items(); ++i, ++index) {
+            this->PushItem(
+                zip_function_(reader.template Next<InputType>(), index));
+        }
+    }
+
+    void Dispose() final {
+        file_.Clear();
+    }
+
+private:
+    //! Zip function
+    ZipFunction zip_function_;
+
+    //! global index of the first local item
+    size_t first_index_ = 0;
+
+    //! Local data file
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+};
+
+template <typename ValueType, typename Stack>
+template <typename ZipFunction>
+auto DIA<ValueType, Stack>::ZipWithIndex(
+    const ZipFunction &zip_function) const {
+    assert(IsValid());
+
+    using ZipResult =
+              typename common::FunctionTraits<ZipFunction>::result_type;
+
+    using ZipWithIndexNode =
+              api::ZipWithIndexNode<ZipResult, DIA, ZipFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename common::FunctionTraits<ZipFunction>::template arg<0>
+            >::value,
+        "ZipFunction has the wrong input type in argument 0");
+
+    static_assert(
+        std::is_convertible<
+            size_t,
+            typename common::FunctionTraits<ZipFunction>::template arg<1>
+            >::value,
+        "ZipFunction needs a size_t index as argument 1");
+
+    auto node = common::MakeCounting<ZipWithIndexNode>(*this, zip_function);
+
+    return DIA<ZipResult>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_ZIP_WITH_INDEX_HEADER
+
+/******************************************************************************/
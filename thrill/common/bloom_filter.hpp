@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * thrill/common/bloom_filter.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_BLOOM_FILTER_HEADER
+#define THRILL_COMMON_BLOOM_FILTER_HEADER
+
+#include <thrill/common/math.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Bloom filter over 64-bit hashes of items with a power of two number of bits.
+ * The bit positions are derived by double hashing from the splitmix64
+ * finalizer of the hash. Contains() may return false positives, with a rate of
+ * about 2% for 8 bits per inserted item and 6 hash functions, but never false
+ * negatives. Two filters of the same size are united by or-ing their words,
+ * hence the words can be combined with an AllReduce.
+ */
+class BloomFilter
+{
+public:
+    //! create a filter with at least num_bits bits and num_hashes hash
+    //! functions.
+    BloomFilter(size_t num_bits, size_t num_hashes)
+        : num_hashes_(num_hashes),
+          words_(RoundUpToPowerOfTwo(std::max<size_t>(num_bits, 64)) / 64, 0) {
+        assert(num_hashes >= 1);
+    }
+
+    //! create a filter with bits_per_item bits for num_items items and the
+    //! optimal number of hash functions.
+    static BloomFilter ForItems(size_t num_items, size_t bits_per_item) {
+        size_t num_hashes = std::max<size_t>(
+            1, static_cast<size_t>(std::lround(bits_per_item * std::log(2.0))));
+        return BloomFilter(num_items * bits_per_item, num_hashes);
+    }
+
+    //! Adds the hash of an item.
+    void Insert(uint64_t hash) {
+        uint64_t h1, h2;
+        Hashes(hash, &h1, &h2);
+        const uint64_t mask = num_bits() - 1;
+        for (size_t i = 0; i < num_hashes_; ++i, h1 += h2)
+            words_[(h1 & mask) / 64] |= uint64_t(1) << (h1 % 64);
+    }
+
+    //! Returns whether the hash of an item may have been inserted.
+    bool Contains(uint64_t hash) const {
+        uint64_t h1, h2;
+        Hashes(hash, &h1, &h2);
+        const uint64_t mask = num_bits() - 1;
+        for (size_t i = 0; i < num_hashes_; ++i, h1 += h2) {
+            if (!(words_[(h1 & mask) / 64] & (uint64_t(1) << (h1 % 64))))
+                return false;
+        }
+        return true;
+    }
+
+    //! Merges the words of another filter into this one.
+    void Merge(const BloomFilter& other) {
+        MergeWords(&words_, other.words_);
+    }
+
+    //! Merges two word vectors of the same size, elementwise or.
+    static void MergeWords(std::vector<uint64_t>* a,
+                           const std::vector<uint64_t>& b) {
+        assert(a->size() == b.size());
+        for (size_t i = 0; i < a->size(); ++i)
+            (*a)[i] |= b[i];
+    }
+
+    //! Returns the number of bits.
+    size_t num_bits() const { return words_.size() * 64; }
+
+    //! Returns the number of hash functions.
+    size_t num_hashes() const { return num_hashes_; }
+
+    //! Returns the size of the filter in bytes.
+    size_t size_bytes() const { return words_.size() * sizeof(uint64_t); }
+
+    //! Returns the words.
+    const std::vector<uint64_t>& words() const { return words_; }
+
+    //! Returns the words.
+    std::vector<uint64_t>& words() { return words_; }
+
+private:
+    //! number of bit positions per item
+    size_t num_hashes_;
+    //! bits of the filter
+    std::vector<uint64_t> words_;
+
+    //! derive the start and the odd step of the bit positions, mixing the hash
+    //! again since e.g. std::hash of integers is the identity.
+    static void Hashes(uint64_t hash, uint64_t* h1, uint64_t* h2) {
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+        *h1 = hash;
+        *h2 = ((hash >> 32) | (hash << 32)) | 1;
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_BLOOM_FILTER_HEADER
+
+/******************************************************************************/
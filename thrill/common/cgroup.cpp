@@ -0,0 +1,214 @@
+/*******************************************************************************
+ * thrill/common/cgroup.cpp
+ *
+ * Detection of the memory and CPU limits of the control group (cgroup v1 or
+ * v2) the process runs in, as set by containers and batch schedulers.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/cgroup.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+#if __linux__
+#include <sched.h>
+#endif
+
+namespace thrill {
+namespace common {
+
+static constexpr bool debug = false;
+
+#if __linux__
+
+//! Find the path of the process's cgroup for a v1 controller, or of the
+//! unified v2 hierarchy if controller is empty, in /proc/self/cgroup. Lines
+//! are "id:controllers:path", v2 has id 0 and no controllers.
+static bool CgroupPath(const std::string& proc_cgroup,
+                       const std::string& controller, std::string& path) {
+    std::ifstream in(proc_cgroup);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string::size_type c1 = line.find(':');
+        std::string::size_type c2 = line.find(':', c1 + 1);
+        if (c1 == std::string::npos || c2 == std::string::npos) continue;
+
+        std::string controllers = line.substr(c1 + 1, c2 - c1 - 1);
+        bool match = controller.empty()
+                     ? controllers.empty()
+                     : ("," + controllers + ",").find(
+            "," + controller + ",") != std::string::npos;
+        if (!match) continue;
+
+        path = line.substr(c2 + 1);
+        // v1 controllers are mounted in directories named by the controllers
+        if (!controller.empty()) path = controllers + path;
+        return true;
+    }
+    return false;
+}
+
+//! Call read(dir) for the cgroup directory of the process and all its parents
+//! below /sys/fs/cgroup. Within containers, the path of /proc/self/cgroup is
+//! often not visible and the limits are found at the mounted root.
+static void CgroupForEachDir(
+    const std::string& proc_cgroup, const std::string& root,
+    const std::string& controller,
+    const std::function<void(const std::string& dir)>& read) {
+    std::string path;
+    if (!CgroupPath(proc_cgroup, controller, path)) return;
+
+    std::string mount = root + "/";
+    if (!controller.empty()) {
+        std::string::size_type slash = path.find('/');
+        mount += path.substr(0, slash) + "/";
+        path = slash == std::string::npos ? "" : path.substr(slash + 1);
+    }
+    else if (!path.empty() && path[0] == '/') {
+        path = path.substr(1);
+    }
+
+    while (true) {
+        read(mount + path);
+        if (path.empty()) break;
+        std::string::size_type slash = path.rfind('/');
+        path = slash == std::string::npos ? "" : path.substr(0, slash);
+    }
+}
+
+//! read the first line of a file, returns false if it does not exist
+static bool ReadLine(const std::string& file, std::string& line) {
+    std::ifstream in(file);
+    return in.good() && std::getline(in, line) && !line.empty();
+}
+
+uint64_t CgroupMemoryLimit() {
+    return CgroupMemoryLimit("/proc/self/cgroup", "/sys/fs/cgroup");
+}
+
+uint64_t CgroupMemoryLimit(
+    const std::string& proc_cgroup, const std::string& root) {
+    uint64_t limit = 0;
+    auto take = [&limit](uint64_t value) {
+        if (value != 0 && (limit == 0 || value < limit)) limit = value;
+    };
+
+    // cgroup v2: memory.max contains "max" or the limit in bytes
+    CgroupForEachDir(
+        proc_cgroup, root, std::string(), [&](const std::string& dir) {
+            std::string line;
+            if (ReadLine(dir + "/memory.max", line) && line != "max")
+                take(std::strtoull(line.c_str(), nullptr, 10));
+        });
+
+    // cgroup v1: memory.limit_in_bytes is a huge number without limit, which
+    // is rounded down to pages from INT64_MAX.
+    CgroupForEachDir(
+        proc_cgroup, root, "memory", [&](const std::string& dir) {
+            std::string line;
+            if (!ReadLine(dir + "/memory.limit_in_bytes", line)) return;
+            uint64_t value = std::strtoull(line.c_str(), nullptr, 10);
+            if (value < (uint64_t(1) << 62)) take(value);
+        });
+
+    LOG << "CgroupMemoryLimit() = " << limit;
+    return limit;
+}
+
+size_t CgroupCpuLimit() {
+    return CgroupCpuLimit("/proc/self/cgroup", "/sys/fs/cgroup");
+}
+
+size_t CgroupCpuLimit(const std::string& proc_cgroup, const std::string& root) {
+    size_t limit = 0;
+    auto take = [&limit](uint64_t quota, uint64_t period) {
+        if (quota == 0 || period == 0) return;
+        size_t cpus = static_cast<size_t>((quota + period - 1) / period);
+        if (limit == 0 || cpus < limit) limit = cpus;
+    };
+
+    // cgroup v2: cpu.max contains "quota period" with quota "max" if unlimited
+    CgroupForEachDir(
+        proc_cgroup, root, std::string(), [&](const std::string& dir) {
+            std::string line;
+            if (!ReadLine(dir + "/cpu.max", line) ||
+                line.compare(0, 3, "max") == 0) return;
+            char* endptr;
+            uint64_t quota = std::strtoull(line.c_str(), &endptr, 10);
+            take(quota, std::strtoull(endptr, nullptr, 10));
+        });
+
+    // cgroup v1: cpu.cfs_quota_us is -1 if unlimited
+    CgroupForEachDir(
+        proc_cgroup, root, "cpu", [&](const std::string& dir) {
+            std::string quota, period;
+            if (!ReadLine(dir + "/cpu.cfs_quota_us", quota) ||
+                !ReadLine(dir + "/cpu.cfs_period_us", period) ||
+                quota[0] == '-') return;
+            take(std::strtoull(quota.c_str(), nullptr, 10),
+                 std::strtoull(period.c_str(), nullptr, 10));
+        });
+
+    LOG << "CgroupCpuLimit() = " << limit;
+    return limit;
+}
+
+//! determine the number of usable CPUs for AvailableCpuCount()
+static size_t DetectCpuCount() {
+    size_t cpus = std::thread::hardware_concurrency();
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        size_t affinity = static_cast<size_t>(CPU_COUNT(&set));
+        if (affinity != 0 && (cpus == 0 || affinity < cpus)) cpus = affinity;
+    }
+
+    size_t quota = CgroupCpuLimit();
+    if (quota != 0 && (cpus == 0 || quota < cpus)) cpus = quota;
+
+    return std::max<size_t>(cpus, 1);
+}
+
+size_t AvailableCpuCount() {
+    static const size_t cpus = DetectCpuCount();
+    return cpus;
+}
+
+#else
+
+uint64_t CgroupMemoryLimit() {
+    return 0;
+}
+
+uint64_t CgroupMemoryLimit(const std::string&, const std::string&) {
+    return 0;
+}
+
+size_t CgroupCpuLimit() {
+    return 0;
+}
+
+size_t CgroupCpuLimit(const std::string&, const std::string&) {
+    return 0;
+}
+
+size_t AvailableCpuCount() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+#endif
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * thrill/common/cgroup.hpp
+ *
+ * Detection of the memory and CPU limits of the control group (cgroup v1 or
+ * v2) the process runs in, as set by containers and batch schedulers.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_CGROUP_HEADER
+#define THRILL_COMMON_CGROUP_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace thrill {
+namespace common {
+
+//! Return the memory limit in bytes of the process's cgroup and its parents,
+//! or zero if there is no limit or cgroups are not supported.
+uint64_t CgroupMemoryLimit();
+
+//! Return the memory limit for the cgroup file proc_cgroup of a process and
+//! the cgroup file systems mounted below root.
+uint64_t CgroupMemoryLimit(
+    const std::string& proc_cgroup, const std::string& root);
+
+//! Return the CPU quota of the process's cgroup and its parents as number of
+//! CPUs rounded up, or zero if there is no quota.
+size_t CgroupCpuLimit();
+
+//! Return the CPU quota for the cgroup file proc_cgroup of a process and the
+//! cgroup file systems mounted below root.
+size_t CgroupCpuLimit(const std::string& proc_cgroup, const std::string& root);
+
+//! Return the number of CPUs the process may use: the hardware concurrency
+//! reduced to the CPU affinity mask and the cgroup CPU quota, at least one.
+//! The count is determined once, before threads are pinned to NUMA nodes.
+size_t AvailableCpuCount();
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_CGROUP_HEADER
+
+/******************************************************************************/
@@ -51,6 +51,15 @@ namespace common {
 
 #endif  // THRILL_HAVE_THREAD_SANITIZER
 
+/******************************************************************************/
+// PREFETCH(address) for reading
+
+#if defined(__GNUC__) || defined(__clang__)
+#define THRILL_PREFETCH(addr) __builtin_prefetch((addr))
+#else
+#define THRILL_PREFETCH(addr)
+#endif
+
 /******************************************************************************/
 // __attribute__ ((packed))
 
@@ -0,0 +1,222 @@
+/*******************************************************************************
+ * thrill/common/hash.hpp
+ *
+ * Fast non-cryptographic hash functions used by default to partition and
+ * reduce keys. Byte strings are hashed in the style of wyhash: 48 bytes in
+ * three independent 64x64 -> 128 bit multiply lanes per round, and short
+ * strings with a few overlapping loads. Integers are mixed by a single
+ * multiplication, since std::hash is the identity in libstdc++.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_HASH_HEADER
+#define THRILL_COMMON_HASH_HEADER
+
+#include <thrill/common/string_view.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace thrill {
+namespace common {
+
+//! secrets mixed into the hashes
+static constexpr uint64_t hash_secret[4] = {
+    0xA0761D6478BD642Full, 0xE7037ED1A0B428DBull,
+    0x8EBC6AF09C88C6E3ull, 0x589965CC75374CC3ull
+};
+
+//! Multiply a and b into a 128 bit product, and return its lower half in a
+//! and its upper half in b.
+static inline void HashMultiply(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(*a) * *b;
+    *a = static_cast<uint64_t>(r);
+    *b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+//! Multiply a and b and fold the 128 bit product into 64 bits.
+static inline uint64_t HashMix(uint64_t a, uint64_t b) {
+    HashMultiply(&a, &b);
+    return a ^ b;
+}
+
+//! Mix the bits of an integer, such that all bits of the result depend on all
+//! bits of the input.
+static inline uint64_t HashInteger(uint64_t x) {
+    return HashMix(x ^ hash_secret[0], hash_secret[1]);
+}
+
+//! Combine two hash values into one, the order matters.
+static inline uint64_t HashCombine(uint64_t a, uint64_t b) {
+    return HashMix(a ^ hash_secret[2], b ^ hash_secret[3]);
+}
+
+//! Hash a byte string with an optional seed.
+static inline uint64_t HashBytes(
+    const void* data, size_t size, uint64_t seed = 0) {
+
+    auto read8 = [](const uint8_t* p) {
+                     uint64_t v;
+                     std::memcpy(&v, p, sizeof(v));
+                     return v;
+                 };
+    auto read4 = [](const uint8_t* p) {
+                     uint32_t v;
+                     std::memcpy(&v, p, sizeof(v));
+                     return static_cast<uint64_t>(v);
+                 };
+
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint64_t* s = hash_secret;
+
+    seed ^= HashMix(seed ^ s[0], s[1]);
+
+    uint64_t a, b;
+    if (size <= 16) {
+        if (size >= 4) {
+            // two overlapping pairs of 4 byte loads cover 4..16 bytes
+            size_t shift = (size >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + shift);
+            b = (read4(p + size - 4) << 32) | read4(p + size - 4 - shift);
+        }
+        else if (size > 0) {
+            a = (static_cast<uint64_t>(p[0]) << 16)
+                | (static_cast<uint64_t>(p[size >> 1]) << 8) | p[size - 1];
+            b = 0;
+        }
+        else {
+            a = b = 0;
+        }
+    }
+    else {
+        size_t i = size;
+        if (i > 48) {
+            // three independent lanes, such that the multiplications overlap
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = HashMix(read8(p) ^ s[1], read8(p + 8) ^ seed);
+                seed1 = HashMix(read8(p + 16) ^ s[2], read8(p + 24) ^ seed1);
+                seed2 = HashMix(read8(p + 32) ^ s[3], read8(p + 40) ^ seed2);
+                p += 48, i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = HashMix(read8(p) ^ s[1], read8(p + 8) ^ seed);
+            p += 16, i -= 16;
+        }
+        // the last 16 bytes, which may overlap the previous ones
+        a = read8(p + i - 16);
+        b = read8(p + i - 8);
+    }
+
+    a ^= s[1], b ^= seed;
+    HashMultiply(&a, &b);
+    return HashMix(a ^ s[0] ^ size, b ^ s[1]);
+}
+
+/*!
+ * Default hash function object for keys of ReduceByKey, GroupByKey and
+ * InnerJoin. Integers, enums, and pointers are mixed with HashInteger(),
+ * strings hashed with HashBytes(), and pairs and tuples combine the hashes of
+ * their members. All other types use std::hash, whose result is mixed again.
+ */
+template <typename Type, typename Enable = void>
+struct Hash {
+    size_t operator () (const Type& v) const {
+        return HashInteger(std::hash<Type>()(v));
+    }
+};
+
+template <typename Type>
+struct Hash<Type, typename std::enable_if<
+                std::is_integral<Type>::value || std::is_enum<Type>::value>::type>{
+    size_t operator () (const Type& v) const {
+        return HashInteger(static_cast<uint64_t>(v));
+    }
+};
+
+template <typename Type>
+struct Hash<Type*>{
+    size_t operator () (Type* const& v) const {
+        return HashInteger(reinterpret_cast<uintptr_t>(v));
+    }
+};
+
+template <>
+struct Hash<std::string>{
+    size_t operator () (const std::string& v) const {
+        return HashBytes(v.data(), v.size());
+    }
+};
+
+template <>
+struct Hash<StringView>{
+    size_t operator () (const StringView& v) const {
+        return HashBytes(v.data(), v.size());
+    }
+};
+
+template <>
+struct Hash<FastString>{
+    size_t operator () (const FastString& v) const {
+        return HashBytes(v.Data(), v.Size());
+    }
+};
+
+template <typename First, typename Second>
+struct Hash<std::pair<First, Second> >{
+    size_t operator () (const std::pair<First, Second>& v) const {
+        return HashCombine(Hash<First>()(v.first), Hash<Second>()(v.second));
+    }
+};
+
+template <typename ... Types>
+struct Hash<std::tuple<Types ...> >{
+    size_t operator () (const std::tuple<Types ...>& v) const {
+        return Combine(v, std::integral_constant<size_t, 0>());
+    }
+
+private:
+    template <size_t Index>
+    static uint64_t Combine(const std::tuple<Types ...>& v,
+                            std::integral_constant<size_t, Index>) {
+        using Type = typename std::tuple_element<
+                  Index, std::tuple<Types ...> >::type;
+        return HashCombine(
+            Hash<Type>()(std::get<Index>(v)),
+            Combine(v, std::integral_constant<size_t, Index + 1>()));
+    }
+
+    static uint64_t Combine(const std::tuple<Types ...>&,
+                            std::integral_constant<size_t, sizeof ... (Types)>) {
+        return 0;
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_HASH_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * thrill/common/hyperloglog.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_HYPERLOGLOG_HEADER
+#define THRILL_COMMON_HYPERLOGLOG_HEADER
+
+#include <thrill/common/math.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * HyperLogLog sketch for estimating the number of distinct items from their
+ * 64-bit hashes. It uses 2^precision one-byte registers, and the standard error
+ * of the estimate is about 1.04 / sqrt(2^precision), i.e. 0.8% for the default
+ * precision of 14 with 16 KiB of registers. Two sketches of the same precision
+ * are merged by taking the maximum of each register, hence the registers can be
+ * combined with an AllReduce.
+ */
+class HyperLogLog
+{
+public:
+    explicit HyperLogLog(unsigned precision = 14)
+        : precision_(precision), registers_(size_t(1) << precision, 0) {
+        assert(precision >= 4 && precision <= 18);
+    }
+
+    //! Adds the hash of an item. The hash is mixed again with the splitmix64
+    //! finalizer, since the index and the rank need independent random bits,
+    //! which a single multiplication like common::HashInteger does not give.
+    void Insert(uint64_t hash) {
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+
+        size_t index = hash >> (64 - precision_);
+        // rank of the lowest one bit in the remaining bits, the sentinel bit
+        // bounds it if all remaining bits are zero.
+        unsigned long long rest =
+            hash | (static_cast<unsigned long long>(1) << (64 - precision_));
+        uint8_t rank = static_cast<uint8_t>(ffs(rest));
+        if (registers_[index] < rank) registers_[index] = rank;
+    }
+
+    //! Merges the registers of another sketch into this one.
+    void Merge(const HyperLogLog& other) {
+        MergeRegisters(&registers_, other.registers_);
+    }
+
+    //! Merges two register vectors of the same precision, elementwise maximum.
+    static void MergeRegisters(std::vector<uint8_t>* a,
+                               const std::vector<uint8_t>& b) {
+        assert(a->size() == b.size());
+        for (size_t i = 0; i < a->size(); ++i)
+            (*a)[i] = std::max((*a)[i], b[i]);
+    }
+
+    //! Returns the estimated number of distinct items.
+    double Estimate() const {
+        return Estimate(registers_);
+    }
+
+    //! Returns the estimated number of distinct items of a register vector.
+    static double Estimate(const std::vector<uint8_t>& registers) {
+        double m = static_cast<double>(registers.size());
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (const uint8_t& r : registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(r));
+            if (r == 0) ++zeros;
+        }
+
+        double alpha = 0.7213 / (1.0 + 1.079 / m);
+        double estimate = alpha * m * m / sum;
+
+        // small range correction with linear counting
+        if (estimate <= 2.5 * m && zeros != 0)
+            estimate = m * std::log(m / static_cast<double>(zeros));
+
+        return estimate;
+    }
+
+    //! Returns the registers.
+    const std::vector<uint8_t>& registers() const { return registers_; }
+
+    //! Returns the registers.
+    std::vector<uint8_t>& registers() { return registers_; }
+
+private:
+    //! number of index bits
+    unsigned precision_;
+    //! one register per index
+    std::vector<uint8_t> registers_;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_HYPERLOGLOG_HEADER
+
+/******************************************************************************/
@@ -27,19 +27,51 @@ namespace common {
 /******************************************************************************/
 // JsonLogger
 
-JsonLogger::JsonLogger(const std::string& path) {
-    if (!path.size()) return;
-
-    os_.open(path.c_str());
-    if (!os_.good()) {
-        die("Could not open json log output: "
-            << path << " : " << strerror(errno));
+JsonLogger::JsonLogger(const std::string& path, LineTap tap)
+    : tap_(std::move(tap)) {
+    if (path.size()) {
+        os_.open(path.c_str());
+        if (!os_.good()) {
+            die("Could not open json log output: "
+                << path << " : " << strerror(errno));
+        }
+    }
+    else if (!tap_) {
+        return;
     }
+
+    writer_ = std::thread([this]() { WriterLoop(); });
 }
 
 JsonLogger::JsonLogger(JsonLogger* super)
     : super_(super) { }
 
+JsonLogger::~JsonLogger() {
+    if (!writer_.joinable()) return;
+    // empty line as sentinel, all lines before it are written.
+    queue_.emplace();
+    writer_.join();
+}
+
+void JsonLogger::WriterLoop() {
+    NameThisThread("json-logger");
+
+    std::string line;
+    while (true) {
+        queue_.pop(line);
+        // write all available lines before flushing.
+        do {
+            if (line.empty()) {
+                if (os_.is_open()) os_.flush();
+                return;
+            }
+            if (tap_) tap_(line);
+            if (os_.is_open()) os_ << line;
+        } while (queue_.try_pop(line));
+        if (os_.is_open()) os_.flush();
+    }
+}
+
 JsonLine JsonLogger::line() {
     if (super_) {
         JsonLine out = super_->line();
@@ -51,8 +83,8 @@ JsonLine JsonLogger::line() {
         return out;
     }
 
-    JsonLine out(this, os_);
-    os_ << '{';
+    JsonLine out(this);
+    out.os_ << '{';
 
     // output timestamp in microseconds
     out << "ts"
@@ -14,13 +14,16 @@
 #ifndef THRILL_COMMON_JSON_LOGGER_HEADER
 #define THRILL_COMMON_JSON_LOGGER_HEADER
 
+#include <thrill/common/mpsc_queue.hpp>
+
 #include <array>
 #include <cassert>
 #include <fstream>
+#include <functional>
 #include <initializer_list>
-#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace thrill {
@@ -47,6 +50,11 @@ using Array = Type[];
 
 /*!
  * JsonLogger is a receiver of JSON output objects for logging.
+ *
+ * Each JsonLine is formatted into its own buffer without any lock. Finished
+ * lines are handed to the top logger's lock-free MpscQueue, which a background
+ * thread drains into the output file, hence threads never wait on file I/O or
+ * on each other while logging.
  */
 class JsonLogger
 {
@@ -54,8 +62,20 @@ public:
     //! open JsonLogger with ofstream uninitialized to discard log output.
     JsonLogger() = default;
 
-    //! open JsonLogger with ofstream
-    explicit JsonLogger(const std::string& path);
+    //! non-copyable: delete copy-constructor
+    JsonLogger(const JsonLogger&) = delete;
+    //! non-copyable: delete assignment operator
+    JsonLogger& operator = (const JsonLogger&) = delete;
+
+    //! destructor: write all queued lines and stop the writer thread.
+    ~JsonLogger();
+
+    //! function receiving each finished line in the writer thread
+    using LineTap = std::function<void(const std::string& line)>;
+
+    //! open JsonLogger with ofstream, and optionally pass each line to a tap,
+    //! which also keeps lines when no path is given.
+    explicit JsonLogger(const std::string& path, LineTap tap = LineTap());
 
     //! open JsonLogger with a super logger
     explicit JsonLogger(JsonLogger* super);
@@ -78,11 +98,26 @@ public:
     //! output to superior JsonLogger
     JsonLogger* super_ = nullptr;
 
-    //! direct output stream for top loggers
+    //! direct output stream for top loggers, only written by writer_
     std::ofstream os_;
 
-    //! mutex to lock logger output
-    std::mutex mutex_;
+    //! optional receiver of all lines, called by writer_
+    LineTap tap_;
+
+    //! finished lines for writer_, an empty string stops the thread.
+    MpscQueue<std::string> queue_;
+
+    //! background thread writing lines from queue_ to os_
+    std::thread writer_;
+
+    //! hand a finished line to the writer thread, or discard it if there is no
+    //! output file or tap.
+    void Deliver(std::string&& line) {
+        if (writer_.joinable()) queue_.emplace(std::move(line));
+    }
+
+    //! main loop of writer_
+    void WriterLoop();
 
     //! common items outputted to each line
     JsonVerbatim common_;
@@ -101,22 +136,25 @@ public:
 class JsonLine
 {
 public:
-    //! ctor: bind output
+    //! ctor: bind output, without a logger the text is only written to os.
     JsonLine(JsonLogger* logger, std::ostream& os)
-        : logger_(logger), os_(os) {
-        if (logger)
-            lock_ = std::unique_lock<std::mutex>(logger_->mutex_);
-    }
+        : logger_(logger), os_(os) { }
+
+    //! ctor: format a line into an own buffer, which is delivered to the
+    //! logger on Close().
+    explicit JsonLine(JsonLogger* logger)
+        : logger_(logger), os_(oss_) { }
 
     //! non-copyable: delete copy-constructor
     JsonLine(const JsonLine&) = delete;
     //! non-copyable: delete assignment operator
     JsonLine& operator = (const JsonLine&) = delete;
-    //! move-constructor: unlink pointer
+    //! move-constructor: unlink pointer, and take over the own buffer.
     JsonLine(JsonLine&& o)
-        : logger_(o.logger_), lock_(std::move(o.lock_)),
-          os_(o.os_), items_(o.items_), sub_dict_(o.sub_dict_)
-    { o.logger_ = nullptr; }
+        : logger_(o.logger_), oss_(std::move(o.oss_)),
+          os_(&o.os_ == &o.oss_ ? static_cast<std::ostream&>(oss_) : o.os_),
+          items_(o.items_), sub_dict_(o.sub_dict_)
+    { o.logger_ = nullptr, o.sub_dict_ = false; }
 
     //! output any type
     template <typename Type>
@@ -131,7 +169,8 @@ public:
     void Close() {
         if (logger_ && items_ != 0) {
             assert(items_ % 2 == 0);
-            os_ << '}' << std::endl;
+            os_ << '}' << '\n';
+            logger_->Deliver(oss_.str());
             items_ = 0;
         }
         else if (!logger_ && sub_dict_) {
@@ -189,8 +228,8 @@ private:
     //! when destructed this object is delivered to the output.
     JsonLogger* logger_ = nullptr;
 
-    //! lock on the logger output stream
-    std::unique_lock<std::mutex> lock_;
+    //! buffer of lines of a logger, unused by sub-dictionaries.
+    std::ostringstream oss_;
 
     //! construct sub-dictionary
     JsonLine(bool /* sentinel */, JsonLine& parent)
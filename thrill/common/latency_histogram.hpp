@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * thrill/common/latency_histogram.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_LATENCY_HISTOGRAM_HEADER
+#define THRILL_COMMON_LATENCY_HISTOGRAM_HEADER
+
+#include <thrill/common/math.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Histogram of latencies with logarithmic buckets, which one thread may fill
+ * while another one takes the counts. Bucket 0 counts latencies below 2
+ * microseconds, bucket i > 0 those in [2^i, 2^(i+1)) microseconds, and the last
+ * bucket all larger ones.
+ */
+class LatencyHistogram
+{
+public:
+    using steady_clock = std::chrono::steady_clock;
+
+    //! number of buckets
+    static constexpr size_t kBuckets = 32;
+
+    //! Adds a latency.
+    void Add(const steady_clock::duration& latency) {
+        uint64_t us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                latency).count());
+        size_t b = us < 2 ? 0 : IntegerLog2Floor(us);
+        if (b >= kBuckets) b = kBuckets - 1;
+        buckets_[b].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! Adds the latency since start.
+    void AddSince(const steady_clock::time_point& start) {
+        Add(steady_clock::now() - start);
+    }
+
+    //! Returns the counts added since the last call and resets them, without
+    //! trailing empty buckets.
+    std::vector<size_t> Take() {
+        std::vector<size_t> counts(kBuckets);
+        for (size_t b = 0; b < kBuckets; ++b)
+            counts[b] = buckets_[b].exchange(0, std::memory_order_relaxed);
+        while (!counts.empty() && counts.back() == 0)
+            counts.pop_back();
+        return counts;
+    }
+
+    //! Adds the counts taken from another histogram.
+    static void Merge(std::vector<size_t>* sum,
+                      const std::vector<size_t>& counts) {
+        if (sum->size() < counts.size()) sum->resize(counts.size());
+        for (size_t b = 0; b < counts.size(); ++b)
+            (*sum)[b] += counts[b];
+    }
+
+private:
+    //! counts of the buckets
+    std::array<std::atomic<size_t>, kBuckets> buckets_ { };
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_LATENCY_HISTOGRAM_HEADER
+
+/******************************************************************************/
@@ -16,6 +16,7 @@
 #include <thrill/common/die.hpp>
 #include <thrill/common/json_logger.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/common/profile_task.hpp>
 #include <thrill/common/profile_thread.hpp>
 #include <thrill/common/string.hpp>
@@ -55,6 +56,12 @@ public:
         file_pid_io_.open("/proc/" + std::to_string(mypid) + "/io");
 
         read_sys_block_devices();
+
+        for (size_t n = 0; n < NumaNumNodes(); ++n) {
+            file_numastat_.emplace_back(
+                "/sys/devices/system/node/node" + std::to_string(n)
+                + "/numastat");
+        }
     }
 
     //! read /sys/block to find block devices
@@ -88,6 +95,9 @@ public:
     //! read /proc/diskstats
     void read_diskstats(JsonLine& out);
 
+    //! read /sys/devices/system/node/node*/numastat
+    void read_numastat(JsonLine& out);
+
     void RunTask(const steady_clock::time_point& tp) final {
 
         // JsonLine to construct
@@ -98,6 +108,7 @@ public:
         read_net_dev(tp, out);
         read_pid_io(tp, out);
         read_diskstats(out);
+        read_numastat(out);
 
         tp_last_ = tp;
     }
@@ -116,6 +127,8 @@ private:
     std::ifstream file_pid_io_;
     //! open file handle to /proc/diskstats
     std::ifstream file_diskstats_;
+    //! open file handles to the numastat of each NUMA node
+    std::vector<std::ifstream> file_numastat_;
 
     //! last time point called
     steady_clock::time_point tp_last_;
@@ -195,6 +208,20 @@ private:
         unsigned long long rq_time = 0;
     };
 
+    struct NumaStat {
+        //! pages allocated on the intended node
+        unsigned long long numa_hit = 0;
+        //! pages allocated on this node although intended elsewhere
+        unsigned long long numa_miss = 0;
+        //! pages allocated by a process running on this node
+        unsigned long long local_node = 0;
+        //! pages allocated on this node by a process running on another node
+        unsigned long long other_node = 0;
+    };
+
+    //! previous readings of the numastat of each NUMA node
+    std::vector<NumaStat> numastat_prev_;
+
     //! delta jiffies since the last iteration (read from uptime() of the cpu
     //! summary)
     unsigned long long jiffies_delta_ = 0;
@@ -729,6 +756,55 @@ void LinuxProcStats::read_diskstats(JsonLine& out) {
     }
 }
 
+void LinuxProcStats::read_numastat(JsonLine& out) {
+    if (file_numastat_.size() <= 1) return;
+
+    bool first = numastat_prev_.empty();
+    numastat_prev_.resize(file_numastat_.size());
+
+    NumaStat sum;
+    for (size_t n = 0; n < file_numastat_.size(); ++n) {
+        std::ifstream& file = file_numastat_[n];
+        if (!file.is_open()) continue;
+
+        file.clear();
+        file.seekg(0);
+        if (!file.good()) continue;
+
+        NumaStat curr;
+        std::string name;
+        unsigned long long value;
+        while (file >> name >> value) {
+            if (name == "numa_hit") curr.numa_hit = value;
+            else if (name == "numa_miss") curr.numa_miss = value;
+            else if (name == "local_node") curr.local_node = value;
+            else if (name == "other_node") curr.other_node = value;
+        }
+
+        NumaStat& prev = numastat_prev_[n];
+        sum.numa_hit += curr.numa_hit - prev.numa_hit;
+        sum.numa_miss += curr.numa_miss - prev.numa_miss;
+        sum.local_node += curr.local_node - prev.local_node;
+        sum.other_node += curr.other_node - prev.other_node;
+        prev = curr;
+    }
+
+    // just store the first reading
+    if (first) return;
+
+    sLOG << "numastat"
+         << "numa_hit" << sum.numa_hit
+         << "numa_miss" << sum.numa_miss
+         << "local_node" << sum.local_node
+         << "other_node" << sum.other_node;
+
+    prepare_out(out).sub("numastat")
+        << "numa_hit" << sum.numa_hit
+        << "numa_miss" << sum.numa_miss
+        << "local_node" << sum.local_node
+        << "other_node" << sum.other_node;
+}
+
 void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger) {
     sched.Add(std::chrono::seconds(1),
               new LinuxProcStats(logger), /* own_task */ true);
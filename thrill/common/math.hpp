@@ -156,16 +156,19 @@ public:
 };
 
 //! given a global range [0,global_size) and p PEs to split the range, calculate
-//! the [local_begin,local_end) index range assigned to the PE i.
+//! the [local_begin,local_end) index range assigned to the PE i. The bounds are
+//! exactly ceil(i * global_size / p), hence index k belongs to PE k * p /
+//! global_size.
 static inline Range CalculateLocalRange(
     size_t global_size, size_t p, size_t i) {
 
-    double per_pe = static_cast<double>(global_size) / static_cast<double>(p);
-    return Range(
-        static_cast<size_t>(std::ceil(static_cast<double>(i) * per_pe)),
-        std::min(static_cast<size_t>(
-                     std::ceil(static_cast<double>(i + 1) * per_pe)),
-                 global_size));
+    // split global_size = q * p + r to calculate ceil(i * global_size / p)
+    // without overflow or rounding errors.
+    size_t q = global_size / p, r = global_size % p;
+    auto bound = [q, r, p](size_t j) {
+                     return j * q + (j * r + p - 1) / p;
+                 };
+    return Range(bound(i), std::min(bound(i + 1), global_size));
 }
 
 /******************************************************************************/
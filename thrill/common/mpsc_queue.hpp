@@ -0,0 +1,335 @@
+/*******************************************************************************
+ * thrill/common/mpsc_queue.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_MPSC_QUEUE_HEADER
+#define THRILL_COMMON_MPSC_QUEUE_HEADER
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * A lock-free unbounded queue for many producers and a single consumer, with
+ * the same interface as ConcurrentBoundedQueue. It is a linked list of nodes
+ * following Dmitry Vyukov's MPSC queue: producers append a node with one
+ * atomic exchange on the head, and the consumer pops from the tail without any
+ * atomic read-modify-write. The blocking pop() spins briefly and then sleeps
+ * on a condition variable, which producers only lock and notify if the
+ * consumer announced that it sleeps.
+ *
+ * The consumer recycles popped nodes through a small bounded ring, from which
+ * producers take them with one compare-and-swap (Vyukov's bounded queue, whose
+ * sequence numbers avoid the ABA problem), such that the queue does not
+ * allocate for each item in steady state.
+ *
+ * Only one thread at a time may call the consumer methods pop(), try_pop(),
+ * pop_for(), clear(), empty(), and size(). As for other containers, the queue
+ * must not be destroyed while a producer is still inside emplace(), even if
+ * the consumer already popped its item.
+ */
+template <typename T, typename Allocator = std::allocator<T> >
+class MpscQueue
+{
+public:
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    //! default constructor
+    explicit MpscQueue(const Allocator& alloc = Allocator())
+        : alloc_(alloc) {
+        InitPool();
+        tail_ = NewNode();
+        head_ = tail_;
+    }
+
+    //! non-copyable: delete copy-constructor
+    MpscQueue(const MpscQueue&) = delete;
+    //! non-copyable: delete assignment operator
+    MpscQueue& operator = (const MpscQueue&) = delete;
+
+    //! move-constructor, the other queue must not be used concurrently.
+    MpscQueue(MpscQueue&& other)
+        : alloc_(other.alloc_) {
+        InitPool();
+        tail_ = NewNode();
+        head_ = tail_;
+        other.ClearPool();
+        Swap(other);
+    }
+
+    //! move-assignment, the other queue must not be used concurrently.
+    MpscQueue& operator = (MpscQueue&& other) {
+        if (this != &other) {
+            clear();
+            ClearPool();
+            other.ClearPool();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    //! destructor
+    ~MpscQueue() {
+        clear();
+        DeleteNode(tail_);
+        ClearPool();
+    }
+
+    //! Pushes a copy of source onto back of the queue.
+    void push(const T& source) {
+        emplace(source);
+    }
+
+    //! Pushes given element into the queue by utilizing element's move
+    //! constructor
+    void push(T&& elem) {
+        emplace(std::move(elem));
+    }
+
+    //! Pushes a new element into the queue. The element is constructed with
+    //! given arguments.
+    template <typename ... Arguments>
+    void emplace(Arguments&& ... args) {
+        Node* n = NewNode();
+        new (n->item()) T(std::forward<Arguments>(args) ...);
+
+        Node* prev = head_.exchange(n, std::memory_order_acq_rel);
+        // sequentially consistent with announcing sleep in pop(): either the
+        // consumer sees the item, or this producer sees the consumer sleep.
+        prev->next.store(n, std::memory_order_seq_cst);
+
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            // only the first producer wakes the consumer, which announces
+            // sleeping again before it waits again.
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (sleeping_.load(std::memory_order_relaxed)) {
+                sleeping_.store(false, std::memory_order_relaxed);
+                cv_.notify_one();
+            }
+        }
+    }
+
+    //! Returns: true if queue has no items; false otherwise. Only for the
+    //! consumer, items of unfinished emplace() calls may be missing.
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    //! Clears the queue.
+    void clear() {
+        T item;
+        while (try_pop(item)) { }
+    }
+
+    //! If value is available, pops it from the queue, move it to destination,
+    //! destroying the original position. Otherwise does nothing.
+    bool try_pop(T& destination) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) return false;
+
+        // next becomes the new stub node, after its item is moved out.
+        destination = std::move(*next->item());
+        next->item()->~T();
+        tail_ = next;
+        if (!PoolPush(tail)) DeleteNode(tail);
+        return true;
+    }
+
+    //! If value is available, pops it from the queue, move it to
+    //! destination. If no item is in the queue, wait until there is one.
+    void pop(T& destination) {
+        for (size_t spin = 0; spin < kSpins; ++spin) {
+            if (try_pop(destination)) return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!SleepingTryPop(destination))
+            cv_.wait(lock);
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+
+    //! If value is available, pops it from the queue, move it to
+    //! destination. If no item is in the queue, wait until there is one, or
+    //! timeout and return false. NOTE: not available in TBB!
+    template <typename Rep, typename Period>
+    bool pop_for(T& destination,
+                 const std::chrono::duration<Rep, Period>& timeout) {
+        if (try_pop(destination)) return true;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!SleepingTryPop(destination)) {
+            if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                bool popped = try_pop(destination);
+                sleeping_.store(false, std::memory_order_relaxed);
+                return popped;
+            }
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    //! return number of items available in the queue by walking the list.
+    //! Only for the consumer, and only for debugging.
+    size_t size() const {
+        size_t size = 0;
+        for (Node* n = tail_->next.load(std::memory_order_acquire);
+             n != nullptr; n = n->next.load(std::memory_order_acquire))
+            ++size;
+        return size;
+    }
+
+private:
+    //! node of the linked list, the item is constructed in place.
+    struct Node {
+        std::atomic<Node*> next { nullptr };
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* item() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    using NodeAllocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+
+    //! cell of the ring of recycled nodes
+    struct PoolCell {
+        std::atomic<size_t> seq;
+        Node* node;
+    };
+
+    //! number of recycled nodes kept, a power of two
+    static constexpr size_t kPoolSize = 32;
+
+    //! number of try_pop() calls before pop() sleeps
+    static constexpr size_t kSpins = 64;
+
+    //! allocator of the nodes
+    NodeAllocator alloc_;
+
+    //! node last appended by producers
+    std::atomic<Node*> head_;
+
+    //! stub node in front of the next item, only touched by the consumer.
+    Node* tail_;
+
+    //! ring of recycled nodes
+    std::array<PoolCell, kPoolSize> pool_;
+
+    //! position of the next recycled node, only touched by the consumer
+    size_t pool_push_ = 0;
+
+    //! position of the next node taken by producers
+    std::atomic<size_t> pool_pop_ { 0 };
+
+    //! whether the consumer sleeps or is about to sleep on cv_.
+    std::atomic<bool> sleeping_ { false };
+
+    //! mutex and condition variable for a sleeping consumer
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    Node * NewNode() {
+        Node* n = PoolPop();
+        if (n != nullptr) {
+            n->next.store(nullptr, std::memory_order_relaxed);
+            return n;
+        }
+        n = std::allocator_traits<NodeAllocator>::allocate(alloc_, 1);
+        new (n) Node();
+        return n;
+    }
+
+    void DeleteNode(Node* n) {
+        n->~Node();
+        std::allocator_traits<NodeAllocator>::deallocate(alloc_, n, 1);
+    }
+
+    void InitPool() {
+        for (size_t i = 0; i < kPoolSize; ++i)
+            pool_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    //! frees all recycled nodes, not concurrently with producers.
+    void ClearPool() {
+        while (Node* n = PoolPop()) DeleteNode(n);
+    }
+
+    //! recycles a node unless the ring is full, only called by the consumer.
+    bool PoolPush(Node* n) {
+        PoolCell& cell = pool_[pool_push_ & (kPoolSize - 1)];
+        if (cell.seq.load(std::memory_order_acquire) != pool_push_)
+            return false;
+        cell.node = n;
+        cell.seq.store(pool_push_ + 1, std::memory_order_release);
+        ++pool_push_;
+        return true;
+    }
+
+    //! takes a recycled node, or returns nullptr if there is none.
+    Node * PoolPop() {
+        size_t pos = pool_pop_.load(std::memory_order_relaxed);
+        for ( ; ; ) {
+            PoolCell& cell = pool_[pos & (kPoolSize - 1)];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (dif == 0) {
+                if (pool_pop_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    Node* n = cell.node;
+                    cell.seq.store(pos + kPoolSize, std::memory_order_release);
+                    return n;
+                }
+            }
+            else if (dif < 0) {
+                return nullptr;
+            }
+            else {
+                pos = pool_pop_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! announce sleeping, and try to pop an item pushed before that.
+    bool SleepingTryPop(T& destination) {
+        sleeping_.store(true, std::memory_order_seq_cst);
+        if (tail_->next.load(std::memory_order_seq_cst) == nullptr)
+            return false;
+        return try_pop(destination);
+    }
+
+    //! swap the lists of two queues, which are not used concurrently.
+    void Swap(MpscQueue& other) {
+        Node* head = head_.load(std::memory_order_relaxed);
+        head_.store(other.head_.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        other.head_.store(head, std::memory_order_relaxed);
+        std::swap(tail_, other.tail_);
+        std::swap(alloc_, other.alloc_);
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_MPSC_QUEUE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,248 @@
+/*******************************************************************************
+ * thrill/common/numa.cpp
+ *
+ * Detection of the NUMA topology, pinning of threads to NUMA nodes, and
+ * node-local memory placement.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/numa.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if __linux__
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace thrill {
+namespace common {
+
+static constexpr bool debug = false;
+
+//! parse a sysfs list of ids like "0-3,8,10-11"
+static std::vector<size_t> ParseSysfsList(const std::string& str) {
+    std::vector<size_t> list;
+    const char* s = str.c_str();
+    while (*s) {
+        char* end;
+        size_t first = std::strtoul(s, &end, 10);
+        if (end == s) break;
+        size_t last = first;
+        s = end;
+        if (*s == '-') {
+            last = std::strtoul(s + 1, &end, 10);
+            s = end;
+        }
+        for (size_t i = first; i <= last; ++i) list.push_back(i);
+        if (*s == ',') ++s;
+        else break;
+    }
+    return list;
+}
+
+//! read a sysfs list file, returns an empty list if it does not exist
+static std::vector<size_t> ReadSysfsList(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    if (!in.good() || !std::getline(in, line)) return std::vector<size_t>();
+    return ParseSysfsList(line);
+}
+
+//! ids of the NUMA nodes online, read once
+static const std::vector<size_t>& NumaNodes() {
+    static const std::vector<size_t> nodes = []() {
+        std::vector<size_t> n =
+            ReadSysfsList("/sys/devices/system/node/online");
+        if (n.empty()) n.push_back(0);
+        return n;
+    } ();
+    return nodes;
+}
+
+size_t NumaNumNodes() {
+    return NumaNodes().size();
+}
+
+std::vector<size_t> NumaNodeCpus(size_t node) {
+    return ReadSysfsList(
+        "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+}
+
+bool NumaEnabled() {
+    static const bool enabled = []() {
+        const char* env = getenv("THRILL_NUMA");
+        if (env && *env == '0') return false;
+        return NumaNumNodes() > 1;
+    } ();
+    return enabled;
+}
+
+size_t NumaNodeOfWorker(size_t worker_id, size_t num_workers) {
+    const std::vector<size_t>& nodes = NumaNodes();
+    if (num_workers == 0) return nodes[0];
+    return nodes[(worker_id % num_workers) * nodes.size() / num_workers];
+}
+
+//! ids of all CPUs online, read once
+static const std::vector<size_t>& OnlineCpus() {
+    static const std::vector<size_t> cpus =
+        ReadSysfsList("/sys/devices/system/cpu/online");
+    return cpus;
+}
+
+//! Pin the calling thread to a set of CPUs
+static bool PinThisThread(const std::vector<size_t>& cpus) {
+#if __linux__
+    if (cpus.empty()) return false;
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const size_t& c : cpus) {
+        if (c < CPU_SETSIZE) CPU_SET(c, &cpu_set);
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+        LOG << "PinThisThread() failed";
+        return false;
+    }
+    return true;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+//! remove the reserved service CPUs from a list of CPUs
+static std::vector<size_t> WithoutServiceCpus(std::vector<size_t> cpus) {
+    const std::vector<size_t>& service = ServiceCpus();
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                              [&service](const size_t& c) {
+                                  return std::find(service.begin(),
+                                                   service.end(), c)
+                                  != service.end();
+                              }),
+               cpus.end());
+    return cpus;
+}
+
+bool NumaPinThisThread(size_t node) {
+    std::vector<size_t> cpus = NumaNodeCpus(node);
+    if (cpus.empty()) return false;
+
+    // keep workers off the service CPUs, unless the node has no other ones.
+    std::vector<size_t> worker_cpus = WithoutServiceCpus(cpus);
+    if (!PinThisThread(worker_cpus.empty() ? cpus : worker_cpus)) {
+        LOG << "NumaPinThisThread() failed for node " << node;
+        return false;
+    }
+    return true;
+}
+
+void NumaPinWorker(size_t worker_id, size_t num_workers) {
+    if (!NumaEnabled()) {
+        if (ServiceCpus().empty()) return;
+        sLOG << "NumaPinWorker() worker" << worker_id
+             << "to all but the service CPUs";
+        PinThisThread(WithoutServiceCpus(OnlineCpus()));
+        return;
+    }
+    size_t node = NumaNodeOfWorker(worker_id, num_workers);
+    sLOG << "NumaPinWorker() worker" << worker_id << "to node" << node;
+    NumaPinThisThread(node);
+}
+
+size_t NumServiceCores() {
+    static const size_t num = []() -> size_t {
+        const char* env = getenv("THRILL_SERVICE_CORES");
+        if (!env || !*env) return 0;
+        return std::strtoul(env, nullptr, 10);
+    } ();
+    return num;
+}
+
+const std::vector<size_t>& ServiceCpus() {
+    static const std::vector<size_t> cpus = []() {
+        std::vector<size_t> result;
+        size_t num = NumServiceCores();
+        if (num == 0) return result;
+
+        // CPU lists of the nodes, or one list of all CPUs without NUMA info
+        std::vector<std::vector<size_t> > node_cpus;
+        for (const size_t& node : NumaNodes()) {
+            node_cpus.emplace_back(NumaNodeCpus(node));
+            if (node_cpus.back().empty()) node_cpus.pop_back();
+        }
+        if (node_cpus.empty())
+            node_cpus.emplace_back(OnlineCpus());
+
+        size_t total = 0;
+        for (const std::vector<size_t>& c : node_cpus) total += c.size();
+        if (num >= total) {
+            LOG1 << "THRILL_SERVICE_CORES=" << num << " would leave no CPUs"
+                 << " for workers, ignoring it.";
+            return result;
+        }
+
+        // take the last CPUs of the nodes in turn
+        for (size_t i = 0; result.size() < num; ++i) {
+            std::vector<size_t>& c = node_cpus[i % node_cpus.size()];
+            if (c.empty()) continue;
+            result.push_back(c.back());
+            c.pop_back();
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    } ();
+    return cpus;
+}
+
+void PinServiceThread() {
+    const std::vector<size_t>& cpus = ServiceCpus();
+    if (cpus.empty()) return;
+    PinThisThread(cpus);
+}
+
+void NumaPreferMemory(void* addr, size_t size, size_t node) {
+#if __linux__ && defined(SYS_mbind)
+    if (!NumaEnabled()) return;
+
+    // only whole pages can be bound.
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t end = begin + size;
+    begin = (begin + page_size - 1) & ~(page_size - 1);
+    end = end & ~(page_size - 1);
+    if (begin >= end) return;
+
+    // MPOL_PREFERRED of linux/mempolicy.h
+    static constexpr int mpol_preferred = 1;
+    static constexpr size_t word_bits = 8 * sizeof(unsigned long);
+
+    std::vector<unsigned long> nodemask(node / word_bits + 1);
+    nodemask[node / word_bits] = 1ul << (node % word_bits);
+
+    if (syscall(SYS_mbind, begin, end - begin, mpol_preferred,
+                nodemask.data(), nodemask.size() * word_bits + 1, 0) != 0) {
+        LOG << "NumaPreferMemory() mbind failed for node " << node;
+    }
+#else
+    (void)addr, (void)size, (void)node;
+#endif
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
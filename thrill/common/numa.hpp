@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * thrill/common/numa.hpp
+ *
+ * Detection of the NUMA topology, pinning of threads to NUMA nodes, and
+ * node-local memory placement. Uses only sysfs and system calls, hence all
+ * functions fall back to a single node on other systems.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_NUMA_HEADER
+#define THRILL_COMMON_NUMA_HEADER
+
+#include <cstddef>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+//! Return the number of NUMA nodes of the machine, or 1 if unknown.
+size_t NumaNumNodes();
+
+//! Return the CPU ids of a NUMA node.
+std::vector<size_t> NumaNodeCpus(size_t node);
+
+//! Whether worker threads are pinned to NUMA nodes and ByteBlocks are placed
+//! on their worker's node. Enabled if the machine has more than one node,
+//! unless THRILL_NUMA=0 is set.
+bool NumaEnabled();
+
+//! Return the NUMA node of worker worker_id of num_workers threads, which are
+//! distributed in equally sized consecutive ranges onto the nodes.
+size_t NumaNodeOfWorker(size_t worker_id, size_t num_workers);
+
+//! Pin the calling thread to the CPUs of the NUMA node. Returns false if
+//! pinning is not supported.
+bool NumaPinThisThread(size_t node);
+
+//! Pin the calling thread to the NUMA node of worker_id if NumaEnabled(). If
+//! service cores are reserved, the worker is pinned to the remaining CPUs of
+//! its node, or of the machine without NUMA.
+void NumaPinWorker(size_t worker_id, size_t num_workers);
+
+//! Return the number of CPUs reserved for service threads (I/O queues,
+//! dispatchers, profiler) as set by THRILL_SERVICE_CORES, default 0.
+size_t NumServiceCores();
+
+//! Return the CPU ids reserved for service threads: the last CPUs of the NUMA
+//! nodes, taken from the nodes in turn. Empty if none are reserved, or if all
+//! CPUs would be reserved.
+const std::vector<size_t>& ServiceCpus();
+
+//! Pin the calling service thread to the reserved service CPUs, if any.
+void PinServiceThread();
+
+//! Set the preferred NUMA node of the pages in the memory area, which places
+//! them on the node when they are first touched. Pages only partially covered
+//! by the area are not changed. Does nothing if not NumaEnabled().
+void NumaPreferMemory(void* addr, size_t size, size_t node);
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_NUMA_HEADER
+
+/******************************************************************************/
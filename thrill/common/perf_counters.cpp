@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * thrill/common/perf_counters.cpp
+ *
+ * Hardware performance counters of the calling thread via perf_event_open().
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/perf_counters.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace thrill {
+namespace common {
+
+bool PerfCounters::Enabled() {
+    static const bool enabled = []() {
+        const char* env = getenv("THRILL_PERF_COUNTERS");
+        return env && *env == '1';
+    } ();
+    return enabled;
+}
+
+const char* PerfCounters::Name(size_t event) {
+    static const char* names[kEvents] = {
+        "cycles", "instructions", "llc_misses", "branch_misses"
+    };
+    return event < kEvents ? names[event] : "unknown";
+}
+
+#if __linux__
+
+namespace {
+
+/*!
+ * Group of counters of one thread, the first is the group leader such that all
+ * are scheduled together and read with a single read().
+ */
+class ThreadCounters
+{
+    static constexpr bool debug = false;
+
+public:
+    ThreadCounters() {
+        static const uint64_t configs[PerfCounters::kEvents] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (size_t i = 0; i < PerfCounters::kEvents; ++i) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.disabled = (i == 0);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            fd_[i] = static_cast<int>(
+                syscall(__NR_perf_event_open, &attr, 0, -1,
+                        i == 0 ? -1 : fd_[0], 0));
+            if (fd_[i] < 0) {
+                LOG << "perf_event_open() failed for "
+                    << PerfCounters::Name(i) << ": " << strerror(errno);
+                Close();
+                return;
+            }
+        }
+
+        ioctl(fd_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    ~ThreadCounters() { Close(); }
+
+    bool Read(PerfCounters::Values* values) {
+        if (fd_[0] < 0) return false;
+
+        // PERF_FORMAT_GROUP: number of counters, then their values
+        uint64_t data[1 + PerfCounters::kEvents];
+        if (read(fd_[0], data, sizeof(data)) != sizeof(data))
+            return false;
+        for (size_t i = 0; i < PerfCounters::kEvents; ++i)
+            (*values)[i] = data[1 + i];
+        return true;
+    }
+
+private:
+    //! file descriptors of the counters, -1 if not open
+    int fd_[PerfCounters::kEvents] = { -1, -1, -1, -1 };
+
+    void Close() {
+        for (size_t i = 0; i < PerfCounters::kEvents; ++i) {
+            if (fd_[i] >= 0) close(fd_[i]);
+            fd_[i] = -1;
+        }
+    }
+};
+
+} // namespace
+
+bool PerfCounters::Read(Values* values) {
+    if (!Enabled()) return false;
+    static thread_local ThreadCounters counters;
+    return counters.Read(values);
+}
+
+#else
+
+bool PerfCounters::Read(Values* /* values */) {
+    return false;
+}
+
+#endif
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * thrill/common/perf_counters.hpp
+ *
+ * Hardware performance counters of the calling thread via perf_event_open().
+ * Falls back to no counters on other systems or if the kernel denies access.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_PERF_COUNTERS_HEADER
+#define THRILL_COMMON_PERF_COUNTERS_HEADER
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Counts hardware events of the calling thread in user space. The counters are
+ * opened lazily once per thread and read to measure the difference between two
+ * points in time.
+ */
+class PerfCounters
+{
+public:
+    //! counted events
+    enum Event { Cycles, Instructions, CacheMisses, BranchMisses, kEvents };
+
+    //! counter values, indexed by Event
+    using Values = std::array<uint64_t, kEvents>;
+
+    //! Whether the counters are enabled, which requires THRILL_PERF_COUNTERS=1
+    //! because opening them costs a few system calls per thread.
+    static bool Enabled();
+
+    //! Read the counters of the calling thread. Returns false if they are not
+    //! enabled or cannot be opened.
+    static bool Read(Values* values);
+
+    //! Name of the event for JSON output
+    static const char * Name(size_t event);
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_PERF_COUNTERS_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * thrill/common/philox.hpp
+ *
+ * Counter-based random number generator Philox4x32-10 of Salmon et al.
+ * "Parallel Random Numbers: As Easy as 1, 2, 3" (SC'11), which computes the
+ * random numbers of any position of any stream directly from a key.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_PHILOX_HEADER
+#define THRILL_COMMON_PHILOX_HEADER
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * The Philox4x32-10 bijection: encrypts a 128-bit counter with a 64-bit key in
+ * ten rounds of multiplications and xors. Consecutive counters yield streams
+ * of independent random numbers, without any state besides the key.
+ */
+class Philox4x32
+{
+public:
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    explicit Philox4x32(uint64_t key = 0)
+        : key_({ { static_cast<uint32_t>(key),
+                   static_cast<uint32_t>(key >> 32) } }) { }
+
+    //! return the four random words of counter ctr
+    Counter operator () (Counter ctr) const {
+        Key key = key_;
+        for (size_t r = 0; r < 9; ++r) {
+            ctr = Round(ctr, key);
+            key[0] += w0, key[1] += w1;
+        }
+        return Round(ctr, key);
+    }
+
+    //! return the four random words of position index of stream
+    Counter operator () (uint64_t index, uint64_t stream) const {
+        return operator () (
+            Counter { { static_cast<uint32_t>(index),
+                        static_cast<uint32_t>(index >> 32),
+                        static_cast<uint32_t>(stream),
+                        static_cast<uint32_t>(stream >> 32) } });
+    }
+
+    //! return a random 64-bit word for index, e.g. the item index of a DIA
+    uint64_t Random(uint64_t index, uint64_t stream = 0) const {
+        Counter c = operator () (index, stream);
+        return (static_cast<uint64_t>(c[1]) << 32) | c[0];
+    }
+
+    const Key& key() const { return key_; }
+
+private:
+    //! multipliers and key increments (golden ratio and sqrt(3)-1)
+    static constexpr uint32_t m0 = 0xD2511F53, m1 = 0xCD9E8D57;
+    static constexpr uint32_t w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+
+    //! key
+    Key key_;
+
+    static Counter Round(const Counter& c, const Key& k) {
+        uint64_t p0 = static_cast<uint64_t>(m0) * c[0];
+        uint64_t p1 = static_cast<uint64_t>(m1) * c[2];
+        return Counter {
+                   { static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+                     static_cast<uint32_t>(p1),
+                     static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+                     static_cast<uint32_t>(p0) }
+        };
+    }
+};
+
+/*!
+ * A UniformRandomBitGenerator returning 64-bit words from the stream of a
+ * Philox4x32 generator, for use with the distributions in <random>. Seeding is
+ * free, hence a new engine can be created for each item: PhiloxEngine(seed, i)
+ * yields the same numbers for item i, regardless of which thread or worker
+ * draws them.
+ */
+class PhiloxEngine
+{
+public:
+    using result_type = uint64_t;
+
+    explicit PhiloxEngine(uint64_t seed = 0, uint64_t stream = 0)
+        : philox_(seed), stream_(stream) { }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    //! return the next random 64-bit word
+    result_type operator () () {
+        if (pos_ == 2) {
+            buffer_ = philox_(index_++, stream_);
+            pos_ = 0;
+        }
+        const size_t p = 2 * pos_++;
+        return (static_cast<uint64_t>(buffer_[p + 1]) << 32) | buffer_[p];
+    }
+
+    //! restart the engine at the beginning of a stream
+    void seed(uint64_t seed, uint64_t stream = 0) {
+        philox_ = Philox4x32(seed);
+        stream_ = stream;
+        index_ = 0, pos_ = 2;
+    }
+
+    //! skip n random words
+    void discard(uint64_t n) {
+        for ( ; n != 0 && pos_ != 2; --n) ++pos_;
+        index_ += n / 2;
+        if (n % 2) operator () ();
+    }
+
+private:
+    //! the bijection
+    Philox4x32 philox_;
+    //! stream number, the upper counter words
+    uint64_t stream_;
+    //! next position in the stream, the lower counter words
+    uint64_t index_ = 0;
+    //! random words of the current counter
+    Philox4x32::Counter buffer_;
+    //! next 64-bit word in buffer_, 2 if it is used up
+    size_t pos_ = 2;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_PHILOX_HEADER
+
+/******************************************************************************/
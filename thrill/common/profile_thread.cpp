@@ -11,6 +11,7 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/common/numa.hpp>
 #include <thrill/common/profile_thread.hpp>
 
 namespace thrill {
@@ -42,6 +43,8 @@ bool ProfileThread::Remove(ProfileTask* task) {
 }
 
 void ProfileThread::Worker() {
+    PinServiceThread();
+
     std::unique_lock<std::timed_mutex> lock(mutex_);
 
     steady_clock::time_point tm = steady_clock::now();
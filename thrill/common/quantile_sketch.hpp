@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * thrill/common/quantile_sketch.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_QUANTILE_SKETCH_HEADER
+#define THRILL_COMMON_QUANTILE_SKETCH_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * KLL sketch for approximate quantiles of a stream of items (Karnin, Lang,
+ * Liberty, "Optimal Quantile Approximation in Streams", 2016). Items are kept
+ * in levels of compactors, an item on level h stands for 2^h input items. If a
+ * level exceeds its capacity, it is sorted and every second item, starting at
+ * a random offset, is promoted to the next level. Level capacities shrink by
+ * 2/3 below the top level, hence the sketch holds O(k) items, and the rank
+ * error is about 1.7 / k of the number of items for the default k = 200.
+ *
+ * Two sketches are merged by concatenating their levels and compacting again,
+ * hence the levels can be combined with an AllReduce.
+ */
+template <typename ValueType, typename CompareFunction = std::less<ValueType> >
+class QuantileSketch
+{
+public:
+    using Levels = std::vector<std::vector<ValueType> >;
+
+    explicit QuantileSketch(
+        size_t k = 200,
+        const CompareFunction& compare_function = CompareFunction())
+        : k_(k), compare_function_(compare_function), levels_(1),
+          capacity0_(k) {
+        assert(k >= 8);
+    }
+
+    //! Adds an item.
+    void Insert(const ValueType& item) {
+        levels_[0].push_back(item);
+        if (levels_[0].size() >= capacity0_) Compress();
+    }
+
+    //! Merges the levels of another sketch into this one.
+    void Merge(const Levels& other) {
+        if (levels_.size() < other.size()) levels_.resize(other.size());
+        for (size_t h = 0; h < other.size(); ++h) {
+            levels_[h].insert(levels_[h].end(),
+                              other[h].begin(), other[h].end());
+        }
+        Compress();
+    }
+
+    //! Returns the approximate q-quantile for q in [0,1] of the items added.
+    //! Requires at least one item.
+    ValueType Quantile(double q) const {
+        return Quantiles(std::vector<double>(1, q))[0];
+    }
+
+    //! Returns the approximate quantiles for all q in qs, which need not be
+    //! sorted. Requires at least one item.
+    std::vector<ValueType> Quantiles(const std::vector<double>& qs) const {
+        // sort all items with their weights
+        std::vector<std::pair<ValueType, uint64_t> > items;
+        uint64_t total = 0;
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            for (const ValueType& v : levels_[h])
+                items.emplace_back(v, uint64_t(1) << h);
+            total += levels_[h].size() << h;
+        }
+        assert(!items.empty());
+
+        std::sort(items.begin(), items.end(),
+                  [this](const std::pair<ValueType, uint64_t>& a,
+                         const std::pair<ValueType, uint64_t>& b) {
+                      return compare_function_(a.first, b.first);
+                  });
+
+        std::vector<ValueType> out;
+        out.reserve(qs.size());
+        for (const double& q : qs) {
+            assert(q >= 0.0 && q <= 1.0);
+            // first item whose cumulative weight reaches the rank q * total
+            uint64_t rank = static_cast<uint64_t>(
+                std::ceil(q * static_cast<double>(total)));
+            uint64_t sum = 0;
+            size_t i = 0;
+            while (i + 1 < items.size() && sum + items[i].second < rank)
+                sum += items[i++].second;
+            out.push_back(items[i].first);
+        }
+        return out;
+    }
+
+    //! Returns the number of items added, estimated from the weights.
+    uint64_t num_items() const {
+        uint64_t total = 0;
+        for (size_t h = 0; h < levels_.size(); ++h)
+            total += levels_[h].size() << h;
+        return total;
+    }
+
+    //! Returns whether no items were added.
+    bool empty() const { return num_items() == 0; }
+
+    //! Returns the levels.
+    const Levels& levels() const { return levels_; }
+
+private:
+    //! parameter determining the accuracy
+    size_t k_;
+    //! compare function
+    CompareFunction compare_function_;
+    //! items on each level
+    Levels levels_;
+    //! cached capacity of level 0
+    size_t capacity0_;
+    //! state of the generator for the random compaction offsets
+    uint64_t random_ = 0x9E3779B97F4A7C15ull;
+
+    //! capacity of level h, which shrinks by 2/3 below the top level
+    size_t Capacity(size_t h) const {
+        size_t depth = levels_.size() - 1 - h;
+        return std::max<size_t>(
+            2, static_cast<size_t>(
+                std::ceil(static_cast<double>(k_) * std::pow(2.0 / 3.0, depth))));
+    }
+
+    //! returns a random bit
+    bool RandomBit() {
+        // xorshift64
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 7;
+        random_ ^= random_ << 17;
+        return (random_ >> 32) & 1;
+    }
+
+    //! compact levels until all are within their capacity
+    void Compress() {
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            if (levels_[h].size() < Capacity(h)) continue;
+
+            if (h + 1 == levels_.size()) levels_.emplace_back();
+
+            std::vector<ValueType>& level = levels_[h];
+            std::sort(level.begin(), level.end(), compare_function_);
+
+            // an odd item stays on this level
+            size_t size = level.size() & ~size_t(1);
+            std::vector<ValueType>& next = levels_[h + 1];
+            for (size_t i = RandomBit() ? 1 : 0; i < size; i += 2)
+                next.push_back(level[i]);
+
+            level.erase(level.begin(), level.begin() + size);
+        }
+        capacity0_ = Capacity(0);
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_QUANTILE_SKETCH_HEADER
+
+/******************************************************************************/
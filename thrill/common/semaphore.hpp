@@ -60,6 +60,14 @@ public:
             cv_.wait(lock);
         return --value_;
     }
+    //! function decrements the semaphore if it is > 0 without blocking, and
+    //! returns whether it did.
+    bool try_acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (value_ <= 0) return false;
+        --value_;
+        return true;
+    }
 
 private:
     //! value of the semaphore
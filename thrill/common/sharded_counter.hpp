@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * thrill/common/sharded_counter.hpp
+ *
+ * Counters which are split into per-thread shards to avoid bouncing cache
+ * lines between threads, and summed when read.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_SHARDED_COUNTER_HEADER
+#define THRILL_COMMON_SHARDED_COUNTER_HEADER
+
+#include <thrill/common/config.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+namespace thrill {
+namespace common {
+
+//! Returns the shard index of the calling thread, which are assigned to
+//! threads round-robin on first use.
+inline size_t ShardedCounterThreadIndex() {
+    static std::atomic<size_t> s_next_index { 0 };
+    static thread_local size_t index = s_next_index++;
+    return index;
+}
+
+/*!
+ * A group of Fields counters, which are split into Shards cache-line padded
+ * shards. Each thread adds to the shard of its thread index, hence threads
+ * rarely write to the same cache line. Reading a counter sums all shards,
+ * which is slower and sees concurrent updates in an arbitrary order, hence
+ * reads should be rare, e.g. for statistics.
+ *
+ * Unsigned counters may be decremented by other threads than those which
+ * incremented them, since the sum wraps around correctly.
+ */
+template <typename Type, size_t Fields = 1, size_t Shards = 16>
+class ShardedCounters
+{
+    static_assert(Shards > 0, "ShardedCounters needs at least one shard");
+
+public:
+    ShardedCounters() {
+        for (Shard& s : shards_) {
+            for (size_t f = 0; f < Fields; ++f)
+                s.value[f].store(Type(0), std::memory_order_relaxed);
+        }
+    }
+
+    //! non-copyable: delete copy-constructor
+    ShardedCounters(const ShardedCounters&) = delete;
+    //! non-copyable: delete assignment operator
+    ShardedCounters& operator = (const ShardedCounters&) = delete;
+
+    //! add to a counter, returns the previous value of the thread's shard.
+    Type add(size_t field, Type amount) {
+        assert(field < Fields);
+        return shard().value[field].fetch_add(
+            amount, std::memory_order_relaxed);
+    }
+
+    //! subtract from a counter.
+    void subtract(size_t field, Type amount) {
+        assert(field < Fields);
+        shard().value[field].fetch_sub(amount, std::memory_order_relaxed);
+    }
+
+    //! returns the sum of a counter over all shards.
+    Type get(size_t field) const {
+        assert(field < Fields);
+        Type sum = Type(0);
+        for (const Shard& s : shards_)
+            sum += s.value[field].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    //! counters of one shard, preceded by a cache line of padding, such that
+    //! the counters of two shards never share a cache line. Padding is used
+    //! instead of alignas(), since operator new ignores over-alignment before
+    //! C++17, e.g. for the io::Stats Singleton.
+    struct Shard {
+        char padding[g_cache_line_size];
+        std::atomic<Type> value[Fields];
+    };
+
+    //! the shards
+    Shard shards_[Shards];
+
+    //! the calling thread's shard
+    Shard& shard() {
+        return shards_[ShardedCounterThreadIndex() % Shards];
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_SHARDED_COUNTER_HEADER
+
+/******************************************************************************/
@@ -17,10 +17,16 @@
 #define THRILL_COMMON_STRING_VIEW_HEADER
 
 #include <thrill/common/fast_string.hpp>
+#include <thrill/common/math.hpp>
 
 #include <algorithm>
 #include <ostream>
 #include <string>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace thrill {
 namespace common {
@@ -194,6 +200,67 @@ void SplitView(
     callback(StringView(last, it));
 }
 
+/*!
+ * Split the given character range at each separator character into words, and
+ * call the given callback for each non-empty word, represented by a StringView
+ * into the range. Consecutive separators are skipped. The separators are
+ * searched 16 bytes at a time with SSE2, and nothing is allocated, hence the
+ * callback can directly emit the words of a line in a FlatMap.
+ *
+ * \param data      begin of the characters to split
+ * \param size      number of characters
+ * \param sep       separator character
+ * \param callback  callback taking a StringView of each word
+ */
+template <typename F>
+static inline
+void SplitWords(const char* data, size_t size, char sep, F&& callback) {
+
+    const char* end = data + size;
+    // begin of the current word
+    const char* word = data;
+
+    auto split = [&](const char* s) {
+                     if (s != word) callback(StringView(word, s - word));
+                     word = s + 1;
+                 };
+
+    const char* p = data;
+#if defined(__SSE2__)
+    const __m128i vsep = _mm_set1_epi8(sep);
+    for ( ; end - p >= 16; p += 16) {
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(
+                                  _mm_loadu_si128(
+                                      reinterpret_cast<const __m128i*>(p)),
+                                  vsep)));
+        while (mask != 0) {
+            split(p + ffs(mask) - 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for ( ; p != end; ++p) {
+        if (*p == sep) split(p);
+    }
+    if (word < end)
+        callback(StringView(word, end - word));
+}
+
+/*!
+ * Split the given string at each separator character into words, skipping
+ * empty ones, and call the given callback with a StringView of each word.
+ *
+ * \param str       string to split
+ * \param sep       separator character
+ * \param callback  callback taking a StringView of each word
+ */
+template <typename F>
+static inline
+void SplitWords(const std::string& str, char sep, F&& callback) {
+    SplitWords(str.data(), str.size(), sep, std::forward<F>(callback));
+}
+
 } // namespace common
 } // namespace thrill
 
@@ -16,8 +16,16 @@
 #include <thrill/common/defines.hpp>
 #include <thrill/common/functional.hpp>
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include <atomic>
+#include <climits>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 
 namespace thrill {
@@ -128,11 +136,107 @@ protected:
     std::atomic<size_t> step_ { 0 };
 };
 
+/*!
+ * Implements a cyclic barrier which first spins on a generation counter like
+ * ThreadBarrierSpinning, and then blocks on it using a futex (Linux) or a
+ * condition variable. Short waits, like those of tiny collectives, thus have
+ * the latency of spinning, while long waits do not burn CPU cycles needed by
+ * other threads. The last thread only makes a system call if other threads are
+ * asleep.
+ */
+class ThreadBarrierSpinBlocking
+{
+public:
+    /*!
+     * Creates a new barrier that waits for n threads.
+     */
+    explicit ThreadBarrierSpinBlocking(size_t thread_count)
+        : thread_count_(thread_count) { }
+
+    /*!
+     * Waits for n threads to arrive.
+     *
+     * This method blocks and returns as soon as n threads are waiting inside
+     * the method.
+     */
+    template <typename Lambda = NoOperation<void> >
+    void Await(Lambda lambda = Lambda()) {
+        // get synchronization generation step counter.
+        uint32_t this_step = step_.load(std::memory_order_acquire);
+
+        if (waiting_.fetch_add(1, std::memory_order_acq_rel) == thread_count_ - 1) {
+            // we are the last thread to Await() -> reset and increment step.
+            waiting_.store(0, std::memory_order_release);
+            lambda();
+            // release all threads, and wake those which went to sleep. Both
+            // are sequentially consistent with the sleepers' operations, hence
+            // either we see a sleeper or the sleeper sees the new step.
+            step_.fetch_add(1);
+            if (sleeping_.load() != 0) Wake();
+        }
+        else {
+            // spin a while awaiting the last thread to increment the step.
+            for (size_t i = 0; i < spin_count; ++i) {
+                if (step_.load(std::memory_order_acquire) != this_step)
+                    return;
+            }
+            // then go to sleep until it does.
+            sleeping_.fetch_add(1);
+            while (step_.load() == this_step)
+                Sleep(this_step);
+            sleeping_.fetch_sub(1);
+        }
+    }
+
+protected:
+    //! number of spins before going to sleep
+    static constexpr size_t spin_count = 16384;
+
+    //! number of threads
+    const size_t thread_count_;
+
+    //! number of threads in spin lock
+    std::atomic<size_t> waiting_ { 0 };
+
+    //! number of threads sleeping or about to sleep
+    std::atomic<size_t> sleeping_ { 0 };
+
+    //! barrier synchronization generation, 32-bit for use as a futex.
+    std::atomic<uint32_t> step_ { 0 };
+
+#if defined(__linux__)
+    //! sleep while step_ equals this_step
+    void Sleep(uint32_t this_step) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&step_),
+                FUTEX_WAIT_PRIVATE, this_step, nullptr, nullptr, 0);
+    }
+
+    //! wake all sleeping threads
+    void Wake() {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&step_),
+                FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+#else
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    void Sleep(uint32_t this_step) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (step_.load() == this_step) cv_.wait(lock);
+    }
+
+    void Wake() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+#endif
+};
+
 // select thread barrier implementation.
 #if THRILL_HAVE_THREAD_SANITIZER
 using ThreadBarrier = ThreadBarrierLocking;
 #else
-using ThreadBarrier = ThreadBarrierSpinning;
+using ThreadBarrier = ThreadBarrierSpinBlocking;
 #endif
 
 } // namespace common
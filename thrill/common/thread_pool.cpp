@@ -11,17 +11,28 @@
  ******************************************************************************/
 
 #include <thrill/common/logger.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/common/thread_pool.hpp>
 
 namespace thrill {
 namespace common {
 
 //! Construct running thread pool of num_threads
-ThreadPool::ThreadPool(size_t num_threads)
+ThreadPool::ThreadPool(size_t num_threads, bool numa_pin)
     : threads_(num_threads) {
     // immediately construct worker threads
-    for (size_t i = 0; i < num_threads; ++i)
-        threads_[i] = std::thread(&ThreadPool::Worker, this);
+    for (size_t i = 0; i < num_threads; ++i) {
+        if (numa_pin) {
+            threads_[i] = std::thread(
+                [this, i, num_threads]() {
+                    NumaPinWorker(i, num_threads);
+                    Worker();
+                });
+        }
+        else {
+            threads_[i] = std::thread(&ThreadPool::Worker, this);
+        }
+    }
 }
 
 //! Stop processing jobs, terminate threads.
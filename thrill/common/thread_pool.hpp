@@ -14,6 +14,7 @@
 #ifndef THRILL_COMMON_THREAD_POOL_HEADER
 #define THRILL_COMMON_THREAD_POOL_HEADER
 
+#include <thrill/common/cgroup.hpp>
 #include <thrill/common/delegate.hpp>
 
 #include <atomic>
@@ -110,9 +111,12 @@ private:
     std::atomic<bool> terminate_ = { false };
 
 public:
-    //! Construct running thread pool of num_threads
+    //! Construct running thread pool of num_threads. If numa_pin is set, the
+    //! threads are distributed and pinned onto the NUMA nodes like workers,
+    //! see NumaPinWorker().
     explicit ThreadPool(
-        size_t num_threads = std::thread::hardware_concurrency());
+        size_t num_threads = AvailableCpuCount(),
+        bool numa_pin = false);
 
     //! non-copyable: delete copy-constructor
     ThreadPool(const ThreadPool&) = delete;
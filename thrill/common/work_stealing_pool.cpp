@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * thrill/common/work_stealing_pool.cpp
+ *
+ * A work-stealing pool of std::threads with fork-join helpers for parallelism
+ * inside a worker.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/numa.hpp>
+#include <thrill/common/work_stealing_pool.hpp>
+
+namespace thrill {
+namespace common {
+
+//! pool and index of the calling thread, if it belongs to a pool
+static thread_local const WorkStealingPool* tls_pool = nullptr;
+static thread_local size_t tls_index = 0;
+
+//! number of failed attempts to find a Job before a thread sleeps
+static constexpr size_t kSpins = 64;
+
+WorkStealingPool::WorkStealingPool(size_t num_threads, size_t numa_node) {
+    if (num_threads == 0) num_threads = 1;
+
+    for (size_t i = 0; i < num_threads; ++i)
+        queues_.emplace_back(new Queue);
+
+    threads_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i)
+        threads_.emplace_back(&WorkStealingPool::Worker, this, i, numa_node);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        terminate_ = true;
+        cv_.notify_all();
+    }
+    for (std::thread& t : threads_)
+        t.join();
+}
+
+size_t WorkStealingPool::ThisThread() const {
+    return tls_pool == this ? tls_index : queues_.size();
+}
+
+void WorkStealingPool::Enqueue(Job&& job) {
+    size_t self = ThisThread();
+    size_t q = self < queues_.size()
+               ? self : next_queue_.fetch_add(1) % queues_.size();
+    {
+        std::unique_lock<std::mutex> lock(queues_[q]->mutex);
+        queues_[q]->jobs.emplace_back(std::move(job));
+    }
+    // pairs with announcing sleep in Worker()
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) != 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.notify_one();
+    }
+}
+
+bool WorkStealingPool::RunOne(size_t self) {
+    if (queued_.load(std::memory_order_acquire) == 0) return false;
+
+    Job job;
+    bool found = false;
+
+    // own deque: newest Job first
+    if (self < queues_.size()) {
+        Queue& q = *queues_[self];
+        std::unique_lock<std::mutex> lock(q.mutex);
+        if (!q.jobs.empty()) {
+            job = std::move(q.jobs.back());
+            q.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // other deques: oldest Job first
+    for (size_t i = 1; !found && i <= queues_.size(); ++i) {
+        Queue& q = *queues_[(self + i) % queues_.size()];
+        std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+        if (lock.owns_lock() && !q.jobs.empty()) {
+            job = std::move(q.jobs.front());
+            q.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) return false;
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+
+    try {
+        job();
+    }
+    catch (std::exception& e) {
+        LOG1 << "EXCEPTION: " << e.what();
+    }
+    ++done_;
+    return true;
+}
+
+void WorkStealingPool::Wait(const std::atomic<size_t>& pending) {
+    size_t self = ThisThread();
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (!RunOne(self))
+            std::this_thread::yield();
+    }
+}
+
+void WorkStealingPool::Worker(size_t self, size_t numa_node) {
+    tls_pool = this;
+    tls_index = self;
+    if (numa_node != size_t(-1))
+        NumaPinThisThread(numa_node);
+
+    size_t idle = 0;
+    while (!terminate_) {
+        if (RunOne(self)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < kSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        cv_.wait(lock, [this]() {
+                     return terminate_ ||
+                     queued_.load(std::memory_order_seq_cst) != 0;
+                 });
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
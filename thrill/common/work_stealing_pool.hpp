@@ -0,0 +1,190 @@
+/*******************************************************************************
+ * thrill/common/work_stealing_pool.hpp
+ *
+ * A work-stealing pool of std::threads with fork-join helpers for parallelism
+ * inside a worker.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_WORK_STEALING_POOL_HEADER
+#define THRILL_COMMON_WORK_STEALING_POOL_HEADER
+
+#include <thrill/common/cgroup.hpp>
+#include <thrill/common/delegate.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * WorkStealingPool starts a fixed number of std::threads, each with its own
+ * deque of Jobs. A thread pushes and pops Jobs at the back of its deque, and
+ * idle threads steal the oldest Jobs from the front of other deques, which are
+ * the largest pieces of work in recursive fork-join algorithms. Jobs enqueued
+ * by threads outside the pool are distributed round-robin.
+ *
+ * Fork-join parallelism is available via ParallelFor() and ParallelInvoke().
+ * They can be called from outside or inside the pool, and the calling thread
+ * runs Jobs while waiting for its forks, hence nested calls do not deadlock.
+
+\code
+WorkStealingPool pool(4);
+
+std::vector<size_t> v(1000000);
+pool.ParallelFor(0, v.size(), 4096, [&v](size_t i) { v[i] = i * i; });
+
+pool.ParallelInvoke([&]() { std::sort(a.begin(), a.end()); },
+                    [&]() { std::sort(b.begin(), b.end()); });
+\endcode
+
+ * Idle threads spin briefly and then sleep on a condition variable, which
+ * Enqueue() only locks if threads are sleeping.
+ */
+class WorkStealingPool
+{
+public:
+    using Job = Delegate<void()>;
+
+    //! Construct running pool of num_threads. If numa_node is given, all
+    //! threads are pinned to the CPUs of that NUMA node, e.g. the node of the
+    //! worker which uses the pool to parallelize its local work.
+    explicit WorkStealingPool(
+        size_t num_threads = AvailableCpuCount(),
+        size_t numa_node = size_t(-1));
+
+    //! non-copyable: delete copy-constructor
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    //! non-copyable: delete assignment operator
+    WorkStealingPool& operator = (const WorkStealingPool&) = delete;
+
+    //! Stop processing jobs, terminate threads. Queued jobs are not run.
+    ~WorkStealingPool();
+
+    //! Enqueue a Job, the caller must pass in all context using captures.
+    //! From a thread of the pool, the Job is pushed onto its own deque.
+    void Enqueue(Job&& job);
+
+    //! Wait until pending is zero, and run Jobs in the meantime.
+    void Wait(const std::atomic<size_t>& pending);
+
+    //! Call functor(i) for all i in [begin,end) in parallel. The range is
+    //! split recursively into halves down to grain_size indexes, whose right
+    //! halves are forked as Jobs.
+    template <typename Functor>
+    void ParallelFor(size_t begin, size_t end, size_t grain_size,
+                     const Functor& functor) {
+        if (grain_size == 0) grain_size = 1;
+        std::atomic<size_t> pending { 0 };
+        ForkRange(begin, end, grain_size, functor, pending);
+        Wait(pending);
+    }
+
+    //! Run all functors in parallel and wait for them. The first one runs on
+    //! the calling thread.
+    template <typename Functor, typename ... Functors>
+    void ParallelInvoke(const Functor& functor, const Functors& ... functors) {
+        std::atomic<size_t> pending { sizeof ... (Functors) };
+        ForkAll(pending, functors ...);
+        functor();
+        Wait(pending);
+    }
+
+    //! Return number of threads in pool
+    size_t size() const { return threads_.size(); }
+
+    //! Return number of jobs completed.
+    size_t done() const { return done_; }
+
+private:
+    //! deque of Jobs of one thread
+    struct Queue {
+        std::mutex      mutex;
+        std::deque<Job> jobs;
+    };
+
+    //! one deque per thread
+    std::vector<std::unique_ptr<Queue> > queues_;
+
+    //! threads in pool
+    std::vector<std::thread> threads_;
+
+    //! next deque for Jobs from outside the pool
+    std::atomic<size_t> next_queue_ { 0 };
+
+    //! number of Jobs in all deques
+    std::atomic<size_t> queued_ { 0 };
+
+    //! number of threads sleeping on cv_
+    std::atomic<size_t> sleeping_ { 0 };
+
+    //! Counter for total number of jobs executed
+    std::atomic<size_t> done_ { 0 };
+
+    //! Flag whether to terminate
+    std::atomic<bool> terminate_ { false };
+
+    //! mutex and condition variable for sleeping threads
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    //! Returns the index of the calling thread in this pool, or size() if it
+    //! is not part of the pool.
+    size_t ThisThread() const;
+
+    //! Pop a Job from the back of the own deque, or steal one from the front
+    //! of another deque, and run it. Returns false if there was none.
+    bool RunOne(size_t self);
+
+    //! Worker function, one per thread is started.
+    void Worker(size_t self, size_t numa_node);
+
+    //! fork the right halves of [begin,end) and run the remaining left part.
+    //! Forked Jobs count their own forks in pending before finishing.
+    template <typename Functor>
+    void ForkRange(size_t begin, size_t end, size_t grain_size,
+                   const Functor& functor, std::atomic<size_t>& pending) {
+        while (end - begin > grain_size) {
+            size_t mid = begin + (end - begin) / 2;
+            pending.fetch_add(1, std::memory_order_relaxed);
+            Enqueue(
+                [this, mid, end, grain_size, &functor, &pending]() {
+                    ForkRange(mid, end, grain_size, functor, pending);
+                    pending.fetch_sub(1, std::memory_order_release);
+                });
+            end = mid;
+        }
+        for (size_t i = begin; i < end; ++i)
+            functor(i);
+    }
+
+    void ForkAll(std::atomic<size_t>&) { }
+
+    template <typename Functor, typename ... Functors>
+    void ForkAll(std::atomic<size_t>& pending,
+                 const Functor& functor, const Functors& ... functors) {
+        Enqueue([&functor, &pending]() {
+                    functor();
+                    pending.fetch_sub(1, std::memory_order_release);
+                });
+        ForkAll(pending, functors ...);
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_WORK_STEALING_POOL_HEADER
+
+/******************************************************************************/
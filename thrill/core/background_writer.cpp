@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * thrill/core/background_writer.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/porting.hpp>
+#include <thrill/core/background_writer.hpp>
+
+#include <cstdlib>
+#include <utility>
+
+namespace thrill {
+namespace core {
+
+BackgroundWriter::BackgroundWriter(size_t max_queue)
+    : max_queue_(max_queue) {
+    if (max_queue_ != 0)
+        thread_ = common::CreateThread([this]() { Work(); });
+}
+
+BackgroundWriter::~BackgroundWriter() {
+    if (!thread_.joinable()) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        terminate_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void BackgroundWriter::Enqueue(Job&& job) {
+    if (max_queue_ == 0) {
+        RethrowError();
+        try {
+            job();
+        }
+        catch (...) {
+            error_ = std::current_exception();
+            throw;
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return queue_.size() < max_queue_ || error_; });
+    RethrowError();
+    queue_.emplace_back(std::move(job));
+    cv_.notify_all();
+}
+
+void BackgroundWriter::Finish() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return queue_.empty(); });
+    RethrowError();
+}
+
+void BackgroundWriter::Work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return terminate_ || !queue_.empty(); });
+        if (queue_.empty()) return;
+
+        // run the front job unlocked, it stays queued to count as pending.
+        if (!error_) {
+            lock.unlock();
+            try {
+                queue_.front()();
+            }
+            catch (...) {
+                lock.lock();
+                error_ = std::current_exception();
+                lock.unlock();
+            }
+            lock.lock();
+        }
+        queue_.pop_front();
+        cv_.notify_all();
+    }
+}
+
+void BackgroundWriter::RethrowError() {
+    if (error_) std::rethrow_exception(error_);
+}
+
+size_t DefaultWriteBehind() {
+    static size_t default_write_behind = []() -> size_t {
+        const char* env = getenv("THRILL_WRITE_BEHIND");
+        if (env && *env) return std::strtoul(env, nullptr, 10);
+        return 2;
+    } ();
+    return default_write_behind;
+}
+
+} // namespace core
+} // namespace thrill
+
+/******************************************************************************/
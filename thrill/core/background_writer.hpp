@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * thrill/core/background_writer.hpp
+ *
+ * Helper thread which runs write jobs from a bounded queue, such that the
+ * producer continues while the previous data is written.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_BACKGROUND_WRITER_HEADER
+#define THRILL_CORE_BACKGROUND_WRITER_HEADER
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * BackgroundWriter runs write jobs in order in a helper thread. At most
+ * max_queue jobs are queued, Enqueue() blocks while the queue is full, such
+ * that the producer overlaps with persisting at most max_queue previous
+ * buffers. With max_queue zero, jobs run synchronously in Enqueue().
+ *
+ * A job keeps its data alive by capturing it, e.g. a PinnedBlock or a moved
+ * buffer. The first exception thrown by a job is rethrown by all following
+ * Enqueue() and Finish() calls, and later jobs are skipped.
+ */
+class BackgroundWriter
+{
+public:
+    using Job = std::function<void()>;
+
+    //! Start the helper thread if max_queue is not zero.
+    explicit BackgroundWriter(size_t max_queue);
+
+    //! non-copyable: delete copy-constructor
+    BackgroundWriter(const BackgroundWriter&) = delete;
+    //! non-copyable: delete assignment operator
+    BackgroundWriter& operator = (const BackgroundWriter&) = delete;
+
+    //! Waits for all queued jobs and joins the thread, ignoring errors.
+    ~BackgroundWriter();
+
+    //! Queue a job, or run it if writing synchronously.
+    void Enqueue(Job&& job);
+
+    //! Wait until all queued jobs ran and rethrow their first exception.
+    void Finish();
+
+private:
+    //! maximum number of queued jobs, zero if synchronous
+    size_t max_queue_;
+
+    //! mutex protecting the queue and flags
+    std::mutex mutex_;
+    //! signaled on changes of the queue and flags
+    std::condition_variable cv_;
+    //! queued jobs, the front one is running
+    std::deque<Job> queue_;
+    //! flag to terminate the thread
+    bool terminate_ = false;
+    //! first exception thrown by a job
+    std::exception_ptr error_;
+
+    //! helper thread
+    std::thread thread_;
+
+    //! helper thread: runs jobs until terminated
+    void Work();
+
+    //! rethrow the first exception, requires the lock
+    void RethrowError();
+};
+
+//! Number of buffers which WriteBinary and WriteLines write behind the
+//! producing worker in a helper thread. The default is taken from the
+//! environment variable THRILL_WRITE_BEHIND, which is 2 if unset, and 0 writes
+//! synchronously.
+size_t DefaultWriteBehind();
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_BACKGROUND_WRITER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * thrill/core/bgzf_file.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
+#include <thrill/core/bgzf_file.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if THRILL_HAVE_ZLIB
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#endif
+
+namespace thrill {
+namespace core {
+
+#if THRILL_HAVE_ZLIB
+
+//! size of gzip header up to the extra field, plus the BC subfield
+static constexpr size_t bgzf_header_size = 18;
+
+//! Returns the total size of the BGZF member whose header starts at p, or zero
+//! if p does not point to a BGZF member header.
+static size_t BgzfMemberSize(const unsigned char* p, size_t avail) {
+    if (avail < bgzf_header_size) return 0;
+    // gzip magic, deflate method, FEXTRA flag
+    if (p[0] != 31 || p[1] != 139 || p[2] != 8 || (p[3] & 4) == 0)
+        return 0;
+
+    size_t xlen = p[10] | (p[11] << 8);
+    if (12 + xlen > avail) return 0;
+
+    // search for the BC subfield holding the member size minus one
+    for (size_t i = 12; i + 6 <= 12 + xlen; ) {
+        size_t slen = p[i + 2] | (p[i + 3] << 8);
+        if (p[i] == 'B' && p[i + 1] == 'C' && slen == 2) {
+            size_t size = (p[i + 4] | (p[i + 5] << 8)) + 1;
+            // header, extra field, CRC32 and ISIZE
+            return size >= 12 + xlen + 8 ? size : 0;
+        }
+        i += 4 + slen;
+    }
+    return 0;
+}
+
+static inline uint32_t ReadLE32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool IsBgzf(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    unsigned char header[64];
+    ssize_t rb = ::pread(fd, header, sizeof(header), 0);
+    ::close(fd);
+    return rb > 0 && BgzfMemberSize(header, static_cast<size_t>(rb)) != 0;
+}
+
+struct BgzfFile::Data {
+    //! path for error messages
+    std::string path;
+    //! file descriptor
+    int fd = -1;
+    //! size of the file
+    uint64_t size = 0;
+    //! offset of the next member
+    uint64_t offset = 0;
+
+    //! buffer of compressed data, holding [buf_offset, buf_offset + buf_size)
+    std::vector<unsigned char> buf;
+    uint64_t buf_offset = 0;
+    size_t buf_size = 0;
+
+    //! raw inflate stream, reset for each member
+    z_stream strm;
+
+    explicit Data(const std::string& _path) : path(_path), buf(4 * max_member_size) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw common::ErrnoException("Cannot open file " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+            throw common::ErrnoException("Cannot stat file " + path);
+        size = static_cast<uint64_t>(st.st_size);
+
+        memset(&strm, 0, sizeof(strm));
+        if (inflateInit2(&strm, -15) != Z_OK)
+            throw std::runtime_error("inflateInit2() failed");
+    }
+
+    ~Data() {
+        inflateEnd(&strm);
+        if (fd >= 0) ::close(fd);
+    }
+
+    //! Ensure that the buffer holds [offset, offset + need), or up to the end
+    //! of the file. Returns the number of bytes available at offset.
+    size_t Fill(size_t need) {
+        if (offset < buf_offset || offset + need > buf_offset + buf_size) {
+            buf_offset = offset;
+            buf_size = 0;
+            while (buf_size < buf.size() && buf_offset + buf_size < size) {
+                ssize_t rb = ::pread(fd, buf.data() + buf_size,
+                                     buf.size() - buf_size,
+                                     static_cast<off_t>(buf_offset + buf_size));
+                if (rb < 0)
+                    throw common::ErrnoException("Read error in " + path);
+                if (rb == 0) break;
+                buf_size += static_cast<size_t>(rb);
+            }
+        }
+        return static_cast<size_t>(buf_offset + buf_size - offset);
+    }
+
+    //! Advance offset to the first member starting at or after it. A member
+    //! header is accepted if it is followed by another one or the end of file.
+    void Seek() {
+        while (offset < size) {
+            size_t avail = Fill(2 * max_member_size);
+            const unsigned char* p = buf.data() + (offset - buf_offset);
+
+            size_t total = BgzfMemberSize(p, avail);
+            if (total != 0 && (offset + total == size ||
+                               (total <= avail &&
+                                BgzfMemberSize(p + total, avail - total) != 0)))
+                return;
+
+            // skip to next possible magic byte
+            const void* q = memchr(p + 1, 31, avail - 1);
+            offset += q ? static_cast<const unsigned char*>(q) - p : avail;
+        }
+    }
+};
+
+BgzfFile::BgzfFile() = default;
+
+BgzfFile::BgzfFile(const std::string& path, uint64_t offset)
+    : d_(std::make_unique<Data>(path)) {
+    d_->offset = offset;
+    d_->Seek();
+    sLOG0 << "BgzfFile" << path << "offset" << offset << "-> member at"
+          << d_->offset;
+}
+
+BgzfFile::BgzfFile(BgzfFile&&) noexcept = default;
+BgzfFile& BgzfFile::operator = (BgzfFile&&) noexcept = default;
+
+BgzfFile::~BgzfFile() = default;
+
+uint64_t BgzfFile::offset() const {
+    return d_->offset;
+}
+
+bool BgzfFile::ReadMember(void* data, size_t* size) {
+    Data& d = *d_;
+    if (d.offset >= d.size) return false;
+
+    size_t avail = d.Fill(max_member_size);
+    const unsigned char* p = d.buf.data() + (d.offset - d.buf_offset);
+
+    size_t total = BgzfMemberSize(p, avail);
+    if (total == 0 || total > avail) {
+        throw std::runtime_error(
+                  "Invalid BGZF member in " + d.path +
+                  " at offset " + std::to_string(d.offset));
+    }
+
+    size_t xlen = p[10] | (p[11] << 8);
+    uint32_t crc = ReadLE32(p + total - 8);
+    uint32_t isize = ReadLE32(p + total - 4);
+    if (isize > max_member_size) {
+        throw std::runtime_error(
+                  "Invalid BGZF member size in " + d.path +
+                  " at offset " + std::to_string(d.offset));
+    }
+
+    // inflate raw deflate stream in one call
+    inflateReset(&d.strm);
+    d.strm.next_in = const_cast<Bytef*>(p + 12 + xlen);
+    d.strm.avail_in = static_cast<uInt>(total - 12 - xlen - 8);
+    d.strm.next_out = static_cast<Bytef*>(data);
+    d.strm.avail_out = static_cast<uInt>(max_member_size);
+
+    int rc = inflate(&d.strm, Z_FINISH);
+    if (rc != Z_STREAM_END || d.strm.total_out != isize ||
+        crc32(0, static_cast<const Bytef*>(data), isize) != crc) {
+        throw std::runtime_error(
+                  "Corrupt BGZF member in " + d.path +
+                  " at offset " + std::to_string(d.offset));
+    }
+
+    d.offset += total;
+    *size = isize;
+    return true;
+}
+
+#else   // !THRILL_HAVE_ZLIB
+
+bool IsBgzf(const std::string& /* path */) {
+    return false;
+}
+
+struct BgzfFile::Data { };
+
+BgzfFile::BgzfFile() = default;
+
+BgzfFile::BgzfFile(const std::string& path, uint64_t /* offset */) {
+    throw std::runtime_error(
+              "Cannot read BGZF file " + path + ": compiled without zlib.");
+}
+
+BgzfFile::BgzfFile(BgzfFile&&) noexcept = default;
+BgzfFile& BgzfFile::operator = (BgzfFile&&) noexcept = default;
+
+BgzfFile::~BgzfFile() = default;
+
+uint64_t BgzfFile::offset() const {
+    return 0;
+}
+
+bool BgzfFile::ReadMember(void* /* data */, size_t* /* size */) {
+    return false;
+}
+
+#endif  // !THRILL_HAVE_ZLIB
+
+} // namespace core
+} // namespace thrill
+
+/******************************************************************************/
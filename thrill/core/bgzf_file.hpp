@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * thrill/core/bgzf_file.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_BGZF_FILE_HEADER
+#define THRILL_CORE_BGZF_FILE_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace thrill {
+namespace core {
+
+//! Returns true, if the file at path is in the blocked gzip format (BGZF)
+//! written by bgzip, and BGZF files can be read in-process. BGZF files consist
+//! of independently compressed gzip members of at most 64 KiB, each carrying
+//! its compressed size in an extra field, hence they can be split at any
+//! member and read by all workers in parallel. Requires zlib.
+bool IsBgzf(const std::string& path);
+
+/*!
+ * Reader of BGZF files, which decompresses the gzip members in-process using
+ * zlib. It starts at the first member beginning at or after a given file
+ * offset, such that workers can read disjoint parts of a single compressed
+ * file. Throws std::runtime_error on invalid data.
+ */
+class BgzfFile
+{
+public:
+    //! maximum uncompressed and compressed size of a member
+    static constexpr size_t max_member_size = 65536;
+
+    //! default constructor: no file.
+    BgzfFile();
+
+    //! Open file and position the reader at the first member starting at or
+    //! after offset.
+    BgzfFile(const std::string& path, uint64_t offset);
+
+    //! non-copyable: delete copy-constructor
+    BgzfFile(const BgzfFile&) = delete;
+    //! non-copyable: delete assignment operator
+    BgzfFile& operator = (const BgzfFile&) = delete;
+    //! move-constructor
+    BgzfFile(BgzfFile&&) noexcept;
+    //! move-assignment
+    BgzfFile& operator = (BgzfFile&&) noexcept;
+
+    ~BgzfFile();
+
+    //! Returns the file offset of the member decompressed by the next
+    //! ReadMember() call, or the file size at the end.
+    uint64_t offset() const;
+
+    //! Decompress the next member into data, which must hold max_member_size
+    //! bytes, and set size to its length, which may be zero for empty members.
+    //! Returns false at the end of the file.
+    bool ReadMember(void* data, size_t* size);
+
+private:
+    //! pimpl data structure holding the file and the zlib stream
+    struct Data;
+
+    //! pimpl data structure
+    std::unique_ptr<Data> d_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_BGZF_FILE_HEADER
+
+/******************************************************************************/
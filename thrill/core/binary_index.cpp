@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * thrill/core/binary_index.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/core/binary_index.hpp>
+#include <thrill/core/file_io.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace thrill {
+namespace core {
+
+//! magic bytes at the very end of a file with index
+static const char binary_index_magic[8] = {
+    'T', 'H', 'R', 'B', 'I', 'D', 'X', '1'
+};
+
+template <typename Type>
+static void Put(std::string* out, const Type& v) {
+    out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <typename Type>
+static Type Get(const char* p) {
+    Type v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+//! read exactly size bytes from path at offset
+static void ReadAt(const std::string& path, uint64_t offset,
+                   char* data, size_t size) {
+    SysFile file = SysFile::OpenForRead(path, false, offset);
+    while (size != 0) {
+        ssize_t rb = file.read(data, size);
+        if (rb <= 0)
+            throw std::runtime_error("Cannot read index of file " + path);
+        data += rb, size -= rb;
+    }
+}
+
+std::string BinaryIndex::Serialize() const {
+    std::string out;
+    for (const Checkpoint& c : checkpoints) {
+        Put(&out, c.first);
+        Put(&out, c.second);
+    }
+    Put(&out, total_items);
+    Put(&out, static_cast<uint64_t>(checkpoints.size()));
+    Put(&out, static_cast<uint64_t>(out.size()));
+    out.append(binary_index_magic, sizeof(binary_index_magic));
+    return out;
+}
+
+bool BinaryIndex::Read(
+    const std::string& path, uint64_t size, BinaryIndex* out) {
+
+    if (IsCompressed(path) || size < trailer_size) return false;
+
+    char trailer[trailer_size];
+    ReadAt(path, size - trailer_size, trailer, trailer_size);
+    if (std::memcmp(trailer + 8, binary_index_magic, 8) != 0)
+        return false;
+
+    uint64_t index_size = Get<uint64_t>(trailer);
+    if (index_size < 16 || index_size > size - trailer_size ||
+        index_size % 16 != 0)
+        throw std::runtime_error("Invalid index in file " + path);
+
+    std::string data(index_size, 0);
+    ReadAt(path, size - trailer_size - index_size, &data[0], index_size);
+
+    out->data_size = size - trailer_size - index_size;
+    out->total_items = Get<uint64_t>(data.data() + index_size - 16);
+    uint64_t num = Get<uint64_t>(data.data() + index_size - 8);
+    if (num != index_size / 16 - 1)
+        throw std::runtime_error("Invalid index in file " + path);
+
+    out->checkpoints.clear();
+    for (uint64_t i = 0; i < num; ++i) {
+        out->checkpoints.emplace_back(
+            Get<uint64_t>(data.data() + 16 * i),
+            Get<uint64_t>(data.data() + 16 * i + 8));
+    }
+    if (out->total_items != 0 &&
+        (num == 0 || out->checkpoints[0] != Checkpoint(0, 0)))
+        throw std::runtime_error("Invalid index in file " + path);
+
+    return true;
+}
+
+const BinaryIndex::Checkpoint&
+BinaryIndex::CheckpointBefore(uint64_t item) const {
+    assert(!checkpoints.empty());
+    auto it = std::upper_bound(
+        checkpoints.begin(), checkpoints.end(), item,
+        [](uint64_t i, const Checkpoint& c) { return i < c.second; });
+    assert(it != checkpoints.begin());
+    return *(it - 1);
+}
+
+uint64_t BinaryIndex::OffsetAfter(uint64_t item) const {
+    auto it = std::lower_bound(
+        checkpoints.begin(), checkpoints.end(), item,
+        [](const Checkpoint& c, uint64_t i) { return c.second < i; });
+    return it == checkpoints.end() ? data_size : it->first;
+}
+
+} // namespace core
+} // namespace thrill
+
+/******************************************************************************/
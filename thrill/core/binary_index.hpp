@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * thrill/core/binary_index.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_BINARY_INDEX_HEADER
+#define THRILL_CORE_BINARY_INDEX_HEADER
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Index of item boundaries optionally appended by WriteBinary() to files of
+ * variable-size items, which lets ReadBinary() split files at items. It
+ * consists of checkpoints (offset, items): item number "items" begins at byte
+ * "offset" of the file, one for each written Block in which an item begins.
+ * The index is stored after the items as
+ *
+ *   checkpoints: (uint64_t offset, uint64_t items) * num_checkpoints
+ *   uint64_t total_items, uint64_t num_checkpoints
+ *   trailer: uint64_t index_size, magic "THRBIDX1"
+ *
+ * in host byte order, where index_size counts all bytes before the trailer.
+ */
+class BinaryIndex
+{
+public:
+    using Checkpoint = std::pair<uint64_t, uint64_t>;
+
+    //! checkpoints sorted by offset and item number
+    std::vector<Checkpoint> checkpoints;
+
+    //! total number of items in the file
+    uint64_t                total_items = 0;
+
+    //! size of the items in the file, which is the offset of the index
+    uint64_t                data_size = 0;
+
+    //! size of the trailer
+    static constexpr size_t trailer_size = 16;
+
+    //! Returns the serialized index with trailer.
+    std::string Serialize() const;
+
+    /*!
+     * Read the index from the end of the file at path with the given size.
+     * Returns false if the file has no index. Throws std::runtime_error if the
+     * index is invalid.
+     */
+    static bool Read(const std::string& path, uint64_t size, BinaryIndex* out);
+
+    //! Returns the last checkpoint at or before the given item.
+    const Checkpoint& CheckpointBefore(uint64_t item) const;
+
+    //! Returns the offset of the first checkpoint at or after the given item,
+    //! or data_size if there is none.
+    uint64_t OffsetAfter(uint64_t item) const;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_BINARY_INDEX_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * thrill/core/checkpoint_index.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/string.hpp>
+#include <thrill/core/checkpoint_index.hpp>
+#include <thrill/core/file_io.hpp>
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <string>
+
+namespace thrill {
+namespace core {
+
+//! magic bytes at the very end of a checkpoint file
+static const char checkpoint_magic[8] = {
+    'T', 'H', 'R', 'C', 'K', 'P', 'T', '1'
+};
+
+template <typename Type>
+static void Put(std::string* out, const Type& v) {
+    out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <typename Type>
+static Type Get(const char* p) {
+    Type v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+//! read exactly size bytes from path at offset, returns false on errors
+static bool ReadAt(const std::string& path, uint64_t offset,
+                   char* data, size_t size) {
+    SysFile file = SysFile::OpenForRead(path, false, offset);
+    while (size != 0) {
+        ssize_t rb = file.read(data, size);
+        if (rb <= 0) return false;
+        data += rb, size -= rb;
+    }
+    return true;
+}
+
+std::string CheckpointIndex::Serialize() const {
+    std::string out;
+    for (const Block& b : blocks) {
+        Put(&out, b.size);
+        Put(&out, b.first_item);
+        Put(&out, b.num_items);
+        Put(&out, b.typecode_verify);
+    }
+    Put(&out, static_cast<uint64_t>(blocks.size()));
+    Put(&out, worker);
+    Put(&out, num_workers);
+    Put(&out, static_cast<uint64_t>(out.size()));
+    out.append(checkpoint_magic, sizeof(checkpoint_magic));
+    return out;
+}
+
+bool CheckpointIndex::Read(const std::string& path, CheckpointIndex* out) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+        return false;
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    if (size < trailer_size) return false;
+
+    char trailer[trailer_size];
+    if (!ReadAt(path, size - trailer_size, trailer, trailer_size) ||
+        std::memcmp(trailer + 8, checkpoint_magic, 8) != 0)
+        return false;
+
+    uint64_t index_size = Get<uint64_t>(trailer);
+    if (index_size < 24 || index_size > size - trailer_size ||
+        (index_size - 24) % 32 != 0)
+        return false;
+
+    std::string data(index_size, 0);
+    if (!ReadAt(path, size - trailer_size - index_size, &data[0], index_size))
+        return false;
+
+    uint64_t num = Get<uint64_t>(data.data() + index_size - 24);
+    if (num != (index_size - 24) / 32) return false;
+    out->worker = Get<uint64_t>(data.data() + index_size - 16);
+    out->num_workers = Get<uint64_t>(data.data() + index_size - 8);
+
+    uint64_t data_size = 0;
+    out->blocks.clear();
+    for (uint64_t i = 0; i < num; ++i) {
+        const char* p = data.data() + 32 * i;
+        out->blocks.emplace_back(
+            Block { Get<uint64_t>(p), Get<uint64_t>(p + 8),
+                    Get<uint64_t>(p + 16), Get<uint64_t>(p + 24) });
+        data_size += out->blocks.back().size;
+    }
+
+    // the Blocks must fill the file up to the index
+    return data_size == size - trailer_size - index_size;
+}
+
+std::string CheckpointIndex::WorkerPath(
+    const std::string& path, size_t worker) {
+    return path + common::str_snprintf<>(32, "-worker-%05zu", worker);
+}
+
+} // namespace core
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * thrill/core/checkpoint_index.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_CHECKPOINT_INDEX_HEADER
+#define THRILL_CORE_CHECKPOINT_INDEX_HEADER
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Index of a checkpoint file written by DIA::Checkpoint(), which holds the
+ * Blocks of one worker's data::File in their internal format, such that they
+ * are restored without deserialization. The file contains the bytes of all
+ * Blocks, followed by the index
+ *
+ *   blocks: (uint64_t size, first_item, num_items, typecode_verify) * num
+ *   uint64_t num_blocks, uint64_t worker, uint64_t num_workers
+ *   trailer: uint64_t index_size, magic "THRCKPT1"
+ *
+ * in host byte order, where index_size counts all bytes of the index before the
+ * trailer. The first_item of a Block is relative to its first byte. Checkpoint
+ * files are written under a temporary name and renamed when complete.
+ */
+class CheckpointIndex
+{
+public:
+    //! Block of the checkpoint
+    struct Block {
+        uint64_t size, first_item, num_items, typecode_verify;
+    };
+
+    //! Blocks in the order of the file
+    std::vector<Block> blocks;
+
+    //! worker rank and number of workers which wrote the checkpoint
+    uint64_t           worker = 0, num_workers = 0;
+
+    //! size of the trailer
+    static constexpr size_t trailer_size = 16;
+
+    //! Returns the serialized index with trailer.
+    std::string Serialize() const;
+
+    /*!
+     * Read the index of the checkpoint file at path. Returns false if the file
+     * does not exist or is not a complete checkpoint.
+     */
+    static bool Read(const std::string& path, CheckpointIndex* out);
+
+    //! Returns the path of the worker's checkpoint file for the given base
+    //! path.
+    static std::string WorkerPath(const std::string& path, size_t worker);
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_CHECKPOINT_INDEX_HEADER
+
+/******************************************************************************/
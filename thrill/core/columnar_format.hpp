@@ -0,0 +1,314 @@
+/*******************************************************************************
+ * thrill/core/columnar_format.hpp
+ *
+ * Columnar file format written by WriteColumnar() and read by ReadColumnar().
+ *
+ * A file consists of chunks of rows, each chunk stores its columns one after
+ * another. The footer at the end of the file records for each chunk and column
+ * the byte range, the encoding, and the minimum and maximum value. A reader
+ * can thus read only some columns and skip whole chunks whose statistics
+ * cannot match a predicate. The layout is:
+ *
+ *   chunk 0: column 0 | column 1 | ...
+ *   chunk 1: column 0 | column 1 | ...
+ *   ...
+ *   footer: num_columns, value_size[num_columns], num_chunks,
+ *           for each chunk: rows, for each column: offset, size, encoding,
+ *                           width, min, max
+ *   trailer: footer_size (uint64_t), magic "THRCOL01"
+ *
+ * Integers are stored in host byte order, like in WriteBinary().
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_COLUMNAR_FORMAT_HEADER
+#define THRILL_CORE_COLUMNAR_FORMAT_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace core {
+namespace columnar {
+
+//! magic bytes at the very end of a columnar file
+static constexpr char magic[8] = { 'T', 'H', 'R', 'C', 'O', 'L', '0', '1' };
+
+//! size of the trailer: footer size and magic
+static constexpr size_t trailer_size = sizeof(uint64_t) + sizeof(magic);
+
+//! lightweight encodings of column chunks
+enum class Encoding : uint8_t {
+    //! values as raw bytes
+    Plain = 0,
+    //! all values are equal to min, no data is stored
+    Constant = 1,
+    //! integers stored as value - min in fewer bytes
+    Narrow = 2
+};
+
+//! Location, encoding, and statistics of a column in a chunk.
+struct ColumnMeta {
+    //! byte offset and size of the encoded data in the file
+    uint64_t    offset, size;
+    //! encoding of the data
+    Encoding    encoding;
+    //! byte width of each value for Encoding::Narrow
+    uint8_t     width;
+    //! raw bytes of the minimum and maximum value
+    std::string min, max;
+};
+
+//! Number of rows and columns of a chunk.
+struct ChunkMeta {
+    uint64_t                rows;
+    std::vector<ColumnMeta> columns;
+};
+
+//! Contents of the footer.
+struct Footer {
+    //! sizeof() each column's value type, checked by the reader
+    std::vector<uint64_t>  value_sizes;
+    //! all chunks of the file
+    std::vector<ChunkMeta> chunks;
+
+    //! append the footer and trailer to out
+    void Serialize(std::string* out) const {
+        size_t begin = out->size();
+        Put(out, static_cast<uint64_t>(value_sizes.size()));
+        for (uint64_t s : value_sizes) Put(out, s);
+        Put(out, static_cast<uint64_t>(chunks.size()));
+        for (const ChunkMeta& c : chunks) {
+            Put(out, c.rows);
+            for (size_t i = 0; i < value_sizes.size(); ++i) {
+                const ColumnMeta& m = c.columns[i];
+                Put(out, m.offset);
+                Put(out, m.size);
+                Put(out, static_cast<uint8_t>(m.encoding));
+                Put(out, m.width);
+                out->append(m.min);
+                out->append(m.max);
+            }
+        }
+        Put(out, static_cast<uint64_t>(out->size() - begin));
+        out->append(magic, sizeof(magic));
+    }
+
+    //! parse a footer without trailer, throws std::runtime_error if invalid.
+    static Footer Deserialize(const std::string& data, const std::string& path) {
+        Footer f;
+        const char* p = data.data(), * end = p + data.size();
+        uint64_t num_columns = Get<uint64_t>(&p, end, path);
+        for (uint64_t i = 0; i < num_columns; ++i)
+            f.value_sizes.push_back(Get<uint64_t>(&p, end, path));
+        uint64_t num_chunks = Get<uint64_t>(&p, end, path);
+        for (uint64_t c = 0; c < num_chunks; ++c) {
+            ChunkMeta chunk;
+            chunk.rows = Get<uint64_t>(&p, end, path);
+            for (uint64_t i = 0; i < num_columns; ++i) {
+                ColumnMeta m;
+                m.offset = Get<uint64_t>(&p, end, path);
+                m.size = Get<uint64_t>(&p, end, path);
+                m.encoding = static_cast<Encoding>(Get<uint8_t>(&p, end, path));
+                m.width = Get<uint8_t>(&p, end, path);
+                if (static_cast<uint64_t>(end - p) < 2 * f.value_sizes[i])
+                    Invalid(path);
+                m.min.assign(p, f.value_sizes[i]), p += f.value_sizes[i];
+                m.max.assign(p, f.value_sizes[i]), p += f.value_sizes[i];
+                chunk.columns.emplace_back(std::move(m));
+            }
+            f.chunks.emplace_back(std::move(chunk));
+        }
+        return f;
+    }
+
+    //! throw an error about an invalid file
+    static void Invalid(const std::string& path) {
+        throw std::runtime_error("Invalid columnar file " + path);
+    }
+
+private:
+    template <typename Type>
+    static void Put(std::string* out, const Type& v) {
+        out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    template <typename Type>
+    static Type Get(const char** p, const char* end, const std::string& path) {
+        if (static_cast<size_t>(end - *p) < sizeof(Type)) Invalid(path);
+        Type v;
+        std::memcpy(&v, *p, sizeof(v));
+        *p += sizeof(v);
+        return v;
+    }
+};
+
+//! Tuple of std::vectors holding the columns of a std::tuple type.
+template <typename Tuple>
+struct ColumnVectors;
+
+template <typename ... Types>
+struct ColumnVectors<std::tuple<Types ...> >{
+    using type = std::tuple<std::vector<Types> ...>;
+};
+
+/******************************************************************************/
+
+//! Helper for Encoding::Narrow, only for integers except bool.
+template <typename Type, typename Enable = void>
+struct Narrow {
+    static constexpr bool supported = false;
+
+    static size_t Width(const Type&, const Type&) { return sizeof(Type); }
+    static void Encode(const Type*, size_t, const Type&, size_t, char*) { }
+    static void Decode(const char*, size_t, const Type&, size_t, Type*) { }
+};
+
+template <typename Type>
+struct Narrow<Type, typename std::enable_if<
+                  std::is_integral<Type>::value &&
+                  !std::is_same<Type, bool>::value>::type>{
+    static constexpr bool supported = true;
+    using Unsigned = typename std::make_unsigned<Type>::type;
+
+    //! smallest width in bytes to store value - min of all values
+    static size_t Width(const Type& min, const Type& max) {
+        uint64_t range = static_cast<Unsigned>(
+            static_cast<Unsigned>(max) - static_cast<Unsigned>(min));
+        return range <= 0xFF ? 1 : range <= 0xFFFF ? 2 :
+               range <= 0xFFFFFFFFu ? 4 : 8;
+    }
+
+    static void Encode(const Type* values, size_t n, const Type& min,
+                       size_t width, char* out) {
+        for (size_t i = 0; i < n; ++i, out += width) {
+            uint64_t d = static_cast<Unsigned>(
+                static_cast<Unsigned>(values[i]) - static_cast<Unsigned>(min));
+            if (width == 1)
+                Store(static_cast<uint8_t>(d), out);
+            else if (width == 2)
+                Store(static_cast<uint16_t>(d), out);
+            else
+                Store(static_cast<uint32_t>(d), out);
+        }
+    }
+
+    static void Decode(const char* data, size_t n, const Type& min,
+                       size_t width, Type* out) {
+        for (size_t i = 0; i < n; ++i, data += width) {
+            uint64_t d =
+                width == 1 ? Load<uint8_t>(data) :
+                width == 2 ? Load<uint16_t>(data) : Load<uint32_t>(data);
+            out[i] = static_cast<Type>(
+                static_cast<Unsigned>(static_cast<Unsigned>(min) + d));
+        }
+    }
+
+private:
+    template <typename Word>
+    static void Store(const Word& v, char* out) {
+        std::memcpy(out, &v, sizeof(v));
+    }
+
+    template <typename Word>
+    static Word Load(const char* data) {
+        Word v;
+        std::memcpy(&v, data, sizeof(v));
+        return v;
+    }
+};
+
+//! Encode the values of a column chunk, append the data to out, and return its
+//! metadata, except for the offset.
+template <typename Type>
+ColumnMeta EncodeColumn(const std::vector<Type>& values, std::string* out) {
+    static_assert(std::is_trivially_copyable<Type>::value,
+                  "columnar values must be trivially copyable");
+    assert(!values.empty());
+
+    Type min = values[0], max = values[0];
+    for (const Type& v : values) {
+        if (v < min) min = v;
+        if (max < v) max = v;
+    }
+
+    ColumnMeta m;
+    m.offset = 0;
+    m.min.assign(reinterpret_cast<const char*>(&min), sizeof(Type));
+    m.max.assign(reinterpret_cast<const char*>(&max), sizeof(Type));
+    m.width = 0;
+
+    size_t begin = out->size();
+
+    size_t width = Narrow<Type>::Width(min, max);
+    if (!(min < max) && !(max < min)) {
+        m.encoding = Encoding::Constant;
+    }
+    else if (Narrow<Type>::supported && width < sizeof(Type) && width <= 4) {
+        m.encoding = Encoding::Narrow;
+        m.width = static_cast<uint8_t>(width);
+        out->resize(begin + values.size() * width);
+        Narrow<Type>::Encode(values.data(), values.size(), min, width,
+                             &(*out)[begin]);
+    }
+    else {
+        m.encoding = Encoding::Plain;
+        out->append(reinterpret_cast<const char*>(values.data()),
+                    values.size() * sizeof(Type));
+    }
+
+    m.size = out->size() - begin;
+    return m;
+}
+
+//! Returns the minimum or maximum value stored in raw bytes.
+template <typename Type>
+Type StatValue(const std::string& raw) {
+    Type v;
+    std::memcpy(&v, raw.data(), sizeof(Type));
+    return v;
+}
+
+//! Decode the data of a column chunk with rows values into out.
+template <typename Type>
+void DecodeColumn(const ColumnMeta& m, const char* data, size_t rows,
+                  std::vector<Type>* out, const std::string& path) {
+    out->resize(rows);
+    switch (m.encoding) {
+    case Encoding::Constant:
+        std::fill(out->begin(), out->end(), StatValue<Type>(m.min));
+        break;
+    case Encoding::Narrow:
+        if (!Narrow<Type>::supported || m.size != rows * m.width ||
+            (m.width != 1 && m.width != 2 && m.width != 4))
+            Footer::Invalid(path);
+        Narrow<Type>::Decode(data, rows, StatValue<Type>(m.min), m.width,
+                             out->data());
+        break;
+    case Encoding::Plain:
+        if (m.size != rows * sizeof(Type)) Footer::Invalid(path);
+        std::memcpy(out->data(), data, m.size);
+        break;
+    default:
+        Footer::Invalid(path);
+    }
+}
+
+} // namespace columnar
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_COLUMNAR_FORMAT_HEADER
+
+/******************************************************************************/
@@ -12,8 +12,11 @@
 #include <thrill/common/porting.hpp>
 #include <thrill/common/string.hpp>
 #include <thrill/common/system_exception.hpp>
+#include <thrill/core/bgzf_file.hpp>
 #include <thrill/core/file_io.hpp>
+#include <thrill/core/remote_file_system.hpp>
 #include <thrill/core/simple_glob.hpp>
+#include <thrill/io/file_mapping.hpp>
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -39,6 +42,8 @@
 #endif
 
 #include <algorithm>
+#include <cassert>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -88,6 +93,9 @@ std::string FillFilePattern(const std::string& pathbase,
 
 std::vector<std::string> GlobFilePattern(const std::string& path) {
 
+    if (IsRemotePath(path))
+        return RemoteGlob(path);
+
     std::vector<std::string> files;
 
 #if defined(_MSC_VER)
@@ -130,9 +138,24 @@ SysFileList GlobFileSizePrefixSum(const std::vector<std::string>& files) {
     struct stat filestat;
     uint64_t total_size = 0;
     bool contains_compressed = false;
+    bool contains_remote = false;
+    bool all_bgzf = true;
 
     for (const std::string& file : files) {
 
+        if (IsRemotePath(file)) {
+            uint64_t size = RemoteFileSize(file);
+
+            contains_compressed = contains_compressed || IsCompressed(file);
+            contains_remote = true;
+            all_bgzf = false;
+
+            file_info.emplace_back(SysFileInfo { file, size, total_size });
+
+            total_size += size;
+            continue;
+        }
+
         if (stat(file.c_str(), &filestat)) {
             throw std::runtime_error(
                       "ERROR: Invalid file " + std::string(file));
@@ -140,6 +163,7 @@ SysFileList GlobFileSizePrefixSum(const std::vector<std::string>& files) {
         if (!S_ISREG(filestat.st_mode)) continue;
 
         contains_compressed = contains_compressed || IsCompressed(file);
+        all_bgzf = all_bgzf && common::EndsWith(file, ".gz") && IsBgzf(file);
 
         file_info.emplace_back(
             SysFileInfo { std::move(file),
@@ -148,13 +172,16 @@ SysFileList GlobFileSizePrefixSum(const std::vector<std::string>& files) {
         total_size += filestat.st_size;
     }
 
+    all_bgzf = all_bgzf && !file_info.empty();
+
     // sentinel entry
     file_info.emplace_back(
         SysFileInfo { std::string(),
                       static_cast<uint64_t>(0), total_size });
 
     return SysFileList {
-               std::move(file_info), total_size, contains_compressed
+               std::move(file_info), total_size, contains_compressed,
+               contains_remote, all_bgzf
     };
 }
 
@@ -175,12 +202,19 @@ void SysFile::close() {
 #if !defined(_MSC_VER)
     if (pid_ != 0) {
         sLOG << "SysFile::close(): waitpid for" << pid_;
+        pid_t pid = pid_;
+        // the child is reaped only once, even if its status throws.
+        pid_ = 0;
         int status;
-        pid_t p = waitpid(pid_, &status, 0);
-        if (p != pid_) {
+        pid_t p = waitpid(pid, &status, 0);
+        if (p != pid) {
             throw common::SystemException(
                       "SysFile: waitpid() failed to return child");
         }
+        // a reader which stopped before the end of a pipe, e.g. at the end of
+        // its range of a remote file, cut off the child while it was writing,
+        // hence the child's failure does not matter.
+        if (read_pipe_ && !eof_) return;
         if (WIFEXITED(status)) {
             // child program exited normally
             if (WEXITSTATUS(status) != 0) {
@@ -201,12 +235,158 @@ void SysFile::close() {
             throw common::ErrnoException(
                       "SysFile: child failed with an unknown error");
         }
-        pid_ = 0;
     }
 #endif
 }
 
-SysFile SysFile::OpenForRead(const std::string& path) {
+void SysFile::truncate(uint64_t size) {
+    assert(fd_ >= 0);
+#if defined(_MSC_VER)
+    int r = ::_chsize_s(fd_, static_cast<__int64>(size));
+#else
+    int r = ::ftruncate(fd_, static_cast<off_t>(size));
+#endif
+    if (r != 0) {
+        throw common::ErrnoException(
+                  "SysFile: cannot truncate file to " + std::to_string(size));
+    }
+}
+
+bool DefaultDirectIO() {
+    static bool default_direct_io = []() {
+        const char* env = getenv("THRILL_DIRECT_IO");
+        return env && *env && *env != '0';
+    } ();
+    return default_direct_io;
+}
+
+bool DefaultReadBinaryMmap() {
+    static bool default_read_binary_mmap = []() {
+        const char* env = getenv("THRILL_READ_BINARY_MMAP");
+        if (env && *env) return *env != '0';
+        return io::FileMapping::supported() && !DefaultDirectIO();
+    } ();
+    return default_read_binary_mmap;
+}
+
+size_t DefaultReadBinaryReadAhead() {
+    static size_t default_read_ahead = []() -> size_t {
+        const char* env = getenv("THRILL_READ_BINARY_READ_AHEAD");
+        if (env && *env) return std::strtoul(env, nullptr, 10);
+        return 2;
+    } ();
+    return default_read_ahead;
+}
+
+size_t DefaultReadBinaryOpenFiles() {
+    static size_t default_open_files = []() -> size_t {
+        const char* env = getenv("THRILL_READ_BINARY_OPEN_FILES");
+        if (env && *env)
+            return std::max<size_t>(1, std::strtoul(env, nullptr, 10));
+        return 2;
+    } ();
+    return default_open_files;
+}
+
+bool SysFile::set_direct(bool direct) {
+#if defined(O_DIRECT)
+    assert(fd_ >= 0);
+    if (direct == direct_) return true;
+    int flags = ::fcntl(fd_, F_GETFL);
+    if (flags < 0) return false;
+    flags = direct ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    if (::fcntl(fd_, F_SETFL, flags) != 0) {
+        sLOG << "SysFile::set_direct(): fcntl failed:" << strerror(errno);
+        return false;
+    }
+    direct_ = direct;
+    return true;
+#else
+    return !direct;
+#endif
+}
+
+//! Returns the program to (de)compress path with, or nullptr.
+static const char* CompressorOf(const std::string& path) {
+    if (common::EndsWith(path, ".gz"))
+        return "gzip";
+    if (common::EndsWith(path, ".bz2"))
+        return "bzip2";
+    if (common::EndsWith(path, ".xz"))
+        return "xz";
+    if (common::EndsWith(path, ".lzo"))
+        return "lzop";
+    if (common::EndsWith(path, ".lz4"))
+        return "lz4";
+    return nullptr;
+}
+
+SysFile SysFile::OpenShell(const std::string& cmd, bool for_write) {
+#if defined(_MSC_VER)
+    throw common::SystemException(
+              "Remote file systems are not supported on windows, yet. "
+              "Please submit a patch.");
+#else
+    // fork a child shell which runs the command and connect its stdin or
+    // stdout via a pipe.
+
+    // pipe[0] = read, pipe[1] = write
+    int pipefd[2];
+    common::MakePipe(pipefd);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (for_write) {
+            // close write end and replace stdin with pipe
+            ::close(pipefd[1]);
+            dup2(pipefd[0], STDIN_FILENO);
+            ::close(pipefd[0]);
+        }
+        else {
+            // close read end and replace stdout with pipe
+            ::close(pipefd[0]);
+            dup2(pipefd[1], STDOUT_FILENO);
+            ::close(pipefd[1]);
+        }
+
+        execl("/bin/sh", "sh", "-c", cmd.c_str(), nullptr);
+
+        LOG1 << "Pipe execution failed: " << strerror(errno);
+        exit(-1);
+    }
+    else if (pid < 0) {
+        throw common::ErrnoException("Error creating child process");
+    }
+
+    sLOG << "SysFile::OpenShell(): pipe to pid" << pid << "running" << cmd;
+
+    if (for_write) {
+        ::close(pipefd[0]);
+        return SysFile(pipefd[1], pid);
+    }
+    else {
+        ::close(pipefd[1]);
+        return SysFile(pipefd[0], pid, /* read_pipe */ true);
+    }
+#endif
+}
+
+SysFile SysFile::OpenForRead(
+    const std::string& path, bool direct, uint64_t offset) {
+
+    if (offset != 0 && IsCompressed(path)) {
+        throw std::runtime_error(
+                  "Cannot open compressed file " + path + " at an offset");
+    }
+
+    // remote files are read by a command, possibly piped into a decompressor.
+
+    if (RemoteFileSystemPtr fs = FindRemoteFileSystem(path)) {
+        std::string cmd = fs->ReadCommand(path, offset);
+        if (const char* decompressor = CompressorOf(path))
+            cmd += std::string(" | ") + decompressor + " -d";
+        return OpenShell(cmd, /* for_write */ false);
+    }
 
     // first open the file and see if it exists at all.
 
@@ -217,30 +397,24 @@ SysFile SysFile::OpenForRead(const std::string& path) {
 
     // then figure out whether we need to pipe it through a decompressor.
 
-    const char* decompressor;
+    const char* decompressor = CompressorOf(path);
 
-    if (common::EndsWith(path, ".gz")) {
-        decompressor = "gzip";
-    }
-    else if (common::EndsWith(path, ".bz2")) {
-        decompressor = "bzip2";
-    }
-    else if (common::EndsWith(path, ".xz")) {
-        decompressor = "xz";
-    }
-    else if (common::EndsWith(path, ".lzo")) {
-        decompressor = "lzop";
-    }
-    else if (common::EndsWith(path, ".lz4")) {
-        decompressor = "lz4";
-    }
-    else {
+    if (decompressor == nullptr) {
         // not a compressed file
         common::PortSetCloseOnExec(fd);
 
         sLOG << "SysFile::OpenForRead(): filefd" << fd;
 
-        return SysFile(fd);
+        if (offset != 0 &&
+            ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            ::close(fd);
+            throw common::ErrnoException("Cannot seek in file " + path);
+        }
+
+        SysFile file(fd);
+        // stay with buffered I/O if the file system does not support O_DIRECT
+        if (direct) file.set_direct(true);
+        return file;
     }
 
 #if defined(_MSC_VER)
@@ -286,11 +460,20 @@ SysFile SysFile::OpenForRead(const std::string& path) {
     // close the file descriptor
     ::close(fd);
 
-    return SysFile(pipefd[0], pid);
+    return SysFile(pipefd[0], pid, /* read_pipe */ true);
 #endif
 }
 
-SysFile SysFile::OpenForWrite(const std::string& path) {
+SysFile SysFile::OpenForWrite(const std::string& path, bool direct) {
+
+    // remote files are stored by a command, possibly fed by a compressor.
+
+    if (RemoteFileSystemPtr fs = FindRemoteFileSystem(path)) {
+        std::string cmd = fs->WriteCommand(path);
+        if (const char* compressor = CompressorOf(path))
+            cmd = std::string(compressor) + " | " + cmd;
+        return OpenShell(cmd, /* for_write */ true);
+    }
 
     // first create the file and see if we can write it at all.
 
@@ -301,30 +484,18 @@ SysFile SysFile::OpenForWrite(const std::string& path) {
 
     // then figure out whether we need to pipe it through a compressor.
 
-    const char* compressor;
+    const char* compressor = CompressorOf(path);
 
-    if (common::EndsWith(path, ".gz")) {
-        compressor = "gzip";
-    }
-    else if (common::EndsWith(path, ".bz2")) {
-        compressor = "bzip2";
-    }
-    else if (common::EndsWith(path, ".xz")) {
-        compressor = "xz";
-    }
-    else if (common::EndsWith(path, ".lzo")) {
-        compressor = "lzop";
-    }
-    else if (common::EndsWith(path, ".lz4")) {
-        compressor = "lz4";
-    }
-    else {
+    if (compressor == nullptr) {
         // not a compressed file
         common::PortSetCloseOnExec(fd);
 
         sLOG << "SysFile::OpenForWrite(): filefd" << fd;
 
-        return SysFile(fd);
+        SysFile file(fd);
+        // stay with buffered I/O if the file system does not support O_DIRECT
+        if (direct) file.set_direct(true);
+        return file;
     }
 
 #if defined(_MSC_VER)
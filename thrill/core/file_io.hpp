@@ -27,6 +27,7 @@
 
 #endif
 
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -80,6 +81,13 @@ struct SysFileList {
 
     //! whether the list contains a compressed file.
     bool                     contains_compressed;
+
+    //! whether the list contains a remote file, see RemoteFileSystem.
+    bool                     contains_remote;
+
+    //! whether all files are BGZF files, which are split among the workers
+    //! at member boundaries like uncompressed files, see IsBgzf().
+    bool                     all_bgzf;
 };
 
 /*!
@@ -95,6 +103,27 @@ std::vector<std::string> GlobFilePattern(const std::string& path);
 std::vector<std::string> GlobFilePatterns(
     const std::vector<std::string>& globlist);
 
+//! Whether ReadBinary and WriteBinary open uncompressed files with O_DIRECT,
+//! bypassing the page cache. The default is taken from the environment
+//! variable THRILL_DIRECT_IO, which is off if unset.
+bool DefaultDirectIO();
+
+//! Whether ReadBinary memory maps uncompressed files and exposes them as
+//! zero-copy Blocks. The default is taken from the environment variable
+//! THRILL_READ_BINARY_MMAP, which is on if unset and THRILL_DIRECT_IO is off.
+bool DefaultReadBinaryMmap();
+
+//! Number of Blocks which ReadBinary reads ahead in a reader thread per file
+//! read via SysFile, such that reading overlaps with processing. The default
+//! is taken from the environment variable THRILL_READ_BINARY_READ_AHEAD, which
+//! is 2 if unset, and 0 reads synchronously.
+size_t DefaultReadBinaryReadAhead();
+
+//! Number of files which ReadBinary opens and reads ahead at once, which
+//! helps striped disks. The default is taken from the environment variable
+//! THRILL_READ_BINARY_OPEN_FILES, which is 2 if unset.
+size_t DefaultReadBinaryOpenFiles();
+
 /*!
  * Represents a POSIX system file via its file descriptor.
  */
@@ -109,19 +138,38 @@ public:
     /*!
      * Open file for reading and return file descriptor. Handles compressed
      * files by calling a decompressor in a pipe, like "cat $f | gzip -dc |" in
-     * bash.
+     * bash, and remote files like s3://bucket/key by reading the output of a
+     * command, see RemoteFileSystem.
      *
      * \param path Path to open
+     *
+     * \param direct Open uncompressed files with O_DIRECT, if supported.
+     *
+     * \param offset Start reading an uncompressed file at this offset. Remote
+     * files are requested from the offset onward, see RemoteFileSystem.
      */
-    static SysFile OpenForRead(const std::string& path);
+    static SysFile OpenForRead(const std::string& path, bool direct = false,
+                               uint64_t offset = 0);
 
     /*!
      * Open file for writing and return file descriptor. Handles compressed
-     * files by calling a compressor in a pipe, like "| gzip -d > $f" in bash.
+     * files by calling a compressor in a pipe, like "| gzip -d > $f" in bash,
+     * and remote files by piping into a command storing them.
      *
      * \param path Path to open
+     *
+     * \param direct Open uncompressed files with O_DIRECT, if supported.
      */
-    static SysFile OpenForWrite(const std::string& path);
+    static SysFile OpenForWrite(const std::string& path, bool direct = false);
+
+    //! Alignment of buffers, sizes, and file offsets required by O_DIRECT.
+    static constexpr size_t direct_alignment = 4096;
+
+    //! Check whether a buffer and size are aligned for O_DIRECT.
+    static bool IsDirectAligned(const void* data, size_t count) {
+        return reinterpret_cast<uintptr_t>(data) % direct_alignment == 0 &&
+               count % direct_alignment == 0;
+    }
 
     //! non-copyable: delete copy-constructor
     SysFile(const SysFile&) = delete;
@@ -129,17 +177,27 @@ public:
     SysFile& operator = (const SysFile&) = delete;
     //! move-constructor
     SysFile(SysFile&& f) noexcept
-        : fd_(f.fd_), pid_(f.pid_) {
-        f.fd_ = -1, f.pid_ = 0;
+        : fd_(f.fd_), pid_(f.pid_), read_pipe_(f.read_pipe_), eof_(f.eof_),
+          direct_(f.direct_) {
+        f.fd_ = -1, f.pid_ = 0, f.read_pipe_ = false, f.direct_ = false;
     }
     //! move-assignment
     SysFile& operator = (SysFile&& f) {
         close();
-        fd_ = f.fd_, pid_ = f.pid_;
-        f.fd_ = -1, f.pid_ = 0;
+        fd_ = f.fd_, pid_ = f.pid_, direct_ = f.direct_;
+        read_pipe_ = f.read_pipe_, eof_ = f.eof_;
+        f.fd_ = -1, f.pid_ = 0, f.read_pipe_ = false, f.direct_ = false;
         return *this;
     }
 
+    //! whether the file descriptor is in O_DIRECT mode, which requires
+    //! buffers, sizes, and file offsets aligned to direct_alignment.
+    bool direct() const { return direct_; }
+
+    //! Switch O_DIRECT mode on or off, e.g. for an unaligned tail of the
+    //! file. Returns false if the mode could not be changed.
+    bool set_direct(bool direct);
+
     //! POSIX write function.
     ssize_t write(const void* data, size_t count) {
         assert(fd_ >= 0);
@@ -154,12 +212,30 @@ public:
     ssize_t read(void* data, size_t count) {
         assert(fd_ >= 0);
 #if defined(_MSC_VER)
-        return ::_read(fd_, data, static_cast<unsigned>(count));
+        ssize_t r = ::_read(fd_, data, static_cast<unsigned>(count));
 #else
-        return ::read(fd_, data, count);
+        ssize_t r = ::read(fd_, data, count);
 #endif
+        if (r == 0 && count != 0) eof_ = true;
+        return r;
     }
 
+    //! POSIX pwrite function: write at offset without moving the file
+    //! position.
+    ssize_t pwrite(const void* data, size_t count, uint64_t offset) {
+        assert(fd_ >= 0);
+#if defined(_MSC_VER)
+        if (::_lseeki64(fd_, static_cast<__int64>(offset), SEEK_SET) < 0)
+            return -1;
+        return ::_write(fd_, data, static_cast<unsigned>(count));
+#else
+        return ::pwrite(fd_, data, count, static_cast<off_t>(offset));
+#endif
+    }
+
+    //! Set the size of the file, throws on errors.
+    void truncate(uint64_t size);
+
     //! POSIX lseek function from current position.
     ssize_t lseek(off_t offset) {
         assert(fd_ >= 0);
@@ -174,9 +250,13 @@ public:
     }
 
 private:
+    //! Run a shell command and connect its stdout, or stdin if for_write, to
+    //! the returned file via a pipe.
+    static SysFile OpenShell(const std::string& cmd, bool for_write);
+
     //! private constructor: use OpenForRead or OpenForWrite.
-    explicit SysFile(int fd, int pid = 0) noexcept
-        : fd_(fd), pid_(pid) { }
+    explicit SysFile(int fd, int pid = 0, bool read_pipe = false) noexcept
+        : fd_(fd), pid_(pid), read_pipe_(read_pipe) { }
 
     //! file descriptor
     int fd_ = -1;
@@ -187,6 +267,15 @@ private:
 
     //! pid of child process to wait for
     pid_t pid_ = 0;
+
+    //! whether fd_ reads the output of the child process
+    bool read_pipe_ = false;
+
+    //! whether read() returned the end of the file
+    bool eof_ = false;
+
+    //! whether O_DIRECT is set on the file descriptor
+    bool direct_ = false;
 };
 
 /*!
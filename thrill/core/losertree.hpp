@@ -30,7 +30,10 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <ostream>
+#include <type_traits>
+#include <vector>
 
 namespace thrill {
 namespace core {
@@ -869,9 +872,169 @@ public:
     }
 };
 
+/******************************************************************************/
+// LoserTreeArithmetic: branch-free tournament tree for arithmetic keys
+
+/*!
+ * Sentinel of an arithmetic key order: a value which is not less than any key,
+ * hence infinity for floating point types. Keys equal to the sentinel still win
+ * against it by the rank. Only std::less and std::greater of arithmetic types
+ * are supported.
+ */
+template <typename ValueType, typename Comparator>
+struct LoserTreeSentinel {
+    static constexpr bool valid = false;
+};
+
+template <typename ValueType>
+struct LoserTreeSentinel<ValueType, std::less<ValueType> >{
+    static constexpr bool valid = std::is_arithmetic<ValueType>::value;
+    static ValueType value() {
+        using Limits = std::numeric_limits<ValueType>;
+        return Limits::has_infinity ? Limits::infinity() : Limits::max();
+    }
+};
+
+template <typename ValueType>
+struct LoserTreeSentinel<ValueType, std::greater<ValueType> >{
+    static constexpr bool valid = std::is_arithmetic<ValueType>::value;
+    static ValueType value() {
+        using Limits = std::numeric_limits<ValueType>;
+        return Limits::has_infinity ? -Limits::infinity() : Limits::lowest();
+    }
+};
+
+/*!
+ * Loser tree specialized for arithmetic keys ordered by std::less or
+ * std::greater. Exhausted sources hold the sentinel key, and ties are broken
+ * by a rank, which is the source index for valid keys and the source index
+ * plus k for exhausted sources. Hence, the games played while replaying a
+ * path need no sup flag branches and compile to conditional moves, the source
+ * is recovered from the rank, and the tree is always stable.
+ *
+ * For small k, which is the usual case of merging a few sorted runs, the whole
+ * tree is only a few cache lines large.
+ *
+ * \tparam ValueType the element type
+ * \tparam Comparator std::less<ValueType> or std::greater<ValueType>
+ */
+template <bool Stable, typename ValueType, typename Comparator>
+class LoserTreeArithmetic
+{
+public:
+    //! size of counters and array indexes
+    using size_type = unsigned int;
+    //! type of the source field
+    using Source = int;
+
+    using Sentinel = LoserTreeSentinel<ValueType, Comparator>;
+
+    static_assert(Sentinel::valid,
+                  "LoserTreeArithmetic requires arithmetic keys");
+
+    explicit LoserTreeArithmetic(size_type k,
+                                 const Comparator& cmp = Comparator())
+        : ik_(k),
+          k_(common::RoundUpToPowerOfTwo(std::max<size_type>(ik_, 1))),
+          losers_(2 * k_),
+          cmp_(cmp) {
+        for (size_type i = 0; i < k_; ++i)
+            losers_[k_ + i] = Loser { Sentinel::value(), k_ + i };
+    }
+
+    //! return the index of the player with the smallest element.
+    Source min_source() const {
+        return static_cast<Source>(losers_[0].rank & (k_ - 1));
+    }
+
+    /*!
+     * Initializes the player source with the element key.
+     *
+     * \param keyp the element to insert
+     * \param source index of the player
+     * \param sup flag that determines whether the value to insert is an
+     *   explicit supremum sentinel.
+     */
+    void insert_start(const ValueType* keyp, Source source, bool sup) {
+        assert(sup == (keyp == nullptr));
+        losers_[k_ + source] = make_loser(keyp, source, sup);
+    }
+
+    //! Computes the winner of the competition at player root recursively.
+    size_type init_winner(size_type root) {
+        if (root >= k_)
+            return root;
+
+        size_type left = init_winner(2 * root);
+        size_type right = init_winner(2 * root + 1);
+        if (wins(losers_[right], losers_[left])) {
+            losers_[root] = losers_[left];
+            return right;
+        }
+        else {
+            losers_[root] = losers_[right];
+            return left;
+        }
+    }
+
+    void init() {
+        losers_[0] = losers_[init_winner(1)];
+    }
+
+    //! Replace the smallest element with a new one and replay its path.
+    void delete_min_insert(const ValueType* keyp, bool sup) {
+        assert(sup == (keyp == nullptr));
+
+        Source source = min_source();
+        Loser cur = make_loser(keyp, source, sup);
+
+        for (size_type pos = (k_ + source) / 2; pos > 0; pos /= 2)
+        {
+            // the winner moves on: select by index instead of branching
+            const Loser pair[2] = { cur, losers_[pos] };
+            size_t other_wins = wins(pair[1], pair[0]);
+            losers_[pos] = pair[1 - other_wins];
+            cur = pair[other_wins];
+        }
+
+        losers_[0] = cur;
+    }
+
+private:
+    //! Internal representation of a loser tree player/node
+    struct Loser
+    {
+        //! copy of key value, the sentinel if exhausted
+        ValueType key;
+        //! tie breaking rank: source index, plus k_ if exhausted
+        size_type rank;
+    };
+
+    //! number of nodes
+    const size_type ik_;
+    //! log_2(ik) next greater power of 2
+    const size_type k_;
+    //! array containing loser tree nodes
+    std::vector<Loser> losers_;
+    //! the comparator object
+    Comparator cmp_;
+
+    Loser make_loser(const ValueType* keyp, Source source, bool sup) const {
+        return Loser { sup ? Sentinel::value() : *keyp,
+                       static_cast<size_type>(source) + (sup ? k_ : 0) };
+    }
+
+    //! true if a wins the game against b
+    bool wins(const Loser& a, const Loser& b) const {
+        return cmp_(a.key, b.key) | (!cmp_(b.key, a.key) & (a.rank < b.rank));
+    }
+};
+
 /******************************************************************************/
 // LoserTreeTraits selects loser tree by size of value type
 
+// and uses the branch-free LoserTreeArithmetic for arithmetic keys.
+
 template <bool Stable, typename ValueType, typename Comparator,
           typename Enable = void>
 struct LoserTreeTraits
@@ -883,11 +1046,22 @@ public:
 template <bool Stable, typename ValueType, typename Comparator>
 struct LoserTreeTraits<
     Stable, ValueType, Comparator,
-    typename std::enable_if<sizeof(ValueType) <= 2* sizeof(size_t)>::type>
+    typename std::enable_if<
+        sizeof(ValueType) <= 2* sizeof(size_t) &&
+        !LoserTreeSentinel<ValueType, Comparator>::valid>::type>
 {
     using Type = LoserTreeCopy<Stable, ValueType, Comparator>;
 };
 
+template <bool Stable, typename ValueType, typename Comparator>
+struct LoserTreeTraits<
+    Stable, ValueType, Comparator,
+    typename std::enable_if<
+        LoserTreeSentinel<ValueType, Comparator>::valid>::type>
+{
+    using Type = LoserTreeArithmetic<Stable, ValueType, Comparator>;
+};
+
 template <bool Stable, typename ValueType, typename Comparator,
           typename Enable = void>
 class LoserTreeTraitsUnguarded
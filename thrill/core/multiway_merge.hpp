@@ -12,23 +12,31 @@
 #ifndef THRILL_CORE_MULTIWAY_MERGE_HEADER
 #define THRILL_CORE_MULTIWAY_MERGE_HEADER
 
+#include <thrill/common/work_stealing_pool.hpp>
 #include <thrill/core/losertree.hpp>
+#include <thrill/data/file.hpp>
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace core {
 
-template <typename ValueType, typename ReaderIterator, typename Comparator>
+template <typename ValueType, typename ReaderIterator, typename Comparator,
+          bool Stable = false,
+          typename LoserTree = typename core::LoserTreeTraits<
+              Stable, ValueType, Comparator>::Type>
 class MultiwayMergeTree
 {
 public:
     using Reader = typename std::iterator_traits<ReaderIterator>::value_type;
 
-    using LoserTreeType = typename core::LoserTreeTraits<
-              /* stable */ false, ValueType, Comparator>::Type;
+    using LoserTreeType = LoserTree;
 
     MultiwayMergeTree(ReaderIterator readers_begin, ReaderIterator readers_end,
                       const Comparator& comp)
@@ -114,6 +122,412 @@ auto make_multiway_merge_tree(
         Comparator>(seqs_begin, seqs_end, comp);
 }
 
+/*!
+ * Sequential stable multi-way merging of readers: equal items are delivered in
+ * the order of the readers in [seqs_begin,seqs_end).
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param comp Comparator.
+ */
+template <typename ValueType, typename ReaderIterator, typename Comparator>
+auto make_stable_multiway_merge_tree(
+    ReaderIterator seqs_begin, ReaderIterator seqs_end,
+    const Comparator &comp) {
+
+    assert(seqs_end - seqs_begin >= 1);
+    return MultiwayMergeTree<
+        ValueType, ReaderIterator,
+        Comparator, /* Stable */ true>(seqs_begin, seqs_end, comp);
+}
+
+/*!
+ * Multi-way merge of readers of sorted std::strings with an LCP-aware loser
+ * tree. Each loser in the tree stores the length of its longest common prefix
+ * (LCP) with the string it lost to, and a new string of an input its LCP with
+ * the previous output. Since all strings are larger than the previous output,
+ * a match is decided by comparing LCPs, and characters are only compared from
+ * the common LCP onwards. Hence, long common prefixes are scanned about once
+ * instead of in every comparison of the tree.
+ *
+ * The order is std::less<std::string>, and equal strings are delivered in the
+ * order of the readers, hence the merge is stable.
+ */
+template <typename ReaderIterator>
+class LcpStringMultiwayMergeTree
+{
+public:
+    using Reader = typename std::iterator_traits<ReaderIterator>::value_type;
+
+    LcpStringMultiwayMergeTree(
+        ReaderIterator readers_begin, ReaderIterator readers_end,
+        const std::less<std::string>& /* comp */ = std::less<std::string>())
+        : readers_(readers_begin),
+          num_inputs_(static_cast<size_t>(readers_end - readers_begin)) {
+
+        tree_size_ = 1;
+        while (tree_size_ < num_inputs_) tree_size_ *= 2;
+
+        current_.resize(tree_size_);
+        exists_.resize(tree_size_, false);
+        nodes_.resize(tree_size_);
+
+        for (size_t t = 0; t < num_inputs_; ++t) {
+            if (readers_[t].HasNext()) {
+                current_[t] = readers_[t].template Next<std::string>();
+                exists_[t] = true;
+                ++remaining_inputs_;
+            }
+        }
+
+        // all strings have the LCP 0 with a virtual empty previous output.
+        nodes_[0] = Build(1);
+    }
+
+    bool HasNext() const {
+        return (remaining_inputs_ != 0);
+    }
+
+    std::string Next() {
+        // take next smallest element out
+        size_t top = nodes_[0].index;
+        std::string res = std::move(current_[top]);
+
+        Node contender { top, 0 };
+        if (readers_[top].HasNext()) {
+            current_[top] = readers_[top].template Next<std::string>();
+            contender.lcp = CommonPrefix(current_[top], res, 0);
+        }
+        else {
+            exists_[top] = false;
+            assert(remaining_inputs_ > 0);
+            --remaining_inputs_;
+        }
+
+        // replay the matches on the path from the leaf to the root
+        for (size_t n = (top + tree_size_) / 2; n > 0; n /= 2)
+            Play(contender, nodes_[n]);
+        nodes_[0] = contender;
+
+        return res;
+    }
+
+private:
+    //! input index and LCP with the string it lost to, or the previous output
+    struct Node {
+        size_t index;
+        size_t lcp;
+    };
+
+    ReaderIterator readers_;
+    size_t num_inputs_;
+    size_t remaining_inputs_ = 0;
+
+    //! number of leaves, the next power of two of num_inputs_
+    size_t tree_size_;
+
+    //! current string of each input
+    std::vector<std::string> current_;
+    //! whether the input has a current string
+    std::vector<bool> exists_;
+    //! losers of the matches in the inner nodes [1,tree_size_), the overall
+    //! winner in nodes_[0]
+    std::vector<Node> nodes_;
+
+    //! extend a common prefix of two strings of known length lcp
+    static size_t CommonPrefix(
+        const std::string& a, const std::string& b, size_t lcp) {
+        size_t n = std::min(a.size(), b.size());
+        while (lcp < n && a[lcp] == b[lcp]) ++lcp;
+        return lcp;
+    }
+
+    //! Play the match of contender and the defender, whose LCPs are relative to
+    //! the same smaller string. The winner is returned in contender, the loser
+    //! stays with its LCP relative to the winner.
+    void Play(Node& contender, Node& defender) {
+        if (!exists_[defender.index]) return;
+        if (!exists_[contender.index]) {
+            std::swap(contender, defender);
+            return;
+        }
+
+        // the string sharing a longer prefix with the smaller one is smaller,
+        // and LCP of the two is the shorter one.
+        if (contender.lcp > defender.lcp) return;
+        if (contender.lcp < defender.lcp) {
+            std::swap(contender, defender);
+            return;
+        }
+
+        const std::string& a = current_[contender.index];
+        const std::string& b = current_[defender.index];
+        size_t lcp = CommonPrefix(a, b, contender.lcp);
+
+        bool defender_wins;
+        if (lcp < a.size() && lcp < b.size()) {
+            defender_wins = static_cast<unsigned char>(b[lcp])
+                            < static_cast<unsigned char>(a[lcp]);
+        }
+        else if (a.size() != b.size()) {
+            defender_wins = (b.size() < a.size());
+        }
+        else {
+            // equal strings: lower input first
+            defender_wins = (defender.index < contender.index);
+        }
+
+        if (defender_wins)
+            std::swap(contender, defender);
+        defender.lcp = lcp;
+    }
+
+    //! play the initial matches of the subtree of node n, returns the winner.
+    Node Build(size_t n) {
+        if (n >= tree_size_)
+            return Node { n - tree_size_, 0 };
+
+        Node contender = Build(2 * n);
+        nodes_[n] = Build(2 * n + 1);
+        Play(contender, nodes_[n]);
+        return contender;
+    }
+};
+
+/*!
+ * Multi-way merge tree for SortNode: the LCP-aware string merge for the
+ * default order of std::string, otherwise a MultiwayMergeTree.
+ */
+template <typename ValueType, typename ReaderIterator, typename Comparator,
+          bool Stable = false>
+using SortMultiwayMergeTree = typename std::conditional<
+          std::is_same<ValueType, std::string>::value &&
+          std::is_same<Comparator, std::less<std::string> >::value,
+          LcpStringMultiwayMergeTree<ReaderIterator>,
+          MultiwayMergeTree<ValueType, ReaderIterator, Comparator, Stable>
+          >::type;
+
+/*!
+ * Reader over the item range [begin,end) of a File, which is used to merge
+ * disjoint parts of sorted Files in parallel.
+ */
+template <typename ValueType>
+class FileRangeReader
+{
+public:
+    FileRangeReader(const data::File& file, size_t begin, size_t end,
+                    size_t prefetch)
+        : reader_(begin < end
+                  ? file.GetReaderAt<ValueType>(begin, prefetch)
+                  : file.GetKeepReader(0)),
+          left_(end - begin) {
+        assert(begin <= end);
+    }
+
+    bool HasNext() const { return left_ != 0; }
+
+    template <typename T>
+    T Next() {
+        assert(left_ != 0);
+        --left_;
+        return reader_.template Next<T>();
+    }
+
+private:
+    data::File::KeepReader reader_;
+    //! number of items left in range
+    size_t left_;
+};
+
+/*!
+ * Multisequence selection on sorted Files: calculate the bounds of num_parts
+ * disjoint parts of [files_begin,files_end), such that merging part p of all
+ * Files yields the p-th consecutive range of the merged output. The result
+ * splits[p][t] is the first index of part p in File t, splits[0][t] = 0 and
+ * splits[num_parts][t] = num_items of File t.
+ *
+ * Items are totally ordered by (value, File index, item index), hence parts
+ * also keep the order required for stable merging. The splitters are picked
+ * from a regular sample of each File, weighted by the File size, and then
+ * located in the other Files with a binary search, which makes the parts
+ * balanced up to the sampling accuracy, even with many equal items.
+ */
+template <typename ValueType, typename FileIterator, typename Comparator>
+std::vector<std::vector<size_t> > multisequence_split_files(
+    FileIterator files_begin, FileIterator files_end, size_t num_parts,
+    const Comparator& comp) {
+
+    // number of samples per File and part
+    static constexpr size_t oversampling = 16;
+
+    const size_t num_files = static_cast<size_t>(files_end - files_begin);
+
+    std::vector<std::vector<size_t> > splits(
+        num_parts + 1, std::vector<size_t>(num_files));
+
+    size_t total = 0;
+    for (size_t t = 0; t < num_files; ++t) {
+        splits[num_parts][t] = files_begin[t].num_items();
+        total += files_begin[t].num_items();
+    }
+
+    if (num_parts <= 1 || total == 0) return splits;
+
+    struct Sample {
+        ValueType value;
+        size_t    file, index;
+        //! number of items this sample represents
+        double    weight;
+    };
+
+    std::vector<Sample> samples;
+
+    for (size_t t = 0; t < num_files; ++t) {
+        const data::File& file = files_begin[t];
+        size_t n = file.num_items();
+        size_t s = std::min(n, oversampling * num_parts);
+        std::vector<size_t> indices(s);
+        for (size_t i = 0; i < s; ++i)
+            indices[i] = (2 * i + 1) * n / (2 * s);
+        std::vector<ValueType> values =
+            file.GetItemsAt<ValueType>(indices);
+        for (size_t i = 0; i < s; ++i) {
+            samples.push_back(
+                Sample { std::move(values[i]), t, indices[i],
+                         static_cast<double>(n) / static_cast<double>(s) });
+        }
+    }
+
+    std::sort(samples.begin(), samples.end(),
+              [&comp](const Sample& a, const Sample& b) {
+                  if (comp(a.value, b.value)) return true;
+                  if (comp(b.value, a.value)) return false;
+                  return a.file < b.file ||
+                  (a.file == b.file && a.index < b.index);
+              });
+
+    // binary search for the first item in file not less than value, or, if
+    // upper, the first item greater than value.
+    auto bound =
+        [&comp](const data::File& file, const ValueType& value, bool upper) {
+            size_t left = 0, right = file.num_items();
+            while (left < right) {
+                size_t mid = (left + right) / 2;
+                ValueType cur = file.GetItemAt<ValueType>(mid);
+                if (upper ? comp(value, cur) : !comp(cur, value))
+                    right = mid;
+                else
+                    left = mid + 1;
+            }
+            return left;
+        };
+
+    // walk over samples and pick splitter where the weight passes p/num_parts
+    double weight = 0;
+    auto it = samples.cbegin();
+
+    for (size_t p = 1; p < num_parts; ++p) {
+        double target =
+            static_cast<double>(p * total) / static_cast<double>(num_parts);
+
+        while (it + 1 != samples.end() && weight + it->weight < target)
+            weight += (it++)->weight;
+
+        const Sample& splitter = *it;
+        for (size_t t = 0; t < num_files; ++t) {
+            if (t == splitter.file) {
+                splits[p][t] = splitter.index;
+            }
+            else {
+                // equal items of Files before the splitter's go to the left,
+                // those of Files after it to the right.
+                splits[p][t] = bound(
+                    files_begin[t], splitter.value, t < splitter.file);
+            }
+            // keep parts non-overlapping if the splitter was picked twice
+            splits[p][t] = std::max(splits[p][t], splits[p - 1][t]);
+        }
+    }
+
+    return splits;
+}
+
+/*!
+ * Parallel multi-way merging of the sorted Files [files_begin,files_end) into
+ * the File output using num_threads threads. The Files are split into
+ * num_threads disjoint parts by multisequence_split_files(), which are merged
+ * independently into separate Files, whose Blocks are then appended in order
+ * to the output File.
+ *
+ * The input Files are only read, hence they may not be delta encoded, and
+ * each thread holds at most (prefetch + 1) Blocks per input File.
+ *
+ * \tparam Stable deliver equal items in the order of the input Files
+ */
+template <typename ValueType, bool Stable = false,
+          typename FileIterator, typename Comparator>
+void parallel_multiway_merge_files(
+    FileIterator files_begin, FileIterator files_end, data::File& output,
+    const Comparator& comp, size_t num_threads, size_t prefetch) {
+
+    // minimum number of items per thread to make parallel merging worthwhile.
+    static constexpr size_t min_part_size = 16384;
+
+    using Reader = FileRangeReader<ValueType>;
+    using ReaderIterator = typename std::vector<Reader>::iterator;
+    using MergeTree = MultiwayMergeTree<
+              ValueType, ReaderIterator, Comparator, Stable>;
+
+    const size_t num_files = static_cast<size_t>(files_end - files_begin);
+
+    size_t total = 0;
+    for (FileIterator f = files_begin; f != files_end; ++f)
+        total += f->num_items();
+
+    num_threads = std::max<size_t>(
+        1, std::min(num_threads, total / min_part_size));
+
+    std::vector<std::vector<size_t> > splits =
+        multisequence_split_files<ValueType>(
+            files_begin, files_end, num_threads, comp);
+
+    std::vector<data::File> parts;
+    parts.reserve(num_threads);
+    for (size_t p = 0; p < num_threads; ++p) {
+        parts.emplace_back(*output.block_pool(), output.local_worker_id(),
+                           output.dia_id());
+    }
+
+    auto merge_part =
+        [&](size_t p) {
+            std::vector<Reader> seq;
+            seq.reserve(num_files);
+            for (size_t t = 0; t < num_files; ++t) {
+                seq.emplace_back(files_begin[t], splits[p][t],
+                                 splits[p + 1][t], prefetch);
+            }
+
+            MergeTree puller(seq.begin(), seq.end(), comp);
+
+            auto writer = parts[p].GetWriter();
+            while (puller.HasNext())
+                writer.Put(puller.Next());
+        };
+
+    if (num_threads == 1) {
+        merge_part(0);
+    }
+    else {
+        common::WorkStealingPool pool(num_threads - 1);
+        pool.ParallelFor(0, num_threads, 1, merge_part);
+    }
+
+    for (const data::File& part : parts) {
+        for (const data::Block& b : part.blocks())
+            output.AppendBlock(b);
+    }
+}
+
 } // namespace core
 } // namespace thrill
 
@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * thrill/core/parallel_sort.hpp
+ *
+ * Simple shared-memory parallel mergesort for run formation using a
+ * WorkStealingPool of a few threads.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_PARALLEL_SORT_HEADER
+#define THRILL_CORE_PARALLEL_SORT_HEADER
+
+#include <thrill/common/work_stealing_pool.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+//! default total size of the temporary merge buffers of parallel_sort()
+static constexpr size_t default_merge_buffer_bytes = 16 * 1024 * 1024;
+
+//! merge the sorted ranges [begin,mid) and [mid,end) sequentially by moving
+//! the smaller one into a temporary buffer. Equal items of the left range are
+//! placed first.
+template <typename Iterator, typename Comparator>
+void MergeBuffered(Iterator begin, Iterator mid, Iterator end,
+                   const Comparator& cmp) {
+    using ValueType = typename std::iterator_traits<Iterator>::value_type;
+
+    std::vector<ValueType> buffer;
+    if (mid - begin <= end - mid) {
+        // move left range into buffer and merge forward
+        buffer.reserve(static_cast<size_t>(mid - begin));
+        std::move(begin, mid, std::back_inserter(buffer));
+
+        auto a = buffer.begin();
+        Iterator b = mid, out = begin;
+        while (a != buffer.end() && b != end) {
+            if (cmp(*b, *a))
+                *out++ = std::move(*b++);
+            else
+                *out++ = std::move(*a++);
+        }
+        std::move(a, buffer.end(), out);
+    }
+    else {
+        // move right range into buffer and merge backward
+        buffer.reserve(static_cast<size_t>(end - mid));
+        std::move(mid, end, std::back_inserter(buffer));
+
+        auto b = buffer.end();
+        Iterator a = mid, out = end;
+        while (a != begin && b != buffer.begin()) {
+            if (cmp(*(b - 1), *(a - 1)))
+                *--out = std::move(*--a);
+            else
+                *--out = std::move(*--b);
+        }
+        std::move_backward(buffer.begin(), b, out);
+    }
+}
+
+/*!
+ * Merge the sorted ranges [begin,mid) and [mid,end) in place. If the smaller
+ * range has more than buffer_items items, the merge is split into two
+ * independent merges: the middle item of the larger range is located in the
+ * smaller one by binary search, and the two middle parts are swapped by a
+ * rotation. The halves of merges larger than 2 * min_part_size are forked onto
+ * the pool, hence also the last rounds of the mergesort run in parallel.
+ */
+template <typename Iterator, typename Comparator>
+void ParallelMerge(common::WorkStealingPool& pool,
+                   Iterator begin, Iterator mid, Iterator end,
+                   const Comparator& cmp,
+                   size_t min_part_size, size_t buffer_items) {
+    size_t size1 = static_cast<size_t>(mid - begin);
+    size_t size2 = static_cast<size_t>(end - mid);
+    if (size1 == 0 || size2 == 0) return;
+
+    if (size1 + size2 == 2) {
+        if (cmp(*mid, *begin)) std::iter_swap(begin, mid);
+        return;
+    }
+
+    bool parallel = size1 + size2 > 2 * min_part_size;
+    if (std::min(size1, size2) <= buffer_items && !parallel) {
+        MergeBuffered(begin, mid, end, cmp);
+        return;
+    }
+
+    Iterator cut1, cut2;
+    if (size1 >= size2) {
+        cut1 = begin + size1 / 2;
+        cut2 = std::lower_bound(mid, end, *cut1, cmp);
+    }
+    else {
+        cut2 = mid + size2 / 2;
+        cut1 = std::upper_bound(begin, mid, *cut2, cmp);
+    }
+    Iterator new_mid = std::rotate(cut1, mid, cut2);
+
+    if (parallel) {
+        pool.ParallelInvoke(
+            [&]() {
+                ParallelMerge(pool, begin, cut1, new_mid, cmp,
+                              min_part_size, buffer_items);
+            },
+            [&]() {
+                ParallelMerge(pool, new_mid, cut2, end, cmp,
+                              min_part_size, buffer_items);
+            });
+    }
+    else {
+        ParallelMerge(pool, begin, cut1, new_mid, cmp,
+                      min_part_size, buffer_items);
+        ParallelMerge(pool, new_mid, cut2, end, cmp,
+                      min_part_size, buffer_items);
+    }
+}
+
+//! recursive fork-join mergesort of [begin,end) on the pool: both halves are
+//! sorted in parallel and then merged by ParallelMerge().
+template <typename Iterator, typename Comparator>
+void ParallelSortRecursive(common::WorkStealingPool& pool,
+                           Iterator begin, Iterator end, const Comparator& cmp,
+                           size_t min_part_size, size_t buffer_items) {
+    size_t size = static_cast<size_t>(end - begin);
+    if (size <= 2 * min_part_size) {
+        std::sort(begin, end, cmp);
+        return;
+    }
+    Iterator mid = begin + size / 2;
+    pool.ParallelInvoke(
+        [&]() {
+            ParallelSortRecursive(pool, begin, mid, cmp,
+                                  min_part_size, buffer_items);
+        },
+        [&]() {
+            ParallelSortRecursive(pool, mid, end, cmp,
+                                  min_part_size, buffer_items);
+        });
+    ParallelMerge(pool, begin, mid, end, cmp, min_part_size, buffer_items);
+}
+
+/*!
+ * Sort the range [begin,end) using num_threads threads. The range is halved
+ * recursively into parts of about size / num_threads items, whose sorting and
+ * merging are forked onto a WorkStealingPool, hence threads which finish their
+ * part early steal the remaining sorts and merges. The calling thread is one
+ * of the num_threads. Falls back to std::sort for small inputs or a single
+ * thread.
+ *
+ * Merges move at most buffer_bytes / num_threads bytes of items into temporary
+ * buffers per thread, larger merges are split by rotations instead.
+ */
+template <typename Iterator, typename Comparator>
+void parallel_sort(Iterator begin, Iterator end, const Comparator& cmp,
+                   size_t num_threads,
+                   size_t buffer_bytes = default_merge_buffer_bytes) {
+    using ValueType = typename std::iterator_traits<Iterator>::value_type;
+
+    size_t size = static_cast<size_t>(end - begin);
+
+    // minimum number of items per thread to make parallel sorting worthwhile.
+    static constexpr size_t min_part_size = 4096;
+
+    num_threads = std::min(num_threads, size / min_part_size);
+    if (num_threads <= 1) {
+        std::sort(begin, end, cmp);
+        return;
+    }
+
+    size_t part_size = std::max(min_part_size, size / num_threads / 2);
+    size_t buffer_items = buffer_bytes / num_threads / sizeof(ValueType);
+
+    common::WorkStealingPool pool(num_threads - 1);
+    ParallelSortRecursive(pool, begin, end, cmp, part_size, buffer_items);
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_PARALLEL_SORT_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * thrill/core/radix_sort.hpp
+ *
+ * In-place most-significant-digit radix sort (American flag sort) for items
+ * with unsigned integer or fixed-width byte array keys.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_RADIX_SORT_HEADER
+#define THRILL_CORE_RADIX_SORT_HEADER
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Traits class defining the byte decomposition of radix sort keys. The byte
+ * with index 0 is the most significant. Specializations exist for unsigned
+ * integral types and for std::array of unsigned chars, which are compared
+ * lexicographically. The primary template marks all other types as not radix
+ * sortable.
+ */
+template <typename Key, typename Enable = void>
+class RadixKeyTraits
+{
+public:
+    //! whether Key can be radix sorted
+    static constexpr bool enabled = false;
+};
+
+//! RadixKeyTraits for unsigned integral types
+template <typename Key>
+class RadixKeyTraits<
+        Key, typename std::enable_if<std::is_integral<Key>::value &&
+                                     std::is_unsigned<Key>::value>::type>
+{
+public:
+    //! whether Key can be radix sorted
+    static constexpr bool enabled = true;
+
+    //! number of bytes in key
+    static constexpr size_t num_bytes = sizeof(Key);
+
+    //! return byte at depth d (0 = most significant)
+    static size_t byte(const Key& k, size_t d) {
+        return static_cast<size_t>((k >> (8 * (num_bytes - 1 - d))) & 0xFF);
+    }
+};
+
+//! RadixKeyTraits for fixed-width byte arrays
+template <size_t N>
+class RadixKeyTraits<std::array<uint8_t, N> >
+{
+public:
+    //! whether Key can be radix sorted
+    static constexpr bool enabled = true;
+
+    //! number of bytes in key
+    static constexpr size_t num_bytes = N;
+
+    //! return byte at depth d (0 = most significant)
+    static size_t byte(const std::array<uint8_t, N>& k, size_t d) {
+        return k[d];
+    }
+};
+
+/*!
+ * Sort [begin,end) in-place by the unsigned integer or byte array key returned
+ * by key_extractor, starting at key byte depth. Buckets smaller than a
+ * threshold are sorted by std::sort on the extracted keys.
+ */
+template <typename Iterator, typename KeyExtractor>
+void radix_sort_msd(Iterator begin, Iterator end,
+                    const KeyExtractor& key_extractor, size_t depth = 0) {
+
+    using ValueType = typename std::iterator_traits<Iterator>::value_type;
+    using Key = typename std::decay<
+              decltype(key_extractor(std::declval<ValueType>()))>::type;
+    using Traits = RadixKeyTraits<Key>;
+    static_assert(Traits::enabled,
+                  "Key must be an unsigned integer or std::array<uint8_t>");
+
+    static constexpr size_t small_sort_threshold = 64;
+
+    size_t size = static_cast<size_t>(end - begin);
+
+    if (depth >= Traits::num_bytes || size <= 1) return;
+
+    if (size < small_sort_threshold) {
+        std::sort(begin, end,
+                  [&key_extractor](const ValueType& a, const ValueType& b) {
+                      return key_extractor(a) < key_extractor(b);
+                  });
+        return;
+    }
+
+    // count occurrences of each byte value
+    size_t bkt_size[256] = { 0 };
+    for (Iterator it = begin; it != end; ++it)
+        ++bkt_size[Traits::byte(key_extractor(*it), depth)];
+
+    // skip this level if all items share the same byte
+    for (size_t b = 0; b < 256; ++b) {
+        if (bkt_size[b] == size)
+            return radix_sort_msd(begin, end, key_extractor, depth + 1);
+        if (bkt_size[b] != 0) break;
+    }
+
+    // calculate bucket boundaries: bkt_index[b] is the next free slot
+    size_t bkt_begin[256], bkt_index[256];
+    bkt_begin[0] = bkt_index[0] = 0;
+    for (size_t b = 1; b < 256; ++b)
+        bkt_begin[b] = bkt_index[b] = bkt_begin[b - 1] + bkt_size[b - 1];
+
+    // permute items in-place into their buckets by following cycles
+    for (size_t b = 0; b < 256; ++b) {
+        size_t bkt_end = bkt_begin[b] + bkt_size[b];
+        while (bkt_index[b] < bkt_end) {
+            size_t c = Traits::byte(key_extractor(begin[bkt_index[b]]), depth);
+            while (c != b) {
+                using std::swap;
+                swap(begin[bkt_index[b]], begin[bkt_index[c]++]);
+                c = Traits::byte(key_extractor(begin[bkt_index[b]]), depth);
+            }
+            ++bkt_index[b];
+        }
+    }
+
+    // recurse into buckets
+    for (size_t b = 0; b < 256; ++b) {
+        if (bkt_size[b] <= 1) continue;
+        radix_sort_msd(begin + bkt_begin[b], begin + bkt_begin[b] + bkt_size[b],
+                       key_extractor, depth + 1);
+    }
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_RADIX_SORT_HEADER
+
+/******************************************************************************/
@@ -13,12 +13,18 @@
 #ifndef THRILL_CORE_REDUCE_BUCKET_HASH_TABLE_HEADER
 #define THRILL_CORE_REDUCE_BUCKET_HASH_TABLE_HEADER
 
+#include <thrill/common/config.hpp>
+#include <thrill/common/defines.hpp>
 #include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_key_arena.hpp>
 #include <thrill/core/reduce_table.hpp>
+#include <thrill/mem/aligned_allocator.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <stack>
 #include <utility>
 #include <vector>
@@ -78,7 +84,28 @@ namespace core {
  *    |   |       |   |
  *    +---+       +---+
  *
+ * If ReduceConfig::store_hash_ is set and the IndexFunction has a key hash,
+ * each bucket block also stores the hashes of its keys. Keys are then only
+ * compared if their hashes match, and spilled items are written to the
+ * partition files preceded by their hash, such that they can be inserted again
+ * with Insert(kv, key_hash) without rehashing the key.
  */
+//! Key hashes of the items in a BucketBlock of ReduceBucketHashTable.
+template <size_t Size>
+struct ReduceBucketHashes {
+    uint64_t hashes[Size]; // NOLINT
+
+    uint64_t hash(size_t i) const { return hashes[i]; }
+    void set_hash(size_t i, uint64_t h) { hashes[i] = h; }
+};
+
+//! Empty base if ReduceBucketHashTable does not store hashes.
+template <>
+struct ReduceBucketHashes<0>{
+    uint64_t hash(size_t) const { return 0; }
+    void set_hash(size_t, uint64_t) { }
+};
+
 template <typename ValueType, typename Key, typename Value,
           typename KeyExtractor, typename ReduceFunction, typename Emitter,
           const bool VolatileKey,
@@ -105,13 +132,30 @@ class ReduceBucketHashTable
 public:
     using KeyValuePair = std::pair<Key, Value>;
 
-    //! calculate number of items such that each BucketBlock has about 1 MiB of
-    //! size, or at least 8 items.
-    static constexpr size_t block_size_ =
-        common::max<size_t>(1, bucket_block_size / sizeof(KeyValuePair));
+    //! whether the key hashes are stored and written to spilled files
+    static constexpr bool store_hash_ =
+        ReduceConfig::store_hash_ && IndexFunction::has_key_hash;
+
+    //! size of the BucketBlock header: the size counter and next pointer.
+    static constexpr size_t block_header_size_ =
+        sizeof(size_t) + sizeof(void*);
+
+    static_assert(bucket_block_size > block_header_size_,
+                  "bucket_block_size must be larger than the block header");
 
-    //! Block holding reduce key/value pairs.
-    struct BucketBlock {
+    //! calculate number of items such that each BucketBlock including its
+    //! header and hashes fits into bucket_block_size bytes, or holds at least
+    //! one item.
+    static constexpr size_t block_size_ =
+        common::max<size_t>(
+            1, (bucket_block_size - block_header_size_)
+            / (sizeof(KeyValuePair) + (store_hash_ ? sizeof(uint64_t) : 0)));
+
+    //! Block holding reduce key/value pairs. Blocks are aligned to cache lines
+    //! and their size is rounded up to whole cache lines, such that walking a
+    //! chain touches only whole lines.
+    struct alignas(common::g_cache_line_size) BucketBlock
+        : public ReduceBucketHashes<store_hash_ ? block_size_ : 0>{
         //! number of _used_/constructed items in this block. next is unused if
         //! size != block_size.
         size_t       size;
@@ -130,6 +174,9 @@ public:
         }
     };
 
+    static_assert(sizeof(BucketBlock) % common::g_cache_line_size == 0,
+                  "BucketBlock must span whole cache lines");
+
     using BucketBlockIterator = typename std::vector<BucketBlock*>::iterator;
 
 public:
@@ -245,7 +292,13 @@ public:
      * inserts the pair into the hashtable.
      */
     void Insert(const Value& p) {
-        Insert(std::make_pair(key_extractor_(p), p));
+        Insert(KeyValuePair(key_extractor_(p), p));
+    }
+
+    //! Inserts a value, which is moved into the key-value-pair.
+    void Insert(Value&& p) {
+        Key key = key_extractor_(p);
+        Insert(KeyValuePair(std::move(key), std::move(p)));
     }
 
     /*!
@@ -263,13 +316,52 @@ public:
      * \param kv Value to be inserted into the table.
      */
     void Insert(const KeyValuePair& kv) {
+        Insert(kv, store_hash_ ? index_function_.key_hash(kv.first) : 0);
+    }
+
+    //! Inserts a key-value-pair, which is moved into a new slot, and whose
+    //! value is passed as an rvalue to the reduce function.
+    void Insert(KeyValuePair&& kv) {
+        uint64_t key_hash =
+            store_hash_ ? index_function_.key_hash(kv.first) : 0;
+        Insert(std::move(kv), key_hash);
+    }
+
+    /*!
+     * Inserts a value into the table whose key_hash() was stored earlier. The
+     * hash is ignored unless store_hash_ is set.
+     *
+     * \param kv Value to be inserted into the table.
+     * \param key_hash hash of the key from IndexFunction::key_hash()
+     */
+    void Insert(const KeyValuePair& kv, uint64_t key_hash) {
+        InsertPair(kv, key_hash);
+    }
+
+    //! Inserts a key-value-pair with a stored key_hash(), which is moved.
+    void Insert(KeyValuePair&& kv, uint64_t key_hash) {
+        InsertPair(ReduceMoveItem(kv), key_hash);
+    }
+
+    /*!
+     * Insert implementation for lvalue and rvalue pairs. New pairs are copied
+     * or moved into their bucket block, and on a match the slot's value is
+     * moved into the reduce function, whose result is move-assigned back.
+     */
+    template <typename KV>
+    void InsertPair(KV&& kv, uint64_t key_hash) {
 
         while (mem::memory_exceeded && num_items_ != 0)
             SpillAnyPartition();
 
-        typename IndexFunction::Result h = index_function_(
-            kv.first, num_partitions_,
-            num_buckets_per_partition_, num_buckets_);
+        typename IndexFunction::Result h =
+            store_hash_
+            ? index_function_.from_key_hash(
+                key_hash, num_partitions_,
+                num_buckets_per_partition_, num_buckets_)
+            : index_function_(
+                kv.first, num_partitions_,
+                num_buckets_per_partition_, num_buckets_);
 
         // sLOG << "kv" << kv.first << "-" << kv.second
         //      << "to partition" << h.partition_id << "bucket" << h.global_index;
@@ -285,18 +377,24 @@ public:
 
         while (current != nullptr)
         {
+            // fetch the next block while scanning this one
+            THRILL_PREFETCH(current->next);
+
             // iterate over valid items in a block
             for (KeyValuePair* bi = current->items;
                  bi != current->items + current->size; ++bi)
             {
                 // if item and key equals, then reduce.
-                if (equal_to_function_(kv.first, bi->first))
+                if ((!store_hash_ ||
+                     current->hash(bi - current->items) == key_hash) &&
+                    equal_to_function_(kv.first, bi->first))
                 {
                     LOGC(debug_items)
                         << "match of key: " << kv.first
                         << " and " << bi->first << " ... reducing...";
 
-                    bi->second = reduce_function_(bi->second, kv.second);
+                    bi->second = reduce_function_(
+                        std::move(bi->second), std::forward<KV>(kv).second);
                     return;
                 }
             }
@@ -330,7 +428,9 @@ public:
         }
 
         // in-place construct/insert new item in current bucket block
-        new (current->items + current->size++)KeyValuePair(kv);
+        current->set_hash(current->size, key_hash);
+        new (current->items + current->size++)KeyValuePair(
+            std::forward<KV>(kv));
 
         LOGC(debug_items)
             << "h.partition_id" << h.partition_id;
@@ -359,12 +459,12 @@ public:
                 // destroy block and advance to next
                 BucketBlock* next = current->next;
                 current->destroy_items();
-                operator delete (current);
+                block_pool_.Deallocate(current);
                 current = next;
             }
         }
 
-        // destroy vector and block pool
+        // destroy vector and block pool, which frees the blocks
         std::vector<BucketBlock*>().swap(buckets_);
         block_pool_.Destroy();
 
@@ -407,9 +507,13 @@ public:
 
             while (current != nullptr)
             {
+                THRILL_PREFETCH(current->next);
+
                 for (KeyValuePair* bi = current->items;
                      bi != current->items + current->size; ++bi)
                 {
+                    if (store_hash_)
+                        writer.Put(current->hash(bi - current->items));
                     writer.Put(*bi);
                 }
 
@@ -497,8 +601,14 @@ public:
         {
             BucketBlock* current = *iter;
 
+            // fetch the first block of the next bucket
+            if (iter + 1 != end)
+                THRILL_PREFETCH(*(iter + 1));
+
             while (current != nullptr)
             {
+                THRILL_PREFETCH(current->next);
+
                 for (KeyValuePair* bi = current->items;
                      bi != current->items + current->size; ++bi)
                 {
@@ -590,7 +700,7 @@ protected:
                 free.pop();
             }
             else {
-                place = static_cast<BucketBlock*>(operator new (sizeof(BucketBlock)));
+                place = alloc_.allocate(1);
                 place->size = 0;
                 place->next = nullptr;
             }
@@ -608,7 +718,7 @@ protected:
         void Destroy() {
             while (!free.empty()) {
                 free.top()->destroy_items();
-                operator delete (free.top());
+                alloc_.deallocate(free.top(), 1);
                 free.pop();
             }
         }
@@ -616,6 +726,10 @@ protected:
     private:
         // stack to hold pointers to free chunks:
         std::stack<BucketBlock*> free;
+
+        // allocator of cache line aligned blocks
+        mem::AlignedAllocator<
+            BucketBlock, std::allocator<char>, common::g_cache_line_size> alloc_;
     };
 
 private:
@@ -22,13 +22,18 @@
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_robin_hood_hash_table.hpp>
+#include <thrill/core/reduce_sort_table.hpp>
+#include <thrill/core/reduce_steal_pool.hpp>
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <functional>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -87,6 +92,8 @@ public:
               KeyExtractor, ReduceFunction, StageEmitter,
               !SendPair, ReduceConfig, IndexFunction, EqualToFunction>::type;
 
+    using StealPool = ReduceStealPool<data::File>;
+
     /*!
      * A data structure which takes an arbitrary value and extracts a key using
      * a key extractor function from that value. Afterwards, the value is hashed
@@ -117,23 +124,124 @@ public:
         table_.Initialize(limit_memory_bytes);
     }
 
+    /*!
+     * Initialize the table with an estimate of the number of distinct keys
+     * which will be inserted, e.g. from HyperLogLog sketches of the senders.
+     * If they fit into the table, the items are reduced in memory. Otherwise
+     * the fan-out is calculated like in ReduceFiles(), and the items of all but
+     * part zero are written to part Files directly, which are re-reduced at
+     * the next level, instead of first filling the table and spilling it.
+     */
+    void Initialize(size_t limit_memory_bytes, size_t expected_keys) {
+        table_.Initialize(limit_memory_bytes);
+
+        // sorted runs are merged instead of re-reduced.
+        if (Table::sorted_runs_) return;
+
+        size_t capacity = std::max<size_t>(
+            table_.limit_items_per_partition() * table_.num_partitions()
+            / 8 * 7, 1);
+        if (expected_keys <= capacity) return;
+
+        size_t part_items = std::max<size_t>(capacity / 4 * 3, 1);
+        fan_out_ = (expected_keys + part_items - 1) / part_items;
+
+        // split with the salt of level zero of ReduceFiles(), which differs
+        // from the table's, such that part zero fills all partitions.
+        split_function_ = IndexFunction(~uint64_t(0), table_.index_function());
+
+        sLOG << "ReducePostStage: expecting" << expected_keys << "keys"
+             << "capacity" << capacity << "fan_out" << fan_out_;
+
+        for (size_t p = 1; p < fan_out_; ++p)
+            parts_.emplace_back(table_.ctx().GetFile(table_.dia_id()));
+        for (data::File& part : parts_)
+            part_writers_.emplace_back(part.GetWriter());
+    }
+
     void Insert(const Value& p) {
+        if (fan_out_ > 1)
+            return InsertSplit(KeyValuePair(table_.key_extractor()(p), p));
         return table_.Insert(p);
     }
 
     void Insert(const KeyValuePair& kv) {
+        if (fan_out_ > 1)
+            return InsertSplit(kv);
         return table_.Insert(kv);
     }
 
+    void Insert(Value&& p) {
+        if (fan_out_ > 1) {
+            Key key = table_.key_extractor()(p);
+            return InsertSplit(KeyValuePair(std::move(key), std::move(p)));
+        }
+        return table_.Insert(std::move(p));
+    }
+
+    void Insert(KeyValuePair&& kv) {
+        if (fan_out_ > 1)
+            return InsertSplit(std::move(kv));
+        return table_.Insert(std::move(kv));
+    }
+
     //! Flushes all items in the whole table.
     template <bool DoCache>
     void Flush(bool consume, data::File::Writer* writer = nullptr) {
+        Flush<DoCache>(consume, writer,
+                       std::integral_constant<bool, Table::sorted_runs_>());
+    }
+
+    //! Flushes all items of a table with sorted runs: spilled partitions are
+    //! merged once instead of being re-reduced with hashing.
+    template <bool DoCache>
+    void Flush(bool consume, data::File::Writer* writer,
+               std::true_type /* sorted_runs */) {
+        LOG << "Flushing items by merging sorted runs";
+
+        assert((consume || !table_.has_spilled_data()) &&
+               "Items were spilled hence Flushing must consume");
+
+        auto emit = [this, writer](
+            const size_t& partition_id, const KeyValuePair& p) {
+                        if (DoCache) writer->Put(p);
+                        emitter_.Emit(partition_id, p);
+                    };
+
+        for (size_t id = 0; id < table_.num_partitions(); ++id)
+        {
+            if (consume)
+                table_.MergePartitionEmit(id, emit);
+            else
+                table_.FlushPartitionEmit(id, consume, emit);
+        }
+
+        LOG << "Flushed items";
+    }
+
+    //! Flushes all items of a hash table, and re-reduces spilled partitions.
+    template <bool DoCache>
+    void Flush(bool consume, data::File::Writer* writer,
+               std::false_type /* sorted_runs */) {
         LOG << "Flushing items";
 
+        auto emit = [this, writer](const KeyValuePair& p) {
+                        if (DoCache) writer->Put(p);
+                        emitter_.Emit(p);
+                    };
+
         // list of remaining files, containing only partially reduced item pairs
         // or items
         std::vector<data::File> remaining_files;
 
+        // parts split off by Initialize() are re-reduced like spilled files.
+        for (data::File::Writer& w : part_writers_) w.Close();
+        part_writers_.clear();
+        for (data::File& part : parts_)
+            remaining_files.emplace_back(std::move(part));
+        parts_.clear();
+        fan_out_ = 1;
+
         // read primary hash table, since ReduceByHash delivers items in any
         // order, we can just emit items from fully reduced partitions.
 
@@ -161,15 +269,18 @@ public:
 
                     table_.FlushPartitionEmit(
                         id, consume,
-                        [this, writer](
-                            const size_t& partition_id, const KeyValuePair& p) {
-                            if (DoCache) writer->Put(p);
-                            emitter_.Emit(partition_id, p);
+                        [&emit](const size_t&, const KeyValuePair& p) {
+                            emit(p);
                         });
                 }
             }
         }
 
+        if (steal_pool_) {
+            ReduceSharedFiles(remaining_files, emit);
+            return;
+        }
+
         if (remaining_files.size() == 0) {
             LOG << "Flushed items directly.";
             return;
@@ -179,90 +290,208 @@ public:
 
         assert(consume && "Items were spilled hence Flushing must consume");
 
-        // if partially reduce files remain, create new hash tables to process
-        // them iteratively.
-
-        size_t iteration = 1;
+        // if partially reduce files remain, re-reduce them with hybrid hashing.
+        ReduceFiles(remaining_files, /* level */ 1, emit);
 
-        while (remaining_files.size())
-        {
-            sLOG1 << "ReducePostStage: re-reducing items from"
-                  << remaining_files.size() << "spilled files"
-                  << "iteration" << iteration;
-            sLOG1 << "-- Try to increase the amount of RAM to avoid this.";
-
-            std::vector<data::File> next_remaining_files;
-
-            Table subtable(
-                table_.ctx(), table_.dia_id(),
-                table_.key_extractor(), table_.reduce_function(), emitter_,
-                /* num_partitions */ 32, config_, /* immediate_flush */ false,
-                IndexFunction(iteration, table_.index_function()),
-                table_.equal_to_function());
-
-            subtable.Initialize(table_.limit_memory_bytes());
+        LOG << "Flushed items";
+    }
 
-            size_t num_subfile = 0;
+    /*!
+     * Publish the spilled files in the pool shared with the other local
+     * workers, and re-reduce them in order, unless they were stolen, in which
+     * case the thief's output is emitted instead.
+     */
+    template <typename Emit>
+    void ReduceSharedFiles(std::vector<data::File>& files, const Emit& emit) {
+        size_t worker = table_.ctx().local_worker_id();
+        size_t num_files = files.size();
+
+        if (num_files != 0) table_.Dispose();
+
+        steal_pool_->Publish(worker, std::move(files),
+                             std::vector<bool>(num_files, true));
+
+        for (size_t i = 0; i < num_files; ++i) {
+            data::FilePtr output = steal_pool_->Claim(worker, i);
+            if (!output) {
+                std::vector<data::File> own;
+                own.emplace_back(std::move(steal_pool_->input(worker, i)));
+                ReduceFiles(own, /* level */ 1, emit);
+            }
+            else {
+                data::File::ConsumeReader reader = output->GetConsumeReader();
+                while (reader.HasNext())
+                    emit(reader.Next<KeyValuePair>());
+            }
+        }
+    }
 
-            for (data::File& file : remaining_files)
+    //! Re-reduce spilled files of other local workers from the shared pool into
+    //! output Files, until none are left.
+    void StealFiles() {
+        size_t victim, index;
+        while (steal_pool_->Steal(
+                   table_.ctx().local_worker_id(), victim, index)) {
+            data::FilePtr output = table_.ctx().GetFilePtr(table_.dia_id());
             {
-                // insert all items from the partially reduced file
-                sLOG << "re-reducing subfile" << num_subfile++
-                     << "containing" << file.num_items() << "items";
+                data::File::Writer writer = output->GetWriter();
+                std::vector<data::File> files;
+                files.emplace_back(
+                    std::move(steal_pool_->input(victim, index)));
+                ReduceFiles(files, /* level */ 1,
+                            [&writer](const KeyValuePair& p) {
+                                writer.Put(p);
+                            });
+            }
+            steal_pool_->Complete(victim, index, std::move(output));
+            ++num_stolen_;
+        }
+    }
 
-                data::File::ConsumeReader reader = file.GetConsumeReader();
+    /*!
+     * Re-reduce the partially reduced items of spilled files with hybrid
+     * hashing. For each file, the fan-out is calculated from its number of
+     * items and the capacity of the subtable, such that each part is expected
+     * to fit into memory. The items of part zero are reduced directly in the
+     * subtable and emitted, while those of the other parts are written to new
+     * Files, which are re-reduced at the next level. Hence each item is
+     * written at most once per level, and only once in total unless the key
+     * distribution is very skewed. The reduced items are passed to emit.
+     */
+    template <typename Emit>
+    void ReduceFiles(std::vector<data::File>& files, size_t level,
+                     const Emit& emit) {
 
-                while (reader.HasNext()) {
-                    subtable.Insert(reader.Next<KeyValuePair>());
-                }
+        std::vector<data::File> next_files;
 
-                // after insertion, flush fully reduced partitions and save
-                // remaining files for next iteration.
+        Table subtable(
+            table_.ctx(), table_.dia_id(),
+            table_.key_extractor(), table_.reduce_function(), emitter_,
+            /* num_partitions */ 32, config_, /* immediate_flush */ false,
+            IndexFunction(level, table_.index_function()),
+            table_.equal_to_function());
 
-                std::vector<data::File>& subfiles = subtable.partition_files();
+        subtable.Initialize(table_.limit_memory_bytes());
 
-                for (size_t id = 0; id < subfiles.size(); ++id)
-                {
-                    // get the actual reader from the file
-                    data::File& subfile = subfiles[id];
+        // aim at 7/8 of the capacity of the subtable, since its partitions do
+        // not fill evenly.
+        size_t capacity = std::max<size_t>(
+            subtable.limit_items_per_partition() * subtable.num_partitions()
+            / 8 * 7, 1);
 
-                    // if items have been spilled, store for a second reduce
-                    if (subfile.num_items() > 0) {
-                        subtable.SpillPartition(id);
+        // split parts with another salt than the subtable, such that the items
+        // of part zero fill all of its partitions.
+        IndexFunction split_function(~level, table_.index_function());
 
-                        sLOG << "partition" << id << "contains"
-                             << subfile.num_items() << "partially reduced items";
+        for (data::File& file : files)
+        {
+            // split into parts of 3/4 of the capacity, such that parts which
+            // are a bit larger than expected still fit.
+            size_t part_items = std::max<size_t>(capacity / 4 * 3, 1);
+            size_t fan_out = file.num_items() <= capacity ? 1 :
+                             (file.num_items() + part_items - 1) / part_items;
+
+            sLOG1 << "ReducePostStage: re-reducing" << file.num_items()
+                  << "items from spilled file"
+                  << "level" << level << "fan_out" << fan_out;
+            sLOG1 << "-- Try to increase the amount of RAM to avoid this.";
 
-                        next_remaining_files.emplace_back(std::move(subfile));
+            std::vector<data::File> parts;
+            std::vector<data::File::Writer> part_writers;
+            for (size_t p = 1; p < fan_out; ++p)
+                parts.emplace_back(table_.ctx().GetFile(table_.dia_id()));
+            for (data::File& part : parts)
+                part_writers.emplace_back(part.GetWriter());
+
+            data::File::ConsumeReader reader = file.GetConsumeReader();
+
+            while (reader.HasNext()) {
+                if (Table::store_hash_) {
+                    // spilled items are preceded by their key hash
+                    uint64_t key_hash = reader.Next<uint64_t>();
+                    KeyValuePair kv = reader.Next<KeyValuePair>();
+                    size_t part = fan_out == 1 ? 0 :
+                                  split_function.from_key_hash(
+                        key_hash, fan_out, 1, fan_out).partition_id;
+                    if (part == 0) {
+                        subtable.Insert(std::move(kv), key_hash);
                     }
                     else {
-                        sLOG << "partition" << id << "contains"
-                             << subtable.items_per_partition(id)
-                             << "fully reduced items";
-
-                        subtable.FlushPartitionEmit(
-                            id, /* consume */ true,
-                            [this, writer](
-                                const size_t& partition_id, const KeyValuePair& p) {
-                                if (DoCache) writer->Put(p);
-                                emitter_.Emit(partition_id, p);
-                            });
+                        part_writers[part - 1].Put(key_hash);
+                        part_writers[part - 1].Put(kv);
                     }
                 }
+                else {
+                    KeyValuePair kv = reader.Next<KeyValuePair>();
+                    size_t part = fan_out == 1 ? 0 :
+                                  split_function(
+                        kv.first, fan_out, 1, fan_out).partition_id;
+                    if (part == 0)
+                        subtable.Insert(std::move(kv));
+                    else
+                        part_writers[part - 1].Put(kv);
+                }
             }
 
-            remaining_files = std::move(next_remaining_files);
-            ++iteration;
+            for (data::File::Writer& w : part_writers) w.Close();
+            for (data::File& part : parts)
+                next_files.emplace_back(std::move(part));
+
+            // flush fully reduced partitions of part zero, and save those
+            // spilled due to skew for the next level.
+
+            std::vector<data::File>& subfiles = subtable.partition_files();
+
+            for (size_t id = 0; id < subfiles.size(); ++id)
+            {
+                // get the actual reader from the file
+                data::File& subfile = subfiles[id];
+
+                // if items have been spilled, store for the next level
+                if (subfile.num_items() > 0) {
+                    subtable.SpillPartition(id);
+
+                    sLOG << "partition" << id << "contains"
+                         << subfile.num_items() << "partially reduced items";
+
+                    next_files.emplace_back(std::move(subfile));
+                    subfile = table_.ctx().GetFile(table_.dia_id());
+                }
+                else {
+                    sLOG << "partition" << id << "contains"
+                         << subtable.items_per_partition(id)
+                         << "fully reduced items";
+
+                    subtable.FlushPartitionEmit(
+                        id, /* consume */ true,
+                        [&emit](const size_t&, const KeyValuePair& p) {
+                            emit(p);
+                        });
+                }
+            }
         }
 
-        LOG << "Flushed items";
+        // release the subtable before re-reducing the parts at the next level
+        subtable.Dispose();
+        files.clear();
+
+        if (!next_files.empty())
+            ReduceFiles(next_files, level + 1, emit);
     }
 
     //! Push data into emitter
     void PushData(bool consume = false) {
+        // share spilled partitions with the other local workers, such that
+        // idle ones help to re-reduce them.
+        if (!Table::sorted_runs_ && config_.steal_partitions())
+            steal_pool_ = StealPool::Share(table_.ctx());
+        num_stolen_ = 0;
+
+        bool spilled = !cache_ && (table_.has_spilled_data() || fan_out_ > 1);
+
         if (!cache_)
         {
-            if (!table_.has_spilled_data()) {
+            if (!spilled) {
                 // no items were spilled to disk, hence we can emit all data
                 // from RAM.
                 Flush</* DoCache */ false>(consume);
@@ -278,14 +507,31 @@ public:
         else
         {
             // previous PushData() has stored data in cache_
+            if (steal_pool_) {
+                steal_pool_->Publish(table_.ctx().local_worker_id(),
+                                     std::vector<data::File>(),
+                                     std::vector<bool>());
+            }
             data::File::Reader reader = cache_->GetReader(consume);
             while (reader.HasNext())
                 emitter_.Emit(reader.Next<KeyValuePair>());
         }
+
+        if (steal_pool_) {
+            // only workers whose table is emptied have memory to steal.
+            if (consume || spilled) {
+                table_.Dispose();
+                StealFiles();
+            }
+            steal_pool_.reset();
+        }
     }
 
     void Dispose() {
         table_.Dispose();
+        part_writers_.clear();
+        parts_.clear();
+        fan_out_ = 1;
         if (cache_) cache_.reset();
     }
 
@@ -298,9 +544,39 @@ public:
     //! Returns the total num of items in the table.
     size_t num_items() const { return table_.num_items(); }
 
+    //! Returns the number of spilled files of other local workers re-reduced
+    //! in the last PushData().
+    size_t num_stolen() const { return num_stolen_; }
+
+    //! Returns the number of parts planned by Initialize(), one unless the
+    //! expected keys exceed the capacity of the table.
+    size_t fan_out() const { return fan_out_; }
+
     //! \}
 
 private:
+    //! insert an item into the table if it belongs to part zero, otherwise
+    //! write it to its part File.
+    template <typename KV>
+    void InsertSplit(KV&& kv) {
+        if (Table::store_hash_) {
+            uint64_t key_hash = table_.index_function().key_hash(kv.first);
+            size_t part = split_function_.from_key_hash(
+                key_hash, fan_out_, 1, fan_out_).partition_id;
+            if (part == 0)
+                return table_.Insert(std::forward<KV>(kv), key_hash);
+            part_writers_[part - 1].Put(key_hash);
+            part_writers_[part - 1].Put(kv);
+        }
+        else {
+            size_t part = split_function_(
+                kv.first, fan_out_, 1, fan_out_).partition_id;
+            if (part == 0)
+                return table_.Insert(std::forward<KV>(kv));
+            part_writers_[part - 1].Put(kv);
+        }
+    }
+
     //! Stored reduce config to initialize the subtable.
     ReduceConfig config_;
 
@@ -312,6 +588,22 @@ private:
 
     //! File for storing data in-case we need multiple re-reduce levels.
     data::FilePtr cache_;
+
+    //! pool of spilled files shared with the local workers during PushData()
+    std::shared_ptr<StealPool> steal_pool_;
+
+    //! number of spilled files of other workers re-reduced in PushData()
+    size_t num_stolen_ = 0;
+
+    //! number of parts planned by Initialize() from the expected keys
+    size_t fan_out_ = 1;
+
+    //! index function which assigns items to the parts
+    IndexFunction split_function_;
+
+    //! Files of parts one to fan_out_ - 1 and their writers
+    std::vector<data::File> parts_;
+    std::vector<data::File::Writer> part_writers_;
 };
 
 } // namespace core
@@ -19,12 +19,16 @@
 #include <thrill/core/reduce_bucket_hash_table.hpp>
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_robin_hood_hash_table.hpp>
+#include <thrill/core/reduce_sort_table.hpp>
+#include <thrill/core/reduce_steal_pool.hpp>
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -123,13 +127,23 @@ public:
         return table_.Insert(kv);
     }
 
+    void Insert(Value&& p) {
+        return table_.Insert(std::move(p));
+    }
+
+    void Insert(KeyValuePair&& kv) {
+        return table_.Insert(std::move(kv));
+    }
+
     using RangeFilePair = std::pair<common::Range, data::File>;
 
-    //! Flush contents of table into emitter and return remaining files
-    template <bool DoCache>
+    using StealPool = ReduceStealPool<RangeFilePair>;
+
+    //! Flush contents of table into emit and return remaining files
+    template <typename Emit>
     void FlushTableInto(
         Table& table, std::vector<RangeFilePair>& remaining_files,
-        bool consume, data::File::Writer* writer = nullptr) {
+        bool consume, const Emit& emit) {
 
         std::vector<data::File>& files = table.partition_files();
 
@@ -156,26 +170,17 @@ public:
 
                 table.FlushPartitionEmit(
                     id, consume,
-                    [this, &table, &file_range, &index, writer](
+                    [this, &index, &emit](
                         const size_t& /* partition_id */, const KeyValuePair& p) {
                         for ( ; index < p.first; ++index) {
-                            KeyValuePair kv = std::make_pair(index, neutral_element_);
-                            emitter_.Emit(kv);
-                            if (DoCache) writer->Put(kv);
-
-                                // sLOG << "emit hole" << index << "-" << neutral_element_;
+                            emit(std::make_pair(index, neutral_element_));
                         }
-                        emitter_.Emit(p);
-                        if (DoCache) writer->Put(p);
-
-                        // sLOG << "emit" << p.first << "-" << p.second;
+                        emit(p);
                         ++index;
                     });
 
                 for ( ; index < file_range.end; ++index) {
-                    KeyValuePair kv = std::make_pair(index, neutral_element_);
-                    emitter_.Emit(kv);
-                    if (DoCache) writer->Put(kv);
+                    emit(std::make_pair(index, neutral_element_));
                 }
             }
         }
@@ -227,13 +232,23 @@ public:
     void Flush(bool consume, data::File::Writer* writer = nullptr) {
         LOG << "Flushing items";
 
+        auto emit = [this, writer](const KeyValuePair& p) {
+                        emitter_.Emit(p);
+                        if (DoCache) writer->Put(p);
+                    };
+
         // list of remaining files, containing only partially reduced item pairs
         // or items. in reverse order.
         std::vector<RangeFilePair> remaining_files;
 
         // read primary hash table, since ReduceByHash delivers items in any
         // order, we can just emit items from fully reduced partitions.
-        FlushTableInto<DoCache>(table_, remaining_files, consume, writer);
+        FlushTableInto(table_, remaining_files, consume, emit);
+
+        if (steal_pool_) {
+            ReduceSharedFiles(remaining_files, emit);
+            return;
+        }
 
         if (remaining_files.size() == 0) {
             LOG << "Flushed items directly.";
@@ -250,19 +265,37 @@ public:
         // if partially reduce files remain, create new hash tables to process
         // them iteratively.
 
-        Table subtable(
+        std::unique_ptr<Table> subtable = MakeSubtable();
+
+        sLOG1 << "ReduceToIndexPostStage: re-reducing items from"
+              << remaining_files.size() << "spilled files";
+
+        ReduceRemainingFiles(*subtable, remaining_files, emit);
+
+        LOG << "Flushed items";
+    }
+
+    //! Create a subtable to re-reduce spilled files.
+    std::unique_ptr<Table> MakeSubtable() {
+        std::unique_ptr<Table> subtable = std::make_unique<Table>(
             table_.ctx(), table_.dia_id(),
             table_.key_extractor(), table_.reduce_function(), emitter_,
             /* num_partitions */ 32, config_, false,
             table_.index_function(),
             table_.equal_to_function());
 
-        subtable.Initialize(table_.limit_memory_bytes());
+        subtable->Initialize(table_.limit_memory_bytes());
+        return subtable;
+    }
 
-        size_t iteration = 1;
+    //! Re-reduce or emit the remaining files, which are in reverse order, with
+    //! the subtable in the order of their ranges.
+    template <typename Emit>
+    void ReduceRemainingFiles(
+        Table& subtable, std::vector<RangeFilePair>& remaining_files,
+        const Emit& emit) {
 
-        sLOG1 << "ReduceToIndexPostStage: re-reducing items from"
-              << remaining_files.size() << "spilled files";
+        size_t iteration = 1;
 
         while (remaining_files.size())
         {
@@ -299,23 +332,15 @@ public:
                     KeyValuePair p = reader.Next<KeyValuePair>();
 
                     for ( ; index < p.first; ++index) {
-                        KeyValuePair kv = std::make_pair(index, neutral_element_);
-                        emitter_.Emit(kv);
-                        if (DoCache) writer->Put(kv);
-
-                        // sLOG << "emit hole" << index << "-" << neutral_element_;
+                        emit(std::make_pair(index, neutral_element_));
                     }
 
-                    // sLOG << "emit" << p.first << "-" << p.second;
-                    emitter_.Emit(p);
-                    if (DoCache) writer->Put(p);
+                    emit(p);
                     ++index;
                 }
 
                 for ( ; index < range.end; ++index) {
-                    KeyValuePair kv = std::make_pair(index, neutral_element_);
-                    emitter_.Emit(kv);
-                    if (DoCache) writer->Put(kv);
+                    emit(std::make_pair(index, neutral_element_));
                 }
             }
             else
@@ -336,8 +361,8 @@ public:
                 // after insertion, flush fully reduced partitions and save
                 // remaining files for next iteration.
 
-                FlushTableInto<DoCache>(
-                    subtable, next_remaining_files, /* consume */ true, writer);
+                FlushTableInto(
+                    subtable, next_remaining_files, /* consume */ true, emit);
 
                 for (auto it = next_remaining_files.rbegin();
                      it != next_remaining_files.rend(); ++it)
@@ -348,14 +373,84 @@ public:
                 ++iteration;
             }
         }
+    }
 
-        LOG << "Flushed items";
+    /*!
+     * Publish the remaining files in the pool shared with the other local
+     * workers, and re-reduce or emit them in order. The output of partially
+     * reduced files stolen by other workers is emitted in their place.
+     */
+    template <typename Emit>
+    void ReduceSharedFiles(std::vector<RangeFilePair>& files,
+                           const Emit& emit) {
+        size_t worker = table_.ctx().local_worker_id();
+        size_t num_files = files.size();
+
+        // only partially reduced files are worth stealing
+        std::vector<bool> stealable(num_files);
+        for (size_t i = 0; i < num_files; ++i)
+            stealable[i] = files[i].first.IsValid();
+
+        steal_pool_->Publish(worker, std::move(files), stealable);
+
+        if (num_files == 0) return;
+
+        table_.Dispose();
+
+        std::unique_ptr<Table> subtable = MakeSubtable();
+
+        for (size_t i = 0; i < num_files; ++i) {
+            data::FilePtr output = steal_pool_->Claim(worker, i);
+            if (!output) {
+                std::vector<RangeFilePair> own;
+                own.emplace_back(std::move(steal_pool_->input(worker, i)));
+                ReduceRemainingFiles(*subtable, own, emit);
+            }
+            else {
+                data::File::ConsumeReader reader = output->GetConsumeReader();
+                while (reader.HasNext())
+                    emit(reader.Next<KeyValuePair>());
+            }
+        }
+    }
+
+    //! Re-reduce spilled files of other local workers from the shared pool into
+    //! output Files, until none are left.
+    void StealFiles() {
+        std::unique_ptr<Table> subtable;
+        size_t victim, index;
+        while (steal_pool_->Steal(
+                   table_.ctx().local_worker_id(), victim, index)) {
+            if (!subtable) subtable = MakeSubtable();
+
+            data::FilePtr output = table_.ctx().GetFilePtr(table_.dia_id());
+            {
+                data::File::Writer writer = output->GetWriter();
+                std::vector<RangeFilePair> files;
+                files.emplace_back(
+                    std::move(steal_pool_->input(victim, index)));
+                ReduceRemainingFiles(*subtable, files,
+                                     [&writer](const KeyValuePair& p) {
+                                         writer.Put(p);
+                                     });
+            }
+            steal_pool_->Complete(victim, index, std::move(output));
+            ++num_stolen_;
+        }
     }
 
     void PushData(bool consume = false) {
+        // share spilled partitions with the other local workers, such that
+        // idle ones help to re-reduce them.
+        if (!Table::sorted_runs_ && config_.steal_partitions())
+            steal_pool_ = StealPool::Share(table_.ctx());
+        num_stolen_ = 0;
+
+        bool spilled = !cache_ && table_.has_spilled_data();
+
         if (!cache_)
         {
-            if (!table_.has_spilled_data()) {
+            if (!spilled) {
                 // no items were spilled to disk, hence we can emit all data
                 // from RAM.
                 Flush</* DoCache */ false>(consume);
@@ -371,10 +466,24 @@ public:
         else
         {
             // previous PushData() has stored data in cache_
+            if (steal_pool_) {
+                steal_pool_->Publish(table_.ctx().local_worker_id(),
+                                     std::vector<RangeFilePair>(),
+                                     std::vector<bool>());
+            }
             data::File::Reader reader = cache_->GetReader(consume);
             while (reader.HasNext())
                 emitter_.Emit(reader.Next<KeyValuePair>());
         }
+
+        if (steal_pool_) {
+            // only workers whose table is emptied have memory to steal.
+            if (consume || spilled) {
+                table_.Dispose();
+                StealFiles();
+            }
+            steal_pool_.reset();
+        }
     }
 
     void Dispose() {
@@ -391,6 +500,10 @@ public:
     //! Returns the total num of items in the table.
     size_t num_items() const { return table_.num_items(); }
 
+    //! Returns the number of spilled files of other local workers re-reduced
+    //! in the last PushData().
+    size_t num_stolen() const { return num_stolen_; }
+
     //! \}
 
 private:
@@ -408,6 +521,12 @@ private:
 
     //! File for storing data in-case we need multiple re-reduce levels.
     data::FilePtr cache_;
+
+    //! pool of spilled files shared with the local workers during PushData()
+    std::shared_ptr<StealPool> steal_pool_;
+
+    //! number of spilled files of other workers re-reduced in PushData()
+    size_t num_stolen_ = 0;
 };
 
 } // namespace core
@@ -17,6 +17,8 @@
 #define THRILL_CORE_REDUCE_FUNCTIONAL_HEADER
 
 #include <thrill/common/defines.hpp>
+#include <thrill/common/die.hpp>
+#include <thrill/common/hash.hpp>
 #include <thrill/common/math.hpp>
 
 namespace thrill {
@@ -39,7 +41,7 @@ static inline uint64_t Hash128to64(const uint64_t upper, const uint64_t lower) {
  * A reduce index function which returns a hash index and partition. It is used
  * by ReduceByKey.
  */
-template <typename Key, typename HashFunction = std::hash<Key> >
+template <typename Key, typename HashFunction = common::Hash<Key> >
 class ReduceByHash
 {
 public:
@@ -65,13 +67,34 @@ public:
         const uint64_t& salt, const ReduceByHash& other)
         : salt_(salt), hash_function_(other.hash_function_) { }
 
+    //! the index is calculated from a hash of the key which does not depend
+    //! on the salt, hence tables may store it to skip rehashing.
+    static constexpr bool has_key_hash = true;
+
     Result operator () (
         const Key& k,
         const size_t& num_partitions,
+        const size_t& num_buckets_per_partition,
+        const size_t& num_buckets_per_table) const {
+        return from_key_hash(
+            key_hash(k), num_partitions,
+            num_buckets_per_partition, num_buckets_per_table);
+    }
+
+    //! hash of the key, independent of the salt
+    uint64_t key_hash(const Key& k) const {
+        return hash_function_(k);
+    }
+
+    //! calculate the index from a key_hash() stored earlier, which may have
+    //! been calculated with a different salt.
+    Result from_key_hash(
+        const uint64_t& key_hash,
+        const size_t& num_partitions,
         const size_t& /* num_buckets_per_partition */,
         const size_t& /* num_buckets_per_table */) const {
 
-        uint64_t hash = Hash128to64(salt_, hash_function_(k));
+        uint64_t hash = Hash128to64(salt_, key_hash);
 
         size_t partition_id = hash % num_partitions;
         size_t remaining_hash = hash / num_partitions;
@@ -135,6 +158,20 @@ public:
         };
     }
 
+    //! the index is calculated directly from the key, there is no hash.
+    static constexpr bool has_key_hash = false;
+
+    //! not available for ReduceByIndex
+    uint64_t key_hash(const Key&) const {
+        die("ReduceByIndex::key_hash() called");
+    }
+
+    //! not available for ReduceByIndex
+    Result from_key_hash(const uint64_t&, const size_t&, const size_t&,
+                         const size_t&) const {
+        die("ReduceByIndex::from_key_hash() called");
+    }
+
     //! inverse mapping: takes a bucket index and returns the smallest index
     //! delivered to the bucket.
     size_t inverse(size_t bucket, const size_t& num_buckets) {
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * thrill/core/reduce_key_arena.hpp
+ *
+ * Arena for the string bytes of items stored in a reduce table partition.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_KEY_ARENA_HEADER
+#define THRILL_CORE_REDUCE_KEY_ARENA_HEADER
+
+#include <thrill/common/fast_string.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * ReduceKeyArena holds the bytes of common::FastString keys and values of one
+ * reduce table partition. New items are stored with FastString references into
+ * the arena instead of allocating each string on the heap, and the arena is
+ * cleared when the partition is spilled or flushed. Spilled or transmitted
+ * items serialize the string bytes inline as usual.
+ */
+class ReduceKeyArena
+{
+public:
+    //! size of regular chunks, larger strings get their own chunk.
+    static constexpr size_t chunk_size = 4096;
+
+    //! copy the bytes into the arena and return their location.
+    const char * Copy(const char* data, size_t size) {
+        if (size > static_cast<size_t>(end_ - ptr_))
+            NewChunk(size);
+        char* p = ptr_;
+        std::copy(data, data + size, p);
+        ptr_ += size;
+        return p;
+    }
+
+    //! drop all strings, keeps the first chunk if it has regular size.
+    void Clear() {
+        if (chunks_.empty()) return;
+        if (first_size_ != chunk_size) {
+            chunks_.clear();
+            ptr_ = end_ = nullptr;
+            reserved_ = 0;
+            return;
+        }
+        chunks_.resize(1);
+        ptr_ = chunks_[0].get();
+        end_ = ptr_ + chunk_size;
+        reserved_ = chunk_size;
+    }
+
+    //! number of bytes in chunks
+    size_t reserved() const { return reserved_; }
+
+private:
+    //! chunks of string bytes
+    std::vector<std::unique_ptr<char[]> > chunks_;
+
+    //! free area of the current chunk
+    char* ptr_ = nullptr, * end_ = nullptr;
+
+    //! size of the first chunk
+    size_t first_size_ = 0;
+
+    //! number of bytes in chunks
+    size_t reserved_ = 0;
+
+    void NewChunk(size_t min_size) {
+        size_t size = std::max(chunk_size, min_size);
+        chunks_.emplace_back(new char[size]);
+        if (chunks_.size() == 1) first_size_ = size;
+        ptr_ = chunks_.back().get();
+        end_ = ptr_ + size;
+        reserved_ += size;
+    }
+};
+
+/*!
+ * Assigns an item to a reduce table slot, storing the bytes of FastStrings in
+ * a ReduceKeyArena. Other types are copied as usual, enabled tells whether a
+ * type contains FastStrings at all.
+ */
+template <typename Type>
+struct ReduceKeyArenaStore {
+    static constexpr bool enabled = false;
+
+    static void Assign(Type& slot, const Type& item, ReduceKeyArena&) {
+        slot = item;
+    }
+};
+
+template <>
+struct ReduceKeyArenaStore<common::FastString>{
+    static constexpr bool enabled = true;
+
+    static void Assign(common::FastString& slot,
+                       const common::FastString& item, ReduceKeyArena& arena) {
+        slot = common::FastString::Ref(
+            arena.Copy(item.Data(), item.Size()), item.Size());
+    }
+};
+
+template <typename First, typename Second>
+struct ReduceKeyArenaStore<std::pair<First, Second> >{
+    static constexpr bool enabled =
+        ReduceKeyArenaStore<First>::enabled ||
+        ReduceKeyArenaStore<Second>::enabled;
+
+    static void Assign(std::pair<First, Second>& slot,
+                       const std::pair<First, Second>& item,
+                       ReduceKeyArena& arena) {
+        ReduceKeyArenaStore<First>::Assign(slot.first, item.first, arena);
+        ReduceKeyArenaStore<Second>::Assign(slot.second, item.second, arena);
+    }
+};
+
+/*!
+ * Casts an item inserted into a reduce table to an rvalue, such that it is
+ * moved into its slot, unless it contains FastStrings: a moved reference
+ * FastString stays a reference, while a copy owns its bytes.
+ */
+template <typename Type>
+typename std::conditional<
+    ReduceKeyArenaStore<Type>::enabled, const Type&, Type&&>::type
+ReduceMoveItem(Type& item) {
+    return std::move(item);
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_KEY_ARENA_HEADER
+
+/******************************************************************************/
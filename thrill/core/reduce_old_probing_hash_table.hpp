@@ -14,6 +14,7 @@
 #define THRILL_CORE_REDUCE_OLD_PROBING_HASH_TABLE_HEADER
 
 #include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_key_arena.hpp>
 #include <thrill/core/reduce_table.hpp>
 
 #include <functional>
@@ -89,6 +90,9 @@ public:
     using KeyValuePair = std::pair<Key, Value>;
     using ReduceConfig = ReduceConfig_;
 
+    //! this table does not store key hashes
+    static constexpr bool store_hash_ = false;
+
     using KeyValueIterator = typename std::vector<KeyValuePair>::iterator;
 
     ReduceOldProbingHashTable(
@@ -157,7 +161,13 @@ public:
      * inserts the pair via the Insert() function.
      */
     void Insert(const Value& p) {
-        Insert(std::make_pair(key_extractor_(p), p));
+        Insert(KeyValuePair(key_extractor_(p), p));
+    }
+
+    //! Inserts a value, which is moved into the key-value-pair.
+    void Insert(Value&& p) {
+        Key key = key_extractor_(p);
+        Insert(KeyValuePair(std::move(key), std::move(p)));
     }
 
     /*!
@@ -175,6 +185,30 @@ public:
      * \param kv Value to be inserted into the table.
      */
     void Insert(const KeyValuePair& kv) {
+        InsertPair(kv);
+    }
+
+    //! Inserts a key-value-pair, which is moved into a new slot, and whose
+    //! value is passed as an rvalue to the reduce function.
+    void Insert(KeyValuePair&& kv) {
+        InsertPair(ReduceMoveItem(kv));
+    }
+
+    //! Inserts a value whose key hash was stored earlier, this table ignores
+    //! the hash.
+    void Insert(const KeyValuePair& kv, uint64_t /* key_hash */) {
+        InsertPair(kv);
+    }
+
+    //! Inserts a moved value whose key hash was stored earlier, this table
+    //! ignores the hash.
+    void Insert(KeyValuePair&& kv, uint64_t /* key_hash */) {
+        InsertPair(ReduceMoveItem(kv));
+    }
+
+    //! Insert implementation for lvalue and rvalue pairs.
+    template <typename KV>
+    void InsertPair(KV&& kv) {
 
         while (mem::memory_exceeded && num_items_ != 0)
             SpillAnyPartition();
@@ -191,11 +225,12 @@ public:
             KeyValuePair& sentinel = items_[num_buckets_];
             if (sentinel_partition_ == invalid_partition_) {
                 // first occurrence of sentinel key
-                sentinel = kv;
+                sentinel = std::forward<KV>(kv);
                 sentinel_partition_ = h.partition_id;
             }
             else {
-                sentinel.second = reduce_function_(sentinel.second, kv.second);
+                sentinel.second = reduce_function_(
+                    std::move(sentinel.second), std::forward<KV>(kv).second);
             }
             ++items_per_partition_[h.partition_id];
             ++num_items_;
@@ -223,7 +258,8 @@ public:
                     << "match of key: " << kv.first
                     << " and " << iter->first << " ... reducing...";
 
-                iter->second = reduce_function_(iter->second, kv.second);
+                iter->second = reduce_function_(
+                    std::move(iter->second), std::forward<KV>(kv).second);
 
                 return;
             }
@@ -239,7 +275,7 @@ public:
 
                 SpillPartition(h.partition_id);
 
-                *iter = kv;
+                *iter = std::forward<KV>(kv);
 
                 // increase counter for partition
                 ++items_per_partition_[h.partition_id];
@@ -250,7 +286,7 @@ public:
         }
 
         // insert new pair
-        *iter = kv;
+        *iter = std::forward<KV>(kv);
 
         // increase counter for partition
         ++items_per_partition_[h.partition_id];
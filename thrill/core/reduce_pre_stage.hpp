@@ -16,12 +16,21 @@
 #ifndef THRILL_CORE_REDUCE_PRE_STAGE_HEADER
 #define THRILL_CORE_REDUCE_PRE_STAGE_HEADER
 
+#include <thrill/common/defines.hpp>
+#include <thrill/common/hash.hpp>
+#include <thrill/common/hyperloglog.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
 #include <thrill/core/reduce_bucket_hash_table.hpp>
 #include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_key_arena.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_robin_hood_hash_table.hpp>
+#include <thrill/core/reduce_sort_table.hpp>
+#include <thrill/data/block_pool.hpp>
 #include <thrill/data/block_writer.hpp>
+#include <thrill/net/flow_control_channel.hpp>
 
 #include <algorithm>
 #include <cassert>
@@ -59,29 +68,69 @@ public:
 
 //! Emitter implementation to plug into a reduce hash table for
 //! collecting/flushing items while reducing. Items flushed in the pre-stage are
-//! transmitted via a network Channel.
+//! transmitted via a network Channel. The table may have several consecutive
+//! partitions per output writer, which are mapped onto the writers many-to-one.
 template <typename KeyValuePair, bool VolatileKey>
 class ReducePreStageEmitter
 {
     static constexpr bool debug = false;
 
 public:
-    explicit ReducePreStageEmitter(std::vector<data::DynBlockWriter>& writer)
+    explicit ReducePreStageEmitter(std::vector<data::DynBlockWriter>& writer,
+                                   size_t partitions_per_output = 1)
         : writer_(writer),
-          stats_(writer.size(), 0) { }
+          partitions_per_output_(partitions_per_output),
+          stats_(writer.size(), 0) {
+        assert(partitions_per_output_ > 0);
+    }
 
     //! output an element into a partition, template specialized for robust and
     //! non-robust keys
     void Emit(const size_t& partition_id, const KeyValuePair& p) {
-        assert(partition_id < writer_.size());
-        stats_[partition_id]++;
+        size_t output = partition_id / partitions_per_output_;
+        assert(output < writer_.size());
+        stats_[output]++;
+        if (!sketches_.empty())
+            sketches_[output].Insert(key_hash_(p.first));
         ReducePreStageEmitterSwitch<KeyValuePair, VolatileKey>::Put(
-            p, writer_[partition_id]);
+            p, writer_[output]);
+    }
+
+    //! flush the writer of an output
+    void Flush(size_t output) {
+        assert(output < writer_.size());
+        writer_[output].Flush();
+    }
+
+    //! number of table partitions per output to reach min_partitions
+    static size_t PartitionsPerOutput(size_t min_partitions,
+                                      size_t num_outputs) {
+        assert(num_outputs > 0);
+        return std::max<size_t>(
+            1, common::IntegerDivRoundUp(min_partitions, num_outputs));
     }
 
-    void Flush(size_t partition_id) {
-        assert(partition_id < writer_.size());
-        writer_[partition_id].Flush();
+    //! sketch the keys emitted to each output with a HyperLogLog of
+    //! 2^precision registers.
+    void EnableSketches(unsigned precision) {
+        sketches_.assign(writer_.size(), common::HyperLogLog(precision));
+    }
+
+    //! key sketches of the outputs, empty unless enabled
+    std::vector<common::HyperLogLog>& sketches() { return sketches_; }
+
+    //! number of table partitions mapped onto each output
+    size_t partitions_per_output() const { return partitions_per_output_; }
+
+    //! number of table partitions of all outputs
+    size_t num_partitions() const
+    { return writer_.size() * partitions_per_output_; }
+
+    //! total number of items emitted into all partitions
+    size_t num_emitted() const {
+        size_t sum = 0;
+        for (const size_t& s : stats_) sum += s;
+        return sum;
     }
 
     void CloseAll() {
@@ -94,11 +143,20 @@ public:
     }
 
 public:
-    //! Set of emitters, one per partition.
+    //! Set of emitters, one per output.
     std::vector<data::DynBlockWriter>& writer_;
 
+    //! number of table partitions mapped onto each output
+    size_t partitions_per_output_;
+
     //! Emitter stats.
     std::vector<size_t> stats_;
+
+    //! HyperLogLog sketches of the keys emitted to each output
+    std::vector<common::HyperLogLog> sketches_;
+
+    //! hash function of the keys for the sketches
+    common::Hash<typename KeyValuePair::first_type> key_hash_;
 };
 
 template <typename ValueType, typename Key, typename Value,
@@ -127,6 +185,28 @@ public:
      * A data structure which takes an arbitrary value and extracts a key using
      * a key extractor function from that value. Afterwards, the value is hashed
      * based on the key into some slot.
+     *
+     * The stage adaptively bypasses the table: in windows of
+     * config.bypass_window_size() items it measures the fraction of items with
+     * new keys. If pre-reduction does not pay, the following
+     * config.bypass_windows() windows are sent directly to the emitters,
+     * afterwards the table is probed again.
+     *
+     * If config.hot_key_sample_size() is non-zero, the stage detects hot keys
+     * with a Misra-Gries summary of the first sampled items. Items with hot
+     * keys are afterwards reduced in a small side table, whose partial results
+     * are combined over all workers by an AllReduce in FlushAll(), and each
+     * combined item is then sent only once to its partition. Hence FlushAll()
+     * becomes a collective operation, which all workers must call. Each
+     * inserted item is compared linearly against the up to
+     * config.max_hot_keys() hot keys.
+     *
+     * When the BlockPool signals memory pressure, the stage spills its
+     * largest partition early instead of waiting until the table is full.
+     *
+     * The table has at least config.min_pre_partitions() partitions: if there
+     * are fewer outputs, each output receives several consecutive partitions,
+     * such that a spill writes out only a small part of the table.
      */
     ReducePreStage(Context& ctx, size_t dia_id,
                    size_t num_partitions,
@@ -136,12 +216,16 @@ public:
                    const ReduceConfig& config = ReduceConfig(),
                    const IndexFunction& index_function = IndexFunction(),
                    const EqualToFunction& equal_to_function = EqualToFunction())
-        : emit_(emit),
+        : emit_(emit, Emitter::PartitionsPerOutput(
+                    config.min_pre_partitions(), num_partitions)),
           table_(ctx, dia_id,
                  key_extractor, reduce_function, emit_,
-                 num_partitions, config, /* immediate_flush */ true,
-                 index_function, equal_to_function) {
-        sLOG << "creating ReducePreStage with" << emit.size() << "output emitters";
+                 emit_.num_partitions(), config, /* immediate_flush */ true,
+                 index_function, equal_to_function),
+          config_(config),
+          pressure_(ctx.block_pool()) {
+        sLOG << "creating ReducePreStage with" << emit.size() << "output emitters"
+             << "and" << emit_.num_partitions() << "partitions";
 
         assert(num_partitions == emit.size());
     }
@@ -156,31 +240,80 @@ public:
     }
 
     void Insert(const Value& p) {
-        return table_.Insert(p);
+        if (config_.hot_key_sample_size() != 0)
+            return Insert(KeyValuePair(table_.key_extractor()(p), p));
+
+        if (bypass_)
+            Bypass(KeyValuePair(table_.key_extractor()(p), p));
+        else
+            InsertTable(p);
+        CountWindow();
     }
 
     void Insert(const KeyValuePair& kv) {
-        return table_.Insert(kv);
+        if (config_.hot_key_sample_size() != 0 && InsertHot(kv))
+            return;
+
+        if (bypass_)
+            Bypass(kv);
+        else
+            InsertTable(kv);
+        CountWindow();
+    }
+
+    //! Inserts a value, which is moved into the table.
+    void Insert(Value&& p) {
+        if (config_.hot_key_sample_size() != 0 || bypass_) {
+            Key key = table_.key_extractor()(p);
+            return Insert(KeyValuePair(std::move(key), std::move(p)));
+        }
+
+        InsertTable(std::move(p));
+        CountWindow();
     }
 
-    //! Flush all partitions
+    //! Inserts a key-value-pair, which is moved into the table or the hot key
+    //! side table.
+    void Insert(KeyValuePair&& kv) {
+        if (config_.hot_key_sample_size() != 0 && InsertHot(ReduceMoveItem(kv)))
+            return;
+
+        if (bypass_)
+            Bypass(kv);
+        else
+            InsertTable(std::move(kv));
+        CountWindow();
+    }
+
+    //! Flush all partitions. If hot key detection is enabled, this is a
+    //! collective operation calling net.AllReduce(), since hot keys are
+    //! combined over all workers, hence all workers must call it.
     void FlushAll() {
-        for (size_t id = 0; id < table_.num_partitions(); ++id) {
-            FlushPartition(id, /* consume */ true);
+        if (config_.hot_key_sample_size() != 0)
+            FlushHotKeys();
+
+        const size_t k = emit_.partitions_per_output();
+        for (size_t output = 0; output < emit_.writer_.size(); ++output) {
+            for (size_t id = output * k; id < (output + 1) * k; ++id)
+                table_.FlushPartition(id, /* consume */ true);
+
+            // flush elements pushed into emitter
+            emit_.Flush(output);
         }
     }
 
-    //! Flushes all items of a partition.
+    //! Flushes all items of a table partition.
     void FlushPartition(size_t partition_id, bool consume) {
 
         table_.FlushPartition(partition_id, consume);
 
         // flush elements pushed into emitter
-        emit_.Flush(partition_id);
+        emit_.Flush(partition_id / emit_.partitions_per_output());
     }
 
     //! Closes all emitter
     void CloseAll() {
+        sLOG << "ReducePreStage bypassed" << num_bypassed_ << "items";
         emit_.CloseAll();
         table_.Dispose();
     }
@@ -191,18 +324,250 @@ public:
     //! Returns the total num of items in the table.
     size_t num_items() const { return table_.num_items(); }
 
-    //! calculate key range for the given output partition
-    common::Range key_range(size_t partition_id)
-    { return table_.key_range(partition_id); }
+    //! Returns the number of items sent directly, bypassing the table.
+    size_t num_bypassed() const { return num_bypassed_; }
+
+    //! Sketch the keys sent to each output with a HyperLogLog of 2^precision
+    //! registers, e.g. to let the receivers estimate their distinct keys.
+    void EnableKeySketches(unsigned precision) {
+        emit_.EnableSketches(precision);
+    }
+
+    //! Returns the key sketches of the outputs, empty unless enabled.
+    std::vector<common::HyperLogLog>& key_sketches()
+    { return emit_.sketches(); }
+
+    //! Returns the hot keys detected locally.
+    const std::vector<Key>& hot_keys() const { return hot_keys_; }
+
+    //! Returns the number of table partitions mapped onto each output.
+    size_t partitions_per_output() const
+    { return emit_.partitions_per_output(); }
+
+    //! calculate key range for the given output, which is the union of the
+    //! ranges of its consecutive partitions.
+    common::Range key_range(size_t output) {
+        const size_t k = emit_.partitions_per_output();
+        return common::Range(table_.key_range(output * k).begin,
+                             table_.key_range((output + 1) * k - 1).end);
+    }
 
     //! \}
 
 private:
+    //! insert an item into the table, spill a partition under memory pressure
+    template <typename Item>
+    void InsertTable(Item&& item) {
+        if (THRILL_UNLIKELY(pressure_.requested())) {
+            pressure_.Take();
+            if (table_.num_items() != 0) {
+                sLOG << "ReducePreStage spilling due to memory pressure";
+                table_.SpillAnyPartition();
+            }
+        }
+        table_.Insert(std::forward<Item>(item));
+    }
+
+    //! send an item directly into its output partition
+    void Bypass(const KeyValuePair& kv) {
+        typename IndexFunction::Result h = table_.index_function()(
+            kv.first, table_.num_partitions(),
+            table_.num_buckets_per_partition(), table_.num_buckets());
+        emit_.Emit(h.partition_id, kv);
+        ++num_bypassed_;
+    }
+
+    //! update the hot key summary while sampling, or reduce an item with a hot
+    //! key into the side table. Returns true if the item was consumed, and
+    //! only then an rvalue item was moved. This costs a linear scan over the
+    //! up to config.max_hot_keys() hot keys for every item.
+    template <typename KV>
+    bool InsertHot(KV&& kv) {
+        if (sampled_items_ < config_.hot_key_sample_size()) {
+            SampleHotKey(kv.first);
+            return false;
+        }
+
+        bool hot = false;
+        for (const Key& k : hot_keys_) {
+            if (table_.equal_to_function()(k, kv.first)) {
+                hot = true;
+                break;
+            }
+        }
+        if (!hot) return false;
+
+        for (KeyValuePair& h : hot_items_) {
+            if (table_.equal_to_function()(h.first, kv.first)) {
+                h.second = table_.reduce_function()(
+                    std::move(h.second), std::forward<KV>(kv).second);
+                return true;
+            }
+        }
+        hot_items_.emplace_back(std::forward<KV>(kv));
+        return true;
+    }
+
+    //! count a key in the Misra-Gries summary and select the hot keys after
+    //! the last sampled item.
+    void SampleHotKey(const Key& key) {
+        ++sampled_items_;
+
+        bool found = false;
+        for (std::pair<Key, size_t>& c : hot_counters_) {
+            if (table_.equal_to_function()(c.first, key)) {
+                ++c.second, found = true;
+                break;
+            }
+        }
+        if (!found) {
+            if (hot_counters_.size() < config_.max_hot_keys()) {
+                hot_counters_.emplace_back(key, 1);
+            }
+            else {
+                // decrement all counters and drop those reaching zero
+                for (std::pair<Key, size_t>& c : hot_counters_) --c.second;
+                hot_counters_.erase(
+                    std::remove_if(hot_counters_.begin(), hot_counters_.end(),
+                                   [](const std::pair<Key, size_t>& c) {
+                                       return c.second == 0;
+                                   }),
+                    hot_counters_.end());
+            }
+        }
+
+        if (sampled_items_ != config_.hot_key_sample_size()) return;
+
+        double threshold = config_.hot_key_rate()
+                           * static_cast<double>(sampled_items_);
+        for (const std::pair<Key, size_t>& c : hot_counters_) {
+            if (static_cast<double>(c.second) >= threshold)
+                hot_keys_.emplace_back(c.first);
+        }
+        std::vector<std::pair<Key, size_t> >().swap(hot_counters_);
+
+        sLOG << "ReducePreStage detected" << hot_keys_.size() << "hot keys";
+    }
+
+    //! combine the hot key partials of all workers and send each combined
+    //! item from one worker into its partition.
+    void FlushHotKeys() {
+        net::FlowControlChannel& net = table_.ctx().net;
+
+        auto equal_to_function = table_.equal_to_function();
+        auto reduce_function = table_.reduce_function();
+
+        std::vector<KeyValuePair> hot = net.AllReduce(
+            hot_items_,
+            [equal_to_function, reduce_function](
+                const std::vector<KeyValuePair>& a,
+                const std::vector<KeyValuePair>& b) {
+                std::vector<KeyValuePair> out = a;
+                for (const KeyValuePair& kv : b) {
+                    bool found = false;
+                    for (KeyValuePair& o : out) {
+                        if (equal_to_function(o.first, kv.first)) {
+                            o.second = reduce_function(o.second, kv.second);
+                            found = true;
+                            break;
+                        }
+                    }
+                    if (!found) out.emplace_back(kv);
+                }
+                return out;
+            });
+
+        // all workers hold the same result, spread the sending among them.
+        for (size_t i = net.my_rank(); i < hot.size(); i += net.num_workers()) {
+            typename IndexFunction::Result h = table_.index_function()(
+                hot[i].first, table_.num_partitions(),
+                table_.num_buckets_per_partition(), table_.num_buckets());
+            emit_.Emit(h.partition_id, hot[i]);
+        }
+
+        std::vector<KeyValuePair>().swap(hot_items_);
+    }
+
+    //! count an inserted item and switch between table and bypass mode at the
+    //! end of a window.
+    void CountWindow() {
+        if (++window_items_ < config_.bypass_window_size()) return;
+
+        if (bypass_) {
+            if (++bypassed_windows_ >= config_.bypass_windows()) {
+                // probe the table again
+                bypass_ = false;
+                bypassed_windows_ = 0;
+                window_begin_ = table_.num_items() + emit_.num_emitted();
+            }
+            window_items_ = 0;
+            return;
+        }
+
+        // each item either was reduced or added a new key to the table, and
+        // flushes only move items from the table to the emitters.
+        size_t new_keys =
+            table_.num_items() + emit_.num_emitted() - window_begin_;
+
+        if (static_cast<double>(new_keys) >
+            config_.bypass_new_key_rate() * static_cast<double>(window_items_)) {
+            sLOG << "ReducePreStage bypassing table, new keys"
+                 << new_keys << "of" << window_items_;
+            bypass_ = true;
+        }
+
+        window_items_ = 0;
+        window_begin_ = table_.num_items() + emit_.num_emitted();
+    }
+
     //! Emitters used to parameterize hash table for output to network.
     Emitter emit_;
 
     //! the first-level hash table implementation
     Table table_;
+
+    //! config of the reduce stage
+    ReduceConfig config_;
+
+    //! memory pressure flag set by the BlockPool
+    data::MemoryPressure pressure_;
+
+    //! \name Adaptive Bypass of the Table
+    //! \{
+
+    //! whether items are currently sent directly to the emitters
+    bool bypass_ = false;
+
+    //! number of items inserted in the current window
+    size_t window_items_ = 0;
+
+    //! number of windows bypassed so far in the current bypass phase
+    size_t bypassed_windows_ = 0;
+
+    //! table items plus emitted items at the beginning of a probe window
+    size_t window_begin_ = 0;
+
+    //! total number of items sent directly
+    size_t num_bypassed_ = 0;
+
+    //! \}
+
+    //! \name Hot Key Detection
+    //! \{
+
+    //! number of items sampled for hot key detection
+    size_t sampled_items_ = 0;
+
+    //! Misra-Gries counters of the sampled keys
+    std::vector<std::pair<Key, size_t> > hot_counters_;
+
+    //! hot keys selected after sampling
+    std::vector<Key> hot_keys_;
+
+    //! partial reductions of the hot keys
+    std::vector<KeyValuePair> hot_items_;
+
+    //! \}
 };
 
 } // namespace core
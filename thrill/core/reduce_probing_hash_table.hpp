@@ -13,15 +13,24 @@
 #ifndef THRILL_CORE_REDUCE_PROBING_HASH_TABLE_HEADER
 #define THRILL_CORE_REDUCE_PROBING_HASH_TABLE_HEADER
 
+#include <thrill/common/die.hpp>
+#include <thrill/common/math.hpp>
 #include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_key_arena.hpp>
 #include <thrill/core/reduce_table.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <limits>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace thrill {
 namespace core {
 
@@ -66,6 +75,18 @@ namespace core {
  *         PI 0        PI 1        PI 2        PI 3        PI 4
  *         PI..Partition ID
  *
+ * For integral keys, an additional array of control bytes is kept parallel to
+ * the slots, like in Swiss tables. An empty slot has control byte zero, an
+ * occupied slot a seven bit tag of the key with the high bit set. Probing then
+ * loads groups of 16 control bytes at once, and compares them against the tag
+ * and the empty byte using SSE2 (or a scalar loop if SSE2 is not available),
+ * such that keys are only compared in slots with matching tags.
+ *
+ * If ReduceConfig::store_hash_ is set and the IndexFunction has a key hash,
+ * the hash of each key is stored in a third array parallel to the slots. Keys
+ * are then only compared if their hashes match, and spilled items are written
+ * to the partition files preceded by their hash, such that they can be
+ * inserted again with Insert(kv, key_hash) without rehashing the key.
  */
 template <typename ValueType, typename Key, typename Value,
           typename KeyExtractor, typename ReduceFunction, typename Emitter,
@@ -90,6 +111,10 @@ public:
     using KeyValuePair = std::pair<Key, Value>;
     using ReduceConfig = ReduceConfig_;
 
+    //! whether the key hashes are stored and written to spilled files
+    static constexpr bool store_hash_ =
+        ReduceConfig::store_hash_ && IndexFunction::has_key_hash;
+
     ReduceProbingHashTable(
         Context& ctx, size_t dia_id,
         const KeyExtractor& key_extractor,
@@ -123,7 +148,7 @@ public:
         num_buckets_per_partition_ = std::max<size_t>(
             1,
             (size_t)(static_cast<double>(limit_memory_bytes_)
-                     / static_cast<double>(sizeof(KeyValuePair))
+                     / static_cast<double>(slot_size_)
                      / static_cast<double>(num_partitions_)));
 
         num_buckets_ = num_buckets_per_partition_ * num_partitions_;
@@ -156,6 +181,23 @@ public:
         items_ = static_cast<KeyValuePair*>(
             operator new ((num_buckets_ + 1) * sizeof(KeyValuePair)));
 
+        // control bytes are padded by one group, such that group loads at the
+        // end of the last partition do not run beyond the array.
+        if (use_tags_)
+            tags_.resize(num_buckets_ + group_size_, 0);
+
+        // the + 1 is for the sentinel's hash.
+        if (store_hash_)
+            hashes_.resize(num_buckets_ + 1);
+
+        // string bytes of a partition may take as much memory as its slots
+        if (use_arena_) {
+            key_arenas_.resize(num_partitions_);
+            limit_arena_bytes_ = std::max(
+                num_buckets_per_partition_ * slot_size_,
+                4 * ReduceKeyArena::chunk_size);
+        }
+
         for (size_t id = 0; id < num_partitions_; ++id) {
             KeyValuePair* iter = items_ + id * num_buckets_per_partition_;
             KeyValuePair* pend = iter + partition_size_[id];
@@ -174,7 +216,13 @@ public:
      * inserts the pair via the Insert() function.
      */
     void Insert(const Value& p) {
-        Insert(std::make_pair(key_extractor_(p), p));
+        Insert(KeyValuePair(key_extractor_(p), p));
+    }
+
+    //! Inserts a value, which is moved into the key-value-pair.
+    void Insert(Value&& p) {
+        Key key = key_extractor_(p);
+        Insert(KeyValuePair(std::move(key), std::move(p)));
     }
 
     /*!
@@ -192,13 +240,52 @@ public:
      * \param kv Value to be inserted into the table.
      */
     void Insert(const KeyValuePair& kv) {
+        Insert(kv, store_hash_ ? index_function_.key_hash(kv.first) : 0);
+    }
+
+    //! Inserts a key-value-pair, which is moved into a new slot, and whose
+    //! value is passed as an rvalue to the reduce function.
+    void Insert(KeyValuePair&& kv) {
+        uint64_t key_hash =
+            store_hash_ ? index_function_.key_hash(kv.first) : 0;
+        Insert(std::move(kv), key_hash);
+    }
+
+    /*!
+     * Inserts a value into the table whose key_hash() was stored earlier. The
+     * hash is ignored unless store_hash_ is set.
+     *
+     * \param kv Value to be inserted into the table.
+     * \param key_hash hash of the key from IndexFunction::key_hash()
+     */
+    void Insert(const KeyValuePair& kv, uint64_t key_hash) {
+        InsertPair(kv, key_hash);
+    }
+
+    //! Inserts a key-value-pair with a stored key_hash(), which is moved.
+    void Insert(KeyValuePair&& kv, uint64_t key_hash) {
+        InsertPair(ReduceMoveItem(kv), key_hash);
+    }
+
+    /*!
+     * Insert implementation for lvalue and rvalue pairs. New pairs are copied
+     * or moved into their slot, and on a match the slot's value is moved into
+     * the reduce function, whose result is move-assigned back.
+     */
+    template <typename KV>
+    void InsertPair(KV&& kv, uint64_t key_hash) {
 
         while (mem::memory_exceeded && num_items_ != 0)
             SpillAnyPartition();
 
-        typename IndexFunction::Result h = index_function_(
-            kv.first, num_partitions_,
-            num_buckets_per_partition_, num_buckets_);
+        typename IndexFunction::Result h =
+            store_hash_
+            ? index_function_.from_key_hash(
+                key_hash, num_partitions_,
+                num_buckets_per_partition_, num_buckets_)
+            : index_function_(
+                kv.first, num_partitions_,
+                num_buckets_per_partition_, num_buckets_);
 
         assert(h.partition_id < num_partitions_);
 
@@ -208,11 +295,13 @@ public:
             KeyValuePair& sentinel = items_[num_buckets_];
             if (sentinel_partition_ == invalid_partition_) {
                 // first occurrence of sentinel key
-                new (&sentinel)KeyValuePair(kv);
+                new (&sentinel)KeyValuePair(std::forward<KV>(kv));
                 sentinel_partition_ = h.partition_id;
+                if (store_hash_) hashes_[num_buckets_] = key_hash;
             }
             else {
-                sentinel.second = reduce_function_(sentinel.second, kv.second);
+                sentinel.second = reduce_function_(
+                    std::move(sentinel.second), std::forward<KV>(kv).second);
             }
             ++items_per_partition_[h.partition_id];
             ++num_items_;
@@ -223,6 +312,9 @@ public:
             return;
         }
 
+        if (use_tags_)
+            return InsertTagged(std::forward<KV>(kv), key_hash, h);
+
         // calculate local index depending on the current subtable's size
         size_t local_index = h.local_index(partition_size_[h.partition_id]);
 
@@ -234,13 +326,15 @@ public:
 
         while (!equal_to_function_(iter->first, Key()))
         {
-            if (equal_to_function_(iter->first, kv.first))
+            if ((!store_hash_ || hashes_[iter - items_] == key_hash) &&
+                equal_to_function_(iter->first, kv.first))
             {
                 LOGC(debug_items)
                     << "match of key: " << kv.first
                     << " and " << iter->first << " ... reducing...";
 
-                iter->second = reduce_function_(iter->second, kv.second);
+                iter->second = reduce_function_(
+                    std::move(iter->second), std::forward<KV>(kv).second);
 
                 return;
             }
@@ -254,12 +348,13 @@ public:
             // flush partition and retry, if all slots are reserved
             if (iter == begin_iter) {
                 SpillPartition(h.partition_id);
-                return Insert(kv);
+                return InsertPair(std::forward<KV>(kv), key_hash);
             }
         }
 
         // insert new pair
-        *iter = kv;
+        StoreItem(*iter, std::forward<KV>(kv), h.partition_id);
+        if (store_hash_) hashes_[iter - items_] = key_hash;
 
         // increase counter for partition
         ++items_per_partition_[h.partition_id];
@@ -267,6 +362,90 @@ public:
 
         while (items_per_partition_[h.partition_id] > limit_items_per_partition_)
             SpillPartition(h.partition_id);
+
+        if (use_arena_ &&
+            key_arenas_[h.partition_id].reserved() > limit_arena_bytes_)
+            SpillPartition(h.partition_id);
+    }
+
+    /*!
+     * Insert variant for integral keys, which probes groups of control bytes
+     * for matching tags and empty slots. Linear probing guarantees that the
+     * key, if present, is located before the first empty slot, hence only tag
+     * matches before it are compared.
+     */
+    template <typename KV, typename IndexResult>
+    void InsertTagged(KV&& kv, uint64_t key_hash, const IndexResult& h) {
+
+        const size_t size = partition_size_[h.partition_id];
+        const uint8_t tag = KeyTag(kv.first);
+
+        KeyValuePair* pbegin = items_ + h.partition_id * num_buckets_per_partition_;
+        uint8_t* tbegin = tags_.data() + h.partition_id * num_buckets_per_partition_;
+
+        size_t slot = h.local_index(size);
+
+        for (size_t probed = 0; probed < size; ) {
+            // number of slots in this group before the partition's end
+            size_t n = size - slot;
+            if (n > group_size_) n = group_size_;
+            unsigned valid = (1u << n) - 1;
+
+            unsigned match, empty;
+            MatchGroup(tbegin + slot, tag, &match, &empty);
+            match &= valid, empty &= valid;
+
+            // ignore tag matches after the first empty slot
+            if (empty)
+                match &= (empty & (0u - empty)) - 1;
+
+            while (match) {
+                KeyValuePair* iter = pbegin + slot + common::ffs(match) - 1;
+                if ((!store_hash_ || hashes_[iter - items_] == key_hash) &&
+                    equal_to_function_(iter->first, kv.first))
+                {
+                    LOGC(debug_items)
+                        << "match of key: " << kv.first
+                        << " and " << iter->first << " ... reducing...";
+
+                    iter->second = reduce_function_(
+                        std::move(iter->second), std::forward<KV>(kv).second);
+
+                    return;
+                }
+                match &= match - 1;
+            }
+
+            if (empty) {
+                // insert new pair
+                size_t i = slot + common::ffs(empty) - 1;
+                StoreItem(pbegin[i], std::forward<KV>(kv), h.partition_id);
+                tbegin[i] = tag;
+                if (store_hash_) hashes_[pbegin + i - items_] = key_hash;
+
+                // increase counter for partition
+                ++items_per_partition_[h.partition_id];
+                ++num_items_;
+
+                while (items_per_partition_[h.partition_id] > limit_items_per_partition_)
+                    SpillPartition(h.partition_id);
+
+                if (use_arena_ &&
+                    key_arenas_[h.partition_id].reserved() > limit_arena_bytes_)
+                    SpillPartition(h.partition_id);
+
+                return;
+            }
+
+            probed += n, slot += n;
+
+            // wrap around if beyond the current partition
+            if (slot == size) slot = 0;
+        }
+
+        // flush partition and retry, if all slots are reserved
+        SpillPartition(h.partition_id);
+        return InsertPair(std::forward<KV>(kv), key_hash);
     }
 
     //! Deallocate items and memory
@@ -289,6 +468,10 @@ public:
         operator delete (items_);
         items_ = nullptr;
 
+        std::vector<uint8_t>().swap(tags_);
+        std::vector<uint64_t>().swap(hashes_);
+        std::vector<ReduceKeyArena>().swap(key_arenas_);
+
         Super::Dispose();
     }
 
@@ -335,6 +518,7 @@ public:
         data::File::Writer writer = partition_files_[partition_id].GetWriter();
 
         if (sentinel_partition_ == partition_id) {
+            if (store_hash_) writer.Put(hashes_[num_buckets_]);
             writer.Put(items_[num_buckets_]);
             items_[num_buckets_].~KeyValuePair();
             sentinel_partition_ = invalid_partition_;
@@ -345,11 +529,15 @@ public:
 
         for ( ; iter != pend; ++iter) {
             if (iter->first != Key()) {
+                if (store_hash_) writer.Put(hashes_[iter - items_]);
                 writer.Put(*iter);
                 *iter = KeyValuePair();
             }
         }
 
+        ClearTags(partition_id);
+        ClearArena(partition_id);
+
         // reset partition specific counter
         num_items_ -= items_per_partition_[partition_id];
         items_per_partition_[partition_id] = 0;
@@ -420,6 +608,9 @@ public:
         }
 
         if (consume) {
+            ClearTags(partition_id);
+            ClearArena(partition_id);
+
             // reset partition specific counter
             num_items_ -= items_per_partition_[partition_id];
             items_per_partition_[partition_id] = 0;
@@ -448,6 +639,81 @@ public:
     //! \}
 
 private:
+    //! use control bytes for integral keys
+    static constexpr bool use_tags_ = std::is_integral<Key>::value;
+
+    //! number of control bytes probed at once
+    static constexpr size_t group_size_ = 16;
+
+    //! bytes per slot: item, control byte, and hash
+    static constexpr size_t slot_size_ =
+        sizeof(KeyValuePair) + (use_tags_ ? 1 : 0)
+        + (store_hash_ ? sizeof(uint64_t) : 0);
+
+    //! calculate the seven bit tag of a key with the high bit set, such that
+    //! it differs from the empty control byte.
+    template <typename KeyType = Key>
+    static typename std::enable_if<
+        std::is_integral<KeyType>::value, uint8_t>::type
+    KeyTag(const KeyType& k) {
+        uint64_t x = static_cast<uint64_t>(k) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint8_t>(0x80 | (x >> 57));
+    }
+
+    //! control bytes are not used for other keys.
+    template <typename KeyType = Key>
+    static typename std::enable_if<
+        !std::is_integral<KeyType>::value, uint8_t>::type
+    KeyTag(const KeyType&) {
+        die("KeyTag() called for non-integral key");
+    }
+
+    //! compare a group of control bytes against tag and the empty byte, and
+    //! return the bit masks of matching slots.
+    static void MatchGroup(const uint8_t* group, uint8_t tag,
+                           unsigned* match, unsigned* empty) {
+#if defined(__SSE2__)
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        *match = static_cast<unsigned>(_mm_movemask_epi8(
+                                           _mm_cmpeq_epi8(g, _mm_set1_epi8(
+                                                              static_cast<char>(tag)))));
+        *empty = static_cast<unsigned>(_mm_movemask_epi8(
+                                           _mm_cmpeq_epi8(g, _mm_setzero_si128())));
+#else
+        *match = *empty = 0;
+        for (size_t i = 0; i < group_size_; ++i) {
+            *match |= unsigned(group[i] == tag) << i;
+            *empty |= unsigned(group[i] == 0) << i;
+        }
+#endif
+    }
+
+    //! store FastStrings of new items in per-partition arenas
+    static constexpr bool use_arena_ =
+        ReduceKeyArenaStore<KeyValuePair>::enabled;
+
+    //! assign or move a new item to its slot, with string bytes in the arena.
+    template <typename KV>
+    void StoreItem(KeyValuePair& slot, KV&& kv, size_t partition_id) {
+        if (use_arena_)
+            ReduceKeyArenaStore<KeyValuePair>::Assign(
+                slot, kv, key_arenas_[partition_id]);
+        else
+            slot = std::forward<KV>(kv);
+    }
+
+    //! drop the string bytes of a partition whose items were removed
+    void ClearArena(size_t partition_id) {
+        if (use_arena_) key_arenas_[partition_id].Clear();
+    }
+
+    //! reset the control bytes of a partition to empty
+    void ClearTags(size_t partition_id) {
+        if (!use_tags_) return;
+        uint8_t* tbegin = tags_.data() + partition_id * num_buckets_per_partition_;
+        std::fill(tbegin, tbegin + partition_size_[partition_id], 0);
+    }
+
     using Super::config_;
     using Super::equal_to_function_;
     using Super::immediate_flush_;
@@ -466,9 +732,21 @@ private:
     //! Storing the actual hash table.
     KeyValuePair* items_ = nullptr;
 
+    //! Control bytes of the slots, only used for integral keys.
+    std::vector<uint8_t> tags_;
+
+    //! Key hashes of the slots and the sentinel, only used if store_hash_.
+    std::vector<uint64_t> hashes_;
+
     //! Current sizes of the partitions because the valid allocated areas grow
     std::vector<size_t> partition_size_;
 
+    //! String bytes of the items of each partition, only used if use_arena_.
+    std::vector<ReduceKeyArena> key_arenas_;
+
+    //! limit of the arena of a partition before it is spilled
+    size_t limit_arena_bytes_ = 0;
+
     //! sentinel for invalid partition or no sentinel.
     static constexpr size_t invalid_partition_ = size_t(-1);
 
@@ -0,0 +1,485 @@
+/*******************************************************************************
+ * thrill/core/reduce_robin_hood_hash_table.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_ROBIN_HOOD_HASH_TABLE_HEADER
+#define THRILL_CORE_REDUCE_ROBIN_HOOD_HASH_TABLE_HEADER
+
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_key_arena.hpp>
+#include <thrill/core/reduce_table.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A linear probing hash table using Robin Hood hashing: each slot stores the
+ * probe distance of its item to the item's home slot, and an insertion takes
+ * the slot of any item which is closer to its home than the inserted one,
+ * which then continues probing. This keeps the variance of probe distances
+ * low, and a lookup can stop as soon as it reaches an item closer to its home
+ * than the current distance, hence unsuccessful lookups are short even at high
+ * fill rates. Partitions can therefore be filled to 90% and more, see
+ * limit_partition_fill_rate_, which results in fewer spills for the same
+ * memory.
+ *
+ * The probe distance is bounded by max_probe_length_. If an insertion would
+ * exceed it, the partition is spilled. Since the probe distances are kept
+ * separately, all keys including Key() can be stored. Items are never removed
+ * individually, only whole partitions are spilled or flushed.
+ *
+ * The layout of partitions follows ReduceOldProbingHashTable, probing wraps
+ * around inside a partition.
+ */
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool VolatileKey,
+          typename ReduceConfig_,
+          typename IndexFunction,
+          typename EqualToFunction = std::equal_to<Key> >
+class ReduceRobinHoodHashTable
+    : public ReduceTable<ValueType, Key, Value,
+                         KeyExtractor, ReduceFunction, Emitter,
+                         VolatileKey, ReduceConfig_,
+                         IndexFunction, EqualToFunction>
+{
+    using Super = ReduceTable<ValueType, Key, Value,
+                              KeyExtractor, ReduceFunction, Emitter,
+                              VolatileKey, ReduceConfig_, IndexFunction,
+                              EqualToFunction>;
+    using Super::debug;
+    static constexpr bool debug_items = false;
+
+public:
+    using KeyValuePair = std::pair<Key, Value>;
+    using ReduceConfig = ReduceConfig_;
+
+    //! this table does not store key hashes
+    static constexpr bool store_hash_ = false;
+
+    //! type of the probe distances, zero marks an empty slot, one an item in
+    //! its home slot.
+    using Distance = uint8_t;
+
+    //! upper bound on max_probe_length_ due to the type of Distance
+    static constexpr size_t max_distance_ =
+        std::numeric_limits<Distance>::max();
+
+    ReduceRobinHoodHashTable(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        Emitter& emitter,
+        size_t num_partitions,
+        const ReduceConfig& config = ReduceConfig(),
+        bool immediate_flush = false,
+        const IndexFunction& index_function = IndexFunction(),
+        const EqualToFunction& equal_to_function = EqualToFunction())
+        : Super(ctx, dia_id,
+                key_extractor, reduce_function, emitter,
+                num_partitions, config, immediate_flush,
+                index_function, equal_to_function) {
+
+        assert(num_partitions > 0);
+    }
+
+    //! Construct the hash table itself and the array of probe distances.
+    void Initialize(size_t limit_memory_bytes) {
+
+        limit_memory_bytes_ = limit_memory_bytes;
+
+        // calculate num_buckets_per_partition_ from the memory limit and the
+        // number of partitions required
+
+        num_buckets_per_partition_ = std::max<size_t>(
+            1,
+            (size_t)(static_cast<double>(limit_memory_bytes_)
+                     / static_cast<double>(sizeof(KeyValuePair)
+                                           + sizeof(Distance))
+                     / static_cast<double>(num_partitions_)));
+
+        num_buckets_ = num_buckets_per_partition_ * num_partitions_;
+
+        assert(num_buckets_per_partition_ > 0);
+        assert(num_buckets_ > 0);
+
+        // calculate limit on the number of items in a partition before these
+        // are spilled to disk or flushed to network.
+
+        double limit_fill_rate = config_.limit_partition_fill_rate();
+
+        assert(limit_fill_rate >= 0.0 && limit_fill_rate <= 1.0
+               && "limit_partition_fill_rate must be between 0.0 and 1.0. "
+               "with a fill rate of 0.0, items are immediately flushed.");
+
+        limit_items_per_partition_ = (size_t)(
+            static_cast<double>(num_buckets_per_partition_) * limit_fill_rate);
+
+        max_probe_length_ = std::min(
+            std::max<size_t>(config_.max_probe_length(), 1), max_distance_);
+
+        // actually allocate the table
+
+        items_.resize(num_buckets_);
+        distance_.resize(num_buckets_, 0);
+    }
+
+    /*!
+     * Inserts a value. Calls the key_extractor_, makes a key-value-pair and
+     * inserts the pair via the Insert() function.
+     */
+    void Insert(const Value& p) {
+        Insert(KeyValuePair(key_extractor_(p), p));
+    }
+
+    //! Inserts a value, which is moved into the key-value-pair.
+    void Insert(Value&& p) {
+        Key key = key_extractor_(p);
+        Insert(KeyValuePair(std::move(key), std::move(p)));
+    }
+
+    /*!
+     * Inserts a value into the table, potentially reducing it in case both the
+     * key of the value already in the table and the key of the value to be
+     * inserted are the same.
+     *
+     * An insert may trigger a spill of the partition if the maximal number of
+     * items in the partition or the maximum probe length is reached.
+     *
+     * \param kv Value to be inserted into the table.
+     */
+    void Insert(const KeyValuePair& kv) {
+        InsertPair(kv);
+    }
+
+    //! Inserts a key-value-pair, which is moved into a new slot, and whose
+    //! value is passed as an rvalue to the reduce function.
+    void Insert(KeyValuePair&& kv) {
+        InsertPair(ReduceMoveItem(kv));
+    }
+
+    //! Inserts a value whose key hash was stored earlier, this table ignores
+    //! the hash.
+    void Insert(const KeyValuePair& kv, uint64_t /* key_hash */) {
+        InsertPair(kv);
+    }
+
+    //! Inserts a moved value whose key hash was stored earlier, this table
+    //! ignores the hash.
+    void Insert(KeyValuePair&& kv, uint64_t /* key_hash */) {
+        InsertPair(ReduceMoveItem(kv));
+    }
+
+    //! Insert implementation for lvalue and rvalue pairs.
+    template <typename KV>
+    void InsertPair(KV&& kv) {
+
+        while (mem::memory_exceeded && num_items_ != 0)
+            SpillAnyPartition();
+
+        typename IndexFunction::Result h = index_function_(
+            kv.first, num_partitions_,
+            num_buckets_per_partition_, num_buckets_);
+
+        assert(h.partition_id < num_partitions_);
+
+        const size_t partition_id = h.partition_id;
+        const size_t begin = partition_id * num_buckets_per_partition_;
+
+        size_t local_index = h.local_index(num_buckets_per_partition_);
+        size_t dist = 1;
+
+        // search the key, all items probed before are at least as far from
+        // their home slot as the key would be.
+        while (distance_[begin + local_index] >= dist)
+        {
+            size_t i = begin + local_index;
+
+            if (distance_[i] == dist &&
+                equal_to_function_(items_[i].first, kv.first))
+            {
+                LOGC(debug_items)
+                    << "match of key: " << kv.first
+                    << " and " << items_[i].first << " ... reducing...";
+
+                items_[i].second = reduce_function_(
+                    std::move(items_[i].second), std::forward<KV>(kv).second);
+
+                return;
+            }
+
+            if (++local_index == num_buckets_per_partition_)
+                local_index = 0;
+
+            if (++dist > max_probe_length_) {
+                // the key is not in the partition, and cannot be inserted
+                // within the probe length bound.
+                SpillPartition(partition_id);
+                return PlaceNew(std::forward<KV>(kv), partition_id,
+                                h.local_index(num_buckets_per_partition_));
+            }
+        }
+
+        // insert new pair, displacing items which are closer to their home.
+        KeyValuePair item = std::forward<KV>(kv);
+
+        while (distance_[begin + local_index] != 0)
+        {
+            size_t i = begin + local_index;
+
+            if (distance_[i] < dist) {
+                using std::swap;
+                swap(items_[i], item);
+                size_t d = distance_[i];
+                distance_[i] = static_cast<Distance>(dist);
+                dist = d;
+            }
+
+            if (++local_index == num_buckets_per_partition_)
+                local_index = 0;
+
+            if (++dist > max_probe_length_) {
+                // the displaced item cannot be placed: spill the partition,
+                // which now contains the new pair, and place the displaced
+                // item into its home slot. The number of items is unchanged.
+                size_t home =
+                    (local_index + num_buckets_per_partition_
+                     - (dist - 1) % num_buckets_per_partition_)
+                    % num_buckets_per_partition_;
+
+                SpillPartition(partition_id);
+                return PlaceNew(std::move(item), partition_id, home);
+            }
+        }
+
+        items_[begin + local_index] = std::move(item);
+        distance_[begin + local_index] = static_cast<Distance>(dist);
+
+        // increase counter for partition
+        ++items_per_partition_[partition_id];
+        ++num_items_;
+
+        while (items_per_partition_[partition_id] > limit_items_per_partition_)
+            SpillPartition(partition_id);
+    }
+
+    //! Deallocate memory
+    void Dispose() {
+        std::vector<KeyValuePair>().swap(items_);
+        std::vector<Distance>().swap(distance_);
+        Super::Dispose();
+    }
+
+    //! \name Spilling Mechanisms to External Memory Files
+    //! \{
+
+    //! Spill all items of a partition into an external memory File.
+    void SpillPartition(size_t partition_id) {
+
+        if (immediate_flush_)
+            return FlushPartition(partition_id, true);
+
+        LOG << "Spilling " << items_per_partition_[partition_id]
+            << " items of partition with id: " << partition_id;
+
+        if (items_per_partition_[partition_id] == 0)
+            return;
+
+        data::File::Writer writer = partition_files_[partition_id].GetWriter();
+
+        const size_t begin = partition_id * num_buckets_per_partition_;
+        const size_t end = begin + num_buckets_per_partition_;
+
+        for (size_t i = begin; i != end; ++i)
+        {
+            if (distance_[i] != 0)
+            {
+                writer.Put(items_[i]);
+                items_[i] = KeyValuePair();
+                distance_[i] = 0;
+            }
+        }
+
+        // reset partition specific counter
+        num_items_ -= items_per_partition_[partition_id];
+        items_per_partition_[partition_id] = 0;
+        assert(num_items_ == this->num_items_calc());
+
+        LOG << "Spilled items of partition with id: " << partition_id;
+    }
+
+    //! Spill all items of an arbitrary partition into an external memory File.
+    void SpillAnyPartition() {
+        return SpillLargestPartition();
+    }
+
+    //! Spill all items of the largest partition into an external memory File.
+    void SpillLargestPartition() {
+        // get partition with max size
+        size_t size_max = 0, index = 0;
+
+        for (size_t i = 0; i < num_partitions_; ++i)
+        {
+            if (items_per_partition_[i] > size_max)
+            {
+                size_max = items_per_partition_[i];
+                index = i;
+            }
+        }
+
+        if (size_max == 0) {
+            return;
+        }
+
+        return SpillPartition(index);
+    }
+
+    //! \}
+
+    //! \name Flushing Mechanisms to Next Stage
+    //! \{
+
+    //! Emit all items of a partition. Items are kept ordered by their home slot
+    //! by Robin Hood hashing, hence the scan starts at a slot which is empty or
+    //! holds an item at home, such that clusters wrapping around the end of the
+    //! partition are emitted in order.
+    template <typename Emit>
+    void FlushPartitionEmit(size_t partition_id, bool consume, Emit emit) {
+
+        LOG << "Flushing " << items_per_partition_[partition_id]
+            << " items of partition: " << partition_id;
+
+        const size_t begin = partition_id * num_buckets_per_partition_;
+
+        size_t start = 0;
+        while (start != num_buckets_per_partition_ &&
+               distance_[begin + start] > 1)
+            ++start;
+        if (start == num_buckets_per_partition_)
+            start = 0;
+
+        for (size_t n = 0; n != num_buckets_per_partition_; ++n)
+        {
+            size_t i = begin + (start + n) % num_buckets_per_partition_;
+
+            if (distance_[i] != 0) {
+                emit(partition_id, items_[i]);
+
+                if (consume) {
+                    items_[i] = KeyValuePair();
+                    distance_[i] = 0;
+                }
+            }
+        }
+
+        if (consume) {
+            // reset partition specific counter
+            num_items_ -= items_per_partition_[partition_id];
+            items_per_partition_[partition_id] = 0;
+            assert(num_items_ == this->num_items_calc());
+        }
+
+        LOG << "Done flushed items of partition: " << partition_id;
+    }
+
+    void FlushPartition(size_t partition_id, bool consume) {
+        FlushPartitionEmit(
+            partition_id, consume,
+            [this](const size_t& partition_id, const KeyValuePair& p) {
+                this->emitter_.Emit(partition_id, p);
+            });
+    }
+
+    void FlushAll() {
+        for (size_t i = 0; i < num_partitions_; ++i) {
+            FlushPartition(i, true);
+        }
+    }
+
+    //! \}
+
+    //! \name Accessors
+    //! \{
+
+    //! Returns max_probe_length_
+    size_t max_probe_length() const { return max_probe_length_; }
+
+    //! \}
+
+private:
+    using Super::config_;
+    using Super::equal_to_function_;
+    using Super::immediate_flush_;
+    using Super::index_function_;
+    using Super::items_per_partition_;
+    using Super::key_extractor_;
+    using Super::limit_items_per_partition_;
+    using Super::limit_memory_bytes_;
+    using Super::num_buckets_;
+    using Super::num_buckets_per_partition_;
+    using Super::num_items_;
+    using Super::num_partitions_;
+    using Super::partition_files_;
+    using Super::reduce_function_;
+
+    //! Storing the actual hash table.
+    std::vector<KeyValuePair> items_;
+
+    //! probe distance plus one of each slot, zero for empty slots.
+    std::vector<Distance> distance_;
+
+    //! maximum probe distance before the partition is spilled
+    size_t max_probe_length_ = max_distance_;
+
+    //! place a new item into the home slot of a partition after it was spilled
+    template <typename KV>
+    void PlaceNew(KV&& kv, size_t partition_id, size_t local_index) {
+        size_t i = partition_id * num_buckets_per_partition_ + local_index;
+        assert(distance_[i] == 0);
+
+        items_[i] = std::forward<KV>(kv);
+        distance_[i] = 1;
+
+        ++items_per_partition_[partition_id];
+        ++num_items_;
+
+        while (items_per_partition_[partition_id] > limit_items_per_partition_)
+            SpillPartition(partition_id);
+    }
+};
+
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          typename Emitter, const bool VolatileKey,
+          typename ReduceConfig, typename IndexFunction,
+          typename EqualToFunction>
+class ReduceTableSelect<
+        ReduceTableImpl::ROBIN_HOOD,
+        ValueType, Key, Value, KeyExtractor, ReduceFunction,
+        Emitter, VolatileKey, ReduceConfig, IndexFunction, EqualToFunction>
+{
+public:
+    using type = ReduceRobinHoodHashTable<
+              ValueType, Key, Value, KeyExtractor, ReduceFunction,
+              Emitter, VolatileKey, ReduceConfig,
+              IndexFunction, EqualToFunction>;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_ROBIN_HOOD_HASH_TABLE_HEADER
+
+/******************************************************************************/
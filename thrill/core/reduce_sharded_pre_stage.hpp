@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * thrill/core/reduce_sharded_pre_stage.hpp
+ *
+ * Reduce pre stage with thread-private hash tables, such that several threads
+ * of one worker can insert items concurrently.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_SHARDED_PRE_STAGE_HEADER
+#define THRILL_CORE_REDUCE_SHARDED_PRE_STAGE_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/work_stealing_pool.hpp>
+#include <thrill/core/reduce_pre_stage.hpp>
+
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+//! ReducePreStageEmitter which serializes concurrent spills of several tables
+//! into the same output with one mutex per output.
+template <typename KeyValuePair, bool VolatileKey>
+class ReduceShardedPreStageEmitter
+    : public ReducePreStageEmitter<KeyValuePair, VolatileKey>
+{
+    using Super = ReducePreStageEmitter<KeyValuePair, VolatileKey>;
+
+public:
+    ReduceShardedPreStageEmitter(std::vector<data::DynBlockWriter>& writer,
+                                 size_t partitions_per_output)
+        : Super(writer, partitions_per_output),
+          mutex_(new std::mutex[writer.size()]) { }
+
+    //! output an element into a partition, locks the output's writer
+    void Emit(const size_t& partition_id, const KeyValuePair& p) {
+        std::unique_lock<std::mutex> lock(
+            mutex_[partition_id / Super::partitions_per_output()]);
+        Super::Emit(partition_id, p);
+    }
+
+private:
+    //! one mutex per output writer
+    std::unique_ptr<std::mutex[]> mutex_;
+};
+
+/*!
+ * ReduceShardedPreStage lets several threads of one worker feed a reduce pre
+ * stage. Each thread inserts into its own shard, which is a complete reduce
+ * table with the partitions of a ReducePreStage and a share of the memory
+ * limit, hence inserts need no synchronization. Only spills of full
+ * partitions lock the output writer, since they are sent immediately as in
+ * the ReducePreStage.
+ *
+ * FlushAll() merges the partitions of all shards into the first one before
+ * flushing it, hence each output receives its partitions in order and every
+ * key at most once from the tables' final contents, as with a ReducePreStage.
+ *
+ * Insert(shard, item) may be called concurrently with different shards, or
+ * InsertParallel() splits a range of items among the shards and inserts them
+ * using a WorkStealingPool. The adaptive bypass and hot key detection of the
+ * ReducePreStage are not available.
+ */
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          const bool VolatileKey,
+          typename ReduceConfig_ = DefaultReduceConfig,
+          typename IndexFunction = ReduceByHash<Key>,
+          typename EqualToFunction = std::equal_to<Key> >
+class ReduceShardedPreStage
+{
+    static constexpr bool debug = false;
+
+public:
+    using KeyValuePair = std::pair<Key, Value>;
+    using ReduceConfig = ReduceConfig_;
+
+    using Emitter = ReduceShardedPreStageEmitter<KeyValuePair, VolatileKey>;
+
+    using Table = typename ReduceTableSelect<
+              ReduceConfig::table_impl_,
+              ValueType, Key, Value,
+              KeyExtractor, ReduceFunction, Emitter,
+              VolatileKey, ReduceConfig, IndexFunction, EqualToFunction>::type;
+
+    ReduceShardedPreStage(
+        Context& ctx, size_t dia_id,
+        size_t num_shards, size_t num_partitions,
+        KeyExtractor key_extractor,
+        ReduceFunction reduce_function,
+        std::vector<data::DynBlockWriter>& emit,
+        const ReduceConfig& config = ReduceConfig(),
+        const IndexFunction& index_function = IndexFunction(),
+        const EqualToFunction& equal_to_function = EqualToFunction())
+        : emit_(emit, Emitter::PartitionsPerOutput(
+                    config.min_pre_partitions(), num_partitions)) {
+
+        assert(num_shards > 0);
+        assert(num_partitions == emit.size());
+
+        for (size_t s = 0; s < num_shards; ++s) {
+            shards_.emplace_back(
+                std::make_unique<Table>(
+                    ctx, dia_id,
+                    key_extractor, reduce_function, emit_,
+                    emit_.num_partitions(), config, /* immediate_flush */ true,
+                    index_function, equal_to_function));
+        }
+
+        sLOG << "creating ReduceShardedPreStage with" << num_shards
+             << "shards and" << emit.size() << "output emitters";
+    }
+
+    //! non-copyable: delete copy-constructor
+    ReduceShardedPreStage(const ReduceShardedPreStage&) = delete;
+    //! non-copyable: delete assignment operator
+    ReduceShardedPreStage& operator = (const ReduceShardedPreStage&) = delete;
+
+    //! Initialize the shards, each with an equal share of the memory limit.
+    void Initialize(size_t limit_memory_bytes) {
+        for (std::unique_ptr<Table>& t : shards_)
+            t->Initialize(limit_memory_bytes / shards_.size());
+    }
+
+    //! Insert an item into a shard. Different shards may be used concurrently.
+    void Insert(size_t shard, const Value& p) {
+        assert(shard < shards_.size());
+        shards_[shard]->Insert(p);
+    }
+
+    //! Insert a pair into a shard. Different shards may be used concurrently.
+    void Insert(size_t shard, const KeyValuePair& kv) {
+        assert(shard < shards_.size());
+        shards_[shard]->Insert(kv);
+    }
+
+    //! Insert an item into a shard, which is moved into the table.
+    void Insert(size_t shard, Value&& p) {
+        assert(shard < shards_.size());
+        shards_[shard]->Insert(std::move(p));
+    }
+
+    //! Insert a pair into a shard, which is moved into the table.
+    void Insert(size_t shard, KeyValuePair&& kv) {
+        assert(shard < shards_.size());
+        shards_[shard]->Insert(std::move(kv));
+    }
+
+    //! Insert all items of the random access range [begin,end), which is
+    //! split evenly among the shards, using the pool's threads.
+    template <typename Iterator>
+    void InsertParallel(common::WorkStealingPool& pool,
+                        Iterator begin, Iterator end) {
+        const size_t size = static_cast<size_t>(std::distance(begin, end));
+        const size_t num_shards = shards_.size();
+
+        pool.ParallelFor(
+            0, num_shards, 1,
+            [this, begin, size, num_shards](size_t s) {
+                Iterator it = begin + s * size / num_shards;
+                Iterator it_end = begin + (s + 1) * size / num_shards;
+                for ( ; it != it_end; ++it)
+                    shards_[s]->Insert(*it);
+            });
+    }
+
+    //! Merge all shards into the first one and flush all its partitions. Must
+    //! not be called concurrently with inserts.
+    void FlushAll() {
+        Table& first = *shards_[0];
+
+        for (size_t s = 1; s < shards_.size(); ++s) {
+            Table& shard = *shards_[s];
+            for (size_t id = 0; id < shard.num_partitions(); ++id) {
+                shard.FlushPartitionEmit(
+                    id, /* consume */ true,
+                    [&first](const size_t& /* partition_id */,
+                             const KeyValuePair& kv) {
+                        first.Insert(kv);
+                    });
+            }
+            shard.Dispose();
+        }
+
+        const size_t k = emit_.partitions_per_output();
+        for (size_t output = 0; output < emit_.writer_.size(); ++output) {
+            for (size_t id = output * k; id < (output + 1) * k; ++id)
+                first.FlushPartition(id, /* consume */ true);
+
+            // flush elements pushed into emitter
+            emit_.Flush(output);
+        }
+    }
+
+    //! Closes all emitter
+    void CloseAll() {
+        emit_.CloseAll();
+        for (std::unique_ptr<Table>& t : shards_)
+            t->Dispose();
+    }
+
+    //! \name Accessors
+    //! \{
+
+    //! Returns the number of shards.
+    size_t num_shards() const { return shards_.size(); }
+
+    //! Returns the total num of items in all shards.
+    size_t num_items() const {
+        size_t sum = 0;
+        for (const std::unique_ptr<Table>& t : shards_)
+            sum += t->num_items();
+        return sum;
+    }
+
+    //! calculate key range for the given output, which is the union of the
+    //! ranges of its consecutive partitions.
+    common::Range key_range(size_t output) {
+        const size_t k = emit_.partitions_per_output();
+        return common::Range(shards_[0]->key_range(output * k).begin,
+                             shards_[0]->key_range((output + 1) * k - 1).end);
+    }
+
+    //! \}
+
+private:
+    //! Emitters used to parameterize the hash tables for output to network.
+    Emitter emit_;
+
+    //! thread-private hash tables
+    std::vector<std::unique_ptr<Table> > shards_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_SHARDED_PRE_STAGE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,549 @@
+/*******************************************************************************
+ * thrill/core/reduce_sort_table.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_SORT_TABLE_HEADER
+#define THRILL_CORE_REDUCE_SORT_TABLE_HEADER
+
+#include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_key_arena.hpp>
+#include <thrill/core/reduce_table.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A sort-based reduce table for very large numbers of distinct keys. Instead
+ * of hashing, each partition appends items to a buffer. When the buffer is
+ * full, it is sorted by a sort key and items with equal keys are combined. If
+ * the partition is still fuller than limit_partition_fill_rate_ afterwards, it
+ * is spilled as a sorted run appended to the partition's File.
+ *
+ * The sort key is the key hash for ReduceByHash, and the key itself for
+ * ReduceByIndex, such that partitions are emitted in index order. Keys with
+ * colliding hashes are told apart by the EqualToFunction.
+ *
+ * A spilled partition is fully reduced by MergePartitionEmit(), which merges
+ * its runs and combines equal keys once more, hence every item is written to
+ * and read from external memory at most once. A partition File which is read
+ * as a whole contains partially reduced items, hence the generic re-reduce
+ * paths of the post-stages also work with this table.
+ */
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool VolatileKey,
+          typename ReduceConfig_,
+          typename IndexFunction,
+          typename EqualToFunction = std::equal_to<Key> >
+class ReduceSortTable
+    : public ReduceTable<ValueType, Key, Value,
+                         KeyExtractor, ReduceFunction, Emitter,
+                         VolatileKey, ReduceConfig_,
+                         IndexFunction, EqualToFunction>
+{
+    using Super = ReduceTable<ValueType, Key, Value,
+                              KeyExtractor, ReduceFunction, Emitter,
+                              VolatileKey, ReduceConfig_, IndexFunction,
+                              EqualToFunction>;
+    using Super::debug;
+    static constexpr bool debug_items = false;
+
+public:
+    using KeyValuePair = std::pair<Key, Value>;
+    using ReduceConfig = ReduceConfig_;
+
+    //! this table does not store key hashes, they are recalculated from the
+    //! keys when merging runs.
+    static constexpr bool store_hash_ = false;
+
+    //! spilled partitions consist of sorted runs, which are merged by
+    //! MergePartitionEmit().
+    static constexpr bool sorted_runs_ = true;
+
+    //! an item in a partition buffer with its sort key
+    struct Entry {
+        uint64_t     sort_key;
+        KeyValuePair kv;
+    };
+
+    ReduceSortTable(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        Emitter& emitter,
+        size_t num_partitions,
+        const ReduceConfig& config = ReduceConfig(),
+        bool immediate_flush = false,
+        const IndexFunction& index_function = IndexFunction(),
+        const EqualToFunction& equal_to_function = EqualToFunction())
+        : Super(ctx, dia_id,
+                key_extractor, reduce_function, emitter,
+                num_partitions, config, immediate_flush,
+                index_function, equal_to_function),
+          run_begin_(num_partitions) {
+
+        assert(num_partitions > 0);
+    }
+
+    //! Allocate the partition buffers.
+    void Initialize(size_t limit_memory_bytes) {
+
+        limit_memory_bytes_ = limit_memory_bytes;
+
+        // calculate num_buckets_per_partition_, the capacity of each buffer,
+        // from the memory limit and the number of partitions required
+
+        num_buckets_per_partition_ = std::max<size_t>(
+            1,
+            (size_t)(static_cast<double>(limit_memory_bytes_)
+                     / static_cast<double>(sizeof(Entry))
+                     / static_cast<double>(num_partitions_)));
+
+        num_buckets_ = num_buckets_per_partition_ * num_partitions_;
+
+        assert(num_buckets_per_partition_ > 0);
+        assert(num_buckets_ > 0);
+
+        // calculate limit on the number of combined items in a partition
+        // before these are spilled to disk or flushed to network.
+
+        double limit_fill_rate = config_.limit_partition_fill_rate();
+
+        assert(limit_fill_rate >= 0.0 && limit_fill_rate <= 1.0
+               && "limit_partition_fill_rate must be between 0.0 and 1.0. "
+               "with a fill rate of 0.0, items are immediately flushed.");
+
+        limit_items_per_partition_ = (size_t)(
+            static_cast<double>(num_buckets_per_partition_) * limit_fill_rate);
+
+        // actually allocate the buffers
+
+        items_.resize(num_partitions_);
+        for (std::vector<Entry>& items : items_)
+            items.reserve(num_buckets_per_partition_);
+    }
+
+    /*!
+     * Inserts a value. Calls the key_extractor_, makes a key-value-pair and
+     * inserts the pair via the Insert() function.
+     */
+    void Insert(const Value& p) {
+        Insert(KeyValuePair(key_extractor_(p), p));
+    }
+
+    //! Inserts a value, which is moved into the key-value-pair.
+    void Insert(Value&& p) {
+        Key key = key_extractor_(p);
+        Insert(KeyValuePair(std::move(key), std::move(p)));
+    }
+
+    /*!
+     * Appends a value to the buffer of its partition. If the buffer is full,
+     * its items are sorted and combined, and the partition is spilled if it
+     * still holds more than limit_items_per_partition_ items.
+     *
+     * \param kv Value to be inserted into the table.
+     */
+    void Insert(const KeyValuePair& kv) {
+        InsertPair(kv);
+    }
+
+    //! Appends a key-value-pair, which is moved into the buffer.
+    void Insert(KeyValuePair&& kv) {
+        InsertPair(ReduceMoveItem(kv));
+    }
+
+    //! Inserts a value whose key hash was stored earlier, this table ignores
+    //! the hash.
+    void Insert(const KeyValuePair& kv, uint64_t /* key_hash */) {
+        InsertPair(kv);
+    }
+
+    //! Inserts a moved value whose key hash was stored earlier, this table
+    //! ignores the hash.
+    void Insert(KeyValuePair&& kv, uint64_t /* key_hash */) {
+        InsertPair(ReduceMoveItem(kv));
+    }
+
+    //! Insert implementation for lvalue and rvalue pairs.
+    template <typename KV>
+    void InsertPair(KV&& kv) {
+
+        while (mem::memory_exceeded && num_items_ != 0)
+            SpillAnyPartition();
+
+        const uint64_t sort_key = SortKey(kv.first, HasKeyHash());
+        const size_t partition_id =
+            PartitionOf(kv.first, sort_key, HasKeyHash());
+
+        assert(partition_id < num_partitions_);
+
+        std::vector<Entry>& items = items_[partition_id];
+        items.emplace_back(Entry { sort_key, std::forward<KV>(kv) });
+
+        ++items_per_partition_[partition_id];
+        ++num_items_;
+
+        if (items.size() < num_buckets_per_partition_)
+            return;
+
+        CombinePartition(partition_id);
+
+        if (items_per_partition_[partition_id] > limit_items_per_partition_)
+            SpillPartition(partition_id);
+    }
+
+    //! Deallocate memory
+    void Dispose() {
+        std::vector<std::vector<Entry> >().swap(items_);
+        std::vector<std::vector<size_t> >().swap(run_begin_);
+        Super::Dispose();
+    }
+
+    //! \name Spilling Mechanisms to External Memory Files
+    //! \{
+
+    //! Sort and combine the items of a partition, and append them as a sorted
+    //! run to its external memory File.
+    void SpillPartition(size_t partition_id) {
+
+        if (immediate_flush_)
+            return FlushPartition(partition_id, true);
+
+        if (items_per_partition_[partition_id] == 0)
+            return;
+
+        CombinePartition(partition_id);
+
+        LOG << "Spilling " << items_per_partition_[partition_id]
+            << " items of partition with id: " << partition_id;
+
+        data::File& file = partition_files_[partition_id];
+
+        // the post-stages may have moved the File's items out
+        if (file.num_items() == 0)
+            run_begin_[partition_id].clear();
+        run_begin_[partition_id].push_back(file.num_items());
+
+        data::File::Writer writer = file.GetWriter();
+
+        std::vector<Entry>& items = items_[partition_id];
+        for (const Entry& e : items)
+            writer.Put(e.kv);
+        items.clear();
+
+        // reset partition specific counter
+        num_items_ -= items_per_partition_[partition_id];
+        items_per_partition_[partition_id] = 0;
+        assert(num_items_ == this->num_items_calc());
+
+        LOG << "Spilled items of partition with id: " << partition_id;
+    }
+
+    //! Spill all items of an arbitrary partition into an external memory File.
+    void SpillAnyPartition() {
+        return SpillLargestPartition();
+    }
+
+    //! Spill all items of the largest partition into an external memory File.
+    void SpillLargestPartition() {
+        // get partition with max size
+        size_t size_max = 0, index = 0;
+
+        for (size_t i = 0; i < num_partitions_; ++i)
+        {
+            if (items_per_partition_[i] > size_max)
+            {
+                size_max = items_per_partition_[i];
+                index = i;
+            }
+        }
+
+        if (size_max == 0) {
+            return;
+        }
+
+        return SpillPartition(index);
+    }
+
+    //! \}
+
+    //! \name Flushing Mechanisms to Next Stage
+    //! \{
+
+    //! Emit all items of a partition, combined and in the order of their sort
+    //! keys.
+    template <typename Emit>
+    void FlushPartitionEmit(size_t partition_id, bool consume, Emit emit) {
+
+        LOG << "Flushing " << items_per_partition_[partition_id]
+            << " items of partition: " << partition_id;
+
+        CombinePartition(partition_id);
+
+        std::vector<Entry>& items = items_[partition_id];
+        for (const Entry& e : items)
+            emit(partition_id, e.kv);
+
+        if (consume) {
+            items.clear();
+
+            // reset partition specific counter
+            num_items_ -= items_per_partition_[partition_id];
+            items_per_partition_[partition_id] = 0;
+            assert(num_items_ == this->num_items_calc());
+        }
+
+        LOG << "Done flushed items of partition: " << partition_id;
+    }
+
+    void FlushPartition(size_t partition_id, bool consume) {
+        FlushPartitionEmit(
+            partition_id, consume,
+            [this](const size_t& partition_id, const KeyValuePair& p) {
+                this->emitter_.Emit(partition_id, p);
+            });
+    }
+
+    void FlushAll() {
+        for (size_t i = 0; i < num_partitions_; ++i) {
+            FlushPartition(i, true);
+        }
+    }
+
+    /*!
+     * Emit the fully reduced items of a partition, which may have been
+     * spilled. The remaining items are spilled as the last run, and all runs
+     * are merged by their sort keys while combining equal keys. The partition
+     * is consumed.
+     */
+    template <typename Emit>
+    void MergePartitionEmit(size_t partition_id, Emit emit) {
+
+        data::File& file = partition_files_[partition_id];
+
+        if (file.num_items() == 0)
+            return FlushPartitionEmit(partition_id, /* consume */ true, emit);
+
+        SpillPartition(partition_id);
+
+        const std::vector<size_t>& run_begin = run_begin_[partition_id];
+
+        LOG << "Merging " << run_begin.size() << " runs with "
+            << file.num_items() << " items of partition: " << partition_id;
+
+        {
+            std::vector<RunReader> readers;
+            readers.reserve(run_begin.size());
+            for (size_t r = 0; r < run_begin.size(); ++r) {
+                size_t end = r + 1 < run_begin.size()
+                             ? run_begin[r + 1] : file.num_items();
+                readers.emplace_back(
+                    *this,
+                    file.template GetReaderAt<KeyValuePair>(run_begin[r]),
+                    end - run_begin[r]);
+            }
+
+            // stable, such that equal keys are reduced in the order of runs
+            auto puller = core::make_stable_multiway_merge_tree<Entry>(
+                readers.begin(), readers.end(),
+                [](const Entry& a, const Entry& b) {
+                    return a.sort_key < b.sort_key;
+                });
+
+            // combine items with equal sort key, which are adjacent
+            std::vector<Entry> group;
+            while (puller.HasNext()) {
+                Entry e = puller.Next();
+                if (!group.empty() && group.front().sort_key != e.sort_key) {
+                    for (const Entry& g : group)
+                        emit(partition_id, g.kv);
+                    group.clear();
+                }
+                CombineInto(group, std::move(e));
+            }
+            for (const Entry& g : group)
+                emit(partition_id, g.kv);
+        }
+
+        file.Clear();
+        run_begin_[partition_id].clear();
+
+        LOG << "Done merged runs of partition: " << partition_id;
+    }
+
+    //! \}
+
+private:
+    using Super::config_;
+    using Super::equal_to_function_;
+    using Super::immediate_flush_;
+    using Super::index_function_;
+    using Super::items_per_partition_;
+    using Super::key_extractor_;
+    using Super::limit_items_per_partition_;
+    using Super::limit_memory_bytes_;
+    using Super::num_buckets_;
+    using Super::num_buckets_per_partition_;
+    using Super::num_items_;
+    using Super::num_partitions_;
+    using Super::partition_files_;
+    using Super::reduce_function_;
+
+    using HasKeyHash = std::integral_constant<
+              bool, IndexFunction::has_key_hash>;
+
+    //! Reader of one sorted run in a partition File, which delivers the items
+    //! with their sort keys.
+    class RunReader
+    {
+    public:
+        RunReader(const ReduceSortTable& table,
+                  data::File::KeepReader&& reader, size_t num_items)
+            : table_(&table), reader_(std::move(reader)),
+              num_items_(num_items) { }
+
+        bool HasNext() { return num_items_ != 0; }
+
+        template <typename T>
+        T Next() {
+            assert(num_items_ != 0);
+            --num_items_;
+            KeyValuePair kv = reader_.template Next<KeyValuePair>();
+            uint64_t sort_key = table_->SortKey(kv.first, HasKeyHash());
+            return T { sort_key, std::move(kv) };
+        }
+
+    private:
+        const ReduceSortTable* table_;
+        data::File::KeepReader reader_;
+        size_t num_items_;
+    };
+
+    //! item buffers of the partitions
+    std::vector<std::vector<Entry> > items_;
+
+    //! start index of each sorted run in the partition Files
+    std::vector<std::vector<size_t> > run_begin_;
+
+    //! sort key of a key for ReduceByHash: its hash
+    uint64_t SortKey(const Key& k, std::true_type) const {
+        return index_function_.key_hash(k);
+    }
+
+    //! sort key of a key for ReduceByIndex: the index itself
+    uint64_t SortKey(const Key& k, std::false_type) const {
+        return static_cast<uint64_t>(k);
+    }
+
+    size_t PartitionOf(const Key& /* k */, uint64_t key_hash,
+                       std::true_type) const {
+        return index_function_.from_key_hash(
+            key_hash, num_partitions_,
+            num_buckets_per_partition_, num_buckets_).partition_id;
+    }
+
+    size_t PartitionOf(const Key& k, uint64_t /* sort_key */,
+                       std::false_type) const {
+        return index_function_(
+            k, num_partitions_,
+            num_buckets_per_partition_, num_buckets_).partition_id;
+    }
+
+    //! reduce an item into a group of items with equal sort key, or append it
+    //! if its key is not in the group.
+    void CombineInto(std::vector<Entry>& group, Entry&& e) {
+        for (Entry& g : group) {
+            if (equal_to_function_(g.kv.first, e.kv.first)) {
+                LOGC(debug_items)
+                    << "match of key: " << e.kv.first
+                    << " and " << g.kv.first << " ... reducing...";
+
+                g.kv.second = reduce_function_(
+                    std::move(g.kv.second), std::move(e.kv.second));
+                return;
+            }
+        }
+        group.emplace_back(std::move(e));
+    }
+
+    //! sort the buffer of a partition by sort key and combine equal keys
+    void CombinePartition(size_t partition_id) {
+
+        std::vector<Entry>& items = items_[partition_id];
+
+        // stable, such that equal keys are reduced in insertion order
+        std::stable_sort(items.begin(), items.end(),
+                         [](const Entry& a, const Entry& b) {
+                             return a.sort_key < b.sort_key;
+                         });
+
+        // compact in place, equal keys have equal sort keys and hence are in
+        // the group of adjacent items [group, out).
+        size_t out = 0;
+        for (size_t i = 0, group = 0; i < items.size(); ++i)
+        {
+            if (out != 0 && items[group].sort_key != items[i].sort_key)
+                group = out;
+
+            size_t j = group;
+            while (j < out && !equal_to_function_(items[j].kv.first,
+                                                  items[i].kv.first))
+                ++j;
+
+            if (j < out) {
+                items[j].kv.second = reduce_function_(
+                    std::move(items[j].kv.second),
+                    std::move(items[i].kv.second));
+            }
+            else {
+                if (out != i) items[out] = std::move(items[i]);
+                ++out;
+            }
+        }
+
+        size_t removed = items.size() - out;
+        items.erase(items.begin() + out, items.end());
+
+        num_items_ -= removed;
+        items_per_partition_[partition_id] -= removed;
+        assert(num_items_ == this->num_items_calc());
+    }
+};
+
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          typename Emitter, const bool VolatileKey,
+          typename ReduceConfig, typename IndexFunction,
+          typename EqualToFunction>
+class ReduceTableSelect<
+        ReduceTableImpl::SORT,
+        ValueType, Key, Value, KeyExtractor, ReduceFunction,
+        Emitter, VolatileKey, ReduceConfig, IndexFunction, EqualToFunction>
+{
+public:
+    using type = ReduceSortTable<
+              ValueType, Key, Value, KeyExtractor, ReduceFunction,
+              Emitter, VolatileKey, ReduceConfig,
+              IndexFunction, EqualToFunction>;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_SORT_TABLE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * thrill/core/reduce_steal_pool.hpp
+ *
+ * Pool of the spilled partitions of the reduce post stages of all workers on a
+ * host, from which idle workers steal partitions to re-reduce them.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_STEAL_POOL_HEADER
+#define THRILL_CORE_REDUCE_STEAL_POOL_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/data/file.hpp>
+
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Pool of the spilled partitions of the reduce post stages of all local
+ * workers, which share the BlockPool and hence can read each other's Files.
+ * Each worker publishes its partitions as tasks, and then claims them in
+ * order. Idle workers, which have no tasks left, steal pending tasks from the
+ * back of the worker with the most pending tasks. A stolen partition is
+ * re-reduced by the thief into an output File, which is handed back and
+ * emitted by the owner in place of the partition, hence the output items stay
+ * on the owning worker and in the same order.
+ *
+ * Input is the type of the tasks' input, e.g. the spilled File.
+ */
+template <typename Input>
+class ReduceStealPool
+{
+public:
+    explicit ReduceStealPool(size_t num_workers)
+        : workers_(num_workers) { }
+
+    //! non-copyable: delete copy-constructor
+    ReduceStealPool(const ReduceStealPool&) = delete;
+    //! non-copyable: delete assignment operator
+    ReduceStealPool& operator = (const ReduceStealPool&) = delete;
+
+    /*!
+     * Share a new pool among the local workers of the host, which must be
+     * called collectively by all of them. Returns nullptr if there is only one
+     * local worker.
+     */
+    static std::shared_ptr<ReduceStealPool> Share(Context& ctx) {
+        if (ctx.workers_per_host() == 1) return nullptr;
+
+        std::shared_ptr<const ReduceStealPool> pool;
+        if (ctx.local_worker_id() == 0)
+            pool = std::make_shared<ReduceStealPool>(ctx.workers_per_host());
+
+        // the pool synchronizes all accesses by its mutex.
+        return std::const_pointer_cast<ReduceStealPool>(
+            ctx.net.LocalBroadcast(pool));
+    }
+
+    /*!
+     * Publish the tasks of a worker, which each local worker must do exactly
+     * once, possibly without tasks. Only tasks flagged stealable may be taken
+     * by other workers.
+     */
+    void Publish(size_t worker, std::vector<Input>&& inputs,
+                 const std::vector<bool>& stealable) {
+        assert(inputs.size() == stealable.size());
+        std::unique_lock<std::mutex> lock(mutex_);
+        Worker& w = workers_[worker];
+        assert(!w.published);
+        w.inputs = std::move(inputs);
+        w.state.resize(w.inputs.size());
+        w.outputs.resize(w.inputs.size());
+        for (size_t i = 0; i < w.inputs.size(); ++i) {
+            w.state[i] = stealable[i] ? Pending : Private;
+            if (stealable[i]) ++w.pending;
+        }
+        w.published = true;
+        ++num_published_;
+        cv_.notify_all();
+    }
+
+    /*!
+     * Claim task index of the worker for itself. Returns nullptr if the owner
+     * got the task, whose input() it must then process. Otherwise the task was
+     * stolen, and the call waits for the thief and returns its output File.
+     */
+    data::FilePtr Claim(size_t worker, size_t index) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Worker& w = workers_[worker];
+        if (w.state[index] == Pending || w.state[index] == Private) {
+            if (w.state[index] == Pending) --w.pending;
+            w.state[index] = Owned;
+            return nullptr;
+        }
+        cv_.wait(lock, [&]() { return w.state[index] == Done; });
+        return std::move(w.outputs[index]);
+    }
+
+    /*!
+     * Steal the last pending task of the worker with the most pending tasks.
+     * Waits until all workers have published, and returns false if no
+     * stealable tasks remain.
+     */
+    bool Steal(size_t thief, size_t& victim, size_t& index) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            size_t best = workers_.size();
+            for (size_t v = 0; v < workers_.size(); ++v) {
+                if (v == thief || workers_[v].pending == 0) continue;
+                if (best == workers_.size() ||
+                    workers_[v].pending > workers_[best].pending)
+                    best = v;
+            }
+            if (best != workers_.size()) {
+                Worker& w = workers_[best];
+                size_t i = w.state.size();
+                while (w.state[--i] != Pending) { }
+                w.state[i] = Stolen;
+                --w.pending;
+                victim = best;
+                index = i;
+                return true;
+            }
+            if (num_published_ == workers_.size())
+                return false;
+            cv_.wait(lock);
+        }
+    }
+
+    //! Hand back the output File of a stolen task to its owner.
+    void Complete(size_t victim, size_t index, data::FilePtr output) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Worker& w = workers_[victim];
+        assert(w.state[index] == Stolen);
+        w.outputs[index] = std::move(output);
+        w.state[index] = Done;
+        cv_.notify_all();
+    }
+
+    //! Returns the input of a task, which only its owner or thief may access.
+    Input& input(size_t worker, size_t index) {
+        return workers_[worker].inputs[index];
+    }
+
+private:
+    //! states of a task
+    enum State { Private, Pending, Owned, Stolen, Done };
+
+    //! tasks of a worker
+    struct Worker {
+        //! whether the worker published its tasks
+        bool                       published = false;
+        //! number of pending stealable tasks
+        size_t                     pending = 0;
+        //! inputs of the tasks
+        std::vector<Input>         inputs;
+        //! states of the tasks
+        std::vector<State>         state;
+        //! output Files of stolen tasks
+        std::vector<data::FilePtr> outputs;
+    };
+
+    //! mutex protecting the states of all tasks
+    std::mutex mutex_;
+
+    //! signaled when tasks are published or completed
+    std::condition_variable cv_;
+
+    //! tasks of the local workers
+    std::vector<Worker> workers_;
+
+    //! number of workers which published their tasks
+    size_t num_published_ = 0;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_STEAL_POOL_HEADER
+
+/******************************************************************************/
@@ -27,7 +27,7 @@ namespace core {
 
 //! Enum class to select a hash table implementation.
 enum class ReduceTableImpl {
-    PROBING, OLD_PROBING, BUCKET
+    PROBING, OLD_PROBING, BUCKET, ROBIN_HOOD, SORT
 };
 
 /*!
@@ -46,16 +46,79 @@ public:
     //! relative to the maximum possible number.
     double bucket_rate_ = 0.6;
 
-    //! select the hash table in the reduce stage by enum
+    //! select the hash table in the reduce stage by enum, SORT reduces sorted
+    //! runs instead and suits key counts far beyond the memory limit.
     static constexpr ReduceTableImpl table_impl_ = ReduceTableImpl::PROBING;
 
     //! only for growing ProbingHashTable: items initially in a partition.
     static constexpr size_t initial_items_per_partition_ = 16;
 
+    //! only for RobinHoodHashTable: maximum probe distance of an item from its
+    //! home slot before the partition is spilled, at most 255.
+    size_t max_probe_length_ = 64;
+
     //! only for BucketHashTable: size of a block in the bucket chain in bytes
     //! (must be a static constexpr)
     static constexpr size_t bucket_block_size_ = 512;
 
+    //! only for ReducePreStage: minimum number of partitions of the table. If
+    //! there are fewer outputs, several consecutive partitions are mapped onto
+    //! each output, which makes spills finer. Set to one for one partition per
+    //! output.
+    size_t min_pre_partitions_ = 64;
+
+    //! only for ReducePreStage: if the fraction of new keys among the items
+    //! inserted during a probe window exceeds this rate, pre-reduction does not
+    //! pay and items are sent directly to the post stage. A rate of 1.0 or
+    //! more disables bypassing.
+    double bypass_new_key_rate_ = 0.9;
+
+    //! only for ReducePreStage: number of items in a probe or bypass window.
+    size_t bypass_window_size_ = 64 * 1024;
+
+    //! only for ReducePreStage: number of windows to bypass the table before
+    //! probing the reduction rate again.
+    size_t bypass_windows_ = 8;
+
+    //! only for ReducePreStage: number of initial items sampled to detect hot
+    //! keys, which are reduced on the side and combined globally. Zero
+    //! disables hot key detection.
+    size_t hot_key_sample_size_ = 0;
+
+    //! only for ReducePreStage: maximum number of hot keys tracked. Each
+    //! inserted item is compared against all hot keys.
+    size_t max_hot_keys_ = 16;
+
+    //! only for ReducePreStage: minimum fraction of the sampled items a key
+    //! must have to be considered hot.
+    double hot_key_rate_ = 0.01;
+
+    //! send the pre-reduced items to other hosts in pairwise phases after the
+    //! pre stage is flushed, instead of to all hosts at once. This avoids
+    //! incast in large clusters, but holds back all items until the end.
+    bool schedule_exchange_ = false;
+
+    //! only for the post stages of hash tables: let idle workers on the same
+    //! host re-reduce whole spilled partitions of busy ones, whose output is
+    //! handed back to the owner to keep its order. Off by default, since
+    //! sharing the partitions costs a host-local barrier in every PushData(),
+    //! also when nothing spilled.
+    bool steal_partitions_ = false;
+
+    //! only for ReduceByKey and ReducePair without the post thread: sketch the
+    //! keys sent to each worker with a HyperLogLog of 2^precision registers,
+    //! which is sent along with the items. The post stage then plans from the
+    //! estimated number of distinct keys whether to reduce in memory, or to
+    //! split the items into parts on disk right away. Zero disables it.
+    unsigned key_sketch_precision_ = 0;
+
+    //! only for ReduceByHash in ProbingHashTable and BucketHashTable: store the
+    //! hash of each key next to its item, also in the files spilled by the
+    //! post stage. Keys are then only compared if their hashes match, and
+    //! re-reducing spilled items with another salt does not hash the keys
+    //! again. Costs eight bytes per item.
+    static constexpr bool store_hash_ = false;
+
     //! use MixStream instead of CatStream in ReduceNodes: this makes the order
     //! of items delivered in the ReduceFunction arbitrary.
     static constexpr bool use_mix_stream_ = true;
@@ -64,6 +127,11 @@ public:
     //! the pre and post stages simultaneously.
     static constexpr bool use_post_thread_ = true;
 
+    //! only for ReduceByKey and ReducePair: combine the pre-reduced items of
+    //! all workers on a host in a second pre stage before sending them over the
+    //! network. This is only done if there are multiple workers per host.
+    static constexpr bool use_host_combine_ = false;
+
     //! \name Accessors
     //! \{
 
@@ -74,6 +142,39 @@ public:
     //! Returns bucket_rate_
     double bucket_rate() const { return bucket_rate_; }
 
+    //! Returns max_probe_length_
+    size_t max_probe_length() const { return max_probe_length_; }
+
+    //! Returns min_pre_partitions_
+    size_t min_pre_partitions() const { return min_pre_partitions_; }
+
+    //! Returns bypass_new_key_rate_
+    double bypass_new_key_rate() const { return bypass_new_key_rate_; }
+
+    //! Returns bypass_window_size_
+    size_t bypass_window_size() const { return bypass_window_size_; }
+
+    //! Returns bypass_windows_
+    size_t bypass_windows() const { return bypass_windows_; }
+
+    //! Returns hot_key_sample_size_
+    size_t hot_key_sample_size() const { return hot_key_sample_size_; }
+
+    //! Returns max_hot_keys_
+    size_t max_hot_keys() const { return max_hot_keys_; }
+
+    //! Returns hot_key_rate_
+    double hot_key_rate() const { return hot_key_rate_; }
+
+    //! Returns schedule_exchange_
+    bool schedule_exchange() const { return schedule_exchange_; }
+
+    //! Returns steal_partitions_
+    bool steal_partitions() const { return steal_partitions_; }
+
+    //! Returns key_sketch_precision_
+    unsigned key_sketch_precision() const { return key_sketch_precision_; }
+
     //! \}
 };
 
@@ -105,6 +206,10 @@ public:
     using KeyValuePair = std::pair<Key, Value>;
     using ReduceConfig = ReduceConfig_;
 
+    //! whether spilled partitions are sorted runs, which the post-stage merges
+    //! instead of re-reducing them with hashing.
+    static constexpr bool sorted_runs_ = false;
+
     ReduceTable(
         Context& ctx, size_t dia_id,
         const KeyExtractor& key_extractor,
@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * thrill/core/remote_file_system.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/common/system_exception.hpp>
+#include <thrill/core/remote_file_system.hpp>
+
+#if !defined(_MSC_VER)
+#include <fnmatch.h>
+#include <sys/wait.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+static constexpr bool debug = false;
+
+//! Run a shell command and return its output, throws if it fails.
+static std::string RunCommand(const std::string& cmd) {
+#if defined(_MSC_VER)
+    throw common::SystemException(
+              "Remote file systems are not supported on windows, yet. "
+              "Please submit a patch.");
+#else
+    sLOG << "RunCommand():" << cmd;
+
+    FILE* p = popen(cmd.c_str(), "r");
+    if (p == nullptr)
+        throw common::ErrnoException("Error running command " + cmd);
+
+    std::string output;
+    char buffer[4096];
+    size_t rb;
+    while ((rb = fread(buffer, 1, sizeof(buffer), p)) > 0)
+        output.append(buffer, rb);
+
+    int status = pclose(p);
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error(
+                  "Command failed with status " + std::to_string(status)
+                  + ": " + cmd);
+    }
+    return output;
+#endif
+}
+
+std::string ShellQuote(const std::string& str) {
+    std::string out = "'";
+    for (char c : str) {
+        if (c == '\'')
+            out += "'\\''";
+        else
+            out += c;
+    }
+    out += "'";
+    return out;
+}
+
+//! Split an URI scheme://authority/path into "scheme://authority" and "path"
+//! without leading slash.
+static std::pair<std::string, std::string> SplitUri(const std::string& uri) {
+    std::string::size_type s = uri.find("://");
+    if (s == std::string::npos) return std::make_pair(std::string(), uri);
+    std::string::size_type e = uri.find('/', s + 3);
+    if (e == std::string::npos) return std::make_pair(uri, std::string());
+    return std::make_pair(uri.substr(0, e), uri.substr(e + 1));
+}
+
+/******************************************************************************/
+
+/*!
+ * Amazon S3 via the aws command line interface. Reads from an offset issue a
+ * ranged GET, and writes are streamed by "aws s3 cp -", which uploads the data
+ * in parts of multipart upload as it arrives. Credentials, region, and
+ * endpoint are taken from the usual AWS environment and configuration files.
+ */
+class S3FileSystem final : public RemoteFileSystem
+{
+public:
+    std::vector<Entry> List(const std::string& prefix) final {
+        std::string base = SplitUri(prefix).first;
+        std::string output = RunCommand(
+            "aws s3 ls --recursive " + ShellQuote(prefix));
+
+        // lines are "date time size key", where key may contain spaces.
+        std::vector<Entry> list;
+        std::istringstream is(output);
+        std::string line;
+        while (std::getline(is, line)) {
+            std::istringstream ls(line);
+            std::string date, time;
+            uint64_t size;
+            if (!(ls >> date >> time >> size)) continue;
+            std::string key;
+            std::getline(ls >> std::ws, key);
+            if (key.empty() || key.back() == '/') continue;
+            list.emplace_back(base + "/" + key, size);
+        }
+        return list;
+    }
+
+    std::string ReadCommand(const std::string& path, uint64_t offset) final {
+        if (offset == 0)
+            return "aws s3 cp --quiet " + ShellQuote(path) + " -";
+
+        // get-object prints its metadata to stdout, hence write the object to
+        // a duplicate of stdout and discard the metadata.
+        std::pair<std::string, std::string> uri = SplitUri(path);
+        return "aws s3api get-object"
+               " --bucket " + ShellQuote(uri.first.substr(5))
+               + " --key " + ShellQuote(uri.second)
+               + " --range bytes=" + std::to_string(offset) + "-"
+               " /dev/fd/3 3>&1 >/dev/null";
+    }
+
+    std::string WriteCommand(const std::string& path) final {
+        return "aws s3 cp --quiet - " + ShellQuote(path);
+    }
+};
+
+/*!
+ * Hadoop Distributed File System via the hdfs command line interface. The
+ * interface provides no ranged reads, hence reads from an offset skip the
+ * beginning of the stream.
+ */
+class HdfsFileSystem final : public RemoteFileSystem
+{
+public:
+    std::vector<Entry> List(const std::string& prefix) final {
+        std::string base = SplitUri(prefix).first;
+
+        // list the parent directory of the prefix
+        std::string dir = prefix.substr(0, prefix.rfind('/') + 1);
+        if (dir.size() <= base.size() + 1) dir = base + "/";
+
+        std::string output = RunCommand(
+            "hdfs dfs -ls -R " + ShellQuote(dir) + " 2>/dev/null");
+
+        // lines are "perm repl owner group size date time path"
+        std::vector<Entry> list;
+        std::istringstream is(output);
+        std::string line;
+        while (std::getline(is, line)) {
+            if (line.empty() || line[0] != '-') continue;
+            std::istringstream ls(line);
+            std::string perm, repl, owner, group, date, time;
+            uint64_t size;
+            if (!(ls >> perm >> repl >> owner >> group >> size >> date >> time))
+                continue;
+            std::string path;
+            std::getline(ls >> std::ws, path);
+            if (path.empty()) continue;
+            if (path.find("://") == std::string::npos)
+                path = base + path;
+            if (!common::StartsWith(path, prefix)) continue;
+            list.emplace_back(path, size);
+        }
+        return list;
+    }
+
+    std::string ReadCommand(const std::string& path, uint64_t offset) final {
+        std::string cmd = "hdfs dfs -cat " + ShellQuote(path);
+        if (offset != 0)
+            cmd += " | tail -c +" + std::to_string(offset + 1);
+        return cmd;
+    }
+
+    std::string WriteCommand(const std::string& path) final {
+        return "hdfs dfs -put -f - " + ShellQuote(path);
+    }
+};
+
+/******************************************************************************/
+
+//! registry of remote file systems and cache of file sizes
+struct RemoteRegistry {
+    std::mutex mutex;
+    std::map<std::string, RemoteFileSystemPtr> file_systems;
+    std::map<std::string, uint64_t> sizes;
+
+    RemoteRegistry() {
+        file_systems["s3"] = std::make_shared<S3FileSystem>();
+        file_systems["hdfs"] = std::make_shared<HdfsFileSystem>();
+    }
+};
+
+static RemoteRegistry& Registry() {
+    static RemoteRegistry registry;
+    return registry;
+}
+
+void RegisterRemoteFileSystem(
+    const std::string& scheme, const RemoteFileSystemPtr& fs) {
+    RemoteRegistry& r = Registry();
+    std::unique_lock<std::mutex> lock(r.mutex);
+    r.file_systems[scheme] = fs;
+}
+
+RemoteFileSystemPtr FindRemoteFileSystem(const std::string& path) {
+    std::string::size_type s = path.find("://");
+    if (s == std::string::npos) return RemoteFileSystemPtr();
+
+    RemoteRegistry& r = Registry();
+    std::unique_lock<std::mutex> lock(r.mutex);
+    auto it = r.file_systems.find(path.substr(0, s));
+    if (it == r.file_systems.end()) return RemoteFileSystemPtr();
+    return it->second;
+}
+
+bool IsRemotePath(const std::string& path) {
+    return FindRemoteFileSystem(path) != nullptr;
+}
+
+std::vector<std::string> RemoteGlob(const std::string& pattern) {
+    RemoteFileSystemPtr fs = FindRemoteFileSystem(pattern);
+    if (!fs) return std::vector<std::string>();
+
+    std::string::size_type w = pattern.find_first_of("*?[");
+    std::string prefix = pattern.substr(0, w);
+
+    std::vector<RemoteFileSystem::Entry> list = fs->List(prefix);
+
+    std::vector<std::string> files;
+    {
+        RemoteRegistry& r = Registry();
+        std::unique_lock<std::mutex> lock(r.mutex);
+
+        for (const RemoteFileSystem::Entry& e : list) {
+            bool match;
+            if (w != std::string::npos) {
+#if !defined(_MSC_VER)
+                match = fnmatch(pattern.c_str(), e.first.c_str(), 0) == 0;
+#else
+                match = false;
+#endif
+            }
+            else {
+                match = e.first == pattern ||
+                        (common::EndsWith(pattern, "/") &&
+                         common::StartsWith(e.first, pattern));
+            }
+            if (!match) continue;
+
+            files.push_back(e.first);
+            r.sizes[e.first] = e.second;
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+
+    sLOG << "RemoteGlob():" << pattern << "matched" << files.size() << "files";
+
+    return files;
+}
+
+uint64_t RemoteFileSize(const std::string& path) {
+    RemoteRegistry& r = Registry();
+    {
+        std::unique_lock<std::mutex> lock(r.mutex);
+        auto it = r.sizes.find(path);
+        if (it != r.sizes.end()) return it->second;
+    }
+
+    RemoteFileSystemPtr fs = FindRemoteFileSystem(path);
+    if (fs) {
+        for (const RemoteFileSystem::Entry& e : fs->List(path)) {
+            if (e.first != path) continue;
+            std::unique_lock<std::mutex> lock(r.mutex);
+            r.sizes[e.first] = e.second;
+            return e.second;
+        }
+    }
+    throw std::runtime_error("ERROR: Invalid file " + path);
+}
+
+} // namespace core
+} // namespace thrill
+
+/******************************************************************************/
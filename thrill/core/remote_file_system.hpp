@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * thrill/core/remote_file_system.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REMOTE_FILE_SYSTEM_HEADER
+#define THRILL_CORE_REMOTE_FILE_SYSTEM_HEADER
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Interface of a remote file system, which is selected by the URI scheme of
+ * paths like s3://bucket/key or hdfs://namenode/path. Remote files are
+ * accessed via shell commands whose output or input is connected to Thrill
+ * through a pipe, in the same manner as compressed files are piped through a
+ * decompressor. Hence, SysFile::OpenForRead() and SysFile::OpenForWrite()
+ * transparently handle remote files and everything built on them: ReadLines,
+ * ReadBinary, WriteLinesMany, and WriteBinary.
+ *
+ * Each worker opens its own part of the input with a ranged request starting
+ * at its offset, hence all workers issue requests in parallel, and the pipe
+ * buffers data ahead of the reader while the worker processes the previous
+ * block.
+ */
+class RemoteFileSystem
+{
+public:
+    //! pair of path and size of a remote file
+    using Entry = std::pair<std::string, uint64_t>;
+
+    virtual ~RemoteFileSystem() = default;
+
+    //! Returns all regular files whose paths start with prefix, with their
+    //! sizes. The paths must include the scheme.
+    virtual std::vector<Entry> List(const std::string& prefix) = 0;
+
+    //! Returns a shell command which writes the contents of the file starting
+    //! at offset to stdout.
+    virtual std::string ReadCommand(
+        const std::string& path, uint64_t offset) = 0;
+
+    //! Returns a shell command which stores all data from stdin as the file.
+    virtual std::string WriteCommand(const std::string& path) = 0;
+};
+
+using RemoteFileSystemPtr = std::shared_ptr<RemoteFileSystem>;
+
+//! Register a remote file system for all paths starting with "scheme://",
+//! replacing any previously registered one. Built-in are "s3" via the aws
+//! command line interface and "hdfs" via the hdfs command line interface.
+void RegisterRemoteFileSystem(
+    const std::string& scheme, const RemoteFileSystemPtr& fs);
+
+//! Returns the remote file system responsible for path, or nullptr if path is
+//! a local file.
+RemoteFileSystemPtr FindRemoteFileSystem(const std::string& path);
+
+//! Returns true, if path has an URI scheme of a registered remote file system.
+bool IsRemotePath(const std::string& path);
+
+//! Returns all remote files matching the glob pattern, sorted by path. The
+//! files below the pattern's prefix up to the first wildcard are listed and
+//! filtered with fnmatch(), hence '*' also matches '/' as is usual for object
+//! stores. A pattern without wildcards matches a single file or all files
+//! below it if it ends with '/'. The sizes are cached for RemoteFileSize().
+std::vector<std::string> RemoteGlob(const std::string& pattern);
+
+//! Returns the size of a remote file, from the cache filled by RemoteGlob() or
+//! by listing the path. Throws std::runtime_error if the file does not exist.
+uint64_t RemoteFileSize(const std::string& path);
+
+//! Quote a string for passing it as a single argument to the shell.
+std::string ShellQuote(const std::string& str);
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REMOTE_FILE_SYSTEM_HEADER
+
+/******************************************************************************/
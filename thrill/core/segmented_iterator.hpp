@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * thrill/core/segmented_iterator.hpp
+ *
+ * Random access iterator over a sequence of equally sized arrays, e.g. the
+ * items stored in a list of ByteBlocks.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_SEGMENTED_ITERATOR_HEADER
+#define THRILL_CORE_SEGMENTED_ITERATOR_HEADER
+
+#include <cstddef>
+#include <iterator>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Random access iterator over the concatenation of arrays (segments), which
+ * all contain segment_size items, except possibly the last one. This enables
+ * sorting items in-place which are stored in multiple separate memory areas.
+ */
+template <typename Type>
+class SegmentedIterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Type *;
+    using reference = Type &;
+
+    SegmentedIterator() = default;
+
+    //! construct iterator at given index into the segments
+    SegmentedIterator(Type* const* segments, size_t segment_size, size_t index)
+        : segments_(segments), segment_size_(segment_size), index_(index) { }
+
+    reference operator * () const {
+        return segments_[index_ / segment_size_][index_ % segment_size_];
+    }
+    pointer operator -> () const { return &**this; }
+    reference operator [] (difference_type n) const { return *(*this + n); }
+
+    SegmentedIterator& operator ++ () { ++index_; return *this; }
+    SegmentedIterator& operator -- () { --index_; return *this; }
+
+    SegmentedIterator operator ++ (int) {
+        SegmentedIterator it = *this;
+        ++index_;
+        return it;
+    }
+    SegmentedIterator operator -- (int) {
+        SegmentedIterator it = *this;
+        --index_;
+        return it;
+    }
+
+    SegmentedIterator& operator += (difference_type n) {
+        index_ += n;
+        return *this;
+    }
+    SegmentedIterator& operator -= (difference_type n) {
+        index_ -= n;
+        return *this;
+    }
+
+    SegmentedIterator operator + (difference_type n) const {
+        return SegmentedIterator(segments_, segment_size_, index_ + n);
+    }
+    SegmentedIterator operator - (difference_type n) const {
+        return SegmentedIterator(segments_, segment_size_, index_ - n);
+    }
+    friend SegmentedIterator operator + (
+        difference_type n, const SegmentedIterator& it) {
+        return it + n;
+    }
+
+    difference_type operator - (const SegmentedIterator& b) const {
+        return static_cast<difference_type>(index_)
+               - static_cast<difference_type>(b.index_);
+    }
+
+    bool operator == (const SegmentedIterator& b) const {
+        return index_ == b.index_;
+    }
+    bool operator != (const SegmentedIterator& b) const {
+        return index_ != b.index_;
+    }
+    bool operator < (const SegmentedIterator& b) const {
+        return index_ < b.index_;
+    }
+    bool operator > (const SegmentedIterator& b) const {
+        return index_ > b.index_;
+    }
+    bool operator <= (const SegmentedIterator& b) const {
+        return index_ <= b.index_;
+    }
+    bool operator >= (const SegmentedIterator& b) const {
+        return index_ >= b.index_;
+    }
+
+private:
+    //! array of pointers to the segments
+    Type* const* segments_ = nullptr;
+    //! number of items in each segment
+    size_t segment_size_ = 1;
+    //! current item index in the concatenation of segments
+    size_t index_ = 0;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_SEGMENTED_ITERATOR_HEADER
+
+/******************************************************************************/
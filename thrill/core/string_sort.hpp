@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * thrill/core/string_sort.hpp
+ *
+ * Multikey quicksort of Bentley and Sedgewick for ranges of strings, which
+ * inspects each character of common prefixes only once per level instead of
+ * comparing full strings.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_STRING_SORT_HEADER
+#define THRILL_CORE_STRING_SORT_HEADER
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace thrill {
+namespace core {
+
+namespace string_sort_detail {
+
+//! below this size, ranges are sorted by insertion sort.
+static constexpr size_t insertion_sort_threshold = 32;
+
+//! character at depth as unsigned value, or -1 at the end of the string.
+template <typename String>
+static inline int CharAt(const String& s, size_t depth) {
+    return depth < s.size() ? static_cast<unsigned char>(s[depth]) : -1;
+}
+
+//! compare two strings with a common prefix of length depth.
+template <typename String>
+static inline bool LessFrom(const String& a, const String& b, size_t depth) {
+    size_t n = std::min(a.size(), b.size());
+    for ( ; depth < n; ++depth) {
+        if (a[depth] != b[depth])
+            return static_cast<unsigned char>(a[depth])
+                   < static_cast<unsigned char>(b[depth]);
+    }
+    return a.size() < b.size();
+}
+
+template <typename Iterator>
+static inline void InsertionSort(Iterator begin, Iterator end, size_t depth) {
+    for (Iterator i = begin + 1; i < end; ++i) {
+        for (Iterator j = i; j != begin && LessFrom(*j, *(j - 1), depth); --j)
+            std::swap(*j, *(j - 1));
+    }
+}
+
+static inline int Median3(int a, int b, int c) {
+    if (a < b) {
+        if (b < c) return b;
+        return a < c ? c : a;
+    }
+    if (a < c) return a;
+    return b < c ? c : b;
+}
+
+} // namespace string_sort_detail
+
+/*!
+ * Sort the range [begin,end) of strings, whose first depth characters are
+ * equal, lexicographically by unsigned characters like std::less<std::string>
+ * with multikey quicksort. The strings need size() and operator [].
+ */
+template <typename Iterator>
+void multikey_quicksort(Iterator begin, Iterator end, size_t depth = 0) {
+    using namespace string_sort_detail;
+
+    while (static_cast<size_t>(end - begin) > insertion_sort_threshold)
+    {
+        int pivot = Median3(CharAt(*begin, depth),
+                            CharAt(*(begin + (end - begin) / 2), depth),
+                            CharAt(*(end - 1), depth));
+
+        // ternary partition by the character at depth
+        Iterator lt = begin, i = begin, gt = end;
+        while (i < gt) {
+            int c = CharAt(*i, depth);
+            if (c < pivot)
+                std::swap(*lt++, *i++);
+            else if (c > pivot)
+                std::swap(*i, *--gt);
+            else
+                ++i;
+        }
+
+        multikey_quicksort(begin, lt, depth);
+        multikey_quicksort(gt, end, depth);
+
+        // strings equal to the pivot which ended are equal.
+        if (pivot < 0) return;
+
+        // continue with the next character of the equal range
+        begin = lt, end = gt, ++depth;
+    }
+
+    if (end - begin > 1)
+        InsertionSort(begin, end, depth);
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_STRING_SORT_HEADER
+
+/******************************************************************************/
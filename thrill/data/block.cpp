@@ -41,6 +41,14 @@ PinRequestPtr Block::Pin(size_t local_worker_id) const {
     return byte_block()->block_pool_->PinBlock(*this, local_worker_id);
 }
 
+PinRequestPtr Block::PinReadAhead(
+    size_t local_worker_id,
+    const std::chrono::steady_clock::time_point& deadline) const {
+    assert(IsValid());
+    return byte_block()->block_pool_->PinBlockReadAhead(
+        *this, local_worker_id, deadline);
+}
+
 /******************************************************************************/
 // PinnedBlock
 
@@ -65,6 +73,9 @@ PinnedBlock PinRequest::Wait() {
     if (ready_) return block_;
 
     std::unique_lock<std::mutex> lock(block_pool_->mutex_);
+    // the Block is needed now: issue a queued read-ahead immediately.
+    if (queued_)
+        block_pool_->IntIssueQueuedRead(this);
     block_pool_->cv_read_complete_.wait(
         lock, [this]() { return ready_.load(); });
     lock.unlock();
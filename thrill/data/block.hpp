@@ -19,6 +19,7 @@
 #include <thrill/mem/pool.hpp>
 
 #include <cassert>
+#include <chrono>
 #include <future>
 #include <ostream>
 #include <string>
@@ -85,12 +86,18 @@ public:
     //! return number of items beginning in this block
     size_t num_items() const { return num_items_; }
 
+    //! accessor to num_items_
+    void set_num_items(size_t n) { num_items_ = n; }
+
     //! return number of pins in underlying ByteBlock
     size_t pin_count(size_t local_worker_id) const {
         assert(byte_block_);
         return byte_block_->pin_count(local_worker_id);
     }
 
+    //! accessor to begin_
+    size_t begin() const { return begin_; }
+
     //! accessor to begin_
     void set_begin(size_t i) { begin_ = i; }
 
@@ -116,6 +123,13 @@ public:
     //! block.  Otherwise an async pin call will be issued.
     PinRequestPtr Pin(size_t local_worker_id) const;
 
+    //! Pin the ByteBlock ahead of its use, see BlockPool::PinBlockReadAhead():
+    //! if the Block is swapped out, the read is scheduled with the others of
+    //! the host by the time the Block is expected to be needed.
+    PinRequestPtr PinReadAhead(
+        size_t local_worker_id,
+        const std::chrono::steady_clock::time_point& deadline) const;
+
     //! Convenience function to call Pin() and wait for the future.
     PinnedBlock PinWait(size_t local_worker_id) const;
 
@@ -354,6 +368,14 @@ private:
     PinnedBlock block_;
     //! running read request
     io::RequestPtr req_;
+    //! temporary buffer for reading compressed data, or nullptr.
+    Byte* em_buffer_ = nullptr;
+    //! whether the read is queued in the BlockPool's read-ahead scheduler
+    bool queued_ = false;
+    //! disk queue id of the read, for the read-ahead scheduler
+    int queue_id_ = 0;
+    //! time the read was issued, for the JSON log
+    std::chrono::steady_clock::time_point issued_;
 
     //! indication that the PinnedBlocks ready
     std::atomic<bool> ready_;
@@ -0,0 +1,211 @@
+/*******************************************************************************
+ * thrill/data/block_compression.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/block_compression.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace thrill {
+namespace data {
+
+namespace {
+
+//! minimum length of a match
+static constexpr size_t min_match = 4;
+//! the last bytes of a block are always encoded as literals
+static constexpr size_t last_literals = 5;
+//! no match may start in the last bytes of a block
+static constexpr size_t match_find_limit = 12;
+//! maximum back reference distance, offsets are stored in two bytes
+static constexpr size_t max_offset = 65535;
+//! number of bits of the hash table of previous positions
+static constexpr size_t hash_bits = 12;
+
+static inline uint32_t Read32(const Byte* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline size_t Hash32(uint32_t v) {
+    return static_cast<uint32_t>(v * 2654435761u) >> (32 - hash_bits);
+}
+
+//! write the extension bytes of a literal or match length
+static inline Byte * WriteLength(Byte* op, size_t len) {
+    for ( ; len >= 255; len -= 255) *op++ = 255;
+    *op++ = static_cast<Byte>(len);
+    return op;
+}
+
+//! maximum number of bytes needed to encode a length extension
+static inline size_t LengthBytes(size_t len) {
+    return len / 255 + 1;
+}
+
+} // namespace
+
+size_t BlockCompress(const Byte* input, size_t size,
+                     Byte* output, size_t capacity) {
+
+    const Byte* const out_end = output + capacity;
+    Byte* op = output;
+    size_t anchor = 0;
+
+    if (size > match_find_limit)
+    {
+        // hash table of the most recent position of each four byte sequence
+        uint32_t table[size_t(1) << hash_bits];
+        std::fill(table, table + (size_t(1) << hash_bits), 0);
+
+        const size_t match_limit = size - match_find_limit;
+        size_t ip = 0;
+
+        while (ip < match_limit)
+        {
+            uint32_t seq = Read32(input + ip);
+            size_t h = Hash32(seq);
+            size_t ref = table[h];
+            table[h] = static_cast<uint32_t>(ip);
+
+            if (ref >= ip || ip - ref > max_offset ||
+                Read32(input + ref) != seq) {
+                // skip faster through incompressible data
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            // extend match forward, but keep the last literals
+            size_t len = min_match;
+            const size_t len_limit = size - last_literals - ip;
+            while (len < len_limit && input[ref + len] == input[ip + len])
+                ++len;
+
+            // emit sequence: token, literals, offset, and match length
+            size_t lit = ip - anchor, ml = len - min_match;
+            if (op + 1 + LengthBytes(lit) + lit + 2 + LengthBytes(ml) > out_end)
+                return 0;
+
+            Byte* token = op++;
+            *token = static_cast<Byte>(
+                (std::min(lit, size_t(15)) << 4) | std::min(ml, size_t(15)));
+            if (lit >= 15) op = WriteLength(op, lit - 15);
+            std::memcpy(op, input + anchor, lit);
+            op += lit;
+
+            size_t offset = ip - ref;
+            *op++ = static_cast<Byte>(offset);
+            *op++ = static_cast<Byte>(offset >> 8);
+            if (ml >= 15) op = WriteLength(op, ml - 15);
+
+            ip += len;
+            anchor = ip;
+
+            // remember a position inside the match for following sequences
+            table[Hash32(Read32(input + ip - 2))] =
+                static_cast<uint32_t>(ip - 2);
+        }
+    }
+
+    // emit remaining literals as last sequence without a match
+    size_t lit = size - anchor;
+    if (op + 1 + LengthBytes(lit) + lit > out_end)
+        return 0;
+
+    *op++ = static_cast<Byte>(std::min(lit, size_t(15)) << 4);
+    if (lit >= 15) op = WriteLength(op, lit - 15);
+    std::memcpy(op, input + anchor, lit);
+    op += lit;
+
+    return static_cast<size_t>(op - output);
+}
+
+bool BlockDecompress(const Byte* input, size_t compressed_size,
+                     Byte* output, size_t size) {
+
+    const Byte* ip = input;
+    const Byte* const in_end = input + compressed_size;
+    Byte* op = output;
+    Byte* const out_end = output + size;
+
+    while (ip < in_end)
+    {
+        size_t token = *ip++;
+
+        // copy literals
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            Byte b;
+            do {
+                if (ip >= in_end) return false;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > static_cast<size_t>(in_end - ip) ||
+            lit > static_cast<size_t>(out_end - op))
+            return false;
+
+        std::memcpy(op, ip, lit);
+        ip += lit, op += lit;
+
+        // the last sequence contains only literals
+        if (ip == in_end) break;
+
+        // copy match
+        if (in_end - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - output))
+            return false;
+
+        size_t ml = token & 15;
+        if (ml == 15) {
+            Byte b;
+            do {
+                if (ip >= in_end) return false;
+                b = *ip++;
+                ml += b;
+            } while (b == 255);
+        }
+        ml += min_match;
+        if (ml > static_cast<size_t>(out_end - op))
+            return false;
+
+        const Byte* match = op - offset;
+        if (offset >= ml) {
+            std::memcpy(op, match, ml);
+            op += ml;
+        }
+        else {
+            // overlapping match: repeats the last offset bytes
+            for (size_t i = 0; i < ml; ++i) *op++ = *match++;
+        }
+    }
+
+    return op == out_end;
+}
+
+bool DefaultBlockCompression() {
+    static const bool enabled = []() {
+        const char* env = getenv("THRILL_BLOCK_COMPRESSION");
+        if (env == nullptr) return false;
+        std::string s = env;
+        return s == "1" || s == "on" || s == "lz4";
+    } ();
+    return enabled;
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
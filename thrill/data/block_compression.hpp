@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * thrill/data/block_compression.hpp
+ *
+ * Fast LZ77 block compression codec used for ByteBlocks that are evicted to
+ * disk or transmitted over the network. The compressed format is the LZ4 block
+ * format.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_BLOCK_COMPRESSION_HEADER
+#define THRILL_DATA_BLOCK_COMPRESSION_HEADER
+
+#include <thrill/data/byte_block.hpp>
+
+#include <cstddef>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+/*!
+ * Compress the bytes [input, input + size) into output, which has capacity
+ * bytes. Returns the compressed size, or zero if the compressed data does not
+ * fit into capacity bytes. Hence, passing capacity = size - 1 rejects all
+ * incompressible blocks.
+ */
+size_t BlockCompress(const Byte* input, size_t size,
+                     Byte* output, size_t capacity);
+
+/*!
+ * Decompress the compressed_size bytes at input into output, which must be
+ * exactly size bytes long. Returns false if the compressed data is corrupt.
+ */
+bool BlockDecompress(const Byte* input, size_t compressed_size,
+                     Byte* output, size_t size);
+
+/*!
+ * Returns the default setting of block compression, which is read once from
+ * the environment variable THRILL_BLOCK_COMPRESSION. Compression is enabled by
+ * the values "1", "on", or "lz4", and disabled otherwise.
+ */
+bool DefaultBlockCompression();
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_BLOCK_COMPRESSION_HEADER
+
+/******************************************************************************/
@@ -12,14 +12,19 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/common/lru_cache.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/data/block.hpp>
+#include <thrill/data/block_compression.hpp>
 #include <thrill/data/block_pool.hpp>
 #include <thrill/io/file_base.hpp>
 #include <thrill/io/iostats.hpp>
+#include <thrill/mem/huge_page_arena.hpp>
 
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <map>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -40,6 +45,13 @@ static constexpr bool debug_mem = false;
 //! debug block eviction: evict, write complete, read complete
 static constexpr bool debug_em = false;
 
+//! microseconds elapsed since a time point, for durations in the JSON log.
+static inline long long MicrosecondsSince(
+    const std::chrono::steady_clock::time_point& tp) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - tp).count();
+}
+
 /******************************************************************************/
 // std::new_handler() which gets called when malloc() returns nullptr
 
@@ -117,11 +129,165 @@ using ReadingMap = std::unordered_map<
           mem::GPoolAllocator<
               std::pair<ByteBlock* const, PinRequestPtr> > >;
 
+EvictionPolicy DefaultEvictionPolicy() {
+    static const EvictionPolicy policy = []() {
+        const char* env = getenv("THRILL_EVICTION_POLICY");
+        if (env == nullptr) return EvictionPolicy::Hint;
+        std::string s = env;
+        if (s == "lru") return EvictionPolicy::LRU;
+        if (s == "2q") return EvictionPolicy::TwoQueue;
+        if (s == "hint") return EvictionPolicy::Hint;
+        die("THRILL_EVICTION_POLICY must be lru, 2q, or hint.");
+    } ();
+    return policy;
+}
+
+/*!
+ * Set of unpinned ByteBlocks in memory, which delivers the next block to evict
+ * according to the EvictionPolicy. The blocks are kept in up to four LRU
+ * lists, ByteBlock::eviction_queue_ stores the list of each block. Blocks with
+ * EvictionHint::Pinned are kept in a fifth list under all policies, which is
+ * evicted only if all others are empty.
+ */
+class EvictionQueue
+{
+public:
+    using LruSet = common::LruCacheSet<
+              ByteBlock*, mem::GPoolAllocator<ByteBlock*> >;
+
+    explicit EvictionQueue(EvictionPolicy policy) : policy_(policy) { }
+
+    EvictionPolicy policy() const { return policy_; }
+
+    //! change the policy and redistribute the blocks in LRU order.
+    void set_policy(EvictionPolicy policy) {
+        std::vector<ByteBlock*> blocks;
+        for (LruSet& q : queues_) {
+            while (q.size()) blocks.push_back(q.pop());
+        }
+        size_ = 0;
+        policy_ = policy;
+        for (ByteBlock* b : blocks) put(b);
+    }
+
+    //! insert an unpinned block as most recently used of its list
+    void put(ByteBlock* block_ptr) {
+        block_ptr->eviction_queue_ = static_cast<uint8_t>(Queue(block_ptr));
+        block_ptr->unpinned_before_ = true;
+        queues_[block_ptr->eviction_queue_].put(block_ptr);
+        ++size_;
+    }
+
+    bool exists(ByteBlock* block_ptr) const {
+        return queues_[block_ptr->eviction_queue_].exists(block_ptr);
+    }
+
+    void erase(ByteBlock* block_ptr) {
+        queues_[block_ptr->eviction_queue_].erase(block_ptr);
+        --size_;
+    }
+
+    size_t size() const { return size_; }
+
+    //! remove and return the next block to evict
+    ByteBlock* pop() {
+        assert(size_ != 0);
+        --size_;
+
+        if (size_ + 1 == queues_[queue_pinned].size())
+            return queues_[queue_pinned].pop();
+
+        if (policy_ == EvictionPolicy::TwoQueue) {
+            // evict first-time blocks while they are more than a quarter
+            if (queues_[0].size() > size_ / 4 || queues_[1].size() == 0)
+                return queues_[0].pop();
+            return queues_[1].pop();
+        }
+
+        // LRU uses only queue 0, Hint evicts in order of the queues.
+        for (size_t q = 0; q < queue_pinned; ++q) {
+            if (queues_[q].size() == 0) continue;
+            if (q == queue_sequential)
+                return queues_[q].pop_newest();
+            return queues_[q].pop();
+        }
+        abort();
+    }
+
+private:
+    static constexpr size_t num_queues = 5;
+
+    //! queue of EvictionHint::Sequential blocks, which is evicted by MRU.
+    static constexpr size_t queue_sequential = 1;
+
+    //! queue of EvictionHint::Pinned blocks, which is evicted last.
+    static constexpr size_t queue_pinned = 4;
+
+    EvictionPolicy policy_;
+
+    //! lists of blocks, evicted from the first non-empty one
+    LruSet queues_[num_queues];
+
+    //! total number of blocks in all queues
+    size_t size_ = 0;
+
+    //! select list of a block
+    size_t Queue(const ByteBlock* block_ptr) const {
+        if (block_ptr->eviction_hint_ == EvictionHint::Pinned)
+            return queue_pinned;
+        switch (policy_) {
+        case EvictionPolicy::LRU:
+            return 0;
+        case EvictionPolicy::TwoQueue:
+            return block_ptr->unpinned_before_ ? 1 : 0;
+        case EvictionPolicy::Hint:
+            switch (block_ptr->eviction_hint_) {
+            case EvictionHint::DeadAfterRead:
+                return 0;
+            case EvictionHint::Sequential:
+                return queue_sequential;
+            case EvictionHint::None:
+                return 2;
+            case EvictionHint::ReadAgainSoon:
+                return 3;
+            case EvictionHint::Pinned:
+                return queue_pinned;
+            }
+        }
+        abort();
+    }
+};
+
+//! read-ahead scheduler queue of a disk
+struct ReadAheadQueue
+{
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    //! number of reads currently in flight on the disk
+    size_t in_flight = 0;
+
+    //! queued read-aheads in order of their deadlines
+    std::multimap<
+        Deadline, PinRequest*, std::less<Deadline>,
+        mem::GPoolAllocator<std::pair<const Deadline, PinRequest*> > > queued;
+};
+
+//! type of list of blocks swapped to the fast tier in order of their swap
+//! times, entries of blocks which were swapped in since are skipped later.
+using FastTierQueue = std::deque<
+          std::pair<std::chrono::steady_clock::time_point, ByteBlock*>,
+          mem::GPoolAllocator<
+              std::pair<std::chrono::steady_clock::time_point, ByteBlock*> > >;
+
+//! type of map of disk queue ids to read-ahead queues
+using ReadAheadMap = std::unordered_map<
+          int, ReadAheadQueue, std::hash<int>, std::equal_to<int>,
+          mem::GPoolAllocator<std::pair<const int, ReadAheadQueue> > >;
+
 struct BlockPool::Data
 {
-    //! list of all blocks that are _in_memory_ but are _not_ pinned.
-    common::LruCacheSet<
-        ByteBlock*, mem::GPoolAllocator<ByteBlock*> > unpinned_blocks_;
+    //! set of all blocks that are _in_memory_ but are _not_ pinned.
+    EvictionQueue unpinned_blocks_ { DefaultEvictionPolicy() };
 
     //! set of ByteBlocks currently begin written to EM.
     WritingMap                                        writing_;
@@ -129,11 +295,38 @@ struct BlockPool::Data
     //! set of ByteBlocks currently begin read from EM.
     ReadingMap                                        reading_;
 
+    //! set of ByteBlocks being compressed for eviction, outside the mutex.
+    std::unordered_set<
+        ByteBlock*, std::hash<ByteBlock*>, std::equal_to<ByteBlock*>,
+        mem::GPoolAllocator<ByteBlock*> >             compressing_;
+
+    //! read-ahead scheduler state of the disks currently read from.
+    ReadAheadMap                                      read_ahead_;
+
     //! set of ByteBlock currently in EM.
     std::unordered_set<
         ByteBlock*, std::hash<ByteBlock*>, std::equal_to<ByteBlock*>,
         mem::GPoolAllocator<ByteBlock*> >             swapped_;
 
+    //! blocks swapped to the fast tier, candidates for demotion.
+    FastTierQueue                                     fast_tier_;
+
+    //! demotions in flight, which are not canceled.
+    std::unordered_map<
+        ByteBlock*, Demotion*,
+        std::hash<ByteBlock*>, std::equal_to<ByteBlock*>,
+        mem::GPoolAllocator<std::pair<ByteBlock* const, Demotion*> > >
+    demoting_;
+
+    //! registered memory pressure handlers and their ids.
+    std::vector<std::pair<size_t, PressureHandler> > pressure_handlers_;
+
+    //! registered memory relief handlers and their ids.
+    std::vector<std::pair<size_t, ReliefHandler> > relief_handlers_;
+
+    //! memory statistics of DIA nodes by their id.
+    std::unordered_map<size_t, DIAMemory>             dia_memory_;
+
     //! I/O layer stats when BlockPool was created.
     io::StatsData                                     io_stats_first_;
 
@@ -141,6 +334,57 @@ struct BlockPool::Data
     io::StatsData                                     io_stats_prev_;
 };
 
+/*!
+ * A swapped ByteBlock being demoted from the fast to the slow tier: its
+ * external memory data is read into buffer_ and written to bid_. If the block
+ * is pinned or destroyed meanwhile, the demotion is canceled by setting
+ * block_ptr_ to nullptr, and the copy is discarded when its I/O completes.
+ */
+struct BlockPool::Demotion
+{
+    Demotion(BlockPool* block_pool, ByteBlock* block_ptr)
+        : block_pool_(block_pool), block_ptr_(block_ptr) { }
+
+    BlockPool* block_pool_;
+
+    //! block being demoted, or nullptr if canceled
+    ByteBlock* block_ptr_;
+
+    //! temporary buffer holding the external memory data
+    Byte* buffer_ = nullptr;
+
+    //! size of the external memory data
+    size_t size_ = 0;
+
+    //! external memory block on the slow tier
+    io::BID<0> bid_;
+
+    //! calls BlockPool::OnDemoteReadComplete
+    void OnReadComplete(io::Request* req, bool success) {
+        return block_pool_->OnDemoteReadComplete(this, req, success);
+    }
+
+    //! calls BlockPool::OnDemoteWriteComplete
+    void OnWriteComplete(io::Request* req, bool success) {
+        return block_pool_->OnDemoteWriteComplete(this, req, success);
+    }
+};
+
+//! Default time after which swapped blocks are demoted to the slow tier: the
+//! environment variable THRILL_DEMOTION_AGE in seconds, default 10.
+static std::chrono::steady_clock::duration DefaultDemotionAge() {
+    static const double seconds = []() {
+        const char* env = getenv("THRILL_DEMOTION_AGE");
+        if (env == nullptr) return 10.0;
+        char* endp;
+        double s = strtod(env, &endp);
+        die_unless(endp != env && *endp == 0 && s >= 0);
+        return s;
+    } ();
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+}
+
 /******************************************************************************/
 // BlockPool
 
@@ -154,10 +398,15 @@ BlockPool::BlockPool(size_t soft_ram_limit, size_t hard_ram_limit,
       mem_manager_(mem_manager, "BlockPool"),
       bm_(io::BlockManager::GetInstance()),
       workers_per_host_(workers_per_host),
+      block_compression_(DefaultBlockCompression()),
       pin_count_(workers_per_host),
       d_(std::make_unique<Data>()),
+      demotion_age_(DefaultDemotionAge()),
       soft_ram_limit_(soft_ram_limit),
       hard_ram_limit_(hard_ram_limit),
+      prefetch_quota_(hard_ram_limit != 0
+                      ? hard_ram_limit / 8
+                      : 64 * default_block_size * workers_per_host),
       tp_last_(std::chrono::steady_clock::now()) {
 
     die_unless(hard_ram_limit >= soft_ram_limit);
@@ -213,6 +462,7 @@ BlockPool::~BlockPool() {
     }
 
     die_unless(writing_bytes_ == 0);
+    die_unless(compress_bytes_ == 0);
 
     // check that not reading any block.
     while (d_->reading_.begin() != d_->reading_.end()) {
@@ -224,6 +474,9 @@ BlockPool::~BlockPool() {
             << "BlockPool::~BlockPool() block=" << block_ptr
             << " is currently begin read from external memory, waiting.";
 
+        if (read->queued_)
+            IntIssueQueuedRead(read.get());
+
         lock.unlock();
         // wait for I/O request for completion and the I/O handler.
         read->req_->wait();
@@ -238,6 +491,9 @@ BlockPool::~BlockPool() {
     cv_total_byte_blocks_.wait(
         lock, [this]() { return total_byte_blocks_ == 0; });
 
+    // destroying the blocks canceled their demotions, wait for their I/O.
+    cv_read_complete_.wait(lock, [this]() { return demoting_ == 0; });
+
     pin_count_.AssertZero();
     die_unequal(total_ram_bytes_, 0);
     die_unequal(d_->unpinned_blocks_.size(), 0);
@@ -275,7 +531,11 @@ BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     // allocate block memory. -- unlock mutex for that time, since it may
     // require block eviction.
     lock.unlock();
-    Byte* data = aligned_alloc_.allocate(size);
+    Byte* data = AllocateData(size);
+    // place the pages on the NUMA node of the allocating worker.
+    common::NumaPreferMemory(
+        data, size,
+        common::NumaNodeOfWorker(local_worker_id, workers_per_host_));
     lock.lock();
 
     // create common::CountingPtr, no need for special make_shared()-equivalent
@@ -315,13 +575,135 @@ ByteBlockPtr BlockPool::MapExternalBlock(
     return block_ptr;
 }
 
+ByteBlockPtr BlockPool::MapMemoryBlock(
+    const io::FileMappingPtr& mapping, size_t offset, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(offset + size <= mapping->size());
+    ByteBlockPtr block_ptr(
+        mem::GPool().make<ByteBlock>(this, mapping, offset, size));
+    ++total_byte_blocks_;
+    ++mapped_blocks_;
+    mapped_bytes_ += size;
+
+    LOGC(debug_blc)
+        << "BlockPool::MapMemoryBlock()"
+        << " ptr=" << block_ptr.get()
+        << " offset=" << offset
+        << " size=" << size;
+
+    return block_ptr;
+}
+
+Byte* BlockPool::AllocateData(size_t size) {
+    if (mem::HugePageArena* arena = mem::GHugePageArena()) {
+        if (void* ptr = arena->allocate(size)) {
+            mem_manager_.add(size);
+            return static_cast<Byte*>(ptr);
+        }
+    }
+    return aligned_alloc_.allocate(size);
+}
+
+void BlockPool::DeallocateData(Byte* data, size_t size) {
+    if (mem::HugePageArena* arena = mem::GHugePageArena()) {
+        if (arena->owns(data)) {
+            arena->deallocate(data, size);
+            mem_manager_.subtract(size);
+            return;
+        }
+    }
+    aligned_alloc_.deallocate(data, size);
+}
+
 //! Pins a block by swapping it in if required.
 PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
-    assert(local_worker_id < workers_per_host_);
+    return IntPinBlock(block, local_worker_id, /* read_ahead */ false,
+                       std::chrono::steady_clock::time_point());
+}
+
+PinRequestPtr BlockPool::PinBlockReadAhead(
+    const Block& block, size_t local_worker_id,
+    const std::chrono::steady_clock::time_point& deadline) {
+    return IntPinBlock(block, local_worker_id, /* read_ahead */ true, deadline);
+}
+
+bool BlockPool::PrefetchBlock(const Block& block, size_t local_worker_id) {
+    ByteBlock* block_ptr = block.byte_block().get();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (block_ptr->in_memory() || block_ptr->total_pins_ != 0 ||
+            d_->writing_.count(block_ptr) || d_->reading_.count(block_ptr))
+            return true;
+
+        const size_t limit =
+            soft_ram_limit_ != 0 ? soft_ram_limit_ : hard_ram_limit_;
+        if (limit != 0 &&
+            total_ram_bytes_ + requested_bytes_ + block_ptr->size() > limit)
+            return false;
+    }
+
+    LOGC(debug_em)
+        << "BlockPool::PrefetchBlock() block=" << block_ptr;
+
+    // the PinRequest is held by reading_ until the read completes, after
+    // which the pin is released.
+    IntPinBlock(block, local_worker_id, /* read_ahead */ true,
+                std::chrono::steady_clock::time_point::max());
+    return true;
+}
+
+void BlockPool::set_read_ahead_depth(size_t depth) {
     std::unique_lock<std::mutex> lock(mutex_);
+    read_ahead_depth_ = std::max<size_t>(depth, 1);
+    for (auto& q : d_->read_ahead_)
+        IntScheduleReadAhead(q.first);
+}
+
+bool BlockPool::RequestPrefetchQuota(size_t bytes) {
+    size_t reserved = prefetch_reserved_.load(std::memory_order_relaxed);
+    do {
+        if (reserved + bytes > prefetch_quota_) return false;
+    } while (!prefetch_reserved_.compare_exchange_weak(
+                 reserved, reserved + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+void BlockPool::ReleasePrefetchQuota(size_t bytes) {
+    assert(prefetch_reserved_ >= bytes);
+    prefetch_reserved_ -= bytes;
+}
+
+PinRequestPtr BlockPool::IntPinBlock(
+    const Block& block, size_t local_worker_id, bool read_ahead,
+    const std::chrono::steady_clock::time_point& deadline) {
+    assert(local_worker_id < workers_per_host_);
 
     ByteBlock* block_ptr = block.byte_block().get();
 
+    if (IntTryIncBlockPinCount(block_ptr, local_worker_id)) {
+        // fast path: Block is already pinned by the thread, which only
+        // requires incrementing its counters without locking.
+
+        LOGC(debug_pin)
+            << "BlockPool::PinBlock block=" << &block
+            << " already pinned by thread";
+
+        return PinRequestPtr(mem::GPool().make<PinRequest>(
+                                 this, PinnedBlock(block, local_worker_id)));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (d_->compressing_.count(block_ptr)) {
+        // the block is being compressed for eviction: wait and start over,
+        // which cancels the write.
+        while (d_->compressing_.count(block_ptr))
+            cv_compressed_.wait(lock);
+        lock.unlock();
+        return IntPinBlock(block, local_worker_id, read_ahead, deadline);
+    }
+
     if (block_ptr->pin_count_[local_worker_id] > 0) {
         // We may get a Block who's underlying is already pinned, since
         // PinnedBlock become Blocks when transfered between Files or delivered
@@ -359,6 +741,26 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
+    if (block_ptr->mapping_) {
+        // block points into a memory mapped file: start paging it in.
+        --mapped_blocks_;
+        mapped_bytes_ -= block_ptr->size();
+
+        IntIncBlockPinCount(block_ptr, local_worker_id);
+        pin_count_.Increment(local_worker_id, block_ptr->size());
+        lock.unlock();
+
+        io::FileMapping::AdviseWillNeed(block_ptr->data_, block_ptr->size());
+
+        LOGC(debug_pin)
+            << "BlockPool::PinBlock block=" << &block
+            << " pinned from memory mapped file"
+            << pin_count_;
+
+        return PinRequestPtr(mem::GPool().make<PinRequest>(
+                                 this, PinnedBlock(block, local_worker_id)));
+    }
+
     // check that not writing the block.
     WritingMap::iterator write_it;
     while ((write_it = d_->writing_.find(block_ptr)) != d_->writing_.end()) {
@@ -427,9 +829,17 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
 
     die_unless(block_ptr->em_bid_.storage);
 
+    // the demotion's copy is superseded, since the block is read back
+    IntCancelDemotion(block_ptr);
+
+    // compressed blocks are read into a temporary buffer, which is charged
+    // until it is decompressed in OnReadComplete().
+    const size_t em_buffer_size =
+        block_ptr->em_compressed_size_ != 0 ? block_ptr->em_bid_.size : 0;
+
     // maybe blocking call until memory is available, this also swaps out other
     // blocks.
-    IntRequestInternalMemory(lock, block_ptr->size());
+    IntRequestInternalMemory(lock, block_ptr->size() + em_buffer_size);
 
     // the requested memory is already counted as a pin.
     pin_count_.Increment(local_worker_id, block_ptr->size());
@@ -443,32 +853,92 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
 
     // allocate block memory.
     lock.unlock();
-    Byte* data = read->byte_block()->data_ =
-                     aligned_alloc_.allocate(block_ptr->size());
+    read->byte_block()->data_ = AllocateData(block_ptr->size());
+    common::NumaPreferMemory(
+        read->byte_block()->data_, block_ptr->size(),
+        common::NumaNodeOfWorker(local_worker_id, workers_per_host_));
+    if (em_buffer_size != 0)
+        read->em_buffer_ = AllocateData(em_buffer_size);
     lock.lock();
 
-    if (!block_ptr->ext_file_) {
-        d_->swapped_.erase(block_ptr);
-        swapped_bytes_ -= block_ptr->size();
-    }
+    if (!block_ptr->ext_file_)
+        IntRemoveSwapped(block_ptr);
 
     LOGC(debug_em)
         << "BlockPool::PinBlock block=" << &block
         << " requested from external memory"
+        << " read_ahead=" << read_ahead
         << pin_count_;
 
+    reading_bytes_ += block_ptr->size();
+
+    read->queue_id_ = block_ptr->em_bid_.storage->get_queue_id();
+    ReadAheadQueue& queue = d_->read_ahead_[read->queue_id_];
+
+    if (read_ahead && queue.in_flight >= read_ahead_depth_) {
+        // disk is busy: queue the read until a slot is free or it is needed
+        read->queued_ = true;
+        queue.queued.emplace(deadline, read.get());
+    }
+    else {
+        IntIssueRead(read.get(), read_ahead ? io::Request::PREFETCH_READ
+                     : io::Request::DEMAND_READ);
+    }
+
+    return read;
+}
+
+void BlockPool::IntIssueRead(
+    PinRequest* read, io::Request::Priority priority) {
+    ByteBlock* block_ptr = read->block_.byte_block().get();
+
+    Byte* data = read->byte_block()->data_;
+    size_t read_size = block_ptr->size();
+    if (read->em_buffer_) {
+        data = read->em_buffer_;
+        read_size = block_ptr->em_bid_.size;
+    }
+
+    ++d_->read_ahead_[read->queue_id_].in_flight;
+    read->issued_ = std::chrono::steady_clock::now();
+
     // issue I/O request, hold the reference to the request in the hashmap
     read->req_ =
         block_ptr->em_bid_.storage->aread(
             // parameters for the read
-            data, block_ptr->em_bid_.offset, block_ptr->size(),
+            data, block_ptr->em_bid_.offset, read_size,
             // construct an immediate CompletionHandler callback
             io::CompletionHandler::make<
-                PinRequest, & PinRequest::OnComplete>(*read));
+                PinRequest, & PinRequest::OnComplete>(*read),
+            priority);
+}
 
-    reading_bytes_ += block_ptr->size();
+void BlockPool::IntIssueQueuedRead(PinRequest* read) {
+    die_unless(read->queued_);
+    auto& queued = d_->read_ahead_[read->queue_id_].queued;
 
-    return read;
+    ByteBlock* block_ptr = read->block_.byte_block().get();
+    LOGC(debug_em)
+        << "BlockPool::IntIssueQueuedRead block=" << block_ptr
+        << " is needed now, issuing read before its deadline.";
+
+    for (auto it = queued.begin(); it != queued.end(); ++it) {
+        if (it->second != read) continue;
+        queued.erase(it);
+        break;
+    }
+    read->queued_ = false;
+    IntIssueRead(read, io::Request::DEMAND_READ);
+}
+
+void BlockPool::IntScheduleReadAhead(int queue_id) {
+    ReadAheadQueue& queue = d_->read_ahead_[queue_id];
+    while (queue.in_flight < read_ahead_depth_ && !queue.queued.empty()) {
+        PinRequest* read = queue.queued.begin()->second;
+        queue.queued.erase(queue.queued.begin());
+        read->queued_ = false;
+        IntIssueRead(read, io::Request::PREFETCH_READ);
+    }
 }
 
 void PinRequest::OnComplete(io::Request* req, bool success) {
@@ -477,11 +947,19 @@ void PinRequest::OnComplete(io::Request* req, bool success) {
 
 void BlockPool::OnReadComplete(
     PinRequest* read, io::Request* req, bool success) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
     ByteBlock* block_ptr = read->block_.byte_block().get();
     size_t block_size = block_ptr->size();
 
+    // decompress without holding the mutex: the PinRequest holds the block,
+    // and other pins wait until it is ready.
+    if (success && read->em_buffer_) {
+        die_unless(BlockDecompress(
+                       read->em_buffer_, block_ptr->em_compressed_size_,
+                       read->byte_block()->data_, block_size));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
     LOGC(debug_em)
         << "OnReadComplete():"
         << " req " << req << " block " << block_ptr
@@ -494,13 +972,16 @@ void BlockPool::OnReadComplete(
         // request was canceled. this is not an I/O error, but intentional,
         // e.g. because the Block was deleted.
 
-        if (!block_ptr->ext_file_) {
-            d_->swapped_.insert(block_ptr);
-            swapped_bytes_ += block_size;
-        }
+        if (!block_ptr->ext_file_)
+            IntAddSwapped(block_ptr);
 
         // release memory
-        aligned_alloc_.deallocate(read->byte_block()->data_, block_size);
+        DeallocateData(read->byte_block()->data_, block_size);
+        if (read->em_buffer_) {
+            DeallocateData(read->em_buffer_, block_ptr->em_bid_.size);
+            read->em_buffer_ = nullptr;
+            IntReleaseInternalMemory(block_ptr->em_bid_.size);
+        }
 
         IntReleaseInternalMemory(block_size);
 
@@ -512,17 +993,38 @@ void BlockPool::OnReadComplete(
     }
     else    // success
     {
+        if (read->em_buffer_) {
+            DeallocateData(read->em_buffer_, block_ptr->em_bid_.size);
+            read->em_buffer_ = nullptr;
+            IntReleaseInternalMemory(block_ptr->em_bid_.size);
+        }
+
+        logger_ << "class" << "BlockPool"
+                << "event" << "read"
+                << "bytes" << block_size
+                << "em_bytes" << block_ptr->em_bid_.size
+                << "read_ahead"
+                << (req->priority() == io::Request::PREFETCH_READ)
+                << "duration" << MicrosecondsSince(read->issued_);
+
+        IntDIAReadBlock(block_ptr);
+
         // set pin on ByteBlock
         IntIncBlockPinCount(block_ptr, read->block_.local_worker_id_);
 
         if (!block_ptr->ext_file_) {
             bm_->delete_block(block_ptr->em_bid_);
             block_ptr->em_bid_ = io::BID<0>();
+            block_ptr->em_compressed_size_ = 0;
         }
     }
 
     read->ready_ = true;
     reading_bytes_ -= block_size;
+
+    // disk has a free read slot: issue the next queued read-ahead.
+    --d_->read_ahead_[read->queue_id_].in_flight;
+    IntScheduleReadAhead(read->queue_id_);
     cv_read_complete_.notify_all();
 
     // remove the PinRequest from the hash map. The problem here is that the
@@ -538,36 +1040,62 @@ void BlockPool::OnReadComplete(
 }
 
 void BlockPool::IncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
-    std::unique_lock<std::mutex> lock(mutex_);
     assert(local_worker_id < workers_per_host_);
+    // the caller holds a pin of local_worker_id, hence the Block cannot be
+    // unpinned concurrently, and no state guarded by the mutex changes.
     die_unless(block_ptr->pin_count_[local_worker_id] > 0);
     return IntIncBlockPinCount(block_ptr, local_worker_id);
 }
 
+bool BlockPool::IntTryIncBlockPinCount(
+    ByteBlock* block_ptr, size_t local_worker_id) {
+    assert(local_worker_id < workers_per_host_);
+
+    std::atomic<size_t>& pc = block_ptr->pin_count_[local_worker_id];
+    size_t p = pc.load();
+    while (p > 0) {
+        if (pc.compare_exchange_weak(p, p + 1))
+            return true;
+    }
+    return false;
+}
+
 void BlockPool::IntIncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
     assert(local_worker_id < workers_per_host_);
 
-    ++block_ptr->pin_count_[local_worker_id];
-    ++block_ptr->total_pins_;
+    // total_pins_ counts the thread_ids with pins, it changes only on the
+    // first pin of a thread_id, which always happens with the mutex locked.
+    if (block_ptr->pin_count_[local_worker_id]++ == 0)
+        ++block_ptr->total_pins_;
 
     LOGC(debug_pin)
         << "BlockPool::IncBlockPinCount()"
         << " block=" << block_ptr
         << " ++block.pin_count[" << local_worker_id << "]="
-        << block_ptr->pin_count_[local_worker_id]
+        << block_ptr->pin_count_[local_worker_id].load()
         << " ++block.total_pins_=" << block_ptr->total_pins_
         << pin_count_;
 }
 
 void BlockPool::DecBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
     assert(local_worker_id < workers_per_host_);
+
+    // fast path: if the thread keeps a pin, only decrement its counter
+    // without locking.
+    std::atomic<size_t>& pc = block_ptr->pin_count_[local_worker_id];
+    size_t p0 = pc.load();
+    while (p0 > 1) {
+        if (pc.compare_exchange_weak(p0, p0 - 1))
+            return;
+    }
+
+    // last pin of the thread: the Block may become unpinned.
+    std::unique_lock<std::mutex> lock(mutex_);
     die_unless(block_ptr->pin_count_[local_worker_id] > 0);
     die_unless(block_ptr->total_pins_ > 0);
 
     size_t p = --block_ptr->pin_count_[local_worker_id];
-    size_t tp = --block_ptr->total_pins_;
+    size_t tp = p == 0 ? --block_ptr->total_pins_ : block_ptr->total_pins_;
 
     LOGC(debug_pin)
         << "BlockPool::DecBlockPinCount()"
@@ -595,6 +1123,13 @@ void BlockPool::IntUnpinBlock(ByteBlock* block_ptr, size_t local_worker_id) {
         return;
     }
 
+    if (block_ptr->mapping_) {
+        // memory mapped blocks are never evicted, the kernel drops their pages.
+        ++mapped_blocks_;
+        mapped_bytes_ += block_ptr->size();
+        return;
+    }
+
     // if all per-thread pins are zero, allow this Block to be swapped out.
     die_unless(!d_->unpinned_blocks_.exists(block_ptr));
     d_->unpinned_blocks_.put(block_ptr);
@@ -622,7 +1157,8 @@ size_t BlockPool::int_total_blocks() noexcept {
         << " reading_.size()=" << d_->reading_.size();
 
     return pin_count_.total_pins_
-           + d_->unpinned_blocks_.size() + d_->writing_.size()
+           + d_->unpinned_blocks_.size() + mapped_blocks_
+           + d_->writing_.size() + d_->compressing_.size()
            + d_->swapped_.size() + d_->reading_.size();
 }
 
@@ -640,7 +1176,7 @@ size_t BlockPool::int_total_bytes() noexcept {
         << " reading_bytes_=" << reading_bytes_;
 
     return pin_count_.total_pinned_bytes_
-           + unpinned_bytes_ + writing_bytes_
+           + unpinned_bytes_ + mapped_bytes_ + writing_bytes_
            + swapped_bytes_ + reading_bytes_;
 }
 
@@ -669,6 +1205,27 @@ size_t BlockPool::reading_blocks() noexcept {
     return d_->reading_.size();
 }
 
+size_t BlockPool::swapped_blocks(size_t tier) noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return tier_swapped_blocks_[tier];
+}
+
+size_t BlockPool::swapped_bytes(size_t tier) noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return tier_swapped_bytes_[tier];
+}
+
+size_t BlockPool::demoted_blocks() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return demoted_blocks_;
+}
+
+bool BlockPool::below_soft_limit() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return soft_ram_limit_ == 0 ||
+           total_ram_bytes_ + requested_bytes_ <= soft_ram_limit_;
+}
+
 void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     LOGC(debug_blc)
         << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
@@ -681,6 +1238,10 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     // pinned blocks cannot be destroyed since they are always unpinned first
     die_unless(block_ptr->total_pins_ == 0);
 
+    // wait until the write of a block being compressed is issued.
+    while (d_->compressing_.count(block_ptr))
+        cv_compressed_.wait(lock);
+
     do {
         if (block_ptr->in_memory())
         {
@@ -709,6 +1270,9 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
             // block was being pinned. cancel read operation
             ReadingMap::iterator it = d_->reading_.find(block_ptr);
             if (it != d_->reading_.end()) {
+                // a queued read-ahead is issued to be canceled like others.
+                if (it->second->queued_)
+                    IntIssueQueuedRead(it->second.get());
                 // get reference count to request, since complete handler
                 // removes it from the map.
                 io::RequestPtr req = it->second->req_;
@@ -729,7 +1293,19 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     }
     while (0); // NOLINT
 
-    if (block_ptr->ext_file_ && block_ptr->in_memory())
+    if (block_ptr->mapping_)
+    {
+        LOGC(debug_blc)
+            << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
+            << " memory mapped block, release reference to mapping";
+
+        --mapped_blocks_;
+        mapped_bytes_ -= block_ptr->size();
+
+        block_ptr->data_ = nullptr;
+        block_ptr->mapping_.reset();
+    }
+    else if (block_ptr->ext_file_ && block_ptr->in_memory())
     {
         LOGC(debug_blc)
             << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
@@ -740,10 +1316,11 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         unpinned_bytes_ -= block_ptr->size();
 
         // release memory
-        aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         IntReleaseInternalMemory(block_ptr->size());
+        IntDIASubtractRam(block_ptr->dia_id_, block_ptr->size());
     }
     else if (block_ptr->ext_file_)
     {
@@ -763,10 +1340,11 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         unpinned_bytes_ -= block_ptr->size();
 
         // release memory
-        aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         IntReleaseInternalMemory(block_ptr->size());
+        IntDIASubtractRam(block_ptr->dia_id_, block_ptr->size());
     }
     else
     {
@@ -774,11 +1352,8 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
             << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
             << " block in external memory, delete block";
 
-        auto it = d_->swapped_.find(block_ptr);
-        die_unless(it != d_->swapped_.end());
-
-        d_->swapped_.erase(it);
-        swapped_bytes_ -= block_ptr->size();
+        IntCancelDemotion(block_ptr);
+        IntRemoveSwapped(block_ptr);
 
         bm_->delete_block(block_ptr->em_bid_);
         block_ptr->em_bid_ = io::BID<0>();
@@ -789,9 +1364,10 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     cv_total_byte_blocks_.notify_all();
 }
 
-void BlockPool::RequestInternalMemory(size_t size) {
+void BlockPool::RequestInternalMemory(size_t size, size_t dia_id) {
     std::unique_lock<std::mutex> lock(mutex_);
-    return IntRequestInternalMemory(lock, size);
+    IntRequestInternalMemory(lock, size);
+    IntDIAAddRam(dia_id, size);
 }
 
 void BlockPool::IntRequestInternalMemory(
@@ -813,10 +1389,21 @@ void BlockPool::IntRequestInternalMemory(
 
     while (soft_ram_limit_ != 0 &&
            d_->unpinned_blocks_.size() &&
-           total_ram_bytes_ + requested_bytes_ > soft_ram_limit_ + writing_bytes_)
+           total_ram_bytes_ + requested_bytes_ >
+           soft_ram_limit_ + IntWritingRamBytes())
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        IntEvictBlockLRU();
+        IntEvictBlockLRU(lock);
+    }
+
+    // no blocks can be evicted, hence ask the DIA nodes to spill early.
+    if (soft_ram_limit_ != 0 &&
+        total_ram_bytes_ + requested_bytes_ >
+        soft_ram_limit_ + IntWritingRamBytes())
+    {
+        IntSignalPressure(
+            total_ram_bytes_ + requested_bytes_
+            - soft_ram_limit_ - IntWritingRamBytes());
     }
 
     // wait up to 60 seconds for other threads to free up memory or pins
@@ -829,10 +1416,18 @@ void BlockPool::IntRequestInternalMemory(
     {
         while (hard_ram_limit_ != 0 &&
                d_->unpinned_blocks_.size() &&
-               total_ram_bytes_ + requested_bytes_ > hard_ram_limit_ + writing_bytes_)
+               total_ram_bytes_ + requested_bytes_ >
+               hard_ram_limit_ + IntWritingRamBytes())
         {
             // evict blocks: schedule async writing which increases writing_bytes_.
-            IntEvictBlockLRU();
+            IntEvictBlockLRU(lock);
+        }
+
+        if (total_ram_bytes_ + requested_bytes_ >
+            hard_ram_limit_ + IntWritingRamBytes()) {
+            IntSignalPressure(
+                total_ram_bytes_ + requested_bytes_
+                - hard_ram_limit_ - IntWritingRamBytes());
         }
 
         cv_memory_change_.wait_for(lock, std::chrono::seconds(1));
@@ -892,15 +1487,72 @@ void BlockPool::AdviseFree(size_t size) {
         << " swapped_.size()=" << d_->swapped_.size();
 
     while (soft_ram_limit_ != 0 && d_->unpinned_blocks_.size() &&
-           total_ram_bytes_ + requested_bytes_ + size > hard_ram_limit_ + writing_bytes_)
+           total_ram_bytes_ + requested_bytes_ + size >
+           hard_ram_limit_ + IntWritingRamBytes())
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        IntEvictBlockLRU();
+        IntEvictBlockLRU(lock);
     }
 }
-void BlockPool::ReleaseInternalMemory(size_t size) {
+size_t BlockPool::AddPressureHandler(const PressureHandler& handler) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t id = next_pressure_id_++;
+    d_->pressure_handlers_.emplace_back(id, handler);
+    return id;
+}
+
+void BlockPool::RemovePressureHandler(size_t id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& handlers = d_->pressure_handlers_;
+    handlers.erase(
+        std::remove_if(handlers.begin(), handlers.end(),
+                       [id](const std::pair<size_t, PressureHandler>& h) {
+                           return h.first == id;
+                       }),
+        handlers.end());
+}
+
+void BlockPool::IntSignalPressure(size_t bytes) {
+    LOGC(debug_mem)
+        << "BlockPool::IntSignalPressure()"
+        << " bytes=" << bytes
+        << " handlers=" << d_->pressure_handlers_.size();
+
+    for (const std::pair<size_t, PressureHandler>& h : d_->pressure_handlers_)
+        h.second(bytes);
+}
+
+size_t BlockPool::AddReliefHandler(const ReliefHandler& handler) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t id = next_pressure_id_++;
+    d_->relief_handlers_.emplace_back(id, handler);
+    return id;
+}
+
+void BlockPool::RemoveReliefHandler(size_t id) {
     std::unique_lock<std::mutex> lock(mutex_);
-    return IntReleaseInternalMemory(size);
+    auto& handlers = d_->relief_handlers_;
+    handlers.erase(
+        std::remove_if(handlers.begin(), handlers.end(),
+                       [id](const std::pair<size_t, ReliefHandler>& h) {
+                           return h.first == id;
+                       }),
+        handlers.end());
+}
+
+void BlockPool::IntSignalRelief() {
+    LOGC(debug_mem)
+        << "BlockPool::IntSignalRelief()"
+        << " handlers=" << d_->relief_handlers_.size();
+
+    for (const std::pair<size_t, ReliefHandler>& h : d_->relief_handlers_)
+        h.second();
+}
+
+void BlockPool::ReleaseInternalMemory(size_t size, size_t dia_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    IntReleaseInternalMemory(size);
+    IntDIASubtractRam(dia_id, size);
 }
 
 void BlockPool::IntReleaseInternalMemory(size_t size) {
@@ -911,11 +1563,82 @@ void BlockPool::IntReleaseInternalMemory(size_t size) {
         << " total_ram_bytes_=" << total_ram_bytes_;
 
     die_unless(total_ram_bytes_ >= size);
+    bool above_soft_limit =
+        total_ram_bytes_ + requested_bytes_ > soft_ram_limit_;
     total_ram_bytes_ -= size;
 
     cv_memory_change_.notify_all();
+
+    if (soft_ram_limit_ != 0 && above_soft_limit &&
+        total_ram_bytes_ + requested_bytes_ <= soft_ram_limit_)
+        IntSignalRelief();
 }
 
+/******************************************************************************/
+// BlockPool Memory Attribution to DIA Nodes
+
+void BlockPool::AttributeToDIA(ByteBlock* block_ptr, size_t dia_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (dia_id == 0 || block_ptr->dia_id_ != 0 || block_ptr->mapping_)
+        return;
+
+    block_ptr->dia_id_ = dia_id;
+    if (block_ptr->in_memory())
+        IntDIAAddRam(dia_id, block_ptr->size());
+}
+
+BlockPool::DIAMemory BlockPool::dia_memory(size_t dia_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = d_->dia_memory_.find(dia_id);
+    return it != d_->dia_memory_.end() ? it->second : DIAMemory();
+}
+
+BlockPool::DIAMemory BlockPool::TakeDIAMemory(size_t dia_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = d_->dia_memory_.find(dia_id);
+    if (it == d_->dia_memory_.end()) return DIAMemory();
+    DIAMemory m = it->second;
+    d_->dia_memory_.erase(it);
+    return m;
+}
+
+void BlockPool::IntDIAAddRam(size_t dia_id, size_t bytes) {
+    if (dia_id == 0 || bytes == 0) return;
+    DIAMemory& m = d_->dia_memory_[dia_id];
+    m.ram_bytes += bytes;
+    m.peak_ram_bytes = std::max(m.peak_ram_bytes, m.ram_bytes);
+}
+
+void BlockPool::IntDIASubtractRam(size_t dia_id, size_t bytes) {
+    if (dia_id == 0) return;
+    // the statistics are taken when the DIA node is destroyed, but its
+    // ByteBlocks may live on in other Files.
+    auto it = d_->dia_memory_.find(dia_id);
+    if (it == d_->dia_memory_.end()) return;
+    it->second.ram_bytes -= std::min(it->second.ram_bytes, bytes);
+}
+
+void BlockPool::IntDIAEvictBlock(ByteBlock* block_ptr) {
+    if (block_ptr->dia_id_ == 0) return;
+    auto it = d_->dia_memory_.find(block_ptr->dia_id_);
+    if (it == d_->dia_memory_.end()) return;
+    it->second.ram_bytes -= std::min(it->second.ram_bytes, block_ptr->size());
+    it->second.evicted_bytes += block_ptr->size();
+}
+
+void BlockPool::IntDIAReadBlock(ByteBlock* block_ptr) {
+    if (block_ptr->dia_id_ == 0) return;
+    auto it = d_->dia_memory_.find(block_ptr->dia_id_);
+    if (it == d_->dia_memory_.end()) return;
+    DIAMemory& m = it->second;
+    m.ram_bytes += block_ptr->size();
+    m.peak_ram_bytes = std::max(m.peak_ram_bytes, m.ram_bytes);
+    m.read_bytes += block_ptr->size();
+}
+
+/******************************************************************************/
+
 void BlockPool::EvictBlock(ByteBlock* block_ptr) {
     std::unique_lock<std::mutex> lock(mutex_);
 
@@ -925,7 +1648,32 @@ void BlockPool::EvictBlock(ByteBlock* block_ptr) {
     d_->unpinned_blocks_.erase(block_ptr);
     unpinned_bytes_ -= block_ptr->size();
 
-    IntEvictBlock(block_ptr);
+    IntEvictBlock(lock, block_ptr);
+}
+
+EvictionPolicy BlockPool::eviction_policy() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->unpinned_blocks_.policy();
+}
+
+void BlockPool::set_eviction_policy(EvictionPolicy policy) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->unpinned_blocks_.set_policy(policy);
+}
+
+void BlockPool::SetEvictionHint(ByteBlock* block_ptr, EvictionHint hint) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (block_ptr->eviction_hint_ == hint) return;
+
+    if (block_ptr->total_pins_ == 0 && d_->unpinned_blocks_.exists(block_ptr)) {
+        // reorder block among the eviction candidates
+        d_->unpinned_blocks_.erase(block_ptr);
+        block_ptr->eviction_hint_ = hint;
+        d_->unpinned_blocks_.put(block_ptr);
+    }
+    else {
+        block_ptr->eviction_hint_ = hint;
+    }
 }
 
 io::RequestPtr BlockPool::GetAnyWriting() {
@@ -936,10 +1684,11 @@ io::RequestPtr BlockPool::GetAnyWriting() {
 
 io::RequestPtr BlockPool::EvictBlockLRU() {
     std::unique_lock<std::mutex> lock(mutex_);
-    return IntEvictBlockLRU();
+    return IntEvictBlockLRU(lock);
 }
 
-io::RequestPtr BlockPool::IntEvictBlockLRU() {
+io::RequestPtr BlockPool::IntEvictBlockLRU(
+    std::unique_lock<std::mutex>& lock) {
 
     if (!d_->unpinned_blocks_.size()) return io::RequestPtr();
 
@@ -947,10 +1696,11 @@ io::RequestPtr BlockPool::IntEvictBlockLRU() {
     die_unless(block_ptr);
     unpinned_bytes_ -= block_ptr->size();
 
-    return IntEvictBlock(block_ptr);
+    return IntEvictBlock(lock, block_ptr);
 }
 
-io::RequestPtr BlockPool::IntEvictBlock(ByteBlock* block_ptr) {
+io::RequestPtr BlockPool::IntEvictBlock(
+    std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
 
     die_unless(block_ptr->block_pool_ == this);
 
@@ -962,32 +1712,86 @@ io::RequestPtr BlockPool::IntEvictBlock(ByteBlock* block_ptr) {
             << " from ext_file " << block_ptr->ext_file_;
 
         // release memory
-        aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         IntReleaseInternalMemory(block_ptr->size());
+        IntDIAEvictBlock(block_ptr);
         return io::RequestPtr();
     }
 
     die_unless(block_ptr->em_bid_.storage == nullptr);
 
-    // allocate EM block
-    block_ptr->em_bid_.size = block_ptr->size();
-    bm_->new_block(io::FullyRandom(), block_ptr->em_bid_);
+    writing_bytes_ += block_ptr->size();
+
+    // optionally compress the block into a temporary buffer which is written
+    // instead of the data and released in OnWriteComplete(). The buffer is
+    // charged to the RAM until then. The write size is rounded up to the I/O
+    // alignment.
+    Byte* write_data = block_ptr->data_;
+    size_t write_size = block_ptr->size();
+
+    if (block_compression_ && block_ptr->size() > THRILL_DEFAULT_ALIGN)
+    {
+        const size_t size = block_ptr->size();
+        total_ram_bytes_ += size;
+        compress_bytes_ += size;
+
+        // compress without holding the mutex, threads pinning or destroying
+        // the block wait until its write is issued.
+        d_->compressing_.insert(block_ptr);
+        lock.unlock();
+
+        Byte* buffer = AllocateData(size);
+        size_t csize = BlockCompress(
+            block_ptr->data_, size, buffer, size - THRILL_DEFAULT_ALIGN);
+        if (csize == 0)
+            DeallocateData(buffer, size);
+
+        lock.lock();
+        d_->compressing_.erase(block_ptr);
+        cv_compressed_.notify_all();
+
+        if (csize != 0) {
+            block_ptr->em_compressed_size_ = csize;
+            block_ptr->em_buffer_ = buffer;
+            write_data = buffer;
+            write_size = common::IntegerDivRoundUp<size_t>(
+                csize, THRILL_DEFAULT_ALIGN) * THRILL_DEFAULT_ALIGN;
+        }
+        else {
+            compress_bytes_ -= size;
+            IntReleaseInternalMemory(size);
+        }
+    }
+
+    // allocate EM block on the fast tier, unless it is full.
+    std::pair<size_t, size_t> tier = bm_->tier_range(0);
+    if (bm_->tiered() && !bm_->has_space(tier.first, tier.second, write_size))
+        tier = bm_->tier_range(1);
+
+    block_ptr->em_bid_.size = write_size;
+    if (block_ptr->em_stripe_ != ByteBlock::no_stripe)
+        bm_->new_block(io::Striping(tier.first, tier.second),
+                       block_ptr->em_bid_, block_ptr->em_stripe_);
+    else
+        bm_->new_block(io::LeastLoaded(tier.first, tier.second),
+                       block_ptr->em_bid_);
 
     LOGC(debug_em)
         << "EvictBlock(): " << block_ptr << " - " << *block_ptr
         << " to em_bid " << block_ptr->em_bid_;
 
-    writing_bytes_ += block_ptr->size();
+    block_ptr->em_write_issued_ = std::chrono::steady_clock::now();
 
     // initiate writing to EM.
     io::RequestPtr req =
         block_ptr->em_bid_.storage->awrite(
-            block_ptr->data_, block_ptr->em_bid_.offset, block_ptr->size(),
+            write_data, block_ptr->em_bid_.offset, write_size,
             // construct an immediate CompletionHandler callback
             io::CompletionHandler::make<
-                ByteBlock, & ByteBlock::OnWriteComplete>(block_ptr));
+                ByteBlock, & ByteBlock::OnWriteComplete>(block_ptr),
+            io::Request::EVICTION_WRITE);
 
     return (d_->writing_[block_ptr] = std::move(req));
 }
@@ -1005,6 +1809,14 @@ void BlockPool::OnWriteComplete(
     die_unequal(d_->writing_.erase(block_ptr), 1);
     writing_bytes_ -= block_ptr->size();
 
+    // release temporary buffer of compressed data
+    if (block_ptr->em_buffer_) {
+        DeallocateData(block_ptr->em_buffer_, block_ptr->size());
+        block_ptr->em_buffer_ = nullptr;
+        compress_bytes_ -= block_ptr->size();
+        IntReleaseInternalMemory(block_ptr->size());
+    }
+
     if (!success)
     {
         // request was canceled. this is not an I/O error, but intentional,
@@ -1016,23 +1828,176 @@ void BlockPool::OnWriteComplete(
 
         bm_->delete_block(block_ptr->em_bid_);
         block_ptr->em_bid_ = io::BID<0>();
+        block_ptr->em_compressed_size_ = 0;
     }
     else    // success
     {
-        d_->swapped_.insert(block_ptr);
-        swapped_bytes_ += block_ptr->size();
+        logger_ << "class" << "BlockPool"
+                << "event" << "evict"
+                << "bytes" << block_ptr->size()
+                << "em_bytes" << block_ptr->em_bid_.size
+                << "duration" << MicrosecondsSince(block_ptr->em_write_issued_);
+
+        IntAddSwapped(block_ptr);
 
         // release memory
-        aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         IntReleaseInternalMemory(block_ptr->size());
+        IntDIAEvictBlock(block_ptr);
+    }
+}
+
+/******************************************************************************/
+// BlockPool Storage Tiers
+
+void BlockPool::set_demotion_age(
+    const std::chrono::steady_clock::duration& age) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    demotion_age_ = age;
+}
+
+void BlockPool::IntAddSwapped(ByteBlock* block_ptr) {
+    d_->swapped_.insert(block_ptr);
+    swapped_bytes_ += block_ptr->size();
+
+    size_t tier = bm_->disk_tier(block_ptr->em_bid_.storage->get_allocator_id());
+    ++tier_swapped_blocks_[tier];
+    tier_swapped_bytes_[tier] += block_ptr->size();
+
+    if (bm_->tiered() && tier == 0) {
+        block_ptr->em_swapped_at_ = std::chrono::steady_clock::now();
+        d_->fast_tier_.emplace_back(block_ptr->em_swapped_at_, block_ptr);
     }
 }
 
+void BlockPool::IntRemoveSwapped(ByteBlock* block_ptr) {
+    die_unequal(d_->swapped_.erase(block_ptr), 1);
+    swapped_bytes_ -= block_ptr->size();
+
+    size_t tier = bm_->disk_tier(block_ptr->em_bid_.storage->get_allocator_id());
+    --tier_swapped_blocks_[tier];
+    tier_swapped_bytes_[tier] -= block_ptr->size();
+}
+
+void BlockPool::IntDemoteColdBlocks(
+    const std::chrono::steady_clock::time_point& tp) {
+    if (!bm_->tiered()) return;
+
+    std::pair<size_t, size_t> slow = bm_->tier_range(1);
+    FastTierQueue& queue = d_->fast_tier_;
+
+    while (!queue.empty() && demoting_ < demotion_depth_ &&
+           queue.front().first + demotion_age_ <= tp)
+    {
+        ByteBlock* block_ptr = queue.front().second;
+
+        // skip blocks which were swapped in since: they are either not in the
+        // set anymore or were swapped out again later.
+        if (d_->swapped_.find(block_ptr) == d_->swapped_.end() ||
+            block_ptr->em_swapped_at_ != queue.front().first) {
+            queue.pop_front();
+            continue;
+        }
+
+        // retry at the next tick if the slow tier is full
+        size_t size = block_ptr->em_bid_.size;
+        if (!bm_->has_space(slow.first, slow.second, size))
+            break;
+
+        queue.pop_front();
+
+        LOGC(debug_em)
+            << "BlockPool::IntDemoteColdBlocks() block=" << block_ptr
+            << " from em_bid " << block_ptr->em_bid_;
+
+        Demotion* demotion = mem::GPool().make<Demotion>(this, block_ptr);
+        demotion->buffer_ = AllocateData(size);
+        demotion->size_ = demotion->bid_.size = size;
+        d_->demoting_[block_ptr] = demotion;
+        ++demoting_;
+
+        block_ptr->em_bid_.storage->aread(
+            demotion->buffer_, block_ptr->em_bid_.offset, size,
+            io::CompletionHandler::make<
+                Demotion, & Demotion::OnReadComplete>(demotion),
+            io::Request::PREFETCH_READ);
+    }
+}
+
+void BlockPool::IntCancelDemotion(ByteBlock* block_ptr) {
+    auto it = d_->demoting_.find(block_ptr);
+    if (it == d_->demoting_.end()) return;
+
+    it->second->block_ptr_ = nullptr;
+    d_->demoting_.erase(it);
+}
+
+void BlockPool::OnDemoteReadComplete(
+    Demotion* demotion, io::Request* req, bool success) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    req->check_error();
+
+    if (!demotion->block_ptr_ || !success)
+        return IntFinishDemotion(demotion);
+
+    // write copy to the slow tier
+    std::pair<size_t, size_t> slow = bm_->tier_range(1);
+    bm_->new_block(io::LeastLoaded(slow.first, slow.second), demotion->bid_);
+
+    demotion->bid_.storage->awrite(
+        demotion->buffer_, demotion->bid_.offset, demotion->bid_.size,
+        io::CompletionHandler::make<
+            Demotion, & Demotion::OnWriteComplete>(demotion),
+        io::Request::BACKGROUND_WRITE);
+}
+
+void BlockPool::OnDemoteWriteComplete(
+    Demotion* demotion, io::Request* req, bool success) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    req->check_error();
+
+    ByteBlock* block_ptr = demotion->block_ptr_;
+    if (block_ptr && success)
+    {
+        LOGC(debug_em)
+            << "BlockPool::OnDemoteWriteComplete() block=" << block_ptr
+            << " to em_bid " << demotion->bid_;
+
+        // exchange the fast tier's external memory block with the copy.
+        IntRemoveSwapped(block_ptr);
+        bm_->delete_block(block_ptr->em_bid_);
+        block_ptr->em_bid_ = demotion->bid_;
+        demotion->bid_ = io::BID<0>();
+        IntAddSwapped(block_ptr);
+
+        ++demoted_blocks_;
+    }
+
+    IntFinishDemotion(demotion);
+}
+
+void BlockPool::IntFinishDemotion(Demotion* demotion) {
+    if (demotion->block_ptr_)
+        d_->demoting_.erase(demotion->block_ptr_);
+    if (demotion->bid_.storage)
+        bm_->delete_block(demotion->bid_);
+
+    DeallocateData(demotion->buffer_, demotion->size_);
+    mem::GPool().destroy(demotion);
+
+    --demoting_;
+    cv_read_complete_.notify_all();
+}
+
+/******************************************************************************/
+
 void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
     std::unique_lock<std::mutex> lock(mutex_);
 
+    IntDemoteColdBlocks(tp);
+
     io::StatsData stnow(*io::Stats::GetInstance());
     io::StatsData stf = stnow - d_->io_stats_first_;
     io::StatsData stp = stnow - d_->io_stats_prev_;
@@ -1053,13 +2018,19 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << "total_ram_bytes" << total_ram_bytes_
             << "ram_bytes"
             << (unpinned_bytes_ + pin_count_.total_pinned_bytes_
-        + writing_bytes_ + reading_bytes_)
+        + writing_bytes_ + compress_bytes_ + reading_bytes_)
             << "pinned_blocks" << pin_count_.total_pins_
             << "pinned_bytes" << pin_count_.total_pinned_bytes_
             << "unpinned_blocks" << d_->unpinned_blocks_.size()
             << "unpinned_bytes" << unpinned_bytes_
             << "swapped_blocks" << d_->swapped_.size()
             << "swapped_bytes" << swapped_bytes_
+            << "swapped_fast_blocks" << tier_swapped_blocks_[0]
+            << "swapped_fast_bytes" << tier_swapped_bytes_[0]
+            << "swapped_slow_blocks" << tier_swapped_blocks_[1]
+            << "swapped_slow_bytes" << tier_swapped_bytes_[1]
+            << "demoting_blocks" << demoting_
+            << "demoted_blocks" << demoted_blocks_
             << "max_pinned_blocks" << pin_count_.max_pins
             << "max_pinned_bytes" << pin_count_.max_pinned_bytes
             << "writing_blocks" << d_->writing_.size()
@@ -23,6 +23,9 @@
 #include <thrill/mem/manager.hpp>
 #include <thrill/mem/pool.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <functional>
 #include <future>
@@ -37,6 +40,25 @@ namespace data {
 //! \addtogroup data_layer
 //! \{
 
+/*!
+ * Policy by which the BlockPool selects unpinned ByteBlocks to evict.
+ */
+enum class EvictionPolicy {
+    //! evict the least recently unpinned block.
+    LRU,
+    //! 2Q: blocks unpinned for the first time are kept in a FIFO, which is
+    //! evicted first while it holds more than a quarter of all unpinned
+    //! blocks, such that scan-once data does not flush reused blocks.
+    TwoQueue,
+    //! order by the EvictionHint of the blocks: dead, sequential, no hint,
+    //! read again soon. Blocks without hint are evicted in LRU order.
+    Hint
+};
+
+//! Default eviction policy: the environment variable THRILL_EVICTION_POLICY
+//! can be "lru", "2q", or "hint", which is the default.
+EvictionPolicy DefaultEvictionPolicy();
+
 /*!
  * Pool to allocate, keep, swap out/in, and free all ByteBlocks on the host.
  * Starts a backgroud thread which is responsible for disk I/O
@@ -84,29 +106,129 @@ public:
     //! return number of workers per host
     size_t workers_per_host() const { return workers_per_host_; }
 
+    //! return hard limit of RAM, 0 for no limit
+    size_t hard_ram_limit() const { return hard_ram_limit_; }
+
     //! Returns logger_
     common::JsonLogger& logger() { return logger_; }
 
+    //! whether ByteBlocks are compressed when evicted to disk or sent over the
+    //! network.
+    bool block_compression() const { return block_compression_; }
+
+    //! enable or disable block compression, the default is taken from the
+    //! environment variable THRILL_BLOCK_COMPRESSION.
+    void set_block_compression(bool enable) { block_compression_ = enable; }
+
     //! return next unique File id
     size_t next_file_id() { return ++next_file_id_; }
 
+    //! Returns the policy to select blocks for eviction
+    EvictionPolicy eviction_policy();
+
+    //! Change the policy to select blocks for eviction, the default is taken
+    //! from the environment variable THRILL_EVICTION_POLICY.
+    void set_eviction_policy(EvictionPolicy policy);
+
+    //! Set the EvictionHint of a ByteBlock, which reorders it among the
+    //! eviction candidates if it is unpinned.
+    void SetEvictionHint(ByteBlock* block_ptr, EvictionHint hint);
+
     //! Updates the memory manager for internal memory. If the hard limit is
-    //! reached, the call is blocked intil memory is free'd
-    void RequestInternalMemory(size_t size);
+    //! reached, the call is blocked intil memory is free'd. The memory is
+    //! attributed to the DIA node dia_id, if it is not zero.
+    void RequestInternalMemory(size_t size, size_t dia_id = 0);
 
     //! Updates the memory manager for the internal memory, wakes up waiting
     //! BlockPool::RequestInternalMemory calls
-    void ReleaseInternalMemory(size_t size);
+    void ReleaseInternalMemory(size_t size, size_t dia_id = 0);
 
     //! Advice the block pool to free up memory in anticipation of a large
     //! future request.
     void AdviseFree(size_t size);
 
+    //! \name Memory Pressure
+    //! \{
+
+    //! Type of handlers called when memory requests exceed the soft limit and
+    //! no unpinned blocks are left to evict, or while a request waits at the
+    //! hard limit. The argument is the number of bytes missing. Handlers are
+    //! called with the BlockPool mutex held, hence they must not call into the
+    //! BlockPool and should only ask their owner to spill or shrink.
+    using PressureHandler = std::function<void(size_t bytes)>;
+
+    //! Register a memory pressure handler, returns an id for removal.
+    size_t AddPressureHandler(const PressureHandler& handler);
+
+    //! Remove a memory pressure handler.
+    void RemovePressureHandler(size_t id);
+
+    //! Type of handlers called when released memory brings the BlockPool from
+    //! above the soft limit back to or below it. Like PressureHandlers, they
+    //! are called with the BlockPool mutex held.
+    using ReliefHandler = std::function<void()>;
+
+    //! Register a memory relief handler, returns an id for removal.
+    size_t AddReliefHandler(const ReliefHandler& handler);
+
+    //! Remove a memory relief handler.
+    void RemoveReliefHandler(size_t id);
+
+    //! \}
+
+    //! \name Memory Attribution to DIA Nodes
+    //! \{
+
+    //! Memory statistics of the ByteBlocks and reserved internal memory
+    //! attributed to a DIA node.
+    struct DIAMemory {
+        //! bytes currently in RAM
+        size_t ram_bytes = 0;
+        //! maximum of ram_bytes
+        size_t peak_ram_bytes = 0;
+        //! bytes of ByteBlocks evicted from RAM
+        size_t evicted_bytes = 0;
+        //! bytes of ByteBlocks read back into RAM
+        size_t read_bytes = 0;
+    };
+
+    //! Attribute a ByteBlock to the DIA node dia_id: its RAM, evictions and
+    //! reads are counted for the node from now on. Blocks are attributed
+    //! only once, to the first node, and memory mapped blocks never.
+    void AttributeToDIA(ByteBlock* block_ptr, size_t dia_id);
+
+    //! Returns the memory statistics of the DIA node dia_id.
+    DIAMemory dia_memory(size_t dia_id);
+
+    //! Returns and removes the memory statistics of the DIA node dia_id.
+    DIAMemory TakeDIAMemory(size_t dia_id);
+
+    //! \}
+
+    //! \name Storage Tiers
+    //! \{
+
+    //! If io::BlockManager::tiered(), evicted blocks are written to the fast
+    //! tier of flash devices while it has space, and blocks which stayed
+    //! swapped out for longer than demotion_age() are moved to the slow tier
+    //! of regular disks in the background.
+    std::chrono::steady_clock::duration demotion_age() const {
+        return demotion_age_;
+    }
+
+    //! Change the time after which swapped blocks are demoted to the slow
+    //! tier, the default is taken from the environment variable
+    //! THRILL_DEMOTION_AGE in seconds.
+    void set_demotion_age(const std::chrono::steady_clock::duration& age);
+
+    //! \}
+
     //! Return any currently being written block (for waiting on completion)
     io::RequestPtr GetAnyWriting();
 
-    //! Evict a Block from the LRU chain into external memory. This can return
-    //! nullptr if no blocks available, or if the Block was not dirty.
+    //! Evict a Block selected by the EvictionPolicy into external memory. This
+    //! can return nullptr if no blocks available, or if the Block was not
+    //! dirty.
     io::RequestPtr EvictBlockLRU();
 
     //! Allocates a byte block with the request size. May block this thread if
@@ -120,10 +242,19 @@ public:
     ByteBlockPtr MapExternalBlock(
         const io::FileBasePtr& file, int64_t offset, size_t size);
 
+    //! Create a zero-copy byte block pointing into a memory mapped file. The
+    //! block is always in memory, pinning it only advises the kernel to read
+    //! its pages. It is not counted against the RAM limits, since its pages
+    //! belong to the page cache.
+    ByteBlockPtr MapMemoryBlock(
+        const io::FileMappingPtr& mapping, size_t offset, size_t size);
+
     //! Increment a ByteBlock's pin count, requires the pin count to be > 0.
+    //! Does not lock the mutex.
     void IncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
-    //! Decrement a ByteBlock's pin count and possibly unpin it.
+    //! Decrement a ByteBlock's pin count and possibly unpin it. Locks the
+    //! mutex only if the last pin of local_worker_id is removed.
     void DecBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
     //! Destroys the block. Called by ByteBlockPtr's deleter.
@@ -157,6 +288,19 @@ public:
     //! Total number of blocks currently begin read from EM.
     size_t reading_blocks()  noexcept;
 
+    //! Total number of swapped blocks residing in a storage tier
+    size_t swapped_blocks(size_t tier)  noexcept;
+
+    //! Total number of bytes in swapped blocks residing in a storage tier
+    size_t swapped_bytes(size_t tier)  noexcept;
+
+    //! Total number of blocks demoted to the slow storage tier
+    size_t demoted_blocks()  noexcept;
+
+    //! Whether the blocks in RAM and the requested memory are below the soft
+    //! limit, or there is no soft limit.
+    bool below_soft_limit()  noexcept;
+
     //! \}
 
     //! \name Methods for ProfileTask
@@ -169,6 +313,44 @@ public:
     //! Pins a block by swapping it in if required.
     PinRequestPtr PinBlock(const Block& block, size_t local_worker_id);
 
+    //! Pins a block ahead of its use. If it must be read from external memory,
+    //! the read is queued in the host-wide read-ahead scheduler, which issues
+    //! the queued reads of all readers to each disk in order of their
+    //! deadlines, such that at most read_ahead_depth() reads are in flight per
+    //! disk. Waiting on the PinRequest issues the read immediately.
+    PinRequestPtr PinBlockReadAhead(
+        const Block& block, size_t local_worker_id,
+        const std::chrono::steady_clock::time_point& deadline);
+
+    //! maximum number of reads in flight per disk issued by read-ahead
+    size_t read_ahead_depth() const { return read_ahead_depth_; }
+
+    //! set maximum number of reads in flight per disk issued by read-ahead
+    void set_read_ahead_depth(size_t depth);
+
+    //! Speculatively read a swapped out block back into RAM as low-priority
+    //! read-ahead, which is issued after all other queued read-aheads. The
+    //! block is unpinned when the read completes, hence it may be evicted
+    //! again. Does nothing if the block is in RAM or being read or written.
+    //! Returns false without reading if the block does not fit below the soft
+    //! limit, or the hard limit if there is no soft limit.
+    bool PrefetchBlock(const Block& block, size_t local_worker_id);
+
+    //! Reserve bytes of the host-wide quota for prefetching deeper than the
+    //! File readers' initial depth. Returns false if the quota is exhausted.
+    bool RequestPrefetchQuota(size_t bytes);
+
+    //! Return bytes reserved by RequestPrefetchQuota().
+    void ReleasePrefetchQuota(size_t bytes);
+
+    //! host-wide quota of bytes for adaptive prefetching of File readers
+    size_t prefetch_quota() const { return prefetch_quota_; }
+
+    //! set host-wide quota of bytes for adaptive prefetching, the default is
+    //! an eighth of the hard RAM limit, or 64 default-sized Blocks per worker
+    //! if there is no limit.
+    void set_prefetch_quota(size_t bytes) { prefetch_quota_ = bytes; }
+
 private:
     //! locked before internal state is changed
     std::mutex mutex_;
@@ -180,6 +362,9 @@ private:
     //! condition_variable for all read requests).
     std::condition_variable cv_read_complete_;
 
+    //! For waiting on blocks being compressed for eviction
+    std::condition_variable cv_compressed_;
+
     //! reference to HostContext's logger or a null sink
     common::JsonLogger logger_;
 
@@ -198,12 +383,27 @@ private:
     //! number of workers per host
     size_t workers_per_host_;
 
+    //! compress ByteBlocks when evicting them to disk or sending them
+    bool block_compression_;
+
+    //! maximum number of reads in flight per disk issued by read-ahead
+    size_t read_ahead_depth_ = 4;
+
     //! next unique File id
     std::atomic<size_t> next_file_id_ { 0 };
 
     //! number of unpinned bytes
     size_t unpinned_bytes_ = 0;
 
+    //! number of unpinned ByteBlocks pointing into memory mapped files
+    size_t mapped_blocks_ = 0;
+
+    //! number of bytes in unpinned ByteBlocks pointing into mapped files
+    size_t mapped_bytes_ = 0;
+
+    //! next id of a memory pressure or relief handler
+    size_t next_pressure_id_ = 0;
+
     struct PinCount
     {
         //! current total number of pins, where each thread pin counts
@@ -254,12 +454,34 @@ private:
     //! number of bytes currently being written to EM.
     size_t writing_bytes_ = 0;
 
+    //! number of bytes in buffers of compressed blocks being written to EM,
+    //! which are charged to the RAM until the writes complete.
+    size_t compress_bytes_ = 0;
+
     //! total number of bytes in swapped blocks
     size_t swapped_bytes_ = 0;
 
     //! number of bytes currently being read from to EM.
     size_t reading_bytes_ = 0;
 
+    //! number of swapped blocks per storage tier
+    std::array<size_t, io::BlockManager::num_tiers> tier_swapped_blocks_ { };
+
+    //! number of bytes in swapped blocks per storage tier
+    std::array<size_t, io::BlockManager::num_tiers> tier_swapped_bytes_ { };
+
+    //! time after which swapped blocks are demoted to the slow tier
+    std::chrono::steady_clock::duration demotion_age_;
+
+    //! maximum number of demotions in flight
+    size_t demotion_depth_ = 4;
+
+    //! number of demotions in flight, including canceled ones
+    size_t demoting_ = 0;
+
+    //! total number of blocks demoted to the slow tier
+    size_t demoted_blocks_ = 0;
+
     //! total number of ByteBlocks allocated
     size_t total_byte_blocks_ = 0;
 
@@ -278,6 +500,12 @@ private:
     //! is reached. 0 for no limit.
     size_t hard_ram_limit_;
 
+    //! host-wide quota of bytes for adaptive prefetching
+    size_t prefetch_quota_;
+
+    //! bytes reserved from prefetch_quota_
+    std::atomic<size_t> prefetch_reserved_ { 0 };
+
     //! last time statistics where outputted
     std::chrono::steady_clock::time_point tp_last_;
 
@@ -289,25 +517,99 @@ private:
     //! BlockPool::RequestInternalMemory calls
     void IntReleaseInternalMemory(size_t size);
 
+    //! call all memory pressure handlers
+    void IntSignalPressure(size_t bytes);
+
+    //! call all memory relief handlers
+    void IntSignalRelief();
+
+    //! add bytes to the RAM of the DIA node dia_id, and update its peak.
+    void IntDIAAddRam(size_t dia_id, size_t bytes);
+
+    //! subtract bytes from the RAM of the DIA node dia_id.
+    void IntDIASubtractRam(size_t dia_id, size_t bytes);
+
+    //! count the eviction of a block for its DIA node.
+    void IntDIAEvictBlock(ByteBlock* block_ptr);
+
+    //! count reading a block back into RAM for its DIA node.
+    void IntDIAReadBlock(ByteBlock* block_ptr);
+
     //! Increment a ByteBlock's pin count - without locking the mutex
     void IntIncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
+    //! Increment a ByteBlock's pin count without locking the mutex, if it is
+    //! already pinned by local_worker_id. Returns false otherwise.
+    bool IntTryIncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
+
     //! Unpins a block. If all pins are removed, the block might be swapped.
     //! Returns immediately. Actual unpinning is async.
     void IntUnpinBlock(ByteBlock* block_ptr, size_t local_worker_id);
 
+    //! allocate memory of a ByteBlock, from the HugePageArena if enabled
+    Byte * AllocateData(size_t size);
+
+    //! free memory of a ByteBlock allocated with AllocateData()
+    void DeallocateData(Byte* data, size_t size);
+
     //! callback for async write of blocks during eviction
     void OnWriteComplete(ByteBlock* block_ptr, io::Request* req, bool success);
 
     //! callback for async read of blocks for pin requests
     void OnReadComplete(PinRequest* read, io::Request* req, bool success);
 
-    //! Evict a block from the lru list into external memory
-    io::RequestPtr IntEvictBlockLRU();
+    //! Pins a block, possibly queueing the read in the read-ahead scheduler.
+    PinRequestPtr IntPinBlock(
+        const Block& block, size_t local_worker_id, bool read_ahead,
+        const std::chrono::steady_clock::time_point& deadline);
+
+    //! issue the read of a PinRequest with allocated memory to its disk
+    void IntIssueRead(PinRequest* read, io::Request::Priority priority);
+
+    //! remove a PinRequest from the read-ahead scheduler and issue its read
+    void IntIssueQueuedRead(PinRequest* read);
+
+    //! issue queued read-aheads of a disk while it has free read slots
+    void IntScheduleReadAhead(int queue_id);
+
+    //! add a block written to EM to the set of swapped blocks
+    void IntAddSwapped(ByteBlock* block_ptr);
+
+    //! remove a block from the set of swapped blocks
+    void IntRemoveSwapped(ByteBlock* block_ptr);
+
+    //! state of a swapped block which is copied to the slow tier
+    struct Demotion;
+
+    //! start demotions of blocks which are swapped out on the fast tier for
+    //! longer than demotion_age_.
+    void IntDemoteColdBlocks(const std::chrono::steady_clock::time_point& tp);
+
+    //! cancel the demotion of a block, if it is demoted.
+    void IntCancelDemotion(ByteBlock* block_ptr);
+
+    //! callback for async read of a block being demoted
+    void OnDemoteReadComplete(Demotion* demotion, io::Request* req, bool success);
+
+    //! callback for async write of a block being demoted
+    void OnDemoteWriteComplete(Demotion* demotion, io::Request* req, bool success);
+
+    //! release a finished or canceled demotion
+    void IntFinishDemotion(Demotion* demotion);
+
+    //! Evict a block selected by the EvictionPolicy into external memory
+    io::RequestPtr IntEvictBlockLRU(std::unique_lock<std::mutex>& lock);
 
     //! Evict a block into external memory. The block must be unpinned and not
-    //! swapped.
-    io::RequestPtr IntEvictBlock(ByteBlock* block_ptr);
+    //! swapped. The lock is released while the block is compressed.
+    io::RequestPtr IntEvictBlock(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr);
+
+    //! RAM bytes which are released once the writes in flight complete: the
+    //! evicted blocks and the buffers of their compressed data.
+    size_t IntWritingRamBytes() const {
+        return writing_bytes_ + compress_bytes_;
+    }
 
     //! make ostream-able
     friend std::ostream& operator << (std::ostream& os, const PinCount& p);
@@ -336,10 +638,11 @@ private:
 class BlockPoolMemoryHolder
 {
 public:
-    BlockPoolMemoryHolder(BlockPool& block_pool, size_t size)
-        : block_pool_(block_pool), size_(size) {
+    BlockPoolMemoryHolder(BlockPool& block_pool, size_t size,
+                          size_t dia_id = 0)
+        : block_pool_(block_pool), size_(size), dia_id_(dia_id) {
         if (size)
-            block_pool_.RequestInternalMemory(size);
+            block_pool_.RequestInternalMemory(size, dia_id_);
     }
 
     //! non-copyable: delete copy-constructor
@@ -349,12 +652,55 @@ public:
 
     ~BlockPoolMemoryHolder() {
         if (size_)
-            block_pool_.ReleaseInternalMemory(size_);
+            block_pool_.ReleaseInternalMemory(size_, dia_id_);
     }
 
 private:
     BlockPool& block_pool_;
     size_t size_;
+    //! DIA node the memory is attributed to, or zero.
+    size_t dia_id_;
+};
+
+/*!
+ * RAII flag registered as memory pressure handler at a BlockPool. DIA nodes
+ * poll requested() while collecting items, and spill or shrink their
+ * in-memory data when it is set, such that memory requests of other threads
+ * need not wait at the hard limit.
+ */
+class MemoryPressure
+{
+public:
+    explicit MemoryPressure(BlockPool& block_pool)
+        : block_pool_(block_pool),
+          id_(block_pool_.AddPressureHandler(
+                  [this](size_t bytes) { requested_ += bytes; })) { }
+
+    //! non-copyable: delete copy-constructor
+    MemoryPressure(const MemoryPressure&) = delete;
+    //! non-copyable: delete assignment operator
+    MemoryPressure& operator = (const MemoryPressure&) = delete;
+
+    ~MemoryPressure() {
+        block_pool_.RemovePressureHandler(id_);
+    }
+
+    //! whether the BlockPool asked to release memory since the last Take()
+    bool requested() const {
+        return requested_.load(std::memory_order_relaxed) != 0;
+    }
+
+    //! returns the number of bytes requested and resets the flag
+    size_t Take() { return requested_.exchange(0); }
+
+private:
+    BlockPool& block_pool_;
+
+    //! number of bytes requested since the last Take()
+    std::atomic<size_t> requested_ { 0 };
+
+    //! id of the registered handler
+    size_t id_;
 };
 
 //! \}
@@ -21,7 +21,9 @@
 #include <thrill/data/serialization.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -78,6 +80,13 @@ public:
     //! Returns typecode_verify_
     size_t typecode_verify() const { return typecode_verify_; }
 
+    //! Returns whether integral items are delta decoded.
+    bool delta_coding() const { return delta_coding_; }
+
+    //! Enable or disable decoding of integral items written by a BlockWriter
+    //! with delta coding. Only sequential reading via Next() is supported.
+    void set_delta_coding(bool enable) { delta_coding_ = enable; }
+
     //! \name Reading (Generic) Items
     //! \{
 
@@ -86,6 +95,8 @@ public:
     T Next() {
         assert(HasNext());
         assert(num_items_ > 0);
+        // the first item starting in a Block resets delta decoding
+        bool first_item = (num_items_ == block_.num_items());
         --num_items_;
 
         if (self_verify && typecode_verify_) {
@@ -98,7 +109,7 @@ public:
                     << " got " << common::HexdumpItem(code));
             }
         }
-        return Serialization<BlockReader, T>::Deserialize(*this);
+        return DeserializeItem<T>(first_item);
     }
 
     //! Next() reads a complete item T, without item counter or self
@@ -109,6 +120,41 @@ public:
         return Serialization<BlockReader, T>::Deserialize(*this);
     }
 
+    /*!
+     * NextMany reads up to n items into an array and returns the number of
+     * items read, which is less than n only at the end of the data. Items
+     * serialized as raw POD values are copied in runs from the Blocks.
+     */
+    template <typename T>
+    size_t NextMany(T* out, size_t n) {
+        size_t count = 0;
+        while (count < n && HasNext()) {
+            size_t avail = 0;
+            if (Serialization<BlockReader, T>::is_fixed_size &&
+                std::is_pod<T>::value && !std::is_pointer<T>::value &&
+                !typecode_verify_ &&
+                !(std::is_integral<T>::value && delta_coding_)) {
+                avail = std::min(
+                    std::min(num_items_, n - count),
+                    static_cast<size_t>(end_ - current_) / sizeof(T));
+            }
+
+            if (avail == 0) {
+                // item is split across Blocks or not a raw POD
+                out[count++] = Next<T>();
+                continue;
+            }
+
+            std::copy(current_, current_ + avail * sizeof(T),
+                      reinterpret_cast<Byte*>(out + count));
+
+            current_ += avail * sizeof(T);
+            num_items_ -= avail;
+            count += avail;
+        }
+        return count;
+    }
+
     //! HasNext() returns true if at least one more item is available.
     bool HasNext() {
         while (current_ == end_) {
@@ -364,6 +410,53 @@ private:
     //! BlockReader, this is false to needed to read external files.
     bool typecode_verify_;
 
+    //! flag whether integral items are delta decoded
+    bool delta_coding_ = false;
+
+    //! previous integral item for delta decoding
+    uint64_t delta_prev_ = 0;
+
+    //! previous std::string for front decoding
+    std::string delta_prev_string_;
+
+    //! Deserialize a non-integral item.
+    template <typename T>
+    typename std::enable_if<!std::is_integral<T>::value &&
+                            !std::is_same<T, std::string>::value, T>::type
+    DeserializeItem(bool /* first_item */) {
+        return Serialization<BlockReader, T>::Deserialize(*this);
+    }
+
+    //! Deserialize a std::string, possibly front coded.
+    template <typename T>
+    typename std::enable_if<std::is_same<T, std::string>::value, T>::type
+    DeserializeItem(bool first_item) {
+        if (!delta_coding_)
+            return Serialization<BlockReader, T>::Deserialize(*this);
+
+        if (first_item) delta_prev_string_.clear();
+
+        size_t lcp = this->GetVarint();
+        size_t rest = this->GetVarint();
+        delta_prev_string_.resize(lcp + rest);
+        Read(&delta_prev_string_[lcp], rest);
+        return delta_prev_string_;
+    }
+
+    //! Deserialize an integral item, possibly delta encoded.
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, T>::type
+    DeserializeItem(bool first_item) {
+        if (!delta_coding_)
+            return Serialization<BlockReader, T>::Deserialize(*this);
+
+        if (first_item) delta_prev_ = 0;
+
+        uint64_t z = this->GetVarint();
+        delta_prev_ += (z >> 1) ^ (uint64_t(0) - (z & 1));
+        return static_cast<T>(delta_prev_);
+    }
+
     //! Call source_.NextBlock with appropriate parameters
     bool NextBlock() {
         // first release old pin.
@@ -20,8 +20,10 @@
 #include <thrill/data/serialization.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <deque>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -86,7 +88,10 @@ public:
           sink_queue_(std::move(bw.sink_queue_)),
           block_size_(std::move(bw.block_size_)),
           max_block_size_(std::move(bw.max_block_size_)),
-          closed_(std::move(bw.closed_)) {
+          closed_(std::move(bw.closed_)),
+          delta_coding_(std::move(bw.delta_coding_)),
+          delta_prev_(std::move(bw.delta_prev_)),
+          delta_prev_string_(std::move(bw.delta_prev_string_)) {
         // set closed flag -> disables destructor
         bw.closed_ = true;
     }
@@ -106,6 +111,9 @@ public:
         block_size_ = std::move(bw.block_size_);
         max_block_size_ = std::move(bw.max_block_size_);
         closed_ = std::move(bw.closed_);
+        delta_coding_ = std::move(bw.delta_coding_);
+        delta_prev_ = std::move(bw.delta_prev_);
+        delta_prev_string_ = std::move(bw.delta_prev_string_);
         // set closed flag -> disables destructor
         bw.closed_ = true;
         return *this;
@@ -129,6 +137,18 @@ public:
     //! Return whether an actual BlockSink is attached.
     bool IsValid() const { return sink_ != nullptr; }
 
+    //! Returns whether integral items are delta encoded.
+    bool delta_coding() const { return delta_coding_; }
+
+    /*!
+     * Enable or disable delta encoding of integral items. Each integral item is
+     * then stored as a zigzag Varint of the difference to the previous item,
+     * where the first item starting in a Block is relative to zero. This
+     * shrinks sorted integer sequences considerably. The data must be read
+     * sequentially by a BlockReader with delta coding enabled.
+     */
+    void set_delta_coding(bool enable) { delta_coding_ = enable; }
+
     //! Flush the current block (only really meaningful for a network sink).
     void Flush() {
         if (!bytes_) return;
@@ -156,6 +176,13 @@ public:
         current_ = end_ = nullptr;
     }
 
+    //! Directly write a Block to the underlying BlockSink (after flushing the
+    //! current one if need be).
+    void AppendBlock(const Block& block) {
+        Flush();
+        sink_->AppendBlock(block);
+    }
+
     //! Directly write Blocks to the underlying BlockSink (after flushing the
     //! current one if need be).
     void AppendBlocks(const std::vector<Block>& blocks) {
@@ -211,6 +238,60 @@ public:
             return PutSafe<T, true>(x);
     }
 
+    /*!
+     * PutMany appends n items from an array. Items serialized as raw POD
+     * values are copied in runs into the Blocks, and are never split across
+     * Blocks, hence such Blocks contain plain arrays of T. Other items, and
+     * Writers with self verification or delta coding, fall back to Put() for
+     * each item.
+     */
+    template <typename T>
+    BlockWriter& PutMany(const T* items, size_t n) {
+        assert(!closed_);
+
+        if (!Serialization<BlockWriter, T>::is_fixed_size ||
+            !std::is_pod<T>::value || std::is_pointer<T>::value ||
+            BlockSink::allocate_can_fail_ || self_verify ||
+            (std::is_integral<T>::value && delta_coding_)) {
+            for (size_t i = 0; i < n; ++i)
+                Put<T>(items[i]);
+            return *this;
+        }
+
+        while (n != 0) {
+            if (static_cast<size_t>(end_ - current_) < sizeof(T)) {
+                Flush(), AllocateBlock();
+
+                if (static_cast<size_t>(end_ - current_) < sizeof(T)) {
+                    // Block is smaller than a single item: split it.
+                    Put<T>(*items++), --n;
+                    continue;
+                }
+            }
+
+            size_t fit = std::min(
+                n, static_cast<size_t>(end_ - current_) / sizeof(T));
+
+            if (nitems_ == 0)
+                first_offset_ = current_ - bytes_->begin();
+            nitems_ += fit;
+
+            std::copy(reinterpret_cast<const Byte*>(items),
+                      reinterpret_cast<const Byte*>(items + fit), current_);
+
+            current_ += fit * sizeof(T);
+            items += fit, n -= fit;
+        }
+
+        return *this;
+    }
+
+    //! appends n items from a std::vector, see PutMany(const T*, size_t).
+    template <typename T>
+    BlockWriter& PutMany(const std::vector<T>& items) {
+        return PutMany(items.data(), items.size());
+    }
+
     //! appends a complete item, or fails safely with a FullException.
     template <typename T, bool NoSelfVerify = false>
     BlockWriter& PutSafe(const T& x) {
@@ -236,6 +317,7 @@ public:
         Byte* initial_current = current_;
         size_t initial_nitems = nitems_;
         size_t initial_first_offset = first_offset_;
+        uint64_t initial_delta_prev = delta_prev_;
         do_queue_ = true;
 
         try {
@@ -244,7 +326,7 @@ public:
                 // for self-verification, prefix T with its hash code
                 PutRaw(typeid(T).hash_code());
             }
-            Serialization<BlockWriter, T>::Serialize(x, *this);
+            SerializeItem(x);
 
             // item fully serialized, push out finished blocks.
             while (!sink_queue_.empty()) {
@@ -275,6 +357,7 @@ public:
             end_ = bytes_->end();
             nitems_ = initial_nitems;
             first_offset_ = initial_first_offset;
+            delta_prev_ = initial_delta_prev;
             do_queue_ = false;
 
             throw;
@@ -296,7 +379,7 @@ public:
                 // for self-verification, prefix T with its hash code
                 PutRaw(typeid(T).hash_code());
             }
-            Serialization<BlockWriter, T>::Serialize(x, *this);
+            SerializeItem(x);
         }
         catch (FullException&) {
             throw std::runtime_error(
@@ -376,6 +459,50 @@ public:
     //! \}
 
 private:
+    //! Serialize a non-integral item.
+    template <typename T>
+    typename std::enable_if<!std::is_integral<T>::value>::type
+    SerializeItem(const T& x) {
+        Serialization<BlockWriter, T>::Serialize(x, *this);
+    }
+
+    //! Serialize an integral item, possibly delta encoded.
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type
+    SerializeItem(const T& x) {
+        if (!delta_coding_)
+            return Serialization<BlockWriter, T>::Serialize(x, *this);
+
+        // the first item starting in a Block is encoded relative to zero.
+        if (nitems_ == 1) delta_prev_ = 0;
+
+        uint64_t v = static_cast<uint64_t>(x);
+        uint64_t d = v - delta_prev_;
+        // zigzag encoding: small negative differences become small values.
+        this->PutVarint((d << 1) ^ (uint64_t(0) - (d >> 63)));
+        delta_prev_ = v;
+    }
+
+    //! Serialize a std::string, possibly front coded: as Varints of the LCP
+    //! with the previous string and of the remaining length, and the
+    //! remaining characters.
+    void SerializeItem(const std::string& x) {
+        if (!delta_coding_)
+            return Serialization<BlockWriter, std::string>::Serialize(x, *this);
+
+        // the first item starting in a Block is encoded relative to "". The
+        // previous string is only replaced once the item is complete, since
+        // PutSafe() may unwind it.
+        size_t lcp = 0, n = nitems_ == 1
+                            ? 0 : std::min(x.size(), delta_prev_string_.size());
+        while (lcp < n && x[lcp] == delta_prev_string_[lcp]) ++lcp;
+
+        this->PutVarint(lcp);
+        this->PutVarint(x.size() - lcp);
+        Append(x.data() + lcp, x.size() - lcp);
+        delta_prev_string_.assign(x);
+    }
+
     //! Allocate a new block (overwriting the existing one).
     void AllocateBlock() {
         bytes_ = sink_->AllocateByteBlock(block_size_);
@@ -427,6 +554,15 @@ private:
 
     //! Flag if Close was called explicitly
     bool closed_ = false;
+
+    //! Flag whether integral items are delta encoded
+    bool delta_coding_ = false;
+
+    //! previous integral item for delta coding
+    uint64_t delta_prev_ = 0;
+
+    //! previous std::string for front coding
+    std::string delta_prev_string_;
 };
 
 //! alias for BlockWriter which outputs to a generic BlockSink.
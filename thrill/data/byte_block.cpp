@@ -18,6 +18,8 @@
 namespace thrill {
 namespace data {
 
+constexpr size_t ByteBlock::no_stripe;
+
 ByteBlock::ByteBlock(BlockPool* block_pool, Byte* data, size_t size)
     : data_(data), size_(size),
       block_pool_(block_pool),
@@ -34,6 +36,15 @@ ByteBlock::ByteBlock(
       ext_file_(ext_file)
 { }
 
+ByteBlock::ByteBlock(
+    BlockPool* block_pool, const io::FileMappingPtr& mapping,
+    size_t offset, size_t size)
+    : data_(const_cast<Byte*>(mapping->data()) + offset), size_(size),
+      block_pool_(block_pool),
+      pin_count_(block_pool_->workers_per_host()),
+      mapping_(mapping)
+{ }
+
 void ByteBlock::Deleter::operator () (ByteBlock* bb) const {
     sLOG << "ByteBlock[" << bb << "]::deleter()"
          << "pin_count_" << bb->pin_count_str();
@@ -53,7 +64,12 @@ void ByteBlock::Deleter::operator () (const ByteBlock* bb) const {
 }
 
 std::string ByteBlock::pin_count_str() const {
-    return "[" + common::Join(",", pin_count_) + "]";
+    std::vector<size_t> pin_count(pin_count_.begin(), pin_count_.end());
+    return "[" + common::Join(",", pin_count) + "]";
+}
+
+void ByteBlock::set_eviction_hint(EvictionHint hint) {
+    return block_pool_->SetEvictionHint(this, hint);
 }
 
 void ByteBlock::IncPinCount(size_t local_worker_id) {
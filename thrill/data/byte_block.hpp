@@ -15,8 +15,11 @@
 #include <thrill/common/counting_ptr.hpp>
 #include <thrill/io/bid.hpp>
 #include <thrill/io/file_base.hpp>
+#include <thrill/io/file_mapping.hpp>
 #include <thrill/mem/pool.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -29,11 +32,35 @@ namespace data {
 //! default size of blocks in File, Channel, BlockQueue, etc.
 static constexpr size_t default_block_size = 2 * 1024 * 1024;
 
+//! smallest maximum block size of the writers of a Stream, see
+//! Stream::AdaptiveBlockSize()
+static constexpr size_t min_stream_block_size = 64 * 1024;
+
 //! type of underlying memory area
 using Byte = uint8_t;
 
 // forward declarations.
 class BlockPool;
+class EvictionQueue;
+
+/*!
+ * Hint on how a ByteBlock will be accessed next, which the BlockPool's
+ * EvictionPolicy::Hint uses to select blocks to evict.
+ */
+enum class EvictionHint : uint8_t {
+    //! no information, ordered by least recent use.
+    None,
+    //! the block will be read again soon, evict it last.
+    ReadAgainSoon,
+    //! the block is not read again, evict it first.
+    DeadAfterRead,
+    //! the block is scanned once in order, evict the most recently unpinned
+    //! one, which is needed last.
+    Sequential,
+    //! the block should stay in RAM: under all EvictionPolicy it is evicted
+    //! only if no other unpinned blocks are left.
+    Pinned
+};
 
 /*!
  * A ByteBlock is the basic storage units of containers like File, BlockQueue,
@@ -82,6 +109,15 @@ public:
     //! Returns whether the ByteBlock is in an external file.
     bool has_ext_file() const { return ext_file_.get() != nullptr; }
 
+    //! Returns the external file of the ByteBlock, if has_ext_file().
+    const io::FileBasePtr& ext_file() const { return ext_file_; }
+
+    //! Returns the offset of the ByteBlock in its external file.
+    int64_t ext_file_offset() const { return em_bid_.offset; }
+
+    //! Returns whether the ByteBlock points into a memory mapped file.
+    bool is_mapped() const { return mapping_.get() != nullptr; }
+
     //! return current pin count
     size_t pin_count(size_t local_worker_id) const {
         return pin_count_[local_worker_id];
@@ -90,6 +126,27 @@ public:
     //! return string list of pin_counts
     std::string pin_count_str() const;
 
+    //! return the current eviction hint
+    EvictionHint eviction_hint() const { return eviction_hint_; }
+
+    //! set the eviction hint, which takes effect immediately if the block is
+    //! unpinned.
+    void set_eviction_hint(EvictionHint hint);
+
+    //! em_stripe() value of blocks placed on the least loaded disk
+    static constexpr size_t no_stripe = size_t(-1);
+
+    //! return the stripe index, which places the block on disk stripe modulo
+    //! the number of disks when evicted, or no_stripe.
+    size_t em_stripe() const { return em_stripe_; }
+
+    //! set the stripe index used when the block is evicted.
+    void set_em_stripe(size_t stripe) { em_stripe_ = stripe; }
+
+    //! return the id of the DIA node the block's memory is attributed to, or
+    //! zero if it is not attributed.
+    size_t dia_id() const { return dia_id_.load(std::memory_order_relaxed); }
+
     //! true if block resides in memory
     bool in_memory() const {
         return data_ != nullptr;
@@ -112,23 +169,64 @@ private:
     //! reference to BlockPool for deletion.
     BlockPool* block_pool_;
 
-    //! counts the number of pins in this block per thread_id.
-    std::vector<size_t, mem::GPoolAllocator<size_t> > pin_count_;
+    //! counts the number of pins in this block per thread_id. The counters are
+    //! atomic, since BlockPool changes them without its mutex as long as the
+    //! count of a thread_id stays above zero.
+    std::vector<std::atomic<size_t>,
+                mem::GPoolAllocator<std::atomic<size_t> > > pin_count_;
 
-    //! counts the total number of pins, the data_ may be swapped out when this
-    //! reaches zero.
+    //! counts the number of thread_ids holding pins, the data_ may be swapped
+    //! out when this reaches zero. Only changed with the BlockPool's mutex.
     size_t total_pins_ = 0;
 
     //! external memory block, which contains a pointer to io::FileBase, an
     //! offset into the file, and (unfortunately) also the size.
     io::BID<0> em_bid_;
 
+    //! size of the compressed data in the external memory block, or zero if
+    //! the block was written uncompressed.
+    size_t em_compressed_size_ = 0;
+
+    //! temporary buffer holding compressed data while being written to
+    //! external memory.
+    Byte* em_buffer_ = nullptr;
+
     //! shared pointer to external file, if this is != nullptr then the Block
     //! was created for directly reading binary files.
     io::FileBasePtr ext_file_;
 
+    //! memory mapping of a file, if this is != nullptr then data_ points into
+    //! the read-only mapping, which is neither counted nor evicted by the
+    //! BlockPool.
+    io::FileMappingPtr mapping_;
+
+    //! hint on how the block is accessed next, changed by the BlockPool.
+    EvictionHint eviction_hint_ = EvictionHint::None;
+
+    //! stripe index for placing the block on disk, or no_stripe.
+    size_t em_stripe_ = no_stripe;
+
+    //! id of the DIA node the block's memory is attributed to, set once by
+    //! BlockPool::AttributeToDIA() with the BlockPool's mutex. Atomic, since
+    //! Files read it without the mutex.
+    std::atomic<size_t> dia_id_ { 0 };
+
+    //! time the block was swapped out, for demoting it to a slower tier.
+    std::chrono::steady_clock::time_point em_swapped_at_;
+
+    //! time the eviction write was issued, for the JSON log.
+    std::chrono::steady_clock::time_point em_write_issued_;
+
+    //! eviction queue of the BlockPool the block is in while unpinned.
+    uint8_t eviction_queue_ = 0;
+
+    //! whether the block was unpinned before, for EvictionPolicy::TwoQueue.
+    bool unpinned_before_ = false;
+
     // BlockPool is a friend to call ctor and to manipulate data_.
     friend class BlockPool;
+    // EvictionQueue of BlockPool sorts blocks by their eviction data.
+    friend class EvictionQueue;
     // Block is a friend to call {Increase,Reduce}PinCount()
     friend class Block;
     friend class PinnedBlock;
@@ -153,6 +251,11 @@ private:
     ByteBlock(BlockPool* block_pool, const io::FileBasePtr& ext_file,
               int64_t offset, size_t size);
 
+    //! Constructor to initialize ByteBlock as a zero-copy view of a memory
+    //! mapped file area.
+    ByteBlock(BlockPool* block_pool, const io::FileMappingPtr& mapping,
+              size_t offset, size_t size);
+
     friend std::ostream& operator << (std::ostream& os, const ByteBlock& b);
 
     //! forwarded to block_pool_
@@ -232,7 +335,7 @@ private:
         : ByteBlockPtr(std::move(ptr)), local_worker_id_(local_worker_id) { }
 
     //! local worker id of holder of pin
-    size_t local_worker_id_;
+    size_t local_worker_id_ = 0;
 
     //! for access to protected constructor to transfer pin
     friend class PinnedBlock;
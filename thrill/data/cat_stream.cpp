@@ -26,6 +26,7 @@ CatStream::CatStream(Multiplexer& multiplexer, const StreamId& id,
 
     sinks_.reserve(num_workers());
     queues_.reserve(num_workers());
+    local_items_.resize(workers_per_host());
 
     // construct StreamSink array
     for (size_t host = 0; host < num_hosts(); ++host) {
@@ -69,11 +70,14 @@ CatStream::CatStream(Multiplexer& multiplexer, const StreamId& id,
             }
             else {
                 // construct outbound StreamSink
+                // on one of the parallel connections, which keeps the order
+                // of its blocks.
 
                 sinks_.emplace_back(
                     *this,
                     multiplexer_.block_pool_,
-                    &multiplexer_.group_.connection(host),
+                    &multiplexer_.connection(
+                        host, id + local_worker_id * workers_per_host() + worker),
                     MagicByte::CatStreamBlock,
                     id,
                     my_host_rank(), local_worker_id,
@@ -85,6 +89,8 @@ CatStream::CatStream(Multiplexer& multiplexer, const StreamId& id,
             }
         }
     }
+
+    StreamSink::AssignBatches(sinks_, &batches_);
 }
 
 CatStream::~CatStream() {
@@ -102,6 +108,9 @@ std::vector<CatStream::Writer>
 CatStream::GetWriters(size_t block_size) {
     tx_timespan_.StartEventually();
 
+    if (block_size == 0)
+        block_size = AdaptiveBlockSize();
+
     std::vector<Writer> result;
     result.reserve(num_workers());
 
@@ -165,6 +174,11 @@ CatStream::CatReader CatStream::GetReader(bool consume) {
     return GetCatReader(consume);
 }
 
+void CatStream::ScheduleExchange() {
+    StreamSink::AssignSchedule(sinks_, my_host_rank(), num_hosts(),
+                               workers_per_host(), &schedule_);
+}
+
 void CatStream::Close() {
     if (is_closed_) return;
     is_closed_ = true;
@@ -205,7 +219,10 @@ bool CatStream::closed() const {
 
 void CatStream::OnStreamBlock(size_t from, PinnedBlock&& b) {
     assert(from < queues_.size());
-    rx_timespan_.StartEventually();
+    {
+        std::unique_lock<std::mutex> lock(rx_timer_mutex_);
+        rx_timespan_.StartEventually();
+    }
 
     rx_bytes_ += b.size();
     rx_blocks_++;
@@ -220,6 +237,11 @@ void CatStream::OnStreamBlock(size_t from, PinnedBlock&& b) {
     queues_[from].AppendPinnedBlock(std::move(b));
 }
 
+void CatStream::OnStreamCredit(size_t from, size_t credits) {
+    assert(from < sinks_.size());
+    sinks_[from].AddCredits(credits);
+}
+
 void CatStream::OnCloseStream(size_t from) {
     assert(from < queues_.size());
     queues_[from].Close();
@@ -236,6 +258,14 @@ void CatStream::OnCloseStream(size_t from) {
     sem_closing_blocks_.signal();
 }
 
+void CatStream::SetLocalItems(
+    size_t local_worker_id, std::shared_ptr<void>&& items) {
+    assert(local_worker_id < workers_per_host());
+    CatStream* peer = multiplexer_.CatLoopbackStream(id_, local_worker_id);
+    assert(!peer->local_items_[local_worker_id_]);
+    peer->local_items_[local_worker_id_] = std::move(items);
+}
+
 BlockQueue* CatStream::loopback_queue(size_t from_worker_id) {
     assert(from_worker_id < workers_per_host());
     size_t global_worker_rank = workers_per_host() * my_host_rank() + from_worker_id;
@@ -18,7 +18,11 @@
 #include <thrill/data/stream.hpp>
 #include <thrill/data/stream_sink.hpp>
 
+#include <cassert>
+#include <deque>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -85,9 +89,10 @@ public:
     void set_dia_id(size_t dia_id);
 
     //! Creates BlockWriters for each worker. BlockWriter can only be opened
-    //! once, otherwise the block sequence is incorrectly interleaved!
+    //! once, otherwise the block sequence is incorrectly interleaved! A
+    //! block_size of 0 selects AdaptiveBlockSize().
     std::vector<Writer>
-    GetWriters(size_t block_size = default_block_size) final;
+    GetWriters(size_t block_size = 0) final;
 
     //! Creates a BlockReader for each worker. The BlockReaders are attached to
     //! the BlockQueues in the Stream and wait for further Blocks to arrive or
@@ -105,6 +110,39 @@ public:
     //! Open a CatReader (function name matches a method in File and MixStream).
     CatReader GetReader(bool consume);
 
+    /*!
+     * Moves items directly as objects to the CatStream of a local worker on
+     * this host, without serializing them into Blocks. Must be called before
+     * the Writer to that worker is closed. The receiver takes the items with
+     * TakeLocalItems(), after it read all Blocks of this worker.
+     */
+    template <typename ItemType>
+    void MoveToLocalWorker(size_t local_worker_id,
+                           std::vector<ItemType>&& items) {
+        SetLocalItems(local_worker_id,
+                      std::make_shared<std::vector<ItemType> >(
+                          std::move(items)));
+    }
+
+    /*!
+     * Takes the items moved to this worker by the local worker with the given
+     * id using MoveToLocalWorker(). Must be called after all Blocks from that
+     * worker were read, e.g. when the CatReader is finished. Returns an empty
+     * vector if no items were moved.
+     */
+    template <typename ItemType>
+    std::vector<ItemType> TakeLocalItems(size_t from_local_worker_id) {
+        assert(from_local_worker_id < local_items_.size());
+        std::shared_ptr<void> ptr = std::move(local_items_[from_local_worker_id]);
+        if (!ptr) return std::vector<ItemType>();
+        return std::move(*std::static_pointer_cast<std::vector<ItemType> >(ptr));
+    }
+
+    //! Sends the Blocks to other hosts in pairwise phases after all Writers
+    //! are closed, instead of sending to all hosts at once. Must be called
+    //! before writing.
+    void ScheduleExchange();
+
     //! shuts the stream down.
     void Close() final;
 
@@ -115,12 +153,24 @@ public:
 private:
     bool is_closed_ = false;
 
+    //! batches of the sinks_ per connection, which batch small Blocks.
+    std::deque<StreamSinkBatch> batches_;
+
+    //! schedule of the sinks_ if the exchange is scheduled.
+    StreamSinkSchedule schedule_;
+
     //! StreamSink objects are receivers of Blocks outbound for other worker.
     std::vector<StreamSink> sinks_;
 
     //! BlockQueues to store incoming Blocks with no attached destination.
     std::vector<BlockQueue> queues_;
 
+    //! items moved by local workers, which are std::vector<ItemType>.
+    std::vector<std::shared_ptr<void> > local_items_;
+
+    //! store items in the CatStream of the local worker.
+    void SetLocalItems(size_t local_worker_id, std::shared_ptr<void>&& items);
+
     //! for calling methods to deliver blocks
     friend class Multiplexer;
 
@@ -128,6 +178,10 @@ private:
     //! Stream.
     void OnStreamBlock(size_t from, PinnedBlock&& b);
 
+    //! called from Multiplexer when the receiving worker from granted credits
+    //! to the StreamSink sending to it.
+    void OnStreamCredit(size_t from, size_t credits);
+
     //! called from Multiplexer when a CatStream closed notification was
     //! received.
     void OnCloseStream(size_t from);
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * thrill/data/compressed_file.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/compressed_file.hpp>
+
+#include <thrill/common/math.hpp>
+#include <thrill/data/block_compression.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+void CompressedFile::Append(const File& file) {
+    // temporary buffer for compressing each Block
+    std::vector<Byte> buffer;
+
+    for (size_t i = 0; i < file.num_blocks(); ++i) {
+        const Block& b = file.block(i);
+        PinnedBlock pb = b.PinWait(local_worker_id_);
+
+        num_items_ += b.num_items();
+        size_bytes_ += b.size();
+
+        size_t csize = 0;
+        if (b.size() > THRILL_DEFAULT_ALIGN) {
+            buffer.resize(b.size());
+            csize = BlockCompress(
+                pb.data_begin(), b.size(), buffer.data(), b.size() - 1);
+        }
+
+        if (csize == 0) {
+            // incompressible or small: keep the original Block
+            entries_.emplace_back(Entry { b, 0, 0, 0 });
+            compressed_bytes_ += b.size();
+            continue;
+        }
+
+        if (current_chunk_.valid() &&
+            current_used_ + csize > current_chunk_->size())
+            FinishChunk();
+
+        if (!current_chunk_.valid()) {
+            current_chunk_ = block_pool_->AllocateByteBlock(
+                std::max(default_block_size,
+                         common::RoundUpToPowerOfTwo(csize)),
+                local_worker_id_);
+            current_used_ = 0;
+        }
+
+        std::copy(buffer.data(), buffer.data() + csize,
+                  current_chunk_->data() + current_used_);
+
+        entries_.emplace_back(
+            Entry {
+                Block(ByteBlockPtr(), b.begin(), b.begin() + b.size(),
+                      b.first_item_absolute(), b.num_items(),
+                      b.typecode_verify()),
+                chunks_.size(), current_used_, csize
+            });
+
+        current_used_ += csize;
+        compressed_bytes_ += csize;
+    }
+
+    if (current_chunk_.valid())
+        FinishChunk();
+}
+
+void CompressedFile::FinishChunk() {
+    chunks_.emplace_back(
+        PinnedBlock(std::move(current_chunk_), 0, current_used_, 0, 0, false)
+        .MoveToBlock());
+    current_used_ = 0;
+}
+
+void CompressedFile::Clear() {
+    std::vector<Entry>().swap(entries_);
+    std::vector<Block>().swap(chunks_);
+    num_items_ = size_bytes_ = compressed_bytes_ = 0;
+}
+
+PinnedBlock CompressedFileBlockSource::NextBlock() {
+    if (current_ == file_->entries_.size()) {
+        chunk_ = PinnedBlock();
+        return PinnedBlock();
+    }
+
+    const CompressedFile::Entry& e = file_->entries_[current_++];
+
+    if (e.compressed_size == 0)
+        return e.block.PinWait(file_->local_worker_id_);
+
+    if (chunk_index_ != e.chunk) {
+        chunk_ = file_->chunks_[e.chunk].PinWait(file_->local_worker_id_);
+        chunk_index_ = e.chunk;
+    }
+
+    const Block& b = e.block;
+    PinnedByteBlockPtr bytes = file_->block_pool_->AllocateByteBlock(
+        common::RoundUpToPowerOfTwo(
+            std::max<size_t>(b.size(), THRILL_DEFAULT_ALIGN)),
+        file_->local_worker_id_);
+
+    die_unless(BlockDecompress(chunk_.data_begin() + e.offset,
+                               e.compressed_size, bytes->data(), b.size()));
+
+    return PinnedBlock(std::move(bytes), 0, b.size(), b.first_item_relative(),
+                       b.num_items(), b.typecode_verify());
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * thrill/data/compressed_file.hpp
+ *
+ * Container of the Blocks of a File, which are kept compressed in memory and
+ * decompressed while reading.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_COMPRESSED_FILE_HEADER
+#define THRILL_DATA_COMPRESSED_FILE_HEADER
+
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_pool.hpp>
+#include <thrill/data/block_reader.hpp>
+#include <thrill/data/file.hpp>
+
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+class CompressedFileBlockSource;
+
+/*!
+ * A CompressedFile holds the Blocks of Files compressed with BlockCompress().
+ * The compressed Blocks are packed into ByteBlocks of default_block_size,
+ * which are ordinary unpinned ByteBlocks of the BlockPool. Blocks which do not
+ * compress are kept as they are. Reading decompresses one Block at a time, so
+ * items split between Blocks are read as from the original File.
+ */
+class CompressedFile
+{
+public:
+    using Reader = BlockReader<CompressedFileBlockSource>;
+
+    CompressedFile(BlockPool& block_pool, size_t local_worker_id)
+        : block_pool_(&block_pool), local_worker_id_(local_worker_id) { }
+
+    //! non-copyable: delete copy-constructor
+    CompressedFile(const CompressedFile&) = delete;
+    //! non-copyable: delete assignment operator
+    CompressedFile& operator = (const CompressedFile&) = delete;
+    //! move-constructor: default
+    CompressedFile(CompressedFile&&) = default;
+    //! move-assignment operator: default
+    CompressedFile& operator = (CompressedFile&&) = default;
+
+    //! Compress and append all Blocks of a File.
+    void Append(const File& file);
+
+    //! Free all Blocks.
+    void Clear();
+
+    //! Get BlockReader for beginning of the CompressedFile.
+    Reader GetReader() const;
+
+    //! Return the number of items
+    size_t num_items() const { return num_items_; }
+
+    //! Return the number of bytes of user data before compression.
+    size_t size_bytes() const { return size_bytes_; }
+
+    //! Return the number of bytes used in memory.
+    size_t compressed_bytes() const { return compressed_bytes_; }
+
+private:
+    //! a Block of the File, whose data is either the original ByteBlock, or
+    //! the range [offset, offset + compressed_size) of a chunk.
+    struct Entry {
+        //! original Block, its byte_block is empty if it was compressed.
+        Block  block;
+        //! index into chunks_ containing the compressed data
+        size_t chunk;
+        //! offset of the compressed data in chunk
+        size_t offset;
+        //! size of the compressed data, zero if the block was not compressed.
+        size_t compressed_size;
+    };
+
+    //! BlockPool to allocate chunks and decompressed Blocks
+    BlockPool* block_pool_;
+
+    //! local worker id to pin Blocks
+    size_t local_worker_id_;
+
+    //! the Blocks in order
+    std::vector<Entry> entries_;
+
+    //! ByteBlocks containing compressed Blocks
+    std::vector<Block> chunks_;
+
+    //! chunk currently being filled, which is pinned
+    PinnedByteBlockPtr current_chunk_;
+
+    //! used bytes in current_chunk_
+    size_t current_used_ = 0;
+
+    //! total number of items
+    size_t num_items_ = 0;
+
+    //! total number of bytes before compression
+    size_t size_bytes_ = 0;
+
+    //! total number of bytes in memory
+    size_t compressed_bytes_ = 0;
+
+    //! Move current_chunk_ into chunks_ as unpinned Block.
+    void FinishChunk();
+
+    //! for access to entries_ and chunks_
+    friend class CompressedFileBlockSource;
+};
+
+/*!
+ * A BlockSource to read Blocks from a CompressedFile, which decompresses each
+ * Block into a newly allocated ByteBlock.
+ */
+class CompressedFileBlockSource
+{
+public:
+    //! Start reading a CompressedFile
+    explicit CompressedFileBlockSource(const CompressedFile& file)
+        : file_(&file) { }
+
+    //! Deliver the next Block for BlockReader
+    PinnedBlock NextBlock();
+
+private:
+    //! CompressedFile to read from
+    const CompressedFile* file_;
+
+    //! index of the next entry
+    size_t current_ = 0;
+
+    //! the chunk of the previous Block, which is kept pinned while Blocks
+    //! compressed into it are read.
+    PinnedBlock chunk_;
+
+    //! index of chunk_
+    size_t chunk_index_ = size_t(-1);
+};
+
+inline CompressedFile::Reader CompressedFile::GetReader() const {
+    return Reader(CompressedFileBlockSource(*this));
+}
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_COMPRESSED_FILE_HEADER
+
+/******************************************************************************/
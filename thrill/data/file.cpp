@@ -41,6 +41,10 @@ File File::Copy() const {
     f.size_bytes_ = size_bytes_;
     f.stats_bytes_ = stats_bytes_;
     f.stats_items_ = stats_items_;
+    f.delta_coding_ = delta_coding_;
+    f.eviction_hint_ = eviction_hint_;
+    f.striped_ = striped_;
+    f.stripe_ = stripe_;
     return f;
 }
 
@@ -56,30 +60,40 @@ void File::Clear() {
 }
 
 File::Writer File::GetWriter(size_t block_size) {
-    return Writer(this, block_size);
+    Writer writer(this, block_size);
+    writer.set_delta_coding(delta_coding_);
+    return writer;
 }
 
 File::DynWriter File::GetDynWriter(size_t block_size) {
-    return DynWriter(this, block_size);
+    DynWriter writer(this, block_size);
+    writer.set_delta_coding(delta_coding_);
+    return writer;
 }
 
 File::KeepReader File::GetKeepReader(size_t num_prefetch) const {
-    return KeepReader(
+    KeepReader reader(
         KeepFileBlockSource(*this, local_worker_id_, num_prefetch));
+    reader.set_delta_coding(delta_coding_);
+    return reader;
 }
 
 File::ConsumeReader File::GetConsumeReader(size_t num_prefetch) {
-    return ConsumeReader(
+    ConsumeReader reader(
         ConsumeFileBlockSource(this, local_worker_id_, num_prefetch));
+    reader.set_delta_coding(delta_coding_);
+    return reader;
 }
 
 File::Reader File::GetReader(bool consume, size_t num_prefetch) {
-    if (consume)
-        return ConstructDynBlockReader<ConsumeFileBlockSource>(
-            this, local_worker_id_, num_prefetch);
-    else
-        return ConstructDynBlockReader<KeepFileBlockSource>(
+    Reader reader =
+        consume
+        ? ConstructDynBlockReader<ConsumeFileBlockSource>(
+            this, local_worker_id_, num_prefetch)
+        : ConstructDynBlockReader<KeepFileBlockSource>(
             *this, local_worker_id_, num_prefetch);
+    reader.set_delta_coding(delta_coding_);
+    return reader;
 }
 
 std::string File::ReadComplete() const {
@@ -98,6 +112,73 @@ std::ostream& operator << (std::ostream& os, const File& f) {
     return os << "]]";
 }
 
+void File::set_eviction_hint(EvictionHint hint) {
+    eviction_hint_ = hint;
+    for (Block& b : blocks_)
+        b.byte_block()->set_eviction_hint(hint);
+}
+
+size_t File::Prefetch(size_t max_blocks) {
+    size_t started = 0;
+    for (size_t i = 0; i < blocks_.size() && i < max_blocks; ++i) {
+        if (blocks_[i].byte_block()->in_memory()) continue;
+        if (!block_pool()->PrefetchBlock(blocks_[i], local_worker_id()))
+            break;
+        ++started;
+    }
+    return started;
+}
+
+void File::AttributeBlock(Block& b) {
+    block_pool()->AttributeToDIA(b.byte_block().get(), dia_id_);
+}
+
+void File::set_striped(bool enable) {
+    striped_ = enable;
+    stripe_ = id_;
+    for (Block& b : blocks_) {
+        b.byte_block()->set_em_stripe(
+            enable ? stripe_++ : ByteBlock::no_stripe);
+    }
+}
+
+/******************************************************************************/
+// AdaptivePrefetch
+
+void AdaptivePrefetch::Reset(size_t depth) {
+    if (reserved_ != 0) {
+        block_pool_->ReleasePrefetchQuota(reserved_ * default_block_size);
+        reserved_ = 0;
+    }
+    base_ = depth_ = depth;
+    ready_streak_ = 0;
+}
+
+void AdaptivePrefetch::Observe(bool ready) {
+    if (base_ == 0) return;
+
+    if (!ready) {
+        // the reader stalled: prefetch deeper, if the quota permits.
+        ready_streak_ = 0;
+        if (depth_ >= max_depth) return;
+        if (depth_ >= base_) {
+            if (!block_pool_->RequestPrefetchQuota(default_block_size))
+                return;
+            ++reserved_;
+        }
+        ++depth_;
+    }
+    else if (++ready_streak_ >= 2 * depth_ && depth_ > 1) {
+        // all recent Blocks were ready: prefetch less.
+        ready_streak_ = 0;
+        if (reserved_ != 0) {
+            block_pool_->ReleasePrefetchQuota(default_block_size);
+            --reserved_;
+        }
+        --depth_;
+    }
+}
+
 /******************************************************************************/
 // KeepFileBlockSource
 
@@ -106,7 +187,7 @@ KeepFileBlockSource::KeepFileBlockSource(
     size_t num_prefetch,
     size_t first_block, size_t first_item)
     : file_(file), local_worker_id_(local_worker_id),
-      num_prefetch_(num_prefetch),
+      prefetch_(file.block_pool(), num_prefetch),
       first_block_(first_block), current_block_(first_block),
       first_item_(first_item) { }
 
@@ -115,7 +196,7 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
     if (current_block_ >= file_.num_blocks() && fetching_blocks_.empty())
         return PinnedBlock();
 
-    if (num_prefetch_ == 0)
+    if (prefetch_.depth() == 0)
     {
         // operate without prefetching
         return NextUnpinnedBlock().PinWait(local_worker_id_);
@@ -123,16 +204,19 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
     else
     {
         // prefetch #desired blocks
-        while (fetching_blocks_.size() < num_prefetch_ &&
+        while (fetching_blocks_.size() < prefetch_.depth() &&
                current_block_ < file_.num_blocks())
         {
             fetching_blocks_.emplace_back(
-                NextUnpinnedBlock().Pin(local_worker_id_));
+                NextUnpinnedBlock().PinReadAhead(
+                    local_worker_id_, rate_.Deadline(fetching_blocks_.size())));
         }
 
         // this might block if the prefetching is not finished
+        prefetch_.Observe(fetching_blocks_.front()->ready());
         PinnedBlock b = fetching_blocks_.front()->Wait();
         fetching_blocks_.pop_front();
+        rate_.Tick();
         return b;
     }
 }
@@ -157,29 +241,28 @@ Block KeepFileBlockSource::NextUnpinnedBlock() {
 ConsumeFileBlockSource::ConsumeFileBlockSource(
     File* file, size_t local_worker_id, size_t num_prefetch)
     : file_(file), local_worker_id_(local_worker_id),
-      num_prefetch_(num_prefetch) {
-    Prefetch(num_prefetch_);
+      prefetch_(file->block_pool(), 0) {
+    // the remaining Blocks are read once in order, the last is needed last.
+    file_->set_eviction_hint(EvictionHint::Sequential);
+    Prefetch(num_prefetch);
 }
 
 ConsumeFileBlockSource::ConsumeFileBlockSource(ConsumeFileBlockSource&& s)
     : file_(s.file_), local_worker_id_(s.local_worker_id_),
-      num_prefetch_(s.num_prefetch_),
-      fetching_blocks_(std::move(s.fetching_blocks_)) {
+      prefetch_(std::move(s.prefetch_)),
+      fetching_blocks_(std::move(s.fetching_blocks_)), rate_(s.rate_) {
     s.file_ = nullptr;
 }
 
 void ConsumeFileBlockSource::Prefetch(size_t prefetch) {
-    if (prefetch >= num_prefetch_) {
-        num_prefetch_ = prefetch;
-        while (fetching_blocks_.size() < num_prefetch_ && !file_->blocks_.empty()) {
-            fetching_blocks_.emplace_back(
-                file_->blocks_.front().Pin(local_worker_id_));
-            file_->blocks_.pop_front();
-        }
-    }
-    else if (prefetch < num_prefetch_) {
-        num_prefetch_ = prefetch;
-        // cannot discard prefetched Blocks
+    // cannot discard prefetched Blocks if the depth decreases
+    prefetch_.Reset(prefetch);
+    while (fetching_blocks_.size() < prefetch_.depth() &&
+           !file_->blocks_.empty()) {
+        fetching_blocks_.emplace_back(
+            file_->blocks_.front().PinReadAhead(
+                local_worker_id_, rate_.Deadline(fetching_blocks_.size())));
+        file_->blocks_.pop_front();
     }
 }
 
@@ -189,22 +272,26 @@ PinnedBlock ConsumeFileBlockSource::NextBlock() {
         return PinnedBlock();
 
     // operate without prefetching
-    if (num_prefetch_ == 0) {
+    if (prefetch_.depth() == 0) {
         data::PinRequestPtr f = file_->blocks_.front().Pin(local_worker_id_);
         file_->blocks_.pop_front();
         return f->Wait();
     }
 
     // prefetch #desired blocks
-    while (fetching_blocks_.size() < num_prefetch_ && !file_->blocks_.empty()) {
+    while (fetching_blocks_.size() < prefetch_.depth() &&
+           !file_->blocks_.empty()) {
         fetching_blocks_.emplace_back(
-            file_->blocks_.front().Pin(local_worker_id_));
+            file_->blocks_.front().PinReadAhead(
+                local_worker_id_, rate_.Deadline(fetching_blocks_.size())));
         file_->blocks_.pop_front();
     }
 
     // this might block if the prefetching is not finished
+    prefetch_.Observe(fetching_blocks_.front()->ready());
     PinnedBlock b = fetching_blocks_.front()->Wait();
     fetching_blocks_.pop_front();
+    rate_.Tick();
     return b;
 }
 
@@ -15,13 +15,16 @@
 #include <thrill/common/die.hpp>
 #include <thrill/common/function_traits.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_reader.hpp>
 #include <thrill/data/block_sink.hpp>
 #include <thrill/data/block_writer.hpp>
 #include <thrill/data/dyn_block_reader.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <deque>
 #include <functional>
 #include <limits>
@@ -101,6 +104,12 @@ public:
         stats_bytes_ += b.size();
         stats_items_ += b.num_items();
         blocks_.push_back(b);
+        if (dia_id_ && blocks_.back().byte_block()->dia_id() == 0)
+            AttributeBlock(blocks_.back());
+        if (eviction_hint_ != EvictionHint::None)
+            blocks_.back().byte_block()->set_eviction_hint(eviction_hint_);
+        if (striped_)
+            blocks_.back().byte_block()->set_em_stripe(stripe_++);
     }
 
     //! Append a block to this file, the block must contain given number of
@@ -112,6 +121,12 @@ public:
         stats_bytes_ += b.size();
         stats_items_ += b.num_items();
         blocks_.emplace_back(std::move(b));
+        if (dia_id_ && blocks_.back().byte_block()->dia_id() == 0)
+            AttributeBlock(blocks_.back());
+        if (eviction_hint_ != EvictionHint::None)
+            blocks_.back().byte_block()->set_eviction_hint(eviction_hint_);
+        if (striped_)
+            blocks_.back().byte_block()->set_em_stripe(stripe_++);
     }
 
     void Close() final;
@@ -138,6 +153,32 @@ public:
     //! Get BlockWriter.
     DynWriter GetDynWriter(size_t block_size = default_block_size);
 
+    /*!
+     * Append an array of items by copying their bytes into new Blocks, without
+     * a BlockWriter. The items must be serialized as their raw bytes, see
+     * is_raw_serializable, and the File must not be delta coded.
+     */
+    template <typename ItemType>
+    void AppendRawItems(const ItemType* items, size_t size,
+                        size_t block_size = default_block_size) {
+        assert(!delta_coding_);
+        const size_t block_items =
+            std::max<size_t>(block_size / sizeof(ItemType), 1);
+        const Byte* bytes = reinterpret_cast<const Byte*>(items);
+        while (size != 0) {
+            size_t n = std::min(size, block_items);
+            size_t n_bytes = n * sizeof(ItemType);
+            PinnedByteBlockPtr bb = AllocateByteBlock(
+                common::RoundUpToPowerOfTwo(
+                    std::max<size_t>(n_bytes, THRILL_DEFAULT_ALIGN)));
+            std::copy(bytes, bytes + n_bytes, bb->data());
+            AppendPinnedBlock(
+                PinnedBlock(std::move(bb), 0, n_bytes, 0, n,
+                            /* typecode_verify */ false));
+            bytes += n_bytes, size -= n;
+        }
+    }
+
     /*!
      * Get BlockReader or a consuming BlockReader for beginning of File
      *
@@ -209,15 +250,22 @@ public:
     template <typename ItemType>
     ItemType GetItemAt(size_t index) const;
 
+    //! Get the items at the given ascending positions, which may repeat. Each
+    //! Block containing requested items is pinned only once, and the items in
+    //! it are read by a single Reader.
+    template <typename ItemType>
+    std::vector<ItemType> GetItemsAt(
+        const std::vector<size_t>& sorted_indices) const;
+
     /*!
      * Get index of the given item, or the next greater item, in this file. The
      * file has to be ordered according to the given compare function. The tie
      * value can be used to make a decision in case of many successive equal
      * elements.  The tie is compared with the local rank of the element.
      *
-     * WARNING: This method uses GetItemAt combined with a binary search and is
-     * therefore not efficient. The method should be reimplemented in near
-     * future.
+     * This method uses GetItemAt() in a binary search, which seeks
+     * arithmetically inside a Block for fixed-size items, but deserializes
+     * from the beginning of the Block for variable-size items.
      */
     template <typename ItemType, typename CompareFunction = std::less<ItemType> >
     size_t GetIndexOf(const ItemType& item, size_t tie,
@@ -230,9 +278,9 @@ public:
      * value can be used to make a decision in case of many successive equal
      * elements.  The tie is compared with the local rank of the element.
      *
-     * WARNING: This method uses GetItemAt combined with a binary search and is
-     * therefore not efficient. The method should be reimplemented in near
-     * future.
+     * This method uses GetItemAt() in a binary search, which seeks
+     * arithmetically inside a Block for fixed-size items, but deserializes
+     * from the beginning of the Block for variable-size items.
      */
     template <typename ItemType, typename CompareFunction = std::less<ItemType> >
     size_t GetIndexOf(const ItemType& item, size_t tie,
@@ -246,6 +294,12 @@ public:
     template <typename ItemType>
     std::vector<Block> GetItemRange(size_t begin, size_t end) const;
 
+    //! Return a File containing the items [begin,end) of this File. The Slice
+    //! shares the ByteBlocks, only the first and last Block's offsets differ,
+    //! hence no items are copied or serialized again.
+    template <typename ItemType>
+    File Slice(size_t begin, size_t end) const;
+
     //! Output the Block objects contained in this File.
     friend std::ostream& operator << (std::ostream& os, const File& f);
 
@@ -253,9 +307,47 @@ public:
     //! construction)
     void set_dia_id(size_t dia_id) {
         dia_id_ = dia_id;
+        if (dia_id_) {
+            for (Block& b : blocks_) AttributeBlock(b);
+        }
     }
 
+    //! Returns the id of the DIANode this File belongs to.
+    size_t dia_id() const { return dia_id_; }
+
+    //! Returns whether integral items in this File are delta encoded.
+    bool delta_coding() const { return delta_coding_; }
+
+    //! Enable delta encoding of integral items for all Writers and Readers of
+    //! this File, see BlockWriter::set_delta_coding(). Delta encoded Files can
+    //! only be read sequentially from their beginning.
+    void set_delta_coding(bool enable) { delta_coding_ = enable; }
+
+    //! Returns the EvictionHint applied to the Blocks of this File.
+    EvictionHint eviction_hint() const { return eviction_hint_; }
+
+    //! Set the EvictionHint of all Blocks in this File and of Blocks appended
+    //! later.
+    void set_eviction_hint(EvictionHint hint);
+
+    //! Speculatively read the first max_blocks swapped out Blocks of this File
+    //! back into RAM as low-priority read-ahead, while there is RAM below the
+    //! BlockPool's limits. The Blocks stay unpinned. Returns the number of
+    //! Blocks whose reads were started.
+    size_t Prefetch(size_t max_blocks = std::numeric_limits<size_t>::max());
+
+    //! Returns whether the Blocks of this File are striped across all disks.
+    bool striped() const { return striped_; }
+
+    //! Stripe the Blocks of this File and Blocks appended later across all
+    //! disks when evicted, instead of placing each on the least loaded disk.
+    //! Used for Files whose Blocks are read in parallel.
+    void set_striped(bool enable);
+
 private:
+    //! attribute the ByteBlock of a Block to the DIANode dia_id_
+    void AttributeBlock(Block& b);
+
     //! unique file id
     size_t id_;
 
@@ -281,6 +373,19 @@ private:
     //! decreases.
     size_t stats_items_ = 0;
 
+    //! whether integral items are delta encoded by Writers and Readers.
+    bool delta_coding_ = false;
+
+    //! EvictionHint applied to Blocks appended to the File.
+    EvictionHint eviction_hint_ = EvictionHint::None;
+
+    //! whether Blocks are striped across all disks
+    bool striped_ = false;
+
+    //! stripe index of the next Block, starts at the file id such that Files
+    //! begin on different disks.
+    size_t stripe_ = 0;
+
     //! for access to blocks_ and num_items_sum_
     friend class data::KeepFileBlockSource;
     friend class data::ConsumeFileBlockSource;
@@ -288,6 +393,98 @@ private:
 
 using FilePtr = common::CountingPtr<File>;
 
+/*!
+ * Estimates the interval at which a reader consumes Blocks, from which the
+ * deadlines of its read-ahead requests are calculated. A fast reader thus
+ * receives earlier deadlines than a slow one in the BlockPool's read-ahead
+ * scheduler.
+ */
+class BlockConsumptionRate
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    //! record the delivery of a Block to the reader
+    void Tick() {
+        TimePoint now = std::chrono::steady_clock::now();
+        if (last_ != TimePoint()) {
+            // exponentially weighted moving average of the intervals
+            interval_ = (3 * interval_ + (now - last_)) / 4;
+        }
+        last_ = now;
+    }
+
+    //! expected time when the Block after depth further Blocks is needed
+    TimePoint Deadline(size_t depth) const {
+        return std::chrono::steady_clock::now()
+               + static_cast<std::chrono::steady_clock::rep>(depth) * interval_;
+    }
+
+private:
+    //! time of the last delivery
+    TimePoint last_;
+
+    //! average interval between deliveries
+    std::chrono::steady_clock::duration interval_ { 0 };
+};
+
+/*!
+ * Adapts the prefetch depth of a File reader at run time. A reader whose next
+ * Block is still being read when needed prefetches one Block deeper, and a
+ * reader whose Blocks were ready for a while prefetches one Block less, but
+ * at least one. Depth beyond the initial depth is reserved from the host-wide
+ * prefetch quota of the BlockPool, hence readers cannot grow beyond it in
+ * total. An initial depth of zero disables prefetching and adaptation.
+ */
+class AdaptivePrefetch
+{
+public:
+    //! maximum depth of an adaptive reader
+    static constexpr size_t max_depth = 64;
+
+    AdaptivePrefetch(BlockPool* block_pool, size_t depth)
+        : block_pool_(block_pool), base_(depth), depth_(depth) { }
+
+    //! copy-constructor: copies the initial depth, not the reservation
+    AdaptivePrefetch(const AdaptivePrefetch& p)
+        : block_pool_(p.block_pool_), base_(p.base_), depth_(p.base_) { }
+    //! non-copyable: delete assignment operator
+    AdaptivePrefetch& operator = (const AdaptivePrefetch&) = delete;
+    //! move-constructor: takes over the reservation
+    AdaptivePrefetch(AdaptivePrefetch&& p)
+        : block_pool_(p.block_pool_), base_(p.base_), depth_(p.depth_),
+          reserved_(p.reserved_), ready_streak_(p.ready_streak_) {
+        p.reserved_ = 0;
+    }
+
+    ~AdaptivePrefetch() { Reset(base_); }
+
+    //! current prefetch depth
+    size_t depth() const { return depth_; }
+
+    //! set a new initial depth and release the quota
+    void Reset(size_t depth);
+
+    //! record whether the Block delivered next was ready when it was needed
+    void Observe(bool ready);
+
+private:
+    //! BlockPool holding the prefetch quota
+    BlockPool* block_pool_;
+
+    //! initial depth
+    size_t base_;
+
+    //! current depth
+    size_t depth_;
+
+    //! number of depth steps above base_ reserved from the quota
+    size_t reserved_ = 0;
+
+    //! number of consecutive Blocks which were ready
+    size_t ready_streak_ = 0;
+};
+
 /*!
  * A BlockSource to read Blocks from a File. The KeepFileBlockSource mainly
  * contains an index to the current block, which is incremented when the
@@ -320,12 +517,15 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of block prefetch operations
-    size_t num_prefetch_;
+    //! adaptive number of block prefetch operations
+    AdaptivePrefetch prefetch_;
 
     //! current prefetch operations
     std::deque<data::PinRequestPtr> fetching_blocks_;
 
+    //! consumption rate of the reader for read-ahead deadlines
+    BlockConsumptionRate rate_;
+
     //! number of the first block
     size_t first_block_;
 
@@ -377,11 +577,14 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of block prefetch operations
-    size_t num_prefetch_;
+    //! adaptive number of block prefetch operations
+    AdaptivePrefetch prefetch_;
 
     //! current prefetch operations
     std::deque<data::PinRequestPtr> fetching_blocks_;
+
+    //! consumption rate of the reader for read-ahead deadlines
+    BlockConsumptionRate rate_;
 };
 
 //! Get BlockReader seeked to the corresponding item index
@@ -390,10 +593,18 @@ typename File::KeepReader
 File::GetReaderAt(size_t index, size_t prefetch) const {
     static constexpr bool debug = false;
 
+    if (delta_coding_)
+        die("File::GetReaderAt() cannot seek in a delta encoded File");
+
     // perform binary search for item block with largest exclusive size
-    // prefixsum less or equal to index.
+    // prefixsum less or equal to index. For fixed-size items, take the block
+    // in which the item starts, such that the Skip() below is plain pointer
+    // arithmetic inside that one block, instead of pinning the preceding
+    // block if its prefixsum equals index.
     auto it =
-        std::lower_bound(num_items_sum_.begin(), num_items_sum_.end(), index);
+        Serialization<KeepReader, ItemType>::is_fixed_size && index < num_items()
+        ? std::upper_bound(num_items_sum_.begin(), num_items_sum_.end(), index)
+        : std::lower_bound(num_items_sum_.begin(), num_items_sum_.end(), index);
 
     if (it == num_items_sum_.end())
         die("Access beyond end of File?");
@@ -453,6 +664,55 @@ ItemType File::GetItemAt(size_t index) const {
     return reader.Next<ItemType>();
 }
 
+template <typename ItemType>
+std::vector<ItemType> File::GetItemsAt(
+    const std::vector<size_t>& sorted_indices) const {
+
+    std::vector<ItemType> out;
+    out.reserve(sorted_indices.size());
+
+    size_t i = 0;
+    while (i < sorted_indices.size()) {
+        size_t index = sorted_indices[i];
+        assert(index < num_items());
+
+        // one Reader for all requested items starting in index's Block
+        size_t block = std::upper_bound(
+            num_items_sum_.begin(), num_items_sum_.end(), index)
+                       - num_items_sum_.begin();
+        size_t block_end = num_items_sum_[block];
+
+        KeepReader reader = GetReaderAt<ItemType>(index, /* prefetch */ 0);
+        out.emplace_back(reader.template Next<ItemType>());
+        size_t next = index + 1;
+
+        for (++i; i < sorted_indices.size() &&
+             sorted_indices[i] < block_end; ++i) {
+            index = sorted_indices[i];
+            assert(index + 1 >= next);
+            if (index + 1 == next) {
+                // repeated index
+                out.emplace_back(out.back());
+                continue;
+            }
+            if (Serialization<KeepReader, ItemType>::is_fixed_size) {
+                const size_t skip_items = index - next;
+                reader.Skip(skip_items, skip_items * (
+                                (reader.typecode_verify() ? sizeof(size_t) : 0)
+                                + Serialization<KeepReader, ItemType>::fixed_size));
+            }
+            else {
+                for ( ; next < index; ++next)
+                    reader.template Next<ItemType>();
+            }
+            out.emplace_back(reader.template Next<ItemType>());
+            next = index + 1;
+        }
+    }
+
+    return out;
+}
+
 template <typename ItemType, typename CompareFunction>
 size_t File::GetIndexOf(
     const ItemType& item, size_t tie, size_t left, size_t right,
@@ -503,6 +763,28 @@ std::vector<Block> File::GetItemRange(size_t begin, size_t end) const {
            .template GetItemBatch<ItemType>(end - begin);
 }
 
+template <typename ItemType>
+File File::Slice(size_t begin, size_t end) const {
+    assert(begin <= end && end <= num_items());
+
+    File f(*block_pool(), local_worker_id(), dia_id_);
+    if (begin == end) return f;
+
+    // the Blocks following the one the last item starts in only hold the rest
+    // of that item, but keep their original item count: clear it.
+    size_t remaining = end - begin;
+    for (Block& b : GetItemRange<ItemType>(begin, end)) {
+        size_t n = std::min(b.num_items(), remaining);
+        b.set_num_items(n);
+        remaining -= n;
+        f.AppendBlock(std::move(b));
+    }
+    assert(remaining == 0);
+
+    f.eviction_hint_ = eviction_hint_;
+    return f;
+}
+
 //! Take a vector of Readers and prefetch equally from them
 template <typename Reader>
 void StartPrefetch(std::vector<Reader>& readers, size_t prefetch) {
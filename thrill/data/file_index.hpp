@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * thrill/data/file_index.hpp
+ *
+ * Sparse index of the first items of the Blocks of an ordered File, kept in
+ * Eytzinger layout to speed up rank queries.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_FILE_INDEX_HEADER
+#define THRILL_DATA_FILE_INDEX_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+/*!
+ * FileIndex is an optional sparse index over an ordered File, which holds the
+ * first item starting in each Block. The items are stored in an Eytzinger
+ * (implicit binary search tree in BFS order) array, such that the descent
+ * touches few cache lines and needs no deserialization.
+ *
+ * GetIndexOf() first descends the index to find the two indexed items
+ * enclosing the searched position, and then runs File::GetIndexOf() only
+ * between them, hence all probes of the binary search lie in one Block.
+ *
+ * Only Blocks which are in memory when the index is built are indexed, hence
+ * building never reads from disk. The index must be rebuilt if the File
+ * changes.
+ */
+template <typename ItemType>
+class FileIndex
+{
+    static constexpr bool debug = false;
+
+public:
+    FileIndex() = default;
+
+    //! Build the index of the given File
+    explicit FileIndex(const File& file) { Build(file); }
+
+    //! Build the index of the given File, replacing the previous one.
+    void Build(const File& file) {
+        positions_.clear();
+        tree_.clear();
+
+        // cannot seek in delta encoded Files, leave the index empty.
+        if (file.delta_coding()) return;
+
+        size_t items_before = 0;
+        for (size_t i = 0; i < file.num_blocks(); ++i) {
+            const size_t items = file.ItemsStartIn(i);
+            if (items != 0 && file.block(i).byte_block()->in_memory())
+                positions_.push_back(items_before);
+            items_before += items;
+        }
+        if (positions_.empty()) return;
+
+        std::vector<ItemType> items =
+            file.template GetItemsAt<ItemType>(positions_);
+
+        tree_.resize(positions_.size() + 1);
+        size_t next = 0;
+        BuildTree(items, next, 1);
+        assert(next == items.size());
+
+        LOG << "FileIndex::Build() indexed " << positions_.size()
+            << " of " << file.num_blocks() << " blocks";
+    }
+
+    //! Returns the number of indexed items
+    size_t size() const { return positions_.size(); }
+
+    //! Returns true if no items are indexed
+    bool empty() const { return positions_.empty(); }
+
+    /*!
+     * Get index of the given item, or the next greater item, in the indexed
+     * file, with the same semantics and result as File::GetIndexOf().
+     */
+    template <typename CompareFunction = std::less<ItemType> >
+    size_t GetIndexOf(const File& file, const ItemType& item, size_t tie,
+                      size_t left, size_t right,
+                      const CompareFunction& less = CompareFunction()) const {
+        assert(left <= right);
+
+        if (!positions_.empty()) {
+            // find the first indexed item at or after the searched position,
+            // k becomes zero if there is none.
+            const size_t n = positions_.size();
+            size_t k = 1;
+            while (k <= n) {
+                const Entry& e = tree_[k];
+                bool before =
+                    !less(item, e.item) &&
+                    (less(e.item, item) || tie > positions_[e.rank]);
+                k = 2 * k + static_cast<size_t>(before);
+            }
+            k >>= common::ffs(~k);
+
+            // the searched position is in (lo, hi]
+            size_t rank = (k == 0) ? n : tree_[k].rank;
+            if (rank < n) {
+                const size_t hi = positions_[rank];
+                if (hi <= left) return left;
+                right = std::min(right, hi);
+            }
+            if (rank > 0) {
+                const size_t lo = positions_[rank - 1] + 1;
+                if (lo >= right) return right;
+                left = std::max(left, lo);
+            }
+        }
+
+        return file.GetIndexOf(item, tie, left, right, less);
+    }
+
+    //! Get index of the given item, or the next greater item, in the indexed
+    //! file, searching all items.
+    template <typename CompareFunction = std::less<ItemType> >
+    size_t GetIndexOf(const File& file, const ItemType& item, size_t tie,
+                      const CompareFunction& less = CompareFunction()) const {
+        return GetIndexOf(file, item, tie, 0, file.num_items(), less);
+    }
+
+private:
+    //! an indexed item and its rank in positions_
+    struct Entry {
+        ItemType item;
+        size_t   rank;
+    };
+
+    //! ascending positions of the indexed items in the File
+    std::vector<size_t> positions_;
+
+    //! indexed items in Eytzinger layout, the root is at index 1.
+    std::vector<Entry> tree_;
+
+    //! fill tree_ by an in-order traversal
+    void BuildTree(std::vector<ItemType>& items, size_t& next, size_t k) {
+        if (k >= tree_.size()) return;
+        BuildTree(items, next, 2 * k);
+        tree_[k].item = std::move(items[next]);
+        tree_[k].rank = next++;
+        BuildTree(items, next, 2 * k + 1);
+    }
+};
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_FILE_INDEX_HEADER
+
+/******************************************************************************/
@@ -194,6 +194,68 @@ bool MixBlockQueueReader::PullBlock() {
     return true;
 }
 
+/******************************************************************************/
+// MixBlockQueueSplitReader
+
+MixBlockQueueSplitReader::MixBlockQueueSplitReader(
+    MixBlockQueue& mix_queue, bool consume, size_t local_worker_id)
+    : mix_queue_(mix_queue),
+      reread_(mix_queue.read_closed()) {
+
+    readers_.reserve(mix_queue_.num_workers_);
+    for (size_t w = 0; w < mix_queue_.num_workers_; ++w) {
+        readers_.emplace_back(
+            mix_queue_.queues_[w].GetReader(consume, local_worker_id));
+    }
+
+    if (!reread_) {
+        available_.resize(mix_queue_.num_workers_, 0);
+        available_at_.resize(mix_queue_.num_workers_, 0);
+        closed_.resize(mix_queue_.num_workers_, 0);
+    }
+}
+
+bool MixBlockQueueSplitReader::HasNext(size_t src) {
+    assert(src < readers_.size());
+    if (reread_) return readers_[src].HasNext();
+
+    while (available_[src] == 0) {
+        if (closed_[src]) return false;
+        PullBlock();
+    }
+    return true;
+}
+
+void MixBlockQueueSplitReader::PullBlock() {
+    MixBlockQueue::SrcBlockPair src_blk = mix_queue_.Pop();
+    size_t src = src_blk.src;
+
+    LOG << "MixBlockQueueSplitReader::PullBlock()"
+        << " src=" << src << " block=" << src_blk.block
+        << " available_[src]=" << available_[src]
+        << " available_at_[src]=" << available_at_[src];
+
+    assert(src < readers_.size());
+
+    if (src_blk.block.IsValid()) {
+        // all but the last started item are whole.
+        available_at_[src] += src_blk.block.num_items();
+        if (available_at_[src] > 1) {
+            available_[src] += available_at_[src] - 1;
+            available_at_[src] = 1;
+        }
+    }
+    else {
+        // close block received: the last item is whole.
+        closed_[src] = 1;
+        available_[src] += available_at_[src];
+        available_at_[src] = 0;
+    }
+
+    // save block with data or sentinel for reader
+    mix_queue_.queues_[src].AppendBlock(std::move(src_blk.block));
+}
+
 } // namespace data
 } // namespace thrill
 
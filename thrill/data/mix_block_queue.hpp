@@ -13,7 +13,7 @@
 #define THRILL_DATA_MIX_BLOCK_QUEUE_HEADER
 
 #include <thrill/common/atomic_movable.hpp>
-#include <thrill/common/concurrent_bounded_queue.hpp>
+#include <thrill/common/mpsc_queue.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_queue.hpp>
@@ -22,6 +22,7 @@
 #include <thrill/data/dyn_block_reader.hpp>
 #include <thrill/data/file.hpp>
 
+#include <algorithm>
 #include <vector>
 
 namespace thrill {
@@ -31,6 +32,7 @@ namespace data {
 //! \{
 
 class MixBlockQueueReader;
+class MixBlockQueueSplitReader;
 
 /*!
  * Implements reading an unordered sequence of items from multiple workers,
@@ -38,7 +40,7 @@ class MixBlockQueueReader;
  *
  * When Blocks arrive from the net, the Multiplexer pushes (src, Blocks) pairs
  * to MixChannel, which pushes them into a MixBlockQueue. The
- * MixBlockQueue stores these in a ConcurrentBoundedQueue for atomic reading.
+ * MixBlockQueue stores these in a lock-free MpscQueue for atomic reading.
  *
  * When the MixChannel should be read, MixBlockQueueReader is used, which
  * retrieves Blocks from the queue. The Reader contains one complete BlockReader
@@ -113,7 +115,7 @@ private:
     BlockPool& block_pool_;
 
     //! the main mix queue, containing the block in the reception order.
-    common::ConcurrentBoundedQueue<SrcBlockPair> mix_queue_;
+    common::MpscQueue<SrcBlockPair> mix_queue_;
 
     //! total number of workers in system.
     size_t num_workers_;
@@ -133,6 +135,7 @@ private:
 
     //! for access to queues_ and other internals.
     friend class MixBlockQueueReader;
+    friend class MixBlockQueueSplitReader;
 };
 
 /*!
@@ -234,6 +237,26 @@ public:
         }
     }
 
+    //! NextMany reads up to n items into an array and returns the number of
+    //! items read, see BlockReader::NextMany().
+    template <typename T>
+    size_t NextMany(T* out, size_t n) {
+        if (reread_)
+            return cat_reader_.template NextMany<T>(out, n);
+
+        size_t count = 0;
+        while (count < n && HasNext()) {
+            assert(available_ > 0);
+            assert(selected_ < readers_.size());
+
+            size_t m = readers_[selected_].template NextMany<T>(
+                out + count, std::min(n - count, available_));
+            available_ -= m;
+            count += m;
+        }
+        return count;
+    }
+
 private:
     //! reference to mix queue
     MixBlockQueue& mix_queue_;
@@ -270,6 +293,107 @@ private:
     bool PullBlock();
 };
 
+/*!
+ * Reader to retrieve the items of each source worker separately from a
+ * MixBlockQueue, in the order they were sent. This enables merging sorted
+ * sequences from all workers on the fly with core::MultiwayMergeTree over
+ * GetSourceReaders(), while their Blocks arrive in any order.
+ *
+ * HasNext(src) takes Blocks from the main mix queue and puts them into the
+ * BlockQueues of their sources, until a whole item of src is available. Like
+ * in MixBlockQueueReader, the last item known to start in the Blocks of a
+ * source is only available once the next Block or the closing sentinel of the
+ * source arrived.
+ */
+class MixBlockQueueSplitReader
+{
+    static constexpr bool debug = false;
+
+public:
+    MixBlockQueueSplitReader(MixBlockQueue& mix_queue,
+                             bool consume, size_t local_worker_id);
+
+    //! non-copyable: delete copy-constructor
+    MixBlockQueueSplitReader(const MixBlockQueueSplitReader&) = delete;
+    //! non-copyable: delete assignment operator
+    MixBlockQueueSplitReader& operator = (const MixBlockQueueSplitReader&) = delete;
+    //! move-constructor: default
+    MixBlockQueueSplitReader(MixBlockQueueSplitReader&&) = default;
+    //! move-assignment operator: default
+    MixBlockQueueSplitReader& operator = (MixBlockQueueSplitReader&&) = default;
+
+    //! View of the items of one source worker with the HasNext() and Next()
+    //! methods of a BlockReader, e.g. as input of core::MultiwayMergeTree.
+    class SourceReader
+    {
+    public:
+        SourceReader(MixBlockQueueSplitReader& reader, size_t src)
+            : reader_(&reader), src_(src) { }
+
+        //! HasNext() returns true if at least one more item is available.
+        bool HasNext() { return reader_->HasNext(src_); }
+
+        //! Next() reads a complete item T
+        template <typename T>
+        T Next() { return reader_->template Next<T>(src_); }
+
+    private:
+        MixBlockQueueSplitReader* reader_;
+        size_t src_;
+    };
+
+    //! Returns the number of source workers
+    size_t num_sources() const { return readers_.size(); }
+
+    //! Returns a SourceReader for each source worker. These refer to this
+    //! object, which must not be moved while they are used.
+    std::vector<SourceReader> GetSourceReaders() {
+        std::vector<SourceReader> out;
+        out.reserve(readers_.size());
+        for (size_t w = 0; w < readers_.size(); ++w)
+            out.emplace_back(*this, w);
+        return out;
+    }
+
+    //! HasNext() returns true if at least one more item is available from src.
+    bool HasNext(size_t src);
+
+    //! Next() reads a complete item T from src
+    template <typename T>
+    T Next(size_t src) {
+        assert(HasNext(src));
+
+        if (!reread_) {
+            assert(available_[src] > 0);
+            --available_[src];
+        }
+        return readers_[src].template Next<T>();
+    }
+
+private:
+    //! reference to mix queue
+    MixBlockQueue& mix_queue_;
+
+    //! flag whether we are rereading the mix queue from the cached files.
+    const bool reread_;
+
+    //! sub-readers for each block queue in mix queue
+    std::vector<BlockQueue::Reader> readers_;
+
+    //! number of whole items available on each reader
+    std::vector<size_t> available_;
+
+    //! number of additional items started at each reader, which may not be
+    //! whole yet.
+    std::vector<size_t> available_at_;
+
+    //! flag whether the closing sentinel of each reader arrived.
+    std::vector<unsigned char> closed_;
+
+    //! take the next Block from the mix queue and deliver it to its reader.
+    void PullBlock();
+};
+
 //! \}
 
 } // namespace data
@@ -38,10 +38,13 @@ MixStream::MixStream(Multiplexer& multiplexer, const StreamId& id,
             }
             else {
                 // StreamSink which transmits MIX_STREAM_BLOCKs
+                // on one of the parallel connections, which keeps the order
+                // of its blocks.
                 sinks_.emplace_back(
                     *this,
                     multiplexer_.block_pool_,
-                    &multiplexer_.group_.connection(host),
+                    &multiplexer_.connection(
+                        host, id + local_worker_id * workers_per_host() + worker),
                     MagicByte::MixStreamBlock,
                     id,
                     my_host_rank(), local_worker_id,
@@ -57,6 +60,8 @@ MixStream::MixStream(Multiplexer& multiplexer, const StreamId& id,
             my_host_rank() * multiplexer_.workers_per_host() + worker,
             worker);
     }
+
+    StreamSink::AssignBatches(sinks_, &batches_);
 }
 
 MixStream::~MixStream() {
@@ -72,6 +77,9 @@ std::vector<MixStream::Writer>
 MixStream::GetWriters(size_t block_size) {
     tx_timespan_.StartEventually();
 
+    if (block_size == 0)
+        block_size = AdaptiveBlockSize();
+
     std::vector<Writer> result;
     result.reserve(num_workers());
 
@@ -102,6 +110,16 @@ MixStream::MixReader MixStream::GetReader(bool consume) {
     return GetMixReader(consume);
 }
 
+MixStream::SplitReader MixStream::GetSplitReader(bool consume) {
+    rx_timespan_.StartEventually();
+    return SplitReader(queue_, consume, local_worker_id_);
+}
+
+void MixStream::ScheduleExchange() {
+    StreamSink::AssignSchedule(sinks_, my_host_rank(), num_hosts(),
+                               workers_per_host(), &schedule_);
+}
+
 void MixStream::Close() {
     if (is_closed_) return;
     is_closed_ = true;
@@ -141,7 +159,10 @@ bool MixStream::closed() const {
 
 void MixStream::OnStreamBlock(size_t from, PinnedBlock&& b) {
     assert(from < num_workers());
-    rx_timespan_.StartEventually();
+    {
+        std::unique_lock<std::mutex> lock(rx_timer_mutex_);
+        rx_timespan_.StartEventually();
+    }
 
     rx_bytes_ += b.size();
     rx_blocks_++;
@@ -154,6 +175,11 @@ void MixStream::OnStreamBlock(size_t from, PinnedBlock&& b) {
     queue_.AppendBlock(from, std::move(b).MoveToBlock());
 }
 
+void MixStream::OnStreamCredit(size_t from, size_t credits) {
+    assert(from < sinks_.size());
+    sinks_[from].AddCredits(credits);
+}
+
 void MixStream::OnCloseStream(size_t from) {
     assert(from < num_workers());
     queue_.Close(from);
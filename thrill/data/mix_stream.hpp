@@ -17,6 +17,7 @@
 #include <thrill/data/stream.hpp>
 #include <thrill/data/stream_sink.hpp>
 
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -45,6 +46,7 @@ class MixStream final : public Stream
 {
 public:
     using MixReader = MixBlockQueueReader;
+    using SplitReader = MixBlockQueueSplitReader;
 
     //! Creates a new stream instance
     MixStream(Multiplexer& multiplexer, const StreamId& id,
@@ -64,9 +66,10 @@ public:
     void set_dia_id(size_t dia_id);
 
     //! Creates BlockWriters for each worker. BlockWriter can only be opened
-    //! once, otherwise the block sequence is incorrectly interleaved!
+    //! once, otherwise the block sequence is incorrectly interleaved! A
+    //! block_size of 0 selects AdaptiveBlockSize().
     std::vector<Writer>
-    GetWriters(size_t block_size = default_block_size) final;
+    GetWriters(size_t block_size = 0) final;
 
     //! Creates a BlockReader which mixes items from all workers.
     MixReader GetMixReader(bool consume);
@@ -74,6 +77,15 @@ public:
     //! Open a MixReader (function name matches a method in File and CatStream).
     MixReader GetReader(bool consume);
 
+    //! Creates a reader which delivers the items of each worker separately,
+    //! in the order they were sent, while Blocks arrive in any order.
+    SplitReader GetSplitReader(bool consume);
+
+    //! Sends the Blocks to other hosts in pairwise phases after all Writers
+    //! are closed, instead of sending to all hosts at once. Must be called
+    //! before writing.
+    void ScheduleExchange();
+
     //! shuts the stream down.
     void Close() final;
 
@@ -87,6 +99,12 @@ private:
     //! flag if Close() was completed
     bool is_closed_ = false;
 
+    //! batches of the sinks_ per connection, which batch small Blocks.
+    std::deque<StreamSinkBatch> batches_;
+
+    //! schedule of the sinks_ if the exchange is scheduled.
+    StreamSinkSchedule schedule_;
+
     //! StreamSink objects are receivers of Blocks outbound for other worker.
     std::vector<StreamSink> sinks_;
 
@@ -103,6 +121,10 @@ private:
     //! called from Multiplexer when there is a new Block for this Stream.
     void OnStreamBlock(size_t from, PinnedBlock&& b);
 
+    //! called from Multiplexer when the receiving worker from granted credits
+    //! to the StreamSink sending to it.
+    void OnStreamCredit(size_t from, size_t credits);
+
     //! called from Multiplexer when a MixStream closed notification was
     //! received.
     void OnCloseStream(size_t from);
@@ -11,14 +11,24 @@
 
 #include <thrill/data/multiplexer.hpp>
 
+#include <thrill/common/mpsc_queue.hpp>
+#include <thrill/data/block_compression.hpp>
 #include <thrill/data/cat_stream.hpp>
 #include <thrill/data/mix_stream.hpp>
 #include <thrill/data/multiplexer_header.hpp>
 #include <thrill/data/stream.hpp>
 #include <thrill/mem/aligned_allocator.hpp>
+#include <thrill/net/dispatcher.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -87,6 +97,22 @@ public:
         die("object " + std::to_string(object_id) + " not in repository");
     }
 
+    //! Get object with given id, or nullptr if it does not exist.
+    template <typename Subclass = Object>
+    common::CountingPtr<Subclass> GetOrNull(Id object_id) {
+        auto it = map_.find(object_id);
+        if (it == map_.end()) return common::CountingPtr<Subclass>();
+
+        die_unless(dynamic_cast<Subclass*>(it->second.get()));
+        return common::CountingPtr<Subclass>(
+            dynamic_cast<Subclass*>(it->second.get()));
+    }
+
+    //! Remove object with given id, if it exists.
+    void Erase(Id object_id) {
+        map_.erase(object_id);
+    }
+
     //! return mutable reference to map of objects.
     std::map<Id, ObjectPtr>& map() { return map_; }
 
@@ -105,6 +131,71 @@ struct Multiplexer::Data {
     //! Streams have an ID in block headers. (worker id, stream id)
     Repository<StreamSetBase> stream_sets_;
 
+    //! credits not yet granted to a sender
+    struct Credits {
+        //! magic byte of the stream's Blocks
+        MagicByte                             magic = MagicByte::Invalid;
+        //! number of received Blocks
+        size_t                                count = 0;
+        //! whether the grant is delayed, and since when
+        bool                                  delayed = false;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    //! credits of each (stream id, sender worker, receiver local worker)
+    std::map<std::tuple<size_t, size_t, size_t>, Credits> credits_;
+
+    //! whether the timer for delayed credits is running
+    bool credit_timer_ = false;
+
+    //! whether any credits are delayed, read by the BlockPool's relief
+    //! handler which must not lock credit_mutex_.
+    std::atomic<bool> credits_delayed_ { false };
+
+    //! id of the relief handler registered at the BlockPool
+    size_t relief_id_ = 0;
+
+    //! protects the credits, which are counted by all dispatcher threads
+    std::mutex credit_mutex_;
+
+    //! pre-allocated ByteBlocks of default_block_size into which a connection
+    //! receives the Blocks of one local worker. Only the connection's
+    //! dispatcher thread pops from the queue, except when the refill thread
+    //! releases the ByteBlocks under memory pressure, and only the refill
+    //! thread pushes to it.
+    struct ReceivePool {
+        //! the pre-allocated ByteBlocks, pinned by local_worker
+        common::MpscQueue<PinnedByteBlockPtr> blocks;
+        //! serializes the pops of the dispatcher and the refill thread, it is
+        //! only contended while the ByteBlocks are released.
+        std::mutex pop_mutex;
+        //! number of ByteBlocks in the queue and requested from the refill
+        //! thread
+        std::atomic<size_t> filled { 0 };
+        //! local worker receiving into the ByteBlocks
+        size_t                local_worker;
+    };
+
+    //! receive pools of each connection and local worker, the map is fixed
+    //! after construction.
+    std::unordered_map<const net::Connection*,
+                       std::vector<std::unique_ptr<ReceivePool> > >
+    receive_pools_;
+
+    //! refill requests of receive pools. A nullptr with zero terminates the
+    //! thread, and with one releases the ByteBlocks of all pools.
+    common::MpscQueue<std::pair<ReceivePool*, size_t> > refill_requests_;
+
+    //! whether a release request is queued, which coalesces the BlockPool's
+    //! pressure signals.
+    std::atomic<bool> release_pending_ { false };
+
+    //! id of the pressure handler registered at the BlockPool
+    size_t pressure_id_ = 0;
+
+    //! thread allocating ByteBlocks for the receive pools
+    std::thread refill_thread_;
+
     explicit Data(size_t workers_per_host)
         : stream_sets_(workers_per_host) { }
 };
@@ -112,28 +203,242 @@ struct Multiplexer::Data {
 Multiplexer::Multiplexer(mem::Manager& mem_manager,
                          data::BlockPool& block_pool,
                          size_t workers_per_host, net::Group& group)
+    : Multiplexer(mem_manager, block_pool, workers_per_host,
+                  std::vector<net::Group*>({ &group })) { }
+
+//! Default number of pre-allocated receive ByteBlocks per connection and local
+//! worker: the environment variable THRILL_NET_RECEIVE_POOL, default 2. Zero
+//! disables the receive pools.
+static size_t DefaultReceivePoolDepth() {
+    static const size_t depth = []() -> size_t {
+        const char* env = getenv("THRILL_NET_RECEIVE_POOL");
+        if (env == nullptr || *env == 0) return 2;
+        char* endp;
+        unsigned long n = strtoul(env, &endp, 10);
+        die_unless(*endp == 0);
+        return n;
+    } ();
+    return depth;
+}
+
+//! Default for credit based flow control: the environment variable
+//! THRILL_FLOW_CONTROL, default 1. Zero disables it, such that senders never
+//! hold back Blocks. All hosts must use the same setting.
+static bool DefaultFlowControl() {
+    static const bool enabled = []() -> bool {
+        const char* env = getenv("THRILL_FLOW_CONTROL");
+        if (env == nullptr || *env == 0) return true;
+        char* endp;
+        unsigned long n = strtoul(env, &endp, 10);
+        die_unless(*endp == 0);
+        return n != 0;
+    } ();
+    return enabled;
+}
+
+//! Default number of dispatcher threads: the environment variable
+//! THRILL_NET_DISPATCHER_THREADS, default 1.
+static size_t DefaultDispatcherThreads() {
+    static const size_t threads = []() -> size_t {
+        const char* env = getenv("THRILL_NET_DISPATCHER_THREADS");
+        if (env == nullptr || *env == 0) return 1;
+        char* endp;
+        unsigned long n = strtoul(env, &endp, 10);
+        die_unless(*endp == 0 && n != 0);
+        return n;
+    } ();
+    return threads;
+}
+
+Multiplexer::Multiplexer(mem::Manager& mem_manager,
+                         data::BlockPool& block_pool,
+                         size_t workers_per_host,
+                         const std::vector<net::Group*>& groups,
+                         size_t num_dispatchers)
     : mem_manager_(mem_manager),
       block_pool_(block_pool),
-      dispatcher_(
-          mem_manager, group,
-          "host " + mem::to_string(group.my_host_rank()) + " multiplexer"),
-      group_(group),
+      group_(*groups.at(0)),
+      groups_(groups),
       workers_per_host_(workers_per_host),
+      tp_last_(std::chrono::steady_clock::now()),
+      receive_pool_depth_(DefaultReceivePoolDepth()),
+      flow_control_(DefaultFlowControl()),
       d_(std::make_unique<Data>(workers_per_host)) {
-    for (size_t id = 0; id < group_.num_hosts(); id++) {
-        if (id == group_.my_host_rank()) continue;
-        AsyncReadMultiplexerHeader(group_.connection(id));
+
+    if (num_dispatchers == 0)
+        num_dispatchers = DefaultDispatcherThreads();
+
+    // there is nothing to shard beyond one thread per connection
+    size_t num_connections = groups_.size() * (group_.num_hosts() - 1);
+    num_dispatchers = std::max<size_t>(
+        1, std::min(num_dispatchers, num_connections));
+
+    for (size_t i = 0; i < num_dispatchers; ++i) {
+        dispatchers_.emplace_back(
+            std::make_unique<net::DispatcherThread>(
+                mem_manager, group_,
+                "host " + mem::to_string(group_.my_host_rank())
+                + " multiplexer"
+                + (num_dispatchers > 1 ? " " + mem::to_string(i) : "")));
+    }
+    prev_busy_us_.resize(num_dispatchers);
+
+    // all parallel connections deliver blocks of arbitrary streams, since the
+    // StreamMultiplexerHeader identifies the stream. The connections are
+    // assigned round-robin to the dispatcher threads.
+    size_t index = 0;
+    for (net::Group* g : groups_) {
+        assert(g->num_hosts() == group_.num_hosts());
+        for (size_t id = 0; id < g->num_hosts(); id++) {
+            if (id == g->my_host_rank()) continue;
+            dispatcher_of_[&g->connection(id)] =
+                dispatchers_[index++ % num_dispatchers].get();
+        }
+    }
+
+    // create empty receive pools, which are filled after their first use.
+    if (receive_pool_depth_ != 0 && !dispatcher_of_.empty()) {
+        for (auto& dc : dispatcher_of_) {
+            auto& pools = d_->receive_pools_[dc.first];
+            for (size_t w = 0; w < workers_per_host_; ++w) {
+                pools.emplace_back(std::make_unique<Data::ReceivePool>());
+                pools.back()->local_worker = w;
+            }
+        }
+        d_->refill_thread_ = std::thread([this]() { RefillLoop(); });
+
+        // pinned ByteBlocks cannot be evicted, hence the pools give them back
+        // when the BlockPool runs out of memory. The handler is called with
+        // the BlockPool locked, hence the refill thread releases them.
+        d_->pressure_id_ = block_pool_.AddPressureHandler(
+            [this](size_t) {
+                if (!d_->release_pending_.exchange(true))
+                    d_->refill_requests_.emplace(nullptr, 1);
+            });
+    }
+
+    // send delayed credits as soon as the BlockPool is below its soft limit
+    // again. The handler is called with the BlockPool locked, hence it only
+    // schedules sending them on a dispatcher thread.
+    if (flow_control_) {
+        d_->relief_id_ = block_pool_.AddReliefHandler(
+            [this]() {
+                if (!d_->credits_delayed_.exchange(false)) return;
+                dispatchers_[0]->AddTimer(
+                    std::chrono::milliseconds(0),
+                    [this]() { OnCreditRelief(); return false; });
+            });
+    }
+
+    for (net::Group* g : groups_) {
+        for (size_t id = 0; id < g->num_hosts(); id++) {
+            if (id == g->my_host_rank()) continue;
+            AsyncReadMultiplexerHeader(g->connection(id));
+        }
     }
     (void)mem_manager_;     // silence unused variable warning.
 }
 
+PinnedByteBlockPtr Multiplexer::AllocateReceiveBlock(
+    Connection& s, size_t alloc_size, size_t local_worker) {
+    if (alloc_size != default_block_size || receive_pool_depth_ == 0)
+        return block_pool_.AllocateByteBlock(alloc_size, local_worker);
+
+    Data::ReceivePool& pool = *d_->receive_pools_.at(&s)[local_worker];
+
+    PinnedByteBlockPtr bytes;
+    bool hit;
+    {
+        std::unique_lock<std::mutex> lock(pool.pop_mutex);
+        hit = pool.blocks.try_pop(bytes);
+    }
+    if (hit) --pool.filled;
+    sLOG << "receive pool of local worker" << local_worker << "hit" << hit;
+
+    // request the missing ByteBlocks from the refill thread
+    size_t filled = pool.filled.load();
+    if (filled < receive_pool_depth_) {
+        pool.filled += receive_pool_depth_ - filled;
+        d_->refill_requests_.emplace(&pool, receive_pool_depth_ - filled);
+    }
+
+    if (hit) return bytes;
+    return block_pool_.AllocateByteBlock(alloc_size, local_worker);
+}
+
+void Multiplexer::RefillLoop() {
+    common::NameThisThread(
+        "host " + mem::to_string(group_.my_host_rank()) + " receive pool");
+
+    std::pair<Data::ReceivePool*, size_t> request;
+    while (true) {
+        d_->refill_requests_.pop(request);
+        if (request.first == nullptr) {
+            if (request.second == 0) return;
+            d_->release_pending_ = false;
+            ReleaseReceivePools();
+            continue;
+        }
+
+        Data::ReceivePool& pool = *request.first;
+        for (size_t i = 0; i < request.second; ++i) {
+            // do not hold memory which the BlockPool would rather evict.
+            if (!block_pool_.below_soft_limit()) {
+                pool.filled -= request.second - i;
+                break;
+            }
+            pool.blocks.emplace(
+                block_pool_.AllocateByteBlock(
+                    default_block_size, pool.local_worker));
+        }
+    }
+}
+
+void Multiplexer::ReleaseReceivePools() {
+    std::vector<PinnedByteBlockPtr> released;
+    for (auto& pools : d_->receive_pools_) {
+        for (auto& pool : pools.second) {
+            std::unique_lock<std::mutex> lock(pool->pop_mutex);
+            PinnedByteBlockPtr bytes;
+            while (pool->blocks.try_pop(bytes)) {
+                --pool->filled;
+                released.emplace_back(std::move(bytes));
+            }
+        }
+    }
+    sLOG << "released" << released.size() << "receive pool ByteBlocks";
+    // the ByteBlocks are freed outside of the pools' locks.
+    released.clear();
+}
+
 void Multiplexer::Close() {
+    {
+        // stop releasing StreamSets while iterating over them
+        std::unique_lock<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+
     // close all still open Streams
     for (auto& ch : d_->stream_sets_.map())
         ch.second->Close();
 
-    // terminate dispatcher, this waits for unfinished AsyncWrites.
-    dispatcher_.Terminate();
+    if (flow_control_)
+        block_pool_.RemoveReliefHandler(d_->relief_id_);
+
+    // terminate dispatchers, this waits for unfinished AsyncWrites.
+    for (auto& dispatcher : dispatchers_)
+        dispatcher->Terminate();
+
+    // stop refilling and release the pre-allocated receive ByteBlocks
+    if (d_->refill_thread_.joinable()) {
+        block_pool_.RemovePressureHandler(d_->pressure_id_);
+        d_->refill_requests_.emplace(nullptr, 0);
+        d_->refill_thread_.join();
+    }
+    for (auto& pools : d_->receive_pools_) {
+        for (auto& pool : pools.second)
+            pool->blocks.clear();
+    }
 
     closed_ = true;
 }
@@ -142,7 +447,8 @@ Multiplexer::~Multiplexer() {
     if (!closed_)
         Close();
 
-    group_.Close();
+    for (net::Group* g : groups_)
+        g->Close();
 }
 
 size_t Multiplexer::AllocateCatStreamId(size_t local_worker_id) {
@@ -205,16 +511,76 @@ MixStreamPtr Multiplexer::IntGetOrCreateMixStream(
     return ptr;
 }
 
+size_t Multiplexer::num_stream_sets() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->stream_sets_.map().size();
+}
+
+void Multiplexer::OnStreamClosed(size_t stream_id) {
+    // declared before the lock, such that the streams are destroyed outside.
+    common::CountingPtr<StreamSetBase> set;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closing_) return;
+
+    set = d_->stream_sets_.GetOrNull(stream_id);
+    if (set && set->OnStreamClosed()) {
+        sLOG << "Multiplexer: releasing StreamSet" << stream_id;
+        d_->stream_sets_.Erase(stream_id);
+    }
+}
+
 common::JsonLogger& Multiplexer::logger() {
     return block_pool_.logger();
 }
 
+void Multiplexer::RunTask(const std::chrono::steady_clock::time_point& tp) {
+
+    double elapsed = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            tp - tp_last_).count());
+    tp_last_ = tp;
+
+    std::vector<double> utilization(dispatchers_.size());
+    std::vector<size_t> write_queue(dispatchers_.size());
+    std::vector<size_t> read_latency, write_latency;
+
+    for (size_t i = 0; i < dispatchers_.size(); ++i) {
+        net::Dispatcher::Stats& stats = dispatchers_[i]->dispatcher().stats();
+
+        uint64_t loop_us = stats.loop_us.load(std::memory_order_relaxed);
+        uint64_t wait_us = stats.wait_us.load(std::memory_order_relaxed);
+        uint64_t busy_us = loop_us > wait_us ? loop_us - wait_us : 0;
+
+        // the counters are updated after each loop, hence busy time is
+        // attributed in a jumpy fashion.
+        if (elapsed > 0 && busy_us > prev_busy_us_[i]) {
+            utilization[i] = std::min(
+                1.0, static_cast<double>(busy_us - prev_busy_us_[i]) / elapsed);
+        }
+        prev_busy_us_[i] = std::max(prev_busy_us_[i], busy_us);
+
+        write_queue[i] = stats.write_queue.load(std::memory_order_relaxed);
+        common::LatencyHistogram::Merge(&read_latency, stats.read_latency.Take());
+        common::LatencyHistogram::Merge(
+            &write_latency, stats.write_latency.Take());
+    }
+
+    logger()
+        << "class" << "Multiplexer"
+        << "event" << "profile"
+        << "dispatcher_utilization" << utilization
+        << "write_queue" << write_queue
+        << "read_latency" << read_latency
+        << "write_latency" << write_latency;
+}
+
 /******************************************************************************/
 
 //! expects the next MultiplexerHeader from a socket and passes to
 //! OnMultiplexerHeader
 void Multiplexer::AsyncReadMultiplexerHeader(Connection& s) {
-    dispatcher_.AsyncRead(
+    dispatcher(s).AsyncRead(
         s, MultiplexerHeader::total_size,
         net::AsyncReadCallback::make<
             Multiplexer, & Multiplexer::OnMultiplexerHeader>(this));
@@ -233,12 +599,58 @@ void Multiplexer::OnMultiplexerHeader(Connection& s, net::Buffer&& buffer) {
     StreamId id = header.stream_id;
     size_t local_worker = header.receiver_local_worker;
 
-    // round of allocation size to next power of two
-    size_t alloc_size = header.size;
+    // round of allocation size to next power of two, compressed blocks are
+    // received into a buffer of their compressed size.
+    size_t read_size =
+        header.compressed_size != 0 ? header.compressed_size : header.size;
+    size_t alloc_size = read_size;
     if (alloc_size < THRILL_DEFAULT_ALIGN) alloc_size = THRILL_DEFAULT_ALIGN;
     alloc_size = common::RoundUpToPowerOfTwo(alloc_size);
 
-    if (header.magic == MagicByte::CatStreamBlock)
+    if (header.magic == MagicByte::StreamBatch)
+    {
+        sLOG << "stream batch from" << s << "of size" << header.size;
+
+        dispatcher(s).AsyncRead(
+            s, header.size,
+            net::AsyncReadCallback::make<
+                Multiplexer, & Multiplexer::OnStreamBatch>(this));
+    }
+    else if (header.magic == MagicByte::CatStreamCredit)
+    {
+        sLOG << "credits" << header.size << "on CatStream" << id
+             << "from worker" << header.sender_worker;
+
+        // credits sent before the receiver got the end of stream may arrive
+        // after the stream was closed and released.
+        CatStreamSetPtr set;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            set = d_->stream_sets_.GetOrNull<CatStreamSet>(id);
+        }
+        if (set)
+            set->peer(local_worker)->OnStreamCredit(
+                header.sender_worker, header.size);
+
+        AsyncReadMultiplexerHeader(s);
+    }
+    else if (header.magic == MagicByte::MixStreamCredit)
+    {
+        sLOG << "credits" << header.size << "on MixStream" << id
+             << "from worker" << header.sender_worker;
+
+        MixStreamSetPtr set;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            set = d_->stream_sets_.GetOrNull<MixStreamSet>(id);
+        }
+        if (set)
+            set->peer(local_worker)->OnStreamCredit(
+                header.sender_worker, header.size);
+
+        AsyncReadMultiplexerHeader(s);
+    }
+    else if (header.magic == MagicByte::CatStreamBlock)
     {
         CatStreamPtr stream = GetOrCreateCatStream(
             id, local_worker, /* dia_id (unknown at this time) */ 0);
@@ -249,6 +661,7 @@ void Multiplexer::OnMultiplexerHeader(Connection& s, net::Buffer&& buffer) {
                  << "from worker" << header.sender_worker;
 
             stream->OnCloseStream(header.sender_worker);
+            GrantCredit(header);
 
             AsyncReadMultiplexerHeader(s);
         }
@@ -257,11 +670,11 @@ void Multiplexer::OnMultiplexerHeader(Connection& s, net::Buffer&& buffer) {
                  << "from worker" << header.sender_worker
                  << "for local_worker" << local_worker;
 
-            PinnedByteBlockPtr bytes = block_pool_.AllocateByteBlock(
-                alloc_size, local_worker);
+            PinnedByteBlockPtr bytes =
+                AllocateReceiveBlock(s, alloc_size, local_worker);
 
-            dispatcher_.AsyncRead(
-                s, header.size, std::move(bytes),
+            dispatcher(s).AsyncRead(
+                s, read_size, std::move(bytes),
                 [this, header, stream](Connection& s, PinnedByteBlockPtr&& bytes) {
                     OnCatStreamBlock(s, header, stream, std::move(bytes));
                 });
@@ -278,6 +691,7 @@ void Multiplexer::OnMultiplexerHeader(Connection& s, net::Buffer&& buffer) {
                  << "from worker" << header.sender_worker;
 
             stream->OnCloseStream(header.sender_worker);
+            GrantCredit(header);
 
             AsyncReadMultiplexerHeader(s);
         }
@@ -286,11 +700,11 @@ void Multiplexer::OnMultiplexerHeader(Connection& s, net::Buffer&& buffer) {
                  << "from worker" << header.sender_worker
                  << "for local_worker" << local_worker;
 
-            PinnedByteBlockPtr bytes = block_pool_.AllocateByteBlock(
-                alloc_size, local_worker);
+            PinnedByteBlockPtr bytes =
+                AllocateReceiveBlock(s, alloc_size, local_worker);
 
-            dispatcher_.AsyncRead(
-                s, header.size, std::move(bytes),
+            dispatcher(s).AsyncRead(
+                s, read_size, std::move(bytes),
                 [this, header, stream](Connection& s, PinnedByteBlockPtr&& bytes) mutable {
                     OnMixStreamBlock(s, header, stream, std::move(bytes));
                 });
@@ -310,11 +724,15 @@ void Multiplexer::OnCatStreamBlock(
          << "in CatStream" << header.stream_id
          << "from worker" << header.sender_worker;
 
+    if (header.compressed_size != 0)
+        bytes = DecompressBlock(header, bytes);
+
     stream->OnStreamBlock(
         header.sender_worker,
         PinnedBlock(std::move(bytes), 0, header.size,
                     header.first_item, header.num_items,
                     header.typecode_verify));
+    GrantCredit(header);
 
     AsyncReadMultiplexerHeader(s);
 }
@@ -328,15 +746,225 @@ void Multiplexer::OnMixStreamBlock(
          << "in MixStream" << header.stream_id
          << "from worker" << header.sender_worker;
 
+    if (header.compressed_size != 0)
+        bytes = DecompressBlock(header, bytes);
+
     stream->OnStreamBlock(
         header.sender_worker,
         PinnedBlock(std::move(bytes), 0, header.size,
                     header.first_item, header.num_items,
                     header.typecode_verify));
+    GrantCredit(header);
+
+    AsyncReadMultiplexerHeader(s);
+}
+
+void Multiplexer::OnStreamBatch(Connection& s, net::Buffer&& buffer) {
+
+    // received invalid Buffer: the connection has closed?
+    if (!buffer.IsValid()) return;
+
+    net::BufferReader br(buffer);
+    while (!br.empty()) {
+        StreamMultiplexerHeader header;
+        header.ParseHeader(br);
+
+        size_t read_size =
+            header.compressed_size != 0 ? header.compressed_size : header.size;
+
+        const uint8_t* data = buffer.data() + br.cursor();
+        br.Skip(read_size);
+
+        OnBatchedMessage(header, data);
+    }
 
     AsyncReadMultiplexerHeader(s);
 }
 
+void Multiplexer::OnBatchedMessage(
+    const StreamMultiplexerHeader& header, const uint8_t* data) {
+
+    StreamId id = header.stream_id;
+    size_t local_worker = header.receiver_local_worker;
+
+    auto deliver = [&](auto stream) {
+        stream->rx_bytes_ += MultiplexerHeader::total_size;
+
+        if (header.IsEnd()) {
+            sLOG << "batched end of stream" << id
+                 << "from worker" << header.sender_worker;
+
+            stream->OnCloseStream(header.sender_worker);
+            GrantCredit(header);
+            return;
+        }
+
+        sLOG << "batched block on stream" << id
+             << "from worker" << header.sender_worker
+             << "for local_worker" << local_worker;
+
+        size_t read_size = header.compressed_size != 0
+                           ? header.compressed_size : header.size;
+        size_t alloc_size = read_size;
+        if (alloc_size < THRILL_DEFAULT_ALIGN)
+            alloc_size = THRILL_DEFAULT_ALIGN;
+        alloc_size = common::RoundUpToPowerOfTwo(alloc_size);
+
+        PinnedByteBlockPtr bytes = block_pool_.AllocateByteBlock(
+            alloc_size, local_worker);
+        std::copy(data, data + read_size, bytes->data());
+
+        if (header.compressed_size != 0)
+            bytes = DecompressBlock(header, bytes);
+
+        stream->OnStreamBlock(
+            header.sender_worker,
+            PinnedBlock(std::move(bytes), 0, header.size,
+                        header.first_item, header.num_items,
+                        header.typecode_verify));
+        GrantCredit(header);
+    };
+
+    if (header.magic == MagicByte::CatStreamBlock) {
+        deliver(GetOrCreateCatStream(
+                    id, local_worker, /* dia_id (unknown at this time) */ 0));
+    }
+    else if (header.magic == MagicByte::MixStreamBlock) {
+        deliver(GetOrCreateMixStream(
+                    id, local_worker, /* dia_id (unknown at this time) */ 0));
+    }
+    else {
+        die("Invalid magic byte in batched MultiplexerHeader");
+    }
+}
+
+void Multiplexer::GrantCredit(const StreamMultiplexerHeader& header) {
+    if (!flow_control_) return;
+
+    auto key = std::make_tuple(header.stream_id, header.sender_worker,
+                               header.receiver_local_worker);
+
+    std::unique_lock<std::mutex> lock(d_->credit_mutex_);
+
+    // the sender closed after all its Blocks were granted
+    if (header.IsEnd()) {
+        d_->credits_.erase(key);
+        return;
+    }
+
+    Data::Credits& c = d_->credits_[key];
+    c.magic = header.magic;
+    if (++c.count < credit_batch || c.delayed) return;
+
+    if (block_pool_.below_soft_limit()) {
+        SendCredits(c.magic, header.stream_id, header.sender_worker,
+                    header.receiver_local_worker, c.count);
+        c.count = 0;
+        return;
+    }
+
+    // delay the credits such that the sender holds back its Blocks, until the
+    // BlockPool's relief handler finds them.
+    c.delayed = true;
+    c.since = std::chrono::steady_clock::now();
+    d_->credits_delayed_ = true;
+
+    if (!d_->credit_timer_) {
+        d_->credit_timer_ = true;
+        dispatchers_[0]->AddTimer(
+            std::chrono::milliseconds(10),
+            [this]() { return OnCreditTimer(); });
+    }
+
+    // the pool may have dropped below the limit before the flag was set.
+    if (block_pool_.below_soft_limit())
+        SendDelayedCredits();
+}
+
+bool Multiplexer::OnCreditTimer() {
+    std::unique_lock<std::mutex> lock(d_->credit_mutex_);
+
+    // timer is repeated while any credits are delayed
+    d_->credit_timer_ = SendDelayedCredits();
+    return d_->credit_timer_;
+}
+
+void Multiplexer::OnCreditRelief() {
+    std::unique_lock<std::mutex> lock(d_->credit_mutex_);
+    SendDelayedCredits();
+}
+
+bool Multiplexer::SendDelayedCredits() {
+    // delay credits for at most this long, since memory may only be freed by
+    // receiving more Blocks, which are swapped out here then.
+    static constexpr auto max_delay = std::chrono::milliseconds(100);
+
+    bool below_limit = block_pool_.below_soft_limit();
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+
+    bool any_delayed = false;
+    for (auto& kv : d_->credits_) {
+        Data::Credits& c = kv.second;
+        if (!c.delayed) continue;
+
+        if (below_limit || now - c.since >= max_delay) {
+            SendCredits(c.magic, std::get<0>(kv.first), std::get<1>(kv.first),
+                        std::get<2>(kv.first), c.count);
+            c.count = 0;
+            c.delayed = false;
+        }
+        else {
+            any_delayed = true;
+        }
+    }
+
+    d_->credits_delayed_ = any_delayed;
+    return any_delayed;
+}
+
+void Multiplexer::SendCredits(
+    MagicByte magic, size_t stream_id, size_t sender_worker,
+    size_t local_worker, size_t credits) {
+
+    size_t sender_host = sender_worker / workers_per_host_;
+
+    StreamMultiplexerHeader header;
+    header.magic = magic == MagicByte::CatStreamBlock
+                   ? MagicByte::CatStreamCredit : MagicByte::MixStreamCredit;
+    header.size = credits;
+    header.stream_id = stream_id;
+    header.receiver_local_worker = sender_worker % workers_per_host_;
+    header.sender_worker = my_host_rank() * workers_per_host_ + local_worker;
+
+    net::BufferBuilder bb;
+    header.Serialize(bb);
+
+    // use the parallel connection of the sender's StreamSink, credits pass
+    // the queued blocks since the sender waits for them.
+    net::Connection& c = connection(
+        sender_host,
+        stream_id + header.receiver_local_worker * workers_per_host_
+        + local_worker);
+    dispatcher(c).AsyncWriteUrgent(c, bb.ToBuffer());
+}
+
+PinnedByteBlockPtr Multiplexer::DecompressBlock(
+    const StreamMultiplexerHeader& header, const PinnedByteBlockPtr& bytes) {
+
+    size_t alloc_size = header.size;
+    if (alloc_size < THRILL_DEFAULT_ALIGN) alloc_size = THRILL_DEFAULT_ALIGN;
+    alloc_size = common::RoundUpToPowerOfTwo(alloc_size);
+
+    PinnedByteBlockPtr data = block_pool_.AllocateByteBlock(
+        alloc_size, header.receiver_local_worker);
+
+    die_unless(BlockDecompress(bytes->data(), header.compressed_size,
+                               data->data(), header.size));
+
+    return data;
+}
+
 BlockQueue* Multiplexer::CatLoopback(
     size_t stream_id, size_t from_worker_id, size_t to_worker_id) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -344,6 +972,13 @@ BlockQueue* Multiplexer::CatLoopback(
            ->peer(to_worker_id)->loopback_queue(from_worker_id);
 }
 
+CatStream* Multiplexer::CatLoopbackStream(
+    size_t stream_id, size_t to_worker_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->stream_sets_.GetOrDie<CatStreamSet>(stream_id)
+           ->peer(to_worker_id).get();
+}
+
 MixBlockQueueSink* Multiplexer::MixLoopback(
     size_t stream_id, size_t from_worker_id, size_t to_worker_id) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -14,12 +14,16 @@
 #define THRILL_DATA_MULTIPLEXER_HEADER
 
 #include <thrill/common/json_logger.hpp>
+#include <thrill/common/profile_task.hpp>
 #include <thrill/net/dispatcher_thread.hpp>
 #include <thrill/net/group.hpp>
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace thrill {
 namespace data {
@@ -47,6 +51,8 @@ class MixBlockQueueSink;
 
 class StreamMultiplexerHeader;
 
+enum class MagicByte : uint8_t;
+
 /*!
  * Multiplexes virtual Connections on Dispatcher.
  *
@@ -61,7 +67,7 @@ class StreamMultiplexerHeader;
  * either attached to an existing stream or a new stream instance is
  * created.
  */
-class Multiplexer
+class Multiplexer : public common::ProfileTask
 {
     static constexpr bool debug = false;
 
@@ -70,6 +76,17 @@ public:
                 data::BlockPool& block_pool,
                 size_t workers_per_host, net::Group& group);
 
+    //! Construct Multiplexer on multiple Groups, all of the same type, which
+    //! contain parallel connections between each host pair. Outgoing stream
+    //! sinks are striped across the Groups. The connections are sharded
+    //! across num_dispatchers dispatcher threads, if zero the number is taken
+    //! from the environment variable THRILL_NET_DISPATCHER_THREADS, default 1.
+    Multiplexer(mem::Manager& mem_manager,
+                data::BlockPool& block_pool,
+                size_t workers_per_host,
+                const std::vector<net::Group*>& groups,
+                size_t num_dispatchers = 0);
+
     //! non-copyable: delete copy-constructor
     Multiplexer(const Multiplexer&) = delete;
     //! non-copyable: delete assignment operator
@@ -96,6 +113,26 @@ public:
         return num_hosts() * workers_per_host_;
     }
 
+    //! number of parallel connections to each host
+    size_t num_connections() const {
+        return groups_.size();
+    }
+
+    //! Connection to host used by the given stripe of parallel connections.
+    net::Connection& connection(size_t host, size_t stripe) {
+        return groups_[stripe % groups_.size()]->connection(host);
+    }
+
+    //! number of dispatcher threads
+    size_t num_dispatchers() const {
+        return dispatchers_.size();
+    }
+
+    //! Dispatcher thread which handles all reads and writes of a connection.
+    net::DispatcherThread& dispatcher(net::Connection& c) {
+        return *dispatcher_of_.at(&c);
+    }
+
     //! number of workers per host
     size_t workers_per_host() const {
         return workers_per_host_;
@@ -104,6 +141,9 @@ public:
     //! Get the used BlockPool
     BlockPool& block_pool() { return block_pool_; }
 
+    //! Whether receivers grant credits and StreamSinks wait for them.
+    bool flow_control() const { return flow_control_; }
+
     //! Get the JsonLogger from the BlockPool
     common::JsonLogger& logger();
 
@@ -137,6 +177,18 @@ public:
 
     //! \}
 
+    //! Returns the number of stream ids whose streams are not all closed yet.
+    size_t num_stream_sets();
+
+    //! \name Methods for ProfileTask
+    //! \{
+
+    //! Log the utilization, write queue depth, and read and write latency
+    //! histograms of the dispatcher threads.
+    void RunTask(const std::chrono::steady_clock::time_point& tp) final;
+
+    //! \}
+
 private:
     //! reference to host-global memory manager
     mem::Manager& mem_manager_;
@@ -144,13 +196,21 @@ private:
     //! reference to host-global BlockPool.
     data::BlockPool& block_pool_;
 
-    //! dispatcher used for all communication by data::Multiplexer, the thread
-    //! never leaves the data components!
-    net::DispatcherThread dispatcher_;
+    //! dispatchers used for all communication by data::Multiplexer, the
+    //! threads never leave the data components! Each connection is handled by
+    //! one of them, such that its messages stay in order.
+    std::vector<std::unique_ptr<net::DispatcherThread> > dispatchers_;
+
+    //! dispatcher thread of each connection
+    std::unordered_map<const net::Connection*, net::DispatcherThread*>
+    dispatcher_of_;
 
     // Holds NetConnections for outgoing Streams
     net::Group& group_;
 
+    //! all Groups with parallel connections, the first is group_.
+    std::vector<net::Group*> groups_;
+
     //! Number of workers per host
     size_t workers_per_host_;
 
@@ -160,11 +220,34 @@ private:
     //! closed
     bool closed_ = false;
 
+    //! Close() started, StreamSets are no longer released.
+    bool closing_ = false;
+
+    //! last time statistics where outputted
+    std::chrono::steady_clock::time_point tp_last_;
+
+    //! busy microseconds of each dispatcher at tp_last_
+    std::vector<uint64_t> prev_busy_us_;
+
+    //! number of pre-allocated receive ByteBlocks per connection and local
+    //! worker
+    size_t receive_pool_depth_;
+
+    //! whether credit based flow control is enabled
+    bool flow_control_;
+
     //! friends for access to network components
+    friend class Stream;
     friend class CatStream;
     friend class MixStream;
     friend class StreamSink;
 
+    //! Called by each Stream after its Close() completed. Once all local
+    //! streams of an id are closed, no more Blocks can arrive for it, hence
+    //! the StreamSet is released, such that the map of streams does not grow
+    //! with the number of stages.
+    void OnStreamClosed(size_t stream_id);
+
     //! Pointer to queue that is used for communication between two workers on
     //! the same host.
     BlockQueue * CatLoopback(
@@ -173,6 +256,10 @@ private:
     MixBlockQueueSink * MixLoopback(
         size_t stream_id, size_t from_worker_id, size_t to_worker_id);
 
+    //! Pointer to the CatStream of a worker on the same host, which receives
+    //! items moved by MoveToLocalWorker().
+    CatStream * CatLoopbackStream(size_t stream_id, size_t to_worker_id);
+
     /**************************************************************************/
 
     //! pimpl data structure
@@ -194,6 +281,20 @@ private:
     //! OnMultiplexerHeader
     void AsyncReadMultiplexerHeader(Connection& s);
 
+    //! Returns a ByteBlock into which the dispatcher thread of the connection
+    //! receives a Block for local_worker. ByteBlocks of default_block_size are
+    //! taken from the connection's receive pool, without locking the
+    //! BlockPool, unless the pool is empty.
+    PinnedByteBlockPtr AllocateReceiveBlock(
+        Connection& s, size_t alloc_size, size_t local_worker);
+
+    //! Loop of the thread refilling the receive pools.
+    void RefillLoop();
+
+    //! Free the ByteBlocks of all receive pools, called by the refill thread
+    //! when the BlockPool signals memory pressure.
+    void ReleaseReceivePools();
+
     //! parses MultiplexerHeader and decides whether to receive Block or close
     //! Stream
     void OnMultiplexerHeader(Connection& s, net::Buffer&& buffer);
@@ -207,6 +308,44 @@ private:
     void OnMixStreamBlock(
         Connection& s, const StreamMultiplexerHeader& header,
         const MixStreamPtr& stream, PinnedByteBlockPtr&& bytes);
+
+    //! Receives a batch of headers and small Blocks and dispatches them to
+    //! their streams.
+    void OnStreamBatch(Connection& s, net::Buffer&& buffer);
+
+    //! Dispatches one Block or end of stream of a batch, the Block's data is
+    //! copied from data.
+    void OnBatchedMessage(const StreamMultiplexerHeader& header,
+                          const uint8_t* data);
+
+    //! Counts a Block received on a stream for the credits granted to its
+    //! sender, and sends them in groups of credit_batch while the BlockPool
+    //! is below its soft limit. Otherwise they are delayed until eviction
+    //! brings the BlockPool below the limit, or for at most 100 ms.
+    void GrantCredit(const StreamMultiplexerHeader& header);
+
+    //! Sends expired delayed credits, called by a timer while there are any.
+    bool OnCreditTimer();
+
+    //! Sends delayed credits after the BlockPool dropped below its soft limit.
+    void OnCreditRelief();
+
+    //! Sends the delayed credits, all if the BlockPool is below its soft limit
+    //! and otherwise the expired ones. Requires credit_mutex_, returns whether
+    //! any are still delayed.
+    bool SendDelayedCredits();
+
+    //! Sends credits for the Blocks of stream_id received by local_worker
+    //! from sender_worker.
+    void SendCredits(MagicByte magic, size_t stream_id, size_t sender_worker,
+                     size_t local_worker, size_t credits);
+
+    //! number of credits sent together to a sender
+    static constexpr size_t credit_batch = 4;
+
+    //! Decompresses a received compressed Block into a new ByteBlock
+    PinnedByteBlockPtr DecompressBlock(
+        const StreamMultiplexerHeader& header, const PinnedByteBlockPtr& bytes);
 };
 
 //! \}
@@ -39,6 +39,8 @@ public:
     size_t size = 0;
     size_t num_items = 0;
     size_t first_item = 0;
+    //! size of the transmitted compressed data, zero if not compressed
+    size_t compressed_size = 0;
     //! typecode self verify
     bool typecode_verify = false;
 
@@ -52,8 +54,16 @@ public:
           typecode_verify(b.typecode_verify())
     { }
 
+    explicit MultiplexerHeader(MagicByte m, const Block& b)
+        : magic(m),
+          size(b.size()),
+          num_items(b.num_items()),
+          first_item(b.first_item_relative()),
+          typecode_verify(b.typecode_verify())
+    { }
+
     static constexpr size_t header_size =
-        sizeof(MagicByte) + 3 * sizeof(size_t);
+        sizeof(MagicByte) + 4 * sizeof(size_t);
 
     static constexpr size_t total_size =
         header_size + 3 * sizeof(size_t);
@@ -71,6 +81,7 @@ public:
             bb.Put<size_t>(first_item |
                            (typecode_verify ? size_t(1) << size_t_highest : 0));
         }
+        bb.Put<size_t>(compressed_size);
     }
 
     void ParseMultiplexerHeader(net::BufferReader& br) {
@@ -83,6 +94,7 @@ public:
             typecode_verify = (first_item & (size_t(1) << size_t_highest)) != 0;
             first_item &= ~(size_t(1) << size_t_highest);
         }
+        compressed_size = br.Get<size_t>();
     }
 };
 
@@ -107,6 +119,10 @@ public:
         : MultiplexerHeader(m, b)
     { }
 
+    explicit StreamMultiplexerHeader(MagicByte m, const Block& b)
+        : MultiplexerHeader(m, b)
+    { }
+
     //! Serializes the whole block struct into a buffer
     void Serialize(net::BufferBuilder& bb) const {
         SerializeMultiplexerHeader(bb);
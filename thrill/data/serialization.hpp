@@ -33,6 +33,9 @@ namespace data {
 template <typename Archive, typename T, typename Enable = void>
 struct Serialization;
 
+//! test for class methods, which take precedence over raw POD serialization
+THRILL_MAKE_METHOD_TEST(thrill_is_fixed_size)
+
 /******************* Serialization of plain old data types ********************/
 
 template <typename Archive, typename T>
@@ -41,6 +44,7 @@ struct Serialization<Archive, T,
                          // a POD, but not a pointer
                          std::is_pod<T>::value
                          && !std::is_pointer<T>::value
+                         && !has_method_thrill_is_fixed_size<T>::value
                          >::type>
 {
     static void Serialize(const T& x, Archive& ar) {
@@ -53,6 +57,14 @@ struct Serialization<Archive, T,
     static constexpr size_t fixed_size = sizeof(T);
 };
 
+//! test whether items of type T are serialized as their raw bytes, which is
+//! the case for PODs without custom serialization methods.
+template <typename T>
+struct is_raw_serializable
+    : public std::integral_constant<
+          bool, std::is_pod<T>::value && !std::is_pointer<T>::value
+          && !has_method_thrill_is_fixed_size<T>::value>{ };
+
 /********************** Serialization of strings ******************************/
 
 template <typename Archive>
@@ -236,8 +248,6 @@ struct Serialization<Archive, std::array<T, N>,
 
 /******************* Serialization via Class Methods **************************/
 
-THRILL_MAKE_METHOD_TEST(thrill_is_fixed_size)
-
 template <typename Archive, typename T>
 struct Serialization<Archive, T,
                      typename std::enable_if<
@@ -255,6 +265,91 @@ struct Serialization<Archive, T,
     static constexpr size_t fixed_size = T::thrill_fixed_size;
 };
 
+/******************* Serialization via THRILL_SERIALIZE ***********************/
+
+namespace detail {
+
+//! archive type for querying is_fixed_size and fixed_size of field types
+struct FixedSizeArchive { };
+
+//! fixed size information of a std::tie() of fields
+template <typename Tie>
+struct TieSerialization;
+
+template <typename ... Args>
+struct TieSerialization<std::tuple<Args& ...> >{
+    using Tuple = std::tuple<typename std::decay<Args>::type ...>;
+
+    static constexpr bool   is_fixed_size =
+        Serialization<FixedSizeArchive, Tuple>::is_fixed_size;
+    static constexpr size_t fixed_size =
+        Serialization<FixedSizeArchive, Tuple>::fixed_size;
+};
+
+template <typename Archive, typename Tie, size_t ... Is>
+static inline void SerializeTie(const Tie& t, Archive& ar,
+                                common::index_sequence<Is ...>) {
+    using Expander = int[];
+    (void)Expander {
+        0, (Serialization<
+                Archive, typename std::decay<
+                    typename std::tuple_element<Is, Tie>::type>::type>
+            ::Serialize(std::get<Is>(t), ar), 0) ...
+    };
+}
+
+template <typename Archive, typename Tie, size_t ... Is>
+static inline void DeserializeTie(const Tie& t, Archive& ar,
+                                  common::index_sequence<Is ...>) {
+    // braced initializer lists are evaluated in order
+    using Expander = int[];
+    (void)Expander {
+        0, (std::get<Is>(t) =
+                Serialization<
+                    Archive, typename std::decay<
+                        typename std::tuple_element<Is, Tie>::type>::type>
+                ::Deserialize(ar), 0) ...
+    };
+}
+
+} // namespace detail
+
+/*!
+ * Generates the class methods for serialization of the listed fields, which
+ * are written in order with the Serialization of their types, without a
+ * fallback to cereal. Use it inside the class body after the fields, e.g.
+ * THRILL_SERIALIZE(MyStruct, key, values). The class must be default
+ * constructible, and it is fixed size if all fields are, such that
+ * BlockWriter skips marking item boundaries.
+ */
+#define THRILL_SERIALIZE(Type, ...)                                         \
+    template <typename Archive>                                             \
+    void ThrillSerialize(Archive& ar) const {                               \
+        auto t = std::tie(__VA_ARGS__);                                     \
+        ::thrill::data::detail::SerializeTie(                               \
+            t, ar, ::thrill::common::make_index_sequence<                   \
+                std::tuple_size<decltype(t)>::value>());                    \
+    }                                                                       \
+    template <typename Archive>                                             \
+    void ThrillDeserializeFields(Archive& ar) {                             \
+        auto t = std::tie(__VA_ARGS__);                                     \
+        ::thrill::data::detail::DeserializeTie(                             \
+            t, ar, ::thrill::common::make_index_sequence<                   \
+                std::tuple_size<decltype(t)>::value>());                    \
+    }                                                                       \
+    template <typename Archive>                                             \
+    static Type ThrillDeserialize(Archive& ar) {                            \
+        Type x;                                                             \
+        x.ThrillDeserializeFields(ar);                                      \
+        return x;                                                           \
+    }                                                                       \
+    static constexpr bool thrill_is_fixed_size =                            \
+        ::thrill::data::detail::TieSerialization<                           \
+            decltype(std::tie(__VA_ARGS__))>::is_fixed_size;                \
+    static constexpr size_t thrill_fixed_size =                             \
+        ::thrill::data::detail::TieSerialization<                           \
+            decltype(std::tie(__VA_ARGS__))>::fixed_size
+
 //! \}
 
 } // namespace data
@@ -11,9 +11,12 @@
 
 #include <thrill/data/stream.hpp>
 
+#include <thrill/common/math.hpp>
 #include <thrill/data/cat_stream.hpp>
 #include <thrill/data/mix_stream.hpp>
 
+#include <algorithm>
+
 namespace thrill {
 namespace data {
 
@@ -28,6 +31,23 @@ Stream::Stream(Multiplexer& multiplexer, const StreamId& id,
 
 Stream::~Stream() { }
 
+size_t Stream::AdaptiveBlockSize() const {
+    return AdaptiveBlockSize(multiplexer_.block_pool().hard_ram_limit(),
+                             workers_per_host(), num_workers());
+}
+
+size_t Stream::AdaptiveBlockSize(
+    size_t ram_limit, size_t workers_per_host, size_t num_workers) {
+    if (ram_limit == 0) return default_block_size;
+
+    size_t budget = ram_limit / workers_per_host / 4;
+    size_t block_size = common::RoundDownToPowerOfTwo(
+        std::max<size_t>(budget / num_workers, 1));
+
+    return std::min(default_block_size,
+                    std::max(min_stream_block_size, block_size));
+}
+
 void Stream::OnAllClosed() {
     multiplexer_.logger()
         << "class" << "Stream"
@@ -41,6 +61,8 @@ void Stream::OnAllClosed() {
         << "rx_blocks" << rx_blocks_
         << "tx_bytes" << tx_bytes_
         << "tx_blocks" << tx_blocks_;
+
+    multiplexer_.OnStreamClosed(id_);
 }
 
 } // namespace data
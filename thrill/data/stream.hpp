@@ -20,6 +20,7 @@
 #include <thrill/data/file.hpp>
 #include <thrill/data/multiplexer.hpp>
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 
@@ -32,7 +33,11 @@ namespace data {
 using StreamId = size_t;
 
 enum class MagicByte : uint8_t {
-    Invalid, CatStreamBlock, MixStreamBlock, PartitionBlock
+    Invalid, CatStreamBlock, MixStreamBlock, PartitionBlock,
+    //! batch of small Blocks and end of stream headers sent as one message
+    StreamBatch,
+    //! credits granted by a receiver to a sender of a stream
+    CatStreamCredit, MixStreamCredit
 };
 
 /*!
@@ -74,9 +79,25 @@ public:
     virtual bool closed() const = 0;
 
     //! Creates BlockWriters for each worker. BlockWriter can only be opened
-    //! once, otherwise the block sequence is incorrectly interleaved!
+    //! once, otherwise the block sequence is incorrectly interleaved! The
+    //! block_size is the maximum size of Blocks, 0 selects
+    //! AdaptiveBlockSize().
     virtual std::vector<Writer>
-    GetWriters(size_t block_size = default_block_size) = 0;
+    GetWriters(size_t block_size = 0) = 0;
+
+    /*!
+     * Maximum block size of the num_workers() writers of this Stream. The
+     * BlockWriters start with small Blocks and double their size up to this
+     * limit, which is chosen such that the Blocks of all writers fit into a
+     * quarter of this worker's share of the BlockPool's hard RAM limit. The
+     * result is a power of two in [min_stream_block_size, default_block_size].
+     */
+    size_t AdaptiveBlockSize() const;
+
+    //! Calculate AdaptiveBlockSize() for given hard RAM limit (0 for none),
+    //! number of workers per host, and total number of workers.
+    static size_t AdaptiveBlockSize(
+        size_t ram_limit, size_t workers_per_host, size_t num_workers);
 
     /*!
      * Scatters a File to many worker: elements from [offset[0],offset[1]) are
@@ -149,8 +170,8 @@ public:
     ///////// expose these members - getters would be too java-ish /////////////
 
     //! StatsCounter for incoming data transfer.  Does not include loopback data
-    //! transfer
-    size_t rx_bytes_ = 0, rx_blocks_ = 0;
+    //! transfer. Blocks may arrive on several dispatcher threads.
+    std::atomic<size_t> rx_bytes_ { 0 }, rx_blocks_ { 0 };
 
     //! StatsCounters for outgoing data transfer - shared by all sinks.  Does
     //! not include loopback data transfer
@@ -178,7 +199,10 @@ protected:
 
     //! number of remaining expected stream closing operations. Required to know
     //! when to stop rx_lifetime
-    size_t remaining_closing_blocks_;
+    std::atomic<size_t> remaining_closing_blocks_;
+
+    //! protects starting rx_timespan_ by several dispatcher threads
+    std::mutex rx_timer_mutex_;
 
     //! number of received stream closing Blocks.
     common::Semaphore sem_closing_blocks_;
@@ -199,6 +223,17 @@ public:
 
     //! Close all streams in the set.
     virtual void Close() = 0;
+
+    //! Returns the number of streams in the set.
+    virtual size_t num_streams() const = 0;
+
+    //! Count a stream of the set whose Close() completed, returns true if all
+    //! streams are closed.
+    bool OnStreamClosed() { return ++num_closed_ == num_streams(); }
+
+private:
+    //! number of streams whose Close() completed
+    size_t num_closed_ = 0;
 };
 
 /*!
@@ -232,6 +267,8 @@ public:
             c->Close();
     }
 
+    size_t num_streams() const final { return streams_.size(); }
+
 private:
     //! 'owns' all streams belonging to one stream id for all local workers.
     std::vector<StreamPtr> streams_;
@@ -10,11 +10,15 @@
 
 #include <thrill/data/stream_sink.hpp>
 
+#include <thrill/common/math.hpp>
+#include <thrill/data/block_compression.hpp>
 #include <thrill/data/cat_stream.hpp>
 #include <thrill/data/mix_stream.hpp>
 #include <thrill/data/multiplexer_header.hpp>
 #include <thrill/data/stream.hpp>
 
+#include <algorithm>
+
 namespace thrill {
 namespace data {
 
@@ -26,11 +30,13 @@ StreamSink::StreamSink(Stream& stream, BlockPool& block_pool,
     : BlockSink(block_pool, host_local_worker),
       stream_(stream),
       connection_(connection),
+      dispatcher_(&stream.multiplexer_.dispatcher(*connection)),
       magic_(magic),
       id_(stream_id),
       host_rank_(host_rank),
       peer_rank_(peer_rank),
-      peer_local_worker_(peer_local_worker) {
+      peer_local_worker_(peer_local_worker),
+      flow_control_(stream.multiplexer_.flow_control()) {
     logger()
         << "class" << "StreamSink"
         << "event" << "open"
@@ -41,27 +47,94 @@ StreamSink::StreamSink(Stream& stream, BlockPool& block_pool,
 }
 
 void StreamSink::AppendBlock(const Block& block) {
-    return AppendPinnedBlock(block.PinWait(local_worker_id()));
+    if (block.size() == 0) return;
+    if (!AcquireCredit()) {
+        pending_.emplace_back(block);
+        ++held_counter_;
+        return;
+    }
+    SendBlock(block);
 }
 
 void StreamSink::AppendBlock(Block&& block) {
-    return AppendPinnedBlock(block.PinWait(local_worker_id()));
+    if (block.size() == 0) return;
+    if (!AcquireCredit()) {
+        pending_.emplace_back(std::move(block));
+        ++held_counter_;
+        return;
+    }
+    SendBlock(block);
 }
 
 void StreamSink::AppendPinnedBlock(const PinnedBlock& block) {
     if (block.size() == 0) return;
+    if (!AcquireCredit()) {
+        // hold the block back unpinned, such that it is spilled here instead
+        // of at the receiver if memory is short.
+        pending_.emplace_back(block.ToBlock());
+        ++held_counter_;
+        return;
+    }
+    SendPinnedBlock(block);
+}
+
+void StreamSink::AppendPinnedBlock(PinnedBlock&& block) {
+    return AppendPinnedBlock(block);
+}
+
+void StreamSink::AddCredits(size_t credits) {
+    credits_.signal(credits);
+}
+
+bool StreamSink::AcquireCredit() {
+    // scheduled sinks hold back all blocks until Finish()
+    if (schedule_) return false;
+    if (!flow_control_) return true;
+
+    // send blocks held back earlier first, as long as there are credits
+    while (!pending_.empty() && credits_.try_acquire()) {
+        Block block = std::move(pending_.front());
+        pending_.pop_front();
+        SendBlock(block);
+    }
+    if (pending_.empty() && credits_.try_acquire())
+        return true;
+
+    // out of credits: send the batch, such that the receiver gets all
+    // outstanding blocks and can grant more.
+    FlushBatch();
+    return false;
+}
+
+void StreamSink::SendBlock(const Block& block) {
+    if (CanSendFile(block))
+        return AppendFileBlock(block);
+    return SendPinnedBlock(block.PinWait(local_worker_id()));
+}
+
+bool StreamSink::CanSendFile(const Block& block) const {
+    // blocks of external files are immutable and not written to swap, hence
+    // they can be sent (uncompressed) from the file without pinning them.
+    return block.size() != 0 &&
+           !block_pool()->block_compression() &&
+           connection_->CanSendFile() &&
+           block.byte_block()->has_ext_file() &&
+           block.byte_block()->ext_file()->native_fd() >= 0;
+}
+
+void StreamSink::AppendFileBlock(const Block& block) {
+    // send previous small blocks first to keep the order
+    FlushBatch();
 
     sem_.wait();
 
-    sLOG << "StreamSink::AppendBlock" << block;
+    sLOG << "StreamSink::AppendFileBlock" << block;
 
     StreamMultiplexerHeader header(magic_, block);
     header.stream_id = id_;
     header.sender_worker = (host_rank_ * workers_per_host()) + local_worker_id_;
     header.receiver_local_worker = peer_local_worker_;
 
-    sLOG << "sending block" << common::Hexdump(block.ToString());
-
     net::BufferBuilder bb;
     header.Serialize(bb);
 
@@ -71,24 +144,100 @@ void StreamSink::AppendPinnedBlock(const PinnedBlock& block) {
     byte_counter_ += buffer.size() + block.size();
     ++block_counter_;
 
-    stream_.multiplexer_.dispatcher_.AsyncWrite(
+    dispatcher_->AsyncWriteFile(
         *connection_,
-        // send out Buffer and Block, guaranteed to be successive
+        // send out Buffer, followed by the Block's data from the file
         std::move(buffer), block,
         [this](net::Connection&) { sem_.signal(); });
 }
 
-void StreamSink::AppendPinnedBlock(PinnedBlock&& block) {
-    return AppendPinnedBlock(block);
+void StreamSink::SendPinnedBlock(const PinnedBlock& block) {
+    sLOG << "StreamSink::SendPinnedBlock" << block;
+
+    StreamMultiplexerHeader header(magic_, block);
+    header.stream_id = id_;
+    header.sender_worker = (host_rank_ * workers_per_host()) + local_worker_id_;
+    header.receiver_local_worker = peer_local_worker_;
+
+    sLOG << "sending block" << common::Hexdump(block.ToString());
+
+    // optionally compress the block into a new ByteBlock, which is then sent
+    // instead of the original block.
+    PinnedBlock send_block = block;
+
+    if (block_pool()->block_compression() && block.size() > THRILL_DEFAULT_ALIGN)
+    {
+        PinnedByteBlockPtr bytes = block_pool()->AllocateByteBlock(
+            common::RoundUpToPowerOfTwo(block.size()), local_worker_id_);
+
+        size_t csize = BlockCompress(
+            block.data_begin(), block.size(), bytes->data(), block.size() - 1);
+
+        if (csize != 0) {
+            header.compressed_size = csize;
+            send_block = PinnedBlock(std::move(bytes), 0, csize, 0, 0, false);
+        }
+    }
+
+    // small blocks are sent together with others in the batch
+    if (batch_ && send_block.size() <= batch_block_size) {
+        AppendToBatch(header, send_block.data_begin(), send_block.size());
+        if (batch_->size >= batch_size) FlushBatch();
+        return;
+    }
+
+    // send previous small blocks first to keep the order
+    FlushBatch();
+
+    sem_.wait();
+
+    net::BufferBuilder bb;
+    header.Serialize(bb);
+
+    net::Buffer buffer = bb.ToBuffer();
+    assert(buffer.size() == MultiplexerHeader::total_size);
+
+    byte_counter_ += buffer.size() + send_block.size();
+    ++block_counter_;
+
+    dispatcher_->AsyncWrite(
+        *connection_,
+        // send out Buffer and Block, guaranteed to be successive
+        std::move(buffer), send_block,
+        [this](net::Connection&) { sem_.signal(); });
 }
 
 void StreamSink::Close() {
     assert(!closed_);
     closed_ = true;
 
-    // wait for the last Blocks to be transmitted (take away semaphore tokens)
-    for (size_t i = 0; i < num_queue_; ++i)
-        sem_.wait();
+    if (schedule_) {
+        // when the last sink of the schedule is closed, all sinks send their
+        // blocks, one after another in the order of the schedule.
+        if (--schedule_->num_open != 0) return;
+
+        StreamSinkSchedule* schedule = schedule_;
+        for (StreamSink* sink : schedule->sinks)
+            sink->schedule_ = nullptr;
+        for (StreamSink* sink : schedule->sinks)
+            sink->Finish();
+        return;
+    }
+
+    Finish();
+}
+
+void StreamSink::Finish() {
+    // send all blocks held back, waiting for credits
+    while (!pending_.empty()) {
+        if (flow_control_ && !credits_.try_acquire()) {
+            FlushBatch();
+            credits_.wait();
+        }
+        Block block = std::move(pending_.front());
+        pending_.pop_front();
+        SendBlock(block);
+    }
 
     sLOG << "sending 'close stream' from host_rank" << host_rank_
          << "worker" << local_worker_id_
@@ -102,17 +251,36 @@ void StreamSink::Close() {
     header.sender_worker = (host_rank_ * workers_per_host()) + local_worker_id_;
     header.receiver_local_worker = peer_local_worker_;
 
-    net::BufferBuilder bb;
-    header.Serialize(bb);
+    if (batch_) {
+        // the end of stream header is sent with the batch, at the latest
+        // when the last sink of the batch is closed.
+        AppendToBatch(header, nullptr, 0);
+        if (--batch_->num_open == 0 || batch_->size >= batch_size)
+            FlushBatch();
 
-    net::Buffer buffer = bb.ToBuffer();
-    assert(buffer.size() == MultiplexerHeader::total_size);
+        // wait for the last Blocks to be transmitted (take away semaphore
+        // tokens)
+        for (size_t i = 0; i < num_queue_; ++i)
+            sem_.wait();
+    }
+    else {
+        // wait for the last Blocks to be transmitted (take away semaphore
+        // tokens)
+        for (size_t i = 0; i < num_queue_; ++i)
+            sem_.wait();
 
-    byte_counter_ += buffer.size();
-    ++block_counter_;
+        net::BufferBuilder bb;
+        header.Serialize(bb);
 
-    stream_.multiplexer_.dispatcher_.AsyncWrite(
-        *connection_, std::move(buffer));
+        net::Buffer buffer = bb.ToBuffer();
+        assert(buffer.size() == MultiplexerHeader::total_size);
+
+        byte_counter_ += buffer.size();
+        ++block_counter_;
+
+        dispatcher_->AsyncWrite(
+            *connection_, std::move(buffer));
+    }
 
     logger()
         << "class" << "StreamSink"
@@ -123,12 +291,118 @@ void StreamSink::Close() {
         << "tgt_worker" << (peer_rank_ * workers_per_host()) + peer_local_worker_
         << "bytes" << byte_counter_
         << "blocks" << block_counter_
+        << "held_blocks" << held_counter_
         << "timespan" << timespan_;
 
     stream_.tx_bytes_ += byte_counter_;
     stream_.tx_blocks_ += block_counter_;
 }
 
+void StreamSink::AssignBatches(std::vector<StreamSink>& sinks,
+                               std::deque<StreamSinkBatch>* batches) {
+    for (StreamSink& sink : sinks) {
+        if (sink.closed_ || !sink.connection_) continue;
+
+        auto it = std::find_if(
+            batches->begin(), batches->end(),
+            [&sink](const StreamSinkBatch& b) {
+                return b.connection == sink.connection_;
+            });
+        if (it == batches->end()) {
+            batches->emplace_back();
+            batches->back().connection = sink.connection_;
+            it = batches->end() - 1;
+        }
+        ++it->num_open;
+        sink.batch_ = &(*it);
+    }
+}
+
+void StreamSink::AssignSchedule(std::vector<StreamSink>& sinks,
+                                size_t my_host_rank, size_t num_hosts,
+                                size_t workers_per_host,
+                                StreamSinkSchedule* schedule) {
+    assert(sinks.size() == num_hosts * workers_per_host);
+
+    // in round r, all hosts send to their 1-factor peers, which send back.
+    for (size_t r = 0; r < common::CalcOneFactorSize(num_hosts); ++r) {
+        size_t peer = common::CalcOneFactorPeer(r, my_host_rank, num_hosts);
+        if (peer == my_host_rank) continue;
+
+        for (size_t w = 0; w < workers_per_host; ++w) {
+            StreamSink& sink = sinks[peer * workers_per_host + w];
+            if (sink.closed_ || !sink.connection_) continue;
+            assert(sink.block_counter_ == 0 && sink.pending_.empty());
+
+            schedule->sinks.push_back(&sink);
+            ++schedule->num_open;
+            sink.schedule_ = schedule;
+        }
+    }
+}
+
+void StreamSink::AppendToBatch(const StreamMultiplexerHeader& header,
+                               const void* data, size_t size) {
+    StreamSinkBatch& batch = *batch_;
+
+    net::BufferBuilder bb;
+    header.Serialize(bb);
+    assert(bb.size() == MultiplexerHeader::total_size);
+
+    // the ByteBlock grows with the messages up to about batch_size, since
+    // many batches carry only a few end of stream headers.
+    size_t need = batch.size + bb.size() + size;
+    if (!batch.bytes.valid() || need > batch.bytes->size()) {
+        PinnedByteBlockPtr bytes = block_pool()->AllocateByteBlock(
+            common::RoundUpToPowerOfTwo(
+                std::max(need, size_t(batch_min_alloc))),
+            local_worker_id_);
+        if (batch.size != 0) {
+            std::copy(batch.bytes->data(), batch.bytes->data() + batch.size,
+                      bytes->data());
+        }
+        batch.bytes = std::move(bytes);
+    }
+
+    uint8_t* out = batch.bytes->data() + batch.size;
+    assert(batch.size + bb.size() + size <= batch.bytes->size());
+    out = std::copy(bb.data(), bb.data() + bb.size(), out);
+    std::copy(reinterpret_cast<const uint8_t*>(data),
+              reinterpret_cast<const uint8_t*>(data) + size, out);
+    batch.size += bb.size() + size;
+
+    byte_counter_ += bb.size() + size;
+    ++block_counter_;
+}
+
+void StreamSink::FlushBatch() {
+    if (!batch_ || batch_->size == 0) return;
+
+    sem_.wait();
+
+    StreamMultiplexerHeader header;
+    header.magic = MagicByte::StreamBatch;
+    header.size = batch_->size;
+
+    net::BufferBuilder bb;
+    header.Serialize(bb);
+
+    net::Buffer buffer = bb.ToBuffer();
+    assert(buffer.size() == MultiplexerHeader::total_size);
+
+    sLOG << "StreamSink::FlushBatch() size" << header.size;
+
+    PinnedBlock send_block(
+        std::move(batch_->bytes), 0, batch_->size, 0, 0, false);
+    batch_->size = 0;
+
+    dispatcher_->AsyncWrite(
+        *batch_->connection,
+        // send out Buffer and Block, guaranteed to be successive
+        std::move(buffer), send_block,
+        [this](net::Connection&) { sem_.signal(); });
+}
+
 } // namespace data
 } // namespace thrill
 
@@ -20,8 +20,12 @@
 #include <thrill/data/block_sink.hpp>
 #include <thrill/data/stream.hpp>
 #include <thrill/net/buffer.hpp>
+#include <thrill/net/buffer_builder.hpp>
 #include <thrill/net/dispatcher_thread.hpp>
 
+#include <deque>
+#include <vector>
+
 namespace thrill {
 namespace data {
 
@@ -30,6 +34,47 @@ namespace data {
 
 // forward declarations
 class Stream;
+class StreamMultiplexerHeader;
+
+/*!
+ * Batch of messages of the StreamSinks of one Stream sending over the same
+ * connection. Small Blocks and end of stream headers are collected with their
+ * headers into one ByteBlock, which grows as needed and is sent after a
+ * StreamBatch header when it is full, before a large Block is sent, and when
+ * the last of the sinks is closed. The receiver reads the batch into one
+ * Buffer and parses all messages from it.
+ */
+class StreamSinkBatch
+{
+public:
+    //! connection of the sinks
+    net::Connection* connection = nullptr;
+
+    //! messages collected for the next StreamBatch, or invalid
+    PinnedByteBlockPtr bytes;
+
+    //! size of the messages in bytes
+    size_t size = 0;
+
+    //! number of sinks using this batch which are not closed
+    size_t num_open = 0;
+};
+
+/*!
+ * Schedule of the StreamSinks of one Stream sending to other hosts. The sinks
+ * hold back all Blocks until the last of them is closed, then they send to one
+ * peer host after another in the order of a 1-factor, such that each host
+ * sends to and receives from only one host at a time instead of all at once.
+ */
+class StreamSinkSchedule
+{
+public:
+    //! sinks in the order in which they send
+    std::vector<class StreamSink*> sinks;
+
+    //! number of sinks in the schedule which are not closed
+    size_t num_open = 0;
+};
 
 /*!
  * StreamSink is an BlockSink that sends data via a network socket to the
@@ -74,6 +119,39 @@ public:
     //! return close flag
     bool closed() const { return closed_; }
 
+    //! Adds credits granted by the receiver, called by the Multiplexer.
+    void AddCredits(size_t credits);
+
+    //! Number of Blocks a sink may send before the receiver grants credits.
+    //! The receiver grants one credit per received Block, unless its
+    //! BlockPool is above the soft limit, in which case it delays the grant
+    //! until eviction brings it below the limit, or for at most 100 ms. Blocks
+    //! appended without credit are held back unpinned at the sender, where
+    //! they are swapped out if memory is short. THRILL_FLOW_CONTROL=0 disables
+    //! the credits.
+    static constexpr size_t initial_credits = 16;
+
+    //! Groups the sinks by their connection into batches, which must outlive
+    //! the sinks.
+    static void AssignBatches(std::vector<StreamSink>& sinks,
+                              std::deque<StreamSinkBatch>* batches);
+
+    //! Puts the sinks to other hosts into a schedule, which must outlive the
+    //! sinks. Must be called before Blocks are appended.
+    static void AssignSchedule(std::vector<StreamSink>& sinks,
+                               size_t my_host_rank, size_t num_hosts,
+                               size_t workers_per_host,
+                               StreamSinkSchedule* schedule);
+
+    //! Blocks (after compression) up to this size are sent in batches.
+    static constexpr size_t batch_block_size = 16 * 1024;
+
+    //! A batch is sent when it reaches this size.
+    static constexpr size_t batch_size = 256 * 1024;
+
+    //! Initial size of a batch's ByteBlock, which is doubled as needed.
+    static constexpr size_t batch_min_alloc = 4 * 1024;
+
     //! boolean flag whether to check if AllocateByteBlock can fail in any
     //! subclass (if false: accelerate BlockWriter to not be able to cope with
     //! nullptr).
@@ -82,9 +160,39 @@ public:
 private:
     static constexpr bool debug = false;
 
+    //! Returns whether block can be sent directly from its external file
+    //! without pinning it.
+    bool CanSendFile(const Block& block) const;
+
+    //! Sends blocks held back while credits are available, and then takes a
+    //! credit for a new block. Returns false if there is none.
+    bool AcquireCredit();
+
+    //! Sends a block, from its file or pinned.
+    void SendBlock(const Block& block);
+
+    //! Sends a pinned block, possibly compressed or in the batch.
+    void SendPinnedBlock(const PinnedBlock& block);
+
+    //! Sends an unpinned block with Connection::SendFile().
+    void AppendFileBlock(const Block& block);
+
+    //! Appends a serialized header and size bytes of data to the batch.
+    void AppendToBatch(const StreamMultiplexerHeader& header,
+                       const void* data, size_t size);
+
+    //! Sends the batch if it contains messages.
+    void FlushBatch();
+
+    //! Sends all Blocks held back and the end of stream.
+    void Finish();
+
     Stream& stream_;
     net::Connection* connection_ = nullptr;
 
+    //! dispatcher thread of connection_
+    net::DispatcherThread* dispatcher_ = nullptr;
+
     MagicByte magic_ = MagicByte::Invalid;
     StreamId id_ = size_t(-1);
     size_t host_rank_ = size_t(-1);
@@ -93,6 +201,22 @@ private:
     size_t peer_local_worker_ = size_t(-1);
     bool closed_ = false;
 
+    //! batch shared with the sinks on the same connection, or nullptr
+    StreamSinkBatch* batch_ = nullptr;
+
+    //! schedule holding back all Blocks until its turn, or nullptr
+    StreamSinkSchedule* schedule_ = nullptr;
+
+    //! whether Blocks are held back without credits, see
+    //! Multiplexer::flow_control()
+    bool flow_control_ = false;
+
+    //! credits for sending Blocks granted by the receiver
+    common::Semaphore credits_ { initial_credits };
+
+    //! Blocks held back while out of credits
+    std::deque<Block> pending_;
+
     //! number of PinnedBlocks to queue in the network layer
     static constexpr size_t num_queue_ = 8;
 
@@ -102,6 +226,7 @@ private:
 
     size_t byte_counter_ = 0;
     size_t block_counter_ = 0;
+    size_t held_counter_ = 0;
     common::StatsTimerStart timespan_;
 };
 
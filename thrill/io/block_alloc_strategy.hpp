@@ -176,6 +176,31 @@ struct RCFlash : public RandomCyclic
     }
 };
 
+//! Load-balancing disk allocation scheme functor: chooses the disk with the
+//! fewest queued requests relative to its bandwidth weight, see
+//! DiskConfig::bandwidth. Ties are broken cyclically by the block index.
+//! \remarks model of \b allocation_strategy concept
+struct LeastLoaded : public Striping
+{
+private:
+    //! index of the previous call and number of repeated calls, which occur
+    //! if the chosen disk is full, to choose the next best disk.
+    mutable size_t last_i_ = size_t(-1), attempt_ = 0;
+
+public:
+    LeastLoaded(size_t b, size_t e) : Striping(b, e)
+    { }
+
+    LeastLoaded() : Striping()
+    { }
+
+    size_t operator () (size_t i) const;
+
+    static const char * name() {
+        return "least loaded disk";
+    }
+};
+
 //! 'Single disk' disk allocation scheme functor.
 //! \remarks model of \b allocation_strategy concept
 struct SingleDisk
@@ -23,6 +23,7 @@
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
 
 namespace thrill {
@@ -38,6 +39,7 @@ BlockManager::BlockManager() {
 
     // allocate disk_allocators
     ndisks_ = config->disks_number();
+    first_flash_ = config->flash_range().first;
     disk_allocators_.resize(ndisks_);
     disk_files_.resize(ndisks_);
 
@@ -79,6 +81,24 @@ BlockManager::BlockManager() {
         disk_allocators_[i] = new DiskAllocator(disk_files_[i].get(), cfg);
     }
 
+    // disks with unknown bandwidth get the average of the configured ones.
+    double bandwidth_sum = 0;
+    size_t bandwidth_num = 0;
+    for (size_t i = 0; i < ndisks_; ++i) {
+        if (config->disk(i).bandwidth <= 0) continue;
+        bandwidth_sum += config->disk(i).bandwidth;
+        ++bandwidth_num;
+    }
+    double bandwidth_avg =
+        bandwidth_num ? bandwidth_sum / static_cast<double>(bandwidth_num) : 1.0;
+
+    disk_weights_.resize(ndisks_);
+    for (size_t i = 0; i < ndisks_; ++i) {
+        double bandwidth = config->disk(i).bandwidth;
+        disk_weights_[i] = (bandwidth > 0 ? bandwidth : bandwidth_avg)
+                           / bandwidth_avg;
+    }
+
     if (ndisks_ > 1)
     {
         std::cerr
@@ -120,6 +140,49 @@ uint64_t BlockManager::get_free_bytes() const {
     return total;
 }
 
+std::pair<size_t, size_t> BlockManager::tier_range(size_t tier) const {
+    if (!tiered())
+        return tier == 0 ? std::make_pair(size_t(0), ndisks_)
+               : std::make_pair(ndisks_, ndisks_);
+    return tier == 0 ? std::make_pair(first_flash_, ndisks_)
+           : std::make_pair(size_t(0), first_flash_);
+}
+
+bool BlockManager::has_space(size_t begin, size_t end, size_t bytes) const {
+    Config* config = Config::GetInstance();
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (size_t i = begin; i < end; ++i) {
+        if (config->disk(i).autogrow ||
+            disk_allocators_[i]->free_bytes() >= static_cast<int64_t>(bytes))
+            return true;
+    }
+    return false;
+}
+
+/******************************************************************************/
+
+size_t LeastLoaded::operator () (size_t i) const {
+    // a repeated call means the chosen disk was full: cycle through the others.
+    if (i == last_i_)
+        return begin_ + (i + ++attempt_) % diff_;
+    last_i_ = i, attempt_ = 0;
+
+    const BlockManager* bm = BlockManager::GetInstance();
+
+    size_t best = begin_ + i % diff_;
+    double best_load = std::numeric_limits<double>::max();
+    for (size_t k = 0; k < diff_; ++k) {
+        size_t disk = begin_ + (i + k) % diff_;
+        double load =
+            static_cast<double>(bm->disk_file(disk)->queue_depth() + 1)
+            / bm->disk_weight(disk);
+        if (load < best_load)
+            best = disk, best_load = load;
+    }
+    return best;
+}
+
 } // namespace io
 } // namespace thrill
 
@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #if THRILL_MSVC
@@ -132,6 +133,41 @@ public:
 
     ~BlockManager();
 
+    //! return number of disks
+    size_t num_disks() const { return ndisks_; }
+
+    //! return the file of a disk, the list of disks is fixed after
+    //! construction, hence no lock is needed.
+    FileBase * disk_file(size_t disk) const { return disk_files_[disk].get(); }
+
+    //! return the relative bandwidth weight of a disk, see
+    //! DiskConfig::bandwidth.
+    double disk_weight(size_t disk) const { return disk_weights_[disk]; }
+
+    //! \name Storage Tiers
+    //! \{
+
+    //! number of storage tiers: tier 0 holds the flash devices (flash= in the
+    //! configuration) and tier 1 the regular disks. If only one kind is
+    //! configured, all disks are in tier 0.
+    static constexpr size_t num_tiers = 2;
+
+    //! whether flash devices and regular disks are configured
+    bool tiered() const { return first_flash_ != 0 && first_flash_ != ndisks_; }
+
+    //! return range [begin, end) of the disks in a tier, which may be empty.
+    std::pair<size_t, size_t> tier_range(size_t tier) const;
+
+    //! return the tier of a disk
+    size_t disk_tier(size_t disk) const {
+        return tiered() && disk < first_flash_ ? 1 : 0;
+    }
+
+    //! whether a disk in [begin, end) has bytes free or can grow
+    bool has_space(size_t begin, size_t end, size_t bytes) const;
+
+    //! \}
+
     //! return total requested allocation in bytes
     uint64_t total_allocation() const {
         std::unique_lock<std::mutex> lock(mutex_);
@@ -161,8 +197,12 @@ private:
 
     std::vector<DiskAllocator*> disk_allocators_;
     std::vector<FileBasePtr> disk_files_;
+    std::vector<double> disk_weights_;
 
     size_t ndisks_;
+
+    //! index of the first flash device, which come after all regular disks
+    size_t first_flash_;
     BlockManager();
 
     mutable std::mutex mutex_;
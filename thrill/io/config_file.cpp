@@ -20,6 +20,7 @@
 #include <thrill/io/error_handling.hpp>
 #include <thrill/io/file_base.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -61,6 +62,15 @@ void Config::initialize() {
     {
         find_config();
     }
+    else
+    {
+        // put flash devices added by add_disk() after regular disks
+        first_flash = static_cast<unsigned>(
+            std::stable_partition(
+                disks_list.begin(), disks_list.end(),
+                [](const DiskConfig& d) { return !d.flash; })
+            - disks_list.begin());
+    }
 
     max_device_id_ = 0;
 
@@ -208,6 +218,7 @@ uint64_t Config::total_size() const {
 DiskConfig::DiskConfig()
     : size(0),
       autogrow(true),
+      bandwidth(0),
       delete_on_exit(false),
       direct(DIRECT_TRY),
       flash(false),
@@ -215,7 +226,9 @@ DiskConfig::DiskConfig()
       device_id(FileBase::DEFAULT_DEVICE_ID),
       raw_device(false),
       unlink_on_open(false),
-      queue_length(0)
+      queue_length(0),
+      preallocate(false),
+      keep(false)
 { }
 
 DiskConfig::DiskConfig(const std::string& _path, uint64_t _size,
@@ -224,6 +237,7 @@ DiskConfig::DiskConfig(const std::string& _path, uint64_t _size,
       size(_size),
       io_impl(_io_impl),
       autogrow(true),
+      bandwidth(0),
       delete_on_exit(false),
       direct(DIRECT_TRY),
       flash(false),
@@ -231,13 +245,16 @@ DiskConfig::DiskConfig(const std::string& _path, uint64_t _size,
       device_id(FileBase::DEFAULT_DEVICE_ID),
       raw_device(false),
       unlink_on_open(false),
-      queue_length(0) {
+      queue_length(0),
+      preallocate(false),
+      keep(false) {
     parse_fileio();
 }
 
 DiskConfig::DiskConfig(const std::string& line)
     : size(0),
       autogrow(true),
+      bandwidth(0),
       delete_on_exit(false),
       direct(DIRECT_TRY),
       flash(false),
@@ -245,7 +262,9 @@ DiskConfig::DiskConfig(const std::string& line)
       device_id(FileBase::DEFAULT_DEVICE_ID),
       raw_device(false),
       unlink_on_open(false),
-      queue_length(0) {
+      queue_length(0),
+      preallocate(false),
+      keep(false) {
     parse_line(line);
 }
 
@@ -273,6 +292,8 @@ void DiskConfig::parse_line(const std::string& line) {
     queue = FileBase::DEFAULT_QUEUE;
     device_id = FileBase::DEFAULT_DEVICE_ID;
     unlink_on_open = false;
+    preallocate = false;
+    keep = false;
 
     // *** Save Basic Options ***
 
@@ -355,6 +376,15 @@ void DiskConfig::parse_fileio() {
                              "Invalid parameter '" << *p << "' in disk configuration file.");
             }
         }
+        else if (eq[0] == "bandwidth")
+        {
+            char* endp;
+            bandwidth = strtod(eq[1].c_str(), &endp);
+            if ((endp && *endp != 0) || bandwidth < 0) {
+                THRILL_THROW(std::runtime_error,
+                             "Invalid parameter '" << *p << "' in disk configuration file.");
+            }
+        }
         else if (*p == "delete" || *p == "delete_on_exit")
         {
             delete_on_exit = true;
@@ -377,9 +407,17 @@ void DiskConfig::parse_fileio() {
                              "Invalid parameter '" << *p << "' in disk configuration file.");
             }
         }
+        else if (*p == "keep")
+        {
+            keep = true;
+        }
+        else if (*p == "preallocate")
+        {
+            preallocate = true;
+        }
         else if (eq[0] == "queue")
         {
-            if (io_impl == "linuxaio") {
+            if (io_impl == "linuxaio" || io_impl == "iouring") {
                 THRILL_THROW(std::runtime_error, "Parameter '" << *p << "' invalid for fileio '" << io_impl << "' in disk configuration file.");
             }
 
@@ -392,9 +430,9 @@ void DiskConfig::parse_fileio() {
         }
         else if (eq[0] == "queue_length")
         {
-            if (io_impl != "linuxaio") {
+            if (io_impl != "linuxaio" && io_impl != "iouring") {
                 THRILL_THROW(std::runtime_error, "Parameter '" << *p << "' "
-                             "is only valid for fileio linuxaio "
+                             "is only valid for fileio linuxaio or iouring "
                              "in disk configuration file.");
             }
 
@@ -425,6 +463,7 @@ void DiskConfig::parse_fileio() {
         else if (*p == "unlink" || *p == "unlink_on_open")
         {
             if (!(io_impl == "syscall" || io_impl == "linuxaio" ||
+                  io_impl == "iouring" ||
                   io_impl == "mmap" || io_impl == "wbtl"))
             {
                 THRILL_THROW(std::runtime_error, "Parameter '" << *p << "' invalid for fileio '" << io_impl << "' in disk configuration file.");
@@ -438,6 +477,12 @@ void DiskConfig::parse_fileio() {
                          "Invalid optional parameter '" << *p << "' in disk configuration file.");
         }
     }
+
+    if (keep && (delete_on_exit || unlink_on_open)) {
+        THRILL_THROW(std::runtime_error,
+                     "Parameter 'keep' cannot be combined with deleting "
+                     "or unlinking the file in disk configuration file.");
+    }
 }
 
 std::string DiskConfig::fileio_string() const {
@@ -448,6 +493,9 @@ std::string DiskConfig::fileio_string() const {
     if (!autogrow)
         oss << " autogrow=no";
 
+    if (bandwidth != 0)
+        oss << " bandwidth=" << bandwidth;
+
     if (delete_on_exit)
         oss << " delete_on_exit";
 
@@ -465,7 +513,15 @@ std::string DiskConfig::fileio_string() const {
     if (flash)
         oss << " flash";
 
-    if (queue != FileBase::DEFAULT_QUEUE && queue != FileBase::DEFAULT_LINUXAIO_QUEUE)
+    if (keep)
+        oss << " keep";
+
+    if (preallocate)
+        oss << " preallocate";
+
+    if (queue != FileBase::DEFAULT_QUEUE &&
+        queue != FileBase::DEFAULT_LINUXAIO_QUEUE &&
+        queue != FileBase::DEFAULT_IOURING_QUEUE)
         oss << " queue=" << queue;
 
     if (device_id != FileBase::DEFAULT_DEVICE_ID)
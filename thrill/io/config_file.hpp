@@ -77,6 +77,11 @@ public:
     //! autogrow file if more disk space is needed, automatically set if size == 0.
     bool autogrow;
 
+    //! measured bandwidth of the disk in MiB/s, which weights the disk in the
+    //! LeastLoaded allocation strategy. 0 -> unknown, the average of all
+    //! configured disks is used.
+    double bandwidth;
+
     //! delete file on program exit (default for autoconfigurated files)
     bool delete_on_exit;
 
@@ -102,9 +107,18 @@ public:
     //! unlink file immediately after opening (available on most Unix)
     bool unlink_on_open;
 
-    //! desired queue length for linuxaio_file and linuxaio_queue
+    //! desired queue length for linuxaio_file/iouring_file and their queues
     int queue_length;
 
+    //! allocate the configured size of the file with fallocate() in the
+    //! background, and autogrown regions directly (Linux only).
+    bool preallocate;
+
+    //! keep an existing file: use all of its space instead of truncating it to
+    //! the configured size, and do not shrink it on exit, such that its
+    //! allocated extents are reused by the next run.
+    bool keep;
+
     //! \}
 };
 
@@ -18,10 +18,12 @@
 #include <thrill/io/error_handling.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <map>
 #include <ostream>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -47,18 +49,51 @@ struct DiskAllocator::Data
 {
     //! map of free space
     SortSeq free_space_;
+
+    //! thread preallocating the initial file size
+    std::thread preallocator_;
+
+    //! flag to stop the preallocator
+    std::atomic<bool> stop_ { false };
 };
 
+//! chunk size of the background preallocation, which is stopped in between.
+static constexpr int64_t preallocate_chunk = 64 * 1024 * 1024;
+
 DiskAllocator::DiskAllocator(FileBase* storage, const DiskConfig& cfg)
     : data_(std::make_unique<Data>()),
       free_bytes_(0), disk_bytes_(0), cfg_bytes_(cfg.size),
-      storage_(storage), autogrow_(cfg.autogrow) {
+      storage_(storage), autogrow_(cfg.autogrow), keep_(cfg.keep),
+      preallocate_(cfg.preallocate) {
+    // reuse all space of a kept file
+    if (keep_)
+        cfg_bytes_ = std::max<int64_t>(cfg_bytes_, storage_->size());
+
     // initial growth to configured file size
-    GrowFile(cfg.size);
+    GrowFile(cfg_bytes_);
+
+    // allocate the initial size in the background, writes into regions which
+    // are not preallocated yet are just as fast as without preallocation.
+    if (preallocate_ && cfg_bytes_ != 0) {
+        int64_t size = cfg_bytes_;
+        data_->preallocator_ = std::thread(
+            [this, size]() {
+                for (int64_t offset = 0; offset < size &&
+                     !data_->stop_.load(std::memory_order_relaxed);
+                     offset += preallocate_chunk) {
+                    storage_->preallocate(
+                        offset, std::min(preallocate_chunk, size - offset));
+                }
+            });
+    }
 }
 
 DiskAllocator::~DiskAllocator() {
-    if (disk_bytes_ > cfg_bytes_) { // reduce to original size
+    if (data_->preallocator_.joinable()) {
+        data_->stop_ = true;
+        data_->preallocator_.join();
+    }
+    if (!keep_ && disk_bytes_ > cfg_bytes_) { // reduce to original size
         storage_->set_size(cfg_bytes_);
     }
 }
@@ -52,6 +52,8 @@ class DiskAllocator
     int64_t cfg_bytes_;
     FileBase* storage_;
     bool autogrow_;
+    bool keep_;
+    bool preallocate_;
 
     void Dump() const;
 
@@ -69,6 +71,8 @@ class DiskAllocator
             return;
 
         storage_->set_size(disk_bytes_ + extend_bytes);
+        if (preallocate_ && disk_bytes_ != 0)
+            storage_->preallocate(disk_bytes_, extend_bytes);
         AddFreeRegion(disk_bytes_, extend_bytes);
         disk_bytes_ += extend_bytes;
     }
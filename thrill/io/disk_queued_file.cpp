@@ -23,11 +23,12 @@ namespace io {
 
 RequestPtr DiskQueuedFile::aread(
     void* buffer, offset_type offset, size_type bytes,
-    const CompletionHandler& on_cmpl) {
+    const CompletionHandler& on_cmpl, Request::Priority priority) {
 
     RequestPtr req(mem::GPool().make<ServingRequest>(
                        on_cmpl, FileBasePtr(this),
                        buffer, offset, bytes, Request::READ));
+    req->set_priority(priority);
 
     DiskQueues::GetInstance()->AddRequest(req, get_queue_id());
 
@@ -36,11 +37,12 @@ RequestPtr DiskQueuedFile::aread(
 
 RequestPtr DiskQueuedFile::awrite(
     void* buffer, offset_type offset, size_type bytes,
-    const CompletionHandler& on_cmpl) {
+    const CompletionHandler& on_cmpl, Request::Priority priority) {
 
     RequestPtr req(mem::GPool().make<ServingRequest>(
                        on_cmpl, FileBasePtr(this),
                        buffer, offset, bytes, Request::WRITE));
+    req->set_priority(priority);
 
     DiskQueues::GetInstance()->AddRequest(req, get_queue_id());
 
@@ -38,11 +38,13 @@ public:
 
     RequestPtr aread(
         void* buffer, offset_type offset, size_type bytes,
-        const CompletionHandler& on_cmpl = CompletionHandler()) override;
+        const CompletionHandler& on_cmpl = CompletionHandler(),
+        Request::Priority priority = Request::DEMAND_READ) override;
 
     RequestPtr awrite(
         void* buffer, offset_type offset, size_type bytes,
-        const CompletionHandler& on_cmpl = CompletionHandler()) override;
+        const CompletionHandler& on_cmpl = CompletionHandler(),
+        Request::Priority priority = Request::BACKGROUND_WRITE) override;
 
     int get_queue_id() const override {
         return queue_id_;
@@ -29,6 +29,7 @@
  #define THRILL_CHECK_BLOCK_ALIGNING
 #endif
 
+#include <atomic>
 #include <cassert>
 #include <ostream>
 #include <string>
@@ -96,6 +97,7 @@ public:
 
     static constexpr int DEFAULT_QUEUE = -1;
     static constexpr int DEFAULT_LINUXAIO_QUEUE = -2;
+    static constexpr int DEFAULT_IOURING_QUEUE = -3;
     static constexpr int NO_ALLOCATOR = -1;
     static constexpr unsigned int DEFAULT_DEVICE_ID = (unsigned int)(-1);
 
@@ -108,23 +110,27 @@ public:
     //! \param offset file position to start read from
     //! \param bytes number of bytes to transfer
     //! \param on_cmpl I/O completion handler
+    //! \param priority scheduling class of the request in the disk queue
     //! \return \c request_ptr request object, which can be used to track the
     //! status of the operation
 
     virtual RequestPtr aread(
         void* buffer, offset_type offset, size_type bytes,
-        const CompletionHandler& on_cmpl = CompletionHandler()) = 0;
+        const CompletionHandler& on_cmpl = CompletionHandler(),
+        Request::Priority priority = Request::DEMAND_READ) = 0;
 
     //! Schedules an asynchronous write request to the file.
     //! \param buffer pointer to memory buffer to write from
     //! \param offset starting file position to write
     //! \param bytes number of bytes to transfer
     //! \param on_cmpl I/O completion handler
+    //! \param priority scheduling class of the request in the disk queue
     //! \return \c request_ptr request object, which can be used to track the
     //! status of the operation
     virtual RequestPtr awrite(
         void* buffer, offset_type offset, size_type bytes,
-        const CompletionHandler& on_cmpl = CompletionHandler()) = 0;
+        const CompletionHandler& on_cmpl = CompletionHandler(),
+        Request::Priority priority = Request::BACKGROUND_WRITE) = 0;
 
     virtual void serve(void* buffer, offset_type offset, size_type bytes,
                        Request::ReadOrWriteType type) = 0;
@@ -155,9 +161,21 @@ public:
         common::UNUSED(size);
     }
 
+    //! Allocate disk space for a region of the file without writing it, such
+    //! that later writes neither allocate nor fragment the file. This is only
+    //! a hint, failures are ignored.
+    virtual void preallocate(offset_type offset, offset_type size) {
+        common::UNUSED(offset);
+        common::UNUSED(size);
+    }
+
     //! close and remove file
     virtual void close_remove() { }
 
+    //! Returns the file descriptor for direct transfers like sendfile(), or -1
+    //! if the implementation has none.
+    virtual int native_fd() const { return -1; }
+
     virtual ~FileBase() { }
 
     //! Identifies the type of I/O implementation.
@@ -173,10 +191,20 @@ protected:
     //! calculation)
     unsigned int device_id_;
 
+    //! number of requests on the file which are not completed yet
+    std::atomic<size_t> queue_depth_ { 0 };
+
+    //! for access to queue_depth_
+    friend class Request;
+
 public:
     //! Returns need_alignment_
     bool need_alignment() const { return need_alignment_; }
 
+    //! Returns the number of queued or running requests on the file, which is
+    //! the load measure of the LeastLoaded disk allocation strategy.
+    size_t queue_depth() const { return queue_depth_.load(); }
+
     //! Returns the file's physical device id
     unsigned int get_device_id() const {
         return device_id_;
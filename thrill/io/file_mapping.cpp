@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * thrill/io/file_mapping.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/io/file_mapping.hpp>
+
+#include <thrill/io/error_handling.hpp>
+
+#if THRILL_HAVE_MMAP_FILE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace thrill {
+namespace io {
+
+FileMapping::FileMapping(const std::string& path, int64_t offset, size_t size)
+    : size_(size) {
+#if THRILL_HAVE_MMAP_FILE
+    if (size == 0) return;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    THRILL_THROW_ERRNO_IF(fd < 0, IoError,
+                          "open() failed for mapping path=" << path);
+
+    // mmap() requires a page-aligned file offset.
+    static const int64_t page_size = sysconf(_SC_PAGESIZE);
+    int64_t aligned = offset - offset % page_size;
+    length_ = size + static_cast<size_t>(offset - aligned);
+
+    base_ = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, aligned);
+    ::close(fd);
+
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        THRILL_THROW_ERRNO(IoError,
+                           "mmap() failed. path=" << path <<
+                           " offset=" << offset << " size=" << size);
+    }
+
+    data_ = static_cast<const uint8_t*>(base_) + (offset - aligned);
+#else
+    (void)offset;
+    THRILL_THROW(IoError, "Memory mapping files is not supported. path=" << path);
+#endif
+}
+
+FileMapping::~FileMapping() {
+#if THRILL_HAVE_MMAP_FILE
+    if (base_) munmap(base_, length_);
+#endif
+}
+
+void FileMapping::AdviseSequential() {
+#if THRILL_HAVE_MMAP_FILE && defined(MADV_SEQUENTIAL)
+    if (base_) madvise(base_, length_, MADV_SEQUENTIAL);
+#endif
+}
+
+void FileMapping::AdviseWillNeed(const void* data, size_t size) {
+#if THRILL_HAVE_MMAP_FILE && defined(MADV_WILLNEED)
+    // madvise() requires a page-aligned address.
+    static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    uintptr_t aligned = begin - begin % page_size;
+    madvise(reinterpret_cast<void*>(aligned), size + (begin - aligned),
+            MADV_WILLNEED);
+#else
+    (void)data, (void)size;
+#endif
+}
+
+} // namespace io
+} // namespace thrill
+
+/******************************************************************************/
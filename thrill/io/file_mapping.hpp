@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * thrill/io/file_mapping.hpp
+ *
+ * A read-only memory mapping of a range of a file, which is shared by the
+ * ByteBlocks pointing into it.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_IO_FILE_MAPPING_HEADER
+#define THRILL_IO_FILE_MAPPING_HEADER
+
+#include <thrill/common/config.hpp>
+#include <thrill/common/counting_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace thrill {
+namespace io {
+
+//! \addtogroup io_layer
+//! \{
+
+/*!
+ * A read-only private memory mapping of the byte range [offset, offset + size)
+ * of a file. Pages are loaded lazily by the kernel when first accessed, and
+ * are part of the page cache instead of the BlockPool's memory. The mapping is
+ * reference counted, such that ByteBlocks pointing into it keep it alive, and
+ * is unmapped when the last reference is dropped.
+ */
+class FileMapping : public common::ReferenceCount
+{
+public:
+    //! Map the range of the file, throws IoError on failure.
+    FileMapping(const std::string& path, int64_t offset, size_t size);
+
+    //! non-copyable: delete copy-constructor
+    FileMapping(const FileMapping&) = delete;
+    //! non-copyable: delete assignment operator
+    FileMapping& operator = (const FileMapping&) = delete;
+
+    //! unmap the range
+    ~FileMapping();
+
+    //! the data of the mapped file range
+    const uint8_t * data() const { return data_; }
+
+    //! the size of the mapped file range
+    size_t size() const { return size_; }
+
+    //! Advise the kernel that the mapping is read sequentially, which enables
+    //! aggressive read-ahead.
+    void AdviseSequential();
+
+    //! Advise the kernel that the given part of a mapping will be accessed
+    //! soon, which starts reading its pages asynchronously.
+    static void AdviseWillNeed(const void* data, size_t size);
+
+    //! Whether memory mapping of files is supported on this platform.
+    static constexpr bool supported() {
+#if THRILL_HAVE_MMAP_FILE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    //! page-aligned base address and length of the mapping
+    void* base_ = nullptr;
+    size_t length_ = 0;
+
+    //! data of the requested file range inside the mapping
+    const uint8_t* data_ = nullptr;
+    size_t size_;
+};
+
+using FileMappingPtr = common::CountingPtr<FileMapping>;
+
+//! \}
+
+} // namespace io
+} // namespace thrill
+
+#endif // !THRILL_IO_FILE_MAPPING_HEADER
+
+/******************************************************************************/
@@ -34,19 +34,17 @@ void Stats::write_started(size_t size, double now) {
 #else
     common::UNUSED(now);
 #endif
+    counters_.add(kWriteOps, 1);
+    counters_.add(kWriteVolume, static_cast<int64_t>(size));
+#if THRILL_IO_STATS_TIMING
     {
         std::unique_lock<std::mutex> write_lock(write_mutex_);
 
-        ++write_ops_;
-        write_volume_ += size;
-#if THRILL_IO_STATS_TIMING
         double diff = now - parallel_write_begin_;
         write_time_ += static_cast<double>(acc_writes_) * diff;
         parallel_write_begin_ = now;
         parallel_write_time_ += (acc_writes_++) ? diff : 0.0;
-#endif
     }
-#if THRILL_IO_STATS_TIMING
     {
         std::unique_lock<std::mutex> io_lock(io_mutex_);
 
@@ -58,12 +56,8 @@ void Stats::write_started(size_t size, double now) {
 }
 
 void Stats::write_canceled(size_t size) {
-    {
-        std::unique_lock<std::mutex> write_lock(write_mutex_);
-
-        --write_ops_;
-        write_volume_ -= size;
-    }
+    counters_.subtract(kWriteOps, 1);
+    counters_.subtract(kWriteVolume, static_cast<int64_t>(size));
     write_finished();
 }
 
@@ -89,10 +83,8 @@ void Stats::write_finished() {
 }
 
 void Stats::write_cached(size_t size) {
-    std::unique_lock<std::mutex> write_lock(write_mutex_);
-
-    ++cached_write_ops_;
-    cached_write_volume_ += size;
+    counters_.add(kCachedWriteOps, 1);
+    counters_.add(kCachedWriteVolume, static_cast<int64_t>(size));
 }
 
 void Stats::read_started(size_t size, double now) {
@@ -102,19 +94,17 @@ void Stats::read_started(size_t size, double now) {
 #else
     common::UNUSED(now);
 #endif
+    counters_.add(kReadOps, 1);
+    counters_.add(kReadVolume, static_cast<int64_t>(size));
+#if THRILL_IO_STATS_TIMING
     {
         std::unique_lock<std::mutex> read_lock(read_mutex_);
 
-        ++read_ops_;
-        read_volume_ += size;
-#if THRILL_IO_STATS_TIMING
         double diff = now - parallel_read_begin_;
         read_time_ += static_cast<double>(acc_reads_) * diff;
         parallel_read_begin_ = now;
         parallel_read_time_ += (acc_reads_++) ? diff : 0.0;
- #endif
     }
- #if THRILL_IO_STATS_TIMING
     {
         std::unique_lock<std::mutex> io_lock(io_mutex_);
 
@@ -126,12 +116,8 @@ void Stats::read_started(size_t size, double now) {
 }
 
 void Stats::read_canceled(size_t size) {
-    {
-        std::unique_lock<std::mutex> read_lock(read_mutex_);
-
-        --read_ops_;
-        read_volume_ -= size;
-    }
+    counters_.subtract(kReadOps, 1);
+    counters_.subtract(kReadVolume, static_cast<int64_t>(size));
     read_finished();
 }
 
@@ -157,10 +143,8 @@ void Stats::read_finished() {
 }
 
 void Stats::read_cached(size_t size) {
-    std::unique_lock<std::mutex> read_lock(read_mutex_);
-
-    ++cached_read_ops_;
-    cached_read_volume_ += size;
+    counters_.add(kCachedReadOps, 1);
+    counters_.add(kCachedReadVolume, static_cast<int64_t>(size));
 }
 
 #if !THRILL_DO_NOT_COUNT_WAIT_TIME
@@ -24,6 +24,7 @@
 
 #include <thrill/common/config.hpp>
 #include <thrill/common/defines.hpp>
+#include <thrill/common/sharded_counter.hpp>
 #include <thrill/common/singleton.hpp>
 
 #include <chrono>
@@ -51,14 +52,15 @@ class Stats : public common::Singleton<Stats>
 {
     friend class common::Singleton<Stats>;
 
-    //! number of operations
-    size_t read_ops_ = 0, write_ops_ = 0;
-    //! number of bytes read/written
-    int64_t read_volume_ = 0, write_volume_ = 0;
-    //! number of cached operations
-    size_t cached_read_ops_ = 0, cached_write_ops_ = 0;
-    //! number of bytes read/written from/to cache
-    int64_t cached_read_volume_ = 0, cached_write_volume_ = 0;
+    //! fields of counters_
+    enum {
+        kReadOps, kWriteOps, kReadVolume, kWriteVolume,
+        kCachedReadOps, kCachedWriteOps, kCachedReadVolume, kCachedWriteVolume,
+        kFields
+    };
+    //! number of operations and bytes read/written, sharded per thread such
+    //! that concurrent requests need no lock unless timing is enabled.
+    common::ShardedCounters<int64_t, kFields> counters_;
     //! seconds spent in operations
     double read_time_ = 0.0, write_time_ = 0.0;
     //! seconds spent in parallel operations
@@ -237,28 +239,34 @@ public:
 
 public:
     //! Returns total number of read_ops.
-    size_t read_ops() const { return read_ops_; }
+    size_t read_ops() const { return counters_.get(kReadOps); }
 
     //! Returns total number of write_ops.
-    size_t write_ops() const { return write_ops_; }
+    size_t write_ops() const { return counters_.get(kWriteOps); }
 
     //! Returns number of bytes read from disks.
-    int64_t read_volume() const { return read_volume_; }
+    int64_t read_volume() const { return counters_.get(kReadVolume); }
 
     //! Returns number of bytes written to the disks.
-    int64_t write_volume() const { return write_volume_; }
+    int64_t write_volume() const { return counters_.get(kWriteVolume); }
 
     //! Returns total number of reads served from cache.
-    size_t cached_read_ops() const { return cached_read_ops_; }
+    size_t cached_read_ops() const { return counters_.get(kCachedReadOps); }
 
     //! Returns total number of cached write_ops.
-    size_t cached_write_ops() const { return cached_write_ops_; }
+    size_t cached_write_ops() const {
+        return counters_.get(kCachedWriteOps);
+    }
 
     //! Returns number of bytes read from cache.
-    int64_t cached_read_volume() const { return cached_read_volume_; }
+    int64_t cached_read_volume() const {
+        return counters_.get(kCachedReadVolume);
+    }
 
     //! Returns number of bytes written to the cache.
-    int64_t cached_write_volume() const { return cached_write_volume_; }
+    int64_t cached_write_volume() const {
+        return counters_.get(kCachedWriteVolume);
+    }
 
     //! Time that would be spent in read syscalls if all parallel read_ops were
     //! serialized.
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * thrill/io/iouring_file.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/io/iouring_file.hpp>
+
+#if THRILL_HAVE_IOURING_FILE
+
+#include <thrill/io/disk_queues.hpp>
+#include <thrill/io/iouring_request.hpp>
+#include <thrill/mem/pool.hpp>
+
+namespace thrill {
+namespace io {
+
+RequestPtr IoUringFile::aread(
+    void* buffer, offset_type offset, size_type bytes,
+    const CompletionHandler& on_cmpl, Request::Priority priority) {
+
+    RequestPtr req(mem::GPool().make<IoUringRequest>(
+                       on_cmpl, FileBasePtr(this),
+                       buffer, offset, bytes, Request::READ));
+    req->set_priority(priority);
+
+    DiskQueues::GetInstance()->AddRequest(req, get_queue_id());
+
+    return req;
+}
+
+RequestPtr IoUringFile::awrite(
+    void* buffer, offset_type offset, size_type bytes,
+    const CompletionHandler& on_cmpl, Request::Priority priority) {
+
+    RequestPtr req(mem::GPool().make<IoUringRequest>(
+                       on_cmpl, FileBasePtr(this),
+                       buffer, offset, bytes, Request::WRITE));
+    req->set_priority(priority);
+
+    DiskQueues::GetInstance()->AddRequest(req, get_queue_id());
+
+    return req;
+}
+
+void IoUringFile::serve(void* buffer, offset_type offset, size_type bytes,
+                        Request::ReadOrWriteType type) {
+    if (type == Request::READ)
+        aread(buffer, offset, bytes)->wait();
+    else
+        awrite(buffer, offset, bytes)->wait();
+}
+
+const char* IoUringFile::io_type() const {
+    return "iouring";
+}
+
+} // namespace io
+} // namespace thrill
+
+#endif // #if THRILL_HAVE_IOURING_FILE
+
+/******************************************************************************/
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * thrill/io/iouring_file.hpp
+ *
+ * File backend using the Linux io_uring asynchronous I/O interface.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_IO_IOURING_FILE_HEADER
+#define THRILL_IO_IOURING_FILE_HEADER
+
+#include <thrill/common/config.hpp>
+
+#if THRILL_HAVE_IOURING_FILE
+
+#include <thrill/io/disk_queued_file.hpp>
+#include <thrill/io/ufs_file_base.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace io {
+
+//! \addtogroup io_layer_fileimpl
+//! \{
+
+//! Implementation of \c file based on the Linux kernel's io_uring interface.
+//! Requests are submitted directly by the calling thread, and completions
+//! are reaped by one thread per queue.
+class IoUringFile final : public UfsFileBase, public DiskQueuedFile
+{
+    friend class IoUringRequest;
+
+private:
+    int desired_queue_length_;
+
+public:
+    //! Constructs file object
+    //! \param filename path of file
+    //! \param mode open mode, see \c FileBase::OpenMode
+    //! \param queue_id disk queue identifier
+    //! \param allocator_id linked disk_allocator
+    //! \param device_id physical device identifier
+    //! \param desired_queue_length number of submission queue entries
+    IoUringFile(
+        const std::string& filename, int mode,
+        int queue_id = DEFAULT_IOURING_QUEUE,
+        int allocator_id = NO_ALLOCATOR,
+        unsigned int device_id = DEFAULT_DEVICE_ID,
+        int desired_queue_length = 0)
+        : FileBase(device_id),
+          UfsFileBase(filename, mode),
+          DiskQueuedFile(queue_id, allocator_id),
+          desired_queue_length_(desired_queue_length)
+    { }
+
+    void serve(void* buffer, offset_type offset, size_type bytes,
+               Request::ReadOrWriteType type) final;
+    RequestPtr aread(void* buffer, offset_type offset, size_type bytes,
+                     const CompletionHandler& on_cmpl = CompletionHandler(),
+                     Request::Priority priority = Request::DEMAND_READ) final;
+    RequestPtr awrite(void* buffer, offset_type offset, size_type bytes,
+                      const CompletionHandler& on_cmpl = CompletionHandler(),
+                      Request::Priority priority = Request::BACKGROUND_WRITE) final;
+    const char * io_type() const final;
+
+    int desired_queue_length() const {
+        return desired_queue_length_;
+    }
+};
+
+//! \}
+
+} // namespace io
+} // namespace thrill
+
+#endif // #if THRILL_HAVE_IOURING_FILE
+
+#endif // !THRILL_IO_IOURING_FILE_HEADER
+
+/******************************************************************************/
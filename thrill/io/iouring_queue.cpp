@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * thrill/io/iouring_queue.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/io/iouring_queue.hpp>
+
+#if THRILL_HAVE_IOURING_FILE
+
+#include <thrill/io/error_handling.hpp>
+#include <thrill/io/iostats.hpp>
+#include <thrill/io/iouring_request.hpp>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace thrill {
+namespace io {
+
+static inline int IoUringSetup(unsigned entries, struct io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static inline int IoUringEnter(int fd, unsigned to_submit,
+                               unsigned min_complete, unsigned flags) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                nullptr, 0));
+}
+
+IoUringQueue::IoUringQueue(int desired_queue_length)
+    : wait_thread_state_(NOT_RUNNING) {
+
+    sq_entries_ = desired_queue_length == 0 ? 64 : desired_queue_length;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd_ = IoUringSetup(sq_entries_, &params);
+    if (ring_fd_ < 0) {
+        THRILL_THROW_ERRNO(IoError, "IoUringQueue::IoUringQueue"
+                           " io_uring_setup() entries=" << sq_entries_);
+    }
+    sq_entries_ = params.sq_entries;
+
+    // map submission and completion rings, which may share one mapping
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes
+                    + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED)
+        THRILL_THROW_ERRNO(IoError, "IoUringQueue::IoUringQueue mmap() sq");
+
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    }
+    else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED)
+            THRILL_THROW_ERRNO(IoError, "IoUringQueue::IoUringQueue mmap() cq");
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        THRILL_THROW_ERRNO(IoError, "IoUringQueue::IoUringQueue mmap() sqes");
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    num_free_events_.signal(sq_entries_);
+
+    LOG1 << "Set up an io_uring queue with " << sq_entries_ << " entries.";
+
+    StartThread(WaitAsync, static_cast<void*>(this),
+                wait_thread_, wait_thread_state_);
+}
+
+IoUringQueue::~IoUringQueue() {
+    StopThread(wait_thread_, wait_thread_state_, num_posted_requests_);
+
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_)
+        munmap(cq_ring_, cq_ring_size_);
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+void IoUringQueue::AddRequest(RequestPtr& req) {
+    if (req.empty())
+        THRILL_THROW_INVALID_ARGUMENT("Empty request submitted to disk_queue.");
+    if (wait_thread_state_() != RUNNING)
+        LOG1 << "Request submitted to stopped queue.";
+
+    IoUringRequest* ureq = dynamic_cast<IoUringRequest*>(req.get());
+    if (!ureq)
+        THRILL_THROW_INVALID_ARGUMENT(
+            "Non-IoUring request submitted to IoUring queue.");
+
+    // might block because too many requests are in flight
+    num_free_events_.wait();
+
+    {
+        std::unique_lock<std::mutex> lock(submit_mtx_);
+
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & *sq_mask_;
+
+        struct io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = (ureq->type() == Request::READ)
+                      ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->fd = ureq->file_des();
+        sqe->addr = reinterpret_cast<uint64_t>(ureq->iov());
+        sqe->len = 1;
+        sqe->off = ureq->offset();
+        // indirection, so the I/O system retains a counting_ptr reference
+        sqe->user_data = reinterpret_cast<uint64_t>(new RequestPtr(req));
+
+        sq_array_[index] = index;
+        // publish entry to the kernel
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+        double now = timestamp();
+        if (ureq->type() == Request::READ)
+            Stats::GetInstance()->read_started(ureq->bytes(), now);
+        else
+            Stats::GetInstance()->write_started(ureq->bytes(), now);
+
+        int r;
+        while ((r = IoUringEnter(ring_fd_, 1, 0, 0)) < 0 &&
+               (errno == EINTR || errno == EAGAIN || errno == EBUSY)) { }
+        if (r < 0) {
+            THRILL_THROW_ERRNO(IoError, "IoUringQueue::AddRequest"
+                               " io_uring_enter()");
+        }
+    }
+
+    num_posted_requests_.signal();
+}
+
+bool IoUringQueue::CancelRequest(Request* req) {
+    if (!req)
+        THRILL_THROW_INVALID_ARGUMENT("Empty request canceled disk_queue.");
+    // requests are submitted to the kernel immediately.
+    return false;
+}
+
+size_t IoUringQueue::HandleCompletions() {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    size_t num = 0;
+
+    for ( ; head != tail; ++head, ++num)
+    {
+        struct io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+
+        RequestPtr* r = reinterpret_cast<RequestPtr*>(cqe->user_data);
+        if (cqe->res < 0 || static_cast<size_t>(cqe->res) != (*r)->bytes()) {
+            std::string msg =
+                "IoUringQueue: I/O error or short transfer, result " +
+                std::to_string(cqe->res);
+            (*r)->save_error(mem::safe_string(msg.begin(), msg.end()));
+        }
+
+        // release ring slot before running the completion handler
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+        dynamic_cast<IoUringRequest*>(r->get())->completed(false);
+        delete r;                    // release auto_ptr reference
+        num_free_events_.signal();
+        num_posted_requests_.wait(); // will never block
+    }
+
+    return num;
+}
+
+// internal routines, run by the waiting thread
+void IoUringQueue::WaitRequests() {
+    for ( ; ; ) // as long as thread is running
+    {
+        // might block until next request is posted or message comes in
+        size_t num_currently_posted_requests = num_posted_requests_.wait();
+
+        // terminate if termination has been requested
+        if (wait_thread_state_() == TERMINATING &&
+            num_currently_posted_requests == 0)
+            break;
+
+        // wait for at least one of them to finish
+        while (__atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) == *cq_head_) {
+            if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+                if (errno == EINTR) {
+                    // premature return, e.g. due to signal. Just try again
+                    continue;
+                }
+
+                THRILL_THROW_ERRNO(IoError, "IoUringQueue::WaitRequests"
+                                   " io_uring_enter()");
+            }
+        }
+
+        // compensate for the one eaten prematurely above
+        num_posted_requests_.signal();
+
+        HandleCompletions();
+    }
+}
+
+void* IoUringQueue::WaitAsync(void* arg) {
+    (static_cast<IoUringQueue*>(arg))->WaitRequests();
+
+    self_type* pthis = static_cast<self_type*>(arg);
+    pthis->wait_thread_state_.set_to(TERMINATED);
+
+    return nullptr;
+}
+
+} // namespace io
+} // namespace thrill
+
+#endif // #if THRILL_HAVE_IOURING_FILE
+
+/******************************************************************************/
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * thrill/io/iouring_queue.hpp
+ *
+ * Request queue for IoUringFile using one io_uring instance.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_IO_IOURING_QUEUE_HEADER
+#define THRILL_IO_IOURING_QUEUE_HEADER
+
+#include <thrill/io/request_queue_impl_worker.hpp>
+
+#if THRILL_HAVE_IOURING_FILE
+
+#include <linux/io_uring.h>
+
+#include <mutex>
+
+namespace thrill {
+namespace io {
+
+//! \addtogroup io_layer_req
+//! \{
+
+/*!
+ * Queue for IoUringFile(s), a singleton like LinuxaioQueue.
+ *
+ * In contrast to LinuxaioQueue, no posting thread is needed: the calling
+ * thread writes the request into the shared submission ring and enters the
+ * kernel once, since submission does not block. One thread waits for and
+ * reaps completions. Requests are submitted immediately, hence they cannot be
+ * canceled.
+ */
+class IoUringQueue final : public RequestQueueImplWorker
+{
+    using self_type = IoUringQueue;
+
+private:
+    //! io_uring file descriptor
+    int ring_fd_ = -1;
+
+    //! number of submission queue entries
+    unsigned sq_entries_;
+
+    //! \name Memory-Mapped Rings
+    //! \{
+
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    struct io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    struct io_uring_cqe* cqes_;
+
+    //! \}
+
+    //! lock for writing into the submission ring
+    std::mutex submit_mtx_;
+
+    //! number of free submission slots and in-flight requests
+    common::Semaphore num_free_events_, num_posted_requests_;
+
+    //! thread reaping completions
+    std::thread wait_thread_;
+    common::SharedState<ThreadState> wait_thread_state_;
+
+    static void * WaitAsync(void* arg);   // thread start callback
+    void WaitRequests();
+    //! handle all available completion queue entries, returns their number.
+    size_t HandleCompletions();
+
+public:
+    //! Construct queue. Requests max number of requests simultaneously
+    //! submitted to disk, 0 means the default of 64.
+    explicit IoUringQueue(int desired_queue_length = 0);
+
+    void AddRequest(RequestPtr& req) final;
+    bool CancelRequest(Request* req) final;
+    ~IoUringQueue();
+};
+
+//! \}
+
+} // namespace io
+} // namespace thrill
+
+#endif // #if THRILL_HAVE_IOURING_FILE
+
+#endif // !THRILL_IO_IOURING_QUEUE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,40 @@
+/*******************************************************************************
+ * thrill/io/iouring_request.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/io/iouring_request.hpp>
+
+#if THRILL_HAVE_IOURING_FILE
+
+#include <thrill/io/iostats.hpp>
+
+namespace thrill {
+namespace io {
+
+int IoUringRequest::file_des() const {
+    return dynamic_cast<IoUringFile*>(file_.get())->file_des_;
+}
+
+void IoUringRequest::completed(bool canceled) {
+    LOG << "IoUringRequest[" << this << "] completed(" << canceled << ")";
+
+    if (!canceled)
+    {
+        if (type_ == READ)
+            Stats::GetInstance()->read_finished();
+        else
+            Stats::GetInstance()->write_finished();
+    }
+    Request::completed(canceled);
+}
+
+} // namespace io
+} // namespace thrill
+
+#endif // #if THRILL_HAVE_IOURING_FILE
+
+/******************************************************************************/
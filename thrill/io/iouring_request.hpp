@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * thrill/io/iouring_request.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_IO_IOURING_REQUEST_HEADER
+#define THRILL_IO_IOURING_REQUEST_HEADER
+
+#include <thrill/io/iouring_file.hpp>
+
+#if THRILL_HAVE_IOURING_FILE
+
+#include <thrill/io/request.hpp>
+
+#include <sys/uio.h>
+
+namespace thrill {
+namespace io {
+
+//! \addtogroup io_layer_req
+//! \{
+
+//! Request for an IoUringFile.
+class IoUringRequest final : public Request
+{
+    //! I/O vector of the readv/writev submission, must remain valid until
+    //! the kernel has consumed the submission queue entry.
+    struct iovec iov_;
+
+public:
+    IoUringRequest(
+        const CompletionHandler& on_complete,
+        const FileBasePtr& file,
+        void* buffer, offset_type offset, size_type bytes,
+        ReadOrWriteType type)
+        : Request(on_complete, file, buffer, offset, bytes, type) {
+        assert(dynamic_cast<IoUringFile*>(file.get()));
+        iov_.iov_base = buffer;
+        iov_.iov_len = bytes;
+        LOG << "IoUringRequest[" << this << "]" << " IoUringRequest"
+            << "(file=" << file << " buffer=" << buffer
+            << " offset=" << offset << " bytes=" << bytes
+            << " type=" << type << ")";
+    }
+
+    //! I/O vector for submission
+    const struct iovec * iov() const { return &iov_; }
+
+    //! file descriptor for submission
+    int file_des() const;
+
+    void completed(bool canceled) final;
+};
+
+//! \}
+
+} // namespace io
+} // namespace thrill
+
+#endif // #if THRILL_HAVE_IOURING_FILE
+
+#endif // !THRILL_IO_IOURING_REQUEST_HEADER
+
+/******************************************************************************/
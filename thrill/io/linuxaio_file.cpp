@@ -19,16 +19,24 @@
 #include <thrill/io/linuxaio_request.hpp>
 #include <thrill/mem/pool.hpp>
 
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
 namespace thrill {
 namespace io {
 
 RequestPtr LinuxaioFile::aread(
     void* buffer, offset_type offset, size_type bytes,
-    const CompletionHandler& on_cmpl) {
+    const CompletionHandler& on_cmpl, Request::Priority priority) {
 
     RequestPtr req(mem::GPool().make<LinuxaioRequest>(
                        on_cmpl, FileBasePtr(this),
                        buffer, offset, bytes, Request::READ));
+    req->set_priority(priority);
 
     DiskQueues::GetInstance()->AddRequest(req, get_queue_id());
 
@@ -37,17 +45,41 @@ RequestPtr LinuxaioFile::aread(
 
 RequestPtr LinuxaioFile::awrite(
     void* buffer, offset_type offset, size_type bytes,
-    const CompletionHandler& on_cmpl) {
+    const CompletionHandler& on_cmpl, Request::Priority priority) {
 
     RequestPtr req(mem::GPool().make<LinuxaioRequest>(
                        on_cmpl, FileBasePtr(this),
                        buffer, offset, bytes, Request::WRITE));
+    req->set_priority(priority);
 
     DiskQueues::GetInstance()->AddRequest(req, get_queue_id());
 
     return req;
 }
 
+int LinuxaioFile::DeviceQueueLength(int fd) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || major(st.st_dev) == 0)
+        return 0;
+
+    std::string dev = "/sys/dev/block/" + std::to_string(major(st.st_dev)) +
+                      ":" + std::to_string(minor(st.st_dev));
+
+    // partitions have no queue directory, use the one of the whole disk.
+    int nr_requests = 0;
+    for (const char* queue : { "/queue/nr_requests", "/../queue/nr_requests" }) {
+        std::ifstream in(dev + queue);
+        if (in >> nr_requests) break;
+        nr_requests = 0;
+    }
+    if (nr_requests <= 0)
+        return 0;
+
+    // keep at least the previous default, and do not take excessive kernel
+    // resources.
+    return std::min(std::max(nr_requests, 64), 1024);
+}
+
 void LinuxaioFile::serve(void* buffer, offset_type offset, size_type bytes,
                          Request::ReadOrWriteType type) {
     // req need not be an linuxaio_request
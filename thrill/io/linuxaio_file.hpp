@@ -50,7 +50,8 @@ public:
     //! \param queue_id disk queue identifier
     //! \param allocator_id linked disk_allocator
     //! \param device_id physical device identifier
-    //! \param desired_queue_length queue length requested from kernel
+    //! \param desired_queue_length queue length requested from kernel, if 0
+    //! the device's request queue length is used.
     LinuxaioFile(
         const std::string& filename, int mode,
         int queue_id = DEFAULT_LINUXAIO_QUEUE,
@@ -60,20 +61,29 @@ public:
         : FileBase(device_id),
           UfsFileBase(filename, mode),
           DiskQueuedFile(queue_id, allocator_id),
-          desired_queue_length_(desired_queue_length)
+          desired_queue_length_(
+              desired_queue_length != 0
+              ? desired_queue_length : DeviceQueueLength(file_des_))
     { }
 
     void serve(void* buffer, offset_type offset, size_type bytes,
                Request::ReadOrWriteType type) final;
     RequestPtr aread(void* buffer, offset_type offset, size_type bytes,
-                     const CompletionHandler& on_cmpl = CompletionHandler()) final;
+                     const CompletionHandler& on_cmpl = CompletionHandler(),
+                     Request::Priority priority = Request::DEMAND_READ) final;
     RequestPtr awrite(void* buffer, offset_type offset, size_type bytes,
-                      const CompletionHandler& on_cmpl = CompletionHandler()) final;
+                      const CompletionHandler& on_cmpl = CompletionHandler(),
+                      Request::Priority priority = Request::BACKGROUND_WRITE) final;
     const char * io_type() const final;
 
     int desired_queue_length() const {
         return desired_queue_length_;
     }
+
+    //! Determine a queue length for the block device containing the open
+    //! file fd from /sys/dev/block/<major>:<minor>/queue/nr_requests, or 0 if
+    //! it is unknown, e.g. for tmpfs.
+    static int DeviceQueueLength(int fd);
 };
 
 //! \}
@@ -18,12 +18,15 @@
 #if THRILL_HAVE_LINUXAIO_FILE
 
 #include <thrill/io/error_handling.hpp>
+#include <thrill/io/iostats.hpp>
 #include <thrill/io/linuxaio_request.hpp>
 
 #include <sys/syscall.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #ifndef THRILL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION
 #define THRILL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION 1
@@ -48,7 +51,7 @@ LinuxaioQueue::LinuxaioQueue(int desired_queue_length)
     while ((result = syscall(SYS_io_setup, max_events_, &context_)) == -1 &&
            errno == EAGAIN && max_events_ > 1)
     {
-        max_events_ <<= 1;               // try with half as many events
+        max_events_ >>= 1;               // try with half as many events
     }
     if (result != 0) {
         THRILL_THROW_ERRNO(IoError, "linuxaio_queue::linuxaio_queue"
@@ -137,9 +140,11 @@ bool LinuxaioQueue::CancelRequest(Request* req) {
 
 // internal routines, run by the posting thread
 void LinuxaioQueue::PostRequests() {
-    RequestPtr req;
     io_event* events = new io_event[max_events_];
 
+    std::vector<RequestPtr> batch, runs;
+    std::vector<iocb*> cbs;
+
     for ( ; ; ) // as long as thread is running
     {
         // might block until next request or message comes in
@@ -149,21 +154,85 @@ void LinuxaioQueue::PostRequests() {
         if (post_thread_state_() == TERMINATING && num_currently_waiting_requests == 0)
             break;
 
-        std::unique_lock<std::mutex> lock(waiting_mtx_);
-        if (!waiting_requests_.empty())
+        // take all waiting requests, up to the number of OS events
         {
-            req = waiting_requests_.front();
+            std::unique_lock<std::mutex> lock(waiting_mtx_);
+            if (waiting_requests_.empty()) {
+                lock.unlock();
+
+                // num_waiting_requests-- was premature, compensate for that
+                num_waiting_requests_.signal();
+                continue;
+            }
+
+            batch.push_back(waiting_requests_.front());
             waiting_requests_.pop_front();
-            lock.unlock();
 
-            // might block because too many requests are posted
+            while (!waiting_requests_.empty() &&
+                   batch.size() < static_cast<size_t>(max_events_) &&
+                   num_waiting_requests_.try_acquire())
+            {
+                batch.push_back(waiting_requests_.front());
+                waiting_requests_.pop_front();
+            }
+        }
+
+        MergeRequests(batch, runs);
+        batch.clear();
+
+        // submit the runs with as few io_submit calls as possible
+        size_t done = 0;
+        while (done < runs.size())
+        {
+            // might block because too many requests are posted, take
+            // further events only if they are free right away.
             num_free_events_.wait();
+            size_t num = 1;
+            while (done + num < runs.size() && num_free_events_.try_acquire())
+                ++num;
+
+            cbs.clear();
+            for (size_t i = done; i < done + num; ++i) {
+                cbs.push_back(
+                    dynamic_cast<LinuxaioRequest*>(runs[i].get())
+                    ->prepare_post());
+            }
+
+            // io_submit might considerable time, so we have to remember the
+            // current time before the call.
+            double now = timestamp();
+            long success = syscall(SYS_io_submit, context_,
+                                   static_cast<long>(num), cbs.data());
+
+            if (success < 0 && errno != EAGAIN) {
+                THRILL_THROW_ERRNO(IoError, "linuxaio_queue::post_requests"
+                                   " io_submit() nr=" << num);
+            }
+            size_t posted = success < 0 ? 0 : static_cast<size_t>(success);
+
+            {
+                std::unique_lock<std::mutex> lock(posted_mtx_);
+                for (size_t i = done; i < done + posted; ++i) {
+                    dynamic_cast<LinuxaioRequest*>(runs[i].get())->started(now);
+                    posted_requests_.push_back(runs[i]);
+                    num_posted_requests_.signal();
+                }
+            }
 
-            // polymorphic_downcast
-            while (!dynamic_cast<LinuxaioRequest*>(req.get())->post())
+            // release references held by the control blocks not submitted,
+            // they are filled again when retrying.
+            for (size_t i = posted; i < num; ++i) {
+                delete reinterpret_cast<RequestPtr*>(
+                    static_cast<size_t>(cbs[i]->aio_data));
+            }
+            num_free_events_.signal(num - posted);
+
+            done += posted;
+
+            if (posted < num)
             {
-                // post failed, so first handle events to make queues (more)
-                // empty, then try again.
+                // submission failed partially, so first handle events to make
+                // queues (more) empty, then try again.
 
                 // wait for at least one event to complete, no time limit
                 long num_events = syscall(SYS_io_getevents, context_, 1, max_events_, events, nullptr);
@@ -174,25 +243,49 @@ void LinuxaioQueue::PostRequests() {
 
                 HandleEvents(events, num_events, false);
             }
+        }
 
-            // request is finally posted
+        runs.clear();
+    }
 
-            {
-                std::unique_lock<std::mutex> lock(posted_mtx_);
-                posted_requests_.push_back(req);
-                num_posted_requests_.signal();
-            }
-        }
-        else
-        {
-            lock.unlock();
+    delete[] events;
+}
+
+void LinuxaioQueue::MergeRequests(
+    std::vector<RequestPtr>& batch, std::vector<RequestPtr>& runs) {
 
-            // num_waiting_requests-- was premature, compensate for that
-            num_waiting_requests_.signal();
+    if (batch.size() == 1) {
+        runs.push_back(batch[0]);
+        return;
+    }
+
+    // order by file, type and offset such that adjacent requests follow each
+    // other. Requests which are submitted together may complete in any order.
+    std::stable_sort(
+        batch.begin(), batch.end(),
+        [](const RequestPtr& a, const RequestPtr& b) {
+            if (a->file().get() != b->file().get())
+                return a->file().get() < b->file().get();
+            if (a->type() != b->type())
+                return a->type() < b->type();
+            return a->offset() < b->offset();
+        });
+
+    for (RequestPtr& req : batch)
+    {
+        if (!runs.empty()) {
+            LinuxaioRequest* last =
+                dynamic_cast<LinuxaioRequest*>(runs.back().get());
+            if (last->num_merged() + 1 < max_merge_requests_ &&
+                last->total_bytes() + req->bytes() <= max_merge_bytes_ &&
+                last->merge(req))
+                continue;
         }
+        runs.push_back(req);
     }
 
-    delete[] events;
+    LOG << "LinuxaioQueue merged " << batch.size()
+        << " requests into " << runs.size();
 }
 
 void LinuxaioQueue::HandleEvents(io_event* events, long num_events, bool canceled) {
@@ -200,7 +293,26 @@ void LinuxaioQueue::HandleEvents(io_event* events, long num_events, bool cancele
     {
         // size_t is as long as a pointer, and like this, we avoid an icpc warning
         RequestPtr* r = reinterpret_cast<RequestPtr*>(static_cast<size_t>(events[e].data));
-        r->get()->completed(canceled);
+        LinuxaioRequest* req = dynamic_cast<LinuxaioRequest*>(r->get());
+
+        if (!canceled) {
+            if (events[e].res < 0 ||
+                static_cast<size_t>(events[e].res) != req->total_bytes()) {
+                std::string msg =
+                    "LinuxaioQueue: I/O error or short transfer, result " +
+                    std::to_string(events[e].res);
+                req->save_error_all(mem::safe_string(msg.begin(), msg.end()));
+            }
+
+            // canceled requests are removed by CancelRequest()
+            std::unique_lock<std::mutex> lock(posted_mtx_);
+            Queue::iterator pos = std::find(
+                posted_requests_.begin(), posted_requests_.end(), *r);
+            if (pos != posted_requests_.end())
+                posted_requests_.erase(pos);
+        }
+
+        req->completed(canceled);
         delete r;                    // release auto_ptr reference
         num_free_events_.signal();
         num_posted_requests_.wait(); // will never block
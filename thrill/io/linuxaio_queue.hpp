@@ -24,6 +24,7 @@
 
 #include <list>
 #include <mutex>
+#include <vector>
 
 namespace thrill {
 namespace io {
@@ -34,8 +35,14 @@ namespace io {
 //! Queue for linuxaio_file(s)
 //!
 //! Only one queue exists in a program, i.e. it is a singleton.
+//!
+//! The posting thread takes all waiting requests at once, merges requests to
+//! adjacent regions of a file into vectored requests, and submits them with
+//! as few io_submit() calls as possible.
 class LinuxaioQueue final : public RequestQueueImplWorker
 {
+    static constexpr bool debug = false;
+
     friend class LinuxaioRequest;
 
     using self_type = LinuxaioQueue;
@@ -71,9 +78,17 @@ private:
 
     static constexpr PriorityOp priority_op_ = WRITE;
 
+    //! maximum number of waiting requests merged into one vectored request
+    static constexpr size_t max_merge_requests_ = 64;
+    //! maximum number of bytes of a merged request
+    static constexpr size_t max_merge_bytes_ = 8 * 1024 * 1024;
+
     static void * PostAsync(void* arg);   // thread start callback
     static void * WaitAsync(void* arg);   // thread start callback
     void PostRequests();
+    //! sort a batch of waiting requests and merge adjacent ones into runs
+    void MergeRequests(std::vector<RequestPtr>& batch,
+                       std::vector<RequestPtr>& runs);
     void HandleEvents(io_event* events, long num_events, bool canceled);
     void WaitRequests();
     void Suspend();
@@ -30,6 +30,12 @@ void LinuxaioRequest::completed(bool posted, bool canceled) {
     LOG << "LinuxaioRequest[" << this << "] completed("
         << posted << "," << canceled << ")";
 
+    // complete the merged requests first, they are released afterwards.
+    std::vector<RequestPtr> merged;
+    merged.swap(merged_);
+    for (RequestPtr& r : merged)
+        dynamic_cast<LinuxaioRequest*>(r.get())->completed(posted, canceled);
+
     if (!canceled)
     {
         if (type_ == READ)
@@ -54,38 +60,64 @@ void LinuxaioRequest::fill_control_block() {
     // indirection, so the I/O system retains a counting_ptr reference
     cb_.aio_data = reinterpret_cast<__u64>(new RequestPtr(this));
     cb_.aio_fildes = af->file_des_;
-    cb_.aio_lio_opcode = (type_ == READ) ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
     cb_.aio_reqprio = 0;
-    cb_.aio_buf = static_cast<__u64>((unsigned long)(buffer_));
-    cb_.aio_nbytes = bytes_;
     cb_.aio_offset = offset_;
+
+    if (merged_.empty()) {
+        cb_.aio_lio_opcode = (type_ == READ) ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
+        cb_.aio_buf = static_cast<__u64>((unsigned long)(buffer_));
+        cb_.aio_nbytes = bytes_;
+        return;
+    }
+
+    iov_.clear();
+    iov_.push_back(iovec { buffer_, bytes_ });
+    for (const RequestPtr& r : merged_)
+        iov_.push_back(iovec { r->buffer(), r->bytes() });
+
+    cb_.aio_lio_opcode = (type_ == READ) ? IOCB_CMD_PREADV : IOCB_CMD_PWRITEV;
+    cb_.aio_buf = static_cast<__u64>((unsigned long)(iov_.data()));
+    cb_.aio_nbytes = iov_.size();
 }
 
-//! Submits an I/O request to the OS
-//! \returns false if submission fails
-bool LinuxaioRequest::post() {
-    LOG << "LinuxaioRequest[" << this << "] post()";
+iocb* LinuxaioRequest::prepare_post() {
+    LOG << "LinuxaioRequest[" << this << "] prepare_post()"
+        << " merged=" << merged_.size();
 
     fill_control_block();
-    iocb* cb_pointer = &cb_;
-    // io_submit might considerable time, so we have to remember the current
-    // time before the call.
-    double now = timestamp();
-    LinuxaioQueue* queue = dynamic_cast<LinuxaioQueue*>(
-        DiskQueues::GetInstance()->GetQueue(file_->get_queue_id()));
-    long success = syscall(SYS_io_submit, queue->io_context(), 1, &cb_pointer);
-    if (success == 1)
-    {
-        if (type_ == READ)
-            Stats::GetInstance()->read_started(bytes_, now);
-        else
-            Stats::GetInstance()->write_started(bytes_, now);
-    }
-    else if (success == -1 && errno != EAGAIN)
-        THRILL_THROW_ERRNO(IoError, "LinuxaioRequest::post"
-                           " io_submit()");
+    return &cb_;
+}
+
+void LinuxaioRequest::started(double now) {
+    if (type_ == READ)
+        Stats::GetInstance()->read_started(bytes_, now);
+    else
+        Stats::GetInstance()->write_started(bytes_, now);
+
+    for (RequestPtr& r : merged_)
+        dynamic_cast<LinuxaioRequest*>(r.get())->started(now);
+}
+
+bool LinuxaioRequest::merge(const RequestPtr& next) {
+    if (next->file().get() != file_.get() || next->type() != type_ ||
+        next->offset() != offset_ + total_bytes())
+        return false;
+
+    merged_.push_back(next);
+    return true;
+}
+
+Request::size_type LinuxaioRequest::total_bytes() const {
+    size_type total = bytes_;
+    for (const RequestPtr& r : merged_)
+        total += r->bytes();
+    return total;
+}
 
-    return success == 1;
+void LinuxaioRequest::save_error_all(const mem::safe_string& msg) {
+    save_error(msg);
+    for (RequestPtr& r : merged_)
+        r->save_error(msg);
 }
 
 //! Cancel the request
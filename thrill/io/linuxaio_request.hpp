@@ -21,8 +21,11 @@
 #if THRILL_HAVE_LINUXAIO_FILE
 
 #include <linux/aio_abi.h>
+#include <sys/uio.h>
 #include <thrill/io/request.hpp>
 
+#include <vector>
+
 namespace thrill {
 namespace io {
 
@@ -30,11 +33,21 @@ namespace io {
 //! \{
 
 //! Request for an linuxaio_file.
+//!
+//! The LinuxaioQueue may merge requests to adjacent regions of the same
+//! file into the first one, which then transfers all of them with one
+//! vectored preadv/pwritev operation and completes them together.
 class LinuxaioRequest final : public Request
 {
     //! control block of async request
     iocb cb_;
 
+    //! requests merged into this one, following it in the file
+    std::vector<RequestPtr> merged_;
+
+    //! buffers of this and the merged requests
+    std::vector<iovec> iov_;
+
     void fill_control_block();
 
 public:
@@ -51,7 +64,21 @@ public:
             << " type=" << type << ")";
     }
 
-    bool post();
+    //! Fill the control block for submission to the OS by the queue.
+    iocb * prepare_post();
+    //! Record the start of a submitted request and the merged ones.
+    void started(double now);
+
+    //! Merge an adjacent request into this one, returns false if it does not
+    //! directly follow this one in the same file.
+    bool merge(const RequestPtr& next);
+    //! total number of bytes including the merged requests
+    size_type total_bytes() const;
+    //! number of requests merged into this one
+    size_t num_merged() const { return merged_.size(); }
+    //! Save an error in this and all merged requests.
+    void save_error_all(const mem::safe_string& msg);
+
     bool cancel() final;
     bool cancel_aio();
     void completed(bool posted, bool canceled);
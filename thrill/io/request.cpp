@@ -15,6 +15,7 @@
 #include <thrill/io/disk_queues.hpp>
 #include <thrill/io/file_base.hpp>
 #include <thrill/io/iostats.hpp>
+#include <thrill/io/iouring_request.hpp>
 #include <thrill/io/linuxaio_request.hpp>
 #include <thrill/io/request.hpp>
 #include <thrill/io/serving_request.hpp>
@@ -40,8 +41,10 @@ Request::Request(
       buffer_(buffer),
       offset_(offset),
       bytes_(bytes),
-      type_(type) {
+      type_(type),
+      priority_(type == READ ? DEMAND_READ : BACKGROUND_WRITE) {
     LOG << "Request::(...), ref_cnt=" << reference_count();
+    if (file_) ++file_->queue_depth_;
 }
 
 Request::~Request() {
@@ -105,6 +108,11 @@ void RequestDeleter::operator () (Request* req) const {
     else if (LinuxaioRequest* r = dynamic_cast<LinuxaioRequest*>(req)) {
         mem::GPool().destroy(r);
     }
+#endif
+#if THRILL_HAVE_IOURING_FILE
+    else if (IoUringRequest* r = dynamic_cast<IoUringRequest*>(req)) {
+        mem::GPool().destroy(r);
+    }
 #endif
     else {
         abort();
@@ -137,6 +145,7 @@ bool Request::cancel() {
         // user callback
         if (on_complete_)
             on_complete_(this, false);
+        --file_->queue_depth_;
         file_.reset();
         state_.set_to(READY2DIE);
         return true;
@@ -160,6 +169,7 @@ void Request::completed(bool canceled) {
     if (on_complete_)
         on_complete_(this, !canceled);
     // notify waiters
+    if (file_) --file_->queue_depth_;
     file_.reset();
     state_.set_to(READY2DIE);
 }
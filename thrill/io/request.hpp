@@ -53,6 +53,23 @@ public:
 
     enum ReadOrWriteType { READ, WRITE };
 
+    //! Scheduling classes of requests in the disk queues, most urgent first.
+    //! Requests of less urgent classes are delayed at most by a class-specific
+    //! slack, hence they are never starved.
+    enum Priority {
+        //! read which a thread is blocked on
+        DEMAND_READ,
+        //! write which frees memory for blocked allocations
+        EVICTION_WRITE,
+        //! read issued ahead of time
+        PREFETCH_READ,
+        //! write which nobody is waiting for
+        BACKGROUND_WRITE
+    };
+
+    //! number of Priority classes
+    static constexpr size_t num_priorities = 4;
+
 protected:
     static constexpr bool debug = false;
 
@@ -73,6 +90,8 @@ protected:
     size_type bytes_;
     //! READ or WRITE
     ReadOrWriteType type_;
+    //! scheduling class in the disk queue
+    Priority priority_;
 
     //! \}
 
@@ -103,6 +122,11 @@ public:
     offset_type offset() const { return offset_; }
     size_type bytes() const { return bytes_; }
     ReadOrWriteType type() const { return type_; }
+    Priority priority() const { return priority_; }
+
+    //! Change the scheduling class, must be called before the request is added
+    //! to a disk queue.
+    void set_priority(Priority priority) { priority_ = priority; }
 
     void check_alignment() const;
 
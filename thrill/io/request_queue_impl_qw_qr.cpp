@@ -33,6 +33,9 @@
 namespace thrill {
 namespace io {
 
+constexpr size_t RequestQueueImplQwQr::slack_us_[];
+constexpr size_t RequestQueueImplQwQr::max_coalesce_;
+
 RequestQueueImplQwQr::RequestQueueImplQwQr(int n)
     : thread_state_(NOT_RUNNING) {
     common::UNUSED(n);
@@ -47,38 +50,25 @@ void RequestQueueImplQwQr::AddRequest(RequestPtr& req) {
     if (!dynamic_cast<ServingRequest*>(req.get()))
         LOG1 << "Incompatible request submitted to running queue.";
 
-    if (req.get()->type() == Request::READ)
-    {
+    Clock::time_point deadline =
+        Clock::now() + std::chrono::microseconds(slack_us_[req->priority()]);
+
+    std::unique_lock<std::mutex> Lock(mutex_);
 #if THRILL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION
-        {
-            std::unique_lock<std::mutex> Lock(write_mutex_);
-            if (std::find_if(write_queue_.begin(), write_queue_.end(),
-                             bind2nd(FileOffsetMatch(), req))
-                != write_queue_.end())
+    for (const Queue& queue : queues_) {
+        for (const Entry& e : queue) {
+            if (e.req->type() != req->type() && FileOffsetMatch()(e.req, req))
             {
-                LOG1 << "READ request submitted for a BID with a pending WRITE request";
+                LOG1 << (req->type() == Request::READ ? "READ" : "WRITE")
+                     << " request submitted for a BID with a pending "
+                     << (e.req->type() == Request::READ ? "READ" : "WRITE")
+                     << " request";
             }
         }
-#endif
-        std::unique_lock<std::mutex> Lock(read_mutex_);
-        read_queue_.push_back(req);
     }
-    else
-    {
-#if THRILL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION
-        {
-            std::unique_lock<std::mutex> Lock(read_mutex_);
-            if (std::find_if(read_queue_.begin(), read_queue_.end(),
-                             bind2nd(FileOffsetMatch(), req))
-                != read_queue_.end())
-            {
-                LOG1 << "WRITE request submitted for a BID with a pending READ request";
-            }
-        }
 #endif
-        std::unique_lock<std::mutex> Lock(write_mutex_);
-        write_queue_.push_back(req);
-    }
+    queues_[req->priority()].emplace_back(Entry { req, deadline });
+    Lock.unlock();
 
     sem_.signal();
 }
@@ -92,27 +82,15 @@ bool RequestQueueImplQwQr::CancelRequest(Request* req) {
         LOG1 << "Incompatible request submitted to running queue.";
 
     bool was_still_in_queue = false;
-    if (req->type() == Request::READ)
     {
-        std::unique_lock<std::mutex> Lock(read_mutex_);
-        Queue::iterator pos
-            = std::find(read_queue_.begin(), read_queue_.end(), req);
-        if (pos != read_queue_.end())
+        std::unique_lock<std::mutex> Lock(mutex_);
+        Queue& queue = queues_[req->priority()];
+        Queue::iterator pos = std::find_if(
+            queue.begin(), queue.end(),
+            [req](const Entry& e) { return e.req.get() == req; });
+        if (pos != queue.end())
         {
-            read_queue_.erase(pos);
-            was_still_in_queue = true;
-            Lock.unlock();
-            sem_.wait();
-        }
-    }
-    else
-    {
-        std::unique_lock<std::mutex> Lock(write_mutex_);
-        Queue::iterator pos
-            = std::find(write_queue_.begin(), write_queue_.end(), req);
-        if (pos != write_queue_.end())
-        {
-            write_queue_.erase(pos);
+            queue.erase(pos);
             was_still_in_queue = true;
             Lock.unlock();
             sem_.wait();
@@ -126,68 +104,83 @@ RequestQueueImplQwQr::~RequestQueueImplQwQr() {
     StopThread(thread_, thread_state_, sem_);
 }
 
+RequestPtr RequestQueueImplQwQr::PopNext() {
+    Queue* best = nullptr;
+    for (Queue& queue : queues_) {
+        if (queue.empty()) continue;
+        if (!best || queue.front().deadline < best->front().deadline)
+            best = &queue;
+    }
+    if (!best) return RequestPtr();
+
+    RequestPtr req = std::move(best->front().req);
+    best->pop_front();
+    return req;
+}
+
+RequestPtr RequestQueueImplQwQr::PopAdjacent(
+    const FileBase* file, Request::ReadOrWriteType type,
+    Request::offset_type offset) {
+    for (Queue& queue : queues_) {
+        for (Queue::iterator it = queue.begin(); it != queue.end(); ++it) {
+            const RequestPtr& r = it->req;
+            if (r->type() == type && r->file().get() == file &&
+                r->offset() == offset)
+            {
+                RequestPtr req = std::move(it->req);
+                queue.erase(it);
+                return req;
+            }
+        }
+    }
+    return RequestPtr();
+}
+
 void* RequestQueueImplQwQr::worker(void* arg) {
     RequestQueueImplQwQr* pthis = static_cast<RequestQueueImplQwQr*>(arg);
 
-    bool write_phase = true;
     for ( ; ; )
     {
         pthis->sem_.wait();
 
-        if (write_phase)
+        std::unique_lock<std::mutex> Lock(pthis->mutex_);
+        RequestPtr req = pthis->PopNext();
+        Lock.unlock();
+
+        if (req)
         {
-            std::unique_lock<std::mutex> WriteLock(pthis->write_mutex_);
-            if (!pthis->write_queue_.empty())
-            {
-                RequestPtr req = pthis->write_queue_.front();
-                pthis->write_queue_.pop_front();
+            LOG << "queue: serving " << *req
+                << " priority " << req->priority();
 
-                WriteLock.unlock();
+            // serve() releases the file, hence save the request's parameters
+            // to find requests continuing directly behind it.
+            FileBasePtr file = req->file();
+            Request::ReadOrWriteType type = req->type();
+            Request::offset_type end = req->offset() + req->bytes();
 
-                // assert(req->get_reference_count()) > 1);
-                dynamic_cast<ServingRequest*>(req.get())->serve();
-            }
-            else
+            // assert(req->get_reference_count()) > 1);
+            dynamic_cast<ServingRequest*>(req.get())->serve();
+
+            // serve adjacent requests back-to-back, which keeps the disk
+            // access sequential.
+            for (size_t i = 0; i < max_coalesce_; ++i)
             {
-                WriteLock.unlock();
+                Lock.lock();
+                RequestPtr next = pthis->PopAdjacent(file.get(), type, end);
+                Lock.unlock();
+                if (!next) break;
 
-                pthis->sem_.signal();
+                // will never block, the request was counted by AddRequest()
+                pthis->sem_.wait();
 
-                if (pthis->priority_op_ == WRITE)
-                    write_phase = false;
+                LOG << "queue: coalesced " << *next;
+                end = next->offset() + next->bytes();
+                dynamic_cast<ServingRequest*>(next.get())->serve();
             }
-
-            if (pthis->priority_op_ == NONE || pthis->priority_op_ == READ)
-                write_phase = false;
         }
         else
         {
-            std::unique_lock<std::mutex> ReadLock(pthis->read_mutex_);
-
-            if (!pthis->read_queue_.empty())
-            {
-                RequestPtr req = pthis->read_queue_.front();
-                pthis->read_queue_.pop_front();
-
-                ReadLock.unlock();
-
-                LOG << "queue: before serve request has " << req->reference_count() << " references ";
-                // assert(req->get_reference_count() > 1);
-                dynamic_cast<ServingRequest*>(req.get())->serve();
-                LOG << "queue: after serve request has " << req->reference_count() << " references ";
-            }
-            else
-            {
-                ReadLock.unlock();
-
-                pthis->sem_.signal();
-
-                if (pthis->priority_op_ == READ)
-                    write_phase = true;
-            }
-
-            if (pthis->priority_op_ == NONE || pthis->priority_op_ == WRITE)
-                write_phase = true;
+            pthis->sem_.signal();
         }
 
         // terminate if it has been requested and queues are empty
@@ -21,6 +21,7 @@
 #include <thrill/io/request_queue_impl_worker.hpp>
 #include <thrill/mem/pool.hpp>
 
+#include <chrono>
 #include <list>
 #include <mutex>
 
@@ -30,39 +31,63 @@ namespace io {
 //! \addtogroup io_layer_req
 //! \{
 
-//! Implementation of a local request queue having two queues, one for read and
-//! one for write requests, thus having two threads. This is the default
+//! Implementation of a local request queue having one queue per
+//! Request::Priority class, served by a single thread. This is the default
 //! implementation.
+//!
+//! Each request gets a virtual deadline of its submission time plus the slack
+//! of its class, and the request with the earliest deadline is served
+//! next. Hence demand reads overtake queued eviction writes, prefetches and
+//! background writes, but those are delayed at most by their slack. After
+//! serving a request, queued requests of the same type continuing directly
+//! behind it in the same file are served back-to-back.
 class RequestQueueImplQwQr : public RequestQueueImplWorker
 {
     static constexpr bool debug = false;
 
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! slack of the Request::Priority classes in microseconds
+    static constexpr size_t slack_us_[Request::num_priorities] = {
+        0, 2000, 10000, 50000
+    };
+
+    //! maximum number of adjacent requests served back-to-back
+    static constexpr size_t max_coalesce_ = 16;
+
 private:
-    using Queue = std::list<RequestPtr, mem::GPoolAllocator<RequestPtr> >;
+    struct Entry {
+        RequestPtr req;
+        Clock::time_point deadline;
+    };
 
-    std::mutex write_mutex_;
-    std::mutex read_mutex_;
-    Queue write_queue_;
-    Queue read_queue_;
+    using Queue = std::list<Entry, mem::GPoolAllocator<Entry> >;
+
+    std::mutex mutex_;
+    //! FIFO queues of each Request::Priority class, deadlines are ascending
+    Queue queues_[Request::num_priorities];
 
     common::SharedState<ThreadState> thread_state_;
     std::thread thread_;
     common::Semaphore sem_;
 
-    static constexpr PriorityOp priority_op_ = WRITE;
-
     static void * worker(void* arg);
 
+    //! remove the request with the earliest deadline, requires mutex_ lock
+    RequestPtr PopNext();
+
+    //! remove a queued request of given type on the file starting at offset,
+    //! or return an empty pointer. requires mutex_ lock
+    RequestPtr PopAdjacent(const FileBase* file, Request::ReadOrWriteType type,
+                           Request::offset_type offset);
+
 public:
     // \param n max number of requests simultaneously submitted to disk
     explicit RequestQueueImplQwQr(int n = 1);
 
-    // in a multi-threaded setup this does not work as intended
-    // also there were race conditions possible
-    // and actually an old value was never restored once a new one was set ...
-    // so just disable it and all it's nice implications
+    //! priorities are determined by the Request::Priority of each request
     void SetPriorityOp(PriorityOp op) final {
-        // _priority_op = op;
         common::UNUSED(op);
     }
     void AddRequest(RequestPtr& req) final;
@@ -15,6 +15,7 @@
  ******************************************************************************/
 
 #include <thrill/common/config.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/common/semaphore.hpp>
 #include <thrill/common/shared_state.hpp>
 #include <thrill/io/error_handling.hpp>
@@ -35,7 +36,11 @@ void RequestQueueImplWorker::StartThread(
     void* (*worker)(void*), void* arg, std::thread& t,
     common::SharedState<ThreadState>& s) {
     assert(s() == NOT_RUNNING);
-    t = std::thread(worker, arg);
+    t = std::thread(
+        [worker, arg]() {
+            common::PinServiceThread();
+            worker(arg);
+        });
     s.set_to(RUNNING);
 }
 
@@ -238,6 +238,27 @@ void UfsFileBase::_set_size(offset_type newsize) {
 #endif
 }
 
+void UfsFileBase::preallocate(offset_type offset, offset_type size) {
+#if defined(__linux__)
+    static constexpr bool debug = false;
+
+    std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+    if ((mode_ & RDONLY) || is_device_ || file_des_ < 0) return;
+
+    // allocate unwritten extents, which neither change the file size nor go
+    // through the page cache. posix_fallocate() is not used as fallback since
+    // it writes zeros on file systems without fallocate().
+    if (::fallocate(file_des_, FALLOC_FL_KEEP_SIZE, offset, size) != 0) {
+        LOG << "fallocate() path=" << path_ << " fd=" << file_des_
+            << " offset=" << offset << " size=" << size
+            << " failed: " << strerror(errno);
+    }
+#else
+    common::UNUSED(offset);
+    common::UNUSED(size);
+#endif
+}
+
 void UfsFileBase::close_remove() {
     close();
 
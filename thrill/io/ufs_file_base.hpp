@@ -50,9 +50,11 @@ public:
     ~UfsFileBase();
     offset_type size() final;
     void set_size(offset_type newsize) final;
+    void preallocate(offset_type offset, offset_type size) final;
     void lock() final;
     const char * io_type() const override;
     void close_remove() final;
+    int native_fd() const final { return file_des_; }
     //! unlink file without closing it.
     void unlink();
     //! return true if file is special device node
@@ -0,0 +1,194 @@
+/*******************************************************************************
+ * thrill/mem/huge_page_arena.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/huge_page_arena.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if __linux__
+#include <sys/mman.h>
+#endif
+
+namespace thrill {
+namespace mem {
+
+static constexpr bool debug = false;
+
+HugePageArena::HugePageArena(Mode mode, size_t region_size)
+    : mode_(mode), region_size_(region_size) {
+    assert((region_size & (region_size - 1)) == 0);
+    num_orders_ = 1;
+    while ((min_block_size << (num_orders_ - 1)) < region_size_)
+        ++num_orders_;
+    free_.resize(num_orders_);
+    huge_page_size_ =
+        mode_ == Mode::HugeTlb1G ? (size_t(1) << 30) : (size_t(2) << 20);
+}
+
+HugePageArena::~HugePageArena() {
+#if __linux__
+    for (const uintptr_t& r : regions_)
+        munmap(reinterpret_cast<void*>(r), region_size_);
+#endif
+}
+
+bool HugePageArena::MapRegion() {
+#if __linux__
+    void* addr = MAP_FAILED;
+    if (mode_ == Mode::Transparent) {
+        // map twice the size to align the region to a huge page boundary,
+        // then unmap the unaligned ends.
+        size_t size = region_size_ + huge_page_size_;
+        char* base = static_cast<char*>(
+            mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+        if (base == MAP_FAILED) return false;
+
+        uintptr_t begin = reinterpret_cast<uintptr_t>(base);
+        uintptr_t aligned =
+            (begin + huge_page_size_ - 1) & ~(huge_page_size_ - 1);
+        if (aligned != begin)
+            munmap(base, aligned - begin);
+        if (aligned + region_size_ != begin + size)
+            munmap(reinterpret_cast<void*>(aligned + region_size_),
+                   begin + size - aligned - region_size_);
+        addr = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+        madvise(addr, region_size_, MADV_HUGEPAGE);
+#endif
+    }
+    else {
+#if defined(MAP_HUGETLB)
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+        flags |= (mode_ == Mode::HugeTlb1G ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+        addr = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE,
+                    flags, -1, 0);
+#endif
+        if (addr == MAP_FAILED) return false;
+    }
+
+    if (debug) {
+        fprintf(stderr, "HugePageArena::MapRegion() region %p size %zu\n",
+                addr, region_size_);
+    }
+
+    regions_.push_back(reinterpret_cast<uintptr_t>(addr));
+    free_[num_orders_ - 1].insert(reinterpret_cast<uintptr_t>(addr));
+    return true;
+#else
+    return false;
+#endif
+}
+
+uintptr_t HugePageArena::FindRegion(uintptr_t ptr) const noexcept {
+    for (const uintptr_t& r : regions_) {
+        if (ptr >= r && ptr < r + region_size_) return r;
+    }
+    return 0;
+}
+
+void* HugePageArena::allocate(size_t size) noexcept {
+    if (size < min_block_size || size > region_size_ ||
+        (size & (size - 1)) != 0)
+        return nullptr;
+
+    size_t order = 0;
+    while ((min_block_size << order) < size) ++order;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // find the smallest order with a free block
+    size_t o = order;
+    while (o < num_orders_ && free_[o].empty()) ++o;
+    if (o == num_orders_) {
+        if (!MapRegion()) return nullptr;
+        o = num_orders_ - 1;
+    }
+
+    uintptr_t block = *free_[o].begin();
+    free_[o].erase(free_[o].begin());
+
+    // split the block, returning the upper halves to the free lists
+    while (o > order) {
+        --o;
+        free_[o].insert(block + (min_block_size << o));
+    }
+
+    allocated_ += size;
+    return reinterpret_cast<void*>(block);
+}
+
+void HugePageArena::deallocate(void* ptr, size_t size) noexcept {
+    size_t order = 0;
+    while ((min_block_size << order) < size) ++order;
+
+    uintptr_t block = reinterpret_cast<uintptr_t>(ptr);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    uintptr_t region = FindRegion(block);
+    assert(region != 0);
+    allocated_ -= size;
+
+#if __linux__
+    // return the physical memory of large blocks to the operating system
+    if (size >= huge_page_size_)
+        madvise(ptr, size, MADV_DONTNEED);
+#endif
+
+    // merge with free buddies
+    while (order + 1 < num_orders_) {
+        uintptr_t buddy =
+            region + ((block - region) ^ (min_block_size << order));
+        FreeSet::iterator it = free_[order].find(buddy);
+        if (it == free_[order].end()) break;
+        free_[order].erase(it);
+        block = std::min(block, buddy);
+        ++order;
+    }
+    free_[order].insert(block);
+}
+
+bool HugePageArena::owns(const void* ptr) const noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return FindRegion(reinterpret_cast<uintptr_t>(ptr)) != 0;
+}
+
+HugePageArena* GHugePageArena() {
+    static HugePageArena* arena = []() -> HugePageArena* {
+        const char* env = getenv("THRILL_HUGEPAGES");
+        if (env == nullptr || *env == 0 || strcmp(env, "0") == 0)
+            return nullptr;
+        if (strcmp(env, "1") == 0 || strcmp(env, "thp") == 0) {
+            return by_new<HugePageArena>(
+                HugePageArena::Mode::Transparent, size_t(1) << 30);
+        }
+        if (strcmp(env, "2m") == 0) {
+            return by_new<HugePageArena>(
+                HugePageArena::Mode::HugeTlb2M, size_t(256) << 20);
+        }
+        if (strcmp(env, "1g") == 0) {
+            return by_new<HugePageArena>(
+                HugePageArena::Mode::HugeTlb1G, size_t(1) << 30);
+        }
+        fprintf(stderr, "Thrill: THRILL_HUGEPAGES must be 0, thp, 2m, or 1g.\n");
+        abort();
+    } ();
+    return arena;
+}
+
+} // namespace mem
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * thrill/mem/huge_page_arena.hpp
+ *
+ * An arena of large memory regions backed by huge pages, from which blocks of
+ * power-of-two sizes are allocated with a buddy system. It serves ByteBlock
+ * data in the BlockPool and the arenas of mem::Pool, which reduces TLB misses
+ * and allocator overhead for large sorts and hash tables.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_MEM_HUGE_PAGE_ARENA_HEADER
+#define THRILL_MEM_HUGE_PAGE_ARENA_HEADER
+
+#include <thrill/mem/allocator_base.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace thrill {
+namespace mem {
+
+/*!
+ * A HugePageArena reserves regions of virtual memory once, which are backed by
+ * transparent huge pages (madvise(MADV_HUGEPAGE)) or explicitly by hugetlbfs
+ * pages (MAP_HUGETLB), and carves blocks of power-of-two sizes out of them
+ * using a buddy system. Allocations of other sizes, or when no region can be
+ * mapped, return nullptr such that the caller falls back to its regular
+ * allocator.
+ *
+ * The arena is configured by the THRILL_HUGEPAGES environment variable: "thp"
+ * (or "1") for transparent huge pages, "2m" for 2 MiB hugetlbfs pages, and
+ * "1g" for 1 GiB hugetlbfs pages. It is disabled if unset or "0".
+ */
+class HugePageArena
+{
+public:
+    //! type of huge pages backing the regions
+    enum class Mode { Transparent, HugeTlb2M, HugeTlb1G };
+
+    //! smallest block size carved out of the regions
+    static constexpr size_t min_block_size = 4096;
+
+    //! construct arena with given region size, which must be a power of two
+    //! and a multiple of the huge page size.
+    HugePageArena(Mode mode, size_t region_size);
+
+    //! non-copyable: delete copy-constructor
+    HugePageArena(const HugePageArena&) = delete;
+    //! non-copyable: delete assignment operator
+    HugePageArena& operator = (const HugePageArena&) = delete;
+
+    //! unmap all regions
+    ~HugePageArena();
+
+    //! Allocate a block of given size, which must be a power of two between
+    //! min_block_size and the region size, or return nullptr.
+    void * allocate(size_t size) noexcept;
+
+    //! Return a block allocated from the arena.
+    void deallocate(void* ptr, size_t size) noexcept;
+
+    //! Returns whether the pointer points into a region of the arena.
+    bool owns(const void* ptr) const noexcept;
+
+    //! number of bytes in blocks currently allocated
+    size_t allocated() const noexcept { return allocated_; }
+
+    //! number of bytes in regions mapped
+    size_t reserved() const noexcept { return regions_.size() * region_size_; }
+
+private:
+    //! type of huge pages
+    Mode mode_;
+
+    //! size of each region
+    size_t region_size_;
+
+    //! number of buddy orders: block sizes min_block_size << order
+    size_t num_orders_;
+
+    //! size of the huge pages, freed blocks of at least this size are returned
+    //! to the operating system.
+    size_t huge_page_size_;
+
+    //! protects the free lists and regions
+    mutable std::mutex mutex_;
+
+    //! type of sets containing the addresses of free blocks
+    using FreeSet = std::unordered_set<
+              uintptr_t, std::hash<uintptr_t>, std::equal_to<uintptr_t>,
+              BypassAllocator<uintptr_t> >;
+
+    //! free blocks of each order
+    std::vector<FreeSet, BypassAllocator<FreeSet> > free_;
+
+    //! begin addresses of mapped regions
+    std::vector<uintptr_t, BypassAllocator<uintptr_t> > regions_;
+
+    //! number of bytes in blocks currently allocated
+    size_t allocated_ = 0;
+
+    //! map a new region and add it as free block, returns false on failure.
+    bool MapRegion();
+
+    //! return the region containing ptr, or 0.
+    uintptr_t FindRegion(uintptr_t ptr) const noexcept;
+};
+
+//! Return the global HugePageArena configured by THRILL_HUGEPAGES, or nullptr
+//! if huge pages are disabled. The arena is never destroyed.
+HugePageArena * GHugePageArena();
+
+} // namespace mem
+} // namespace thrill
+
+#endif // !THRILL_MEM_HUGE_PAGE_ARENA_HEADER
+
+/******************************************************************************/
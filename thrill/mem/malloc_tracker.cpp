@@ -19,6 +19,14 @@
 #if __linux__ || __APPLE__ || __FreeBSD__
 
 #include <dlfcn.h>
+#include <pthread.h>
+
+#endif
+
+#if __linux__
+
+#include <execinfo.h>
+#include <unistd.h>
 
 #endif
 
@@ -166,9 +174,190 @@ void update_peak(size_t float_curr, size_t base_curr) {
         peak_bytes = float_curr + base_curr;
 }
 
+/******************************************************************************/
+// Sampling mode: per-thread counters and allocation site sampling
+
+//! sampling interval in bytes, zero if the sampling mode is disabled.
+static size_t sample_interval = 0;
+
+//! flush per-thread counters after this many operations or bytes.
+static constexpr size_t sample_flush_ops = 256;
+static constexpr size_t sample_flush_bytes = 256 * 1024;
+
+//! Per-thread counters of the sampling mode. This must be a trivial type,
+//! since it is accessed from malloc() and cannot register a destructor. The
+//! remaining counts of exiting threads are flushed by a pthread key
+//! destructor.
+struct SampleThreadCounters {
+    //! change of float_curr not yet added to the global counter
+    size_t float_delta;
+    //! change of current_allocs not yet added to the global counter
+    size_t allocs_delta;
+    //! number of new allocations and bytes not yet added to the totals
+    size_t total_allocs, total_bytes;
+    //! number of operations since the last flush
+    size_t ops;
+    //! bytes until the next allocation site sample
+    size_t until_sample;
+    //! set while capturing a stack, to avoid sampling recursive allocations
+    bool in_sample;
+    //! whether the pthread key destructor is registered for this thread
+    bool registered;
+};
+
+static thread_local SampleThreadCounters sample_tc;
+
+#if __linux__ || __APPLE__ || __FreeBSD__
+static pthread_key_t sample_key;
+#endif
+
+//! depth of captured allocation call stacks
+static constexpr size_t sample_depth = 12;
+
+//! number of distinct call stacks in the hotspot table
+static constexpr size_t sample_slots = 4096;
+
+//! an allocation site: call stack with sampled bytes and number of samples
+struct SampleSite {
+    size_t hash;
+    size_t depth;
+    void* stack[sample_depth];
+    size_t bytes;
+    size_t samples;
+};
+
+//! open addressing hash table of allocation sites
+static SampleSite sample_sites[sample_slots];
+static size_t sample_sites_used = 0;
+static size_t sample_dropped = 0;
+static std::mutex sample_mutex;
+
+//! add the per-thread counters to the global statistics
+ATTRIBUTE_NO_SANITIZE
+static void sample_flush(SampleThreadCounters& tc) {
+    size_t mycurr = sync_add_and_fetch(float_curr, tc.float_delta);
+    sync_add_and_fetch(current_allocs, tc.allocs_delta);
+    sync_add_and_fetch(total_allocs, tc.total_allocs);
+    sync_add_and_fetch(total_bytes, tc.total_bytes);
+
+    tc.float_delta = tc.allocs_delta = 0;
+    tc.total_allocs = tc.total_bytes = 0;
+    tc.ops = 0;
+
+    // other threads may not have flushed their allocations yet, hence the
+    // global counter may temporarily underflow.
+    if (mycurr > std::numeric_limits<size_t>::max() / 2) mycurr = 0;
+
+    update_peak(mycurr, base_curr);
+    memory_exceeded = (mycurr >= memory_limit_indication);
+    update_memprofile(mycurr, get(base_curr));
+}
+
+#if __linux__ || __APPLE__ || __FreeBSD__
+ATTRIBUTE_NO_SANITIZE
+static void sample_thread_exit(void* ptr) {
+    sample_flush(*static_cast<SampleThreadCounters*>(ptr));
+}
+#endif
+
+//! count an operation, returns true if the counters should be flushed
+ATTRIBUTE_NO_SANITIZE
+static inline bool sample_need_flush(SampleThreadCounters& tc) {
+    // float_delta is a signed difference stored as size_t
+    return ++tc.ops >= sample_flush_ops ||
+           tc.float_delta + sample_flush_bytes >= 2 * sample_flush_bytes;
+}
+
+//! capture the call stack and attribute the sampling interval to its site
+ATTRIBUTE_NO_SANITIZE
+static void sample_record(size_t bytes) {
+#if __linux__
+    void* stack[sample_depth + 2];
+    int depth = backtrace(stack, sample_depth + 2);
+    // skip the frames of the malloc tracker itself
+    int skip = std::min(depth, 2);
+    depth -= skip;
+
+    size_t hash = 0;
+    for (int i = 0; i < depth; ++i) {
+        hash ^= reinterpret_cast<uintptr_t>(stack[skip + i])
+                + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    }
+    if (hash == 0) hash = 1;
+
+    std::unique_lock<std::mutex> lock(sample_mutex);
+    for (size_t p = 0; p < sample_slots; ++p) {
+        SampleSite& s = sample_sites[(hash + p) % sample_slots];
+        if (s.hash == 0) {
+            s.hash = hash;
+            s.depth = static_cast<size_t>(depth);
+            std::copy(stack + skip, stack + skip + depth, s.stack);
+            ++sample_sites_used;
+        }
+        else if (s.hash != hash || s.depth != static_cast<size_t>(depth) ||
+                 !std::equal(stack + skip, stack + skip + depth, s.stack)) {
+            continue;
+        }
+        s.bytes += bytes;
+        ++s.samples;
+        return;
+    }
+    ++sample_dropped;
+#else
+    (void)bytes;
+#endif
+}
+
+//! count an allocation in the per-thread counters of the sampling mode
+ATTRIBUTE_NO_SANITIZE
+static void sample_inc_count(size_t inc, size_t interval) {
+    SampleThreadCounters& tc = sample_tc;
+#if __linux__ || __APPLE__ || __FreeBSD__
+    if (!tc.registered) {
+        tc.registered = true;
+        pthread_setspecific(sample_key, &tc);
+    }
+#endif
+    tc.float_delta += inc;
+    tc.allocs_delta += 1;
+    tc.total_allocs += 1;
+    tc.total_bytes += inc;
+
+    if (tc.until_sample <= inc) {
+        // attribute one interval per sample, skip intervals of huge allocations
+        size_t bytes = (inc - tc.until_sample) / interval * interval + interval;
+        tc.until_sample = tc.until_sample + bytes - inc;
+        if (!tc.in_sample && real_malloc) {
+            tc.in_sample = true;
+            sample_record(bytes);
+            tc.in_sample = false;
+        }
+    }
+    else {
+        tc.until_sample -= inc;
+    }
+
+    if (sample_need_flush(tc)) sample_flush(tc);
+}
+
+//! count a deallocation in the per-thread counters of the sampling mode
+ATTRIBUTE_NO_SANITIZE
+static void sample_dec_count(size_t dec) {
+    SampleThreadCounters& tc = sample_tc;
+    tc.float_delta -= dec;
+    tc.allocs_delta -= 1;
+
+    if (sample_need_flush(tc)) sample_flush(tc);
+}
+
+/******************************************************************************/
+
 //! add allocation to statistics
 ATTRIBUTE_NO_SANITIZE
 static void inc_count(size_t inc) {
+    size_t interval = sample_interval;
+    if (interval) return sample_inc_count(inc, interval);
+
     size_t mycurr = sync_add_and_fetch(float_curr, inc);
 
     total_bytes += inc;
@@ -184,6 +373,8 @@ static void inc_count(size_t inc) {
 //! decrement allocation to statistics
 ATTRIBUTE_NO_SANITIZE
 static void dec_count(size_t dec) {
+    if (sample_interval) return sample_dec_count(dec);
+
     size_t mycurr = sync_sub_and_fetch(float_curr, dec);
 
     sync_sub_and_fetch(current_allocs, 1);
@@ -194,7 +385,10 @@ static void dec_count(size_t dec) {
 
 //! user function to return the currently allocated amount of memory
 size_t malloc_tracker_current() {
-    return float_curr;
+    size_t curr = float_curr;
+    // the global counter may underflow in the sampling mode
+    if (curr > std::numeric_limits<size_t>::max() / 2) return 0;
+    return curr;
 }
 
 //! user function to return the peak allocation
@@ -218,11 +412,77 @@ void malloc_tracker_print_status() {
             get(float_curr), get(peak_bytes), get(base_curr));
 }
 
+void malloc_tracker_set_sampling(size_t interval) {
+    if (sample_interval) sample_flush(sample_tc);
+    sample_tc.until_sample = interval;
+    sample_interval = interval;
+}
+
+size_t malloc_tracker_sampling() {
+    return sample_interval;
+}
+
+void malloc_tracker_flush() {
+    if (sample_interval) sample_flush(sample_tc);
+}
+
+size_t malloc_tracker_sampled_bytes() {
+    std::unique_lock<std::mutex> lock(sample_mutex);
+    size_t bytes = 0;
+    for (size_t i = 0; i < sample_slots; ++i)
+        bytes += sample_sites[i].bytes;
+    return bytes;
+}
+
+void malloc_tracker_print_hotspots(size_t num) {
+    // do not sample allocations made while printing
+    bool in_sample = sample_tc.in_sample;
+    sample_tc.in_sample = true;
+
+    std::unique_lock<std::mutex> lock(sample_mutex);
+
+    static SampleSite* order[sample_slots];
+    size_t used = 0, total = 0;
+    for (size_t i = 0; i < sample_slots; ++i) {
+        if (sample_sites[i].hash == 0) continue;
+        order[used++] = &sample_sites[i];
+        total += sample_sites[i].bytes;
+    }
+    num = std::min(num, used);
+    std::partial_sort(order, order + num, order + used,
+                      [](const SampleSite* a, const SampleSite* b) {
+                          return a->bytes > b->bytes;
+                      });
+
+    fprintf(stderr, PPREFIX "allocation hotspots: %zu sites, %zu bytes sampled"
+            " every %zu bytes, %zu samples dropped\n",
+            used, total, sample_interval, sample_dropped);
+
+    for (size_t i = 0; i < num; ++i) {
+        fprintf(stderr, PPREFIX "hotspot %zu: %zu bytes (%.1f%%) in %zu samples\n",
+                i, order[i]->bytes,
+                total ? 100.0 * order[i]->bytes / total : 0.0,
+                order[i]->samples);
+#if __linux__
+        backtrace_symbols_fd(order[i]->stack,
+                             static_cast<int>(order[i]->depth), STDERR_FILENO);
+#endif
+    }
+
+    sample_tc.in_sample = in_sample;
+}
+
 void set_memory_limit_indication(size_t size) {
     // fprintf(stderr, PPREFIX "set_memory_limit_indication %zu\n", size);
     memory_limit_indication = size;
 }
 
+bool memory_available(size_t size) {
+    size_t curr = malloc_tracker_current();
+    return curr < memory_limit_indication &&
+           size < memory_limit_indication - curr;
+}
+
 /******************************************************************************/
 // Run-time memory profiler
 
@@ -319,10 +579,37 @@ void StartMemProfiler(common::ProfileThread& sched, common::JsonLogger& logger)
 
 #if __linux__ || __APPLE__ || __FreeBSD__
 
+//! Enable the sampling mode if THRILL_MALLOC_SAMPLE is set to the sampling
+//! interval in bytes.
+ATTRIBUTE_NO_SANITIZE
+static void init_sampling() {
+    pthread_key_create(&sample_key, sample_thread_exit);
+
+    const char* env = getenv("THRILL_MALLOC_SAMPLE");
+    if (!env || !*env) return;
+
+    char* endptr;
+    size_t interval = strtoul(env, &endptr, 10);
+    if (*endptr != 0) {
+        fprintf(stderr, PPREFIX "THRILL_MALLOC_SAMPLE must be a number of bytes.\n");
+        exit(EXIT_FAILURE);
+    }
+
+#if __linux__
+    // the first backtrace() loads libgcc_s, which allocates memory.
+    void* stack[1];
+    backtrace(stack, 1);
+#endif
+
+    malloc_tracker_set_sampling(interval);
+}
+
 ATTRIBUTE_NO_SANITIZE
 static __attribute__ ((constructor)) void init() { // NOLINT
 
     // try to use AddressSanitizer's malloc first.
+    init_sampling();
+
     real_malloc = (malloc_type)dlsym(RTLD_DEFAULT, "__interceptor_malloc");
     if (real_malloc)
     {
@@ -364,6 +651,10 @@ static __attribute__ ((constructor)) void init() { // NOLINT
 
 ATTRIBUTE_NO_SANITIZE
 static __attribute__ ((destructor)) void finish() { // NOLINT
+    if (sample_interval) {
+        sample_flush(sample_tc);
+        malloc_tracker_print_hotspots(20);
+    }
     update_memprofile(get(float_curr), get(base_curr));
     fprintf(stderr, PPREFIX
             "exiting, total: %zu, peak: %zu, current: %zu / %zu, "
@@ -578,9 +869,6 @@ static void preinit_free(void* ptr) {
 #define MALLOC_USABLE_SIZE malloc_usable_size
 #include <malloc.h>
 
-#include <execinfo.h>
-#include <unistd.h>
-
 #endif
 
 /******************************************************************************/
@@ -31,6 +31,10 @@ extern bool memory_exceeded;
 //! exceed. it does not actually limit allocation!
 void set_memory_limit_indication(size_t size);
 
+//! check whether size more bytes can be allocated without exceeding the limit
+//! set by set_memory_limit_indication().
+bool memory_available(size_t size);
+
 //! bypass malloc tracker and access malloc() directly
 void * bypass_malloc(size_t size) noexcept;
 
@@ -52,6 +56,31 @@ size_t malloc_tracker_total_allocs();
 //! user function which prints current and peak allocation to stderr
 void malloc_tracker_print_status();
 
+/*!
+ * Enable the low-overhead sampling mode if interval > 0, or disable it. In this
+ * mode, each thread counts its allocations locally and adds them to the global
+ * statistics only every few hundred operations or hundred KiB, hence the
+ * current and peak values above are approximate. Additionally, the call stack
+ * of an allocation is captured about every interval bytes, which yields a
+ * profile of allocation hotspots printed at exit.
+ *
+ * The sampling mode is enabled at startup by setting THRILL_MALLOC_SAMPLE to
+ * the sampling interval, e.g. THRILL_MALLOC_SAMPLE=1048576.
+ */
+void malloc_tracker_set_sampling(size_t interval);
+
+//! returns the sampling interval, or zero if the sampling mode is disabled
+size_t malloc_tracker_sampling();
+
+//! add the calling thread's counters to the global statistics
+void malloc_tracker_flush();
+
+//! returns the number of bytes attributed to sampled allocation sites
+size_t malloc_tracker_sampled_bytes();
+
+//! user function which prints the top allocation sites to stderr
+void malloc_tracker_print_hotspots(size_t num = 20);
+
 //! launch profiler task
 void StartMemProfiler(common::ProfileThread& sched, common::JsonLogger& logger);
 
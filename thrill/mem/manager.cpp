@@ -21,7 +21,7 @@ Manager::~Manager() {
     // LoggerAllocator any more
     if (debug) {
         printf("mem::Manager() name=%s alloc_count_=%zu peak_=%zu total_=%zu\n",
-               name_, alloc_count_.load(), peak_.load(), total_.load());
+               name_, counters_.get(kAllocCount), peak(), total());
     }
 }
 
@@ -12,6 +12,8 @@
 #ifndef THRILL_MEM_MANAGER_HEADER
 #define THRILL_MEM_MANAGER_HEADER
 
+#include <thrill/common/sharded_counter.hpp>
+
 #include <algorithm>
 #include <atomic>
 #include <cassert>
@@ -24,11 +26,22 @@ namespace mem {
  * allocations. These is one global mem::Manager per compute host. To track
  * memory consumption of subcomponents of Thrill, one can create local child
  * mem::Managers which report allocation automatically to their superiors.
+ *
+ * The counters are sharded per thread, such that concurrent allocations do not
+ * contend on a cache line. The peak is sampled from the summed total on large
+ * allocations and on every peak_sample_count-th allocation of a shard, hence
+ * it may miss short spikes of small allocations.
  */
 class Manager
 {
     static constexpr bool debug = false;
 
+    //! allocations of at least this size always sample the peak
+    static constexpr size_t peak_sample_bytes = 64 * 1024;
+
+    //! every this many allocations of a shard sample the peak
+    static constexpr size_t peak_sample_count = 64;
+
 public:
     explicit Manager(Manager* super, const char* name)
         : super_(super), name_(name)
@@ -40,21 +53,24 @@ public:
     Manager * super() { return super_; }
 
     //! return total allocation (local value)
-    size_t total() const { return total_; }
+    size_t total() const { return counters_.get(kTotal); }
+
+    //! return sampled peak allocation (local value)
+    size_t peak() const { return std::max(peak_.load(), total()); }
 
     //! add memory consumption.
     Manager& add(size_t amount) {
-        size_t current = (total_ += amount);
-        peak_ = std::max(peak_.load(), current);
-        ++alloc_count_;
+        counters_.add(kTotal, amount);
+        size_t count = counters_.add(kAllocCount, 1);
+        if (amount >= peak_sample_bytes || count % peak_sample_count == 0)
+            SamplePeak();
         if (super_) super_->add(amount);
         return *this;
     }
 
     //! subtract memory consumption.
     Manager& subtract(size_t amount) {
-        assert(total_ >= amount);
-        total_ -= amount;
+        counters_.subtract(kTotal, amount);
         if (super_) super_->subtract(amount);
         return *this;
     }
@@ -66,14 +82,23 @@ private:
     //! description for output
     const char* name_;
 
-    //! total allocation
-    std::atomic<size_t> total_ { 0 };
+    //! fields of counters_
+    enum { kTotal, kAllocCount, kFields };
+
+    //! total allocation and number of allocations
+    common::ShardedCounters<size_t, kFields> counters_;
 
-    //! peak allocation
+    //! sampled peak allocation
     std::atomic<size_t> peak_ { 0 };
 
-    //! number of allocation
-    std::atomic<size_t> alloc_count_ { 0 };
+    //! raise peak_ to the current total
+    void SamplePeak() {
+        size_t current = total();
+        size_t peak = peak_.load(std::memory_order_relaxed);
+        while (current > peak &&
+               !peak_.compare_exchange_weak(
+                   peak, current, std::memory_order_relaxed)) { }
+    }
 };
 
 } // namespace mem
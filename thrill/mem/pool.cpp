@@ -10,6 +10,7 @@
 #include <thrill/mem/pool.hpp>
 
 #include <thrill/common/splay_tree.hpp>
+#include <thrill/mem/huge_page_arena.hpp>
 
 #include <limits>
 #include <new>
@@ -20,7 +21,7 @@ namespace mem {
 /******************************************************************************/
 
 Pool& GPool() {
-    static Pool* pool = new Pool();
+    static Pool* pool = new Pool(16384, /* thread_cache */ true);
     return *pool;
 }
 
@@ -61,11 +62,58 @@ struct Pool::Arena {
     Slot * slot(size_t i) { return &head_slot + 1 + i; }
 };
 
+/******************************************************************************/
+// Pool::ThreadCache
+
+struct Pool::ThreadCache {
+    //! number of size classes: allocations of 1 .. num_classes slots
+    static constexpr size_t num_classes = thread_cache_max_bytes / sizeof(Slot);
+
+    static_assert(thread_cache_max_bytes % sizeof(Slot) == 0,
+                  "thread cached sizes must be whole slots");
+
+    //! size class of an allocation of bytes
+    static size_t class_of(size_t bytes) { return (bytes - 1) / sizeof(Slot); }
+
+    //! bytes of the slots cached in size class c
+    static size_t class_bytes(size_t c) { return (c + 1) * sizeof(Slot); }
+
+    //! maximum number of free slots cached per size class
+    static constexpr size_t capacity = 64;
+
+    //! number of slots moved between the magazine and the Pool at once
+    static constexpr size_t batch = capacity / 2;
+
+    //! the Pool the cached slots belong to
+    Pool* pool = nullptr;
+
+    //! number of cached slots per size class
+    size_t count[num_classes] = { 0 };
+
+    //! cached slots per size class
+    void* items[num_classes][capacity];
+
+    //! return all cached slots to the Pool when the thread exits
+    ~ThreadCache() {
+        if (!pool) return;
+        std::unique_lock<std::mutex> lock(pool->mutex_);
+        for (size_t c = 0; c < num_classes; ++c) {
+            while (count[c] != 0)
+                pool->IntDeallocate(items[c][--count[c]], class_bytes(c));
+        }
+    }
+};
+
+Pool::ThreadCache& Pool::thread_cache() {
+    static thread_local ThreadCache tc;
+    return tc;
+}
+
 /******************************************************************************/
 // Pool
 
-Pool::Pool(size_t default_arena_size) noexcept
-    : default_arena_size_(default_arena_size) {
+Pool::Pool(size_t default_arena_size, bool thread_cache) noexcept
+    : default_arena_size_(default_arena_size), thread_cache_(thread_cache) {
     std::unique_lock<std::mutex> lock(mutex_);
 
     if (debug_check_pairing)
@@ -103,6 +151,15 @@ struct Pool::ArenaCompare {
     }
 };
 
+//! free memory of an Arena, which may be from the HugePageArena
+static void FreeArenaMemory(void* ptr, size_t size) {
+    HugePageArena* huge_arena = GHugePageArena();
+    if (huge_arena && huge_arena->owns(ptr))
+        huge_arena->deallocate(ptr, size);
+    else
+        bypass_free(ptr, size);
+}
+
 Pool::Arena* Pool::AllocateFreeArena(size_t arena_size, bool die_on_failure) {
 
     if (debug) {
@@ -110,8 +167,11 @@ Pool::Arena* Pool::AllocateFreeArena(size_t arena_size, bool die_on_failure) {
     }
 
     // Allocate space for the new block
-    Arena* new_arena =
-        reinterpret_cast<Arena*>(bypass_malloc(arena_size));
+    Arena* new_arena = nullptr;
+    if (HugePageArena* huge_arena = GHugePageArena())
+        new_arena = reinterpret_cast<Arena*>(huge_arena->allocate(arena_size));
+    if (!new_arena)
+        new_arena = reinterpret_cast<Arena*>(bypass_malloc(arena_size));
     if (!new_arena) {
         if (!die_on_failure) return nullptr;
         fprintf(stderr, "out-of-memory - mem::Pool cannot allocate a new Arena."
@@ -148,7 +208,7 @@ void Pool::IntDeallocateAll() {
     Arena* curr_arena = free_arena_;
     while (curr_arena != nullptr) {
         Arena* next_arena = curr_arena->next_arena;
-        bypass_free(curr_arena, curr_arena->total_size);
+        FreeArenaMemory(curr_arena, curr_arena->total_size);
         curr_arena = next_arena;
     }
     min_free_ = 0;
@@ -162,9 +222,36 @@ size_t Pool::bytes_per_arena(size_t arena_size) {
     return arena_size - sizeof(Arena);
 }
 
+Pool::ThreadCache* Pool::IntThreadCache(size_t bytes) {
+    if (!thread_cache_ || bytes == 0 || bytes > thread_cache_max_bytes ||
+        debug_check_pairing)
+        return nullptr;
+
+    // a thread caches slots of the first Pool with thread caches it uses.
+    ThreadCache& tc = thread_cache();
+    if (tc.pool == nullptr) tc.pool = this;
+    return tc.pool == this ? &tc : nullptr;
+}
+
 void* Pool::allocate(size_t bytes) {
+    ThreadCache* tc = IntThreadCache(bytes);
+    if (tc) {
+        size_t c = ThreadCache::class_of(bytes);
+        if (tc->count[c] == 0) {
+            // refill magazine with a batch of slots from the arenas
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (tc->count[c] < ThreadCache::batch)
+                tc->items[c][tc->count[c]++] =
+                    IntAllocate(ThreadCache::class_bytes(c));
+        }
+        return tc->items[c][--tc->count[c]];
+    }
+
     std::unique_lock<std::mutex> lock(mutex_);
+    return IntAllocate(bytes);
+}
 
+void* Pool::IntAllocate(size_t bytes) {
     if (debug) {
         std::cout << "allocate() bytes=" << bytes
                   << std::endl;
@@ -270,7 +357,25 @@ void* Pool::allocate(size_t bytes) {
 void Pool::deallocate(void* ptr, size_t bytes) {
     if (ptr == nullptr) return;
 
+    ThreadCache* tc = IntThreadCache(bytes);
+    if (tc) {
+        size_t c = ThreadCache::class_of(bytes);
+        if (tc->count[c] == ThreadCache::capacity) {
+            // return a batch of slots to the arenas
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (tc->count[c] > ThreadCache::capacity - ThreadCache::batch)
+                IntDeallocate(tc->items[c][--tc->count[c]],
+                              ThreadCache::class_bytes(c));
+        }
+        tc->items[c][tc->count[c]++] = ptr;
+        return;
+    }
+
     std::unique_lock<std::mutex> lock(mutex_);
+    IntDeallocate(ptr, bytes);
+}
+
+void Pool::IntDeallocate(void* ptr, size_t bytes) {
     if (debug) {
         std::cout << "deallocate() ptr" << ptr << "bytes" << bytes << std::endl;
     }
@@ -351,7 +456,7 @@ void Pool::deallocate(void* ptr, size_t bytes) {
             free_arena_ = root->next_arena;
 
         free_ -= root->num_slots();
-        bypass_free(root, root->total_size);
+        FreeArenaMemory(root, root->total_size);
     }
 
     print();
@@ -66,6 +66,12 @@ namespace mem {
  *
  * During allocation the next fitting free slot is searched for. During
  * deallocation multiple free areas may be consolidated.
+ *
+ * If constructed with thread_cache, small allocations of up to
+ * thread_cache_max_bytes are served from a per-thread magazine of free slots,
+ * which skips the mutex. Magazines are refilled from and returned to the
+ * arenas in batches. Each thread caches only for the first such Pool it uses,
+ * which must outlive the thread: this is the case for GPool().
  */
 class Pool
 {
@@ -76,8 +82,12 @@ class Pool
     static constexpr size_t check_limit = 4 * 1024 * 1024;
 
 public:
+    //! largest allocation served from the thread-local magazines
+    static constexpr size_t thread_cache_max_bytes = 128;
+
     //! construct with base allocator
-    explicit Pool(size_t default_arena_size = 16384) noexcept;
+    explicit Pool(size_t default_arena_size = 16384,
+                  bool thread_cache = false) noexcept;
 
     //! non-copyable: delete copy-constructor
     Pool(const Pool&) = delete;
@@ -129,6 +139,15 @@ private:
     //! comparison function for splay tree
     struct ArenaCompare;
 
+    //! thread-local magazines of free slots
+    struct ThreadCache;
+
+    //! return the calling thread's magazines
+    static ThreadCache& thread_cache();
+
+    //! return the calling thread's magazines if they serve this allocation.
+    ThreadCache * IntThreadCache(size_t bytes);
+
     //! mutex to protect data structures (remove this if you use it in another
     //! context than Thrill).
     std::mutex mutex_;
@@ -149,6 +168,9 @@ private:
     //! minimum amount of spare memory to keep in the Pool.
     size_t min_free_ = 1024 * 1024 / 8;
 
+    //! whether small allocations use thread-local magazines
+    bool thread_cache_;
+
     //! array of allocations for checking
     std::vector<std::pair<void*, size_t> > allocs_;
 
@@ -158,6 +180,12 @@ private:
     //! allocate a new Arena blob
     Arena * AllocateFreeArena(size_t arena_size, bool die_on_failure = true);
 
+    //! allocate a continuous segment of n bytes, the mutex must be held.
+    void * IntAllocate(size_t bytes);
+
+    //! deallocate a continuous segment of n bytes, the mutex must be held.
+    void IntDeallocate(void* ptr, size_t bytes);
+
     //! deallocate all Arenas
     void IntDeallocateAll();
 };
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * thrill/mem/stage_arena.cpp
+ *
+ * A bump allocator for temporary data structures of one stage, whose memory is
+ * released at once when the stage finishes.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/stage_arena.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace thrill {
+namespace mem {
+
+StageArena::~StageArena() {
+    while (chunk_) {
+        Chunk* prev = chunk_->prev;
+        manager_.subtract(chunk_->size);
+        free(chunk_);
+        chunk_ = prev;
+    }
+}
+
+void StageArena::NewChunk(size_t min_size) {
+    size_t size = std::max(chunk_size_, min_size + sizeof(Chunk));
+
+    Chunk* c = static_cast<Chunk*>(malloc(size));
+    if (!c) throw std::bad_alloc();
+    manager_.add(size);
+
+    c->prev = chunk_;
+    c->size = size;
+    chunk_ = c;
+    reserved_ += size;
+
+    ptr_ = reinterpret_cast<char*>(c + 1);
+    end_ = reinterpret_cast<char*>(c) + size;
+    last_ = nullptr;
+}
+
+void StageArena::Release() {
+    allocated_ = 0;
+    last_ = nullptr;
+    if (!chunk_) return;
+
+    // free all chunks but the oldest, which is kept if it has regular size.
+    while (chunk_->prev) {
+        Chunk* prev = chunk_->prev;
+        reserved_ -= chunk_->size;
+        manager_.subtract(chunk_->size);
+        free(chunk_);
+        chunk_ = prev;
+    }
+    if (chunk_->size != chunk_size_) {
+        reserved_ -= chunk_->size;
+        manager_.subtract(chunk_->size);
+        free(chunk_);
+        chunk_ = nullptr;
+        ptr_ = end_ = nullptr;
+        return;
+    }
+
+    ptr_ = reinterpret_cast<char*>(chunk_ + 1);
+    end_ = reinterpret_cast<char*>(chunk_) + chunk_->size;
+}
+
+} // namespace mem
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * thrill/mem/stage_arena.hpp
+ *
+ * A bump allocator for temporary data structures of one stage, whose memory is
+ * released at once when the stage finishes.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_MEM_STAGE_ARENA_HEADER
+#define THRILL_MEM_STAGE_ARENA_HEADER
+
+#include <thrill/mem/allocator_base.hpp>
+#include <thrill/mem/manager.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace mem {
+
+/*!
+ * A StageArena hands out memory by bumping a pointer through chunks, which are
+ * allocated with malloc(), such that they count towards the malloc tracker's
+ * memory limit, and are accounted in a Manager. Single allocations are never
+ * freed, except the most recent one, such that short-lived temporaries are
+ * reclaimed immediately. Instead, Release() drops all allocations at once and
+ * keeps the first chunk for the next stage. Containers which grow repeatedly
+ * leave their old space behind, hence the arena fits best for data of known
+ * size.
+ *
+ * Each worker Context has one StageArena, and the StageBuilder releases it
+ * after each Execute() and PushData(). Hence, memory from it may only be used
+ * by the worker thread until the end of the current Execute() or PushData(),
+ * which includes the PreOps and lambdas of child nodes called therein.
+ */
+class StageArena
+{
+public:
+    //! default size of the chunks, larger allocations get their own chunk.
+    static constexpr size_t default_chunk_size = 64 * 1024;
+
+    explicit StageArena(Manager& manager,
+                        size_t chunk_size = default_chunk_size)
+        : manager_(manager), chunk_size_(chunk_size) { }
+
+    //! non-copyable: delete copy-constructor
+    StageArena(const StageArena&) = delete;
+    //! non-copyable: delete assignment operator
+    StageArena& operator = (const StageArena&) = delete;
+
+    //! free all chunks
+    ~StageArena();
+
+    //! Allocate size bytes aligned to alignment, which must be a power of two.
+    void * allocate(size_t size,
+                    size_t alignment = alignof(std::max_align_t)) {
+        char* p = AlignUp(ptr_, alignment);
+        if (!p || p + size > end_) {
+            NewChunk(size + alignment);
+            p = AlignUp(ptr_, alignment);
+        }
+        ptr_ = p + size;
+        last_ = p;
+        allocated_ += size;
+        return p;
+    }
+
+    //! Return memory. Only the most recent allocation is reclaimed, all others
+    //! are kept until Release().
+    void deallocate(void* ptr, size_t size) noexcept {
+        if (ptr == last_ && static_cast<char*>(ptr) + size == ptr_) {
+            ptr_ = last_;
+            last_ = nullptr;
+            allocated_ -= size;
+        }
+    }
+
+    //! Drop all allocations, free all chunks but the first.
+    void Release();
+
+    //! number of bytes handed out since the last Release()
+    size_t allocated() const { return allocated_; }
+
+    //! number of bytes in chunks
+    size_t reserved() const { return reserved_; }
+
+private:
+    //! header at the beginning of each chunk
+    struct Chunk {
+        //! previously allocated chunk
+        Chunk* prev;
+        //! total size of the chunk including the header
+        size_t size;
+    };
+
+    //! memory manager accounting the chunks
+    Manager& manager_;
+
+    //! size of regular chunks
+    size_t chunk_size_;
+
+    //! most recently allocated chunk, the head of a list of all chunks
+    Chunk* chunk_ = nullptr;
+
+    //! free area of the current chunk
+    char* ptr_ = nullptr, * end_ = nullptr;
+
+    //! begin of the most recent allocation
+    char* last_ = nullptr;
+
+    //! number of bytes handed out
+    size_t allocated_ = 0;
+
+    //! number of bytes in chunks
+    size_t reserved_ = 0;
+
+    static char * AlignUp(char* p, size_t alignment) {
+        uintptr_t u = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((u + alignment - 1) & ~(alignment - 1));
+    }
+
+    //! allocate a new chunk of at least min_size usable bytes
+    void NewChunk(size_t min_size);
+};
+
+/*!
+ * Allocator for STL containers taking memory from a StageArena, for example
+ * std::vector<T, StageArenaAllocator<T> >.
+ */
+template <typename Type>
+class StageArenaAllocator : public AllocatorBase<Type>
+{
+public:
+    using value_type = Type;
+    using pointer = Type *;
+    using const_pointer = const Type *;
+    using reference = Type &;
+    using const_reference = const Type &;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    //! C++11 type flag
+    using is_always_equal = std::false_type;
+
+    //! Return allocator for different type.
+    template <typename U>
+    struct rebind { using other = StageArenaAllocator<U>; };
+
+    //! Construct StageArenaAllocator with StageArena object
+    explicit StageArenaAllocator(StageArena& arena) noexcept
+        : arena_(&arena) { }
+
+    //! copy-constructor
+    StageArenaAllocator(const StageArenaAllocator&) noexcept = default;
+
+    //! copy-constructor from a rebound allocator
+    template <typename OtherType>
+    StageArenaAllocator(const StageArenaAllocator<OtherType>& other) noexcept
+        : arena_(other.arena_) { }
+
+    //! copy-assignment operator
+    StageArenaAllocator& operator = (const StageArenaAllocator&) noexcept
+        = default;
+
+    //! allocate n elements from the arena
+    pointer allocate(size_type n, const void* /* hint */ = nullptr) {
+        if (n > this->max_size())
+            throw std::bad_alloc();
+        return static_cast<Type*>(
+            arena_->allocate(n * sizeof(Type), alignof(Type)));
+    }
+
+    //! return n elements to the arena
+    void deallocate(pointer p, size_type n) const noexcept {
+        arena_->deallocate(p, n * sizeof(Type));
+    }
+
+    //! pointer to the StageArena
+    StageArena* arena_;
+
+    //! Compare to another allocator of same type
+    template <typename Other>
+    bool operator == (const StageArenaAllocator<Other>& other) const noexcept {
+        return (arena_ == other.arena_);
+    }
+
+    //! Compare to another allocator of same type
+    template <typename Other>
+    bool operator != (const StageArenaAllocator<Other>& other) const noexcept {
+        return (arena_ != other.arena_);
+    }
+};
+
+//! std::vector with memory from a StageArena
+template <typename T>
+using arena_vector = std::vector<T, StageArenaAllocator<T> >;
+
+} // namespace mem
+} // namespace thrill
+
+#endif // !THRILL_MEM_STAGE_ARENA_HEADER
+
+/******************************************************************************/
@@ -21,7 +21,11 @@
 #include <thrill/common/math.hpp>
 #include <thrill/net/group.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace thrill {
 namespace net {
@@ -119,17 +123,21 @@ void PrefixSumHypercube(
         // communication peer for this round (hypercube dimension)
         size_t peer = net.my_host_rank() ^ d;
 
-        // Send total sum of this hypercube to worker with id = id XOR d
+        // Exchange total sums of the hypercubes with worker id = id XOR d. The
+        // lower host sends first, since large values do not fit into socket
+        // buffers and blocking sends on both sides would deadlock.
+        T recv_data;
         if (peer < net.num_hosts()) {
-            net.SendTo(peer, total_sum);
             sLOG << "PREFIX_SUM: host" << net.my_host_rank()
                  << ": sending to peer" << peer;
-        }
-
-        // Receive total sum of smaller hypercube from worker with id = id XOR d
-        T recv_data;
-        if (peer < net.num_hosts()) {
-            net.ReceiveFrom(peer, &recv_data);
+            if (net.my_host_rank() < peer) {
+                net.SendTo(peer, total_sum);
+                net.ReceiveFrom(peer, &recv_data);
+            }
+            else {
+                net.ReceiveFrom(peer, &recv_data);
+                net.SendTo(peer, total_sum);
+            }
             // The order of addition is important. The total sum of the smaller
             // hypercube always comes first.
             if (net.my_host_rank() & d)
@@ -222,9 +230,130 @@ void BroadcastBinomialTree(Group& net, T& value, size_t origin = 0) {
     }
 }
 
+/******************************************************************************/
+// Topology-Aware Algorithms
+
+/*!
+ * Broadcasts the value from index 0 to a subset of count hosts along a binomial
+ * tree, in which index i is the host host_of(i).
+ */
+template <typename T, typename HostOf>
+static inline
+void BroadcastSubset(Group& net, T& value, size_t my_index, size_t count,
+                     const HostOf& host_of) {
+    size_t d = 1;
+    if (my_index > 0) {
+        d <<= common::ffs(my_index) - 1;
+        net.ReceiveFrom(host_of(my_index ^ d), &value);
+    }
+    else {
+        d = common::RoundUpToPowerOfTwo(count);
+    }
+    for (d >>= 1; d > 0; d >>= 1) {
+        if (my_index + d < count)
+            net.SendTo(host_of(my_index + d), value);
+    }
+}
+
+/*!
+ * Reduces the values of a subset of count hosts to index 0 along a binomial
+ * tree, in which index i is the host host_of(i). The values are reduced in
+ * index order.
+ */
+template <typename T, typename HostOf, typename BinarySumOp>
+static inline
+void ReduceSubset(Group& net, T& value, size_t my_index, size_t count,
+                  const HostOf& host_of, BinarySumOp sum_op) {
+    for (size_t d = 1; d < count; d <<= 1) {
+        if (my_index & d) {
+            net.SendTo(host_of(my_index - d), value);
+            break;
+        }
+        else if (my_index + d < count) {
+            T recv_data;
+            net.ReceiveFrom(host_of(my_index + d), &recv_data);
+            value = sum_op(value, recv_data);
+        }
+    }
+}
+
+/*!
+ * Broadcasts the value of the worker with index "origin" to all others using
+ * the racks of the group: the origin sends to the first hosts of all other
+ * racks, which then broadcast within their racks. Only num_racks() - 1
+ * messages cross rack boundaries.
+ *
+ * \param net The current group onto which to apply the operation
+ *
+ * \param value The value to be broadcast / receive into.
+ *
+ * \param origin The PE to broadcast value from.
+ */
+template <typename T>
+static inline
+void BroadcastTopology(Group& net, T& value, size_t origin = 0) {
+    const size_t num_racks = net.num_racks();
+    const size_t origin_rack = net.rack_of(origin);
+    const size_t my_host = net.my_host_rank();
+    const size_t rack = net.rack_of(my_host);
+    const size_t begin = net.rack_begin(rack);
+    const size_t size = net.rack_begin(rack + 1) - begin;
+
+    // the origin represents its rack, the first host all other racks.
+    auto rep = [&](size_t r) {
+                   return r == origin_rack ? origin : net.rack_begin(r);
+               };
+    const size_t shift = rep(rack) - begin;
+
+    if (my_host == rep(rack)) {
+        BroadcastSubset(
+            net, value, (rack + num_racks - origin_rack) % num_racks, num_racks,
+            [&](size_t i) { return rep((i + origin_rack) % num_racks); });
+    }
+    BroadcastSubset(
+        net, value, (my_host - begin + size - shift) % size, size,
+        [&](size_t i) { return begin + (i + shift) % size; });
+}
+
+/*!
+ * Perform an All-Reduce using the racks of the group: the values are reduced
+ * to the first host of each rack, then among these hosts, and the result is
+ * broadcast back within the racks. Only 2 (num_racks() - 1) messages cross
+ * rack boundaries. Since racks are contiguous ranges of ranks, the values are
+ * reduced in rank order.
+ *
+ * \param net The current group onto which to apply the operation
+ *
+ * \param value The value to be added to the aggregation
+ *
+ * \param sum_op A custom summation operator
+ */
+template <typename T, typename BinarySumOp = std::plus<T> >
+static inline
+void AllReduceTopology(Group& net, T& value,
+                       BinarySumOp sum_op = BinarySumOp()) {
+    const size_t my_host = net.my_host_rank();
+    const size_t rack = net.rack_of(my_host);
+    const size_t begin = net.rack_begin(rack);
+    const size_t size = net.rack_begin(rack + 1) - begin;
+
+    auto in_rack = [begin](size_t i) { return begin + i; };
+    auto leader = [&net](size_t r) { return net.rack_begin(r); };
+
+    ReduceSubset(net, value, my_host - begin, size, in_rack, sum_op);
+    if (my_host == begin) {
+        ReduceSubset(net, value, rack, net.num_racks(), leader, sum_op);
+        BroadcastSubset(net, value, rack, net.num_racks(), leader);
+    }
+    BroadcastSubset(net, value, my_host - begin, size, in_rack);
+}
+
+/******************************************************************************/
+
 /*!
  * Broadcasts the value of the worker with index 0 to all the others. This is a
- * binomial tree broadcast method.
+ * binomial tree broadcast method, or BroadcastTopology() if the group has
+ * racks.
  *
  * \param net The current group onto which to apply the operation
  *
@@ -235,6 +364,8 @@ void BroadcastBinomialTree(Group& net, T& value, size_t origin = 0) {
 template <typename T>
 static inline
 void Broadcast(Group& net, T& value, size_t origin = 0) {
+    if (net.num_racks() > 1)
+        return BroadcastTopology(net, value, origin);
     return BroadcastBinomialTree(net, value, origin);
 }
 
@@ -291,7 +422,8 @@ void Reduce(Group& net, T& value, size_t root = 0,
 
 //! \brief   Perform an All-Reduce on the workers.
 //! \details This is done by aggregating all values according to a summation
-//!          operator and sending them backto all workers.
+//!          operator and sending them backto all workers. Groups with racks
+//!          use AllReduceTopology().
 //!
 //! \param   net The current group onto which to apply the operation
 //! \param   value The value to be added to the aggregation
@@ -299,6 +431,8 @@ void Reduce(Group& net, T& value, size_t root = 0,
 template <typename T, typename BinarySumOp = std::plus<T> >
 static inline
 void AllReduce(Group& net, T& value, BinarySumOp sum_op = BinarySumOp()) {
+    if (net.num_racks() > 1)
+        return AllReduceTopology(net, value, sum_op);
     Reduce(net, value, 0, sum_op);
     Broadcast(net, value, 0);
 }
@@ -321,17 +455,20 @@ void AllReduceHypercube(Group& net, T& value, BinarySumOp sum_op = BinarySumOp()
         // communication peer for this round (hypercube dimension)
         size_t peer = net.my_host_rank() ^ d;
 
-        // Send value to worker with id id ^ d
+        // Exchange values with worker id ^ d, the lower host sends first to
+        // avoid deadlocks of blocking sends of large values.
+        T recv_data;
         if (peer < net.num_hosts()) {
-            net.connection(peer).Send(value);
             sLOG << "ALL_REDUCE_HYPERCUBE: Host" << net.my_host_rank()
                  << ": Sending" << value << "to worker" << peer;
-        }
-
-        // Receive value from worker with id id ^ d
-        T recv_data;
-        if (peer < net.num_hosts()) {
-            net.connection(peer).Receive(&recv_data);
+            if (net.my_host_rank() < peer) {
+                net.connection(peer).Send(value);
+                net.connection(peer).Receive(&recv_data);
+            }
+            else {
+                net.connection(peer).Receive(&recv_data);
+                net.connection(peer).Send(value);
+            }
 
             // The order of addition is important. The total sum of the smaller
             // hypercube always comes first.
@@ -349,6 +486,218 @@ void AllReduceHypercube(Group& net, T& value, BinarySumOp sum_op = BinarySumOp()
     sLOG << "ALL_REDUCE_HYPERCUBE: value after all reduce " << value;
 }
 
+/******************************************************************************/
+// Large Message Algorithms for Vectors of Trivially Copyable Items
+
+//! vectors of at least this many bytes are transmitted using pipelined or ring
+//! algorithms instead of sending whole values along trees.
+static constexpr size_t kLargeMessageThreshold = 128 * 1024;
+
+//! size of chunks sent by pipelined broadcasts.
+static constexpr size_t kPipelineChunkSize = 32 * 1024;
+
+//! whether std::vector<T> can be sent as plain memory by large message
+//! algorithms.
+template <typename T>
+using IsLargeMessageVector = std::integral_constant<
+          bool, std::is_trivially_copyable<T>::value &&
+          !std::is_same<T, bool>::value>;
+
+/*!
+ * Broadcasts a vector from worker "origin" to all others by pipelining chunks
+ * along a chain of the workers. The vector must already have the same size on
+ * all workers. The run-time is in O((p + size / chunk_size) * chunk_size)
+ * instead of O(log p * size) for the binomial tree.
+ *
+ * \param net The current group onto which to apply the operation
+ *
+ * \param values The vector to be broadcast / receive into.
+ *
+ * \param origin The PE to broadcast values from.
+ *
+ * \param chunk_size Number of bytes to send in each pipeline step.
+ */
+template <typename T>
+static inline
+void BroadcastPipelined(Group& net, std::vector<T>& values, size_t origin = 0,
+                        size_t chunk_size = kPipelineChunkSize) {
+    static_assert(IsLargeMessageVector<T>::value,
+                  "BroadcastPipelined requires trivially copyable items");
+
+    const size_t num_hosts = net.num_hosts();
+    // rank in the chain starting at origin
+    const size_t my_rank = (net.my_host_rank() + num_hosts - origin) % num_hosts;
+
+    char* data = reinterpret_cast<char*>(values.data());
+    const size_t size = values.size() * sizeof(T);
+
+    for (size_t pos = 0; pos < size; pos += chunk_size) {
+        size_t n = std::min(chunk_size, size - pos);
+        if (my_rank > 0) {
+            net.connection((net.my_host_rank() + num_hosts - 1) % num_hosts)
+            .SyncRecv(data + pos, n);
+        }
+        if (my_rank + 1 < num_hosts) {
+            net.connection((net.my_host_rank() + 1) % num_hosts)
+            .SyncSend(data + pos, n);
+        }
+    }
+}
+
+/*!
+ * Broadcasts a vector of trivially copyable items from worker "origin" to all
+ * others. Small vectors are sent along the binomial tree, while large vectors
+ * are announced along the tree and then sent with BroadcastPipelined().
+ *
+ * \param net The current group onto which to apply the operation
+ *
+ * \param values The vector to be broadcast / receive into.
+ *
+ * \param origin The PE to broadcast values from.
+ */
+template <typename T>
+static inline
+typename std::enable_if<IsLargeMessageVector<T>::value>::type
+Broadcast(Group& net, std::vector<T>& values, size_t origin = 0) {
+    // the message contains the vector size and, for small vectors, the items.
+    std::pair<size_t, std::vector<T> > msg;
+    if (net.my_host_rank() == origin) {
+        msg.first = values.size();
+        if (values.size() * sizeof(T) < kLargeMessageThreshold ||
+            net.num_hosts() <= 2)
+            msg.second = values;
+    }
+
+    Broadcast(net, msg, origin);
+
+    if (msg.second.size() == msg.first) {
+        if (net.my_host_rank() != origin)
+            values = std::move(msg.second);
+        return;
+    }
+
+    values.resize(msg.first);
+    BroadcastPipelined(net, values, origin);
+}
+
+//! Exchange blocks with both neighbors in a ring. Even ranks send first, odd
+//! ranks receive first, which prevents a cyclic wait of blocking sends.
+template <typename T>
+static inline
+void RingExchange(Group& net, const T* send, size_t send_size,
+                  T* recv, size_t recv_size) {
+    const size_t num_hosts = net.num_hosts();
+    Connection& next = net.connection((net.my_host_rank() + 1) % num_hosts);
+    Connection& prev =
+        net.connection((net.my_host_rank() + num_hosts - 1) % num_hosts);
+
+    if (net.my_host_rank() % 2 == 0) {
+        if (send_size) next.SyncSend(send, send_size * sizeof(T));
+        if (recv_size) prev.SyncRecv(recv, recv_size * sizeof(T));
+    }
+    else {
+        if (recv_size) prev.SyncRecv(recv, recv_size * sizeof(T));
+        if (send_size) next.SyncSend(send, send_size * sizeof(T));
+    }
+}
+
+/*!
+ * Perform an All-Gather of the blocks of a vector using a ring. The vector
+ * must have the same size on all workers and is split into num_hosts() equal
+ * blocks, of which rank r owns block (r + shift) % num_hosts(). After p - 1
+ * steps, all workers contain all blocks. Each worker sends and receives only
+ * (p - 1) / p of the vector.
+ *
+ * \param net The current group onto which to apply the operation
+ *
+ * \param values The vector, containing the local block and receiving all
+ * others.
+ *
+ * \param shift Offset of the block owned by each rank.
+ */
+template <typename T>
+static inline
+void AllGatherRing(Group& net, std::vector<T>& values, size_t shift = 0) {
+    static_assert(IsLargeMessageVector<T>::value,
+                  "AllGatherRing requires trivially copyable items");
+
+    const size_t num_hosts = net.num_hosts();
+    const size_t my_rank = net.my_host_rank();
+    auto begin = [&](size_t b) { return b * values.size() / num_hosts; };
+
+    for (size_t s = 0; s + 1 < num_hosts; ++s) {
+        // forward the block received in the previous step.
+        size_t send_block = (my_rank + shift + num_hosts - s) % num_hosts;
+        size_t recv_block = (my_rank + shift + num_hosts - s - 1) % num_hosts;
+
+        RingExchange(net,
+                     values.data() + begin(send_block),
+                     begin(send_block + 1) - begin(send_block),
+                     values.data() + begin(recv_block),
+                     begin(recv_block + 1) - begin(recv_block));
+    }
+}
+
+/*!
+ * Perform an elementwise All-Reduce on vectors of trivially copyable
+ * items. The vectors must have the same size on all workers. Small vectors are
+ * reduced using AllReduce(). Large vectors are reduced bandwidth-optimally by
+ * a ring reduce-scatter followed by a ring all-gather, in which each worker
+ * sends and receives only 2 (p - 1) / p of the vector. The reduction order of
+ * items differs between workers, hence sum_op must be commutative.
+ *
+ * \param net The current group onto which to apply the operation
+ *
+ * \param values The vector to reduce, will be overwritten with the result.
+ *
+ * \param sum_op A commutative reduction operator on the items
+ */
+template <typename T, typename BinarySumOp = std::plus<T> >
+static inline
+void AllReduceElementwise(Group& net, std::vector<T>& values,
+                          BinarySumOp sum_op = BinarySumOp()) {
+    static_assert(IsLargeMessageVector<T>::value,
+                  "AllReduceElementwise requires trivially copyable items");
+
+    const size_t num_hosts = net.num_hosts();
+    if (num_hosts == 1) return;
+
+    if (values.size() * sizeof(T) < kLargeMessageThreshold ||
+        values.size() < num_hosts) {
+        return AllReduce(
+            net, values,
+            [&sum_op](const std::vector<T>& a, const std::vector<T>& b) {
+                std::vector<T> r(a.size());
+                for (size_t i = 0; i < a.size(); ++i)
+                    r[i] = sum_op(a[i], b[i]);
+                return r;
+            });
+    }
+
+    const size_t my_rank = net.my_host_rank();
+    auto begin = [&](size_t b) { return b * values.size() / num_hosts; };
+
+    // reduce-scatter: after p - 1 steps rank r holds the complete reduction
+    // of block (r + 1) % p.
+    std::vector<T> recv(begin(1) + 1);
+    for (size_t s = 0; s + 1 < num_hosts; ++s) {
+        size_t send_block = (my_rank + num_hosts - s) % num_hosts;
+        size_t recv_block = (my_rank + num_hosts - s - 1) % num_hosts;
+        size_t recv_size = begin(recv_block + 1) - begin(recv_block);
+
+        RingExchange(net,
+                     values.data() + begin(send_block),
+                     begin(send_block + 1) - begin(send_block),
+                     recv.data(), recv_size);
+
+        T* block = values.data() + begin(recv_block);
+        for (size_t i = 0; i < recv_size; ++i)
+            block[i] = sum_op(block[i], recv[i]);
+    }
+
+    AllGatherRing(net, values, /* shift */ 1);
+}
+
 //! \}
 
 } // namespace collective
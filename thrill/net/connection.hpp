@@ -98,6 +98,31 @@ public:
     virtual ssize_t SendOne(const void* data, size_t size,
                             Flags flags = NoFlags) = 0;
 
+    //! Non-blocking send of two successive (data,size) messages, which
+    //! network layers may gather into one system call. returns the total
+    //! number of bytes sent, the second message is only touched if the first
+    //! was sent completely. check errno for errors.
+    virtual ssize_t SendTwo(const void* data1, size_t size1,
+                            const void* data2, size_t size2) {
+        ssize_t r1 = SendOne(data1, size1, MsgMore);
+        if (r1 <= 0 || static_cast<size_t>(r1) != size1) return r1;
+        ssize_t r2 = SendOne(data2, size2);
+        return r2 <= 0 ? r1 : r1 + r2;
+    }
+
+    //! Returns whether SendFile() can transfer file data on this connection.
+    virtual bool CanSendFile() const { return false; }
+
+    //! Non-blocking send of size bytes from file descriptor fd at offset,
+    //! which network layers may transfer without copying them through user
+    //! space. returns number of bytes sent. check errno for errors, EINVAL or
+    //! ENOSYS indicate that the file cannot be sent this way.
+    virtual ssize_t SendFile(int /* fd */, uint64_t /* offset */,
+                             size_t /* size */) {
+        errno = ENOSYS;
+        return -1;
+    }
+
     //! Send any serializable item T. if sending fails, a net::Exception is
     //! thrown.
     template <typename T>
@@ -16,6 +16,7 @@
 #define THRILL_NET_DISPATCHER_HEADER
 
 #include <thrill/common/delegate.hpp>
+#include <thrill/common/latency_histogram.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/byte_block.hpp>
 #include <thrill/mem/allocator.hpp>
@@ -89,6 +90,28 @@ public:
     //! virtual destructor
     virtual ~Dispatcher() { }
 
+    /*!
+     * Statistics of the dispatcher, which the profiling thread reads while the
+     * dispatcher runs.
+     */
+    class Stats
+    {
+    public:
+        //! microseconds spent in Dispatch() and waiting for events in it
+        std::atomic<uint64_t> loop_us { 0 }, wait_us { 0 };
+
+        //! number of queued asynchronous writes
+        std::atomic<size_t> write_queue { 0 };
+
+        //! latencies of asynchronous ByteBlock reads from the header until the
+        //! block was received, and of asynchronous writes from being queued
+        //! until they were sent.
+        common::LatencyHistogram read_latency, write_latency;
+    };
+
+    //! Returns the statistics of the dispatcher
+    Stats& stats() { return stats_; }
+
     //! \name Timeout Callbacks
     //! \{
 
@@ -111,6 +134,14 @@ public:
     //! Register a buffered write callback and a default exception callback.
     virtual void AddWrite(Connection& c, const AsyncCallback& write_cb) = 0;
 
+    //! Register a buffered write callback, which runs before all callbacks on
+    //! the connection that have not started yet, but in the order of previous
+    //! urgent callbacks. Falls back to AddWrite() if the dispatcher has no
+    //! priorities.
+    virtual void AddWriteUrgent(Connection& c, const AsyncCallback& write_cb) {
+        return AddWrite(c, write_cb);
+    }
+
     //! Cancel all callbacks on a given connection.
     virtual void Cancel(Connection& c) = 0;
 
@@ -152,7 +183,8 @@ public:
         }
 
         // add new async reader object
-        async_read_block_.emplace_back(c, n, std::move(block), done_cb);
+        async_read_block_.emplace_back(
+            c, n, std::move(block), done_cb, &stats_.read_latency);
 
         // register read callback
         AsyncReadByteBlock& arbb = async_read_block_.back();
@@ -173,7 +205,8 @@ public:
         }
 
         // add new async writer object
-        async_write_.emplace_back(c, std::move(buffer), done_cb);
+        async_write_.emplace_back(
+            c, std::move(buffer), done_cb, &stats_.write_latency);
 
         // register write callback
         AsyncWriteBuffer& awb = async_write_.back();
@@ -181,6 +214,31 @@ public:
                      AsyncWriteBuffer, & AsyncWriteBuffer::operator ()>(&awb));
     }
 
+    //! asynchronously write a small control buffer ahead of the queued bulk
+    //! writes on the connection, and callback when delivered. The buffer is
+    //! MOVED into the async writer. Urgent writes must not depend on their
+    //! order relative to normal writes.
+    virtual void AsyncWriteUrgent(
+        Connection& c, Buffer&& buffer,
+        const AsyncWriteCallback& done_cb = AsyncWriteCallback()) {
+        assert(c.IsValid());
+
+        if (buffer.size() == 0) {
+            if (done_cb) done_cb(c);
+            return;
+        }
+
+        // add new async writer object
+        async_write_.emplace_back(
+            c, std::move(buffer), done_cb, &stats_.write_latency);
+
+        // register urgent write callback
+        AsyncWriteBuffer& awb = async_write_.back();
+        AddWriteUrgent(
+            c, AsyncCallback::make<
+                AsyncWriteBuffer, & AsyncWriteBuffer::operator ()>(&awb));
+    }
+
     //! asynchronously write buffer and callback when delivered. The buffer is
     //! MOVED into the async writer.
     virtual void AsyncWrite(
@@ -194,7 +252,30 @@ public:
         }
 
         // add new async writer object
-        async_write_block_.emplace_back(c, block, done_cb);
+        async_write_block_.emplace_back(
+            c, Buffer(), block, done_cb, &stats_.write_latency);
+
+        // register write callback
+        AsyncWriteBlock& awb = async_write_block_.back();
+        AddWrite(c, AsyncCallback::make<
+                     AsyncWriteBlock, & AsyncWriteBlock::operator ()>(&awb));
+    }
+
+    //! asynchronously write a header buffer followed by a block, and callback
+    //! when both are delivered. The buffer is MOVED into the async writer. Both
+    //! are gathered into the same send calls, such that no separate packet or
+    //! system call is needed for the header.
+    virtual void AsyncWrite(
+        Connection& c, Buffer&& buffer, const data::PinnedBlock& block,
+        const AsyncWriteCallback& done_cb = AsyncWriteCallback()) {
+        assert(c.IsValid());
+
+        if (block.size() == 0)
+            return AsyncWrite(c, std::move(buffer), done_cb);
+
+        // add new async writer object
+        async_write_block_.emplace_back(
+            c, std::move(buffer), block, done_cb, &stats_.write_latency);
 
         // register write callback
         AsyncWriteBlock& awb = async_write_block_.back();
@@ -202,6 +283,31 @@ public:
                      AsyncWriteBlock, & AsyncWriteBlock::operator ()>(&awb));
     }
 
+    //! asynchronously write a header buffer followed by the data of a Block
+    //! backed by an external file, and callback when both are delivered. The
+    //! data is transferred directly from the file with Connection::SendFile(),
+    //! hence the Block is not pinned into memory. The buffer is MOVED into the
+    //! async writer.
+    virtual void AsyncWriteFile(
+        Connection& c, Buffer&& buffer, const data::Block& block,
+        const AsyncWriteCallback& done_cb = AsyncWriteCallback()) {
+        assert(c.IsValid());
+        assert(c.CanSendFile());
+
+        if (block.size() == 0)
+            return AsyncWrite(c, std::move(buffer), done_cb);
+
+        // add new async writer object
+        async_write_file_.emplace_back(
+            c, std::move(buffer), block, done_cb, &stats_.write_latency);
+
+        // register write callback
+        AsyncWriteFileBlock& awf = async_write_file_.back();
+        AddWrite(c, AsyncCallback::make<
+                     AsyncWriteFileBlock,
+                     & AsyncWriteFileBlock::operator ()>(&awf));
+    }
+
     //! asynchronously write buffer and callback when delivered. COPIES the data
     //! into a Buffer!
     void AsyncWriteCopy(
@@ -227,6 +333,8 @@ public:
     void Dispatch() {
         // process timer events that lie in the past
         steady_clock::time_point now = steady_clock::now();
+        const steady_clock::time_point begin = now;
+        UpdateWriteQueue();
 
         while (!terminate_ &&
                !timer_pq_.empty() &&
@@ -272,6 +380,14 @@ public:
         while (async_write_block_.size() && async_write_block_.front().IsDone()) {
             async_write_block_.pop_front();
         }
+        while (async_write_file_.size() && async_write_file_.front().IsDone()) {
+            async_write_file_.pop_front();
+        }
+
+        UpdateWriteQueue();
+        stats_.loop_us += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                steady_clock::now() - begin).count());
     }
 
     //! Loop over Dispatch() until terminate_ flag is set.
@@ -293,7 +409,8 @@ public:
 
     //! Check whether there are still AsyncWrite()s in the queue.
     bool HasAsyncWrites() const {
-        return (async_write_.size() != 0) || (async_write_block_.size() != 0);
+        return (async_write_.size() != 0) || (async_write_block_.size() != 0) ||
+               (async_write_file_.size() != 0);
     }
 
     //! \}
@@ -301,6 +418,23 @@ public:
 protected:
     virtual void DispatchOne(const std::chrono::milliseconds& timeout) = 0;
 
+    //! Adds the time spent waiting for events since begin, called by
+    //! DispatchOne() implementations around their blocking call.
+    void AddWaitTime(const steady_clock::time_point& begin) {
+        stats_.wait_us += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                steady_clock::now() - begin).count());
+    }
+
+    //! Stores the number of queued asynchronous writes in the statistics.
+    void UpdateWriteQueue() {
+        stats_.write_queue = async_write_.size() + async_write_block_.size()
+                             + async_write_file_.size();
+    }
+
+    //! statistics of the dispatcher
+    Stats stats_;
+
     //! true if dispatcher needs to stop
     std::atomic<bool> terminate_ { false };
 
@@ -352,33 +486,36 @@ protected:
 
         //! Should be called when the socket is readable
         bool operator () () {
-            ssize_t r = conn_->RecvOne(
-                buffer_.data() + size_, buffer_.size() - size_);
-
-            if (r <= 0) {
-                // these errors are acceptable: just redo the recv later.
-                if (errno == EINTR || errno == EAGAIN) return true;
+            // transfer until done or the socket would block, which is
+            // required for edge-triggered readiness notification.
+            while (true) {
+                ssize_t r = conn_->RecvOne(
+                    buffer_.data() + size_, buffer_.size() - size_);
+
+                if (r <= 0) {
+                    // interrupted by a signal: retry right away.
+                    if (errno == EINTR) continue;
+                    // socket drained: redo the recv when it is readable again.
+                    if (errno == EAGAIN) return true;
+
+                    // signal artificial IsDone, for clean up.
+                    size_ = buffer_.size();
+
+                    // these errors are end-of-file indications (good and bad)
+                    if (errno == 0 || errno == EPIPE || errno == ECONNRESET) {
+                        if (callback_) callback_(*conn_, Buffer());
+                        return false;
+                    }
+                    throw Exception("AsyncReadBuffer() error in recv() on "
+                                    "connection " + conn_->ToString(), errno);
+                }
 
-                // signal artificial IsDone, for clean up.
-                size_ = buffer_.size();
+                size_ += r;
 
-                // these errors are end-of-file indications (both good and bad)
-                if (errno == 0 || errno == EPIPE || errno == ECONNRESET) {
-                    if (callback_) callback_(*conn_, Buffer());
+                if (size_ == buffer_.size()) {
+                    DoCallback();
                     return false;
                 }
-                throw Exception("AsyncReadBuffer() error in recv() on "
-                                "connection " + conn_->ToString(), errno);
-            }
-
-            size_ += r;
-
-            if (size_ == buffer_.size()) {
-                DoCallback();
-                return false;
-            }
-            else {
-                return true;
             }
         }
 
@@ -417,45 +554,52 @@ protected:
         //! Construct buffered writer with callback
         AsyncWriteBuffer(Connection& conn,
                          Buffer&& buffer,
-                         const AsyncWriteCallback& callback)
+                         const AsyncWriteCallback& callback,
+                         common::LatencyHistogram* latency = nullptr)
             : conn_(&conn),
               buffer_(std::move(buffer)),
-              callback_(callback)
+              callback_(callback),
+              latency_(latency)
         { }
 
         //! Should be called when the socket is writable
         bool operator () () {
-            ssize_t r = conn_->SendOne(
-                buffer_.data() + size_, buffer_.size() - size_);
-
-            if (r <= 0) {
-                if (errno == EINTR || errno == EAGAIN) return true;
+            // transfer until done or the socket would block, which is
+            // required for edge-triggered readiness notification.
+            while (true) {
+                ssize_t r = conn_->SendOne(
+                    buffer_.data() + size_, buffer_.size() - size_);
+
+                if (r <= 0) {
+                    // interrupted by a signal: retry right away.
+                    if (errno == EINTR) continue;
+                    // send buffer full: continue when it is writable again.
+                    if (errno == EAGAIN) return true;
+
+                    // signal artificial IsDone, for clean up.
+                    size_ = buffer_.size();
+
+                    if (errno == EPIPE) {
+                        LOG1 << "AsyncWriteBuffer() got SIGPIPE";
+                        DoCallback();
+                        return false;
+                    }
+                    throw Exception("AsyncWriteBuffer() error in send", errno);
+                }
 
-                // signal artificial IsDone, for clean up.
-                size_ = buffer_.size();
+                size_ += r;
 
-                if (errno == EPIPE) {
-                    LOG1 << "AsyncWriteBuffer() got SIGPIPE";
+                if (size_ == buffer_.size()) {
                     DoCallback();
                     return false;
                 }
-                throw Exception("AsyncWriteBuffer() error in send", errno);
-            }
-
-            size_ += r;
-
-            if (size_ == buffer_.size()) {
-                DoCallback();
-                return false;
-            }
-            else {
-                return true;
             }
         }
 
         bool IsDone() const { return size_ == buffer_.size(); }
 
         void DoCallback() {
+            if (latency_) latency_->AddSince(start_);
             if (callback_) callback_(*conn_);
         }
 
@@ -471,6 +615,11 @@ protected:
 
         //! functional object to call once data is complete
         AsyncWriteCallback callback_;
+
+        //! histogram to add the latency to, and start time
+        common::LatencyHistogram* latency_;
+        std::chrono::steady_clock::time_point start_ =
+            std::chrono::steady_clock::now();
     };
 
     //! deque of asynchronous writers
@@ -485,41 +634,46 @@ protected:
         //! Construct block reader with callback
         AsyncReadByteBlock(Connection& conn, size_t size,
                            data::PinnedByteBlockPtr&& block,
-                           const AsyncReadByteBlockCallback& callback)
+                           const AsyncReadByteBlockCallback& callback,
+                           common::LatencyHistogram* latency = nullptr)
             : conn_(&conn),
               block_(std::move(block)),
               size_(size),
-              callback_(callback)
+              callback_(callback),
+              latency_(latency)
         { }
 
         //! Should be called when the socket is readable
         bool operator () () {
-            ssize_t r = conn_->RecvOne(
-                block_->data() + pos_, size_ - pos_);
-
-            if (r <= 0) {
-                // these errors are acceptable: just redo the recv later.
-                if (errno == EINTR || errno == EAGAIN) return true;
+            // transfer until done or the socket would block, which is
+            // required for edge-triggered readiness notification.
+            while (true) {
+                ssize_t r = conn_->RecvOne(
+                    block_->data() + pos_, size_ - pos_);
+
+                if (r <= 0) {
+                    // interrupted by a signal: retry right away.
+                    if (errno == EINTR) continue;
+                    // socket drained: redo the recv when it is readable again.
+                    if (errno == EAGAIN) return true;
+
+                    // signal artificial IsDone, for clean up.
+                    pos_ = size_;
+
+                    // these errors are end-of-file indications (good and bad)
+                    if (errno == 0 || errno == EPIPE || errno == ECONNRESET) {
+                        DoCallback();
+                        return false;
+                    }
+                    throw Exception("AsyncReadBlock() error in recv", errno);
+                }
 
-                // signal artificial IsDone, for clean up.
-                pos_ = size_;
+                pos_ += r;
 
-                // these errors are end-of-file indications (both good and bad)
-                if (errno == 0 || errno == EPIPE || errno == ECONNRESET) {
+                if (pos_ == size_) {
                     DoCallback();
                     return false;
                 }
-                throw Exception("AsyncReadBlock() error in recv", errno);
-            }
-
-            pos_ += r;
-
-            if (pos_ == size_) {
-                DoCallback();
-                return false;
-            }
-            else {
-                return true;
             }
         }
 
@@ -531,6 +685,7 @@ protected:
         data::PinnedByteBlockPtr& byte_block() { return block_; }
 
         void DoCallback() {
+            if (latency_) latency_->AddSince(start_);
             if (callback_) callback_(*conn_, std::move(block_));
         }
 
@@ -549,6 +704,11 @@ protected:
 
         //! functional object to call once data is complete
         AsyncReadByteBlockCallback callback_;
+
+        //! histogram to add the latency to, and start time
+        common::LatencyHistogram* latency_;
+        std::chrono::steady_clock::time_point start_ =
+            std::chrono::steady_clock::now();
     };
 
     //! deque of asynchronous readers
@@ -560,48 +720,66 @@ protected:
     class AsyncWriteBlock
     {
     public:
-        //! Construct block writer with callback
+        //! Construct block writer with an optional header and callback
         AsyncWriteBlock(Connection& conn,
+                        Buffer&& header,
                         const data::PinnedBlock& block,
-                        const AsyncWriteCallback& callback)
+                        const AsyncWriteCallback& callback,
+                        common::LatencyHistogram* latency = nullptr)
             : conn_(&conn),
+              header_(std::move(header)),
               block_(block),
-              callback_(callback)
+              callback_(callback),
+              latency_(latency)
         { }
 
         //! Should be called when the socket is writable
         bool operator () () {
-            ssize_t r = conn_->SendOne(
-                block_.data_begin() + size_, block_.size() - size_);
+            // transfer until done or the socket would block, which is
+            // required for edge-triggered readiness notification.
+            while (true) {
+                ssize_t r;
+                if (size_ < header_.size()) {
+                    r = conn_->SendTwo(
+                        header_.data() + size_, header_.size() - size_,
+                        block_.data_begin(), block_.size());
+                }
+                else {
+                    r = conn_->SendOne(
+                        block_.data_begin() + (size_ - header_.size()),
+                        total_size() - size_);
+                }
 
-            if (r <= 0) {
-                if (errno == EINTR || errno == EAGAIN) return true;
+                if (r <= 0) {
+                    // interrupted by a signal: retry right away.
+                    if (errno == EINTR) continue;
+                    // send buffer full: continue when it is writable again.
+                    if (errno == EAGAIN) return true;
+
+                    // signal artificial IsDone, for clean up.
+                    size_ = total_size();
+
+                    if (errno == EPIPE) {
+                        LOG1 << "AsyncWriteBlock() got SIGPIPE";
+                        DoCallback();
+                        return false;
+                    }
+                    throw Exception("AsyncWriteBlock() error in send", errno);
+                }
 
-                // signal artificial IsDone, for clean up.
-                size_ = block_.size();
+                size_ += r;
 
-                if (errno == EPIPE) {
-                    LOG1 << "AsyncWriteBlock() got SIGPIPE";
+                if (size_ == total_size()) {
                     DoCallback();
                     return false;
                 }
-                throw Exception("AsyncWriteBlock() error in send", errno);
-            }
-
-            size_ += r;
-
-            if (size_ == block_.size()) {
-                DoCallback();
-                return false;
-            }
-            else {
-                return true;
             }
         }
 
-        bool IsDone() const { return size_ == block_.size(); }
+        bool IsDone() const { return size_ == total_size(); }
 
         void DoCallback() {
+            if (latency_) latency_->AddSince(start_);
             if (callback_) callback_(*conn_);
         }
 
@@ -609,14 +787,25 @@ protected:
         //! Connection reference
         Connection* conn_;
 
+        //! Header sent before the block, may be empty (owned by this writer)
+        Buffer header_;
+
         //! Send block (holds a pin on the underlying ByteBlock)
         data::PinnedBlock block_;
 
+        //! total size of header and block
+        size_t total_size() const { return header_.size() + block_.size(); }
+
         //! total size currently written
         size_t size_ = 0;
 
         //! functional object to call once data is complete
         AsyncWriteCallback callback_;
+
+        //! histogram to add the latency to, and start time
+        common::LatencyHistogram* latency_;
+        std::chrono::steady_clock::time_point start_ =
+            std::chrono::steady_clock::now();
     };
 
     //! deque of asynchronous writers
@@ -625,6 +814,111 @@ protected:
 
     /**************************************************************************/
 
+    class AsyncWriteFileBlock
+    {
+    public:
+        //! Construct file block writer with a header and callback
+        AsyncWriteFileBlock(Connection& conn,
+                            Buffer&& header,
+                            const data::Block& block,
+                            const AsyncWriteCallback& callback,
+                            common::LatencyHistogram* latency = nullptr)
+            : conn_(&conn),
+              header_(std::move(header)),
+              block_(block),
+              fd_(block.byte_block()->ext_file()->native_fd()),
+              offset_(block.byte_block()->ext_file_offset() + block.begin()),
+              callback_(callback),
+              latency_(latency) {
+            assert(fd_ >= 0);
+        }
+
+        //! Should be called when the socket is writable
+        bool operator () () {
+            // transfer until done or the socket would block, which is
+            // required for edge-triggered readiness notification.
+            while (true) {
+                ssize_t r;
+                if (size_ < header_.size()) {
+                    r = conn_->SendOne(
+                        header_.data() + size_, header_.size() - size_,
+                        Connection::MsgMore);
+                }
+                else {
+                    r = conn_->SendFile(
+                        fd_, offset_ + (size_ - header_.size()),
+                        total_size() - size_);
+                }
+
+                if (r <= 0) {
+                    // interrupted by a signal: retry right away.
+                    if (errno == EINTR) continue;
+                    // send buffer full: continue when it is writable again.
+                    if (errno == EAGAIN) return true;
+
+                    // signal artificial IsDone, for clean up.
+                    size_ = total_size();
+
+                    if (errno == EPIPE) {
+                        LOG1 << "AsyncWriteFileBlock() got SIGPIPE";
+                        DoCallback();
+                        return false;
+                    }
+                    throw Exception(
+                              "AsyncWriteFileBlock() error in send", errno);
+                }
+
+                size_ += r;
+
+                if (size_ == total_size()) {
+                    DoCallback();
+                    return false;
+                }
+            }
+        }
+
+        bool IsDone() const { return size_ == total_size(); }
+
+        void DoCallback() {
+            if (latency_) latency_->AddSince(start_);
+            if (callback_) callback_(*conn_);
+        }
+
+    private:
+        //! Connection reference
+        Connection* conn_;
+
+        //! Header sent before the block (owned by this writer)
+        Buffer header_;
+
+        //! Send block, unpinned (holds a reference on the external file)
+        data::Block block_;
+
+        //! file descriptor and offset of the block's data
+        int fd_;
+        uint64_t offset_;
+
+        //! total size of header and block
+        size_t total_size() const { return header_.size() + block_.size(); }
+
+        //! total size currently written
+        size_t size_ = 0;
+
+        //! functional object to call once data is complete
+        AsyncWriteCallback callback_;
+
+        //! histogram to add the latency to, and start time
+        common::LatencyHistogram* latency_;
+        std::chrono::steady_clock::time_point start_ =
+            std::chrono::steady_clock::now();
+    };
+
+    //! deque of asynchronous file block writers
+    std::deque<AsyncWriteFileBlock,
+               mem::GPoolAllocator<AsyncWriteFileBlock> > async_write_file_;
+
+    /**************************************************************************/
+
     //! Default exception handler
     static bool ExceptionCallback(Connection& c) {
         // exception on listen socket ?
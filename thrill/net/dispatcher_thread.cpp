@@ -8,6 +8,7 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/common/numa.hpp>
 #include <thrill/net/dispatcher.hpp>
 #include <thrill/net/dispatcher_thread.hpp>
 #include <thrill/net/group.hpp>
@@ -40,6 +41,10 @@ DispatcherThread::~DispatcherThread() {
 }
 
 //! Terminate the dispatcher thread (if now already done).
+Dispatcher& DispatcherThread::dispatcher() {
+    return *dispatcher_;
+}
+
 void DispatcherThread::Terminate() {
     if (terminate_) return;
 
@@ -126,8 +131,32 @@ void DispatcherThread::AsyncWrite(
     // the following captures the move-only buffer in a lambda.
     Enqueue([=, &c,
               b1 = std::move(buffer), b2 = block]() mutable {
-                dispatcher_->AsyncWrite(c, std::move(b1));
-                dispatcher_->AsyncWrite(c, b2, done_cb);
+                dispatcher_->AsyncWrite(c, std::move(b1), b2, done_cb);
+            });
+    WakeUpThread();
+}
+
+//! asynchronously write a small control buffer ahead of the queued bulk
+//! writes on the connection, and callback when delivered.
+void DispatcherThread::AsyncWriteUrgent(
+    Connection& c, Buffer&& buffer, AsyncWriteCallback done_cb) {
+    // the following captures the move-only buffer in a lambda.
+    Enqueue([=, &c, b = std::move(buffer)]() mutable {
+                dispatcher_->AsyncWriteUrgent(c, std::move(b), done_cb);
+            });
+    WakeUpThread();
+}
+
+//! asynchronously write a header buffer and the unpinned block from its
+//! external file with Connection::SendFile(), and callback when delivered.
+void DispatcherThread::AsyncWriteFile(
+    Connection& c, Buffer&& buffer, const data::Block& block,
+    AsyncWriteCallback done_cb) {
+    assert(block.IsValid());
+    // the following captures the move-only buffer in a lambda.
+    Enqueue([=, &c,
+              b1 = std::move(buffer), b2 = block]() mutable {
+                dispatcher_->AsyncWriteFile(c, std::move(b1), b2, done_cb);
             });
     WakeUpThread();
 }
@@ -155,6 +184,7 @@ void DispatcherThread::Enqueue(Job&& job) {
 //! What happens in the dispatcher thread
 void DispatcherThread::Work() {
     common::NameThisThread(name_);
+    common::PinServiceThread();
 
     while (!terminate_ ||
            dispatcher_->HasAsyncWrites() || !jobqueue_.empty())
@@ -15,7 +15,7 @@
 #ifndef THRILL_NET_DISPATCHER_THREAD_HEADER
 #define THRILL_NET_DISPATCHER_THREAD_HEADER
 
-#include <thrill/common/concurrent_queue.hpp>
+#include <thrill/common/mpsc_queue.hpp>
 #include <thrill/common/delegate.hpp>
 #include <thrill/common/thread_pool.hpp>
 #include <thrill/data/block.hpp>
@@ -81,6 +81,9 @@ public:
     //! Terminate the dispatcher thread (if now already done).
     void Terminate();
 
+    //! Enclosed dispatcher, only for reading its Stats from other threads.
+    class Dispatcher& dispatcher();
+
     // *** note that callbacks are passed by value, because they must be copied
     // *** into the closured by the methods. -tb
 
@@ -129,6 +132,17 @@ public:
                     Buffer&& buffer, const data::PinnedBlock& block,
                     AsyncWriteCallback done_cb = AsyncWriteCallback());
 
+    //! asynchronously write a small control buffer ahead of the queued bulk
+    //! writes on the connection, and callback when delivered.
+    void AsyncWriteUrgent(Connection& c, Buffer&& buffer,
+                          AsyncWriteCallback done_cb = AsyncWriteCallback());
+
+    //! asynchronously write a header buffer and the unpinned block from its
+    //! external file with Connection::SendFile(), and callback when delivered.
+    void AsyncWriteFile(Connection& c,
+                        Buffer&& buffer, const data::Block& block,
+                        AsyncWriteCallback done_cb = AsyncWriteCallback());
+
     //! asynchronously write buffer and callback when delivered. COPIES the data
     //! into a Buffer!
     void AsyncWriteCopy(
@@ -158,7 +172,7 @@ private:
     mem::Manager mem_manager_;
 
     //! Queue of jobs to be run by dispatching thread at its discretion.
-    common::ConcurrentQueue<Job, mem::Allocator<Job> > jobqueue_ {
+    common::MpscQueue<Job, mem::Allocator<Job> > jobqueue_ {
         mem::Allocator<Job>(mem_manager_)
     };
 
@@ -16,14 +16,23 @@
 #include <thrill/common/defines.hpp>
 #include <thrill/common/functional.hpp>
 #include <thrill/common/thread_barrier.hpp>
+#include <thrill/common/thread_pool.hpp>
 #include <thrill/net/collective.hpp>
 #include <thrill/net/group.hpp>
 
 #include <algorithm>
+#include <array>
 #include <condition_variable>
+#include <cstring>
+#include <exception>
 #include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -81,6 +90,9 @@ private:
         //! atomic generation counter, compare this to generation_.
         std::atomic<size_t>     counter { 0 };
 
+        //! step of the last inline collective for which value is set.
+        std::atomic<size_t>     inline_step { 0 };
+
 #if THRILL_HAVE_THREAD_SANITIZER
         // workarounds because ThreadSanitizer has false-positives work with
         // generation counters.
@@ -114,6 +126,18 @@ private:
         }
 
         //! \}
+
+        //! spin and then yield until inline_step reaches this_step.
+        void WaitInlineStep(size_t this_step) {
+            for (size_t i = 0;
+                 inline_step.load(std::memory_order_acquire) != this_step; ++i) {
+                if (i >= 16384) std::this_thread::yield();
+            }
+        }
+
+        //! value of small types in inline collectives, in its own cache line.
+        alignas(common::g_cache_line_size)
+        unsigned char           value[common::g_cache_line_size];
     };
 
     static_assert(sizeof(LocalData) % common::g_cache_line_size == 0,
@@ -122,12 +146,29 @@ private:
     //! for access to struct LocalData
     friend class FlowControlChannelManager;
 
+    //! Host-global state of asynchronous collectives: the values of pending
+    //! operations and a single thread which performs them in order.
+    struct AsyncState
+    {
+        //! mutex protecting jobs
+        std::mutex                               mutex;
+
+        //! jobs by async step which await local threads, type-erased.
+        std::map<size_t, std::shared_ptr<void> > jobs;
+
+        //! thread performing the collectives over the Group in order.
+        common::ThreadPool                       pool { 1 };
+    };
+
     //! The global shared local data memory location to work upon.
     LocalData* shmem_;
 
     //! Host-global shared generation counter
     std::atomic<size_t>& generation_;
 
+    //! Host-global state of asynchronous collectives
+    AsyncState& async_;
+
     //! \name Pointer Casting
     //! \{
 
@@ -154,18 +195,117 @@ private:
 
     //! \}
 
+    //! \name Inline Collectives
+    //! \{
+
+    //! Inline collectives copy values of small trivial types into the LocalData
+    //! of the threads and signal them via per-thread steps, which needs no
+    //! ThreadBarrier and no pointers into other threads' stacks. Thread 0
+    //! writes only after receiving all values of the step, hence no thread can
+    //! overwrite a value which another has not read yet.
+    template <typename T>
+    using IsInline = std::integral_constant<
+              bool, std::is_trivially_copyable<T>::value&&
+              std::is_default_constructible<T>::value&&
+              sizeof(T) <= common::g_cache_line_size>;
+
+    //! number of inline collectives performed, equal on all threads.
+    size_t inline_step_ = 0;
+
+    template <typename T>
+    void PutInline(size_t idx, const T& v) {
+        std::memcpy(shmem_[idx].value, &v, sizeof(T));
+    }
+
+    template <typename T>
+    T GetInline(size_t idx) {
+        T v;
+        std::memcpy(&v, shmem_[idx].value, sizeof(T));
+        return v;
+    }
+
+    //! \}
+
+    //! \name Asynchronous Collectives
+    //! \{
+
+    //! Values and results of an asynchronous collective of all local threads.
+    template <typename T>
+    struct AsyncJob
+    {
+        explicit AsyncJob(size_t thread_count)
+            : values(thread_count), promises(thread_count) { }
+
+        std::vector<T>                values;
+        std::vector<std::promise<T> > promises;
+        size_t                        arrived = 0;
+    };
+
+    //! number of asynchronous collectives started, equal on all threads.
+    size_t async_step_ = 0;
+
+    /*!
+     * Deposit the value of this thread for the next asynchronous collective
+     * and return a future of its result. The last arriving thread enqueues the
+     * job, which calls operation(values) to replace the values of all threads
+     * with their results, into AsyncState's thread. Enqueuing happens under the
+     * mutex, hence jobs run in the same order on all hosts.
+     */
+    template <typename T, typename Operation>
+    std::future<T> StartAsync(const T& value, const Operation& operation) {
+        size_t step = ++async_step_;
+
+        std::unique_lock<std::mutex> lock(async_.mutex);
+        std::shared_ptr<void>& slot = async_.jobs[step];
+        if (!slot) slot = std::make_shared<AsyncJob<T> >(thread_count_);
+
+        std::shared_ptr<AsyncJob<T> > job =
+            std::static_pointer_cast<AsyncJob<T> >(slot);
+        job->values[local_id_] = value;
+        std::future<T> future = job->promises[local_id_].get_future();
+
+        if (++job->arrived == thread_count_) {
+            async_.jobs.erase(step);
+            async_.pool.Enqueue(
+                [job, operation]() {
+                    try {
+                        operation(job->values);
+                        for (size_t i = 0; i < job->values.size(); ++i)
+                            job->promises[i].set_value(std::move(job->values[i]));
+                    }
+                    catch (...) {
+                        for (std::promise<T>& p : job->promises)
+                            p.set_exception(std::current_exception());
+                    }
+                });
+        }
+        return future;
+    }
+
+    //! Wait until all asynchronous collectives started by this thread are
+    //! done, since they use the Group, and return it.
+    Group& SyncGroup() {
+        while (async_.pool.done() < async_step_)
+            std::this_thread::yield();
+        return group_;
+    }
+
+    //! \}
+
 public:
     //! Creates a new instance of this class, wrapping a group.
     FlowControlChannel(Group& group,
                        size_t local_id, size_t thread_count,
                        common::ThreadBarrier& barrier,
                        LocalData* shmem,
-                       std::atomic<size_t>& generation)
+                       std::atomic<size_t>& generation,
+                       AsyncState& async)
         : group_(group),
           host_rank_(group_.my_host_rank()), num_hosts_(group_.num_hosts()),
           local_id_(local_id),
           thread_count_(thread_count),
-          barrier_(barrier), shmem_(shmem), generation_(generation) { }
+          barrier_(barrier), shmem_(shmem), generation_(generation),
+          async_(async) { }
 
     //! Return the associated net::Group. USE AT YOUR OWN RISK.
     Group& group() { return group_; }
@@ -204,6 +344,63 @@ public:
     PrefixSum(const T& value, const T& initial = T(),
               const BinarySumOp& sum_op = BinarySumOp(),
               bool inclusive = true) {
+        return PrefixSum(value, initial, sum_op, inclusive, IsInline<T>());
+    }
+
+private:
+    //! PrefixSum of small trivial types via inline values: thread 0 gathers
+    //! the values, calculates the prefix sums, and writes them back.
+    template <typename T, typename BinarySumOp>
+    T PrefixSum(const T& value, const T& initial, const BinarySumOp& sum_op,
+                bool inclusive, std::true_type /* inline */) {
+
+        size_t step = ++inline_step_;
+
+        if (local_id_ != 0) {
+            PutInline(local_id_, value);
+            shmem_[local_id_].inline_step.store(step, std::memory_order_release);
+            shmem_[0].WaitInlineStep(step);
+            return GetInline<T>(local_id_);
+        }
+
+        for (size_t i = 1; i < thread_count_; i++) {
+            shmem_[i].WaitInlineStep(step);
+        }
+
+        // Local inclusive prefix sums
+        PutInline(0, value);
+        for (size_t i = 1; i < thread_count_; i++) {
+            PutInline(i, sum_op(GetInline<T>(i - 1), GetInline<T>(i)));
+        }
+
+        T base_sum = GetInline<T>(thread_count_ - 1);
+        SyncGroup().PrefixSum(base_sum, sum_op, false);
+
+        if (host_rank_ == 0) {
+            base_sum = initial;
+        }
+
+        if (inclusive) {
+            for (size_t i = 0; i < thread_count_; i++) {
+                PutInline(i, sum_op(base_sum, GetInline<T>(i)));
+            }
+        }
+        else {
+            for (size_t i = thread_count_ - 1; i > 0; i--) {
+                PutInline(i, sum_op(base_sum, GetInline<T>(i - 1)));
+            }
+            PutInline(0, base_sum);
+        }
+
+        T result = GetInline<T>(0);
+        shmem_[0].inline_step.store(step, std::memory_order_release);
+        return result;
+    }
+
+    //! PrefixSum of other types via pointers to the threads' values.
+    template <typename T, typename BinarySumOp>
+    T PrefixSum(const T& value, const T& initial, const BinarySumOp& sum_op,
+                bool inclusive, std::false_type /* inline */) {
 
         static constexpr bool debug = false;
 
@@ -234,7 +431,7 @@ public:
             }
 
             T base_sum = *(locals[thread_count_ - 1]);
-            group_.PrefixSum(base_sum, sum_op, false);
+            SyncGroup().PrefixSum(base_sum, sum_op, false);
 
             if (host_rank_ == 0) {
                 base_sum = initial;
@@ -266,6 +463,7 @@ public:
         return local_value;
     }
 
+public:
     /*!
      * Calculates the exclusive prefix sum over all workers, given a certain sum
      * operation.
@@ -287,6 +485,67 @@ public:
         return PrefixSum(value, initial, sum_op, false);
     }
 
+    /*!
+     * Starts calculating the prefix sum over all workers like PrefixSum(), but
+     * returns immediately with a future of the result. The collective is
+     * performed by a background thread once all local workers have started
+     * it, hence the worker can overlap it with local computation.
+     *
+     * All workers must start the same sequence of collectives, synchronous
+     * collectives wait for the asynchronous ones started before them to finish.
+     *
+     * \param value The local value of this worker.
+     * \param initial The initial element for the body defined by T and sum_op
+     * \param sum_op The operation to use for
+     * calculating the prefix sum. The default operation is a normal addition.
+     * \param inclusive Whether the prefix sum is inclusive or exclusive.
+     * \return A future of the prefix sum for the position of this worker.
+     */
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    std::future<T>
+    PrefixSumAsync(const T& value, const T& initial = T(),
+                   const BinarySumOp& sum_op = BinarySumOp(),
+                   bool inclusive = true) {
+        return StartAsync(
+            value, [this, initial, sum_op, inclusive](std::vector<T>& values) {
+                // Local inclusive prefix sums
+                for (size_t i = 1; i < values.size(); i++) {
+                    values[i] = sum_op(values[i - 1], values[i]);
+                }
+
+                T base_sum = values.back();
+                group_.PrefixSum(base_sum, sum_op, false);
+
+                if (host_rank_ == 0) {
+                    base_sum = initial;
+                }
+
+                if (inclusive) {
+                    for (size_t i = 0; i < values.size(); i++) {
+                        values[i] = sum_op(base_sum, values[i]);
+                    }
+                }
+                else {
+                    for (size_t i = values.size() - 1; i > 0; i--) {
+                        values[i] = sum_op(base_sum, values[i - 1]);
+                    }
+                    values[0] = base_sum;
+                }
+            });
+    }
+
+    /*!
+     * Starts calculating the exclusive prefix sum over all workers like
+     * ExPrefixSum(), but returns immediately with a future of the result. See
+     * PrefixSumAsync().
+     */
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    std::future<T>
+    ExPrefixSumAsync(const T& value, const T& initial = T(),
+                     const BinarySumOp& sum_op = BinarySumOp()) {
+        return PrefixSumAsync(value, initial, sum_op, false);
+    }
+
     /*!
      * Broadcasts a value of a serializable type T from the master (the worker
      * with id 0) to all other workers.
@@ -314,7 +573,7 @@ public:
         if (local_id_ == local_pe) {
             SetLocalShared(&res);
 
-            group_.Broadcast(res, origin / thread_count_);
+            SyncGroup().Broadcast(res, origin / thread_count_);
         }
 
         barrier_.Await();
@@ -329,6 +588,79 @@ public:
         return res;
     }
 
+    /*!
+     * Broadcasts a value of a serializable type T from the worker origin to all
+     * other workers, like Broadcast(), but returns a single read-only copy per
+     * host, which all workers on the host share. Use it for large side inputs,
+     * which are then accessed via the pointer instead of being copied into each
+     * worker's closures.
+     *
+     * This method is blocking on all workers.
+     *
+     * \param value The value to broadcast, ignored on all workers except the
+     * origin.
+     *
+     * \param origin Worker number to broadcast value from.
+     *
+     * \return Pointer to the host's copy of the value sent by the origin.
+     */
+    template <typename T>
+    std::shared_ptr<const T> THRILL_ATTRIBUTE_WARN_UNUSED_RESULT
+    BroadcastShared(const T& value, size_t origin = 0) {
+
+        std::shared_ptr<const T> res;
+
+        // Select primary thread of each node to handle IO (assumes all hosts
+        // has the same number of threads).
+        size_t local_pe = origin % thread_count_;
+
+        if (local_id_ == local_pe) {
+            // only the origin host copies value, all others receive it.
+            std::shared_ptr<T> v =
+                host_rank_ == origin / thread_count_ ?
+                std::make_shared<T>(value) : std::make_shared<T>();
+            SyncGroup().Broadcast(*v, origin / thread_count_);
+            res = std::move(v);
+        }
+
+        return LocalBroadcast(res, local_pe);
+    }
+
+    /*!
+     * Shares a pointer from the worker local_origin with all workers on the
+     * same host, without any network communication or copies of the pointee.
+     *
+     * This method is blocking on all workers of the host.
+     *
+     * \param value The pointer to share, ignored on all workers except
+     * local_origin.
+     *
+     * \param local_origin Local worker id to share the pointer from.
+     *
+     * \return The pointer of local_origin.
+     */
+    template <typename T>
+    std::shared_ptr<const T> THRILL_ATTRIBUTE_WARN_UNUSED_RESULT
+    LocalBroadcast(const std::shared_ptr<const T>& value,
+                   size_t local_origin = 0) {
+        assert(local_origin < thread_count_);
+
+        std::shared_ptr<const T> res = value;
+
+        if (local_id_ == local_origin)
+            SetLocalShared(&res);
+
+        barrier_.Await();
+
+        // other threads: copy the pointer from local_origin.
+        if (local_id_ != local_origin)
+            res = *GetLocalShared<std::shared_ptr<const T> >(local_origin);
+
+        barrier_.Await();
+
+        return res;
+    }
+
     /*!
      * Reduces a value of a serializable type T over all workers to the given
      * worker, provided a certain reduce function.
@@ -361,7 +693,7 @@ public:
             }
 
             // Global reduce
-            group_.Reduce(local, root / thread_count_, sum_op);
+            SyncGroup().Reduce(local, root / thread_count_, sum_op);
 
             // set the local value only at the root
             if (root / thread_count_ == group_.my_host_rank())
@@ -388,6 +720,106 @@ public:
     template <typename T, typename BinarySumOp = std::plus<T> >
     T THRILL_ATTRIBUTE_WARN_UNUSED_RESULT
     AllReduce(const T& value, const BinarySumOp& sum_op = BinarySumOp()) {
+        return AllReduce(value, sum_op, IsInline<T>());
+    }
+
+    /*!
+     * Reduces vectors of arithmetic items elementwise over all workers. The
+     * vectors must have the same size on all workers. In the local phase, each
+     * thread reduces a slice of the vectors of all threads in a tight loop
+     * over contiguous arrays, which the compiler vectorizes for simple sum_op
+     * like std::plus, instead of applying sum_op to whole vectors one thread
+     * after another. The hosts' results are then reduced by
+     * collective::AllReduceElementwise(), which uses ring algorithms for large
+     * vectors. The reduction order differs between items, hence sum_op must
+     * be commutative.
+     *
+     * \param values The vector to reduce.
+     * \param sum_op The commutative operation on two items.
+     * \return The elementwise reduced vector.
+     */
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    std::vector<T> THRILL_ATTRIBUTE_WARN_UNUSED_RESULT
+    AllReduceElementwise(const std::vector<T>& values,
+                         const BinarySumOp& sum_op = BinarySumOp()) {
+        static_assert(std::is_arithmetic<T>::value,
+                      "AllReduceElementwise requires arithmetic items");
+
+        std::vector<T> local = values;
+        LocalReduceElementwise(local.data(), local.size(), sum_op);
+
+        if (local_id_ == 0)
+            collective::AllReduceElementwise(SyncGroup(), local, sum_op);
+
+        CopyLocalElementwise(local.data(), local.size());
+        return local;
+    }
+
+    //! Reduces arrays of arithmetic items elementwise over all workers, like
+    //! AllReduceElementwise() on vectors.
+    template <typename T, size_t N, typename BinarySumOp = std::plus<T> >
+    std::array<T, N> THRILL_ATTRIBUTE_WARN_UNUSED_RESULT
+    AllReduceElementwise(const std::array<T, N>& values,
+                         const BinarySumOp& sum_op = BinarySumOp()) {
+        static_assert(std::is_arithmetic<T>::value,
+                      "AllReduceElementwise requires arithmetic items");
+
+        std::array<T, N> local = values;
+        LocalReduceElementwise(local.data(), N, sum_op);
+
+        if (local_id_ == 0) {
+            std::vector<T> v(local.begin(), local.end());
+            collective::AllReduceElementwise(SyncGroup(), v, sum_op);
+            std::copy(v.begin(), v.end(), local.begin());
+        }
+
+        CopyLocalElementwise(local.data(), N);
+        return local;
+    }
+
+private:
+    //! AllReduce of small trivial types via inline values: a binomial tree, in
+    //! which thread i combines the ranges [i, i + k) and [i + k, i + 2k) in
+    //! order, reduces the local values to thread 0, which writes the global
+    //! result.
+    template <typename T, typename BinarySumOp>
+    T AllReduce(const T& value, const BinarySumOp& sum_op,
+                std::true_type /* inline */) {
+
+        size_t step = ++inline_step_;
+        T local = value;
+
+        for (size_t k = 1; k < thread_count_; k <<= 1) {
+            if (local_id_ & k) {
+                // pass partial result to parent local_id_ - k
+                PutInline(local_id_, local);
+                shmem_[local_id_].inline_step.store(
+                    step, std::memory_order_release);
+                break;
+            }
+            if (local_id_ + k < thread_count_) {
+                shmem_[local_id_ + k].WaitInlineStep(step);
+                local = sum_op(local, GetInline<T>(local_id_ + k));
+            }
+        }
+
+        if (local_id_ != 0) {
+            shmem_[0].WaitInlineStep(step);
+            return GetInline<T>(0);
+        }
+
+        // Global reduce
+        SyncGroup().AllReduce(local, sum_op);
+
+        PutInline(0, local);
+        shmem_[0].inline_step.store(step, std::memory_order_release);
+        return local;
+    }
+
+    //! AllReduce of other types via pointers to the threads' values.
+    template <typename T, typename BinarySumOp>
+    T AllReduce(const T& value, const BinarySumOp& sum_op,
+                std::false_type /* inline */) {
         T local = value;
 
         SetLocalShared(&local);
@@ -402,7 +834,7 @@ public:
             }
 
             // Global reduce
-            group_.AllReduce(local, sum_op);
+            SyncGroup().AllReduce(local, sum_op);
 
             // We have the choice: One more barrier so each slave can read from
             // master's shared memory, or p writes to write to each slaves
@@ -418,6 +850,80 @@ public:
         return local;
     }
 
+    //! Reduce the arrays of all threads elementwise into the array of thread
+    //! 0, each thread reduces one slice of items.
+    template <typename T, typename BinarySumOp>
+    void LocalReduceElementwise(T* data, size_t size,
+                                const BinarySumOp& sum_op) {
+        SetLocalShared(data);
+
+        barrier_.Await();
+
+        const size_t begin = local_id_ * size / thread_count_;
+        const size_t end = (local_id_ + 1) * size / thread_count_;
+
+        T* out = GetLocalShared<T>(0);
+        for (size_t t = 1; t < thread_count_; ++t) {
+            const T* in = GetLocalShared<T>(t);
+            for (size_t i = begin; i < end; ++i)
+                out[i] = sum_op(out[i], in[i]);
+        }
+
+        barrier_.Await();
+    }
+
+    //! Copy the result in the array of thread 0 to all threads, after it was
+    //! reduced globally.
+    template <typename T>
+    void CopyLocalElementwise(T* data, size_t size) {
+        // the global reduce may have reallocated thread 0's items
+        if (local_id_ == 0)
+            SetLocalShared(data);
+
+        barrier_.Await();
+
+        if (local_id_ != 0) {
+            const T* res = GetLocalShared<T>(0);
+            std::copy(res, res + size, data);
+        }
+
+        // thread 0's array must outlive the copies
+        barrier_.Await();
+    }
+
+public:
+    /*!
+     * Starts reducing a value over all workers like AllReduce(), but returns
+     * immediately with a future of the result. The collective is performed by
+     * a background thread once all local workers have started it, hence the
+     * worker can overlap it with local computation.
+     *
+     * All workers must start the same sequence of collectives, synchronous
+     * collectives wait for the asynchronous ones started before them to finish.
+     *
+     * \param value The value to use for the reduce operation.
+     * \param sum_op The operation to use for
+     * calculating the reduced value. The default operation is a normal addition.
+     * \return A future of the result of the reduce operation.
+     */
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    std::future<T>
+    AllReduceAsync(const T& value, const BinarySumOp& sum_op = BinarySumOp()) {
+        return StartAsync(
+            value, [this, sum_op](std::vector<T>& values) {
+                // Local reduce
+                T local = values[0];
+                for (size_t i = 1; i < values.size(); i++) {
+                    local = sum_op(local, values[i]);
+                }
+
+                // Global reduce
+                group_.AllReduce(local, sum_op);
+
+                std::fill(values.begin(), values.end(), local);
+            });
+    }
+
     /*!
      * Collects up to k predecessors of type T from preceding PEs. k must be
      * equal on all PEs.
@@ -453,10 +959,10 @@ public:
             else if (host_rank_ + 1 != num_hosts_) {
                 if (my_values.size() > k) {
                     std::vector<T> send_values_next(my_values.end() - k, my_values.end());
-                    group_.SendTo(host_rank_ + 1, send_values_next);
+                    SyncGroup().SendTo(host_rank_ + 1, send_values_next);
                 }
                 else {
-                    group_.SendTo(host_rank_ + 1, my_values);
+                    SyncGroup().SendTo(host_rank_ + 1, my_values);
                 }
                 // increment generation counter for synchronizing
                 shmem_[local_id_].IncCounter();
@@ -482,7 +988,7 @@ public:
                     pre->size() <= k ? pre->begin() : pre->end() - k, pre->end());
             }
             else if (host_rank_ != 0) {
-                group_.ReceiveFrom(host_rank_ - 1, &res);
+                SyncGroup().ReceiveFrom(host_rank_ - 1, &res);
             }
         }
         else {
@@ -502,7 +1008,7 @@ public:
                     pre->size() <= k ? pre->begin() : pre->end() - k, pre->end());
             }
             else if (host_rank_ != 0) {
-                group_.ReceiveFrom(host_rank_ - 1, &res);
+                SyncGroup().ReceiveFrom(host_rank_ - 1, &res);
             }
 
             // prepend values we got from our predecessor with local ones, such
@@ -529,7 +1035,7 @@ public:
                 shmem_[local_id_].IncCounter();
             }
             else if (host_rank_ + 1 != num_hosts_) {
-                group_.SendTo(host_rank_ + 1, send_values);
+                SyncGroup().SendTo(host_rank_ + 1, send_values);
                 // increment generation counter for synchronizing
                 shmem_[local_id_].IncCounter();
             }
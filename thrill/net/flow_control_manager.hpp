@@ -45,6 +45,9 @@ private:
     //! Host-global generation counter
     std::atomic<size_t> generation_ { 0 };
 
+    //! Host-global state of asynchronous collectives
+    FlowControlChannel::AsyncState async_;
+
 public:
     /*!
      * Initializes a certain count of flow control channels.
@@ -58,7 +61,8 @@ public:
         assert(shmem_.size() == local_worker_count);
         for (size_t i = 0; i < local_worker_count; i++) {
             channels_.emplace_back(group, i, local_worker_count,
-                                   barrier_, shmem_.data(), generation_);
+                                   barrier_, shmem_.data(), generation_,
+                                   async_);
         }
     }
 
@@ -16,12 +16,33 @@
 #include <thrill/net/tcp/group.hpp>
 #endif
 
+#include <string>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace net {
 
+bool Group::SetRacks(const std::vector<size_t>& rack_of_host) {
+    rack_begin_.clear();
+    if (rack_of_host.size() != num_hosts()) return false;
+
+    std::vector<size_t> rack_begin;
+    for (size_t h = 0; h < rack_of_host.size(); ++h) {
+        if (h != 0 && rack_of_host[h] == rack_of_host[h - 1]) continue;
+        // a rack may not appear again after other racks.
+        for (size_t r : rack_begin) {
+            if (rack_of_host[r] == rack_of_host[h]) return false;
+        }
+        rack_begin.push_back(h);
+    }
+    if (rack_begin.size() <= 1) return true;
+
+    rack_begin.push_back(num_hosts());
+    rack_begin_ = std::move(rack_begin);
+    return true;
+}
+
 void RunLoopbackGroupTest(
     size_t num_hosts,
     const std::function<void(Group*)>& thread_function) {
@@ -44,7 +65,7 @@ void RunLoopbackGroupTest(
 std::pair<size_t, size_t> Manager::Traffic() const {
     size_t total_tx = 0, total_rx = 0;
 
-    for (size_t g = 0; g < kGroupCount; ++g) {
+    for (size_t g = 0; g < groups_.size(); ++g) {
         Group& group = *groups_[g];
 
         for (size_t h = 0; h < group.num_hosts(); ++h) {
@@ -71,13 +92,15 @@ void Manager::RunTask(const std::chrono::steady_clock::time_point& tp) {
     size_t total_tx = 0, total_rx = 0;
     size_t prev_total_tx = 0, prev_total_rx = 0;
 
-    for (size_t g = 0; g < kGroupCount; ++g) {
+    for (size_t g = 0; g < groups_.size(); ++g) {
         Group& group = *groups_[g];
 
         size_t group_tx = 0, group_rx = 0;
         size_t prev_group_tx = 0, prev_group_rx = 0;
         std::vector<size_t> tx_per_host(group.num_hosts());
         std::vector<size_t> rx_per_host(group.num_hosts());
+        std::vector<double> tx_speed_per_host(group.num_hosts());
+        std::vector<double> rx_speed_per_host(group.num_hosts());
 
         for (size_t h = 0; h < group.num_hosts(); ++h) {
             if (h == group.my_host_rank()) continue;
@@ -99,9 +122,14 @@ void Manager::RunTask(const std::chrono::steady_clock::time_point& tp) {
 
             tx_per_host[h] = tx;
             rx_per_host[h] = rx;
+            tx_speed_per_host[h] =
+                static_cast<double>(tx - prev_tx) / elapsed;
+            rx_speed_per_host[h] =
+                static_cast<double>(rx - prev_rx) / elapsed;
         }
 
-        line.sub(g == 0 ? "flow" : g == 1 ? "data" : "???")
+        line.sub(g == 0 ? "flow" : g == 1 ? "data"
+                 : "data" + std::to_string(g - 1))
             << "tx_bytes" << group_tx
             << "rx_bytes" << group_rx
             << "tx_speed"
@@ -109,7 +137,9 @@ void Manager::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << "rx_speed"
             << static_cast<double>(group_rx - prev_group_rx) / elapsed
             << "tx_per_host" << tx_per_host
-            << "rx_per_host" << rx_per_host;
+            << "rx_per_host" << rx_per_host
+            << "tx_speed_per_host" << tx_speed_per_host
+            << "rx_speed_per_host" << rx_speed_per_host;
 
         total_tx += group_tx;
         total_rx += group_rx;
@@ -92,6 +92,39 @@ public:
 
     //! \}
 
+    //! \name Topology Functions
+    //! \{
+
+    /*!
+     * Set the rack of each host, which lets the collectives first reduce and
+     * broadcast within racks, such that only one message per rack crosses the
+     * spine links. The hosts of each rack must be a contiguous range of ranks,
+     * which keeps the order of non-commutative reductions. Returns false and
+     * keeps a flat topology if they are not.
+     */
+    bool SetRacks(const std::vector<size_t>& rack_of_host);
+
+    //! Return number of racks, which is 1 for a flat topology
+    size_t num_racks() const {
+        return rack_begin_.empty() ? 1 : rack_begin_.size() - 1;
+    }
+
+    //! Return the rack of the host
+    size_t rack_of(size_t host) const {
+        if (rack_begin_.empty()) return 0;
+        return std::upper_bound(rack_begin_.begin(), rack_begin_.end(), host)
+               - rack_begin_.begin() - 1;
+    }
+
+    //! Return the first host of a rack, rack_begin(num_racks()) is
+    //! num_hosts().
+    size_t rack_begin(size_t rack) const {
+        if (rack_begin_.empty()) return rack == 0 ? 0 : num_hosts();
+        return rack_begin_[rack];
+    }
+
+    //! \}
+
     //! \name Convenience Functions
     //! \{
 
@@ -148,6 +181,9 @@ public:
 protected:
     //! our rank in the network group
     size_t my_rank_;
+
+    //! first host of each rack and num_hosts() as sentinel, empty if flat.
+    std::vector<size_t> rack_begin_;
 };
 
 //! unique pointer to a Group.
@@ -20,6 +20,7 @@
 
 #include <array>
 #include <chrono>
+#include <iterator>
 #include <string>
 #include <utility>
 #include <vector>
@@ -63,13 +64,15 @@ public:
     //! Construct Manager from already initialized net::Groups.
     Manager(std::array<GroupPtr, kGroupCount>&& groups,
             common::JsonLogger& logger) noexcept
-        : groups_(std::move(groups)), logger_(logger) { }
+        : groups_(std::make_move_iterator(groups.begin()),
+                  std::make_move_iterator(groups.end())),
+          logger_(logger) { }
 
-    //! Construct Manager from already initialized net::Groups.
+    //! Construct Manager from already initialized net::Groups. Groups beyond
+    //! kGroupCount are additional parallel data connections.
     Manager(std::vector<GroupPtr>&& groups, common::JsonLogger& logger) noexcept
-        : logger_(logger) {
-        assert(groups.size() == kGroupCount);
-        std::move(groups.begin(), groups.end(), groups_.begin());
+        : groups_(std::move(groups)), logger_(logger) {
+        assert(groups_.size() >= kGroupCount);
     }
 
     //! Returns the net::Group for the flow control channel.
@@ -82,8 +85,17 @@ public:
         return *groups_[1];
     }
 
+    //! Returns all net::Groups for the data manager, which contain parallel
+    //! connections between each host pair.
+    std::vector<Group*> GetDataGroups() {
+        std::vector<Group*> groups;
+        for (size_t i = 1; i < groups_.size(); i++)
+            groups.push_back(groups_[i].get());
+        return groups;
+    }
+
     void Close() {
-        for (size_t i = 0; i < kGroupCount; i++) {
+        for (size_t i = 0; i < groups_.size(); i++) {
             groups_[i]->Close();
         }
     }
@@ -99,8 +111,9 @@ public:
     //! \}
 
 private:
-    //! The Groups initialized and managed by this Manager.
-    std::array<GroupPtr, kGroupCount> groups_;
+    //! The Groups initialized and managed by this Manager: flow control, data,
+    //! and optionally further data groups.
+    std::vector<GroupPtr> groups_;
 
     //! JsonLogger for statistics output
     common::JsonLogger& logger_;
@@ -271,7 +271,11 @@ Dispatcher::Watch& Dispatcher::GetWatch(Connection* c) {
 void Dispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
 
     Connection* c = nullptr;
-    if (!d_->notify_.pop_for(c, timeout)) {
+    std::chrono::steady_clock::time_point wait_begin =
+        std::chrono::steady_clock::now();
+    bool popped = d_->notify_.pop_for(c, timeout);
+    AddWaitTime(wait_begin);
+    if (!popped) {
         sLOG << "DispatchOne timeout";
         return;
     }
@@ -12,6 +12,7 @@
 
 #include <mpi.h>
 
+#include <algorithm>
 #include <mutex>
 #include <vector>
 
@@ -19,19 +20,49 @@ namespace thrill {
 namespace net {
 namespace mpi {
 
-//! The Grand MPI Library Invocation Mutex (The GMLIM)
-extern std::mutex g_mutex;
-
 /******************************************************************************/
 // mpi::Dispatcher
 
-void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
+void Dispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
+
+    // poll both, completions of one may be waiting behind the other.
+    bool completed = TestRequests();
+    if (ProbeWatches()) completed = true;
+
+    if (completed) {
+        idle_rounds_ = 0;
+        return;
+    }
+
+    // spin for a while, since messages often follow each other closely.
+    if (++idle_rounds_ <= spin_rounds) return;
+
+    // then wait between polls, doubling the wait up to max_wait_us, unless
+    // Interrupt() signals new async requests.
+    size_t shift = std::min<size_t>(idle_rounds_ - spin_rounds, 10);
+    std::chrono::microseconds wait(
+        std::min<size_t>(size_t(1) << shift, max_wait_us));
+    if (wait > timeout) wait = timeout;
+
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        if (wait_cv_.wait_for(lock, wait, [this]() { return interrupted_; }))
+            idle_rounds_ = 0;
+        interrupted_ = false;
+    }
+    AddWaitTime(begin);
+}
+
+bool Dispatcher::TestRequests() {
 
     // use MPI_Testsome() to check for finished writes
-    if (mpi_async_requests_.size())
+    if (mpi_async_requests_.size() == 0) return false;
+
     {
-        // lock the GMLIM
-        std::unique_lock<std::mutex> lock(g_mutex);
+        // lock the GMLIM, unless MPI is thread-safe
+        std::unique_lock<std::mutex> lock = LockMpi();
 
         assert(mpi_async_.size() == mpi_async_requests_.size());
         assert(mpi_async_.size() == mpi_async_out_.size());
@@ -61,39 +92,52 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
         if (r != MPI_SUCCESS)
             throw Exception("Error during MPI_Testsome()", r);
 
-        if (out_count == MPI_UNDEFINED) {
+        if (out_count == MPI_UNDEFINED || out_count == 0) {
             // nothing returned
+            return false;
         }
-        else if (out_count > 0) {
-            sLOG << "DispatchOne(): MPI_Testsome() out_count=" << out_count;
 
-            size_t len = mpi_async_.size();
+        sLOG << "DispatchOne(): MPI_Testsome() out_count=" << out_count;
 
-            // run through finished requests back to front, swap last entry into
-            // finished ones.
-            for (int k = out_count - 1; k >= 0; --k) {
-                size_t p = mpi_async_out_[k];
+        size_t len = mpi_async_.size();
 
-                // TODO(tb): check for errors?
+        // run through finished requests back to front, swap last entry into
+        // finished ones.
+        for (int k = out_count - 1; k >= 0; --k) {
+            size_t p = mpi_async_out_[k];
 
-                // perform callback
-                mpi_async_[p]();
+            // TODO(tb): check for errors?
 
-                // deleted the entry (no problem is k == len)
-                --len;
-                mpi_async_[p] = std::move(mpi_async_[len]);
-                mpi_async_requests_[p] = std::move(mpi_async_requests_[len]);
-                mpi_async_out_[p] = std::move(mpi_async_out_[len]);
-                mpi_async_status_[p] = std::move(mpi_async_status_[len]);
+            // copy the data of a persistent receive, whose request can
+            // be started again by the callback.
+            if (PersistentRecv* pr = mpi_async_[p].persistent_) {
+                std::copy(pr->buffer.data(), pr->buffer.data() + pr->size,
+                          mpi_async_[p].read_buffer_.buffer().data());
+                pr->active = false;
             }
 
-            mpi_async_.resize(len);
-            mpi_async_requests_.resize(len);
-            mpi_async_out_.resize(len);
-            mpi_async_status_.resize(len);
+            // perform callback
+            mpi_async_[p]();
+
+            // deleted the entry (no problem is k == len)
+            --len;
+            mpi_async_[p] = std::move(mpi_async_[len]);
+            mpi_async_requests_[p] = std::move(mpi_async_requests_[len]);
+            mpi_async_out_[p] = std::move(mpi_async_out_[len]);
+            mpi_async_status_[p] = std::move(mpi_async_status_[len]);
         }
+
+        mpi_async_.resize(len);
+        mpi_async_requests_.resize(len);
+        mpi_async_out_.resize(len);
+        mpi_async_status_.resize(len);
     }
 
+    return true;
+}
+
+bool Dispatcher::ProbeWatches() {
+
     if (watch_active_)
     {
         // use MPI_Iprobe() to check for a new message on this MPI tag.
@@ -101,8 +145,8 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
         MPI_Status status;
 
         {
-            // lock the GMLIM
-            std::unique_lock<std::mutex> lock(g_mutex);
+            // lock the GMLIM, unless MPI is thread-safe
+            std::unique_lock<std::mutex> lock = LockMpi();
 
             int r = MPI_Iprobe(MPI_ANY_SOURCE, group_tag_, MPI_COMM_WORLD,
                                &flag, &status);
@@ -112,7 +156,7 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
         }
 
         // check whether probe was successful
-        if (flag == 0) return;
+        if (flag == 0) return false;
 
         // get the right watch
         int p = status.MPI_SOURCE;
@@ -122,7 +166,7 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
 
         if (!w.active) {
             sLOG << "Got Iprobe() for unwatched peer" << p;
-            return;
+            return false;
         }
 
         sLOG << "Got iprobe for peer" << p;
@@ -143,7 +187,10 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
             LOG << "Dispatcher: got MPI_Iprobe() for peer "
                 << p << " without a read handler.";
         }
+        return true;
     }
+
+    return false;
 }
 
 } // namespace mpi
@@ -22,7 +22,9 @@
 #include <mpi.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <deque>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -48,8 +50,25 @@ public:
         : net::Dispatcher(mem_manager),
           group_tag_(group_tag) {
         watch_.reserve(group_size);
-        for (size_t i = 0; i < group_size; ++i)
+        for (size_t i = 0; i < group_size; ++i) {
             watch_.emplace_back(mem_manager_);
+            // the async reads point to the persistent receives
+            watch_.back().persistent.reserve(max_persistent_per_peer);
+        }
+    }
+
+    //! cancel and free the persistent receive requests.
+    ~Dispatcher() {
+        std::unique_lock<std::mutex> lock = LockMpi();
+        for (Watch& w : watch_) {
+            for (PersistentRecv& pr : w.persistent) {
+                if (pr.active) {
+                    MPI_Cancel(&pr.request);
+                    MPI_Wait(&pr.request, MPI_STATUS_IGNORE);
+                }
+                MPI_Request_free(&pr.request);
+            }
+        }
     }
 
     //! Register a buffered read callback and a default exception callback.
@@ -99,6 +118,8 @@ public:
     }
 
     MPI_Request ISend(Connection& c, const void* data, size_t size) {
+        std::unique_lock<std::mutex> lock = LockMpi();
+
         MPI_Request request;
         int r = MPI_Isend(const_cast<void*>(data), static_cast<int>(size), MPI_BYTE,
                           c.peer(), group_tag_, MPI_COMM_WORLD, &request);
@@ -135,6 +156,13 @@ public:
         mpi_async_status_.emplace_back();
     }
 
+    //! MPI sends are issued immediately and cannot be reordered.
+    void AsyncWriteUrgent(
+        net::Connection& c, Buffer&& buffer,
+        const AsyncWriteCallback& done_cb = AsyncWriteCallback()) final {
+        return AsyncWrite(c, std::move(buffer), done_cb);
+    }
+
     void AsyncWrite(
         net::Connection& c, const data::PinnedBlock& block,
         const AsyncWriteCallback& done_cb = AsyncWriteCallback()) final {
@@ -158,7 +186,17 @@ public:
         mpi_async_status_.emplace_back();
     }
 
+    void AsyncWrite(
+        net::Connection& c, Buffer&& buffer, const data::PinnedBlock& block,
+        const AsyncWriteCallback& done_cb = AsyncWriteCallback()) final {
+        // MPI messages cannot be gathered, issue two Isends.
+        AsyncWrite(c, std::move(buffer));
+        AsyncWrite(c, block, done_cb);
+    }
+
     MPI_Request IRecv(Connection& c, void* data, size_t size) {
+        std::unique_lock<std::mutex> lock = LockMpi();
+
         MPI_Request request;
         int r = MPI_Irecv(data, static_cast<int>(size), MPI_BYTE,
                           c.peer(), group_tag_, MPI_COMM_WORLD, &request);
@@ -189,6 +227,14 @@ public:
         mpi_async_out_.emplace_back();
         mpi_async_status_.emplace_back();
 
+        // recurring small messages, like the multiplexer's headers, are
+        // received with a persistent request into its fixed buffer.
+        if (PersistentRecv* pr = GetPersistentRecv(*mpic, n)) {
+            mpi_async_.back().persistent_ = pr;
+            mpi_async_requests_.emplace_back(StartPersistentRecv(*mpic, pr));
+            return;
+        }
+
         Buffer& buffer = mpi_async_.back().read_buffer_.buffer();
 
         // perform Irecv.
@@ -220,28 +266,73 @@ public:
         mpi_async_status_.emplace_back();
     }
 
-    //! Run one iteration of dispatching using MPI_Iprobe().
-    void DispatchOne(const std::chrono::milliseconds& /* timeout */) final;
+    /*!
+     * Run one iteration of dispatching using MPI_Testsome() and MPI_Iprobe().
+     * If nothing completed for spin_rounds iterations, it waits between the
+     * polls with exponentially growing timeouts, until woken by Interrupt().
+     */
+    void DispatchOne(const std::chrono::milliseconds& timeout) final;
 
-    //! Interrupt does nothing.
-    void Interrupt() final { }
+    //! Interrupt a wait between the polls of DispatchOne().
+    void Interrupt() final {
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        interrupted_ = true;
+        wait_cv_.notify_one();
+    }
 
 private:
+    //! number of polls without completions before DispatchOne() waits
+    static constexpr size_t spin_rounds = 4096;
+
+    //! maximum wait in microseconds between polls of an idle dispatcher
+    static constexpr size_t max_wait_us = 1000;
+
+    //! reads up to this size use persistent receive requests
+    static constexpr size_t max_persistent_size = 256;
+
+    //! maximum number of persistent receive requests per peer
+    static constexpr size_t max_persistent_per_peer = 4;
+
     //! group_tag attached to this Dispatcher
     int group_tag_;
 
+    //! persistent receive request of a peer for a recurring message size,
+    //! whose fixed buffer is copied into the read's Buffer when completed.
+    struct PersistentRecv
+    {
+        //! message size
+        size_t      size;
+        //! fixed receive buffer, which MPI may register once
+        Buffer      buffer;
+        //! request created by MPI_Recv_init()
+        MPI_Request request = MPI_REQUEST_NULL;
+        //! whether the request was started and has not completed
+        bool        active = false;
+
+        explicit PersistentRecv(size_t _size)
+            : size(_size), buffer(_size) { }
+    };
+
     //! callback vectors per peer
     struct Watch
     {
         //! boolean check whether any callbacks are registered
-        bool                 active = false;
+        bool                       active = false;
         //! queue of callbacks for peer.
-        mem::deque<Callback> read_cb;
+        mem::deque<Callback>       read_cb;
         //! only one exception callback for the peer.
-        Callback             except_cb;
+        Callback                   except_cb;
+        //! persistent receive requests of the peer, one per message size.
+        mem::vector<PersistentRecv> persistent;
 
         explicit Watch(mem::Manager& mem_manager)
-            : read_cb(mem::Allocator<Callback>(mem_manager)) { }
+            : read_cb(mem::Allocator<Callback>(mem_manager)),
+              persistent(mem::Allocator<PersistentRecv>(mem_manager)) { }
+
+        //! non-copyable: delete copy-constructor
+        Watch(const Watch&) = delete;
+        //! move-constructor: default
+        Watch(Watch&&) = default;
     };
 
     //! callback watch vector
@@ -255,6 +346,64 @@ private:
         throw Exception("SelectDispatcher() exception on socket!", errno);
     }
 
+    //! number of successive polls without completions
+    size_t idle_rounds_ = 0;
+
+    //! mutex and condition variable for waiting between polls
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+
+    //! set by Interrupt() to end a wait
+    bool interrupted_ = false;
+
+    //! Test the async requests with MPI_Testsome() and run the callbacks of
+    //! completed ones. Returns true if any completed.
+    bool TestRequests();
+
+    //! Check for a new message with MPI_Iprobe() and run the peer's read
+    //! callbacks. Returns true if a message was found.
+    bool ProbeWatches();
+
+    /*!
+     * Returns the idle persistent receive request of the peer for messages of
+     * size n, which is created on first use, or nullptr if n is too large or
+     * the request is already active.
+     */
+    PersistentRecv* GetPersistentRecv(Connection& c, size_t n) {
+        if (n > max_persistent_size) return nullptr;
+
+        Watch& w = watch_[c.peer()];
+        for (PersistentRecv& pr : w.persistent) {
+            if (pr.size == n) return pr.active ? nullptr : &pr;
+        }
+        if (w.persistent.size() == max_persistent_per_peer) return nullptr;
+
+        w.persistent.emplace_back(n);
+        PersistentRecv& pr = w.persistent.back();
+
+        std::unique_lock<std::mutex> lock = LockMpi();
+        int r = MPI_Recv_init(pr.buffer.data(), static_cast<int>(n), MPI_BYTE,
+                              c.peer(), group_tag_, MPI_COMM_WORLD,
+                              &pr.request);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Recv_init()", r);
+
+        return &pr;
+    }
+
+    //! Start a persistent receive request, returns its handle.
+    MPI_Request StartPersistentRecv(Connection& c, PersistentRecv* pr) {
+        std::unique_lock<std::mutex> lock = LockMpi();
+        int r = MPI_Start(&pr->request);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Start()", r);
+
+        pr->active = true;
+        c.rx_bytes_ += pr->size;
+
+        return pr->request;
+    }
+
     /**************************************************************************/
 
     /*!
@@ -293,7 +442,7 @@ private:
                  const data::PinnedBlock& block,
                  const AsyncWriteCallback& callback)
             : type_(WRITE_BLOCK),
-              write_block_(conn, block, callback) { }
+              write_block_(conn, Buffer(), block, callback) { }
 
         //! Construct AsyncRead with ByteBuffer
         MpiAsync(net::Connection& conn,
@@ -309,7 +458,7 @@ private:
 
         //! move-constructor: move item
         MpiAsync(MpiAsync&& ma)
-            : type_(ma.type_) {
+            : type_(ma.type_), persistent_(ma.persistent_) {
             Acquire(std::move(ma));
             ma.type_ = NONE;
         }
@@ -322,6 +471,7 @@ private:
             this->~MpiAsync();
             // move item.
             type_ = ma.type_;
+            persistent_ = ma.persistent_;
             Acquire(std::move(ma));
             // release other
             ma.type_ = NONE;
@@ -357,6 +507,9 @@ private:
         //! type of this async
         Type type_;
 
+        //! persistent receive request of a READ_BUFFER, if any
+        PersistentRecv* persistent_ = nullptr;
+
         //! the big unification of async receivers. these also hold reference
         //! counts on the Buffer or Block objects.
         union {
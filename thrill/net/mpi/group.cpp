@@ -25,6 +25,16 @@ namespace mpi {
 //! The Grand MPI Library Invocation Mutex (The GMLIM)
 std::mutex g_mutex;
 
+//! whether MPI provides MPI_THREAD_MULTIPLE, which makes the GMLIM unnecessary
+//! for sends, receives and tests. Set once by Initialize().
+static bool g_thread_multiple = false;
+
+std::unique_lock<std::mutex> LockMpi() {
+    if (g_thread_multiple)
+        return std::unique_lock<std::mutex>(g_mutex, std::defer_lock);
+    return std::unique_lock<std::mutex>(g_mutex);
+}
+
 /******************************************************************************/
 // mpi::Exception
 
@@ -40,7 +50,7 @@ std::string Exception::GetErrorString(int error_code) {
 
 void Connection::SyncSend(
     const void* data, size_t size, Flags /* flags */) {
-    std::unique_lock<std::mutex> lock(g_mutex);
+    std::unique_lock<std::mutex> lock = LockMpi();
 
     LOG << "MPI_Send()"
         << " size=" << size
@@ -60,7 +70,7 @@ void Connection::SyncSend(
 
 ssize_t Connection::SendOne(
     const void* data, size_t size, Flags /* flags */) {
-    std::unique_lock<std::mutex> lock(g_mutex);
+    std::unique_lock<std::mutex> lock = LockMpi();
 
     assert(size <= std::numeric_limits<int>::max());
 
@@ -78,7 +88,7 @@ ssize_t Connection::SendOne(
 }
 
 void Connection::SyncRecv(void* out_data, size_t size) {
-    std::unique_lock<std::mutex> lock(g_mutex);
+    std::unique_lock<std::mutex> lock = LockMpi();
 
     LOG << "MPI_Recv()"
         << " size=" << size
@@ -142,15 +152,28 @@ static inline void Initialize() {
         int argc = 1;
         const char* argv[] = { "thrill", nullptr };
 
+        // request concurrent calls, such that the workers' synchronous sends
+        // and the dispatcher's polling do not wait for each other.
         int provided;
         int r = MPI_Init_thread(&argc, reinterpret_cast<char***>(&argv),
-                                MPI_THREAD_SERIALIZED, &provided);
+                                MPI_THREAD_MULTIPLE, &provided);
         if (r != MPI_SUCCESS)
             throw Exception("Error during MPI_Init_thread()", r);
 
+        g_thread_multiple = (provided >= MPI_THREAD_MULTIPLE);
+
         // register atexit method
         atexit(&Deinitialize);
     }
+    else {
+        // MPI was initialized by the application, use what it provides.
+        int provided;
+        r = MPI_Query_thread(&provided);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Query_thread()", r);
+
+        g_thread_multiple = (provided >= MPI_THREAD_MULTIPLE);
+    }
 }
 
 /*!
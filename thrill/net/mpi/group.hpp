@@ -2,10 +2,9 @@
  * thrill/net/mpi/group.hpp
  *
  * A Thrill network layer Implementation which uses MPI to transmit messages to
- * peers. Since MPI implementations are very bad at multi-threading, this
- * implementation is not recommended: it sequentialized all calls to the MPI
- * library (such that it does not deadlock), which _requires_ a busy-waiting
- * loop for new messages.
+ * peers. Unless the MPI library provides MPI_THREAD_MULTIPLE, this
+ * implementation sequentializes all calls to the MPI library (such that it
+ * does not deadlock), and it always requires a polling loop for new messages.
  *
  * Due to this restriction, the mpi::Group allows only **one Thrill host**
  * within a system process. We cannot start independent test threads as MPI
@@ -26,6 +25,7 @@
 #include <thrill/net/group.hpp>
 
 #include <algorithm>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -200,6 +200,13 @@ size_t NumMpiProcesses();
 //! Return the rank of this process in the MPI COMM WORLD.
 size_t MpiRank();
 
+/*!
+ * Lock the mutex which sequentializes all calls to the MPI library, unless MPI
+ * was initialized with MPI_THREAD_MULTIPLE, in which case the returned lock
+ * does not own the mutex and threads call MPI concurrently.
+ */
+std::unique_lock<std::mutex> LockMpi();
+
 //! \}
 
 } // namespace mpi
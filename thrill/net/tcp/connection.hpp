@@ -177,6 +177,25 @@ public:
         return wb;
     }
 
+    ssize_t SendTwo(const void* data1, size_t size1,
+                    const void* data2, size_t size2) final {
+        SetNonBlocking(true);
+        ssize_t wb = socket_.send_two(data1, size1, data2, size2);
+        if (wb > 0) tx_bytes_ += wb;
+        return wb;
+    }
+
+#if defined(__linux__)
+    bool CanSendFile() const final { return true; }
+#endif
+
+    ssize_t SendFile(int fd, uint64_t offset, size_t size) final {
+        SetNonBlocking(true);
+        ssize_t wb = socket_.send_file(fd, offset, size);
+        if (wb > 0) tx_bytes_ += wb;
+        return wb;
+    }
+
     void SyncRecv(void* out_data, size_t size) final {
         SetNonBlocking(false);
         if (socket_.recv(out_data, size) != static_cast<ssize_t>(size))
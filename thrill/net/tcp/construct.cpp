@@ -10,11 +10,13 @@
  ******************************************************************************/
 
 #include <thrill/common/die.hpp>
+#include <thrill/net/dispatcher.hpp>
 #include <thrill/net/tcp/connection.hpp>
 #include <thrill/net/tcp/construct.hpp>
 #include <thrill/net/tcp/group.hpp>
-#include <thrill/net/tcp/select_dispatcher.hpp>
 
+#include <chrono>
+#include <cstdlib>
 #include <deque>
 #include <map>
 #include <string>
@@ -51,6 +53,7 @@ public:
 
         this->my_rank_ = my_rank_;
         die_unless(my_rank_ < endpoints.size());
+        die_unless(group_count_ > 0);
 
         LOG << "Client " << my_rank_ << " starting: " << endpoints[my_rank_];
 
@@ -58,6 +61,11 @@ public:
             groups_[i] = std::make_unique<Group>(my_rank_, endpoints.size());
         }
 
+        // use the same dispatcher as the Groups, which is epoll on Linux and
+        // scales to the hundreds of sockets of a large cluster.
+        dispatcher_ = groups_[0]->ConstructDispatcher(mem_manager_);
+        num_links_ = group_count_ * (endpoints.size() - 1);
+
         // Parse endpoints.
         std::vector<SocketAddress> address_list
             = GetAddressList(endpoints);
@@ -77,12 +85,41 @@ public:
                 throw Exception("Could not listen on socket "
                                 + lsa.ToStringHostPort(), errno);
 
+            listen_socket.SetNonBlocking(true);
+
             listener_ = Connection(std::move(listen_socket));
         }
 
+        // Create local listening socket for peers on the same host.
+        colocated_.resize(address_list.size(), false);
+        if (UseLocalSockets()) {
+            Socket local_socket = Socket::CreateLocal();
+
+            const SocketAddress& lsa = address_list[my_rank_];
+            std::string name = LocalSocketName(lsa);
+
+            if (!local_socket.bind_local(name))
+                throw Exception("Could not bind local listen socket to "
+                                + name, errno);
+
+            if (!local_socket.listen())
+                throw Exception("Could not listen on local socket "
+                                + name, errno);
+
+            local_socket.SetNonBlocking(true);
+
+            local_listener_ = Connection(std::move(local_socket));
+
+            for (size_t id = 0; id < address_list.size(); ++id) {
+                colocated_[id] =
+                    id != my_rank_ && IsColocated(lsa, address_list[id]);
+            }
+        }
+
         LOG << "Client " << my_rank_ << " listening: " << endpoints[my_rank_];
 
-        // Initiate connections to all hosts with higher id.
+        // Initiate connections to all hosts with higher id. All connects run
+        // concurrently in the dispatcher.
         for (uint32_t g = 0; g < group_count_; g++) {
             for (size_t id = my_rank_ + 1; id < address_list.size(); ++id) {
                 AsyncConnect(g, id, address_list[id]);
@@ -90,20 +127,27 @@ public:
         }
 
         // Add reads to the dispatcher to accept new connections.
-        dispatcher_.AddRead(listener_,
+        dispatcher_->AddRead(listener_,
                             [=]() {
                                 return OnIncomingConnection(listener_);
                             });
+        if (local_listener_.IsValid()) {
+            dispatcher_->AddRead(local_listener_,
+                                [=]() {
+                                    return OnIncomingConnection(local_listener_);
+                                });
+        }
 
         // Dispatch until everything is connected.
-        while (!IsInitializationFinished())
+        while (num_connected_ != num_links_)
         {
             LOG << "Client " << my_rank_ << " dispatching.";
-            dispatcher_.Dispatch();
+            dispatcher_->Dispatch();
         }
 
-        // All connected, Dispose listener.
+        // All connected, Dispose listeners.
         listener_.Close();
+        if (local_listener_.IsValid()) local_listener_.Close();
 
         LOG << "Client " << my_rank_ << " done";
 
@@ -134,8 +178,21 @@ private:
     //! The Connections responsible for listening to incoming connections.
     Connection listener_;
 
+    //! Listener for incoming local connections from peers on the same host,
+    //! invalid if local sockets are disabled.
+    Connection local_listener_;
+
+    //! Which peers are on the same host and are connected via local sockets.
+    std::vector<bool> colocated_;
+
     //! Dispatcher instance used by this Manager to perform async operations.
-    SelectDispatcher dispatcher_ { mem_manager_ };
+    std::unique_ptr<net::Dispatcher> dispatcher_;
+
+    //! number of links to other hosts in all groups
+    size_t num_links_ = 0;
+
+    //! number of links which reached ConnectionState::Connected
+    size_t num_connected_ = 0;
 
     //! Some definitions for convenience
     using GroupNodeIdPair = std::pair<size_t, size_t>;
@@ -145,16 +202,27 @@ private:
     //! Connection is moved out of the deque into the right Group.
     std::deque<Connection> connections_;
 
+    //! Connect backoff of a (group,id) link and the time of its first failed
+    //! connect.
+    struct Backoff {
+        size_t                                timeout;
+        std::chrono::steady_clock::time_point first_failure;
+    };
+
     //! Array of connect timeouts which are exponentially increased from 10msec
-    //! on failed connects.
-    std::map<GroupNodeIdPair, size_t> timeouts_;
+    //! on failed connects, up to max_timeout_.
+    std::map<GroupNodeIdPair, Backoff> timeouts_;
 
     //! start connect backoff at 10msec
     const size_t initial_timeout_ = 10;
 
-    //! maximum connect backoff, after which the program fails. Total waiting
-    //! time is about 2 * final_timeout_ (in millisec).
-    const size_t final_timeout_ = 40960;
+    //! maximum connect backoff, such that a host which is started late in a
+    //! large cluster is connected to at most this long after it listens.
+    const size_t max_timeout_ = 640;
+
+    //! total time in millisec after the first failed connect, after which the
+    //! program fails.
+    const size_t final_timeout_ = 80000;
 
     //! Represents a welcome message that is exchanged by Connections during
     //! network initialization.
@@ -197,28 +265,39 @@ private:
     }
 
     /*!
-     * Returns wether the initialization is completed.  Checks the Groups
-     * associated with this Manager and returns true or false wether the
-     * initialization is finished.
-     *
-     * \return True if initialization is finished, else false.
+     * Returns whether peers on the same host are connected via local (Unix
+     * domain) sockets instead of TCP, which bypasses the TCP/IP stack. This is
+     * on by default on Linux and can be disabled by setting
+     * THRILL_NET_LOCAL_SOCKETS=0, which must then be done on all hosts.
      */
-    bool IsInitializationFinished() {
-
-        for (size_t g = 0; g < group_count_; g++) {
-
-            for (size_t id = 0; id < groups_[g]->num_hosts(); ++id) {
-                if (id == my_rank_) continue;
+    static bool UseLocalSockets() {
+#if defined(__linux__)
+        const char* env = getenv("THRILL_NET_LOCAL_SOCKETS");
+        if (env == nullptr || *env == 0) return true;
+        die_unless(std::string(env) == "0" || std::string(env) == "1");
+        return std::string(env) == "1";
+#else
+        return false;
+#endif
+    }
 
-                // Just checking the state works since this implicitey checks the
-                // size. Unset connections have state ConnectionState::Invalid.
-                if (groups_[g]->tcp_connection(id).state()
-                    != ConnectionState::Connected)
-                    return false;
-            }
-        }
+    //! Name of the local listening socket of a host in the abstract namespace,
+    //! which is derived from the TCP endpoint and hence unique.
+    static std::string LocalSocketName(const SocketAddress& address) {
+        return "thrill-" + address.ToStringHostPort();
+    }
 
-        return true;
+    //! Returns whether the peer address refers to the same host as ours: it is
+    //! either a loopback address or has the same IP.
+    static bool IsColocated(const SocketAddress& mine,
+                            const SocketAddress& peer) {
+        if (peer.IsIPv4() &&
+            (ntohl(peer.sockaddr_in()->sin_addr.s_addr) >> 24) == 127)
+            return true;
+        if (peer.IsIPv6() &&
+            IN6_IS_ADDR_LOOPBACK(&peer.sockaddr_in6()->sin6_addr))
+            return true;
+        return peer.ToStringHost() == mine.ToStringHost();
     }
 
     /*!
@@ -234,23 +313,27 @@ private:
         Connection& tcp = static_cast<Connection&>(nc);
 
         // Start asynchronous connect.
+        bool local = colocated_[tcp.peer_id()];
         tcp.GetSocket().SetNonBlocking(true);
-        int res = tcp.GetSocket().connect(address);
+        int res = local
+                  ? tcp.GetSocket().connect_local(LocalSocketName(address))
+                  : tcp.GetSocket().connect(address);
 
         tcp.set_state(ConnectionState::Connecting);
 
         if (res == 0) {
-            LOG << "Early connect success. This should not happen.";
-            // connect() already successful? this should not be.
+            // connect() already successful? this should only happen for local
+            // sockets.
+            LOG << "Early connect success. local=" << local;
             OnConnected(tcp, address);
         }
         else if (errno == EINPROGRESS) {
             // connect is in progress, will wait for completion.
-            dispatcher_.AddWrite(tcp, [this, &address, &tcp]() {
+            dispatcher_->AddWrite(tcp, [this, &address, &tcp]() {
                                      return OnConnected(tcp, address);
                                  });
         }
-        else if (errno == ECONNREFUSED) {
+        else if (errno == ECONNREFUSED || (local && errno == EAGAIN)) {
             LOG << "Early connect refused.";
             // connect() already refused connection?
             OnConnected(tcp, address, errno);
@@ -279,9 +362,13 @@ private:
 
         // Construct a new socket (old one is destroyed)
         Connection& nc = groups_[group]->tcp_connection(id);
-        if (nc.IsValid()) nc.Close();
+        if (nc.IsValid()) {
+            // unregister the old fd, whose number may be reused by epoll.
+            dispatcher_->Cancel(nc);
+            nc.Close();
+        }
 
-        nc = Connection(Socket::Create());
+        nc = Connection(colocated_[id] ? Socket::CreateLocal() : Socket::Create());
         nc.set_group_id(group);
         nc.set_peer_id(id);
 
@@ -303,6 +390,7 @@ private:
         }
         else if (tcp.state() == ConnectionState::HelloReceived) {
             tcp.set_state(ConnectionState::Connected);
+            ++num_connected_;
         }
         else {
             die("State mismatch: " + std::to_string(tcp.state()));
@@ -313,21 +401,24 @@ private:
     size_t NextConnectTimeout(size_t group, size_t id,
                               const SocketAddress& address) {
         GroupNodeIdPair gnip(group, id);
+        auto now = std::chrono::steady_clock::now();
         auto it = timeouts_.find(gnip);
         if (it == timeouts_.end()) {
-            it = timeouts_.insert(std::make_pair(gnip, initial_timeout_)).first;
+            it = timeouts_.insert(
+                std::make_pair(gnip, Backoff { initial_timeout_, now })).first;
         }
         else {
             // exponential backoff of reconnects.
-            it->second = 2 * it->second;
+            it->second.timeout = std::min(2 * it->second.timeout, max_timeout_);
 
-            if (it->second >= final_timeout_) {
+            if (now - it->second.first_failure
+                >= std::chrono::milliseconds(final_timeout_)) {
                 throw Exception("Timeout error connecting to client "
                                 + std::to_string(id) + " via "
                                 + address.ToStringHostPort());
             }
         }
-        return it->second;
+        return it->second.timeout;
     }
 
     /*!
@@ -358,7 +449,7 @@ private:
             die("FAULTY STATE DETECTED");
         }
 
-        if (err == ECONNREFUSED || err == ETIMEDOUT) {
+        if (err == ECONNREFUSED || err == ETIMEDOUT || err == EAGAIN) {
 
             // Connection refused. The other workers might not be online yet.
 
@@ -370,7 +461,7 @@ private:
                 << " timed out or refused with error " << err << "."
                 << " Attempting reconnect in " << next_timeout << "msec";
 
-            dispatcher_.AddTimer(
+            dispatcher_->AddTimer(
                 std::chrono::milliseconds(next_timeout),
                 [&]() {
                     // Construct a new connection since the socket might not be
@@ -403,7 +494,7 @@ private:
         // send welcome message
         const WelcomeMsg hello = { thrill_sign, tcp.group_id(), my_rank_ };
 
-        dispatcher_.AsyncWriteCopy(
+        dispatcher_->AsyncWriteCopy(
             tcp, &hello, sizeof(hello),
             AsyncWriteCallback::make<
                 Construction, & Construction::OnHelloSent>(this));
@@ -411,7 +502,7 @@ private:
         LOG << "Client " << my_rank_ << " sent active hello to "
             << "client " << tcp.peer_id() << " group id " << tcp.group_id();
 
-        dispatcher_.AsyncRead(
+        dispatcher_->AsyncRead(
             tcp, sizeof(hello),
             AsyncReadCallback::make<
                 Construction, & Construction::OnIncomingWelcome>(this));
@@ -452,6 +543,7 @@ private:
         die_unequal(tcp.group_id(), msg->group_id);
 
         tcp.set_state(ConnectionState::Connected);
+        ++num_connected_;
     }
 
     /*!
@@ -494,7 +586,7 @@ private:
 
         const WelcomeMsg msg_out = { thrill_sign, msg_in->group_id, my_rank_ };
 
-        dispatcher_.AsyncWriteCopy(
+        dispatcher_->AsyncWriteCopy(
             c, &msg_out, sizeof(msg_out),
             AsyncWriteCallback::make<
                 Construction, & Construction::OnHelloSent>(this));
@@ -513,21 +605,33 @@ private:
         assert(dynamic_cast<Connection*>(&conn));
         Connection& tcp = static_cast<Connection&>(conn);
 
-        // accept listening socket
-        connections_.emplace_back(tcp.GetSocket().accept());
-        die_unless(connections_.back().GetSocket().IsValid());
-
-        tcp.set_state(ConnectionState::TransportConnected);
-
-        LOG << "OnIncomingConnection() " << my_rank_ << " accepted connection"
-            << " fd=" << connections_.back().GetSocket().fd()
-            << " from=" << connections_.back().GetPeerAddress();
-
-        // wait for welcome message from other side
-        dispatcher_.AsyncRead(
-            connections_.back(), sizeof(WelcomeMsg),
-            AsyncReadCallback::make<
-                Construction, & Construction::OnIncomingWelcomeAndReply>(this));
+        // accept all pending connections of the nonblocking listener, since
+        // many peers connect at once on large clusters.
+        for ( ; ; ) {
+            Socket socket = tcp.GetSocket().accept();
+            if (!socket.IsValid()) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK ||
+                    errno == ECONNABORTED || errno == EINTR) break;
+                throw Exception("Error accepting connection", errno);
+            }
+            // accepted sockets may inherit the listener's O_NONBLOCK
+            socket.SetNonBlocking(false);
+            connections_.emplace_back(std::move(socket));
+
+            tcp.set_state(ConnectionState::TransportConnected);
+
+            LOG << "OnIncomingConnection() " << my_rank_
+                << " accepted connection"
+                << " fd=" << connections_.back().GetSocket().fd()
+                << " from=" << connections_.back().GetPeerAddress();
+
+            // wait for welcome message from other side
+            dispatcher_->AsyncRead(
+                connections_.back(), sizeof(WelcomeMsg),
+                AsyncReadCallback::make<
+                    Construction, & Construction::OnIncomingWelcomeAndReply>(
+                    this));
+        }
 
         // wait for more connections.
         return true;
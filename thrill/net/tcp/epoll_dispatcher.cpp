@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * thrill/net/tcp/epoll_dispatcher.cpp
+ *
+ * Asynchronous callback wrapper around Linux epoll()
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
+
+#if THRILL_HAVE_NET_EPOLL
+
+namespace thrill {
+namespace net {
+namespace tcp {
+
+void EpollDispatcher::Register(int fd) {
+    Watch& w = watch_[fd];
+    if (w.registered) return;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0)
+        throw Exception("EpollDispatcher() could not add fd!", errno);
+
+    LOG << "EpollDispatcher::Register() fd=" << fd;
+
+    w.registered = true;
+}
+
+void EpollDispatcher::Unregister(int fd) {
+    Watch& w = watch_[fd];
+    if (!w.registered) return;
+
+    // the kernel removes closed fds automatically, so ignore failures.
+    struct epoll_event ev;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev);
+
+    LOG << "EpollDispatcher::Unregister() fd=" << fd;
+
+    w.registered = w.ready = false;
+    w.can_read = w.can_write = w.error = false;
+}
+
+void EpollDispatcher::ProcessReady(int fd) {
+    // we use a pointer into the watch_ table. however, since the std::vector
+    // may regrow when callback handlers are called, this pointer is reset a
+    // lot of times.
+    Watch* w = &watch_[fd];
+
+    // fd may have been canceled, or be listed twice.
+    if (!w->ready) return;
+    w->ready = false;
+
+    if (w->error && w->except_cb) {
+        w->error = false;
+        if (!w->except_cb()) {
+            // callback returned false: remove exception callback
+            watch_[fd].except_cb = Callback();
+        }
+        w = &watch_[fd];
+    }
+
+    if (w->can_read)
+    {
+        // run read callbacks until one returns true, which means its recv()
+        // failed with EAGAIN, hence the socket is drained and the next edge
+        // will be reported. Callbacks retry recv() on EINTR themselves, such
+        // that can_read is never cleared while data is still pending.
+        while (w->read_cb.size()) {
+            if (w->read_cb.front()()) {
+                w = &watch_[fd];
+                w->can_read = false;
+                break;
+            }
+            w = &watch_[fd];
+            // callback may have canceled all callbacks
+            if (w->read_cb.size()) w->read_cb.pop_front();
+        }
+    }
+
+    if (w->can_write)
+    {
+        // run write callbacks until one returns true, which means its send()
+        // failed with EAGAIN as the send buffer is full, or the write_cb list
+        // is empty.
+        while (w->write_cb.size()) {
+            if (w->write_cb.front()()) {
+                w = &watch_[fd];
+                w->can_write = false;
+                break;
+            }
+            w = &watch_[fd];
+            // callback may have canceled all callbacks
+            if (w->write_cb.size()) {
+                w->write_cb.pop_front();
+                // the next urgent callback is now the first one
+                if (w->write_urgent) --w->write_urgent;
+            }
+        }
+    }
+}
+
+//! Run one iteration of dispatching epoll_wait().
+void EpollDispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
+
+    // do not wait if callbacks were added to fds which are already ready.
+    std::chrono::steady_clock::time_point wait_begin =
+        std::chrono::steady_clock::now();
+    int r = epoll_wait(epoll_fd_, events_.data(),
+                       static_cast<int>(events_.size()),
+                       ready_.empty() ? static_cast<int>(timeout.count()) : 0);
+    AddWaitTime(wait_begin);
+
+    if (r < 0) {
+        // if we caught a signal, this is intended to interrupt epoll_wait().
+        if (errno == EINTR) {
+            LOG << "Dispatch(): epoll_wait() was interrupted due to a signal.";
+            return;
+        }
+
+        throw Exception("Dispatch::epoll_wait() failed!", errno);
+    }
+
+    LOG << "epoll_wait() returned " << r << " events";
+
+    for (int i = 0; i < r; ++i)
+    {
+        int fd = events_[i].data.fd;
+        uint32_t ev = events_[i].events;
+
+        Watch& w = watch_[fd];
+        if (!w.registered) continue;
+
+        if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            w.can_read = true;
+        if (ev & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+            w.can_write = true;
+        if (ev & EPOLLERR)
+            w.error = true;
+
+        MarkReady(fd);
+    }
+
+    // grow event buffer if it was filled completely
+    if (static_cast<size_t>(r) == events_.size())
+        events_.resize(2 * events_.size());
+
+    // process ready fds, callbacks may add new ones to ready_.
+    processing_.swap(ready_);
+    for (const int& fd : processing_)
+        ProcessReady(fd);
+    processing_.clear();
+}
+
+} // namespace tcp
+} // namespace net
+} // namespace thrill
+
+#endif // THRILL_HAVE_NET_EPOLL
+
+/******************************************************************************/
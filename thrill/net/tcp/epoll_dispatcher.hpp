@@ -0,0 +1,282 @@
+/*******************************************************************************
+ * thrill/net/tcp/epoll_dispatcher.hpp
+ *
+ * Asynchronous callback wrapper around Linux epoll()
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_NET_TCP_EPOLL_DISPATCHER_HEADER
+#define THRILL_NET_TCP_EPOLL_DISPATCHER_HEADER
+
+#include <thrill/common/config.hpp>
+
+#if THRILL_HAVE_NET_EPOLL
+
+#include <thrill/common/delegate.hpp>
+#include <thrill/common/die.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/porting.hpp>
+#include <thrill/mem/allocator.hpp>
+#include <thrill/net/connection.hpp>
+#include <thrill/net/dispatcher.hpp>
+#include <thrill/net/exception.hpp>
+#include <thrill/net/tcp/connection.hpp>
+#include <thrill/net/tcp/socket.hpp>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace thrill {
+namespace net {
+namespace tcp {
+
+//! \addtogroup net_tcp TCP Socket API
+//! \{
+
+/*!
+ * EpollDispatcher is a higher level wrapper for Linux's epoll() with the same
+ * interface as SelectDispatcher. Each file descriptor is registered only once
+ * in edge-triggered mode, hence adding and removing callbacks requires no
+ * system calls, and waiting costs O(ready fds) instead of O(max fd) without
+ * an FD_SETSIZE limit.
+ *
+ * Edge-triggered events are stored as readable/writable flags per fd until
+ * the fd is drained. Callbacks call non-blocking recv() or send() until they
+ * are done or the call fails with EAGAIN, retrying on EINTR, and return true
+ * only in the latter case, when they want to be called on the next edge.
+ */
+class EpollDispatcher final : public net::Dispatcher
+{
+    static constexpr bool debug = false;
+
+public:
+    //! type for file descriptor readiness callbacks
+    using Callback = AsyncCallback;
+
+    //! constructor
+    explicit EpollDispatcher(mem::Manager& mem_manager)
+        : net::Dispatcher(mem_manager) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0)
+            throw Exception("EpollDispatcher() could not get epoll fd!", errno);
+
+        // allocate self-pipe, the read end is drained in non-blocking mode.
+        common::MakePipe(self_pipe_);
+        if (fcntl(self_pipe_[0], F_SETFL,
+                  fcntl(self_pipe_[0], F_GETFL) | O_NONBLOCK) != 0)
+            throw Exception("EpollDispatcher() could not set self-pipe "
+                            "non-blocking!", errno);
+
+        // Ignore PIPE signals (received when writing to closed sockets)
+        signal(SIGPIPE, SIG_IGN);
+
+        // wait interrupts via self-pipe.
+        AddRead(self_pipe_[0],
+                Callback::make<EpollDispatcher,
+                               & EpollDispatcher::SelfPipeCallback>(this));
+    }
+
+    ~EpollDispatcher() {
+        ::close(self_pipe_[0]);
+        ::close(self_pipe_[1]);
+        ::close(epoll_fd_);
+    }
+
+    //! Grow table if needed
+    void CheckSize(int fd) {
+        assert(fd >= 0);
+        assert(fd <= 32000); // this is an arbitrary limit to catch errors.
+        if (static_cast<size_t>(fd) >= watch_.size())
+            watch_.resize(fd + 1, Watch(mem_manager_));
+    }
+
+    //! Register a buffered read callback and a default exception callback.
+    void AddRead(int fd, const Callback& read_cb) {
+        CheckSize(fd);
+        Watch& w = watch_[fd];
+        w.read_cb.emplace_back(read_cb);
+        Register(fd);
+        if (w.can_read) MarkReady(fd);
+    }
+
+    //! Register a buffered read callback and a default exception callback.
+    void AddRead(net::Connection& c, const Callback& read_cb) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        return AddRead(fd, read_cb);
+    }
+
+    //! Register a buffered write callback and a default exception callback.
+    void AddWrite(net::Connection& c, const Callback& write_cb) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        CheckSize(fd);
+        Watch& w = watch_[fd];
+        w.write_cb.emplace_back(write_cb);
+        Register(fd);
+        if (w.can_write) MarkReady(fd);
+    }
+
+    //! Register a buffered write callback, which is queued behind the first
+    //! one, which may be partially written, and the previous urgent ones.
+    void AddWriteUrgent(net::Connection& c, const Callback& write_cb) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        CheckSize(fd);
+        Watch& w = watch_[fd];
+        if (w.write_cb.size() == 0)
+            return AddWrite(c, write_cb);
+        w.write_cb.emplace(w.write_cb.begin() + 1 + w.write_urgent, write_cb);
+        ++w.write_urgent;
+    }
+
+    //! Register a buffered write callback and a default exception callback.
+    void SetExcept(net::Connection& c, const Callback& except_cb) {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        CheckSize(fd);
+        watch_[fd].except_cb = except_cb;
+        Register(fd);
+    }
+
+    //! Cancel all callbacks on a given fd. This must be called before closing
+    //! a registered fd, since otherwise a reused fd number would not be
+    //! registered with epoll.
+    void Cancel(net::Connection& c) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        CheckSize(fd);
+
+        if (watch_[fd].read_cb.size() == 0 &&
+            watch_[fd].write_cb.size() == 0)
+            LOG << "EpollDispatcher::Cancel() fd=" << fd
+                << " called with no callbacks registered.";
+
+        Watch& w = watch_[fd];
+        w.read_cb.clear();
+        w.write_cb.clear();
+        w.write_urgent = 0;
+        w.except_cb = Callback();
+        Unregister(fd);
+    }
+
+    //! Run one iteration of dispatching epoll_wait().
+    void DispatchOne(const std::chrono::milliseconds& timeout) final;
+
+    //! Interrupt the current epoll_wait() via self-pipe
+    void Interrupt() final {
+        // send one byte to wake up the epoll_wait() handler.
+        ssize_t wb;
+        while ((wb = write(self_pipe_[1], this, 1)) == 0) {
+            LOG1 << "WakeUp: error sending to self-pipe: " << errno;
+        }
+        die_unless(wb == 1);
+    }
+
+private:
+    //! epoll file descriptor
+    int epoll_fd_;
+
+    //! self-pipe to wake up epoll_wait().
+    int self_pipe_[2];
+
+    //! buffer to drain bytes from self-pipe
+    char self_pipe_buffer_[64];
+
+    //! callback vectors and readiness state per watched file descriptor
+    struct Watch
+    {
+        //! whether the fd is registered with epoll
+        bool                 registered = false;
+        //! whether the fd is in the ready list
+        bool                 ready = false;
+        //! edge-triggered readiness flags, cleared once a callback drains the
+        //! socket.
+        bool                 can_read = false, can_write = false;
+        //! error or hangup event received
+        bool                 error = false;
+        //! queue of callbacks for fd.
+        mem::deque<Callback> read_cb, write_cb;
+        //! number of urgent callbacks queued directly behind the first one in
+        //! write_cb.
+        size_t               write_urgent = 0;
+        //! only one exception callback for the fd.
+        Callback             except_cb;
+
+        explicit Watch(mem::Manager& mem_manager)
+            : read_cb(mem::Allocator<Callback>(mem_manager)),
+              write_cb(mem::Allocator<Callback>(mem_manager)) { }
+    };
+
+    //! handlers for all registered file descriptors. the fd integer range
+    //! should be small enough, otherwise a more complicated data structure is
+    //! needed.
+    mem::vector<Watch> watch_ { mem::Allocator<Watch>(mem_manager_) };
+
+    //! list of fds with pending readiness events and callbacks
+    mem::vector<int> ready_ { mem::Allocator<int>(mem_manager_) };
+
+    //! list of ready fds currently being processed, swapped with ready_.
+    mem::vector<int> processing_ { mem::Allocator<int>(mem_manager_) };
+
+    //! buffer of events delivered by epoll_wait()
+    mem::vector<struct epoll_event> events_ {
+        64, mem::Allocator<struct epoll_event>(mem_manager_)
+    };
+
+    //! register fd with epoll for all events, if not done yet.
+    void Register(int fd);
+
+    //! unregister fd from epoll and reset its readiness state.
+    void Unregister(int fd);
+
+    //! add fd to ready list
+    void MarkReady(int fd) {
+        if (watch_[fd].ready) return;
+        watch_[fd].ready = true;
+        ready_.push_back(fd);
+    }
+
+    //! run callbacks of a ready fd
+    void ProcessReady(int fd);
+
+    //! Self-pipe callback: drain all wake up bytes, since there may be
+    //! multiple per edge.
+    bool SelfPipeCallback() {
+        ssize_t r;
+        while ((r = read(self_pipe_[0], self_pipe_buffer_,
+                         sizeof(self_pipe_buffer_))) > 0 ||
+               (r < 0 && errno == EINTR)) { }
+        die_unless(errno == EAGAIN || errno == EWOULDBLOCK);
+        return true;
+    }
+};
+
+//! \}
+
+} // namespace tcp
+} // namespace net
+} // namespace thrill
+
+#endif // THRILL_HAVE_NET_EPOLL
+
+#endif // !THRILL_NET_TCP_EPOLL_DISPATCHER_HEADER
+
+/******************************************************************************/
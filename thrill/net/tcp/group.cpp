@@ -14,9 +14,11 @@
 
 #include <thrill/common/logger.hpp>
 #include <thrill/net/tcp/construct.hpp>
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
 #include <thrill/net/tcp/group.hpp>
 #include <thrill/net/tcp/select_dispatcher.hpp>
 
+#include <cstdlib>
 #include <random>
 #include <string>
 #include <thread>
@@ -29,6 +31,22 @@ namespace tcp {
 
 std::unique_ptr<Dispatcher>
 Group::ConstructDispatcher(mem::Manager& mem_manager) const {
+    // THRILL_NET_DISPATCHER selects "select" or "epoll", the default is epoll
+    // if available.
+    const char* env = getenv("THRILL_NET_DISPATCHER");
+    std::string dispatcher = env ? env : "";
+
+#if THRILL_HAVE_NET_EPOLL
+    if (dispatcher.empty() || dispatcher == "epoll") {
+        // construct tcp::EpollDispatcher
+        return std::make_unique<EpollDispatcher>(mem_manager);
+    }
+#endif
+    if (!dispatcher.empty() && dispatcher != "select") {
+        throw Exception("THRILL_NET_DISPATCHER: unknown or unsupported "
+                        "dispatcher \"" + dispatcher + "\"");
+    }
+
     // construct tcp::SelectDispatcher
     return std::make_unique<SelectDispatcher>(mem_manager);
 }
@@ -57,7 +57,10 @@ void SelectDispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
         LOG << "Performing select() on " << oss.str();
     }
 
+    std::chrono::steady_clock::time_point wait_begin =
+        std::chrono::steady_clock::now();
     int r = fdset.select_timeout(static_cast<double>(timeout.count()));
+    AddWaitTime(wait_begin);
 
     if (r < 0) {
         // if we caught a signal, this is intended to interrupt a select().
@@ -123,6 +126,8 @@ void SelectDispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
                 while (w->write_cb.size() && w->write_cb.front()() == false) {
                     w = &watch_[fd];
                     w->write_cb.pop_front();
+                    // the next urgent callback is now the first one
+                    if (w->write_urgent) --w->write_urgent;
                 }
                 w = &watch_[fd];
 
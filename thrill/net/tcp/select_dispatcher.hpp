@@ -119,6 +119,20 @@ public:
         watch_[fd].write_cb.emplace_back(write_cb);
     }
 
+    //! Register a buffered write callback, which is queued behind the first
+    //! one, which may be partially written, and the previous urgent ones.
+    void AddWriteUrgent(net::Connection& c, const Callback& write_cb) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        CheckSize(fd);
+        Watch& w = watch_[fd];
+        if (w.write_cb.size() == 0)
+            return AddWrite(c, write_cb);
+        w.write_cb.emplace(w.write_cb.begin() + 1 + w.write_urgent, write_cb);
+        ++w.write_urgent;
+    }
+
     //! Register a buffered write callback and a default exception callback.
     void SetExcept(net::Connection& c, const Callback& except_cb) {
         assert(dynamic_cast<Connection*>(&c));
@@ -151,6 +165,7 @@ public:
         Watch& w = watch_[fd];
         w.read_cb.clear();
         w.write_cb.clear();
+        w.write_urgent = 0;
         w.except_cb = Callback();
         w.active = false;
     }
@@ -194,6 +209,9 @@ private:
         bool                 active = false;
         //! queue of callbacks for fd.
         mem::deque<Callback> read_cb, write_cb;
+        //! number of urgent callbacks queued directly behind the first one in
+        //! write_cb.
+        size_t               write_urgent = 0;
         //! only one exception callback for the fd.
         Callback             except_cb;
 
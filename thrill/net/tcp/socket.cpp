@@ -15,11 +15,67 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
 
 namespace thrill {
 namespace net {
 namespace tcp {
 
+//! Fill sa with the name in the abstract namespace, which starts with a zero
+//! byte and is not bound to the file system. Returns the address length.
+static socklen_t MakeLocalAddress(const std::string& name,
+                                  struct sockaddr_un* sa) {
+    memset(sa, 0, sizeof(*sa));
+    sa->sun_family = AF_UNIX;
+    size_t size = std::min(name.size(), sizeof(sa->sun_path) - 1);
+    memcpy(sa->sun_path + 1, name.data(), size);
+    return static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path)
+                                  + 1 + size);
+}
+
+bool Socket::bind_local(const std::string& name) {
+    assert(IsValid());
+
+    struct sockaddr_un sa;
+    socklen_t salen = MakeLocalAddress(name, &sa);
+
+    int r = ::bind(fd_, reinterpret_cast<struct sockaddr*>(&sa), salen);
+
+    if (r != 0) {
+        LOG << "Socket::bind_local()"
+            << " fd_=" << fd_
+            << " name=" << name
+            << " return=" << r
+            << " error=" << strerror(errno);
+    }
+
+    return (r == 0);
+}
+
+int Socket::connect_local(const std::string& name) {
+    assert(IsValid());
+
+    struct sockaddr_un sa;
+    socklen_t salen = MakeLocalAddress(name, &sa);
+
+    int r = ::connect(fd_, reinterpret_cast<struct sockaddr*>(&sa), salen);
+
+    if (r == 0)
+        return r;
+
+    LOG << "Socket::connect_local()"
+        << " fd_=" << fd_
+        << " name=" << name
+        << " return=" << r
+        << " error=" << strerror(errno);
+
+    return r;
+}
+
 void Socket::SetKeepAlive(bool activate) {
     assert(IsValid());
 
@@ -22,6 +22,10 @@
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <cassert>
@@ -135,6 +139,30 @@ public:
         return std::make_pair(Socket(fds[0]), Socket(fds[1]));
     }
 
+    //! Create a new local (Unix domain) stream socket, which is used for
+    //! connections between processes on the same host.
+    static Socket CreateLocal() {
+#ifdef SOCK_CLOEXEC
+        int fd = ::socket(PF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+        int fd = ::socket(PF_UNIX, SOCK_STREAM, 0);
+#endif
+        if (fd < 0) {
+            LOG << "Socket::CreateLocal()"
+                << " fd=" << fd
+                << " error=" << strerror(errno);
+        }
+
+#ifndef SOCK_CLOEXEC
+        if (fcntl(fd, F_SETFD, FD_CLOEXEC) != 0) {
+            throw common::ErrnoException(
+                      "Error setting FD_CLOEXEC on network socket");
+        }
+#endif
+
+        return Socket(fd);
+    }
+
     //! \}
 
     //! \name Status
@@ -285,6 +313,14 @@ public:
         return r;
     }
 
+    //! Bind local socket to the given name in the abstract namespace (Linux
+    //! only) for listening.
+    bool bind_local(const std::string& name);
+
+    //! Initial local socket connection to the given name in the abstract
+    //! namespace (Linux only).
+    int connect_local(const std::string& name);
+
     //! Turn socket into listener state to accept incoming connections.
     bool listen(int backlog = 0) {
         assert(IsValid());
@@ -356,6 +392,65 @@ public:
         return r;
     }
 
+    //! Send (data1,size1) followed by (data2,size2) to socket with one
+    //! gathering sendmsg() call (BSD socket API function wrapper).
+    ssize_t send_two(const void* data1, size_t size1,
+                     const void* data2, size_t size2, int flags = 0) {
+        assert(IsValid());
+
+        LOG << "Socket::send_two()"
+            << " fd_=" << fd_
+            << " size1=" << size1
+            << " size2=" << size2
+            << " flags=" << flags;
+
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(data1);
+        iov[0].iov_len = size1;
+        iov[1].iov_base = const_cast<void*>(data2);
+        iov[1].iov_len = size2;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+
+        ssize_t r = ::sendmsg(fd_, &msg, flags);
+
+        LOG << "done Socket::send_two()"
+            << " fd_=" << fd_
+            << " return=" << r;
+
+        return r;
+    }
+
+    //! Send size bytes from file descriptor in_fd at offset to socket without
+    //! copying them through user space (Linux sendfile() wrapper). Returns -1
+    //! with errno ENOSYS on other systems.
+    ssize_t send_file(int in_fd, uint64_t offset, size_t size) {
+        assert(IsValid());
+
+        LOG << "Socket::send_file()"
+            << " fd_=" << fd_
+            << " in_fd=" << in_fd
+            << " offset=" << offset
+            << " size=" << size;
+
+#if defined(__linux__)
+        off_t off = static_cast<off_t>(offset);
+        ssize_t r = ::sendfile(fd_, in_fd, &off, size);
+#else
+        ssize_t r = -1;
+        errno = ENOSYS;
+#endif
+
+        LOG << "done Socket::send_file()"
+            << " fd_=" << fd_
+            << " return=" << r;
+
+        return r;
+    }
+
     //! Send (data,size) to socket, retry sends if short-sends occur.
     ssize_t send(const void* data, size_t size, int flags = 0) {
         assert(IsValid());
@@ -19,8 +19,11 @@ print "#include <$_>\n" foreach sort glob("thrill/api/"."*.hpp");
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/all_reduce.hpp>
+#include <thrill/api/approx_count_distinct.hpp>
+#include <thrill/api/approx_quantiles.hpp>
 #include <thrill/api/bernoulli_sample.hpp>
 #include <thrill/api/cache.hpp>
+#include <thrill/api/checkpoint.hpp>
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/concat.hpp>
 #include <thrill/api/concat_to_dia.hpp>
@@ -28,6 +31,7 @@ print "#include <$_>\n" foreach sort glob("thrill/api/"."*.hpp");
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dia_base.hpp>
 #include <thrill/api/dia_node.hpp>
+#include <thrill/api/distinct.hpp>
 #include <thrill/api/distribute.hpp>
 #include <thrill/api/dop_node.hpp>
 #include <thrill/api/equal_to_dia.hpp>
@@ -38,25 +42,39 @@ print "#include <$_>\n" foreach sort glob("thrill/api/"."*.hpp");
 #include <thrill/api/group_by_iterator.hpp>
 #include <thrill/api/group_by_key.hpp>
 #include <thrill/api/group_to_index.hpp>
+#include <thrill/api/inner_join.hpp>
+#include <thrill/api/iterate.hpp>
 #include <thrill/api/max.hpp>
 #include <thrill/api/merge.hpp>
 #include <thrill/api/min.hpp>
+#include <thrill/api/partial_sort.hpp>
 #include <thrill/api/prefixsum.hpp>
+#include <thrill/api/pregel.hpp>
 #include <thrill/api/print.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/read_columnar.hpp>
 #include <thrill/api/read_lines.hpp>
+#include <thrill/api/rebalance.hpp>
 #include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/reduce_to_index.hpp>
 #include <thrill/api/sample.hpp>
+#include <thrill/api/select.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/sort.hpp>
+#include <thrill/api/sort_merge_join.hpp>
+#include <thrill/api/sparse_matrix.hpp>
 #include <thrill/api/source_node.hpp>
+#include <thrill/api/streaming_reduce.hpp>
 #include <thrill/api/sum.hpp>
+#include <thrill/api/top_k.hpp>
+#include <thrill/api/union.hpp>
 #include <thrill/api/window.hpp>
 #include <thrill/api/write_binary.hpp>
+#include <thrill/api/write_columnar.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_many.hpp>
 #include <thrill/api/zip.hpp>
+#include <thrill/api/zip_with_index.hpp>
 // [[[end]]]
 
 namespace thrill {